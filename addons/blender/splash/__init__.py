@@ -34,6 +34,7 @@ sys.path.insert(0, '/usr/local/lib/python3/dist-packages')
 
 if "bpy" in locals():
     import imp
+    imp.reload(mesh_frames)
     imp.reload(operators)
     imp.reload(nodes)
 else:
@@ -47,6 +48,7 @@ else:
     from bpy.types import (Operator,
                            PropertyGroup,
                            )
+    from . import mesh_frames
     from . import operators
     from . import nodes
 
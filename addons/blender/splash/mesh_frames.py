@@ -0,0 +1,111 @@
+#
+# Copyright (C) 2026 Emmanuel Durand
+#
+# This file is part of Splash (http://github.com/paperManu/splash)
+#
+# This program is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+#
+# Splash is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with Splash.  If not, see <http://www.gnu.org/licenses/>.
+#
+
+# Encoding of the frames of the application/x-polymesh shmdata meshes, read by Mesh_Shmdata:
+# - full frames hold the vertex and polygon counts, the vertices then the polygons
+# - delta frames only hold the ranges of vertices which changed, when the topology did not
+# The delta frame layout is described in src/utils/mesh_delta.h
+
+import struct
+import numpy
+
+DELTA_MARKER = -1
+DELTA_QUANTIZED = 0x1
+
+
+class MeshFrameEncoder:
+    def __init__(self, quantize=False, max_gap=16):
+        """
+        quantize: if True, positions and normals of the delta frames are sent as 16 bits integers
+        max_gap: ranges of changed vertices separated by at most this many unchanged vertices are merged
+        """
+        self._quantize = quantize
+        self._max_gap = max_gap
+        self._vertices = None
+        self._polygons = None
+
+    def reset(self):
+        """Forget the last frame, so that the next one is sent in full"""
+        self._vertices = None
+        self._polygons = None
+
+    def encode(self, vertices, polygons):
+        """
+        Encode a mesh as a frame, a delta frame being sent if only some vertices changed since the last one
+        vertices: array of shape (count, 8), holding x, y, z, u, v, nx, ny, nz for each vertex
+        polygons: list of polygons, each one given as a list of vertex indices
+        Returns the frame as bytes, or None if nothing changed
+        """
+        vertices = numpy.ascontiguousarray(vertices, dtype=numpy.float32)
+
+        if self._vertices is None or self._vertices.shape != vertices.shape or self._polygons != polygons:
+            self._vertices = vertices.copy()
+            self._polygons = [list(polygon) for polygon in polygons]
+            return self._encode_full(vertices, polygons)
+
+        changed = numpy.flatnonzero(numpy.any(vertices != self._vertices, axis=1))
+        if changed.size == 0:
+            return None
+
+        self._vertices = vertices.copy()
+        return self._encode_delta(vertices, self._ranges(changed))
+
+    def _ranges(self, changed):
+        ranges = []
+        first = int(changed[0])
+        last = first
+        for index in changed[1:]:
+            index = int(index)
+            if index - last > self._max_gap + 1:
+                ranges.append((first, last - first + 1))
+                first = index
+            last = index
+        ranges.append((first, last - first + 1))
+        return ranges
+
+    def _encode_full(self, vertices, polygons):
+        data = [struct.pack("=ii", vertices.shape[0], len(polygons)), vertices.tobytes()]
+        for polygon in polygons:
+            data.append(struct.pack("=i%ii" % len(polygon), len(polygon), *polygon))
+        return b"".join(data)
+
+    def _encode_delta(self, vertices, ranges):
+        flags = DELTA_QUANTIZED if self._quantize else 0
+        data = [struct.pack("=iiii", DELTA_MARKER, vertices.shape[0], flags, len(ranges))]
+
+        if self._quantize:
+            box_min = vertices[:, 0:3].min(axis=0)
+            box_max = vertices[:, 0:3].max(axis=0)
+            data.append(struct.pack("=6f", *box_min, *box_max))
+            extent = numpy.where(box_max > box_min, box_max - box_min, 1.0)
+
+        for first, count in ranges:
+            data.append(struct.pack("=ii", first, count))
+            values = vertices[first:first + count]
+            if not self._quantize:
+                data.append(values.tobytes())
+                continue
+
+            quantized = numpy.zeros(count, dtype=[('position', '<u2', 3), ('normal', '<i2', 3), ('uv', '<f4', 2)])
+            quantized['position'] = numpy.rint((values[:, 0:3] - box_min) / extent * 65535.0).clip(0, 65535)
+            quantized['normal'] = numpy.rint(values[:, 5:8].clip(-1.0, 1.0) * 32767.0)
+            quantized['uv'] = values[:, 3:5]
+            data.append(quantized.tobytes())
+
+        return b"".join(data)
@@ -28,11 +28,14 @@ from bpy.props import StringProperty, BoolProperty
 from math import floor
 from mathutils import Vector
 
+from .mesh_frames import MeshFrameEncoder
+
 
 class Target:
     def __init__(self):
         self._object = None
         self._meshWriter = None
+        self._meshEncoder = MeshFrameEncoder()
         self._updatePeriodObject = 1.0
         self._updatePeriodEdit = 1.0
         self._startTime = 0.0
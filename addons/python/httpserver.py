@@ -8,6 +8,10 @@
 #
 # For this to work,  the configuration file should be in the same
 # directory as this script. Otherwise, modify the path accordingly
+#
+# This server handles one request at a time. For many clients or frequent
+# updates, prefer the native "http_server" object which also supports
+# WebSocket subscriptions.
 
 import splash
 import re
@@ -28,6 +28,9 @@
 /* Defined to 1 if the CALIMIRO is detected */
 #cmakedefine01 HAVE_CALIMIRO
 
+/* Defined to 1 if libturbojpeg is detected */
+#cmakedefine01 HAVE_TURBOJPEG
+
 /* Support mmx instructions */
 #cmakedefine01 HAVE_MMX
 
@@ -3,6 +3,13 @@
 #define PIC_DISABLE_OPENGL
 #define PIC_DISABLE_QT
 
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+
 #include <gsl/gsl_errno.h>
 #include <gsl/gsl_spline.h>
 
@@ -13,12 +20,21 @@
 #include <glm/gtx/euler_angles.hpp>
 
 #include <opencv2/highgui.hpp>
+#include <opencv2/imgproc.hpp>
 
 #include "./image/image_gphoto.h"
 #include "./utils/log.h"
+#include "./utils/osutils.h"
 #include "./utils/scope_guard.h"
+#include "./utils/thread_pool.h"
 #include "./utils/timer.h"
 
+#define SPLASH_COLORCALIBRATOR_CRF_CACHE_MAGIC "SPLCRF"
+#define SPLASH_COLORCALIBRATOR_CRF_CACHE_VERSION 1
+// Number of LDR images, and stops between them, used to compute the camera response function
+#define SPLASH_COLORCALIBRATOR_CRF_LDR_COUNT 9
+#define SPLASH_COLORCALIBRATOR_CRF_LDR_STEP 0.33
+
 using namespace std;
 
 namespace Splash
@@ -107,10 +123,9 @@ void ColorCalibrator::update()
             setObjectAttribute(params.camName, "hide", {false});
 
         //
-        // Compute the camera response function
+        // Compute the camera response function, or reuse the one of the same camera and settings
         //
-        if (_crf.total() == 0)
-            captureHDR(9, 0.33);
+        updateResponse();
 
         for (auto& params : _calibrationParams)
             setObjectAttribute(params.camName, "hide", {true});
@@ -150,6 +165,7 @@ void ColorCalibrator::update()
                 }
 
             params.maskROI = getMaskROI(diffHdr);
+            params.boundingROI = getMaskBoundingBox(params.maskROI, diffHdr.cols);
             for (auto& otherCam : cameras)
                 setObjectAttribute(otherCam->getName(), "clearColor", {0.0, 0.0, 0.0, 1.0});
 
@@ -159,13 +175,23 @@ void ColorCalibrator::update()
 
         //
         // Find color curves for each Camera
+        // Projectors which do not overlap can be measured together, and the curves
+        // of a group are fitted while the next group is being measured
         //
-        for (auto& params : _calibrationParams)
+        future<void> curveFitting{};
+        OnScopeExit
         {
-            string camName = params.camName;
+            if (curveFitting.valid())
+                curveFitting.wait();
+        };
+
+        for (const auto& group : getMeasureGroups())
+        {
+            // Only the projection areas of the group are merged
+            cv::Rect groupROI{};
+            for (auto index : group)
+                groupROI = groupROI.empty() ? _calibrationParams[index].boundingROI : (groupROI | _calibrationParams[index].boundingROI);
 
-            RgbValue minValues;
-            RgbValue maxValues;
             for (int c = 0; c < 3; ++c)
             {
                 int samples = _colorCurveSamples;
@@ -177,33 +203,48 @@ void ColorCalibrator::update()
                     Values color(4, 0.0);
                     color[c] = x;
                     color[3] = 1.0;
-                    setObjectAttribute(camName, "clearColor", {color[0], color[1], color[2], color[3]});
+                    for (auto index : group)
+                        setObjectAttribute(_calibrationParams[index].camName, "clearColor", {color[0], color[1], color[2], color[3]});
 
                     // Set approximately the exposure
                     _gcamera->setAttribute("shutterspeed", {mediumExposureTime});
 
-                    hdr = captureHDR(_imagePerHDR, _hdrStep);
+                    hdr = captureHDR(_imagePerHDR, _hdrStep, false, groupROI);
                     if (hdr.total() == 0)
                         return;
-                    vector<float> values = getMeanValue(hdr, params.maskROI);
-                    params.curves[c].push_back(Point(x, values));
 
-                    setObjectAttribute(camName, "clearColor", {0.0, 0.0, 0.0, 1.0});
-                    Log::get() << Log::MESSAGE << "ColorCalibrator::" << __FUNCTION__ << " - Camera " << camName << ", color channel " << c << " value: " << values[c]
-                               << " for input value: " << x << Log::endl;
+                    for (auto index : group)
+                    {
+                        auto& params = _calibrationParams[index];
+                        vector<float> values = getMeanValue(hdr, params.maskROI);
+                        params.curves[c].push_back(Point(x, values));
+
+                        setObjectAttribute(params.camName, "clearColor", {0.0, 0.0, 0.0, 1.0});
+                        Log::get() << Log::MESSAGE << "ColorCalibrator::" << __FUNCTION__ << " - Camera " << params.camName << ", color channel " << c << " value: " << values[c]
+                                   << " for input value: " << x << Log::endl;
+                    }
                 }
 
                 // Update min and max values, added to the black level
-                minValues[c] = params.curves[c][0].second[c];
-                maxValues[c] = params.curves[c][samples - 1].second[c];
+                for (auto index : group)
+                {
+                    auto& params = _calibrationParams[index];
+                    params.minValues[c] = params.curves[c][0].second[c];
+                    params.maxValues[c] = params.curves[c][samples - 1].second[c];
+                }
             }
 
-            params.minValues = minValues;
-            params.maxValues = maxValues;
-
-            params.projectorCurves = computeProjectorFunctionInverse(params.curves);
+            if (curveFitting.valid())
+                curveFitting.wait();
+            curveFitting = async(launch::async, [this, group]() {
+                for (auto index : group)
+                    _calibrationParams[index].projectorCurves = computeProjectorFunctionInverse(_calibrationParams[index].curves);
+            });
         }
 
+        if (curveFitting.valid())
+            curveFitting.wait();
+
         //
         // Find color mixing matrix
         //
@@ -360,13 +401,110 @@ void ColorCalibrator::updateCRF()
 
         findCorrectExposure();
 
-        // Compute the camera response function
-        captureHDR(9, 0.33);
+        // Compute the camera response function, replacing the cached one
+        _crfKey = computeResponseKey();
+        captureHDR(SPLASH_COLORCALIBRATOR_CRF_LDR_COUNT, SPLASH_COLORCALIBRATOR_CRF_LDR_STEP, true);
+        if (_useResponseCache && _crf.total() != 0)
+            writeResponseToCache(_crfKey, _crf);
+    });
+}
+
+/*************/
+uint64_t ColorCalibrator::computeResponseKey() const
+{
+    // The exposure time is changed while capturing, and does not change the response
+    string keyData;
+    for (const auto& attribute : {"model", "lens", "aperture", "isospeed"})
+    {
+        Values value;
+        _gcamera->getAttribute(attribute, value);
+        keyData += (value.empty() ? string() : value[0].as<string>()) + '\0';
+    }
+    return hash<string>()(keyData);
+}
+
+/*************/
+string ColorCalibrator::getResponseCacheFilePath(uint64_t key)
+{
+    stringstream path;
+    path << Utils::getCachePath() << "/color_response/" << hex << setw(16) << setfill('0') << key << ".splashcrf";
+    return path.str();
+}
+
+/*************/
+cv::Mat ColorCalibrator::readResponseFromCache(uint64_t key)
+{
+    ifstream file(getResponseCacheFilePath(key), ios::in | ios::binary);
+    if (!file)
+        return {};
+
+    char magic[sizeof(SPLASH_COLORCALIBRATOR_CRF_CACHE_MAGIC)];
+    uint32_t version = 0;
+    int32_t rows = 0;
+    int32_t cols = 0;
+    file.read(magic, sizeof(magic));
+    file.read(reinterpret_cast<char*>(&version), sizeof(version));
+    file.read(reinterpret_cast<char*>(&rows), sizeof(rows));
+    file.read(reinterpret_cast<char*>(&cols), sizeof(cols));
+    if (!file || memcmp(magic, SPLASH_COLORCALIBRATOR_CRF_CACHE_MAGIC, sizeof(magic)) != 0 || version != SPLASH_COLORCALIBRATOR_CRF_CACHE_VERSION)
+        return {};
+
+    // Responses computed by cv::CalibrateDebevec have one row per 8 bits value
+    if (rows != 256 || cols != 1)
+        return {};
+
+    cv::Mat crf(rows, cols, CV_32FC3);
+    file.read(reinterpret_cast<char*>(crf.data), crf.total() * crf.elemSize());
+    if (!file)
+        return {};
+
+    return crf;
+}
+
+/*************/
+void ColorCalibrator::writeResponseToCache(uint64_t key, const cv::Mat& crf)
+{
+    if (crf.type() != CV_32FC3 || !crf.isContinuous())
+        return;
+
+    Utils::writeCacheFile(getResponseCacheFilePath(key), SPLASH_COLORCALIBRATOR_CRF_CACHE_MAGIC, SPLASH_COLORCALIBRATOR_CRF_CACHE_VERSION, [&](ofstream& file) {
+        int32_t rows = crf.rows;
+        int32_t cols = crf.cols;
+
+        file.write(reinterpret_cast<const char*>(&rows), sizeof(rows));
+        file.write(reinterpret_cast<const char*>(&cols), sizeof(cols));
+        file.write(reinterpret_cast<const char*>(crf.data), crf.total() * crf.elemSize());
     });
 }
 
 /*************/
-cv::Mat3f ColorCalibrator::captureHDR(unsigned int nbrLDR, double step, bool computeResponseOnly)
+void ColorCalibrator::updateResponse()
+{
+    // A response computed for another camera or other settings does not hold anymore
+    auto key = computeResponseKey();
+    if (key != _crfKey)
+    {
+        _crf = cv::Mat();
+        _crfKey = key;
+    }
+
+    if (_crf.total() == 0 && _useResponseCache)
+    {
+        _crf = readResponseFromCache(key);
+        if (_crf.total() != 0)
+            Log::get() << Log::MESSAGE << "ColorCalibrator::" << __FUNCTION__ << " - Reusing the cached camera response function" << Log::endl;
+    }
+
+    if (_crf.total() != 0)
+        return;
+
+    captureHDR(SPLASH_COLORCALIBRATOR_CRF_LDR_COUNT, SPLASH_COLORCALIBRATOR_CRF_LDR_STEP, true);
+    if (_useResponseCache && _crf.total() != 0)
+        writeResponseToCache(key, _crf);
+}
+
+/*************/
+cv::Mat3f ColorCalibrator::captureHDR(unsigned int nbrLDR, double step, bool computeResponseOnly, const cv::Rect& roi)
 {
     // Capture LDR images
     // Get the current shutterspeed
@@ -379,8 +517,22 @@ cv::Mat3f ColorCalibrator::captureHDR(unsigned int nbrLDR, double step, bool com
     for (int steps = nbrLDR / 2; steps > 0; --steps)
         nextSpeed /= pow(2.0, step);
 
+    // Each photo is decoded while the next one is being captured
+    auto toMat = [](future<unique_ptr<ImageBuffer>>& photo) -> cv::Mat {
+        if (!photo.valid())
+            return {};
+        auto img = photo.get();
+        if (!img)
+            return {};
+        const auto& spec = img->getSpec();
+        cv::Mat bgr;
+        cv::cvtColor(cv::Mat(spec.height, spec.width, CV_8UC4, img->data()), bgr, cv::COLOR_RGBA2BGR);
+        return bgr;
+    };
+
     vector<cv::Mat> ldr(nbrLDR);
     vector<float> expositionDurations(nbrLDR);
+    future<unique_ptr<ImageBuffer>> previousPhoto;
     for (unsigned int i = 0; i < nbrLDR; ++i)
     {
         _gcamera->setAttribute("shutterspeed", {nextSpeed});
@@ -394,12 +546,13 @@ cv::Mat3f ColorCalibrator::captureHDR(unsigned int nbrLDR, double step, bool com
         // Update exposure for next step
         nextSpeed *= pow(2.0, step);
 
-        string filename = "/tmp/splash_ldr_sample_" + to_string(i) + ".bmp";
-        _gcamera->update();
-        _gcamera->write(filename);
-
-        ldr[i] = cv::imread(filename);
+        auto photo = _gcamera->captureAsync();
+        if (i > 0)
+            ldr[i - 1] = toMat(previousPhoto);
+        previousPhoto = std::move(photo);
     }
+    if (nbrLDR > 0)
+        ldr.back() = toMat(previousPhoto);
 
     // Reset the shutterspeed
     _gcamera->setAttribute("shutterspeed", {defaultSpeed});
@@ -420,20 +573,32 @@ cv::Mat3f ColorCalibrator::captureHDR(unsigned int nbrLDR, double step, bool com
         calibrate->process(ldr, _crf, expositionDurations);
     }
 
-    cv::Mat3f hdr;
-    cv::Ptr<cv::MergeDebevec> mergeDebevec = cv::createMergeDebevec();
-    mergeDebevec->process(ldr, hdr, expositionDurations, _crf);
-
-    for (int y = 0; y < hdr.rows; ++y)
-        for (int x = 0; x < hdr.cols; ++x)
-        {
-            auto pixelValue = hdr.at<cv::Vec3f>(y, x);
-            pixelValue[0] = max(0.f, pixelValue[0]);
-            pixelValue[1] = max(0.f, pixelValue[1]);
-            pixelValue[2] = max(0.f, pixelValue[2]);
-        }
+    // Only the region of interest is merged, split in bands merged in parallel
+    const auto imageRect = cv::Rect(0, 0, ldr[0].cols, ldr[0].rows);
+    const auto mergeRect = roi.empty() ? imageRect : (roi & imageRect);
+    cv::Mat3f hdr = cv::Mat3f::zeros(ldr[0].rows, ldr[0].cols);
+    if (mergeRect.empty())
+        return hdr;
+
+    const auto bandCount = std::max(1u, std::min(ThreadPool::get().getThreadCount(), static_cast<unsigned int>(mergeRect.height)));
+    ThreadPool::get().runParallel(bandCount, [&](unsigned int band) {
+        const int firstRow = mergeRect.y + mergeRect.height * band / bandCount;
+        const int lastRow = mergeRect.y + mergeRect.height * (band + 1) / bandCount;
+        const auto bandRect = cv::Rect(mergeRect.x, firstRow, mergeRect.width, lastRow - firstRow);
+
+        vector<cv::Mat> bandLdr(nbrLDR);
+        for (unsigned int i = 0; i < nbrLDR; ++i)
+            bandLdr[i] = ldr[i](bandRect).clone();
+
+        cv::Mat bandHdr;
+        cv::Ptr<cv::MergeDebevec> mergeDebevec = cv::createMergeDebevec();
+        mergeDebevec->process(bandLdr, bandHdr, expositionDurations, _crf);
+        cv::max(bandHdr, 0.f, bandHdr);
+        bandHdr.copyTo(hdr(bandRect));
+    });
 
-    cv::imwrite("/tmp/splash_hdr.hdr", hdr);
+    if (_saveHDR)
+        cv::imwrite("/tmp/splash_hdr.hdr", hdr);
     Log::get() << Log::MESSAGE << "ColorCalibrator::" << __FUNCTION__ << " - HDRI computed" << Log::endl;
 
     return hdr;
@@ -528,16 +693,21 @@ float ColorCalibrator::findCorrectExposure()
     while (true)
     {
         _gcamera->getAttribute("shutterspeed", res);
-        _gcamera->update();
-        ImageBuffer img = _gcamera->get();
-        ImageBufferSpec spec = _gcamera->getSpec();
+        auto photo = _gcamera->captureAsync();
+        auto img = photo.valid() ? photo.get() : nullptr;
+        if (!img)
+        {
+            Log::get() << Log::WARNING << "ColorCalibrator::" << __FUNCTION__ << " - Unable to capture a photo" << Log::endl;
+            break;
+        }
+        const ImageBufferSpec& spec = img->getSpec();
 
         // Exposure is found from a centered area, covering 4% of the frame
         int roiSize = spec.width / 5;
         unsigned long total = roiSize * roiSize;
         unsigned long sum = 0;
 
-        uint8_t* pixel = reinterpret_cast<uint8_t*>(img.data());
+        uint8_t* pixel = reinterpret_cast<uint8_t*>(img->data());
         for (uint32_t y = spec.height / 2 - roiSize / 2; y < spec.height / 2 + roiSize / 2; ++y)
             for (uint32_t x = spec.width / 2 - roiSize / 2; x < spec.width / 2 + roiSize / 2; ++x)
             {
@@ -685,6 +855,69 @@ vector<bool> ColorCalibrator::getMaskROI(const cv::Mat3f& image)
     return mask;
 }
 
+/*************/
+cv::Rect ColorCalibrator::getMaskBoundingBox(const vector<bool>& mask, int width)
+{
+    if (width <= 0)
+        return {};
+
+    int minX = width, minY = numeric_limits<int>::max();
+    int maxX = -1, maxY = -1;
+    for (size_t i = 0; i < mask.size(); ++i)
+    {
+        if (!mask[i])
+            continue;
+        const int x = static_cast<int>(i % width);
+        const int y = static_cast<int>(i / width);
+        minX = std::min(minX, x);
+        maxX = std::max(maxX, x);
+        minY = std::min(minY, y);
+        maxY = std::max(maxY, y);
+    }
+
+    if (maxX < 0)
+        return {};
+    return cv::Rect(minX, minY, maxX - minX + 1, maxY - minY + 1);
+}
+
+/*************/
+vector<vector<size_t>> ColorCalibrator::getMeasureGroups() const
+{
+    vector<vector<size_t>> groups;
+    for (size_t index = 0; index < _calibrationParams.size(); ++index)
+    {
+        const auto& params = _calibrationParams[index];
+        auto groupIt = groups.end();
+        if (_parallelMeasure)
+        {
+            // Projectors are added to the first group they do not overlap with
+            groupIt = find_if(groups.begin(), groups.end(), [&](const vector<size_t>& group) {
+                return all_of(group.begin(), group.end(), [&](size_t other) {
+                    const auto& otherParams = _calibrationParams[other];
+                    if ((params.boundingROI & otherParams.boundingROI).empty())
+                        return true;
+                    if (params.maskROI.size() != otherParams.maskROI.size())
+                        return false;
+                    for (size_t i = 0; i < params.maskROI.size(); ++i)
+                        if (params.maskROI[i] && otherParams.maskROI[i])
+                            return false;
+                    return true;
+                });
+            });
+        }
+
+        if (groupIt == groups.end())
+            groups.push_back({index});
+        else
+            groupIt->push_back(index);
+    }
+
+    if (_parallelMeasure)
+        Log::get() << Log::MESSAGE << "ColorCalibrator::" << __FUNCTION__ << " - " << _calibrationParams.size() << " projectors measured in " << groups.size() << " groups" << Log::endl;
+
+    return groups;
+}
+
 /*************/
 vector<float> ColorCalibrator::getMeanValue(const cv::Mat3f& image, vector<int> coords, int boxSize)
 {
@@ -882,6 +1115,34 @@ void ColorCalibrator::registerAttributes()
         {'r'});
     setAttributeDescription("hdrStep", "Set the step between two images for HDRI");
 
+    addAttribute("parallelMeasure",
+        [&](const Values& args) {
+            _parallelMeasure = args[0].as<bool>();
+            return true;
+        },
+        [&]() -> Values { return {_parallelMeasure}; },
+        {'b'});
+    setAttributeDescription("parallelMeasure", "If set to true, projectors which do not overlap are measured simultaneously");
+
+    addAttribute("saveHDR",
+        [&](const Values& args) {
+            _saveHDR = args[0].as<bool>();
+            return true;
+        },
+        [&]() -> Values { return {_saveHDR}; },
+        {'b'});
+    setAttributeDescription("saveHDR", "If set to true, the last captured HDRI is saved to /tmp/splash_hdr.hdr for debugging purposes");
+
+    addAttribute("useResponseCache",
+        [&](const Values& args) {
+            _useResponseCache = args[0].as<bool>();
+            return true;
+        },
+        [&]() -> Values { return {_useResponseCache}; },
+        {'b'});
+    setAttributeDescription("useResponseCache",
+        "If set to true, the camera response function is cached on disk, and reused by the next calibrations with the same camera model, lens, aperture and ISO");
+
     addAttribute("equalizeMethod",
         [&](const Values& args) {
             _equalizationMethod = std::max(0, std::min(2, args[0].as<int>()));
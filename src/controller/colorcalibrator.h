@@ -79,6 +79,7 @@ class ColorCalibrator : public ControllerObject
         std::string camName{};
         std::vector<int> camROI{0, 0};
         std::vector<bool> maskROI;
+        cv::Rect boundingROI{}; //!< Bounding box of maskROI, the only region merged when measuring colors
         RgbValue whitePoint;
         RgbValue whiteBalance;
         RgbValue minValues;
@@ -93,6 +94,8 @@ class ColorCalibrator : public ControllerObject
     //
     std::shared_ptr<Image_GPhoto> _gcamera{nullptr};
     cv::Mat _crf{};
+    uint64_t _crfKey{0};          //!< Key of the camera and settings _crf has been computed for, see computeResponseKey
+    bool _useResponseCache{true}; //!< If true, the camera response functions are cached on disk and reused for the same camera and settings
 
     unsigned int _colorCurveSamples{5};     //!< Number of samples for each channels to create the color curves
     double _displayDetectionThreshold{1.f}; //!< Coefficient applied while detecting displays / projectors, increase to get rid of ambiant lights
@@ -100,6 +103,8 @@ class ColorCalibrator : public ControllerObject
     int _imagePerHDR{1};                    //!< Number of images taken for each color-measuring HDR
     double _hdrStep{1.0};                   //!< Stops between images taken for color-measuring HDR
     int _equalizationMethod{2};
+    bool _parallelMeasure{false}; //!< If true, projectors which do not overlap are measured simultaneously
+    bool _saveHDR{false}; //!< If true, the last HDR image is saved to /tmp/splash_hdr.hdr for debugging purposes
 
     std::vector<CalibrationParams> _calibrationParams{};
 
@@ -111,9 +116,42 @@ class ColorCalibrator : public ControllerObject
      * \param nbrLDR Low dynamic ranger images count to use to create the HDR
      * \param step Stops between successive LDR images
      * \param computeResponseOnly If true, stop after the computation of the camera response function
+     * \param roi Region to merge, the HDR image being black outside of it. The whole image is merged if empty
      * \return Return the HDR image
      */
-    cv::Mat3f captureHDR(unsigned int nbrLDR = 3, double step = 1.0, bool computeResponseOnly = false);
+    cv::Mat3f captureHDR(unsigned int nbrLDR = 3, double step = 1.0, bool computeResponseOnly = false, const cv::Rect& roi = {});
+
+    /**
+     * \brief Compute the key identifying the camera response function of the connected camera, from its model, lens and settings
+     * \return Return the key
+     */
+    uint64_t computeResponseKey() const;
+
+    /**
+     * \brief Get the path of the cache file for the given key
+     * \param key Response key
+     * \return Return the cache file path
+     */
+    static std::string getResponseCacheFilePath(uint64_t key);
+
+    /**
+     * \brief Read a camera response function from the cache
+     * \param key Response key
+     * \return Return the camera response function, empty if the key is not cached
+     */
+    static cv::Mat readResponseFromCache(uint64_t key);
+
+    /**
+     * \brief Write a camera response function to the cache
+     * \param key Response key
+     * \param crf Camera response function
+     */
+    static void writeResponseToCache(uint64_t key, const cv::Mat& crf);
+
+    /**
+     * \brief Make sure the camera response function matches the connected camera, reading it from the cache or computing it if needed
+     */
+    void updateResponse();
 
     /**
      * \brief Compute the inverse projection transformation function, typically correcting the projector non linearity for all three channels
@@ -141,6 +179,21 @@ class ColorCalibrator : public ControllerObject
      */
     std::vector<bool> getMaskROI(const cv::Mat3f& image);
 
+    /**
+     * \brief Get the bounding box of a mask
+     * \param mask Mask, as returned by getMaskROI
+     * \param width Width of the masked image
+     * \return Return the bounding box, empty if the mask is empty
+     */
+    cv::Rect getMaskBoundingBox(const std::vector<bool>& mask, int width);
+
+    /**
+     * \brief Group the projectors which can be measured simultaneously, i.e. whose masks do not overlap
+     * Each projector is in its own group, unless parallel measurement is enabled
+     * \return Return the groups, as indices in the calibration parameters
+     */
+    std::vector<std::vector<size_t>> getMeasureGroups() const;
+
     /**
      * \brief Get the mean value of the area around the given coords
      * \param image Input image
@@ -50,7 +50,7 @@ vector<shared_ptr<GraphObject>> ControllerObject::getObjectsPtr(const vector<str
 /*************/
 string ControllerObject::getObjectAlias(const std::string& name) const
 {
-    auto tree = _root->getTree();
+    auto tree = _root->getTreeSnapshot();
 
     for (const auto& rootName : tree->getBranchList())
     {
@@ -69,7 +69,7 @@ string ControllerObject::getObjectAlias(const std::string& name) const
 unordered_map<string, string> ControllerObject::getObjectAliases() const
 {
     auto aliases = unordered_map<string, string>();
-    auto tree = _root->getTree();
+    auto tree = _root->getTreeSnapshot();
 
     for (const auto& rootName : tree->getBranchList())
     {
@@ -94,7 +94,7 @@ unordered_map<string, string> ControllerObject::getObjectAliases() const
 vector<string> ControllerObject::getObjectList() const
 {
     auto names = vector<string>();
-    auto tree = _root->getTree();
+    auto tree = _root->getTreeSnapshot();
 
     for (const auto& rootName : tree->getBranchList())
     {
@@ -112,7 +112,7 @@ vector<string> ControllerObject::getObjectList() const
 /*************/
 Values ControllerObject::getObjectAttributeDescription(const string& name, const string& attr) const
 {
-    auto tree = _root->getTree();
+    auto tree = _root->getTreeSnapshot();
     for (const auto& rootName : tree->getBranchList())
     {
         auto objectPath = "/" + rootName + "/objects/" + name;
@@ -132,7 +132,7 @@ Values ControllerObject::getObjectAttributeDescription(const string& name, const
 /*************/
 Values ControllerObject::getObjectAttribute(const string& name, const string& attr) const
 {
-    auto tree = _root->getTree();
+    auto tree = _root->getTreeSnapshot();
 
     for (const auto& rootName : tree->getBranchList())
     {
@@ -147,11 +147,31 @@ Values ControllerObject::getObjectAttribute(const string& name, const string& at
     return {};
 }
 
+/*************/
+vector<Values> ControllerObject::getObjectsAttributes(const vector<pair<string, string>>& attributes) const
+{
+    // All the attributes are read from the same snapshot, so that no update comes in between
+    auto tree = _root->getTreeSnapshot();
+    auto rootList = tree->getBranchList();
+
+    vector<Values> values;
+    values.reserve(attributes.size());
+    for (const auto& [name, attr] : attributes)
+    {
+        Value value;
+        for (const auto& rootName : rootList)
+            if (tree->getValueForLeafAt("/" + rootName + "/objects/" + name + "/attributes/" + attr, value))
+                break;
+        values.push_back(value.as<Values>());
+    }
+    return values;
+}
+
 /*************/
 unordered_map<string, Values> ControllerObject::getObjectAttributes(const string& name) const
 {
     auto attributes = unordered_map<string, Values>();
-    auto tree = _root->getTree();
+    auto tree = _root->getTreeSnapshot();
 
     for (const auto& rootName : tree->getBranchList())
     {
@@ -171,11 +191,35 @@ unordered_map<string, Values> ControllerObject::getObjectAttributes(const string
     return attributes;
 }
 
+/*************/
+unordered_map<string, unordered_map<string, Values>> ControllerObject::getRootBranchValues(const string& branch) const
+{
+    unordered_map<string, unordered_map<string, Values>> rootValues;
+    auto tree = _root->getTreeSnapshot();
+
+    for (const auto& rootName : tree->getBranchList())
+    {
+        auto branchPath = "/" + rootName + "/" + branch;
+        if (!tree->hasBranchAt(branchPath))
+            continue;
+
+        auto& values = rootValues[rootName];
+        for (const auto& leafName : tree->getLeafListAt(branchPath))
+        {
+            Value value;
+            if (tree->getValueForLeafAt(branchPath + "/" + leafName, value))
+                values[leafName] = value.as<Values>();
+        }
+    }
+
+    return rootValues;
+}
+
 /*************/
 unordered_map<string, vector<string>> ControllerObject::getObjectLinks() const
 {
     auto links = unordered_map<string, vector<string>>();
-    auto tree = _root->getTree();
+    auto tree = _root->getTreeSnapshot();
 
     for (const auto& rootName : tree->getBranchList())
     {
@@ -210,7 +254,7 @@ unordered_map<string, vector<string>> ControllerObject::getObjectLinks() const
 unordered_map<string, vector<string>> ControllerObject::getObjectReversedLinks() const
 {
     auto links = unordered_map<string, vector<string>>();
-    auto tree = _root->getTree();
+    auto tree = _root->getTreeSnapshot();
 
     for (const auto& rootName : tree->getBranchList())
     {
@@ -266,7 +310,7 @@ vector<string> ControllerObject::getTypesFromCategory(const GraphObject::Categor
 map<string, string> ControllerObject::getObjectTypes() const
 {
     auto types = map<string, string>();
-    auto tree = _root->getTree();
+    auto tree = _root->getTreeSnapshot();
 
     auto feedListFunc = [&](const string& branch) {
         auto objectPath = "/" + branch + "/objects";
@@ -302,7 +346,7 @@ vector<string> ControllerObject::getObjectsOfType(const string& type) const
 {
     vector<string> objectList;
 
-    auto tree = _root->getTree();
+    auto tree = _root->getTreeSnapshot();
     for (const auto& rootName : tree->getBranchList())
     {
         auto objectsPath = "/" + rootName + "/objects";
@@ -358,7 +402,7 @@ void ControllerObject::setInScene(const string& name, const Values& values) cons
 /*************/
 Values ControllerObject::getWorldAttribute(const string& attr) const
 {
-    auto tree = _root->getTree();
+    auto tree = _root->getTreeSnapshot();
     auto attrPath = "/world/attributes/" + attr;
     if (!tree->hasLeafAt(attrPath))
         return {};
@@ -385,6 +429,22 @@ void ControllerObject::setObjectAttribute(const string& name, const string& attr
     }
 }
 
+/*************/
+void ControllerObject::setObjectsAttributes(const vector<tuple<string, string, Values>>& attributes) const
+{
+    Values calls;
+    for (const auto& [name, attr, values] : attributes)
+        if (!name.empty())
+            calls.push_back(Values({name, attr, values}));
+    if (calls.empty())
+        return;
+
+    // Objects can live in any root object, each of them applies the calls for the ones it holds
+    auto tree = _root->getTree();
+    for (const auto& branchName : tree->getBranchList())
+        _root->addTreeCommand(branchName, RootObject::Command::callObjects, calls);
+}
+
 /*************/
 void ControllerObject::setObjectsOfType(const string& type, const string& attr, const Values& values) const
 {
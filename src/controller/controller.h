@@ -27,6 +27,8 @@
 
 #include <chrono>
 #include <string>
+#include <tuple>
+#include <utility>
 #include <vector>
 
 #include "./core/constants.h"
@@ -118,6 +120,20 @@ class ControllerObject : public GraphObject
      */
     std::unordered_map<std::string, Values> getObjectAttributes(const std::string& name) const;
 
+    /**
+     * \brief Get multiple attributes at once, all read from the same state of the tree
+     * \param attributes List of object and attribute names
+     * \return Return the values of the attributes, in the same order, empty for the ones which do not exist
+     */
+    std::vector<Values> getObjectsAttributes(const std::vector<std::pair<std::string, std::string>>& attributes) const;
+
+    /**
+     * \brief Get the values of the leaves of a branch, for the World and each Scene, all read from the same state of the tree
+     * \param branch Branch name, relative to the branch of the World or Scene, e.g. durations or stats
+     * \return Return the leaf values per leaf name, per World or Scene name
+     */
+    std::unordered_map<std::string, std::unordered_map<std::string, Values>> getRootBranchValues(const std::string& branch) const;
+
     /**
      * \brief Get the links between all objects, from parents to children
      * \return Return an unordered_map of the links, from one object to potentially many others
@@ -218,6 +234,14 @@ class ControllerObject : public GraphObject
      */
     void setObjectAttribute(const std::string& name, const std::string& attr, const Values& values = {}) const;
 
+    /**
+     * \brief Set multiple attributes at once
+     * The changes are sent to each root object as a single command, and are applied
+     * together at the beginning of one of its loops, in the given order
+     * \param attributes List of object names, attribute names and values
+     */
+    void setObjectsAttributes(const std::vector<std::tuple<std::string, std::string, Values>>& attributes) const;
+
     /**
      * \brief Set the given attribute for all objets of the given type
      * \param type Object type
@@ -1,9 +1,25 @@
 #include "./controller/controller_blender.h"
 
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <limits>
+#include <sstream>
+#include <string_view>
+
 #include "./core/scene.h"
 #include "./graphics/camera.h"
 #include "./graphics/geometry.h"
 #include "./graphics/object.h"
+#include "./mesh/mesh.h"
+#include "./utils/log.h"
+#include "./utils/osutils.h"
+
+#define SPLASH_BLENDER_CACHE_MAGIC "SPLBLND"
+#define SPLASH_BLENDER_CACHE_VERSION 1
 
 using namespace std;
 
@@ -54,53 +70,147 @@ void Blender::update()
 
     if (_computeBlending && (!_blendingComputed || _continuousBlending))
     {
+        auto forced = !_blendingComputed;
         _blendingComputed = true;
 
         // Only the master scene computes the blending
         if (isMaster)
         {
             auto cameras = getObjectsPtr(getObjectsOfType("camera"));
-            auto objects = getObjLinkedToCameras();
+            if (cameras.size() == 0)
+                return;
+
+            auto links = getObjectLinks();
+            unordered_map<string, vector<string>> cameraObjects;
+            for (auto& camera : cameras)
+                for (auto& linked : links[camera->getName()])
+                    if (dynamic_pointer_cast<Object>(getObjectPtr(linked)))
+                        cameraObjects[camera->getName()].push_back(linked);
+
+            queueAffectedObjects(cameraObjects);
+
+            // In continuous mode, the work is spread over multiple updates by computing one object at a time.
+            // This is not needed for the image blending, whose cost does not depend on the objects
+            auto isImageBlending = _blendingMethod == "image";
+            vector<shared_ptr<Object>> objects;
+            while (!_pendingObjects.empty() && (!_continuousBlending || isImageBlending || objects.empty()))
+            {
+                auto object = dynamic_pointer_cast<Object>(getObjectPtr(*_pendingObjects.begin()));
+                _pendingObjects.erase(_pendingObjects.begin());
+                if (object)
+                    objects.push_back(object);
+            }
+
+            if (objects.empty())
+            {
+                // The other scenes wait for a notification after a forced update
+                if (forced)
+                    setObjectAttribute(_name, "blendingUpdated", {});
+                return;
+            }
+
+            // The blending of an object depends on all the cameras seeing it
+            vector<shared_ptr<Camera>> involvedCameras;
+            for (auto& it : cameras)
+            {
+                const auto& linkedObjects = cameraObjects[it->getName()];
+                auto isInvolved = any_of(objects.begin(), objects.end(), [&](const shared_ptr<Object>& object) {
+                    return find(linkedObjects.begin(), linkedObjects.end(), object->getName()) != linkedObjects.end();
+                });
+                if (isInvolved)
+                    involvedCameras.push_back(dynamic_pointer_cast<Camera>(it));
+            }
+
+            if (isImageBlending)
+            {
+                computeBlendingMaps(cameras, involvedCameras);
+                for (auto& object : objects)
+                {
+                    object->setAttribute("activateVertexBlending", {false});
+                    object->setAttribute("activateImageBlending", {true});
+                }
+
+                setObjectAttribute(_name, "blendingUpdated", {});
+                return;
+            }
+
+            vector<shared_ptr<Geometry>> geometries;
+            for (auto& object : objects)
+                for (auto& linked : links[object->getName()])
+                    if (auto geometry = dynamic_pointer_cast<Geometry>(getObjectPtr(linked)))
+                        geometries.push_back(geometry);
+
+            // In "once" mode, the blending is restored from the cache if nothing changed since it was computed
+            auto useCache = _useCache && !_continuousBlending;
+            auto cacheKey = useCache ? computeCacheKey(objects, involvedCameras, cameraObjects, links) : 0;
 
-            if (cameras.size() != 0)
+            unordered_map<string, shared_ptr<SerializedObject>> serializedGeometries;
+            if (useCache)
             {
-                for (auto& it : objects)
-                    dynamic_pointer_cast<Object>(it)->resetTessellation();
+                serializedGeometries = readFromCache(cacheKey);
+                auto isCached = !serializedGeometries.empty() && all_of(geometries.begin(), geometries.end(), [&](const shared_ptr<Geometry>& geometry) {
+                    return serializedGeometries.find(geometry->getName()) != serializedGeometries.end();
+                });
+
+                if (isCached)
+                {
+                    for (auto& geometry : geometries)
+                        geometry->setAlternativeBuffers(serializedGeometries[geometry->getName()]);
+                    Log::get() << Log::MESSAGE << "Blender::" << __FUNCTION__ << " - Blending loaded from cache" << Log::endl;
+                }
+                else
+                {
+                    serializedGeometries.clear();
+                }
+            }
+
+            if (serializedGeometries.empty())
+            {
+                // The blending is computed from the finest level of detail needed by the cameras
+                for (auto& object : objects)
+                {
+                    auto level = numeric_limits<int>::max();
+                    for (auto& camera : involvedCameras)
+                        level = std::min(level, camera->computeLevelOfDetail(*object));
+                    object->setLevelOfDetail(involvedCameras.empty() ? 0 : level);
+                    object->resetTessellation();
+                }
 
                 // Tessellate
-                for (auto& it : cameras)
+                for (auto& camera : involvedCameras)
                 {
-                    auto camera = dynamic_pointer_cast<Camera>(it);
                     camera->computeVertexVisibility();
-                    camera->blendingTessellateForCurrentCamera();
+                    camera->blendingTessellateForCurrentCamera(objects);
                 }
 
-                for (auto& it : objects)
-                    dynamic_pointer_cast<Object>(it)->resetBlendingAttribute();
+                for (auto& object : objects)
+                    object->resetBlendingAttribute();
 
                 // Compute each camera contribution
-                for (auto& it : cameras)
+                for (auto& camera : involvedCameras)
                 {
-                    auto camera = dynamic_pointer_cast<Camera>(it);
                     camera->computeVertexVisibility();
-                    camera->computeBlendingContribution();
+                    camera->computeBlendingContribution(objects);
                 }
-            }
-            else
-            {
-                return;
+
+                for (auto& geometry : geometries)
+                    serializedGeometries[geometry->getName()] = geometry->serialize();
+
+                if (useCache)
+                    writeToCache(cacheKey, serializedGeometries);
             }
 
+            for (auto& camera : involvedCameras)
+                camera->resetBlendingMap();
             for (auto& object : objects)
+            {
+                object->setAttribute("activateImageBlending", {false});
                 object->setAttribute("activateVertexBlending", {true});
+            }
 
-            // If there are some other scenes, send them the blending
-            auto geometries = getObjectsPtr(getObjectsOfType("geometry"));
+            // If there are some other scenes, send them the blending of the updated objects
             for (auto& geometry : geometries)
-            {
-                auto serializedGeometry = dynamic_pointer_cast<Geometry>(geometry)->serialize();
-                sendBuffer(geometry->getName(), serializedGeometry);
-            }
+                sendBuffer(geometry->getName(), serializedGeometries[geometry->getName()]);
 
             setObjectAttribute(_name, "blendingUpdated", {});
         }
@@ -108,9 +218,10 @@ void Blender::update()
         else
         {
             // Wait for the master scene to notify us that the blending was updated
-            // Note that we do not wait more that 2 seconds
+            // Note that we do not wait more that 2 seconds, and not at all in continuous mode
+            // as the master scene only sends updates when something changed
             unique_lock<mutex> updateBlendingLock(_vertexBlendingMutex);
-            int maxSecElapsed = 2;
+            int maxSecElapsed = _continuousBlending ? 0 : 2;
             while (!_vertexBlendingReceptionStatus && maxSecElapsed)
             {
                 _vertexBlendingCondition.wait_for(updateBlendingLock, chrono::seconds(1));
@@ -121,8 +232,12 @@ void Blender::update()
             {
                 _vertexBlendingReceptionStatus = false;
 
+                auto isImageBlending = _blendingMethod == "image";
                 for (auto& object : getObjLinkedToCameras())
-                    object->setAttribute("activateVertexBlending", {true});
+                {
+                    object->setAttribute("activateVertexBlending", {!isImageBlending});
+                    object->setAttribute("activateImageBlending", {isImageBlending});
+                }
             }
         }
     }
@@ -145,8 +260,253 @@ void Blender::update()
         }
 
         for (auto& object : objects)
+        {
             object->setAttribute("activateVertexBlending", {false});
+            object->setAttribute("activateImageBlending", {false});
+        }
+
+        for (auto& it : cameras)
+        {
+            if (auto camera = dynamic_pointer_cast<Camera>(it); camera)
+            {
+                camera->resetBlendingMap();
+                camera->releaseBlendingDepth();
+            }
+        }
+
+        resetChangeTracking();
+    }
+}
+
+/*************/
+void Blender::computeBlendingMaps(const vector<shared_ptr<GraphObject>>& cameras, const vector<shared_ptr<Camera>>& involvedCameras)
+{
+    // Any camera may overlap with the involved ones, so all their depths are needed
+    vector<shared_ptr<Camera>> allCameras;
+    for (auto& it : cameras)
+        if (auto camera = dynamic_pointer_cast<Camera>(it); camera)
+            allCameras.push_back(camera);
+
+    for (auto& camera : allCameras)
+        camera->renderBlendingDepth();
+
+    auto tree = _root->getTree();
+    for (auto& camera : involvedCameras)
+    {
+        camera->computeBlendingMap(allCameras);
+
+        // Ghost cameras are rendered by another Scene, which gets the map
+        if (tree->hasLeafAt("/" + _root->getName() + "/objects/" + camera->getName() + "/ghost"))
+            setObjectAttribute(camera->getName(), "blendingMap", camera->getBlendingMap());
     }
+
+    // The depths are kept in continuous mode, as they are rendered again soon
+    if (!_continuousBlending)
+        for (auto& camera : allCameras)
+            camera->releaseBlendingDepth();
+}
+
+/*************/
+void Blender::queueAffectedObjects(const unordered_map<string, vector<string>>& cameraObjects)
+{
+    // Cameras which moved, or which are not linked to the same objects as before
+    set<string> changedCameras;
+    for (const auto& [cameraName, objectNames] : cameraObjects)
+    {
+        auto camera = dynamic_pointer_cast<Camera>(getObjectPtr(cameraName));
+        if (!camera)
+            continue;
+
+        auto state = camera->getBlendingState();
+        auto previousObjectsIt = _cameraObjects.find(cameraName);
+        if (_cameraStates[cameraName] != state || previousObjectsIt == _cameraObjects.end() || previousObjectsIt->second != objectNames)
+            changedCameras.insert(cameraName);
+        _cameraStates[cameraName] = state;
+    }
+
+    // The objects previously seen by a changed or removed camera lose its contribution
+    for (const auto& [cameraName, objectNames] : _cameraObjects)
+    {
+        if (changedCameras.count(cameraName) != 0)
+        {
+            _pendingObjects.insert(objectNames.begin(), objectNames.end());
+        }
+        else if (cameraObjects.find(cameraName) == cameraObjects.end())
+        {
+            _pendingObjects.insert(objectNames.begin(), objectNames.end());
+            _cameraStates.erase(cameraName);
+        }
+    }
+
+    // Objects which moved or whose mesh changed
+    unordered_map<string, vector<double>> objectStates;
+    for (const auto& [cameraName, objectNames] : cameraObjects)
+    {
+        for (const auto& objectName : objectNames)
+        {
+            if (objectStates.find(objectName) != objectStates.end())
+                continue;
+            auto object = dynamic_pointer_cast<Object>(getObjectPtr(objectName));
+            if (object)
+                objectStates[objectName] = object->getBlendingState();
+        }
+    }
+
+    set<string> changedObjects;
+    for (const auto& [objectName, state] : objectStates)
+    {
+        auto previousStateIt = _objectStates.find(objectName);
+        if (previousStateIt == _objectStates.end() || previousStateIt->second != state)
+            changedObjects.insert(objectName);
+    }
+
+    // A changed object can occlude or reveal the other objects seen by the same cameras
+    for (const auto& [cameraName, objectNames] : cameraObjects)
+    {
+        auto isAffected = changedCameras.count(cameraName) != 0
+            || any_of(objectNames.begin(), objectNames.end(), [&](const string& objectName) { return changedObjects.count(objectName) != 0; });
+        if (isAffected)
+            _pendingObjects.insert(objectNames.begin(), objectNames.end());
+    }
+
+    _objectStates = std::move(objectStates);
+    _cameraObjects = cameraObjects;
+}
+
+/*************/
+uint64_t Blender::computeCacheKey(const vector<shared_ptr<Object>>& objects,
+    const vector<shared_ptr<Camera>>& cameras,
+    const unordered_map<string, vector<string>>& cameraObjects,
+    const unordered_map<string, vector<string>>& links)
+{
+    string keyData;
+    auto appendString = [&](const string& value) {
+        keyData.append(value);
+        keyData.push_back('\0');
+    };
+    auto appendValues = [&](const auto& values) { keyData.append(reinterpret_cast<const char*>(values.data()), values.size() * sizeof(values[0])); };
+
+    // Mesh timestamps are not stable across runs, the mesh content is hashed instead
+    for (const auto& object : objects)
+    {
+        appendString(object->getName());
+        appendValues(object->getBlendingState(false));
+
+        auto linksIt = links.find(object->getName());
+        if (linksIt == links.end())
+            continue;
+        for (const auto& linked : linksIt->second)
+        {
+            auto geometry = dynamic_pointer_cast<Geometry>(getObjectPtr(linked));
+            if (!geometry)
+                continue;
+            appendString(geometry->getName());
+
+            auto mesh = geometry->getMesh();
+            if (!mesh)
+                continue;
+            appendValues(mesh->getVertCoords());
+            appendValues(mesh->getUVCoords());
+            appendValues(mesh->getNormals());
+        }
+    }
+
+    auto sortedCameras = cameras;
+    sort(sortedCameras.begin(), sortedCameras.end(), [](const shared_ptr<Camera>& lhs, const shared_ptr<Camera>& rhs) { return lhs->getName() < rhs->getName(); });
+    for (const auto& camera : sortedCameras)
+    {
+        appendString(camera->getName());
+        appendValues(camera->getBlendingState());
+
+        auto cameraObjectsIt = cameraObjects.find(camera->getName());
+        if (cameraObjectsIt != cameraObjects.end())
+            for (const auto& objectName : cameraObjectsIt->second)
+                appendString(objectName);
+    }
+
+    return hash<string_view>()(string_view(keyData));
+}
+
+/*************/
+string Blender::getCacheFilePath(uint64_t key)
+{
+    stringstream path;
+    path << Utils::getCachePath() << "/blending/" << hex << setw(16) << setfill('0') << key << ".splashblend";
+    return path.str();
+}
+
+/*************/
+unordered_map<string, shared_ptr<SerializedObject>> Blender::readFromCache(uint64_t key)
+{
+    ifstream file(getCacheFilePath(key), ios::in | ios::binary);
+    if (!file)
+        return {};
+
+    char magic[sizeof(SPLASH_BLENDER_CACHE_MAGIC)];
+    uint32_t version = 0;
+    uint32_t count = 0;
+    file.read(magic, sizeof(magic));
+    file.read(reinterpret_cast<char*>(&version), sizeof(version));
+    file.read(reinterpret_cast<char*>(&count), sizeof(count));
+    if (!file || memcmp(magic, SPLASH_BLENDER_CACHE_MAGIC, sizeof(magic)) != 0 || version != SPLASH_BLENDER_CACHE_VERSION)
+        return {};
+
+    unordered_map<string, shared_ptr<SerializedObject>> geometries;
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        uint32_t nameSize = 0;
+        file.read(reinterpret_cast<char*>(&nameSize), sizeof(nameSize));
+        if (!file || nameSize > 4096)
+            return {};
+        string name(nameSize, '\0');
+        file.read(name.data(), nameSize);
+
+        uint64_t dataSize = 0;
+        file.read(reinterpret_cast<char*>(&dataSize), sizeof(dataSize));
+        if (!file || dataSize < sizeof(int))
+            return {};
+
+        auto serialized = make_shared<SerializedObject>(static_cast<int>(dataSize));
+        file.read(reinterpret_cast<char*>(serialized->data()), dataSize);
+        if (!file)
+            return {};
+
+        // Same layout check as Geometry::deserialize
+        uint32_t verticesNumber = *reinterpret_cast<int*>(serialized->data());
+        if (dataSize != verticesNumber * 4 * 14 + 4)
+            return {};
+
+        geometries[name] = serialized;
+    }
+
+    return geometries;
+}
+
+/*************/
+void Blender::writeToCache(uint64_t key, const unordered_map<string, shared_ptr<SerializedObject>>& geometries)
+{
+    Utils::writeCacheFile(getCacheFilePath(key), SPLASH_BLENDER_CACHE_MAGIC, SPLASH_BLENDER_CACHE_VERSION, [&](ofstream& file) {
+        uint32_t count = geometries.size();
+        file.write(reinterpret_cast<const char*>(&count), sizeof(count));
+        for (const auto& [name, serialized] : geometries)
+        {
+            uint32_t nameSize = name.size();
+            uint64_t dataSize = serialized->size();
+            file.write(reinterpret_cast<const char*>(&nameSize), sizeof(nameSize));
+            file.write(name.data(), nameSize);
+            file.write(reinterpret_cast<const char*>(&dataSize), sizeof(dataSize));
+            file.write(reinterpret_cast<const char*>(serialized->data()), dataSize);
+        }
+    });
+}
+
+/*************/
+void Blender::resetChangeTracking()
+{
+    _cameraStates.clear();
+    _objectStates.clear();
+    _cameraObjects.clear();
+    _pendingObjects.clear();
 }
 
 /*************/
@@ -185,6 +545,37 @@ void Blender::registerAttributes()
         {'s'});
     setAttributeDescription("mode", "Set the blending mode. Can be 'none', 'once' or 'continuous'");
 
+    addAttribute("method",
+        [&](const Values& args) {
+            auto method = args[0].as<string>();
+            if (method != "vertex" && method != "image")
+                return false;
+
+            // Switching method computes the blending of all the objects again
+            if (method != _blendingMethod)
+            {
+                _blendingMethod = method;
+                _blendingComputed = false;
+                resetChangeTracking();
+            }
+
+            return true;
+        },
+        [&]() -> Values { return {_blendingMethod}; },
+        {'s'});
+    setAttributeDescription("method",
+        "Set the blending method. Can be 'vertex', which tessellates the objects near the blending borders, or 'image' which computes a blending map for each camera, "
+        "independently of the density of the meshes");
+
+    addAttribute("cache",
+        [&](const Values& args) {
+            _useCache = args[0].as<bool>();
+            return true;
+        },
+        [&]() -> Values { return {_useCache}; },
+        {'b'});
+    setAttributeDescription("cache", "If true, the blending computed in 'once' mode is cached on disk and reused while the cameras and meshes do not change");
+
     addAttribute("blendingUpdated", [&](const Values&) {
         _vertexBlendingReceptionStatus = true;
         _vertexBlendingCondition.notify_one();
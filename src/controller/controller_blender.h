@@ -25,13 +25,22 @@
 #ifndef SPLASH_CONTROLLER_BLENDER_H
 #define SPLASH_CONTROLLER_BLENDER_H
 
+#include <cstdint>
+#include <memory>
+#include <set>
 #include <string>
+#include <unordered_map>
+#include <vector>
 
 #include "./controller.h"
+#include "./core/serialized_object.h"
 
 namespace Splash
 {
 
+class Camera;
+class Object;
+
 class Blender : public ControllerObject
 {
   public:
@@ -53,20 +62,83 @@ class Blender : public ControllerObject
 
     /**
      * Force blending computation at the next call to update()
+     * Only the objects which changed, or are seen by cameras which changed, are recomputed
      */
     void forceUpdate() { _blendingComputed = false; }
 
   private:
-    std::string _blendingMode{"none"}; //!< Can be "none", "once" or "continuous"
-    bool _computeBlending{false};      //!< If true, compute blending in the next render
-    bool _continuousBlending{false};   //!< If true, render does not reset _computeBlending
-    bool _blendingComputed{false};     //!< True if the blending has been computed
+    std::string _blendingMode{"none"};     //!< Can be "none", "once" or "continuous"
+    std::string _blendingMethod{"vertex"}; //!< Can be "vertex" or "image"
+    bool _computeBlending{false};          //!< If true, compute blending in the next render
+    bool _continuousBlending{false};       //!< If true, render does not reset _computeBlending
+    bool _blendingComputed{false};         //!< True if the blending has been computed
+    bool _useCache{true};                  //!< If true, the blending computed in "once" mode is cached on disk
 
     // Vertex blending variables
     std::mutex _vertexBlendingMutex;
     std::condition_variable _vertexBlendingCondition;
     std::atomic_bool _vertexBlendingReceptionStatus{false};
 
+    // Change tracking, to only recompute the blending of the objects affected by a change
+    std::unordered_map<std::string, std::vector<double>> _cameraStates{};      //!< Camera states at the last blending computation
+    std::unordered_map<std::string, std::vector<double>> _objectStates{};      //!< Object states at the last blending computation
+    std::unordered_map<std::string, std::vector<std::string>> _cameraObjects{}; //!< Objects linked to each camera at the last blending computation
+    std::set<std::string> _pendingObjects{};                                   //!< Objects whose blending has to be computed
+
+    /**
+     * \brief Compute the image space blending maps of the given cameras, and send the maps of the ghost cameras to their Scene
+     * \param cameras All the cameras
+     * \param involvedCameras Cameras whose map has to be computed
+     */
+    void computeBlendingMaps(const std::vector<std::shared_ptr<GraphObject>>& cameras, const std::vector<std::shared_ptr<Camera>>& involvedCameras);
+
+    /**
+     * \brief Compare the cameras and objects to their state at the last blending computation, and queue the affected objects
+     * An object is affected if it changed, or if it is seen by a camera which sees an object which changed, as it may be occluded by it
+     * \param cameraObjects Objects linked to each camera
+     */
+    void queueAffectedObjects(const std::unordered_map<std::string, std::vector<std::string>>& cameraObjects);
+
+    /**
+     * \brief Compute the key of the cached blending for the given objects
+     * The key depends on the cameras seeing the objects, their blending parameters and the content of the meshes
+     * \param objects Objects whose blending is computed
+     * \param cameras Cameras seeing the objects
+     * \param cameraObjects Objects linked to each camera
+     * \param links Links between all objects
+     * \return Return the cache key
+     */
+    uint64_t computeCacheKey(const std::vector<std::shared_ptr<Object>>& objects,
+        const std::vector<std::shared_ptr<Camera>>& cameras,
+        const std::unordered_map<std::string, std::vector<std::string>>& cameraObjects,
+        const std::unordered_map<std::string, std::vector<std::string>>& links);
+
+    /**
+     * \brief Get the path of the cache file for the given key
+     * \param key Cache key
+     * \return Return the cache file path
+     */
+    static std::string getCacheFilePath(uint64_t key);
+
+    /**
+     * \brief Read the serialized geometries from the blending cache
+     * \param key Cache key
+     * \return Return the serialized geometries by name, empty if the key is not cached
+     */
+    static std::unordered_map<std::string, std::shared_ptr<SerializedObject>> readFromCache(uint64_t key);
+
+    /**
+     * \brief Write the serialized geometries to the blending cache
+     * \param key Cache key
+     * \param geometries Serialized geometries by name
+     */
+    static void writeToCache(uint64_t key, const std::unordered_map<std::string, std::shared_ptr<SerializedObject>>& geometries);
+
+    /**
+     * \brief Reset the change tracking, so that all objects are computed at the next update
+     */
+    void resetChangeTracking();
+
     /**
      * \brief Register new functors to modify attributes
      */
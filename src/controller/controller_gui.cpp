@@ -3,6 +3,7 @@
 #include <fstream>
 
 #include "./controller/controller.h"
+#include "./controller/widget/thumbnail_cache.h"
 #include "./controller/widget/widget_camera.h"
 #include "./controller/widget/widget_control.h"
 #include "./controller/widget/widget_filters.h"
@@ -57,6 +58,7 @@ Gui::Gui(shared_ptr<GlWindow> w, RootObject* s)
     glGetError();
 
     _fbo = make_unique<Framebuffer>(_root);
+    _fbo->setDepthAttachment(false);
     _fbo->setResizable(true);
 
     _window->releaseContext();
@@ -87,6 +89,8 @@ Gui::~Gui()
 
     if (_window->setAsCurrentContext())
     {
+        _thumbnailCache.reset();
+
         // Clean ImGui
         ImGui::DestroyContext();
         _window->releaseContext();
@@ -125,6 +129,7 @@ void Gui::unicodeChar(unsigned int unicodeChar)
     ImGuiIO& io = GetIO();
     if (unicodeChar > 0 && unicodeChar < 0x10000)
         io.AddInputCharacter((unsigned short)unicodeChar);
+    _inputReceived = true;
 }
 
 /*************/
@@ -268,6 +273,7 @@ void Gui::key(int key, int action, int mods)
             key = GLFW_KEY_ENTER;
 
         ImGuiIO& io = GetIO();
+        _inputReceived = true;
         if (action == GLFW_PRESS || action == GLFW_REPEAT)
             io.KeysDown[key] = true;
         if (action == GLFW_RELEASE)
@@ -396,6 +402,7 @@ void Gui::mouseButton(int btn, int action, int mods)
 
     io.KeyCtrl = (mods & GLFW_MOD_CONTROL) != 0;
     io.KeyShift = (mods & GLFW_MOD_SHIFT) != 0;
+    _inputReceived = true;
 
     return;
 }
@@ -405,6 +412,7 @@ void Gui::mouseScroll(double /*xoffset*/, double yoffset)
 {
     ImGuiIO& io = ImGui::GetIO();
     io.MouseWheel += (float)yoffset;
+    _inputReceived = true;
 
     return;
 }
@@ -833,6 +841,14 @@ void Gui::render()
     if (spec.width != _width || spec.height != _height)
         setOutputSize(spec.width, spec.height);
 
+    // The GUI is refreshed at its own rate, the previous frame being shown in between
+    // Inputs trigger a frame right away, so that presses and releases shorter than a GUI frame are not missed
+    const auto now = Timer::getTime();
+    if (_framerate > 0 && !_resized && !_inputReceived && now - _lastFrameTime < 1000000 / _framerate)
+        return;
+    _lastFrameTime = now;
+    _inputReceived = false;
+
 #ifdef DEBUG
     GLenum error = glGetError();
 #endif
@@ -941,7 +957,7 @@ void Gui::render()
 
             auto tree = _root->getTree();
             Value clock;
-            if (tree->getValueForLeafAt("/world/attributes/masterClock", clock) && clock.size() == 8)
+            if (tree->getValueForLeafAt("/world/attributes/masterClock", clock) && clock.size() >= 8)
             {
                 year = clock[0].as<int>();
                 month = clock[1].as<int>();
@@ -1001,6 +1017,9 @@ void Gui::render()
     ImGui::EndFrame();
     _fbo->getColorTexture()->generateMipmap();
 
+    if (_thumbnailCache)
+        _thumbnailCache->purge();
+
 #ifdef DEBUG
     error = glGetError();
     if (error)
@@ -1371,12 +1390,96 @@ void Gui::initImWidgets()
                 stats[branchName + "_gui"] = runningAverage(stats[branchName + "_gui"], getLeafValue(durationPath + "/gui"));
                 stream << "    GUI rendering: " << setprecision(4) << stats[branchName + "_gui"] << " ms\n";
             }
+
+            // Frame statistics per window, with the phase most often responsible for the late frames
+            auto framesPath = "/" + branchName + "/frames";
+            if (tree->hasBranchAt(framesPath))
+            {
+                for (const auto& windowName : tree->getBranchListAt(framesPath))
+                {
+                    auto windowPath = framesPath + "/" + windowName;
+                    stream << "    " << windowName << ": " << static_cast<int64_t>(getLeafValue(windowPath + "/missed_frames")) << " missed frames, render to present "
+                           << setprecision(4) << getLeafValue(windowPath + "/render_to_present_p50") * 0.001f << " / " << getLeafValue(windowPath + "/render_to_present_p99") * 0.001f
+                           << " ms (p50 / p99)";
+
+                    Value lateReason;
+                    if (tree->getValueForLeafAt(windowPath + "/late_reason", lateReason) && !lateReason[0].as<string>().empty())
+                        stream << ", late frames mostly due to " << lateReason[0].as<string>();
+                    stream << "\n";
+                }
+            }
+
+            // GPU time per object, as measured by the Scene GPU profiler
+            auto gpuPath = "/" + branchName + "/gpu";
+            if (tree->hasBranchAt(gpuPath))
+            {
+                auto gpuLeaves = tree->getLeafListAt(gpuPath);
+                if (!gpuLeaves.empty())
+                    stream << "    GPU time per object:\n";
+                for (const auto& objectName : gpuLeaves)
+                {
+                    auto statName = branchName + "_gpu_" + objectName;
+                    stats[statName] = runningAverage(stats[statName], getLeafValue(gpuPath + "/" + objectName));
+                    stream << "      " << objectName << ": " << setprecision(4) << stats[statName] << " ms\n";
+                }
+            }
         }
 
         return stream.str();
     });
     _guiBottomWidgets.push_back(dynamic_pointer_cast<GuiWidget>(timingBox));
 
+    // Memory held by the objects, per root object
+    auto memoryBox = make_shared<GuiTextBox>(_scene, "Memory");
+    memoryBox->setTextFunc([this]() {
+        ostringstream stream;
+        stream << fixed << setprecision(1);
+        auto tree = _root->getTree();
+
+        auto toMegabytes = [](int64_t bytes) { return static_cast<float>(bytes) / (1024.f * 1024.f); };
+        auto getLeafValues = [&](const string& path) {
+            Value value;
+            if (!tree->getValueForLeafAt(path, value) || value.getType() != Value::Type::values)
+                return Values();
+            return value.as<Values>();
+        };
+
+        for (const auto& branchName : tree->getBranchList())
+        {
+            auto statsPath = "/" + branchName + "/stats";
+            auto ram = getLeafValues(statsPath + "/memory_ram");
+            auto vram = getLeafValues(statsPath + "/memory_vram");
+            if (ram.empty() || vram.empty())
+                continue;
+
+            stream << branchName << ": " << toMegabytes(ram[0].as<int64_t>()) << " MB RAM, " << toMegabytes(vram[0].as<int64_t>()) << " MB VRAM";
+            auto vramBudget = getLeafValues("/" + branchName + "/attributes/vramBudget");
+            if (!vramBudget.empty() && vramBudget[0].as<int64_t>() != 0)
+                stream << " (budget: " << vramBudget[0].as<int64_t>() << " MB)";
+            auto vramAvailable = getLeafValues(statsPath + "/vram_available");
+            if (!vramAvailable.empty())
+                stream << ", " << toMegabytes(vramAvailable[0].as<int64_t>()) << " MB VRAM available";
+            stream << "\n";
+
+            // Largest objects first
+            vector<tuple<string, int64_t, int64_t>> objects;
+            auto memoryPath = "/" + branchName + "/memory";
+            for (const auto& objectName : tree->getLeafListAt(memoryPath))
+            {
+                auto usage = getLeafValues(memoryPath + "/" + objectName);
+                if (usage.size() == 2)
+                    objects.emplace_back(objectName, usage[0].as<int64_t>(), usage[1].as<int64_t>());
+            }
+            sort(objects.begin(), objects.end(), [](const auto& lhs, const auto& rhs) { return get<1>(lhs) + get<2>(lhs) > get<1>(rhs) + get<2>(rhs); });
+
+            for (const auto& [objectName, objectRam, objectVram] : objects)
+                stream << "  " << objectName << ": " << toMegabytes(objectRam) << " MB RAM, " << toMegabytes(objectVram) << " MB VRAM\n";
+        }
+
+        return stream.str();
+    });
+    _guiBottomWidgets.push_back(dynamic_pointer_cast<GuiWidget>(memoryBox));
+
     // Log display
     auto logBox = make_shared<GuiTextBox>(_scene, "Logs");
     logBox->setTextFunc([]() {
@@ -1391,6 +1494,11 @@ void Gui::initImWidgets()
         return text;
     });
     _guiBottomWidgets.push_back(dynamic_pointer_cast<GuiWidget>(logBox));
+
+    // Previews are drawn from thumbnails shared by all widgets
+    _thumbnailCache = make_unique<ThumbnailCache>();
+    for (auto& widget : _guiWidgets)
+        widget->setThumbnailCache(_thumbnailCache.get());
 }
 
 /*************/
@@ -1493,6 +1601,16 @@ void Gui::registerAttributes()
         [&]() -> Values { return {_fullscreen}; },
         {'b'});
     setAttributeDescription("fullscreen", "The GUI will take the whole window if set to true");
+
+    addAttribute("framerate",
+        [&](const Values& args) {
+            _framerate = std::max(0, args[0].as<int>());
+            return true;
+        },
+        [&]() -> Values { return {_framerate}; },
+        {'i'});
+    setAttributeDescription("framerate",
+        "Maximum rate of the GUI frames, the GUI being also refreshed on inputs. Set to 0 to render the GUI at every frame of its Scene. See also the decoupleGui attribute of the Scene");
 }
 
 } // namespace Splash
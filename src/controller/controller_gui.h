@@ -105,6 +105,12 @@ class Gui : public ControllerObject
      */
     bool isInitialized() const { return _isInitialized; }
 
+    /**
+     * \brief Check whether the gui is shown
+     * \return Return true if the gui is visible
+     */
+    bool isVisible() const { return _isVisible; }
+
     /**
      * \brief Forward a unicode char event
      * \param unicodeChar Unicode character to forward to the gui
@@ -236,6 +242,7 @@ class Gui : public ControllerObject
     std::map<FontType, ImFont*> _guiFonts{};
     std::vector<std::shared_ptr<GuiWidget>> _guiWidgets;
     std::vector<std::shared_ptr<GuiWidget>> _guiBottomWidgets;
+    std::unique_ptr<ThumbnailCache> _thumbnailCache{nullptr}; //!< Thumbnails drawn by the widgets, released with the GUI context current
 
     // Gui related attributes
     std::string _configurationPath;
@@ -248,6 +255,9 @@ class Gui : public ControllerObject
     bool _showAbout{false};
     bool _showHelp{false};
     bool _fullscreen{false};
+    int _framerate{0};          //!< Maximum rate of the GUI frames, 0 to render one at each Scene frame
+    int64_t _lastFrameTime{0};  //!< Time of the last GUI frame, in us
+    bool _inputReceived{false}; //!< Set when an input was received since the last GUI frame
 
     /**
      * \brief Initialize ImGui
@@ -0,0 +1,1023 @@
+#include "./controller/controller_httpserver.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <fcntl.h>
+#include <functional>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sstream>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "./utils/jsonutils.h"
+#include "./utils/log.h"
+
+// Maximum size of an HTTP request, or of a WebSocket message
+#define SPLASH_HTTPSERVER_MAX_REQUEST_SIZE (1 << 20)
+// Maximum size of the data waiting to be sent to a client, slower clients are disconnected
+#define SPLASH_HTTPSERVER_MAX_OUTPUT_SIZE (16 << 20)
+// Maximum number of simultaneous connections
+#define SPLASH_HTTPSERVER_MAX_CONNECTIONS 64
+// Size of the data waiting to be sent to a client above which it skips preview packets until the next keyframe
+#define SPLASH_HTTPSERVER_MAX_PREVIEW_BACKLOG (1 << 20)
+// Maximum number of preview packets received between two ticks, older packets are dropped past this
+#define SPLASH_HTTPSERVER_MAX_PREVIEW_PACKETS 64
+// Default size and framerate of the previews, and their limits
+#define SPLASH_HTTPSERVER_PREVIEW_WIDTH 320
+#define SPLASH_HTTPSERVER_PREVIEW_HEIGHT 180
+#define SPLASH_HTTPSERVER_PREVIEW_FRAMERATE 15
+#define SPLASH_HTTPSERVER_PREVIEW_MAX_WIDTH 1920
+#define SPLASH_HTTPSERVER_PREVIEW_MAX_HEIGHT 1080
+#define SPLASH_HTTPSERVER_PREVIEW_MAX_FRAMERATE 30
+
+using namespace std;
+
+namespace Splash
+{
+
+/*************/
+HttpServer::HttpServer(RootObject* root)
+    : ControllerObject(root)
+{
+    _type = "http_server";
+    registerAttributes();
+
+    // Without a root, the object is only created to get its documentation
+    if (!_root)
+        return;
+
+    _running = true;
+    _serverThread = thread([&]() { loop(); });
+}
+
+/*************/
+HttpServer::~HttpServer()
+{
+    _running = false;
+    if (_serverThread.joinable())
+        _serverThread.join();
+}
+
+/*************/
+void HttpServer::loop()
+{
+    auto nextTick = chrono::steady_clock::now();
+
+    while (_running)
+    {
+        unique_lock<mutex> lockConfiguration(_configurationMutex);
+        if (_configurationChanged)
+        {
+            _configurationChanged = false;
+            lockConfiguration.unlock();
+            openListenSocket();
+        }
+        else
+        {
+            lockConfiguration.unlock();
+        }
+
+        vector<pollfd> pollFds;
+        if (_listenSocket >= 0)
+            pollFds.push_back({_listenSocket, POLLIN, 0});
+        for (const auto& [socket, connection] : _connections)
+            pollFds.push_back({socket, static_cast<short>(connection.output.empty() ? POLLIN : POLLIN | POLLOUT), 0});
+
+        auto timeout = chrono::duration_cast<chrono::milliseconds>(nextTick - chrono::steady_clock::now()).count();
+        poll(pollFds.data(), pollFds.size(), static_cast<int>(max<int64_t>(timeout, 0)));
+
+        vector<int> toClose;
+        for (const auto& pollFd : pollFds)
+        {
+            if (pollFd.revents == 0)
+                continue;
+
+            if (pollFd.fd == _listenSocket)
+            {
+                acceptConnections();
+                continue;
+            }
+
+            auto connectionIt = _connections.find(pollFd.fd);
+            if (connectionIt == _connections.end())
+                continue;
+
+            auto& connection = connectionIt->second;
+            if ((pollFd.revents & (POLLERR | POLLNVAL)) || ((pollFd.revents & POLLIN) && !readConnection(connection)) || ((pollFd.revents & POLLHUP) && !(pollFd.revents & POLLIN)))
+                toClose.push_back(pollFd.fd);
+        }
+
+        // Writes and subscriptions are handled at a fixed rate, so that many changes are sent as one
+        if (chrono::steady_clock::now() >= nextTick)
+        {
+            flushWrites();
+            pushUpdates();
+            pushPreviews();
+            nextTick = chrono::steady_clock::now() + chrono::microseconds(1000000 / max(1, _updateRate.load()));
+        }
+
+        for (auto& [socket, connection] : _connections)
+        {
+            if (!connection.output.empty() && !writeConnection(connection))
+                toClose.push_back(socket);
+            else if (connection.closing && connection.output.empty())
+                toClose.push_back(socket);
+        }
+
+        for (auto socket : toClose)
+            closeConnection(socket);
+    }
+
+    flushWrites();
+    closeSockets();
+}
+
+/*************/
+bool HttpServer::openListenSocket()
+{
+    closeSockets();
+
+    unique_lock<mutex> lockConfiguration(_configurationMutex);
+    auto address = _address;
+    auto port = to_string(_port);
+    lockConfiguration.unlock();
+
+    addrinfo hints{};
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    hints.ai_flags = AI_PASSIVE;
+
+    addrinfo* info = nullptr;
+    if (getaddrinfo(address.empty() ? nullptr : address.c_str(), port.c_str(), &hints, &info) != 0 || !info)
+    {
+        Log::get() << Log::WARNING << "HttpServer::" << __FUNCTION__ << " - Unable to resolve address " << address << Log::endl;
+        return false;
+    }
+
+    _listenSocket = socket(info->ai_family, info->ai_socktype, info->ai_protocol);
+    if (_listenSocket >= 0)
+    {
+        int enable = 1;
+        setsockopt(_listenSocket, SOL_SOCKET, SO_REUSEADDR, &enable, sizeof(enable));
+        if (bind(_listenSocket, info->ai_addr, info->ai_addrlen) != 0 || listen(_listenSocket, SPLASH_HTTPSERVER_MAX_CONNECTIONS) != 0)
+        {
+            close(_listenSocket);
+            _listenSocket = -1;
+        }
+    }
+    freeaddrinfo(info);
+
+    if (_listenSocket < 0)
+    {
+        Log::get() << Log::WARNING << "HttpServer::" << __FUNCTION__ << " - Unable to listen on " << address << ":" << port << ": " << string(strerror(errno)) << Log::endl;
+        return false;
+    }
+
+    fcntl(_listenSocket, F_SETFL, fcntl(_listenSocket, F_GETFL) | O_NONBLOCK);
+    Log::get() << Log::MESSAGE << "HttpServer::" << __FUNCTION__ << " - Listening on " << address << ":" << port << Log::endl;
+    return true;
+}
+
+/*************/
+void HttpServer::closeSockets()
+{
+    vector<int> sockets;
+    for (const auto& [socket, connection] : _connections)
+        sockets.push_back(socket);
+    for (auto socket : sockets)
+        closeConnection(socket);
+
+    if (_listenSocket >= 0)
+    {
+        close(_listenSocket);
+        _listenSocket = -1;
+    }
+}
+
+/*************/
+void HttpServer::acceptConnections()
+{
+    while (true)
+    {
+        auto clientSocket = accept(_listenSocket, nullptr, nullptr);
+        if (clientSocket < 0)
+            return;
+
+        if (_connections.size() >= SPLASH_HTTPSERVER_MAX_CONNECTIONS)
+        {
+            Log::get() << Log::WARNING << "HttpServer::" << __FUNCTION__ << " - Too many connections, refusing a new one" << Log::endl;
+            close(clientSocket);
+            continue;
+        }
+
+        fcntl(clientSocket, F_SETFL, fcntl(clientSocket, F_GETFL) | O_NONBLOCK);
+        int enable = 1;
+        setsockopt(clientSocket, IPPROTO_TCP, TCP_NODELAY, &enable, sizeof(enable));
+
+        Connection connection;
+        connection.socket = clientSocket;
+        _connections[clientSocket] = std::move(connection);
+    }
+}
+
+/*************/
+bool HttpServer::readConnection(Connection& connection)
+{
+    char buffer[16384];
+    while (true)
+    {
+        auto received = recv(connection.socket, buffer, sizeof(buffer), 0);
+        if (received > 0)
+        {
+            connection.input.append(buffer, received);
+            continue;
+        }
+
+        if (received == 0)
+            return false;
+        if (errno == EAGAIN || errno == EWOULDBLOCK)
+            break;
+        if (errno != EINTR)
+            return false;
+    }
+
+    if (connection.closing)
+    {
+        connection.input.clear();
+        return true;
+    }
+
+    return connection.isWebSocket ? processWebSocket(connection) : processHttp(connection);
+}
+
+/*************/
+bool HttpServer::writeConnection(Connection& connection)
+{
+    while (!connection.output.empty())
+    {
+        auto sent = send(connection.socket, connection.output.data(), connection.output.size(), MSG_NOSIGNAL);
+        if (sent > 0)
+        {
+            connection.output.erase(0, sent);
+            continue;
+        }
+
+        if (sent < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+            break;
+        if (sent < 0 && errno == EINTR)
+            continue;
+        return false;
+    }
+
+    return connection.output.size() <= SPLASH_HTTPSERVER_MAX_OUTPUT_SIZE;
+}
+
+/*************/
+void HttpServer::closeConnection(int socket)
+{
+    auto connectionIt = _connections.find(socket);
+    if (connectionIt == _connections.end())
+        return;
+
+    vector<string> paths;
+    for (const auto& [path, subscription] : _subscriptions)
+        if (subscription.clients.count(socket))
+            paths.push_back(path);
+    for (const auto& path : paths)
+        unsubscribe(socket, path);
+
+    vector<string> previews;
+    for (const auto& [object, preview] : _previews)
+        if (preview.clients.count(socket))
+            previews.push_back(object);
+    for (const auto& object : previews)
+        stopPreview(socket, object);
+
+    close(socket);
+    _connections.erase(connectionIt);
+}
+
+/*************/
+bool HttpServer::processHttp(Connection& connection)
+{
+    while (!connection.input.empty() && !connection.isWebSocket && !connection.closing)
+    {
+        Http::Request request;
+        size_t consumed = 0;
+        auto status = Http::parseRequest(connection.input, request, consumed, SPLASH_HTTPSERVER_MAX_REQUEST_SIZE);
+        if (status == Http::ParseStatus::Incomplete)
+            return true;
+
+        if (status == Http::ParseStatus::Invalid)
+        {
+            connection.output += Http::buildResponse(400, "text/plain", "Malformed or too large request", false);
+            connection.closing = true;
+            return true;
+        }
+
+        connection.input.erase(0, consumed);
+
+        if (Http::isWebSocketUpgrade(request))
+        {
+            connection.output += Http::buildWebSocketHandshake(request);
+            connection.isWebSocket = true;
+            return processWebSocket(connection);
+        }
+
+        int responseStatus = 200;
+        auto body = handleRequest(request, responseStatus);
+        auto keepAlive = !Http::hasToken(request.getHeader("connection"), "close");
+        connection.output += Http::buildResponse(responseStatus, body.empty() ? "" : "application/json", body, keepAlive);
+        connection.closing = !keepAlive;
+    }
+
+    return true;
+}
+
+/*************/
+bool HttpServer::processWebSocket(Connection& connection)
+{
+    while (!connection.input.empty() && !connection.closing)
+    {
+        Http::Frame frame;
+        size_t consumed = 0;
+        auto status = Http::decodeFrame(connection.input, frame, consumed, SPLASH_HTTPSERVER_MAX_REQUEST_SIZE);
+        if (status == Http::ParseStatus::Incomplete)
+            return true;
+        if (status == Http::ParseStatus::Invalid)
+            return false;
+
+        connection.input.erase(0, consumed);
+
+        switch (frame.opcode)
+        {
+        default:
+            return false;
+        case Http::Opcode::Ping:
+            connection.output += Http::encodeFrame(Http::Opcode::Pong, frame.payload);
+            break;
+        case Http::Opcode::Pong:
+            break;
+        case Http::Opcode::Close:
+            connection.output += Http::encodeFrame(Http::Opcode::Close, frame.payload.substr(0, 2));
+            connection.closing = true;
+            break;
+        case Http::Opcode::Text:
+        case Http::Opcode::Binary:
+        case Http::Opcode::Continuation:
+        {
+            if (frame.opcode != Http::Opcode::Continuation)
+            {
+                connection.fragments.clear();
+                connection.fragmentsOpcode = frame.opcode;
+            }
+            else if (connection.fragmentsOpcode == 0)
+            {
+                return false;
+            }
+
+            connection.fragments += frame.payload;
+            if (connection.fragments.size() > SPLASH_HTTPSERVER_MAX_REQUEST_SIZE)
+                return false;
+
+            if (frame.fin)
+            {
+                auto message = std::move(connection.fragments);
+                connection.fragments.clear();
+                connection.fragmentsOpcode = 0;
+                handleMessage(connection, message);
+            }
+            break;
+        }
+        }
+    }
+
+    return true;
+}
+
+/*************/
+string HttpServer::handleRequest(const Http::Request& request, int& status)
+{
+    Json::StreamWriterBuilder writerBuilder;
+    writerBuilder["indentation"] = "";
+
+    if (request.method == "OPTIONS")
+    {
+        status = 204;
+        return {};
+    }
+
+    // Split the target in path components, the query string is ignored
+    vector<string> parts;
+    auto target = request.target.substr(0, request.target.find('?'));
+    istringstream targetStream(target);
+    for (string part; getline(targetStream, part, '/');)
+        if (!part.empty())
+            parts.push_back(Http::decodeUrl(part));
+
+    const bool isRead = request.method == "GET";
+    const bool isWrite = request.method == "PUT" || request.method == "POST";
+
+    status = 404;
+    if (parts.empty())
+        return {};
+
+    if (parts[0] == "tree")
+    {
+        if (!isRead)
+        {
+            status = 405;
+            return {};
+        }
+
+        string path;
+        for (size_t i = 1; i < parts.size(); ++i)
+            path += "/" + parts[i];
+
+        Json::Value json;
+        if (!getTreeAsJson(path.empty() ? "/" : path, json))
+            return {};
+
+        status = 200;
+        return Json::writeString(writerBuilder, json);
+    }
+    else if (parts[0] == "objects")
+    {
+        if (parts.size() == 1 && isRead)
+        {
+            Json::Value json(Json::arrayValue);
+            for (const auto& name : getObjectList())
+                json.append(name);
+            status = 200;
+            return Json::writeString(writerBuilder, json);
+        }
+        else if (parts.size() == 2 && isRead)
+        {
+            if (!checkObjectExists(parts[1]))
+                return {};
+
+            Json::Value json(Json::objectValue);
+            for (const auto& [attribute, values] : getObjectAttributes(parts[1]))
+                json[attribute] = valueToJson(values);
+            status = 200;
+            return Json::writeString(writerBuilder, json);
+        }
+        else if (parts.size() == 3 && isRead)
+        {
+            if (getAttributePath(parts[1], parts[2]).empty())
+                return {};
+
+            status = 200;
+            return Json::writeString(writerBuilder, valueToJson(getObjectAttribute(parts[1], parts[2])));
+        }
+        else if (parts.size() == 3 && isWrite)
+        {
+            Json::Value json;
+            string errors;
+            unique_ptr<Json::CharReader> reader(Json::CharReaderBuilder().newCharReader());
+            if (!reader->parse(request.body.data(), request.body.data() + request.body.size(), &json, &errors))
+            {
+                status = 400;
+                return {};
+            }
+
+            queueWrite(parts[1], parts[2], json);
+            status = 202;
+            return {};
+        }
+        else if (parts.size() <= 3)
+        {
+            status = 405;
+            return {};
+        }
+    }
+    else if (parts[0] == "batch" && parts.size() == 1)
+    {
+        if (!isWrite)
+        {
+            status = 405;
+            return {};
+        }
+
+        Json::Value json;
+        string errors;
+        unique_ptr<Json::CharReader> reader(Json::CharReaderBuilder().newCharReader());
+        if (!reader->parse(request.body.data(), request.body.data() + request.body.size(), &json, &errors) || !queueWrites(json))
+        {
+            status = 400;
+            return {};
+        }
+
+        status = 202;
+        return {};
+    }
+
+    return {};
+}
+
+/*************/
+void HttpServer::handleMessage(Connection& connection, const string& message)
+{
+    Json::Value json;
+    string errors;
+    unique_ptr<Json::CharReader> reader(Json::CharReaderBuilder().newCharReader());
+    if (!reader->parse(message.data(), message.data() + message.size(), &json, &errors) || !json.isObject())
+    {
+        Json::Value error;
+        error["type"] = "error";
+        error["message"] = "Messages must be Json objects";
+        sendMessage(connection, error);
+        return;
+    }
+
+    auto getString = [&](const char* key) { return json.isMember(key) && json[key].isString() ? json[key].asString() : string(); };
+    auto type = getString("type");
+
+    // Leaves can be given either by their path, or by an object and one of its attributes
+    auto path = getString("path");
+    if (path.empty() && !getString("object").empty() && !getString("attribute").empty())
+        path = getAttributePath(getString("object"), getString("attribute"));
+
+    Json::Value error;
+    error["type"] = "error";
+    error["request"] = json;
+
+    if (type == "subscribe" || type == "get")
+    {
+        // The current value is sent right away, as the whole branch for a branch path
+        Json::Value current;
+        if (path.empty() || (type == "subscribe" && !subscribe(connection.socket, path)) || !getTreeAsJson(path, current))
+        {
+            error["message"] = "Nothing found at the given path";
+            sendMessage(connection, error);
+            return;
+        }
+
+        Json::Value update;
+        update["type"] = "update";
+        update["values"][path] = current;
+        sendMessage(connection, update);
+    }
+    else if (type == "unsubscribe")
+    {
+        unsubscribe(connection.socket, path);
+    }
+    else if (type == "preview")
+    {
+        if (!startPreview(connection.socket, json))
+        {
+            error["message"] = "No object found with the given name";
+            sendMessage(connection, error);
+        }
+    }
+    else if (type == "stopPreview")
+    {
+        stopPreview(connection.socket, getString("object"));
+    }
+    else if (type == "set")
+    {
+        if (json.isMember("changes"))
+        {
+            if (!queueWrites(json["changes"]))
+            {
+                error["message"] = "Changes must be an array of [object, attribute, value] arrays";
+                sendMessage(connection, error);
+            }
+        }
+        else if (!getString("object").empty() && !getString("attribute").empty() && json.isMember("value"))
+        {
+            queueWrite(getString("object"), getString("attribute"), json["value"]);
+        }
+        else
+        {
+            error["message"] = "Missing object, attribute or value";
+            sendMessage(connection, error);
+        }
+    }
+    else
+    {
+        error["message"] = "Unknown message type";
+        sendMessage(connection, error);
+    }
+}
+
+/*************/
+void HttpServer::sendMessage(Connection& connection, const Json::Value& message)
+{
+    Json::StreamWriterBuilder writerBuilder;
+    writerBuilder["indentation"] = "";
+    connection.output += Http::encodeFrame(Http::Opcode::Text, Json::writeString(writerBuilder, message));
+}
+
+/*************/
+bool HttpServer::subscribe(int socket, const string& path)
+{
+    auto subscriptionIt = _subscriptions.find(path);
+    if (subscriptionIt != _subscriptions.end())
+    {
+        subscriptionIt->second.clients.insert(socket);
+        return true;
+    }
+
+    // Changes are delivered once per loop by the root, the callback only records them
+    auto tree = _root->getTree();
+    if (!tree->hasLeafAt(path) && !tree->hasBranchAt(path))
+        return false;
+
+    auto subscriptionId = tree->subscribe(path, [this, path](const Tree::Root::ChangeSet& changes) {
+        lock_guard<mutex> lockChanged(_changedValuesMutex);
+        auto& changedValues = _changedValues[path];
+        for (const auto& [leafPath, value] : changes)
+            changedValues[leafPath] = value;
+    });
+
+    Subscription subscription;
+    subscription.id = subscriptionId;
+    subscription.clients.insert(socket);
+    _subscriptions[path] = subscription;
+    return true;
+}
+
+/*************/
+void HttpServer::unsubscribe(int socket, const string& path)
+{
+    auto subscriptionIt = _subscriptions.find(path);
+    if (subscriptionIt == _subscriptions.end())
+        return;
+
+    subscriptionIt->second.clients.erase(socket);
+    if (!subscriptionIt->second.clients.empty())
+        return;
+
+    _root->getTree()->unsubscribe(subscriptionIt->second.id);
+    _subscriptions.erase(subscriptionIt);
+
+    lock_guard<mutex> lockChanged(_changedValuesMutex);
+    _changedValues.erase(path);
+}
+
+/*************/
+bool HttpServer::startPreview(int socket, const Json::Value& request)
+{
+    auto object = request["object"].isString() ? request["object"].asString() : string();
+    if (object.empty() || !checkObjectExists(object))
+        return false;
+
+    // The client can only decode from a keyframe, even if the preview was already running
+    auto previewIt = _previews.find(object);
+    if (previewIt != _previews.end())
+    {
+        previewIt->second.clients.insert(socket);
+        previewIt->second.waitingKeyframe.insert(socket);
+        return true;
+    }
+
+    auto getInt = [&](const char* key, int defaultValue, int maxValue) {
+        return request[key].isInt() ? std::clamp(request[key].asInt(), 1, maxValue) : defaultValue;
+    };
+    auto width = getInt("width", SPLASH_HTTPSERVER_PREVIEW_WIDTH, SPLASH_HTTPSERVER_PREVIEW_MAX_WIDTH);
+    auto height = getInt("height", SPLASH_HTTPSERVER_PREVIEW_HEIGHT, SPLASH_HTTPSERVER_PREVIEW_MAX_HEIGHT);
+    auto framerate = getInt("framerate", SPLASH_HTTPSERVER_PREVIEW_FRAMERATE, SPLASH_HTTPSERVER_PREVIEW_MAX_FRAMERATE);
+
+    Preview preview;
+    preview.sinkName = "_" + getName() + "_preview_" + object;
+    preview.clients.insert(socket);
+    preview.waitingKeyframe.insert(socket);
+    _previews[object] = preview;
+
+    setWorldAttribute("addPreview", {object, preview.sinkName, getName(), width, height, framerate});
+    return true;
+}
+
+/*************/
+void HttpServer::stopPreview(int socket, const string& object)
+{
+    auto previewIt = _previews.find(object);
+    if (previewIt == _previews.end())
+        return;
+
+    previewIt->second.clients.erase(socket);
+    previewIt->second.waitingKeyframe.erase(socket);
+    if (!previewIt->second.clients.empty())
+        return;
+
+    setWorldAttribute("deleteObject", {previewIt->second.sinkName});
+    _previews.erase(previewIt);
+}
+
+/*************/
+void HttpServer::pushPreviews()
+{
+    deque<PreviewPacket> packets;
+    unique_lock<mutex> lockPackets(_previewPacketsMutex);
+    std::swap(packets, _previewPackets);
+    auto dropped = _previewPacketsDropped;
+    _previewPacketsDropped = false;
+    lockPackets.unlock();
+
+    if (dropped)
+        for (auto& [object, preview] : _previews)
+            preview.waitingKeyframe = preview.clients;
+
+    for (const auto& packet : packets)
+    {
+        auto previewIt = std::find_if(_previews.begin(), _previews.end(), [&](const auto& entry) { return entry.second.sinkName == packet.sinkName; });
+        if (previewIt == _previews.end())
+            continue;
+
+        auto& preview = previewIt->second;
+        Json::Value header;
+        header["type"] = "preview";
+        header["object"] = previewIt->first;
+        header["codec"] = packet.codec;
+        header["width"] = packet.width;
+        header["height"] = packet.height;
+        header["keyframe"] = packet.keyframe;
+
+        for (auto socket : preview.clients)
+        {
+            auto connectionIt = _connections.find(socket);
+            if (connectionIt == _connections.end())
+                continue;
+
+            // Slow clients skip packets until they catch up, instead of being disconnected
+            auto& connection = connectionIt->second;
+            if (connection.output.size() > SPLASH_HTTPSERVER_MAX_PREVIEW_BACKLOG)
+            {
+                preview.waitingKeyframe.insert(socket);
+                continue;
+            }
+
+            if (preview.waitingKeyframe.count(socket))
+            {
+                if (!packet.keyframe)
+                    continue;
+                preview.waitingKeyframe.erase(socket);
+            }
+
+            sendMessage(connection, header);
+            connection.output += Http::encodeFrame(Http::Opcode::Binary, packet.data);
+        }
+    }
+}
+
+/*************/
+void HttpServer::queueWrite(const string& name, const string& attribute, const Json::Value& value)
+{
+    // Single values are accepted as a shorthand for an array holding only this value
+    auto arrayValue = value;
+    if (!value.isArray())
+    {
+        arrayValue = Json::Value(Json::arrayValue);
+        arrayValue.append(value);
+    }
+    auto values = Utils::jsonToValues(arrayValue);
+
+    auto key = make_pair(name, attribute);
+    if (auto indexIt = _pendingWritesIndex.find(key); indexIt != _pendingWritesIndex.end())
+    {
+        get<2>(_pendingWrites[indexIt->second]) = values;
+        return;
+    }
+
+    _pendingWritesIndex[key] = _pendingWrites.size();
+    _pendingWrites.emplace_back(name, attribute, values);
+}
+
+/*************/
+bool HttpServer::queueWrites(const Json::Value& writes)
+{
+    if (!writes.isArray())
+        return false;
+
+    for (const auto& write : writes)
+        if (!write.isArray() || write.size() != 3 || !write[0].isString() || !write[1].isString())
+            return false;
+
+    for (const auto& write : writes)
+        queueWrite(write[0].asString(), write[1].asString(), write[2]);
+    return true;
+}
+
+/*************/
+void HttpServer::flushWrites()
+{
+    if (_pendingWrites.empty())
+        return;
+
+    setObjectsAttributes(_pendingWrites);
+    _pendingWrites.clear();
+    _pendingWritesIndex.clear();
+}
+
+/*************/
+void HttpServer::pushUpdates()
+{
+    map<string, Tree::Root::ChangeSet> changedValues;
+    unique_lock<mutex> lockChanged(_changedValuesMutex);
+    std::swap(changedValues, _changedValues);
+    lockChanged.unlock();
+
+    map<int, Json::Value> updates;
+    for (const auto& [path, changes] : changedValues)
+    {
+        auto subscriptionIt = _subscriptions.find(path);
+        if (subscriptionIt == _subscriptions.end())
+            continue;
+
+        for (const auto& [leafPath, value] : changes)
+        {
+            auto json = valueToJson(value);
+            for (auto socket : subscriptionIt->second.clients)
+                updates[socket][leafPath] = json;
+        }
+    }
+
+    for (auto& [socket, values] : updates)
+    {
+        auto connectionIt = _connections.find(socket);
+        if (connectionIt == _connections.end())
+            continue;
+
+        Json::Value update;
+        update["type"] = "update";
+        update["values"] = values;
+        sendMessage(connectionIt->second, update);
+    }
+}
+
+/*************/
+string HttpServer::getAttributePath(const string& name, const string& attribute) const
+{
+    auto tree = _root->getTree();
+    for (const auto& rootName : tree->getBranchList())
+    {
+        auto path = "/" + rootName + "/objects/" + name + "/attributes/" + attribute;
+        if (tree->hasLeafAt(path))
+            return path;
+    }
+    return {};
+}
+
+/*************/
+bool HttpServer::getTreeAsJson(const string& path, Json::Value& json) const
+{
+    auto tree = _root->getTree();
+
+    if (path != "/" && tree->hasLeafAt(path))
+    {
+        Value value;
+        tree->getValueForLeafAt(path, value);
+        json = valueToJson(value);
+        return true;
+    }
+
+    if (path != "/" && !tree->hasBranchAt(path))
+        return false;
+
+    function<Json::Value(const string&)> branchToJson = [&](const string& branchPath) {
+        Json::Value branch(Json::objectValue);
+        auto prefix = branchPath == "/" ? string("/") : branchPath + "/";
+
+        for (const auto& name : branchPath == "/" ? tree->getBranchList() : tree->getBranchListAt(branchPath))
+            branch[name] = branchToJson(prefix + name);
+
+        for (const auto& name : branchPath == "/" ? tree->getLeafList() : tree->getLeafListAt(branchPath))
+        {
+            Value value;
+            tree->getValueForLeafAt(prefix + name, value);
+            branch[name] = valueToJson(value);
+        }
+
+        return branch;
+    };
+
+    json = branchToJson(path);
+    return true;
+}
+
+/*************/
+Json::Value HttpServer::valueToJson(const Value& value)
+{
+    switch (value.getType())
+    {
+    default:
+        return {};
+    case Value::boolean:
+        return value.as<bool>();
+    case Value::integer:
+        return static_cast<Json::Int64>(value.as<int64_t>());
+    case Value::real:
+        return value.as<double>();
+    case Value::string:
+        return value.as<string>();
+    case Value::values:
+    {
+        auto values = value.as<Values>();
+
+        // If the first value is named, the values are treated as a Json object
+        if (!values.empty() && values[0].isNamed())
+        {
+            Json::Value json(Json::objectValue);
+            for (const auto& v : values)
+                json[v.getName()] = valueToJson(v);
+            return json;
+        }
+
+        Json::Value json(Json::arrayValue);
+        for (const auto& v : values)
+            json.append(valueToJson(v));
+        return json;
+    }
+    case Value::reals:
+    {
+        const auto& reals = value.asRef<Value::Reals>();
+        Json::Value json(Json::arrayValue);
+        for (uint32_t i = 0; i < reals.size(); ++i)
+            json.append(static_cast<double>(reals[i]));
+        return json;
+    }
+    }
+}
+
+/*************/
+void HttpServer::registerAttributes()
+{
+    ControllerObject::registerAttributes();
+
+    addAttribute(
+        "address",
+        [&](const Values& args) {
+            lock_guard<mutex> lockConfiguration(_configurationMutex);
+            _address = args[0].as<string>();
+            _configurationChanged = true;
+            return true;
+        },
+        [&]() -> Values {
+            lock_guard<mutex> lockConfiguration(_configurationMutex);
+            return {_address};
+        },
+        {'s'});
+    setAttributeDescription("address", "Address to listen on, set to 0.0.0.0 to accept connections from any host");
+
+    addAttribute(
+        "port",
+        [&](const Values& args) {
+            auto port = args[0].as<int>();
+            if (port <= 0 || port > 65535)
+                return false;
+
+            lock_guard<mutex> lockConfiguration(_configurationMutex);
+            _port = port;
+            _configurationChanged = true;
+            return true;
+        },
+        [&]() -> Values {
+            lock_guard<mutex> lockConfiguration(_configurationMutex);
+            return {_port};
+        },
+        {'i'});
+    setAttributeDescription("port", "Port to listen on");
+
+    addAttribute(
+        "updateRate",
+        [&](const Values& args) {
+            _updateRate = std::clamp(args[0].as<int>(), 1, 1000);
+            return true;
+        },
+        [&]() -> Values { return {_updateRate.load()}; },
+        {'i'});
+    setAttributeDescription("updateRate", "Rate at which the received changes are applied and the subscribed values are pushed, in Hz");
+
+    addAttribute(
+        "previewPacket",
+        [&](const Values& args) {
+            PreviewPacket packet;
+            packet.sinkName = args[0].as<string>();
+            packet.keyframe = args[1].as<bool>();
+            packet.width = args[2].as<int>();
+            packet.height = args[3].as<int>();
+            packet.codec = args[4].as<string>();
+            auto data = args[5].as<Value::Buffer>();
+            packet.data.assign(reinterpret_cast<const char*>(data.data()), data.size());
+
+            // If the server thread falls behind, the queued packets are dropped and all clients restart from a keyframe
+            lock_guard<mutex> lockPackets(_previewPacketsMutex);
+            if (_previewPackets.size() >= SPLASH_HTTPSERVER_MAX_PREVIEW_PACKETS)
+            {
+                _previewPackets.clear();
+                _previewPacketsDropped = true;
+            }
+            _previewPackets.push_back(std::move(packet));
+            return true;
+        },
+        {'s', 'b', 'i', 'i', 's', 'd'});
+    setAttributeDescription("previewPacket", "Encoded packet sent by a preview sink, as: sink, keyframe, width, height, codec, data. Only used internally");
+}
+
+} // namespace Splash
@@ -0,0 +1,299 @@
+/*
+ * Copyright (C) 2026 Emmanuel Durand
+ *
+ * This file is part of Splash.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Splash is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Splash.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * @controller_httpserver.h
+ * Event driven HTTP and WebSocket server, to control Splash remotely
+ */
+
+#ifndef SPLASH_CONTROLLER_HTTPSERVER_H
+#define SPLASH_CONTROLLER_HTTPSERVER_H
+
+#include <atomic>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include <json/json.h>
+
+#include "./controller/controller.h"
+#include "./utils/http_protocol.h"
+
+namespace Splash
+{
+
+/*************/
+//! Remote control server, running in its own thread
+//! All sockets are handled by a single thread waiting on poll(), so that many clients can be
+//! served without blocking each other nor the rendering. The tree is served as Json over HTTP,
+//! and WebSocket clients can subscribe to leaves or branches of the tree to be notified when they change.
+//! Writes from all clients are coalesced and sent to the roots as a single batch at each tick.
+//! Clients can also ask for encoded previews of objects, for which a Sink_Preview is created in the Scene holding them.
+//! Each packet is sent as a Json header followed by a binary message, and clients start receiving from a keyframe.
+class HttpServer : public ControllerObject
+{
+  public:
+    /**
+     * \brief Constructor
+     * \param root Root object
+     */
+    explicit HttpServer(RootObject* root);
+
+    /**
+     * \brief Destructor
+     */
+    ~HttpServer() final;
+
+  private:
+    //! Client connection, only accessed from the server thread
+    struct Connection
+    {
+        int socket{-1};
+        std::string input{};        //!< Received data, not yet processed
+        std::string output{};       //!< Data waiting to be sent
+        bool isWebSocket{false};    //!< True once upgraded to the WebSocket protocol
+        bool closing{false};        //!< If true, the connection is closed once the output is sent
+        std::string fragments{};    //!< Payload of a fragmented WebSocket message
+        uint8_t fragmentsOpcode{0}; //!< Opcode of the fragmented message, 0 if none
+    };
+
+    //! Subscription to a leaf or a branch of the tree, shared by all the clients subscribed to it
+    struct Subscription
+    {
+        Tree::Root::SubscriptionID id{0};
+        std::set<int> clients{}; //!< Sockets of the subscribed clients
+    };
+
+    //! Encoded preview of an object, shared by all the clients watching it
+    struct Preview
+    {
+        std::string sinkName{};
+        std::set<int> clients{};         //!< Sockets of the clients watching the preview
+        std::set<int> waitingKeyframe{}; //!< Clients which can only start decoding from the next keyframe
+    };
+
+    //! Encoded packet received from a preview sink
+    struct PreviewPacket
+    {
+        std::string sinkName{};
+        bool keyframe{false};
+        int width{0};
+        int height{0};
+        std::string codec{};
+        std::string data{};
+    };
+
+    std::thread _serverThread{};
+    std::atomic_bool _running{false};
+
+    std::mutex _configurationMutex{};
+    std::string _address{"127.0.0.1"}; //!< Address to listen on
+    int _port{10000};                  //!< Port to listen on
+    bool _configurationChanged{true};  //!< Set to true to (re)open the listening socket
+    std::atomic_int _updateRate{60};   //!< Ticks per second, at which writes are applied and changes are pushed
+
+    int _listenSocket{-1};
+    std::map<int, Connection> _connections{};
+    std::map<std::string, Subscription> _subscriptions{};
+    std::vector<std::tuple<std::string, std::string, Values>> _pendingWrites{};  //!< Writes to apply at the next tick
+    std::map<std::pair<std::string, std::string>, size_t> _pendingWritesIndex{}; //!< Index of each object attribute in the pending writes
+
+    std::mutex _changedValuesMutex{};
+    std::map<std::string, Tree::Root::ChangeSet> _changedValues{}; //!< Leaves which changed since the last tick, by subscribed path, filled from the tree notifications
+
+    std::map<std::string, Preview> _previews{}; //!< Previews by object name
+    std::mutex _previewPacketsMutex{};
+    std::deque<PreviewPacket> _previewPackets{}; //!< Packets received since the last tick
+    bool _previewPacketsDropped{false};          //!< Set if packets had to be dropped, in which case all clients wait for the next keyframe
+
+    /**
+     * \brief Server thread loop
+     */
+    void loop();
+
+    /**
+     * \brief Open the listening socket, closing the previous one
+     * \return Return true if the server is listening
+     */
+    bool openListenSocket();
+
+    /**
+     * \brief Close the listening socket and all connections
+     */
+    void closeSockets();
+
+    /**
+     * \brief Accept the pending connections
+     */
+    void acceptConnections();
+
+    /**
+     * \brief Read the available data from a connection, and process the complete requests or messages
+     * \param connection Connection
+     * \return Return false if the connection has to be closed right away
+     */
+    bool readConnection(Connection& connection);
+
+    /**
+     * \brief Send as much as possible of the pending output of a connection
+     * \param connection Connection
+     * \return Return false if the connection has to be closed right away
+     */
+    bool writeConnection(Connection& connection);
+
+    /**
+     * \brief Close a connection and drop its subscriptions
+     * \param socket Connection socket
+     */
+    void closeConnection(int socket);
+
+    /**
+     * \brief Process the complete HTTP requests received from a connection
+     * \param connection Connection
+     * \return Return false if the connection has to be closed right away
+     */
+    bool processHttp(Connection& connection);
+
+    /**
+     * \brief Process the complete WebSocket frames received from a connection
+     * \param connection Connection
+     * \return Return false if the connection has to be closed right away
+     */
+    bool processWebSocket(Connection& connection);
+
+    /**
+     * \brief Answer an HTTP request
+     * \param request Request
+     * \param status Set to the response status
+     * \return Return the response body
+     */
+    std::string handleRequest(const Http::Request& request, int& status);
+
+    /**
+     * \brief Handle a message received from a WebSocket client
+     * \param connection Connection the message comes from
+     * \param message Message text
+     */
+    void handleMessage(Connection& connection, const std::string& message);
+
+    /**
+     * \brief Send a Json message to a WebSocket client
+     * \param connection Connection
+     * \param message Message
+     */
+    void sendMessage(Connection& connection, const Json::Value& message);
+
+    /**
+     * \brief Subscribe a client to a leaf or a branch of the tree
+     * \param socket Client socket
+     * \param path Leaf or branch path
+     * \return Return true if the leaf or branch exists
+     */
+    bool subscribe(int socket, const std::string& path);
+
+    /**
+     * \brief Unsubscribe a client from a leaf or a branch of the tree
+     * \param socket Client socket
+     * \param path Leaf or branch path
+     */
+    void unsubscribe(int socket, const std::string& path);
+
+    /**
+     * \brief Add a client to the preview of an object, creating the preview sink if needed
+     * \param socket Client socket
+     * \param request Preview request, holding the object name and optionally the preview size and framerate
+     * \return Return false if the object is not found
+     */
+    bool startPreview(int socket, const Json::Value& request);
+
+    /**
+     * \brief Remove a client from the preview of an object, deleting the preview sink if nobody watches it anymore
+     * \param socket Client socket
+     * \param object Object name
+     */
+    void stopPreview(int socket, const std::string& object);
+
+    /**
+     * \brief Send the preview packets received since the last tick to the clients watching them
+     */
+    void pushPreviews();
+
+    /**
+     * \brief Queue a write, replacing any pending write to the same attribute
+     * \param name Object name
+     * \param attribute Attribute name
+     * \param value Attribute value, as Json
+     */
+    void queueWrite(const std::string& name, const std::string& attribute, const Json::Value& value);
+
+    /**
+     * \brief Queue a list of writes, given as an array of [object, attribute, value] arrays
+     * \param writes Writes
+     * \return Return false if the writes are malformed, in which case none is queued
+     */
+    bool queueWrites(const Json::Value& writes);
+
+    /**
+     * \brief Apply the pending writes, all at once
+     */
+    void flushWrites();
+
+    /**
+     * \brief Send the changed values to the subscribed clients
+     */
+    void pushUpdates();
+
+    /**
+     * \brief Get the path of the leaf holding the given object attribute
+     * \param name Object name
+     * \param attribute Attribute name
+     * \return Return the leaf path, or an empty string if not found
+     */
+    std::string getAttributePath(const std::string& name, const std::string& attribute) const;
+
+    /**
+     * \brief Get a branch or a leaf of the tree as Json
+     * \param path Path to the branch or leaf
+     * \param json Holds the branch or leaf content
+     * \return Return false if there is nothing at the given path
+     */
+    bool getTreeAsJson(const std::string& path, Json::Value& json) const;
+
+    /**
+     * \brief Convert a Value to Json
+     * \param value Value
+     * \return Return the Json value
+     */
+    static Json::Value valueToJson(const Value& value);
+
+    /**
+     * \brief Register new functors to modify attributes
+     */
+    void registerAttributes();
+};
+
+} // namespace Splash
+
+#endif // SPLASH_CONTROLLER_HTTPSERVER_H
@@ -1,5 +1,7 @@
 #include "./controller/controller_pythonembedded.h"
 
+#include <cstring>
+#include <deque>
 #include <fstream>
 #include <functional>
 #include <mutex>
@@ -8,6 +10,9 @@
 #include "./utils/log.h"
 #include "./utils/osutils.h"
 
+// Maximum number of attribute callbacks waiting to be run by the Python loop, older ones are dropped
+#define SPLASH_PYTHON_MAX_PENDING_CALLBACKS 4096
+
 using namespace std;
 
 namespace Splash
@@ -19,6 +24,42 @@ atomic_int PythonEmbedded::_pythonInstances{0};
 PyThreadState* PythonEmbedded::_pythonGlobalThreadState{nullptr};
 PyObject* PythonEmbedded::SplashError{nullptr};
 std::string PythonEmbedded::_capsuleName{"splash._splash"};
+thread_local bool PythonEmbedded::_isLoopThread{false};
+
+/*************/
+//! Release the GIL for the lifetime of the object
+//! From the loop thread, the mutex shared by all interpreters is released as well, so that other scripts can run meanwhile
+class PythonEmbedded::GilRelease
+{
+  public:
+    GilRelease()
+        : _threadState(PyEval_SaveThread())
+    {
+        if (_isLoopThread)
+            _pythonMutex.unlock();
+    }
+
+    ~GilRelease()
+    {
+        if (_isLoopThread)
+            _pythonMutex.lock();
+        PyEval_RestoreThread(_threadState);
+    }
+
+    GilRelease(const GilRelease&) = delete;
+    GilRelease& operator=(const GilRelease&) = delete;
+
+  private:
+    PyThreadState* _threadState{nullptr};
+};
+
+/*************/
+template <typename F>
+auto PythonEmbedded::callWithoutGil(F&& func)
+{
+    GilRelease gilRelease;
+    return func();
+}
 
 /*******************/
 // Embedded Python //
@@ -116,6 +157,58 @@ PyObject* PythonEmbedded::pythonGetTimings(PyObject* /*self*/, PyObject* /*args*
     return pythonTimerDict;
 }
 
+/*************/
+PyDoc_STRVAR(pythonGetRootBranchValues_doc__,
+    "Get the values of the leaves of a branch of the tree, for the World and each Scene\n"
+    "\n"
+    "splash.get_root_branch_values(branch)\n"
+    "\n"
+    "Args:\n"
+    "  branch (string): branch name, relative to the World or Scene branch, e.g. durations or stats\n"
+    "\n"
+    "Returns:\n"
+    "  A dict of the leaf values given their name, for each World or Scene name. Durations are in microseconds\n"
+    "\n"
+    "Raises:\n"
+    "  splash.error: if Splash instance is not available");
+
+PyObject* PythonEmbedded::pythonGetRootBranchValues(PyObject* /*self*/, PyObject* args, PyObject* kwds)
+{
+    auto that = getInstance();
+    if (!that || !that->_doLoop)
+    {
+        PyErr_SetString(SplashError, "Error accessing Splash instance");
+        return PyDict_New();
+    }
+
+    char* strBranch;
+    static const char* kwlist[] = {"branch", nullptr};
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "s", const_cast<char**>(kwlist), &strBranch))
+    {
+        PyErr_Warn(PyExc_Warning, "Wrong argument type or number");
+        return PyDict_New();
+    }
+
+    auto rootValues = callWithoutGil([&]() { return that->getRootBranchValues(string(strBranch)); });
+
+    PyObject* pythonRootDict = PyDict_New();
+    for (const auto& [rootName, values] : rootValues)
+    {
+        PyObject* pythonValueDict = PyDict_New();
+        for (const auto& [leafName, value] : values)
+        {
+            // Leaves holding a single value are given as that value
+            PyObject* val = value.size() == 1 ? convertFromValue(value[0]) : convertFromValue(value);
+            PyDict_SetItemString(pythonValueDict, leafName.c_str(), val);
+            Py_DECREF(val);
+        }
+        PyDict_SetItemString(pythonRootDict, rootName.c_str(), pythonValueDict);
+        Py_DECREF(pythonValueDict);
+    }
+
+    return pythonRootDict;
+}
+
 /*************/
 PyDoc_STRVAR(pythonGetMasterClock_doc__,
     "Get the master clock from Splash, in milliseconds\n"
@@ -250,7 +343,7 @@ PyObject* PythonEmbedded::pythonGetObjectList(PyObject* /*self*/, PyObject* /*ar
         return PyList_New(0);
     }
 
-    auto objects = that->getObjectList();
+    auto objects = callWithoutGil([&]() { return that->getObjectList(); });
     PyObject* pythonObjectList = PyList_New(objects.size());
     for (uint32_t i = 0; i < objects.size(); ++i)
         PyList_SetItem(pythonObjectList, i, Py_BuildValue("s", objects[i].c_str()));
@@ -494,11 +587,64 @@ PyObject* PythonEmbedded::pythonGetObjectAttribute(PyObject* /*self*/, PyObject*
         return PyList_New(0);
     }
 
-    auto result = that->getObjectAttribute(string(strName), string(strAttr));
+    auto result = callWithoutGil([&]() { return that->getObjectAttribute(string(strName), string(strAttr)); });
 
     return convertFromValue(result, static_cast<bool>(asDict));
 }
 
+/*************/
+PyDoc_STRVAR(pythonGetAttributesBatch_doc__,
+    "Get multiple attributes at once, all read from the same state of Splash\n"
+    "\n"
+    "Signature:\n"
+    "  splash.get_attributes_batch(attributes, as_dict=False)\n"
+    "\n"
+    "Args:\n"
+    "  attributes (list): list of (objectname, attribute) tuples\n"
+    "  as_dict (bool): if True, returns the values as dicts (if values are named)\n"
+    "\n"
+    "Returns:\n"
+    "  The list of the attribute values, in the same order\n"
+    "\n"
+    "Raises:\n"
+    "  splash.error: if Splash instance is not available");
+
+PyObject* PythonEmbedded::pythonGetAttributesBatch(PyObject* /*self*/, PyObject* args, PyObject* kwds)
+{
+    auto that = getInstance();
+    if (!that || !that->_doLoop)
+    {
+        PyErr_SetString(SplashError, "Error accessing Splash instance");
+        return PyList_New(0);
+    }
+
+    PyObject* pyAttributes;
+    int asDict = 0;
+    static const char* kwlist[] = {"attributes", "as_dict", nullptr};
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "O|p", const_cast<char**>(kwlist), &pyAttributes, &asDict))
+    {
+        PyErr_Warn(PyExc_Warning, "Wrong argument type or number");
+        return PyList_New(0);
+    }
+
+    vector<pair<string, string>> attributes;
+    if (!parseBatch(pyAttributes, 2, [&](PyObject** items) {
+            attributes.emplace_back(PyUnicode_AsUTF8(items[0]), PyUnicode_AsUTF8(items[1]));
+            return true;
+        }))
+    {
+        PyErr_Warn(PyExc_Warning, "Attributes should be given as a list of (objectname, attribute) tuples");
+        return PyList_New(0);
+    }
+
+    auto results = callWithoutGil([&]() { return that->getObjectsAttributes(attributes); });
+    auto pyResults = PyList_New(results.size());
+    for (size_t i = 0; i < results.size(); ++i)
+        PyList_SetItem(pyResults, i, convertFromValue(results[i], static_cast<bool>(asDict)));
+
+    return pyResults;
+}
+
 /*************/
 PyDoc_STRVAR(pythonGetObjectAttributes_doc__,
     "Get attributes for the given object\n"
@@ -532,7 +678,7 @@ PyObject* PythonEmbedded::pythonGetObjectAttributes(PyObject* /*self*/, PyObject
         return PyDict_New();
     }
 
-    auto result = that->getObjectAttributes(string(strName));
+    auto result = callWithoutGil([&]() { return that->getObjectAttributes(string(strName)); });
     auto pyResult = PyDict_New();
     for (auto& r : result)
     {
@@ -566,7 +712,7 @@ PyObject* PythonEmbedded::pythonGetObjectLinks(PyObject* /*self*/, PyObject* /*a
         return PyList_New(0);
     }
 
-    auto objects = that->getObjectLinks();
+    auto objects = callWithoutGil([&]() { return that->getObjectLinks(); });
     PyObject* pythonObjectDict = PyDict_New();
     for (auto& obj : objects)
     {
@@ -602,7 +748,7 @@ PyObject* PythonEmbedded::pythonGetObjectReversedLinks(PyObject* /*self*/, PyObj
         return PyList_New(0);
     }
 
-    auto objects = that->getObjectReversedLinks();
+    auto objects = callWithoutGil([&]() { return that->getObjectReversedLinks(); });
     PyObject* pythonObjectDict = PyDict_New();
     for (auto& obj : objects)
     {
@@ -706,7 +852,7 @@ PyObject* PythonEmbedded::pythonSetGlobal(PyObject* /*self*/, PyObject* args, Py
     }
 
     auto value = convertToValue(pyValue).as<Values>();
-    that->setWorldAttribute(string(attrName), value);
+    callWithoutGil([&]() { that->setWorldAttribute(string(attrName), value); });
 
     Py_INCREF(Py_True);
     return Py_True;
@@ -752,7 +898,59 @@ PyObject* PythonEmbedded::pythonSetObject(PyObject* /*self*/, PyObject* args, Py
     }
 
     auto value = convertToValue(pyValue).as<Values>();
-    that->setObjectAttribute(string(strName), string(strAttr), value);
+    callWithoutGil([&]() { that->setObjectAttribute(string(strName), string(strAttr), value); });
+
+    Py_INCREF(Py_True);
+    return Py_True;
+}
+
+/*************/
+PyDoc_STRVAR(pythonSetAttributesBatch_doc__,
+    "Set multiple attributes at once. The changes are applied together, at the beginning of the same frame\n"
+    "\n"
+    "Signature:\n"
+    "  splash.set_attributes_batch(attributes)\n"
+    "\n"
+    "Args:\n"
+    "  attributes (list): list of (objectname, attribute, value) tuples, applied in this order\n"
+    "\n"
+    "Returns:\n"
+    "  True if all went well\n"
+    "\n"
+    "Raises:\n"
+    "  splash.error: if Splash instance is not available");
+
+PyObject* PythonEmbedded::pythonSetAttributesBatch(PyObject* /*self*/, PyObject* args, PyObject* kwds)
+{
+    auto that = getInstance();
+    if (!that || !that->_doLoop)
+    {
+        PyErr_SetString(SplashError, "Error accessing Splash instance");
+        Py_INCREF(Py_False);
+        return Py_False;
+    }
+
+    PyObject* pyAttributes;
+    static const char* kwlist[] = {"attributes", nullptr};
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "O", const_cast<char**>(kwlist), &pyAttributes))
+    {
+        PyErr_Warn(PyExc_Warning, "Wrong argument type or number");
+        Py_INCREF(Py_False);
+        return Py_False;
+    }
+
+    vector<tuple<string, string, Values>> attributes;
+    if (!parseBatch(pyAttributes, 3, [&](PyObject** items) {
+            attributes.emplace_back(PyUnicode_AsUTF8(items[0]), PyUnicode_AsUTF8(items[1]), convertToValue(items[2]).as<Values>());
+            return true;
+        }))
+    {
+        PyErr_Warn(PyExc_Warning, "Attributes should be given as a list of (objectname, attribute, value) tuples");
+        Py_INCREF(Py_False);
+        return Py_False;
+    }
+
+    callWithoutGil([&]() { that->setObjectsAttributes(attributes); });
 
     Py_INCREF(Py_True);
     return Py_True;
@@ -798,7 +996,7 @@ PyObject* PythonEmbedded::pythonSetObjectsOfType(PyObject* /*self*/, PyObject* a
     }
 
     auto value = convertToValue(pyValue).as<Values>();
-    that->setObjectsOfType(string(strType), string(strAttr), value);
+    callWithoutGil([&]() { that->setObjectsOfType(string(strType), string(strAttr), value); });
 
     Py_INCREF(Py_True);
     return Py_True;
@@ -883,6 +1081,7 @@ PyObject* PythonEmbedded::pythonAddCustomAttribute(PyObject* /*self*/, PyObject*
 /*************/
 PyDoc_STRVAR(pythonRegisterAttributeCallback_doc__,
     "Register a callback to the attribute of the given Splash object\n"
+    "The callback is run by the script thread, before the next call to splash_loop\n"
     "\n"
     "Signature:\n"
     "  splash.register_attribute_callback(object_name, attribute, callback)\n"
@@ -930,30 +1129,21 @@ PyObject* PythonEmbedded::pythonRegisterAttributeCallback(PyObject* /*self*/, Py
         return Py_BuildValue("I", 0);
     }
 
-    auto callbackFunc = [that, callable](const string& obj, const string& attr) {
+    // The callback is called from Splash threads, it only queues the call to be run by the Python loop
+    auto callbackId = make_shared<uint32_t>(0);
+    auto callbackFunc = [that, callbackId](const string& obj, const string& attr) {
         lock_guard<mutex> lockCb(that->_attributeCallbackMutex);
-
-        unique_lock<recursive_mutex> pythonMutexLock(_pythonMutex);
-        PyEval_AcquireThread(that->_pythonGlobalThreadState);
-        PyThreadState_Swap(that->_pythonLocalThreadState);
-
-        auto pyTuple = PyTuple_New(2);
-        PyTuple_SetItem(pyTuple, 0, Py_BuildValue("s", obj.c_str()));
-        PyTuple_SetItem(pyTuple, 1, Py_BuildValue("s", attr.c_str()));
-
-        PyObject_CallObject(callable, pyTuple);
-        if (PyErr_Occurred())
-            PyErr_Print();
-
-        Py_DECREF(pyTuple);
-
-        PyThreadState_Swap(that->_pythonGlobalThreadState);
-        PyEval_ReleaseThread(that->_pythonGlobalThreadState);
+        if (that->_pendingCallbacks.size() >= SPLASH_PYTHON_MAX_PENDING_CALLBACKS)
+            that->_pendingCallbacks.pop_front();
+        that->_pendingCallbacks.push_back({*callbackId, obj, attr});
     };
 
     lock_guard<mutex> lockCb(that->_attributeCallbackMutex);
     auto handle = splashObject->registerCallback(attributeName, callbackFunc);
+    *callbackId = handle.getId();
     auto pyHandleId = Py_BuildValue("I", handle.getId());
+    Py_INCREF(callable);
+    that->_attributeCallables[handle.getId()] = callable;
     that->_attributeCallbackHandles[handle.getId()] = std::move(handle);
 
     return pyHandleId;
@@ -1009,6 +1199,11 @@ PyObject* PythonEmbedded::pythonUnregisterAttributeCallback(PyObject* /*self*/,
     }
 
     that->_attributeCallbackHandles.erase(callbackIt);
+    if (auto callableIt = that->_attributeCallables.find(callbackId); callableIt != that->_attributeCallables.end())
+    {
+        Py_DECREF(callableIt->second);
+        that->_attributeCallables.erase(callableIt);
+    }
 
     Py_INCREF(Py_True);
     return Py_True;
@@ -1031,13 +1226,16 @@ PyMethodDef PythonEmbedded::SplashMethods[] = {
     {(const char*)"get_objects_of_type", (PyCFunction)PythonEmbedded::pythonGetObjectsOfType, METH_VARARGS | METH_KEYWORDS, pythonGetObjectsOfType_doc__},
     {(const char*)"get_object_attribute", (PyCFunction)PythonEmbedded::pythonGetObjectAttribute, METH_VARARGS | METH_KEYWORDS, pythonGetObjectAttribute_doc__},
     {(const char*)"get_object_attributes", (PyCFunction)PythonEmbedded::pythonGetObjectAttributes, METH_VARARGS | METH_KEYWORDS, pythonGetObjectAttributes_doc__},
+    {(const char*)"get_attributes_batch", (PyCFunction)PythonEmbedded::pythonGetAttributesBatch, METH_VARARGS | METH_KEYWORDS, pythonGetAttributesBatch_doc__},
     {(const char*)"get_object_links", (PyCFunction)PythonEmbedded::pythonGetObjectLinks, METH_VARARGS | METH_KEYWORDS, pythonGetObjectLinks_doc__},
     {(const char*)"get_object_reversed_links", (PyCFunction)PythonEmbedded::pythonGetObjectReversedLinks, METH_VARARGS | METH_KEYWORDS, pythonGetObjectReversedLinks_doc__},
     {(const char*)"get_types_from_category", (PyCFunction)PythonEmbedded::pythonGetTypesFromCategory, METH_VARARGS | METH_KEYWORDS, pythonGetTypesFromCategory_doc__},
     {(const char*)"get_timings", (PyCFunction)PythonEmbedded::pythonGetTimings, METH_VARARGS, pythonGetTimings_doc__},
+    {(const char*)"get_root_branch_values", (PyCFunction)PythonEmbedded::pythonGetRootBranchValues, METH_VARARGS | METH_KEYWORDS, pythonGetRootBranchValues_doc__},
     {(const char*)"register_attribute_callback", (PyCFunction)PythonEmbedded::pythonRegisterAttributeCallback, METH_VARARGS | METH_KEYWORDS, pythonRegisterAttributeCallback_doc__},
     {(const char*)"set_world_attribute", (PyCFunction)PythonEmbedded::pythonSetGlobal, METH_VARARGS | METH_KEYWORDS, pythonSetGlobal_doc__},
     {(const char*)"set_object_attribute", (PyCFunction)PythonEmbedded::pythonSetObject, METH_VARARGS | METH_KEYWORDS, pythonSetObject_doc__},
+    {(const char*)"set_attributes_batch", (PyCFunction)PythonEmbedded::pythonSetAttributesBatch, METH_VARARGS | METH_KEYWORDS, pythonSetAttributesBatch_doc__},
     {(const char*)"set_objects_of_type", (PyCFunction)PythonEmbedded::pythonSetObjectsOfType, METH_VARARGS | METH_KEYWORDS, pythonSetObjectsOfType_doc__},
     {(const char*)"unregister_attribute_callback", (PyCFunction)PythonEmbedded::pythonUnregisterAttributeCallback, METH_VARARGS | METH_KEYWORDS, pythonUnregisterAttributeCallback_doc__},
     {nullptr, nullptr, 0, nullptr}
@@ -1077,6 +1275,12 @@ PyObject* PythonEmbedded::pythonInitSplash()
     Py_INCREF(&PythonSink::pythonSinkType);
     PyModule_AddObject(module, "Sink", (PyObject*)&PythonSink::pythonSinkType);
 
+    if (PyType_Ready(&PythonSink::pythonSinkFrameType) < 0)
+    {
+        Log::get() << Log::WARNING << "PythonEmbedded::" << __FUNCTION__ << " - Sink frame type is not ready" << Log::endl;
+        return nullptr;
+    }
+
     SplashError = PyErr_NewException((const char*)"splash.error", PyExc_Exception, nullptr);
     if (SplashError)
     {
@@ -1165,6 +1369,7 @@ void PythonEmbedded::stop()
 void PythonEmbedded::loop()
 {
     PyObject* pName;
+    _isLoopThread = true;
 
     // Create the sub-interpreter
     unique_lock<recursive_mutex> pythonMutexLock(_pythonMutex);
@@ -1240,6 +1445,8 @@ void PythonEmbedded::loop()
             _attributesToUpdate.clear();
             lockAttributes.unlock();
 
+            runPendingCallbacks();
+
             // Run the loop
             auto returnValue = PyObject_CallObject(pFuncLoop, nullptr);
             if (returnValue != nullptr)
@@ -1294,6 +1501,15 @@ void PythonEmbedded::loop()
             Py_XDECREF(pFuncStop);
         }
 
+        // Callbacks must not outlive the interpreter
+        unique_lock<mutex> lockCb(_attributeCallbackMutex);
+        _attributeCallbackHandles.clear();
+        for (auto& [id, callable] : _attributeCallables)
+            Py_DECREF(callable);
+        _attributeCallables.clear();
+        _pendingCallbacks.clear();
+        lockCb.unlock();
+
         Py_DECREF(_pythonModule);
 
         PyThreadState_Swap(_pythonGlobalThreadState);
@@ -1325,6 +1541,42 @@ void PythonEmbedded::loop()
     pythonMutexLock.unlock();
 }
 
+/*************/
+void PythonEmbedded::runPendingCallbacks()
+{
+    deque<PendingCallback> pendingCallbacks;
+    unique_lock<mutex> lockCb(_attributeCallbackMutex);
+    std::swap(pendingCallbacks, _pendingCallbacks);
+    lockCb.unlock();
+
+    for (const auto& pendingCallback : pendingCallbacks)
+    {
+        // The callback may have been unregistered since it was queued, possibly by a previous callback
+        lockCb.lock();
+        auto callableIt = _attributeCallables.find(pendingCallback.id);
+        if (callableIt == _attributeCallables.end())
+        {
+            lockCb.unlock();
+            continue;
+        }
+        auto callable = callableIt->second;
+        Py_INCREF(callable);
+        lockCb.unlock();
+
+        auto pyTuple = PyTuple_New(2);
+        PyTuple_SetItem(pyTuple, 0, Py_BuildValue("s", pendingCallback.object.c_str()));
+        PyTuple_SetItem(pyTuple, 1, Py_BuildValue("s", pendingCallback.attribute.c_str()));
+
+        auto returnValue = PyObject_CallObject(callable, pyTuple);
+        Py_XDECREF(returnValue);
+        if (PyErr_Occurred())
+            PyErr_Print();
+
+        Py_DECREF(pyTuple);
+        Py_DECREF(callable);
+    }
+}
+
 /*************/
 PyObject* PythonEmbedded::getFuncFromModule(PyObject* module, const string& name)
 {
@@ -1364,6 +1616,16 @@ PyObject* PythonEmbedded::convertFromValue(const Value& value, bool toDict)
             auto buffer = v.as<Value::Buffer>();
             pyValue = Py_BuildValue("y#", reinterpret_cast<char*>(buffer.data()), buffer.size());
         }
+        else if (v.getType() == Value::Type::reals)
+        {
+            // Exposed as a memoryview of floats, which numpy wraps without copying through the buffer protocol
+            const auto& reals = v.asRef<Value::Reals>();
+            auto bytes = PyBytes_FromStringAndSize(reinterpret_cast<const char*>(reals.data()), reals.size() * sizeof(float));
+            auto memoryView = PyMemoryView_FromObject(bytes);
+            Py_DECREF(bytes);
+            pyValue = PyObject_CallMethod(memoryView, "cast", "s", "f");
+            Py_DECREF(memoryView);
+        }
         else if (v.getType() == Value::Type::values)
         {
             auto values = v.as<Values>();
@@ -1388,6 +1650,37 @@ PyObject* PythonEmbedded::convertFromValue(const Value& value, bool toDict)
     return parseValue(value);
 }
 
+/*************/
+bool PythonEmbedded::parseBatch(PyObject* pyObject, Py_ssize_t itemSize, const function<bool(PyObject**)>& parseItem)
+{
+    auto sequence = PySequence_Fast(pyObject, "");
+    if (!sequence)
+    {
+        PyErr_Clear();
+        return false;
+    }
+
+    bool success = true;
+    auto length = PySequence_Fast_GET_SIZE(sequence);
+    for (Py_ssize_t i = 0; i < length && success; ++i)
+    {
+        auto item = PySequence_Fast(PySequence_Fast_GET_ITEM(sequence, i), "");
+        if (!item)
+        {
+            PyErr_Clear();
+            success = false;
+            break;
+        }
+
+        auto items = PySequence_Fast_ITEMS(item);
+        success = PySequence_Fast_GET_SIZE(item) == itemSize && PyUnicode_Check(items[0]) && PyUnicode_Check(items[1]) && parseItem(items);
+        Py_DECREF(item);
+    }
+
+    Py_DECREF(sequence);
+    return success;
+}
+
 /*************/
 Value PythonEmbedded::convertToValue(PyObject* pyObject)
 {
@@ -1417,6 +1710,41 @@ Value PythonEmbedded::convertToValue(PyObject* pyObject)
             if (PyBytes_AsStringAndSize(obj, reinterpret_cast<char**>(&bytes), &size) != -1)
                 value = Value::Buffer(bytes, bytes + size);
         }
+        else if (PyObject_CheckBuffer(obj))
+        {
+            // Arrays of floats or doubles, such as numpy arrays, are copied in bulk to contiguous reals
+            Py_buffer view;
+            if (PyObject_GetBuffer(obj, &view, PyBUF_C_CONTIGUOUS | PyBUF_FORMAT) == -1)
+            {
+                PyErr_Clear();
+                return value;
+            }
+
+            const string format = view.format ? view.format : "B";
+            const auto type = format.empty() ? 'B' : format.back();
+            const bool nativeOrder = format.size() == 1 || format[0] == '@' || format[0] == '=';
+            if (type == 'f' && view.itemsize == sizeof(float) && nativeOrder)
+            {
+                Value::Reals reals(view.len / sizeof(float));
+                memcpy(reals.data(), view.buf, reals.size() * sizeof(float));
+                value = reals;
+            }
+            else if (type == 'd' && view.itemsize == sizeof(double) && nativeOrder)
+            {
+                Value::Reals reals(view.len / sizeof(double));
+                auto doubles = reinterpret_cast<const double*>(view.buf);
+                for (uint32_t i = 0; i < reals.size(); ++i)
+                    reals[i] = static_cast<float>(doubles[i]);
+                value = reals;
+            }
+            else
+            {
+                auto bytes = reinterpret_cast<uint8_t*>(view.buf);
+                value = Value::Buffer(bytes, bytes + view.len);
+            }
+
+            PyBuffer_Release(&view);
+        }
         else
         {
             value = "";
@@ -26,6 +26,8 @@
 #define SPLASH_PYTHON_EMBEDDED_H
 
 #include <atomic>
+#include <deque>
+#include <functional>
 #include <future>
 #include <iostream>
 #include <string>
@@ -97,21 +99,47 @@ class PythonEmbedded : public ControllerObject
     PyObject* _pythonModule{nullptr};                //!< Loaded module (from the specified script)
     PyThreadState* _pythonLocalThreadState{nullptr}; //!< Local Python thread state, for the sub-interpreter
 
+    //! Attribute callback triggered by Splash, waiting to be run in the Python loop
+    struct PendingCallback
+    {
+        uint32_t id{0};
+        std::string object{};
+        std::string attribute{};
+    };
+
     std::mutex _attributesMutex{};
     std::mutex _attributeCallbackMutex{};
     std::map<uint32_t, CallbackHandle> _attributeCallbackHandles{};
+    std::map<uint32_t, PyObject*> _attributeCallables{}; //!< Python callables of the callbacks, a reference is held for each
+    std::deque<PendingCallback> _pendingCallbacks{};     //!< Callbacks queued by Splash threads, run by the Python loop
     std::map<std::string, Values> _attributesValue{};
     std::map<std::string, Values> _attributesToUpdate{};
 
     static std::recursive_mutex _pythonMutex;
     static std::atomic_int _pythonInstances;        //!< Number of Python scripts running
     static PyThreadState* _pythonGlobalThreadState; //!< Global Python thread state, shared by all PythonEmbedded instances
+    static thread_local bool _isLoopThread;         //!< True in the Python loop threads, which hold _pythonMutex while running Python code
+
+    class GilRelease;
+
+    /**
+     * \brief Run the given function with the GIL released, to be used for calls which may block on Splash
+     * \param func Function to run, which must not use the Python API
+     * \return Return the result of the function
+     */
+    template <typename F>
+    static auto callWithoutGil(F&& func);
 
     /**
      * \brief Python interpreter main loop
      */
     void loop();
 
+    /**
+     * \brief Run the attribute callbacks queued since the last call, the GIL must be held
+     */
+    void runPendingCallbacks();
+
     /**
      * \brief Get a Python function from the given module
      * \param module Python module
@@ -135,6 +163,15 @@ class PythonEmbedded : public ControllerObject
      */
     static Value convertToValue(PyObject* pyObject);
 
+    /**
+     * \brief Parse a Python list of tuples, each starting with two strings
+     * \param pyObject Python sequence to parse
+     * \param itemSize Expected size of each tuple
+     * \param parseItem Function called with the items of each tuple, returning false on error
+     * \return Return true if the whole sequence was parsed
+     */
+    static bool parseBatch(PyObject* pyObject, Py_ssize_t itemSize, const std::function<bool(PyObject**)>& parseItem);
+
     /**
      * \brief Register new functors to modify attributes
      */
@@ -148,6 +185,7 @@ class PythonEmbedded : public ControllerObject
     static PyObject* pythonGetInterpreterName(PyObject* self, PyObject* args);
     static PyObject* pythonGetLogs(PyObject* self, PyObject* args);
     static PyObject* pythonGetTimings(PyObject* self, PyObject* args);
+    static PyObject* pythonGetRootBranchValues(PyObject* self, PyObject* args, PyObject* kwds);
     static PyObject* pythonGetMasterClock(PyObject* self, PyObject* args);
     static PyObject* pythonGetObjectAlias(PyObject* self, PyObject* args, PyObject* kwds);
     static PyObject* pythonGetObjectAliases(PyObject* self, PyObject* args);
@@ -159,11 +197,13 @@ class PythonEmbedded : public ControllerObject
     static PyObject* pythonGetObjectsOfType(PyObject* self, PyObject* args, PyObject* kwds);
     static PyObject* pythonGetObjectAttribute(PyObject* self, PyObject* args, PyObject* kwds);
     static PyObject* pythonGetObjectAttributes(PyObject* self, PyObject* args, PyObject* kwds);
+    static PyObject* pythonGetAttributesBatch(PyObject* self, PyObject* args, PyObject* kwds);
     static PyObject* pythonGetObjectLinks(PyObject* self, PyObject* args);
     static PyObject* pythonGetObjectReversedLinks(PyObject* self, PyObject* args);
     static PyObject* pythonGetTypesFromCategory(PyObject* self, PyObject* args, PyObject* kwds);
     static PyObject* pythonSetGlobal(PyObject* self, PyObject* args, PyObject* kwds);
     static PyObject* pythonSetObject(PyObject* self, PyObject* args, PyObject* kwds);
+    static PyObject* pythonSetAttributesBatch(PyObject* self, PyObject* args, PyObject* kwds);
     static PyObject* pythonSetObjectsOfType(PyObject* self, PyObject* args, PyObject* kwds);
     static PyObject* pythonAddCustomAttribute(PyObject* self, PyObject* args, PyObject* kwds);
     static PyObject* pythonRegisterAttributeCallback(PyObject* self, PyObject* args, PyObject* kwds);
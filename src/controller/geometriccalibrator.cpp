@@ -22,6 +22,9 @@
 #include "./image/image_gphoto.h"
 #endif
 
+#define SPLASH_GEOMETRICCALIBRATOR_POLL_PERIOD 2   // Polling period while waiting for a pattern to be displayed or grabbed, in ms
+#define SPLASH_GEOMETRICCALIBRATOR_GRAB_TIMEOUT 30 // Maximum time to wait for a frame from the grabber, in s
+
 namespace Splash
 {
 
@@ -99,6 +102,24 @@ void GeometricCalibrator::unlinkIt(const std::shared_ptr<GraphObject>& obj)
         _grabber.reset();
 }
 
+/*************/
+ImageBuffer GeometricCalibrator::waitForGrabbedFrame(int64_t after)
+{
+    // Only the timestamp is polled, the frame is copied once it is recent enough
+    const auto deadline = Timer::getTime() + SPLASH_GEOMETRICCALIBRATOR_GRAB_TIMEOUT * 1000000;
+    while (_grabber->getTimestamp() < after)
+    {
+        if (_abortCalibration || Timer::getTime() > deadline)
+        {
+            Log::get() << Log::WARNING << "GeometricCalibrator::" << __FUNCTION__ << " - No frame has been grabbed in time" << Log::endl;
+            return {};
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(SPLASH_GEOMETRICCALIBRATOR_POLL_PERIOD));
+    }
+
+    return _grabber->get();
+}
+
 /*************/
 GeometricCalibrator::ConfigurationState GeometricCalibrator::saveCurrentState()
 {
@@ -211,7 +232,6 @@ std::optional<GeometricCalibrator::Calibration> GeometricCalibrator::calibration
 {
     // Begin calibration
     calimiro::Workspace workspace;
-    calimiro::Structured_Light structuredLight(&_logger, _structuredLightScale);
 
     // Set all cameras to display a pattern
     for (size_t index = 0; index < state.windowList.size(); ++index)
@@ -244,14 +264,18 @@ std::optional<GeometricCalibrator::Calibration> GeometricCalibrator::calibration
         }
 
         // For each position, capture the patterns for all cameras
-        std::vector<cv::Mat2i> decodedProjectors;
+        // The patterns of a camera are decoded while the ones of the next cameras are captured
+        using Decoding = std::pair<cv::Mat2i, calimiro::Workspace::ImageList>;
+        std::vector<std::future<std::optional<Decoding>>> decodings;
+        std::vector<std::future<void>> patternWrites;
         for (size_t cameraIndex = 0; cameraIndex < state.cameraList.size(); ++cameraIndex)
         {
             const auto& cameraName = state.cameraList[cameraIndex];
             auto cameraSize = getObjectAttribute(cameraName, "size");
             auto camWidth = cameraSize[0].as<int>();
             auto camHeight = cameraSize[1].as<int>();
-            auto patterns = structuredLight.create(camWidth, camHeight);
+            auto structuredLight = std::make_shared<calimiro::Structured_Light>(&_logger, _structuredLightScale);
+            auto patterns = structuredLight->create(camWidth, camHeight);
 
             // Convert patterns to RGB
             for (auto& pattern : patterns)
@@ -294,7 +318,12 @@ std::optional<GeometricCalibrator::Calibration> GeometricCalibrator::calibration
             layout[targetLayoutIndex] = 2; // This index will display the third texture, named _worldImageName
             setObjectAttribute(targetFilterName, "texLayout", layout);
 
-            std::vector<cv::Mat1b> capturedPatterns{};
+            const std::string directory = workspace.getWorkPath() + "/pos_" + std::to_string(positionIndex);
+            std::filesystem::create_directory(directory);
+
+            // Captured frames are converted while the next patterns are displayed and captured
+            // Each pattern is handed to the decoding once converted, its copy in the workspace being written afterwards
+            std::vector<std::future<std::optional<cv::Mat1b>>> capturedPatterns{};
             for (size_t patternIndex = 0; patternIndex < patterns.size(); ++patternIndex)
             {
                 auto& pattern = patterns[patternIndex];
@@ -312,7 +341,7 @@ std::optional<GeometricCalibrator::Calibration> GeometricCalibrator::calibration
                 sendBuffer(_worldImageName, serializedImage);
                 for (int64_t updatedTimestamp = 0; updatedTimestamp != imageObject.getTimestamp();
                      updatedTimestamp = getObjectAttribute(targetWindowName, "timestamp")[0].as<int64_t>())
-                    std::this_thread::sleep_for(15ms);
+                    std::this_thread::sleep_for(std::chrono::milliseconds(SPLASH_GEOMETRICCALIBRATOR_POLL_PERIOD));
 
                 // Wait for a few more frames to be drawn, to account for double buffering,
                 // and exposure time of the input grabber
@@ -321,50 +350,48 @@ std::optional<GeometricCalibrator::Calibration> GeometricCalibrator::calibration
                 const auto updateTime = Timer::getTime();
                 // Some grabber need to be asked to capture a frame
                 setObjectAttribute(_grabber->getName(), "capture", {1});
-                while (updateTime > imageBuffer.getSpec().timestamp)
-                {
-                    imageBuffer = _grabber->get();
-                    std::this_thread::sleep_for(100ms);
-                }
-
-                if (imageBuffer.empty())
+                auto frame = std::make_shared<ImageBuffer>(waitForGrabbedFrame(updateTime));
+                if (frame->empty())
                     return {};
 
-                spec = imageBuffer.getSpec();
-                cv::Mat capturedImage;
+                const auto patternPath = directory + "/prj" + std::to_string(cameraIndex) + "_pattern" + std::to_string(patternIndex) + ".jpg";
+                auto capturedPattern = std::make_shared<std::promise<std::optional<cv::Mat1b>>>();
+                capturedPatterns.push_back(capturedPattern->get_future());
+                patternWrites.push_back(std::async(std::launch::async, [frame, patternPath, capturedPattern]() {
+                    const auto& spec = frame->getSpec();
+                    cv::Mat capturedImage;
 
-                if (spec.format.find("RGB") != std::string::npos)
-                {
-                    assert(spec.channels == 4 || spec.channels == 3); // All Image classes should output RGB or RGBA (when uncompressed)
-                    capturedImage = cv::Mat(spec.height, spec.width, spec.channels == 4 ? CV_8UC4 : CV_8UC3, imageBuffer.data());
-                    cv::cvtColor(capturedImage, capturedImage, cv::COLOR_RGB2GRAY);
-                }
-                else if (spec.format.find("BGR") != std::string::npos)
-                {
-                    assert(spec.channels == 4 || spec.channels == 3);
-                    auto bgraImage = cv::Mat(spec.height, spec.width, spec.channels == 4 ? CV_8UC4 : CV_8UC3, imageBuffer.data());
-                    cv::cvtColor(bgraImage, capturedImage, cv::COLOR_BGR2GRAY);
-                }
-                else if (spec.format == "YUYV")
-                {
-                    assert(spec.channels == 3 && spec.bpp == 16);
-                    auto yuvImage = cv::Mat(spec.height, spec.width, CV_8UC2, imageBuffer.data());
-                    cv::cvtColor(yuvImage, capturedImage, cv::COLOR_YUV2RGB_YUYV);
-                }
-                else
-                {
-                    Log::get() << Log::WARNING << "GeometricCalibrator::" << __FUNCTION__ << " - Format " << spec.format << " is not supported" << Log::endl;
-                    return {};
-                }
-
-                cv::Mat1b grayscale(spec.height, spec.width);
-                int fromTo[] = {0, 0};
-                cv::mixChannels(&capturedImage, 1, &grayscale, 1, fromTo, 1);
-                capturedPatterns.push_back(grayscale);
+                    if (spec.format.find("RGB") != std::string::npos)
+                    {
+                        assert(spec.channels == 4 || spec.channels == 3); // All Image classes should output RGB or RGBA (when uncompressed)
+                        capturedImage = cv::Mat(spec.height, spec.width, spec.channels == 4 ? CV_8UC4 : CV_8UC3, frame->data());
+                        cv::cvtColor(capturedImage, capturedImage, cv::COLOR_RGB2GRAY);
+                    }
+                    else if (spec.format.find("BGR") != std::string::npos)
+                    {
+                        assert(spec.channels == 4 || spec.channels == 3);
+                        auto bgraImage = cv::Mat(spec.height, spec.width, spec.channels == 4 ? CV_8UC4 : CV_8UC3, frame->data());
+                        cv::cvtColor(bgraImage, capturedImage, cv::COLOR_BGR2GRAY);
+                    }
+                    else if (spec.format == "YUYV")
+                    {
+                        assert(spec.channels == 3 && spec.bpp == 16);
+                        auto yuvImage = cv::Mat(spec.height, spec.width, CV_8UC2, frame->data());
+                        cv::cvtColor(yuvImage, capturedImage, cv::COLOR_YUV2GRAY_YUYV);
+                    }
+                    else
+                    {
+                        Log::get() << Log::WARNING << "GeometricCalibrator::calibrationFunc - Format " << spec.format << " is not supported" << Log::endl;
+                        capturedPattern->set_value(std::nullopt);
+                        return;
+                    }
 
-                std::string directory = workspace.getWorkPath() + "/pos_" + std::to_string(positionIndex);
-                std::filesystem::create_directory(directory);
-                cv::imwrite(directory + "/prj" + std::to_string(cameraIndex) + "_pattern" + std::to_string(patternIndex) + ".jpg", capturedImage);
+                    cv::Mat1b grayscale(spec.height, spec.width);
+                    int fromTo[] = {0, 0};
+                    cv::mixChannels(&capturedImage, 1, &grayscale, 1, fromTo, 1);
+                    capturedPattern->set_value(grayscale);
+                    cv::imwrite(patternPath, capturedImage);
+                }));
 
 #ifdef DEBUG
                 std::string patternImageFilePath = directory + "/prj" + std::to_string(cameraIndex) + "_pattern" + std::to_string(patternIndex) + ".png";
@@ -379,22 +406,45 @@ std::optional<GeometricCalibrator::Calibration> GeometricCalibrator::calibration
             if (abortCurrentPosition)
                 break;
 
-            auto decoded = structuredLight.decode(camWidth, camHeight, capturedPatterns);
-            auto shadowMask = structuredLight.getShadowMask();
-            auto decodedCoords = structuredLight.getDecodedCoordinates(camWidth, camHeight);
+            const auto prefix = "decoded_images/pos_" + std::to_string(positionIndex) + "_proj" + std::to_string(cameraIndex);
+            decodings.push_back(std::async(std::launch::async,
+                [structuredLight, capturedPatterns = std::move(capturedPatterns), camWidth, camHeight, prefix]() mutable -> std::optional<Decoding> {
+                    std::vector<cv::Mat1b> grayscalePatterns{};
+                    for (auto& capturedPattern : capturedPatterns)
+                    {
+                        auto grayscale = capturedPattern.get();
+                        if (!grayscale)
+                            return {};
+                        grayscalePatterns.push_back(grayscale.value());
+                    }
 
-            if (!decoded || !shadowMask || !decodedCoords)
-                return {};
+                    auto decoded = structuredLight->decode(camWidth, camHeight, grayscalePatterns);
+                    auto shadowMask = structuredLight->getShadowMask();
+                    auto decodedCoords = structuredLight->getDecodedCoordinates(camWidth, camHeight);
+
+                    if (!decoded || !shadowMask || !decodedCoords)
+                        return {};
 
-            calimiro::Workspace::ImageList imagesToSave(
-                {{"decoded_images/pos_" + std::to_string(positionIndex) + "_proj" + std::to_string(cameraIndex) + "_shadow_mask.jpg", shadowMask.value()},
-                    {"decoded_images/pos_" + std::to_string(positionIndex) + "_proj" + std::to_string(cameraIndex) + "_x.jpg", decodedCoords.value().first},
-                    {"decoded_images/pos_" + std::to_string(positionIndex) + "_proj" + std::to_string(cameraIndex) + "_y.jpg", decodedCoords.value().second}});
-            if (!workspace.saveImagesFromList(imagesToSave))
+                    calimiro::Workspace::ImageList imagesToSave({{prefix + "_shadow_mask.jpg", shadowMask.value()},
+                        {prefix + "_x.jpg", decodedCoords.value().first},
+                        {prefix + "_y.jpg", decodedCoords.value().second}});
+                    return Decoding(decoded.value(), imagesToSave);
+                }));
+        }
+
+        std::vector<cv::Mat2i> decodedProjectors;
+        for (auto& decoding : decodings)
+        {
+            auto result = decoding.get();
+            if (!result || !workspace.saveImagesFromList(result->second))
                 return {};
-            decodedProjectors.push_back(decoded.value());
+            decodedProjectors.push_back(result->first);
         }
 
+        // The captured patterns are all in the workspace before going to the next position
+        for (auto& patternWrite : patternWrites)
+            patternWrite.wait();
+
         // Set all cameras to display a pattern
         for (size_t index = 0; index < state.windowList.size(); ++index)
         {
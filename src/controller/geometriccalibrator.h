@@ -142,6 +142,13 @@ class GeometricCalibrator : public ControllerObject
      */
     std::optional<Calibration> calibrationFunc(const ConfigurationState& state);
 
+    /**
+     * Wait for the grabber to output a frame captured after the given time
+     * \param after Time after which the frame must have been captured, in us
+     * \return Return the frame, or an empty buffer if none has been captured in time
+     */
+    ImageBuffer waitForGrabbedFrame(int64_t after);
+
     /**
      * Save the configuration state at the beginning of the calibration
      * \return Return the configuration state
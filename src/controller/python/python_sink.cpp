@@ -30,7 +30,6 @@ void PythonSink::pythonSinkDealloc(PythonSinkObject* self)
         that->setInScene("deleteObject", {*self->filterName});
     }
 
-    Py_XDECREF(self->lastBuffer);
     Py_TYPE(self)->tp_free((PyObject*)self);
 }
 
@@ -73,7 +72,7 @@ int PythonSink::pythonSinkInit(PythonSinkObject* self, PyObject* args, PyObject*
     self->framerate = 30;
     self->linked = false;
     self->opened = false;
-    self->lastBuffer = nullptr;
+    self->lastFrameIndex = 0;
 
     auto index = self->sinkIndex.fetch_add(1);
     self->sinkName = make_unique<string>(that->getName() + "_pythonsink_" + to_string(index));
@@ -272,15 +271,22 @@ PyObject* PythonSink::pythonSinkUnlink(PythonSinkObject* self)
 PyDoc_STRVAR(pythonSinkGrab_doc__,
     "Grab the latest image from the sink\n"
     "\n"
-    "splash.grab()\n"
+    "splash.grab(timeout=None)\n"
+    "\n"
+    "The image is not copied: it stays valid and unchanged until the returned memoryview\n"
+    "is released, either explicitly with its release() method or by leaving a 'with' block.\n"
+    "It can be wrapped without any copy with numpy.frombuffer(image, dtype=numpy.uint8).\n"
+    "\n"
+    "Args:\n"
+    "  timeout (float): If set, wait up to this duration in seconds for an image newer than the last grabbed one\n"
     "\n"
     "Returns:\n"
-    "  The grabbed image as a bytes object\n"
+    "  The grabbed image as a read only memoryview, or None if no image is available\n"
     "\n"
     "Raises:\n"
     "  splash.error: if Splash instance is not available");
 
-PyObject* PythonSink::pythonSinkGrab(PythonSinkObject* self)
+PyObject* PythonSink::pythonSinkGrab(PythonSinkObject* self, PyObject* args, PyObject* kwds)
 {
     auto that = PythonEmbedded::getInstance();
     if (!that)
@@ -296,6 +302,20 @@ PyObject* PythonSink::pythonSinkGrab(PythonSinkObject* self)
     if (!self->opened)
         return Py_BuildValue("");
 
+    PyObject* timeoutObject = nullptr;
+    static char* kwlist[] = {(char*)"timeout", nullptr};
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "|O", kwlist, &timeoutObject))
+        return nullptr;
+
+    int64_t timeout = -1;
+    if (timeoutObject && timeoutObject != Py_None)
+    {
+        auto seconds = PyFloat_AsDouble(timeoutObject);
+        if (PyErr_Occurred())
+            return nullptr;
+        timeout = std::max<int64_t>(0, static_cast<int64_t>(seconds * 1e6));
+    }
+
     // The Sink wrapper can be opened although its Splash counterpart has not
     // received the order yet. We wait for that
     Values opened({Value(false)});
@@ -305,15 +325,28 @@ PyObject* PythonSink::pythonSinkGrab(PythonSinkObject* self)
         this_thread::sleep_for(chrono::milliseconds(5));
     }
 
+    // Other Python threads can run while waiting for the next frame
+    if (timeout >= 0)
+    {
+        bool hasNewFrame = false;
+        Py_BEGIN_ALLOW_THREADS
+        hasNewFrame = self->sink->waitForFrame(self->lastFrameIndex, timeout);
+        Py_END_ALLOW_THREADS
+        if (!hasNewFrame)
+            return Py_BuildValue("");
+    }
+
     // Due to the asynchronicity of passing messages to Splash, the frame may still
     // be at a wrong resolution if set_size was called. We test for this case.
-    PyObject* buffer = nullptr;
+    shared_ptr<const ResizableArray<uint8_t>> frame{nullptr};
+    uint64_t frameIndex = 0;
     int triesLeft = SPLASH_PYTHON_MAX_TRIES;
     while (triesLeft)
     {
-        auto frame = self->sink->getBuffer();
-        if (frame.size() != self->width * self->height * 4 /* RGBA*/)
+        frame = self->sink->getFrame(&frameIndex);
+        if (!frame || frame->size() != self->width * self->height * 4 /* RGBA*/)
         {
+            frame.reset();
             --triesLeft;
             this_thread::sleep_for(chrono::milliseconds(5));
             // Keeping the ratio may also have had some effects
@@ -326,23 +359,23 @@ PyObject* PythonSink::pythonSinkGrab(PythonSinkObject* self)
         }
         else
         {
-            buffer = PyByteArray_FromStringAndSize(reinterpret_cast<char*>(frame.data()), frame.size());
             break;
         }
     }
 
-    if (!buffer)
+    if (!frame)
         return Py_BuildValue("");
+    self->lastFrameIndex = frameIndex;
 
-    PyObject* tmp = nullptr;
-    if (self->lastBuffer != nullptr)
-        tmp = self->lastBuffer;
-    self->lastBuffer = buffer;
-    if (tmp != nullptr)
-        Py_XDECREF(tmp);
+    auto frameObject = reinterpret_cast<PythonSinkFrameObject*>(pythonSinkFrameType.tp_alloc(&pythonSinkFrameType, 0));
+    if (!frameObject)
+        return nullptr;
+    frameObject->frame = frame;
 
-    Py_INCREF(self->lastBuffer);
-    return self->lastBuffer;
+    // The memoryview holds the only reference to the frame object
+    auto view = PyMemoryView_FromObject(reinterpret_cast<PyObject*>(frameObject));
+    Py_DECREF(frameObject);
+    return view;
 }
 
 /*************/
@@ -562,13 +595,6 @@ PyObject* PythonSink::pythonSinkClose(PythonSinkObject* self)
     that->setObjectAttribute(*self->sinkName, "opened", {0});
     self->opened = false;
 
-    PyObject* tmp = nullptr;
-    if (self->lastBuffer != nullptr)
-        tmp = self->lastBuffer;
-    self->lastBuffer = nullptr;
-    if (tmp != nullptr)
-        Py_XDECREF(tmp);
-
     Py_INCREF(Py_True);
     return Py_True;
 }
@@ -608,7 +634,7 @@ PyObject* PythonSink::pythonSinkGetCaps(PythonSinkObject* self)
 // clang-format off
 /*************/
 PyMethodDef PythonSink::SinkMethods[] = {
-    {(const char*)"grab", (PyCFunction)PythonSink::pythonSinkGrab, METH_NOARGS, pythonSinkGrab_doc__},
+    {(const char*)"grab", (PyCFunction)PythonSink::pythonSinkGrab, METH_VARARGS | METH_KEYWORDS, pythonSinkGrab_doc__},
     {(const char*)"set_size", (PyCFunction)PythonSink::pythonSinkSetSize, METH_VARARGS | METH_KEYWORDS, pythonSinkSetSize_doc__},
     {(const char*)"get_size", (PyCFunction)PythonSink::pythonSinkGetSize, METH_VARARGS | METH_KEYWORDS, pythonSinkGetSize_doc__},
     {(const char*)"set_framerate", (PyCFunction)PythonSink::pythonSinkSetFramerate, METH_VARARGS | METH_KEYWORDS, pythonSinkSetFramerate_doc__},
@@ -674,4 +700,61 @@ PyTypeObject PythonSink::pythonSinkType = {
 };
 // clang-format on
 
+/***********************/
+// Frame Python wrapper //
+/***********************/
+void PythonSink::pythonSinkFrameDealloc(PythonSinkFrameObject* self)
+{
+    self->frame.reset();
+    Py_TYPE(self)->tp_free((PyObject*)self);
+}
+
+/*************/
+int PythonSink::pythonSinkFrameGetBuffer(PythonSinkFrameObject* self, Py_buffer* view, int flags)
+{
+    if (!self->frame)
+    {
+        PyErr_SetString(PyExc_BufferError, "The frame has been released");
+        view->obj = nullptr;
+        return -1;
+    }
+
+    // The buffer is read only, as the same frame may be shared with other readers
+    auto data = const_cast<uint8_t*>(self->frame->data());
+    return PyBuffer_FillInfo(view, reinterpret_cast<PyObject*>(self), data, static_cast<Py_ssize_t>(self->frame->size()), 1, flags);
+}
+
+// clang-format off
+/*************/
+PyBufferProcs PythonSink::pythonSinkFrameBufferProcs = {
+    (getbufferproc)PythonSink::pythonSinkFrameGetBuffer, /* bf_getbuffer */
+    0                                                    /* bf_releasebuffer */
+};
+
+/*************/
+PyTypeObject PythonSink::pythonSinkFrameType = {
+    PyVarObject_HEAD_INIT(NULL, 0)
+    (const char*) "splash.Frame",                        /* tp_name */
+    sizeof(PythonSinkFrameObject),                       /* tp_basicsize */
+    0,                                                   /* tp_itemsize */
+    (destructor)PythonSink::pythonSinkFrameDealloc,      /* tp_dealloc */
+    0,                                                   /* tp_print */
+    0,                                                   /* tp_getattr */
+    0,                                                   /* tp_setattr */
+    0,                                                   /* tp_reserved */
+    0,                                                   /* tp_repr */
+    0,                                                   /* tp_as_number */
+    0,                                                   /* tp_as_sequence */
+    0,                                                   /* tp_as_mapping */
+    0,                                                   /* tp_hash  */
+    0,                                                   /* tp_call */
+    0,                                                   /* tp_str */
+    0,                                                   /* tp_getattro */
+    0,                                                   /* tp_setattro */
+    &PythonSink::pythonSinkFrameBufferProcs,             /* tp_as_buffer */
+    Py_TPFLAGS_DEFAULT,                                  /* tp_flags */
+    (const char*)"Splash Sink frame",                    /* tp_doc */
+};
+// clang-format on
+
 } // namespace Splash
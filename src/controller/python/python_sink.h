@@ -53,17 +53,24 @@ class PythonSink
         std::shared_ptr<Splash::Sink> sink;
         bool linked;
         bool opened;
-        PyObject* lastBuffer;
+        uint64_t lastFrameIndex;
     };
     PythonSinkObject pythonSinkObject;
 
+    //! Frame shared with Python through the buffer protocol, the pixels go back to the Sink frame pool once released
+    struct PythonSinkFrameObject
+    {
+        PyObject_HEAD
+        std::shared_ptr<const ResizableArray<uint8_t>> frame;
+    };
+
     // Sink wrapper methods. They are in this class to be able to access the Splash capsule
     static void pythonSinkDealloc(PythonSinkObject* self);
     static PyObject* pythonSinkNew(PyTypeObject* type, PyObject* args, PyObject* kwds);
     static int pythonSinkInit(PythonSinkObject* self, PyObject* args, PyObject* kwds);
     static PyObject* pythonSinkLink(PythonSinkObject* self, PyObject* args, PyObject* kwds);
     static PyObject* pythonSinkUnlink(PythonSinkObject* self);
-    static PyObject* pythonSinkGrab(PythonSinkObject* self);
+    static PyObject* pythonSinkGrab(PythonSinkObject* self, PyObject* args, PyObject* kwds);
     static PyObject* pythonSinkSetSize(PythonSinkObject* self, PyObject* args, PyObject* kwds);
     static PyObject* pythonSinkGetSize(PythonSinkObject* self);
     static PyObject* pythonSinkKeepRatio(PythonSinkObject* self, PyObject* args, PyObject* kwds);
@@ -74,6 +81,13 @@ class PythonSink
 
     static PyMethodDef SinkMethods[];
     static PyTypeObject pythonSinkType;
+
+    // Frame methods, exposing the frame pixels as a read only buffer
+    static void pythonSinkFrameDealloc(PythonSinkFrameObject* self);
+    static int pythonSinkFrameGetBuffer(PythonSinkFrameObject* self, Py_buffer* view, int flags);
+
+    static PyBufferProcs pythonSinkFrameBufferProcs;
+    static PyTypeObject pythonSinkFrameType;
 };
 
 }
@@ -0,0 +1,107 @@
+#include "./controller/widget/thumbnail_cache.h"
+
+#include <algorithm>
+
+#include "./utils/timer.h"
+
+using namespace std;
+
+namespace Splash
+{
+
+/*************/
+ThumbnailCache::ThumbnailCache()
+{
+    glCreateFramebuffers(1, &_readFbo);
+    glCreateFramebuffers(1, &_drawFbo);
+}
+
+/*************/
+ThumbnailCache::~ThumbnailCache()
+{
+    for (auto& [key, thumbnail] : _thumbnails)
+        glDeleteTextures(1, &thumbnail.texture);
+    glDeleteFramebuffers(1, &_readFbo);
+    glDeleteFramebuffers(1, &_drawFbo);
+}
+
+/*************/
+GLuint ThumbnailCache::get(const string& name, GLuint texture, int width, int height, int displayWidth)
+{
+    if (texture == 0 || width <= 0 || height <= 0 || displayWidth <= 0)
+        return texture;
+
+    // Thumbnail widths are powers of two, so that widgets showing a texture at similar sizes share it
+    int thumbnailWidth = 1;
+    while (thumbnailWidth < displayWidth && thumbnailWidth < SPLASH_THUMBNAIL_MAX_SIZE)
+        thumbnailWidth <<= 1;
+    if (thumbnailWidth >= width)
+        return texture;
+    int thumbnailHeight = std::max(1, static_cast<int>(static_cast<int64_t>(thumbnailWidth) * height / width));
+
+    const auto now = Timer::getTime();
+    auto& thumbnail = _thumbnails[{name, thumbnailWidth}];
+    thumbnail.lastRequest = now;
+
+    if (thumbnail.texture != 0 && thumbnail.height != thumbnailHeight)
+    {
+        glDeleteTextures(1, &thumbnail.texture);
+        thumbnail = Thumbnail();
+        thumbnail.lastRequest = now;
+    }
+
+    if (thumbnail.texture == 0)
+    {
+        glCreateTextures(GL_TEXTURE_2D, 1, &thumbnail.texture);
+        glTextureStorage2D(thumbnail.texture, 1, GL_RGBA8, thumbnailWidth, thumbnailHeight);
+        glTextureParameteri(thumbnail.texture, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTextureParameteri(thumbnail.texture, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTextureParameteri(thumbnail.texture, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTextureParameteri(thumbnail.texture, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        thumbnail.width = thumbnailWidth;
+        thumbnail.height = thumbnailHeight;
+    }
+
+    if (!thumbnail.valid && thumbnail.source == texture)
+        return texture;
+
+    if (thumbnail.source != texture || now - thumbnail.lastUpdate >= SPLASH_THUMBNAIL_REFRESH_PERIOD)
+    {
+        thumbnail.source = texture;
+        thumbnail.lastUpdate = now;
+
+        // Compressed or multi-planar textures cannot be attached, their widgets keep showing them directly
+        glNamedFramebufferTexture(_readFbo, GL_COLOR_ATTACHMENT0, texture, 0);
+        glNamedFramebufferTexture(_drawFbo, GL_COLOR_ATTACHMENT0, thumbnail.texture, 0);
+        thumbnail.valid = glCheckNamedFramebufferStatus(_readFbo, GL_READ_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+        if (!thumbnail.valid)
+            return texture;
+
+        glBlitNamedFramebuffer(_readFbo, _drawFbo, 0, 0, width, height, 0, 0, thumbnailWidth, thumbnailHeight, GL_COLOR_BUFFER_BIT, GL_LINEAR);
+    }
+
+    return thumbnail.texture;
+}
+
+/*************/
+void ThumbnailCache::purge()
+{
+    const auto now = Timer::getTime();
+    for (auto thumbnailIt = _thumbnails.begin(); thumbnailIt != _thumbnails.end();)
+    {
+        if (now - thumbnailIt->second.lastRequest > SPLASH_THUMBNAIL_EXPIRATION)
+        {
+            glDeleteTextures(1, &thumbnailIt->second.texture);
+            thumbnailIt = _thumbnails.erase(thumbnailIt);
+        }
+        else
+        {
+            ++thumbnailIt;
+        }
+    }
+
+    // The source textures are not kept attached, they may be deleted by their owners
+    glNamedFramebufferTexture(_readFbo, GL_COLOR_ATTACHMENT0, 0, 0);
+}
+
+} // namespace Splash
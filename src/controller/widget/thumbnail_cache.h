@@ -0,0 +1,101 @@
+/*
+ * Copyright (C) 2026 Emmanuel Durand
+ *
+ * This file is part of Splash.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Splash is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Splash.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * @thumbnail_cache.h
+ * Low resolution previews of textures, shared by the GUI widgets
+ */
+
+#ifndef SPLASH_THUMBNAIL_CACHE_H
+#define SPLASH_THUMBNAIL_CACHE_H
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <utility>
+
+#include "./core/constants.h"
+
+// Largest thumbnail width, in pixels
+#define SPLASH_THUMBNAIL_MAX_SIZE 512
+// Period between two updates of a thumbnail, in us
+#define SPLASH_THUMBNAIL_REFRESH_PERIOD 100000
+// Thumbnails which were not requested for this long are released, in us
+#define SPLASH_THUMBNAIL_EXPIRATION 5000000
+
+namespace Splash
+{
+
+/*************/
+//! Cache of low resolution copies of textures, drawn by the widgets instead of the full resolution textures
+//! Thumbnails are downscaled copies refreshed at a throttled rate, so that the GUI does not sample
+//! 4K or 8K textures at every frame. They are shared by all the widgets showing the same texture at a
+//! similar size. All methods must be called from the GUI rendering context.
+class ThumbnailCache
+{
+  public:
+    /**
+     * \brief Constructor
+     */
+    ThumbnailCache();
+
+    /**
+     * \brief Destructor, the GUI rendering context must be current
+     */
+    ~ThumbnailCache();
+
+    ThumbnailCache(const ThumbnailCache&) = delete;
+    ThumbnailCache& operator=(const ThumbnailCache&) = delete;
+
+    /**
+     * \brief Get the thumbnail of a texture, updated if it is older than the refresh period
+     * \param name Name of the object holding the texture
+     * \param texture Source texture id
+     * \param width Source texture width
+     * \param height Source texture height
+     * \param displayWidth Width at which the thumbnail is displayed
+     * \return Return the thumbnail texture id, or the source texture id if a thumbnail would not be smaller or could not be made
+     */
+    GLuint get(const std::string& name, GLuint texture, int width, int height, int displayWidth);
+
+    /**
+     * \brief Release the thumbnails which have not been requested recently
+     */
+    void purge();
+
+  private:
+    struct Thumbnail
+    {
+        GLuint texture{0};
+        GLuint source{0};       //!< Source texture id at the last update
+        int width{0};
+        int height{0};
+        int64_t lastUpdate{0};  //!< Time of the last update, in us
+        int64_t lastRequest{0}; //!< Time of the last request, in us
+        bool valid{true};       //!< False if the source could not be copied, which is then shown as is
+    };
+
+    GLuint _readFbo{0};
+    GLuint _drawFbo{0};
+    std::map<std::pair<std::string, int>, Thumbnail> _thumbnails{}; //!< Thumbnails, by object name and width
+};
+
+} // namespace Splash
+
+#endif // SPLASH_THUMBNAIL_CACHE_H
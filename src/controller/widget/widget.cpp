@@ -9,6 +9,7 @@
 #include <imgui.h>
 #include <imgui_internal.h>
 
+#include "./controller/widget/thumbnail_cache.h"
 #include "./graphics/camera.h"
 #include "./image/image.h"
 #include "./image/image_ffmpeg.h"
@@ -241,6 +242,14 @@ GuiWidget::GuiWidget(Scene* scene, const string& name)
     _name = name;
 }
 
+/*************/
+ImTextureID GuiWidget::getThumbnail(const string& name, GLuint texture, int width, int height, int displayWidth)
+{
+    if (_thumbnailCache)
+        texture = _thumbnailCache->get(name, texture, width, height, displayWidth);
+    return reinterpret_cast<ImTextureID>(static_cast<intptr_t>(texture));
+}
+
 /*************/
 void GuiWidget::drawAttributes(const string& objName, const unordered_map<string, Values>& attributes)
 {
@@ -47,6 +47,7 @@ namespace Splash
 {
 class Gui;
 class Scene;
+class ThumbnailCache;
 
 namespace SplashImGui
 {
@@ -87,8 +88,15 @@ class GuiWidget : public ControllerObject
      */
     virtual void setJoystick(const std::vector<float>& /*axes*/, const std::vector<uint8_t>& /*buttons*/) {}
 
+    /**
+     * Set the thumbnail cache used to draw the texture previews
+     * \param cache Thumbnail cache, owned by the GUI
+     */
+    void setThumbnailCache(ThumbnailCache* cache) { _thumbnailCache = cache; }
+
   protected:
     Scene* _scene;
+    ThumbnailCache* _thumbnailCache{nullptr};
     std::string _fileSelectorTarget{""};
     std::list<std::string> _hiddenAttributes{"savable"};
 
@@ -97,6 +105,17 @@ class GuiWidget : public ControllerObject
      * and sends the appriorate messages to the World
      */
     void drawAttributes(const std::string& objName, const std::unordered_map<std::string, Values>& attributes);
+
+    /**
+     * Get the texture to draw a small preview of the given texture with
+     * \param name Name of the object holding the texture
+     * \param texture Texture id
+     * \param width Texture width
+     * \param height Texture height
+     * \param displayWidth Width at which the preview is displayed
+     * \return Return a thumbnail if one is available, the texture itself otherwise
+     */
+    ImTextureID getThumbnail(const std::string& name, GLuint texture, int width, int height, int displayWidth);
 };
 
 } // end of namespace
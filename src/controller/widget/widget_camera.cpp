@@ -79,7 +79,7 @@ void GuiCamera::render()
         int w = ImGui::GetWindowWidth() - 3 * leftMargin;
         int h = w * size[1].as<int>() / size[0].as<int>();
 
-        if (ImGui::ImageButton((void*)(intptr_t)camera->getTexture()->getTexId(), ImVec2(w, h), ImVec2(0, 1), ImVec2(1, 0)))
+        if (ImGui::ImageButton(getThumbnail(camera->getName(), camera->getTexture()->getTexId(), size[0].as<int>(), size[1].as<int>(), w), ImVec2(w, h), ImVec2(0, 1), ImVec2(1, 0)))
         {
             // If shift is pressed, we hide / unhide this camera
             if (io.KeyCtrl)
@@ -599,13 +599,14 @@ void GuiCamera::processMouseEvents()
         // Calibration point set
         if (io.MouseClicked[2])
         {
-            float fragDepth = 0.f;
-            _newTarget = _camera->pickFragment(mousePos.x, mousePos.y, fragDepth);
-
-            if (fragDepth == 0.f)
-                _newTargetDistance = 1.f;
-            else
-                _newTargetDistance = -fragDepth * 0.1f;
+            // The target is picked asynchronously, so as not to stall the rendering while reading the depth back
+            _camera->pickFragmentAsync(mousePos.x, mousePos.y, [this](const Values& target, float fragDepth) {
+                _newTarget = target;
+                if (fragDepth == 0.f)
+                    _newTargetDistance = 1.f;
+                else
+                    _newTargetDistance = -fragDepth * 0.1f;
+            });
         }
 
         if (io.MouseWheel != 0)
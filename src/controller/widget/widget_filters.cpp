@@ -36,7 +36,7 @@ void GuiFilters::render()
         int w = ImGui::GetWindowWidth() - 3 * leftMargin;
         int h = w * spec.height / spec.width;
 
-        if (ImGui::ImageButton((void*)(intptr_t)filter->getTexId(), ImVec2(w, h), ImVec2(0, 0), ImVec2(1, 1)))
+        if (ImGui::ImageButton(getThumbnail(filter->getName(), filter->getTexId(), spec.width, spec.height, w), ImVec2(w, h), ImVec2(0, 0), ImVec2(1, 1)))
             _selectedFilterName = filter->getName();
         if (ImGui::IsItemHovered())
             ImGui::SetTooltip("%s", filter->getName().c_str());
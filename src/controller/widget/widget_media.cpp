@@ -48,7 +48,7 @@ void GuiMedia::render()
             int w = ImGui::GetWindowWidth() - 3 * leftMargin;
             int h = w * spec.height / spec.width;
 
-            if (ImGui::ImageButton((void*)(intptr_t)filter->getTexId(), ImVec2(w, h)))
+            if (ImGui::ImageButton(getThumbnail(filter->getName(), filter->getTexId(), spec.width, spec.height, w), ImVec2(w, h)))
                 _selectedMediaName = media->getName();
             if (ImGui::IsItemHovered())
                 ImGui::SetTooltip("%s", media->getName().c_str());
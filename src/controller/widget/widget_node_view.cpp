@@ -1,5 +1,7 @@
 #include "./controller/widget/widget_node_view.h"
 
+#include <unordered_set>
+
 #include "./core/factory.h"
 #include "./core/scene.h"
 
@@ -14,6 +16,67 @@ GuiNodeView::GuiNodeView(Scene* scene, const string& name)
 {
     auto factory = Factory();
     _objectTypes = factory.getObjectTypes();
+
+    if (!_root)
+        return;
+
+    // Only the changes to the objects, their links, aliases and savable flags affect the graph
+    _treeSubscription = _root->getTree()->subscribe("/", [this](const Tree::Root::ChangeSet& changes) {
+        auto endsWith = [](const string& str, const string& suffix) { return str.size() >= suffix.size() && str.compare(str.size() - suffix.size(), suffix.size(), suffix) == 0; };
+        for (const auto& [path, value] : changes)
+        {
+            if (path.find("/objects/") == string::npos)
+                continue;
+
+            if (value.getType() == Value::Type::empty || endsWith(path, "/links/children") || endsWith(path, "/attributes/alias") || endsWith(path, "/attributes/savable"))
+            {
+                _graphChanged = true;
+                return;
+            }
+        }
+    });
+}
+
+/*************/
+GuiNodeView::~GuiNodeView()
+{
+    if (_root && _treeSubscription)
+        _root->getTree()->unsubscribe(_treeSubscription);
+}
+
+/*************/
+void GuiNodeView::updateGraph()
+{
+    // Reset first, so that changes happening while reading the tree are not missed
+    _graphChanged = false;
+    _cachedNonSavableObjects = _viewNonSavableObjects;
+
+    _objectNames = getObjectList();
+    _objectAliases = getObjectAliases();
+
+    if (!_viewNonSavableObjects)
+    {
+        _objectNames.erase(std::remove_if(_objectNames.begin(),
+                               _objectNames.end(),
+                               [this](const auto& name) -> bool {
+                                   Values savable = getObjectAttribute(name, "savable");
+                                   if (savable.empty())
+                                       return true;
+                                   return !savable[0].as<bool>();
+                               }),
+            _objectNames.end());
+    }
+
+    auto displayedObjects = unordered_set<string>(_objectNames.begin(), _objectNames.end());
+    _links.clear();
+    for (const auto& [name, children] : getObjectLinks())
+    {
+        if (!displayedObjects.count(name))
+            continue;
+        for (const auto& child : children)
+            if (displayedObjects.count(child))
+                _links.emplace_back(name, child);
+    }
 }
 
 /*************/
@@ -101,22 +164,9 @@ void GuiNodeView::initializeNodePositions(const vector<string>& objectNames)
 /*************/
 void GuiNodeView::render()
 {
-    auto objectLinks = getObjectLinks();
-    auto objectNames = getObjectList();
-    auto objectAliases = getObjectAliases();
-
-    if (!_viewNonSavableObjects)
-    {
-        objectNames.erase(std::remove_if(objectNames.begin(),
-                              objectNames.end(),
-                              [this](const auto& name) -> bool {
-                                  Values savable = getObjectAttribute(name, "savable");
-                                  if (savable.empty())
-                                      return true;
-                                  return !savable[0].as<bool>();
-                              }),
-            objectNames.end());
-    }
+    if (_graphChanged || _cachedNonSavableObjects != _viewNonSavableObjects)
+        updateGraph();
+    const auto& objectNames = _objectNames;
 
     // Combo box for adding objects
     {
@@ -158,43 +208,44 @@ void GuiNodeView::render()
     canvasPos.x += _viewShift[0];
     canvasPos.y += _viewShift[1];
 
-    // Draw objects according to their link level
+    // Only the nodes and links intersecting the view are drawn
+    auto viewSize = ImGui::GetWindowSize();
     for (const auto& objectName : objectNames)
+    {
+        auto nodePos = _nodePositions.find(objectName);
+        if (nodePos == _nodePositions.end())
+            continue;
+
+        auto x = nodePos->second[0] + _viewShift[0];
+        auto y = nodePos->second[1] + _viewShift[1];
+        if (x + _nodeSize[0] < 0.f || y + _nodeSize[1] < 0.f || x > viewSize.x || y > viewSize.y)
+            continue;
+
         renderNode(objectName);
+    }
 
     // Draw lines
     auto& style = ImGui::GetStyle();
     auto drawList = ImGui::GetWindowDrawList();
-    for (const auto& object : objectLinks)
+    const auto clipMin = drawList->GetClipRectMin();
+    const auto clipMax = drawList->GetClipRectMax();
+    for (const auto& [name, target] : _links)
     {
-        auto& name = object.first;
-        auto& links = object.second;
-
-        // Check that the source is displayed
-        if (std::find(objectNames.begin(), objectNames.end(), name) == objectNames.end())
-            continue;
-
-        if (links.empty())
+        auto sourceIt = _nodePositions.find(name);
+        auto targetIt = _nodePositions.find(target);
+        if (sourceIt == _nodePositions.end() || targetIt == _nodePositions.end())
             continue;
 
-        auto& currentNodePos = _nodePositions[name];
-        auto firstPoint = ImVec2(currentNodePos[0] + canvasPos.x - style.WindowPadding[0], currentNodePos[1] + canvasPos.y - style.WindowPadding[1] + _nodeSize[1] / 2.0);
+        const auto& sourcePos = sourceIt->second;
+        const auto& targetPos = targetIt->second;
+        auto firstPoint = ImVec2(sourcePos[0] + canvasPos.x - style.WindowPadding[0], sourcePos[1] + canvasPos.y - style.WindowPadding[1] + _nodeSize[1] / 2.0);
+        auto secondPoint = ImVec2(targetPos[0] + canvasPos.x + _nodeSize[0] - style.WindowPadding[0], targetPos[1] + canvasPos.y - style.WindowPadding[1] + _nodeSize[1] / 2.0);
 
-        for (const auto& target : links)
-        {
-            // Check that the source is displayed
-            if (std::find(objectNames.begin(), objectNames.end(), target) == objectNames.end())
-                continue;
-
-            auto targetIt = _nodePositions.find(target);
-            if (targetIt == _nodePositions.end())
-                continue;
-
-            auto& targetPos = targetIt->second;
-            auto secondPoint = ImVec2(targetPos[0] + canvasPos.x + _nodeSize[0] - style.WindowPadding[0], targetPos[1] + canvasPos.y - style.WindowPadding[1] + _nodeSize[1] / 2.0);
+        if (std::max(firstPoint.x, secondPoint.x) < clipMin.x || std::min(firstPoint.x, secondPoint.x) > clipMax.x || std::max(firstPoint.y, secondPoint.y) < clipMin.y ||
+            std::min(firstPoint.y, secondPoint.y) > clipMax.y)
+            continue;
 
-            drawList->AddLine(firstPoint, secondPoint, 0xBB0088FF, 2.f);
-        }
+        drawList->AddLine(firstPoint, secondPoint, 0xBB0088FF, 2.f);
     }
 
     // end of the subwindow
@@ -230,7 +281,7 @@ void GuiNodeView::render()
 
     // Select an object by its name
     vector<const char*> items;
-    std::transform(objectNames.begin(), objectNames.end(), std::back_inserter(items), [&](auto& name) -> const char* { return objectAliases[name].c_str(); });
+    std::transform(objectNames.begin(), objectNames.end(), std::back_inserter(items), [&](auto& name) -> const char* { return _objectAliases[name].c_str(); });
 
     ImGui::Text("Object list:");
     ImGui::SameLine();
@@ -279,7 +330,8 @@ void GuiNodeView::renderNode(const string& name)
     }
 
     ImGui::BeginChild(string("node_" + name).c_str(), ImVec2(_nodeSize[0], _nodeSize[1]), false);
-    if (ImGui::Button(getObjectAlias(name).c_str(), ImVec2(_nodeSize[0], _nodeSize[1])))
+    auto aliasIt = _objectAliases.find(name);
+    if (ImGui::Button(aliasIt != _objectAliases.end() ? aliasIt->second.c_str() : name.c_str(), ImVec2(_nodeSize[0], _nodeSize[1])))
     {
         _clickedNode = name;
         _sourceNode = name;
@@ -28,7 +28,10 @@
 #include "./widget.h"
 
 #include <array>
+#include <atomic>
 #include <string>
+#include <unordered_map>
+#include <utility>
 #include <vector>
 
 #include <imgui.h>
@@ -41,6 +44,7 @@ class GuiNodeView : public GuiWidget
 {
   public:
     GuiNodeView(Scene* scene, const std::string& name);
+    ~GuiNodeView() final;
     void render() final;
     std::string getClickedNode() { return _clickedNode; }
     int updateWindowFlags() final;
@@ -57,11 +61,24 @@ class GuiNodeView : public GuiWidget
     std::vector<int> _viewShift{0, 0};
     std::map<std::string, std::vector<float>> _nodePositions;
 
+    // Graph structure, cached until an object, a link, an alias or a savable flag changes
+    std::atomic_bool _graphChanged{true};                          //!< Set from the tree notifications
+    Tree::Root::SubscriptionID _treeSubscription{0};               //!< Subscription to the tree changes
+    bool _cachedNonSavableObjects{false};                          //!< Value of _viewNonSavableObjects when the graph was cached
+    std::vector<std::string> _objectNames{};                       //!< Displayed objects
+    std::unordered_map<std::string, std::string> _objectAliases{}; //!< Aliases of all objects
+    std::vector<std::pair<std::string, std::string>> _links{};     //!< Links between displayed objects, from parent to child
+
     // Temporary variables used for ImGui
     bool _firstRender{true};
     int _comboObjectIndex{0};
     ImVec2 _graphSize{0, 0};
 
+    /**
+     * Read the graph structure from the tree
+     */
+    void updateGraph();
+
     /**
      * Render the given node
      * \param name Node name
@@ -46,7 +46,7 @@ void GuiTexturesView::render()
         w = ImGui::GetWindowWidth() - 4 * leftMargin;
         h = sizeX != 0 ? w * sizeY / sizeX : 1;
         if (camera)
-            ImGui::Image((void*)(intptr_t)camera->getTexture()->getTexId(), ImVec2(w, h), ImVec2(0, 1), ImVec2(1, 0));
+            ImGui::Image(getThumbnail(camera->getName(), camera->getTexture()->getTexId(), sizeX, sizeY, w), ImVec2(w, h), ImVec2(0, 1), ImVec2(1, 0));
 
         if (ImGui::IsItemHovered())
             ImGui::SetTooltip("%s", camera->getName().c_str());
@@ -78,7 +78,7 @@ void GuiTexturesView::render()
 
         w = ImGui::GetWindowWidth() - 4 * leftMargin;
         h = sizeX != 0 ? w * sizeY / sizeX : 1;
-        ImGui::Image((void*)(intptr_t)object->getTexId(), ImVec2(w, h), ImVec2(0, 1), ImVec2(1, 0));
+        ImGui::Image(getThumbnail(object->getName(), object->getTexId(), sizeX, sizeY, w), ImVec2(w, h), ImVec2(0, 1), ImVec2(1, 0));
 
         if (ImGui::IsItemHovered())
             ImGui::SetTooltip("%s", object->getName().c_str());
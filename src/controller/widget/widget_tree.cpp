@@ -10,32 +10,104 @@ namespace Splash
 {
 
 /*************/
-void GuiTree::render()
+GuiTree::GuiTree(Scene* scene, const string& name)
+    : GuiWidget(scene, name)
 {
-    auto tree = _root->getTree();
+    if (!_root)
+        return;
 
-    std::function<void(const string&, const string&)> printBranch;
-    printBranch = [&](const string& path, const string& nodeName) {
-        if (ImGui::TreeNode(nodeName.c_str()))
+    // Only leaves appearing or disappearing change the rows, new leaves being reported once with their first value
+    _treeSubscription = _root->getTree()->subscribe("/", [this](const Tree::Root::ChangeSet& changes) {
+        for (const auto& [path, value] : changes)
         {
-            for (const auto& branch : tree->getBranchListAt(path))
+            if (value.getType() == Value::Type::empty)
+            {
+                _knownLeaves.erase(path);
+                _structureChanged = true;
+            }
+            else if (_knownLeaves.insert(path).second)
             {
-                auto childPath = Utils::cleanPath(path + "/" + branch);
-                printBranch(childPath, branch);
+                _structureChanged = true;
             }
+        }
+    });
+}
+
+/*************/
+GuiTree::~GuiTree()
+{
+    if (_root && _treeSubscription)
+        _root->getTree()->unsubscribe(_treeSubscription);
+}
+
+/*************/
+void GuiTree::updateRows(const Tree::Snapshot& tree)
+{
+    // Reset first, so that changes happening while reading the tree are not missed
+    _structureChanged = false;
+    _openBranchesChanged = false;
+    _rows.clear();
+
+    std::function<void(const string&, const string&, int)> addBranch;
+    addBranch = [&](const string& path, const string& name, int depth) {
+        _rows.push_back({name, path, depth, true});
+        if (!_openBranches.count(path))
+            return;
+
+        for (const auto& branch : tree.getBranchListAt(path))
+            addBranch(Utils::cleanPath(path + "/" + branch), branch, depth + 1);
+        for (const auto& leaf : tree.getLeafListAt(path))
+            _rows.push_back({leaf, Utils::cleanPath(path + "/" + leaf), depth + 1, false});
+    };
+
+    addBranch("/", "/", 0);
+}
+
+/*************/
+void GuiTree::render()
+{
+    // Rendering from a snapshot does not block the loop thread, however large the tree is
+    auto tree = _root->getTreeSnapshot();
 
-            for (const auto& leaf : tree->getLeafListAt(path))
+    if (_structureChanged || _openBranchesChanged)
+        updateRows(*tree);
+
+    const auto indentSpacing = ImGui::GetStyle().IndentSpacing;
+    ImGuiListClipper clipper;
+    clipper.Begin(static_cast<int>(_rows.size()));
+    while (clipper.Step())
+    {
+        for (int i = clipper.DisplayStart; i < clipper.DisplayEnd; ++i)
+        {
+            const auto& row = _rows[i];
+            ImGui::PushID(row.path.c_str());
+            ImGui::SetCursorPosX(ImGui::GetCursorPosX() + row.depth * indentSpacing);
+
+            if (row.isBranch)
+            {
+                // The open state is held by ImGui, the rows are updated when it differs from the one they were built with
+                const bool wasOpen = _openBranches.count(row.path) != 0;
+                const bool isOpen = ImGui::TreeNodeEx(row.name.c_str(), ImGuiTreeNodeFlags_NoTreePushOnOpen);
+                if (isOpen != wasOpen)
+                {
+                    if (isOpen)
+                        _openBranches.insert(row.path);
+                    else
+                        _openBranches.erase(row.path);
+                    _openBranchesChanged = true;
+                }
+            }
+            else
             {
                 Value leafValue;
-                tree->getValueForLeafAt(Utils::cleanPath(path + "/" + leaf), leafValue);
-                ImGui::Text("%s : %s", leaf.c_str(), leafValue.as<string>().c_str());
+                tree->getValueForLeafAt(row.path, leafValue);
+                ImGui::Text("%s : %s", row.name.c_str(), leafValue.as<string>().c_str());
             }
 
-            ImGui::TreePop();
+            ImGui::PopID();
         }
-    };
-
-    printBranch("/", "/");
+    }
+    clipper.End();
 }
 
 } // namespace Splash
@@ -27,18 +27,47 @@
 
 #include "./widget.h"
 
+#include <atomic>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
 namespace Splash
 {
 
+/*************/
+//! Inspector of the tree, only drawing the rows of the expanded branches which are visible
+//! The expanded branches are flattened into a list of rows, updated when branches are expanded or collapsed,
+//! or when the tree notifications report leaves being added or removed. Values are only read for the visible rows.
 class GuiTree : public GuiWidget
 {
   public:
-    GuiTree(Scene* scene, const std::string& name)
-        : GuiWidget(scene, name)
+    GuiTree(Scene* scene, const std::string& name);
+    ~GuiTree() final;
+    void render() final;
+
+  private:
+    struct Row
     {
-    }
+        std::string name{};
+        std::string path{};
+        int depth{0};
+        bool isBranch{false};
+    };
 
-    void render() final;
+    std::vector<Row> _rows{};                        //!< Flattened rows of the expanded branches
+    std::unordered_set<std::string> _openBranches{}; //!< Paths of the expanded branches
+    bool _openBranchesChanged{true};                 //!< Set when a branch is expanded or collapsed
+
+    std::atomic_bool _structureChanged{true};        //!< Set from the tree notifications
+    std::unordered_set<std::string> _knownLeaves{};  //!< Leaves reported by the tree notifications, only accessed from them
+    Tree::Root::SubscriptionID _treeSubscription{0}; //!< Subscription to the tree changes
+
+    /**
+     * Flatten the expanded branches of the tree into rows
+     * \param tree Tree snapshot
+     */
+    void updateRows(const Tree::Snapshot& tree);
 };
 
 } // namespace Splash
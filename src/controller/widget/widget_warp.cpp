@@ -45,7 +45,7 @@ void GuiWarp::render()
         else
             setObjectAttribute(warp->getName(), "showControlLattice", {false});
 
-        warp->render();
+        warp->renderOutput();
 
         auto warpSpec = warp->getSpec();
         if (warpSpec.width == 0 || warpSpec.height == 0)
@@ -54,7 +54,7 @@ void GuiWarp::render()
         int w = ImGui::GetWindowWidth() - 4 * leftMargin;
         int h = w * warpSpec.height / warpSpec.width;
 
-        if (ImGui::ImageButton((void*)(intptr_t)warp->getTexture()->getTexId(), ImVec2(w, h), ImVec2(0, 1), ImVec2(1, 0)))
+        if (ImGui::ImageButton(getThumbnail(warp->getName(), warp->getTexId(), warpSpec.width, warpSpec.height, w), ImVec2(w, h), ImVec2(0, 1), ImVec2(1, 0)))
             _currentWarp = i;
 
         if (ImGui::IsItemHovered())
@@ -9,6 +9,7 @@ namespace Splash
 {
 
 atomic_uint CallbackHandle::_nextCallbackId{1};
+atomic_uint64_t Attribute::_versionCounter{0};
 
 /*************/
 CallbackHandle::~CallbackHandle()
@@ -21,6 +22,7 @@ CallbackHandle::~CallbackHandle()
 /*************/
 Attribute::Attribute(const string& name, const function<bool(const Values&)>& setFunc, const function<Values()>& getFunc, const vector<char>& types)
     : _name(name)
+    , _id(getId(name))
     , _setFunc(setFunc)
     , _getFunc(getFunc)
     , _defaultSetAndGet(false)
@@ -34,6 +36,7 @@ Attribute& Attribute::operator=(Attribute&& a)
     if (this != &a)
     {
         _name = move(a._name);
+        _id = a._id;
         _objectName = move(a._objectName);
         _setFunc = move(a._setFunc);
         _getFunc = move(a._getFunc);
@@ -44,6 +47,7 @@ Attribute& Attribute::operator=(Attribute&& a)
         _valuesTypes = move(a._valuesTypes);
         _syncMethod = a._syncMethod;
         _callbacks = move(a._callbacks);
+        _version = ++_versionCounter;
     }
 
     return *this;
@@ -71,6 +75,7 @@ bool Attribute::operator()(const Values& args)
         for (const auto& a : args)
             _valuesTypes.push_back(a.getTypeAsChar());
 
+        _version = ++_versionCounter;
         return true;
     }
     else if (!_setFunc)
@@ -99,7 +104,11 @@ bool Attribute::operator()(const Values& args)
         return false;
     }
 
-    return _setFunc(args);
+    if (!_setFunc(args))
+        return false;
+
+    _version = ++_versionCounter;
+    return true;
 }
 
 /*************/
@@ -118,6 +127,38 @@ Values Attribute::operator()() const
     return _getFunc();
 }
 
+/*************/
+Attribute::IdRegistry& Attribute::getIdRegistry()
+{
+    static IdRegistry registry;
+    return registry;
+}
+
+/*************/
+AttributeId Attribute::getId(const string& name)
+{
+    auto& registry = getIdRegistry();
+    lock_guard<mutex> lock(registry.mutex);
+    auto idIt = registry.ids.find(name);
+    if (idIt != registry.ids.end())
+        return idIt->second;
+
+    auto id = static_cast<AttributeId>(registry.names.size());
+    registry.ids.emplace(name, id);
+    registry.names.push_back(name);
+    return id;
+}
+
+/*************/
+string Attribute::getName(AttributeId id)
+{
+    auto& registry = getIdRegistry();
+    lock_guard<mutex> lock(registry.mutex);
+    if (id >= registry.names.size())
+        return {};
+    return registry.names[id];
+}
+
 /*************/
 Values Attribute::getArgsTypes() const
 {
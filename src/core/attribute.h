@@ -31,8 +31,10 @@
 #include <json/json.h>
 #include <list>
 #include <map>
+#include <mutex>
 #include <string>
 #include <unordered_map>
+#include <vector>
 
 #include "./core/constants.h"
 
@@ -43,6 +45,9 @@ namespace Splash
 
 class BaseObject;
 
+//! Attribute identifier, shared by all attributes of the same name whatever the object holding them
+using AttributeId = uint32_t;
+
 /*************/
 // Handle to a callback for an attribute modification
 // Destroying this automatically destroys the callback
@@ -99,7 +104,8 @@ class Attribute
      */
     Attribute() = default;
     explicit Attribute(const std::string& name)
-        : _name(name){};
+        : _name(name)
+        , _id(getId(name)){};
 
     /**
      * Constructor.
@@ -130,6 +136,27 @@ class Attribute
      */
     Values operator()() const;
 
+    /**
+     * Get the identifier for the given attribute name, registering it if needed.
+     * Identifiers are stable for the lifetime of the process, so they are best resolved once and stored.
+     * \param name Attribute name
+     * \return Return the identifier
+     */
+    static AttributeId getId(const std::string& name);
+
+    /**
+     * Get the attribute name associated to the given identifier
+     * \param id Attribute identifier
+     * \return Return the name, or an empty string if the identifier is unknown
+     */
+    static std::string getName(AttributeId id);
+
+    /**
+     * Get the identifier of this attribute
+     * \return Return the identifier
+     */
+    AttributeId getId() const { return _id; }
+
     /**
      * Tells whether the setter and getters are the default ones or not.
      * \return Returns true if the setter and getter are the default ones.
@@ -148,6 +175,14 @@ class Attribute
      */
     bool hasGetter() const { return _getFunc != nullptr; }
 
+    /**
+     * Get the attribute version, which changes each time the setter succeeds.
+     * Versions are unique across all attributes, so that a recreated attribute never matches an older version.
+     * If a getter is defined, the value can change without the version changing.
+     * \return Return the version
+     */
+    uint64_t getVersion() const { return _version; }
+
     /**
      * Ask whether the attribute is locked.
      * \return Returns true if the attribute is locked.
@@ -216,6 +251,7 @@ class Attribute
   private:
     mutable std::mutex _defaultFuncMutex{};
     std::string _name{}; // Name of the attribute
+    AttributeId _id{0}; // Identifier of the attribute, 0 being the identifier of the empty name
 
     std::function<bool(const Values&)> _setFunc{};
     std::function<const Values()> _getFunc{};
@@ -232,6 +268,22 @@ class Attribute
     std::map<uint32_t, Callback> _callbacks{};
 
     bool _isLocked{false};
+
+    struct IdRegistry
+    {
+        std::mutex mutex{};
+        std::unordered_map<std::string, AttributeId> ids{{"", 0}};
+        std::vector<std::string> names{""};
+    };
+
+    /**
+     * Get the attribute identifiers registry, created on first use so that it is available during static initialization
+     * \return Return the registry
+     */
+    static IdRegistry& getIdRegistry();
+
+    static std::atomic_uint64_t _versionCounter;
+    std::atomic_uint64_t _version{++_versionCounter}; //!< Attribute version, updated after each successful set
 };
 
 } // namespace Splash
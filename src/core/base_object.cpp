@@ -1,14 +1,31 @@
 #include "./core/base_object.h"
 
 #include <algorithm>
+#include <limits>
 
 #include "./utils/log.h"
+#include "./utils/thread_pool.h"
 
 using namespace std;
 
 namespace Splash
 {
 
+/*************/
+BaseObject::~BaseObject()
+{
+    // Futures from the thread pool do not block on destruction, contrary to the ones from std::async
+    map<uint32_t, future<void>> asyncTasks;
+    {
+        lock_guard<mutex> lockTasks(_asyncTaskMutex);
+        std::swap(asyncTasks, _asyncTasks);
+    }
+
+    for (auto& task : asyncTasks)
+        if (task.second.valid())
+            task.second.wait();
+}
+
 /*************/
 void BaseObject::addTask(const function<void()>& task)
 {
@@ -16,6 +33,22 @@ void BaseObject::addTask(const function<void()>& task)
     _taskQueue.push_back(task);
 }
 
+/*************/
+void BaseObject::addTask(const string& key, const function<void()>& task)
+{
+    lock_guard<recursive_mutex> lock(_taskMutex);
+
+    // The replaced task is dropped and the new one queued last, so that it still runs after the tasks added before it
+    if (auto taskIt = _keyedTasks.find(key); taskIt != _keyedTasks.end())
+    {
+        _taskQueue.erase(taskIt->second);
+        taskIt->second = _taskQueue.insert(_taskQueue.end(), task);
+        return;
+    }
+
+    _keyedTasks.emplace(key, _taskQueue.insert(_taskQueue.end(), task));
+}
+
 /*************/
 void BaseObject::addPeriodicTask(const string& name, const function<void()>& task, uint32_t period)
 {
@@ -36,7 +69,7 @@ void BaseObject::addPeriodicTask(const string& name, const function<void()>& tas
         periodicTask->second = {task, period};
     }
 
-    return;
+    schedulePeriodicTasks();
 }
 
 /*************/
@@ -51,15 +84,37 @@ bool BaseObject::setAttribute(const string& attrib, const Values& args)
         auto result = _attribFunctions.emplace(attrib, Attribute(attrib));
         assert(result.second);
         attribFunction = result.first;
+        _attribIndicesDirty = true;
     }
 
-    if (!attribFunction->second.isDefault())
+    bool isDefault = attribFunction->second.isDefault();
+    if (!isDefault)
         _updatedParams = true;
     bool attribResult = attribFunction->second(args);
+    if (!isDefault)
+        ++_attributesVersion;
 
     return attribResult && attribNotPresent;
 }
 
+/*************/
+bool BaseObject::setAttribute(AttributeId attrib, const Values& args)
+{
+    unique_lock<recursive_mutex> lock(_attribMutex);
+    auto attribute = findAttribute(attrib);
+    if (!attribute)
+        return setAttribute(Attribute::getName(attrib), args);
+
+    bool isDefault = attribute->isDefault();
+    if (!isDefault)
+        _updatedParams = true;
+    bool attribResult = (*attribute)(args);
+    if (!isDefault)
+        ++_attributesVersion;
+
+    return attribResult;
+}
+
 /*************/
 bool BaseObject::getAttribute(const string& attrib, Values& args) const
 {
@@ -76,6 +131,22 @@ bool BaseObject::getAttribute(const string& attrib, Values& args) const
     return true;
 }
 
+/*************/
+bool BaseObject::getAttribute(AttributeId attrib, Values& args) const
+{
+    unique_lock<recursive_mutex> lock(_attribMutex);
+    auto attribute = findAttribute(attrib);
+    if (!attribute)
+    {
+        args.clear();
+        return false;
+    }
+
+    args = (*attribute)();
+
+    return true;
+}
+
 /*************/
 optional<Values> BaseObject::getAttribute(const string& attrib) const
 {
@@ -85,6 +156,16 @@ optional<Values> BaseObject::getAttribute(const string& attrib) const
     return value;
 }
 
+/*************/
+optional<uint64_t> BaseObject::getAttributeVersion(const string& attrib) const
+{
+    unique_lock<recursive_mutex> lock(_attribMutex);
+    auto attribFunction = _attribFunctions.find(attrib);
+    if (attribFunction == _attribFunctions.end() || attribFunction->second.hasGetter())
+        return {};
+    return attribFunction->second.getVersion();
+}
+
 /*************/
 vector<std::string> BaseObject::getAttributesList() const
 {
@@ -132,7 +213,7 @@ void BaseObject::runAsyncTask(const function<void(void)>& func)
 {
     lock_guard<mutex> lockTasks(_asyncTaskMutex);
     auto taskId = _nextAsyncTaskId++;
-    _asyncTasks[taskId] = async(launch::async, [this, func, taskId]() -> void {
+    _asyncTasks[taskId] = ThreadPool::get().enqueue([this, func, taskId]() -> void {
         func();
         addTask([this, taskId]() -> void {
             lock_guard<mutex> lockTasks(_asyncTaskMutex);
@@ -146,6 +227,7 @@ Attribute& BaseObject::addAttribute(const string& name, const function<bool(cons
 {
     unique_lock<recursive_mutex> lock(_attribMutex);
     _attribFunctions[name] = Attribute(name, set, nullptr, types);
+    _attribIndicesDirty = true;
     _attribFunctions[name].setObjectName(_name);
     return _attribFunctions[name];
 }
@@ -155,6 +237,7 @@ Attribute& BaseObject::addAttribute(const string& name, const function<bool(cons
 {
     unique_lock<recursive_mutex> lock(_attribMutex);
     _attribFunctions[name] = Attribute(name, set, get, types);
+    _attribIndicesDirty = true;
     _attribFunctions[name].setObjectName(_name);
     return _attribFunctions[name];
 }
@@ -194,7 +277,38 @@ void BaseObject::removeAttribute(const string& name)
     unique_lock<recursive_mutex> lock(_attribMutex);
     auto attr = _attribFunctions.find(name);
     if (attr != _attribFunctions.end())
+    {
         _attribFunctions.erase(attr);
+        _attribIndicesDirty = true;
+    }
+}
+
+/*************/
+Attribute* BaseObject::findAttribute(AttributeId id)
+{
+    return const_cast<Attribute*>(static_cast<const BaseObject*>(this)->findAttribute(id));
+}
+
+/*************/
+const Attribute* BaseObject::findAttribute(AttributeId id) const
+{
+    if (_attribIndicesDirty)
+    {
+        _attribIndices.clear();
+        int32_t index = 0;
+        for (const auto& attribute : _attribFunctions)
+        {
+            auto attributeId = attribute.second.getId();
+            if (attributeId >= _attribIndices.size())
+                _attribIndices.resize(attributeId + 1, -1);
+            _attribIndices[attributeId] = index++;
+        }
+        _attribIndicesDirty = false;
+    }
+
+    if (id >= _attribIndices.size() || _attribIndices[id] < 0)
+        return nullptr;
+    return &(*DenseMap<string, Attribute>::const_iterator(_attribIndices[id], _attribFunctions)).second;
 }
 
 /*************/
@@ -210,6 +324,23 @@ void BaseObject::removePeriodicTask(const string& name)
     auto periodicTask = _periodicTasks.find(name);
     if (periodicTask != _periodicTasks.end())
         _periodicTasks.erase(periodicTask);
+    schedulePeriodicTasks();
+}
+
+/*************/
+void BaseObject::schedulePeriodicTasks()
+{
+    _hasPeriodicTasks = !_periodicTasks.empty();
+    _nextPeriodicTaskCall = numeric_limits<int64_t>::max();
+    for (const auto& task : _periodicTasks)
+    {
+        if (task.second.period == 0)
+        {
+            _nextPeriodicTaskCall = 0;
+            return;
+        }
+        _nextPeriodicTaskCall = std::min(_nextPeriodicTaskCall, task.second.lastCall + task.second.period + 1);
+    }
 }
 
 /*************/
@@ -244,13 +375,24 @@ void BaseObject::runTasks()
     decltype(_taskQueue) tasks;
     std::swap(tasks, _taskQueue);
     _taskQueue.clear();
+    _keyedTasks.clear();
     lock.unlock();
 
     for (const auto& task : tasks)
         task();
+    // Tasks are mostly deferred attribute changes
+    if (!tasks.empty())
+        ++_attributesVersion;
+
+    // Most objects have no periodic task, and the others are only visited once one of their tasks is due
+    if (!_hasPeriodicTasks.load(std::memory_order_acquire))
+        return;
 
     unique_lock<mutex> lockRecurrsiveTasks(_periodicTaskMutex);
     auto currentTime = Timer::getTime() / 1000;
+    if (currentTime < _nextPeriodicTaskCall)
+        return;
+
     for (auto& task : _periodicTasks)
     {
         if (task.second.period == 0 || currentTime - task.second.lastCall > task.second.period)
@@ -259,5 +401,6 @@ void BaseObject::runTasks()
             task.second.lastCall = currentTime;
         }
     }
+    schedulePeriodicTasks();
 }
 } // namespace Splash
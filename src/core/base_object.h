@@ -53,9 +53,9 @@ class BaseObject : public std::enable_shared_from_this<BaseObject>
     BaseObject() { registerAttributes(); }
 
     /**
-     * Destructor.
+     * Destructor, waits for the asynchronous tasks to finish
      */
-    virtual ~BaseObject() {}
+    virtual ~BaseObject();
 
     /**
      * Set the name of the object.
@@ -84,6 +84,15 @@ class BaseObject : public std::enable_shared_from_this<BaseObject>
      */
     bool setAttribute(const std::string& attrib, const Values& args = {});
 
+    /**
+     * Set the specified attribute from its identifier, which avoids looking it up by name
+     * If the attribute does not exist, falls back to setting it by name
+     * \param attrib Attribute identifier, as given by Attribute::getId
+     * \param args Values object which holds attribute values
+     * \return Returns true if the parameter exists and was set
+     */
+    bool setAttribute(AttributeId attrib, const Values& args = {});
+
     /**
      * Get the specified attribute
      * \param attrib Attribute name
@@ -93,12 +102,33 @@ class BaseObject : public std::enable_shared_from_this<BaseObject>
     bool getAttribute(const std::string& attrib, Values& args) const;
     std::optional<Values> getAttribute(const std::string& attrib) const;
 
+    /**
+     * Get the specified attribute from its identifier, which avoids looking it up by name
+     * \param attrib Attribute identifier, as given by Attribute::getId
+     * \param args Values object which will hold the attribute values
+     * \return Return true if the parameter exists
+     */
+    bool getAttribute(AttributeId attrib, Values& args) const;
+
     /**
      * Get a list of the object attributes
      * \return Returns a vector holding all the attributes
      */
     std::vector<std::string> getAttributesList() const;
 
+    /**
+     * Get the number of times a non default attribute has been set, to detect changes
+     * \return Return the attributes version
+     */
+    uint64_t getAttributesVersion() const { return _attributesVersion; }
+
+    /**
+     * Get the version of the given attribute, to detect changes of its value
+     * \param attrib Attribute name
+     * \return Return the version, or nothing if the attribute does not exist or has a getter, as its value can then change without being set
+     */
+    std::optional<uint64_t> getAttributeVersion(const std::string& attrib) const;
+
     /**
      * Get the description for the given attribute, if it exists
      * \param name Name of the attribute
@@ -143,13 +173,17 @@ class BaseObject : public std::enable_shared_from_this<BaseObject>
     std::string _name{""};                             //!< Object name
     DenseMap<std::string, Attribute> _attribFunctions; //!< Map of all attributes
     mutable std::recursive_mutex _attribMutex;
-    bool _updatedParams{true}; //!< True if the parameters have been updated and the object needs to reflect these changes
+    mutable std::vector<int32_t> _attribIndices{}; //!< Index in _attribFunctions for each attribute identifier, -1 if the object does not have it
+    mutable bool _attribIndicesDirty{true};       //!< Set when attributes are added or removed, _attribIndices is then rebuilt on next use
+    bool _updatedParams{true};                  //!< True if the parameters have been updated and the object needs to reflect these changes
+    std::atomic_uint64_t _attributesVersion{0}; //!< Incremented after each non default attribute has been set, or queued tasks have run
 
     uint32_t _nextAsyncTaskId{0};
     std::map<uint32_t, std::future<void>> _asyncTasks{};
     std::mutex _asyncTaskMutex{};
 
     std::list<std::function<void()>> _taskQueue;
+    std::unordered_map<std::string, std::list<std::function<void()>>::iterator> _keyedTasks{}; //!< Keyed tasks waiting in the queue, by key
     std::recursive_mutex _taskMutex;
 
     struct PeriodicTask
@@ -165,6 +199,16 @@ class BaseObject : public std::enable_shared_from_this<BaseObject>
     };
     std::map<std::string, PeriodicTask> _periodicTasks{};
     std::mutex _periodicTaskMutex{};
+    std::atomic_bool _hasPeriodicTasks{false}; //!< Lets runTasks skip the periodic tasks without locking them when there are none
+    int64_t _nextPeriodicTaskCall{0};          //!< Time in ms at which the next periodic task is due, 0 if one is due at every frame
+
+    /**
+     * Find the attribute with the given identifier. The attribute mutex must be locked.
+     * \param id Attribute identifier
+     * \return Return a pointer to the attribute, or nullptr if the object does not have it
+     */
+    Attribute* findAttribute(AttributeId id);
+    const Attribute* findAttribute(AttributeId id) const;
 
     /**
      * Add a new task to the queue
@@ -172,6 +216,14 @@ class BaseObject : public std::enable_shared_from_this<BaseObject>
      */
     void addTask(const std::function<void()>& task);
 
+    /**
+     * Add a new task to the queue, replacing the task still waiting in the queue for the same key
+     * Used by the setters which can be called at a high rate, so that only their latest value is applied
+     * \param key Task key, typically the attribute name
+     * \param task Task function
+     */
+    void addTask(const std::string& key, const std::function<void()>& task);
+
     /**
      * Add a task repeated at each frame
      * Note that the period is not a hard constraint, and depends on the framerate
@@ -232,6 +284,11 @@ class BaseObject : public std::enable_shared_from_this<BaseObject>
      */
     void removePeriodicTask(const std::string& name);
 
+    /**
+     * Update the time at which the next periodic task is due. The periodic task mutex must be locked.
+     */
+    void schedulePeriodicTasks();
+
     /**
      * Register new attributes
      */
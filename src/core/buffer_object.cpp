@@ -53,13 +53,28 @@ void BufferObject::updateTimestamp(int64_t timestamp)
         _timestamp = Timer::getTime();
     _updatedBuffer = true;
     if (_root)
-        _root->signalBufferObjectUpdated();
+        _root->signalBufferObjectUpdated(_name);
 }
 
 /*************/
 void BufferObject::registerAttributes()
 {
     GraphObject::registerAttributes();
+
+    addAttribute(
+        "placement",
+        [&](const Values& args) {
+            auto placement = args[0].as<string>();
+            if (placement != "world" && placement != "scene")
+                return false;
+            _placement = placement;
+            return true;
+        },
+        [&]() -> Values { return {_placement}; },
+        {'s'});
+    setAttributeDescription("placement",
+        "Where the object runs, only taken into account when it is created: \"world\" to run it in the World which sends its data to the Scenes, \"scene\" to run it "
+        "directly in the Scenes using it");
 }
 
 } // namespace Splash
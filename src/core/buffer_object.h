@@ -140,6 +140,13 @@ class BufferObject : public GraphObject
      */
     bool hasSerializedObjectWaiting() const { return _newSerializedObject; };
 
+    /**
+     * \brief Get where the object runs: "world" if it runs in the World and sends its buffers to the Scenes,
+     * "scene" if it runs directly in the Scenes using it
+     * \return Return the placement
+     */
+    std::string getPlacement() const { return _placement; }
+
   protected:
     mutable Spinlock _readMutex;                //!< Read mutex locked when the object is read from
     mutable std::shared_mutex _writeMutex;      //!< Write mutex locked when the object is written to
@@ -151,6 +158,7 @@ class BufferObject : public GraphObject
 
     std::shared_ptr<SerializedObject> _serializedObject{nullptr}; //!< Internal buffer object
     bool _newSerializedObject{false};                             //!< Set to true during serialized object processing
+    std::string _placement{"world"};                              //!< Process the object runs in, only taken into account when it is created
 
     /**
      * Updates the timestamp of the object. Also, set the update flag to true.
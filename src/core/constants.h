@@ -32,6 +32,7 @@
 
 #define SPLASH_ALL_PEERS "__ALL__"
 #define SPLASH_DEFAULTS_FILE_ENV "SPLASH_DEFAULTS"
+#define SPLASH_SHADER_CACHE_ENV "SPLASH_SHADER_CACHE"
 
 #define SPLASH_FILE_CONFIGURATION "splashConfiguration"
 #define SPLASH_FILE_PROJECT "splashProject"
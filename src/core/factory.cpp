@@ -1,6 +1,7 @@
 #include "./core/factory.h"
 
 #include "./controller/controller_blender.h"
+#include "./controller/controller_httpserver.h"
 #include "./core/link.h"
 #include "./core/scene.h"
 #include "./graphics/camera.h"
@@ -8,9 +9,11 @@
 #include "./graphics/filter_black_level.h"
 #include "./graphics/filter_color_curves.h"
 #include "./graphics/filter_custom.h"
+#include "./graphics/filter_yuv.h"
 #include "./graphics/geometry.h"
 #include "./graphics/object.h"
 #include "./graphics/texture.h"
+#include "./graphics/texture_array.h"
 #include "./graphics/texture_image.h"
 #include "./graphics/virtual_probe.h"
 #include "./graphics/warp.h"
@@ -18,9 +21,14 @@
 #include "./image/image.h"
 #include "./image/image_ffmpeg.h"
 #include "./image/image_list.h"
+#include "./image/image_raw.h"
 #include "./image/queue.h"
 #include "./mesh/mesh.h"
 #include "./sink/sink.h"
+#include "./sink/sink_group.h"
+#include "./sink/sink_network.h"
+#include "./sink/sink_preview.h"
+#include "./sink/sink_record.h"
 #include "./utils/jsonutils.h"
 #include "./utils/log.h"
 #include "./utils/timer.h"
@@ -59,6 +67,7 @@ Factory::Factory()
 {
     loadDefaults();
     registerObjects();
+    compileDefaults();
 }
 
 /*************/
@@ -69,6 +78,7 @@ Factory::Factory(RootObject* root)
 
     loadDefaults();
     registerObjects();
+    compileDefaults();
 }
 
 /*************/
@@ -98,21 +108,22 @@ void Factory::loadDefaults()
 }
 
 /*************/
-shared_ptr<GraphObject> Factory::create(const string& type)
+shared_ptr<GraphObject> Factory::create(const string& type, bool local)
 {
     // Not all object types are listed here, only those available to the user
     auto page = _objectBook.find(type);
     if (page != _objectBook.end())
     {
+        _createLocally = local;
         auto object = page->second.builder(_root);
+        _createLocally = false;
 
-        auto defaultIt = _defaults.find(type);
-        if (defaultIt != _defaults.end())
-            for (auto& attr : defaultIt->second)
-                object->setAttribute(attr.first, attr.second);
+        if (!object)
+            return object;
 
-        if (object)
-            object->setCategory(page->second.objectCategory);
+        for (const auto& [id, values] : page->second.defaults)
+            object->setAttribute(id, values);
+        object->setCategory(page->second.objectCategory);
         return object;
     }
     else
@@ -122,6 +133,24 @@ shared_ptr<GraphObject> Factory::create(const string& type)
     }
 }
 
+/*************/
+void Factory::compileDefaults()
+{
+    for (const auto& [type, defaults] : _defaults)
+    {
+        auto page = _objectBook.find(type);
+        if (page == _objectBook.end())
+        {
+            Log::get() << Log::WARNING << "Factory::" << __FUNCTION__ << " - Default values given for unknown object type " << type << Log::endl;
+            continue;
+        }
+
+        page->second.defaults.clear();
+        for (const auto& [attribute, values] : defaults)
+            page->second.defaults.emplace_back(Attribute::getId(attribute), values);
+    }
+}
+
 /*************/
 vector<string> Factory::getObjectTypes()
 {
@@ -225,11 +254,26 @@ void Factory::registerObjects()
         "Custom filter, which can take a GLSL fragment shader source to process the input texture(s).",
         true);
 
+    _objectBook["filter_yuv"] = Page([&](RootObject* root) { return dynamic_pointer_cast<GraphObject>(make_shared<FilterYuv>(root)); },
+        GraphObject::Category::FILTER,
+        "YUV filter",
+        "Filter converting its input to a planar YUV 4:2:0 frame packed in an RGBA texture, used to read back frames in encoder layout.");
+
     _objectBook["geometry"] = Page([&](RootObject* root) { return dynamic_pointer_cast<GraphObject>(make_shared<Geometry>(root)); },
         GraphObject::Category::MISC,
         "Geometry",
         "Intermediary object holding vertices, UV and normal coordinates of a projection surface.");
 
+    _objectBook["http_server"] = Page(
+        [&](RootObject* root) {
+            if (!root || (_scene && !_scene->isMaster()))
+                return shared_ptr<GraphObject>(nullptr);
+            return dynamic_pointer_cast<GraphObject>(make_shared<HttpServer>(root));
+        },
+        GraphObject::Category::MISC,
+        "http server",
+        "Serves the tree as Json over HTTP and WebSocket, to control Splash remotely.");
+
     _objectBook["image"] = Page([&](RootObject* root) { return dynamic_pointer_cast<GraphObject>(make_shared<Image>(root)); },
         GraphObject::Category::IMAGE,
         "image",
@@ -239,7 +283,7 @@ void Factory::registerObjects()
     _objectBook["image_list"] = Page(
         [&](RootObject* root) {
             shared_ptr<GraphObject> object;
-            if (!_scene)
+            if (!_scene || _createLocally)
                 object = dynamic_pointer_cast<GraphObject>(make_shared<Image_List>(root));
             else
                 object = dynamic_pointer_cast<GraphObject>(make_shared<Image>(root));
@@ -250,11 +294,25 @@ void Factory::registerObjects()
         "Static images read from a directory.",
         true);
 
+    _objectBook["image_raw"] = Page(
+        [&](RootObject* root) {
+            shared_ptr<GraphObject> object;
+            if (!_scene || _createLocally)
+                object = dynamic_pointer_cast<GraphObject>(make_shared<Image_Raw>(root));
+            else
+                object = dynamic_pointer_cast<GraphObject>(make_shared<Image>(root));
+            return object;
+        },
+        GraphObject::Category::IMAGE,
+        "raw frames",
+        "Image object playing a memory mapped sequence of uncompressed frames.",
+        true);
+
 #if HAVE_LINUX
     _objectBook["image_v4l2"] = Page(
         [&](RootObject* root) {
             shared_ptr<GraphObject> object;
-            if (!_scene)
+            if (!_scene || _createLocally)
                 object = dynamic_pointer_cast<GraphObject>(make_shared<Image_V4L2>(root));
             else
                 object = dynamic_pointer_cast<GraphObject>(make_shared<Image>(root));
@@ -269,7 +327,7 @@ void Factory::registerObjects()
     _objectBook["image_ffmpeg"] = Page(
         [&](RootObject* root) {
             shared_ptr<GraphObject> object;
-            if (!_scene)
+            if (!_scene || _createLocally)
                 object = dynamic_pointer_cast<GraphObject>(make_shared<Image_FFmpeg>(root));
             else
                 object = dynamic_pointer_cast<GraphObject>(make_shared<Image>(root));
@@ -284,7 +342,7 @@ void Factory::registerObjects()
     _objectBook["image_gphoto"] = Page(
         [&](RootObject* root) {
             shared_ptr<GraphObject> object;
-            if (!_scene)
+            if (!_scene || _createLocally)
                 object = dynamic_pointer_cast<GraphObject>(make_shared<Image_GPhoto>(root));
             else
                 object = dynamic_pointer_cast<GraphObject>(make_shared<Image>(root));
@@ -300,7 +358,7 @@ void Factory::registerObjects()
     _objectBook["image_shmdata"] = Page(
         [&](RootObject* root) {
             shared_ptr<GraphObject> object;
-            if (!_scene)
+            if (!_scene || _createLocally)
                 object = dynamic_pointer_cast<GraphObject>(make_shared<Image_Shmdata>(root));
             else
                 object = dynamic_pointer_cast<GraphObject>(make_shared<Image>(root));
@@ -316,7 +374,7 @@ void Factory::registerObjects()
     _objectBook["image_opencv"] = Page(
         [&](RootObject* root) {
             shared_ptr<GraphObject> object;
-            if (!_scene)
+            if (!_scene || _createLocally)
                 object = dynamic_pointer_cast<GraphObject>(make_shared<Image_OpenCV>(root));
             else
                 object = dynamic_pointer_cast<GraphObject>(make_shared<Image>(root));
@@ -338,7 +396,7 @@ void Factory::registerObjects()
     _objectBook["mesh_shmdata"] = Page(
         [&](RootObject* root) {
             shared_ptr<GraphObject> object;
-            if (!_scene)
+            if (!_scene || _createLocally)
                 object = dynamic_pointer_cast<GraphObject>(make_shared<Mesh_Shmdata>(root));
             else
                 object = dynamic_pointer_cast<GraphObject>(make_shared<Mesh>(root));
@@ -355,6 +413,26 @@ void Factory::registerObjects()
         "sink a texture to a host buffer",
         "Get the texture content to a host buffer. Only used internally.");
 
+    _objectBook["sink_group"] = Page([&](RootObject* root) { return dynamic_pointer_cast<GraphObject>(make_shared<Sink_Group>(root)); },
+        GraphObject::Category::MISC,
+        "read back many sinks at once",
+        "Copies the inputs of the linked sinks, optionally scaled down, to a single atlas which is read back at once and split between the sinks.");
+
+    _objectBook["sink_network"] = Page([&](RootObject* root) { return dynamic_pointer_cast<GraphObject>(make_shared<Sink_Network>(root)); },
+        GraphObject::Category::MISC,
+        "sink a texture as an encoded video stream over the network",
+        "Outputs texture as an encoded MPEG-TS stream, sent over SRT, RTP or UDP.");
+
+    _objectBook["sink_preview"] = Page([&](RootObject* root) { return dynamic_pointer_cast<GraphObject>(make_shared<Sink_Preview>(root)); },
+        GraphObject::Category::MISC,
+        "sink a low resolution preview to a remote GUI",
+        "Encodes a small preview of the connected object, sent to the World for remote GUIs. Only used internally.");
+
+    _objectBook["sink_record"] = Page([&](RootObject* root) { return dynamic_pointer_cast<GraphObject>(make_shared<Sink_Record>(root)); },
+        GraphObject::Category::MISC,
+        "record a texture to a movie file",
+        "Records texture to a MOV file, encoded with Hap by default for cheap playback.");
+
 #if HAVE_SHMDATA
     _objectBook["sink_shmdata"] = Page([&](RootObject* root) { return dynamic_pointer_cast<GraphObject>(make_shared<Sink_Shmdata>(root)); },
         GraphObject::Category::MISC,
@@ -405,6 +483,18 @@ void Factory::registerObjects()
         "Texture object created from an Image object.",
         true);
 
+    _objectBook["texture_array"] = Page([&](RootObject* root) { return dynamic_pointer_cast<GraphObject>(make_shared<Texture_Array>(root)); },
+        GraphObject::Category::TEXTURE,
+        "texture array",
+        "Array texture holding many small images, one per layer. Created for the images whose textureArray attribute is set.",
+        false);
+
+    _objectBook["texture_array_layer"] = Page([&](RootObject* root) { return dynamic_pointer_cast<GraphObject>(make_shared<Texture_ArrayLayer>(root)); },
+        GraphObject::Category::TEXTURE,
+        "texture array layer",
+        "Layer of a texture array holding a single image, sampled as any other texture.",
+        false);
+
     _objectBook["virtual_probe"] = Page(
         [&](RootObject* root) {
             if (!_scene)
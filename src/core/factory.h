@@ -55,15 +55,17 @@ class Factory
     /**
      * \brief Creates a GraphObject given its type
      * \param type Object type
+     * \param local If true, objects which usually run in the World and send their data to the Scenes, like media decoders,
+     * are created as is even if the root is a Scene, instead of as a counterpart receiving this data
      * \return Return a shared pointer to the created object
      */
-    std::shared_ptr<GraphObject> create(const std::string& type);
+    std::shared_ptr<GraphObject> create(const std::string& type, bool local = false);
 
     /**
      * Get the default parameters
      * \return Return a const reference to the default values
      */
-    const std::unordered_map<std::string, std::unordered_map<std::string, Values>> getDefaults() const { return _defaults; }
+    const std::unordered_map<std::string, std::unordered_map<std::string, Values>>& getDefaults() const { return _defaults; }
 
     /**
      * \brief Get all creatable object types
@@ -133,10 +135,12 @@ class Factory
         std::string shortDescription{"none"};
         std::string description{"none"};
         bool projectSavable{false};
+        std::vector<std::pair<AttributeId, Values>> defaults{}; //!< Default values from _defaults, with their attribute names resolved
     };
 
     RootObject* _root{nullptr};              //!< Root object, used as root for all created objects
     Scene* _scene{nullptr};                  //!< If root is a Scene, this is set
+    bool _createLocally{false};              //!< Set during the creation of an object which runs in the Scene
     std::map<std::string, Page> _objectBook; //!< List of all creatable objects
 
     std::unordered_map<std::string, std::unordered_map<std::string, Values>> _defaults{}; //!< Default values
@@ -150,6 +154,11 @@ class Factory
      * |brief Registers the available objects inside the _objectBook
      */
     void registerObjects();
+
+    /**
+     * Resolve the default values of each type in the object book, so that they are applied without any lookup by name
+     */
+    void compileDefaults();
 };
 
 /*************/
@@ -31,6 +31,15 @@ Attribute& GraphObject::operator[](const string& attr)
     return attribFunction->second;
 }
 
+/*************/
+Attribute& GraphObject::operator[](AttributeId attr)
+{
+    unique_lock<recursive_mutex> lock(_attribMutex);
+    auto attribute = findAttribute(attr);
+    assert(attribute);
+    return *attribute;
+}
+
 /*************/
 Attribute& GraphObject::addAttribute(const string& name, const function<bool(const Values&)>& set, const vector<char>& types)
 {
@@ -99,6 +108,15 @@ void GraphObject::unlinkFromParent(GraphObject* obj)
     }
 }
 
+/*************/
+bool GraphObject::inputsChanged(vector<int64_t>& state)
+{
+    if (state == _inputsState)
+        return false;
+    std::swap(state, _inputsState);
+    return true;
+}
+
 /*************/
 bool GraphObject::linkTo(const shared_ptr<GraphObject>& obj)
 {
@@ -125,6 +143,8 @@ bool GraphObject::linkTo(const shared_ptr<GraphObject>& obj)
 
     _linkedObjects.push_back(obj);
     obj->linkToParent(this);
+    if (_root)
+        _root->signalObjectsChanged();
 
     if (_root && !_name.empty() && !obj->getName().empty())
     {
@@ -164,6 +184,8 @@ void GraphObject::unlinkFrom(const shared_ptr<GraphObject>& obj)
     unlinkIt(obj);
     _linkedObjects.erase(objectIt);
     obj->unlinkFromParent(this);
+    if (_root)
+        _root->signalObjectsChanged();
 
     if (_root && !_name.empty() && !obj->getName().empty())
     {
@@ -211,6 +233,8 @@ bool GraphObject::setRenderingPriority(Priority priority)
     if (priority < Priority::PRE_CAMERA || priority >= Priority::POST_WINDOW)
         return false;
     _renderingPriority = priority;
+    if (_root)
+        _root->signalObjectsChanged();
     return true;
 }
 /*************/
@@ -242,6 +266,8 @@ void GraphObject::registerAttributes()
         "priorityShift",
         [&](const Values& args) {
             _priorityShift = args[0].as<int>();
+            if (_root)
+                _root->signalObjectsChanged();
             return true;
         },
         [&]() -> Values { return {_priorityShift}; },
@@ -362,10 +388,17 @@ void GraphObject::initializeTree()
     }
 }
 
+/*************/
+void GraphObject::detachFromTree()
+{
+    uninitializeTree();
+    _isDetachedFromTree = true;
+}
+
 /*************/
 void GraphObject::uninitializeTree()
 {
-    if (!_root || _name.empty())
+    if (!_root || _name.empty() || _isDetachedFromTree)
         return;
 
     auto tree = _root->getTree();
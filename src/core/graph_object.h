@@ -61,6 +61,20 @@ class GraphObject : public BaseObject
         TEXTURE
     };
 
+    //! Memory held by an object, in bytes
+    struct MemoryUsage
+    {
+        int64_t ram{0};  //!< Host memory
+        int64_t vram{0}; //!< GPU memory: buffers, PBOs, textures and framebuffer attachments
+
+        MemoryUsage& operator+=(const MemoryUsage& rhs)
+        {
+            ram += rhs.ram;
+            vram += rhs.vram;
+            return *this;
+        }
+    };
+
   public:
     /**
      * Constructor.
@@ -89,6 +103,13 @@ class GraphObject : public BaseObject
      */
     Attribute& operator[](const std::string& attr);
 
+    /**
+     * Access the attributes through operator[], from their identifier.
+     * \param attr Identifier of the attribute, as given by Attribute::getId
+     * \return Returns a reference to the attribute.
+     */
+    Attribute& operator[](AttributeId attr);
+
     /**
      * Add a new attribute to this object
      * \param name Attribute name
@@ -146,6 +167,12 @@ class GraphObject : public BaseObject
      */
     void setName(const std::string& name) override;
 
+    /**
+     * Remove the object from the tree right away, instead of at destruction
+     * This is needed when the destruction is deferred, so that it does not remove the branch of a new object with the same name
+     */
+    void detachFromTree();
+
     /**
      * Set the remote type of the object. This implies that this object gets data streamed from a World object
      * \param type Remote type
@@ -181,6 +208,12 @@ class GraphObject : public BaseObject
      */
     const std::vector<std::weak_ptr<GraphObject>> getLinkedObjects() { return _linkedObjects; }
 
+    /**
+     * Return the objects this object is linked to, i.e. its parents
+     * \return Returns a vector of the parent objects
+     */
+    const std::vector<GraphObject*>& getParents() const { return _parents; }
+
     /**
      * Get the savability for this object
      * \return Returns true if the object should be saved
@@ -209,6 +242,12 @@ class GraphObject : public BaseObject
      */
     virtual void update() {}
 
+    /**
+     * Get whether update() only works on the CPU, in which case it can be called from any thread
+     * \return Return true if update() does no GL call
+     */
+    bool hasCpuOnlyUpdate() const { return _cpuOnlyUpdate; }
+
     /**
      * Get the rendering priority for this object
      * The priorities have the following values:
@@ -245,6 +284,12 @@ class GraphObject : public BaseObject
      */
     virtual void setTimestamp(int64_t) {}
 
+    /**
+     * Get the memory held by this object, as a best effort estimation
+     * \return Return the memory usage
+     */
+    virtual MemoryUsage getMemoryUsage() const { return {}; }
+
     /**
      * Set the rendering priority for this object
      * Set GraphObject::getRenderingPriority() for precision about priority
@@ -266,11 +311,15 @@ class GraphObject : public BaseObject
     std::vector<GraphObject*> _parents{}; //!< Objects parents
     std::unordered_map<std::string, int> _treeCallbackIds{};
 
+    std::vector<int64_t> _inputsState{}; //!< State of the inputs when last rendered, see inputsChanged()
+
     Priority _renderingPriority{Priority::NO_RENDER}; //!< Rendering priority, if negative the object won't be rendered
     bool _savable{true};                              //!< True if the object should be saved
     int _priorityShift{0};                            //!< Shift applied to rendering priority
+    bool _cpuOnlyUpdate{false};                       //!< True if update() does no GL call, and can run out of the render thread
 
     bool _isConnectedToRemote{false}; //!< True if the object gets data from a World object
+    bool _isDetachedFromTree{false};  //!< True if the object has already been removed from the tree
 
     RootObject* _root;                                      //!< Root object, Scene or World
     std::vector<std::weak_ptr<GraphObject>> _linkedObjects; //!< Linked objects
@@ -293,6 +342,14 @@ class GraphObject : public BaseObject
      */
     void linkToParent(GraphObject* obj);
 
+    /**
+     * Check whether the inputs changed since the previous call, and store their state
+     * This is used to skip rendering when nothing upstream changed
+     * \param state Current state of the inputs, typically their timestamps and attributes versions
+     * \return Return true if the state differs from the previous one
+     */
+    bool inputsChanged(std::vector<int64_t>& state);
+
     /**
      * Remove the given object as a parent
      * \param obj Parent object
@@ -36,6 +36,15 @@ string ImageBufferSpec::to_string() const
     spec += std::to_string(static_cast<int>(videoFrame)) + ";";
     spec += std::to_string(timestamp) + ";";
 
+    // The tile description is only added for tiles, to keep the spec of whole images unchanged
+    if (isTile())
+    {
+        spec += std::to_string(tileX) + ";";
+        spec += std::to_string(tileY) + ";";
+        spec += std::to_string(fullWidth) + ";";
+        spec += std::to_string(fullHeight) + ";";
+    }
+
     return spec;
 }
 
@@ -52,7 +61,7 @@ void ImageBufferSpec::from_string(const string& spec)
         prev = curr + 1;
         curr = spec.find(";", prev);
     }
-    assert(parts.size() == 8);
+    assert(parts.size() == 8 || parts.size() == 12);
 
     width = stoi(parts[0]);
     height = stoi(parts[1]);
@@ -76,6 +85,34 @@ void ImageBufferSpec::from_string(const string& spec)
     format = parts[5];
     videoFrame = static_cast<bool>(stoi(parts[6]));
     timestamp = stoll(parts[7]);
+
+    // Specs without the tile description hold the whole image
+    if (parts.size() == 12)
+    {
+        tileX = stoi(parts[8]);
+        tileY = stoi(parts[9]);
+        fullWidth = stoi(parts[10]);
+        fullHeight = stoi(parts[11]);
+    }
+    else
+    {
+        tileX = 0;
+        tileY = 0;
+        fullWidth = 0;
+        fullHeight = 0;
+    }
+}
+
+/*************/
+bool ImageBufferSpec::isTileable() const
+{
+    if (bpp == 0 || bpp % 8 != 0)
+        return false;
+    if (format.find("DXT") != string::npos)
+        return false;
+    if (format == "NV12" || format == "P010" || format == "I420")
+        return false;
+    return true;
 }
 
 /*************/
@@ -90,7 +127,7 @@ ImageBuffer::ImageBuffer(const ImageBufferSpec& spec, uint8_t* data, bool map)
     }
     else if (!map)
     {
-        auto size = spec.width * spec.height * spec.pixelBytes();
+        auto size = spec.rawSize();
         if (data)
             _buffer = ResizableArray<uint8_t>(data, data + size);
         else
@@ -98,6 +135,14 @@ ImageBuffer::ImageBuffer(const ImageBufferSpec& spec, uint8_t* data, bool map)
     }
 }
 
+/*************/
+ImageBuffer::ImageBuffer(const ImageBufferSpec& spec, ResizableArray<uint8_t>&& buffer)
+    : _spec(spec)
+    , _buffer(std::move(buffer))
+{
+    assert(_buffer.size() == spec.rawSize());
+}
+
 /*************/
 void ImageBuffer::zero()
 {
@@ -101,6 +101,12 @@ class ImageBufferSpec
     bool videoFrame{true};
     int64_t timestamp{-1};
 
+    // If the buffer only holds a tile of a larger image, position of the tile and size of the whole image
+    uint32_t tileX{0};
+    uint32_t tileY{0};
+    uint32_t fullWidth{0};
+    uint32_t fullHeight{0};
+
     inline bool operator==(const ImageBufferSpec& spec) const
     {
         if (width != spec.width)
@@ -115,6 +121,8 @@ class ImageBufferSpec
             return false;
         if (format != spec.format)
             return false;
+        if (tileX != spec.tileX || tileY != spec.tileY || fullWidth != spec.fullWidth || fullHeight != spec.fullHeight)
+            return false;
 
         return true;
     }
@@ -133,6 +141,19 @@ class ImageBufferSpec
      */
     void from_string(const std::string& spec);
 
+    /**
+     * \brief Check whether the buffer only holds a tile of a larger image
+     * \return Return true if this is a tile
+     */
+    bool isTile() const { return fullWidth != 0 && fullHeight != 0; }
+
+    /**
+     * \brief Check whether tiles can be extracted from images of this spec, by copying a subset of each row
+     * This excludes block compressed, planar and sub-byte formats
+     * \return Return true if the image can be tiled
+     */
+    bool isTileable() const;
+
     /**
      * \brief Get channel size in bytes
      * \return Return channel size
@@ -141,9 +162,10 @@ class ImageBufferSpec
 
     /**
      * \brief Get image size in bytes
+     * Computed from the bits per pixel, as subsampled formats like NV12 have a fractional pixel size in bytes
      * \return Return image size
      */
-    int rawSize() const { return pixelBytes() * width * height; }
+    int rawSize() const { return static_cast<int>(static_cast<int64_t>(bpp) * width * height / 8); }
 };
 
 /*************/
@@ -163,6 +185,13 @@ class ImageBuffer
      */
     ImageBuffer(const ImageBufferSpec& spec, uint8_t* data = nullptr, bool map = false);
 
+    /**
+     * \brief Constructor taking ownership of the given buffer, without copying it
+     * \param spec Image spec
+     * \param buffer Buffer, which can adopt external memory released through its deleter
+     */
+    ImageBuffer(const ImageBufferSpec& spec, ResizableArray<uint8_t>&& buffer);
+
     /**
      * \brief Destructor
      */
@@ -203,7 +232,7 @@ class ImageBuffer
      * \brief Get the image buffer size
      * \return Return the size
      */
-    size_t getSize() const { return _mappedBuffer ? _spec.width * _spec.height * _spec.pixelBytes() : _buffer.size(); }
+    size_t getSize() const { return _mappedBuffer ? _spec.rawSize() : _buffer.size(); }
 
     /**
      * \brief Fill all channels with the given value
@@ -218,7 +247,7 @@ class ImageBuffer
     void setRawBuffer(ResizableArray<uint8_t>&& buffer)
     {
         if (!_mappedBuffer)
-            _buffer = buffer;
+            _buffer = std::move(buffer);
     }
 
   private:
@@ -0,0 +1,154 @@
+/*
+ * Copyright (C) 2026 Emmanuel Durand
+ *
+ * This file is part of Splash.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Splash is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Splash.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * @imagebuffer_pool.h
+ * Pool of image buffers, recycled from the consumer of the frames to their producer
+ */
+
+#ifndef SPLASH_IMAGEBUFFER_POOL_H
+#define SPLASH_IMAGEBUFFER_POOL_H
+
+#include <deque>
+#include <memory>
+#include <mutex>
+
+#include "./core/imagebuffer.h"
+
+namespace Splash
+{
+
+/*************/
+//! Pool of image buffers, keyed by their spec
+//! Buffers released by the consumer are handed back to the producer when it asks for the same spec,
+//! saving both the allocation and the page faults on first touch. The pool holds at most the given
+//! amount of memory, the oldest buffers being dropped first. Buffers of another spec than the one asked
+//! for are dropped as soon as no buffer matches, as they belong to a previous resolution or format.
+//! The pool can be used concurrently from any number of threads.
+class ImageBufferPool
+{
+  public:
+    /**
+     * Constructor
+     * \param maximumSize Maximum memory held by the pool, in bytes
+     */
+    explicit ImageBufferPool(int64_t maximumSize = 0)
+        : _maximumSize(maximumSize)
+    {
+    }
+
+    ImageBufferPool(const ImageBufferPool&) = delete;
+    ImageBufferPool& operator=(const ImageBufferPool&) = delete;
+
+    /**
+     * Get a buffer of the given spec, recycled if possible. Its content is undefined.
+     * \param spec Image spec
+     * \return Return the buffer
+     */
+    std::unique_ptr<ImageBuffer> acquire(const ImageBufferSpec& spec)
+    {
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            for (auto bufferIt = _buffers.rbegin(); bufferIt != _buffers.rend(); ++bufferIt)
+            {
+                if ((*bufferIt)->getSpec() != spec)
+                    continue;
+
+                auto buffer = std::move(*bufferIt);
+                _buffers.erase(std::next(bufferIt).base());
+                _size -= static_cast<int64_t>(buffer->getSize());
+                buffer->getSpec() = spec;
+                return buffer;
+            }
+
+            _buffers.clear();
+            _size = 0;
+        }
+
+        return std::make_unique<ImageBuffer>(spec);
+    }
+
+    /**
+     * Give a buffer back to the pool. Empty buffers and buffers mapping external memory are dropped.
+     * \param buffer Buffer to recycle
+     */
+    void release(std::unique_ptr<ImageBuffer>&& buffer)
+    {
+        if (!buffer || buffer->empty() || buffer->data() != buffer->getRawBuffer().data() || buffer->getSize() != static_cast<size_t>(buffer->getSpec().rawSize()))
+            return;
+
+        std::lock_guard<std::mutex> lock(_mutex);
+        _size += static_cast<int64_t>(buffer->getSize());
+        _buffers.push_back(std::move(buffer));
+        trim();
+    }
+
+    /**
+     * Set the maximum memory held by the pool, dropping the oldest buffers if needed
+     * \param maximumSize Maximum size, in bytes
+     */
+    void setMaximumSize(int64_t maximumSize)
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _maximumSize = maximumSize;
+        trim();
+    }
+
+    /**
+     * Get the memory currently held by the pool
+     * \return Return the size in bytes
+     */
+    int64_t getSize() const
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return _size;
+    }
+
+    /**
+     * Drop all the buffers
+     */
+    void clear()
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _buffers.clear();
+        _size = 0;
+    }
+
+  private:
+    mutable std::mutex _mutex{};
+    std::deque<std::unique_ptr<ImageBuffer>> _buffers{}; //!< Recycled buffers, the oldest first
+    int64_t _size{0};                                    //!< Memory held by the buffers, in bytes
+    int64_t _maximumSize{0};
+
+    /**
+     * Drop the oldest buffers until the pool fits in its maximum size, the mutex being held
+     */
+    void trim()
+    {
+        while (_size > _maximumSize && !_buffers.empty())
+        {
+            _size -= static_cast<int64_t>(_buffers.front()->getSize());
+            _buffers.pop_front();
+        }
+    }
+};
+
+} // namespace Splash
+
+#endif // SPLASH_IMAGEBUFFER_POOL_H
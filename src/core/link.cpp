@@ -2,13 +2,26 @@
 
 #include <algorithm>
 #include <chrono>
+#include <snappy.h>
 #include <thread>
 
 #include "./core/attribute.h"
 #include "./core/buffer_object.h"
 #include "./core/root_object.h"
+#include "./core/serialize/serialize_value.h"
+#include "./core/serializer.h"
+#include "./core/value_codec.h"
 #include "./utils/log.h"
+#include "./utils/osutils.h"
 #include "./utils/timer.h"
+#include "./utils/trace_recorder.h"
+
+// Maximum number of sent buffers kept for reuse
+#define SPLASH_LINK_BUFFER_POOL_SIZE 8
+// Receive timeout of the input threads, in ms, which bounds the time to stop them
+#define SPLASH_LINK_RECEIVE_TIMEOUT 10
+// Maximum multicast rate, in kbit/s
+#define SPLASH_LINK_MULTICAST_RATE 1000000
 
 using namespace std;
 
@@ -28,11 +41,16 @@ Link::Link(RootObject* root, const string& name)
         _socketMessageIn = make_unique<zmq::socket_t>(*_context, ZMQ_SUB);
         _socketBufferOut = make_unique<zmq::socket_t>(*_context, ZMQ_PUB);
         _socketBufferIn = make_unique<zmq::socket_t>(*_context, ZMQ_SUB);
+        _socketShmOut = make_unique<zmq::socket_t>(*_context, ZMQ_PUB);
+        _socketShmIn = make_unique<zmq::socket_t>(*_context, ZMQ_SUB);
+        _socketQueryIn = make_unique<zmq::socket_t>(*_context, ZMQ_REP);
+        _socketBufferDirectIn = make_unique<zmq::socket_t>(*_context, ZMQ_PULL);
 
         // High water mark set to zero for the outputs
         int hwm = 0;
         _socketMessageOut->setsockopt(ZMQ_SNDHWM, &hwm, sizeof(hwm));
         _socketBufferOut->setsockopt(ZMQ_SNDHWM, &hwm, sizeof(hwm));
+        _socketShmOut->setsockopt(ZMQ_SNDHWM, &hwm, sizeof(hwm));
     }
     catch (const zmq::error_t& e)
     {
@@ -41,13 +59,47 @@ Link::Link(RootObject* root, const string& name)
     }
 
     auto socketPrefix = _rootObject->getSocketPrefix();
+    _tcpAddress = _rootObject->getListenAddress();
+    _multicastAddress = _rootObject->getMulticastAddress();
     _basePath = "ipc:///tmp/splash_";
+    _shmBasePath = "/splash_";
     if (!socketPrefix.empty())
+    {
         _basePath += socketPrefix + string("_");
+        _shmBasePath += socketPrefix + string("_");
+    }
+
+    // Buffers for the peers on other hosts are sent once to the multicast group they all joined
+    if (!_multicastAddress.empty())
+    {
+        try
+        {
+            _socketBufferMulticastOut = make_unique<zmq::socket_t>(*_context, ZMQ_PUB);
+            int rate = SPLASH_LINK_MULTICAST_RATE;
+            _socketBufferMulticastOut->setsockopt(ZMQ_RATE, &rate, sizeof(rate));
+            _socketBufferMulticastOut->connect(("epgm://" + _multicastAddress).c_str());
+        }
+        catch (const zmq::error_t& e)
+        {
+            Log::get() << Log::WARNING << "Link::" << __FUNCTION__ << " - Unable to join multicast group " << _multicastAddress << ", buffers will be sent to each peer: " << e.what()
+                       << Log::endl;
+            _socketBufferMulticastOut.reset();
+        }
+    }
+
+    // Outgoing buffers are written in shared memory whenever possible
+    _shmRing = make_unique<ShmRing>(_shmBasePath + _name);
+    if (!_shmRing->isValid())
+    {
+        Log::get() << Log::WARNING << "Link::" << __FUNCTION__ << " - Unable to create the shared memory ring, buffers will be copied through ZMQ" << Log::endl;
+        _shmRing.reset();
+    }
 
     _running = true;
     _bufferInThread = thread([&]() { handleInputBuffers(); });
     _messageInThread = thread([&]() { handleInputMessages(); });
+    _queryInThread = thread([&]() { handleInputQueries(); });
+    _innerThread = thread([&]() { handleInnerItems(); });
 }
 
 /*************/
@@ -56,12 +108,28 @@ Link::~Link()
     _running = false;
     _bufferInThread.join();
     _messageInThread.join();
+    _queryInThread.join();
+    _innerCondition.notify_one();
+    _innerThread.join();
+
+    // Items which were not delivered are still owned by the queue
+    InnerItem* item = nullptr;
+    while (_innerQueue.pop(item))
+        delete item;
 
     int lingerValue = 0;
     try
     {
         _socketMessageOut->setsockopt(ZMQ_LINGER, &lingerValue, sizeof(lingerValue));
         _socketBufferOut->setsockopt(ZMQ_LINGER, &lingerValue, sizeof(lingerValue));
+        _socketShmOut->setsockopt(ZMQ_LINGER, &lingerValue, sizeof(lingerValue));
+        if (_socketBufferMulticastOut)
+            _socketBufferMulticastOut->setsockopt(ZMQ_LINGER, &lingerValue, sizeof(lingerValue));
+        _socketQueryIn->setsockopt(ZMQ_LINGER, &lingerValue, sizeof(lingerValue));
+        for (auto& socketIt : _socketsQueryOut)
+            socketIt.second->setsockopt(ZMQ_LINGER, &lingerValue, sizeof(lingerValue));
+        for (auto& socketIt : _socketsBufferDirectOut)
+            socketIt.second->setsockopt(ZMQ_LINGER, &lingerValue, sizeof(lingerValue));
     }
     catch (zmq::error_t &e)
     {
@@ -70,18 +138,55 @@ Link::~Link()
 }
 
 /*************/
-void Link::connectTo(const string& name)
+void Link::connectTo(const string& name, const string& address)
 {
-    if (find(_connectedTargets.begin(), _connectedTargets.end(), name) == _connectedTargets.end())
-        _connectedTargets.push_back(name);
-    else
+    if (find(_connectedTargets.begin(), _connectedTargets.end(), name) != _connectedTargets.end())
         return;
 
+    if (!address.empty() && getEndpoint(name, "msg", address).empty())
+    {
+        Log::get() << Log::WARNING << "Link::" << __FUNCTION__ << " - Invalid address for peer " << name << ": " << address << ", expected host:port" << Log::endl;
+        return;
+    }
+
+    _connectedTargets.push_back(name);
+    if (!address.empty())
+    {
+        _targetAddresses[name] = address;
+        _connectedToRemote = true;
+    }
+
     try
     {
-        // For now, all connections are through IPC.
-        _socketMessageOut->connect((_basePath + "msg_" + name).c_str());
-        _socketBufferOut->connect((_basePath + "buf_" + name).c_str());
+        _socketMessageOut->connect(getEndpoint(name, "msg", address).c_str());
+        if (address.empty() || !_socketBufferMulticastOut)
+            _socketBufferOut->connect(getEndpoint(name, "buf", address).c_str());
+        if (address.empty())
+            _socketShmOut->connect(getEndpoint(name, "shm", address).c_str());
+
+        // Queries which timed out must not prevent the next ones from being sent,
+        // and late answers to them must be discarded
+        auto socketQueryOut = make_unique<zmq::socket_t>(*_context, ZMQ_REQ);
+        int enabled = 1;
+        int lingerValue = 0;
+        socketQueryOut->setsockopt(ZMQ_REQ_RELAXED, &enabled, sizeof(enabled));
+        socketQueryOut->setsockopt(ZMQ_REQ_CORRELATE, &enabled, sizeof(enabled));
+        socketQueryOut->setsockopt(ZMQ_LINGER, &lingerValue, sizeof(lingerValue));
+        socketQueryOut->connect(getEndpoint(name, "qry", address).c_str());
+
+        auto socketBufferDirectOut = make_unique<zmq::socket_t>(*_context, ZMQ_PUSH);
+        int hwm = 0;
+        socketBufferDirectOut->setsockopt(ZMQ_SNDHWM, &hwm, sizeof(hwm));
+        socketBufferDirectOut->setsockopt(ZMQ_LINGER, &lingerValue, sizeof(lingerValue));
+        socketBufferDirectOut->connect(getEndpoint(name, "bfd", address).c_str());
+
+        {
+            lock_guard<Spinlock> lockBuffer(_bufferSendMutex);
+            _socketsBufferDirectOut[name] = std::move(socketBufferDirectOut);
+        }
+
+        lock_guard<mutex> lock(_queryMutex);
+        _socketsQueryOut[name] = std::move(socketQueryOut);
     }
     catch (const zmq::error_t& e)
     {
@@ -100,11 +205,14 @@ void Link::connectTo(const std::string& name, RootObject* peer)
     if (!peer)
         return;
 
-    auto rootObjectIt = _connectedTargetPointers.find(name);
-    if (rootObjectIt == _connectedTargetPointers.end())
-        _connectedTargetPointers[name] = peer;
-    else
-        return;
+    {
+        lock_guard<mutex> lock(_innerPeersMutex);
+        auto rootObjectIt = _connectedTargetPointers.find(name);
+        if (rootObjectIt == _connectedTargetPointers.end())
+            _connectedTargetPointers[name] = peer;
+        else
+            return;
+    }
 
     // Wait a bit for the connection to be up
     this_thread::sleep_for(chrono::milliseconds(100));
@@ -117,11 +225,34 @@ void Link::disconnectFrom(const std::string& name)
     auto targetIt = find(_connectedTargets.begin(), _connectedTargets.end(), name);
     if (targetIt != _connectedTargets.end())
     {
+        auto addressIt = _targetAddresses.find(name);
+        auto address = addressIt == _targetAddresses.end() ? string() : addressIt->second;
+
         try
         {
-            _socketMessageOut->disconnect((_basePath + "msg_" + name).c_str());
-            _socketBufferOut->disconnect((_basePath + "buf_" + name).c_str());
+            _socketMessageOut->disconnect(getEndpoint(name, "msg", address).c_str());
+            if (address.empty() || !_socketBufferMulticastOut)
+                _socketBufferOut->disconnect(getEndpoint(name, "buf", address).c_str());
+            if (address.empty())
+            {
+                _socketShmOut->disconnect(getEndpoint(name, "shm", address).c_str());
+                // The buffers the peer holds, and the descriptors it did not receive, do not keep the slots anymore
+                if (_shmRing)
+                    _shmRing->removeReader(name);
+            }
             _connectedTargets.erase(targetIt);
+
+            if (addressIt != _targetAddresses.end())
+                _targetAddresses.erase(addressIt);
+            _connectedToRemote = !_targetAddresses.empty();
+
+            {
+                lock_guard<Spinlock> lockBuffer(_bufferSendMutex);
+                _socketsBufferDirectOut.erase(name);
+            }
+
+            lock_guard<mutex> lock(_queryMutex);
+            _socketsQueryOut.erase(name);
         }
         catch (const zmq::error_t& e)
         {
@@ -130,11 +261,65 @@ void Link::disconnectFrom(const std::string& name)
         }
     }
 
-    auto targetPointerIt = _connectedTargetPointers.find(name);
-    if (targetPointerIt != _connectedTargetPointers.end())
     {
-        _connectedTargetPointers.erase(targetPointerIt);
+        lock_guard<mutex> lock(_innerPeersMutex);
+        if (_connectedTargetPointers.find(name) == _connectedTargetPointers.end())
+            return;
+    }
+
+    // Items queued before the disconnection, as a last message asking the peer to quit, are delivered first.
+    // This is skipped when called while delivering an item, which would wait for itself
+    const bool fromInnerThread = this_thread::get_id() == _innerThread.get_id();
+    if (!fromInnerThread)
+    {
+        const auto queuedCount = _innerQueuedCount.load(std::memory_order_acquire);
+        while (_running && _innerDeliveredCount.load(std::memory_order_acquire) < queuedCount)
+        {
+            unique_lock<mutex> lock(_innerMutex);
+            _innerDeliveredCondition.wait_for(lock, chrono::milliseconds(1));
+        }
+    }
+
+    // Later items are not delivered to this peer anymore
+    {
+        lock_guard<mutex> lock(_innerPeersMutex);
+        _connectedTargetPointers.erase(name);
+    }
+
+    // Wait for an item being delivered to the peer, from a copy of the peers taken before it was erased
+    if (!fromInnerThread)
+    {
+        lock_guard<mutex> lockDelivery(_innerDeliveryMutex);
+    }
+}
+
+/*************/
+string Link::getEndpoint(const string& name, const string& channel, const string& address) const
+{
+    if (address.empty())
+        return _basePath + channel + "_" + name;
+
+    static const vector<string> tcpChannels{"msg", "buf", "qry", "bfd"};
+    auto channelIt = find(tcpChannels.begin(), tcpChannels.end(), channel);
+    auto separator = address.rfind(':');
+    if (channelIt == tcpChannels.end() || separator == string::npos || separator == 0)
+        return "";
+
+    int port = 0;
+    try
+    {
+        port = stoi(address.substr(separator + 1));
+    }
+    catch (...)
+    {
+        return "";
     }
+
+    port += static_cast<int>(distance(tcpChannels.begin(), channelIt));
+    if (port <= 0 || port > 65535)
+        return "";
+
+    return "tcp://" + address.substr(0, separator) + ":" + to_string(port);
 }
 
 /*************/
@@ -145,7 +330,8 @@ bool Link::waitForBufferSending(chrono::milliseconds maximumWait)
 
     while (true)
     {
-        if (_otgNumber == 0)
+        // Latest only buffers are dropped by the send methods if a peer lags, there is no need to wait for them
+        if (_otgNumber.load(std::memory_order_acquire) - _otgLatestOnlyNumber.load(std::memory_order_acquire) <= 0 && _innerPending.load(std::memory_order_acquire) == 0)
         {
             returnValue = true;
             break;
@@ -163,58 +349,274 @@ bool Link::waitForBufferSending(chrono::milliseconds maximumWait)
 }
 
 /*************/
-bool Link::sendBuffer(const string& name, shared_ptr<SerializedObject> buffer)
+shared_ptr<SerializedObject> Link::allocateBuffer(size_t size)
 {
+    const auto remoteCount = _targetAddresses.size();
+    if (_connectedToOuter && _shmRing && _connectedTargets.size() != remoteCount && (remoteCount == 0 || _socketBufferMulticastOut))
+    {
+        auto buffer = _shmRing->allocate(size);
+        if (buffer)
+            return buffer;
+    }
+
+    {
+        lock_guard<Spinlock> lock(_bufferPoolMutex);
+        auto poolIt = _bufferPool.find(size);
+        if (poolIt != _bufferPool.end() && !poolIt->second.empty())
+        {
+            auto buffer = std::move(poolIt->second.back());
+            poolIt->second.pop_back();
+            if (poolIt->second.empty())
+                _bufferPool.erase(poolIt);
+            --_bufferPoolCount;
+            return buffer;
+        }
+    }
+
+    return make_shared<SerializedObject>(size);
+}
+
+/*************/
+bool Link::sendBuffer(const string& name, shared_ptr<SerializedObject> buffer, BufferPolicy policy)
+{
+    TraceSpan span("link_send", name);
+
     if (_connectedToInner)
     {
-        for (auto& rootObjectIt : _connectedTargetPointers)
+        auto item = make_unique<InnerItem>();
+        item->name = name;
+        // If there is also a connection to another process,
+        // we make a copy of the buffer right now
+        if (_connectedToOuter)
         {
-            auto rootObject = rootObjectIt.second;
-            // If there is also a connection to another process,
-            // we make a copy of the buffer right now
-            if (rootObject && _connectedToOuter)
-            {
-                auto copiedBuffer = make_shared<SerializedObject>();
-                *copiedBuffer = *buffer;
-                rootObject->setFromSerializedObject(name, copiedBuffer);
-            }
-            else if (rootObject)
-            {
-                rootObject->setFromSerializedObject(name, buffer);
-            }
+            item->buffer = make_shared<SerializedObject>();
+            *item->buffer = *buffer;
+        }
+        else
+        {
+            item->buffer = buffer;
         }
+        queueInnerItem(std::move(item));
     }
 
     if (_connectedToOuter)
     {
-        try
+        lock_guard<Spinlock> lock(_bufferSendMutex);
+
+        // If the previous buffer is still queued, a peer lags behind and this one would only add to its latency
+        const bool latestOnly = policy == BufferPolicy::latestOnly;
+        if (latestOnly && isLatestBufferQueued(name))
         {
-            lock_guard<Spinlock> lock(_bufferSendMutex);
-            auto bufferPtr = buffer.get();
+            _droppedBufferCount.fetch_add(1, std::memory_order_acq_rel);
+            return false;
+        }
+        LatestBuffer latestBuffer;
 
-            _otgMutex.lock();
-            _otgBuffers.push_back(buffer);
-            _otgMutex.unlock();
+        const auto remoteCount = _targetAddresses.size();
+        const auto localCount = _connectedTargets.size() - remoteCount;
+        const bool useMulticast = _socketBufferMulticastOut && remoteCount != 0;
 
-            _otgNumber.fetch_add(1, std::memory_order_acq_rel);
+        // Peers on other hosts either get the buffer once for all of them through multicast,
+        // or through the buffer socket they share with the local peers
+        if (useMulticast)
+            latestBuffer.sequences[0] = sendCompressedBuffer(*_socketBufferMulticastOut, name, buffer, latestOnly);
 
-            zmq::message_t msg(name.size() + 1);
-            memcpy(msg.data(), (void*)name.c_str(), name.size() + 1);
-            _socketBufferOut->send(msg, zmq::send_flags::sndmore);
+        // If the buffer lives in shared memory, only its descriptor is sent
+        // Descriptors are tiny and read right away by the peers link thread, so they are not subject to the policy
+        if (_shmRing && localCount != 0 && (remoteCount == 0 || useMulticast))
+        {
+            if (auto descriptor = _shmRing->retain(buffer); descriptor)
+            {
+                try
+                {
+                    zmq::message_t msg(name.size() + 1);
+                    memcpy(msg.data(), (void*)name.c_str(), name.size() + 1);
+                    _socketShmOut->send(msg, zmq::send_flags::sndmore);
+
+                    msg.rebuild(_name.size() + 1);
+                    memcpy(msg.data(), (void*)_name.c_str(), _name.size() + 1);
+                    _socketShmOut->send(msg, zmq::send_flags::sndmore);
 
-            msg.rebuild(bufferPtr->data(), bufferPtr->size(), Link::freeOlderBuffer, this);
-            _socketBufferOut->send(msg, zmq::send_flags::none);
+                    msg.rebuild(sizeof(ShmRing::Descriptor));
+                    memcpy(msg.data(), &descriptor.value(), sizeof(ShmRing::Descriptor));
+                    _socketShmOut->send(msg, zmq::send_flags::none);
+                }
+                catch (const zmq::error_t& e)
+                {
+                    if (errno != ETERM)
+                        Log::get() << Log::WARNING << "Link::" << __FUNCTION__ << " - Exception: " << e.what() << Log::endl;
+                }
+
+                if (latestOnly)
+                    _latestBuffers[name] = latestBuffer;
+                return true;
+            }
         }
-        catch (const zmq::error_t& e)
+
+        // Buffers going to other hosts are compressed, as the network is much slower than the memory
+        if (remoteCount != 0 && !useMulticast)
         {
-            if (errno != ETERM)
-                Log::get() << Log::WARNING << "Link::" << __FUNCTION__ << " - Exception: " << e.what() << Log::endl;
+            latestBuffer.sequences[1] = sendCompressedBuffer(*_socketBufferOut, name, buffer, latestOnly);
+        }
+        else if (localCount != 0)
+        {
+            latestBuffer.sequences[1] = sendRawBuffer(*_socketBufferOut, name, buffer, latestOnly);
+        }
+
+        if (latestOnly)
+            _latestBuffers[name] = latestBuffer;
+    }
+
+    return true;
+}
+
+/*************/
+bool Link::sendBufferTo(const string& peer, const string& name, shared_ptr<SerializedObject> buffer, BufferPolicy policy)
+{
+    TraceSpan span("link_send", name);
+
+    if (_connectedToInner)
+    {
+        unique_lock<mutex> lockInner(_innerPeersMutex);
+        if (auto targetPointerIt = _connectedTargetPointers.find(peer); targetPointerIt != _connectedTargetPointers.end())
+        {
+            if (!targetPointerIt->second)
+                return false;
+            lockInner.unlock();
+
+            auto item = make_unique<InnerItem>();
+            item->peer = peer;
+            item->name = name;
+            item->buffer = std::move(buffer);
+            queueInnerItem(std::move(item));
+            return true;
         }
     }
 
+    lock_guard<Spinlock> lock(_bufferSendMutex);
+    auto socketIt = _socketsBufferDirectOut.find(peer);
+    if (socketIt == _socketsBufferDirectOut.end())
+        return false;
+
+    // Each peer has its own channel, so that a lagging peer only drops its own buffers
+    const bool latestOnly = policy == BufferPolicy::latestOnly;
+    const auto key = peer + "/" + name;
+    if (latestOnly && isLatestBufferQueued(key))
+    {
+        _droppedBufferCount.fetch_add(1, std::memory_order_acq_rel);
+        return false;
+    }
+
+    // As for the buffer socket, buffers going to other hosts are compressed
+    uint64_t sequence = 0;
+    if (_targetAddresses.find(peer) != _targetAddresses.end())
+        sequence = sendCompressedBuffer(*socketIt->second, name, buffer, latestOnly);
+    else
+        sequence = sendRawBuffer(*socketIt->second, name, buffer, latestOnly);
+
+    if (latestOnly)
+        _latestBuffers[key].sequences = {sequence, 0};
+
     return true;
 }
 
+/*************/
+bool Link::isLatestBufferQueued(const string& key)
+{
+    auto latestIt = _latestBuffers.find(key);
+    if (latestIt == _latestBuffers.end())
+        return false;
+
+    const auto& latestBuffer = latestIt->second;
+    lock_guard<Spinlock> lockOtg(_otgMutex);
+    for (const auto& outgoing : _otgBuffers)
+        for (const auto sequence : latestBuffer.sequences)
+            if (sequence != 0 && outgoing.sequence == sequence)
+                return true;
+
+    return false;
+}
+
+/*************/
+uint64_t Link::sendRawBuffer(zmq::socket_t& socket, const string& name, const shared_ptr<SerializedObject>& buffer, bool latestOnly)
+{
+    return sendBufferWithoutCopy(socket, name, buffer, buffer->size(), BufferEncoding::raw, latestOnly);
+}
+
+/*************/
+uint64_t Link::sendBufferWithoutCopy(
+    zmq::socket_t& socket, const string& name, const shared_ptr<SerializedObject>& buffer, size_t size, BufferEncoding encoding, bool latestOnly)
+{
+    try
+    {
+        auto bufferPtr = buffer.get();
+
+        _otgMutex.lock();
+        const auto sequence = ++_otgSequence;
+        auto& outgoing = _otgBuffers.emplace_back(OutgoingBuffer{this, buffer, sequence, latestOnly, encoding == BufferEncoding::raw});
+        _otgMutex.unlock();
+
+        _otgNumber.fetch_add(1, std::memory_order_acq_rel);
+        if (latestOnly)
+            _otgLatestOnlyNumber.fetch_add(1, std::memory_order_acq_rel);
+
+        zmq::message_t msg(name.size() + 1);
+        memcpy(msg.data(), (void*)name.c_str(), name.size() + 1);
+        socket.send(msg, zmq::send_flags::sndmore);
+
+        msg.rebuild(&encoding, sizeof(encoding));
+        socket.send(msg, zmq::send_flags::sndmore);
+
+        msg.rebuild(bufferPtr->data(), size, Link::freeOlderBuffer, &outgoing);
+        socket.send(msg, zmq::send_flags::none);
+        return sequence;
+    }
+    catch (const zmq::error_t& e)
+    {
+        if (errno != ETERM)
+            Log::get() << Log::WARNING << "Link::" << __FUNCTION__ << " - Exception: " << e.what() << Log::endl;
+    }
+
+    return 0;
+}
+
+/*************/
+uint64_t Link::sendCompressedBuffer(zmq::socket_t& socket, const string& name, const shared_ptr<SerializedObject>& buffer, bool latestOnly)
+{
+    // Latest only buffers are compressed into a buffer kept until sent, so that it is known when they left the queue
+    if (latestOnly)
+    {
+        auto compressedBuffer = make_shared<SerializedObject>(static_cast<int>(snappy::MaxCompressedLength(buffer->size())));
+        size_t compressedSize = 0;
+        snappy::RawCompress(reinterpret_cast<const char*>(buffer->data()), buffer->size(), reinterpret_cast<char*>(compressedBuffer->data()), &compressedSize);
+        return sendBufferWithoutCopy(socket, name, compressedBuffer, compressedSize, BufferEncoding::snappy, true);
+    }
+
+    try
+    {
+        string compressed;
+        snappy::Compress(reinterpret_cast<const char*>(buffer->data()), buffer->size(), &compressed);
+
+        zmq::message_t msg(name.size() + 1);
+        memcpy(msg.data(), (void*)name.c_str(), name.size() + 1);
+        socket.send(msg, zmq::send_flags::sndmore);
+
+        auto encoding = BufferEncoding::snappy;
+        msg.rebuild(&encoding, sizeof(encoding));
+        socket.send(msg, zmq::send_flags::sndmore);
+
+        msg.rebuild(compressed.data(), compressed.size());
+        socket.send(msg, zmq::send_flags::none);
+    }
+    catch (const zmq::error_t& e)
+    {
+        if (errno != ETERM)
+            Log::get() << Log::WARNING << "Link::" << __FUNCTION__ << " - Exception: " << e.what() << Log::endl;
+    }
+
+    return 0;
+}
+
 /*************/
 bool Link::sendBuffer(const string& name, const shared_ptr<BufferObject>& object)
 {
@@ -225,14 +627,15 @@ bool Link::sendBuffer(const string& name, const shared_ptr<BufferObject>& object
 /*************/
 bool Link::sendMessage(const string& name, const string& attribute, const Values& message)
 {
+    TraceSpan span("link_message", attribute);
+
     if (_connectedToInner)
     {
-        for (auto& rootObjectIt : _connectedTargetPointers)
-        {
-            auto rootObject = rootObjectIt.second;
-            if (rootObject)
-                rootObject->set(name, attribute, message);
-        }
+        auto item = make_unique<InnerItem>();
+        item->name = name;
+        item->attribute = attribute;
+        item->values = message;
+        queueInnerItem(std::move(item));
     }
 
     if (_connectedToOuter)
@@ -251,52 +654,10 @@ bool Link::sendMessage(const string& name, const string& attribute, const Values
             memcpy(msg.data(), (void*)attribute.c_str(), attribute.size() + 1);
             _socketMessageOut->send(msg, zmq::send_flags::sndmore);
 
-            // Helper function to send messages
-            std::function<void(const Values& message)> sendMessage;
-            sendMessage = [&](const Values& message) {
-                // Size of the message
-                int size = message.size();
-                msg.rebuild(sizeof(size));
-                memcpy(msg.data(), (void*)&size, sizeof(size));
-
-                if (message.size() == 0)
-                    _socketMessageOut->send(msg, zmq::send_flags::none);
-                else
-                    _socketMessageOut->send(msg, zmq::send_flags::sndmore);
-
-                for (uint32_t i = 0; i < message.size(); ++i)
-                {
-                    auto v = message[i];
-                    Value::Type valueType = v.getType();
-
-                    msg.rebuild(sizeof(valueType));
-                    memcpy(msg.data(), (void*)&valueType, sizeof(valueType));
-                    _socketMessageOut->send(msg, zmq::send_flags::sndmore);
-
-                    std::string valueName = v.getName();
-                    msg.rebuild(valueName.size() + 1);
-                    memcpy(msg.data(), valueName.data(), valueName.size() + 1);
-                    _socketMessageOut->send(msg, zmq::send_flags::sndmore);
-
-                    if (valueType == Value::Type::values)
-                        sendMessage(v.as<Values>());
-                    else
-                    {
-                        int valueSize = (valueType == Value::Type::string) ? v.byte_size() + 1 : v.byte_size();
-                        void* value = v.data();
-                        msg.rebuild(valueSize);
-                        memcpy(msg.data(), value, valueSize);
-
-                        if (i != message.size() - 1)
-                            _socketMessageOut->send(msg, zmq::send_flags::sndmore);
-                        else
-                            _socketMessageOut->send(msg, zmq::send_flags::none);
-                    }
-                }
-            };
-
-            // Send the message
-            sendMessage(message);
+            // Then the whole message, as a single frame
+            msg.rebuild(ValueCodec::getEncodedSize(message));
+            ValueCodec::encode(message, static_cast<uint8_t*>(msg.data()));
+            _socketMessageOut->send(msg, zmq::send_flags::none);
         }
         catch (const zmq::error_t& e)
         {
@@ -315,95 +676,229 @@ bool Link::sendMessage(const string& name, const string& attribute, const Values
 }
 
 /*************/
-void Link::freeOlderBuffer(void* data, void* hint)
+Values Link::sendQuery(const string& peer, const Values& queries, chrono::microseconds timeout)
 {
-    Link* ctx = (Link*)hint;
-    lock_guard<Spinlock> lock(ctx->_otgMutex);
-    uint32_t index = 0;
-    for (; index < ctx->_otgBuffers.size(); ++index)
-        if (ctx->_otgBuffers[index]->data() == data)
-            break;
+    RootObject* innerPeer = nullptr;
+    {
+        lock_guard<mutex> lockInner(_innerPeersMutex);
+        if (auto targetPointerIt = _connectedTargetPointers.find(peer); targetPointerIt != _connectedTargetPointers.end())
+            innerPeer = targetPointerIt->second;
+    }
+    if (innerPeer)
+        return innerPeer->answerQuery(queries);
 
-    if (index >= ctx->_otgBuffers.size())
+    lock_guard<mutex> lock(_queryMutex);
+    auto socketIt = _socketsQueryOut.find(peer);
+    if (socketIt == _socketsQueryOut.end())
     {
-        Log::get() << Log::DEBUGGING << "Link::" << __FUNCTION__ << " - Buffer to free not found in currently sent buffers list" << Log::endl;
-        return;
+        Log::get() << Log::WARNING << "Link::" << __FUNCTION__ << " - Not connected to peer " << peer << Log::endl;
+        return {};
+    }
+
+    try
+    {
+        auto& socket = socketIt->second;
+        int timeoutMs = std::max<int>(1, (timeout.count() + 999) / 1000);
+        socket->setsockopt(ZMQ_RCVTIMEO, &timeoutMs, sizeof(timeoutMs));
+
+        vector<uint8_t> serializedQueries;
+        Serial::serialize(queries, serializedQueries);
+        zmq::message_t msg(serializedQueries.data(), serializedQueries.size());
+        socket->send(msg, zmq::send_flags::none);
+
+        if (!socket->recv(msg, zmq::recv_flags::none))
+        {
+            Log::get() << Log::WARNING << "Link::" << __FUNCTION__ << " - No answer from peer " << peer << " before timeout" << Log::endl;
+            return {};
+        }
+
+        auto dataPtr = static_cast<uint8_t*>(msg.data());
+        return Serial::deserialize<Values>(vector<uint8_t>(dataPtr, dataPtr + msg.size()));
     }
-    ctx->_otgBuffers.erase(ctx->_otgBuffers.begin() + index);
+    catch (const zmq::error_t& e)
+    {
+        if (errno != ETERM)
+            Log::get() << Log::WARNING << "Link::" << __FUNCTION__ << " - Exception: " << e.what() << Log::endl;
+    }
+
+    return {};
+}
+
+/*************/
+void Link::freeOlderBuffer(void* /*data*/, void* hint)
+{
+    // The entry is only removed here, so its link can be read before locking
+    auto queued = static_cast<OutgoingBuffer*>(hint);
+    Link* ctx = queued->link;
+    OutgoingBuffer outgoing;
+
+    {
+        lock_guard<Spinlock> lock(ctx->_otgMutex);
+        auto outgoingIt = find_if(ctx->_otgBuffers.begin(), ctx->_otgBuffers.end(), [queued](const auto& entry) { return &entry == queued; });
+        if (outgoingIt == ctx->_otgBuffers.end())
+        {
+            Log::get() << Log::DEBUGGING << "Link::" << __FUNCTION__ << " - Buffer to free not found in currently sent buffers list" << Log::endl;
+            return;
+        }
+        outgoing = std::move(*outgoingIt);
+        ctx->_otgBuffers.erase(outgoingIt);
+    }
+
+    if (outgoing.latestOnly)
+        ctx->_otgLatestOnlyNumber.fetch_sub(1, std::memory_order_acq_rel);
     ctx->_otgNumber.fetch_sub(1, std::memory_order_acq_rel);
+
+    // Compressed buffers are larger than their content, they are not worth keeping
+    if (outgoing.recyclable)
+        ctx->recycleBuffer(std::move(outgoing.buffer));
+}
+
+/*************/
+void Link::recycleBuffer(shared_ptr<SerializedObject>&& buffer)
+{
+    // Only buffers nobody else holds, and which memory belongs to them, can be reused
+    if (!buffer || buffer.use_count() != 1 || buffer->isAdopted() || buffer->size() == 0)
+        return;
+
+    lock_guard<Spinlock> lock(_bufferPoolMutex);
+    if (_bufferPoolCount >= SPLASH_LINK_BUFFER_POOL_SIZE)
+    {
+        // Make room by dropping a buffer of another size, as buffer sizes change when the inputs do
+        auto size = buffer->size();
+        auto poolIt = find_if(_bufferPool.begin(), _bufferPool.end(), [size](const auto& entry) { return entry.first != size; });
+        if (poolIt == _bufferPool.end())
+            return;
+        poolIt->second.pop_back();
+        if (poolIt->second.empty())
+            _bufferPool.erase(poolIt);
+        --_bufferPoolCount;
+    }
+
+    _bufferPool[buffer->size()].push_back(std::move(buffer));
+    ++_bufferPoolCount;
+}
+
+/*************/
+void Link::queueInnerItem(unique_ptr<InnerItem>&& item)
+{
+    _innerPending.fetch_add(1, std::memory_order_acq_rel);
+    _innerQueuedCount.fetch_add(1, std::memory_order_acq_rel);
+
+    if (_innerOverflowCount.load(std::memory_order_acquire) == 0 && _innerQueue.push(item.get()))
+    {
+        item.release();
+    }
+    else
+    {
+        lock_guard<Spinlock> lock(_innerOverflowMutex);
+        _innerOverflow.push_back(std::move(item));
+        _innerOverflowCount.fetch_add(1, std::memory_order_acq_rel);
+    }
+
+    _innerCondition.notify_one();
+}
+
+/*************/
+void Link::handleInnerItems()
+{
+    TraceRecorder::get().setThreadName(_name + " inner");
+
+    vector<RootObject*> peers{};
+    while (_running)
+    {
+        unique_ptr<InnerItem> item{nullptr};
+        InnerItem* queuedItem = nullptr;
+        if (_innerQueue.pop(queuedItem))
+        {
+            item.reset(queuedItem);
+        }
+        else if (_innerOverflowCount.load(std::memory_order_acquire) != 0)
+        {
+            lock_guard<Spinlock> lock(_innerOverflowMutex);
+            item = std::move(_innerOverflow.front());
+            _innerOverflow.pop_front();
+            _innerOverflowCount.fetch_sub(1, std::memory_order_acq_rel);
+        }
+
+        if (!item)
+        {
+            // The timeout covers a notification sent right before waiting
+            unique_lock<mutex> lock(_innerMutex);
+            _innerCondition.wait_for(lock, chrono::milliseconds(1));
+            continue;
+        }
+
+        {
+            TraceSpan span("link_inner", item->name);
+            lock_guard<mutex> lockDelivery(_innerDeliveryMutex);
+
+            // The peers are delivered to without holding their lock, as the handlers can send through this link
+            peers.clear();
+            {
+                lock_guard<mutex> lock(_innerPeersMutex);
+                for (const auto& [peerName, rootObject] : _connectedTargetPointers)
+                    if (rootObject && (item->peer.empty() || item->peer == peerName))
+                        peers.push_back(rootObject);
+            }
+
+            for (auto rootObject : peers)
+            {
+                if (item->attribute.empty())
+                    rootObject->setFromSerializedObject(item->name, item->buffer);
+                else
+                    rootObject->set(item->name, item->attribute, item->values);
+            }
+        }
+
+        _innerPending.fetch_sub(1, std::memory_order_acq_rel);
+        _innerDeliveredCount.fetch_add(1, std::memory_order_acq_rel);
+        _innerDeliveredCondition.notify_all();
+    }
 }
 
 /*************/
 void Link::handleInputMessages()
 {
+    TraceRecorder::get().setThreadName(_name + " messages");
+
     try
     {
         // We don't want to miss a message: set the high water mark to a high value
         int hwm = 1000;
         _socketMessageIn->setsockopt(ZMQ_RCVHWM, &hwm, sizeof(hwm));
 
-        _socketMessageIn->bind((_basePath + "msg_" + _name).c_str());
+        // Block on reception so that messages, and answers in particular, are handled as soon as they arrive
+        int timeout = SPLASH_LINK_RECEIVE_TIMEOUT;
+        _socketMessageIn->setsockopt(ZMQ_RCVTIMEO, &timeout, sizeof(timeout));
+
+        _socketMessageIn->bind(getEndpoint(_name, "msg", "").c_str());
+        if (!_tcpAddress.empty())
+            _socketMessageIn->bind(getEndpoint(_name, "msg", _tcpAddress).c_str());
         _socketMessageIn->setsockopt(ZMQ_SUBSCRIBE, NULL, 0); // We subscribe to all incoming messages
 
-        // Helper function to receive messages
         zmq::message_t msg;
-        std::function<Values(void)> recvMessage;
-        recvMessage = [&]() -> Values {
-            auto result = _socketMessageIn->recv(msg, zmq::recv_flags::none); // size of the message
-            if (!result)
-                return {};
-            size_t size = *(static_cast<int*>(msg.data()));
-
-            Values values;
-            for (size_t i = 0; i < size; ++i)
-            {
-                if (!_socketMessageIn->recv(msg, zmq::recv_flags::none))
-                    return {};
-                Value::Type valueType = *(Value::Type*)msg.data();
-
-                if (!_socketMessageIn->recv(msg, zmq::recv_flags::none))
-                    return {};
-                string valueName(static_cast<char*>(msg.data()));
-
-                if (valueType == Value::Type::values)
-                {
-                    values.push_back(recvMessage());
-                }
-                else
-                {
-                    if (!_socketMessageIn->recv(msg, zmq::recv_flags::none))
-                        return {};
-
-                    if (valueType == Value::Type::boolean)
-                        values.push_back(*(bool*)msg.data());
-                    else if (valueType == Value::Type::integer)
-                        values.push_back(*(int64_t*)msg.data());
-                    else if (valueType == Value::Type::real)
-                        values.push_back(*(double*)msg.data());
-                    else if (valueType == Value::Type::string)
-                        values.push_back(string((char*)msg.data()));
-                }
-
-                if (!valueName.empty())
-                    values.back().setName(valueName);
-            }
-            return values;
-        };
-
         while (_running)
         {
-            if (!_socketMessageIn->recv(msg, zmq::recv_flags::dontwait)) // name of the target
-            {
-                std::this_thread::sleep_for(1ms);
+            if (!Utils::applyThreadClass(Utils::ThreadClass::network))
+                Log::get() << Log::WARNING << "Link::" << __FUNCTION__ << " - Unable to apply the scheduling of the network threads" << Log::endl;
+
+            if (!_socketMessageIn->recv(msg, zmq::recv_flags::none)) // name of the target
                 continue;
-            }
             string name((char*)msg.data());
             if (!_socketMessageIn->recv(msg, zmq::recv_flags::none)) // target's attribute
                 return;
 
             string attribute((char*)msg.data());
 
-            Values values = recvMessage();
+            // The values are decoded straight from the received frame
+            if (!_socketMessageIn->recv(msg, zmq::recv_flags::none))
+                return;
+            Values values;
+            if (!ValueCodec::decode(static_cast<const uint8_t*>(msg.data()), msg.size(), values))
+            {
+                Log::get() << Log::WARNING << "Link::" << __FUNCTION__ << " - Received malformed values for " << name << "::" << attribute << Log::endl;
+                continue;
+            }
 
             if (_rootObject)
                 _rootObject->set(name, attribute, values);
@@ -422,35 +917,158 @@ void Link::handleInputMessages()
     }
 }
 
+/*************/
+bool Link::receiveShmBuffer()
+{
+    zmq::message_t msg;
+    if (!_socketShmIn->recv(msg, zmq::recv_flags::dontwait))
+        return false;
+    string name((char*)msg.data());
+    TraceSpan span("link_receive", name);
+
+    if (!_socketShmIn->recv(msg, zmq::recv_flags::none))
+        return true;
+    string peer((char*)msg.data());
+
+    if (!_socketShmIn->recv(msg, zmq::recv_flags::none) || msg.size() != sizeof(ShmRing::Descriptor))
+        return true;
+    ShmRing::Descriptor descriptor;
+    memcpy(&descriptor, msg.data(), sizeof(ShmRing::Descriptor));
+
+    auto& reader = _shmRingReaders[peer];
+    if (!reader)
+        reader = make_unique<ShmRingReader>(_shmBasePath + peer, _name);
+
+    auto buffer = reader->adopt(descriptor);
+    if (buffer && _rootObject)
+        _rootObject->setFromSerializedObject(name, buffer);
+
+    return true;
+}
+
+/*************/
+bool Link::receiveBuffer(zmq::socket_t& socket)
+{
+    zmq::message_t msg;
+    if (!socket.recv(msg, zmq::recv_flags::dontwait))
+        return false;
+    string name((char*)msg.data());
+    TraceSpan span("link_receive", name);
+
+    if (!socket.recv(msg, zmq::recv_flags::none) || msg.size() != sizeof(BufferEncoding))
+        return true;
+    auto encoding = *static_cast<BufferEncoding*>(msg.data());
+
+    if (!socket.recv(msg, zmq::recv_flags::none))
+        return true;
+
+    shared_ptr<SerializedObject> buffer;
+    if (encoding == BufferEncoding::snappy)
+    {
+        auto compressed = static_cast<const char*>(msg.data());
+        size_t uncompressedSize = 0;
+        if (!snappy::GetUncompressedLength(compressed, msg.size(), &uncompressedSize))
+            return true;
+        buffer = make_shared<SerializedObject>(uncompressedSize);
+        if (!snappy::RawUncompress(compressed, msg.size(), reinterpret_cast<char*>(buffer->data())))
+        {
+            Log::get() << Log::WARNING << "Link::" << __FUNCTION__ << " - Unable to uncompress buffer " << name << Log::endl;
+            return true;
+        }
+    }
+    else
+    {
+        buffer = make_shared<SerializedObject>(static_cast<uint8_t*>(msg.data()), static_cast<uint8_t*>(msg.data()) + msg.size());
+    }
+
+    if (_rootObject)
+        _rootObject->setFromSerializedObject(name, buffer);
+
+    return true;
+}
+
 /*************/
 void Link::handleInputBuffers()
 {
+    TraceRecorder::get().setThreadName(_name + " buffers");
+
     try
     {
         // We only keep one buffer in memory while processing
         int hwm = 1;
         _socketBufferIn->setsockopt(ZMQ_RCVHWM, &hwm, sizeof(hwm));
 
-        _socketBufferIn->bind((_basePath + "buf_" + _name).c_str());
+        // Shared memory descriptors must not be dropped, otherwise the slots they hold are never released
+        int shmHwm = 0;
+        _socketShmIn->setsockopt(ZMQ_RCVHWM, &shmHwm, sizeof(shmHwm));
+
+        _socketBufferIn->bind(getEndpoint(_name, "buf", "").c_str());
+        if (!_tcpAddress.empty())
+            _socketBufferIn->bind(getEndpoint(_name, "buf", _tcpAddress).c_str());
+        if (_socketBufferMulticastOut)
+        {
+            int rate = SPLASH_LINK_MULTICAST_RATE;
+            _socketBufferIn->setsockopt(ZMQ_RATE, &rate, sizeof(rate));
+            _socketBufferIn->connect(("epgm://" + _multicastAddress).c_str());
+        }
         _socketBufferIn->setsockopt(ZMQ_SUBSCRIBE, NULL, 0); // We subscribe to all incoming messages
+        _socketShmIn->bind(getEndpoint(_name, "shm", "").c_str());
+        _socketShmIn->setsockopt(ZMQ_SUBSCRIBE, NULL, 0);
+
+        // Buffers sent to this peer only, like image tiles
+        _socketBufferDirectIn->bind(getEndpoint(_name, "bfd", "").c_str());
+        if (!_tcpAddress.empty())
+            _socketBufferDirectIn->bind(getEndpoint(_name, "bfd", _tcpAddress).c_str());
 
         while (_running)
         {
-            zmq::message_t msg;
+            if (!Utils::applyThreadClass(Utils::ThreadClass::network))
+                Log::get() << Log::WARNING << "Link::" << __FUNCTION__ << " - Unable to apply the scheduling of the network threads" << Log::endl;
 
-            if (!_socketBufferIn->recv(msg, zmq::recv_flags::dontwait))
-            {
+            auto bufferReceived = receiveShmBuffer();
+            bufferReceived = receiveBuffer(*_socketBufferIn) || bufferReceived;
+            bufferReceived = receiveBuffer(*_socketBufferDirectIn) || bufferReceived;
+
+            if (!bufferReceived)
                 std::this_thread::sleep_for(1ms);
-                continue;
-            }
-            string name((char*)msg.data());
+        }
+    }
+    catch (const zmq::error_t& e)
+    {
+        if (errno != ETERM)
+            Log::get() << Log::WARNING << "Link::" << __FUNCTION__ << " - Exception: " << e.what() << Log::endl;
+    }
+}
+
+/*************/
+void Link::handleInputQueries()
+{
+    try
+    {
+        int timeout = SPLASH_LINK_RECEIVE_TIMEOUT;
+        _socketQueryIn->setsockopt(ZMQ_RCVTIMEO, &timeout, sizeof(timeout));
+        _socketQueryIn->bind(getEndpoint(_name, "qry", "").c_str());
+        if (!_tcpAddress.empty())
+            _socketQueryIn->bind(getEndpoint(_name, "qry", _tcpAddress).c_str());
+
+        while (_running)
+        {
+            if (!Utils::applyThreadClass(Utils::ThreadClass::network))
+                Log::get() << Log::WARNING << "Link::" << __FUNCTION__ << " - Unable to apply the scheduling of the network threads" << Log::endl;
 
-            if (!_socketBufferIn->recv(msg, zmq::recv_flags::none))
+            zmq::message_t msg;
+            if (!_socketQueryIn->recv(msg, zmq::recv_flags::none))
                 continue;
-            auto buffer = make_shared<SerializedObject>(static_cast<uint8_t*>(msg.data()), static_cast<uint8_t*>(msg.data()) + msg.size());
 
-            if (_rootObject)
-                _rootObject->setFromSerializedObject(name, buffer);
+            auto dataPtr = static_cast<uint8_t*>(msg.data());
+            auto queries = Serial::deserialize<Values>(vector<uint8_t>(dataPtr, dataPtr + msg.size()));
+            auto answers = _rootObject ? _rootObject->answerQuery(queries) : Values();
+
+            // A reply must be sent for each request, even if empty
+            vector<uint8_t> serializedAnswers;
+            Serial::serialize(answers, serializedAnswers);
+            msg.rebuild(serializedAnswers.data(), serializedAnswers.size());
+            _socketQueryIn->send(msg, zmq::send_flags::none);
         }
     }
     catch (const zmq::error_t& e)
@@ -25,21 +25,31 @@
 #ifndef SPLASH_LINK_H
 #define SPLASH_LINK_H
 
+#include <array>
 #include <atomic>
 #include <chrono>
+#include <condition_variable>
 #include <deque>
+#include <list>
 #include <map>
+#include <memory>
 #include <mutex>
 #include <string>
 #include <thread>
+#include <unordered_map>
 #include <vector>
 #include <zmq.hpp>
 
 #include "./core/constants.h"
 
 #include "./core/serialized_object.h"
+#include "./core/shm_ring.h"
 #include "./core/spinlock.h"
 #include "./core/value.h"
+#include "./utils/mpsc_ring.h"
+
+// Capacity of the queue of messages and buffers for the peers in the same process
+#define SPLASH_LINK_INNER_QUEUE_SIZE 1024
 
 namespace Splash
 {
@@ -50,6 +60,14 @@ class BufferObject;
 /*************/
 class Link
 {
+  public:
+    //! Queuing policy for the buffers sent to the peers
+    enum class BufferPolicy : uint8_t
+    {
+        lossless,  //!< Every buffer is delivered, like still images or meshes
+        latestOnly //!< Only the freshest buffer matters, like frames from live sources
+    };
+
   public:
     /**
      * \brief Constructor
@@ -66,11 +84,14 @@ class Link
     /**
      * \brief Connect to a pair given its name
      * \param name Peer name
+     * \param address TCP address of the peer as host:port if it runs on another host, empty for a peer on the same host
      */
-    void connectTo(const std::string& name);
+    void connectTo(const std::string& name, const std::string& address = "");
 
     /**
-     * \brief Connect to a pair given its name and a shared_ptr, useful when the peer is an object of _root
+     * \brief Connect to a pair given its name and a pointer, for a peer living in the same process
+     * Messages and buffers are then passed by pointer through a lock-free queue, and delivered by a
+     * dedicated thread so that the sender never runs the peer's handlers. Queries are answered directly.
      * \param name Peer name
      * \param peer Pointer to an inner peer
      */
@@ -78,16 +99,29 @@ class Link
 
     /**
      * \brief Disconnect from a pair given its name
+     * Items already queued for a peer in the same process are delivered before it is disconnected
      * \param name Peer name
      */
     void disconnectFrom(const std::string& name);
 
+    /**
+     * \brief Get a buffer suitable for sending through the link
+     * If peers in other processes are connected, the buffer is allocated in shared memory
+     * so that it can be sent to them without being copied. Otherwise a previously sent buffer
+     * of the same size is reused if available
+     * \param size Buffer size
+     * \return Return the buffer
+     */
+    std::shared_ptr<SerializedObject> allocateBuffer(size_t size);
+
     /**
      * \brief Send a buffer to the connected peers
      * \param name Buffer name
      * \param buffer Serialized buffer
+     * \param policy Queuing policy, latest only buffers being dropped while the previous one is still queued
+     * \return Return false if the buffer has been dropped
      */
-    bool sendBuffer(const std::string& name, std::shared_ptr<SerializedObject> buffer);
+    bool sendBuffer(const std::string& name, std::shared_ptr<SerializedObject> buffer, BufferPolicy policy = BufferPolicy::lossless);
 
     /**
      * \brief Send a buffer to the connected peers
@@ -96,6 +130,17 @@ class Link
      */
     bool sendBuffer(const std::string& name, const std::shared_ptr<BufferObject>& object);
 
+    /**
+     * \brief Send a buffer to a single peer, through a channel dedicated to this peer
+     * This is meant for buffers which differ from one peer to another, like image tiles
+     * \param peer Peer name
+     * \param name Buffer name
+     * \param buffer Serialized buffer
+     * \param policy Queuing policy, latest only buffers being dropped while the previous one is still queued
+     * \return Return true if the buffer has been sent
+     */
+    bool sendBufferTo(const std::string& peer, const std::string& name, std::shared_ptr<SerializedObject> buffer, BufferPolicy policy = BufferPolicy::lossless);
+
     /**
      * \brief Send a message to connected peers
      * \param name Destination object name
@@ -116,15 +161,77 @@ class Link
     bool sendMessage(const std::string& name, const std::string& attribute, const std::vector<T>& message);
 
     /**
-     * \brief Check that all buffers were sent to the client
+     * \brief Send a batch of queries to a peer, and wait for its answer
+     * Queries go through a dedicated request / reply channel, which is answered by the
+     * peer's link thread as soon as it is received, without waiting for the peer main loop.
+     * \param peer Peer name
+     * \param queries Queries, each one being a Values holding an object name and an attribute name
+     * \param timeout Maximum waiting time
+     * \return Return the answers, in the same order as the queries, or an empty Values if the peer did not answer in time
+     */
+    Values sendQuery(const std::string& peer, const Values& queries, std::chrono::microseconds timeout);
+
+    /**
+     * \brief Check that all lossless buffers were sent to the client
+     * Latest only buffers are not waited for, as a slow peer drops them instead of delaying the others
      * \param maximumWait Maximum waiting time
      * \return Return true if all went well
      */
     bool waitForBufferSending(std::chrono::milliseconds maximumWait);
 
+    /**
+     * \brief Get the number of buffers sent but not yet released by the transport
+     * \return Return the outgoing queue depth
+     */
+    int getPendingBufferCount() const { return _otgNumber.load(std::memory_order_acquire); }
+
+    /**
+     * \brief Get the number of latest only buffers dropped because the previous one was still queued
+     * \return Return the number of dropped buffers since the creation of the link
+     */
+    int64_t getDroppedBufferCount() const { return _droppedBufferCount.load(std::memory_order_acquire); }
+
+  private:
+    //! Buffer sent without copy, kept until the transport releases it
+    struct OutgoingBuffer
+    {
+        Link* link{nullptr}; //!< Link which queued the buffer, for the transport release callback
+        std::shared_ptr<SerializedObject> buffer{nullptr};
+        uint64_t sequence{0}; //!< Number of the send, as buffers from the pool are reused for other names
+        bool latestOnly{false};
+        bool recyclable{true};
+    };
+
+    //! Sends of the last latest only buffer sent under a given key, to check whether it is still queued
+    //! A buffer can be queued twice, to the multicast group and to the local peers
+    struct LatestBuffer
+    {
+        std::array<uint64_t, 2> sequences{0, 0};
+    };
+
+    //! Message or buffer for peers in the same process, waiting to be delivered
+    struct InnerItem
+    {
+        std::string peer{""};                              //!< Peer name, or empty for all the inner peers
+        std::string name{""};                              //!< Target object name, or buffer name
+        std::string attribute{""};                         //!< Target attribute, empty for a buffer
+        Values values{};                                   //!< Message
+        std::shared_ptr<SerializedObject> buffer{nullptr}; //!< Buffer
+    };
+
+    //! Encoding of the buffers sent through ZMQ
+    enum class BufferEncoding : uint8_t
+    {
+        raw,
+        snappy
+    };
+
   private:
     RootObject* _rootObject;
     std::string _basePath{""};
+    std::string _shmBasePath{""};
+    std::string _tcpAddress{""};       //!< TCP address to listen on as host:port, in addition to the local sockets
+    std::string _multicastAddress{""}; //!< PGM multicast address as interface;group:port, used for the buffers exchanged with peers on other hosts
     std::string _name{""};
 
     std::unique_ptr<zmq::context_t> _context;
@@ -132,31 +239,137 @@ class Link
     std::unique_ptr<zmq::socket_t> _socketBufferOut;
     std::unique_ptr<zmq::socket_t> _socketMessageIn;
     std::unique_ptr<zmq::socket_t> _socketMessageOut;
+    std::unique_ptr<zmq::socket_t> _socketShmIn;
+    std::unique_ptr<zmq::socket_t> _socketShmOut;
+    std::unique_ptr<zmq::socket_t> _socketBufferMulticastOut{nullptr};
+    std::unique_ptr<zmq::socket_t> _socketQueryIn;
+    std::unique_ptr<zmq::socket_t> _socketBufferDirectIn;
+    std::map<std::string, std::unique_ptr<zmq::socket_t>> _socketsBufferDirectOut{}; //!< Buffer sockets dedicated to each peer, by peer name
+    std::map<std::string, std::unique_ptr<zmq::socket_t>> _socketsQueryOut{}; //!< Query sockets, by peer name
+    std::mutex _queryMutex{};
+
+    std::unique_ptr<ShmRing> _shmRing{nullptr};                              //!< Shared memory slots for outgoing buffers
+    std::map<std::string, std::unique_ptr<ShmRingReader>> _shmRingReaders{}; //!< Shared memory rings of the peers, by peer name
 
     std::vector<std::string> _connectedTargets;
     std::map<std::string, RootObject*> _connectedTargetPointers;
+    std::mutex _innerPeersMutex{};    //!< Protects _connectedTargetPointers
+    std::mutex _innerDeliveryMutex{}; //!< Held while delivering an item, so that a disconnected peer is not used anymore once it is taken
+    std::map<std::string, std::string> _targetAddresses{}; //!< TCP addresses of the peers running on other hosts
 
     bool _connectedToInner{false};
     bool _connectedToOuter{false};
+    std::atomic_bool _connectedToRemote{false}; //!< True if connected to peers on other hosts, which cannot read the shared memory
     bool _running{false};
 
     Spinlock _msgSendMutex;
     Spinlock _bufferSendMutex;
 
-    std::deque<std::shared_ptr<SerializedObject>> _otgBuffers;
+    std::list<OutgoingBuffer> _otgBuffers; //!< A list, as each entry is given to the transport to be released once sent
     Spinlock _otgMutex;
+    uint64_t _otgSequence{0}; //!< Number of the last buffer sent without copy, protected by _otgMutex
     std::atomic_int _otgNumber{0};
+    std::atomic_int _otgLatestOnlyNumber{0};                        //!< Number of latest only buffers among the outgoing ones
+    std::unordered_map<std::string, LatestBuffer> _latestBuffers{}; //!< Last latest only buffers sent, by name, protected by _bufferSendMutex
+    std::atomic<int64_t> _droppedBufferCount{0};                    //!< Number of latest only buffers dropped
+
+    std::map<size_t, std::vector<std::shared_ptr<SerializedObject>>> _bufferPool{}; //!< Sent buffers kept for reuse, by size
+    size_t _bufferPoolCount{0};                                                    //!< Number of buffers in the pool
+    Spinlock _bufferPoolMutex;
+
+    MpscRing<InnerItem*> _innerQueue{SPLASH_LINK_INNER_QUEUE_SIZE}; //!< Items for the inner peers, owned by the queue until popped
+    std::deque<std::unique_ptr<InnerItem>> _innerOverflow{};         //!< Items which did not fit in the queue, delivered after it
+    Spinlock _innerOverflowMutex;
+    std::atomic_int _innerOverflowCount{0}; //!< Number of items in _innerOverflow
+    std::atomic_int _innerPending{0};       //!< Number of items not yet delivered to the inner peers
+    std::atomic<uint64_t> _innerQueuedCount{0};    //!< Number of items queued since the creation of the link
+    std::atomic<uint64_t> _innerDeliveredCount{0}; //!< Number of items delivered since the creation of the link
+    std::mutex _innerMutex{};
+    std::condition_variable _innerCondition{};
+    std::condition_variable _innerDeliveredCondition{}; //!< Signaled each time an item is delivered, used with _innerMutex
 
     std::thread _bufferInThread;
     std::thread _messageInThread;
+    std::thread _queryInThread;
+    std::thread _innerThread;
+
+    /**
+     * \brief Get the endpoint of one of the channels of a peer, or of this link
+     * Local channels go through IPC. Over TCP, the messages, buffers, queries and direct buffers use consecutive ports
+     * starting from the one in the address, and the shared memory channel is not available.
+     * \param name Peer name
+     * \param channel Channel, one of "msg", "buf", "shm", "qry" or "bfd"
+     * \param address TCP address as host:port, or empty for a local endpoint
+     * \return Return the endpoint, or an empty string if the channel is not available at this address
+     */
+    std::string getEndpoint(const std::string& name, const std::string& channel, const std::string& address) const;
+
+    /**
+     * \brief Compress a buffer and send it through the given socket
+     * \param socket Buffer socket
+     * \param name Buffer name
+     * \param buffer Serialized buffer
+     * \param latestOnly True if the buffer follows the latest only policy, in which case the compressed buffer is kept until sent
+     * \return Return the sequence number of the queued buffer, or 0 if the transport copied it
+     */
+    uint64_t sendCompressedBuffer(zmq::socket_t& socket, const std::string& name, const std::shared_ptr<SerializedObject>& buffer, bool latestOnly = false);
+
+    /**
+     * \brief Send a buffer through the given socket without copying it, the buffer being kept until it has been sent
+     * \param socket Buffer socket
+     * \param name Buffer name
+     * \param buffer Serialized buffer
+     * \param latestOnly True if the buffer follows the latest only policy
+     * \return Return the sequence number of the queued buffer, or 0 if sending failed
+     */
+    uint64_t sendRawBuffer(zmq::socket_t& socket, const std::string& name, const std::shared_ptr<SerializedObject>& buffer, bool latestOnly = false);
+
+    /**
+     * \brief Send the start of a buffer through the given socket without copying it, the buffer being kept until it has been sent
+     * \param socket Buffer socket
+     * \param name Buffer name
+     * \param buffer Buffer holding the data
+     * \param size Number of bytes to send
+     * \param encoding Encoding of the data
+     * \param latestOnly True if the buffer follows the latest only policy
+     * \return Return the sequence number of the queued buffer, or 0 if sending failed
+     */
+    uint64_t sendBufferWithoutCopy(
+        zmq::socket_t& socket, const std::string& name, const std::shared_ptr<SerializedObject>& buffer, size_t size, BufferEncoding encoding, bool latestOnly);
+
+    /**
+     * \brief Check whether the last latest only buffer sent under the given key is still queued
+     * Must be called with _bufferSendMutex locked
+     * \param key Buffer key
+     * \return Return true if the buffer is still queued
+     */
+    bool isLatestBufferQueued(const std::string& key);
 
     /**
      * \brief Callback to remove the shared_ptr to a sent buffer
      * \param data Pointer to sent data
-     * \param hint Pointer to the Link
+     * \param hint Pointer to the queued OutgoingBuffer, as the same buffer can be queued more than once
      */
     static void freeOlderBuffer(void* data, void* hint);
 
+    /**
+     * \brief Keep a buffer which is not used anymore, to be returned by a later call to allocateBuffer
+     * \param buffer Buffer to recycle
+     */
+    void recycleBuffer(std::shared_ptr<SerializedObject>&& buffer);
+
+    /**
+     * \brief Queue an item for the inner peers
+     * Items only go to the overflow queue when the lock-free one is full, and stay there until it is empty to keep their order
+     * \param item Item to queue
+     */
+    void queueInnerItem(std::unique_ptr<InnerItem>&& item);
+
+    /**
+     * \brief Inner peers delivery thread function
+     */
+    void handleInnerItems();
+
     /**
      * \brief Message input thread function
      */
@@ -166,6 +379,24 @@ class Link
      * \brief Buffer input thread function
      */
     void handleInputBuffers();
+
+    /**
+     * \brief Query input thread function
+     */
+    void handleInputQueries();
+
+    /**
+     * \brief Receive a buffer descriptor from the shared memory socket, and adopt the corresponding buffer
+     * \return Return true if a descriptor has been received
+     */
+    bool receiveShmBuffer();
+
+    /**
+     * \brief Receive a buffer from one of the buffer sockets, if one is waiting
+     * \param socket Buffer socket
+     * \return Return true if a buffer has been received
+     */
+    bool receiveBuffer(zmq::socket_t& socket);
 };
 
 /*************/
@@ -0,0 +1,259 @@
+#include "./core/metrics_exporter.h"
+
+#include <cctype>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <netdb.h>
+#include <sstream>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "./utils/log.h"
+
+// Maximum size of a StatsD datagram, kept below the usual path MTU
+#define SPLASH_METRICS_STATSD_DATAGRAM_SIZE 1400
+
+using namespace std;
+
+namespace Splash
+{
+
+namespace
+{
+//! Prometheus metric name, help and label name for each exported group
+struct GroupDescription
+{
+    const char* metric;
+    const char* help;
+    const char* label;
+};
+
+const map<string, GroupDescription> exportedGroups{
+    {"durations", {"splash_duration_microseconds", "Duration measured by the Timer probes", "timer"}},
+    {"gpu", {"splash_gpu_time_microseconds", "GPU time of the rendered objects", "object"}},
+    {"stats", {"splash_statistic", "Counters and queue depths", "statistic"}},
+};
+
+/*************/
+string sanitizeName(const string& name)
+{
+    auto sanitized = name;
+    for (auto& c : sanitized)
+        if (!isalnum(static_cast<unsigned char>(c)) && c != '_')
+            c = '_';
+    return sanitized;
+}
+
+/*************/
+string escapeLabelValue(const string& value)
+{
+    string escaped;
+    escaped.reserve(value.size());
+    for (auto c : value)
+    {
+        if (c == '\\' || c == '"')
+            escaped += '\\';
+        if (c == '\n')
+        {
+            escaped += "\\n";
+            continue;
+        }
+        escaped += c;
+    }
+    return escaped;
+}
+} // namespace
+
+/*************/
+MetricsExporter::~MetricsExporter()
+{
+    closeStatsdSocket();
+}
+
+/*************/
+vector<MetricsExporter::Sample> MetricsExporter::collect(const Tree::Root& tree)
+{
+    vector<Sample> samples;
+    for (const auto& root : tree.getBranchListAt("/"))
+    {
+        for (const auto& group : exportedGroups)
+        {
+            auto groupPath = "/" + root + "/" + group.first;
+            if (!tree.hasBranchAt(groupPath))
+                continue;
+
+            for (const auto& leafName : tree.getLeafListAt(groupPath))
+            {
+                Value value;
+                if (!tree.getValueForLeafAt(groupPath + "/" + leafName, value))
+                    continue;
+                if (value.getType() == Value::Type::values)
+                {
+                    if (value.size() == 0)
+                        continue;
+                    value = value[0];
+                }
+
+                auto type = value.getType();
+                if (type != Value::Type::integer && type != Value::Type::real && type != Value::Type::boolean)
+                    continue;
+
+                samples.push_back({root, group.first, leafName, value.as<double>()});
+            }
+        }
+    }
+
+    return samples;
+}
+
+/*************/
+string MetricsExporter::formatPrometheus(const vector<Sample>& samples)
+{
+    ostringstream stream;
+    stream.precision(15);
+
+    // Prometheus expects all the samples of a metric to be grouped below its description
+    for (const auto& [groupName, group] : exportedGroups)
+    {
+        bool described = false;
+        for (const auto& sample : samples)
+        {
+            if (sample.group != groupName)
+                continue;
+
+            if (!described)
+            {
+                stream << "# HELP " << group.metric << " " << group.help << "\n";
+                stream << "# TYPE " << group.metric << " gauge\n";
+                described = true;
+            }
+
+            stream << group.metric << "{root=\"" << escapeLabelValue(sample.root) << "\"," << group.label << "=\"" << escapeLabelValue(sample.name) << "\"} " << sample.value
+                   << "\n";
+        }
+    }
+
+    return stream.str();
+}
+
+/*************/
+vector<string> MetricsExporter::formatStatsd(const vector<Sample>& samples)
+{
+    vector<string> lines;
+    lines.reserve(samples.size());
+    for (const auto& sample : samples)
+    {
+        ostringstream stream;
+        stream.precision(15);
+        stream << "splash." << sanitizeName(sample.root) << "." << sample.group << "." << sanitizeName(sample.name) << ":" << sample.value << "|g";
+        lines.push_back(stream.str());
+    }
+    return lines;
+}
+
+/*************/
+bool MetricsExporter::setStatsdAddress(const string& address)
+{
+    closeStatsdSocket();
+    _statsdAddress = address;
+    if (address.empty())
+        return true;
+
+    auto separator = address.rfind(':');
+    if (separator == string::npos || separator == 0 || separator == address.size() - 1)
+    {
+        Log::get() << Log::WARNING << "MetricsExporter::" << __FUNCTION__ << " - StatsD address must be given as host:port, got " << address << Log::endl;
+        return false;
+    }
+
+    auto host = address.substr(0, separator);
+    auto port = address.substr(separator + 1);
+
+    addrinfo hints{};
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_DGRAM;
+    addrinfo* result = nullptr;
+    if (auto status = getaddrinfo(host.c_str(), port.c_str(), &hints, &result); status != 0)
+    {
+        Log::get() << Log::WARNING << "MetricsExporter::" << __FUNCTION__ << " - Unable to resolve " << address << ": " << string(gai_strerror(status)) << Log::endl;
+        return false;
+    }
+
+    for (auto info = result; info != nullptr; info = info->ai_next)
+    {
+        _statsdSocket = socket(info->ai_family, info->ai_socktype, info->ai_protocol);
+        if (_statsdSocket < 0)
+            continue;
+
+        memcpy(&_statsdSocketAddress, info->ai_addr, info->ai_addrlen);
+        _statsdSocketAddressLength = info->ai_addrlen;
+        break;
+    }
+    freeaddrinfo(result);
+
+    if (_statsdSocket < 0)
+    {
+        Log::get() << Log::WARNING << "MetricsExporter::" << __FUNCTION__ << " - Unable to create a socket for " << address << Log::endl;
+        return false;
+    }
+
+    return true;
+}
+
+/*************/
+void MetricsExporter::closeStatsdSocket()
+{
+    if (_statsdSocket >= 0)
+        close(_statsdSocket);
+    _statsdSocket = -1;
+    _statsdSocketAddressLength = 0;
+}
+
+/*************/
+void MetricsExporter::exportMetrics(const Tree::Root& tree)
+{
+    if (!isEnabled())
+        return;
+
+    auto samples = collect(tree);
+
+    if (!_prometheusPath.empty())
+    {
+        // Written aside then renamed, so that the collector never reads a partial file
+        auto temporaryPath = _prometheusPath + ".tmp";
+        {
+            ofstream file(temporaryPath, ios::out | ios::trunc);
+            if (file.is_open())
+                file << formatPrometheus(samples);
+        }
+        if (rename(temporaryPath.c_str(), _prometheusPath.c_str()) != 0)
+            Log::get() << Log::WARNING << "MetricsExporter::" << __FUNCTION__ << " - Unable to write metrics to " << _prometheusPath << ": " << string(strerror(errno))
+                       << Log::endl;
+    }
+
+    if (_statsdSocket >= 0)
+    {
+        // Lines are packed into datagrams, StatsD servers split them on line feeds
+        string datagram;
+        auto sendDatagram = [&]() {
+            if (datagram.empty())
+                return;
+            sendto(_statsdSocket, datagram.data(), datagram.size(), MSG_DONTWAIT, reinterpret_cast<const sockaddr*>(&_statsdSocketAddress), _statsdSocketAddressLength);
+            datagram.clear();
+        };
+
+        for (const auto& line : formatStatsd(samples))
+        {
+            if (!datagram.empty() && datagram.size() + line.size() + 1 > SPLASH_METRICS_STATSD_DATAGRAM_SIZE)
+                sendDatagram();
+            if (!datagram.empty())
+                datagram += '\n';
+            datagram += line;
+        }
+        sendDatagram();
+    }
+}
+
+} // namespace Splash
@@ -0,0 +1,131 @@
+/*
+ * Copyright (C) 2026 Emmanuel Durand
+ *
+ * This file is part of Splash.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Splash is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Splash.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * @metrics_exporter.h
+ * Export of the durations and statistics held in the tree, for monitoring systems
+ */
+
+#ifndef SPLASH_METRICS_EXPORTER_H
+#define SPLASH_METRICS_EXPORTER_H
+
+#include <string>
+#include <vector>
+
+#include <netinet/in.h>
+
+#include "./core/tree.h"
+
+namespace Splash
+{
+
+/*************/
+//! Periodic export of the durations, statistics and GPU times of the World and of every Scene
+//! Metrics are read from the tree, which holds a branch per root object. They can be written
+//! in the Prometheus text format to a file, to be picked up by the node exporter textfile
+//! collector, and / or sent as StatsD gauges over UDP.
+class MetricsExporter
+{
+  public:
+    struct Sample
+    {
+        std::string root{};  //!< Root object name, "world" or a Scene name
+        std::string group{}; //!< Branch holding the metric: durations, stats or gpu
+        std::string name{};  //!< Leaf name
+        double value{0.0};
+    };
+
+  public:
+    /**
+     * \brief Constructor
+     */
+    MetricsExporter() = default;
+
+    /**
+     * \brief Destructor
+     */
+    ~MetricsExporter();
+
+    MetricsExporter(const MetricsExporter&) = delete;
+    MetricsExporter& operator=(const MetricsExporter&) = delete;
+
+    /**
+     * \brief Gather the metrics from the tree
+     * \param tree Tree to read from
+     * \return Return the samples, sorted by root object then by group
+     */
+    static std::vector<Sample> collect(const Tree::Root& tree);
+
+    /**
+     * \brief Format the samples in the Prometheus text exposition format
+     * \param samples Samples
+     * \return Return the formatted metrics
+     */
+    static std::string formatPrometheus(const std::vector<Sample>& samples);
+
+    /**
+     * \brief Format the samples as StatsD gauges
+     * \param samples Samples
+     * \return Return one line per sample
+     */
+    static std::vector<std::string> formatStatsd(const std::vector<Sample>& samples);
+
+    /**
+     * \brief Set the path of the file to write the Prometheus metrics to
+     * \param path File path, empty to disable
+     */
+    void setPrometheusPath(const std::string& path) { _prometheusPath = path; }
+    std::string getPrometheusPath() const { return _prometheusPath; }
+
+    /**
+     * \brief Set the address of the StatsD server
+     * \param address Address as host:port, empty to disable
+     * \return Return false if the address could not be resolved
+     */
+    bool setStatsdAddress(const std::string& address);
+    std::string getStatsdAddress() const { return _statsdAddress; }
+
+    /**
+     * \brief Check whether at least one output is set
+     * \return Return true if metrics are exported
+     */
+    bool isEnabled() const { return !_prometheusPath.empty() || _statsdSocket >= 0; }
+
+    /**
+     * \brief Export the metrics held in the tree to all outputs
+     * \param tree Tree to read from
+     */
+    void exportMetrics(const Tree::Root& tree);
+
+  private:
+    std::string _prometheusPath{""};
+    std::string _statsdAddress{""};
+    int _statsdSocket{-1};
+    sockaddr_storage _statsdSocketAddress{};
+    socklen_t _statsdSocketAddressLength{0};
+
+    /**
+     * \brief Close the StatsD socket, if opened
+     */
+    void closeStatsdSocket();
+};
+
+} // namespace Splash
+
+#endif // SPLASH_METRICS_EXPORTER_H
@@ -0,0 +1,269 @@
+/*
+ * Copyright (C) 2026 Emmanuel Durand
+ *
+ * This file is part of Splash.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Splash is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Splash.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * @object_registry.h
+ * Registry of the objects of a root object, readable without locking through snapshots
+ */
+
+#ifndef SPLASH_OBJECT_REGISTRY_H
+#define SPLASH_OBJECT_REGISTRY_H
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "./utils/dense_map.h"
+
+namespace Splash
+{
+
+/*************/
+//! Handle to a registered object, valid until the object is unregistered or replaced
+//! The generation tells apart the objects successively registered in the same slot
+struct ObjectHandle
+{
+    uint32_t slot{0};
+    uint32_t generation{0}; //!< Generations start at 1, so that a default handle is invalid
+
+    bool isValid() const { return generation != 0; }
+    bool operator==(const ObjectHandle& rhs) const { return slot == rhs.slot && generation == rhs.generation; }
+    bool operator!=(const ObjectHandle& rhs) const { return !operator==(rhs); }
+};
+
+/*************/
+//! Map of named objects, modified with the given mutex locked and read through immutable snapshots
+//! Modifications only mark the current snapshot as stale, the next reader building a new one. Readers
+//! then share the same snapshot without taking the mutex until the next modification, RCU style.
+//! Each object gets a handle when it first appears in a snapshot, to be resolved without any name lookup.
+//! Objects must not be replaced through the iterators, as this would not be noticed.
+template <typename T>
+class ObjectRegistry
+{
+  public:
+    using Map = DenseMap<std::string, std::shared_ptr<T>>;
+    using iterator = typename Map::iterator;
+    using const_iterator = typename Map::const_iterator;
+
+    //! Immutable view of the registered objects, valid as long as it is held
+    class Snapshot
+    {
+        friend ObjectRegistry;
+
+      public:
+        /**
+         * Get the object of the given handle
+         * \param handle Object handle
+         * \return Return the object, or nullptr if the handle is not valid anymore
+         */
+        std::shared_ptr<T> get(const ObjectHandle& handle) const
+        {
+            if (handle.slot >= _slots.size() || _slots[handle.slot].generation != handle.generation)
+                return {nullptr};
+            return _slots[handle.slot].object;
+        }
+
+        /**
+         * Get the object of the given name
+         * \param name Object name
+         * \return Return the object, or nullptr if there is none
+         */
+        std::shared_ptr<T> get(const std::string& name) const { return get(getHandle(name)); }
+
+        /**
+         * Get the handle of the object of the given name
+         * \param name Object name
+         * \return Return the handle, which is not valid if there is no such object
+         */
+        ObjectHandle getHandle(const std::string& name) const
+        {
+            auto handleIt = _handles.find(name);
+            return handleIt == _handles.end() ? ObjectHandle() : handleIt->second;
+        }
+
+        /**
+         * Get all the objects, by name
+         * \return Return the objects
+         */
+        const std::unordered_map<std::string, std::shared_ptr<T>>& getObjects() const { return _objects; }
+
+      private:
+        struct Slot
+        {
+            std::shared_ptr<T> object{nullptr};
+            uint32_t generation{0};
+        };
+
+        std::vector<Slot> _slots{};
+        std::unordered_map<std::string, ObjectHandle> _handles{};
+        std::unordered_map<std::string, std::shared_ptr<T>> _objects{};
+    };
+
+    /**
+     * Constructor
+     * \param mutex Mutex held by the writers, also locked when building a snapshot
+     */
+    explicit ObjectRegistry(std::recursive_mutex& mutex)
+        : _mutex(mutex)
+    {
+    }
+
+    ObjectRegistry(const ObjectRegistry&) = delete;
+    ObjectRegistry& operator=(const ObjectRegistry&) = delete;
+
+    /**
+     * Get the current snapshot, building it if the registry changed since the last one
+     * \return Return the snapshot
+     */
+    std::shared_ptr<const Snapshot> getSnapshot() const
+    {
+        if (!_stale.load(std::memory_order_acquire))
+            if (auto snapshot = std::atomic_load(&_snapshot); snapshot)
+                return snapshot;
+
+        std::lock_guard<std::recursive_mutex> lock(_mutex);
+        if (_stale.exchange(false, std::memory_order_acq_rel) || !_snapshot)
+            std::atomic_store(&_snapshot, buildSnapshot());
+        return std::atomic_load(&_snapshot);
+    }
+
+    // Map interface, to be used with the mutex locked
+    iterator begin() noexcept { return _map.begin(); }
+    const_iterator begin() const noexcept { return _map.begin(); }
+    iterator end() noexcept { return _map.end(); }
+    const_iterator end() const noexcept { return _map.end(); }
+    iterator find(const std::string& name) { return _map.find(name); }
+    const_iterator find(const std::string& name) const { return _map.find(name); }
+    size_t count(const std::string& name) const { return _map.count(name); }
+    size_t size() const noexcept { return _map.size(); }
+    bool empty() const noexcept { return _map.empty(); }
+
+    std::shared_ptr<T>& operator[](const std::string& name)
+    {
+        _stale.store(true, std::memory_order_release);
+        return _map[name];
+    }
+
+    iterator erase(iterator pos)
+    {
+        _stale.store(true, std::memory_order_release);
+        return _map.erase(pos);
+    }
+
+    size_t erase(const std::string& name)
+    {
+        _stale.store(true, std::memory_order_release);
+        return _map.erase(name);
+    }
+
+    void clear()
+    {
+        _stale.store(true, std::memory_order_release);
+        _map.clear();
+    }
+
+  private:
+    struct SlotState
+    {
+        std::string name{};
+        const T* object{nullptr};
+        uint32_t generation{0};
+    };
+
+    std::recursive_mutex& _mutex;
+    Map _map{};
+
+    mutable std::atomic_bool _stale{true};
+    mutable std::shared_ptr<const Snapshot> _snapshot{nullptr}; //!< Accessed through std::atomic_load and std::atomic_store only
+    mutable std::vector<SlotState> _slotStates{};               //!< Slots assigned to the objects, kept across snapshots
+    mutable std::vector<uint32_t> _freeSlots{};
+
+    /**
+     * Build a snapshot of the current objects, the mutex being held
+     * \return Return the snapshot
+     */
+    std::shared_ptr<const Snapshot> buildSnapshot() const
+    {
+        // Slots of the objects which were unregistered or replaced are freed first
+        std::unordered_map<std::string, uint32_t> slotOfName;
+        for (uint32_t slot = 0; slot < _slotStates.size(); ++slot)
+        {
+            auto& state = _slotStates[slot];
+            if (!state.object)
+                continue;
+
+            auto objectIt = _map.find(state.name);
+            if (objectIt != _map.end() && objectIt->second.get() == state.object)
+            {
+                slotOfName[state.name] = slot;
+                continue;
+            }
+
+            state.object = nullptr;
+            _freeSlots.push_back(slot);
+        }
+
+        auto snapshot = std::make_shared<Snapshot>();
+        for (const auto& [name, object] : _map)
+        {
+            if (!object)
+                continue;
+
+            uint32_t slot = 0;
+            if (auto slotIt = slotOfName.find(name); slotIt != slotOfName.end())
+            {
+                slot = slotIt->second;
+            }
+            else
+            {
+                if (_freeSlots.empty())
+                {
+                    slot = static_cast<uint32_t>(_slotStates.size());
+                    _slotStates.emplace_back();
+                }
+                else
+                {
+                    slot = _freeSlots.back();
+                    _freeSlots.pop_back();
+                }
+
+                auto& state = _slotStates[slot];
+                state.name = name;
+                state.object = object.get();
+                state.generation = state.generation == UINT32_MAX ? 1 : state.generation + 1;
+            }
+
+            if (snapshot->_slots.size() <= slot)
+                snapshot->_slots.resize(slot + 1);
+            snapshot->_slots[slot] = {object, _slotStates[slot].generation};
+            snapshot->_handles[name] = {slot, _slotStates[slot].generation};
+            snapshot->_objects[name] = object;
+        }
+
+        return snapshot;
+    }
+};
+
+} // namespace Splash
+
+#endif // SPLASH_OBJECT_REGISTRY_H
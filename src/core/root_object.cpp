@@ -6,6 +6,11 @@
 #include "./core/serialize/serialize_uuid.h"
 #include "./core/serialize/serialize_value.h"
 #include "./core/serializer.h"
+#include "./utils/boot_timeline.h"
+#include "./utils/osutils.h"
+
+// Ratio of the memory budget above which a warning is issued
+#define SPLASH_ROOT_MEMORY_BUDGET_WARNING_RATIO 0.9
 
 using namespace std;
 
@@ -76,6 +81,7 @@ weak_ptr<GraphObject> RootObject::createObject(const string& type, const string&
         object->setName(name);
         object->setSavable(false);
         _objects[name] = object;
+        signalObjectsChanged();
         return object;
     }
 }
@@ -87,7 +93,12 @@ void RootObject::disposeObject(const string& name)
         lock_guard<recursive_mutex> registerLock(_objectsMutex);
         auto objectIt = _objects.find(name);
         if (objectIt != _objects.end() && objectIt->second.use_count() == 1)
+        {
+            auto object = std::move(objectIt->second);
             _objects.erase(objectIt);
+            signalObjectsChanged();
+            releaseObject(std::move(object));
+        }
     });
 }
 
@@ -126,6 +137,18 @@ void RootObject::executeTreeCommands()
                 objectIt->second->setAttribute(attrName, params);
             break;
         }
+        case Command::callObjects:
+        {
+            for (const auto& arg : args)
+            {
+                auto call = arg.as<Values>();
+                assert(call.size() == 3);
+                auto objectIt = _objects.find(call[0].as<string>());
+                if (objectIt != _objects.end())
+                    objectIt->second->setAttribute(call[1].as<string>(), call[2].as<Values>());
+            }
+            break;
+        }
         case Command::callRoot:
         {
             assert(args.size() == 2);
@@ -142,20 +165,43 @@ void RootObject::executeTreeCommands()
 }
 
 /*************/
-shared_ptr<GraphObject> RootObject::getObject(const string& name)
+Values RootObject::answerQuery(const Values& queries)
 {
-    lock_guard<recursive_mutex> registerLock(_objectsMutex);
+    Values answers;
+    for (const auto& query : queries)
+    {
+        Values answer;
+        if (query.getType() != Value::Type::values || query.size() != 2)
+        {
+            answers.push_back(answer);
+            continue;
+        }
 
-    auto objectIt = _objects.find(name);
-    if (objectIt != _objects.end())
-        return objectIt->second;
+        const auto fields = query.as<Values>();
+        const auto objectName = fields[0].as<string>();
+        const auto attributeName = fields[1].as<string>();
+        if (objectName == _name)
+        {
+            getAttribute(attributeName, answer);
+        }
+        else
+        {
+            auto object = getObject(objectName);
+            if (object)
+                object->getAttribute(attributeName, answer);
+        }
+        answers.push_back(answer);
+    }
 
-    return {nullptr};
+    return answers;
 }
 
 /*************/
 bool RootObject::set(const string& name, const string& attrib, const Values& args, bool async)
 {
+    if (_sessionRecording)
+        _sessionRecording->recordMessage(name, attrib, args);
+
     if (name == _name || name == SPLASH_ALL_PEERS)
         return setAttribute(attrib, args);
 
@@ -204,11 +250,13 @@ bool RootObject::setFromSerializedObject(const string& name, const shared_ptr<Se
 }
 
 /*************/
-void RootObject::signalBufferObjectUpdated()
+void RootObject::signalBufferObjectUpdated(const string& name)
 {
     unique_lock<mutex> lockCondition(_bufferObjectUpdatedMutex);
 
     _bufferObjectUpdated = true;
+    if (_trackUpdatedBufferObjects && !name.empty())
+        _updatedBufferObjects.insert(name);
     // Only a single buffer has to wave for update at a time
     if (!_bufferObjectSingleMutex.try_lock())
         return;
@@ -242,6 +290,15 @@ bool RootObject::waitSignalBufferObjectUpdated(uint64_t timeout)
     }
 }
 
+/*************/
+unordered_set<string> RootObject::getUpdatedBufferObjects()
+{
+    unordered_set<string> updatedBufferObjects;
+    lock_guard<mutex> lockCondition(_bufferObjectUpdatedMutex);
+    std::swap(updatedBufferObjects, _updatedBufferObjects);
+    return updatedBufferObjects;
+}
+
 /*************/
 bool RootObject::handleSerializedObject(const string& name, const shared_ptr<SerializedObject>& obj)
 {
@@ -250,6 +307,8 @@ bool RootObject::handleSerializedObject(const string& name, const shared_ptr<Ser
         auto dataPtr = reinterpret_cast<uint8_t*>(obj->data());
         auto serializedSeeds = vector<uint8_t>(dataPtr, dataPtr + obj->size());
         auto seeds = Serial::deserialize<list<Tree::Seed>>(serializedSeeds);
+        if (_sessionRecording)
+            _sessionRecording->recordSeeds(seeds);
         _tree.addSeedsToQueue(seeds);
 
         return true;
@@ -286,6 +345,32 @@ void RootObject::updateTreeFromObjects()
         _tree.setValueForLeafAt(path, Values({Value(static_cast<int>(d.second))}));
     }
 
+    // Update the locks contention counters
+    auto spinlockStatistics = Spinlock::getStatistics();
+    for (const auto& [leafName, value] : {make_pair("spinlock_contended", spinlockStatistics.contended), make_pair("spinlock_parked", spinlockStatistics.parked)})
+    {
+        string path = "/" + _name + "/stats/" + leafName;
+        if (!_tree.hasLeafAt(path))
+            if (!_tree.createLeafAt(path))
+                continue;
+        _tree.setValueForLeafAt(path, Values({Value(value)}));
+    }
+
+    // Update the depth of the outgoing buffer queue, and the number of frames dropped for lagging peers
+    if (_link)
+    {
+        for (const auto& [leafName, value] :
+            {make_pair("link_pending_buffers", static_cast<int64_t>(_link->getPendingBufferCount())), make_pair("link_dropped_buffers", _link->getDroppedBufferCount())})
+        {
+            string path = "/" + _name + "/stats/" + leafName;
+            if (_tree.hasLeafAt(path) || _tree.createLeafAt(path))
+                _tree.setValueForLeafAt(path, Values({Value(value)}));
+        }
+    }
+
+    updateMemoryUsage();
+    updateBootTimeline();
+
     // Update the Root object attributes
     auto attributePath = string("/" + _name + "/attributes");
     assert(_tree.hasBranchAt(attributePath));
@@ -313,13 +398,27 @@ void RootObject::updateTreeFromObjects()
 
         attributePath = string("/" + _name + "/objects/" + objectName + "/attributes");
         assert(_tree.hasBranchAt(attributePath));
+        auto& syncedVersions = _treeSyncedVersions[objectName];
         for (const auto& leafName : _tree.getLeafListAt(attributePath))
         {
+            // Attributes without a getter only change when set, skip them if they did not since the last update
+            auto version = object->getAttributeVersion(leafName);
+            auto syncedIt = syncedVersions.find(leafName);
+            if (version && syncedIt != syncedVersions.end() && syncedIt->second == version.value())
+                continue;
+
             auto attribValue = object->getAttribute(leafName);
             if (attribValue)
+            {
                 _tree.setValueForLeafAt(attributePath + "/" + leafName, attribValue.value());
+                if (version)
+                    syncedVersions[leafName] = version.value();
+            }
             else
+            {
                 _tree.removeLeafAt(attributePath + "/" + leafName);
+                syncedVersions.erase(leafName);
+            }
         }
 
         auto docPath = string("/" + _name + "/objects/" + objectName + "/documentation");
@@ -330,6 +429,87 @@ void RootObject::updateTreeFromObjects()
                 _tree.removeBranchAt(docPath + "/" + docBranchName);
         }
     }
+
+    for (auto syncedIt = _treeSyncedVersions.begin(); syncedIt != _treeSyncedVersions.end();)
+    {
+        if (_objects.find(syncedIt->first) == _objects.end())
+            syncedIt = _treeSyncedVersions.erase(syncedIt);
+        else
+            ++syncedIt;
+    }
+}
+
+/*************/
+void RootObject::updateBootTimeline()
+{
+    auto version = BootTimeline::get().getVersion();
+    if (version == _bootTimelineVersion)
+        return;
+    _bootTimelineVersion = version;
+
+    const auto bootPath = "/" + _name + "/boot";
+    if (!_tree.hasBranchAt(bootPath))
+        return;
+
+    // Steps are published on the shared clock, so that the World can lay the timelines of all processes side by side
+    const auto clockOffset = Timer::get().getClockOffset();
+    for (const auto& step : BootTimeline::get().getSteps(_name))
+    {
+        auto path = bootPath + "/" + step.name;
+        if (_tree.hasLeafAt(path) || _tree.createLeafAt(path))
+            _tree.setValueForLeafAt(path, Values({step.start + clockOffset, step.end + clockOffset, step.duration, static_cast<int64_t>(step.count)}));
+    }
+}
+
+/*************/
+void RootObject::updateMemoryUsage()
+{
+    const auto memoryPath = "/" + _name + "/memory";
+    if (!_tree.hasBranchAt(memoryPath))
+        return;
+
+    GraphObject::MemoryUsage total;
+    for (const auto& [objectName, object] : _objects)
+    {
+        auto usage = object->getMemoryUsage();
+        if (usage.ram == 0 && usage.vram == 0)
+            continue;
+        total += usage;
+
+        auto path = memoryPath + "/" + objectName;
+        if (_tree.hasLeafAt(path) || _tree.createLeafAt(path))
+            _tree.setValueForLeafAt(path, Values({usage.ram, usage.vram}));
+    }
+
+    for (const auto& leafName : _tree.getLeafListAt(memoryPath))
+        if (_objects.find(leafName) == _objects.end())
+            _tree.removeLeafAt(memoryPath + "/" + leafName);
+
+    for (const auto& [leafName, value] : {make_pair("memory_ram", total.ram), make_pair("memory_vram", total.vram)})
+    {
+        auto path = "/" + _name + "/stats/" + leafName;
+        if (_tree.hasLeafAt(path) || _tree.createLeafAt(path))
+            _tree.setValueForLeafAt(path, Values({Value(value)}));
+    }
+
+    auto checkBudget = [&](const string& memoryName, int64_t usage, int64_t budget, bool& warned) {
+        if (budget <= 0)
+            return;
+
+        const auto threshold = static_cast<int64_t>(static_cast<double>(budget * 1024 * 1024) * SPLASH_ROOT_MEMORY_BUDGET_WARNING_RATIO);
+        if (usage > threshold && !warned)
+        {
+            Log::get() << Log::WARNING << "RootObject::" << __FUNCTION__ << " - " << _name << " uses " << usage / (1024 * 1024) << " MB of " << memoryName << ", close to its budget of "
+                       << budget << " MB" << Log::endl;
+            warned = true;
+        }
+        else if (usage <= threshold)
+        {
+            warned = false;
+        }
+    };
+    checkBudget("RAM", total.ram, _ramBudget, _ramBudgetWarned);
+    checkBudget("VRAM", total.vram, _vramBudget, _vramBudgetWarned);
 }
 
 /*************/
@@ -337,13 +517,21 @@ void RootObject::propagateTree()
 {
     assert(_link);
 
+    // Changes made during this loop are delivered all at once to the subscribers
+    _tree.notifySubscribers();
+
     auto treeSeeds = _tree.getUpdateSeedList();
     if (treeSeeds.empty())
         return;
-    vector<uint8_t> serializedSeeds;
-    Serial::serialize(treeSeeds, serializedSeeds);
-    auto dataPtr = reinterpret_cast<uint8_t*>(serializedSeeds.data());
-    _link->sendBuffer("_tree", make_shared<SerializedObject>(dataPtr, dataPtr + serializedSeeds.size()));
+
+    // Leaves are often set multiple times per loop, only their last value is worth sending
+    Tree::Root::coalesceSeeds(treeSeeds, _frameArena.resource());
+
+    // The serialization buffer keeps its capacity from one loop to the next
+    _serializedSeeds.clear();
+    Serial::serialize(treeSeeds, _serializedSeeds);
+    auto dataPtr = reinterpret_cast<uint8_t*>(_serializedSeeds.data());
+    _link->sendBuffer("_tree", make_shared<SerializedObject>(dataPtr, dataPtr + _serializedSeeds.size()));
 }
 
 /*************/
@@ -372,6 +560,72 @@ void RootObject::registerAttributes()
         _answerCondition.notify_one();
         return true;
     });
+
+    addAttribute(
+        "ramBudget",
+        [&](const Values& args) {
+            _ramBudget = std::max<int64_t>(0, args[0].as<int64_t>());
+            return true;
+        },
+        [&]() -> Values { return {_ramBudget}; },
+        {'i'});
+    setAttributeDescription("ramBudget", "Host memory budget of the objects in MB, a warning is issued when they get close to it. Set to 0 to disable");
+
+    addAttribute(
+        "vramBudget",
+        [&](const Values& args) {
+            _vramBudget = std::max<int64_t>(0, args[0].as<int64_t>());
+            return true;
+        },
+        [&]() -> Values { return {_vramBudget}; },
+        {'i'});
+    setAttributeDescription("vramBudget", "GPU memory budget of the objects in MB, a warning is issued when they get close to it. Set to 0 to disable");
+
+    addAttribute(
+        "threadScheduling",
+        [&](const Values& args) {
+            for (const auto& arg : args)
+            {
+                auto classScheduling = arg.as<Values>();
+                if (classScheduling.size() < 2)
+                {
+                    Log::get() << Log::WARNING << "RootObject::" << __FUNCTION__ << " - Expected at least a thread class and a scheduling policy" << Log::endl;
+                    return false;
+                }
+
+                auto threadClass = Utils::getThreadClassFromName(classScheduling[0].as<string>());
+                if (threadClass == Utils::ThreadClass::count)
+                {
+                    Log::get() << Log::WARNING << "RootObject::" << __FUNCTION__ << " - Unknown thread class: " << classScheduling[0].as<string>() << Log::endl;
+                    return false;
+                }
+
+                Utils::ThreadScheduling scheduling;
+                scheduling.policy = classScheduling[1].as<string>();
+                scheduling.priority = classScheduling.size() > 2 ? classScheduling[2].as<int>() : 0;
+                for (size_t i = 3; i < classScheduling.size(); ++i)
+                    scheduling.cores.push_back(classScheduling[i].as<int>());
+                Utils::setThreadClassScheduling(threadClass, scheduling);
+            }
+            return true;
+        },
+        [&]() -> Values {
+            Values threadScheduling;
+            for (const auto& className : {"render", "audio", "decode", "network"})
+            {
+                auto scheduling = Utils::getThreadClassScheduling(Utils::getThreadClassFromName(className));
+                Values classScheduling{className, scheduling.policy, scheduling.priority};
+                for (auto core : scheduling.cores)
+                    classScheduling.push_back(core);
+                threadScheduling.push_back(classScheduling);
+            }
+            return threadScheduling;
+        },
+        {});
+    setAttributeDescription("threadScheduling",
+        "Cores and scheduling policy for each class of threads, as a list of [class, policy, priority, cores...]. Classes are render (render loop, texture upload, video "
+        "display), audio, decode (demuxing, decoding, capture, encoding) and network (link input). Policies are default, batch, idle, fifo and rr, the priority being only "
+        "used by fifo and rr. If no core is given, the threads can run on any core");
 }
 
 /*************/
@@ -379,10 +633,13 @@ void RootObject::initializeTree()
 {
     _tree.createBranchAt("/world");
     _tree.createBranchAt("/world/attributes");
+    _tree.createBranchAt("/world/boot");
     _tree.createBranchAt("/world/commands");
     _tree.createBranchAt("/world/durations");
     _tree.createBranchAt("/world/logs");
+    _tree.createBranchAt("/world/memory");
     _tree.createBranchAt("/world/objects");
+    _tree.createBranchAt("/world/stats");
 
     // Clear the seed list, all these leaves being automatically added to all root objets
     _tree.clearSeedList();
@@ -449,6 +706,9 @@ Json::Value RootObject::getValuesAsJson(const Values& values, bool asObject) con
                     jsValue[v.getName()] = getValuesAsJson(vv, false);
                 break;
             }
+            case Value::reals:
+                jsValue[v.getName()] = getValuesAsJson(v.as<Values>(), false);
+                break;
             }
         }
     }
@@ -482,6 +742,9 @@ Json::Value RootObject::getValuesAsJson(const Values& values, bool asObject) con
                     jsValue.append(getValuesAsJson(vv, false));
                 break;
             }
+            case Value::reals:
+                jsValue.append(getValuesAsJson(v.as<Values>(), false));
+                break;
             }
         }
     }
@@ -490,6 +753,12 @@ Json::Value RootObject::getValuesAsJson(const Values& values, bool asObject) con
 
 /*************/
 Json::Value RootObject::getObjectConfigurationAsJson(const string& object, const string& rootObject)
+{
+    return getObjectConfigurationAsJson(*_tree.getSnapshot(), object, rootObject);
+}
+
+/*************/
+Json::Value RootObject::getObjectConfigurationAsJson(const Tree::Snapshot& tree, const string& object, const string& rootObject)
 {
     assert(!object.empty());
 
@@ -503,13 +772,13 @@ Json::Value RootObject::getObjectConfigurationAsJson(const string& object, const
     for (const auto& rootName : rootList)
     {
         auto attrPath = "/" + rootName + "/objects/" + object + "/attributes";
-        if (!_tree.hasBranchAt(attrPath))
+        if (!tree.hasBranchAt(attrPath))
             continue;
 
-        for (const auto& attrName : _tree.getLeafListAt(attrPath))
+        for (const auto& attrName : tree.getLeafListAt(attrPath))
         {
             Value attrValue;
-            if (!_tree.getValueForLeafAt(attrPath + "/" + attrName, attrValue))
+            if (!tree.getValueForLeafAt(attrPath + "/" + attrName, attrValue))
                 continue;
 
             if (attrValue.size() == 0)
@@ -525,10 +794,10 @@ Json::Value RootObject::getObjectConfigurationAsJson(const string& object, const
 
         // Type is handled separately
         auto typePath = "/" + rootName + "/objects/" + object + "/type";
-        if (_tree.hasLeafAt(typePath))
+        if (tree.hasLeafAt(typePath))
         {
             Value typeValue;
-            if (_tree.getValueForLeafAt(typePath, typeValue))
+            if (tree.getValueForLeafAt(typePath, typeValue))
                 root["type"] = typeValue.as<string>();
         }
     }
@@ -539,17 +808,19 @@ Json::Value RootObject::getObjectConfigurationAsJson(const string& object, const
 /*************/
 Json::Value RootObject::getRootConfigurationAsJson(const string& rootName)
 {
-    if (!_tree.hasBranchAt("/" + rootName))
+    // The configuration is read from a snapshot, so that the loop thread is not blocked meanwhile
+    auto tree = _tree.getSnapshot();
+    if (!tree->hasBranchAt("/" + rootName))
         return {};
 
     Json::Value root;
     auto attrPath = "/" + rootName + "/attributes";
-    assert(_tree.hasBranchAt(attrPath));
+    assert(tree->hasBranchAt(attrPath));
 
-    for (const auto& attrName : _tree.getLeafListAt(attrPath))
+    for (const auto& attrName : tree->getLeafListAt(attrPath))
     {
         Value attrValue;
-        if (!_tree.getValueForLeafAt(attrPath + "/" + attrName, attrValue))
+        if (!tree->getValueForLeafAt(attrPath + "/" + attrName, attrValue))
             continue;
 
         if (attrValue.size() == 0)
@@ -573,25 +844,25 @@ Json::Value RootObject::getRootConfigurationAsJson(const string& rootName)
     root["links"] = Json::Value();
 
     auto objectsPath = "/" + rootName + "/objects";
-    assert(_tree.hasBranchAt(objectsPath));
-    for (const auto& objectName : _tree.getBranchListAt(objectsPath))
+    assert(tree->hasBranchAt(objectsPath));
+    for (const auto& objectName : tree->getBranchListAt(objectsPath))
     {
         Value confValue;
-        if (_tree.getValueForLeafAt(objectsPath + "/" + objectName + "/attributes/savable", confValue) && confValue[0].as<bool>() == false)
+        if (tree->getValueForLeafAt(objectsPath + "/" + objectName + "/attributes/savable", confValue) && confValue[0].as<bool>() == false)
             continue;
-        if (_tree.getValueForLeafAt(objectsPath + "/" + objectName + "/ghost", confValue) && confValue.as<bool>() == true)
+        if (tree->getValueForLeafAt(objectsPath + "/" + objectName + "/ghost", confValue) && confValue.as<bool>() == true)
             continue;
-        root["objects"][objectName] = getObjectConfigurationAsJson(objectName, rootName);
+        root["objects"][objectName] = getObjectConfigurationAsJson(*tree, objectName, rootName);
 
-        assert(_tree.hasLeafAt(objectsPath + "/" + objectName + "/links/children"));
+        assert(tree->hasLeafAt(objectsPath + "/" + objectName + "/links/children"));
         Value value;
-        _tree.getValueForLeafAt(objectsPath + "/" + objectName + "/links/children", value);
+        tree->getValueForLeafAt(objectsPath + "/" + objectName + "/links/children", value);
         for (const auto& parent : value.as<Values>())
         {
             auto linkName = parent.as<string>();
-            if (_tree.getValueForLeafAt(objectsPath + "/" + linkName + "/attributes/savable", confValue) && confValue[0].as<bool>() == false)
+            if (tree->getValueForLeafAt(objectsPath + "/" + linkName + "/attributes/savable", confValue) && confValue[0].as<bool>() == false)
                 continue;
-            if (_tree.getValueForLeafAt(objectsPath + "/" + linkName + "/ghost", confValue) && confValue.as<bool>() == true)
+            if (tree->getValueForLeafAt(objectsPath + "/" + linkName + "/ghost", confValue) && confValue.as<bool>() == true)
                 continue;
             root["links"].append(getValuesAsJson({linkName, objectName}));
         }
@@ -625,4 +896,16 @@ Values RootObject::sendMessageWithAnswer(const string& name, const string& attri
         return {};
 }
 
+/*************/
+Values RootObject::queryAttributes(const string& name, const vector<pair<string, string>>& attributes, const unsigned long long timeout)
+{
+    assert(_link);
+
+    Values queries;
+    for (const auto& attribute : attributes)
+        queries.push_back(Values({attribute.first, attribute.second}));
+
+    return _link->sendQuery(name, queries, chrono::microseconds(timeout));
+}
+
 } // namespace Splash
@@ -32,14 +32,18 @@
 #include <string>
 #include <map>
 #include <unordered_map>
+#include <unordered_set>
 
 #include "./core/base_object.h"
 #include "./core/factory.h"
 #include "./core/graph_object.h"
 #include "./core/link.h"
 #include "./core/name_registry.h"
+#include "./core/object_registry.h"
+#include "./core/session_recording.h"
 #include "./core/tree.h"
 #include "./utils/dense_map.h"
+#include "./utils/frame_arena.h"
 
 namespace Splash
 {
@@ -66,23 +70,34 @@ class RootObject : public BaseObject
         bool childProcess{false};
         bool spawnSubprocesses{true};
         bool unitTest{false};
+        bool headless{false}; //!< If true, Scenes create their contexts through EGL and without a display server, if supported by GLFW
         std::string executableName{""};
         std::string executablePath{""};
         std::string socketPrefix{""};
+        std::string listenAddress{""}; //!< TCP address as host:port to listen on for peers on other hosts, empty to only allow local peers
+        std::string worldAddress{""};  //!< TCP address of the World as host:port, for a child Scene running on another host
+        std::string multicastAddress{""}; //!< PGM multicast address as interface;group:port, to exchange buffers with the peers on other hosts
         std::string childSceneName{"scene"};
+        RootObject* innerWorld{nullptr}; //!< World of a Scene running in the same process, reached without going through sockets
+        std::optional<uint32_t> benchmarkFrames{}; //!< If set, number of frames to render with synthetic media before printing the timings and quitting
+        std::optional<std::string> recordSessionPath{}; //!< If set, file to record the messages and tree changes received by the World to
+        std::optional<std::string> replaySessionPath{}; //!< If set, recorded session to replay before printing the timings and quitting
+        std::optional<std::string> remoteGuiAddress{}; //!< If set, TCP address as host:port on which the World serves remote GUI clients
         std::string configurationFile{std::string(DATADIR) + "splash.json"};
         std::optional<std::string> pythonScriptPath{};
         Values pythonArgs{};
 #if HAVE_LINUX
         std::optional<std::string> forcedDisplay{};
         std::string displayServer{"0"};
+        std::optional<int> numaNode{}; //!< If set, NUMA node the process runs on and allocates memory from
 #endif
     };
 
     enum Command
     {
         callObject,
-        callRoot
+        callRoot,
+        callObjects //!< Set attributes of multiple objects, all during the same loop
     };
 
   public:
@@ -131,11 +146,39 @@ class RootObject : public BaseObject
     void executeTreeCommands();
 
     /**
-     * Get the object of the given name
+     * Get the object of the given name, without locking the objects
      * \param name Object name
-     * \return Return the object name
+     * \return Return the object, or nullptr if there is none
      */
-    std::shared_ptr<GraphObject> getObject(const std::string& name);
+    std::shared_ptr<GraphObject> getObject(const std::string& name) const { return _objects.getSnapshot()->get(name); }
+
+    /**
+     * Get the object of the given handle, without locking the objects nor looking up its name
+     * \param handle Object handle, from getObjectHandle
+     * \return Return the object, or nullptr if it is not registered anymore
+     */
+    std::shared_ptr<GraphObject> getObject(const ObjectHandle& handle) const { return _objects.getSnapshot()->get(handle); }
+
+    /**
+     * Get the handle of the object of the given name, which stays valid as long as the object is registered
+     * \param name Object name
+     * \return Return the handle, which is not valid if there is no such object
+     */
+    ObjectHandle getObjectHandle(const std::string& name) const { return _objects.getSnapshot()->getHandle(name); }
+
+    /**
+     * Get a snapshot of all the objects, to iterate over them without locking the objects
+     * The snapshot is not modified by later registrations and unregistrations
+     * \return Return the snapshot
+     */
+    std::shared_ptr<const ObjectRegistry<GraphObject>::Snapshot> getObjectsSnapshot() const { return _objects.getSnapshot(); }
+
+    /**
+     * \brief Answer a batch of attribute queries. Called by the Link from its own thread, without waiting for the main loop
+     * \param queries Queries, each one being a Values holding an object name (or this root object's name) and an attribute name
+     * \return Return the attribute values, in the same order as the queries. Unknown attributes are answered with an empty Values
+     */
+    Values answerQuery(const Values& queries);
 
     /**
      * Get the socket prefix
@@ -143,6 +186,18 @@ class RootObject : public BaseObject
      */
     std::string getSocketPrefix() const { return _context.socketPrefix; }
 
+    /**
+     * Get the TCP address to listen on for peers on other hosts
+     * \return Return the address as host:port, or an empty string if only local peers are allowed
+     */
+    std::string getListenAddress() const { return _context.listenAddress; }
+
+    /**
+     * Get the multicast address used to send buffers to the peers on other hosts
+     * \return Return the address as interface;group:port, or an empty string if multicast is not used
+     */
+    std::string getMulticastAddress() const { return _context.multicastAddress; }
+
     /**
      * \brief Get the configuration path
      * \return Return the configuration path
@@ -175,6 +230,12 @@ class RootObject : public BaseObject
      */
     Tree::RootHandle getTree() { return _tree.getHandle(); }
 
+    /**
+     * \brief Get an immutable snapshot of the tree, to be read without locking it
+     * \return Return the snapshot
+     */
+    std::shared_ptr<const Tree::Snapshot> getTreeSnapshot() const { return _tree.getSnapshot(); }
+
     /**
      * \brief Set the attribute of the named object with the given args
      * \param name Object name
@@ -193,6 +254,13 @@ class RootObject : public BaseObject
      */
     bool setFromSerializedObject(const std::string& name, const std::shared_ptr<SerializedObject>& obj);
 
+    /**
+     * \brief Allocate a serialized object meant to be sent through the link
+     * \param size Size of the serialized object
+     * \return Return the serialized object
+     */
+    std::shared_ptr<SerializedObject> allocateSerializedObject(size_t size) { return _link ? _link->allocateBuffer(size) : std::make_shared<SerializedObject>(size); }
+
     /**
      * \brief Send the given serialized buffer through the link
      * \param name Destination BufferObject name
@@ -206,10 +274,16 @@ class RootObject : public BaseObject
      */
     std::unique_lock<std::recursive_mutex> getLockOnObjects() { return std::unique_lock<std::recursive_mutex>(_objectsMutex); }
 
+    /**
+     * \brief Signals that objects have been added, removed, linked, or that their rendering priority changed
+     */
+    void signalObjectsChanged() { _objectsChanged = true; }
+
     /**
      * \brief Signals that a BufferObject has been updated
+     * \param name Name of the updated object, recorded if this root tracks updated buffer objects
      */
-    void signalBufferObjectUpdated();
+    void signalBufferObjectUpdated(const std::string& name = "");
 
   protected:
     Context _context{};
@@ -217,6 +291,7 @@ class RootObject : public BaseObject
     Tree::Root _tree{}; //!< Configuration / status tree, shared between all root objects
     std::unordered_map<std::string, int> _treeCallbackIds{};
     std::unordered_map<std::string, CallbackHandle> _attributeCallbackHandles{};
+    std::unordered_map<std::string, std::unordered_map<std::string, uint64_t>> _treeSyncedVersions{}; //!< Attribute versions last pushed to the tree, per object
 
     std::unique_ptr<Factory> _factory{}; //!< Object factory
     std::unique_ptr<Link> _link{};       //!< Link object for communicatin between World and Scene
@@ -232,10 +307,25 @@ class RootObject : public BaseObject
     std::mutex _bufferObjectUpdatedMutex{};
     Spinlock _bufferObjectSingleMutex{};
     bool _bufferObjectUpdated = ATOMIC_FLAG_INIT;
+    bool _trackUpdatedBufferObjects{false};                    //!< If true, the names of the signaled buffer objects are recorded
+    std::unordered_set<std::string> _updatedBufferObjects{}; //!< Buffer objects signaled since the last call to getUpdatedBufferObjects
 
-    mutable std::recursive_mutex _objectsMutex{};                   //!< Used in registration and unregistration of objects
-    std::atomic_bool _objectsCurrentlyUpdated{false};               //!< Prevents modification of objects from multiple places at the same time
-    DenseMap<std::string, std::shared_ptr<GraphObject>> _objects{}; //!< Map of all the objects
+    mutable std::recursive_mutex _objectsMutex{};          //!< Used in registration and unregistration of objects
+    std::atomic_bool _objectsCurrentlyUpdated{false};      //!< Prevents modification of objects from multiple places at the same time
+    ObjectRegistry<GraphObject> _objects{_objectsMutex};   //!< Map of all the objects, modified with _objectsMutex locked
+    std::atomic_bool _objectsChanged{true};                //!< Set by signalObjectsChanged, reset when the change has been handled
+
+    int64_t _ramBudget{0};         //!< Host memory budget for the objects, in MB, 0 to disable the warning
+    int64_t _vramBudget{0};        //!< GPU memory budget for the objects, in MB, 0 to disable the warning
+    bool _ramBudgetWarned{false};  //!< Set when the budget warning was issued, until the usage goes down again
+    bool _vramBudgetWarned{false}; //!< Set when the budget warning was issued, until the usage goes down again
+
+    uint64_t _bootTimelineVersion{0}; //!< Version of the boot timeline last published to the tree
+
+    std::unique_ptr<SessionRecording> _sessionRecording{}; //!< Recording of the received messages and tree changes, if enabled
+
+    FrameArena _frameArena{};                //!< Arena for the temporaries of the current loop, reset by the loop owner
+    std::vector<uint8_t> _serializedSeeds{}; //!< Buffer for the serialized tree seeds, reused across loops
 
     /**
      * \brief Wait for a BufferObject update. This does not prevent spurious wakeups.
@@ -244,6 +334,12 @@ class RootObject : public BaseObject
      */
     bool waitSignalBufferObjectUpdated(uint64_t timeout = 0ull);
 
+    /**
+     * \brief Get the names of the buffer objects signaled since the last call, and clear them
+     * \return Return the object names
+     */
+    std::unordered_set<std::string> getUpdatedBufferObjects();
+
     /**
      * \brief Method to process a serialized object
      * \param name Object name to receive the serialized object
@@ -252,6 +348,13 @@ class RootObject : public BaseObject
      */
     virtual bool handleSerializedObject(const std::string& name, const std::shared_ptr<SerializedObject>& obj);
 
+    /**
+     * Release an object which has been removed from the objects list
+     * The object is destroyed right away, derived classes can defer its destruction
+     * \param object Object to release
+     */
+    virtual void releaseObject(std::shared_ptr<GraphObject>&& object) { object.reset(); }
+
     /**
      * Force the propagation of a specific path
      * \param path Path to propagate
@@ -273,6 +376,16 @@ class RootObject : public BaseObject
      */
     void updateTreeFromObjects();
 
+    /**
+     * Publish the memory held by each object and the totals to the tree, and warn if they get close to the budgets
+     */
+    void updateMemoryUsage();
+
+    /**
+     * Publish the boot steps of this root object to the tree, as long as some are recorded
+     */
+    void updateBootTimeline();
+
     /**
      * Initialize the tree
      */
@@ -301,6 +414,15 @@ class RootObject : public BaseObject
      */
     Json::Value getRootConfigurationAsJson(const std::string& rootName);
 
+    /**
+     * Save the given objects tree in a Json::Value, from a snapshot of the tree
+     * \param tree Tree snapshot
+     * \param object Object name
+     * \param rootObject Root name
+     * \return Return the configuration as a Json::Value
+     */
+    Json::Value getObjectConfigurationAsJson(const Tree::Snapshot& tree, const std::string& object, const std::string& rootObject = "");
+
     /**
      * \brief Send a message to another root object
      * \param name Root object name
@@ -318,6 +440,16 @@ class RootObject : public BaseObject
      * \return Return the answer received (or an empty Values)
      */
     Values sendMessageWithAnswer(const std::string& name, const std::string& attribute, const Values& message = {}, const unsigned long long timeout = 0ull);
+
+    /**
+     * \brief Get attributes values from another root object. Contrary to sendMessageWithAnswer, the query does not go through the
+     * message channel nor wait for the main loop of the other root object, so it is answered within microseconds.
+     * \param name Root object name
+     * \param attributes Pairs of object name and attribute name
+     * \param timeout Timeout in microseconds
+     * \return Return the attributes values in the same order as the requested attributes, or an empty Values if no answer was received
+     */
+    Values queryAttributes(const std::string& name, const std::vector<std::pair<std::string, std::string>>& attributes, const unsigned long long timeout = 1000000ull);
 };
 
 } // namespace Splash
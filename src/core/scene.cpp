@@ -1,5 +1,7 @@
 #include "./core/scene.h"
 
+#include <cmath>
+#include <limits>
 #include <list>
 #include <utility>
 
@@ -9,23 +11,31 @@
 #include "./graphics/camera.h"
 #include "./graphics/filter.h"
 #include "./graphics/geometry.h"
+#include "./graphics/gl_capabilities.h"
 #include "./graphics/object.h"
 #include "./graphics/profiler_gl.h"
 #include "./graphics/texture.h"
 #include "./graphics/texture_image.h"
+#include "./graphics/virtual_probe.h"
 #include "./graphics/warp.h"
 #include "./graphics/window.h"
 #include "./image/image.h"
 #include "./image/queue.h"
 #include "./mesh/mesh.h"
+#include "./sink/sink.h"
+#include "./sink/sink_group.h"
 #include "./userinput/userinput_dragndrop.h"
 #include "./userinput/userinput_joystick.h"
 #include "./userinput/userinput_keyboard.h"
 #include "./userinput/userinput_mouse.h"
+#include "./utils/boot_timeline.h"
+#include "./utils/clock_sync.h"
 #include "./utils/log.h"
 #include "./utils/osutils.h"
 #include "./utils/scope_guard.h"
+#include "./utils/thread_pool.h"
 #include "./utils/timer.h"
+#include "./utils/trace_recorder.h"
 
 #if HAVE_GPHOTO and HAVE_OPENCV
 #include "./controller/colorcalibrator.h"
@@ -42,16 +52,77 @@
 #include "./controller/geometriccalibrator.h"
 #endif
 
+// Period between two updates of the image regions sampled by the cameras, in ms
+#define SPLASH_SCENE_SAMPLED_REGIONS_PERIOD 100
+// Margin added around the sampled image regions, in UV coordinates, to account for filtering and camera motion
+#define SPLASH_SCENE_SAMPLED_REGIONS_MARGIN 0.02
+// Step to which the image resolutions needed by the cameras are rounded up, in pixels, so that they are not sent on every camera motion
+#define SPLASH_SCENE_SAMPLED_RESOLUTION_STEP 64
+// Period between two clock synchronization exchanges with the World, in ms
+#define SPLASH_SCENE_CLOCK_SYNC_PERIOD 1000
+// Number of exchanges done in a row when starting, to get a good first estimation of the clock offset
+#define SPLASH_SCENE_CLOCK_SYNC_BURST 8
+// Timeout for a clock synchronization exchange, in us
+#define SPLASH_SCENE_CLOCK_SYNC_TIMEOUT 100000
+// Maximum time to wait for the other Scenes before swapping anyway, in us
+#define SPLASH_SCENE_SWAP_BARRIER_TIMEOUT 100000
+// Maximum number of released objects holding GL resources destroyed per frame
+#define SPLASH_SCENE_GL_RELEASE_BATCH 4
+// Fraction of the frame budget above which the GPU is considered overloaded, and below which the render scale can be raised
+#define SPLASH_SCENE_DYNAMIC_RESOLUTION_HIGH 0.9
+#define SPLASH_SCENE_DYNAMIC_RESOLUTION_LOW 0.6
+// Number of consecutive frames over budget before lowering the render scale, and with headroom before raising it
+#define SPLASH_SCENE_DYNAMIC_RESOLUTION_DOWN_FRAMES 5
+#define SPLASH_SCENE_DYNAMIC_RESOLUTION_UP_FRAMES 120
+// Factor applied to the render scale when lowering it, and step when raising it
+#define SPLASH_SCENE_DYNAMIC_RESOLUTION_DOWN_FACTOR 0.85f
+#define SPLASH_SCENE_DYNAMIC_RESOLUTION_UP_STEP 0.05f
+// Safety margin between the estimated end of the render and the next vertical blank, in us
+#define SPLASH_SCENE_FRAME_PACING_MARGIN 2000
+// Decay of the render duration estimate per frame, the estimate rises immediately when the render gets longer
+#define SPLASH_SCENE_FRAME_PACING_DECAY 0.98
+// Period between two queries of the available GPU memory, in frames
+#define SPLASH_SCENE_MEMORY_INFO_PERIOD 60
+// Decay of the running averages of the frame phase durations, against which the phases of the late frames are compared
+#define SPLASH_SCENE_FRAME_PHASE_DECAY 0.95
+// Maximum number of consecutive frames for which a decoupled GUI can be skipped, so that it stays responsive
+#define SPLASH_SCENE_GUI_MAX_SKIPPED_FRAMES 30
+// Period between two checks of the render loop by the watchdog, in ms
+#define SPLASH_SCENE_WATCHDOG_PERIOD 100
+// Duration of a loop after which the render loop is considered stalled, in ms
+#define SPLASH_SCENE_WATCHDOG_STALL 500
+// Fraction of the frame budget above which a loop is over budget, and below which it leaves enough headroom to restore the quality
+#define SPLASH_SCENE_WATCHDOG_HIGH 1.0
+#define SPLASH_SCENE_WATCHDOG_LOW 0.6
+// Number of consecutive loops over budget before degrading the quality one step further, and with headroom before restoring one step
+#define SPLASH_SCENE_WATCHDOG_DEGRADE_FRAMES 30
+#define SPLASH_SCENE_WATCHDOG_RESTORE_FRAMES 600
+// Render scale of the virtual probes while their resolution is lowered by the watchdog
+#define SPLASH_SCENE_WATCHDOG_PROBE_SCALE 0.5f
+
+// From the GL_NVX_gpu_memory_info and GL_ATI_meminfo extensions, which are not part of the core profile headers
+#ifndef GL_GPU_MEMORY_INFO_CURRENT_AVAILABLE_VIDMEM_NVX
+#define GL_GPU_MEMORY_INFO_CURRENT_AVAILABLE_VIDMEM_NVX 0x9049
+#endif
+#ifndef GL_TEXTURE_FREE_MEMORY_ATI
+#define GL_TEXTURE_FREE_MEMORY_ATI 0x87FC
+#endif
+
 using namespace std;
 
 namespace Splash
 {
 
 bool Scene::_hasNVSwapGroup{false};
+bool Scene::_hasBindlessTextures{false};
+bool Scene::_hasParallelShaderCompile{false};
 vector<int> Scene::_glVersion{0, 0};
 std::string Scene::_glVendor{};
 std::string Scene::_glRenderer{};
+int Scene::_glMaxTextureSize{0};
 vector<string> Scene::_ghostableTypes{"camera", "warp"};
+const array<const char*, Scene::FRAME_PHASE_COUNT> Scene::_framePhaseNames{"upload", "blending", "render", "swap", "other"};
+const array<const char*, Scene::LOOP_PHASE_COUNT> Scene::_loopPhaseNames{"tree processing", "tasks", "inputs", "upload", "render", "swap", "gui", "tree update"};
 
 /*************/
 Scene::Scene(Context context)
@@ -77,7 +148,13 @@ Scene::Scene(Context context)
         _objects["blender"] = _blender;
     }
 
-    init(_name);
+    // An inner Scene is built from the World thread, which keeps recording its own steps afterwards
+    auto previousBootOwner = BootTimeline::get().setThreadOwner(_name);
+    {
+        BootStep bootStep("scene_init");
+        init(_name);
+    }
+    BootTimeline::get().setThreadOwner(previousBootOwner);
 }
 
 /*************/
@@ -93,17 +170,24 @@ Scene::~Scene()
         for (auto& obj : _objects)
             obj.second.reset();
         _objects.clear();
+        destroyReleasedObjects(true);
+        _gpuTimer.reset();
+        _objectGpuTimers.clear();
 
         _mainWindow->releaseContext();
     }
 
+    // The worker releasing CPU objects accesses the Scene
+    if (_deferredReleaseFuture.valid())
+        _deferredReleaseFuture.wait();
+
 #ifdef DEBUG
     Log::get() << Log::DEBUGGING << "Scene::~Scene - Destructor" << Log::endl;
 #endif
 }
 
 /*************/
-std::shared_ptr<GraphObject> Scene::addObject(const string& type, const string& name)
+std::shared_ptr<GraphObject> Scene::addObject(const string& type, const string& name, bool local)
 {
 #ifdef DEBUG
     Log::get() << Log::DEBUGGING << "Scene::" << __FUNCTION__ << " - Creating object of type " << type << Log::endl;
@@ -125,15 +209,20 @@ std::shared_ptr<GraphObject> Scene::addObject(const string& type, const string&
     }
 
     // Create the wanted object
-    auto obj = _factory->create(type);
+    auto obj = _factory->create(type, local);
 
     // Add the object to the objects list
     if (obj.get() != nullptr)
     {
-        obj->setRemoteType(type); // Not all objects have remote types, but this doesn't harm
+        // Local objects produce their data themselves, instead of receiving it from the World
+        if (!local)
+            obj->setRemoteType(type); // Not all objects have remote types, but this doesn't harm
+        else
+            obj->setAttribute("placement", {"scene"});
 
         obj->setName(name);
         _objects[name] = obj;
+        signalObjectsChanged();
 
         // Some objects have to be connected to the gui (if the Scene is master)
         if (_gui != nullptr)
@@ -211,12 +300,16 @@ void Scene::setEnableJoystickInput(bool enable)
         _joystick = make_shared<Joystick>(this);
         _joystick->setName(joystickName);
         _objects[_joystick->getName()] = _joystick;
+        signalObjectsChanged();
     }
     else if (_joystick && !enable)
     {
         _joystick.reset();
         if (auto objectsIt = _objects.find(joystickName); objectsIt != _objects.end())
+        {
             _objects.erase(objectsIt);
+            signalObjectsChanged();
+        }
     }
 }
 
@@ -233,71 +326,146 @@ void Scene::remove(const string& name)
 
     lock_guard<recursive_mutex> lockObjects(_objectsMutex);
 
-    if (_objects.find(name) != _objects.end())
-        _objects.erase(name);
+    if (auto objectIt = _objects.find(name); objectIt != _objects.end())
+    {
+        auto object = std::move(objectIt->second);
+        _objects.erase(objectIt);
+        signalObjectsChanged();
+        releaseObject(std::move(object));
+    }
 }
 
 /*************/
 void Scene::render()
 {
+    static const auto swapProbe = Timer::get().getProbe("swap");
+
+    // Start rendering as late as possible before the next vertical blank, so that the frame holds the latest inputs
+    if (_framePacing)
+        paceFrame();
+    auto renderStart = Timer::getTime();
+
+    // Whatever happened between the previous swap and this render, pacing included
+    _framePhaseDurations.fill(0);
+    _framePhaseDurations[FRAME_PHASE_OTHER] = _lastSwapTime != 0 ? renderStart - _lastSwapTime : 0;
+    _framePhaseDurations[FRAME_PHASE_SWAP] = _lastSwapDuration;
+
     // We want to have as much time as possible for uploading the textures,
     // so we start it right now.
+    _loopPhase = LOOP_PHASE_UPLOAD;
     bool expectedAtomicValue = false;
     if (!_doUploadTextures.compare_exchange_strong(expectedAtomicValue, false, std::memory_order_acq_rel))
     {
-        lock_guard<recursive_mutex> lockObjects(_objectsMutex);
-        for (auto& obj : _objects)
+        auto asyncUpload = _textureUploadThread.joinable();
+        {
+            lock_guard<recursive_mutex> lockObjects(_objectsMutex);
+            updateRenderGraph();
+
+            for (const auto& weakTexture : _renderGraphTextures)
+                if (auto texture = weakTexture.lock(); texture)
+                    texture->update();
+
+            // Images are uploaded by the upload thread, if it runs
+            vector<shared_ptr<Texture_Image>> images;
+            for (const auto& weakTexture : _renderGraphImages)
+            {
+                auto texture = weakTexture.lock();
+                if (!texture)
+                    continue;
+                texture->updateMipmapsNeeded();
+                images.push_back(texture);
+            }
+
+            if (!asyncUpload)
+            {
+                scheduleTextureUploads(images);
+                for (const auto& texture : images)
+                    texture->update();
+            }
+        }
+
+        if (asyncUpload)
         {
-            auto texture = dynamic_pointer_cast<Texture>(obj.second);
-            if (texture)
-                texture->update();
+            lock_guard<mutex> lockUpload(_textureUploadMutex);
+            _texturesToUpload = true;
+            _textureUploadCondition.notify_one();
         }
     }
+    _framePhaseDurations[FRAME_PHASE_UPLOAD] += Timer::getTime() - renderStart;
 
     {
 #ifdef PROFILE
         PROFILEGL("Render loop")
 #endif
-        // Create lists of objects to update and to render
-        map<GraphObject::Priority, vector<shared_ptr<GraphObject>>> objectList{};
         {
             lock_guard<recursive_mutex> lockObjects(_objectsMutex);
-            for (auto obj = _objects.cbegin(); obj != _objects.cend(); ++obj)
-            {
-                // We also run all pending tasks for every object
-                obj->second->runTasks();
+            // We run all pending tasks for every object, which may modify the objects
+            for (auto& obj : _objects)
+                obj.second->runTasks();
+            updateRenderGraph();
+        }
 
-                auto priority = obj->second->getRenderingPriority();
-                if (priority == GraphObject::Priority::NO_RENDER)
+        // Objects whose update does not touch the GPU are updated all at once on the thread pool,
+        // so that the render thread only updates and renders the others
+        {
+            const auto cpuUpdateStart = Timer::getTime();
+            pmr::vector<shared_ptr<GraphObject>> cpuUpdatedObjects(_frameArena.resource());
+            for (const auto& objPriority : _renderGraph)
+            {
+                if (_decoupleGui && objPriority.first == GraphObject::Priority::GUI)
                     continue;
-
-                auto listIt = objectList.find(priority);
-                if (listIt == objectList.end())
-                {
-                    auto entry = objectList.emplace(std::make_pair(priority, vector<shared_ptr<GraphObject>>()));
-                    if (entry.second == true)
-                        listIt = entry.first;
-                    else
-                        continue;
-                }
-
-                listIt->second.push_back(obj->second);
+                for (const auto& weakObj : objPriority.second)
+                    if (auto obj = weakObj.lock(); obj && obj->hasCpuOnlyUpdate())
+                        cpuUpdatedObjects.push_back(obj);
             }
+            ThreadPool::get().runParallel(cpuUpdatedObjects.size(), [&](unsigned int index) { cpuUpdatedObjects[index]->update(); });
+            _framePhaseDurations[FRAME_PHASE_UPLOAD] += Timer::getTime() - cpuUpdateStart;
+        }
+
+        if (_dynamicResolution)
+        {
+            if (!_gpuTimer)
+                _gpuTimer = make_unique<GpuTimer>(_name + " render loop");
+            _gpuTimer->begin();
         }
 
+        // GPU time is measured every few frames only, so that the readback cost stays negligible, or at every frame when tracing
+        bool profileGpu = (_gpuProfilingPeriod != 0 && _frameIndex % _gpuProfilingPeriod == 0) || TraceRecorder::get().isRecording();
+        ++_frameIndex;
+
         // Update and render the objects
         // See GraphObject::getRenderingPriority() for precision about priorities
-        for (auto& objPriority : objectList)
+        _loopPhase = LOOP_PHASE_RENDER;
+        for (auto& objPriority : _renderGraph)
         {
-            if (objPriority.second.size() != 0)
-                Timer::get() << objPriority.second[0]->getType();
-
-            for (auto& obj : objPriority.second)
+            if (_decoupleGui && objPriority.first == GraphObject::Priority::GUI)
+                continue;
+            // Blending maps are kept as they are while the watchdog skips their update
+            if (_watchdogSkipBlending && objPriority.first == GraphObject::Priority::BLENDING)
+                continue;
+
+            const auto priorityStart = Timer::getTime();
+            string timerName;
+            pmr::vector<shared_ptr<Camera>> cameras(_frameArena.resource());
+            for (const auto& weakObj : objPriority.second)
             {
+                auto obj = weakObj.lock();
+                if (!obj)
+                    continue;
+                if (_watchdogPauseSinks && objPriority.first == GraphObject::Priority::POST_CAMERA && (dynamic_pointer_cast<Sink>(obj) || dynamic_pointer_cast<Sink_Group>(obj)))
+                    continue;
+
+                if (timerName.empty())
+                {
+                    timerName = obj->getType();
+                    Timer::get() << timerName;
+                }
+
 #ifdef PROFILE
                 PROFILEGL("object " + obj->getName());
 #endif
-                obj->update();
+                if (!obj->hasCpuOnlyUpdate())
+                    obj->update();
 
                 auto objectCategory = obj->getCategory();
                 if (objectCategory == GraphObject::Category::MESH)
@@ -311,97 +479,1008 @@ void Scene::render()
                     if (obj->wasUpdated())
                         obj->setNotUpdated();
 
-                obj->render();
-            }
+                // Cameras are rendered together afterwards, so that those sharing objects can be batched
+                // Batching is skipped for profiled frames, to get the GPU time of each camera
+                if (_batchCameras && !profileGpu && objPriority.first == GraphObject::Priority::CAMERA)
+                    if (auto camera = dynamic_pointer_cast<Camera>(obj); camera)
+                    {
+                        cameras.push_back(camera);
+                        continue;
+                    }
+
+                if (profileGpu)
+                {
+                    auto& gpuTimer = _objectGpuTimers.try_emplace(obj->getName(), obj->getName()).first->second;
+                    gpuTimer.begin();
+                    obj->render();
+                    gpuTimer.end();
+                }
+                else
+                {
+                    obj->render();
+                }
+            }
+
+            if (!cameras.empty())
+                Camera::renderBatch(cameras);
+
+            if (!timerName.empty())
+                Timer::get() >> timerName;
+
+            auto phase = FRAME_PHASE_RENDER;
+            if (objPriority.first == GraphObject::Priority::MEDIA)
+                phase = FRAME_PHASE_UPLOAD;
+            else if (objPriority.first == GraphObject::Priority::BLENDING)
+                phase = FRAME_PHASE_BLENDING;
+            _framePhaseDurations[phase] += Timer::getTime() - priorityStart;
+        }
+
+        if (_gpuTimer)
+            _gpuTimer->end();
+        updateRenderScale();
+        updateGpuDurations();
+        updateFrameStatistics();
+        updateWindowFrameStatistics();
+
+        {
+#ifdef PROFILE
+            PROFILEGL("swap buffers");
+#endif
+            // Swap all buffers at once
+            _loopPhase = LOOP_PHASE_SWAP;
+            Timer::get() << swapProbe;
+            auto renderDuration = static_cast<double>(Timer::getTime() - renderStart);
+            _renderDurationEstimate = std::max(renderDuration, _renderDurationEstimate * SPLASH_SCENE_FRAME_PACING_DECAY);
+            swapWindows(renderStart);
+            Timer::get() >> swapProbe;
+
+            if (!_firstFrameSwapped && !_renderGraphWindows.empty())
+            {
+                _firstFrameSwapped = true;
+                BootTimeline::get().mark("first_frame");
+                // An inner Scene shares the boot timeline of the World, which ends it once all Scenes are up
+                if (_context.childProcess)
+                    BootTimeline::get().finish();
+            }
+
+            // Frames drawn during this loop are now shown
+            for (const auto& weakTexture : _renderGraphImages)
+                if (auto texture = weakTexture.lock(); texture)
+                    texture->setFramePresented();
+        }
+
+        if (_decoupleGui)
+        {
+            _loopPhase = LOOP_PHASE_GUI;
+            renderDecoupledGui();
+        }
+    }
+
+#ifdef PROFILE
+    ProfilerGL::get().gatherTimings();
+#endif
+}
+
+/*************/
+void Scene::updateGpuDurations()
+{
+    if (_gpuProfilingPeriod == 0)
+    {
+        _objectGpuTimers.clear();
+        return;
+    }
+
+    lock_guard<recursive_mutex> lockObjects(_objectsMutex);
+    for (auto timerIt = _objectGpuTimers.begin(); timerIt != _objectGpuTimers.end();)
+    {
+        auto path = "/" + _name + "/gpu/" + timerIt->first;
+        if (_objects.find(timerIt->first) == _objects.end())
+        {
+            if (_tree.hasLeafAt(path))
+                _tree.removeLeafAt(path);
+            timerIt = _objectGpuTimers.erase(timerIt);
+            continue;
+        }
+
+        if (auto duration = timerIt->second.getDuration(); duration)
+        {
+            if (!_tree.hasLeafAt(path))
+                _tree.createLeafAt(path);
+            _tree.setValueForLeafAt(path, Values({Value(static_cast<int64_t>(*duration))}));
+        }
+
+        ++timerIt;
+    }
+}
+
+/*************/
+void Scene::updateFrameStatistics()
+{
+    // Frames missed by all the windows, which are the frame drops seen by the audience
+    uint64_t missedFrames = 0;
+    for (const auto& weakWindow : _renderGraphWindows)
+        if (auto window = weakWindow.lock(); window)
+            missedFrames += window->getMissedFrames();
+    auto missedFramesPath = "/" + _name + "/stats/missed_frames";
+    if (_tree.hasLeafAt(missedFramesPath) || _tree.createLeafAt(missedFramesPath))
+        _tree.setValueForLeafAt(missedFramesPath, Values({Value(static_cast<int64_t>(missedFrames))}));
+
+    auto frameCountPath = "/" + _name + "/stats/frame_count";
+    if (_tree.hasLeafAt(frameCountPath) || _tree.createLeafAt(frameCountPath))
+        _tree.setValueForLeafAt(frameCountPath, Values({Value(static_cast<int64_t>(_frameIndex))}));
+
+    // The free GPU memory also accounts for other processes, and for what is not tracked by the objects
+    if ((_hasNvxMemoryInfo || _hasAtiMemInfo) && _frameIndex % SPLASH_SCENE_MEMORY_INFO_PERIOD == 0)
+    {
+        GLint freeMemory[4] = {0, 0, 0, 0}; // In kB
+        glGetIntegerv(_hasNvxMemoryInfo ? GL_GPU_MEMORY_INFO_CURRENT_AVAILABLE_VIDMEM_NVX : GL_TEXTURE_FREE_MEMORY_ATI, freeMemory);
+        auto availablePath = "/" + _name + "/stats/vram_available";
+        if (_tree.hasLeafAt(availablePath) || _tree.createLeafAt(availablePath))
+            _tree.setValueForLeafAt(availablePath, Values({Value(static_cast<int64_t>(freeMemory[0]) * 1024)}));
+    }
+}
+
+/*************/
+void Scene::swapWindows(int64_t renderStart)
+{
+    auto barrierStart = Timer::getTime();
+    waitForSwapBarrier();
+    _framePhaseDurations[FRAME_PHASE_SWAP] += Timer::getTime() - barrierStart;
+
+    // The phase which exceeded its usual duration the most is held responsible for a late frame
+    int dominantPhase = 0;
+    double largestExcess = std::numeric_limits<double>::lowest();
+    for (int phase = 0; phase < FRAME_PHASE_COUNT; ++phase)
+    {
+        auto excess = static_cast<double>(_framePhaseDurations[phase]) - _framePhaseAverages[phase];
+        if (excess > largestExcess)
+        {
+            largestExcess = excess;
+            dominantPhase = phase;
+        }
+        _framePhaseAverages[phase] = _framePhaseAverages[phase] * SPLASH_SCENE_FRAME_PHASE_DECAY + _framePhaseDurations[phase] * (1.0 - SPLASH_SCENE_FRAME_PHASE_DECAY);
+    }
+
+    auto swapStart = Timer::getTime();
+    for (const auto& weakWindow : _renderGraphWindows)
+    {
+        auto window = weakWindow.lock();
+        if (!window)
+            continue;
+
+        // Frames missed since the previous swap of this window are detected when issuing this one,
+        // they are the vertical blanks this frame was not ready for
+        auto missedFrames = window->getMissedFrames();
+        window->swapBuffers(renderStart);
+        if (auto newlyMissed = window->getMissedFrames() - missedFrames; newlyMissed != 0)
+            _windowLateFrames[window->getName()][dominantPhase] += newlyMissed;
+    }
+    _lastSwapTime = Timer::getTime();
+    _lastSwapDuration = _lastSwapTime - swapStart;
+}
+
+/*************/
+void Scene::updateWindowFrameStatistics()
+{
+    const auto framesPath = "/" + _name + "/frames";
+    if (!_tree.hasBranchAt(framesPath))
+        return;
+
+    auto setLeaf = [&](const string& path, const Value& value) {
+        if (_tree.hasLeafAt(path) || _tree.createLeafAt(path))
+            _tree.setValueForLeafAt(path, {value});
+    };
+
+    vector<string> windowNames;
+    for (const auto& weakWindow : _renderGraphWindows)
+    {
+        auto window = weakWindow.lock();
+        if (!window)
+            continue;
+
+        auto windowName = window->getName();
+        windowNames.push_back(windowName);
+        auto windowPath = framesPath + "/" + windowName;
+        if (!_tree.hasBranchAt(windowPath) && !_tree.createBranchAt(windowPath))
+            continue;
+
+        setLeaf(windowPath + "/missed_frames", static_cast<int64_t>(window->getMissedFrames()));
+        setLeaf(windowPath + "/render_to_present_p50", window->getRenderToPresent(50.0));
+        setLeaf(windowPath + "/render_to_present_p99", window->getRenderToPresent(99.0));
+
+        const auto& lateFrames = _windowLateFrames[windowName];
+        int dominantPhase = -1;
+        for (int phase = 0; phase < FRAME_PHASE_COUNT; ++phase)
+        {
+            setLeaf(windowPath + "/late_" + _framePhaseNames[phase], static_cast<int64_t>(lateFrames[phase]));
+            if (lateFrames[phase] != 0 && (dominantPhase == -1 || lateFrames[phase] > lateFrames[dominantPhase]))
+                dominantPhase = phase;
+        }
+        setLeaf(windowPath + "/late_reason", string(dominantPhase == -1 ? "" : _framePhaseNames[dominantPhase]));
+    }
+
+    for (const auto& branchName : _tree.getBranchListAt(framesPath))
+    {
+        if (find(windowNames.begin(), windowNames.end(), branchName) != windowNames.end())
+            continue;
+        _tree.removeBranchAt(framesPath + "/" + branchName);
+        _windowLateFrames.erase(branchName);
+    }
+}
+
+/*************/
+void Scene::paceFrame()
+{
+    // With a frame lock the swap barrier drives the timing, and without vsync there is no vertical blank to aim for
+    if (_frameLock || _runInBackground || _swapInterval < 1 || _lastSwapTime == 0)
+        return;
+
+    int64_t vblankInterval = 0;
+    for (const auto& weakWindow : _renderGraphWindows)
+    {
+        if (auto window = weakWindow.lock(); window)
+        {
+            vblankInterval = window->getVblankInterval();
+            if (vblankInterval != 0)
+                break;
+        }
+    }
+
+    // Without sync control, the swap returns right after the vertical blank and the target frame duration is the best guess
+    int64_t frameDuration = (vblankInterval != 0 ? vblankInterval : static_cast<int64_t>(_targetFrameDuration)) * _swapInterval;
+    if (frameDuration == 0)
+        return;
+
+    int64_t renderStart = _lastSwapTime + frameDuration - static_cast<int64_t>(_renderDurationEstimate) - SPLASH_SCENE_FRAME_PACING_MARGIN;
+    auto delay = renderStart - Timer::getTime();
+    if (delay > 0 && delay < frameDuration)
+        this_thread::sleep_for(chrono::microseconds(delay));
+}
+
+/*************/
+void Scene::updateRenderGraph()
+{
+    if (!_objectsChanged.exchange(false))
+        return;
+
+    _renderGraph.clear();
+    _renderGraphTextures.clear();
+    _renderGraphImages.clear();
+    _renderGraphWindows.clear();
+
+    for (const auto& obj : _objects)
+    {
+        if (auto image = dynamic_pointer_cast<Texture_Image>(obj.second); image)
+            _renderGraphImages.push_back(image);
+        else if (auto texture = dynamic_pointer_cast<Texture>(obj.second); texture)
+            _renderGraphTextures.push_back(texture);
+
+        if (obj.second->getType() == "window")
+            _renderGraphWindows.push_back(dynamic_pointer_cast<Window>(obj.second));
+
+        auto priority = obj.second->getRenderingPriority();
+        if (priority == GraphObject::Priority::NO_RENDER)
+            continue;
+        _renderGraph[priority].push_back(obj.second);
+    }
+}
+
+/*************/
+void Scene::renderDecoupledGui()
+{
+    auto guiIt = _renderGraph.find(GraphObject::Priority::GUI);
+    if (guiIt == _renderGraph.end() || guiIt->second.empty())
+        return;
+
+    // The GUI only gets the time left until the next frame has to start rendering, it is shown by its window at the next swap
+    if (_targetFrameDuration != 0 && _skippedGuiFrames < SPLASH_SCENE_GUI_MAX_SKIPPED_FRAMES)
+    {
+        auto timeLeft = static_cast<double>(_targetFrameDuration) - static_cast<double>(Timer::getTime() - _lastSwapTime) - _renderDurationEstimate;
+        if (_guiDurationEstimate > timeLeft)
+        {
+            ++_skippedGuiFrames;
+            return;
+        }
+    }
+    _skippedGuiFrames = 0;
+
+    const auto guiStart = Timer::getTime();
+    Timer::get() << "gui";
+    for (const auto& weakObj : guiIt->second)
+    {
+        auto obj = weakObj.lock();
+        if (!obj)
+            continue;
+        obj->update();
+        obj->render();
+    }
+    Timer::get() >> "gui";
+
+    const auto guiDuration = static_cast<double>(Timer::getTime() - guiStart);
+    _guiDurationEstimate = std::max(guiDuration, _guiDurationEstimate * SPLASH_SCENE_FRAME_PACING_DECAY);
+}
+
+/*************/
+void Scene::updateSampledImageRegions()
+{
+    auto now = chrono::steady_clock::now();
+    if (now - _lastSampledImageRegionsUpdate < chrono::milliseconds(SPLASH_SCENE_SAMPLED_REGIONS_PERIOD))
+        return;
+    _lastSampledImageRegionsUpdate = now;
+
+    const auto unite = [](optional<glm::dvec4>& region, const glm::dvec4& other) {
+        if (!region)
+            region = other;
+        else
+            region = glm::dvec4(glm::min((*region)[0], other[0]), glm::min((*region)[1], other[1]), glm::max((*region)[2], other[2]), glm::max((*region)[3], other[3]));
+    };
+
+    Values regions{_name};
+    Values resolutions{_name};
+    Values unsampledImages{_name};
+    {
+        lock_guard<recursive_mutex> lockObjects(_objectsMutex);
+
+        unordered_map<string, glm::dvec4> objectRegions;
+        unordered_map<string, glm::dvec2> objectDensities;
+        for (const auto& [name, obj] : _objects)
+        {
+            auto camera = dynamic_pointer_cast<Camera>(obj);
+            if (!camera)
+                continue;
+            Values hide;
+            if (camera->getAttribute("hide", hide) && !hide.empty() && hide[0].as<bool>())
+                continue;
+            for (const auto& [objectName, region] : camera->computeSampledUVRegions())
+            {
+                optional<glm::dvec4> objectRegion;
+                if (auto regionIt = objectRegions.find(objectName); regionIt != objectRegions.end())
+                    objectRegion = regionIt->second;
+                unite(objectRegion, region.region);
+                objectRegions[objectName] = objectRegion.value();
+                objectDensities[objectName] = glm::max(objectDensities[objectName], region.density);
+            }
+        }
+
+        // Add the region seen through the given parent of a texture, returns false if it can not be known
+        const auto addParentRegion = [&](GraphObject* parent, optional<glm::dvec4>& region) {
+            auto object = dynamic_cast<Object*>(parent);
+            if (!object)
+                return false;
+            if (auto regionIt = objectRegions.find(object->getName()); regionIt != objectRegions.end())
+                unite(region, regionIt->second);
+            return true;
+        };
+
+        // Same for the texture resolution needed by the given parent
+        const auto addParentDensity = [&](GraphObject* parent, glm::dvec2& density) {
+            auto object = dynamic_cast<Object*>(parent);
+            if (!object)
+                return false;
+            if (auto densityIt = objectDensities.find(object->getName()); densityIt != objectDensities.end())
+                density = glm::max(density, densityIt->second);
+            return true;
+        };
+
+        // Check whether the given parent of a texture is seen by a camera, consumers other than objects and filters being assumed to be visible
+        const auto isParentSampled = [&](GraphObject* parent) {
+            const auto isObjectSampled = [&](GraphObject* candidate) {
+                if (!dynamic_cast<Object*>(candidate))
+                    return true;
+                return objectRegions.find(candidate->getName()) != objectRegions.end();
+            };
+
+            auto filter = dynamic_cast<Filter*>(parent);
+            if (!filter)
+                return isObjectSampled(parent);
+            const auto& filterParents = filter->getParents();
+            return any_of(filterParents.begin(), filterParents.end(), isObjectSampled);
+        };
+
+        map<string, glm::dvec4> imageRegions;
+        map<string, glm::dvec2> imageDensities;
+        map<string, bool> sampledImages;
+        for (const auto& [name, obj] : _objects)
+        {
+            auto texture = dynamic_pointer_cast<Texture_Image>(obj);
+            if (!texture)
+                continue;
+            auto image = texture->getImage();
+            if (!image)
+                continue;
+
+            const auto& parents = texture->getParents();
+            sampledImages[image->getName()] = sampledImages[image->getName()] || any_of(parents.begin(), parents.end(), isParentSampled);
+
+            // Only objects, directly or through a filter which does not move the texture, are known to sample the
+            // texture with their UV coordinates. Anything else needs the whole image.
+            optional<glm::dvec4> region;
+            glm::dvec2 density{0.0};
+            bool wholeImage = false;
+            for (auto parent : texture->getParents())
+            {
+                if (addParentRegion(parent, region))
+                {
+                    addParentDensity(parent, density);
+                    continue;
+                }
+
+                auto filter = dynamic_cast<Filter*>(parent);
+                Values scale;
+                if (filter && filter->getType() == "filter" && filter->getAttribute("scale", scale) && scale.size() == 2 && scale[0].as<float>() == 1.f &&
+                    scale[1].as<float>() == 1.f)
+                {
+                    for (auto filterParent : filter->getParents())
+                        wholeImage = !addParentRegion(filterParent, region) || !addParentDensity(filterParent, density) || wholeImage;
+                    continue;
+                }
+
+                wholeImage = true;
+            }
+
+            // The resolution is only known for the textures sampled by objects
+            if (wholeImage)
+                density = glm::dvec2(numeric_limits<double>::infinity());
+            imageDensities[image->getName()] = glm::max(imageDensities[image->getName()], density);
+
+            // UV coordinates outside of the image wrap around it
+            if (region && ((*region)[0] < 0.0 || (*region)[1] < 0.0 || (*region)[2] > 1.0 || (*region)[3] > 1.0))
+                wholeImage = true;
+            if (!region || wholeImage)
+                region = glm::dvec4(0.0, 0.0, 1.0, 1.0);
+
+            Values flip, flop;
+            image->getAttribute("flip", flip);
+            image->getAttribute("flop", flop);
+            if (!flop.empty() && flop[0].as<bool>())
+                region = glm::dvec4(1.0 - (*region)[2], (*region)[1], 1.0 - (*region)[0], (*region)[3]);
+            if (!flip.empty() && flip[0].as<bool>())
+                region = glm::dvec4((*region)[0], 1.0 - (*region)[3], (*region)[2], 1.0 - (*region)[1]);
+
+            auto margin = glm::dvec4(-SPLASH_SCENE_SAMPLED_REGIONS_MARGIN, -SPLASH_SCENE_SAMPLED_REGIONS_MARGIN, SPLASH_SCENE_SAMPLED_REGIONS_MARGIN, SPLASH_SCENE_SAMPLED_REGIONS_MARGIN);
+            region = glm::clamp(*region + margin, glm::dvec4(0.0), glm::dvec4(1.0));
+
+            // Textures set from the same image can be sampled differently
+            optional<glm::dvec4> imageRegion;
+            if (auto regionIt = imageRegions.find(image->getName()); regionIt != imageRegions.end())
+                imageRegion = regionIt->second;
+            unite(imageRegion, region.value());
+            imageRegions[image->getName()] = imageRegion.value();
+        }
+
+        for (const auto& [imageName, region] : imageRegions)
+            regions.push_back(Values({imageName, region[0], region[1], region[2], region[3]}));
+
+        // A null resolution means that the whole image resolution is needed, as is the case for
+        // the images shown in the GUI of the master Scene
+        const auto guiVisible = _isMaster && _gui && _gui->isVisible();
+        for (const auto& [imageName, density] : imageDensities)
+        {
+            if (guiVisible || !isfinite(density.x) || !isfinite(density.y))
+            {
+                resolutions.push_back(Values({imageName, 0, 0}));
+                continue;
+            }
+
+            const auto roundUp = [](double value) { return static_cast<int>(ceil(value / SPLASH_SCENE_SAMPLED_RESOLUTION_STEP)) * SPLASH_SCENE_SAMPLED_RESOLUTION_STEP; };
+            resolutions.push_back(Values({imageName, roundUp(density.x), roundUp(density.y)}));
+        }
+
+        // The master Scene shows the images in its GUI, it needs all of them entirely while it is visible
+        _hiddenImages.clear();
+        if (!guiVisible)
+        {
+            for (const auto& [imageName, sampled] : sampledImages)
+            {
+                if (!sampled)
+                {
+                    unsampledImages.push_back(imageName);
+                    _hiddenImages.insert(imageName);
+                }
+            }
+        }
+    }
+
+    if (unsampledImages != _unsampledImages)
+    {
+        _unsampledImages = unsampledImages;
+        sendMessageToWorld("unsampledImages", unsampledImages);
+    }
+
+    if (resolutions != _sampledImageResolutions)
+    {
+        _sampledImageResolutions = resolutions;
+        sendMessageToWorld("sampledImageResolutions", resolutions);
+    }
+
+    if (_isMaster || regions == _sampledImageRegions)
+        return;
+    _sampledImageRegions = regions;
+    sendMessageToWorld("sampledImageRegions", regions);
+}
+
+/*************/
+void Scene::run()
+{
+    static const auto treeProcessProbe = Timer::get().getProbe("tree_process");
+    static const auto loopSceneProbe = Timer::get().getProbe("loop_scene");
+    static const auto renderingProbe = Timer::get().getProbe("rendering");
+    static const auto inputsUpdateProbe = Timer::get().getProbe("inputsUpdate");
+    static const auto treeUpdateProbe = Timer::get().getProbe("tree_update");
+    static const auto treePropagateProbe = Timer::get().getProbe("tree_propagate");
+
+    if (!_mainWindow)
+    {
+        Log::get() << Log::ERROR << "Scene::" << __FUNCTION__ << " - No rendering context has been created" << Log::endl;
+        return;
+    }
+
+    startTextureUpload();
+    startClockSync();
+    startWatchdog();
+
+    // Inner Scenes share the process of the World, which then gives its name to the process
+    TraceRecorder::get().setProcessName(_name);
+    TraceRecorder::get().setThreadName(_name);
+    BootTimeline::get().setThreadOwner(_name);
+    BootTimeline::get().mark("scene_loop_start");
+
+    _mainWindow->setAsCurrentContext();
+    while (_isRunning)
+    {
+        if (!Utils::applyThreadClass(Utils::ThreadClass::render))
+            Log::get() << Log::WARNING << "Scene::" << __FUNCTION__ << " - Unable to apply the scheduling of the render threads" << Log::endl;
+
+        // Temporaries of the previous loop are all dead by now
+        _frameArena.reset();
+
+        const auto loopStart = Timer::getTime();
+        _loopHeartbeat = loopStart;
+
+        // Process tree updates
+        _loopPhase = LOOP_PHASE_TREE_PROCESS;
+        Timer::get() << treeProcessProbe;
+        _tree.processQueue();
+        Timer::get() >> treeProcessProbe;
+
+        // This gets the whole loop duration
+        if (_runInBackground && _swapInterval != 0)
+        {
+            // Artificial synchronization to avoid overloading the GPU in hidden mode
+            Timer::get() >> _targetFrameDuration >> "swap_sync";
+            Timer::get() << "swap_sync";
+        }
+
+        Timer::get() >> loopSceneProbe;
+        Timer::get() << loopSceneProbe;
+
+        // Execute waiting tasks
+        _loopPhase = LOOP_PHASE_TASKS;
+        executeTreeCommands();
+        runTasks();
+
+        if (_started)
+        {
+            // Inputs are consumed at frame start so that they affect the frame about to be rendered.
+            // Event polling has to stay on this thread, as GLFW requires it to be done from the main one.
+            _loopPhase = LOOP_PHASE_INPUTS;
+            Timer::get() << inputsUpdateProbe;
+            updateInputs();
+            Timer::get() >> inputsUpdateProbe;
+
+            Timer::get() << renderingProbe;
+            render();
+            Timer::get() >> renderingProbe;
+
+            updateSampledImageRegions();
+        }
+        else
+        {
+            this_thread::sleep_for(chrono::milliseconds(50));
+        }
+
+        // Right after the swap, to leave as much time as possible before the next one
+        _loopPhase = LOOP_PHASE_TREE_UPDATE;
+        destroyReleasedObjects();
+
+        Timer::get() << treeUpdateProbe;
+        updateTreeFromObjects();
+        Timer::get() >> treeUpdateProbe;
+        Timer::get() << treePropagateProbe;
+        propagateTree();
+        Timer::get() >> treePropagateProbe;
+
+        if (_started)
+            updateWatchdog(Timer::getTime() - loopStart);
+    }
+    destroyReleasedObjects(true);
+    _mainWindow->releaseContext();
+
+    stopTextureUpload();
+    stopClockSync();
+    stopWatchdog();
+    signalBufferObjectUpdated();
+
+    // Clean the tree from anything related to this Scene
+    _tree.cutBranchAt("/" + _name);
+    propagateTree();
+
+#ifdef PROFILE
+    ProfilerGL::get().processTimings();
+    ProfilerGL::get().processFlamegraph("/tmp/splash_profiling_data_" + _name);
+#endif
+}
+
+/*************/
+void Scene::releaseObject(shared_ptr<GraphObject>&& object)
+{
+    if (!object)
+        return;
+
+    // The object's name can be reused before it is destroyed
+    object->detachFromTree();
+
+    lock_guard<mutex> lock(_deferredReleaseMutex);
+    if (dynamic_pointer_cast<Image>(object) || dynamic_pointer_cast<Mesh>(object))
+        _deferredCpuObjects.push_back(std::move(object));
+    else
+        _deferredGlObjects.push_back(std::move(object));
+}
+
+/*************/
+void Scene::destroyReleasedObjects(bool flush)
+{
+    vector<shared_ptr<GraphObject>> glObjects;
+    bool hasCpuObjects = false;
+    {
+        lock_guard<mutex> lock(_deferredReleaseMutex);
+        auto count = flush ? _deferredGlObjects.size() : min<size_t>(_deferredGlObjects.size(), SPLASH_SCENE_GL_RELEASE_BATCH);
+        glObjects.insert(glObjects.end(), make_move_iterator(_deferredGlObjects.begin()), make_move_iterator(_deferredGlObjects.begin() + count));
+        _deferredGlObjects.erase(_deferredGlObjects.begin(), _deferredGlObjects.begin() + count);
+        hasCpuObjects = !_deferredCpuObjects.empty();
+    }
+
+    // A single worker job at a time, it takes all the objects released until it runs
+    bool isWorkerBusy = _deferredReleaseFuture.valid() && _deferredReleaseFuture.wait_for(chrono::seconds(0)) != future_status::ready;
+    if (hasCpuObjects && !isWorkerBusy)
+    {
+        _deferredReleaseFuture = ThreadPool::get().enqueue([this]() {
+            vector<shared_ptr<GraphObject>> cpuObjects;
+            {
+                lock_guard<mutex> lock(_deferredReleaseMutex);
+                swap(cpuObjects, _deferredCpuObjects);
+            }
+        });
+    }
+
+    if (flush && _deferredReleaseFuture.valid())
+    {
+        _deferredReleaseFuture.wait();
+        lock_guard<mutex> lock(_deferredReleaseMutex);
+        _deferredCpuObjects.clear();
+    }
+
+    // Objects holding GL resources are destroyed when leaving this scope
+}
+
+/*************/
+void Scene::startTextureUpload()
+{
+    // The upload window is not created through getNewSharedWindow, as it should not join any swap group
+    glfwWindowHint(GLFW_VISIBLE, false);
+    GLFWwindow* window = glfwCreateWindow(32, 32, "Splash::TextureUpload", NULL, _mainWindow->get());
+    if (!window)
+    {
+        Log::get() << Log::WARNING << "Scene::" << __FUNCTION__ << " - Unable to create the texture upload context, textures will be uploaded from the render loop" << Log::endl;
+        return;
+    }
+
+    _textureUploadWindow = make_shared<GlWindow>(window, _mainWindow->get());
+    _textureUploadThread = thread([&]() { textureUploadLoop(); });
+}
+
+/*************/
+void Scene::stopTextureUpload()
+{
+    if (!_textureUploadThread.joinable())
+        return;
+
+    {
+        lock_guard<mutex> lockUpload(_textureUploadMutex);
+        _textureUploadCondition.notify_one();
+    }
+    _textureUploadThread.join();
+    _textureUploadWindow.reset();
+}
+
+/*************/
+void Scene::startClockSync()
+{
+    _clockSyncThread = thread([&]() {
+        ClockSync clockSync;
+        uint32_t exchanges = 0;
+        while (_isRunning)
+        {
+            auto localSend = Timer::getTime();
+            auto answer = queryWorldAttributes({{"world", "clock"}}, SPLASH_SCENE_CLOCK_SYNC_TIMEOUT);
+            auto localReceive = Timer::getTime();
+
+            if (answer.size() == 1 && answer[0].getType() == Value::Type::values && answer[0].size() == 1)
+            {
+                auto hadOffset = clockSync.isSynchronized();
+                if (clockSync.addSample(localSend, answer[0].as<Values>()[0].as<int64_t>(), localReceive))
+                {
+                    Timer::get().setClockOffset(clockSync.getOffset());
+                    if (!hadOffset)
+                        Log::get() << Log::MESSAGE << "Scene::" << __FUNCTION__ << " - Clock offset to the World: " << clockSync.getOffset() << "us" << Log::endl;
+                }
+            }
+
+            ++exchanges;
+            auto period = exchanges < SPLASH_SCENE_CLOCK_SYNC_BURST ? chrono::milliseconds(0) : chrono::milliseconds(SPLASH_SCENE_CLOCK_SYNC_PERIOD);
+            unique_lock<mutex> lock(_clockSyncMutex);
+            _clockSyncCondition.wait_for(lock, period, [&]() { return !_isRunning; });
+        }
+    });
+}
+
+/*************/
+void Scene::stopClockSync()
+{
+    if (!_clockSyncThread.joinable())
+        return;
+
+    {
+        lock_guard<mutex> lock(_clockSyncMutex);
+        _clockSyncCondition.notify_one();
+    }
+    _clockSyncThread.join();
+}
+
+/*************/
+void Scene::startWatchdog()
+{
+    _watchdogThread = thread([&]() {
+        int64_t reportedHeartbeat = 0;
+        while (_isRunning)
+        {
+            {
+                unique_lock<mutex> lock(_watchdogMutex);
+                _watchdogCondition.wait_for(lock, chrono::milliseconds(SPLASH_SCENE_WATCHDOG_PERIOD), [&]() { return !_isRunning; });
+            }
+            if (!_isRunning)
+                break;
+
+            // A stall is reported once, and its end once the loop starts again
+            const auto heartbeat = _loopHeartbeat.load();
+            const auto now = Timer::getTime();
+            if (reportedHeartbeat != 0 && heartbeat != reportedHeartbeat)
+            {
+                Log::get() << Log::MESSAGE << "Scene::" << __FUNCTION__ << " - Render loop of Scene " << _name << " running again after "
+                           << (heartbeat - reportedHeartbeat) / 1000 << "ms" << Log::endl;
+                reportedHeartbeat = 0;
+            }
+
+            if (heartbeat != 0 && heartbeat != reportedHeartbeat && now - heartbeat > SPLASH_SCENE_WATCHDOG_STALL * 1000)
+            {
+                Log::get() << Log::WARNING << "Scene::" << __FUNCTION__ << " - Render loop of Scene " << _name << " stalled for " << (now - heartbeat) / 1000 << "ms, during "
+                           << _loopPhaseNames[_loopPhase.load()] << Log::endl;
+                reportedHeartbeat = heartbeat;
+                _loopStalled = true;
+            }
+        }
+    });
+}
+
+/*************/
+void Scene::stopWatchdog()
+{
+    if (!_watchdogThread.joinable())
+        return;
+
+    {
+        lock_guard<mutex> lock(_watchdogMutex);
+        _watchdogCondition.notify_one();
+    }
+    _watchdogThread.join();
+}
 
-            if (objPriority.second.size() != 0)
-                Timer::get() >> objPriority.second[0]->getType();
-        }
+/*************/
+void Scene::updateWatchdog(int64_t loopDuration)
+{
+    const auto stalled = _loopStalled.exchange(false);
+    if (!_watchdog || _watchdogDegradations.empty())
+    {
+        setWatchdogLevel(0);
+        return;
+    }
+
+    auto budget = static_cast<double>(_targetFrameDuration * std::max(1, _swapInterval));
+    if (budget == 0.0)
+        return;
 
+    auto level = _watchdogLevel;
+    if (stalled)
+    {
+        // A stall is dealt with right away, without waiting for more loops over budget
+        level = std::min(_watchdogLevel + 1, static_cast<int>(_watchdogDegradations.size()));
+        _watchdogOverBudgetLoops = 0;
+        _watchdogUnderBudgetLoops = 0;
+    }
+    else if (loopDuration > budget * SPLASH_SCENE_WATCHDOG_HIGH)
+    {
+        _watchdogUnderBudgetLoops = 0;
+        if (++_watchdogOverBudgetLoops >= SPLASH_SCENE_WATCHDOG_DEGRADE_FRAMES)
         {
-#ifdef PROFILE
-            PROFILEGL("swap buffers");
-#endif
-            // Swap all buffers at once
-            Timer::get() << "swap";
-            for (auto& obj : _objects)
-                if (obj.second->getType() == "window")
-                    dynamic_pointer_cast<Window>(obj.second)->swapBuffers();
-            Timer::get() >> "swap";
+            level = std::min(_watchdogLevel + 1, static_cast<int>(_watchdogDegradations.size()));
+            _watchdogOverBudgetLoops = 0;
+        }
+    }
+    else if (loopDuration < budget * SPLASH_SCENE_WATCHDOG_LOW)
+    {
+        _watchdogOverBudgetLoops = 0;
+        if (++_watchdogUnderBudgetLoops >= SPLASH_SCENE_WATCHDOG_RESTORE_FRAMES)
+        {
+            level = std::max(_watchdogLevel - 1, 0);
+            _watchdogUnderBudgetLoops = 0;
         }
     }
+    else
+    {
+        _watchdogOverBudgetLoops = 0;
+        _watchdogUnderBudgetLoops = 0;
+    }
 
-#ifdef PROFILE
-    ProfilerGL::get().gatherTimings();
-#endif
+    setWatchdogLevel(level);
 }
 
 /*************/
-void Scene::run()
+void Scene::setWatchdogLevel(int level)
 {
-    if (!_mainWindow)
-    {
-        Log::get() << Log::ERROR << "Scene::" << __FUNCTION__ << " - No rendering context has been created" << Log::endl;
+    level = std::clamp(level, 0, static_cast<int>(_watchdogDegradations.size()));
+    if (level == _watchdogLevel)
         return;
+
+    // Degradations are applied in the order they are listed, the first ones being the first applied
+    bool skipBlending = false;
+    bool pauseSinks = false;
+    bool lowerProbes = false;
+    for (int i = 0; i < level; ++i)
+    {
+        if (_watchdogDegradations[i] == "blending")
+            skipBlending = true;
+        else if (_watchdogDegradations[i] == "sinks")
+            pauseSinks = true;
+        else if (_watchdogDegradations[i] == "probes")
+            lowerProbes = true;
     }
 
-    _mainWindow->setAsCurrentContext();
-    while (_isRunning)
+    if (level > _watchdogLevel)
+        Log::get() << Log::WARNING << "Scene::" << __FUNCTION__ << " - Scene " << _name << " over its frame budget, degrading " << _watchdogDegradations[level - 1] << Log::endl;
+    else
+        Log::get() << Log::MESSAGE << "Scene::" << __FUNCTION__ << " - Scene " << _name << " back within its frame budget, restoring " << _watchdogDegradations[level] << Log::endl;
+
+    _watchdogLevel = level;
+    _watchdogSkipBlending = skipBlending;
+    _watchdogPauseSinks = pauseSinks;
+    if (_watchdogLowerProbes != lowerProbes)
     {
-        // Process tree updates
-        Timer::get() << "tree_process";
-        _tree.processQueue();
-        Timer::get() >> "tree_process";
+        _watchdogLowerProbes = lowerProbes;
+        lock_guard<recursive_mutex> lockObjects(_objectsMutex);
+        for (const auto& obj : _objects)
+            if (auto probe = dynamic_pointer_cast<VirtualProbe>(obj.second); probe)
+                probe->setRenderScale(getProbeRenderScale());
+    }
 
-        // This gets the whole loop duration
-        if (_runInBackground && _swapInterval != 0)
+    auto levelPath = "/" + _name + "/stats/degradation_level";
+    if (_tree.hasLeafAt(levelPath) || _tree.createLeafAt(levelPath))
+        _tree.setValueForLeafAt(levelPath, Values({Value(static_cast<int64_t>(_watchdogLevel))}));
+}
+
+/*************/
+float Scene::getProbeRenderScale() const
+{
+    return _watchdogLowerProbes ? std::min(_renderScale, SPLASH_SCENE_WATCHDOG_PROBE_SCALE) : _renderScale;
+}
+
+/*************/
+void Scene::waitForSwapBarrier()
+{
+    if (!_frameLock || _hasNVSwapGroup || _renderGraphWindows.empty())
+        return;
+
+    unique_lock<mutex> lock(_swapBarrierMutex);
+    auto generation = _swapBarrierGeneration;
+    lock.unlock();
+
+    sendMessageToWorld("swapReady", {_name});
+
+    lock.lock();
+    auto released = _swapBarrierCondition.wait_for(
+        lock, chrono::microseconds(SPLASH_SCENE_SWAP_BARRIER_TIMEOUT), [&]() { return _swapBarrierGeneration != generation || !_isRunning; });
+    auto presentationTime = _swapPresentationTime;
+    lock.unlock();
+
+    if (!released)
+    {
+        auto now = chrono::steady_clock::now();
+        if (now - _lastSwapBarrierWarning > chrono::seconds(1))
         {
-            // Artificial synchronization to avoid overloading the GPU in hidden mode
-            Timer::get() >> _targetFrameDuration >> "swap_sync";
-            Timer::get() << "swap_sync";
+            Log::get() << Log::WARNING << "Scene::" << __FUNCTION__ << " - Swap barrier timed out, swapping without waiting for the other Scenes" << Log::endl;
+            _lastSwapBarrierWarning = now;
         }
+        return;
+    }
 
-        Timer::get() >> "loop_scene";
-        Timer::get() << "loop_scene";
+    // All Scenes received the release at slightly different times, they all wait for the same shared clock time
+    auto delay = presentationTime - Timer::get().getSharedTime();
+    if (delay > 0 && delay < SPLASH_SCENE_SWAP_BARRIER_TIMEOUT)
+        this_thread::sleep_for(chrono::microseconds(delay));
+}
 
-        // Execute waiting tasks
-        executeTreeCommands();
-        runTasks();
+/*************/
+void Scene::textureUploadLoop()
+{
+    _textureUploadWindow->setAsCurrentContext();
+    while (true)
+    {
+        if (!Utils::applyThreadClass(Utils::ThreadClass::render))
+            Log::get() << Log::WARNING << "Scene::" << __FUNCTION__ << " - Unable to apply the scheduling of the render threads" << Log::endl;
 
-        if (_started)
         {
-            Timer::get() << "rendering";
-            render();
-            Timer::get() >> "rendering";
-
-            Timer::get() << "inputsUpdate";
-            updateInputs();
-            Timer::get() >> "inputsUpdate";
+            unique_lock<mutex> lockUpload(_textureUploadMutex);
+            _textureUploadCondition.wait(lockUpload, [&]() { return _texturesToUpload || !_isRunning; });
+            if (!_isRunning)
+                break;
+            _texturesToUpload = false;
         }
-        else
+
+        vector<shared_ptr<Texture_Image>> textures;
         {
-            this_thread::sleep_for(chrono::milliseconds(50));
+            lock_guard<recursive_mutex> lockObjects(_objectsMutex);
+            for (const auto& weakTexture : _renderGraphImages)
+                if (auto texture = weakTexture.lock(); texture)
+                    textures.push_back(texture);
+            scheduleTextureUploads(textures);
         }
 
-        Timer::get() << "tree_update";
-        updateTreeFromObjects();
-        Timer::get() >> "tree_update";
-        Timer::get() << "tree_propagate";
-        propagateTree();
-        Timer::get() >> "tree_propagate";
+        // Each texture sets a fence after being updated, which is waited for when it is bound for rendering
+        Timer::get() << "texture_upload";
+        for (auto& texture : textures)
+            texture->update();
+        Timer::get() >> "texture_upload";
     }
-    _mainWindow->releaseContext();
+    _textureUploadWindow->releaseContext();
+}
 
-    signalBufferObjectUpdated();
+/*************/
+void Scene::scheduleTextureUploads(const vector<shared_ptr<Texture_Image>>& textures)
+{
+    _uploadScheduler.setBudget(static_cast<size_t>(std::max(0, _uploadBudget.load())) << 20);
 
-    // Clean the tree from anything related to this Scene
-    _tree.cutBranchAt("/" + _name);
-    propagateTree();
+    // Video frames, either from live inputs or from playing media, go before still images
+    vector<UploadScheduler::Request> requests;
+    requests.reserve(textures.size());
+    for (const auto& texture : textures)
+    {
+        auto image = texture->getImage();
+        const bool live = image && image->getSpec().videoFrame;
+        const bool hidden = image && _hiddenImages.count(image->getName());
+
+        UploadScheduler::Request request;
+        request.name = texture->getName();
+        request.size = texture->getPendingUploadSize();
+        request.splittable = texture->canUploadInParts();
+        if (hidden)
+            request.priority = live ? UploadScheduler::Priority::HiddenLive : UploadScheduler::Priority::HiddenStill;
+        else
+            request.priority = live ? UploadScheduler::Priority::VisibleLive : UploadScheduler::Priority::VisibleStill;
+        requests.push_back(request);
+    }
 
-#ifdef PROFILE
-    ProfilerGL::get().processTimings();
-    ProfilerGL::get().processFlamegraph("/tmp/splash_profiling_data_" + _name);
-#endif
+    auto budgets = _uploadScheduler.schedule(requests);
+    for (size_t index = 0; index < textures.size(); ++index)
+        textures[index]->setUploadBudget(budgets[index]);
 }
 
 /*************/
@@ -469,6 +1548,8 @@ void Scene::setAsMaster(const string& configFilePath)
     _geometricCalibrator->setName("geometricCalibrator");
     _objects["geometricCalibrator"] = _geometricCalibrator;
 #endif
+
+    signalObjectsChanged();
 }
 
 /*************/
@@ -483,6 +1564,12 @@ Values Scene::sendMessageToWorldWithAnswer(const string& message, const Values&
     return sendMessageWithAnswer("world", message, value, timeout);
 }
 
+/*************/
+Values Scene::queryWorldAttributes(const vector<pair<string, string>>& attributes, const unsigned long long timeout)
+{
+    return queryAttributes("world", attributes, timeout);
+}
+
 /*************/
 shared_ptr<GlWindow> Scene::getNewSharedWindow(const string& name)
 {
@@ -542,18 +1629,13 @@ shared_ptr<GlWindow> Scene::getNewSharedWindow(const string& name)
 /*************/
 vector<int> Scene::findGLVersion()
 {
+    BootStep bootStep("gl_version_probe");
     vector<vector<int>> glVersionList{{4, 5}};
     vector<int> detectedVersion{0, 0};
 
     for (auto version : glVersionList)
     {
-        glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, version[0]);
-        glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, version[1]);
-        glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
-        glfwWindowHint(GLFW_SRGB_CAPABLE, GL_TRUE);
-        glfwWindowHint(GLFW_DEPTH_BITS, 24);
-        glfwWindowHint(GLFW_VISIBLE, false);
-        GLFWwindow* window = glfwCreateWindow(512, 512, "test_window", NULL, NULL);
+        GLFWwindow* window = createMainGLFWWindow(version, "test_window");
 
         if (window)
         {
@@ -566,11 +1648,38 @@ vector<int> Scene::findGLVersion()
     return detectedVersion;
 }
 
+/*************/
+GLFWwindow* Scene::createMainGLFWWindow(const vector<int>& glVersion, const string& name)
+{
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, glVersion[0]);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, glVersion[1]);
+    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+#ifdef DEBUGGL
+    glfwWindowHint(GLFW_OPENGL_DEBUG_CONTEXT, true);
+#else
+    glfwWindowHint(GLFW_OPENGL_DEBUG_CONTEXT, false);
+#endif
+    glfwWindowHint(GLFW_SRGB_CAPABLE, GL_TRUE);
+    glfwWindowHint(GLFW_DEPTH_BITS, 24);
+    glfwWindowHint(GLFW_VISIBLE, false);
+
+    return glfwCreateWindow(512, 512, name.c_str(), NULL, NULL);
+}
+
 /*************/
 void Scene::init(const string& name)
 {
     glfwSetErrorCallback(Scene::glfwErrorCallback);
 
+    // Headless Scenes need no display server, the windows being only virtual
+#if GLFW_VERSION_MAJOR > 3 || (GLFW_VERSION_MAJOR == 3 && GLFW_VERSION_MINOR >= 4)
+    if (_context.headless)
+        glfwInitHint(GLFW_PLATFORM, GLFW_PLATFORM_NULL);
+#else
+    if (_context.headless)
+        Log::get() << Log::WARNING << "Scene::" << __FUNCTION__ << " - Headless rendering needs GLFW 3.4 or later, a display server is still needed" << Log::endl;
+#endif
+
     // GLFW stuff
     if (!glfwInit())
     {
@@ -579,30 +1688,46 @@ void Scene::init(const string& name)
         return;
     }
 
-    auto glVersion = findGLVersion();
-    if (glVersion[0] == 0)
+    // Window hints are kept for all the windows created afterwards, including those of the Window objects
+    if (_context.headless)
     {
-        Log::get() << Log::ERROR << "Scene::" << __FUNCTION__ << " - Unable to find a suitable GL version (higher than 4.3)" << Log::endl;
-        _isInitialized = false;
-        return;
+        glfwWindowHint(GLFW_CONTEXT_CREATION_API, GLFW_EGL_CONTEXT_API);
+        Log::get() << Log::MESSAGE << "Scene::" << __FUNCTION__ << " - Contexts are created through EGL" << Log::endl;
     }
 
-    _glVersion = glVersion;
-    Log::get() << Log::MESSAGE << "Scene::" << __FUNCTION__ << " - GL version: " << glVersion[0] << "." << glVersion[1] << Log::endl;
+    // The GL version found by a previous Scene on the same display and driver is tried directly,
+    // so that no trial window is created unless it does not work anymore
+    const auto capabilitiesKey = GlCapabilities::getCacheKey(_context.headless);
+    auto cachedCapabilities = GlCapabilities::readFromCache(capabilitiesKey);
 
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, glVersion[0]);
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, glVersion[1]);
-    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
-#ifdef DEBUGGL
-    glfwWindowHint(GLFW_OPENGL_DEBUG_CONTEXT, true);
-#else
-    glfwWindowHint(GLFW_OPENGL_DEBUG_CONTEXT, false);
-#endif
-    glfwWindowHint(GLFW_SRGB_CAPABLE, GL_TRUE);
-    glfwWindowHint(GLFW_DEPTH_BITS, 24);
-    glfwWindowHint(GLFW_VISIBLE, false);
+    GLFWwindow* window = nullptr;
+    vector<int> glVersion{0, 0};
+    if (cachedCapabilities)
+    {
+        glVersion = cachedCapabilities->glVersion;
+        window = createMainGLFWWindow(glVersion, name);
+        if (!window)
+        {
+            Log::get() << Log::MESSAGE << "Scene::" << __FUNCTION__ << " - Cached GL version " << glVersion[0] << "." << glVersion[1] << " is not available anymore, probing again" << Log::endl;
+            cachedCapabilities.reset();
+        }
+    }
+
+    if (!window)
+    {
+        glVersion = findGLVersion();
+        if (glVersion[0] == 0)
+        {
+            Log::get() << Log::ERROR << "Scene::" << __FUNCTION__ << " - Unable to find a suitable GL version (higher than 4.3)" << Log::endl;
+            _isInitialized = false;
+            return;
+        }
+
+        window = createMainGLFWWindow(glVersion, name);
+    }
 
-    GLFWwindow* window = glfwCreateWindow(512, 512, name.c_str(), NULL, NULL);
+    _glVersion = glVersion;
+    Log::get() << Log::MESSAGE << "Scene::" << __FUNCTION__ << " - GL version: " << glVersion[0] << "." << glVersion[1] << Log::endl;
 
     if (!window)
     {
@@ -617,9 +1742,21 @@ void Scene::init(const string& name)
     _mainWindow->setAsCurrentContext();
     gladLoadGLLoader((GLADloadproc)glfwGetProcAddress);
 
-    // Get hardware information
-    _glVendor = std::string(reinterpret_cast<const char*>(glGetString(GL_VENDOR)));
-    _glRenderer = std::string(reinterpret_cast<const char*>(glGetString(GL_RENDERER)));
+    // Get hardware information, the extensions and limits being taken from the cache if the driver did not change
+    auto capabilities = GlCapabilities::queryIdentity(glVersion);
+    if (cachedCapabilities && cachedCapabilities->isSameImplementation(capabilities))
+    {
+        capabilities = *cachedCapabilities;
+    }
+    else
+    {
+        capabilities.queryExtensionsAndLimits();
+        GlCapabilities::writeToCache(capabilitiesKey, capabilities);
+    }
+
+    _glVendor = capabilities.vendor;
+    _glRenderer = capabilities.renderer;
+    _glMaxTextureSize = capabilities.maxTextureSize;
     Log::get() << Log::MESSAGE << "Scene::" << __FUNCTION__ << " - GL vendor: " << _glVendor << Log::endl;
     Log::get() << Log::MESSAGE << "Scene::" << __FUNCTION__ << " - GL renderer: " << _glRenderer << Log::endl;
 
@@ -644,12 +1781,31 @@ void Scene::init(const string& name)
             _hasNVSwapGroup = true;
     }
 #endif
+
+    _hasNvxMemoryInfo = capabilities.hasExtension("GL_NVX_gpu_memory_info");
+    _hasAtiMemInfo = !_hasNvxMemoryInfo && capabilities.hasExtension("GL_ATI_meminfo");
+
+    // Bindless textures save binding each texture for each draw
+    _hasBindlessTextures = capabilities.hasExtension("GL_ARB_bindless_texture");
+    if (_hasBindlessTextures)
+        Log::get() << Log::MESSAGE << "Scene::" << __FUNCTION__ << " - Bindless textures are available and will be used" << Log::endl;
+
+    // Parallel shader compilation lets the shaders be rebuilt without stalling the rendering
+    _hasParallelShaderCompile = capabilities.hasExtension("GL_ARB_parallel_shader_compile");
+    if (_hasParallelShaderCompile)
+    {
+        glMaxShaderCompilerThreadsARB(0xFFFFFFFF);
+        Log::get() << Log::MESSAGE << "Scene::" << __FUNCTION__ << " - Parallel shader compilation is available and will be used" << Log::endl;
+    }
     _mainWindow->releaseContext();
 
     // Create the link and connect to the World
     _link = make_unique<Link>(this, name);
-    _link->connectTo("world");
-    sendMessageToWorld("sceneLaunched", {});
+    if (_context.innerWorld)
+        _link->connectTo("world", _context.innerWorld);
+    else
+        _link->connectTo("world", _context.worldAddress);
+    sendMessageToWorld("sceneLaunched", {name});
 }
 
 /*************/
@@ -670,6 +1826,64 @@ unsigned long long Scene::updateTargetFrameDuration()
     return static_cast<unsigned long long>(1e6 / refreshRate);
 }
 
+/*************/
+void Scene::updateRenderScale()
+{
+    auto renderScale = _renderScale;
+    if (!_dynamicResolution)
+    {
+        // Free the queries, and get back to the full resolution
+        _gpuTimer.reset();
+        renderScale = 1.f;
+    }
+    else if (_gpuTimer && _targetFrameDuration != 0)
+    {
+        auto gpuDuration = _gpuTimer->getDuration();
+        if (!gpuDuration)
+            return;
+
+        auto budget = static_cast<double>(_targetFrameDuration * std::max(1, _swapInterval));
+        if (*gpuDuration > budget * SPLASH_SCENE_DYNAMIC_RESOLUTION_HIGH)
+        {
+            _underBudgetFrames = 0;
+            if (++_overBudgetFrames >= SPLASH_SCENE_DYNAMIC_RESOLUTION_DOWN_FRAMES)
+            {
+                renderScale = std::max(_minRenderScale, _renderScale * SPLASH_SCENE_DYNAMIC_RESOLUTION_DOWN_FACTOR);
+                _overBudgetFrames = 0;
+            }
+        }
+        else if (*gpuDuration < budget * SPLASH_SCENE_DYNAMIC_RESOLUTION_LOW)
+        {
+            _overBudgetFrames = 0;
+            if (++_underBudgetFrames >= SPLASH_SCENE_DYNAMIC_RESOLUTION_UP_FRAMES)
+            {
+                renderScale = std::min(1.f, _renderScale + SPLASH_SCENE_DYNAMIC_RESOLUTION_UP_STEP);
+                _underBudgetFrames = 0;
+            }
+        }
+        else
+        {
+            _overBudgetFrames = 0;
+            _underBudgetFrames = 0;
+        }
+    }
+
+    if (renderScale == _renderScale)
+        return;
+
+    _renderScale = renderScale;
+    Log::get() << Log::MESSAGE << "Scene::" << __FUNCTION__ << " - Render scale set to " << _renderScale << Log::endl;
+
+    lock_guard<recursive_mutex> lockObjects(_objectsMutex);
+    for (const auto& obj : _objects)
+    {
+        if (auto camera = dynamic_pointer_cast<Camera>(obj.second); camera)
+            camera->setRenderScale(_renderScale);
+        else if (auto probe = dynamic_pointer_cast<VirtualProbe>(obj.second); probe)
+            probe->setRenderScale(getProbeRenderScale());
+    }
+}
+
 /*************/
 void Scene::glfwErrorCallback(int /*code*/, const char* msg)
 {
@@ -741,9 +1955,10 @@ void Scene::registerAttributes()
                 string type = args[0].as<string>();
                 string name = args[1].as<string>();
                 string sceneName = args.size() > 2 ? args[2].as<string>() : "";
+                bool local = args.size() > 3 && args[3].as<string>() == "scene";
 
                 if (sceneName == _name)
-                    addObject(type, name);
+                    addObject(type, name, local);
                 else if (_isMaster)
                     addGhost(type, name);
             });
@@ -751,7 +1966,7 @@ void Scene::registerAttributes()
             return true;
         },
         {'s', 's'});
-    setAttributeDescription("addObject", "Add an object of the given name, type, and optionally the target scene");
+    setAttributeDescription("addObject", "Add an object of the given name, type, and optionally the target scene and the object placement (\"world\" or \"scene\")");
 
     addAttribute("deleteObject",
         [&](const Values& args) {
@@ -772,6 +1987,8 @@ void Scene::registerAttributes()
                 for (auto& localObject : _objects)
                     unlink(object, localObject.second);
                 _objects.erase(objectName);
+                signalObjectsChanged();
+                releaseObject(std::move(object));
             });
 
             return true;
@@ -798,7 +2015,11 @@ void Scene::registerAttributes()
             clock.secs = args[5].as<uint32_t>();
             clock.frame = args[6].as<uint32_t>();
             clock.paused = args[7].as<bool>();
-            Timer::get().setMasterClock(clock);
+            // The World also sends when the clock took this value, on the shared clock
+            if (args.size() > 8)
+                Timer::get().setMasterClock(clock, args[8].as<int64_t>() - Timer::get().getClockOffset());
+            else
+                Timer::get().setMasterClock(clock);
             return true;
         },
         {'i', 'i', 'i', 'i', 'i', 'i', 'i'});
@@ -833,6 +2054,17 @@ void Scene::registerAttributes()
         {'b'});
     setAttributeDescription("logToFile", "If true, the process holding the Scene will try to write log to file");
 
+    addAttribute("recordTrace",
+        [&](const Values& args) {
+            if (args[0].as<bool>())
+                TraceRecorder::get().start();
+            else if (args.size() > 1)
+                TraceRecorder::get().stop(args[1].as<string>() + "_" + _name + "_" + to_string(getpid()) + ".json");
+            return true;
+        },
+        {'b'});
+    setAttributeDescription("recordTrace", "Start or stop recording a trace of the spans measured in the process holding the Scene, the second argument being the output path prefix");
+
     addAttribute("ping", [&](const Values&) {
         signalBufferObjectUpdated();
         sendMessageToWorld("pong", {_name});
@@ -883,7 +2115,7 @@ void Scene::registerAttributes()
     setAttributeDescription("stop", "Stop the Scene main loop");
 
     addAttribute("swapTest", [&](const Values& args) {
-        addTask([=]() {
+        addTask("swapTest", [=]() {
             lock_guard<recursive_mutex> lock(_objectsMutex);
             for (auto& obj : _objects)
                 if (obj.second->getType() == "window")
@@ -894,7 +2126,7 @@ void Scene::registerAttributes()
     setAttributeDescription("swapTest", "Activate video swap test if set to anything but 0");
 
     addAttribute("swapTestColor", [&](const Values& args) {
-        addTask([=]() {
+        addTask("swapTestColor", [=]() {
             lock_guard<recursive_mutex> lock(_objectsMutex);
             for (auto& obj : _objects)
                 if (obj.second->getType() == "window")
@@ -904,6 +2136,27 @@ void Scene::registerAttributes()
     });
     setAttributeDescription("swapTestColor", "Set the swap test color");
 
+    addAttribute("frameLock",
+        [&](const Values& args) {
+            _frameLock = args[0].as<bool>();
+            return true;
+        },
+        [&]() -> Values { return {_frameLock.load()}; },
+        {'b'});
+    setAttributeDescription("frameLock", "If true, swap buffers synchronously with the other Scenes when NV swap barriers are not available");
+
+    // Called directly from the Link thread, as the render loop is waiting for it
+    addAttribute("swapRelease",
+        [&](const Values& args) {
+            lock_guard<mutex> lock(_swapBarrierMutex);
+            _swapBarrierGeneration = args[0].as<int64_t>();
+            _swapPresentationTime = args[1].as<int64_t>();
+            _swapBarrierCondition.notify_all();
+            return true;
+        },
+        {'i', 'i'});
+    setAttributeDescription("swapRelease", "Release the swap barrier, given its generation and the shared clock time to swap at");
+
     addAttribute("uploadTextures", [&](const Values& /*args*/) {
         _doUploadTextures = true;
         return true;
@@ -934,7 +2187,7 @@ void Scene::registerAttributes()
 
     addAttribute("wireframe",
         [&](const Values& args) {
-            addTask([=]() {
+            addTask("wireframe", [=]() {
                 lock_guard<recursive_mutex> lock(_objectsMutex);
                 for (auto& obj : _objects)
                     if (obj.second->getType() == "camera")
@@ -973,6 +2226,116 @@ void Scene::registerAttributes()
     });
 #endif
 
+    addAttribute("batchCameras",
+        [&](const Values& args) {
+            _batchCameras = args[0].as<bool>();
+            return true;
+        },
+        [&]() -> Values { return {_batchCameras}; },
+        {'b'});
+    setAttributeDescription("batchCameras", "If true, cameras drawing the same objects are rendered together, activating each object only once");
+
+    addAttribute("dynamicResolution",
+        [&](const Values& args) {
+            _dynamicResolution = args[0].as<bool>();
+            return true;
+        },
+        [&]() -> Values { return {_dynamicResolution}; },
+        {'b'});
+    setAttributeDescription("dynamicResolution",
+        "If true, the render resolution of the cameras and virtual probes is lowered when the GPU time exceeds the frame budget, and raised back when there is headroom");
+
+    addAttribute("gpuProfilingPeriod",
+        [&](const Values& args) {
+            _gpuProfilingPeriod = std::max(0, args[0].as<int>());
+            return true;
+        },
+        [&]() -> Values { return {static_cast<int>(_gpuProfilingPeriod)}; },
+        {'i'});
+    setAttributeDescription("gpuProfilingPeriod",
+        "Number of frames between two measures of the GPU time of each rendered object, published in microseconds in the gpu branch of the Scene. Set to 0 to disable");
+
+    addAttribute("uploadBudget",
+        [&](const Values& args) {
+            _uploadBudget = std::max(0, args[0].as<int>());
+            return true;
+        },
+        [&]() -> Values { return {_uploadBudget.load()}; },
+        {'i'});
+    setAttributeDescription("uploadBudget",
+        "Number of megabytes of textures uploaded per frame, 0 for no limit. Visible and live textures go first, the others are deferred to the next frames "
+        "and large still images are uploaded in parts");
+
+    addAttribute("framePacing",
+        [&](const Values& args) {
+            _framePacing = args[0].as<bool>();
+            return true;
+        },
+        [&]() -> Values { return {_framePacing}; },
+        {'b'});
+    setAttributeDescription("framePacing",
+        "If true, the render loop starts just in time before the next vertical blank, based on the measured render duration, to reduce the latency. Ignored with frameLock or without vsync");
+
+    addAttribute("decoupleGui",
+        [&](const Values& args) {
+            _decoupleGui = args[0].as<bool>();
+            return true;
+        },
+        [&]() -> Values { return {_decoupleGui}; },
+        {'b'});
+    setAttributeDescription("decoupleGui",
+        "If true, the GUI is rendered after the swap of the windows, and only if the time left before the next frame allows for it, so that it never delays the outputs. The GUI is then "
+        "shown with one frame of delay. See also the framerate attribute of the GUI");
+
+    addAttribute("minRenderScale",
+        [&](const Values& args) {
+            _minRenderScale = std::clamp(args[0].as<float>(), 0.1f, 1.f);
+            return true;
+        },
+        [&]() -> Values { return {_minRenderScale}; },
+        {'r'});
+    setAttributeDescription("minRenderScale", "Lowest render scale allowed by the dynamic resolution, between 0.1 and 1");
+
+    addAttribute("watchdog",
+        [&](const Values& args) {
+            _watchdog = args[0].as<bool>();
+            return true;
+        },
+        [&]() -> Values { return {_watchdog}; },
+        {'b'});
+    setAttributeDescription("watchdog",
+        "If true, the quality is degraded step by step while the render loop stalls or exceeds the frame budget, and restored once it keeps up again. See watchdogDegradations. "
+        "Stalls are logged with the phase of the loop in progress whether this is enabled or not");
+
+    addAttribute("watchdogDegradations",
+        [&](const Values& args) {
+            vector<string> degradations;
+            for (const auto& arg : args)
+            {
+                auto degradation = arg.as<string>();
+                if (degradation != "blending" && degradation != "sinks" && degradation != "probes")
+                {
+                    Log::get() << Log::WARNING << "Scene::watchdogDegradations - Unknown degradation " << degradation << ", expected blending, sinks or probes" << Log::endl;
+                    return false;
+                }
+                degradations.push_back(degradation);
+            }
+
+            addTask([=]() {
+                setWatchdogLevel(0);
+                _watchdogDegradations = degradations;
+            });
+            return true;
+        },
+        [&]() -> Values {
+            Values degradations;
+            for (const auto& degradation : _watchdogDegradations)
+                degradations.push_back(degradation);
+            return degradations;
+        });
+    setAttributeDescription("watchdogDegradations",
+        "Degradations applied by the watchdog, in order: blending to stop updating the blending maps, sinks to pause the sinks, probes to lower the resolution of the virtual probes");
+
     addAttribute("runInBackground",
         [&](const Values& args) {
             _runInBackground = args[0].as<bool>();
@@ -1007,17 +2370,26 @@ void Scene::initializeTree()
             clock.secs = args[5].as<uint32_t>();
             clock.frame = args[6].as<uint32_t>();
             clock.paused = args[7].as<bool>();
-            Timer::get().setMasterClock(clock);
+            // The World also sends when the clock took this value, on the shared clock
+            if (args.size() > 8)
+                Timer::get().setMasterClock(clock, args[8].as<int64_t>() - Timer::get().getClockOffset());
+            else
+                Timer::get().setMasterClock(clock);
         },
         true);
 
     _tree.setName(_name);
     _tree.createBranchAt("/" + _name);
     _tree.createBranchAt("/" + _name + "/attributes");
+    _tree.createBranchAt("/" + _name + "/boot");
     _tree.createBranchAt("/" + _name + "/commands");
     _tree.createBranchAt("/" + _name + "/durations");
+    _tree.createBranchAt("/" + _name + "/frames");
+    _tree.createBranchAt("/" + _name + "/gpu");
     _tree.createBranchAt("/" + _name + "/logs");
+    _tree.createBranchAt("/" + _name + "/memory");
     _tree.createBranchAt("/" + _name + "/objects");
+    _tree.createBranchAt("/" + _name + "/stats");
 }
 
 } // namespace Splash
@@ -25,10 +25,18 @@
 #ifndef SPLASH_SCENE_H
 #define SPLASH_SCENE_H
 
+#include <array>
 #include <atomic>
+#include <chrono>
+#include <condition_variable>
 #include <cstddef>
 #include <future>
 #include <list>
+#include <map>
+#include <mutex>
+#include <set>
+#include <thread>
+#include <unordered_map>
 #include <vector>
 
 #include "./core/constants.h"
@@ -37,7 +45,9 @@
 #include "./core/factory.h"
 #include "./core/root_object.h"
 #include "./core/spinlock.h"
+#include "./core/upload_scheduler.h"
 #include "./graphics/gl_window.h"
+#include "./graphics/gpu_timer.h"
 #include "./graphics/object_library.h"
 
 namespace Splash
@@ -46,6 +56,9 @@ namespace Splash
 class ControllerObject;
 class Gui;
 class Scene;
+class Texture;
+class Texture_Image;
+class Window;
 
 /*************/
 //! Scene class, which does the rendering on a given GPU
@@ -70,9 +83,10 @@ class Scene : public RootObject
      *  Add an object of the given type, with the given name
      * \param type Object type
      * \param name Object name
+     * \param local If true, objects usually running in the World, like media decoders, run in this Scene instead
      * \return Return a shared pointer to the created object
      */
-    std::shared_ptr<GraphObject> addObject(const std::string& type, const std::string& name = "");
+    std::shared_ptr<GraphObject> addObject(const std::string& type, const std::string& name = "", bool local = false);
 
     /**
      *  Add an object ghosting one in another Scene. Used in master Scene for controlling purposes
@@ -106,12 +120,30 @@ class Scene : public RootObject
      */
     static std::string getGLRenderer() { return _glRenderer; }
 
+    /**
+     * Get the maximum texture size supported by the OpenGL renderer
+     * \return Return the maximum width and height of a texture
+     */
+    static int getGLMaxTextureSize() { return _glMaxTextureSize; }
+
     /**
      * Get whether NV swap groups are available
      * \return Return true if they are
      */
     static bool getHasNVSwapGroup() { return _hasNVSwapGroup; }
 
+    /**
+     * Get whether bindless textures are available
+     * \return Return true if they are
+     */
+    static bool getHasBindlessTextures() { return _hasBindlessTextures; }
+
+    /**
+     * Get whether shaders can be compiled and linked in the background
+     * \return Return true if they can
+     */
+    static bool getHasParallelShaderCompile() { return _hasParallelShaderCompile; }
+
     /**
      * Get a reference to the object library
      * \return Return a reference to the object library
@@ -215,6 +247,14 @@ class Scene : public RootObject
      */
     Values sendMessageToWorldWithAnswer(const std::string& message, const Values& value = {}, const unsigned long long timeout = 0);
 
+    /**
+     *  Get attributes values from the World, without waiting for the World main loop
+     * \param attributes Pairs of object name and attribute name, use "world" as the object name for the World attributes
+     * \param timeout Timeout in microseconds
+     * \return Return the attributes values in the same order as the requested attributes, or an empty Values if no answer was received
+     */
+    Values queryWorldAttributes(const std::vector<std::pair<std::string, std::string>>& attributes, const unsigned long long timeout = 1000000ull);
+
   protected:
     std::shared_ptr<GlWindow> _mainWindow;
     std::atomic_bool _isRunning{false};
@@ -241,13 +281,18 @@ class Scene : public RootObject
   private:
     ObjectLibrary _objectLibrary; //!< Library of 3D objects used by multiple GraphObjects
 
-    static bool _hasNVSwapGroup; //!< If true, NV swap groups have been detected and are used
+    static bool _hasNVSwapGroup;           //!< If true, NV swap groups have been detected and are used
+    static bool _hasBindlessTextures;      //!< If true, ARB_bindless_texture has been detected and textures are sampled through handles
+    static bool _hasParallelShaderCompile; //!< If true, ARB_parallel_shader_compile has been detected and shaders are rebuilt in the background
     static std::vector<int> _glVersion;
     static std::string _glVendor;
     static std::string _glRenderer;
+    static int _glMaxTextureSize;
 
     bool _runInBackground{false}; //!< If true, no window will be created
+    bool _batchCameras{true};     //!< If true, cameras sharing the same objects are rendered as a batch
     std::atomic_bool _started{false};
+    bool _firstFrameSwapped{false}; //!< Set once a first frame has been swapped to the windows, which ends the boot of this Scene
 
     bool _isMaster{false}; //!< Set to true if this is the master Scene of the current config
     bool _isInitialized{false};
@@ -256,10 +301,130 @@ class Scene : public RootObject
     unsigned long long _targetFrameDuration{0}; //!< Duration in microseconds of a frame at the refresh rate of the primary monitor
     std::atomic_bool _doUploadTextures{false};
 
+    // Dynamic resolution, lowering the render size of cameras and virtual probes while the GPU time exceeds the frame budget
+    bool _dynamicResolution{false};
+    float _minRenderScale{0.5f};           //!< Lowest render scale allowed
+    float _renderScale{1.f};               //!< Current render scale
+    int _overBudgetFrames{0};              //!< Number of consecutive frames over budget
+    int _underBudgetFrames{0};             //!< Number of consecutive frames with enough headroom to raise the scale
+    std::unique_ptr<GpuTimer> _gpuTimer{}; //!< GPU time of the render loop
+
+    // Always on GPU profiling, measuring the GPU time of each rendered object every few frames
+    uint32_t _gpuProfilingPeriod{30};                             //!< Number of frames between two measures, 0 to disable
+    uint64_t _frameIndex{0};                                      //!< Number of render loops since the start
+    std::unordered_map<std::string, GpuTimer> _objectGpuTimers{}; //!< GPU timers of the rendered objects, per object name
+
+    // Frame pacing, starting the render just in time before the next vertical blank
+    bool _framePacing{false};
+    int64_t _lastSwapTime{0};            //!< Time at which the last swap returned, in us
+    double _renderDurationEstimate{0.0}; //!< Decaying maximum of the render duration, in us
+
+    // Decoupled GUI, rendered after the swap of the windows and only when the frame leaves enough time for it
+    bool _decoupleGui{false};
+    double _guiDurationEstimate{0.0}; //!< Decaying maximum of the GUI render duration, in us
+    uint32_t _skippedGuiFrames{0};    //!< Number of consecutive frames for which the GUI was not rendered
+
+    // Phases of the frame, to find out why a frame was late
+    enum FramePhase
+    {
+        FRAME_PHASE_UPLOAD = 0, //!< Texture updates and media objects
+        FRAME_PHASE_BLENDING,   //!< Blending computation
+        FRAME_PHASE_RENDER,     //!< Filters, cameras, warps and windows
+        FRAME_PHASE_SWAP,       //!< Previous swap and swap barrier
+        FRAME_PHASE_OTHER,      //!< Rest of the loop: tree, tasks and pacing
+        FRAME_PHASE_COUNT
+    };
+    static const std::array<const char*, FRAME_PHASE_COUNT> _framePhaseNames;
+    std::array<int64_t, FRAME_PHASE_COUNT> _framePhaseDurations{};                              //!< Durations of the phases of the current frame, in us
+    std::array<double, FRAME_PHASE_COUNT> _framePhaseAverages{};                                //!< Running averages of the phase durations, in us
+    std::unordered_map<std::string, std::array<uint64_t, FRAME_PHASE_COUNT>> _windowLateFrames{}; //!< Late frames of each window, per dominant phase
+    int64_t _lastSwapDuration{0};                                                               //!< Duration of the previous swap, in us
+
+    // Phases of the render loop, reported by the watchdog when the loop stalls
+    enum LoopPhase
+    {
+        LOOP_PHASE_TREE_PROCESS = 0,
+        LOOP_PHASE_TASKS,
+        LOOP_PHASE_INPUTS,
+        LOOP_PHASE_UPLOAD,
+        LOOP_PHASE_RENDER,
+        LOOP_PHASE_SWAP,
+        LOOP_PHASE_GUI,
+        LOOP_PHASE_TREE_UPDATE,
+        LOOP_PHASE_COUNT
+    };
+    static const std::array<const char*, LOOP_PHASE_COUNT> _loopPhaseNames;
+
+    // Watchdog, monitoring the render loop from its own thread and degrading the quality while the loop cannot keep up
+    bool _watchdog{false};                                                         //!< If true, the quality is degraded while the loop is over budget
+    std::vector<std::string> _watchdogDegradations{"blending", "sinks", "probes"}; //!< Degradations, in the order they are applied
+    int _watchdogLevel{0};                                                         //!< Number of degradations currently applied
+    int _watchdogOverBudgetLoops{0};                                               //!< Number of consecutive loops over budget
+    int _watchdogUnderBudgetLoops{0};                                              //!< Number of consecutive loops with enough headroom to restore the quality
+    bool _watchdogSkipBlending{false};                                             //!< If true, the blending objects are not updated
+    bool _watchdogPauseSinks{false};                                               //!< If true, the sinks are not updated
+    bool _watchdogLowerProbes{false};                                              //!< If true, the virtual probes are rendered at a lower resolution
+    std::atomic<int64_t> _loopHeartbeat{0};                                        //!< Start time of the current loop, in us
+    std::atomic_int _loopPhase{LOOP_PHASE_TREE_PROCESS};                           //!< Phase of the loop in progress
+    std::atomic_bool _loopStalled{false};                                          //!< Set by the watchdog thread when the loop stalled
+    std::thread _watchdogThread{};
+    std::mutex _watchdogMutex{};
+    std::condition_variable _watchdogCondition{};
+
+    // Texture upload thread, which updates the Texture_Image objects from a context shared with the main window
+    std::shared_ptr<GlWindow> _textureUploadWindow{nullptr}; //!< Hidden window holding the upload context
+    std::thread _textureUploadThread{};
+    std::mutex _textureUploadMutex{};
+    std::condition_variable _textureUploadCondition{};
+    bool _texturesToUpload{false}; //!< Set to true to signal the upload thread that new images are available
+
+    // Texture upload scheduling, spreading the uploads so that no frame uploads more than a given number of bytes
+    // The scheduler is only used by the thread uploading the textures, _hiddenImages being accessed with _objectsMutex held
+    UploadScheduler _uploadScheduler{};
+    std::atomic_int _uploadBudget{64};     //!< Megabytes uploaded per frame, 0 for no limit
+    std::set<std::string> _hiddenImages{}; //!< Images which no visible camera samples, uploaded with a lower priority
+
+    // Render graph, cached between frames and rebuilt when RootObject::signalObjectsChanged has been called
+    // Only the render loop modifies it, and the upload thread reads _renderGraphImages while holding _objectsMutex
+    std::map<GraphObject::Priority, std::vector<std::weak_ptr<GraphObject>>> _renderGraph{}; //!< Objects to render, sorted by priority
+    std::vector<std::weak_ptr<Texture>> _renderGraphTextures{};                              //!< Textures other than Texture_Image
+    std::vector<std::weak_ptr<Texture_Image>> _renderGraphImages{};                          //!< Texture_Image objects
+    std::vector<std::weak_ptr<Window>> _renderGraphWindows{};                                //!< Windows, to swap their buffers
+
+    // Regions of the images sampled by the cameras, sent to the World so that it only sends these parts
+    std::chrono::steady_clock::time_point _lastSampledImageRegionsUpdate{};
+    Values _sampledImageRegions{};     //!< Last regions sent to the World
+    Values _unsampledImages{};         //!< Last images sent to the World as not sampled by any visible camera
+    Values _sampledImageResolutions{}; //!< Last image resolutions needed by the cameras, sent to the World
+
+    // Frame lock over the network, used when NV swap barriers are not available
+    // All Scenes wait for the World to release a barrier before swapping, then swap at the presentation time it targets
+    std::atomic_bool _frameLock{false}; //!< If true, swapping is synchronized with the other Scenes
+    std::mutex _swapBarrierMutex{};
+    std::condition_variable _swapBarrierCondition{};
+    int64_t _swapBarrierGeneration{0}; //!< Generation of the last barrier released by the World
+    int64_t _swapPresentationTime{0};  //!< Shared clock time at which to swap, for the last released barrier
+    std::chrono::steady_clock::time_point _lastSwapBarrierWarning{};
+
+    // Synchronization of the shared clock with the World clock
+    std::thread _clockSyncThread{};
+    std::mutex _clockSyncMutex{};
+    std::condition_variable _clockSyncCondition{};
+
+    // Objects removed from the Scene, waiting to be destroyed without stalling the rendering
+    std::mutex _deferredReleaseMutex{};
+    std::vector<std::shared_ptr<GraphObject>> _deferredCpuObjects{}; //!< Objects holding only CPU memory, destroyed on a worker
+    std::vector<std::shared_ptr<GraphObject>> _deferredGlObjects{};  //!< Objects holding GL resources, destroyed in batches by the render loop
+    std::future<void> _deferredReleaseFuture{};                      //!< Pending destruction of CPU objects
+
     // NV Swap group specific
     GLuint _maxSwapGroups{0};
     GLuint _maxSwapBarriers{0};
 
+    // Vendor specific extensions reporting the available GPU memory
+    bool _hasNvxMemoryInfo{false};
+    bool _hasAtiMemInfo{false};
+
     static std::vector<std::string> _ghostableTypes;
 
     /**
@@ -268,6 +433,38 @@ class Scene : public RootObject
      */
     std::vector<int> findGLVersion();
 
+    /**
+     *  Start and stop the watchdog thread, which reports the stalls of the render loop
+     */
+    void startWatchdog();
+    void stopWatchdog();
+
+    /**
+     *  Update the degradation level from the duration of the last loop, and the stalls reported by the watchdog thread
+     * \param loopDuration Duration of the last loop, in us
+     */
+    void updateWatchdog(int64_t loopDuration);
+
+    /**
+     *  Set the number of degradations applied
+     * \param level Degradation level, 0 for the full quality
+     */
+    void setWatchdogLevel(int level);
+
+    /**
+     *  Get the render scale of the virtual probes, from the dynamic resolution and the watchdog
+     * \return Return the render scale
+     */
+    float getProbeRenderScale() const;
+
+    /**
+     *  Create the main window, with the given GL version
+     * \param glVersion GL version as {MAJOR, MINOR}
+     * \param name Window name
+     * \return Return the window, or nullptr if the context could not be created
+     */
+    GLFWwindow* createMainGLFWWindow(const std::vector<int>& glVersion, const std::string& name);
+
     /**
      *  Set up the context and everything
      * \param name Scene name
@@ -280,6 +477,37 @@ class Scene : public RootObject
      */
     unsigned long long updateTargetFrameDuration();
 
+    /**
+     *  Update the render scale of the cameras and virtual probes from the GPU time of the last frames
+     */
+    void updateRenderScale();
+
+    /**
+     *  Publish the GPU times of the rendered objects which are available, and drop the timers of removed objects
+     */
+    void updateGpuDurations();
+
+    /**
+     *  Publish the frame statistics, like the frame count and the frames missed by the windows
+     */
+    void updateFrameStatistics();
+
+    /**
+     *  Wait until the render has to start to be done just before the next vertical blank
+     */
+    void paceFrame();
+
+    /**
+     *  Swap the buffers of all windows, and attribute the frames they missed to the phase which lasted abnormally long
+     * \param renderStart Time at which the rendering of the frame started, in us
+     */
+    void swapWindows(int64_t renderStart);
+
+    /**
+     *  Publish the frame statistics of each window: missed frames, render to present durations and late frames per phase
+     */
+    void updateWindowFrameStatistics();
+
     /**
      *  Callback for GLFW errors
      * \param code Error code
@@ -306,6 +534,76 @@ class Scene : public RootObject
      *  Update the various inputs (mouse, keyboard...)
      */
     void updateInputs();
+
+    /**
+     * Create the upload context and start the texture upload thread
+     * If the context can not be created, textures are uploaded from the render loop
+     */
+    void startTextureUpload();
+
+    /**
+     * Stop the texture upload thread and release its context
+     */
+    void stopTextureUpload();
+
+    /**
+     * Texture upload loop, run by the texture upload thread
+     */
+    void textureUploadLoop();
+
+    /**
+     * Set the upload budget of the given textures for their next update, according to their pending uploads
+     * This has to be called with the objects locked, by the thread updating the textures
+     * \param textures Textures to update
+     */
+    void scheduleTextureUploads(const std::vector<std::shared_ptr<Texture_Image>>& textures);
+
+    /**
+     * Start the thread synchronizing the shared clock with the World clock, see Timer::getSharedTime
+     */
+    void startClockSync();
+
+    /**
+     * Stop the clock synchronization thread
+     */
+    void stopClockSync();
+
+    /**
+     * Redefinition of a method from RootObject. Defer the destruction of the object out of the rendering
+     * \param object Object to release
+     */
+    void releaseObject(std::shared_ptr<GraphObject>&& object) final;
+
+    /**
+     * Destroy the released objects: CPU only objects are handed to a worker, and a batch of objects holding
+     * GL resources is destroyed in the current thread. Must be called with the GL context current.
+     * \param flush Destroy all released objects and wait for the worker, instead of a single batch
+     */
+    void destroyReleasedObjects(bool flush = false);
+
+    /**
+     * Wait for all the Scenes to be ready to swap, then for the presentation time targeted by the World
+     * Does nothing if frame lock is disabled or if NV swap barriers are used
+     */
+    void waitForSwapBarrier();
+
+    /**
+     * Rebuild the render graph from the objects list, if it changed. Objects should be locked.
+     */
+    void updateRenderGraph();
+
+    /**
+     * Render the GUI objects after the swap, if the time left before the next frame allows for it
+     */
+    void renderDecoupledGui();
+
+    /**
+     * Compute the region of each image sampled by the cameras, and send them to the World if they changed
+     * Images which are not only sampled by objects seen through the cameras are reported as entirely sampled.
+     * Images which no visible camera samples are sent too, so that the World can suspend them, as well as
+     * the resolution the cameras need for each image so that it can be decoded at a lower resolution.
+     */
+    void updateSampledImageRegions();
 };
 
 } // namespace Splash
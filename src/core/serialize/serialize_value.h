@@ -70,6 +70,41 @@ struct deserializeHelper<T, typename std::enable_if<std::is_same<T, Value::Buffe
     }
 };
 
+// Specialisation of serialization for Splash::ResizableArray<float>, here known as Value::Reals
+template <class T>
+struct getSizeHelper<T, typename std::enable_if<std::is_same<T, Value::Reals>::value>::type>
+{
+    static uint32_t value(const T& obj) { return sizeof(uint32_t) + obj.size() * sizeof(float); }
+};
+
+template <class T>
+struct serializeHelper<T, typename std::enable_if<std::is_same<T, Value::Reals>::value>::type>
+{
+    static void apply(const T& obj, std::vector<uint8_t>::iterator& it)
+    {
+        auto count = static_cast<uint32_t>(obj.size());
+        serializer(count, it);
+        auto data = reinterpret_cast<const uint8_t*>(obj.data());
+        std::copy(data, data + count * sizeof(float), it);
+        it += count * sizeof(float);
+    }
+};
+
+template <class T>
+struct deserializeHelper<T, typename std::enable_if<std::is_same<T, Value::Reals>::value>::type>
+{
+    static T apply(std::vector<uint8_t>::const_iterator& it)
+    {
+        auto count = deserializer<uint32_t>(it);
+        T obj(static_cast<size_t>(count));
+        auto data = reinterpret_cast<uint8_t*>(obj.data());
+        std::copy(it, it + count * sizeof(float), data);
+        it += count * sizeof(float);
+
+        return obj;
+    }
+};
+
 // Specialisation of serialization for Splash::Value
 template <class T>
 struct getSizeHelper<T, typename std::enable_if<std::is_same<T, Value>::value>::type>
@@ -85,6 +120,8 @@ struct getSizeHelper<T, typename std::enable_if<std::is_same<T, Value>::value>::
             return acc + getSize(obj.as<Values>());
         else if (objType == Value::Type::buffer)
             return acc + getSize(obj.as<Value::Buffer>());
+        else if (objType == Value::Type::reals)
+            return acc + getSize(obj.asRef<Value::Reals>());
         else
             return acc + obj.byte_size();
     }
@@ -110,6 +147,10 @@ struct serializeHelper<T, typename std::enable_if<std::is_same<T, Value>::value>
         {
             serializer(obj.as<Value::Buffer>(), it);
         }
+        else if (objType == Value::Type::reals)
+        {
+            serializer(obj.asRef<Value::Reals>(), it);
+        }
         else
         {
             auto ptr = reinterpret_cast<const uint8_t*>(obj.data());
@@ -155,6 +196,9 @@ struct deserializeHelper<T, typename std::enable_if<std::is_same<T, Value>::valu
         case Value::Type::buffer:
             obj = Value(deserializer<Value::Buffer>(it));
             break;
+        case Value::Type::reals:
+            obj = Value(deserializer<Value::Reals>(it));
+            break;
         }
 
         return obj;
@@ -54,6 +54,15 @@ struct SerializedObject
     {
     }
 
+    /**
+     * \brief Constructor taking ownership of an existing buffer
+     * \param data Buffer to move into the object
+     */
+    explicit SerializedObject(ResizableArray<uint8_t>&& data)
+        : _data(std::move(data))
+    {
+    }
+
     /**
      * \brief Get the pointer to the data
      * \return Return a pointer to the data
@@ -70,7 +79,13 @@ struct SerializedObject
      * \brief Get the size of the data
      * \return Return the size
      */
-    inline std::size_t size() { return _data.size(); }
+    inline std::size_t size() const { return _data.size(); }
+
+    /**
+     * \brief Check whether the data lives in memory not owned by this object, for example shared memory
+     * \return Return true if the data has been adopted
+     */
+    inline bool isAdopted() const { return _data.isAdopted(); }
 
     /**
      * \brief Modify the size of the data
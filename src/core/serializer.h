@@ -28,6 +28,7 @@
 #define SPLASH_SERIALIZER_H
 
 #include <chrono>
+#include <cstring>
 #include <iterator>
 #include <numeric>
 #include <string>
@@ -88,6 +89,23 @@ struct is_specialisation_of<Template, Template<Args...>> : std::true_type
 {
 };
 
+/**
+ * Helper tool to check whether a container stores arithmetic values contiguously,
+ * in which case it is serialized with a single copy
+ */
+template <typename T>
+struct isContiguousArithmetic : std::false_type
+{
+};
+template <typename U, typename Alloc>
+struct isContiguousArithmetic<std::vector<U, Alloc>> : std::bool_constant<std::is_arithmetic<U>::value && !std::is_same<U, bool>::value>
+{
+};
+template <typename Traits, typename Alloc>
+struct isContiguousArithmetic<std::basic_string<char, Traits, Alloc>> : std::true_type
+{
+};
+
 /*************/
 template <class T>
 uint32_t getSize(const T& obj);
@@ -105,9 +123,9 @@ struct getSizeHelper<T, typename std::enable_if<std::is_arithmetic<T>::value ||
 };
 
 template <class T>
-struct getSizeHelper<T, typename std::enable_if<std::is_same<T, std::string>::value>::type>
+struct getSizeHelper<T, typename std::enable_if<isContiguousArithmetic<T>::value>::type>
 {
-    static uint32_t value(const T& obj) { return sizeof(uint32_t) + obj.size() * sizeof(char); }
+    static uint32_t value(const T& obj) { return sizeof(uint32_t) + obj.size() * sizeof(typename T::value_type); }
 };
 
 template <class T>
@@ -117,7 +135,7 @@ struct getSizeHelper<T, typename std::enable_if<is_specialisation_of<std::chrono
 };
 
 template <class T>
-struct getSizeHelper<T, typename std::enable_if<isIterable<T>::value && !std::is_same<T, std::string>::value>::type>
+struct getSizeHelper<T, typename std::enable_if<isIterable<T>::value && !isContiguousArithmetic<T>::value>::type>
 {
     static uint32_t value(const T& obj)
     {
@@ -198,7 +216,7 @@ struct serializeHelper<T, typename std::enable_if<is_specialisation_of<std::chro
 };
 
 template <class T>
-struct serializeHelper<T, typename std::enable_if<isIterable<T>::value>::type>
+struct serializeHelper<T, typename std::enable_if<isIterable<T>::value && !isContiguousArithmetic<T>::value>::type>
 {
     static void apply(const T& obj, std::vector<uint8_t>::iterator& it)
     {
@@ -208,6 +226,20 @@ struct serializeHelper<T, typename std::enable_if<isIterable<T>::value>::type>
     }
 };
 
+template <class T>
+struct serializeHelper<T, typename std::enable_if<isContiguousArithmetic<T>::value>::type>
+{
+    static void apply(const T& obj, std::vector<uint8_t>::iterator& it)
+    {
+        serializer(static_cast<uint32_t>(obj.size()), it);
+        const auto byteSize = obj.size() * sizeof(typename T::value_type);
+        if (byteSize == 0)
+            return;
+        memcpy(&*it, obj.data(), byteSize);
+        it += byteSize;
+    }
+};
+
 template <class T>
 inline void serializeTuple(const T& obj, std::vector<uint8_t>::iterator& it, int_<0>)
 {
@@ -280,14 +312,17 @@ struct deserializeHelper<T, typename std::enable_if<std::is_arithmetic<T>::value
 };
 
 template <class T>
-struct deserializeHelper<T, typename std::enable_if<std::is_same<T, std::string>::value>::type>
+struct deserializeHelper<T, typename std::enable_if<isContiguousArithmetic<T>::value>::type>
 {
     static T apply(std::vector<uint8_t>::const_iterator& it)
     {
         auto size = deserializer<uint32_t>(it);
-        auto obj = T(static_cast<size_t>(size), ' ');
-        for (uint32_t i = 0; i < size; ++i)
-            obj[i] = deserializer<typename T::value_type>(it);
+        auto obj = T(static_cast<size_t>(size), typename T::value_type());
+        const auto byteSize = obj.size() * sizeof(typename T::value_type);
+        if (byteSize == 0)
+            return obj;
+        memcpy(obj.data(), &*it, byteSize);
+        it += byteSize;
         return obj;
     }
 };
@@ -305,7 +340,7 @@ struct deserializeHelper<T, typename std::enable_if<is_specialisation_of<std::ch
 };
 
 template <class T>
-struct deserializeHelper<T, typename std::enable_if<isIterable<T>::value && !std::is_same<T, std::string>::value>::type>
+struct deserializeHelper<T, typename std::enable_if<isIterable<T>::value && !isContiguousArithmetic<T>::value>::type>
 {
     static T apply(std::vector<uint8_t>::const_iterator& it)
     {
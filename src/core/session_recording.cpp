@@ -0,0 +1,279 @@
+#include "./core/session_recording.h"
+
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <set>
+
+#include "./core/serialize/serialize_value.h"
+#include "./core/serializer.h"
+#include "./utils/log.h"
+#include "./utils/timer.h"
+
+// Identifier written at the start of the recordings
+#define SPLASH_SESSION_RECORDING_MAGIC "splash_session"
+
+using namespace std;
+
+namespace Splash
+{
+
+namespace
+{
+using SerializedHeader = tuple<string, int32_t, string, int64_t>;
+using SerializedEvent = tuple<int64_t, uint8_t, string, string, Values>;
+
+/*************/
+// Get the size and modification time of a file, the size being -1 if it does not exist
+pair<int64_t, int64_t> getFileState(const string& path)
+{
+    error_code errorCode;
+    const auto size = filesystem::file_size(path, errorCode);
+    if (errorCode)
+        return {-1, 0};
+    const auto writeTime = filesystem::last_write_time(path, errorCode);
+    if (errorCode)
+        return {static_cast<int64_t>(size), 0};
+    return {static_cast<int64_t>(size), chrono::duration_cast<chrono::seconds>(writeTime.time_since_epoch()).count()};
+}
+} // namespace
+
+/*************/
+bool SessionRecording::start(const string& path, const string& configurationFile)
+{
+    lock_guard<mutex> lock(_mutex);
+    if (_file.is_open())
+        _file.close();
+
+    _file.open(path, ios::binary | ios::trunc);
+    if (!_file.is_open())
+    {
+        Log::get() << Log::WARNING << "SessionRecording::" << __FUNCTION__ << " - Unable to open file " << path << " for writing" << Log::endl;
+        return false;
+    }
+
+    _startTime = Timer::getTime();
+    const auto startDate = chrono::duration_cast<chrono::milliseconds>(chrono::system_clock::now().time_since_epoch()).count();
+    _buffer.clear();
+    Serial::serialize(SerializedHeader(SPLASH_SESSION_RECORDING_MAGIC, SPLASH_SESSION_RECORDING_VERSION, configurationFile, startDate), _buffer);
+    writeBuffer();
+
+    Log::get() << Log::MESSAGE << "SessionRecording::" << __FUNCTION__ << " - Recording the session to " << path << Log::endl;
+    return true;
+}
+
+/*************/
+void SessionRecording::stop()
+{
+    lock_guard<mutex> lock(_mutex);
+    if (_file.is_open())
+        _file.close();
+}
+
+/*************/
+bool SessionRecording::isRecording() const
+{
+    lock_guard<mutex> lock(_mutex);
+    return _file.is_open();
+}
+
+/*************/
+void SessionRecording::recordMessage(const string& name, const string& attribute, const Values& args)
+{
+    if (!isRecordedMessage(attribute))
+        return;
+
+    {
+        lock_guard<mutex> lock(_mutex);
+        if (!_file.is_open())
+            return;
+        write({Timer::getTime() - _startTime, EventType::Message, name, attribute, args});
+    }
+
+    if (attribute == "file" && args.size() > 0 && args[0].getType() == Value::Type::string)
+        recordMedia(name, args[0].as<string>());
+}
+
+/*************/
+void SessionRecording::recordSeeds(const list<Tree::Seed>& seeds)
+{
+    Values changes;
+    for (const auto& seed : seeds)
+    {
+        const auto task = std::get<0>(seed);
+        auto args = std::get<1>(seed);
+        if (args.size() == 0 || !isRecordedSeed(task, args[0].as<string>()))
+            continue;
+        changes.push_back(Values({static_cast<int>(task), args}));
+    }
+
+    if (changes.empty())
+        return;
+
+    lock_guard<mutex> lock(_mutex);
+    if (!_file.is_open())
+        return;
+    write({Timer::getTime() - _startTime, EventType::Seeds, "", "", changes});
+}
+
+/*************/
+void SessionRecording::recordMedia(const string& name, const string& path)
+{
+    if (path.empty())
+        return;
+
+    const auto [size, modificationTime] = getFileState(path);
+    lock_guard<mutex> lock(_mutex);
+    if (!_file.is_open())
+        return;
+    write({Timer::getTime() - _startTime, EventType::Media, name, "file", {path, size, modificationTime}});
+}
+
+/*************/
+void SessionRecording::recordOrigin()
+{
+    lock_guard<mutex> lock(_mutex);
+    if (!_file.is_open())
+        return;
+    write({Timer::getTime() - _startTime, EventType::Origin, "", "", {}});
+}
+
+/*************/
+bool SessionRecording::isRecordedMessage(const string& attribute)
+{
+    // Messages sent by the Scenes to keep the World informed of their state, which the replayed Scenes send again by themselves
+    static const set<string> protocolMessages{
+        "answerMessage", "pong", "previewPacket", "quit", "sampledImageRegions", "sampledImageResolutions", "sceneLaunched", "swapReady", "unsampledImages"};
+    return protocolMessages.find(attribute) == protocolMessages.end();
+}
+
+/*************/
+bool SessionRecording::isRecordedSeed(Tree::Task task, const string& path)
+{
+    if (task != Tree::Task::AddBranch && task != Tree::Task::AddLeaf && task != Tree::Task::SetLeaf)
+        return false;
+
+    // Paths are in the form /root_object/branch/..., only the branches holding the state set by the users are kept
+    if (path.empty() || path[0] != '/')
+        return false;
+    const auto rootEnd = path.find('/', 1);
+    if (rootEnd == string::npos)
+        return false;
+    const auto branchEnd = path.find('/', rootEnd + 1);
+    if (branchEnd == string::npos)
+        return false;
+
+    const auto branch = path.substr(rootEnd + 1, branchEnd - rootEnd - 1);
+    return branch == "attributes" || branch == "commands" || branch == "objects";
+}
+
+/*************/
+bool SessionRecording::checkMedia(const Event& event)
+{
+    if (event.type != EventType::Media || event.args.size() != 3)
+        return true;
+
+    const auto path = event.args[0].as<string>();
+    const auto recordedSize = event.args[1].as<int64_t>();
+    const auto recordedModificationTime = event.args[2].as<int64_t>();
+    // Files which were already missing during the recording are not checked
+    if (recordedSize < 0)
+        return true;
+
+    const auto [size, modificationTime] = getFileState(path);
+    if (size < 0)
+    {
+        Log::get() << Log::WARNING << "SessionRecording::" << __FUNCTION__ << " - Media file " << path << " used by " << event.name << " is missing" << Log::endl;
+        return false;
+    }
+    else if (size != recordedSize || modificationTime != recordedModificationTime)
+    {
+        Log::get() << Log::WARNING << "SessionRecording::" << __FUNCTION__ << " - Media file " << path << " used by " << event.name << " changed since the recording" << Log::endl;
+        return false;
+    }
+
+    return true;
+}
+
+/*************/
+bool SessionRecording::read(const string& path, Header& header, vector<Event>& events)
+{
+    events.clear();
+
+    ifstream file(path, ios::binary);
+    if (!file.is_open())
+    {
+        Log::get() << Log::WARNING << "SessionRecording::" << __FUNCTION__ << " - Unable to open file " << path << Log::endl;
+        return false;
+    }
+
+    vector<uint8_t> buffer;
+    auto readRecord = [&]() -> bool {
+        uint32_t size = 0;
+        if (!file.read(reinterpret_cast<char*>(&size), sizeof(size)))
+            return false;
+        buffer.resize(size);
+        return static_cast<bool>(file.read(reinterpret_cast<char*>(buffer.data()), size));
+    };
+
+    if (!readRecord())
+    {
+        Log::get() << Log::WARNING << "SessionRecording::" << __FUNCTION__ << " - File " << path << " is not a session recording" << Log::endl;
+        return false;
+    }
+
+    // The header is checked before deserializing it as a whole, as the file may be anything
+    const auto magic = string(SPLASH_SESSION_RECORDING_MAGIC);
+    if (buffer.size() < sizeof(uint32_t) + magic.size() + sizeof(int32_t) || string(buffer.begin() + sizeof(uint32_t), buffer.begin() + sizeof(uint32_t) + magic.size()) != magic)
+    {
+        Log::get() << Log::WARNING << "SessionRecording::" << __FUNCTION__ << " - File " << path << " is not a session recording" << Log::endl;
+        return false;
+    }
+
+    const auto serializedHeader = Serial::deserialize<SerializedHeader>(buffer);
+    header.version = std::get<1>(serializedHeader);
+    header.configurationFile = std::get<2>(serializedHeader);
+    header.startDate = std::get<3>(serializedHeader);
+    if (header.version != SPLASH_SESSION_RECORDING_VERSION)
+    {
+        Log::get() << Log::WARNING << "SessionRecording::" << __FUNCTION__ << " - File " << path << " has version " << header.version << ", only version "
+                   << SPLASH_SESSION_RECORDING_VERSION << " is supported" << Log::endl;
+        return false;
+    }
+
+    while (readRecord())
+    {
+        auto serializedEvent = Serial::deserialize<SerializedEvent>(buffer);
+        const auto type = std::get<1>(serializedEvent);
+        if (type > static_cast<uint8_t>(EventType::Origin))
+            continue;
+        events.push_back({std::get<0>(serializedEvent), static_cast<EventType>(type), std::move(std::get<2>(serializedEvent)), std::move(std::get<3>(serializedEvent)),
+            std::move(std::get<4>(serializedEvent))});
+    }
+
+    if (!file.eof())
+        Log::get() << Log::WARNING << "SessionRecording::" << __FUNCTION__ << " - Error while reading " << path << ", the recording is read up to this error" << Log::endl;
+
+    stable_sort(events.begin(), events.end(), [](const auto& a, const auto& b) { return a.time < b.time; });
+    return true;
+}
+
+/*************/
+void SessionRecording::write(const Event& event)
+{
+    _buffer.clear();
+    Serial::serialize(SerializedEvent(event.time, static_cast<uint8_t>(event.type), event.name, event.attribute, event.args), _buffer);
+    writeBuffer();
+}
+
+/*************/
+void SessionRecording::writeBuffer()
+{
+    const auto size = static_cast<uint32_t>(_buffer.size());
+    _file.write(reinterpret_cast<const char*>(&size), sizeof(size));
+    _file.write(reinterpret_cast<const char*>(_buffer.data()), _buffer.size());
+    // Events are flushed as they come, for the recording to survive a crash
+    _file.flush();
+}
+
+} // namespace Splash
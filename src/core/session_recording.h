@@ -0,0 +1,187 @@
+/*
+ * Copyright (C) 2026 Emmanuel Durand
+ *
+ * This file is part of Splash.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Splash is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Splash.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * @session_recording.h
+ * Recording of the messages and tree changes received by the World, to replay a session
+ */
+
+#ifndef SPLASH_SESSION_RECORDING_H
+#define SPLASH_SESSION_RECORDING_H
+
+#include <cstdint>
+#include <fstream>
+#include <list>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "./core/tree.h"
+#include "./core/value.h"
+
+// Version of the session recording format, increased with each incompatible change
+#define SPLASH_SESSION_RECORDING_VERSION 1
+
+namespace Splash
+{
+
+/*************/
+//! Recording of a session, as the messages and tree changes received by the World from the Scenes
+//! A session is recorded as a header followed by timestamped events, each one being serialized and
+//! prefixed with its size so that a recording interrupted abruptly can still be read up to its last
+//! complete event. Only the changes made by the users are kept: the messages of the protocol between
+//! the World and the Scenes, as well as the measurement branches of the tree, are left out.
+class SessionRecording
+{
+  public:
+    enum class EventType : uint8_t
+    {
+        Message, //!< Message received through the link, holding the target, the attribute and its values
+        Seeds,   //!< Tree changes, each one held as a Values of the task and its arguments
+        Media,   //!< Media file used by an object, holding its path, size and modification time
+        Origin   //!< Time at which every Scene rendered its first frame, from which the events are replayed
+    };
+
+    struct Event
+    {
+        int64_t time{0}; //!< Time since the start of the recording, in us
+        EventType type{EventType::Message};
+        std::string name{};      //!< Target object, or object using the media
+        std::string attribute{}; //!< Target attribute
+        Values args{};
+    };
+
+    struct Header
+    {
+        int32_t version{SPLASH_SESSION_RECORDING_VERSION};
+        std::string configurationFile{}; //!< Configuration the session was recorded with
+        int64_t startDate{0};            //!< Date of the start of the recording, in ms since epoch
+    };
+
+  public:
+    /**
+     * \brief Constructor
+     */
+    SessionRecording() = default;
+
+    /**
+     * \brief Destructor
+     */
+    ~SessionRecording() { stop(); }
+
+    SessionRecording(const SessionRecording&) = delete;
+    SessionRecording& operator=(const SessionRecording&) = delete;
+
+    /**
+     * \brief Start recording to the given file, replacing it if it exists
+     * \param path File path
+     * \param configurationFile Configuration the session is recorded with
+     * \return Return true if the file could be opened
+     */
+    bool start(const std::string& path, const std::string& configurationFile);
+
+    /**
+     * \brief Stop recording and close the file
+     */
+    void stop();
+
+    /**
+     * \brief Check whether a recording is in progress
+     * \return Return true if recording
+     */
+    bool isRecording() const;
+
+    /**
+     * \brief Record a message received through the link, if it is not part of the protocol between the World and the Scenes
+     * \param name Target object
+     * \param attribute Target attribute
+     * \param args Attribute values
+     */
+    void recordMessage(const std::string& name, const std::string& attribute, const Values& args);
+
+    /**
+     * \brief Record the tree changes received from a peer which concern the attributes, commands and objects
+     * \param seeds Tree seeds
+     */
+    void recordSeeds(const std::list<Tree::Seed>& seeds);
+
+    /**
+     * \brief Record a media file used by an object, so that the replay can check it is still the same
+     * \param name Object name
+     * \param path Media file path
+     */
+    void recordMedia(const std::string& name, const std::string& path);
+
+    /**
+     * \brief Record the time from which the events are replayed
+     */
+    void recordOrigin();
+
+    /**
+     * \brief Check whether a message is recorded, messages of the protocol between the World and the Scenes being left out
+     * \param attribute Message attribute
+     * \return Return true if the message is recorded
+     */
+    static bool isRecordedMessage(const std::string& attribute);
+
+    /**
+     * \brief Check whether a tree change is recorded, changes of the measurement branches being left out
+     * \param task Task type
+     * \param path Path of the branch or leaf
+     * \return Return true if the change is recorded
+     */
+    static bool isRecordedSeed(Tree::Task task, const std::string& path);
+
+    /**
+     * \brief Check that a media file recorded during the session is still the same, and warn otherwise
+     * \param event Media event, other events being ignored
+     * \return Return false if the file is missing or changed since the recording
+     */
+    static bool checkMedia(const Event& event);
+
+    /**
+     * \brief Read a recording
+     * \param path File path
+     * \param header Recording header
+     * \param events Recorded events, sorted by time
+     * \return Return true if the file is a recording of a supported version
+     */
+    static bool read(const std::string& path, Header& header, std::vector<Event>& events);
+
+  private:
+    mutable std::mutex _mutex{};
+    std::ofstream _file{};
+    int64_t _startTime{0}; //!< Time of the start of the recording, in us
+    std::vector<uint8_t> _buffer{};
+
+    /**
+     * \brief Write an event to the file, with _mutex locked
+     * \param event Event
+     */
+    void write(const Event& event);
+
+    /**
+     * \brief Write a serialized record to the file, prefixed with its size, with _mutex locked
+     */
+    void writeBuffer();
+};
+
+} // namespace Splash
+
+#endif // SPLASH_SESSION_RECORDING_H
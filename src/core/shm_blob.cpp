@@ -0,0 +1,165 @@
+#include "./core/shm_blob.h"
+
+#include <cstring>
+#include <fcntl.h>
+#include <functional>
+#include <iomanip>
+#include <sstream>
+#include <string_view>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "./utils/log.h"
+
+using namespace std;
+
+namespace Splash
+{
+
+mutex ShmBlob::_registryMutex{};
+unordered_map<string, weak_ptr<ShmBlob>> ShmBlob::_registry{};
+
+/*************/
+ShmBlob::ShmBlob(const Reference& reference)
+    : _reference(reference)
+{
+}
+
+/*************/
+ShmBlob::~ShmBlob()
+{
+    shm_unlink(_reference.name);
+}
+
+/*************/
+shared_ptr<ShmBlob> ShmBlob::publish(const string& prefix, const uint8_t* data, size_t size)
+{
+    if (!data || size == 0)
+        return {nullptr};
+
+    Reference reference;
+    reference.hash = hash<string_view>()(string_view(reinterpret_cast<const char*>(data), size));
+    reference.size = size;
+
+    ostringstream stream;
+    stream << prefix << getpid() << "_" << hex << setw(16) << setfill('0') << reference.hash;
+    auto name = stream.str();
+    if (name.size() >= SPLASH_SHM_BLOB_NAME_LENGTH)
+    {
+        Log::get() << Log::WARNING << "ShmBlob::" << __FUNCTION__ << " - Shared memory segment name is too long: " << name << Log::endl;
+        return {nullptr};
+    }
+    strncpy(reference.name, name.c_str(), SPLASH_SHM_BLOB_NAME_LENGTH - 1);
+
+    lock_guard<mutex> lock(_registryMutex);
+    for (auto registryIt = _registry.begin(); registryIt != _registry.end();)
+    {
+        if (registryIt->second.expired())
+            registryIt = _registry.erase(registryIt);
+        else
+            ++registryIt;
+    }
+
+    if (auto registryIt = _registry.find(name); registryIt != _registry.end())
+    {
+        auto blob = registryIt->second.lock();
+        if (blob->_reference.size == size)
+            return blob;
+
+        // Hash collision with a live blob, let the caller fall back to sending the content
+        return {nullptr};
+    }
+
+    // A segment with the same name can only be a leftover from a previous process with the same pid
+    int fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, S_IRUSR | S_IWUSR);
+    if (fd < 0 && errno == EEXIST)
+    {
+        shm_unlink(name.c_str());
+        fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, S_IRUSR | S_IWUSR);
+    }
+
+    if (fd < 0)
+    {
+        Log::get() << Log::WARNING << "ShmBlob::" << __FUNCTION__ << " - Unable to create shared memory segment " << name << ": " << string(strerror(errno)) << Log::endl;
+        return {nullptr};
+    }
+
+    if (ftruncate(fd, size) != 0)
+    {
+        Log::get() << Log::WARNING << "ShmBlob::" << __FUNCTION__ << " - Unable to resize shared memory segment " << name << ": " << string(strerror(errno)) << Log::endl;
+        close(fd);
+        shm_unlink(name.c_str());
+        return {nullptr};
+    }
+
+    auto ptr = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (ptr == MAP_FAILED)
+    {
+        shm_unlink(name.c_str());
+        return {nullptr};
+    }
+
+    // The segment is only written once, readers only ever map it read only
+    memcpy(ptr, data, size);
+    munmap(ptr, size);
+
+    auto blob = shared_ptr<ShmBlob>(new ShmBlob(reference));
+    _registry[name] = blob;
+    return blob;
+}
+
+/*************/
+shared_ptr<SerializedObject> ShmBlob::map(const Reference& reference)
+{
+    if (reference.size == 0 || strnlen(reference.name, SPLASH_SHM_BLOB_NAME_LENGTH) == SPLASH_SHM_BLOB_NAME_LENGTH)
+        return {nullptr};
+
+    int fd = shm_open(reference.name, O_RDONLY, 0);
+    if (fd < 0)
+    {
+        Log::get() << Log::WARNING << "ShmBlob::" << __FUNCTION__ << " - Unable to open shared memory segment " << reference.name << ": " << string(strerror(errno)) << Log::endl;
+        return {nullptr};
+    }
+
+    struct stat segmentStat;
+    if (fstat(fd, &segmentStat) != 0 || static_cast<uint64_t>(segmentStat.st_size) < reference.size)
+    {
+        close(fd);
+        return {nullptr};
+    }
+
+    auto ptr = mmap(nullptr, reference.size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (ptr == MAP_FAILED)
+        return {nullptr};
+
+    auto size = static_cast<size_t>(reference.size);
+    auto data = ResizableArray<uint8_t>(static_cast<uint8_t*>(ptr), size, [size](uint8_t* mapped) { munmap(mapped, size); });
+    return make_shared<SerializedObject>(std::move(data));
+}
+
+/*************/
+optional<ShmBlob::Reference> ShmBlob::getReference(const shared_ptr<SerializedObject>& obj)
+{
+    if (!obj || obj->size() != sizeof(Reference))
+        return {};
+
+    Reference reference;
+    memcpy(&reference, obj->data(), sizeof(Reference));
+    if (memcmp(reference.magic, SPLASH_SHM_BLOB_MAGIC, sizeof(reference.magic)) != 0)
+        return {};
+
+    return reference;
+}
+
+/*************/
+shared_ptr<SerializedObject> ShmBlob::serializeReference() const
+{
+    auto obj = make_shared<SerializedObject>(sizeof(Reference));
+    memcpy(obj->data(), &_reference, sizeof(Reference));
+    return obj;
+}
+
+} // namespace Splash
@@ -0,0 +1,118 @@
+/*
+ * Copyright (C) 2026 Emmanuel Durand
+ *
+ * This file is part of Splash.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Splash is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Splash.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * @shm_blob.h
+ * Immutable, content addressed buffers published in shared memory
+ */
+
+#ifndef SPLASH_SHM_BLOB_H
+#define SPLASH_SHM_BLOB_H
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+
+#include "./core/serialized_object.h"
+
+#define SPLASH_SHM_BLOB_MAGIC "SPLBLOB"
+#define SPLASH_SHM_BLOB_NAME_LENGTH 64
+
+namespace Splash
+{
+
+/*************/
+//! Immutable buffer published in a shared memory segment named after its content
+//! The segment is unlinked when the last ShmBlob referring to it is destroyed,
+//! readers which already mapped it keep their mapping until they release it.
+class ShmBlob
+{
+  public:
+    //! Small description of a blob, sent instead of the blob content
+    struct Reference
+    {
+        char magic[8]{SPLASH_SHM_BLOB_MAGIC};
+        uint64_t hash{0};
+        uint64_t size{0};
+        char name[SPLASH_SHM_BLOB_NAME_LENGTH]{};
+    };
+
+  public:
+    /**
+     * Publish the given buffer, or get the existing blob if the same content has already been published by this process
+     * \param prefix Prefix for the segment name, must start with a '/'
+     * \param data Buffer to publish
+     * \param size Buffer size
+     * \return Return the blob, or nullptr if the shared memory segment could not be created
+     */
+    static std::shared_ptr<ShmBlob> publish(const std::string& prefix, const uint8_t* data, size_t size);
+
+    /**
+     * Map the blob described by the given reference, read only
+     * \param reference Blob reference
+     * \return Return a SerializedObject mapping the blob, or nullptr if the segment could not be mapped
+     */
+    static std::shared_ptr<SerializedObject> map(const Reference& reference);
+
+    /**
+     * Check whether a serialized object holds a blob reference
+     * \param obj Serialized object
+     * \return Return the reference if the object holds one
+     */
+    static std::optional<Reference> getReference(const std::shared_ptr<SerializedObject>& obj);
+
+    /**
+     * Destructor, unlinks the shared memory segment
+     */
+    ~ShmBlob();
+
+    ShmBlob(const ShmBlob&) = delete;
+    ShmBlob& operator=(const ShmBlob&) = delete;
+
+    /**
+     * Get a serialized object holding the reference to this blob, to be sent to the readers
+     * \return Return the serialized reference
+     */
+    std::shared_ptr<SerializedObject> serializeReference() const;
+
+    /**
+     * Get the reference to this blob
+     * \return Return the reference
+     */
+    const Reference& getReference() const { return _reference; }
+
+  private:
+    Reference _reference{};
+
+    static std::mutex _registryMutex;
+    static std::unordered_map<std::string, std::weak_ptr<ShmBlob>> _registry;
+
+    /**
+     * Constructor
+     * \param reference Reference of the already created segment
+     */
+    explicit ShmBlob(const Reference& reference);
+};
+
+} // namespace Splash
+
+#endif // SPLASH_SHM_BLOB_H
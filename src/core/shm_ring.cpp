@@ -0,0 +1,395 @@
+#include "./core/shm_ring.h"
+
+#include <cerrno>
+#include <csignal>
+#include <cstring>
+#include <fcntl.h>
+#include <limits>
+#include <new>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "./utils/log.h"
+#include "./utils/scope_guard.h"
+
+// Slots are grown by steps of this size, to avoid resizing them for slightly different buffers
+#define SPLASH_SHM_RING_GRANULARITY (1 << 20)
+
+using namespace std;
+
+namespace Splash
+{
+
+/*************/
+ShmRing::Segment::Segment(int fd, size_t size)
+{
+    if (fd < 0 || size == 0)
+        return;
+
+    auto ptr = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (ptr == MAP_FAILED)
+        return;
+
+    data = static_cast<uint8_t*>(ptr);
+    this->size = size;
+}
+
+/*************/
+ShmRing::Segment::~Segment()
+{
+    if (data)
+        munmap(data, size);
+}
+
+/*************/
+ShmRing::ShmRing(const string& name)
+    : _name(name)
+{
+    _slots.resize(SPLASH_SHM_RING_SLOTS);
+    _slotFds.resize(SPLASH_SHM_RING_SLOTS, -1);
+    _slotSequences.resize(SPLASH_SHM_RING_SLOTS, 0);
+
+    auto controlName = getControlName(_name);
+    int fd = shm_open(controlName.c_str(), O_CREAT | O_RDWR | O_TRUNC, S_IRUSR | S_IWUSR);
+    if (fd < 0)
+    {
+        Log::get() << Log::WARNING << "ShmRing::" << __FUNCTION__ << " - Unable to create shared memory segment " << controlName << ": " << string(strerror(errno)) << Log::endl;
+        return;
+    }
+
+    if (ftruncate(fd, sizeof(Control)) != 0)
+    {
+        Log::get() << Log::WARNING << "ShmRing::" << __FUNCTION__ << " - Unable to resize shared memory segment " << controlName << ": " << string(strerror(errno)) << Log::endl;
+        close(fd);
+        shm_unlink(controlName.c_str());
+        return;
+    }
+
+    auto control = make_shared<Segment>(fd, sizeof(Control));
+    close(fd);
+    if (!control->isValid())
+    {
+        shm_unlink(controlName.c_str());
+        return;
+    }
+
+    new (control->data) Control();
+    _control = control;
+}
+
+/*************/
+ShmRing::~ShmRing()
+{
+    if (!_control)
+        return;
+
+    for (uint32_t slot = 0; slot < _slotFds.size(); ++slot)
+    {
+        if (_slotFds[slot] < 0)
+            continue;
+        close(_slotFds[slot]);
+        shm_unlink(getSlotName(_name, slot).c_str());
+    }
+    shm_unlink(getControlName(_name).c_str());
+}
+
+/*************/
+bool ShmRing::reserveSlot(uint32_t slot, size_t size)
+{
+    if (_slots[slot] && _slots[slot]->size >= size)
+        return true;
+
+    auto slotName = getSlotName(_name, slot);
+    if (_slotFds[slot] < 0)
+    {
+        _slotFds[slot] = shm_open(slotName.c_str(), O_CREAT | O_RDWR | O_TRUNC, S_IRUSR | S_IWUSR);
+        if (_slotFds[slot] < 0)
+        {
+            Log::get() << Log::WARNING << "ShmRing::" << __FUNCTION__ << " - Unable to create shared memory segment " << slotName << ": " << string(strerror(errno)) << Log::endl;
+            return false;
+        }
+    }
+
+    // Segments only grow: readers may still have the previous, smaller mapping cached
+    auto capacity = ((size + SPLASH_SHM_RING_GRANULARITY - 1) / SPLASH_SHM_RING_GRANULARITY) * SPLASH_SHM_RING_GRANULARITY;
+    if (ftruncate(_slotFds[slot], capacity) != 0)
+    {
+        Log::get() << Log::WARNING << "ShmRing::" << __FUNCTION__ << " - Unable to resize shared memory segment " << slotName << ": " << string(strerror(errno)) << Log::endl;
+        return false;
+    }
+
+    auto segment = make_shared<Segment>(_slotFds[slot], capacity);
+    if (!segment->isValid())
+        return false;
+
+    _slots[slot] = segment;
+    return true;
+}
+
+/*************/
+bool ShmRing::acquireSlot(uint32_t slot)
+{
+    auto control = getControl();
+
+    // Readers which did not receive the last descriptor of the slot yet may still adopt it
+    for (const auto& reader : control->readers)
+        if (reader.active.load() && reader.lastSequence.load() < _slotSequences[slot])
+            return false;
+
+    auto& slotControl = control->slots[slot];
+    uint32_t expected = 0;
+    if (!slotControl.refCount.compare_exchange_strong(expected, 1))
+        return false;
+
+    // The generation is changed before checking the holds, while readers check it after adding theirs,
+    // so that a reader adopting the slot concurrently either is seen here or sees it was reused
+    slotControl.generation.fetch_add(1);
+    for (const auto& reader : control->readers)
+    {
+        if (reader.active.load() && reader.holds[slot].load() != 0)
+        {
+            slotControl.refCount.store(0);
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/*************/
+void ShmRing::reclaimReaders()
+{
+    for (auto& reader : getControl()->readers)
+    {
+        auto pid = reader.pid.load();
+        if (pid == 0)
+            continue;
+
+        bool exited = kill(pid, 0) != 0 && errno == ESRCH;
+        bool gone = reader.lastSequence.load() == numeric_limits<uint64_t>::max();
+        for (const auto& holds : reader.holds)
+            gone = gone && holds.load() == 0;
+
+        if (exited || gone)
+        {
+            reader.active.store(0);
+            reader.pid.store(0);
+        }
+    }
+}
+
+/*************/
+shared_ptr<SerializedObject> ShmRing::allocate(size_t size)
+{
+    if (!_control || size == 0)
+        return {nullptr};
+
+    lock_guard<mutex> lock(_mutex);
+
+    // If all the slots are held, some may only be held by readers which are not there anymore
+    for (uint32_t pass = 0; pass < 2; ++pass)
+    {
+        if (pass == 1)
+            reclaimReaders();
+
+        for (uint32_t i = 0; i < SPLASH_SHM_RING_SLOTS; ++i)
+        {
+            auto slot = (_nextSlot + i) % SPLASH_SHM_RING_SLOTS;
+            if (!acquireSlot(slot))
+                continue;
+
+            if (!reserveSlot(slot, size))
+            {
+                getControl()->slots[slot].refCount.store(0, memory_order_release);
+                return {nullptr};
+            }
+
+            _nextSlot = (slot + 1) % SPLASH_SHM_RING_SLOTS;
+
+            // The deleter holds references to the mappings, so that they outlive the ring if needed
+            auto controlSegment = _control;
+            auto slotSegment = _slots[slot];
+            auto data = ResizableArray<uint8_t>(slotSegment->data, size, [controlSegment, slotSegment, slot](uint8_t*) {
+                auto control = reinterpret_cast<Control*>(controlSegment->data);
+                control->slots[slot].refCount.fetch_sub(1, memory_order_acq_rel);
+            });
+            return make_shared<SerializedObject>(std::move(data));
+        }
+    }
+
+    return {nullptr};
+}
+
+/*************/
+optional<ShmRing::Descriptor> ShmRing::retain(const shared_ptr<SerializedObject>& obj)
+{
+    if (!_control || !obj || obj->size() == 0)
+        return {};
+
+    lock_guard<mutex> lock(_mutex);
+    auto dataPtr = obj->data();
+    for (uint32_t slot = 0; slot < SPLASH_SHM_RING_SLOTS; ++slot)
+    {
+        const auto& segment = _slots[slot];
+        if (!segment || dataPtr < segment->data || dataPtr + obj->size() > segment->data + segment->size)
+            continue;
+
+        // The slot is then kept until every reader received this descriptor or a later one
+        _slotSequences[slot] = ++_sequence;
+
+        Descriptor descriptor;
+        descriptor.slot = slot;
+        descriptor.generation = getControl()->slots[slot].generation.load(memory_order_acquire);
+        descriptor.sequence = _slotSequences[slot];
+        descriptor.offset = static_cast<uint64_t>(dataPtr - segment->data);
+        descriptor.size = obj->size();
+        return descriptor;
+    }
+
+    return {};
+}
+
+/*************/
+void ShmRing::removeReader(const string& readerName)
+{
+    if (!_control)
+        return;
+
+    lock_guard<mutex> lock(_mutex);
+    for (auto& reader : getControl()->readers)
+        if (reader.pid.load() != 0 && strncmp(reader.name, readerName.c_str(), SPLASH_SHM_RING_READER_NAME_LENGTH) == 0)
+            reader.active.store(0);
+}
+
+/*************/
+ShmRingReader::ShmRingReader(const string& name, const string& readerName)
+    : _name(name)
+    , _readerName(readerName)
+{
+    _slots.resize(SPLASH_SHM_RING_SLOTS);
+}
+
+/*************/
+ShmRingReader::~ShmRingReader()
+{
+    // The buffers still adopted keep their holds, and the writer frees the entry once they are released
+    if (_control && _readerIndex >= 0)
+        reinterpret_cast<ShmRing::Control*>(_control->data)->readers[_readerIndex].lastSequence.store(numeric_limits<uint64_t>::max());
+}
+
+/*************/
+bool ShmRingReader::registerReader()
+{
+    auto control = reinterpret_cast<ShmRing::Control*>(_control->data);
+    for (int index = 0; index < SPLASH_SHM_RING_READERS; ++index)
+    {
+        auto& reader = control->readers[index];
+        int32_t expected = 0;
+        if (!reader.pid.compare_exchange_strong(expected, static_cast<int32_t>(getpid())))
+            continue;
+
+        for (auto& holds : reader.holds)
+            holds.store(0);
+        reader.lastSequence.store(0);
+        strncpy(reader.name, _readerName.c_str(), SPLASH_SHM_RING_READER_NAME_LENGTH - 1);
+        reader.name[SPLASH_SHM_RING_READER_NAME_LENGTH - 1] = '\0';
+        reader.active.store(1);
+
+        _readerIndex = index;
+        return true;
+    }
+
+    Log::get() << Log::WARNING << "ShmRingReader::" << __FUNCTION__ << " - No entry left to register as a reader of " << _name << Log::endl;
+    return false;
+}
+
+/*************/
+shared_ptr<ShmRing::Segment> ShmRingReader::mapSegment(const string& name)
+{
+    int fd = shm_open(name.c_str(), O_RDWR, 0);
+    if (fd < 0)
+    {
+        Log::get() << Log::WARNING << "ShmRingReader::" << __FUNCTION__ << " - Unable to open shared memory segment " << name << ": " << string(strerror(errno)) << Log::endl;
+        return {nullptr};
+    }
+
+    struct stat segmentStat;
+    if (fstat(fd, &segmentStat) != 0)
+    {
+        close(fd);
+        return {nullptr};
+    }
+
+    auto segment = make_shared<ShmRing::Segment>(fd, static_cast<size_t>(segmentStat.st_size));
+    close(fd);
+    if (!segment->isValid())
+        return {nullptr};
+
+    return segment;
+}
+
+/*************/
+shared_ptr<SerializedObject> ShmRingReader::adopt(const ShmRing::Descriptor& descriptor)
+{
+    if (descriptor.slot >= SPLASH_SHM_RING_SLOTS || descriptor.size == 0)
+        return {nullptr};
+
+    if (!_control)
+    {
+        _control = mapSegment(ShmRing::getControlName(_name));
+        if (!_control || _control->size < sizeof(ShmRing::Control) || reinterpret_cast<ShmRing::Control*>(_control->data)->magic != SPLASH_SHM_RING_MAGIC)
+        {
+            _control.reset();
+            return {nullptr};
+        }
+
+        registerReader();
+    }
+
+    // Buffers are only adopted once registered, so that the writer waits for them to be released
+    if (_readerIndex < 0)
+        return {nullptr};
+
+    auto controlSegment = _control;
+    auto control = reinterpret_cast<ShmRing::Control*>(controlSegment->data);
+    auto& reader = control->readers[_readerIndex];
+
+    // The writer stops waiting for this reader when disconnecting from it, until it reconnects
+    if (reader.active.load() == 0)
+        reader.active.store(1);
+    auto holds = &reader.holds[descriptor.slot];
+    auto releaseSlot = [holds]() { holds->fetch_sub(1, memory_order_acq_rel); };
+
+    // The hold is added before marking the descriptor as received, so that the writer does not reuse the slot in between
+    holds->fetch_add(1);
+    OnScopeExit
+    {
+        reader.lastSequence.store(descriptor.sequence);
+    };
+
+    // As the writer keeps the slot until its descriptor is received, it can only have been reused if this reader registered since it was sent
+    if (control->slots[descriptor.slot].generation.load() != descriptor.generation)
+    {
+        Log::get() << Log::WARNING << "ShmRingReader::" << __FUNCTION__ << " - Slot " << descriptor.slot << " of " << _name << " has been reused before being read" << Log::endl;
+        releaseSlot();
+        return {nullptr};
+    }
+
+    // The slot may have been grown by the writer since it was last mapped
+    auto& segment = _slots[descriptor.slot];
+    if (!segment || segment->size < descriptor.offset + descriptor.size)
+        segment = mapSegment(ShmRing::getSlotName(_name, descriptor.slot));
+
+    if (!segment || segment->size < descriptor.offset + descriptor.size)
+    {
+        releaseSlot();
+        return {nullptr};
+    }
+
+    auto slotSegment = segment;
+    auto data = ResizableArray<uint8_t>(slotSegment->data + descriptor.offset, descriptor.size, [controlSegment, slotSegment, releaseSlot](uint8_t*) { releaseSlot(); });
+    return make_shared<SerializedObject>(std::move(data));
+}
+
+} // namespace Splash
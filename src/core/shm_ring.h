@@ -0,0 +1,246 @@
+/*
+ * Copyright (C) 2026 Emmanuel Durand
+ *
+ * This file is part of Splash.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Splash is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Splash.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * @shm_ring.h
+ * Ring of shared memory slots, used by the Link to send buffers without copying them
+ */
+
+#ifndef SPLASH_SHM_RING_H
+#define SPLASH_SHM_RING_H
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "./core/serialized_object.h"
+
+#define SPLASH_SHM_RING_SLOTS 32
+#define SPLASH_SHM_RING_READERS 16
+#define SPLASH_SHM_RING_READER_NAME_LENGTH 64
+#define SPLASH_SHM_RING_MAGIC 0x53504c49
+
+namespace Splash
+{
+
+/*************/
+//! Writer side of the shared memory ring
+//! Each slot is a separate shared memory segment, which is grown as needed.
+//! Readers register in a control segment shared with the writer, where they mark the descriptors they received
+//! and the buffers they hold. A slot is only reused once every registered reader received its last descriptor,
+//! or a later one as descriptors lost on the way are never received, and released it.
+class ShmRing
+{
+  public:
+    //! Description of a buffer held in a slot, which is sent to the readers
+    struct Descriptor
+    {
+        uint32_t slot{0};
+        uint32_t generation{0};
+        uint64_t sequence{0}; //!< Number of the descriptor, increasing with each buffer sent
+        uint64_t offset{0};
+        uint64_t size{0};
+    };
+
+    //! Memory mapped segment, unmapped when the last reference is dropped
+    struct Segment
+    {
+        Segment(int fd, size_t size);
+        ~Segment();
+        bool isValid() const { return data != nullptr; }
+
+        uint8_t* data{nullptr};
+        size_t size{0};
+    };
+
+    //! Information about a slot, stored in the control segment
+    struct SlotControl
+    {
+        std::atomic<uint32_t> refCount{0}; //!< References held by the writer
+        std::atomic<uint32_t> generation{0};
+    };
+
+    //! Information about a reader, stored in the control segment
+    struct ReaderControl
+    {
+        std::atomic<int32_t> pid{0};                         //!< Process of the reader, 0 if the entry is free
+        std::atomic<uint32_t> active{0};                     //!< Set once registered, cleared when the writer disconnects from the reader
+        std::atomic<uint64_t> lastSequence{0};               //!< Sequence of the last descriptor received
+        std::atomic<uint32_t> holds[SPLASH_SHM_RING_SLOTS]{}; //!< Buffers adopted and not released yet, by slot
+        char name[SPLASH_SHM_RING_READER_NAME_LENGTH]{};
+    };
+
+    //! Layout of the control segment
+    struct Control
+    {
+        uint32_t magic{SPLASH_SHM_RING_MAGIC};
+        uint32_t slotCount{SPLASH_SHM_RING_SLOTS};
+        SlotControl slots[SPLASH_SHM_RING_SLOTS];
+        ReaderControl readers[SPLASH_SHM_RING_READERS];
+    };
+
+  public:
+    /**
+     * Constructor
+     * \param name Base name for the shared memory segments, must start with a '/'
+     */
+    explicit ShmRing(const std::string& name);
+
+    /**
+     * Destructor, unlinks all the shared memory segments
+     * Memory still used by some SerializedObject stays mapped until they are released
+     */
+    ~ShmRing();
+
+    ShmRing(const ShmRing&) = delete;
+    ShmRing& operator=(const ShmRing&) = delete;
+
+    /**
+     * Check whether the ring has been created successfully
+     * \return Return true if the ring is usable
+     */
+    bool isValid() const { return _control != nullptr; }
+
+    /**
+     * Get a SerializedObject backed by a free slot
+     * \param size Size of the buffer
+     * \return Return a SerializedObject, or nullptr if no slot is currently free
+     */
+    std::shared_ptr<SerializedObject> allocate(size_t size);
+
+    /**
+     * Retain the slot holding the given buffer until the readers received its descriptor
+     * \param obj Buffer previously given by allocate()
+     * \return Return the descriptor to send to the readers, or nothing if the buffer is not held by this ring
+     */
+    std::optional<Descriptor> retain(const std::shared_ptr<SerializedObject>& obj);
+
+    /**
+     * Stop waiting for a reader, for example once disconnected from it, releasing the buffers it holds
+     * \param readerName Name the reader registered with
+     */
+    void removeReader(const std::string& readerName);
+
+    /**
+     * Get the name of the control segment for a given ring name
+     * \param name Ring name
+     * \return Return the control segment name
+     */
+    static std::string getControlName(const std::string& name) { return name + "_ctl"; }
+
+    /**
+     * Get the name of a slot segment for a given ring name
+     * \param name Ring name
+     * \param slot Slot index
+     * \return Return the slot segment name
+     */
+    static std::string getSlotName(const std::string& name, uint32_t slot) { return name + "_" + std::to_string(slot); }
+
+  private:
+    std::string _name{};
+    std::shared_ptr<Segment> _control{nullptr};
+    std::vector<std::shared_ptr<Segment>> _slots{};
+    std::vector<int> _slotFds{};
+    std::vector<uint64_t> _slotSequences{}; //!< Sequence of the last descriptor of each slot
+    uint64_t _sequence{0};
+    uint32_t _nextSlot{0};
+    std::mutex _mutex{};
+
+    /**
+     * Get the control structure
+     * \return Return a pointer to the control structure
+     */
+    Control* getControl() const { return reinterpret_cast<Control*>(_control->data); }
+
+    /**
+     * Make sure a slot segment is large enough
+     * \param slot Slot index
+     * \param size Minimum size
+     * \return Return true if the slot is large enough
+     */
+    bool reserveSlot(uint32_t slot, size_t size);
+
+    /**
+     * Try to take a slot for a new buffer
+     * \param slot Slot index
+     * \return Return true if the slot was free, in which case it is now held by the writer
+     */
+    bool acquireSlot(uint32_t slot);
+
+    /**
+     * Free the entries of the readers which exited, or which are gone and do not hold any buffer anymore
+     */
+    void reclaimReaders();
+};
+
+/*************/
+//! Reader side of the shared memory ring
+class ShmRingReader
+{
+  public:
+    /**
+     * Constructor
+     * \param name Base name of the ring to read from
+     * \param readerName Name to register with in the ring, used by the writer to stop waiting for this reader
+     */
+    ShmRingReader(const std::string& name, const std::string& readerName);
+
+    /**
+     * Destructor, the writer not waiting for descriptors anymore. Buffers still adopted are held until released
+     */
+    ~ShmRingReader();
+
+    ShmRingReader(const ShmRingReader&) = delete;
+    ShmRingReader& operator=(const ShmRingReader&) = delete;
+
+    /**
+     * Get a SerializedObject mapping the buffer described by the descriptor, without copying it
+     * The descriptor is marked as received even if it can not be adopted, and the slot is released when the SerializedObject inner buffer is destroyed
+     * \param descriptor Buffer descriptor
+     * \return Return the SerializedObject, or nullptr if the segment could not be mapped
+     */
+    std::shared_ptr<SerializedObject> adopt(const ShmRing::Descriptor& descriptor);
+
+  private:
+    std::string _name{};
+    std::string _readerName{};
+    std::shared_ptr<ShmRing::Segment> _control{nullptr};
+    std::vector<std::shared_ptr<ShmRing::Segment>> _slots{};
+    int _readerIndex{-1}; //!< Entry of this reader in the control segment, -1 if not registered
+
+    /**
+     * Register this reader in the control segment
+     * \return Return true if an entry was available
+     */
+    bool registerReader();
+
+    /**
+     * Map the given segment
+     * \param name Segment name
+     * \return Return the mapped segment, or nullptr
+     */
+    static std::shared_ptr<ShmRing::Segment> mapSegment(const std::string& name);
+};
+
+} // namespace Splash
+
+#endif // SPLASH_SHM_RING_H
@@ -20,32 +20,123 @@
 /*
  * @spinlock.h
  * Spinlock, when mutexes have too much overhead
+ * It spins briefly before sleeping, so it is safe to hold it for longer operations
  */
 
 #ifndef SPLASH_SPINLOCK_H
 #define SPLASH_SPINLOCK_H
 
 #include <atomic>
+#include <cstdint>
 #include <thread>
 
+#include "./config.h"
+
+#if HAVE_LINUX
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#define SPLASH_SPINLOCK_SPIN_COUNT 128
+
 namespace Splash
 {
 
 /*************/
+//! Adaptive lock: it spins for a short while when contended, then sleeps on a futex
+//! until the lock is released, to avoid burning cores while another thread holds
+//! it for a long time. Not recursive.
 class Spinlock
 {
   public:
-    void unlock() { _lock.clear(std::memory_order_release); }
-    bool try_lock() { return !_lock.test_and_set(std::memory_order_acquire); }
+    //! Counters shared by all Spinlocks, only updated on contention
+    struct Statistics
+    {
+        uint64_t contended{0}; //!< Number of lock calls which found the lock held
+        uint64_t parked{0};    //!< Number of those which had to sleep until the lock was released
+    };
+
+  public:
+    void unlock()
+    {
+        if (_state.exchange(State::unlocked, std::memory_order_release) == State::lockedWithWaiters)
+            wake();
+    }
+
+    bool try_lock()
+    {
+        uint32_t expected = State::unlocked;
+        return _state.compare_exchange_strong(expected, State::locked, std::memory_order_acquire, std::memory_order_relaxed);
+    }
+
     void lock()
     {
-        for (uint32_t i = 0; !try_lock(); ++i)
-            if (i % 100 == 0)
-                std::this_thread::yield();
+        if (!try_lock())
+            lockContended();
     }
 
+    /**
+     * Get the contention counters of all Spinlocks
+     * \return Return the counters
+     */
+    static Statistics getStatistics() { return {_contendedCount.load(std::memory_order_relaxed), _parkedCount.load(std::memory_order_relaxed)}; }
+
   private:
-    std::atomic_flag _lock = ATOMIC_FLAG_INIT;
+    enum State : uint32_t
+    {
+        unlocked = 0,
+        locked,
+        lockedWithWaiters
+    };
+
+    std::atomic<uint32_t> _state{State::unlocked};
+
+    static inline std::atomic_uint64_t _contendedCount{0};
+    static inline std::atomic_uint64_t _parkedCount{0};
+
+    void lockContended()
+    {
+        _contendedCount.fetch_add(1, std::memory_order_relaxed);
+
+        for (uint32_t i = 0; i < SPLASH_SPINLOCK_SPIN_COUNT; ++i)
+        {
+            pause();
+            if (_state.load(std::memory_order_relaxed) == State::unlocked && try_lock())
+                return;
+        }
+
+        _parkedCount.fetch_add(1, std::memory_order_relaxed);
+
+        // From now on the lock is flagged as having waiters, so that unlock wakes one of them up
+        while (_state.exchange(State::lockedWithWaiters, std::memory_order_acquire) != State::unlocked)
+            wait();
+    }
+
+    static inline void pause()
+    {
+#if defined(__x86_64__) || defined(__i386__)
+        __builtin_ia32_pause();
+#elif defined(__aarch64__)
+        asm volatile("yield");
+#endif
+    }
+
+    void wait()
+    {
+#if HAVE_LINUX
+        syscall(SYS_futex, reinterpret_cast<uint32_t*>(&_state), FUTEX_WAIT_PRIVATE, State::lockedWithWaiters, nullptr, nullptr, 0);
+#else
+        std::this_thread::yield();
+#endif
+    }
+
+    void wake()
+    {
+#if HAVE_LINUX
+        syscall(SYS_futex, reinterpret_cast<uint32_t*>(&_state), FUTEX_WAKE_PRIVATE, 1, nullptr, nullptr, 0);
+#endif
+    }
 };
 
 } // namespace Splash
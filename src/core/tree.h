@@ -30,5 +30,6 @@
 #include "./core/tree/tree_branch.h"
 #include "./core/tree/tree_leaf.h"
 #include "./core/tree/tree_root.h"
+#include "./core/tree/tree_snapshot.h"
 
 #endif // SPLASH_TREE_H
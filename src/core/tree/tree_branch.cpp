@@ -61,6 +61,7 @@ bool Branch::addBranch(unique_ptr<Branch>&& branch)
 
     branch->setParent(this);
     _branches.emplace(branchName, move(branch));
+    invalidateSnapshot();
 
     for (const auto& id : _callbackTargetIds[Task::AddBranch])
         _callbacks[id](*this, branchName);
@@ -80,6 +81,7 @@ bool Branch::addLeaf(unique_ptr<Leaf>&& leaf)
 
     leaf->setParent(this);
     _leaves.emplace(leafName, move(leaf));
+    invalidateSnapshot();
 
     for (const auto& id : _callbackTargetIds[Task::AddLeaf])
         _callbacks[id](*this, leafName);
@@ -121,6 +123,7 @@ unique_ptr<Branch> Branch::cutBranch(const string& branchName)
     swap(branchIt->second, branch);
     _branches.erase(branchIt);
     branch->setParent(nullptr);
+    invalidateSnapshot();
     return branch;
 }
 
@@ -135,6 +138,7 @@ unique_ptr<Leaf> Branch::cutLeaf(const string& leafName)
     swap(leafIt->second, leaf);
     _leaves.erase(leafIt);
     leaf->setParent(nullptr);
+    invalidateSnapshot();
     return leaf;
 }
 
@@ -188,6 +192,31 @@ string Branch::getPath() const
     return path;
 }
 
+/*************/
+shared_ptr<const Snapshot::Branch> Branch::getSnapshot() const
+{
+    if (_snapshot)
+        return _snapshot;
+
+    // Unchanged children are shared with the previous snapshots
+    auto snapshot = make_shared<Snapshot::Branch>();
+    for (const auto& branch : _branches)
+        snapshot->branches.emplace(branch.first, branch.second->getSnapshot());
+    for (const auto& leaf : _leaves)
+        snapshot->leaves.emplace(leaf.first, leaf.second->getSnapshot());
+
+    _snapshot = snapshot;
+    return _snapshot;
+}
+
+/*************/
+void Branch::invalidateSnapshot()
+{
+    // Parents of a branch without snapshot node do not have one either
+    for (auto branch = this; branch && branch->_snapshot; branch = branch->_parentBranch)
+        branch->_snapshot.reset();
+}
+
 /*************/
 string Branch::print(int indent) const
 {
@@ -216,6 +245,7 @@ bool Branch::removeBranch(const string& name)
 
     _branches[name]->setParent(nullptr);
     _branches.erase(name);
+    invalidateSnapshot();
 
     return true;
 }
@@ -231,6 +261,7 @@ bool Branch::removeLeaf(const string& name)
 
     _leaves[name]->setParent(nullptr);
     _leaves.erase(name);
+    invalidateSnapshot();
     return true;
 }
 
@@ -247,6 +278,7 @@ bool Branch::renameBranch(const string& name, const string& newName)
     branchIt->second->setName(newName);
     _branches.emplace(newName, move(branchIt->second));
     _branches.erase(name);
+    invalidateSnapshot();
     return true;
 }
 
@@ -260,6 +292,7 @@ bool Branch::renameLeaf(const string& name, const string& newName)
     leafIt->second->setName(newName);
     _leaves.emplace(newName, move(leafIt->second));
     _leaves.erase(leafIt);
+    invalidateSnapshot();
     return true;
 }
 
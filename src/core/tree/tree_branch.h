@@ -37,6 +37,7 @@
 #include <utility>
 
 #include "./core/constants.h"
+#include "./core/tree/tree_snapshot.h"
 #include "./utils/dense_map.h"
 
 namespace Splash
@@ -54,6 +55,7 @@ class Leaf;
  */
 class Branch
 {
+    friend Leaf;
     friend Root;
 
   public:
@@ -178,6 +180,12 @@ class Branch
      */
     std::string getPath() const;
 
+    /**
+     * Get the immutable node capturing the current state of this branch, rebuilt only if it changed since the last call
+     * \return Return the snapshot node
+     */
+    std::shared_ptr<const Snapshot::Branch> getSnapshot() const;
+
     /**
      * Return a string describing the branch
      * \param indent Indent for this branch
@@ -236,6 +244,12 @@ class Branch
     DenseMap<std::string, std::unique_ptr<Branch>> _branches{};
     DenseMap<std::string, std::unique_ptr<Leaf>> _leaves{};
     Branch* _parentBranch{nullptr};
+    mutable std::shared_ptr<const Snapshot::Branch> _snapshot{nullptr}; //!< Node this branch was last captured as, reset when it or a child changes
+
+    /**
+     * Reset the snapshot node of this branch and of its parents, after a change
+     */
+    void invalidateSnapshot();
 };
 
 } // namespace Tree
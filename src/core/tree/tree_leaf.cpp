@@ -57,6 +57,14 @@ string Leaf::getPath() const
     return path;
 }
 
+/*************/
+shared_ptr<const Snapshot::Leaf> Leaf::getSnapshot() const
+{
+    if (!_snapshot)
+        _snapshot = make_shared<const Snapshot::Leaf>(Snapshot::Leaf{_value, _timestamp});
+    return _snapshot;
+}
+
 /*************/
 string Leaf::print(int indent) const
 {
@@ -92,6 +100,9 @@ bool Leaf::set(Value value, chrono::system_clock::time_point timestamp)
 
     _timestamp = timestamp;
     _value = value;
+    _snapshot.reset();
+    if (_parentBranch)
+        _parentBranch->invalidateSnapshot();
 
     lock_guard<mutex> lock(_callbackMutex);
     for (const auto& callback : _callbacks)
@@ -36,6 +36,7 @@
 
 #include "./core/constants.h"
 
+#include "./core/tree/tree_snapshot.h"
 #include "./core/value.h"
 #include "./utils/dense_map.h"
 
@@ -99,6 +100,12 @@ class Leaf
      */
     std::string getPath() const;
 
+    /**
+     * Get the immutable node capturing the current value of this leaf, rebuilt only if it changed since the last call
+     * \return Return the snapshot node
+     */
+    std::shared_ptr<const Snapshot::Leaf> getSnapshot() const;
+
     /**
      * Return a string describing the leaf
      * \param indent Indent for this leaf
@@ -145,6 +152,7 @@ class Leaf
     std::string _name{"leaf"};
     Value _value{};
     Branch* _parentBranch{nullptr};
+    mutable std::shared_ptr<const Snapshot::Leaf> _snapshot{nullptr}; //!< Node this leaf was last captured as, reset when its value changes
 };
 
 } // namespace Tree
@@ -1,6 +1,7 @@
 #include "./core/tree/tree_root.h"
 
 #include <stdexcept>
+#include <string_view>
 
 #include "./utils/log.h"
 
@@ -149,6 +150,7 @@ void Root::clearSeedList()
 void Root::cutdown()
 {
     _rootBranch = make_unique<Tree::Branch>("");
+    _leafCache.clear();
     _seedQueue.clear();
     _updates.clear();
     _branchCallbacksToRegister.clear();
@@ -243,6 +245,8 @@ bool Root::createLeafAt(const std::string& path, Values value, bool silent)
         return false;
     }
 
+    recordChange(path, value);
+
     if (!silent)
     {
         lock_guard<recursive_mutex> lock(_updatesMutex);
@@ -269,6 +273,7 @@ unique_ptr<Branch> Root::cutBranchAt(const string& path, bool silent)
     parts.pop_back();
 
     lock_guard<recursive_mutex> lockTree(_treeMutex);
+    _leafCache.clear();
     auto holdingBranch = getBranchAt(parts);
     if (!holdingBranch)
         return nullptr;
@@ -279,7 +284,10 @@ unique_ptr<Branch> Root::cutBranchAt(const string& path, bool silent)
         _updates.emplace_back(make_tuple(Task::RemoveBranch, Values({path}), chrono::system_clock::now(), _uuid));
     }
 
-    return holdingBranch->cutBranch(branchName);
+    auto branch = holdingBranch->cutBranch(branchName);
+    if (branch)
+        recordChange(path, Value());
+    return branch;
 }
 
 /*************/
@@ -298,6 +306,7 @@ unique_ptr<Leaf> Root::cutLeafAt(const string& path, bool silent)
     parts.pop_back();
 
     lock_guard<recursive_mutex> lockTree(_treeMutex);
+    _leafCache.clear();
     auto holdingBranch = getBranchAt(parts);
     if (!holdingBranch)
         return nullptr;
@@ -308,7 +317,10 @@ unique_ptr<Leaf> Root::cutLeafAt(const string& path, bool silent)
         _updates.emplace_back(make_tuple(Task::RemoveLeaf, Values({path}), chrono::system_clock::now(), _uuid));
     }
 
-    return holdingBranch->cutLeaf(leafName);
+    auto leaf = holdingBranch->cutLeaf(leafName);
+    if (leaf)
+        recordChange(path, Value());
+    return leaf;
 }
 
 /*************/
@@ -372,24 +384,8 @@ list<string> Root::getLeafListAt(const string& path) const
 /*************/
 bool Root::getValueForLeafAt(const string& path, Value& value) const
 {
-    auto parts = processPath(path);
-    if (parts.empty())
-    {
-#ifdef DEBUG
-        Log::get() << Log::DEBUGGING << "Tree::Root::" << __FUNCTION__ << " - Given path is not valid: " << path << Log::endl;
-#endif
-        return false;
-    }
-
-    auto leafName = parts.back();
-    parts.pop_back();
-
     lock_guard<recursive_mutex> lockTree(_treeMutex);
-    auto holdingBranch = getBranchAt(parts);
-    if (!holdingBranch)
-        return false;
-
-    auto leaf = holdingBranch->getLeaf(leafName);
+    auto leaf = getLeafAt(path);
     if (!leaf)
         return false;
 
@@ -397,6 +393,16 @@ bool Root::getValueForLeafAt(const string& path, Value& value) const
     return true;
 }
 
+/*************/
+shared_ptr<const Snapshot> Root::getSnapshot() const
+{
+    lock_guard<recursive_mutex> lockTree(_treeMutex);
+    auto rootBranch = _rootBranch->getSnapshot();
+    if (!_snapshot || &_snapshot->getRootBranch() != rootBranch.get())
+        _snapshot = make_shared<const Snapshot>(rootBranch, ++_snapshotVersion);
+    return _snapshot;
+}
+
 /*************/
 bool Root::hasBranchAt(const string& path) const
 {
@@ -421,27 +427,7 @@ bool Root::hasBranchAt(const string& path) const
 /*************/
 bool Root::hasLeafAt(const string& path) const
 {
-    auto parts = processPath(path);
-    if (parts.empty())
-    {
-#ifdef DEBUG
-        Log::get() << Log::DEBUGGING << "Tree::Root::" << __FUNCTION__ << " - Given path is not valid: " << path << Log::endl;
-#endif
-        return false;
-    }
-
-    auto leafName = parts.back();
-    parts.pop_back();
-
-    lock_guard<recursive_mutex> lockTree(_treeMutex);
-    auto holdingBranch = getBranchAt(parts);
-    if (!holdingBranch)
-        return false;
-
-    if (holdingBranch->hasLeaf(leafName))
-        return true;
-    else
-        return false;
+    return getLeafAt(path) != nullptr;
 }
 
 /*************/
@@ -460,7 +446,7 @@ bool Root::setValueForLeafAt(const string& path, const Value& value, int64_t tim
 bool Root::setValueForLeafAt(const string& path, const Value& value, chrono::system_clock::time_point timestamp, bool silent)
 {
     lock_guard<recursive_mutex> lockTree(_treeMutex);
-    auto leaf = getLeafAt(processPath(path));
+    auto leaf = getLeafAt(path);
     if (!leaf)
         return false;
 
@@ -470,6 +456,8 @@ bool Root::setValueForLeafAt(const string& path, const Value& value, chrono::sys
     if (!leaf->set(value, timestamp))
         return false;
 
+    recordChange(path, value);
+
     if (!silent)
     {
         lock_guard<recursive_mutex> lock(_updatesMutex);
@@ -489,6 +477,33 @@ list<Seed> Root::getUpdateSeedList()
     return updates;
 }
 
+/*************/
+void Root::coalesceSeeds(list<Seed>& seeds, pmr::memory_resource* resource)
+{
+    // Keys point to the paths held by the seeds, which stay in place in the list
+    pmr::unordered_map<string_view, list<Seed>::iterator> lastSetLeaf(resource);
+    for (auto seedIt = seeds.begin(); seedIt != seeds.end(); ++seedIt)
+    {
+        auto& args = std::get<1>(*seedIt);
+        if (std::get<0>(*seedIt) != Task::SetLeaf || args.size() < 2 || args[0].getType() != Value::Type::string)
+        {
+            lastSetLeaf.clear();
+            continue;
+        }
+
+        auto path = string_view(static_cast<const char*>(args[0].data()));
+        auto [previousIt, inserted] = lastSetLeaf.try_emplace(path, seedIt);
+        if (!inserted)
+        {
+            // The key refers to the path of the seed being erased, so the entry is replaced
+            auto previousSeedIt = previousIt->second;
+            lastSetLeaf.erase(previousIt);
+            seeds.erase(previousSeedIt);
+            lastSetLeaf.emplace(path, seedIt);
+        }
+    }
+}
+
 /*************/
 string Root::print() const
 {
@@ -498,6 +513,42 @@ string Root::print() const
     return _rootBranch->print(0);
 }
 
+/*************/
+void Root::notifySubscribers()
+{
+    if (!_hasSubscriptions)
+        return;
+
+    lock_guard<recursive_mutex> lockNotification(_notificationMutex);
+
+    vector<pair<SubscriptionID, ChangeSet>> notifications;
+    unique_lock<mutex> lockSubscriptions(_subscriptionsMutex);
+    for (auto& [id, subscription] : _subscriptions)
+    {
+        if (subscription.changes.empty())
+            continue;
+        notifications.emplace_back(id, ChangeSet());
+        swap(notifications.back().second, subscription.changes);
+    }
+    lockSubscriptions.unlock();
+
+    for (const auto& [id, changes] : notifications)
+    {
+        // A previous callback may have removed this subscription
+        lockSubscriptions.lock();
+        auto subscriptionIt = _subscriptions.find(id);
+        if (subscriptionIt == _subscriptions.end())
+        {
+            lockSubscriptions.unlock();
+            continue;
+        }
+        auto callback = subscriptionIt->second.callback;
+        lockSubscriptions.unlock();
+
+        callback(changes);
+    }
+}
+
 /*************/
 bool Root::processQueue(bool propagate)
 {
@@ -663,6 +714,30 @@ bool Root::processQueue(bool propagate)
     return true;
 }
 
+/*************/
+Root::SubscriptionID Root::subscribe(const string& path, const SubscriptionCallback& callback)
+{
+    auto subscribedPath = path;
+    while (subscribedPath.size() > 1 && subscribedPath.back() == '/')
+        subscribedPath.pop_back();
+
+    lock_guard<mutex> lockSubscriptions(_subscriptionsMutex);
+    auto id = _nextSubscriptionID++;
+    _subscriptions[id] = {subscribedPath, callback, {}};
+    _hasSubscriptions = true;
+    return id;
+}
+
+/*************/
+bool Root::unsubscribe(SubscriptionID id)
+{
+    lock_guard<recursive_mutex> lockNotification(_notificationMutex);
+    lock_guard<mutex> lockSubscriptions(_subscriptionsMutex);
+    auto erased = _subscriptions.erase(id) != 0;
+    _hasSubscriptions = !_subscriptions.empty();
+    return erased;
+}
+
 /*************/
 bool Root::removeBranchAt(const string& path, bool silent)
 {
@@ -679,6 +754,7 @@ bool Root::removeBranchAt(const string& path, bool silent)
     parts.pop_back();
 
     lock_guard<recursive_mutex> lockTree(_treeMutex);
+    _leafCache.clear();
     auto holdingBranch = getBranchAt(parts);
     if (!holdingBranch)
     {
@@ -704,6 +780,7 @@ bool Root::removeBranchAt(const string& path, bool silent)
         _updates.emplace_back(move(seed));
     }
 
+    recordChange(path, Value());
     return true;
 }
 
@@ -723,6 +800,7 @@ bool Root::removeLeafAt(const string& path, bool silent)
     parts.pop_back();
 
     lock_guard<recursive_mutex> lockTree(_treeMutex);
+    _leafCache.clear();
     auto holdingBranch = getBranchAt(parts);
     if (!holdingBranch)
     {
@@ -747,6 +825,7 @@ bool Root::removeLeafAt(const string& path, bool silent)
         _updates.emplace_back(move(seed));
     }
 
+    recordChange(path, Value());
     return true;
 }
 
@@ -766,6 +845,7 @@ bool Root::renameBranchAt(const string& path, const string& name, bool silent)
     parts.pop_back();
 
     lock_guard<recursive_mutex> lockTree(_treeMutex);
+    _leafCache.clear();
     auto holdingBranch = getBranchAt(parts);
     if (!holdingBranch)
     {
@@ -809,6 +889,7 @@ bool Root::renameLeafAt(const string& path, const string& name, bool silent)
     parts.pop_back();
 
     lock_guard<recursive_mutex> lockTree(_treeMutex);
+    _leafCache.clear();
     auto holdingBranch = getBranchAt(parts);
     if (!holdingBranch)
     {
@@ -917,6 +998,10 @@ Branch* Root::getBranchAt(const string& path) const
 /*************/
 Leaf* Root::getLeafAt(const string& path) const
 {
+    lock_guard<recursive_mutex> lockTree(_treeMutex);
+    if (auto leafIt = _leafCache.find(path); leafIt != _leafCache.end())
+        return leafIt->second;
+
     auto parts = processPath(path);
     if (parts.empty())
     {
@@ -926,8 +1011,10 @@ Leaf* Root::getLeafAt(const string& path) const
         return nullptr;
     }
 
-    lock_guard<recursive_mutex> lockTree(_treeMutex);
-    return getLeafAt(parts);
+    auto leaf = getLeafAt(parts);
+    if (leaf)
+        _leafCache.emplace(path, leaf);
+    return leaf;
 }
 
 /*************/
@@ -997,6 +1084,25 @@ vector<string> Root::processPath(const string& path)
     return parts;
 }
 
+/*************/
+void Root::recordChange(const string& path, const Value& value)
+{
+    if (!_hasSubscriptions)
+        return;
+
+    auto isUnder = [](const string& path, const string& parentPath) {
+        return parentPath == "/" || path == parentPath || (path.size() > parentPath.size() && path.compare(0, parentPath.size(), parentPath) == 0 && path[parentPath.size()] == '/');
+    };
+
+    // Removing a branch also removes the leaves subscribed to under it
+    const bool isRemoval = value.getType() == Value::Type::empty;
+
+    lock_guard<mutex> lockSubscriptions(_subscriptionsMutex);
+    for (auto& [id, subscription] : _subscriptions)
+        if (isUnder(path, subscription.path) || (isRemoval && isUnder(subscription.path, path)))
+            subscription.changes[path] = value;
+}
+
 /*************/
 void Root::registerPendingCallbacks()
 {
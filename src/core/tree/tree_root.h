@@ -25,10 +25,13 @@
 #ifndef SPLASH_TREE_ROOT_H
 #define SPLASH_TREE_ROOT_H
 
+#include <atomic>
 #include <chrono>
 #include <functional>
 #include <list>
+#include <map>
 #include <memory>
+#include <memory_resource>
 #include <mutex>
 #include <string>
 #include <tuple>
@@ -39,6 +42,7 @@
 
 #include "./core/tree/tree_branch.h"
 #include "./core/tree/tree_leaf.h"
+#include "./core/tree/tree_snapshot.h"
 #include "./core/value.h"
 #include "./utils/uuid.h"
 
@@ -97,6 +101,12 @@ class RootHandle
 class Root
 {
     friend RootHandle;
+    friend Snapshot;
+
+  public:
+    using ChangeSet = std::map<std::string, Value>; //!< Last value of each leaf which changed, by path
+    using SubscriptionCallback = std::function<void(const ChangeSet&)>;
+    using SubscriptionID = int;
 
   public:
     /**
@@ -268,6 +278,14 @@ class Root
      */
     std::string getName() const { return _name; }
 
+    /**
+     * Get an immutable snapshot of the tree, to be read without locking it
+     * The tree is only locked while capturing the branches and leaves which changed since the previous
+     * snapshot, the other ones being shared. If nothing changed, the previous snapshot is returned.
+     * \return Return the snapshot
+     */
+    std::shared_ptr<const Snapshot> getSnapshot() const;
+
     /**
      * Get the value held by the given leaf
      * \param path Path to the leaf
@@ -303,6 +321,22 @@ class Root
      */
     std::list<Seed> getUpdateSeedList();
 
+    /**
+     * Remove the seeds which are overridden by a later one, to reduce the number of seeds to propagate
+     * Only SetLeaf seeds are coalesced, keeping the last one for every leaf. Any other task
+     * acts as a barrier, as it may change the leaf a path points to.
+     * \param seeds Seeds, sorted chronologically
+     * \param resource Memory resource for the temporaries
+     */
+    static void coalesceSeeds(std::list<Seed>& seeds, std::pmr::memory_resource* resource = std::pmr::get_default_resource());
+
+    /**
+     * Deliver the changes recorded since the last call to the subscribers
+     * Callbacks are called from the calling thread, without the tree being locked. They
+     * should be short, and must not lock the tree as unsubscribing waits for them to return.
+     */
+    void notifySubscribers();
+
     /**
      * Process the seeds queue to update the tree. Also register pending leaf callbacks
      * \param propagate If true, the seeds are duplicated inside the updates seed list for propagation to other trees
@@ -372,6 +406,24 @@ class Root
      */
     std::string print() const;
 
+    /**
+     * Subscribe to the changes of a leaf, or of all the leaves under a branch
+     * Changes are coalesced, only the last value of each leaf is kept until it is delivered
+     * by notifySubscribers(). This includes the leaves created after the subscription. Removed
+     * leaves and branches are reported at their path, with an empty value.
+     * \param path Path to a leaf or to a branch, which do not need to exist yet
+     * \param callback Callback, called with the leaves which changed since the last notification
+     * \return Return the ID of the subscription
+     */
+    SubscriptionID subscribe(const std::string& path, const SubscriptionCallback& callback);
+
+    /**
+     * Remove a subscription. Once this returns, the callback is not called anymore
+     * \param id Subscription ID
+     * \return Return true if the subscription existed
+     */
+    bool unsubscribe(SubscriptionID id);
+
   protected:
     mutable std::recursive_mutex _treeMutex{};
 
@@ -390,6 +442,25 @@ class Root
     bool _hasError{false};
     std::string _errorMsg{};
 
+    struct Subscription
+    {
+        std::string path{};
+        SubscriptionCallback callback{};
+        ChangeSet changes{};
+    };
+
+    std::mutex _subscriptionsMutex{};
+    std::recursive_mutex _notificationMutex{}; //!< Held while delivering changes, so that unsubscribing waits for the callback to return
+    std::map<SubscriptionID, Subscription> _subscriptions{};
+    SubscriptionID _nextSubscriptionID{1};
+    std::atomic_bool _hasSubscriptions{false}; //!< Allows for skipping the change recording when there is no subscriber
+
+    mutable std::shared_ptr<const Snapshot> _snapshot{nullptr}; //!< Last snapshot taken, returned as long as the tree does not change
+    mutable uint64_t _snapshotVersion{0};
+
+    //!< Leaves already resolved from their path, cleared whenever a leaf may have been moved or destroyed
+    mutable std::unordered_map<std::string, Leaf*> _leafCache{};
+
     /**
      * Generate a seed list to recreate the given branch
      * \param branch Branch to recreate
@@ -420,6 +491,7 @@ class Root
 
     /**
      * Get a pointer to the leaf at the given path
+     * Leaves are cached by path, so that repeated accesses do not need to walk the tree
      * \param path Path to the leaf
      * \return Return the leaf, or nullptr
      */
@@ -443,6 +515,13 @@ class Root
      * Register the pending callbacks
      */
     void registerPendingCallbacks();
+
+    /**
+     * Record the change of a leaf for the matching subscriptions
+     * \param path Leaf path
+     * \param value New leaf value
+     */
+    void recordChange(const std::string& path, const Value& value);
 };
 
 } // namespace Tree
@@ -0,0 +1,101 @@
+#include "./core/tree/tree_snapshot.h"
+
+#include "./core/tree/tree_root.h"
+
+using namespace std;
+
+namespace Splash
+{
+
+namespace Tree
+{
+
+/*************/
+Snapshot::Snapshot(shared_ptr<const Branch> root, uint64_t version)
+    : _rootBranch(root ? root : make_shared<const Branch>())
+    , _version(version)
+{
+}
+
+/*************/
+const Snapshot::Branch* Snapshot::getBranchAt(const string& path) const
+{
+    return getBranchAt(Root::processPath(path));
+}
+
+/*************/
+const Snapshot::Branch* Snapshot::getBranchAt(const vector<string>& path) const
+{
+    auto branch = _rootBranch.get();
+    for (const auto& part : path)
+    {
+        auto branchIt = branch->branches.find(part);
+        if (branchIt == branch->branches.end())
+            return nullptr;
+        branch = branchIt->second.get();
+    }
+
+    return branch;
+}
+
+/*************/
+list<string> Snapshot::getBranchListAt(const string& path) const
+{
+    auto branch = getBranchAt(path);
+    if (!branch)
+        return {};
+
+    list<string> branchList;
+    for (const auto& child : branch->branches)
+        branchList.push_back(child.first);
+    return branchList;
+}
+
+/*************/
+list<string> Snapshot::getLeafListAt(const string& path) const
+{
+    auto branch = getBranchAt(path);
+    if (!branch)
+        return {};
+
+    list<string> leafList;
+    for (const auto& leaf : branch->leaves)
+        leafList.push_back(leaf.first);
+    return leafList;
+}
+
+/*************/
+const Snapshot::Leaf* Snapshot::getLeafAt(const string& path) const
+{
+    auto parts = Root::processPath(path);
+    if (parts.empty())
+        return nullptr;
+
+    auto leafName = parts.back();
+    parts.pop_back();
+
+    auto branch = getBranchAt(parts);
+    if (!branch)
+        return nullptr;
+
+    auto leafIt = branch->leaves.find(leafName);
+    if (leafIt == branch->leaves.end())
+        return nullptr;
+
+    return leafIt->second.get();
+}
+
+/*************/
+bool Snapshot::getValueForLeafAt(const string& path, Value& value) const
+{
+    auto leaf = getLeafAt(path);
+    if (!leaf)
+        return false;
+
+    value = leaf->value;
+    return true;
+}
+
+} // namespace Tree
+
+} // namespace Splash
@@ -0,0 +1,155 @@
+/*
+ * Copyright (C) 2026 Emmanuel Durand
+ *
+ * This file is part of Splash.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Splash is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Splash.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * @tree_snapshot.h
+ * The Snapshot class, an immutable view of a tree Root
+ */
+
+#ifndef SPLASH_TREE_SNAPSHOT_H
+#define SPLASH_TREE_SNAPSHOT_H
+
+#include <chrono>
+#include <list>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "./core/constants.h"
+
+#include "./core/value.h"
+#include "./utils/dense_map.h"
+
+namespace Splash
+{
+
+namespace Tree
+{
+
+/*************/
+/**
+ * Tree::Snapshot class, holding the state of a tree at a given version
+ * Snapshots are immutable, and can be read from any thread without locking the tree. Each branch
+ * and leaf of the tree keeps the node it was last captured as, so that a new snapshot only rebuilds
+ * the nodes which changed and shares all the others with the previous snapshots.
+ * The read interface mirrors the one of Tree::Root.
+ */
+class Snapshot
+{
+  public:
+    struct Leaf
+    {
+        Value value{};
+        std::chrono::system_clock::time_point timestamp{};
+    };
+
+    struct Branch
+    {
+        DenseMap<std::string, std::shared_ptr<const Branch>> branches{};
+        DenseMap<std::string, std::shared_ptr<const Leaf>> leaves{};
+    };
+
+  public:
+    /**
+     * Constructor
+     * \param root Root branch
+     * \param version Version of the tree
+     */
+    Snapshot(std::shared_ptr<const Branch> root, uint64_t version);
+
+    /**
+     * Get the version of the tree this snapshot was taken at, which increases with each snapshot taken after a change
+     * \return Return the version
+     */
+    uint64_t getVersion() const { return _version; }
+
+    /**
+     * Get the root branch
+     * \return Return the root branch
+     */
+    const Branch& getRootBranch() const { return *_rootBranch; }
+
+    /**
+     * Get the given branch
+     * \param path Path to the branch
+     * \return Return a pointer to the branch, or nullptr
+     */
+    const Branch* getBranchAt(const std::string& path) const;
+
+    /**
+     * Get the list of branches connected to the root, or to the given branch
+     * \param path Branch path
+     * \return Return the list of branches
+     */
+    std::list<std::string> getBranchList() const { return getBranchListAt("/"); }
+    std::list<std::string> getBranchListAt(const std::string& path) const;
+
+    /**
+     * Get the list of leaves connected to the root, or to the given branch
+     * \param path Branch path
+     * \return Return the list of leaves
+     */
+    std::list<std::string> getLeafList() const { return getLeafListAt("/"); }
+    std::list<std::string> getLeafListAt(const std::string& path) const;
+
+    /**
+     * Get the value held by the given leaf
+     * \param path Path to the leaf
+     * \param value The value of the leaf, or an empty value
+     * \return Return true if the leaf was found
+     */
+    bool getValueForLeafAt(const std::string& path, Value& value) const;
+
+    /**
+     * Return whether the given branch exists
+     * \param path Path to the branch
+     * \return Return true if the branch exists
+     */
+    bool hasBranchAt(const std::string& path) const { return getBranchAt(path) != nullptr; }
+
+    /**
+     * Return whether the given leaf exists
+     * \param path Path to the leaf
+     * \return Return true if the leaf exists
+     */
+    bool hasLeafAt(const std::string& path) const { return getLeafAt(path) != nullptr; }
+
+  private:
+    std::shared_ptr<const Branch> _rootBranch{nullptr};
+    uint64_t _version{0};
+
+    /**
+     * Get the branch at the given path
+     * \param path Path as a list of strings
+     * \return Return the branch, or nullptr
+     */
+    const Branch* getBranchAt(const std::vector<std::string>& path) const;
+
+    /**
+     * Get the leaf at the given path
+     * \param path Path to the leaf
+     * \return Return the leaf, or nullptr
+     */
+    const Leaf* getLeafAt(const std::string& path) const;
+};
+
+} // namespace Tree
+} // namespace Splash
+
+#endif // SPLASH_TREE_SNAPSHOT_H
@@ -0,0 +1,231 @@
+/*
+ * Copyright (C) 2026 Emmanuel Durand
+ *
+ * This file is part of Splash.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Splash is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Splash.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * @upload_ring.h
+ * Ring of upload buffers owned by a texture, written directly by an image
+ */
+
+#ifndef SPLASH_UPLOAD_RING_H
+#define SPLASH_UPLOAD_RING_H
+
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+#include "./core/imagebuffer.h"
+
+namespace Splash
+{
+
+/*************/
+//! Ring of buffers of a fixed spec, through which frames go from an image thread to the texture uploading them
+//! The texture owns the buffer memory and hands slots back once the GPU is done reading them. The writer
+//! always gets a slot, replacing the last frame if it has not been consumed yet, so that only the latest
+//! frame is uploaded. Closing the ring waits for the pending writes, after which the memory can be released.
+class UploadRing
+{
+  public:
+    /**
+     * Constructor
+     * \param spec Spec of the frames going through the ring
+     * \param slots Memory of each slot, owned by the caller
+     * \param slotSize Size of each slot, in bytes
+     */
+    UploadRing(const ImageBufferSpec& spec, const std::vector<uint8_t*>& slots, size_t slotSize)
+        : _spec(spec)
+        , _slots(slots)
+        , _slotSize(slotSize)
+        , _states(slots.size(), State::Free)
+        , _timestamps(slots.size(), -1)
+    {
+    }
+
+    UploadRing(const UploadRing&) = delete;
+    UploadRing& operator=(const UploadRing&) = delete;
+
+    /**
+     * Get the spec of the frames going through the ring
+     * \return Return the spec
+     */
+    const ImageBufferSpec& getSpec() const { return _spec; }
+
+    /**
+     * Get the size of each slot
+     * \return Return the size in bytes
+     */
+    size_t getSlotSize() const { return _slotSize; }
+
+    /**
+     * Get a slot to write the next frame to
+     * \return Return the slot index, or -1 if the ring is closed or all slots are being uploaded
+     */
+    int acquire()
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (_closed)
+            return -1;
+
+        for (size_t index = 0; index < _states.size(); ++index)
+        {
+            if (_states[index] == State::Free)
+            {
+                _states[index] = State::Writing;
+                return static_cast<int>(index);
+            }
+        }
+
+        // The frame not consumed yet is dropped in favor of the new one
+        if (_readyIndex >= 0)
+        {
+            auto index = _readyIndex;
+            _states[index] = State::Writing;
+            _readyIndex = -1;
+            return index;
+        }
+
+        return -1;
+    }
+
+    /**
+     * Get the memory of the given slot
+     * \param index Slot index
+     * \return Return a pointer to the slot memory
+     */
+    uint8_t* getPixels(int index) const { return _slots[index]; }
+
+    /**
+     * Mark the given slot as holding the latest frame
+     * \param index Slot index, as returned by acquire()
+     * \param timestamp Frame timestamp, in us
+     */
+    void commit(int index, int64_t timestamp)
+    {
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            if (_readyIndex >= 0)
+                _states[_readyIndex] = State::Free;
+            _states[index] = State::Ready;
+            _timestamps[index] = timestamp;
+            _readyIndex = index;
+        }
+        _condition.notify_all();
+    }
+
+    /**
+     * Get whether a frame has been committed and not consumed yet
+     * \return Return true if consume() would return a frame
+     */
+    bool hasReadyFrame() const
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return !_closed && _readyIndex >= 0;
+    }
+
+    /**
+     * Give back a slot without writing a frame to it
+     * \param index Slot index, as returned by acquire()
+     */
+    void cancel(int index)
+    {
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _states[index] = State::Free;
+        }
+        _condition.notify_all();
+    }
+
+    /**
+     * Get the latest frame, if a new one has been committed
+     * \param timestamp Set to the frame timestamp
+     * \return Return the slot index, or -1 if there is no new frame
+     */
+    int consume(int64_t& timestamp)
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (_closed || _readyIndex < 0)
+            return -1;
+
+        auto index = _readyIndex;
+        _states[index] = State::Uploading;
+        _readyIndex = -1;
+        timestamp = _timestamps[index];
+        return index;
+    }
+
+    /**
+     * Hand back a consumed slot, once it is not read anymore
+     * \param index Slot index, as returned by consume()
+     */
+    void release(int index)
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _states[index] = State::Free;
+    }
+
+    /**
+     * Close the ring, waiting for the pending writes
+     */
+    void close()
+    {
+        std::unique_lock<std::mutex> lock(_mutex);
+        _closed = true;
+        _condition.wait(lock, [&]() {
+            for (const auto& state : _states)
+                if (state == State::Writing)
+                    return false;
+            return true;
+        });
+    }
+
+    /**
+     * Get whether the ring has been closed
+     * \return Return true if closed
+     */
+    bool isClosed() const
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return _closed;
+    }
+
+  private:
+    enum class State
+    {
+        Free,
+        Writing,
+        Ready,
+        Uploading
+    };
+
+    const ImageBufferSpec _spec;
+    const std::vector<uint8_t*> _slots;
+    const size_t _slotSize;
+
+    mutable std::mutex _mutex{};
+    std::condition_variable _condition{};
+    std::vector<State> _states;
+    std::vector<int64_t> _timestamps;
+    int _readyIndex{-1};
+    bool _closed{false};
+};
+
+} // namespace Splash
+
+#endif // SPLASH_UPLOAD_RING_H
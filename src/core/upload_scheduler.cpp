@@ -0,0 +1,81 @@
+#include "./core/upload_scheduler.h"
+
+#include <algorithm>
+#include <limits>
+#include <numeric>
+
+using namespace std;
+
+namespace Splash
+{
+
+/*************/
+vector<size_t> UploadScheduler::schedule(const vector<Request>& requests)
+{
+    vector<size_t> budgets(requests.size(), 0);
+
+    // Uploads which are not pending anymore, or which disappeared, do not age
+    map<string, int> deferredFrames;
+    for (const auto& request : requests)
+        if (auto frameIt = _deferredFrames.find(request.name); request.size > 0 && frameIt != _deferredFrames.end())
+            deferredFrames[request.name] = frameIt->second;
+    std::swap(deferredFrames, _deferredFrames);
+
+    if (_budget == 0)
+    {
+        std::fill(budgets.begin(), budgets.end(), numeric_limits<size_t>::max());
+        _deferredFrames.clear();
+        return budgets;
+    }
+
+    const auto getRank = [&](const Request& request) { return static_cast<int>(request.priority) - getDeferredFrames(request.name) / SPLASH_UPLOAD_SCHEDULER_AGING_FRAMES; };
+
+    vector<size_t> order(requests.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&](size_t lhs, size_t rhs) {
+        const auto lhsRank = getRank(requests[lhs]);
+        const auto rhsRank = getRank(requests[rhs]);
+        if (lhsRank != rhsRank)
+            return lhsRank < rhsRank;
+        return getDeferredFrames(requests[lhs].name) > getDeferredFrames(requests[rhs].name);
+    });
+
+    auto remaining = _budget;
+    bool uploaded = false;
+    for (auto index : order)
+    {
+        const auto& request = requests[index];
+        if (request.size == 0)
+            continue;
+
+        if (request.size <= remaining || (!uploaded && !request.splittable))
+        {
+            budgets[index] = request.size;
+            remaining -= std::min(request.size, remaining);
+        }
+        else if (request.splittable && remaining > 0)
+        {
+            budgets[index] = remaining;
+            remaining = 0;
+        }
+        else
+        {
+            ++_deferredFrames[request.name];
+            continue;
+        }
+
+        uploaded = true;
+        _deferredFrames.erase(request.name);
+    }
+
+    return budgets;
+}
+
+/*************/
+int UploadScheduler::getDeferredFrames(const string& name) const
+{
+    auto frameIt = _deferredFrames.find(name);
+    return frameIt == _deferredFrames.end() ? 0 : frameIt->second;
+}
+
+} // namespace Splash
@@ -0,0 +1,99 @@
+/*
+ * Copyright (C) 2026 Emmanuel Durand
+ *
+ * This file is part of Splash.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Splash is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Splash.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * @upload_scheduler.h
+ * The UploadScheduler class, deciding which textures are uploaded in each frame
+ */
+
+#ifndef SPLASH_UPLOAD_SCHEDULER_H
+#define SPLASH_UPLOAD_SCHEDULER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+// Number of frames an upload has to be deferred for to be promoted to the next priority
+#define SPLASH_UPLOAD_SCHEDULER_AGING_FRAMES 4
+
+namespace Splash
+{
+
+/*************/
+//! Scheduler spreading the texture uploads over the frames, so that no frame uploads more than a given number of bytes
+//! Uploads are taken by priority, visible before hidden and live before still, and those left out are deferred to the
+//! next frames. Deferred uploads rise in priority with time so that they are never starved, and the first upload of
+//! a frame always happens even if it exceeds the budget. Splittable uploads get whatever budget is left, to be
+//! continued in the next frames.
+class UploadScheduler
+{
+  public:
+    enum class Priority : uint8_t
+    {
+        VisibleLive = 0,
+        VisibleStill,
+        HiddenLive,
+        HiddenStill
+    };
+
+    struct Request
+    {
+        std::string name{};
+        size_t size{0}; //!< Bytes waiting to be uploaded, 0 if none
+        Priority priority{Priority::VisibleLive};
+        bool splittable{false}; //!< If true, the upload can be done in parts over several frames
+    };
+
+  public:
+    /**
+     * Set the number of bytes uploaded per frame
+     * \param budget Budget in bytes, 0 for no limit
+     */
+    void setBudget(size_t budget) { _budget = budget; }
+
+    /**
+     * Get the number of bytes uploaded per frame
+     * \return Return the budget in bytes, 0 if there is no limit
+     */
+    size_t getBudget() const { return _budget; }
+
+    /**
+     * Decide which uploads happen in this frame
+     * \param requests Pending uploads, one per texture
+     * \return Return the number of bytes each request may upload in this frame, in the same order, 0 meaning that it is deferred
+     */
+    std::vector<size_t> schedule(const std::vector<Request>& requests);
+
+    /**
+     * Get the number of frames an upload has been deferred for
+     * \param name Request name
+     * \return Return the number of frames
+     */
+    int getDeferredFrames(const std::string& name) const;
+
+  private:
+    size_t _budget{0};
+    std::map<std::string, int> _deferredFrames{}; //!< Number of frames each deferred upload has been waiting for
+};
+
+} // namespace Splash
+
+#endif // SPLASH_UPLOAD_SCHEDULER_H
@@ -46,6 +46,7 @@ struct Value
 {
   public:
     using Buffer = ResizableArray<uint8_t>;
+    using Reals = ResizableArray<float>; //!< Contiguous reals, for large numeric attributes sent in bulk
 
   public:
     enum Type : uint8_t
@@ -56,7 +57,8 @@ struct Value
         real,      // float
         string,    // string
         values,    // values
-        buffer     // buffer
+        buffer,    // buffer
+        reals      // contiguous floats
     };
 
     Value() = default;
@@ -95,6 +97,11 @@ struct Value
             _type = Type::buffer;
             _data = v;
         }
+        else if constexpr (std::is_same_v<T, Reals>)
+        {
+            _type = Type::reals;
+            _data = v;
+        }
         else
         {
             assert(false);
@@ -153,10 +160,21 @@ struct Value
                     return false;
             return true;
         }
+        case Type::reals:
+        {
+            auto& data = std::get<Reals>(_data);
+            auto& other = std::get<Reals>(v._data);
+            if (data.size() != other.size())
+                return false;
+            for (uint32_t i = 0; i < data.size(); ++i)
+                if (data[i] != other[i])
+                    return false;
+            return true;
+        }
         }
     }
 
-    bool operator==(const Values v) const
+    bool operator==(const Values& v) const
     {
         if (_type != Type::values)
             return false;
@@ -231,6 +249,12 @@ struct Value
                 _type = Type::buffer;
                 return std::get<Buffer>(_data);
             }
+            else if constexpr (std::is_same_v<T, Reals>)
+            {
+                _data = Reals();
+                _type = Type::reals;
+                return std::get<Reals>(_data);
+            }
             else
             {
                 assert(false);
@@ -249,7 +273,7 @@ struct Value
                 return std::get<bool>(_data);
             else if constexpr (std::is_same_v<T, Values>)
                 return {std::get<bool>(_data)};
-            else if constexpr (std::is_same_v<T, Buffer>)
+            else if constexpr (std::is_same_v<T, Buffer> || std::is_same_v<T, Reals>)
                 return {};
             else
             {
@@ -267,6 +291,12 @@ struct Value
                 return {std::get<int64_t>(_data)};
             else if constexpr (std::is_same_v<T, Buffer>)
                 return {};
+            else if constexpr (std::is_same_v<T, Reals>)
+            {
+                Reals reals(1);
+                reals[0] = static_cast<float>(std::get<int64_t>(_data));
+                return reals;
+            }
             else
             {
                 assert(false);
@@ -283,6 +313,12 @@ struct Value
                 return {std::get<double>(_data)};
             else if constexpr (std::is_same_v<T, Buffer>)
                 return {};
+            else if constexpr (std::is_same_v<T, Reals>)
+            {
+                Reals reals(1);
+                reals[0] = static_cast<float>(std::get<double>(_data));
+                return reals;
+            }
             else
             {
                 assert(false);
@@ -306,7 +342,7 @@ struct Value
             }
             else if constexpr (std::is_same_v<T, Values>)
                 return {std::get<std::string>(_data)};
-            else if constexpr (std::is_same_v<T, Buffer>)
+            else if constexpr (std::is_same_v<T, Buffer> || std::is_same_v<T, Reals>)
                 return {};
             else
             {
@@ -335,6 +371,14 @@ struct Value
                 return std::get<Values>(_data);
             else if constexpr (std::is_same_v<T, Buffer>)
                 return {};
+            else if constexpr (std::is_same_v<T, Reals>)
+            {
+                auto& data = std::get<Values>(_data);
+                Reals reals(data.size());
+                for (uint32_t i = 0; i < data.size(); ++i)
+                    reals[i] = data[i].as<float>();
+                return reals;
+            }
             else
             {
                 assert(false);
@@ -361,6 +405,43 @@ struct Value
                 return {};
             else if constexpr (std::is_same_v<T, Buffer>)
                 return std::get<Buffer>(_data);
+            else if constexpr (std::is_same_v<T, Reals>)
+                return {};
+            else
+            {
+                assert(false);
+                return {};
+            }
+        case Type::reals:
+            if constexpr (std::is_same_v<T, bool>)
+                return false;
+            else if constexpr (std::is_same_v<T, std::string>)
+            {
+                auto& data = std::get<Reals>(_data);
+                std::string out = "[";
+                for (uint32_t i = 0; i < data.size(); ++i)
+                {
+                    out += std::to_string(data[i]);
+                    if (data.size() > 1 && i < data.size() - 1)
+                        out += ", ";
+                }
+                out += "]";
+                return out;
+            }
+            else if constexpr (std::is_arithmetic_v<T>)
+                return 0;
+            else if constexpr (std::is_same_v<T, Values>)
+            {
+                auto& data = std::get<Reals>(_data);
+                Values values;
+                for (uint32_t i = 0; i < data.size(); ++i)
+                    values.push_back(data[i]);
+                return values;
+            }
+            else if constexpr (std::is_same_v<T, Buffer>)
+                return {};
+            else if constexpr (std::is_same_v<T, Reals>)
+                return std::get<Reals>(_data);
             else
             {
                 assert(false);
@@ -390,6 +471,8 @@ struct Value
             return nullptr;
         case Type::buffer:
             return std::get<Buffer>(_data).data();
+        case Type::reals:
+            return std::get<Reals>(_data).data();
         }
     }
 
@@ -414,9 +497,22 @@ struct Value
             return nullptr;
         case Type::buffer:
             return std::get<Buffer>(_data).data();
+        case Type::reals:
+            return std::get<Reals>(_data).data();
         }
     }
 
+    /**
+     * Get a reference to the held data, without converting nor copying it
+     * The Value must hold this exact type, see getType
+     * \return Return a reference to the data
+     */
+    template <class T>
+    const T& asRef() const
+    {
+        return std::get<T>(_data);
+    }
+
     std::string getName() const { return _name; }
     void setName(const std::string& name) { _name = name; }
     bool isNamed() const { return !_name.empty(); }
@@ -443,6 +539,8 @@ struct Value
             return 'v';
         case Type::buffer:
             return 'd';
+        case Type::reals:
+            return 'f';
         }
     }
 
@@ -472,13 +570,15 @@ struct Value
             return Type::values;
         case 'd':
             return Type::buffer;
+        case 'f':
+            return Type::reals;
         }
     }
 
     /**
      * Check whether the current value is convertible to the given type
      * If the Value given as parameter is of type Integer, it 
-     * can be converted to a Real. All other conversions are forbidden
+     * can be converted to a Real, and Reals to Values. All other conversions are forbidden
      * \param v Other value to compute type with
      * \return Return true if the conversion is possible
      */
@@ -486,6 +586,8 @@ struct Value
     {
         if (_type == Type::integer && type == Type::real)
             return true;
+        if (_type == Type::reals && type == Type::values)
+            return true;
         if (_type == type)
             return true;
         return false;
@@ -521,6 +623,8 @@ struct Value
         }
         case Type::buffer:
             return std::get<Buffer>(_data).size();
+        case Type::reals:
+            return std::get<Reals>(_data).size() * sizeof(float);
         }
     }
 
@@ -549,13 +653,15 @@ struct Value
             return std::get<Values>(_data).size();
         case Type::buffer:
             return std::get<Buffer>(_data).size();
+        case Type::reals:
+            return std::get<Reals>(_data).size();
         }
     }
 
   private:
     std::string _name{""};
     mutable Type _type{Type::empty};
-    mutable std::variant<bool, int64_t, double, std::string, Values, Buffer> _data{};
+    mutable std::variant<bool, int64_t, double, std::string, Values, Buffer, Reals> _data{};
 }; // namespace Splash
 
 } // namespace Splash
@@ -0,0 +1,407 @@
+#include "./core/value_codec.h"
+
+#include <cstring>
+#include <string>
+
+using namespace std;
+
+namespace Splash
+{
+namespace ValueCodec
+{
+
+namespace
+{
+
+// Tags of an encoded Value, the named flag being set when a name follows the tag
+enum Tag : uint8_t
+{
+    tagEmpty = 0,
+    tagFalse,
+    tagTrue,
+    tagInteger,
+    tagReal,
+    tagString,
+    tagValues,
+    tagBuffer,
+    tagReals,
+    tagNamed = 0x80
+};
+
+// Layouts of an encoded Values
+enum Layout : uint8_t
+{
+    layoutList = 0, // Count, then each encoded Value
+    layoutReals     // Count, then the reals copied in bulk, for unnamed reals only
+};
+
+/*************/
+size_t getVarintSize(uint64_t value)
+{
+    size_t size = 1;
+    while (value >= 0x80)
+    {
+        value >>= 7;
+        ++size;
+    }
+    return size;
+}
+
+/*************/
+uint8_t* writeVarint(uint64_t value, uint8_t* output)
+{
+    while (value >= 0x80)
+    {
+        *output++ = static_cast<uint8_t>(value) | 0x80;
+        value >>= 7;
+    }
+    *output++ = static_cast<uint8_t>(value);
+    return output;
+}
+
+/*************/
+bool readVarint(const uint8_t*& data, const uint8_t* end, uint64_t& value)
+{
+    value = 0;
+    for (uint32_t shift = 0; shift < 64; shift += 7)
+    {
+        if (data == end)
+            return false;
+        auto byte = *data++;
+        value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+        if (!(byte & 0x80))
+            return true;
+    }
+    return false;
+}
+
+/*************/
+uint64_t zigzag(int64_t value)
+{
+    return (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63);
+}
+
+/*************/
+int64_t unzigzag(uint64_t value)
+{
+    return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+}
+
+/*************/
+bool isRealSequence(const Values& values)
+{
+    if (values.empty())
+        return false;
+    for (const auto& value : values)
+        if (value.getType() != Value::Type::real || value.isNamed())
+            return false;
+    return true;
+}
+
+size_t getValuesSize(const Values& values);
+
+/*************/
+size_t getValueSize(const Value& value)
+{
+    size_t size = 1;
+    if (value.isNamed())
+    {
+        auto nameSize = value.getName().size();
+        size += getVarintSize(nameSize) + nameSize;
+    }
+
+    switch (value.getType())
+    {
+    default:
+    case Value::Type::empty:
+    case Value::Type::boolean:
+        return size;
+    case Value::Type::integer:
+        return size + getVarintSize(zigzag(value.asRef<int64_t>()));
+    case Value::Type::real:
+        return size + sizeof(double);
+    case Value::Type::string:
+    case Value::Type::buffer:
+        return size + getVarintSize(value.byte_size()) + value.byte_size();
+    case Value::Type::reals:
+        return size + getVarintSize(value.size()) + value.byte_size();
+    case Value::Type::values:
+        return size + getValuesSize(value.asRef<Values>());
+    }
+}
+
+/*************/
+size_t getValuesSize(const Values& values)
+{
+    size_t size = 1 + getVarintSize(values.size());
+    if (isRealSequence(values))
+        return size + values.size() * sizeof(double);
+
+    for (const auto& value : values)
+        size += getValueSize(value);
+    return size;
+}
+
+uint8_t* encodeValues(const Values& values, uint8_t* output);
+
+/*************/
+uint8_t* encodeValue(const Value& value, uint8_t* output)
+{
+    uint8_t tag = tagEmpty;
+    switch (value.getType())
+    {
+    default:
+    case Value::Type::empty:
+        break;
+    case Value::Type::boolean:
+        tag = value.asRef<bool>() ? tagTrue : tagFalse;
+        break;
+    case Value::Type::integer:
+        tag = tagInteger;
+        break;
+    case Value::Type::real:
+        tag = tagReal;
+        break;
+    case Value::Type::string:
+        tag = tagString;
+        break;
+    case Value::Type::values:
+        tag = tagValues;
+        break;
+    case Value::Type::buffer:
+        tag = tagBuffer;
+        break;
+    case Value::Type::reals:
+        tag = tagReals;
+        break;
+    }
+
+    if (value.isNamed())
+    {
+        const auto name = value.getName();
+        *output++ = tag | tagNamed;
+        output = writeVarint(name.size(), output);
+        memcpy(output, name.data(), name.size());
+        output += name.size();
+    }
+    else
+    {
+        *output++ = tag;
+    }
+
+    switch (tag)
+    {
+    default:
+        return output;
+    case tagInteger:
+        return writeVarint(zigzag(value.asRef<int64_t>()), output);
+    case tagReal:
+        memcpy(output, value.data(), sizeof(double));
+        return output + sizeof(double);
+    case tagString:
+    case tagBuffer:
+    {
+        auto size = value.byte_size();
+        output = writeVarint(size, output);
+        if (size != 0)
+            memcpy(output, value.data(), size);
+        return output + size;
+    }
+    case tagReals:
+    {
+        // Copied in bulk, as they are laid out in memory
+        output = writeVarint(value.size(), output);
+        if (value.size() != 0)
+            memcpy(output, value.data(), value.byte_size());
+        return output + value.byte_size();
+    }
+    case tagValues:
+        return encodeValues(value.asRef<Values>(), output);
+    }
+}
+
+/*************/
+uint8_t* encodeValues(const Values& values, uint8_t* output)
+{
+    if (isRealSequence(values))
+    {
+        *output++ = layoutReals;
+        output = writeVarint(values.size(), output);
+        for (const auto& value : values)
+        {
+            memcpy(output, value.data(), sizeof(double));
+            output += sizeof(double);
+        }
+        return output;
+    }
+
+    *output++ = layoutList;
+    output = writeVarint(values.size(), output);
+    for (const auto& value : values)
+        output = encodeValue(value, output);
+    return output;
+}
+
+bool decodeValues(const uint8_t*& data, const uint8_t* end, Values& values, uint32_t depth);
+
+/*************/
+bool decodeValue(const uint8_t*& data, const uint8_t* end, Value& value, uint32_t depth)
+{
+    if (data == end)
+        return false;
+    auto tag = *data++;
+
+    string name;
+    if (tag & tagNamed)
+    {
+        uint64_t nameSize;
+        if (!readVarint(data, end, nameSize) || nameSize > static_cast<uint64_t>(end - data))
+            return false;
+        name.assign(reinterpret_cast<const char*>(data), nameSize);
+        data += nameSize;
+        tag &= ~tagNamed;
+    }
+
+    switch (tag)
+    {
+    default:
+        return false;
+    case tagEmpty:
+        value = Value();
+        break;
+    case tagFalse:
+    case tagTrue:
+        value = Value(tag == tagTrue);
+        break;
+    case tagInteger:
+    {
+        uint64_t integer;
+        if (!readVarint(data, end, integer))
+            return false;
+        value = Value(unzigzag(integer));
+        break;
+    }
+    case tagReal:
+    {
+        if (static_cast<size_t>(end - data) < sizeof(double))
+            return false;
+        double real;
+        memcpy(&real, data, sizeof(double));
+        data += sizeof(double);
+        value = Value(real);
+        break;
+    }
+    case tagString:
+    case tagBuffer:
+    {
+        uint64_t size;
+        if (!readVarint(data, end, size) || size > static_cast<uint64_t>(end - data))
+            return false;
+        if (tag == tagString)
+        {
+            value = Value(string(reinterpret_cast<const char*>(data), size));
+        }
+        else
+        {
+            Value::Buffer buffer(size);
+            if (size != 0)
+                memcpy(buffer.data(), data, size);
+            value = Value(buffer);
+        }
+        data += size;
+        break;
+    }
+    case tagReals:
+    {
+        uint64_t count;
+        if (!readVarint(data, end, count) || count > static_cast<uint64_t>(end - data) / sizeof(float))
+            return false;
+        Value::Reals reals(count);
+        if (count != 0)
+            memcpy(reals.data(), data, count * sizeof(float));
+        data += count * sizeof(float);
+        value = Value(reals);
+        break;
+    }
+    case tagValues:
+    {
+        Values values;
+        if (!decodeValues(data, end, values, depth + 1))
+            return false;
+        value = Value(values);
+        break;
+    }
+    }
+
+    if (!name.empty())
+        value.setName(name);
+    return true;
+}
+
+/*************/
+bool decodeValues(const uint8_t*& data, const uint8_t* end, Values& values, uint32_t depth)
+{
+    // Nesting is bounded, so that a malformed buffer can not exhaust the stack
+    if (depth > 64 || data == end)
+        return false;
+    auto layout = *data++;
+
+    uint64_t count;
+    if (!readVarint(data, end, count))
+        return false;
+
+    values.clear();
+    if (layout == layoutReals)
+    {
+        if (count > static_cast<uint64_t>(end - data) / sizeof(double))
+            return false;
+        values.reserve(count);
+        for (uint64_t i = 0; i < count; ++i)
+        {
+            double real;
+            memcpy(&real, data, sizeof(double));
+            data += sizeof(double);
+            values.emplace_back(real);
+        }
+        return true;
+    }
+    else if (layout != layoutList)
+    {
+        return false;
+    }
+
+    // Each Value takes at least one byte
+    if (count > static_cast<uint64_t>(end - data))
+        return false;
+    values.reserve(count);
+    for (uint64_t i = 0; i < count; ++i)
+        if (!decodeValue(data, end, values.emplace_back(), depth))
+            return false;
+    return true;
+}
+
+} // namespace
+
+/*************/
+size_t getEncodedSize(const Values& values)
+{
+    return getValuesSize(values);
+}
+
+/*************/
+uint8_t* encode(const Values& values, uint8_t* output)
+{
+    return encodeValues(values, output);
+}
+
+/*************/
+bool decode(const uint8_t* data, size_t size, Values& values)
+{
+    auto end = data + size;
+    if (!decodeValues(data, end, values, 0))
+        return false;
+    return data == end;
+}
+
+} // namespace ValueCodec
+} // namespace Splash
@@ -0,0 +1,66 @@
+/*
+ * Copyright (C) 2026 Emmanuel Durand
+ *
+ * This file is part of Splash.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Splash is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Splash.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * @value_codec.h
+ * Compact, single buffer binary encoding of Values, used for the messages sent by Link
+ */
+
+#ifndef SPLASH_VALUE_CODEC_H
+#define SPLASH_VALUE_CODEC_H
+
+#include <cstddef>
+#include <cstdint>
+
+#include "./core/value.h"
+
+namespace Splash
+{
+namespace ValueCodec
+{
+
+/**
+ * Get the size of the encoding of the given values
+ * \param values Values to encode
+ * \return Return the size in bytes
+ */
+size_t getEncodedSize(const Values& values);
+
+/**
+ * Encode the given values. Names are kept, integers are stored as variable length integers,
+ * and sequences of unnamed reals are copied in bulk.
+ * \param values Values to encode
+ * \param output Output buffer, which must be at least getEncodedSize(values) long
+ * \return Return a pointer past the last written byte
+ */
+uint8_t* encode(const Values& values, uint8_t* output);
+
+/**
+ * Decode values, directly from the given buffer
+ * \param data Encoded values
+ * \param size Size of the encoded values
+ * \param values Decoded values
+ * \return Return false if the buffer does not hold valid encoded values
+ */
+bool decode(const uint8_t* data, size_t size, Values& values);
+
+} // namespace ValueCodec
+} // namespace Splash
+
+#endif // SPLASH_VALUE_CODEC_H
@@ -1,11 +1,16 @@
 #include "./core/world.h"
 
+#include <algorithm>
+#include <atomic>
 #include <chrono>
+#include <filesystem>
 #include <fstream>
 #include <getopt.h>
 #include <glm/gtc/matrix_transform.hpp>
+#include <iterator>
 #include <regex>
 #include <set>
+#include <sstream>
 #include <spawn.h>
 #include <sys/wait.h>
 #include <unistd.h>
@@ -18,10 +23,33 @@
 #include "./image/image.h"
 #include "./image/queue.h"
 #include "./mesh/mesh.h"
+#include "./utils/boot_timeline.h"
+#include "./utils/json_snapshot.h"
 #include "./utils/jsonutils.h"
 #include "./utils/log.h"
 #include "./utils/osutils.h"
+#include "./utils/thread_pool.h"
 #include "./utils/timer.h"
+#include "./utils/trace_recorder.h"
+
+// Time to wait for a spawned Scene to be launched, in seconds
+#define SPLASH_WORLD_SCENE_LAUNCH_TIMEOUT 5
+// Scenes which were not ready to swap for this long, in us, are not waited for anymore
+#define SPLASH_WORLD_SWAP_BARRIER_DROPOUT 500000
+// Delay between the release of the swap barrier and the targeted presentation time, in us
+// This has to cover the delivery of the release message to all the Scenes
+#define SPLASH_WORLD_SWAP_BARRIER_MARGIN 2000
+// Number of frames rendered by every Scene before the benchmark measures start
+#define SPLASH_WORLD_BENCHMARK_WARMUP_FRAMES 60
+// Size of the synthetic images used in benchmark mode
+#define SPLASH_WORLD_BENCHMARK_IMAGE_WIDTH 1920
+#define SPLASH_WORLD_BENCHMARK_IMAGE_HEIGHT 1080
+// Time during which the timings are still measured after the last replayed event, in ms
+#define SPLASH_WORLD_REPLAY_TAIL_DURATION 1000
+// Time after which the boot report is issued even if some Scenes did not render their first frame, in seconds
+#define SPLASH_WORLD_BOOT_REPORT_TIMEOUT 30
+// Name of the server object handling the remote GUI clients
+#define SPLASH_WORLD_REMOTE_GUI_SERVER "_remoteGui"
 
 using namespace glm;
 using namespace std;
@@ -46,6 +74,8 @@ World::World(Context context)
     if (_context.socketPrefix.empty())
         _context.socketPrefix = to_string(static_cast<int>(getpid()));
     _link = make_unique<Link>(this, _name);
+    _trackUpdatedBufferObjects = true;
+    BootTimeline::get().setThreadOwner(_name);
 
     registerAttributes();
     initializeTree();
@@ -59,6 +89,8 @@ World::~World()
 #endif
     if (_innerSceneThread.joinable())
         _innerSceneThread.join();
+    // The inner Scene link delivers to this World until it is destroyed
+    _innerScene.reset();
 }
 
 /*************/
@@ -97,6 +129,9 @@ bool World::applyContext()
     if (_context.log2file)
         addTask([=] { setAttribute("logToFile", {_context.log2file}); });
 
+    if (_context.replaySessionPath && !loadSessionReplay(*_context.replaySessionPath))
+        return false;
+
     if (_context.defaultConfigurationFile)
         Log::get() << Log::MESSAGE << "No filename specified, loading default file" << Log::endl;
     else
@@ -110,67 +145,80 @@ bool World::applyContext()
     else if (!_context.unitTest)
         return false;
 
+    // Recording starts before the Scenes are spawned, for no message from them to be missed
+    if (_context.recordSessionPath)
+    {
+        _sessionRecording = make_unique<SessionRecording>();
+        const auto configurationFile = Utils::getFullPathFromFilePath(_context.configurationFile, Utils::getCurrentWorkingDirectory());
+        if (!_sessionRecording->start(*_context.recordSessionPath, configurationFile))
+            _sessionRecording.reset();
+    }
+
     return true;
 }
 
 /*************/
 void World::run()
 {
-    if (!applyContext())
-        return;
+    static const auto loopWorldProbe = Timer::get().getProbe("loop_world");
+    static const auto loopWorldInnerProbe = Timer::get().getProbe("loop_world_inner");
+    static const auto treeProcessProbe = Timer::get().getProbe("tree_process");
+    static const auto serializeProbe = Timer::get().getProbe("serialize");
+    static const auto uploadProbe = Timer::get().getProbe("upload");
+    static const auto treePropagateProbe = Timer::get().getProbe("tree_propagate");
+
+    {
+        BootStep bootStep("apply_context");
+        if (!applyContext())
+            return;
+    }
+
+    TraceRecorder::get().setProcessName("world");
+    TraceRecorder::get().setThreadName("world");
 
     if (!applyConfig())
         return;
 
     while (true)
     {
-        Timer::get() << "loop_world";
-        Timer::get() << "loop_world_inner";
+        Timer::get() << loopWorldProbe;
+        Timer::get() << loopWorldInnerProbe;
         lock_guard<mutex> lockConfiguration(_configurationMutex);
 
+        // Temporaries of the previous loop are all dead by now
+        _frameArena.reset();
+
         // Process tree updates
-        Timer::get() << "tree_process";
+        Timer::get() << treeProcessProbe;
         _tree.processQueue(true);
-        Timer::get() >> "tree_process";
+        Timer::get() >> treeProcessProbe;
 
         // Execute waiting tasks
         executeTreeCommands();
         runTasks();
 
-        {
-            lock_guard<recursive_mutex> lockObjects(_objectsMutex);
+        if (_context.benchmarkFrames)
+            updateBenchmark();
+        else if (_context.replaySessionPath)
+            updateReplay();
 
-            // Read and serialize new buffers
-            Timer::get() << "serialize";
-            unordered_map<string, shared_ptr<SerializedObject>> serializedObjects;
-            for (auto& [name, object] : _objects)
+        {
+            // All objects are updated at the world framerate, including the ones which signaled a new buffer.
+            // Buffer objects are updated and sent outside of the objects lock, each one holding its own locks
+            pmr::vector<shared_ptr<BufferObject>> bufferObjects(_frameArena.resource());
             {
-                object->runTasks();
-                object->update();
-                if (auto bufferObject = dynamic_pointer_cast<BufferObject>(object); bufferObject)
+                lock_guard<recursive_mutex> lockObjects(_objectsMutex);
+                getUpdatedBufferObjects();
+                for (auto& [name, object] : _objects)
                 {
-                    if (bufferObject->wasUpdated())
-                    {
-                        auto serializedObject = bufferObject->serialize();
-                        bufferObject->setNotUpdated();
-                        serializedObjects[name] = serializedObject;
-                    }
+                    object->runTasks();
+                    if (auto bufferObject = dynamic_pointer_cast<BufferObject>(object); bufferObject)
+                        bufferObjects.push_back(bufferObject);
+                    else
+                        object->update();
                 }
             }
-            Timer::get() >> "serialize";
-
-            // Wait for previous buffers to be uploaded
-            _link->waitForBufferSending(chrono::milliseconds(50)); // Maximum time to wait for frames to arrive
-            sendMessage(SPLASH_ALL_PEERS, "uploadTextures", {});
-            Timer::get() >> "upload";
-
-            // Ask for the upload of the new buffers, during the next world loop
-            Timer::get() << "upload";
-            for (auto& [name, serializedObject] : serializedObjects)
-            {
-                assert(serializedObject);
-                _link->sendBuffer(name, serializedObject);
-            }
+            sendBufferObjects(bufferObjects, false);
         }
 
         if (_quit)
@@ -180,19 +228,468 @@ void World::run()
             break;
         }
 
-        Timer::get() << "tree_propagate";
+        Timer::get() << treePropagateProbe;
         updateTreeFromObjects();
+#if HAVE_PORTAUDIO
+        // Publish how the LTC clock relates to the local one
+        if (_clock && *_clock)
+        {
+            for (const auto& [leafName, value] : {make_pair("ltc_offset", _clock->getOffset()), make_pair("ltc_jitter", _clock->getJitter())})
+            {
+                auto path = "/world/stats/" + string(leafName);
+                if (_tree.hasLeafAt(path) || _tree.createLeafAt(path))
+                    _tree.setValueForLeafAt(path, Values({Value(value)}));
+            }
+        }
+#endif
         propagateTree();
-        Timer::get() >> "tree_propagate";
+        Timer::get() >> treePropagateProbe;
+
+        if (!_bootReported)
+        {
+            updateBootReport();
+            if (_bootReported && _sessionRecording)
+                recordSessionOrigin();
+        }
+
+        {
+            lock_guard<mutex> lockMetrics(_metricsMutex);
+            if (_metricsExporter.isEnabled() && Timer::getTime() - _lastMetricsExport >= static_cast<int64_t>(_metricsPeriod) * 1000)
+            {
+                _metricsExporter.exportMetrics(_tree);
+                _lastMetricsExport = Timer::getTime();
+            }
+        }
+
+        // Until the next world tick, only the buffer objects signaling a new buffer are updated and sent, right away
+        Timer::get() >> loopWorldInnerProbe;
+        const auto nextTick = Timer::getTime() + std::max<int64_t>(1, 1e6 / (float)_worldFramerate - Timer::get().getDuration(loopWorldInnerProbe));
+        for (auto now = Timer::getTime(); now < nextTick && !_quit; now = Timer::getTime())
+        {
+            if (!waitSignalBufferObjectUpdated(nextTick - now))
+                break;
+
+            auto updatedBufferObjects = getUpdatedBufferObjects();
+            if (updatedBufferObjects.empty())
+                continue;
 
-        // Sync with buffer object update
-        Timer::get() >> "loop_world_inner";
-        auto elapsed = Timer::get().getDuration("loop_world_inner");
-        waitSignalBufferObjectUpdated(std::max<uint64_t>(1, 1e6 / (float)_worldFramerate - elapsed));
+            _frameArena.reset();
+            pmr::vector<shared_ptr<BufferObject>> bufferObjects(_frameArena.resource());
+            {
+                lock_guard<recursive_mutex> lockObjects(_objectsMutex);
+                for (const auto& name : updatedBufferObjects)
+                {
+                    auto objectIt = _objects.find(name);
+                    if (objectIt == _objects.end())
+                        continue;
+                    if (auto bufferObject = dynamic_pointer_cast<BufferObject>(objectIt->second); bufferObject)
+                        bufferObjects.push_back(bufferObject);
+                }
+            }
+            sendBufferObjects(bufferObjects, true);
+        }
 
         // Sync to world framerate
-        Timer::get() >> "loop_world";
+        Timer::get() >> loopWorldProbe;
+    }
+}
+
+/*************/
+void World::sendBufferObjects(const pmr::vector<shared_ptr<BufferObject>>& bufferObjects, bool uploadRightAway)
+{
+    static const auto serializeProbe = Timer::get().getProbe("serialize");
+    static const auto uploadProbe = Timer::get().getProbe("upload");
+
+    // Wait for previous buffers to be uploaded, which they mostly are as they were sent during the previous world loop
+    if (!uploadRightAway)
+    {
+        _link->waitForBufferSending(chrono::milliseconds(50)); // Maximum time to wait for frames to arrive
+        sendMessage(SPLASH_ALL_PEERS, "uploadTextures", {});
+        Timer::get() >> uploadProbe;
+    }
+
+    // Update, serialize and send the new buffers, each one as soon as it is ready so that a big image does not delay the others.
+    // The tasks of the World are not run meanwhile, so the sampled regions and suspended images stay untouched.
+    Timer::get() << serializeProbe;
+    Timer::get() << uploadProbe;
+    atomic_uint sentCount{0};
+    ThreadPool::get().runParallel(bufferObjects.size(), [&](unsigned int index) {
+        const auto& bufferObject = bufferObjects[index];
+        bufferObject->update();
+        if (!bufferObject->wasUpdated())
+            return;
+
+        // Images are only sent partially to the Scenes which do not sample them entirely
+        const auto name = bufferObject->getName();
+        auto image = dynamic_pointer_cast<Image>(bufferObject);
+
+        // Suspended images are kept marked as updated, so that they are sent as soon as they are resumed
+        if (image && _suspendedImages.count(name))
+            return;
+
+        // Frames from live sources are superseded by the next ones, a lagging Scene can skip them
+        auto policy = image && image->getSpec().videoFrame ? Link::BufferPolicy::latestOnly : Link::BufferPolicy::lossless;
+        if (auto tiles = image ? serializeImageTiles(name, image) : map<string, shared_ptr<SerializedObject>>(); !tiles.empty())
+        {
+            bufferObject->setNotUpdated();
+            for (auto& [sceneName, tile] : tiles)
+                if (tile)
+                    _link->sendBufferTo(sceneName, name, tile, policy);
+        }
+        else
+        {
+            auto serializedObject = bufferObject->serialize();
+            bufferObject->setNotUpdated();
+            if (serializedObject)
+                _link->sendBuffer(name, serializedObject, policy);
+        }
+        ++sentCount;
+    });
+    Timer::get() >> serializeProbe;
+
+    // Signaled buffers are uploaded as soon as they are sent, instead of at the next world tick
+    if (uploadRightAway && sentCount > 0)
+    {
+        _link->waitForBufferSending(chrono::milliseconds(50));
+        sendMessage(SPLASH_ALL_PEERS, "uploadTextures", {});
+        Timer::get() >> uploadProbe;
+    }
+}
+
+/*************/
+void World::updateBenchmark()
+{
+    if (!_benchmarkSetup)
+    {
+        // Images get their synthetic content, and are sent at every frame as a playing video would
+        {
+            lock_guard<recursive_mutex> lockObjects(_objectsMutex);
+            for (auto& object : _objects)
+            {
+                if (auto image = dynamic_pointer_cast<Image>(object.second); image)
+                {
+                    image->setAttribute("pattern", {true, SPLASH_WORLD_BENCHMARK_IMAGE_WIDTH, SPLASH_WORLD_BENCHMARK_IMAGE_HEIGHT});
+                    image->setAttribute("benchmark", {true});
+                }
+            }
+        }
+
+        // Rendering is not throttled to the refresh rate
+        sendMessage(SPLASH_ALL_PEERS, "swapInterval", {0});
+        _benchmarkSetup = true;
+        return;
+    }
+
+    auto samples = MetricsExporter::collect(_tree);
+    auto frameCounts = getSceneFrameCounts(samples);
+    if (frameCounts.empty() || frameCounts.size() != _scenes.size())
+        return;
+
+    if (!_benchmarkStarted)
+    {
+        for (const auto& frameCount : frameCounts)
+            if (frameCount.second < SPLASH_WORLD_BENCHMARK_WARMUP_FRAMES)
+                return;
+
+        _benchmarkStarted = true;
+        startMeasure(frameCounts);
+        return;
+    }
+
+    accumulateMeasure(samples);
+
+    for (const auto& frameCount : frameCounts)
+        if (frameCount.second - _benchmarkStartFrames[frameCount.first] < static_cast<int64_t>(*_context.benchmarkFrames))
+            return;
+
+    auto results = getMeasureAsJson(frameCounts);
+    results["frames"] = *_context.benchmarkFrames;
+
+    cout << results.toStyledString() << endl;
+    _quit = true;
+}
+
+/*************/
+map<string, int64_t> World::getSceneFrameCounts(const vector<MetricsExporter::Sample>& samples) const
+{
+    map<string, int64_t> frameCounts;
+    for (const auto& sample : samples)
+        if (sample.group == "stats" && sample.name == "frame_count" && _scenes.find(sample.root) != _scenes.end())
+            frameCounts[sample.root] = static_cast<int64_t>(sample.value);
+    return frameCounts;
+}
+
+/*************/
+void World::startMeasure(const map<string, int64_t>& frameCounts)
+{
+    _benchmarkStartTime = Timer::getTime();
+    _benchmarkStartFrames = frameCounts;
+    _benchmarkDurations.clear();
+}
+
+/*************/
+void World::accumulateMeasure(const vector<MetricsExporter::Sample>& samples)
+{
+    // Durations are sampled at each World loop, and averaged over the whole measure
+    for (const auto& sample : samples)
+    {
+        if (sample.group == "stats")
+            continue;
+        auto& accumulator = _benchmarkDurations[sample.root][sample.group][sample.name];
+        accumulator.first += sample.value;
+        ++accumulator.second;
+    }
+}
+
+/*************/
+Json::Value World::getMeasureAsJson(const map<string, int64_t>& frameCounts) const
+{
+    auto elapsed = static_cast<double>(Timer::getTime() - _benchmarkStartTime) / 1e6;
+    Json::Value results;
+    results["version"] = PACKAGE_VERSION;
+    results["configuration"] = _configFilename;
+    results["duration"] = elapsed;
+
+    for (const auto& [rootName, groups] : _benchmarkDurations)
+    {
+        auto& rootResults = rootName == "world" ? results["world"] : results["scenes"][rootName];
+        for (const auto& [groupName, durations] : groups)
+            for (const auto& [durationName, accumulator] : durations)
+                rootResults[groupName + "_ms"][durationName] = accumulator.first / static_cast<double>(std::max<uint64_t>(1, accumulator.second)) / 1e3;
+    }
+
+    for (const auto& [sceneName, frameCount] : frameCounts)
+    {
+        auto startFrames = _benchmarkStartFrames.find(sceneName);
+        auto frames = frameCount - (startFrames != _benchmarkStartFrames.end() ? startFrames->second : 0);
+        results["scenes"][sceneName]["frames"] = static_cast<Json::Int64>(frames);
+        results["scenes"][sceneName]["fps"] = elapsed > 0.0 ? static_cast<double>(frames) / elapsed : 0.0;
+    }
+
+    return results;
+}
+
+/*************/
+bool World::loadSessionReplay(const string& path)
+{
+    SessionRecording::Header header;
+    if (!SessionRecording::read(path, header, _replayEvents))
+        return false;
+
+    // The session is replayed with the configuration it was recorded with, unless another one is given
+    if (_context.defaultConfigurationFile && !header.configurationFile.empty())
+    {
+        _context.defaultConfigurationFile = false;
+        _context.configurationFile = header.configurationFile;
+    }
+    else if (Utils::getFullPathFromFilePath(_context.configurationFile, Utils::getCurrentWorkingDirectory()) != header.configurationFile)
+    {
+        Log::get() << Log::WARNING << "World::" << __FUNCTION__ << " - Session " << path << " was recorded with configuration " << header.configurationFile
+                   << ", the replay may differ from the recording" << Log::endl;
+    }
+
+    bool hasOrigin = false;
+    bool mediaUnchanged = true;
+    for (const auto& event : _replayEvents)
+    {
+        if (event.type == SessionRecording::EventType::Origin && !hasOrigin)
+        {
+            _replayOrigin = event.time;
+            hasOrigin = true;
+        }
+        mediaUnchanged &= SessionRecording::checkMedia(event);
+    }
+
+    if (!mediaUnchanged)
+        Log::get() << Log::WARNING << "World::" << __FUNCTION__ << " - Some media files changed since the recording, the replay may differ from the recording" << Log::endl;
+
+    Log::get() << Log::MESSAGE << "World::" << __FUNCTION__ << " - Replaying session " << path << ", holding " << _replayEvents.size() << " events" << Log::endl;
+    return true;
+}
+
+/*************/
+void World::updateReplay()
+{
+    if (!_bootReported)
+        return;
+
+    auto samples = MetricsExporter::collect(_tree);
+    auto frameCounts = getSceneFrameCounts(samples);
+
+    // Events are replayed relative to the time every Scene rendered its first frame, as they were recorded
+    if (!_replayStarted)
+    {
+        _replayStarted = true;
+        startMeasure(frameCounts);
+    }
+    else
+    {
+        accumulateMeasure(samples);
+    }
+
+    const auto elapsed = Timer::getTime() - _benchmarkStartTime;
+    for (; _replayNextEvent < _replayEvents.size(); ++_replayNextEvent)
+    {
+        const auto& event = _replayEvents[_replayNextEvent];
+        if (event.time - _replayOrigin > elapsed)
+            break;
+
+        if (event.type == SessionRecording::EventType::Message)
+        {
+            set(event.name, event.attribute, event.args);
+            ++_replayedEvents;
+        }
+        else if (event.type == SessionRecording::EventType::Seeds)
+        {
+            // Changes are applied as if they were made now, for them not to be overridden by older values
+            for (const auto& change : event.args)
+            {
+                const auto task = change.as<Values>();
+                if (task.size() != 2)
+                    continue;
+                _tree.addSeedToQueue(static_cast<Tree::Task>(task[0].as<int>()), task[1].as<Values>());
+            }
+            ++_replayedEvents;
+        }
+    }
+
+    if (_replayNextEvent < _replayEvents.size())
+        return;
+
+    const auto lastEventTime = _replayEvents.empty() ? _replayOrigin : _replayEvents.back().time;
+    if (elapsed < lastEventTime - _replayOrigin + static_cast<int64_t>(SPLASH_WORLD_REPLAY_TAIL_DURATION) * 1000)
+        return;
+
+    auto results = getMeasureAsJson(frameCounts);
+    results["session"] = *_context.replaySessionPath;
+    results["events"] = static_cast<Json::UInt64>(_replayedEvents);
+
+    cout << results.toStyledString() << endl;
+    _quit = true;
+}
+
+/*************/
+void World::recordSessionOrigin()
+{
+    _sessionRecording->recordOrigin();
+
+    lock_guard<recursive_mutex> lockObjects(_objectsMutex);
+    for (auto& [name, object] : _objects)
+    {
+        Values file;
+        if (object->getAttribute("file", file) && file.size() > 0 && file[0].getType() == Value::Type::string)
+            _sessionRecording->recordMedia(name, file[0].as<string>());
+    }
+
+    // Media files not loaded yet are recorded too, they will be once linked
+    lock_guard<mutex> lockMedia(_lazyMediaMutex);
+    for (auto& [name, file] : _deferredMedia)
+        if (file.size() > 0 && file[0].getType() == Value::Type::string)
+            _sessionRecording->recordMedia(name, file[0].as<string>());
+}
+
+/*************/
+void World::updateBootReport()
+{
+    if (_scenes.empty())
+        return;
+
+    const auto now = Timer::getTime();
+    if (_bootReportDeadline == 0)
+        _bootReportDeadline = now + static_cast<int64_t>(SPLASH_WORLD_BOOT_REPORT_TIMEOUT) * 1000000;
+
+    vector<string> pendingScenes;
+    for (const auto& scene : _scenes)
+        if (!_tree.hasLeafAt("/" + scene.first + "/boot/first_frame"))
+            pendingScenes.push_back(scene.first);
+    if (!pendingScenes.empty() && now < _bootReportDeadline)
+        return;
+
+    _bootReported = true;
+    BootTimeline::get().finish();
+
+    // Steps are read from the tree, where each root object published them on the shared clock
+    struct Step
+    {
+        string root;
+        string name;
+        int64_t start;
+        int64_t end;
+        int64_t duration;
+        int64_t count;
+    };
+    vector<Step> steps;
+    vector<string> roots{"world"};
+    for (const auto& scene : _scenes)
+        roots.push_back(scene.first);
+    for (const auto& root : roots)
+    {
+        const auto bootPath = "/" + root + "/boot";
+        if (!_tree.hasBranchAt(bootPath))
+            continue;
+        for (const auto& stepName : _tree.getLeafListAt(bootPath))
+        {
+            Value value;
+            if (!_tree.getValueForLeafAt(bootPath + "/" + stepName, value) || value.size() != 4)
+                continue;
+            steps.push_back({root, stepName, value[0].as<int64_t>(), value[1].as<int64_t>(), value[2].as<int64_t>(), value[3].as<int64_t>()});
+        }
+    }
+    if (steps.empty())
+        return;
+
+    std::sort(steps.begin(), steps.end(), [](const Step& a, const Step& b) { return a.start < b.start; });
+    const auto origin = steps.front().start;
+    int64_t bootEnd = origin;
+    for (const auto& step : steps)
+        if (step.name == "first_frame")
+            bootEnd = std::max(bootEnd, step.end);
+
+    const auto toMs = [](int64_t duration) { return static_cast<double>(duration) / 1e3; };
+    Log::get() << Log::MESSAGE << "World::" << __FUNCTION__ << " - Boot took " << toMs(bootEnd - origin) << " ms until the first frame of all Scenes" << Log::endl;
+    for (const auto& step : steps)
+    {
+        ostringstream entry;
+        entry << "[" << step.root << "] +" << toMs(step.start - origin) << " ms: " << step.name;
+        if (step.end != step.start)
+            entry << " took " << toMs(step.duration) << " ms";
+        if (step.count > 1)
+            entry << " over " << step.count << " occurrences";
+        Log::get() << Log::MESSAGE << "World::" << __FUNCTION__ << " - " << entry.str() << Log::endl;
     }
+    for (const auto& sceneName : pendingScenes)
+        Log::get() << Log::WARNING << "World::" << __FUNCTION__ << " - Scene " << sceneName << " did not render its first frame within " << SPLASH_WORLD_BOOT_REPORT_TIMEOUT << " seconds"
+                   << Log::endl;
+
+    const auto bootDurationPath = "/world/stats/boot_duration";
+    if (_tree.hasLeafAt(bootDurationPath) || _tree.createLeafAt(bootDurationPath))
+        _tree.setValueForLeafAt(bootDurationPath, Values({Value(bootEnd - origin)}));
+
+    if (_bootReportPath.empty())
+        return;
+
+    Json::Value report;
+    report["version"] = PACKAGE_VERSION;
+    report["configuration"] = _configFilename;
+    report["duration_ms"] = toMs(bootEnd - origin);
+    report["pending_scenes"] = Json::Value(Json::arrayValue);
+    for (const auto& sceneName : pendingScenes)
+        report["pending_scenes"].append(sceneName);
+    for (const auto& step : steps)
+    {
+        Json::Value jsStep;
+        jsStep["name"] = step.name;
+        jsStep["start_ms"] = toMs(step.start - origin);
+        jsStep["end_ms"] = toMs(step.end - origin);
+        jsStep["duration_ms"] = toMs(step.duration);
+        jsStep["count"] = static_cast<Json::Int64>(step.count);
+        report["roots"][step.root].append(jsStep);
+    }
+
+    ofstream file(_bootReportPath, ios::out | ios::binary);
+    file << report.toStyledString();
+    if (!file.good())
+        Log::get() << Log::WARNING << "World::" << __FUNCTION__ << " - Unable to write the boot report to " << _bootReportPath << Log::endl;
 }
 
 /*************/
@@ -211,15 +708,351 @@ void World::addToWorld(const string& type, const string& name)
     }
 }
 
+/*************/
+void World::addObject(const string& requestedType, string name, const string& scene, bool checkName, const string& placement, bool sync)
+{
+    lock_guard<recursive_mutex> lockObjects(_objectsMutex);
+
+    // In benchmark mode media are replaced with synthetic images, so that the results depend neither on the files nor on the decoders
+    auto type = requestedType;
+    if (_context.benchmarkFrames && type != "image" && _factory->isSubtype<Image>(type))
+        type = "image";
+
+    if (checkName && (name.empty() || !_nameRegistry.registerName(name)))
+        name = _nameRegistry.generateName(type);
+
+    // Objects placed in the Scenes have no counterpart in the World, which only sends them the clock and their attributes
+    if (placement != "scene")
+        addToWorld(type, name);
+
+    if (type == "window")
+    {
+        lock_guard<mutex> lockMedia(_lazyMediaMutex);
+        _windowNames.insert(name);
+    }
+
+    if (scene.empty())
+    {
+        for (auto& s : _scenes)
+        {
+            sendMessage(s.first, "addObject", {type, name, s.first, placement});
+            if (sync)
+                sendMessageWithAnswer(s.first, "sync");
+        }
+    }
+    else
+    {
+        sendMessage(scene, "addObject", {type, name, scene, placement});
+        if (scene != _masterSceneName)
+            sendMessage(_masterSceneName, "addObject", {type, name, scene});
+        if (sync)
+            sendMessageWithAnswer(scene, "sync");
+    }
+
+    set(name, "configFilePath", {Utils::getPathFromFilePath(_configFilename)}, false);
+}
+
+/*************/
+void World::setObjectAttribute(const string& name, const string& attr, const Values& values)
+{
+    // Send the updated values to all scenes
+    sendMessage(name, attr, values);
+
+    // Also update local version
+    auto object = getObject(name);
+    if (!object)
+        return;
+
+    // The Scenes still get the file path, they do not load it anyway and it has to be saved with the configuration
+    if (_lazyMediaLoading && attr == "file")
+    {
+        lock_guard<mutex> lockMedia(_lazyMediaMutex);
+        if (!isLinkedToWindow(name))
+        {
+            _deferredMedia[name] = values;
+            return;
+        }
+        _deferredMedia.erase(name);
+    }
+
+    object->setAttribute(attr, values);
+}
+
+/*************/
+void World::configureObjects(const Json::Value& objects)
+{
+    addTask([=]() {
+        // Loading media files is what takes time here, and objects do not depend on each other
+        auto objectNames = objects.getMemberNames();
+        ThreadPool::get().runParallel(objectNames.size(), [&](unsigned int index) {
+            const auto& objectName = objectNames[index];
+            const auto& obj = objects[objectName];
+            for (const auto& attr : obj.getMemberNames())
+            {
+                if (attr == "type")
+                    continue;
+                setObjectAttribute(objectName, attr, Utils::jsonToValues(obj[attr]));
+            }
+        });
+    });
+}
+
+/*************/
+void World::updateObjectLink(const string& source, const string& sink, bool linked)
+{
+    {
+        lock_guard<mutex> lockMedia(_lazyMediaMutex);
+        if (linked)
+            _objectLinks.insert({source, sink});
+        else
+            _objectLinks.erase({source, sink});
+    }
+
+    if (linked)
+        loadDeferredMedia();
+}
+
+/*************/
+bool World::isLinkedToWindow(const string& name) const
+{
+    std::set<string> visited{name};
+    vector<string> toVisit{name};
+    while (!toVisit.empty())
+    {
+        auto current = toVisit.back();
+        toVisit.pop_back();
+        if (_windowNames.count(current))
+            return true;
+
+        for (auto linkIt = _objectLinks.lower_bound({current, ""}); linkIt != _objectLinks.end() && linkIt->first == current; ++linkIt)
+            if (visited.insert(linkIt->second).second)
+                toVisit.push_back(linkIt->second);
+    }
+
+    return false;
+}
+
+/*************/
+void World::loadDeferredMedia()
+{
+    vector<pair<string, Values>> media;
+    {
+        lock_guard<mutex> lockMedia(_lazyMediaMutex);
+        for (auto mediaIt = _deferredMedia.begin(); mediaIt != _deferredMedia.end();)
+        {
+            if (!_lazyMediaLoading || isLinkedToWindow(mediaIt->first))
+            {
+                media.push_back(*mediaIt);
+                mediaIt = _deferredMedia.erase(mediaIt);
+            }
+            else
+            {
+                ++mediaIt;
+            }
+        }
+    }
+
+    ThreadPool::get().runParallel(media.size(), [&](unsigned int index) {
+        const auto& [name, values] = media[index];
+        if (auto object = getObject(name); object)
+        {
+            Log::get() << Log::MESSAGE << "World::" << __FUNCTION__ << " - Loading media of " << name << ", now linked to a window" << Log::endl;
+            object->setAttribute("file", values);
+        }
+    });
+}
+
+/*************/
+string World::getObjectPlacement(const Json::Value& object)
+{
+    if (!object.isMember("placement"))
+        return "world";
+
+    auto placement = Utils::jsonToValues(object["placement"]);
+    if (placement.empty() || placement[0].getType() != Value::Type::string)
+        return "world";
+
+    return placement[0].as<string>();
+}
+
+/*************/
+void World::setSceneReadyToSwap(const string& sceneName)
+{
+    if (!_frameLock)
+        return;
+
+    unique_lock<mutex> lock(_swapBarrierMutex);
+    auto now = Timer::getTime();
+    _swapBarrierParticipants[sceneName] = now;
+    _swapBarrierReady.insert(sceneName);
+
+    // Scenes which stopped swapping, or stopped altogether, must not hold the others
+    for (auto participantIt = _swapBarrierParticipants.begin(); participantIt != _swapBarrierParticipants.end();)
+    {
+        if (now - participantIt->second > SPLASH_WORLD_SWAP_BARRIER_DROPOUT)
+        {
+            _swapBarrierReady.erase(participantIt->first);
+            participantIt = _swapBarrierParticipants.erase(participantIt);
+        }
+        else
+        {
+            ++participantIt;
+        }
+    }
+
+    if (_swapBarrierReady.size() < _swapBarrierParticipants.size())
+        return;
+
+    _swapBarrierReady.clear();
+    auto generation = ++_swapBarrierGeneration;
+    lock.unlock();
+
+    // The World clock is the shared clock
+    sendMessage(SPLASH_ALL_PEERS, "swapRelease", {generation, now + SPLASH_WORLD_SWAP_BARRIER_MARGIN});
+}
+
+/*************/
+map<string, shared_ptr<SerializedObject>> World::serializeImageTiles(const string& name, const shared_ptr<Image>& image) const
+{
+    static const array<float, 4> wholeImage{0.f, 0.f, 1.f, 1.f};
+
+    map<string, array<float, 4>> sceneRegions;
+    bool isTiled = false;
+    for (const auto& [sceneName, pid] : _scenes)
+    {
+        auto region = wholeImage;
+        if (auto scenesIt = _sampledImageRegions.find(sceneName); scenesIt != _sampledImageRegions.end())
+            if (auto regionIt = scenesIt->second.find(name); regionIt != scenesIt->second.end())
+                region = regionIt->second;
+        isTiled = isTiled || region != wholeImage;
+        sceneRegions[sceneName] = region;
+    }
+
+    // As soon as one Scene gets a tile, each Scene gets its own buffer instead of the broadcast one
+    map<string, shared_ptr<SerializedObject>> tiles;
+    if (!isTiled)
+        return tiles;
+
+    for (const auto& [sceneName, region] : sceneRegions)
+        tiles[sceneName] = image->serializeRegion(region[0], region[1], region[2], region[3]);
+
+    return tiles;
+}
+
+/*************/
+void World::updateSuspendedImages()
+{
+    // An image is suspended only if every Scene reported it as not sampled
+    std::set<string> suspendedImages;
+    if (!_scenes.empty())
+    {
+        for (const auto& [sceneName, pid] : _scenes)
+        {
+            auto imagesIt = _unsampledImages.find(sceneName);
+            if (imagesIt == _unsampledImages.end())
+            {
+                suspendedImages.clear();
+                break;
+            }
+
+            if (sceneName == _scenes.begin()->first)
+            {
+                suspendedImages = imagesIt->second;
+                continue;
+            }
+
+            std::set<string> intersection;
+            set_intersection(suspendedImages.begin(),
+                suspendedImages.end(),
+                imagesIt->second.begin(),
+                imagesIt->second.end(),
+                inserter(intersection, intersection.begin()));
+            suspendedImages = std::move(intersection);
+        }
+    }
+
+    if (suspendedImages == _suspendedImages)
+        return;
+
+    lock_guard<recursive_mutex> lockObjects(_objectsMutex);
+    const auto setSuspended = [&](const string& name, bool suspended) {
+        auto objectIt = _objects.find(name);
+        if (objectIt == _objects.end())
+            return;
+        if (auto image = dynamic_pointer_cast<Image>(objectIt->second); image)
+            image->setSuspended(suspended);
+    };
+
+    for (const auto& name : _suspendedImages)
+        if (!suspendedImages.count(name))
+            setSuspended(name, false);
+    for (const auto& name : suspendedImages)
+        if (!_suspendedImages.count(name))
+            setSuspended(name, true);
+    _suspendedImages = std::move(suspendedImages);
+}
+
+/*************/
+void World::updateImageResolutions()
+{
+    // Only the Scenes holding an image tell which resolution they need, the highest one being kept
+    std::map<std::string, std::array<int, 2>> imageResolutions;
+    for (const auto& [sceneName, resolutions] : _sampledImageResolutions)
+    {
+        for (const auto& [imageName, resolution] : resolutions)
+        {
+            auto resolutionIt = imageResolutions.find(imageName);
+            if (resolutionIt == imageResolutions.end())
+                imageResolutions[imageName] = resolution;
+            else if (resolution[0] == 0 || resolution[1] == 0 || resolutionIt->second[0] == 0 || resolutionIt->second[1] == 0)
+                resolutionIt->second = {0, 0};
+            else
+                resolutionIt->second = {std::max(resolutionIt->second[0], resolution[0]), std::max(resolutionIt->second[1], resolution[1])};
+        }
+    }
+
+    if (imageResolutions == _imageResolutions)
+        return;
+
+    lock_guard<recursive_mutex> lockObjects(_objectsMutex);
+    for (const auto& [imageName, resolution] : _imageResolutions)
+    {
+        if (imageResolutions.find(imageName) != imageResolutions.end())
+            continue;
+        if (auto image = dynamic_pointer_cast<Image>(getObject(imageName)); image)
+            image->setSampledResolution(0, 0);
+    }
+    for (const auto& [imageName, resolution] : imageResolutions)
+    {
+        if (auto resolutionIt = _imageResolutions.find(imageName); resolutionIt != _imageResolutions.end() && resolutionIt->second == resolution)
+            continue;
+        if (auto image = dynamic_pointer_cast<Image>(getObject(imageName)); image)
+            image->setSampledResolution(resolution[0], resolution[1]);
+    }
+    _imageResolutions = std::move(imageResolutions);
+}
+
 /*************/
 bool World::applyConfig()
 {
+    BootStep bootStep("apply_config");
     lock_guard<mutex> lockConfiguration(_configurationMutex);
 
     // We first destroy all scene and objects
     _scenes.clear();
+    _sampledImageRegions.clear();
+    _unsampledImages.clear();
+    _suspendedImages.clear();
+    _sampledImageResolutions.clear();
+    _imageResolutions.clear();
     _objects.clear();
     _masterSceneName = "";
+    {
+        lock_guard<mutex> lockMedia(_lazyMediaMutex);
+        _objectLinks.clear();
+        _windowNames.clear();
+        _deferredMedia.clear();
+    }
 
     try
     {
@@ -236,15 +1069,23 @@ bool World::applyConfig()
             string sceneAddress = scenes[sceneName].isMember("address") ? scenes[sceneName]["address"].asString() : "localhost";
             string sceneDisplay = scenes[sceneName].isMember("display") ? scenes[sceneName]["display"].asString() : "";
             bool spawn = scenes[sceneName].isMember("spawn") ? scenes[sceneName]["spawn"].asBool() : true;
+            string sceneGpu = scenes[sceneName].isMember("gpu") ? scenes[sceneName]["gpu"].asString() : "";
+            // Scenes run by default next to their GPU, so that the buffers they upload do not cross sockets
+            int sceneNumaNode = scenes[sceneName].isMember("numaNode") ? scenes[sceneName]["numaNode"].asInt() : getGpuNumaNode(sceneGpu);
 
-            if (!addScene(sceneName, sceneDisplay, sceneAddress, spawn && _context.spawnSubprocesses))
-                continue;
+            addScene(sceneName, sceneDisplay, sceneAddress, spawn && _context.spawnSubprocesses, sceneGpu, sceneNumaNode);
+        }
+
+        // All Scenes have been spawned without waiting for each other, now wait for them all
+        connectSpawnedScenes();
 
-            // Set the remaining parameters
-            for (const auto& paramName : scenes[sceneName].getMemberNames())
+        // Set the remaining parameters
+        for (const auto& scene : _scenes)
+        {
+            for (const auto& paramName : scenes[scene.first].getMemberNames())
             {
-                auto values = Utils::jsonToValues(scenes[sceneName][paramName]);
-                sendMessage(sceneName, paramName, values);
+                auto values = Utils::jsonToValues(scenes[scene.first][paramName]);
+                sendMessage(scene.first, paramName, values);
             }
         }
 
@@ -257,35 +1098,34 @@ bool World::applyConfig()
         sendMessage(_masterSceneName, "setMaster", {_configFilename});
 
         // Then, we create the objects
-        for (const auto& scene : _scenes)
-        {
-            const Json::Value& objects = _config["scenes"][scene.first]["objects"];
-            if (!objects)
-                continue;
-
-            // Create the objects
-            auto sceneMembers = objects.getMemberNames();
-            for (const auto& objectName : objects.getMemberNames())
+        // Scenes create them concurrently, and are only synced once all of them have been sent
+        addTask([=]() {
+            for (const auto& scene : _scenes)
             {
-                if (!objects[objectName].isMember("type"))
+                const Json::Value& objects = _config["scenes"][scene.first]["objects"];
+                if (!objects)
                     continue;
 
-                setAttribute("addObject", {objects[objectName]["type"].asString(), objectName, scene.first, false});
+                for (const auto& objectName : objects.getMemberNames())
+                {
+                    if (!objects[objectName].isMember("type"))
+                        continue;
+
+                    addObject(objects[objectName]["type"].asString(), objectName, scene.first, false, getObjectPlacement(objects[objectName]), false);
+                }
             }
 
-            sendMessage(SPLASH_ALL_PEERS, "runInBackground", {_context.hide});
-        }
+            // Make sure all objects have been created in every Scene
+            for (const auto& s : _scenes)
+                sendMessageWithAnswer(s.first, "sync");
+        });
 
-        // Make sure all objects have been created in every Scene, by sending a sync
-        // message
-        for (const auto& s : _scenes)
-            sendMessageWithAnswer(s.first, "sync");
+        sendMessage(SPLASH_ALL_PEERS, "runInBackground", {_context.hide});
 
         // Then we link the objects together
         for (auto& s : _scenes)
         {
             const Json::Value& scene = _config["scenes"][s.first];
-            auto sceneMembers = scene.getMemberNames();
             const Json::Value& links = scene["links"];
             if (!links)
                 continue;
@@ -294,94 +1134,312 @@ bool World::applyConfig()
             {
                 if (link.size() < 2)
                     continue;
-                addTask([=]() { sendMessage(SPLASH_ALL_PEERS, "link", {link[0].asString(), link[1].asString()}); });
+                addTask([=]() {
+                    sendMessage(SPLASH_ALL_PEERS, "link", {link[0].asString(), link[1].asString()});
+                    updateObjectLink(link[0].asString(), link[1].asString(), true);
+                });
             }
         }
 
         // Configure the objects
+        // Objects with the same name in multiple Scenes are clones, the attributes are sent to all of them anyway
+        Json::Value objects;
         for (auto& s : _scenes)
         {
-            const Json::Value& objects = _config["scenes"][s.first]["objects"];
-            if (!objects)
-                continue;
+            const Json::Value& sceneObjects = _config["scenes"][s.first]["objects"];
+            for (const auto& objectName : sceneObjects.getMemberNames())
+                objects[objectName] = sceneObjects[objectName];
+        }
+        configureObjects(objects);
 
-            // Create the objects
-            for (const auto& objectName : objects.getMemberNames())
+        // Lastly, configure this very World
+        // This happens last as some parameters are sent to Scenes (like blending
+        // computation)
+        if (_config.isMember("world"))
+        {
+            const Json::Value jsWorld = _config["world"];
+            auto worldMember = jsWorld.getMemberNames();
+            int idx{0};
+            for (const auto& attr : jsWorld)
             {
-                auto& obj = objects[objectName];
+                auto values = Utils::jsonToValues(attr);
+                string paramName = worldMember[idx];
+                setAttribute(paramName, values);
+                idx++;
+            }
+        }
+    }
+    catch (...)
+    {
+        Log::get() << Log::ERROR << "Exception caught while applying configuration from file " << _configFilename << Log::endl;
+        return false;
+    }
 
-                addTask([=]() {
-                    // Set their attributes
-                    auto objMembers = obj.getMemberNames();
-                    int idxAttr = 0;
-                    for (const auto& attr : obj)
-                    {
-                        if (objMembers[idxAttr] == "type")
-                        {
-                            idxAttr++;
-                            continue;
-                        }
+// Also, enable the master clock if it was not enabled
+#if HAVE_PORTAUDIO
+    addTask([&]() {
+        if (!_clock)
+            _clock = unique_ptr<LtcClock>(new LtcClock(true));
+    });
+#endif
 
-                        auto values = Utils::jsonToValues(attr);
-                        values.push_front(objMembers[idxAttr]);
-                        values.push_front(objectName);
-                        setAttribute("sendAll", values);
+    // Send the start message for all scenes
+    for (auto& s : _scenes)
+    {
+        auto answer = sendMessageWithAnswer(s.first, "start", {}, 2e6);
+        if (0 == answer.size())
+        {
+            Log::get() << Log::ERROR << "World::" << __FUNCTION__ << " - Timeout when trying to connect to scene \"" << s.first << "\". Exiting." << Log::endl;
+            _quit = true;
+            break;
+        }
+    }
 
-                        idxAttr++;
-                    }
-                });
+    // The remote GUI server lives in the World, so that remote clients never reach the render loops of the Scenes
+    if (_context.remoteGuiAddress)
+        addRemoteGuiServer(*_context.remoteGuiAddress);
+
+    return true;
+}
+
+/*************/
+void World::addRemoteGuiServer(const string& address)
+{
+    auto separator = address.rfind(':');
+    if (separator == string::npos || separator == address.size() - 1)
+    {
+        Log::get() << Log::WARNING << "World::" << __FUNCTION__ << " - Remote GUI address must be given as host:port, got " << address << Log::endl;
+        return;
+    }
+
+    auto server = _factory->create("http_server");
+    if (!server)
+        return;
+
+    lock_guard<recursive_mutex> lockObjects(_objectsMutex);
+    server->setName(SPLASH_WORLD_REMOTE_GUI_SERVER);
+    server->setSavable(false);
+    server->setAttribute("address", {address.substr(0, separator)});
+    server->setAttribute("port", {atoi(address.substr(separator + 1).c_str())});
+    _objects[SPLASH_WORLD_REMOTE_GUI_SERVER] = server;
+}
+
+/*************/
+vector<string> World::getGpuEnvironment(const string& gpu)
+{
+    if (gpu.empty())
+        return {};
+
+    if (gpu.rfind("nvidia", 0) == 0)
+    {
+        vector<string> env = {"__NV_PRIME_RENDER_OFFLOAD=1", "__GLX_VENDOR_LIBRARY_NAME=nvidia"};
+        if (auto separator = gpu.find(':'); separator != string::npos)
+            env.push_back("__NV_PRIME_RENDER_OFFLOAD_PROVIDER=NVIDIA-G" + gpu.substr(separator + 1));
+        return env;
+    }
+
+    return {"DRI_PRIME=" + gpu};
+}
+
+/*************/
+int World::getGpuNumaNode(const string& gpu)
+{
+    if (Utils::getNumaNodeCount() < 2)
+        return -1;
+
+    string busId;
+    if (gpu.rfind("pci-", 0) == 0)
+    {
+        // DRI_PRIME tags replace the separators of the bus id with underscores: pci-0000_01_00_0
+        busId = gpu.substr(4);
+        if (busId.size() != 12)
+            return -1;
+        busId[4] = ':';
+        busId[7] = ':';
+        busId[10] = '.';
+    }
+    else if (gpu.rfind("nvidia:", 0) == 0)
+    {
+        // The NVIDIA driver lists its GPUs by bus id, along with their minor device number
+        auto minor = gpu.substr(7);
+        error_code errorCode;
+        for (const auto& entry : filesystem::directory_iterator("/proc/driver/nvidia/gpus", errorCode))
+        {
+            ifstream information(entry.path() / "information");
+            string line;
+            while (getline(information, line))
+            {
+                if (line.rfind("Device Minor:", 0) != 0)
+                    continue;
+                auto value = line.substr(line.find(':') + 1);
+                value.erase(0, value.find_first_not_of(" \t"));
+                if (value == minor)
+                    busId = entry.path().filename();
+                break;
             }
+            if (!busId.empty())
+                break;
         }
+    }
+
+    if (busId.empty())
+        return -1;
+
+    // Sysfs lists the bus ids with lower case hexadecimal digits
+    transform(busId.begin(), busId.end(), busId.begin(), ::tolower);
+    return Utils::getPciDeviceNumaNode(busId);
+}
+
+/*************/
+bool World::reloadConfig(const Json::Value& configuration)
+{
+    lock_guard<mutex> lockConfiguration(_configurationMutex);
+
+    // Scenes are not reloaded, the new configuration has to describe the same ones
+    static const vector<string> sceneSpawnParameters{"address", "display", "spawn", "gpu", "numaNode"};
+    const Json::Value& scenes = configuration["scenes"];
+    if (_scenes.empty() || scenes.size() != _scenes.size())
+        return false;
+    const Json::Value& currentScenes = _config["scenes"];
+    for (const auto& scene : _scenes)
+    {
+        if (!scenes.isMember(scene.first) || !_tree.hasBranchAt("/" + scene.first))
+            return false;
+        for (const auto& parameter : sceneSpawnParameters)
+            if (scenes[scene.first][parameter] != currentScenes[scene.first][parameter])
+                return false;
+    }
+
+    ObjectsConfiguration current;
+    ObjectsConfiguration target;
+    for (const auto& scene : _scenes)
+    {
+        const auto& sceneName = scene.first;
+        const Json::Value& sceneConfiguration = scenes[sceneName];
+        auto currentConfiguration = getRootConfigurationAsJson(sceneName);
+
+        // Scene parameters
+        for (const auto& attr : sceneConfiguration.getMemberNames())
+        {
+            if (attr == "objects" || attr == "links" || find(sceneSpawnParameters.begin(), sceneSpawnParameters.end(), attr) != sceneSpawnParameters.end())
+                continue;
+            if (currentConfiguration.isMember(attr) && Utils::isJsonEquivalent(currentConfiguration[attr], sceneConfiguration[attr]))
+                continue;
+            sendMessage(sceneName, attr, Utils::jsonToValues(sceneConfiguration[attr]));
+        }
+
+        const auto flatten = [&](const Json::Value& sceneObjects, const Json::Value& sceneLinks, ObjectsConfiguration& flat) {
+            for (const auto& objectName : sceneObjects.getMemberNames())
+            {
+                if (!flat.objects.isMember(objectName))
+                    flat.objects[objectName] = sceneObjects[objectName];
+                flat.scenes[objectName].insert(sceneName);
+            }
+            for (const auto& link : sceneLinks)
+                if (link.size() >= 2)
+                    flat.links.insert({link[0].asString(), link[1].asString()});
+        };
+        flatten(currentConfiguration["objects"], currentConfiguration["links"], current);
+        flatten(sceneConfiguration["objects"], sceneConfiguration["links"], target);
+    }
+
+    applyObjectsDelta(current, target);
+
+    // Lastly, the World itself
+    auto currentWorld = getRootConfigurationAsJson("world");
+    const Json::Value& jsWorld = configuration["world"];
+    for (const auto& attr : jsWorld.getMemberNames())
+    {
+        if (currentWorld.isMember(attr) && Utils::isJsonEquivalent(currentWorld[attr], jsWorld[attr]))
+            continue;
+        setAttribute(attr, Utils::jsonToValues(jsWorld[attr]));
+    }
+
+    _config = configuration;
+    return true;
+}
+
+/*************/
+void World::applyObjectsDelta(const ObjectsConfiguration& current, const ObjectsConfiguration& target)
+{
+    const auto getScenes = [](const ObjectsConfiguration& configuration, const string& name) {
+        auto scenesIt = configuration.scenes.find(name);
+        return scenesIt == configuration.scenes.end() ? std::set<string>() : scenesIt->second;
+    };
+
+    // Objects which disappeared, or changed type or Scenes, are deleted
+    std::set<string> deletedObjects;
+    Json::Value newObjects{Json::objectValue};
+    for (const auto& name : current.objects.getMemberNames())
+    {
+        if (target.objects.isMember(name))
+        {
+            const auto& targetObject = target.objects[name];
+            if (!targetObject.isMember("type"))
+                continue;
+            if (targetObject["type"] == current.objects[name]["type"] && getScenes(target, name) == getScenes(current, name))
+                continue;
+            newObjects[name] = targetObject;
+        }
+
+        setAttribute("deleteObject", {name});
+        deletedObjects.insert(name);
+    }
 
-        // Lastly, configure this very World
-        // This happens last as some parameters are sent to Scenes (like blending
-        // computation)
-        if (_config.isMember("world"))
+    for (const auto& name : target.objects.getMemberNames())
+        if (!current.objects.isMember(name) && target.objects[name].isMember("type"))
+            newObjects[name] = target.objects[name];
+
+    // New objects are sent to all their Scenes before syncing them, as in applyConfig
+    auto targetScenes = target.scenes;
+    addTask([=]() {
+        for (const auto& name : newObjects.getMemberNames())
         {
-            const Json::Value jsWorld = _config["world"];
-            auto worldMember = jsWorld.getMemberNames();
-            int idx{0};
-            for (const auto& attr : jsWorld)
+            const auto& object = newObjects[name];
+            auto scenesIt = targetScenes.find(name);
+            if (scenesIt == targetScenes.end())
             {
-                auto values = Utils::jsonToValues(attr);
-                string paramName = worldMember[idx];
-                setAttribute(paramName, values);
-                idx++;
+                addObject(object["type"].asString(), name, "", false, getObjectPlacement(object), false);
+                continue;
             }
+            for (const auto& scene : scenesIt->second)
+                addObject(object["type"].asString(), name, scene, false, getObjectPlacement(object), false);
         }
-    }
-    catch (...)
-    {
-        Log::get() << Log::ERROR << "Exception caught while applying configuration from file " << _configFilename << Log::endl;
-        return false;
-    }
 
-// Also, enable the master clock if it was not enabled
-#if HAVE_PORTAUDIO
-    addTask([&]() {
-        if (!_clock)
-            _clock = unique_ptr<LtcClock>(new LtcClock(true));
+        for (const auto& s : _scenes)
+            sendMessageWithAnswer(s.first, "sync");
     });
-#endif
 
-    // Send the start message for all scenes
-    for (auto& s : _scenes)
+    // Links of deleted objects are gone with them
+    for (const auto& link : current.links)
+        if (!target.links.count(link) && !deletedObjects.count(link.first) && !deletedObjects.count(link.second))
+            setAttribute("unlink", {link.first, link.second});
+    for (const auto& link : target.links)
+        if (!current.links.count(link) || deletedObjects.count(link.first) || deletedObjects.count(link.second))
+            setAttribute("link", {link.first, link.second});
+
+    // Only the attributes which changed are set
+    Json::Value changedObjects{Json::objectValue};
+    for (const auto& name : target.objects.getMemberNames())
     {
-        auto answer = sendMessageWithAnswer(s.first, "start", {}, 2e6);
-        if (0 == answer.size())
+        const auto& targetObject = target.objects[name];
+        bool isNew = newObjects.isMember(name) || !current.objects.isMember(name);
+        for (const auto& attr : targetObject.getMemberNames())
         {
-            Log::get() << Log::ERROR << "World::" << __FUNCTION__ << " - Timeout when trying to connect to scene \"" << s.first << "\". Exiting." << Log::endl;
-            _quit = true;
-            break;
+            if (attr == "type")
+                continue;
+            if (!isNew && current.objects[name].isMember(attr) && Utils::isJsonEquivalent(current.objects[name][attr], targetObject[attr]))
+                continue;
+            changedObjects[name][attr] = targetObject[attr];
         }
     }
-
-    return true;
+    configureObjects(changedObjects);
 }
 
 /*************/
-bool World::addScene(const std::string& sceneName, const std::string& sceneDisplay, const std::string& sceneAddress, bool spawn)
+bool World::addScene(const std::string& sceneName, const std::string& sceneDisplay, const std::string& sceneAddress, bool spawn, const std::string& sceneGpu, int numaNode)
 {
+    BootStep bootStep("add_scene_" + sceneName);
     if (sceneAddress == "localhost")
     {
         string display{""};
@@ -419,14 +1477,24 @@ bool World::addScene(const std::string& sceneName, const std::string& sceneDispl
         int pid = -1;
         if (spawn)
         {
-            _sceneLaunched = false;
+            {
+                lock_guard<mutex> lockChildProcess(_childProcessMutex);
+                _launchedScenes.erase(sceneName);
+            }
 
             // If the current process is on the correct display, we use an inner Scene
-            if (worldDisplay.size() > 0 && display.find(worldDisplay) == display.size() - worldDisplay.size() && !_innerScene)
+            // The GPU and the NUMA node can only be selected for a new process
+            bool isInnerScene = sceneGpu.empty() && numaNode < 0 && worldDisplay.size() > 0 && display.find(worldDisplay) == display.size() - worldDisplay.size() && !_innerScene;
+            if (isInnerScene)
             {
                 Log::get() << Log::MESSAGE << "World::" << __FUNCTION__ << " - Starting an inner Scene" << Log::endl;
                 auto sceneContext = _context;
                 sceneContext.childSceneName = sceneName;
+                // The network addresses belong to the World, the inner Scene only talks to it
+                sceneContext.listenAddress = "";
+                sceneContext.multicastAddress = "";
+                // Both directions go through the in-process path of the Link
+                sceneContext.innerWorld = this;
                 _innerScene = make_shared<Scene>(sceneContext);
                 _innerSceneThread = thread([&]() { _innerScene->run(); });
             }
@@ -451,46 +1519,99 @@ bool World::addScene(const std::string& sceneName, const std::string& sceneDispl
                     argv.push_back(const_cast<char*>(debug.c_str()));
                 if (!timer.empty())
                     argv.push_back(const_cast<char*>(timer.c_str()));
+                if (_context.headless)
+                    argv.push_back((char*)"--headless");
+                string numaNodeArgument = to_string(numaNode);
+                if (numaNode >= 0)
+                {
+                    argv.push_back((char*)"--numaNode");
+                    argv.push_back(const_cast<char*>(numaNodeArgument.c_str()));
+                }
                 argv.push_back(const_cast<char*>(sceneName.c_str()));
                 argv.push_back(nullptr);
-                vector<char*> env = {const_cast<char*>(display.c_str()), const_cast<char*>(xauth.c_str()), nullptr};
+                auto gpuEnv = getGpuEnvironment(sceneGpu);
+                vector<char*> env = {const_cast<char*>(display.c_str()), const_cast<char*>(xauth.c_str())};
+                for (const auto& variable : gpuEnv)
+                    env.push_back(const_cast<char*>(variable.c_str()));
+                env.push_back(nullptr);
+
+                if (!sceneGpu.empty())
+                    Log::get() << Log::MESSAGE << "World::" << __FUNCTION__ << " - Scene " << sceneName << " will render on GPU " << sceneGpu << Log::endl;
+                if (numaNode >= 0)
+                    Log::get() << Log::MESSAGE << "World::" << __FUNCTION__ << " - Scene " << sceneName << " will run on NUMA node " << numaNode << Log::endl;
 
                 int status = posix_spawn(&pid, cmd.c_str(), nullptr, nullptr, argv.data(), env.data());
                 if (status != 0)
                     Log::get() << Log::ERROR << "World::" << __FUNCTION__ << " - Error while spawning process for scene " << sceneName << Log::endl;
             }
 
-            // We wait for the child process to be launched
-            unique_lock<mutex> lockChildProcess(_childProcessMutex);
-            while (!_sceneLaunched)
-            {
-                if (cv_status::timeout == _childProcessConditionVariable.wait_for(lockChildProcess, chrono::seconds(5)))
-                {
-                    Log::get() << Log::ERROR << "World::" << __FUNCTION__ << " - Timeout when trying to connect to newly spawned scene \"" << sceneName << "\". Exiting."
-                               << Log::endl;
-                    _quit = true;
-                    return false;
-                }
-            }
+            // The communication is initialized once the Scene is launched, see connectSpawnedScenes
+            _scenesToConnect[sceneName] = isInnerScene;
         }
 
         _scenes[sceneName] = pid;
         if (_masterSceneName.empty())
             _masterSceneName = sceneName;
 
-        // Initialize the communication
-        if (pid == -1 && spawn)
-            _link->connectTo(sceneName, _innerScene.get());
-        else
+        if (!spawn)
             _link->connectTo(sceneName);
 
         return true;
     }
     else
     {
-        Log::get() << Log::WARNING << "World::" << __FUNCTION__ << " - Non-local scenes are not implemented yet" << Log::endl;
-        return false;
+        // Scenes on other hosts cannot be spawned, they are expected to be already running:
+        // splash --child --address <sceneAddress> --world <worldAddress> <sceneName>
+        if (_context.listenAddress.empty())
+        {
+            Log::get() << Log::WARNING << "World::" << __FUNCTION__ << " - Scene " << sceneName << " is on another host, the World has to listen on a TCP address (see --address)"
+                       << Log::endl;
+            return false;
+        }
+
+        Log::get() << Log::MESSAGE << "World::" << __FUNCTION__ << " - Connecting to Scene " << sceneName << " at address " << sceneAddress << Log::endl;
+        _scenes[sceneName] = -1;
+        if (_masterSceneName.empty())
+            _masterSceneName = sceneName;
+
+        _link->connectTo(sceneName, sceneAddress);
+        return true;
+    }
+}
+
+/*************/
+bool World::connectSpawnedScenes()
+{
+    BootStep bootStep("connect_scenes");
+    bool allConnected = true;
+    for (const auto& [sceneName, isInnerScene] : _scenesToConnect)
+    {
+        {
+            // Scenes were all spawned before, so they are launching concurrently while we wait for the first ones
+            unique_lock<mutex> lockChildProcess(_childProcessMutex);
+            auto launched = _childProcessConditionVariable.wait_for(
+                lockChildProcess, chrono::seconds(SPLASH_WORLD_SCENE_LAUNCH_TIMEOUT), [&]() { return _launchedScenes.count(sceneName) != 0; });
+            if (!launched)
+            {
+                Log::get() << Log::ERROR << "World::" << __FUNCTION__ << " - Timeout when trying to connect to newly spawned scene \"" << sceneName << "\". Exiting."
+                           << Log::endl;
+                _quit = true;
+                _scenes.erase(sceneName);
+                if (_masterSceneName == sceneName)
+                    _masterSceneName = _scenes.empty() ? "" : _scenes.begin()->first;
+                allConnected = false;
+                continue;
+            }
+        }
+
+        if (isInnerScene)
+            _link->connectTo(sceneName, _innerScene.get());
+        else
+            _link->connectTo(sceneName);
     }
+
+    _scenesToConnect.clear();
+    return allConnected;
 }
 
 /*************/
@@ -566,7 +1687,7 @@ string World::getObjectsAttributesDescriptions()
 }
 
 /*************/
-void World::saveConfig()
+void World::saveConfig(bool snapshotOnly)
 {
     setlocale(LC_NUMERIC,
         "C"); // Needed to make sure numbers are written with commas
@@ -609,11 +1730,20 @@ void World::saveConfig()
         _config["world"][attr] = worldConfiguration[attr];
     }
 
+    if (snapshotOnly)
+    {
+        Utils::saveJsonSnapshot(Utils::getJsonSnapshotPath(_configFilename), _config, _configFilename);
+        return;
+    }
+
     setlocale(LC_NUMERIC,
         "C"); // Needed to make sure numbers are written with commas
     ofstream out(_configFilename, ios::binary);
     out << _config.toStyledString();
     out.close();
+
+    // The snapshot is written after the Json file, as it records its modification date
+    Utils::saveJsonSnapshot(Utils::getJsonSnapshotPath(_configFilename), _config, _configFilename);
 }
 
 /*************/
@@ -672,6 +1802,8 @@ void World::saveProject(const string& filename)
         ofstream out(filename, ios::binary);
         out << root.toStyledString();
         out.close();
+
+        Utils::saveJsonSnapshot(Utils::getJsonSnapshotPath(filename), root, filename);
     }
     catch (...)
     {
@@ -763,13 +1895,18 @@ bool World::copyCameraParameters(const std::string& filename)
 /*************/
 bool World::loadConfig(const string& filename, Json::Value& configuration)
 {
-    if (!Utils::loadJsonFile(filename, configuration))
+    BootStep bootStep("load_config");
+    if (!Utils::loadJsonFileOrSnapshot(filename, configuration))
         return false;
 
     if (!Utils::checkAndUpgradeConfiguration(configuration))
         return false;
 
     _configFilename = filename;
+    // When loading a snapshot directly, the configuration is saved back to the Json file it stands for
+    const string snapshotSuffix = SPLASH_JSON_SNAPSHOT_SUFFIX;
+    if (filename.size() > snapshotSuffix.size() && filename.compare(filename.size() - snapshotSuffix.size(), snapshotSuffix.size(), snapshotSuffix) == 0)
+        _configFilename = filename.substr(0, filename.size() - snapshotSuffix.size());
     _configurationPath = Utils::getPathFromFilePath(_configFilename);
     _mediaPath = Utils::getHomePath(); // By default, home path
     return true;
@@ -781,7 +1918,7 @@ bool World::loadProject(const string& filename)
     try
     {
         Json::Value partialConfig;
-        if (!Utils::loadJsonFile(filename, partialConfig))
+        if (!Utils::loadJsonFileOrSnapshot(filename, partialConfig))
             return false;
 
         if (!partialConfig.isMember("description") || partialConfig["description"].asString() != SPLASH_FILE_PROJECT)
@@ -792,32 +1929,35 @@ bool World::loadProject(const string& filename)
         _configurationPath = Utils::getPathFromFilePath(filename);
 
         // Now, we apply the configuration depending on the current state
-        // Meaning, we replace objects with the same name, create objects with
-        // non-existing name, and delete objects which are not in the partial config
-
-        // Delete existing objects
+        // Meaning, we keep objects with the same name and type and only set the attributes which changed,
+        // create objects with non-existing name, and delete objects which are not in the partial config
+        ObjectsConfiguration current;
+        std::set<pair<string, string>> currentLinks;
         for (const auto& s : _scenes)
         {
-            const Json::Value& sceneObjects = _config["scenes"][s.first]["objects"];
+            auto sceneConfiguration = getRootConfigurationAsJson(s.first);
+            const Json::Value& sceneObjects = sceneConfiguration["objects"];
             for (const auto& member : sceneObjects.getMemberNames())
             {
-                if (!sceneObjects[member].isMember("type"))
+                if (!sceneObjects[member].isMember("type") || !_factory->isProjectSavable(sceneObjects[member]["type"].asString()))
                     continue;
-                if (_factory->isProjectSavable(sceneObjects[member]["type"].asString()))
-                    setAttribute("deleteObject", {member});
+                if (!current.objects.isMember(member))
+                    current.objects[member] = sceneObjects[member];
             }
-        }
 
-        // Create new objects
-        for (const auto& objectName : partialConfig["objects"].getMemberNames())
-        {
-            if (!partialConfig["objects"][objectName].isMember("type"))
-                continue;
-            setAttribute("addObject", {partialConfig["objects"][objectName]["type"].asString(), objectName, "", false});
+            for (const auto& link : sceneConfiguration["links"])
+                if (link.size() >= 2)
+                    currentLinks.insert({link[0].asString(), link[1].asString()});
         }
 
-        // Handle the links
-        // We will need a list of all cameras
+        // Only links from partially saved types are part of the project
+        for (const auto& link : currentLinks)
+            if (current.objects.isMember(link.first))
+                current.links.insert(link);
+
+        ObjectsConfiguration target;
+        target.objects = partialConfig["objects"];
+        auto cameraNames = getObjectsOfType("camera");
         for (const auto& link : partialConfig["links"])
         {
             if (link.size() != 2)
@@ -825,47 +1965,18 @@ bool World::loadProject(const string& filename)
             auto source = link[0].asString();
             auto sink = link[1].asString();
 
-            addTask([=]() {
-                if (sink != SPLASH_CAMERA_LINK)
-                {
-                    sendMessage(SPLASH_ALL_PEERS, "link", {link[0].asString(), link[1].asString()});
-                }
-                else
-                {
-                    auto cameraNames = getObjectsOfType("camera");
-                    for (const auto& camera : cameraNames)
-                        sendMessage(SPLASH_ALL_PEERS, "link", {link[0].asString(), camera});
-                }
-            });
+            if (sink != SPLASH_CAMERA_LINK)
+            {
+                target.links.insert({source, sink});
+            }
+            else
+            {
+                for (const auto& camera : cameraNames)
+                    target.links.insert({source, camera});
+            }
         }
 
-        // Configure the objects
-        for (const auto& objectName : partialConfig["objects"].getMemberNames())
-        {
-            auto& obj = partialConfig["objects"][objectName];
-            auto configPath = Utils::getPathFromFilePath(_configFilename);
-
-            addTask([=]() {
-                // Set their attributes
-                auto objMembers = obj.getMemberNames();
-                int idxAttr = 0;
-                for (const auto& attr : obj)
-                {
-                    if (objMembers[idxAttr] == "type")
-                    {
-                        idxAttr++;
-                        continue;
-                    }
-
-                    auto values = Utils::jsonToValues(attr);
-                    values.push_front(objMembers[idxAttr]);
-                    values.push_front(objectName);
-                    setAttribute("sendAll", values);
-
-                    idxAttr++;
-                }
-            });
-        }
+        applyObjectsDelta(current, target);
 
         return true;
     }
@@ -886,45 +1997,77 @@ void World::registerAttributes()
                 auto name = args.size() < 2 ? "" : args[1].as<string>();
                 auto scene = args.size() < 3 ? "" : args[2].as<string>();
                 auto checkName = args.size() < 4 ? true : args[3].as<bool>();
+                auto placement = args.size() < 5 ? "world" : args[4].as<string>();
+                addObject(type, name, scene, checkName, placement, true);
+            });
 
-                lock_guard<recursive_mutex> lockObjects(_objectsMutex);
+            return true;
+        },
+        {'s'});
+    setAttributeDescription("addObject", "Add an object to the scenes, given its type, name, target scene, whether to check the name and its placement (\"world\" or \"scene\")");
 
-                if (checkName && (name.empty() || !_nameRegistry.registerName(name)))
-                    name = _nameRegistry.generateName(type);
+    addAttribute("sceneLaunched",
+        [&](const Values& args) {
+            lock_guard<mutex> lockChildProcess(_childProcessMutex);
+            _launchedScenes.insert(args[0].as<string>());
+            _childProcessConditionVariable.notify_all();
+            return true;
+        },
+        {'s'});
+    setAttributeDescription("sceneLaunched", "Message sent by Scenes with their name, to confirm they are running");
 
-                if (scene.empty())
-                {
-                    addToWorld(type, name);
-                    for (auto& s : _scenes)
-                    {
-                        sendMessage(s.first, "addObject", {type, name, s.first});
-                        sendMessageWithAnswer(s.first, "sync");
-                    }
-                }
-                else
+    addAttribute("sampledImageRegions",
+        [&](const Values& args) {
+            // Only the latest report of each Scene matters
+            addTask("sampledImageRegions_" + args[0].as<string>(), [=]() {
+                auto& regions = _sampledImageRegions[args[0].as<string>()];
+                regions.clear();
+                for (uint32_t i = 1; i < args.size(); ++i)
                 {
-                    addToWorld(type, name);
-                    sendMessage(scene, "addObject", {type, name, scene});
-                    if (scene != _masterSceneName)
-                        sendMessage(_masterSceneName, "addObject", {type, name, scene});
-                    sendMessageWithAnswer(scene, "sync");
+                    auto region = args[i].as<Values>();
+                    if (region.size() != 5)
+                        continue;
+                    regions[region[0].as<string>()] = {region[1].as<float>(), region[2].as<float>(), region[3].as<float>(), region[4].as<float>()};
                 }
-
-                set(name, "configFilePath", {Utils::getPathFromFilePath(_configFilename)}, false);
             });
+            return true;
+        },
+        {'s'});
+    setAttributeDescription("sampledImageRegions", "Message sent by Scenes with the regions of the images sampled by their cameras, as: scene, [image, left, top, right, bottom]...");
 
+    addAttribute("unsampledImages",
+        [&](const Values& args) {
+            addTask("unsampledImages_" + args[0].as<string>(), [=]() {
+                auto& images = _unsampledImages[args[0].as<string>()];
+                images.clear();
+                for (uint32_t i = 1; i < args.size(); ++i)
+                    images.insert(args[i].as<string>());
+                updateSuspendedImages();
+            });
             return true;
         },
         {'s'});
-    setAttributeDescription("addObject", "Add an object to the scenes");
+    setAttributeDescription("unsampledImages", "Message sent by Scenes with the images which none of their visible cameras sample, as: scene, image...");
 
-    addAttribute("sceneLaunched", [&](const Values&) {
-        lock_guard<mutex> lockChildProcess(_childProcessMutex);
-        _sceneLaunched = true;
-        _childProcessConditionVariable.notify_all();
-        return true;
-    });
-    setAttributeDescription("sceneLaunched", "Message sent by Scenes to confirm they are running");
+    addAttribute("sampledImageResolutions",
+        [&](const Values& args) {
+            addTask("sampledImageResolutions_" + args[0].as<string>(), [=]() {
+                auto& resolutions = _sampledImageResolutions[args[0].as<string>()];
+                resolutions.clear();
+                for (uint32_t i = 1; i < args.size(); ++i)
+                {
+                    auto resolution = args[i].as<Values>();
+                    if (resolution.size() != 3)
+                        continue;
+                    resolutions[resolution[0].as<string>()] = {resolution[1].as<int>(), resolution[2].as<int>()};
+                }
+                updateImageResolutions();
+            });
+            return true;
+        },
+        {'s'});
+    setAttributeDescription("sampledImageResolutions",
+        "Message sent by Scenes with the resolutions at which their cameras sample the images, 0 meaning the whole image resolution, as: scene, [image, width, height]...");
 
     addAttribute("deleteObject",
         [&](const Values& args) {
@@ -938,6 +2081,19 @@ void World::registerAttributes()
                 if (objectIt != _objects.end())
                     _objects.erase(objectIt);
 
+                {
+                    lock_guard<mutex> lockMedia(_lazyMediaMutex);
+                    _deferredMedia.erase(objectName);
+                    _windowNames.erase(objectName);
+                    for (auto linkIt = _objectLinks.begin(); linkIt != _objectLinks.end();)
+                    {
+                        if (linkIt->first == objectName || linkIt->second == objectName)
+                            linkIt = _objectLinks.erase(linkIt);
+                        else
+                            ++linkIt;
+                    }
+                }
+
                 // Ask for Scenes to delete the object
                 sendMessage(SPLASH_ALL_PEERS, "deleteObject", args);
 
@@ -952,7 +2108,10 @@ void World::registerAttributes()
 
     addAttribute("link",
         [&](const Values& args) {
-            addTask([=]() { sendMessage(SPLASH_ALL_PEERS, "link", args); });
+            addTask([=]() {
+                sendMessage(SPLASH_ALL_PEERS, "link", args);
+                updateObjectLink(args[0].as<string>(), args[1].as<string>(), true);
+            });
             return true;
         },
         {'s', 's'});
@@ -960,12 +2119,69 @@ void World::registerAttributes()
 
     addAttribute("unlink",
         [&](const Values& args) {
-            addTask([=]() { sendMessage(SPLASH_ALL_PEERS, "unlink", args); });
+            addTask([=]() {
+                sendMessage(SPLASH_ALL_PEERS, "unlink", args);
+                updateObjectLink(args[0].as<string>(), args[1].as<string>(), false);
+            });
             return true;
         },
         {'s', 's'});
     setAttributeDescription("unlink", "Unlink the two given objects");
 
+    addAttribute("addPreview",
+        [&](const Values& args) {
+            addTask([=]() {
+                auto objectName = args[0].as<string>();
+                auto sinkName = args[1].as<string>();
+
+                // The preview is encoded by the first Scene holding the object
+                string sceneName;
+                for (const auto& s : _scenes)
+                {
+                    if (_tree.hasBranchAt("/" + s.first + "/objects/" + objectName))
+                    {
+                        sceneName = s.first;
+                        break;
+                    }
+                }
+
+                if (sceneName.empty())
+                {
+                    Log::get() << Log::WARNING << "World::addPreview - No Scene holds an object named " << objectName << Log::endl;
+                    return;
+                }
+
+                addObject("sink_preview", sinkName, sceneName, false, "scene", true);
+                setObjectAttribute(sinkName, "server", {args[2].as<string>()});
+                if (args.size() >= 5)
+                    setObjectAttribute(sinkName, "encodingSize", {args[3].as<int>(), args[4].as<int>()});
+                if (args.size() >= 6)
+                    setObjectAttribute(sinkName, "framerate", {args[5].as<int>()});
+
+                sendMessage(SPLASH_ALL_PEERS, "link", {objectName, sinkName});
+                updateObjectLink(objectName, sinkName, true);
+            });
+            return true;
+        },
+        {'s', 's', 's'});
+    setAttributeDescription("addPreview",
+        "Create a sink encoding a preview of the given object, as: object, sink name, name of the object receiving the packets, and optionally width, height and framerate. "
+        "Delete the sink with deleteObject to stop the preview");
+
+    addAttribute("previewPacket",
+        [&](const Values& args) {
+            // Packets are handed to their server as soon as received, forwarding them to the Scenes if it does not live in the World
+            auto serverName = args[0].as<string>();
+            auto packet = Values(args.begin() + 1, args.end());
+            if (auto server = getObject(serverName))
+                server->setAttribute("previewPacket", packet);
+            else
+                sendMessage(serverName, "previewPacket", packet);
+            return true;
+        },
+        {'s', 's', 'b', 'i', 'i', 's', 'd'});
+    setAttributeDescription("previewPacket", "Message sent by preview sinks with an encoded packet, as: server, sink, keyframe, width, height, codec, data");
+
     addAttribute("loadConfig",
         [&](const Values& args) {
             string filename = args[0].as<string>();
@@ -973,6 +2189,13 @@ void World::registerAttributes()
                 Json::Value config;
                 if (loadConfig(filename, config))
                 {
+                    // If the Scenes stay the same, only what changed is applied to them
+                    if (reloadConfig(config))
+                    {
+                        Log::get() << Log::MESSAGE << "World::loadConfig - Applied the changes from configuration " << filename << " to the running Scenes" << Log::endl;
+                        return;
+                    }
+
                     for (auto& s : _scenes)
                     {
                         sendMessage(s.first, "quit", {});
@@ -1060,6 +2283,14 @@ void World::registerAttributes()
     });
     setAttributeDescription("save", "Save the configuration to the current file (or a new one if a name is given as parameter)");
 
+    addAttribute("saveSnapshot", [&](const Values&) {
+        addTask([=]() { saveConfig(true); });
+        return true;
+    });
+    setAttributeDescription("saveSnapshot",
+        "Save the configuration to the binary snapshot of the current file only, which is much cheaper than saving the Json file and suited for autosaving. "
+        "The snapshot is loaded instead of the Json file as long as the latter is not modified");
+
     addAttribute("saveProject",
         [&](const Values& args) {
             auto filename = args[0].as<string>();
@@ -1093,21 +2324,88 @@ void World::registerAttributes()
         {'b'});
     setAttributeDescription("logToFile", "If true, the process holding the World will try to write log to file");
 
+    addAttribute("recordTrace",
+        [&](const Values& args) {
+            auto record = args[0].as<bool>();
+            if (record)
+                TraceRecorder::get().start();
+            else
+                TraceRecorder::get().stop(_tracePath + "_world_" + to_string(getpid()) + ".json");
+            setAttribute("sendAllScenes", {"recordTrace", record, _tracePath});
+            return true;
+        },
+        {'b'});
+    setAttributeDescription("recordTrace",
+        "Start or stop recording a trace of the timers, decoding, Link transfers and GPU times of the World and all Scenes. Each process writes its own file in the Chrome trace event "
+        "format, with timestamps on the shared clock, see tools/merge_traces.py");
+
+    addAttribute("tracePath",
+        [&](const Values& args) {
+            _tracePath = args[0].as<string>();
+            return true;
+        },
+        [&]() -> Values { return {_tracePath}; },
+        {'s'});
+    setAttributeDescription("tracePath", "Path prefix of the trace files, completed with the process name and pid");
+
+    addAttribute("bootReportPath",
+        [&](const Values& args) {
+            _bootReportPath = args[0].as<string>();
+            return true;
+        },
+        [&]() -> Values { return {_bootReportPath}; },
+        {'s'});
+    setAttributeDescription("bootReportPath",
+        "Path of the Json boot report, holding the boot steps of the World and of every Scene until their first frame. The report is always logged, this file is only written if set");
+
+    addAttribute("metricsFile",
+        [&](const Values& args) {
+            lock_guard<mutex> lockMetrics(_metricsMutex);
+            _metricsExporter.setPrometheusPath(args[0].as<string>());
+            return true;
+        },
+        [&]() -> Values {
+            lock_guard<mutex> lockMetrics(_metricsMutex);
+            return {_metricsExporter.getPrometheusPath()};
+        },
+        {'s'});
+    setAttributeDescription("metricsFile",
+        "Path of the file to periodically write the metrics of the World and Scenes to, in the Prometheus text format. Meant for the textfile collector of the node exporter");
+
+    addAttribute("metricsStatsdAddress",
+        [&](const Values& args) {
+            lock_guard<mutex> lockMetrics(_metricsMutex);
+            return _metricsExporter.setStatsdAddress(args[0].as<string>());
+        },
+        [&]() -> Values {
+            lock_guard<mutex> lockMetrics(_metricsMutex);
+            return {_metricsExporter.getStatsdAddress()};
+        },
+        {'s'});
+    setAttributeDescription("metricsStatsdAddress", "Address of the StatsD server to periodically send the metrics of the World and Scenes to, as host:port");
+
+    addAttribute("metricsPeriod",
+        [&](const Values& args) {
+            lock_guard<mutex> lockMetrics(_metricsMutex);
+            _metricsPeriod = std::max(10, args[0].as<int>());
+            return true;
+        },
+        [&]() -> Values {
+            lock_guard<mutex> lockMetrics(_metricsMutex);
+            return {_metricsPeriod};
+        },
+        {'i'});
+    setAttributeDescription("metricsPeriod", "Period between two metrics exports, in milliseconds");
+
     addAttribute("sendAll",
         [&](const Values& args) {
             addTask([=]() {
                 string name = args[0].as<string>();
                 string attr = args[1].as<string>();
                 auto values = args;
-
-                // Send the updated values to all scenes
                 values.erase(values.begin());
                 values.erase(values.begin());
-                sendMessage(name, attr, values);
-
-                // Also update local version
-                if (_objects.find(name) != _objects.end())
-                    _objects[name]->setAttribute(attr, values);
+                setObjectAttribute(name, attr, values);
             });
 
             return true;
@@ -1207,6 +2505,43 @@ void World::registerAttributes()
         {'i'});
     setAttributeDescription("swapTest", "Activate video swap test if set to anything but 0");
 
+    addAttribute("frameLock",
+        [&](const Values& args) {
+            _frameLock = args[0].as<bool>();
+            {
+                lock_guard<mutex> lock(_swapBarrierMutex);
+                _swapBarrierParticipants.clear();
+                _swapBarrierReady.clear();
+            }
+            addTask([=]() { sendMessage(SPLASH_ALL_PEERS, "frameLock", {_frameLock}); });
+            return true;
+        },
+        [&]() -> Values { return {_frameLock}; },
+        {'b'});
+    setAttributeDescription("frameLock", "If true, Scenes swap their buffers synchronously, through the network if NV swap barriers are not available");
+
+    addAttribute("lazyMediaLoading",
+        [&](const Values& args) {
+            _lazyMediaLoading = args[0].as<bool>();
+            if (!_lazyMediaLoading)
+            {
+                addTask([&]() { loadDeferredMedia(); });
+            }
+            return true;
+        },
+        [&]() -> Values { return {_lazyMediaLoading}; },
+        {'b'});
+    setAttributeDescription("lazyMediaLoading", "If true, media files are only loaded once their object is linked to a window, to speed up startup");
+
+    // Called directly from the Link thread, to release the barrier as soon as possible
+    addAttribute("swapReady",
+        [&](const Values& args) {
+            setSceneReadyToSwap(args[0].as<string>());
+            return true;
+        },
+        {'s'});
+    setAttributeDescription("swapReady", "Signal that the given Scene is ready to swap its buffers");
+
     addAttribute("wireframe",
         [&](const Values& args) {
             addTask([=]() { sendMessage(SPLASH_ALL_PEERS, "wireframe", args); });
@@ -1236,6 +2571,32 @@ void World::registerAttributes()
         [&]() -> Values { return {_enforceRealtime}; },
         {'b'});
     setAttributeDescription("forceRealtime", "Ask the scheduler to run Splash with realtime priority.");
+
+    addAttribute("threadPoolAffinity",
+        [&](const Values& args) {
+            vector<int> cores;
+            for (const auto& arg : args)
+                cores.push_back(arg.as<int>());
+            ThreadPool::get().setAffinity(cores);
+            return true;
+        },
+        [&]() -> Values {
+            Values cores;
+            for (auto core : ThreadPool::get().getAffinity())
+                cores.push_back(core);
+            return cores;
+        },
+        {});
+    setAttributeDescription("threadPoolAffinity", "Cores the worker threads of the World are allowed to run on. If empty, they can run on any core");
+
+    addAttribute("threadPoolRealtime",
+        [&](const Values& args) {
+            ThreadPool::get().setRealTime(args[0].as<bool>());
+            return true;
+        },
+        [&]() -> Values { return {ThreadPool::get().getRealTime()}; },
+        {'b'});
+    setAttributeDescription("threadPoolRealtime", "Ask the scheduler to run the worker threads of the World with realtime priority");
 #endif
 
     addAttribute("framerate",
@@ -1297,12 +2658,20 @@ void World::registerAttributes()
         [&]() -> Values {
             Timer::Point masterClock;
             if (Timer::get().getMasterClock(masterClock))
-                return {masterClock.years, masterClock.months, masterClock.days, masterClock.hours, masterClock.mins, masterClock.secs, masterClock.frame, masterClock.paused};
+                return {masterClock.years,
+                    masterClock.months,
+                    masterClock.days,
+                    masterClock.hours,
+                    masterClock.mins,
+                    masterClock.secs,
+                    masterClock.frame,
+                    masterClock.paused,
+                    Timer::get().getMasterClockUpdateTime()};
             else
                 return {};
         },
         {});
-    setAttributeDescription("masterClock", "Current World master clock (not settable)");
+    setAttributeDescription("masterClock", "Current World master clock, followed by the World clock time when it was last updated (not settable)");
 
     RootObject::registerAttributes();
 }
@@ -25,18 +25,25 @@
 #ifndef SPLASH_WORLD_H
 #define SPLASH_WORLD_H
 
+#include <array>
 #include <condition_variable>
 #include <glm/glm.hpp>
+#include <memory_resource>
 #include <mutex>
+#include <set>
 #include <signal.h>
 #include <string>
+#include <string_view>
 #include <thread>
+#include <utility>
 #include <vector>
 
 #include "./core/constants.h"
 
 #include "./core/attribute.h"
 #include "./core/factory.h"
+#include "./core/metrics_exporter.h"
+#include "./core/session_recording.h"
 #if HAVE_PORTAUDIO
 #include "./sound/ltcclock.h"
 #endif
@@ -46,6 +53,8 @@
 namespace Splash
 {
 
+class BufferObject;
+class Image;
 class Scene;
 class World;
 
@@ -93,6 +102,33 @@ class World : public RootObject
     bool _enforceCoreAffinity{false}; //!< If true, World and Scenes have their affinity fixed in specific, separate cores
     bool _enforceRealtime{false};     //!< If true, realtime scheduling is asked to the system, if possible
 
+    std::string _tracePath{"/tmp/splash_trace"}; //!< Path prefix of the recorded trace files
+
+    // Boot timeline report, merged from the boot steps of all root objects
+    bool _bootReported{false};      //!< True once the boot report has been issued
+    int64_t _bootReportDeadline{0}; //!< Time after which the report is issued even if some Scenes did not render yet, in us
+    std::string _bootReportPath{};  //!< Path of the Json boot report, none is written if empty
+
+    // Benchmark mode, see RootObject::Context::benchmarkFrames. The measures are shared with the session replay
+    bool _benchmarkSetup{false};                                  //!< True once the synthetic media are set up
+    bool _benchmarkStarted{false};                                //!< True once the warmup frames are rendered
+    int64_t _benchmarkStartTime{0};                               //!< Time at which the measure started, in us
+    std::map<std::string, int64_t> _benchmarkStartFrames{};       //!< Frame count of each Scene when the measure started
+    std::map<std::string, std::map<std::string, std::map<std::string, std::pair<double, uint64_t>>>> _benchmarkDurations{}; //!< Sum and count of the sampled durations, by root object, group and name
+
+    // Session replay, see RootObject::Context::replaySessionPath
+    std::vector<SessionRecording::Event> _replayEvents{}; //!< Recorded events, sorted by time
+    size_t _replayNextEvent{0};                           //!< Index of the next event to replay
+    int64_t _replayOrigin{0};                             //!< Time of the recording from which the events are replayed, in us
+    bool _replayStarted{false};                           //!< True once every Scene rendered its first frame and the replay started
+    uint64_t _replayedEvents{0};                          //!< Number of messages and tree changes replayed
+
+    // Metrics export, for monitoring systems
+    std::mutex _metricsMutex{};
+    MetricsExporter _metricsExporter{}; //!< Exporter of the durations, statistics and GPU times of the World and Scenes
+    int _metricsPeriod{1000};           //!< Period between two exports, in ms
+    int64_t _lastMetricsExport{0};      //!< Time of the last export, in us
+
     // World parameters
     unsigned int _worldFramerate{60}; //!< World framerate, default 60, because synchronous tasks need the loop to run
     std::string _blendingMode{};      //!< Blending mode: can be none, once or continuous
@@ -105,6 +141,12 @@ class World : public RootObject
     std::map<std::string, int> _scenes; //!< Map holding the PID of the Scene processes
     std::string _masterSceneName{""};   //!< Name of the master Scene
 
+    std::map<std::string, std::map<std::string, std::array<float, 4>>> _sampledImageRegions{}; //!< Image regions sampled by each Scene, by Scene and image name
+    std::map<std::string, std::set<std::string>> _unsampledImages{}; //!< Images which no visible camera samples, by Scene
+    std::set<std::string> _suspendedImages{};                        //!< Images sampled by no Scene, which are neither decoded nor sent
+    std::map<std::string, std::map<std::string, std::array<int, 2>>> _sampledImageResolutions{}; //!< Image resolutions needed by each Scene, by Scene and image name
+    std::map<std::string, std::array<int, 2>> _imageResolutions{};                               //!< Image resolutions last set to the images
+
     std::string _configurationPath{""}; //!< Path to the configuration file
     std::string _mediaPath{""};         //!< Default path to the medias
     std::string _configFilename;        //!< Configuration file path
@@ -112,13 +154,48 @@ class World : public RootObject
     Json::Value _config;                //!< Configuration as JSon
 
     NameRegistry _nameRegistry{}; //!< Object name registry
-    bool _sceneLaunched{false};
+    std::set<std::string> _launchedScenes{};        //!< Scenes which confirmed they are running
+    std::map<std::string, bool> _scenesToConnect{}; //!< Spawned Scenes to connect to once launched, and whether they are the inner Scene
     std::mutex _childProcessMutex;
     std::condition_variable _childProcessConditionVariable;
 
+    // Lazy loading of the media files, which are loaded only once linked to a window
+    bool _lazyMediaLoading{false};
+    std::mutex _lazyMediaMutex{};
+    std::set<std::pair<std::string, std::string>> _objectLinks{}; //!< Links between the objects, as sent to the Scenes
+    std::set<std::string> _windowNames{};                          //!< Names of the windows, where the links end
+    std::map<std::string, Values> _deferredMedia{};                //!< Media files not loaded yet, by object name
+
     // Synchronization testings
     int _swapSynchronizationTesting{0}; //!< If not 0, number of frames to keep the same color
 
+    // Frame lock over the network, see Scene::waitForSwapBarrier
+    bool _frameLock{false}; //!< If true, Scenes swap their buffers synchronously
+    std::mutex _swapBarrierMutex{};
+    std::map<std::string, int64_t> _swapBarrierParticipants{}; //!< Scenes taking part in the swap barrier, with the last time they were ready
+    std::set<std::string> _swapBarrierReady{};                  //!< Scenes ready to swap for the current barrier
+    int64_t _swapBarrierGeneration{0};
+
+    //! Objects and links of a configuration, flattened across the Scenes
+    struct ObjectsConfiguration
+    {
+        Json::Value objects{Json::objectValue};                 //!< Objects configuration, by object name
+        std::map<std::string, std::set<std::string>> scenes{}; //!< Scenes holding each object, no entry meaning all Scenes
+        std::set<std::pair<std::string, std::string>> links{}; //!< Links, as source and sink
+    };
+
+    /**
+     * Mark a Scene as ready to swap, and release the swap barrier if all Scenes are ready
+     * \param sceneName Scene name
+     */
+    void setSceneReadyToSwap(const std::string& sceneName);
+
+    /**
+     * Create the server handling remote GUI clients, which get the tree and encoded previews
+     * \param address Address to listen on, as host:port
+     */
+    void addRemoteGuiServer(const std::string& address);
+
     /**
      * Add an object to the world (used for Images and Meshes currently)
      * \param type Object type
@@ -126,6 +203,140 @@ class World : public RootObject
      */
     void addToWorld(const std::string& type, const std::string& name);
 
+    /**
+     * Set up the benchmark once the configuration is loaded, then measure the timings and quit once enough frames have been rendered
+     */
+    void updateBenchmark();
+
+    /**
+     * Get the frame count of each Scene from the collected metrics
+     * \param samples Metrics collected from the tree
+     * \return Return the frame counts, by Scene name
+     */
+    std::map<std::string, int64_t> getSceneFrameCounts(const std::vector<MetricsExporter::Sample>& samples) const;
+
+    /**
+     * Start measuring the timings, for the benchmark and the session replay
+     * \param frameCounts Frame count of each Scene
+     */
+    void startMeasure(const std::map<std::string, int64_t>& frameCounts);
+
+    /**
+     * Accumulate the durations sampled during this loop into the measure
+     * \param samples Metrics collected from the tree
+     */
+    void accumulateMeasure(const std::vector<MetricsExporter::Sample>& samples);
+
+    /**
+     * Get the measured timings, averaged since the start of the measure
+     * \param frameCounts Current frame count of each Scene
+     * \return Return the timings as Json
+     */
+    Json::Value getMeasureAsJson(const std::map<std::string, int64_t>& frameCounts) const;
+
+    /**
+     * Load the session to replay, and check that the media files it uses did not change
+     * \param path Path to the recorded session
+     * \return Return false if the recording could not be read
+     */
+    bool loadSessionReplay(const std::string& path);
+
+    /**
+     * Once every Scene rendered its first frame, replay the recorded events at the time they were recorded,
+     * then print the timings measured during the replay and quit
+     */
+    void updateReplay();
+
+    /**
+     * Record the time from which a session is replayed, and the media files used by the objects
+     */
+    void recordSessionOrigin();
+
+    /**
+     * Once every Scene rendered its first frame, merge the boot timelines of all root objects and report them
+     */
+    void updateBootReport();
+
+    /**
+     * Add an object to the World if needed, and to the Scenes
+     * \param type Object type
+     * \param name Object name, generated if empty or already used and checkName is true
+     * \param scene Scene to add the object to, all Scenes if empty
+     * \param checkName If true, check that the name is not already used
+     * \param placement Object placement, "world" or "scene"
+     * \param sync If true, wait for the Scenes to have created the object
+     */
+    void addObject(const std::string& type, std::string name, const std::string& scene, bool checkName, const std::string& placement, bool sync);
+
+    /**
+     * Set an attribute of an object, in the World and in all Scenes
+     * If lazy media loading is enabled, media files of objects not linked to a window are only loaded once they are
+     * \param name Object name
+     * \param attr Attribute name
+     * \param values Attribute value
+     */
+    void setObjectAttribute(const std::string& name, const std::string& attr, const Values& values);
+
+    /**
+     * Set the attributes of the given objects from their configuration
+     * Objects are independent from each other, so they are configured concurrently
+     * \param objects Objects configuration, by object name
+     */
+    void configureObjects(const Json::Value& objects);
+
+    /**
+     * Add or remove a link between two objects to the links known by the World, and load the media which became visible
+     * \param source Source object
+     * \param sink Sink object
+     * \param linked True for a new link, false for a removed one
+     */
+    void updateObjectLink(const std::string& source, const std::string& sink, bool linked);
+
+    /**
+     * Check whether the given object is linked to a window, directly or not. _lazyMediaMutex must be locked.
+     * \param name Object name
+     * \return Return true if it is
+     */
+    bool isLinkedToWindow(const std::string& name) const;
+
+    /**
+     * Load the deferred media of the objects which are now linked to a window, or all of them if lazy loading has been disabled
+     */
+    void loadDeferredMedia();
+
+    /**
+     * Get the placement of an object from its configuration, "world" if not specified
+     * \param object Object configuration
+     * \return Return the placement
+     */
+    static std::string getObjectPlacement(const Json::Value& object);
+
+    /**
+     * Serialize one tile of an image for each Scene, covering the region sampled by this Scene
+     * \param name Image name
+     * \param image Image to serialize
+     * \return Return the tiles by Scene name, or nothing if all Scenes sample the whole image
+     */
+    std::map<std::string, std::shared_ptr<SerializedObject>> serializeImageTiles(const std::string& name, const std::shared_ptr<Image>& image) const;
+
+    /**
+     * Suspend the images which no Scene samples, and resume the ones which are sampled again
+     */
+    void updateSuspendedImages();
+
+    /**
+     * Set to each image the highest resolution it is sampled at by the Scenes
+     */
+    void updateImageResolutions();
+
+    /**
+     * Update the given buffer objects, then serialize and send the updated ones to the Scenes
+     * The objects are processed in parallel, without holding the objects mutex
+     * \param bufferObjects Buffer objects
+     * \param uploadRightAway If true, ask the Scenes to upload the buffers right after sending them, otherwise ask for the upload of the previously sent ones
+     */
+    void sendBufferObjects(const std::pmr::vector<std::shared_ptr<BufferObject>>& bufferObjects, bool uploadRightAway);
+
     /**
      * Match the current context
      * \return Return true if the context was applied successfully
@@ -138,14 +349,57 @@ class World : public RootObject
      */
     bool applyConfig();
 
+    /**
+     * Apply a new configuration to the running Scenes, by only sending what differs from their current state
+     * Objects and links which did not change are left untouched, so nothing is reloaded nor reuploaded
+     * \param configuration New configuration
+     * \return Return false if the configuration changes the Scenes themselves, and has to be applied with applyConfig
+     */
+    bool reloadConfig(const Json::Value& configuration);
+
+    /**
+     * Send the commands needed to go from the current objects and links to the target ones
+     * Objects which changed type or Scenes are recreated, others only get the attributes which changed
+     * \param current Current objects, usually from the tree
+     * \param target Objects to reach
+     */
+    void applyObjectsDelta(const ObjectsConfiguration& current, const ObjectsConfiguration& target);
+
     /**
      * Spawn a scene given its parameters
+     * Spawned Scenes are not waited for, so that they start concurrently: call connectSpawnedScenes once all are spawned
      * \param name Scene name
      * \param display Display where to spawn the scene
      * \param address Address where to spawn the scene
      * \param spawn If true, the Scene is spawned, otherwise it is considered to be already running
+     * \param sceneGpu GPU to render the scene with, see getGpuEnvironment. If empty, the GPU driving the display is used
+     * \param numaNode NUMA node to bind the Scene process to, -1 to leave it unbound
+     */
+    bool addScene(
+        const std::string& sceneName, const std::string& sceneDisplay, const std::string& sceneAddress, bool spawn = true, const std::string& sceneGpu = "", int numaNode = -1);
+
+    /**
+     * Wait for the spawned Scenes to be launched, and connect to them
+     * Scenes which could not be reached are removed and the World is set to quit
+     * \return Return true if all Scenes were connected
+     */
+    bool connectSpawnedScenes();
+
+    /**
+     * Get the environment variables selecting the GPU a Scene process renders with
+     * Rendering then happens on the given GPU, and frames are copied to the GPU driving the display (PRIME render offload)
+     * \param gpu GPU description: either a Mesa DRI_PRIME value (GPU index or "pci-XXXX_XX_XX_X" tag),
+     * or "nvidia" / "nvidia:N" to use the N-th NVIDIA GPU
+     * \return Return the environment variables, as "NAME=value"
+     */
+    static std::vector<std::string> getGpuEnvironment(const std::string& gpu);
+
+    /**
+     * Get the NUMA node a GPU is attached to
+     * \param gpu GPU description, see getGpuEnvironment. Only "pci-XXXX_XX_XX_X" tags and "nvidia:N" can be located
+     * \return Return the NUMA node, or -1 if unknown
      */
-    bool addScene(const std::string& sceneName, const std::string& sceneDisplay, const std::string& sceneAddress, bool spawn = true);
+    static int getGpuNumaNode(const std::string& gpu);
 
     /**
      * Copies the camera calibration from the given file to the current configuration
@@ -161,9 +415,10 @@ class World : public RootObject
     std::string getObjectsAttributesDescriptions();
 
     /**
-     * Save the configuration
+     * Save the configuration, as Json along with its binary snapshot
+     * \param snapshotOnly If true, only the snapshot is written. It is used when loading the configuration, as long as the Json file is not modified
      */
-    void saveConfig();
+    void saveConfig(bool snapshotOnly = false);
 
     /**
      * Partially save the configuration
@@ -1,5 +1,6 @@
 #include "./graphics/camera.h"
 
+#include <algorithm>
 #include <fstream>
 #include <limits>
 
@@ -8,6 +9,7 @@
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtx/euler_angles.hpp>
 #include <glm/gtx/vector_angle.hpp>
+#include <gsl/gsl_errno.h>
 
 #include "./core/scene.h"
 #include "./graphics/object.h"
@@ -20,6 +22,7 @@
 #include "./utils/cgutils.h"
 #include "./utils/log.h"
 #include "./utils/osutils.h"
+#include "./utils/thread_pool.h"
 #include "./utils/timer.h"
 
 #define SCISSOR_WIDTH 8
@@ -57,6 +60,14 @@
     {                                                                                                                                                                              \
         0.2, 0.2, 1.0, 1.0                                                                                                                                                         \
     }
+// Samples along each axis of the baked color transform, and the texture unit it is bound to.
+// The unit must match the binding of _colorTransformLUT in FRAGMENT_SHADER_TEXTURE
+#define SPLASH_CAMERA_COLOR_LUT_SIZE 33
+#define SPLASH_CAMERA_COLOR_LUT_UNIT 15
+// Texture unit of the blending map, matching the binding of _blendingMap in FRAGMENT_SHADER_TEXTURE
+#define SPLASH_CAMERA_BLENDING_MAP_UNIT 14
+// Work group size of the blending map compute shaders, along each axis
+#define SPLASH_CAMERA_BLENDING_GROUP_SIZE 16
 
 using namespace std;
 using namespace glm;
@@ -64,6 +75,12 @@ using namespace glm;
 namespace Splash
 {
 
+// Attributes set at each frame on the markers and shaders
+const AttributeId colorAttributeId = Attribute::getId("color");
+const AttributeId positionAttributeId = Attribute::getId("position");
+const AttributeId scaleAttributeId = Attribute::getId("scale");
+const AttributeId uniformAttributeId = Attribute::getId("uniform");
+
 /*************/
 Camera::Camera(RootObject* root)
     : GraphObject(root)
@@ -93,16 +110,23 @@ Camera::~Camera()
 #ifdef DEBUG
     Log::get() << Log::DEBUGGING << "Camera::~Camera - Destructor" << Log::endl;
 #endif
+
+    if (_colorTransformLUT)
+        glDeleteTextures(1, &_colorTransformLUT);
+    if (_blendingMap)
+        glDeleteTextures(1, &_blendingMap);
 }
 
 /*************/
-void Camera::computeBlendingContribution()
+void Camera::computeBlendingContribution(const vector<shared_ptr<Object>>& objects)
 {
     for (auto& o : _objects)
     {
         if (o.expired())
             continue;
         auto obj = o.lock();
+        if (!objects.empty() && find(objects.begin(), objects.end(), obj) == objects.end())
+            continue;
 
         obj->computeCameraContribution(computeViewMatrix(), computeProjectionMatrix(), _blendWidth);
     }
@@ -111,67 +135,212 @@ void Camera::computeBlendingContribution()
 /*************/
 void Camera::computeVertexVisibility()
 {
-    // We want to render the object with a specific texture, containing the primitive IDs
-    vector<Values> shaderFill;
-    int primitiveIdShift = 0; // The primitive ID is shifted by the number of vertices already drawn
+    if (!_outFbo)
+        return;
+
+    // A single shader is used for all objects, so that their own shaders are left untouched
+    if (!_visibilityShader)
+    {
+        _visibilityShader = make_shared<Shader>();
+        _visibilityShader->setAttribute("fill", {"primitiveId"});
+    }
+
+    // The primitive ID is shifted by the number of vertices already drawn
+    vector<shared_ptr<Object>> objects;
+    int primitiveIdShift = 0;
     for (auto& o : _objects)
     {
-        if (o.expired())
-            continue;
         auto obj = o.lock();
+        if (!obj)
+            continue;
         obj->resetVisibility(primitiveIdShift);
         primitiveIdShift += obj->getVerticesNumber() / 3;
-
-        Values fill;
-        obj->getAttribute("fill", fill);
-        shaderFill.push_back(fill);
-        obj->setAttribute("fill", {"primitiveId"});
+        objects.push_back(obj);
     }
+    glMemoryBarrier(GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT);
 
-    // Render with the current texture, with no marker or frame
-    bool drawFrame = _drawFrame;
-    bool displayCalibration = _displayCalibration;
-    _drawFrame = _displayCalibration = false;
-    render();
-    _drawFrame = drawFrame;
-    _displayCalibration = displayCalibration;
+    // Draw the primitive IDs of all objects in a single pass. This is done directly
+    // in the output framebuffer, as multisampling would mix the IDs
+    auto renderSize = getRenderSize();
+    glViewport(0, 0, renderSize.x, renderSize.y);
+    glEnable(GL_DEPTH_TEST);
+    _outFbo->bindDraw();
+    glClearColor(0.0, 0.0, 0.0, 0.0);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-    // Reset the objects to their initial shader
-    int fillIndex{0};
-    for (auto& o : _objects)
-    {
-        if (o.expired())
-            continue;
-        auto obj = o.lock();
+    auto viewMatrix = computeViewMatrix();
+    auto projectionMatrix = computeProjectionMatrix();
+    for (auto& obj : objects)
+        obj->drawPrimitiveIds(*_visibilityShader, viewMatrix, projectionMatrix);
 
-        obj->setAttribute("fill", shaderFill[fillIndex]);
-        fillIndex++;
-    }
+    _outFbo->unbindDraw();
+    glDisable(GL_DEPTH_TEST);
 
-    // Update the vertices visibility based on the result
+    // Update the vertices visibility based on the result, with a single barrier for all objects
     glActiveTexture(GL_TEXTURE0);
     _outFbo->getColorTexture()->bind();
     primitiveIdShift = 0;
+    for (auto& obj : objects)
+    {
+        obj->transferVisibilityFromTexToAttr(renderSize.x, renderSize.y, primitiveIdShift);
+        primitiveIdShift += obj->getVerticesNumber() / 3;
+    }
+    _outFbo->getColorTexture()->unbind();
+    glMemoryBarrier(GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT | GL_SHADER_STORAGE_BARRIER_BIT);
+
+    // The output texture now holds the primitive IDs, so the camera has to render again
+    _inputsState.clear();
+}
+
+/*************/
+void Camera::renderBlendingDepth()
+{
+    if (!_blendingFbo)
+        _blendingFbo = make_unique<Framebuffer>(_root);
+
+    if (!_visibilityShader)
+    {
+        _visibilityShader = make_shared<Shader>();
+        _visibilityShader->setAttribute("fill", {"primitiveId"});
+    }
+
+    auto renderSize = getRenderSize();
+    if (_blendingFbo->isReleased() || _blendingFbo->getWidth() != renderSize.x || _blendingFbo->getHeight() != renderSize.y)
+        _blendingFbo->setSize(renderSize.x, renderSize.y);
+
+    // Only the depth is used, any shader writing it would do
+    glViewport(0, 0, renderSize.x, renderSize.y);
+    glEnable(GL_DEPTH_TEST);
+    _blendingFbo->bindDraw();
+    glClearColor(0.0, 0.0, 0.0, 0.0);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+    auto viewMatrix = computeViewMatrix();
+    auto projectionMatrix = computeProjectionMatrix();
     for (auto& o : _objects)
+        if (auto obj = o.lock(); obj)
+            obj->drawPrimitiveIds(*_visibilityShader, viewMatrix, projectionMatrix);
+
+    _blendingFbo->unbindDraw();
+    glDisable(GL_DEPTH_TEST);
+}
+
+/*************/
+void Camera::computeBlendingMap(const vector<shared_ptr<Camera>>& cameras)
+{
+    if (!_blendingFbo || _blendingFbo->isReleased())
+        return;
+
+    if (!_blendingAccumulateShader)
     {
-        if (o.expired())
+        _blendingAccumulateShader = make_shared<Shader>(Shader::prgCompute);
+        _blendingAccumulateShader->setAttribute("computePhase", {"accumulateBlendingWeights"});
+        _blendingNormalizeShader = make_shared<Shader>(Shader::prgCompute);
+        _blendingNormalizeShader->setAttribute("computePhase", {"normalizeBlendingWeights"});
+    }
+
+    auto size = ivec2(_blendingFbo->getWidth(), _blendingFbo->getHeight());
+    allocateBlendingMap(size);
+    auto groupsX = (size.x + SPLASH_CAMERA_BLENDING_GROUP_SIZE - 1) / SPLASH_CAMERA_BLENDING_GROUP_SIZE;
+    auto groupsY = (size.y + SPLASH_CAMERA_BLENDING_GROUP_SIZE - 1) / SPLASH_CAMERA_BLENDING_GROUP_SIZE;
+
+    // The weight of this camera and the sum of the weights of all cameras are accumulated for each pixel
+    GLuint weights{0};
+    glCreateTextures(GL_TEXTURE_2D, 1, &weights);
+    glTextureStorage2D(weights, 1, GL_RG32F, size.x, size.y);
+    glClearTexImage(weights, 0, GL_RG, GL_FLOAT, nullptr);
+
+    glBindImageTexture(0, weights, 0, GL_FALSE, 0, GL_READ_WRITE, GL_RG32F);
+    glBindTextureUnit(0, _blendingFbo->getDepthTexture()->getTexId());
+    _blendingAccumulateShader->setUniform("_inverseViewProjection", glm::mat4(inverse(computeProjectionMatrix() * computeViewMatrix())));
+    for (const auto& camera : cameras)
+    {
+        if (!camera->_blendingFbo || camera->_blendingFbo->isReleased())
             continue;
-        auto obj = o.lock();
 
-        obj->transferVisibilityFromTexToAttr(_width, _height, primitiveIdShift);
-        primitiveIdShift += obj->getVerticesNumber() / 3;
+        auto otherViewProjection = camera->computeProjectionMatrix() * camera->computeViewMatrix();
+        glBindTextureUnit(1, camera->_blendingFbo->getDepthTexture()->getTexId());
+        _blendingAccumulateShader->setUniform("_otherViewProjection", glm::mat4(otherViewProjection));
+        _blendingAccumulateShader->setUniform("_otherInverseViewProjection", glm::mat4(inverse(otherViewProjection)));
+        _blendingAccumulateShader->setUniform("_otherBlendWidth", camera->_blendWidth);
+        _blendingAccumulateShader->setUniform("_isSelf", camera.get() == this ? 1 : 0);
+        _blendingAccumulateShader->doCompute(groupsX, groupsY);
+        glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
     }
-    _outFbo->getColorTexture()->unbind();
+    glBindTextureUnit(0, 0);
+    glBindTextureUnit(1, 0);
+
+    glBindImageTexture(0, weights, 0, GL_FALSE, 0, GL_READ_ONLY, GL_RG32F);
+    glBindImageTexture(1, _blendingMap, 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_R16);
+    _blendingNormalizeShader->doCompute(groupsX, groupsY);
+    glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT | GL_TEXTURE_UPDATE_BARRIER_BIT);
+    glBindImageTexture(0, 0, 0, GL_FALSE, 0, GL_READ_ONLY, GL_RG32F);
+    glBindImageTexture(1, 0, 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_R16);
+
+    glDeleteTextures(1, &weights);
+
+    // The objects have to be drawn again with the new map
+    _inputsState.clear();
+}
+
+/*************/
+Values Camera::getBlendingMap()
+{
+    if (!_blendingMap)
+        return {};
+
+    Value::Buffer buffer(static_cast<size_t>(_blendingMapSize.x) * _blendingMapSize.y * sizeof(uint16_t));
+    glGetTextureImage(_blendingMap, 0, GL_RED, GL_UNSIGNED_SHORT, buffer.size(), buffer.data());
+    return {_blendingMapSize.x, _blendingMapSize.y, buffer};
+}
+
+/*************/
+void Camera::releaseBlendingDepth()
+{
+    if (_blendingFbo)
+        _blendingFbo->release();
+}
+
+/*************/
+void Camera::resetBlendingMap()
+{
+    if (!_blendingMap)
+        return;
+
+    glDeleteTextures(1, &_blendingMap);
+    _blendingMap = 0;
+    _blendingMapSize = ivec2(0, 0);
+    _inputsState.clear();
+}
+
+/*************/
+void Camera::allocateBlendingMap(const ivec2& size)
+{
+    if (_blendingMap && _blendingMapSize == size)
+        return;
+
+    if (_blendingMap)
+        glDeleteTextures(1, &_blendingMap);
+
+    glCreateTextures(GL_TEXTURE_2D, 1, &_blendingMap);
+    glTextureParameteri(_blendingMap, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTextureParameteri(_blendingMap, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTextureParameteri(_blendingMap, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTextureParameteri(_blendingMap, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTextureStorage2D(_blendingMap, 1, GL_R16, size.x, size.y);
+    _blendingMapSize = size;
 }
 
 /*************/
-void Camera::blendingTessellateForCurrentCamera()
+void Camera::blendingTessellateForCurrentCamera(const vector<shared_ptr<Object>>& objects)
 {
     for (auto& o : _objects)
     {
         if (o.expired())
             continue;
         auto obj = o.lock();
+        if (!objects.empty() && find(objects.begin(), objects.end(), obj) == objects.end())
+            continue;
 
         obj->tessellateForThisCamera(computeViewMatrix(), computeProjectionMatrix(), glm::radians(_fov * _width / _height), glm::radians(_fov), _blendWidth, _blendPrecision);
     }
@@ -197,118 +366,86 @@ bool Camera::doCalibration()
 
     _calibrationCalledOnce = true;
 
-    gsl_multimin_function calibrationFunc;
-    calibrationFunc.n = 9;
-    calibrationFunc.f = &Camera::calibrationCostFunc;
-    calibrationFunc.params = (void*)this;
-
     Log::get() << "Camera::" << __FUNCTION__ << " - Starting calibration..." << Log::endl;
 
-    const gsl_multimin_fminimizer_type* minimizerType = gsl_multimin_fminimizer_nmsimplex2rand;
+    // Everything the cost function needs is gathered once, so that the minimizations can run in parallel
+    CalibrationProblem problem;
+    problem.width = _width;
+    problem.height = _height;
+    problem.near = _near;
+    problem.far = _far;
+    if (operator[]("fov").isLocked())
+        problem.lockedFov = _fov;
+    if (operator[]("principalPoint").isLocked())
+        problem.lockedPrincipalPoint = dvec2(_cx, _cy);
+    for (auto& point : _calibrationPoints)
+    {
+        if (!point.isSet)
+            continue;
+
+        problem.objectPoints.emplace_back(point.world);
+        problem.imagePoints.emplace_back((point.screen.x + 1.0) / 2.0 * _width, (point.screen.y + 1.0) / 2.0 * _height);
+        problem.weights.push_back(_weightedCalibrationPoints ? point.weight : 1.0);
+    }
+
     // Variables we do not want to keep between tries
     dvec3 eyeOriginal = _eye;
 
-    double minValue = numeric_limits<double>::max();
-    vector<double> selectedValues(9);
-
-    gsl_multimin_fminimizer* minimizer;
-    minimizer = gsl_multimin_fminimizer_alloc(minimizerType, 9);
-    gsl_vector* x = gsl_vector_alloc(9);
-    gsl_vector* step = gsl_vector_alloc(9);
-    gsl_vector_set(step, 0, 10.0);
-    gsl_vector_set(step, 1, 0.1);
-    gsl_vector_set(step, 2, 0.1);
-    for (int i = 3; i < 6; ++i)
-        gsl_vector_set(step, i, 1.0);
-    for (int i = 3; i < 9; ++i)
-        gsl_vector_set(step, i, M_PI / 4.0);
-
-    // First step: find a rough estimate, quickly
+    // First step: find rough estimates, quickly, from a grid of seeds
+    vector<vector<double>> seeds;
     for (double s = 0.0; s <= 1.3; s += 0.3)
     {
         for (double t = 0.0; t <= 1.3; t += 0.3)
         {
-            gsl_vector_set(x, 0, 50.0 + ((float)rand() / RAND_MAX * 2.0 - 1.0) * 25.0);
-            gsl_vector_set(x, 1, s);
-            gsl_vector_set(x, 2, t);
+            vector<double> seed(9);
+            seed[0] = 50.0 + ((float)rand() / RAND_MAX * 2.0 - 1.0) * 25.0;
+            seed[1] = s;
+            seed[2] = t;
             for (int i = 0; i < 3; ++i)
             {
-                gsl_vector_set(x, i + 3, eyeOriginal[i]);
-                gsl_vector_set(x, i + 6, (float)rand() / RAND_MAX * M_PI * 2.0);
-            }
-
-            gsl_multimin_fminimizer_set(minimizer, &calibrationFunc, x, step);
-
-            size_t iter = 0;
-            int status = GSL_CONTINUE;
-            double localMinimum = numeric_limits<double>::max();
-            while (status == GSL_CONTINUE && iter < 1000 && localMinimum > 64.0)
-            {
-                iter++;
-                status = gsl_multimin_fminimizer_iterate(minimizer);
-                if (status)
-                {
-                    Log::get() << Log::WARNING << "Camera::" << __FUNCTION__ << " - An error has occured during minimization" << Log::endl;
-                    break;
-                }
-
-                status = gsl_multimin_test_size(minimizer->size, 1e-2);
-                localMinimum = gsl_multimin_fminimizer_minimum(minimizer);
-            }
-
-            if (localMinimum < minValue)
-            {
-                minValue = localMinimum;
-                for (int i = 0; i < 9; ++i)
-                    selectedValues[i] = gsl_vector_get(minimizer->x, i);
+                seed[i + 3] = eyeOriginal[i];
+                seed[i + 6] = (float)rand() / RAND_MAX * M_PI * 2.0;
             }
+            seeds.push_back(seed);
         }
     }
 
-    // Second step: we improve on the best result from the previous step
-    for (int index = 0; index < 8; ++index)
-    {
-        gsl_vector_set(step, 0, 1.0);
-        gsl_vector_set(step, 1, 0.05);
-        gsl_vector_set(step, 2, 0.05);
-        for (int i = 3; i < 6; ++i)
-            gsl_vector_set(step, i, 0.1);
-        for (int i = 3; i < 9; ++i)
-            gsl_vector_set(step, i, M_PI / 10.0);
-
-        for (int i = 0; i < 9; ++i)
-            gsl_vector_set(x, i, selectedValues[i]);
-
-        gsl_multimin_fminimizer_set(minimizer, &calibrationFunc, x, step);
-
-        size_t iter = 0;
-        int status = GSL_CONTINUE;
-        double localMinimum = numeric_limits<double>::max();
-        while (status == GSL_CONTINUE && iter < 10000 && localMinimum > 0.5)
+    const vector<double> roughSteps{10.0, 0.1, 0.1, M_PI / 4.0, M_PI / 4.0, M_PI / 4.0, M_PI / 4.0, M_PI / 4.0, M_PI / 4.0};
+    vector<double> seedMinimums(seeds.size());
+    ThreadPool::get().runParallel(seeds.size(), [&](unsigned int index) { seedMinimums[index] = minimizeCalibrationSimplex(problem, seeds[index], roughSteps, 1000, 64.0, 1e-2); });
+
+    // Second step: we improve on the best results from the previous step, restarting the simplex a few times
+    vector<size_t> order(seeds.size());
+    for (size_t i = 0; i < order.size(); ++i)
+        order[i] = i;
+    sort(order.begin(), order.end(), [&](size_t lhs, size_t rhs) { return seedMinimums[lhs] < seedMinimums[rhs]; });
+
+    const size_t startCount = std::clamp<size_t>(_calibrationStarts, 1, seeds.size());
+    const vector<double> fineSteps{1.0, 0.05, 0.05, M_PI / 10.0, M_PI / 10.0, M_PI / 10.0, M_PI / 10.0, M_PI / 10.0, M_PI / 10.0};
+    vector<double> startMinimums(startCount);
+    vector<vector<double>> startValues(startCount);
+    ThreadPool::get().runParallel(startCount, [&](unsigned int index) {
+        startMinimums[index] = seedMinimums[order[index]];
+        startValues[index] = seeds[order[index]];
+        for (int restart = 0; restart < 8; ++restart)
         {
-            iter++;
-            status = gsl_multimin_fminimizer_iterate(minimizer);
-            if (status)
+            auto values = startValues[index];
+            auto localMinimum = minimizeCalibrationSimplex(problem, values, fineSteps, 10000, 0.5, 1e-7);
+            if (localMinimum < startMinimums[index])
             {
-                Log::get() << Log::WARNING << "Camera::" << __FUNCTION__ << " - An error has occured during minimization" << Log::endl;
-                break;
+                startMinimums[index] = localMinimum;
+                startValues[index] = values;
             }
-
-            status = gsl_multimin_test_size(minimizer->size, 1e-7);
-            localMinimum = gsl_multimin_fminimizer_minimum(minimizer);
         }
+    });
 
-        if (localMinimum < minValue)
-        {
-            minValue = localMinimum;
-            for (int i = 0; i < 9; ++i)
-                selectedValues[i] = gsl_vector_get(minimizer->x, i);
-        }
-    }
+    const auto bestStart = distance(startMinimums.begin(), min_element(startMinimums.begin(), startMinimums.end()));
+    double minValue = startMinimums[bestStart];
+    vector<double> selectedValues = startValues[bestStart];
 
-    gsl_vector_free(x);
-    gsl_vector_free(step);
-    gsl_multimin_fminimizer_free(minimizer);
+    // Optional third step: Levenberg-Marquardt converges to the exact local minimum of the least squares problem
+    if (_calibrationRefineLM)
+        minValue = minimizeCalibrationLM(problem, selectedValues);
 
     // If the result is good enough, apply it. Otherwise, drop!
     if (minValue > 1000.0)
@@ -410,6 +547,23 @@ void Camera::unlinkIt(const shared_ptr<GraphObject>& obj)
         _objects.erase(objIterator);
 }
 
+/*************/
+GraphObject::MemoryUsage Camera::getMemoryUsage() const
+{
+    MemoryUsage usage;
+    for (const auto* fbo : {_msFbo.get(), _outFbo.get(), _blendingFbo.get()})
+        if (fbo)
+            usage += fbo->getMemoryUsage();
+    usage.vram += static_cast<int64_t>(_blendingMapSize.x) * _blendingMapSize.y * sizeof(uint16_t);
+    return usage;
+}
+
+/*************/
+int Camera::computeLevelOfDetail(const Object& obj)
+{
+    return obj.computeLevelOfDetail(computeViewMatrix(), computeProjectionMatrix(), _height, _lodPixelSize);
+}
+
 /*************/
 Values Camera::pickVertex(float x, float y)
 {
@@ -418,7 +572,7 @@ Values Camera::pickVertex(float x, float y)
     float realY = y * _height;
 
     // Get the depth at the given point
-    auto depth = _outFbo->getDepthAt(realX, realY);
+    auto depth = _outFbo->getDepthAt(realX * _renderScale, realY * _renderScale);
     if (depth == 1.f)
         return Values();
 
@@ -454,7 +608,7 @@ Values Camera::pickFragment(float x, float y, float& fragDepth)
     float realY = y * _height;
 
     // Get the depth at the given point
-    auto depth = _outFbo->getDepthAt(realX, realY);
+    auto depth = _outFbo->getDepthAt(realX * _renderScale, realY * _renderScale);
     if (depth == 1.f)
         return Values();
 
@@ -466,6 +620,13 @@ Values Camera::pickFragment(float x, float y, float& fragDepth)
     return {point.x, point.y, point.z};
 }
 
+/*************/
+void Camera::pickFragmentAsync(float x, float y, const function<void(const Values&, float)>& callback)
+{
+    lock_guard<mutex> lock(_pickingMutex);
+    _pickingRequests.push_back({x, y, callback});
+}
+
 /*************/
 Values Camera::pickCalibrationPoint(float x, float y)
 {
@@ -529,11 +690,8 @@ Values Camera::pickVertexOrCalibrationPoint(float x, float y)
 }
 
 /*************/
-void Camera::render()
+bool Camera::prepareRender()
 {
-    // Keep the timestamp of the newest object
-    int64_t timestamp{0};
-
     if (_updateColorDepth)
     {
         _msFbo->setMultisampling(_multisample);
@@ -544,8 +702,6 @@ void Camera::render()
 
     if (_newWidth != 0 && _newHeight != 0)
     {
-        _msFbo->setSize(_newWidth, _newHeight);
-        _outFbo->setSize(_newWidth, _newHeight);
         _width = _newWidth;
         _height = _newHeight;
         _newWidth = 0;
@@ -553,19 +709,114 @@ void Camera::render()
     }
 
     if (!_msFbo || !_outFbo)
-        return;
+        return false;
 
+    // The framebuffers are smaller than the camera when the render scale is lowered
+    auto renderSize = getRenderSize();
     ImageBufferSpec spec = _msFbo->getColorTexture()->getSpec();
-    if (spec.width != _width || spec.height != _height)
+    if (static_cast<int>(spec.width) != renderSize.x || static_cast<int>(spec.height) != renderSize.y)
+    {
+        _msFbo->setSize(renderSize.x, renderSize.y);
+        _outFbo->setSize(renderSize.x, renderSize.y);
+    }
+
+    // Blending maps received from the master Scene are uploaded here, as the context is current
+    {
+        lock_guard<mutex> lock(_blendingMapMutex);
+        if (!_receivedBlendingMap.empty())
+        {
+            auto size = ivec2(_receivedBlendingMap[0].as<int>(), _receivedBlendingMap[1].as<int>());
+            const auto& buffer = _receivedBlendingMap[2].as<Value::Buffer>();
+            if (size.x > 0 && size.y > 0 && buffer.size() == static_cast<size_t>(size.x) * size.y * sizeof(uint16_t))
+            {
+                allocateBlendingMap(size);
+                glTextureSubImage2D(_blendingMap, 0, 0, 0, size.x, size.y, GL_RED, GL_UNSIGNED_SHORT, buffer.data());
+                _inputsState.clear();
+            }
+            else
+            {
+                resetBlendingMap();
+            }
+            _receivedBlendingMap.clear();
+        }
+    }
+
+    // Nothing to do if neither the camera nor the objects changed, except when displaying calibration helpers
+    vector<int64_t> inputsState{static_cast<int64_t>(getAttributesVersion()), static_cast<int64_t>(renderSize.x), static_cast<int64_t>(renderSize.y)};
+    for (const auto& o : _objects)
     {
-        _msFbo->setSize(spec.width, spec.height);
-        _outFbo->setSize(spec.width, spec.height);
+        auto obj = o.lock();
+        if (!obj)
+            continue;
+        inputsState.push_back(reinterpret_cast<int64_t>(obj.get()));
+        obj->appendRenderState(inputsState);
     }
+    bool isInteractive = _drawFrame || _flashBG || _displayCalibration || _displayAllCalibrations || !_drawables.empty();
+    if (!inputsChanged(inputsState) && !isInteractive)
+        return false;
+
+    if (_bakeColorTransform)
+        updateColorTransformLUT();
 
 #ifdef DEBUG
     glGetError();
 #endif
-    glViewport(0, 0, _width, _height);
+
+    return true;
+}
+
+/*************/
+void Camera::updateColorTransformLUT()
+{
+    vec2 colorBalance = colorBalanceFromTemperature(_colorTemperature);
+
+    ColorTransform transform;
+    transform.balanceRed = colorBalance.x;
+    transform.balanceBlue = colorBalance.y;
+    transform.brightness = _brightness;
+    transform.saturation = _saturation;
+    transform.contrast = _contrast;
+    if (_colorLUT.size() == 768 && _isColorLUTActivated)
+    {
+        transform.lut.reserve(_colorLUT.size());
+        for (const auto& value : _colorLUT)
+            transform.lut.push_back(value.as<float>());
+    }
+
+    if (_colorTransformLUT && transform == _bakedColorTransform)
+        return;
+
+    if (!_colorTransformLUT)
+    {
+        glCreateTextures(GL_TEXTURE_3D, 1, &_colorTransformLUT);
+        glTextureParameteri(_colorTransformLUT, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTextureParameteri(_colorTransformLUT, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTextureParameteri(_colorTransformLUT, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTextureParameteri(_colorTransformLUT, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glTextureParameteri(_colorTransformLUT, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+        glTextureStorage3D(_colorTransformLUT, 1, GL_RGB16F, SPLASH_CAMERA_COLOR_LUT_SIZE, SPLASH_CAMERA_COLOR_LUT_SIZE, SPLASH_CAMERA_COLOR_LUT_SIZE);
+    }
+
+    auto table = transform.bake(SPLASH_CAMERA_COLOR_LUT_SIZE);
+    glTextureSubImage3D(_colorTransformLUT,
+        0,
+        0,
+        0,
+        0,
+        SPLASH_CAMERA_COLOR_LUT_SIZE,
+        SPLASH_CAMERA_COLOR_LUT_SIZE,
+        SPLASH_CAMERA_COLOR_LUT_SIZE,
+        GL_RGB,
+        GL_FLOAT,
+        table.data());
+    _bakedColorTransform = std::move(transform);
+}
+
+/*************/
+void Camera::bindRenderTarget()
+{
+    auto renderSize = getRenderSize();
+    glViewport(0, 0, renderSize.x, renderSize.y);
     glEnable(GL_DEPTH_TEST);
 
     if (_multisample)
@@ -575,10 +826,33 @@ void Camera::render()
 
     if (_drawFrame)
     {
+        glEnable(GL_SCISSOR_TEST);
+        glScissor(SCISSOR_WIDTH, SCISSOR_WIDTH, renderSize.x - SCISSOR_WIDTH * 2, renderSize.y - SCISSOR_WIDTH * 2);
+    }
+}
+
+/*************/
+void Camera::unbindRenderTarget()
+{
+    if (_drawFrame)
+        glDisable(GL_SCISSOR_TEST);
+    glDisable(GL_DEPTH_TEST);
+
+    if (_multisample)
+        _msFbo->unbindDraw();
+    else
+        _outFbo->unbindDraw();
+}
+
+/*************/
+void Camera::clearRenderTarget()
+{
+    if (_drawFrame)
+    {
+        glDisable(GL_SCISSOR_TEST);
         glClearColor(1.0, 0.5, 0.0, 1.0);
         glClear(GL_COLOR_BUFFER_BIT);
         glEnable(GL_SCISSOR_TEST);
-        glScissor(SCISSOR_WIDTH, SCISSOR_WIDTH, _width - SCISSOR_WIDTH * 2, _height - SCISSOR_WIDTH * 2);
     }
 
     if (_flashBG)
@@ -586,186 +860,400 @@ void Camera::render()
     else
         glClearColor(0.0, 0.0, 0.0, 0.0);
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+}
 
-    if (!_hidden)
+/*************/
+void Camera::recordDrawList()
+{
+    _drawList.clear();
+    if (_hidden)
+        return;
+
+    vector<shared_ptr<Object>> objects;
+    for (const auto& o : _objects)
+        if (auto obj = o.lock(); obj)
+            objects.push_back(obj);
+    sortByDrawState(objects);
+
+    auto viewMatrix = computeViewMatrix();
+    auto projectionMatrix = computeProjectionMatrix();
+
+    _drawList.resize(objects.size());
+    for (uint32_t i = 0; i < objects.size(); ++i)
     {
-        // Draw the objects
-        for (auto& o : _objects)
-        {
-            auto obj = o.lock();
-            if (!obj)
-                continue;
+        auto& item = _drawList[i];
+        item.object = objects[i];
+        item.levelOfDetail = objects[i]->computeLevelOfDetail(viewMatrix, projectionMatrix, _height, _lodPixelSize);
+        // Objects entirely out of the view are not drawn at all, and only the visible parts of the others are
+        if (_frustumCulling)
+            item.visible = objects[i]->computeVisibleRanges(viewMatrix, projectionMatrix, item.firsts, item.counts);
+    }
+}
 
-            timestamp = std::max(timestamp, obj->getTimestamp());
-            obj->activate();
+/*************/
+void Camera::drawObject(Object& obj, Shader& shader, const DrawItem& item)
+{
+    if (!item.visible)
+        return;
 
-            auto objShader = obj->getShader();
-            if (!objShader)
-                continue;
+    auto viewMatrix = computeViewMatrix();
+    auto projectionMatrix = computeProjectionMatrix();
 
-            vec2 colorBalance = colorBalanceFromTemperature(_colorTemperature);
-            objShader->setAttribute("uniform", {"_wireframeColor", _wireframeColor.x, _wireframeColor.y, _wireframeColor.z, _wireframeColor.w});
-            objShader->setAttribute("uniform", {"_cameraAttributes", _blendWidth, _brightness, _saturation, _contrast});
-            objShader->setAttribute("uniform", {"_fovAndColorBalance", _fov * _width / _height * M_PI / 180.0, _fov * M_PI / 180.0, colorBalance.x, colorBalance.y});
-            objShader->setAttribute("uniform", {"_showCameraCount", (int)_showCameraCount});
-            if (_colorLUT.size() == 768 && _isColorLUTActivated)
-            {
-                objShader->setAttribute("uniform", {"_colorLUT", _colorLUT});
-                objShader->setAttribute("uniform", {"_isColorLUT", 1});
-
-                Values m(10);
-                m[0] = "_colorMixMatrix";
-                for (int u = 0; u < 3; ++u)
-                    for (int v = 0; v < 3; ++v)
-                        m[u * 3 + v + 1] = _colorMixMatrix[u][v];
-                objShader->setAttribute("uniform", m);
-            }
-            else
-            {
-                objShader->setAttribute("uniform", {"_isColorLUT", 0});
-            }
+    vec2 colorBalance = colorBalanceFromTemperature(_colorTemperature);
+    shader.setUniform("_wireframeColor", glm::vec4(_wireframeColor));
+    shader.setUniform("_cameraAttributes", glm::vec4(_blendWidth, _brightness, _saturation, _contrast));
+    shader.setUniform("_fovAndColorBalance", glm::vec4(_fov * _width / _height * M_PI / 180.0, _fov * M_PI / 180.0, colorBalance.x, colorBalance.y));
+    shader.setUniform("_showCameraCount", static_cast<int>(_showCameraCount));
+    if (_blendingMap)
+    {
+        auto renderSize = getRenderSize();
+        glBindTextureUnit(SPLASH_CAMERA_BLENDING_MAP_UNIT, _blendingMap);
+        shader.setUniform("_isBlendingMap", 1);
+        shader.setUniform("_blendingMapScale", glm::vec2(1.f / renderSize.x, 1.f / renderSize.y));
+    }
+    else
+    {
+        shader.setUniform("_isBlendingMap", 0);
+    }
+    if (_bakeColorTransform && _colorTransformLUT)
+    {
+        // The whole transform is in the 3D lookup table, the per channel one is not needed
+        glBindTextureUnit(SPLASH_CAMERA_COLOR_LUT_UNIT, _colorTransformLUT);
+        shader.setUniform("_isColorTransformLUT", 1);
+        shader.setUniform("_isColorLUT", 0);
+    }
+    else if (_colorLUT.size() == 768 && _isColorLUTActivated)
+    {
+        shader.setUniform("_isColorTransformLUT", 0);
+        shader.setAttribute(uniformAttributeId, {"_colorLUT", _colorLUT});
+        shader.setUniform("_isColorLUT", 1);
+        shader.setUniform("_colorMixMatrix", _colorMixMatrix);
+    }
+    else
+    {
+        shader.setUniform("_isColorTransformLUT", 0);
+        shader.setUniform("_isColorLUT", 0);
+    }
 
-            obj->setViewProjectionMatrix(computeViewMatrix(), computeProjectionMatrix());
-            obj->draw();
-            obj->deactivate();
-        }
+    obj.setDrawRanges(item.firsts, item.counts);
+    obj.setViewProjectionMatrix(viewMatrix, projectionMatrix);
+    obj.draw();
+}
 
-        auto viewMatrix = computeViewMatrix();
-        auto projectionMatrix = computeProjectionMatrix();
+/*************/
+void Camera::drawHelpers()
+{
+    auto viewMatrix = computeViewMatrix();
+    auto projectionMatrix = computeProjectionMatrix();
 
-        auto scene = dynamic_cast<Scene*>(_root);
-        assert(scene != nullptr);
+    auto scene = dynamic_cast<Scene*>(_root);
+    assert(scene != nullptr);
 
-        // Draw the calibrations points of all the cameras
-        if (_displayAllCalibrations)
+    // Draw the calibrations points of all the cameras
+    if (_displayAllCalibrations)
+    {
+        for (auto& objWeakPtr : _objects)
         {
-            for (auto& objWeakPtr : _objects)
-            {
-                auto object = objWeakPtr.lock();
-                auto points = object->getCalibrationPoints();
+            auto object = objWeakPtr.lock();
+            auto points = object->getCalibrationPoints();
 
-                auto worldMarker = scene->getObjectLibrary().getModel("3d_marker");
-                if (worldMarker != nullptr)
+            auto worldMarker = scene->getObjectLibrary().getModel("3d_marker");
+            if (worldMarker != nullptr)
+            {
+                for (auto& point : points)
                 {
-                    for (auto& point : points)
-                    {
-                        glm::dvec4 transformedPoint = projectionMatrix * viewMatrix * glm::dvec4(point.x, point.y, point.z, 1.0);
-                        worldMarker->setAttribute("scale", {WORLDMARKER_SCALE * 0.66 * std::max(transformedPoint.z, 1.0) * _fov});
-                        worldMarker->setAttribute("position", {point.x, point.y, point.z});
-                        worldMarker->setAttribute("color", OBJECT_MARKER);
-
-                        worldMarker->activate();
-                        worldMarker->setViewProjectionMatrix(viewMatrix, projectionMatrix);
-                        worldMarker->draw();
-                        worldMarker->deactivate();
-                    }
+                    glm::dvec4 transformedPoint = projectionMatrix * viewMatrix * glm::dvec4(point.x, point.y, point.z, 1.0);
+                    worldMarker->setAttribute(scaleAttributeId, {WORLDMARKER_SCALE * 0.66 * std::max(transformedPoint.z, 1.0) * _fov});
+                    worldMarker->setAttribute(positionAttributeId, {point.x, point.y, point.z});
+                    worldMarker->setAttribute(colorAttributeId, OBJECT_MARKER);
+
+                    worldMarker->activate();
+                    worldMarker->setViewProjectionMatrix(viewMatrix, projectionMatrix);
+                    worldMarker->draw();
+                    worldMarker->deactivate();
                 }
             }
         }
+    }
 
-        // Draw the calibration points
-        if (_displayCalibration)
+    // Draw the calibration points
+    if (_displayCalibration)
+    {
+        auto worldMarker = scene->getObjectLibrary().getModel("3d_marker");
+        auto screenMarker = scene->getObjectLibrary().getModel("2d_marker");
+        if (worldMarker != nullptr && screenMarker != nullptr)
         {
-            auto worldMarker = scene->getObjectLibrary().getModel("3d_marker");
-            auto screenMarker = scene->getObjectLibrary().getModel("2d_marker");
-            if (worldMarker != nullptr && screenMarker != nullptr)
+            for (uint32_t i = 0; i < _calibrationPoints.size(); ++i)
             {
-                for (uint32_t i = 0; i < _calibrationPoints.size(); ++i)
+                auto& point = _calibrationPoints[i];
+
+                worldMarker->setAttribute(positionAttributeId, {point.world.x, point.world.y, point.world.z});
+                glm::dvec4 transformedPoint = projectionMatrix * viewMatrix * glm::dvec4(point.world.x, point.world.y, point.world.z, 1.0);
+                worldMarker->setAttribute(scaleAttributeId, {WORLDMARKER_SCALE * std::max(transformedPoint.z, 1.0) * _fov});
+                if (_selectedCalibrationPoint == static_cast<int>(i))
+                    worldMarker->setAttribute(colorAttributeId, MARKER_SELECTED);
+                else if (point.isSet)
+                    worldMarker->setAttribute(colorAttributeId, MARKER_SET);
+                else
+                    worldMarker->setAttribute(colorAttributeId, MARKER_ADDED);
+
+                worldMarker->activate();
+                worldMarker->setViewProjectionMatrix(viewMatrix, projectionMatrix);
+                worldMarker->draw();
+                worldMarker->deactivate();
+
+                if ((point.isSet && _selectedCalibrationPoint == static_cast<int>(i)) || _showAllCalibrationPoints) // Draw the target position on screen as well
                 {
-                    auto& point = _calibrationPoints[i];
 
-                    worldMarker->setAttribute("position", {point.world.x, point.world.y, point.world.z});
-                    glm::dvec4 transformedPoint = projectionMatrix * viewMatrix * glm::dvec4(point.world.x, point.world.y, point.world.z, 1.0);
-                    worldMarker->setAttribute("scale", {WORLDMARKER_SCALE * std::max(transformedPoint.z, 1.0) * _fov});
+                    screenMarker->setAttribute(positionAttributeId, {point.screen.x, point.screen.y, 0.f});
+                    screenMarker->setAttribute(scaleAttributeId, {SCREENMARKER_SCALE});
                     if (_selectedCalibrationPoint == static_cast<int>(i))
-                        worldMarker->setAttribute("color", MARKER_SELECTED);
-                    else if (point.isSet)
-                        worldMarker->setAttribute("color", MARKER_SET);
+                        screenMarker->setAttribute(colorAttributeId, SCREEN_MARKER_SELECTED);
                     else
-                        worldMarker->setAttribute("color", MARKER_ADDED);
-
-                    worldMarker->activate();
-                    worldMarker->setViewProjectionMatrix(viewMatrix, projectionMatrix);
-                    worldMarker->draw();
-                    worldMarker->deactivate();
-
-                    if ((point.isSet && _selectedCalibrationPoint == static_cast<int>(i)) || _showAllCalibrationPoints) // Draw the target position on screen as well
-                    {
+                        screenMarker->setAttribute(colorAttributeId, SCREEN_MARKER_SET);
 
-                        screenMarker->setAttribute("position", {point.screen.x, point.screen.y, 0.f});
-                        screenMarker->setAttribute("scale", {SCREENMARKER_SCALE});
-                        if (_selectedCalibrationPoint == static_cast<int>(i))
-                            screenMarker->setAttribute("color", SCREEN_MARKER_SELECTED);
-                        else
-                            screenMarker->setAttribute("color", SCREEN_MARKER_SET);
-
-                        screenMarker->activate();
-                        screenMarker->setViewProjectionMatrix(dmat4(1.f), dmat4(1.f));
-                        screenMarker->draw();
-                        screenMarker->deactivate();
-                    }
+                    screenMarker->activate();
+                    screenMarker->setViewProjectionMatrix(dmat4(1.f), dmat4(1.f));
+                    screenMarker->draw();
+                    screenMarker->deactivate();
                 }
             }
         }
+    }
 
-        // Draw the additionals objects
-        for (auto& object : _drawables)
+    // Draw the additionals objects
+    for (auto& object : _drawables)
+    {
+        auto model = scene->getObjectLibrary().getModel(object.model);
+        if (model != nullptr)
         {
-            auto model = scene->getObjectLibrary().getModel(object.model);
-            if (model != nullptr)
-            {
-                auto rtMatrix = glm::inverse(object.rtMatrix);
+            auto rtMatrix = glm::inverse(object.rtMatrix);
 
-                auto position = glm::column(rtMatrix, 3);
-                glm::dvec4 transformedPoint = projectionMatrix * viewMatrix * position;
+            auto position = glm::column(rtMatrix, 3);
+            glm::dvec4 transformedPoint = projectionMatrix * viewMatrix * position;
 
-                model->setAttribute("scale", {0.01 * std::max(transformedPoint.z, 1.0) * _fov});
-                model->setAttribute("color", DEFAULT_COLOR);
-                model->setModelMatrix(rtMatrix);
+            model->setAttribute(scaleAttributeId, {0.01 * std::max(transformedPoint.z, 1.0) * _fov});
+            model->setAttribute(colorAttributeId, DEFAULT_COLOR);
+            model->setModelMatrix(rtMatrix);
 
-                model->activate();
-                model->setViewProjectionMatrix(viewMatrix, projectionMatrix);
-                model->draw();
-                model->deactivate();
-            }
+            model->activate();
+            model->setViewProjectionMatrix(viewMatrix, projectionMatrix);
+            model->draw();
+            model->deactivate();
         }
-        _drawables.clear();
     }
+    _drawables.clear();
+}
 
-    if (_drawFrame)
-        glDisable(GL_SCISSOR_TEST);
-    glDisable(GL_DEPTH_TEST);
+/*************/
+void Camera::finishRender(int64_t timestamp)
+{
+    unbindRenderTarget();
+
+    // The objects are not held longer than needed
+    _drawList.clear();
 
     // Blit the result to resolve the multisampling
     if (_multisample)
-    {
-        _msFbo->unbindDraw();
         Framebuffer::blit(*_msFbo, *_outFbo);
-    }
-    else
+
+    // Read the depth for the picking requests, with the matrices used for this render
     {
-        _outFbo->unbindDraw();
+        lock_guard<mutex> lock(_pickingMutex);
+        if (!_pickingRequests.empty())
+        {
+            auto viewMatrix = lookAt(_eye, _target, _up);
+            auto projectionMatrix = computeProjectionMatrix();
+            auto viewport = dvec4(0, 0, _width, _height);
+            for (const auto& request : _pickingRequests)
+            {
+                // Convert the normalized coordinates ([0, 1]) to pixel coordinates
+                float realX = request.x * _width;
+                float realY = request.y * _height;
+                _outFbo->getDepthAtAsync(realX * _renderScale, realY * _renderScale, [=, callback = request.callback](float depth) {
+                    if (depth == 1.f)
+                    {
+                        callback({}, 0.f);
+                        return;
+                    }
+
+                    dvec3 point = unProject(dvec3(realX, realY, depth), viewMatrix, projectionMatrix, viewport);
+                    auto fragDepth = static_cast<float>((viewMatrix * dvec4(point.x, point.y, point.z, 1.0)).z);
+                    callback({point.x, point.y, point.z}, fragDepth);
+                });
+            }
+            _pickingRequests.clear();
+        }
     }
+    _outFbo->processDepthReads();
 
     if (_grabMipmapLevel >= 0)
     {
         auto colorTexture = _outFbo->getColorTexture();
         colorTexture->generateMipmap();
-        _mipmapBuffer = colorTexture->grabMipmap(_grabMipmapLevel).getRawBuffer();
-        auto spec = colorTexture->getSpec();
-        _mipmapBufferSpec = {spec.width, spec.height, spec.channels, spec.bpp, spec.format};
+        // The grab is read back asynchronously, the buffer holds the latest completed one
+        if (ImageBuffer mipmap; colorTexture->grabMipmapAsync(_grabMipmapLevel, mipmap))
+        {
+            _mipmapBuffer = mipmap.getRawBuffer();
+            auto spec = colorTexture->getSpec();
+            _mipmapBufferSpec = {spec.width, spec.height, spec.channels, spec.bpp, spec.format};
+        }
     }
 
     // Set the timestamp for the output texture
     _outFbo->getColorTexture()->setTimestamp(timestamp);
+    _outFbo->getColorTexture()->setContentUpdated();
 
 #ifdef DEBUG
     GLenum error = glGetError();
     if (error)
         Log::get() << Log::WARNING << _type << "::" << __FUNCTION__ << " - Error while rendering the camera: " << error << Log::endl;
 #endif
+}
+
+/*************/
+void Camera::render()
+{
+    if (!prepareRender())
+        return;
+
+    bindRenderTarget();
+    clearRenderTarget();
+
+    // Keep the timestamp of the newest object
+    int64_t timestamp{0};
+
+    if (!_hidden)
+    {
+        recordDrawList();
+
+        // Draw the objects
+        for (const auto& item : _drawList)
+        {
+            auto& obj = item.object;
+            timestamp = std::max(timestamp, obj->getTimestamp());
+            obj->setLevelOfDetail(item.levelOfDetail);
+            obj->activate();
 
-    return;
+            auto objShader = obj->getShader();
+            if (!objShader)
+                continue;
+
+            drawObject(*obj, *objShader, item);
+            obj->deactivate();
+        }
+
+        drawHelpers();
+    }
+
+    finishRender(timestamp);
+}
+
+/*************/
+void Camera::renderBatch(const pmr::vector<shared_ptr<Camera>>& cameras)
+{
+    // Temporaries are allocated from the same resource as the cameras list
+    auto resource = cameras.get_allocator().resource();
+    pmr::vector<Camera*> camerasToRender(resource);
+    for (const auto& camera : cameras)
+        if (camera->prepareRender())
+            camerasToRender.push_back(camera.get());
+
+    // Recording the draw lists only needs the CPU, so it is done for all the cameras in parallel, the GL calls being issued afterwards
+    ThreadPool::get().runParallel(camerasToRender.size(), [&](unsigned int index) { camerasToRender[index]->recordDrawList(); });
+
+    // Cameras are batched together if they draw the exact same objects
+    pmr::vector<bool> isBatched(camerasToRender.size(), false, resource);
+    for (uint32_t i = 0; i < camerasToRender.size(); ++i)
+    {
+        if (isBatched[i])
+            continue;
+
+        pmr::vector<Camera*> batch({camerasToRender[i]}, resource);
+        const auto& objects = camerasToRender[i]->_drawList;
+        const auto sameObjects = [&](const Camera* camera) {
+            return equal(objects.begin(), objects.end(), camera->_drawList.begin(), camera->_drawList.end(), [](const auto& lhs, const auto& rhs) {
+                return lhs.object == rhs.object;
+            });
+        };
+
+        if (!camerasToRender[i]->_hidden)
+        {
+            for (uint32_t j = i + 1; j < camerasToRender.size(); ++j)
+            {
+                auto camera = camerasToRender[j];
+                if (isBatched[j] || camera->_hidden)
+                    continue;
+
+                if (sameObjects(camera))
+                {
+                    batch.push_back(camera);
+                    isBatched[j] = true;
+                }
+            }
+        }
+
+        for (auto camera : batch)
+        {
+            camera->bindRenderTarget();
+            camera->clearRenderTarget();
+            camera->unbindRenderTarget();
+        }
+
+        // Each object is activated once, then only the render target and the view dependent uniforms change between cameras
+        // A hidden camera has an empty draw list, and is never batched with others
+        int64_t timestamp{0};
+        const auto& drawList = batch[0]->_drawList;
+        for (uint32_t index = 0; index < drawList.size(); ++index)
+        {
+            auto& obj = drawList[index].object;
+            timestamp = std::max(timestamp, obj->getTimestamp());
+
+            // The finest level of detail needed by the cameras of the batch is drawn
+            auto level = numeric_limits<int>::max();
+            for (auto camera : batch)
+                level = std::min(level, camera->_drawList[index].levelOfDetail);
+            obj->setLevelOfDetail(level);
+            obj->activate();
+
+            auto objShader = obj->getShader();
+            if (!objShader)
+                continue;
+
+            for (auto camera : batch)
+            {
+                camera->bindRenderTarget();
+                camera->drawObject(*obj, *objShader, camera->_drawList[index]);
+                camera->unbindRenderTarget();
+            }
+
+            obj->deactivate();
+        }
+
+        for (auto camera : batch)
+        {
+            camera->bindRenderTarget();
+            if (!camera->_hidden)
+                camera->drawHelpers();
+            camera->finishRender(timestamp);
+        }
+    }
+}
+
+/*************/
+template <typename Objects>
+void Camera::sortByDrawState(Objects& objects)
+{
+    // The depth test makes the result independent of the drawing order
+    // The sort is stable so that objects with the same state keep their link order
+    vector<pair<vector<int64_t>, shared_ptr<Object>>> drawList;
+    drawList.reserve(objects.size());
+    for (const auto& obj : objects)
+        drawList.emplace_back(obj->getDrawState(), obj);
+
+    stable_sort(drawList.begin(), drawList.end(), [](const auto& lhs, const auto& rhs) { return lhs.first < rhs.first; });
+    for (uint32_t i = 0; i < drawList.size(); ++i)
+        objects[i] = drawList[i].second;
 }
 
 /*************/
@@ -905,25 +1393,11 @@ bool Camera::setCalibrationPoint(const Values& screenPoint)
 }
 
 /*************/
-double Camera::calibrationCostFunc(const gsl_vector* v, void* params)
+double Camera::computeCalibrationResiduals(const CalibrationProblem& problem, const double* values, double* residuals)
 {
-    if (params == NULL)
-        return 0.0;
-
-    Camera& camera = *(Camera*)params;
-
-    double fov = gsl_vector_get(v, 0);
-    double cx = gsl_vector_get(v, 1);
-    double cy = gsl_vector_get(v, 2);
-
-    // Check whether the camera parameters are locked
-    if (camera["fov"].isLocked())
-        fov = camera["fov"]()[0].as<float>();
-    if (camera["principalPoint"].isLocked())
-    {
-        cx = camera["principalPoint"]()[0].as<float>();
-        cy = camera["principalPoint"]()[1].as<float>();
-    }
+    double fov = problem.lockedFov.value_or(values[0]);
+    double cx = problem.lockedPrincipalPoint ? problem.lockedPrincipalPoint->x : values[1];
+    double cy = problem.lockedPrincipalPoint ? problem.lockedPrincipalPoint->y : values[2];
 
     // Some limits for the calibration parameters
     if (fov < 4.0 || fov > 120.0 || abs(cx - 0.5) > 1.0 || abs(cy - 0.5) > 1.0)
@@ -935,8 +1409,8 @@ double Camera::calibrationCostFunc(const gsl_vector* v, void* params)
     dvec3 euler;
     for (int i = 0; i < 3; ++i)
     {
-        eye[i] = gsl_vector_get(v, i + 3);
-        euler[i] = gsl_vector_get(v, i + 6);
+        eye[i] = values[i + 3];
+        euler[i] = values[i + 6];
     }
     dmat4 rotateMat = yawPitchRoll(euler[0], euler[1], euler[2]);
     dvec4 targetTmp = rotateMat * dvec4(1.0, 0.0, 0.0, 0.0);
@@ -948,42 +1422,33 @@ double Camera::calibrationCostFunc(const gsl_vector* v, void* params)
     }
     target += eye;
 
-    vector<dvec3> objectPoints;
-    vector<dvec3> imagePoints;
-    vector<float> pointsWeight;
-    for (auto& point : camera._calibrationPoints)
-    {
-        if (!point.isSet)
-            continue;
-
-        objectPoints.emplace_back(dvec3(point.world.x, point.world.y, point.world.z));
-        imagePoints.emplace_back(dvec3((point.screen.x + 1.0) / 2.0 * camera._width, (point.screen.y + 1.0) / 2.0 * camera._height, 0.0));
-        pointsWeight.push_back(point.weight);
-    }
-
 #ifdef DEBUG
-    Log::get() << Log::DEBUGGING << "Camera::" << __FUNCTION__ << " - Values for the current iteration (fov, cx, cy): " << fov << " " << camera._width - cx << " "
-               << camera._height - cy << Log::endl;
+    Log::get() << Log::DEBUGGING << "Camera::" << __FUNCTION__ << " - Values for the current iteration (fov, cx, cy): " << fov << " " << problem.width - cx << " "
+               << problem.height - cy << Log::endl;
 #endif
 
     dmat4 lookM = lookAt(eye, target, up);
-    dmat4 projM = dmat4(getProjectionMatrix(fov, camera._near, camera._far, camera._width, camera._height, cx, cy));
-    dvec4 viewport(0, 0, camera._width, camera._height);
+    dmat4 projM = dmat4(getProjectionMatrix(fov, problem.near, problem.far, problem.width, problem.height, cx, cy));
+    dvec4 viewport(0, 0, problem.width, problem.height);
 
     // Project all the object points, and measure the distance between them and the image points
+    const auto pointCount = problem.imagePoints.size();
+    const double normalization = 1.0 / sqrt(static_cast<double>(pointCount));
     double summedDistance = 0.0;
-    for (uint32_t i = 0; i < imagePoints.size(); ++i)
+    for (uint32_t i = 0; i < pointCount; ++i)
     {
-        dvec3 projectedPoint;
-        projectedPoint = project(objectPoints[i], lookM, projM, viewport);
-        projectedPoint.z = 0.0;
+        dvec3 projectedPoint = project(problem.objectPoints[i], lookM, projM, viewport);
+        const double dx = sqrt(problem.weights[i]) * (problem.imagePoints[i].x - projectedPoint.x);
+        const double dy = problem.imagePoints[i].y - projectedPoint.y;
+        summedDistance += dx * dx + dy * dy;
 
-        if (camera._weightedCalibrationPoints)
-            summedDistance += pointsWeight[i] * pow(imagePoints[i].x - projectedPoint.x, 2.0) + pow(imagePoints[i].y - projectedPoint.y, 2.0);
-        else
-            summedDistance += pow(imagePoints[i].x - projectedPoint.x, 2.0) + pow(imagePoints[i].y - projectedPoint.y, 2.0);
+        if (residuals)
+        {
+            residuals[2 * i] = dx * normalization;
+            residuals[2 * i + 1] = dy * normalization;
+        }
     }
-    summedDistance /= imagePoints.size();
+    summedDistance /= pointCount;
 
 #ifdef DEBUG
     Log::get() << Log::DEBUGGING << "Camera::" << __FUNCTION__ << " - Actual summed distance: " << summedDistance << Log::endl;
@@ -992,6 +1457,151 @@ double Camera::calibrationCostFunc(const gsl_vector* v, void* params)
     return summedDistance;
 }
 
+/*************/
+double Camera::calibrationCostFunc(const gsl_vector* v, void* params)
+{
+    if (params == NULL)
+        return 0.0;
+
+    const auto& problem = *static_cast<const CalibrationProblem*>(params);
+    double values[9];
+    for (int i = 0; i < 9; ++i)
+        values[i] = gsl_vector_get(v, i);
+
+    return computeCalibrationResiduals(problem, values, nullptr);
+}
+
+/*************/
+int Camera::calibrationResidualsFunc(const gsl_vector* v, void* params, gsl_vector* f)
+{
+    if (params == NULL)
+        return GSL_EINVAL;
+
+    const auto& problem = *static_cast<const CalibrationProblem*>(params);
+    double values[9];
+    for (int i = 0; i < 9; ++i)
+        values[i] = gsl_vector_get(v, i);
+
+    vector<double> residuals(2 * problem.imagePoints.size());
+    if (computeCalibrationResiduals(problem, values, residuals.data()) == numeric_limits<double>::max())
+        return GSL_EDOM;
+
+    for (size_t i = 0; i < residuals.size(); ++i)
+        gsl_vector_set(f, i, residuals[i]);
+    return GSL_SUCCESS;
+}
+
+/*************/
+double Camera::minimizeCalibrationSimplex(
+    const CalibrationProblem& problem, vector<double>& values, const vector<double>& steps, size_t maxIterations, double targetCost, double sizeTolerance)
+{
+    gsl_multimin_function calibrationFunc;
+    calibrationFunc.n = 9;
+    calibrationFunc.f = &Camera::calibrationCostFunc;
+    calibrationFunc.params = const_cast<CalibrationProblem*>(&problem);
+
+    gsl_multimin_fminimizer* minimizer = gsl_multimin_fminimizer_alloc(gsl_multimin_fminimizer_nmsimplex2rand, 9);
+    gsl_vector* x = gsl_vector_alloc(9);
+    gsl_vector* step = gsl_vector_alloc(9);
+    for (int i = 0; i < 9; ++i)
+    {
+        gsl_vector_set(x, i, values[i]);
+        gsl_vector_set(step, i, steps[i]);
+    }
+
+    gsl_multimin_fminimizer_set(minimizer, &calibrationFunc, x, step);
+
+    size_t iter = 0;
+    int status = GSL_CONTINUE;
+    double localMinimum = numeric_limits<double>::max();
+    while (status == GSL_CONTINUE && iter < maxIterations && localMinimum > targetCost)
+    {
+        iter++;
+        status = gsl_multimin_fminimizer_iterate(minimizer);
+        if (status)
+        {
+            Log::get() << Log::WARNING << "Camera::" << __FUNCTION__ << " - An error has occured during minimization" << Log::endl;
+            break;
+        }
+
+        status = gsl_multimin_test_size(minimizer->size, sizeTolerance);
+        localMinimum = gsl_multimin_fminimizer_minimum(minimizer);
+    }
+
+    for (int i = 0; i < 9; ++i)
+        values[i] = gsl_vector_get(minimizer->x, i);
+
+    gsl_vector_free(x);
+    gsl_vector_free(step);
+    gsl_multimin_fminimizer_free(minimizer);
+
+    return localMinimum;
+}
+
+/*************/
+double Camera::minimizeCalibrationLM(const CalibrationProblem& problem, vector<double>& values)
+{
+    const double initialCost = computeCalibrationResiduals(problem, values.data(), nullptr);
+    const size_t residualCount = 2 * problem.imagePoints.size();
+
+    gsl_multifit_nlinear_fdf fdf;
+    fdf.f = &Camera::calibrationResidualsFunc;
+    fdf.df = nullptr; // The Jacobian is computed with finite differences
+    fdf.fvv = nullptr;
+    fdf.n = residualCount;
+    fdf.p = 9;
+    fdf.params = const_cast<CalibrationProblem*>(&problem);
+
+    // Levenberg scaling keeps the problem well posed when some parameters are locked, and thus have no influence
+    auto parameters = gsl_multifit_nlinear_default_parameters();
+    parameters.scale = gsl_multifit_nlinear_scale_levenberg;
+
+    gsl_multifit_nlinear_workspace* workspace = gsl_multifit_nlinear_alloc(gsl_multifit_nlinear_trust, &parameters, residualCount, 9);
+    gsl_vector* x = gsl_vector_alloc(9);
+    for (int i = 0; i < 9; ++i)
+        gsl_vector_set(x, i, values[i]);
+
+    int info = 0;
+    gsl_multifit_nlinear_init(x, &fdf, workspace);
+    int status = gsl_multifit_nlinear_driver(200, 1e-10, 1e-10, 1e-10, nullptr, nullptr, &info, workspace);
+
+    vector<double> refinedValues(9);
+    for (int i = 0; i < 9; ++i)
+        refinedValues[i] = gsl_vector_get(gsl_multifit_nlinear_position(workspace), i);
+
+    gsl_vector_free(x);
+    gsl_multifit_nlinear_free(workspace);
+
+    const double refinedCost = computeCalibrationResiduals(problem, refinedValues.data(), nullptr);
+    if (status != GSL_SUCCESS && status != GSL_EMAXITER)
+    {
+        Log::get() << Log::WARNING << "Camera::" << __FUNCTION__ << " - Levenberg-Marquardt refinement failed: " << string(gsl_strerror(status)) << Log::endl;
+        return initialCost;
+    }
+    if (refinedCost >= initialCost)
+        return initialCost;
+
+    values = refinedValues;
+    return refinedCost;
+}
+
+/*************/
+vector<double> Camera::getBlendingState()
+{
+    vector<double> state;
+
+    auto viewMatrix = computeViewMatrix();
+    auto projectionMatrix = computeProjectionMatrix();
+    state.insert(state.end(), value_ptr(viewMatrix), value_ptr(viewMatrix) + 16);
+    state.insert(state.end(), value_ptr(projectionMatrix), value_ptr(projectionMatrix) + 16);
+    state.push_back(_blendWidth);
+    state.push_back(_blendPrecision);
+    state.push_back(_width);
+    state.push_back(_height);
+
+    return state;
+}
+
 /*************/
 dmat4 Camera::computeProjectionMatrix()
 {
@@ -1013,6 +1623,38 @@ dmat4 Camera::computeViewMatrix()
     return viewMatrix;
 }
 
+/*************/
+glm::ivec2 Camera::getRenderSize() const
+{
+    return glm::ivec2(std::max(1, static_cast<int>(_width * _renderScale)), std::max(1, static_cast<int>(_height * _renderScale)));
+}
+
+/*************/
+void Camera::setRenderScale(float scale)
+{
+    _renderScale = std::clamp(scale, 0.1f, 1.f);
+}
+
+/*************/
+unordered_map<string, Object::SampledUVRegion> Camera::computeSampledUVRegions()
+{
+    unordered_map<string, Object::SampledUVRegion> regions;
+    auto viewMatrix = computeViewMatrix();
+    auto projectionMatrix = computeProjectionMatrix();
+    auto viewportSize = glm::dvec2(getRenderSize());
+
+    for (const auto& weakObject : _objects)
+    {
+        auto object = weakObject.lock();
+        if (!object)
+            continue;
+        if (auto region = object->computeSampledUVRegion(viewMatrix, projectionMatrix, viewportSize); region)
+            regions[object->getName()] = region.value();
+    }
+
+    return regions;
+}
+
 /*************/
 void Camera::loadDefaultModels()
 {
@@ -1279,6 +1921,24 @@ void Camera::registerAttributes()
     });
     setAttributeDescription("calibrate", "Compute calibration with the current calibration points");
 
+    addAttribute("calibrationStarts",
+        [&](const Values& args) {
+            _calibrationStarts = std::max(1, args[0].as<int>());
+            return true;
+        },
+        [&]() -> Values { return {_calibrationStarts}; },
+        {'i'});
+    setAttributeDescription("calibrationStarts", "Number of rough calibration estimates refined in parallel, increase to avoid getting stuck in local minima");
+
+    addAttribute("calibrationRefineLM",
+        [&](const Values& args) {
+            _calibrationRefineLM = args[0].as<bool>();
+            return true;
+        },
+        [&]() -> Values { return {_calibrationRefineLM}; },
+        {'b'});
+    setAttributeDescription("calibrationRefineLM", "If set to true, the calibration is refined with a Levenberg-Marquardt minimization");
+
     addAttribute("addCalibrationPoint",
         [&](const Values& args) {
             addCalibrationPoint({args[0].as<float>(), args[1].as<float>(), args[2].as<float>()});
@@ -1429,6 +2089,19 @@ void Camera::registerAttributes()
         {'r'});
     setAttributeDescription("blendPrecision", "Set the blending precision");
 
+    addAttribute(
+        "blendingMap",
+        [&](const Values& args) {
+            // The master Scene computes the maps itself
+            if (auto scene = dynamic_cast<Scene*>(_root); scene && scene->isMaster())
+                return true;
+            lock_guard<mutex> lock(_blendingMapMutex);
+            _receivedBlendingMap = args;
+            return true;
+        },
+        {'i', 'i', 'd'});
+    setAttributeDescription("blendingMap", "Set the image space blending map computed by the master Scene, as its width, height and 16 bits values");
+
     addAttribute("clearColor", [&](const Values& args) {
         if (args.size() == 0)
             _clearColor = CAMERA_FLASH_COLOR;
@@ -1504,6 +2177,17 @@ void Camera::registerAttributes()
         {'i'});
     setAttributeDescription("activateColorLUT", "Activate the color lookup table. If set to 2, switches its status");
 
+    addAttribute(
+        "bakeColorTransform",
+        [&](const Values& args) {
+            _bakeColorTransform = args[0].as<bool>();
+            return true;
+        },
+        [&]() -> Values { return {_bakeColorTransform}; },
+        {'b'});
+    setAttributeDescription("bakeColorTransform",
+        "If true, the color balance, brightness, saturation, contrast and lookup table are baked into a single 3D lookup table, updated only when one of them changes");
+
     addAttribute(
         "colorMixMatrix",
         [&](const Values& args) {
@@ -1601,6 +2285,27 @@ void Camera::registerAttributes()
         {'b'});
     setAttributeDescription("showCameraCount", "If true, shows visually the camera count, encoded in binary in RGB (blending has to be activated)");
 
+    addAttribute(
+        "frustumCulling",
+        [&](const Values& args) {
+            _frustumCulling = args[0].as<bool>();
+            return true;
+        },
+        [&]() -> Values { return {_frustumCulling}; },
+        {'b'});
+    setAttributeDescription("frustumCulling", "If true, objects and parts of objects out of the view are not drawn. Disable it for shaders moving the vertices");
+
+    addAttribute(
+        "lodPixelSize",
+        [&](const Values& args) {
+            _lodPixelSize = args[0].as<float>();
+            return true;
+        },
+        [&]() -> Values { return {_lodPixelSize}; },
+        {'r'});
+    setAttributeDescription("lodPixelSize",
+        "Target length of the projected triangle edges in pixels, for meshes with levels of detail. The coarsest level with edges up to this length is drawn. Set to 0 to always draw the full resolution");
+
     //
     // Mipmap capture
     addAttribute(
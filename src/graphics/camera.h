@@ -28,6 +28,9 @@
 #include <functional>
 #include <list>
 #include <memory>
+#include <memory_resource>
+#include <mutex>
+#include <optional>
 #include <string>
 #include <unordered_map>
 #include <utility>
@@ -38,6 +41,7 @@
 #include <glm/gtx/euler_angles.hpp>
 #include <gsl/gsl_blas.h>
 #include <gsl/gsl_deriv.h>
+#include <gsl/gsl_multifit_nlinear.h>
 #include <gsl/gsl_multimin.h>
 
 #include "./core/constants.h"
@@ -50,6 +54,7 @@
 #include "./graphics/texture_image.h"
 #include "./image/image.h"
 #include "./utils/cgutils.h"
+#include "./utils/color_transform.h"
 
 namespace Splash
 {
@@ -84,19 +89,58 @@ class Camera : public GraphObject
 
     /**
      * \brief Tessellate the objects for this camera
+     * \param objects Objects to tessellate, all objects seen by this camera if empty
      */
-    void blendingTessellateForCurrentCamera();
+    void blendingTessellateForCurrentCamera(const std::vector<std::shared_ptr<Object>>& objects = {});
 
     /**
      * \brief Compute the blending for all objects seen by this camera
+     * \param objects Objects to compute the blending for, all objects seen by this camera if empty
      */
-    void computeBlendingContribution();
+    void computeBlendingContribution(const std::vector<std::shared_ptr<Object>>& objects = {});
 
     /**
      * \brief Compute the vertex visibility for all objects visible by this camera
      */
     void computeVertexVisibility();
 
+    /**
+     * \brief Render the depth of the objects seen by this camera, for the image space blending
+     * The depth is kept until releaseBlendingDepth() is called, as the other cameras need it to compute their blending map
+     */
+    void renderBlendingDepth();
+
+    /**
+     * \brief Compute the blending map of this camera in image space
+     * Each pixel gets the ratio of the weight of this camera to the sum of the weights of the cameras seeing
+     * the same point. The cost only depends on the resolution of the cameras, not on the density of the meshes.
+     * \param cameras Cameras contributing to the blending, including this one, whose blending depth has been rendered
+     */
+    void computeBlendingMap(const std::vector<std::shared_ptr<Camera>>& cameras);
+
+    /**
+     * \brief Read back the blending map, to send it to the Scene rendering this camera
+     * \return Return the width, height and 16 bits values of the map, or nothing if there is no map
+     */
+    Values getBlendingMap();
+
+    /**
+     * \brief Release the memory held by the depth rendered for the blending
+     */
+    void releaseBlendingDepth();
+
+    /**
+     * \brief Drop the blending map
+     */
+    void resetBlendingMap();
+
+    /**
+     * \brief Get the state of the camera which the blending depends on
+     * This is used by the blender to detect which cameras moved since the last blending computation
+     * \return Return the state as a list of values
+     */
+    std::vector<double> getBlendingState();
+
     /**
      * \brief Get the projection matrix
      * \return Return the projection matrix
@@ -109,6 +153,12 @@ class Camera : public GraphObject
      */
     glm::dmat4 computeViewMatrix();
 
+    /**
+     * \brief Compute the UV region of each object seen by the camera, and the texture resolution it needs
+     * \return Return the sampled regions, by object name
+     */
+    std::unordered_map<std::string, Object::SampledUVRegion> computeSampledUVRegions();
+
     /**
      * \brief Compute the calibration given the calibration points
      * \return Return true if all went well
@@ -140,6 +190,19 @@ class Camera : public GraphObject
      */
     virtual int64_t getTimestamp() const final { return _outFbo ? _outFbo->getColorTexture()->getTimestamp() : 0; }
 
+    /**
+     * Get the memory held by the render targets
+     * \return Return the memory usage
+     */
+    MemoryUsage getMemoryUsage() const final;
+
+    /**
+     * \brief Compute the level of detail to draw the given object with, see Object::computeLevelOfDetail
+     * \param obj Object
+     * \return Return the level of detail
+     */
+    int computeLevelOfDetail(const Object& obj);
+
     /**
      * \brief Get the coordinates of the closest vertex to the given point
      * \param x Target x coordinate
@@ -157,6 +220,16 @@ class Camera : public GraphObject
      */
     Values pickFragment(float x, float y, float& fragDepth);
 
+    /**
+     * \brief Get the coordinates of the given fragment without waiting for the GPU, see pickFragment
+     * The request is served at the end of the next render of the camera, and the callback is called
+     * from the render thread once the depth has been read back, usually a frame later.
+     * \param x Target x coordinate
+     * \param y Target y coordinate
+     * \param callback Callback receiving the world coordinates, empty if there is no fragment, and the fragment depth
+     */
+    void pickFragmentAsync(float x, float y, const std::function<void(const Values&, float)>& callback);
+
     /**
      * \brief Get the coordinates of the closest calibration point
      * \param x Target x coordinate
@@ -178,6 +251,21 @@ class Camera : public GraphObject
      */
     void render() override;
 
+    /**
+     * \brief Set the render scale, used to lower the rendering resolution when the GPU is overloaded
+     * The output texture is then smaller than the camera size, the projection is left unchanged
+     * \param scale Render scale, between 0.1 and 1
+     */
+    void setRenderScale(float scale);
+
+    /**
+     * \brief Render the given cameras, batching those which draw the same objects
+     * Each object is activated once for all the cameras of a batch, which reduces the state changes when
+     * multiple cameras share the same objects. The result is the same as calling render() for each camera.
+     * \param cameras Cameras to render
+     */
+    static void renderBatch(const std::pmr::vector<std::shared_ptr<Camera>>& cameras);
+
     /**
      * \brief Set the given calibration point. This point is then selected
      * \return Return true if the point has been added or if it already existed
@@ -224,13 +312,36 @@ class Camera : public GraphObject
     void unlinkIt(const std::shared_ptr<GraphObject>& obj) final;
 
   private:
+    // Object drawn by the camera, with the parameters computed before any GL call
+    struct DrawItem
+    {
+        std::shared_ptr<Object> object{nullptr};
+        int levelOfDetail{0};
+        bool visible{true};          //!< False if the object is entirely out of the view
+        std::vector<GLint> firsts{}; //!< Ranges of visible faces, see Object::computeVisibleRanges
+        std::vector<GLsizei> counts{};
+    };
+
     std::unique_ptr<Framebuffer> _msFbo{nullptr}, _outFbo{nullptr};
     std::vector<std::weak_ptr<Object>> _objects;
+    std::vector<DrawItem> _drawList{}; //!< Objects to draw for the current frame, sorted by draw state
+    std::shared_ptr<Shader> _visibilityShader{nullptr}; //!< Shader drawing the primitive IDs of all objects, for the visibility test
+
+    // Image space blending
+    std::unique_ptr<Framebuffer> _blendingFbo{nullptr};          //!< Depth seen by the camera, used to compute the blending maps
+    std::shared_ptr<Shader> _blendingAccumulateShader{nullptr}; //!< Shader adding the weight of a camera to the blending weights
+    std::shared_ptr<Shader> _blendingNormalizeShader{nullptr};  //!< Shader converting the blending weights to the blending map
+    GLuint _blendingMap{0};                                      //!< Blending value of each pixel, applied when drawing the objects
+    glm::ivec2 _blendingMapSize{0, 0};
+    std::mutex _blendingMapMutex{};
+    Values _receivedBlendingMap{}; //!< Blending map received from the master Scene, uploaded at the next render
 
     // Rendering parameters
     bool _drawFrame{false};
     bool _showCameraCount{false};
     bool _hidden{false};
+    bool _frustumCulling{true}; //!< If true, the objects are culled against the view frustum
+    float _lodPixelSize{2.f};   //!< Target length of the projected triangle edges when selecting the levels of detail, in pixels
     bool _flashBG{false};
     bool _render16bits{true};
     int _multisample{0};
@@ -243,15 +354,29 @@ class Camera : public GraphObject
     Value _mipmapBuffer{};
     Values _mipmapBufferSpec{};
 
+    // Fragment picking requests, served at the end of the render
+    struct PickingRequest
+    {
+        float x{0.f};
+        float y{0.f};
+        std::function<void(const Values&, float)> callback{};
+    };
+    std::mutex _pickingMutex{};
+    std::vector<PickingRequest> _pickingRequests{};
+
     // Color correction
     Values _colorLUT{0};
     bool _isColorLUTActivated{false};
     glm::mat3 _colorMixMatrix;
+    bool _bakeColorTransform{false};       //!< If true, the whole color transform is applied through a 3D lookup table
+    ColorTransform _bakedColorTransform{}; //!< Color transform currently baked into _colorTransformLUT
+    GLuint _colorTransformLUT{0};          //!< 3D lookup table texture
 
     // Camera parameters
     float _fov{35.f};                      //!< Vertical FOV
     float _width{512.f}, _height{512.f};   //!< Current width and height
     float _newWidth{0.f}, _newHeight{0.f}; //!< New width and height
+    float _renderScale{1.f};               //!< Scale of the render size relatively to the camera size
     float _near{0.1f}, _far{100.0f};       //!< Near and far parameters
     float _cx{0.5f}, _cy{0.5f};            //!< Relative position of the lens center
     glm::dvec3 _eye{1.0, 0.0, 5.0};        //!< Camera position
@@ -291,6 +416,22 @@ class Camera : public GraphObject
     std::vector<CalibrationPoint> _calibrationPoints;
     int _selectedCalibrationPoint{-1};
     float _calibrationReprojectionError{0.f};
+    int _calibrationStarts{1};        //!< Number of the best rough estimates which are refined in parallel during calibration
+    bool _calibrationRefineLM{false}; //!< If true, the calibration is finally refined with a Levenberg-Marquardt minimization
+
+    //! Calibration points and fixed parameters, gathered before the minimization so that the cost function does not access the camera
+    struct CalibrationProblem
+    {
+        std::vector<glm::dvec3> objectPoints{};
+        std::vector<glm::dvec2> imagePoints{};
+        std::vector<double> weights{};
+        double width{0.0};
+        double height{0.0};
+        double near{0.0};
+        double far{0.0};
+        std::optional<double> lockedFov{};
+        std::optional<glm::dvec2> lockedPrincipalPoint{};
+    };
 
     //! List of additional objects to draw
     struct Drawable
@@ -306,8 +447,110 @@ class Camera : public GraphObject
     };
     std::list<Drawable> _drawables;
 
-    // Function used for the calibration (camera parameters optimization)
+    /**
+     * \brief Compute the calibration residuals, as the weighted distances between the image points and the projected object points
+     * \param problem Calibration problem
+     * \param values Camera parameters: fov, principal point, eye and euler angles
+     * \param residuals If not null, set to the residuals, two per point, so that their summed square equal the returned cost
+     * \return Return the cost, or the max double value if the parameters are out of bounds
+     */
+    static double computeCalibrationResiduals(const CalibrationProblem& problem, const double* values, double* residuals);
+
+    // Functions used for the calibration (camera parameters optimization), params pointing to a CalibrationProblem
     static double calibrationCostFunc(const gsl_vector* v, void* params);
+    static int calibrationResidualsFunc(const gsl_vector* v, void* params, gsl_vector* f);
+
+    /**
+     * \brief Minimize the calibration cost with the Nelder-Mead simplex method
+     * \param problem Calibration problem
+     * \param values Camera parameters to start from, set to the minimum found
+     * \param steps Initial simplex step for each parameter
+     * \param maxIterations Maximum iteration count
+     * \param targetCost Cost under which the minimization is stopped
+     * \param sizeTolerance Simplex size under which the minimization is stopped
+     * \return Return the minimum found
+     */
+    static double minimizeCalibrationSimplex(
+        const CalibrationProblem& problem, std::vector<double>& values, const std::vector<double>& steps, size_t maxIterations, double targetCost, double sizeTolerance);
+
+    /**
+     * \brief Minimize the calibration cost with the Levenberg-Marquardt method
+     * \param problem Calibration problem
+     * \param values Camera parameters to start from, set to the minimum found if it improves the cost
+     * \return Return the cost for the resulting values
+     */
+    static double minimizeCalibrationLM(const CalibrationProblem& problem, std::vector<double>& values);
+
+    /**
+     * \brief Get the size of the framebuffers, depending on the camera size and the render scale
+     * \return Return the render size
+     */
+    glm::ivec2 getRenderSize() const;
+
+    /**
+     * \brief Update the framebuffers if needed, and check whether the camera has to be rendered
+     * \return Return true if the camera needs to be rendered
+     */
+    bool prepareRender();
+
+    /**
+     * \brief Allocate the blending map for the given size, keeping it if it already has this size
+     * \param size Map size
+     */
+    void allocateBlendingMap(const glm::ivec2& size);
+
+    /**
+     * \brief Bake the color transform into the 3D lookup table, if it changed since the last call
+     */
+    void updateColorTransformLUT();
+
+    /**
+     * \brief Bind the framebuffer to render into, and set the related GL states
+     */
+    void bindRenderTarget();
+
+    /**
+     * \brief Unbind the framebuffer and reset the GL states set by bindRenderTarget
+     */
+    void unbindRenderTarget();
+
+    /**
+     * \brief Clear the bound framebuffer
+     */
+    void clearRenderTarget();
+
+    /**
+     * \brief Sort the given objects by their draw state, see Object::getDrawState
+     * Objects sharing the same fill and textures end up next to each other, which reduces the state changes between draws
+     * \param objects Objects to sort
+     */
+    template <typename Objects>
+    static void sortByDrawState(Objects& objects);
+
+    /**
+     * \brief Record the objects to draw for the current frame into _drawList, with their level of detail and visible faces
+     * This does not call GL, so the draw lists of several cameras can be recorded in parallel
+     */
+    void recordDrawList();
+
+    /**
+     * \brief Draw the given object, which must be active, as seen by this camera
+     * \param obj Object to draw
+     * \param shader Shader of the object
+     * \param item Draw parameters recorded for the object by recordDrawList
+     */
+    void drawObject(Object& obj, Shader& shader, const DrawItem& item);
+
+    /**
+     * \brief Draw the calibration points and additional models, into the bound framebuffer
+     */
+    void drawHelpers();
+
+    /**
+     * \brief Unbind the framebuffer, resolve the multisampling and update the output texture
+     * \param timestamp Timestamp of the newest object drawn
+     */
+    void finishRender(int64_t timestamp);
 
     /**
      * \brief Load some defaults models, like the locator for calibration
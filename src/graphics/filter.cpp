@@ -2,6 +2,7 @@
 
 #include "./core/scene.h"
 #include "./graphics/camera.h"
+#include "./graphics/texture_array.h"
 #include "./graphics/texture_image.h"
 #include "./utils/cgutils.h"
 #include "./utils/log.h"
@@ -25,8 +26,9 @@ Filter::Filter(RootObject* root)
         return;
 
     _fbo = make_unique<Framebuffer>(_root);
+    _fbo->setDepthAttachment(false);
     _fbo->getColorTexture()->setAttribute("filtering", {true});
-    _fbo->setSixteenBpc(_sixteenBpc);
+    _fbo->setColorFormat(getColorFormat());
 
     // Setup the virtual screen
     _screen = make_shared<Object>(_root);
@@ -38,14 +40,21 @@ Filter::Filter(RootObject* root)
 /*************/
 void Filter::bind()
 {
-    _fbo->getColorTexture()->bind();
+    if (auto fusedInput = getFusedInput())
+        fusedInput->bind();
+    else
+        _fbo->getColorTexture()->bind();
 }
 
 /*************/
 unordered_map<string, Values> Filter::getShaderUniforms() const
 {
+    if (auto fusedInput = getFusedInput())
+        return fusedInput->getShaderUniforms();
+
     unordered_map<string, Values> uniforms;
     uniforms["size"] = {static_cast<float>(_fbo->getColorTexture()->getSpec().width), static_cast<float>(_fbo->getColorTexture()->getSpec().height)};
+    uniforms["tileRect"] = _tileRect;
     return uniforms;
 }
 
@@ -70,6 +79,18 @@ bool Filter::linkIt(const std::shared_ptr<GraphObject>& obj)
     }
     else if (dynamic_pointer_cast<Image>(obj))
     {
+        // Images set to share a texture array are sampled from their layer of it
+        Values textureArray;
+        if (obj->getAttribute("textureArray", textureArray) && !textureArray.empty() && !textureArray[0].as<string>().empty())
+        {
+            auto array = _root->createObject("texture_array", textureArray[0].as<string>()).lock();
+            auto layer = dynamic_pointer_cast<Texture_ArrayLayer>(_root->createObject("texture_array_layer", getName() + "_" + obj->getName() + "_tex").lock());
+            if (array && layer && layer->linkTo(array) && layer->linkTo(obj))
+                return linkTo(layer);
+            else
+                return false;
+        }
+
         auto tex = dynamic_pointer_cast<Texture_Image>(_root->createObject("texture_image", getName() + "_" + obj->getName() + "_tex").lock());
         if (tex->linkTo(obj))
             return linkTo(tex);
@@ -89,7 +110,10 @@ bool Filter::linkIt(const std::shared_ptr<GraphObject>& obj)
 /*************/
 void Filter::unbind()
 {
-    _fbo->getColorTexture()->unbind();
+    if (auto fusedInput = getFusedInput())
+        fusedInput->unbind();
+    else
+        _fbo->getColorTexture()->unbind();
 }
 
 /*************/
@@ -148,11 +172,45 @@ void Filter::setKeepRatio(bool keepRatio)
 /*************/
 void Filter::setSixteenBpc(bool active)
 {
-    _sixteenBpc = active;
+    _colorFormat = active ? "RGBA16" : "RGBA";
     if (!_fbo)
         return;
 
-    _fbo->setSixteenBpc(active);
+    _fbo->setColorFormat(_colorFormat);
+}
+
+/*************/
+string Filter::getColorFormat() const
+{
+    if (_colorFormat != "auto")
+        return _colorFormat;
+
+    string colorFormat = "RGB10A2";
+    for (const auto& texture : _inTextures)
+    {
+        auto texturePtr = texture.lock();
+        if (!texturePtr)
+            continue;
+
+        string inputFormat;
+        if (auto inputFilter = dynamic_pointer_cast<Filter>(texturePtr))
+        {
+            inputFormat = inputFilter->getColorFormat();
+        }
+        else
+        {
+            auto spec = texturePtr->getSpec();
+            if (spec.channels == 0 || spec.bpp / spec.channels > 8 || spec.format.find('A') != string::npos)
+                inputFormat = "RGBA16";
+        }
+
+        if (inputFormat == "RGBA16")
+            return inputFormat;
+        else if (inputFormat == "R11G11B10F")
+            colorFormat = inputFormat;
+    }
+
+    return colorFormat;
 }
 
 /*************/
@@ -182,6 +240,15 @@ void Filter::render()
         registerDefaultShaderAttributes();
     }
 
+    // A fused filter is computed by its input filter, which also holds the output, so its own output is released
+    if (auto fusedInput = getFusedInput())
+    {
+        _fbo->release();
+        _inputsState.clear();
+        _spec.timestamp = fusedInput->getTimestamp();
+        return;
+    }
+
     if (!_inTextures.empty() && !_inTextures[0].expired())
     {
         auto input = _inTextures[0].lock();
@@ -203,9 +270,25 @@ void Filter::render()
                 _fbo->setSize(_spec.width, _spec.height);
             }
         }
+
+        // A tile is filtered at its own size, the output covering the region of the image where it ends up once flipped
+        Values tileRect{0.f, 0.f, 1.f, 1.f};
+        auto inputUniforms = input->getShaderUniforms();
+        if (auto rectIt = inputUniforms.find("tileRect"); rectIt != inputUniforms.end() && rectIt->second.size() == 4)
+        {
+            tileRect = rectIt->second;
+            const auto isSet = [&](const string& uniform) { return !inputUniforms[uniform].empty() && inputUniforms[uniform][0].as<bool>(); };
+            if (isSet("flop"))
+                tileRect[0] = 1.f - tileRect[0].as<float>() - tileRect[2].as<float>();
+            if (isSet("flip"))
+                tileRect[1] = 1.f - tileRect[1].as<float>() - tileRect[3].as<float>();
+        }
+        _tileRect = tileRect;
     }
     else
     {
+        _tileRect = {0.f, 0.f, 1.f, 1.f};
+
         if (_sizeOverride[0] == -1 && _sizeOverride[1] == -1)
         {
             _sizeOverride[0] = _defaultSize[0];
@@ -220,6 +303,12 @@ void Filter::render()
         }
     }
 
+    _fbo->setColorFormat(getColorFormat());
+
+    // The output may have been released while the filter was fused
+    if (_fbo->isReleased() && _spec.width != 0 && _spec.height != 0)
+        _fbo->setSize(_spec.width, _spec.height);
+
     // Update the timestamp to the latest from all input textures
     int64_t timestamp{0};
     for (const auto& texture : _inTextures)
@@ -231,10 +320,39 @@ void Filter::render()
     }
     _spec.timestamp = timestamp;
 
+    updateFusedStages();
+
+    // Nothing to do if neither the inputs, the attributes nor the output size changed
+    vector<int64_t> inputsState{static_cast<int64_t>(getAttributesVersion()), static_cast<int64_t>(_spec.width), static_cast<int64_t>(_spec.height)};
+    for (const auto& texture : _inTextures)
+    {
+        auto texturePtr = texture.lock();
+        if (!texturePtr)
+            continue;
+        inputsState.push_back(reinterpret_cast<int64_t>(texturePtr.get()));
+        inputsState.push_back(texturePtr->getTimestamp());
+        inputsState.push_back(static_cast<int64_t>(texturePtr->getContentVersion()));
+    }
+    for (const auto& stage : _fusedStages)
+    {
+        inputsState.push_back(reinterpret_cast<int64_t>(stage));
+        inputsState.push_back(static_cast<int64_t>(stage->getAttributesVersion()));
+    }
+    if (!inputsChanged(inputsState) && !isAnimated())
+    {
+        // A consumer needing the mipmaps may have appeared since they were skipped
+        if (_mipmapsOutdated && isSampledWithMipmaps())
+        {
+            _fbo->getColorTexture()->generateMipmap();
+            _mipmapsOutdated = false;
+        }
+        return;
+    }
+
     _fbo->bindDraw();
     glViewport(0, 0, _spec.width, _spec.height);
     glClearColor(0.0, 0.0, 0.0, 0.0);
-    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    glClear(GL_COLOR_BUFFER_BIT);
 
     _screen->activate();
     updateUniforms();
@@ -243,14 +361,117 @@ void Filter::render()
 
     _fbo->unbindDraw();
 
-    _fbo->getColorTexture()->generateMipmap();
+    // Mipmaps are only generated if sampled, or up to the level to grab
+    auto colorTexture = _fbo->getColorTexture();
+    colorTexture->setContentUpdated();
+    auto isSampled = isSampledWithMipmaps();
+    colorTexture->generateMipmap(isSampled ? -1 : std::max(0, _grabMipmapLevel));
+    _mipmapsOutdated = !isSampled;
+
     if (_grabMipmapLevel >= 0)
     {
-        auto colorTexture = _fbo->getColorTexture();
-        _mipmapBuffer = colorTexture->grabMipmap(_grabMipmapLevel).getRawBuffer();
-        auto spec = colorTexture->getSpec();
-        _mipmapBufferSpec = {spec.width, spec.height, spec.channels, spec.bpp, spec.format};
+        // The grab is read back asynchronously, the buffer holds the latest completed one
+        if (ImageBuffer mipmap; colorTexture->grabMipmapAsync(_grabMipmapLevel, mipmap))
+        {
+            _mipmapBuffer = mipmap.getRawBuffer();
+            auto spec = colorTexture->getSpec();
+            _mipmapBufferSpec = {spec.width, spec.height, spec.channels, spec.bpp, spec.format};
+        }
+    }
+}
+
+/*************/
+shared_ptr<Filter> Filter::getFusedInput() const
+{
+    if (!_fusion || _inTextures.size() != 1 || _sizeOverride[0] > 0 || _sizeOverride[1] > 0 || _grabMipmapLevel >= 0)
+        return {nullptr};
+
+    auto input = dynamic_pointer_cast<Filter>(_inTextures[0].lock());
+    if (!input || !input->canFuseOutput())
+        return {nullptr};
+
+    // The input output is replaced by the fused one, so nothing else may use it
+    const auto& inputParents = input->getParents();
+    if (inputParents.size() != 1 || inputParents[0] != this)
+        return {nullptr};
+
+    if (getFusedStageSource(getFusedStagePrefix(0)).empty())
+        return {nullptr};
+
+    return input;
+}
+
+/*************/
+bool Filter::samplesWithMipmaps(const Texture& input) const
+{
+    // A fused filter does not sample its input, its consumers sample the fused output
+    if (getFusedInput())
+        return isSampledWithMipmaps();
+
+    // Only minification reads the levels above the base one
+    auto inputSpec = input.getSpec();
+    if (_spec.width < inputSpec.width || _spec.height < inputSpec.height)
+        return true;
+
+    auto scaleIt = _filterUniforms.find("_scale");
+    if (scaleIt != _filterUniforms.end() && scaleIt->second.size() == 2 && (scaleIt->second[0].as<float>() < 1.f || scaleIt->second[1].as<float>() < 1.f))
+        return true;
+
+    return false;
+}
+
+/*************/
+void Filter::updateFusedStages()
+{
+    _fusedStages.clear();
+    string stagesSource;
+    string applySource;
+
+    const Filter* current = this;
+    while (current->getParents().size() == 1)
+    {
+        auto next = dynamic_cast<Filter*>(current->getParents()[0]);
+        if (!next || next->getFusedInput().get() != current)
+            break;
+
+        auto prefix = getFusedStagePrefix(_fusedStages.size());
+        stagesSource += next->getFusedStageSource(prefix) + "\n";
+        applySource += "    color = " + prefix + "apply(color);\n";
+        _fusedStages.push_back(next);
+        current = next;
     }
+
+    if (_fusedStages.empty())
+        _fusedStagesSource.clear();
+    else
+        _fusedStagesSource = stagesSource + "vec4 applyFusedStages(vec4 color)\n{\n" + applySource + "    return color;\n}";
+
+    updateShaderFill();
+}
+
+/*************/
+void Filter::updateShaderFill()
+{
+    auto fill = getShaderFill();
+    if (fill.empty())
+        return;
+
+    // The fused stages are defined right after the FUSED_STAGES define, so that their uniforms are parsed as any other
+    if (!_fusedStagesSource.empty())
+        fill.push_back("FUSED_STAGES\n" + _fusedStagesSource);
+
+    if (fill == _shaderFill)
+        return;
+
+    _shaderFill = fill;
+    _screen->setAttribute("fill", fill);
+}
+
+/*************/
+bool Filter::isAnimated() const
+{
+    auto shader = _screen->getShader();
+    return shader && (shader->hasUniform("_time") || shader->hasUniform("_clock"));
 }
 
 /*************/
@@ -261,6 +482,7 @@ void Filter::updateUniforms()
     // Built-in uniforms
     _filterUniforms["_time"] = {static_cast<int>(Timer::getTime() / 1000)};
     _filterUniforms["_resolution"] = {static_cast<float>(_spec.width), static_cast<float>(_spec.height)};
+    _filterUniforms["_outputTileRect"] = _tileRect;
 
     int64_t masterClock;
     bool paused;
@@ -295,6 +517,19 @@ void Filter::updateUniforms()
             param.push_back(v);
         shader->setAttribute("uniform", param);
     }
+
+    // Uniforms of the fused stages
+    for (size_t i = 0; i < _fusedStages.size(); ++i)
+    {
+        for (auto& uniform : _fusedStages[i]->getFusedStageUniforms(getFusedStagePrefix(i)))
+        {
+            Values param;
+            param.push_back(uniform.first);
+            for (auto& v : uniform.second)
+                param.push_back(v);
+            shader->setAttribute("uniform", param);
+        }
+    }
 }
 
 /*************/
@@ -336,6 +571,30 @@ void Filter::registerAttributes()
         {'i', 'i'});
     setAttributeDescription("sizeOverride", "Sets the filter output to a different resolution than its input");
 
+    addAttribute(
+        "fusion",
+        [&](const Values& args) {
+            _fusion = args[0].as<bool>();
+            return true;
+        },
+        [&]() -> Values { return {_fusion}; },
+        {'b'});
+    setAttributeDescription("fusion", "If true, a pointwise filter is computed in the same pass as its input filter, when it is the only one using it");
+
+    addAttribute(
+        "colorFormat",
+        [&](const Values& args) {
+            auto format = args[0].as<string>();
+            if (format != "auto" && format != "RGBA" && format != "RGBA16" && format != "RGB10A2" && format != "R11G11B10F")
+                return false;
+            _colorFormat = format;
+            return true;
+        },
+        [&]() -> Values { return {_colorFormat}; },
+        {'s'});
+    setAttributeDescription("colorFormat",
+        "Pixel format of the output, among RGBA, RGBA16, RGB10A2 and R11G11B10F (without alpha). Set to auto to keep 16bpc only when the inputs need it");
+
     //
     // Mipmap capture
     addAttribute(
@@ -80,13 +80,41 @@ class Filter : public Texture
      *  Get specs of the texture
      * \return Return the texture specs
      */
-    ImageBufferSpec getSpec() const override { return _fbo->getColorTexture()->getSpec(); }
+    ImageBufferSpec getSpec() const override
+    {
+        auto fusedInput = getFusedInput();
+        return fusedInput ? fusedInput->getSpec() : _fbo->getColorTexture()->getSpec();
+    }
 
     /**
      *  Get the id of the gl texture
      * \return Return the texture id
      */
-    GLuint getTexId() const override { return _fbo->getColorTexture()->getTexId(); }
+    GLuint getTexId() const override
+    {
+        auto fusedInput = getFusedInput();
+        return fusedInput ? fusedInput->getTexId() : _fbo->getColorTexture()->getTexId();
+    }
+
+    /**
+     * Get a bindless handle to sample the output from
+     * \return Return the handle, or 0 if the texture has to be bound
+     */
+    GLuint64 getBindlessHandle() override
+    {
+        auto fusedInput = getFusedInput();
+        return fusedInput ? fusedInput->getBindlessHandle() : _fbo->getColorTexture()->getBindlessHandle();
+    }
+
+    /**
+     * Get the content version of the output texture
+     * \return Return the content version
+     */
+    uint64_t getContentVersion() const override
+    {
+        auto fusedInput = getFusedInput();
+        return fusedInput ? fusedInput->getContentVersion() : _fbo->getColorTexture()->getContentVersion();
+    }
 
     /**
      * Set whether to keep the input image ratio
@@ -100,11 +128,32 @@ class Filter : public Texture
      */
     void setSixteenBpc(bool active);
 
+    /**
+     * Get the format of the output, resolving the automatic one from the inputs
+     * An automatic format keeps 16 bpc for deep inputs and inputs with an alpha channel, and uses
+     * 10 bpc packed pixels otherwise. A chain of filters keeps the format chosen by its first filter.
+     * \return Return the pixel format of the output
+     */
+    std::string getColorFormat() const;
+
+    /**
+     * Get the memory held by the render target
+     * \return Return the memory usage
+     */
+    MemoryUsage getMemoryUsage() const override { return _fbo ? _fbo->getMemoryUsage() : MemoryUsage(); }
+
     /**
      *  Render the filter
      */
     void render() override;
 
+    /**
+     * Check whether this filter samples the given input texture with mipmaps, which is the case if it minifies it
+     * \param input Input texture
+     * \return Return true if the mipmaps of the input are sampled
+     */
+    bool samplesWithMipmaps(const Texture& input) const override;
+
   protected:
     std::vector<std::weak_ptr<Texture>> _inTextures;
     std::shared_ptr<Object> _screen;
@@ -130,6 +179,63 @@ class Filter : public Texture
      */
     virtual void updateUniforms();
 
+    /**
+     * Force the output size, as the sizeOverride attribute does but synchronously
+     * \param width Output width
+     * \param height Output height
+     */
+    void setSizeOverride(int width, int height)
+    {
+        _sizeOverride[0] = width;
+        _sizeOverride[1] = height;
+    }
+
+    /**
+     * Check whether the filter output changes over time, even if its inputs do not
+     * \return Return true if the filter has to be rendered every frame
+     */
+    virtual bool isAnimated() const;
+
+    /**
+     * Get the fill parameters of the shader used by this filter
+     * \return Return the fill parameters, or an empty list if the filter manages its shader itself
+     */
+    virtual Values getShaderFill() const { return {"image_filter"}; }
+
+    /**
+     * Apply the shader fill, with the fused stages if any. Does nothing if the fill did not change
+     */
+    void updateShaderFill();
+
+    /**
+     * Check whether the following pointwise filters can be computed in the same pass as this filter
+     * This is not the case if the filter output itself is needed, or if its shader has no fused stages support
+     * \return Return true if the output of this filter can be fused
+     */
+    virtual bool canFuseOutput() const { return _grabMipmapLevel < 0; }
+
+    /**
+     * Get the source of this filter as a stage fused in the shader of its input filter
+     * The source declares the stage uniforms and a "vec4 <prefix>apply(vec4 color)" function
+     * \param prefix Prefix for all the identifiers of the stage
+     * \return Return the stage source, or an empty string if this filter is not pointwise
+     */
+    virtual std::string getFusedStageSource(const std::string& /*prefix*/) const { return {}; }
+
+    /**
+     * Get the uniforms of this filter as a stage fused in the shader of its input filter
+     * \param prefix Prefix for all the identifiers of the stage
+     * \return Return the uniforms, with their prefixed names
+     */
+    virtual std::unordered_map<std::string, Values> getFusedStageUniforms(const std::string& /*prefix*/) const { return {}; }
+
+    /**
+     * Get the input filter this filter is fused into, if any
+     * A pointwise filter is fused into its input filter if it is the only consumer of this input
+     * \return Return the input filter, or nullptr if this filter renders by itself
+     */
+    std::shared_ptr<Filter> getFusedInput() const;
+
     /**
      *  Register new functors to modify attributes
      */
@@ -141,12 +247,32 @@ class Filter : public Texture
     static constexpr int _defaultSize[2]{512, 512};
     int _sizeOverride[2]{-1, -1}; //!< If set to positive values, overrides the size given by input textures
     bool _keepRatio{false};
-    bool _sixteenBpc{true};
+    std::string _colorFormat{"auto"}; //!< Output pixel format, or auto to choose it from the inputs
+    Values _tileRect{0.f, 0.f, 1.f, 1.f}; //!< Region of the whole image covered by the output, when filtering a tile of it
 
     // Mipmap capture
     int _grabMipmapLevel{-1};
     Value _mipmapBuffer{};
     Values _mipmapBufferSpec{};
+    bool _mipmapsOutdated{false}; //!< True if the mipmaps were not generated for the current output
+
+    // Fusion of the following pointwise filters
+    bool _fusion{true};                 //!< If true, this filter is computed in the pass of its input filter when possible
+    std::vector<Filter*> _fusedStages{}; //!< Filters fused into this one, updated at each render
+    std::string _fusedStagesSource{};    //!< Shader source of the fused stages
+    Values _shaderFill{};                //!< Last fill parameters applied to the shader
+
+    /**
+     * Update the list of filters fused into this one, and the shader accordingly
+     */
+    void updateFusedStages();
+
+    /**
+     * Get the prefix of the identifiers of the given fused stage
+     * \param index Stage index
+     * \return Return the prefix
+     */
+    static std::string getFusedStagePrefix(size_t index) { return "_fused" + std::to_string(index) + "_"; }
 
     /**
      * Update the size override to take (or not) ratio into account
@@ -17,13 +17,17 @@ FilterBlackLevel::FilterBlackLevel(RootObject* root)
 /*************/
 void FilterBlackLevel::render()
 {
-    _screen->setAttribute("fill", {"blacklevel_filter"});
     Filter::render();
 
     // Automatic black level stuff
     if (_autoBlackLevelTargetValue != 0.f)
     {
-        auto luminance = _fbo->getColorTexture()->getMeanValue().luminance();
+        // The mean value is read back asynchronously, the black level is only updated once it is available
+        RgbValue meanValue;
+        if (!_fbo->getColorTexture()->getMeanValueAsync(meanValue))
+            return;
+
+        auto luminance = meanValue.luminance();
         auto deltaLuminance = _autoBlackLevelTargetValue - luminance;
         auto newBlackLevel = _autoBlackLevel + deltaLuminance / 2.f;
 
@@ -41,6 +45,34 @@ void FilterBlackLevel::render()
     }
 }
 
+/*************/
+bool FilterBlackLevel::isAnimated() const
+{
+    return Filter::isAnimated() || _autoBlackLevelTargetValue != 0.f;
+}
+
+/*************/
+string FilterBlackLevel::getFusedStageSource(const string& prefix) const
+{
+    // The automatic black level depends on the output of this very filter
+    if (_autoBlackLevelTargetValue != 0.f)
+        return {};
+
+    return "uniform float " + prefix + "blackLevel = 0.f;\n"
+        + "vec4 " + prefix + "apply(vec4 color)\n"
+        + "{\n"
+        + "    color.rgb = color.rgb * (1.0 - " + prefix + "blackLevel) + " + prefix + "blackLevel;\n"
+        + "    return color;\n"
+        + "}";
+}
+
+/*************/
+unordered_map<string, Values> FilterBlackLevel::getFusedStageUniforms(const string& prefix) const
+{
+    auto blackLevelIt = _filterUniforms.find("_blackLevel");
+    return {{prefix + "blackLevel", blackLevelIt != _filterUniforms.end() ? blackLevelIt->second : Values({0.f})}};
+}
+
 /*************/
 void FilterBlackLevel::registerDefaultShaderAttributes()
 {
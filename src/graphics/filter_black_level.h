@@ -53,6 +53,39 @@ class FilterBlackLevel : public Filter
      */
     void render() override;
 
+  protected:
+    /**
+     * Check whether the filter output changes over time, which is the case for the automatic black level
+     * \return Return true if the filter has to be rendered every frame
+     */
+    bool isAnimated() const override;
+
+    /**
+     * Get the fill parameters of the black level shader
+     * \return Return the fill parameters
+     */
+    Values getShaderFill() const override { return {"blacklevel_filter"}; }
+
+    /**
+     * Check whether the following pointwise filters can be fused, which is not the case with automatic black level as it measures the output
+     * \return Return true if the output of this filter can be fused
+     */
+    bool canFuseOutput() const override { return Filter::canFuseOutput() && _autoBlackLevelTargetValue == 0.f; }
+
+    /**
+     * Get the source of this filter as a fused stage
+     * \param prefix Prefix for all the identifiers of the stage
+     * \return Return the stage source, or an empty string if automatic black level is enabled
+     */
+    std::string getFusedStageSource(const std::string& prefix) const override;
+
+    /**
+     * Get the uniforms of this filter as a fused stage
+     * \param prefix Prefix for all the identifiers of the stage
+     * \return Return the uniforms
+     */
+    std::unordered_map<std::string, Values> getFusedStageUniforms(const std::string& prefix) const override;
+
   private:
     float _autoBlackLevelTargetValue{0.f}; //!< If not zero, defines the target luminance value
     float _autoBlackLevelSpeed{1.f};       //!< Time to match the black level target value
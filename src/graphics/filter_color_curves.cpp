@@ -12,11 +12,62 @@ FilterColorCurves::FilterColorCurves(RootObject* root)
     _type = "filter_color_curves";
 }
 
+/*************/
+Values FilterColorCurves::getShaderFill() const
+{
+    if (_colorCurves.empty())
+        return Filter::getShaderFill();
+    // Validity of color curve has been checked earlier
+    return {"color_curves_filter", "COLOR_CURVE_COUNT " + to_string(static_cast<int>(_colorCurves[0].size()))};
+}
+
+/*************/
+string FilterColorCurves::getFusedStageSource(const string& prefix) const
+{
+    // Without curves, this filter behaves as the image filter which is not pointwise
+    if (_colorCurves.empty())
+        return {};
+
+    // Same Bezier curve as the color curves shader, with the binomial coefficients computed iteratively
+    auto count = to_string(static_cast<int>(_colorCurves[0].size()));
+    return "uniform vec3 " + prefix + "colorCurves[" + count + "];\n"
+        + "vec4 " + prefix + "apply(vec4 color)\n"
+        + "{\n"
+        + "    color = clamp(color, vec4(0.0), vec4(1.0));\n"
+        + "    vec3 curvedColor = vec3(0.0);\n"
+        + "    float factor = 1.0;\n"
+        + "    for (int i = 0; i < " + count + "; ++i)\n"
+        + "    {\n"
+        + "        curvedColor += factor * pow(color.rgb, vec3(float(i))) * pow(vec3(0.9999) - color.rgb, vec3(float(" + count + " - 1 - i))) * " + prefix + "colorCurves[i];\n"
+        + "        factor = factor * float(" + count + " - 1 - i) / float(i + 1);\n"
+        + "    }\n"
+        + "    color.rgb = curvedColor;\n"
+        + "    return color;\n"
+        + "}";
+}
+
+/*************/
+unordered_map<string, Values> FilterColorCurves::getFusedStageUniforms(const string& prefix) const
+{
+    if (_colorCurves.empty())
+        return {};
+    return {{prefix + "colorCurves", {getFlatColorCurves()}}};
+}
+
+/*************/
+Values FilterColorCurves::getFlatColorCurves() const
+{
+    Values curves;
+    for (uint32_t i = 0; i < _colorCurves[0].size(); ++i)
+        for (uint32_t j = 0; j < _colorCurves.size(); ++j)
+            curves.push_back(_colorCurves[j].as<Values>()[i].as<float>());
+    return curves;
+}
+
 /*************/
 void FilterColorCurves::updateShaderParameters()
 {
-    if (!_colorCurves.empty()) // Validity of color curve has been checked earlier
-        _screen->setAttribute("fill", {"color_curves_filter", "COLOR_CURVE_COUNT " + to_string(static_cast<int>(_colorCurves[0].size()))});
+    updateShaderFill();
 
     // This is a trick to force the shader compilation
     _screen->activate();
@@ -31,12 +82,8 @@ void FilterColorCurves::updateUniforms()
 
     if (!_colorCurves.empty())
     {
-        Values tmpCurves;
-        for (uint32_t i = 0; i < _colorCurves[0].size(); ++i)
-            for (uint32_t j = 0; j < _colorCurves.size(); ++j)
-                tmpCurves.push_back(_colorCurves[j][i].as<float>());
         Values curves;
-        curves.push_back(tmpCurves);
+        curves.push_back(getFlatColorCurves());
         shader->setAttribute("uniform", {"_colorCurves", curves});
     }
 }
@@ -48,9 +48,36 @@ class FilterColorCurves : public Filter
     FilterColorCurves(FilterColorCurves&&) = default;
     FilterColorCurves& operator=(const FilterColorCurves&) = delete;
 
+  protected:
+    /**
+     * Get the fill parameters of the color curves shader, or of the image filter if no curve is set
+     * \return Return the fill parameters
+     */
+    Values getShaderFill() const override;
+
+    /**
+     * Get the source of this filter as a fused stage
+     * \param prefix Prefix for all the identifiers of the stage
+     * \return Return the stage source, or an empty string if no curve is set
+     */
+    std::string getFusedStageSource(const std::string& prefix) const override;
+
+    /**
+     * Get the uniforms of this filter as a fused stage
+     * \param prefix Prefix for all the identifiers of the stage
+     * \return Return the uniforms
+     */
+    std::unordered_map<std::string, Values> getFusedStageUniforms(const std::string& prefix) const override;
+
   private:
     Values _colorCurves{}; //!< RGB points for the color curves, active if at least 3 points are set
 
+    /**
+     * Get the color curves as a flat list, as expected by the shaders
+     * \return Return the curves points
+     */
+    Values getFlatColorCurves() const;
+
     /**
      * Register attributes related to the default shader
      */
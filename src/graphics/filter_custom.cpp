@@ -16,24 +16,56 @@ FilterCustom::FilterCustom(RootObject* root)
 /*************/
 bool FilterCustom::setFilterSource(const string& source)
 {
-    auto shader = make_shared<Shader>();
-    // Save the value for all existing uniforms
-    auto uniformValues = _filterUniforms;
+    // The shader is kept from a source to the next, so that the previous program is used while the new one is built
+    if (!_customShader)
+        _customShader = make_shared<Shader>();
 
     map<Shader::ShaderType, string> shaderSources;
     shaderSources[Shader::ShaderType::fragment] = source;
-    if (!shader->setSource(shaderSources))
+    if (!_customShader->setSource(shaderSources))
     {
         Log::get() << Log::WARNING << "Filter::" << __FUNCTION__ << " - Could not apply shader filter" << Log::endl;
         return false;
     }
-    Log::get() << Log::MESSAGE << "Filter::" << __FUNCTION__ << " - Shader filter updated" << Log::endl;
-    _screen->setShader(shader);
+
+    if (_screen->getShader() != _customShader)
+        _screen->setShader(_customShader);
 
     // This is a trick to force the shader compilation
     _screen->activate();
     _screen->deactivate();
 
+    // Uniforms are only known once the shader is linked
+    _uniformsPending = true;
+    if (!_customShader->isLinkPending())
+        registerFilterUniforms();
+
+    return true;
+}
+
+/*************/
+void FilterCustom::updateUniforms()
+{
+    if (_uniformsPending && _customShader && !_customShader->isLinkPending())
+        registerFilterUniforms();
+
+    Filter::updateUniforms();
+}
+
+/*************/
+void FilterCustom::registerFilterUniforms()
+{
+    _uniformsPending = false;
+    if (_customShader->hasLinkFailed())
+    {
+        Log::get() << Log::WARNING << "Filter::" << __FUNCTION__ << " - Could not apply shader filter, keeping the previous one" << Log::endl;
+        return;
+    }
+    Log::get() << Log::MESSAGE << "Filter::" << __FUNCTION__ << " - Shader filter updated" << Log::endl;
+
+    // Save the value for all existing uniforms
+    auto uniformValues = _filterUniforms;
+
     // Unregister previously added uniforms
     // We remove the associated attribute fonction if it exists
     for (const auto& uniform : _filterUniforms)
@@ -49,8 +81,8 @@ bool FilterCustom::setFilterSource(const string& source)
     _filterUniforms.clear();
 
     // Register the attributes corresponding to the shader uniforms
-    auto uniforms = shader->getUniforms();
-    auto uniformsDocumentation = shader->getUniformsDocumentation();
+    auto uniforms = _customShader->getUniforms();
+    auto uniformsDocumentation = _customShader->getUniformsDocumentation();
 
     for (const auto& u : uniforms)
     {
@@ -81,8 +113,6 @@ bool FilterCustom::setFilterSource(const string& source)
         if (uniformValueIt != uniformValues.end())
             setAttribute(u.first, uniformValueIt->second);
     }
-
-    return true;
 }
 
 /*************/
@@ -50,11 +50,37 @@ class FilterCustom : public Filter
     FilterCustom(FilterCustom&&) = default;
     FilterCustom& operator=(const FilterCustom&) = delete;
 
+  protected:
+    /**
+     * The shader is set from the user source, not through its fill parameters
+     * \return Return an empty list
+     */
+    Values getShaderFill() const override { return {}; }
+
+    /**
+     * User defined shaders have no support for fused stages
+     * \return Return false
+     */
+    bool canFuseOutput() const override { return false; }
+
+    /**
+     * How a user defined shader samples its inputs is unknown
+     * \return Return true
+     */
+    bool samplesWithMipmaps(const Texture& /*input*/) const override { return true; }
+
+    /**
+     * Register the uniforms of the shader once it is linked, then update the uniforms
+     */
+    void updateUniforms() override;
+
   private:
     std::string _shaderSource{""};                            //!< User defined fragment shader filter
     std::string _shaderSourceFile{""};                        //!< User defined fragment shader filter source file
     bool _watchShaderFile{false};                             //!< If true, updates shader automatically if source file changes
     std::filesystem::file_time_type _lastShaderSourceWrite{}; //!< Last time the shader source has been updated
+    std::shared_ptr<Shader> _customShader{nullptr};          //!< Shader built from the user source, kept so that it is rebuilt in the background
+    bool _uniformsPending{false};                             //!< True if the uniforms have to be registered once the shader is linked
 
     /**
      * Register new functors to modify attributes
@@ -72,6 +98,11 @@ class FilterCustom : public Filter
      * \return Return true if the shader is valid
      */
     bool setFilterSource(const std::string& source);
+
+    /**
+     * Replace the attributes of the previous shader uniforms by those of the current shader
+     */
+    void registerFilterUniforms();
 };
 
 } // namespace Splash
@@ -0,0 +1,53 @@
+#include "./graphics/filter_yuv.h"
+
+using namespace std;
+
+namespace Splash
+{
+
+/*************/
+FilterYuv::FilterYuv(RootObject* root)
+    : Filter(root)
+{
+    _type = "filter_yuv";
+
+    registerDefaultShaderAttributes();
+}
+
+/*************/
+void FilterYuv::render()
+{
+    if (_inTextures.empty() || _inTextures[0].expired())
+        return;
+
+    auto inputSpec = _inTextures[0].lock()->getSpec();
+    auto width = _requestedSize[0] > 0 ? _requestedSize[0] : static_cast<int>(inputSpec.width);
+    auto height = _requestedSize[1] > 0 ? _requestedSize[1] : static_cast<int>(inputSpec.height);
+
+    // Each texel packs four luma samples, and planes must start on a texel
+    auto frameWidth = std::max(8, width / 8 * 8);
+    auto frameHeight = std::max(2, height / 2 * 2);
+    setSizeOverride(frameWidth / 4, frameHeight * 3 / 2);
+    _filterUniforms["_frameSize"] = {frameWidth, frameHeight};
+
+    Filter::render();
+}
+
+/*************/
+void FilterYuv::registerDefaultShaderAttributes()
+{
+    addAttribute(
+        "frameSize",
+        [&](const Values& args) {
+            _requestedSize[0] = args[0].as<int>();
+            _requestedSize[1] = args[1].as<int>();
+            return true;
+        },
+        [&]() -> Values {
+            return {_requestedSize[0], _requestedSize[1]};
+        },
+        {'i', 'i'});
+    setAttributeDescription("frameSize", "Size of the YUV frame, the input size being used if set to 0. The width is rounded to a multiple of 8, the height to a multiple of 2");
+}
+
+} // namespace Splash
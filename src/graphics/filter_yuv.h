@@ -0,0 +1,89 @@
+/*
+ * Copyright (C) 2026 Emmanuel Durand
+ *
+ * This file is part of Splash.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Splash is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Splash.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * @filter_yuv.h
+ * The FilterYuv class
+ */
+
+#ifndef SPLASH_FILTER_YUV_H
+#define SPLASH_FILTER_YUV_H
+
+#include "./core/constants.h"
+#include "./graphics/filter.h"
+
+namespace Splash
+{
+
+/*************/
+//! Filter converting its input to a planar YUV 4:2:0 (I420) frame, optionally scaled
+//! The frame is packed in an RGBA texture a quarter as wide and one and a half times as high,
+//! so that reading the texture back gives the frame as laid out in memory by encoders.
+class FilterYuv : public Filter
+{
+  public:
+    /**
+     *  Constructor
+     * \param root Root object
+     */
+    FilterYuv(RootObject* root);
+
+    /**
+     * No copy constructor, but a move one
+     */
+    FilterYuv(const FilterYuv&) = delete;
+    FilterYuv(FilterYuv&&) = default;
+    FilterYuv& operator=(const FilterYuv&) = delete;
+
+    /**
+     *  Render the filter
+     */
+    void render() override;
+
+  protected:
+    /**
+     * Get the fill parameters of the YUV shader
+     * \return Return the fill parameters
+     */
+    Values getShaderFill() const override { return {"yuv420_filter"}; }
+
+    /**
+     * The output is a packed YUV frame, no pointwise color stage can be applied to it
+     * \return Return false
+     */
+    bool canFuseOutput() const override { return false; }
+
+    /**
+     * The chroma is sampled from the mipmap level above the luma one
+     * \return Return true
+     */
+    bool samplesWithMipmaps(const Texture& /*input*/) const override { return true; }
+
+  private:
+    int _requestedSize[2]{0, 0}; //!< Requested frame size, the input size being used if not positive
+
+    /**
+     * Register attributes related to the default shader
+     */
+    void registerDefaultShaderAttributes() override;
+};
+
+} // namespace Splash
+
+#endif // SPLASH_FILTER_YUV_H
@@ -3,6 +3,9 @@
 #include "./utils/log.h"
 #include "./utils/timer.h"
 
+// Size of the attachments once released, large enough for all the mipmap levels of the color texture
+#define SPLASH_FRAMEBUFFER_RELEASED_SIZE 8
+
 using namespace std;
 
 namespace Splash
@@ -24,7 +27,7 @@ Framebuffer::Framebuffer(RootObject* root)
         _colorTexture = make_shared<Texture_Image>(_root);
         _colorTexture->setAttribute("clampToEdge", {true});
         _colorTexture->setAttribute("filtering", {false});
-        _colorTexture->reset(_width, _height, _16bits ? "RGBA16" : "RGBA", nullptr, _multisample);
+        _colorTexture->reset(_width, _height, _colorFormat, nullptr, _multisample);
         glNamedFramebufferTexture(_fbo, GL_COLOR_ATTACHMENT0, _colorTexture->getTexId(), 0);
     }
 
@@ -49,6 +52,36 @@ Framebuffer::Framebuffer(RootObject* root)
 Framebuffer::~Framebuffer()
 {
     glDeleteFramebuffers(1, &_fbo);
+
+    for (auto& read : _depthReads)
+    {
+        glDeleteSync(read.fence);
+        _depthPbos.push_back(read.pbo);
+    }
+    if (!_depthPbos.empty())
+        glDeleteBuffers(_depthPbos.size(), _depthPbos.data());
+}
+
+/*************/
+uint32_t Framebuffer::getBitDepth() const
+{
+    if (_colorFormat == "RGBA16")
+        return 16;
+    else if (_colorFormat == "R11G11B10F")
+        return 11;
+    else if (_colorFormat == "RGB10A2")
+        return 10;
+    return 8;
+}
+
+/*************/
+GraphObject::MemoryUsage Framebuffer::getMemoryUsage() const
+{
+    MemoryUsage usage;
+    for (const auto& texture : {_depthTexture, _colorTexture})
+        if (texture)
+            usage += texture->getMemoryUsage();
+    return usage;
 }
 
 /*************/
@@ -90,6 +123,64 @@ float Framebuffer::getDepthAt(float x, float y)
     return depth;
 }
 
+/*************/
+void Framebuffer::getDepthAtAsync(float x, float y, const function<void(float)>& callback)
+{
+    DepthRead read;
+    read.callback = callback;
+    if (_depthPbos.empty())
+    {
+        glCreateBuffers(1, &read.pbo);
+        glNamedBufferData(read.pbo, sizeof(float), nullptr, GL_STREAM_READ);
+    }
+    else
+    {
+        read.pbo = _depthPbos.back();
+        _depthPbos.pop_back();
+    }
+
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, _fbo);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, read.pbo);
+    glReadPixels(x, y, 1, 1, GL_DEPTH_COMPONENT, GL_FLOAT, 0);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+
+    read.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    _depthReads.push_back(std::move(read));
+}
+
+/*************/
+void Framebuffer::processDepthReads()
+{
+    // Reads complete in order, so the first pending one stops the processing
+    size_t completed = 0;
+    for (; completed < _depthReads.size(); ++completed)
+    {
+        auto& read = _depthReads[completed];
+        auto status = glClientWaitSync(read.fence, 0, 0);
+        if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED)
+            break;
+
+        glDeleteSync(read.fence);
+        float depth = 1.f;
+        glGetNamedBufferSubData(read.pbo, 0, sizeof(float), &depth);
+        _depthPbos.push_back(read.pbo);
+        read.callback(depth);
+    }
+
+    _depthReads.erase(_depthReads.begin(), _depthReads.begin() + completed);
+}
+
+/*************/
+void Framebuffer::release()
+{
+    if (_released)
+        return;
+
+    setSize(SPLASH_FRAMEBUFFER_RELEASED_SIZE, SPLASH_FRAMEBUFFER_RELEASED_SIZE);
+    _released = true;
+}
+
 /*************/
 void Framebuffer::setCubemap(bool cubemap)
 {
@@ -100,6 +191,25 @@ void Framebuffer::setCubemap(bool cubemap)
     }
 }
 
+/*************/
+void Framebuffer::setDepthAttachment(bool depth)
+{
+    if (depth == (_depthTexture != nullptr))
+        return;
+
+    if (depth)
+    {
+        _depthTexture = make_shared<Texture_Image>(_root, _width, _height, "D", nullptr, _multisample, _cubemap);
+        _depthTexture->setResizable(_automaticResize);
+        glNamedFramebufferTexture(_fbo, GL_DEPTH_ATTACHMENT, _depthTexture->getTexId(), 0);
+    }
+    else
+    {
+        glNamedFramebufferTexture(_fbo, GL_DEPTH_ATTACHMENT, 0, 0);
+        _depthTexture.reset();
+    }
+}
+
 /*************/
 void Framebuffer::setsRGB(bool srgb)
 {
@@ -121,11 +231,17 @@ void Framebuffer::setMultisampling(int samples)
 }
 
 /*************/
-void Framebuffer::setSixteenBpc(bool sixteenbpc)
+void Framebuffer::setColorFormat(const string& format)
 {
-    if (_16bits != sixteenbpc)
+    if (format != "RGBA" && format != "RGBA16" && format != "RGB10A2" && format != "R11G11B10F")
     {
-        _16bits = sixteenbpc;
+        Log::get() << Log::WARNING << "Framebuffer::" << __FUNCTION__ << " - Unsupported color format: " << format << Log::endl;
+        return;
+    }
+
+    if (_colorFormat != format)
+    {
+        _colorFormat = format;
         setRenderingParameters();
     }
 }
@@ -135,16 +251,13 @@ void Framebuffer::setRenderingParameters()
 {
     auto spec = _colorTexture->getSpec();
 
-    _depthTexture->reset(spec.width, spec.height, "D", nullptr, _multisample, _cubemap);
+    if (_depthTexture)
+        _depthTexture->reset(spec.width, spec.height, "D", nullptr, _multisample, _cubemap);
 
-    if (_srgb)
-        _colorTexture->reset(spec.width, spec.height, "sRGBA", nullptr, _multisample, _cubemap);
-    else if (_16bits)
-        _colorTexture->reset(spec.width, spec.height, "RGBA16", nullptr, _multisample, _cubemap);
-    else
-        _colorTexture->reset(spec.width, spec.height, "RGBA", nullptr, _multisample, _cubemap);
+    _colorTexture->reset(spec.width, spec.height, _srgb ? "sRGBA" : _colorFormat, nullptr, _multisample, _cubemap);
 
-    glNamedFramebufferTexture(_fbo, GL_DEPTH_ATTACHMENT, _depthTexture->getTexId(), 0);
+    if (_depthTexture)
+        glNamedFramebufferTexture(_fbo, GL_DEPTH_ATTACHMENT, _depthTexture->getTexId(), 0);
     glNamedFramebufferTexture(_fbo, GL_COLOR_ATTACHMENT0, _colorTexture->getTexId(), 0);
 }
 
@@ -154,10 +267,13 @@ void Framebuffer::setSize(int width, int height)
     if (width == 0 || height == 0)
         return;
 
-    _depthTexture->setResizable(true);
-    _depthTexture->setAttribute("size", {width, height});
-    _depthTexture->setResizable(_automaticResize);
-    glNamedFramebufferTexture(_fbo, GL_DEPTH_ATTACHMENT, _depthTexture->getTexId(), 0);
+    if (_depthTexture)
+    {
+        _depthTexture->setResizable(true);
+        _depthTexture->setAttribute("size", {width, height});
+        _depthTexture->setResizable(_automaticResize);
+        glNamedFramebufferTexture(_fbo, GL_DEPTH_ATTACHMENT, _depthTexture->getTexId(), 0);
+    }
 
     _colorTexture->setResizable(true);
     _colorTexture->setAttribute("size", {width, height});
@@ -166,13 +282,15 @@ void Framebuffer::setSize(int width, int height)
 
     _width = width;
     _height = height;
+    _released = false;
 }
 
 /*************/
 void Framebuffer::setResizable(bool resizable)
 {
     _automaticResize = resizable;
-    _depthTexture->setResizable(_automaticResize);
+    if (_depthTexture)
+        _depthTexture->setResizable(_automaticResize);
     _colorTexture->setResizable(_automaticResize);
 }
 
@@ -25,7 +25,9 @@
 #ifndef SPLASH_FBO_H
 #define SPLASH_FBO_H
 
+#include <functional>
 #include <memory>
+#include <vector>
 
 #include "./core/constants.h"
 
@@ -73,7 +75,7 @@ class Framebuffer : public GraphObject
      * Get bit depth
      * \return Return the bit depth for each channel
      */
-    uint32_t getBitDepth() const { return _16bits ? 16 : 8; }
+    uint32_t getBitDepth() const;
 
     /**
      * Get the color texture
@@ -95,6 +97,20 @@ class Framebuffer : public GraphObject
      */
     float getDepthAt(float x, float y);
 
+    /**
+     * Read the depth at the given location without waiting for the GPU
+     * The depth is read to a PBO, and the callback is called from processDepthReads once it is available.
+     * \param x X position
+     * \param y Y position
+     * \param callback Callback receiving the depth
+     */
+    void getDepthAtAsync(float x, float y, const std::function<void(float)>& callback);
+
+    /**
+     * Call the callbacks of the completed depth reads, without waiting for the pending ones
+     */
+    void processDepthReads();
+
     /**
      * Get the GL FBO id
      * \return The FBO id
@@ -107,6 +123,24 @@ class Framebuffer : public GraphObject
     int getWidth() const { return _width; }
     int getHeight() const { return _height; }
 
+    /**
+     * Get whether the attachments storage has been released, see release()
+     * \return Return true if released
+     */
+    bool isReleased() const { return _released; }
+
+    /**
+     * Shrink the attachments to a few pixels, to release their memory while the FBO is not used
+     * The content is lost, the FBO is allocated again by the next call to setSize
+     */
+    void release();
+
+    /**
+     * Get the memory held by the attachments
+     * \return Return the memory usage
+     */
+    MemoryUsage getMemoryUsage() const final;
+
     /**
      * Set whether this FBO should resize automatically
      * \param autoresize Set to true for auto resizing
@@ -119,6 +153,12 @@ class Framebuffer : public GraphObject
      */
     void setCubemap(bool cubemap);
 
+    /**
+     * Set whether the FBO has a depth attachment. FBOs only drawing screen aligned quads do not need one
+     * \param depth Set to false to remove the depth attachment
+     */
+    void setDepthAttachment(bool depth);
+
     /**
      * Set multisampling sample count
      * \param samples Sample count
@@ -135,7 +175,13 @@ class Framebuffer : public GraphObject
      * Set the color depth to 16bpc
      * \param sixteenbpc If true, set color depth to 16bpc
      */
-    void setSixteenBpc(bool sixteenbpc);
+    void setSixteenBpc(bool sixteenbpc) { setColorFormat(sixteenbpc ? "RGBA16" : "RGBA"); }
+
+    /**
+     * Set the format of the color attachment
+     * \param format Pixel format, among RGBA, RGBA16, RGB10A2 and R11G11B10F. sRGB, if set, overrides it
+     */
+    void setColorFormat(const std::string& format);
 
     /**
      * Set the FBO size
@@ -156,6 +202,14 @@ class Framebuffer : public GraphObject
     void unbindDraw();
     void unbindRead();
 
+  private:
+    struct DepthRead
+    {
+        GLuint pbo{0};
+        GLsync fence{nullptr};
+        std::function<void(float)> callback{};
+    };
+
   private:
     GLuint _fbo{0};
     std::shared_ptr<Texture_Image> _depthTexture{nullptr};
@@ -163,11 +217,15 @@ class Framebuffer : public GraphObject
 
     int _width{512}, _height{512};
     int _multisample{0};
-    bool _16bits{false};
+    std::string _colorFormat{"RGBA"};
     bool _srgb{false};
     bool _cubemap{false};
     bool _automaticResize{false}; // TODO: handle this correctly
     int _previousFbo{0};
+    bool _released{false}; //!< True if the attachments have been shrunk until the next resize
+
+    std::vector<DepthRead> _depthReads{}; //!< Pending depth reads, in request order
+    std::vector<GLuint> _depthPbos{};     //!< PBOs available for the next depth reads
 
     /**
      * Set the FBO multisampling and bit per channel settings
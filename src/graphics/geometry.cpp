@@ -1,8 +1,11 @@
 #include "./graphics/geometry.h"
 
+#include <algorithm>
+
 #include "./core/scene.h"
 #include "./mesh/mesh.h"
 #include "./utils/log.h"
+#include "./utils/vertex_packing.h"
 
 using namespace std;
 using namespace glm;
@@ -77,25 +80,28 @@ void Geometry::activateAsSharedBuffer()
     }
     else
     {
-        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, _glBuffers[0]->getId());
-        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, _glBuffers[1]->getId());
-        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, _glBuffers[2]->getId());
-        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 3, _glBuffers[3]->getId());
+        // Streaming buffers only expose their current region. Compact texture coordinates and normals
+        // are bound as is, which is fine as long as compute shaders do not read them
+        const auto& buffers = getLevelBuffers();
+        for (uint32_t idx = 0; idx < 4; ++idx)
+            glBindBufferRange(GL_SHADER_STORAGE_BUFFER, idx, buffers[idx]->getId(), buffers[idx]->getOffset(), buffers[idx]->getMemorySize());
     }
 }
 
 /*************/
 void Geometry::activateForFeedback()
 {
-    _feedbackMaxNbrPrimitives = std::max(_verticesNumber / 3, _feedbackMaxNbrPrimitives);
+    auto verticesNumber = _levelOfDetail == 0 ? _verticesNumber : _lodVerticesNumbers[_levelOfDetail - 1];
+    _feedbackMaxNbrPrimitives = std::max(verticesNumber / 3, _feedbackMaxNbrPrimitives);
     if (_glTemporaryBuffers.size() < _glBuffers.size() || _buffersDirty || _feedbackMaxNbrPrimitives * 6 > _temporaryBufferSize)
     {
         _glTemporaryBuffers.clear();
         _temporaryBufferSize = _feedbackMaxNbrPrimitives * 6; // 3 vertices per primitive, times two to keep some margin for future updates
         for (auto& buffer : _glBuffers)
         {
-            // This creates a copy of the buffer
-            auto altBuffer = std::make_shared<GpuBuffer>(*buffer);
+            // This creates a copy of the buffer, or a float one for compact buffers as the feedback outputs floats
+            auto altBuffer = buffer->getType() == GL_FLOAT ? std::make_shared<GpuBuffer>(*buffer)
+                                                           : std::make_shared<GpuBuffer>(buffer->getElementSize(), GL_FLOAT, GL_STATIC_DRAW, _temporaryBufferSize);
             altBuffer->resize(_temporaryBufferSize);
             _glTemporaryBuffers.push_back(altBuffer);
         }
@@ -144,6 +150,24 @@ void Geometry::deactivateFeedback()
     _temporaryVerticesNumber = drawnPrimitives * 3;
 }
 
+/*************/
+GraphObject::MemoryUsage Geometry::getMemoryUsage() const
+{
+    // GPU buffers are only modified from the rendering thread, which also calls this method
+    MemoryUsage usage;
+    for (const auto* buffers : {&_glBuffers, &_glAlternativeBuffers, &_glTemporaryBuffers})
+        for (const auto& buffer : *buffers)
+            if (buffer)
+                usage.vram += static_cast<int64_t>(buffer->getMemorySize());
+    for (const auto& buffers : _glLodBuffers)
+        for (const auto& buffer : buffers)
+            usage.vram += static_cast<int64_t>(buffer->getMemorySize());
+
+    shared_lock<shared_mutex> lock(_writeMutex);
+    usage.ram = static_cast<int64_t>(_serializedMesh.size());
+    return usage;
+}
+
 /*************/
 shared_ptr<SerializedObject> Geometry::serialize() const
 {
@@ -176,6 +200,25 @@ bool Geometry::deserialize(const shared_ptr<SerializedObject>& obj)
     return true;
 }
 
+/*************/
+bool Geometry::setAlternativeBuffers(const shared_ptr<SerializedObject>& obj)
+{
+    if (!obj || obj->size() < sizeof(int))
+        return false;
+
+    uint32_t verticesNumber = *reinterpret_cast<int*>(obj->data());
+    if (obj->size() != verticesNumber * 4 * 14 + 4)
+    {
+        Log::get() << Log::WARNING << "Geometry::" << __FUNCTION__ << " - Buffer size does not match its header. Dropping." << Log::endl;
+        return false;
+    }
+
+    lock_guard<shared_mutex> lock(_writeMutex);
+    _serializedMesh = *obj;
+    _forceSerializedMesh = true;
+    return true;
+}
+
 /*************/
 bool Geometry::linkIt(const shared_ptr<GraphObject>& obj)
 {
@@ -192,25 +235,8 @@ bool Geometry::linkIt(const shared_ptr<GraphObject>& obj)
 /*************/
 float Geometry::pickVertex(dvec3 p, dvec3& v)
 {
-    float distance = numeric_limits<float>::max();
-    dvec3 closestVertex;
-
     assert(_mesh);
-    vector<float> vertices = _mesh->getVertCoords();
-    for (uint32_t i = 0; i < vertices.size(); i += 4)
-    {
-        dvec3 vertex(vertices[i], vertices[i + 1], vertices[i + 2]);
-        float dist = length(p - vertex);
-        if (dist < distance)
-        {
-            closestVertex = vertex;
-            distance = dist;
-        }
-    }
-
-    v = closestVertex;
-
-    return distance;
+    return _mesh->pickVertex(p, v);
 }
 
 /*************/
@@ -235,34 +261,98 @@ void Geometry::update()
     // Update the vertex buffers if mesh was updated
     if (_timestamp != _mesh->getTimestamp())
     {
-        _glBuffers.clear();
         _mesh->update();
 
-        vector<float> vertices = _mesh->getVertCoords();
-        if (vertices.empty())
-            return;
-
-        _verticesNumber = vertices.size() / 4;
-        _glBuffers.push_back(make_shared<GpuBuffer>(4, GL_FLOAT, GL_STATIC_DRAW, _verticesNumber, vertices.data()));
-
-        vector<float> texcoords = _mesh->getUVCoords();
-        if (!texcoords.empty())
-            _glBuffers.push_back(make_shared<GpuBuffer>(2, GL_FLOAT, GL_STATIC_DRAW, _verticesNumber, texcoords.data()));
+        // Dynamic meshes are streamed to the existing buffers
+        if (_mesh->isDynamic() && _glBuffers.size() == 4 && _glBuffers[0]->isStreaming())
+        {
+            vector<float> vertices = _mesh->getVertCoords();
+            vector<float> texcoords = _mesh->getUVCoords();
+            vector<float> normals = _mesh->getNormals();
+            vector<float> annexe = _mesh->getAnnexe();
+
+            // Only the vertices changed since the content held by the buffers are uploaded, if known
+            size_t first = 0;
+            size_t count = 0;
+            if (_mesh->getUpdatedRange(_timestamp, first, count) && vertices.size() / 4 == static_cast<size_t>(_verticesNumber))
+            {
+                _glBuffers[0]->stream(vertices.data(), _verticesNumber, first, count);
+                _glBuffers[1]->stream(texcoords.empty() ? nullptr : texcoords.data(), _verticesNumber, first, count);
+                _glBuffers[2]->stream(normals.empty() ? nullptr : normals.data(), _verticesNumber, first, count);
+                _glBuffers[3]->stream(annexe.empty() ? nullptr : annexe.data(), _verticesNumber, first, count);
+            }
+            else
+            {
+                _verticesNumber = vertices.size() / 4;
+                _glBuffers[0]->stream(vertices.data(), _verticesNumber);
+                _glBuffers[1]->stream(texcoords.empty() ? nullptr : texcoords.data(), _verticesNumber);
+                _glBuffers[2]->stream(normals.empty() ? nullptr : normals.data(), _verticesNumber);
+                _glBuffers[3]->stream(annexe.empty() ? nullptr : annexe.data(), _verticesNumber);
+            }
+        }
         else
-            _glBuffers.push_back(make_shared<GpuBuffer>(2, GL_FLOAT, GL_STATIC_DRAW, _verticesNumber, nullptr));
+        {
+            _glBuffers.clear();
 
-        vector<float> normals = _mesh->getNormals();
-        if (!normals.empty())
-            _glBuffers.push_back(make_shared<GpuBuffer>(4, GL_FLOAT, GL_STATIC_DRAW, _verticesNumber, normals.data()));
-        else
-            _glBuffers.push_back(make_shared<GpuBuffer>(4, GL_FLOAT, GL_STATIC_DRAW, _verticesNumber, nullptr));
+            // Meshes mapped from shared memory are uploaded straight from the mapping
+            if (auto packedMesh = _mesh->getPackedMesh(); packedMesh)
+            {
+                _verticesNumber = *reinterpret_cast<int*>(packedMesh->data());
+                if (_verticesNumber == 0)
+                    return;
+
+                auto packedPtr = reinterpret_cast<float*>(packedMesh->data() + sizeof(int));
+                bool hasAnnexe = packedMesh->size() > sizeof(int) + _verticesNumber * 10 * sizeof(float);
+                _glBuffers = createStaticBuffers(
+                    _verticesNumber, packedPtr, packedPtr + _verticesNumber * 4, packedPtr + _verticesNumber * 6, hasAnnexe ? packedPtr + _verticesNumber * 10 : nullptr);
+            }
+            else if (!_mesh->isDynamic())
+            {
+                vector<float> vertices = _mesh->getVertCoords();
+                if (vertices.empty())
+                    return;
 
-        // An additional annexe buffer, to be filled by compute shaders. Contains a vec4 for each vertex
-        vector<float> annexe = _mesh->getAnnexe();
-        if (!annexe.empty())
-            _glBuffers.push_back(make_shared<GpuBuffer>(4, GL_FLOAT, GL_STATIC_DRAW, _verticesNumber, annexe.data()));
-        else
-            _glBuffers.push_back(make_shared<GpuBuffer>(4, GL_FLOAT, GL_STATIC_DRAW, _verticesNumber, nullptr));
+                vector<float> texcoords = _mesh->getUVCoords();
+                vector<float> normals = _mesh->getNormals();
+                vector<float> annexe = _mesh->getAnnexe();
+                auto getData = [](vector<float>& array) { return array.empty() ? nullptr : array.data(); };
+
+                _verticesNumber = vertices.size() / 4;
+                _glBuffers = createStaticBuffers(_verticesNumber, vertices.data(), getData(texcoords), getData(normals), getData(annexe));
+            }
+            else
+            {
+                vector<float> vertices = _mesh->getVertCoords();
+                if (vertices.empty())
+                    return;
+
+                // Dynamic meshes are rewritten continuously, their buffers are streamed as is
+                const auto streaming = true;
+                const auto usage = GL_STREAM_DRAW;
+
+                _verticesNumber = vertices.size() / 4;
+                _glBuffers.push_back(make_shared<GpuBuffer>(4, GL_FLOAT, usage, _verticesNumber, vertices.data(), streaming));
+
+                vector<float> texcoords = _mesh->getUVCoords();
+                if (!texcoords.empty())
+                    _glBuffers.push_back(make_shared<GpuBuffer>(2, GL_FLOAT, usage, _verticesNumber, texcoords.data(), streaming));
+                else
+                    _glBuffers.push_back(make_shared<GpuBuffer>(2, GL_FLOAT, usage, _verticesNumber, nullptr, streaming));
+
+                vector<float> normals = _mesh->getNormals();
+                if (!normals.empty())
+                    _glBuffers.push_back(make_shared<GpuBuffer>(4, GL_FLOAT, usage, _verticesNumber, normals.data(), streaming));
+                else
+                    _glBuffers.push_back(make_shared<GpuBuffer>(4, GL_FLOAT, usage, _verticesNumber, nullptr, streaming));
+
+                // An additional annexe buffer, to be filled by compute shaders. Contains a vec4 for each vertex
+                vector<float> annexe = _mesh->getAnnexe();
+                if (!annexe.empty())
+                    _glBuffers.push_back(make_shared<GpuBuffer>(4, GL_FLOAT, usage, _verticesNumber, annexe.data(), streaming));
+                else
+                    _glBuffers.push_back(make_shared<GpuBuffer>(4, GL_FLOAT, usage, _verticesNumber, nullptr, streaming));
+            }
+        }
 
         for (auto& v : _vertexArray)
             glDeleteVertexArrays(1, &(v.second));
@@ -270,14 +360,22 @@ void Geometry::update()
 
         _timestamp = _mesh->getTimestamp();
 
+        // Levels of detail are uploaded again once the mesh generated them
+        _glLodBuffers.clear();
+        _lodVerticesNumbers.clear();
+        _levelsOfDetail.reset();
+        _levelOfDetail = 0;
+
         _buffersDirty = true;
     }
 
     if (_glBuffers.empty())
         return;
 
+    updateLevelsOfDetail();
+
     // If a serialized geometry is present, we use it as the alternative buffer
-    if (!_onMasterScene && _serializedMesh.size() != 0)
+    if ((!_onMasterScene || _forceSerializedMesh) && _serializedMesh.size() != 0)
     {
         lock_guard<shared_mutex> lock(_writeMutex);
 
@@ -313,6 +411,7 @@ void Geometry::update()
         swapBuffers();
         _buffersDirty = true;
         _serializedMesh.resize(0);
+        _forceSerializedMesh = false;
     }
 
     GLFWwindow* context = glfwGetCurrentContext();
@@ -328,7 +427,8 @@ void Geometry::update()
 
         glBindVertexArray(vertexArrayIt->second);
 
-        for (uint32_t idx = 0; idx < _glBuffers.size(); ++idx)
+        const auto& buffers = getLevelBuffers();
+        for (uint32_t idx = 0; idx < buffers.size(); ++idx)
         {
             if (_useAlternativeBuffers && _glAlternativeBuffers.size() != 0 && _glAlternativeBuffers[0])
             {
@@ -337,8 +437,14 @@ void Geometry::update()
             }
             else
             {
-                glBindBuffer(GL_ARRAY_BUFFER, _glBuffers[idx]->getId());
-                glVertexAttribPointer((GLuint)idx, _glBuffers[idx]->getElementSize(), GL_FLOAT, GL_FALSE, 0, 0);
+                glBindBuffer(GL_ARRAY_BUFFER, buffers[idx]->getId());
+                // Compact buffers hold normalized integers, converted back to floats by the vertex fetch
+                glVertexAttribPointer((GLuint)idx,
+                    buffers[idx]->getElementSize(),
+                    buffers[idx]->getType(),
+                    buffers[idx]->isNormalized() ? GL_TRUE : GL_FALSE,
+                    0,
+                    reinterpret_cast<const GLvoid*>(buffers[idx]->getOffset()));
             }
             glEnableVertexAttribArray((GLuint)idx);
         }
@@ -350,6 +456,73 @@ void Geometry::update()
     }
 }
 
+/*************/
+vector<shared_ptr<GpuBuffer>> Geometry::createStaticBuffers(int verticesNumber, float* vertices, float* texCoords, float* normals, float* annexe) const
+{
+    vector<shared_ptr<GpuBuffer>> buffers;
+    buffers.push_back(make_shared<GpuBuffer>(4, GL_FLOAT, GL_STATIC_DRAW, verticesNumber, vertices));
+
+    const auto compact = _mesh->hasCompactVertexAttributes();
+    vector<uint16_t> packedTexCoords;
+    if (compact && texCoords && VertexPacking::packTexCoords(texCoords, verticesNumber, packedTexCoords))
+        buffers.push_back(make_shared<GpuBuffer>(2, GL_UNSIGNED_SHORT, GL_STATIC_DRAW, verticesNumber, packedTexCoords.data()));
+    else
+        buffers.push_back(make_shared<GpuBuffer>(2, GL_FLOAT, GL_STATIC_DRAW, verticesNumber, texCoords));
+
+    if (compact && normals)
+    {
+        auto packedNormals = VertexPacking::packNormals(normals, verticesNumber);
+        buffers.push_back(make_shared<GpuBuffer>(4, GL_INT_2_10_10_10_REV, GL_STATIC_DRAW, verticesNumber, packedNormals.data()));
+    }
+    else
+    {
+        buffers.push_back(make_shared<GpuBuffer>(4, GL_FLOAT, GL_STATIC_DRAW, verticesNumber, normals));
+    }
+
+    // The annexe is filled by compute shaders, and holds values which do not fit in less than a float
+    buffers.push_back(make_shared<GpuBuffer>(4, GL_FLOAT, GL_STATIC_DRAW, verticesNumber, annexe));
+    return buffers;
+}
+
+/*************/
+void Geometry::updateLevelsOfDetail()
+{
+    auto levelsOfDetail = _mesh->getLevelsOfDetail();
+    if (levelsOfDetail == _levelsOfDetail)
+        return;
+
+    _glLodBuffers.clear();
+    _lodVerticesNumbers.clear();
+    if (levelsOfDetail)
+    {
+        for (const auto& level : levelsOfDetail->levels)
+        {
+            const auto& arrays = level.arrays;
+            auto verticesNumber = static_cast<int>(arrays.vertices.size() / 4);
+            auto getData = [](const vector<float>& array) { return array.empty() ? nullptr : const_cast<float*>(array.data()); };
+            _glLodBuffers.push_back(createStaticBuffers(verticesNumber, getData(arrays.vertices), getData(arrays.uvs), getData(arrays.normals), getData(arrays.annexe)));
+            _lodVerticesNumbers.push_back(verticesNumber);
+        }
+    }
+
+    _levelsOfDetail = levelsOfDetail;
+    _levelOfDetail = 0;
+    _buffersDirty = true;
+}
+
+/*************/
+void Geometry::setLevelOfDetail(int level)
+{
+    level = std::clamp(level, 0, static_cast<int>(_glLodBuffers.size()));
+    if (level == _levelOfDetail)
+        return;
+
+    _levelOfDetail = level;
+    // The vertex array only has to be updated if it points to the level buffers
+    if (!_useAlternativeBuffers)
+        _buffersDirty = true;
+}
+
 /*************/
 void Geometry::useAlternativeBuffers(bool isActive)
 {
@@ -90,7 +90,31 @@ class Geometry : public BufferObject
      * \brief Get the number of vertices for this geometry
      * \return Return the vertice count
      */
-    int getVerticesNumber() const { return _useAlternativeBuffers ? _alternativeVerticesNumber : _verticesNumber; }
+    int getVerticesNumber() const
+    {
+        if (_useAlternativeBuffers)
+            return _alternativeVerticesNumber;
+        return _levelOfDetail == 0 ? _verticesNumber : _lodVerticesNumbers[_levelOfDetail - 1];
+    }
+
+    /**
+     * \brief Get the levels of detail uploaded to the GPU
+     * \return Return the levels of detail, or nullptr if none
+     */
+    std::shared_ptr<const Mesh::LevelsOfDetail> getLevelsOfDetail() const { return _levelsOfDetail; }
+
+    /**
+     * \brief Set the level of detail to draw, and to tessellate from for the blending
+     * It has no effect on the alternative buffers, which are drawn when set.
+     * \param level Level of detail, 0 being the full resolution mesh. Clamped to the uploaded levels.
+     */
+    void setLevelOfDetail(int level);
+
+    /**
+     * Get the memory held by the GPU buffers, and by the serialized mesh waiting to be uploaded
+     * \return Return the memory usage
+     */
+    MemoryUsage getMemoryUsage() const override;
 
     /**
      * \brief Get the geometry as serialized
@@ -105,12 +129,26 @@ class Geometry : public BufferObject
      */
     bool deserialize(const std::shared_ptr<SerializedObject>& obj) override;
 
+    /**
+     * \brief Use the given serialized geometry as the alternative buffers, at the next update
+     * Contrary to deserialize(), this also applies on the master scene, for example to restore a cached blending
+     * \param obj Serialized object, as returned by serialize()
+     * \return Return true if the serialized object is valid
+     */
+    bool setAlternativeBuffers(const std::shared_ptr<SerializedObject>& obj);
+
     /**
      * Get the timestamp
      * \return Return the timestamp
      */
     virtual int64_t getTimestamp() const final { return _mesh ? _mesh->getTimestamp() : 0; }
 
+    /**
+     * \brief Get the mesh this geometry is set from
+     * \return Return the mesh
+     */
+    std::shared_ptr<Mesh> getMesh() const { return _mesh; }
+
     /**
      * \brief Get whether the alternative buffers have been resized during the last feedback call
      * \return Return true if the buffers have been resized
@@ -168,11 +206,16 @@ class Geometry : public BufferObject
     std::vector<std::shared_ptr<GpuBuffer>> _glBuffers{};
     std::vector<std::shared_ptr<GpuBuffer>> _glAlternativeBuffers{}; // Alternative buffers used for rendering
     std::vector<std::shared_ptr<GpuBuffer>> _glTemporaryBuffers{};   // Temporary buffers used for feedback
+    std::vector<std::vector<std::shared_ptr<GpuBuffer>>> _glLodBuffers{}; // Buffers of the levels of detail, from the finest to the coarsest
+    std::vector<int> _lodVerticesNumbers{};
+    std::shared_ptr<const Mesh::LevelsOfDetail> _levelsOfDetail{nullptr}; // Levels of detail uploaded to _glLodBuffers
+    int _levelOfDetail{0};                                                 // Level of detail in use, 0 being the full resolution _glBuffers
     bool _buffersDirty{false};
     bool _buffersResized{false}; // Holds whether the alternative buffers have been resized in the previous feedback
     bool _useAlternativeBuffers{false};
 
     SerializedObject _serializedMesh{};
+    bool _forceSerializedMesh{false}; // If true, _serializedMesh is applied even on the master scene
 
     int _verticesNumber{0};
     int _alternativeVerticesNumber{0};
@@ -184,11 +227,35 @@ class Geometry : public BufferObject
     GLuint _feedbackQuery;
     int _feedbackMaxNbrPrimitives{0};
 
+    /**
+     * \brief Get the buffers of the level of detail in use
+     * \return Return the buffers
+     */
+    const std::vector<std::shared_ptr<GpuBuffer>>& getLevelBuffers() const { return _levelOfDetail == 0 ? _glBuffers : _glLodBuffers[_levelOfDetail - 1]; }
+
+    /**
+     * \brief Create the buffers of a static mesh, with compact texture coordinates and normals if the mesh allows for it
+     * Texture coordinates are then stored as 16 bits normalized integers if they lie in [0, 1], and normals in
+     * the 2_10_10_10 format. Vertices and annexe are kept as floats, the latter holding primitive IDs and blending sums.
+     * \param verticesNumber Vertex count
+     * \param vertices Vertices, four floats each
+     * \param texCoords Texture coordinates, two floats each, or nullptr
+     * \param normals Normals, four floats each, or nullptr
+     * \param annexe Annexe, four floats each, or nullptr
+     * \return Return the vertex, texture coordinates, normal and annexe buffers
+     */
+    std::vector<std::shared_ptr<GpuBuffer>> createStaticBuffers(int verticesNumber, float* vertices, float* texCoords, float* normals, float* annexe) const;
+
     /**
      * \brief Initialization
      */
     void init();
 
+    /**
+     * \brief Upload the levels of detail of the mesh, once available
+     */
+    void updateLevelsOfDetail();
+
     /**
      * Register new functors to modify attributes
      */
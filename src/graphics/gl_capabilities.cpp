@@ -0,0 +1,186 @@
+#include "./graphics/gl_capabilities.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <unistd.h>
+
+#include "./utils/jsonutils.h"
+#include "./utils/log.h"
+#include "./utils/osutils.h"
+
+using namespace std;
+
+namespace Splash
+{
+
+/*************/
+string GlCapabilities::getCacheKey(bool headless)
+{
+    string key;
+    if (headless)
+        key = "headless";
+    else if (auto waylandDisplay = getenv("WAYLAND_DISPLAY"); waylandDisplay != nullptr && string(waylandDisplay) != "")
+        key = "wayland:" + string(waylandDisplay);
+    else if (auto display = getenv("DISPLAY"); display != nullptr)
+        key = "x11:" + string(display);
+    else
+        key = "x11:";
+
+    // The proprietary NVIDIA driver exposes its version without a context, other drivers
+    // being identified by their GL_VERSION string once the context is created
+    ifstream nvidiaVersion("/proc/driver/nvidia/version");
+    string driverLine;
+    if (nvidiaVersion && getline(nvidiaVersion, driverLine))
+        key += "|" + driverLine;
+
+    return key;
+}
+
+/*************/
+string GlCapabilities::getCacheFilePath()
+{
+    return Utils::getCachePath() + "/gl_capabilities.json";
+}
+
+/*************/
+optional<GlCapabilities> GlCapabilities::readFromCache(const string& key)
+{
+    auto cachePath = getCacheFilePath();
+    error_code errorCode;
+    if (!filesystem::exists(cachePath, errorCode))
+        return {};
+
+    Json::Value cache;
+    if (!Utils::loadJsonFile(cachePath, cache) || !cache.isObject())
+        return {};
+    if (cache["version"].asInt() != SPLASH_GL_CAPABILITIES_CACHE_VERSION || !cache["entries"].isObject() || !cache["entries"].isMember(key))
+        return {};
+
+    return fromJson(cache["entries"][key]);
+}
+
+/*************/
+void GlCapabilities::writeToCache(const string& key, const GlCapabilities& capabilities)
+{
+    auto cachePath = getCacheFilePath();
+    error_code errorCode;
+    filesystem::create_directories(filesystem::path(cachePath).parent_path(), errorCode);
+    if (errorCode)
+    {
+        Log::get() << Log::WARNING << "GlCapabilities::" << __FUNCTION__ << " - Unable to create cache directory for " << cachePath << ": " << errorCode.message() << Log::endl;
+        return;
+    }
+
+    // Entries for other displays and drivers are kept
+    Json::Value cache;
+    if (!filesystem::exists(cachePath, errorCode) || !Utils::loadJsonFile(cachePath, cache) || !cache.isObject() || cache["version"].asInt() != SPLASH_GL_CAPABILITIES_CACHE_VERSION)
+        cache = Json::Value(Json::objectValue);
+    cache["version"] = SPLASH_GL_CAPABILITIES_CACHE_VERSION;
+    cache["entries"][key] = capabilities.toJson();
+
+    // Written to a temporary file first, as multiple Scenes may start at the same time
+    auto tmpPath = cachePath + "." + to_string(getpid()) + ".tmp";
+    {
+        Json::StreamWriterBuilder writerBuilder;
+        ofstream file(tmpPath, ios::out | ios::trunc);
+        file << Json::writeString(writerBuilder, cache);
+        if (!file)
+        {
+            Log::get() << Log::WARNING << "GlCapabilities::" << __FUNCTION__ << " - Unable to write cache file " << tmpPath << Log::endl;
+            file.close();
+            filesystem::remove(tmpPath, errorCode);
+            return;
+        }
+    }
+
+    filesystem::rename(tmpPath, cachePath, errorCode);
+    if (errorCode)
+        filesystem::remove(tmpPath, errorCode);
+}
+
+/*************/
+GlCapabilities GlCapabilities::queryIdentity(const vector<int>& glVersion)
+{
+    const auto getString = [](GLenum name) {
+        auto str = reinterpret_cast<const char*>(glGetString(name));
+        return str ? string(str) : string();
+    };
+
+    GlCapabilities capabilities;
+    capabilities.glVersion = glVersion;
+    capabilities.versionString = getString(GL_VERSION);
+    capabilities.vendor = getString(GL_VENDOR);
+    capabilities.renderer = getString(GL_RENDERER);
+    return capabilities;
+}
+
+/*************/
+void GlCapabilities::queryExtensionsAndLimits()
+{
+    GLint extensionCount = 0;
+    glGetIntegerv(GL_NUM_EXTENSIONS, &extensionCount);
+    extensions.clear();
+    for (GLint i = 0; i < extensionCount; ++i)
+        if (auto extension = reinterpret_cast<const char*>(glGetStringi(GL_EXTENSIONS, i)); extension)
+            extensions.insert(extension);
+
+    glGetIntegerv(GL_MAX_TEXTURE_SIZE, &maxTextureSize);
+    glGetIntegerv(GL_MAX_SAMPLES, &maxSamples);
+    glGetIntegerv(GL_MAX_COMBINED_TEXTURE_IMAGE_UNITS, &maxCombinedTextureImageUnits);
+}
+
+/*************/
+bool GlCapabilities::isSameImplementation(const GlCapabilities& other) const
+{
+    return glVersion == other.glVersion && versionString == other.versionString && vendor == other.vendor && renderer == other.renderer;
+}
+
+/*************/
+Json::Value GlCapabilities::toJson() const
+{
+    Json::Value json;
+    json["glVersion"] = Json::Value(Json::arrayValue);
+    for (auto v : glVersion)
+        json["glVersion"].append(v);
+    json["versionString"] = versionString;
+    json["vendor"] = vendor;
+    json["renderer"] = renderer;
+
+    // Sorted so that the cache file does not change from one run to the next
+    vector<string> sortedExtensions(extensions.begin(), extensions.end());
+    sort(sortedExtensions.begin(), sortedExtensions.end());
+    json["extensions"] = Json::Value(Json::arrayValue);
+    for (const auto& extension : sortedExtensions)
+        json["extensions"].append(extension);
+
+    json["maxTextureSize"] = maxTextureSize;
+    json["maxSamples"] = maxSamples;
+    json["maxCombinedTextureImageUnits"] = maxCombinedTextureImageUnits;
+    return json;
+}
+
+/*************/
+optional<GlCapabilities> GlCapabilities::fromJson(const Json::Value& json)
+{
+    if (!json.isObject() || !json["glVersion"].isArray() || json["glVersion"].size() != 2 || !json["extensions"].isArray())
+        return {};
+
+    GlCapabilities capabilities;
+    capabilities.glVersion = {json["glVersion"][0].asInt(), json["glVersion"][1].asInt()};
+    capabilities.versionString = json["versionString"].asString();
+    capabilities.vendor = json["vendor"].asString();
+    capabilities.renderer = json["renderer"].asString();
+    for (const auto& extension : json["extensions"])
+        capabilities.extensions.insert(extension.asString());
+    capabilities.maxTextureSize = json["maxTextureSize"].asInt();
+    capabilities.maxSamples = json["maxSamples"].asInt();
+    capabilities.maxCombinedTextureImageUnits = json["maxCombinedTextureImageUnits"].asInt();
+
+    if (capabilities.glVersion[0] == 0)
+        return {};
+    return capabilities;
+}
+
+} // namespace Splash
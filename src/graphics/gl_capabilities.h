@@ -0,0 +1,120 @@
+/*
+ * Copyright (C) 2026 Emmanuel Durand
+ *
+ * This file is part of Splash.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Splash is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Splash.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * @gl_capabilities.h
+ * Capabilities of the OpenGL implementation, cached across runs
+ */
+
+#ifndef SPLASH_GL_CAPABILITIES_H
+#define SPLASH_GL_CAPABILITIES_H
+
+#include <optional>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+#include <json/json.h>
+
+#include "./core/constants.h"
+
+// Version of the capability cache layout, cached entries with another version being ignored
+#define SPLASH_GL_CAPABILITIES_CACHE_VERSION 1
+
+namespace Splash
+{
+
+/*************/
+//! Capabilities of the OpenGL implementation, as found once a context is current
+//! They are cached per display and driver, so that the next Scenes can create their context
+//! with the cached GL version directly instead of probing it with trial windows.
+struct GlCapabilities
+{
+    std::vector<int> glVersion{0, 0};             //!< GL version the context has been created with, as {MAJOR, MINOR}
+    std::string versionString{};                  //!< GL_VERSION string, which holds the driver version
+    std::string vendor{};                         //!< GL_VENDOR string
+    std::string renderer{};                       //!< GL_RENDERER string
+    std::unordered_set<std::string> extensions{}; //!< Supported GL extensions
+    int maxTextureSize{0};                        //!< GL_MAX_TEXTURE_SIZE
+    int maxSamples{0};                            //!< GL_MAX_SAMPLES
+    int maxCombinedTextureImageUnits{0};          //!< GL_MAX_COMBINED_TEXTURE_IMAGE_UNITS
+
+    /**
+     * \brief Get the key the capabilities are cached with, identifying the display and, when available without a context, the driver
+     * \param headless True if the contexts are created without a display server
+     * \return Return the cache key
+     */
+    static std::string getCacheKey(bool headless);
+
+    /**
+     * \brief Get the path to the capability cache file
+     * \return Return the path
+     */
+    static std::string getCacheFilePath();
+
+    /**
+     * \brief Read the capabilities cached for the given key
+     * \param key Cache key
+     * \return Return the capabilities, or nothing if none is cached for this key
+     */
+    static std::optional<GlCapabilities> readFromCache(const std::string& key);
+
+    /**
+     * \brief Cache the capabilities for the given key, replacing any previous entry
+     * \param key Cache key
+     * \param capabilities Capabilities to cache
+     */
+    static void writeToCache(const std::string& key, const GlCapabilities& capabilities);
+
+    /**
+     * \brief Query the identification strings of the current context, which are cheap to get
+     * \param glVersion GL version the context has been created with
+     * \return Return the capabilities, without the extensions and limits
+     */
+    static GlCapabilities queryIdentity(const std::vector<int>& glVersion);
+
+    /**
+     * \brief Query the extensions and limits of the current context
+     */
+    void queryExtensionsAndLimits();
+
+    /**
+     * \brief Check whether these capabilities have been found for the same implementation and driver as others
+     * \param other Other capabilities
+     * \return Return true if the GL version and the identification strings match
+     */
+    bool isSameImplementation(const GlCapabilities& other) const;
+
+    /**
+     * \brief Check whether an extension is supported
+     * \param extension Extension name
+     * \return Return true if it is supported
+     */
+    bool hasExtension(const std::string& extension) const { return extensions.find(extension) != extensions.end(); }
+
+    /**
+     * \brief Convert to and from Json, as stored in the cache
+     */
+    Json::Value toJson() const;
+    static std::optional<GlCapabilities> fromJson(const Json::Value& json);
+};
+
+} // namespace Splash
+
+#endif // SPLASH_GL_CAPABILITIES_H
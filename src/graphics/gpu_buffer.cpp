@@ -1,12 +1,21 @@
 #include "./graphics/gpu_buffer.h"
 
+#include <algorithm>
+#include <cstring>
+#include <limits>
+
+#include "./utils/log.h"
+
+// Regions are aligned so that they can be bound as shader storage buffers
+#define SPLASH_GPU_BUFFER_REGION_ALIGNMENT 256
+
 using namespace std;
 
 namespace Splash
 {
 
 /*************/
-GpuBuffer::GpuBuffer(GLint elementSize, GLenum type, GLenum usage, size_t size, GLvoid* data)
+GpuBuffer::GpuBuffer(GLint elementSize, GLenum type, GLenum usage, size_t size, GLvoid* data, bool streaming)
 {
     glCreateBuffers(1, &_glId);
     switch (type)
@@ -23,6 +32,13 @@ GpuBuffer::GpuBuffer(GLint elementSize, GLenum type, GLenum usage, size_t size,
     case GL_SHORT:
         _baseSize = sizeof(short);
         break;
+    case GL_UNSIGNED_SHORT:
+        _baseSize = sizeof(unsigned short);
+        break;
+    case GL_INT_2_10_10_10_REV:
+        // Four components packed in 32 bits, each entry must then have four components
+        _baseSize = sizeof(uint32_t) / 4;
+        break;
     case GL_UNSIGNED_BYTE:
         _baseSize = sizeof(unsigned char);
         break;
@@ -38,7 +54,15 @@ GpuBuffer::GpuBuffer(GLint elementSize, GLenum type, GLenum usage, size_t size,
     _type = type;
     _usage = usage;
 
-    if (data == nullptr)
+    if (streaming && allocateStreamingStorage(size))
+    {
+        if (data == nullptr)
+            memset(_mappedData, 0, getMemorySize());
+        else
+            memcpy(_mappedData, data, getMemorySize());
+        _regionStaleRanges[0] = {0, 0};
+    }
+    else if (data == nullptr)
     {
         auto zeroBuffer = vector<char>(size * _elementSize * _baseSize, 0);
         glNamedBufferData(_glId, size * _elementSize * _baseSize, zeroBuffer.data(), usage);
@@ -52,6 +76,7 @@ GpuBuffer::GpuBuffer(GLint elementSize, GLenum type, GLenum usage, size_t size,
 /*************/
 GpuBuffer::~GpuBuffer()
 {
+    deleteRegionFences();
     if (_glId)
         glDeleteBuffers(1, &_glId);
     if (_copyBufferId)
@@ -64,7 +89,12 @@ void GpuBuffer::clear()
     if (!_glId)
         return;
 
-    glClearNamedBufferData(_glId, GL_R8, GL_RED, _type, NULL);
+    // Packed types can not describe a single red component
+    auto type = _type == GL_INT_2_10_10_10_REV ? GL_UNSIGNED_BYTE : _type;
+    if (_streaming)
+        glClearNamedBufferSubData(_glId, GL_R8, getOffset(), getMemorySize(), GL_RED, type, NULL);
+    else
+        glClearNamedBufferData(_glId, GL_R8, GL_RED, type, NULL);
 }
 
 /*************/
@@ -97,7 +127,7 @@ vector<char> GpuBuffer::getBufferAsVector(size_t vertexNbr)
     }
 
     // Copy the actual buffer to the copy buffer
-    glCopyNamedBufferSubData(_glId, _copyBufferId, 0, 0, vectorSize);
+    glCopyNamedBufferSubData(_glId, _copyBufferId, getOffset(), 0, vectorSize);
 
     // Read the copy buffer
     auto buffer = vector<char>(vectorSize);
@@ -112,18 +142,200 @@ void GpuBuffer::setBufferFromVector(const vector<char>& buffer)
     if (!_glId || !_type || !_usage || !_elementSize)
         return;
 
+    if (_streaming)
+    {
+        stream(buffer.data(), buffer.size() / (_baseSize * _elementSize));
+        return;
+    }
+
     if (buffer.size() > _baseSize * _elementSize * _size)
         resize(buffer.size());
 
     glNamedBufferSubData(_glId, 0, buffer.size(), buffer.data());
 }
 
+/*************/
+void GpuBuffer::stream(const GLvoid* data, size_t size)
+{
+    if (!_glId || !_type || !_usage || !_elementSize)
+        return;
+
+    auto memorySize = size * _elementSize * _baseSize;
+
+    if (_streaming)
+        nextRegion(size);
+
+    if (_streaming)
+    {
+        _size = size;
+        if (data == nullptr)
+            memset(_mappedData + getOffset(), 0, memorySize);
+        else
+            memcpy(_mappedData + getOffset(), data, memorySize);
+
+        // All the other regions now hold outdated content
+        for (auto& range : _regionStaleRanges)
+            range = {0, numeric_limits<size_t>::max()};
+        _regionStaleRanges[_regionIndex] = {0, 0};
+        return;
+    }
+
+    // Fallback when persistent mapping is not available
+    if (size > _size)
+        resize(size);
+    _size = size;
+    if (data == nullptr)
+        glClearNamedBufferSubData(_glId, GL_R8, 0, memorySize, GL_RED, _type, NULL);
+    else
+        glNamedBufferSubData(_glId, 0, memorySize, data);
+}
+
+/*************/
+void GpuBuffer::stream(const GLvoid* data, size_t size, size_t first, size_t count)
+{
+    if (!_glId || !_type || !_usage || !_elementSize)
+        return;
+
+    if (data == nullptr || size != _size || first + count > size)
+    {
+        stream(data, size);
+        return;
+    }
+
+    auto entrySize = _elementSize * _baseSize;
+    auto source = static_cast<const uint8_t*>(data);
+
+    if (!_streaming)
+    {
+        if (count != 0)
+            glNamedBufferSubData(_glId, first * entrySize, count * entrySize, source + first * entrySize);
+        return;
+    }
+
+    nextRegion(size);
+    if (!_streaming)
+    {
+        stream(data, size);
+        return;
+    }
+
+    // The region also has to catch up with the entries changed since it was last filled
+    auto& staleRange = _regionStaleRanges[_regionIndex];
+    auto begin = first;
+    auto end = first + count;
+    if (staleRange.first < staleRange.second)
+    {
+        begin = std::min(begin, staleRange.first);
+        end = std::max(end, std::min(staleRange.second, size));
+    }
+
+    if (begin < end)
+        memcpy(_mappedData + getOffset() + begin * entrySize, source + begin * entrySize, (end - begin) * entrySize);
+
+    staleRange = {0, 0};
+    if (count == 0)
+        return;
+
+    for (uint32_t region = 0; region < _regionStaleRanges.size(); ++region)
+    {
+        if (region == _regionIndex)
+            continue;
+        auto& range = _regionStaleRanges[region];
+        if (range.first < range.second)
+            range = {std::min(range.first, first), std::max(range.second, first + count)};
+        else
+            range = {first, first + count};
+    }
+}
+
+/*************/
+void GpuBuffer::nextRegion(size_t size)
+{
+    // The region being left may still be read by the commands issued since it was filled
+    if (_regionFences[_regionIndex])
+        glDeleteSync(_regionFences[_regionIndex]);
+    _regionFences[_regionIndex] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+    if (size * _elementSize * _baseSize > _regionSize)
+    {
+        // Keep some margin, so that slight growths do not trigger new allocations
+        allocateStreamingStorage(size + size / 2);
+        return;
+    }
+
+    _regionIndex = (_regionIndex + 1) % SPLASH_GPU_BUFFER_STREAMING_REGIONS;
+
+    // The fence is usually signaled already, as the region was last used a few updates ago
+    auto& fence = _regionFences[_regionIndex];
+    if (fence)
+    {
+        while (glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000) == GL_TIMEOUT_EXPIRED)
+            continue;
+        glDeleteSync(fence);
+        fence = nullptr;
+    }
+}
+
+/*************/
+bool GpuBuffer::allocateStreamingStorage(size_t size)
+{
+    deleteRegionFences();
+    _streaming = false;
+    _mappedData = nullptr;
+    _regionIndex = 0;
+
+    // Buffer storage is immutable, so a new buffer is needed each time
+    if (_glId)
+        glDeleteBuffers(1, &_glId);
+    glCreateBuffers(1, &_glId);
+    if (!_glId)
+        return false;
+
+    auto memorySize = std::max<size_t>(size * _elementSize * _baseSize, 1);
+    _regionSize = ((memorySize + SPLASH_GPU_BUFFER_REGION_ALIGNMENT - 1) / SPLASH_GPU_BUFFER_REGION_ALIGNMENT) * SPLASH_GPU_BUFFER_REGION_ALIGNMENT;
+
+    auto flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+    glNamedBufferStorage(_glId, _regionSize * SPLASH_GPU_BUFFER_STREAMING_REGIONS, nullptr, flags);
+    _mappedData = static_cast<uint8_t*>(glMapNamedBufferRange(_glId, 0, _regionSize * SPLASH_GPU_BUFFER_STREAMING_REGIONS, flags));
+
+    if (!_mappedData)
+    {
+        Log::get() << Log::WARNING << "GpuBuffer::" << __FUNCTION__ << " - Unable to map streaming buffer, falling back to a regular buffer" << Log::endl;
+        glDeleteBuffers(1, &_glId);
+        glCreateBuffers(1, &_glId);
+        glNamedBufferData(_glId, size * _elementSize * _baseSize, nullptr, _usage);
+        _size = size;
+        return false;
+    }
+
+    _regionFences.resize(SPLASH_GPU_BUFFER_STREAMING_REGIONS, nullptr);
+    _regionStaleRanges.assign(SPLASH_GPU_BUFFER_STREAMING_REGIONS, {0, numeric_limits<size_t>::max()});
+    _streaming = true;
+    _size = size;
+    return true;
+}
+
+/*************/
+void GpuBuffer::deleteRegionFences()
+{
+    for (auto& fence : _regionFences)
+        if (fence)
+            glDeleteSync(fence);
+    _regionFences.clear();
+}
+
 /*************/
 void GpuBuffer::resize(size_t size)
 {
     if (!_type || !_usage || !_elementSize)
         return;
 
+    if (_streaming)
+    {
+        allocateStreamingStorage(size);
+        return;
+    }
+
     glDeleteBuffers(1, &_glId);
     glCreateBuffers(1, &_glId);
     if (!_glId)
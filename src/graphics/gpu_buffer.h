@@ -35,6 +35,9 @@
 #include "./core/attribute.h"
 #include "./mesh/mesh.h"
 
+// Number of regions in the ring of a streaming buffer
+#define SPLASH_GPU_BUFFER_STREAMING_REGIONS 3
+
 namespace Splash
 {
 
@@ -48,8 +51,9 @@ class GpuBuffer
      * \param usage Buffer usage, as per OpenGL specs
      * \param size Number of entries
      * \param data Pointer to data to initialized the buffer with
+     * \param streaming If true, the buffer is a persistently mapped ring of regions, meant to be updated through stream()
      */
-    GpuBuffer(GLint elementSize, GLenum type, GLenum usage, size_t size, GLvoid* data = nullptr);
+    GpuBuffer(GLint elementSize, GLenum type, GLenum usage, size_t size, GLvoid* data = nullptr, bool streaming = false);
 
     /**
      * \brief Destructor
@@ -110,6 +114,18 @@ class GpuBuffer
      */
     inline size_t getMemorySize() const { return _size * _baseSize * _elementSize; }
 
+    /**
+     * \brief Get the offset in bytes of the data in the GL buffer, which changes with each call to stream()
+     * \return Return the offset, always 0 for non streaming buffers
+     */
+    inline size_t getOffset() const { return _streaming ? _regionIndex * _regionSize : 0; }
+
+    /**
+     * \brief Check whether this is a streaming buffer
+     * \return Return true if the buffer is streaming
+     */
+    inline bool isStreaming() const { return _streaming; }
+
     /**
      * Get the content of the buffer
      * One can specify the vertex number to get, with care!
@@ -128,6 +144,18 @@ class GpuBuffer
      */
     inline size_t getElementSize() const { return _elementSize; }
 
+    /**
+     * \brief Get the component type
+     * \return Return the component type, as per OpenGL specs
+     */
+    inline GLenum getType() const { return _type; }
+
+    /**
+     * \brief Check whether the components are integers to be read as normalized floats by the vertex fetch
+     * \return Return true if the components are normalized
+     */
+    inline bool isNormalized() const { return _type != GL_FLOAT && _type != GL_HALF_FLOAT; }
+
     /**
      * \brief Resize the GL buffer
      * \param size Entry count
@@ -140,6 +168,26 @@ class GpuBuffer
      */
     void setBufferFromVector(const std::vector<char>& buffer);
 
+    /**
+     * \brief Write new content to the next region of a streaming buffer, once the GPU is done reading it
+     * The GL buffer is only reallocated if the content does not fit in the regions anymore. Either way,
+     * the offset changes and the buffer has to be bound again.
+     * \param data Source data, the region is filled with 0 if nullptr
+     * \param size Entry count
+     */
+    void stream(const GLvoid* data, size_t size);
+
+    /**
+     * \brief Write new content to the next region of a streaming buffer, knowing which entries changed since the last call
+     * Only the given entries, and the ones changed since the region was last filled, are copied. The whole
+     * content is copied if the size changed, or if no data is given.
+     * \param data Source data, holding all the entries
+     * \param size Entry count
+     * \param first First changed entry
+     * \param count Changed entry count
+     */
+    void stream(const GLvoid* data, size_t size, size_t first, size_t count);
+
   private:
     GLuint _glId{0};
     size_t _size{0};
@@ -149,6 +197,33 @@ class GpuBuffer
     GLenum _usage{0};
 
     GLuint _copyBufferId{0};
+
+    // Streaming buffer
+    bool _streaming{false};
+    size_t _regionSize{0}; //!< Size in bytes of each region
+    uint32_t _regionIndex{0};
+    uint8_t* _mappedData{nullptr};
+    std::vector<GLsync> _regionFences{}; //!< Fences set when leaving a region, signaled once the GPU is done reading it
+    std::vector<std::pair<size_t, size_t>> _regionStaleRanges{}; //!< Entries changed since each region was last filled, as [begin, end)
+
+    /**
+     * \brief Allocate the persistently mapped storage of a streaming buffer
+     * \param size Entry count each region can hold
+     * \return Return true if the storage has been allocated and mapped
+     */
+    bool allocateStreamingStorage(size_t size);
+
+    /**
+     * \brief Move to the next region of a streaming buffer, waiting for the GPU to be done reading it
+     * The storage is reallocated if the content does not fit in the regions anymore
+     * \param size Entry count to be written
+     */
+    void nextRegion(size_t size);
+
+    /**
+     * \brief Delete all the region fences
+     */
+    void deleteRegionFences();
 };
 
 } // end of namespace
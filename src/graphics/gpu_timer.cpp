@@ -0,0 +1,97 @@
+#include "./graphics/gpu_timer.h"
+
+#include "./utils/trace_recorder.h"
+
+using namespace std;
+
+namespace Splash
+{
+
+/*************/
+GpuTimer::~GpuTimer()
+{
+    if (!_initialized)
+        return;
+
+    for (auto& measure : _measures)
+        glDeleteQueries(2, measure.queries);
+}
+
+/*************/
+void GpuTimer::begin()
+{
+    if (_running)
+        return;
+
+    if (!_initialized)
+    {
+        for (auto& measure : _measures)
+            glGenQueries(2, measure.queries);
+        _initialized = true;
+    }
+
+    // All measures are in flight, drop this one rather than waiting for the oldest
+    auto& measure = _measures[_current];
+    if (measure.pending)
+        return;
+
+    // Reading the GPU clock does not wait for the pending commands, but it still is a round trip to the driver
+    if (!_traceName.empty() && TraceRecorder::get().isRecording())
+    {
+        GLint64 gpuTime = 0;
+        glGetInteger64v(GL_TIMESTAMP, &gpuTime);
+        measure.clockOffset = TraceRecorder::getTime() - gpuTime / 1000;
+    }
+    else
+    {
+        measure.clockOffset = 0;
+    }
+
+    glQueryCounter(measure.queries[0], GL_TIMESTAMP);
+    _running = true;
+}
+
+/*************/
+void GpuTimer::end()
+{
+    if (!_running)
+        return;
+
+    auto& measure = _measures[_current];
+    glQueryCounter(measure.queries[1], GL_TIMESTAMP);
+    measure.pending = true;
+    _current = (_current + 1) % SPLASH_GPU_TIMER_QUERIES;
+    _running = false;
+}
+
+/*************/
+optional<uint64_t> GpuTimer::getDuration()
+{
+    optional<uint64_t> duration{};
+
+    // Measures complete in order, so we stop at the first one not yet available
+    while (_measures[_oldest].pending)
+    {
+        auto& measure = _measures[_oldest];
+        GLint available = 0;
+        glGetQueryObjectiv(measure.queries[1], GL_QUERY_RESULT_AVAILABLE, &available);
+        if (!available)
+            break;
+
+        GLuint64 start = 0;
+        GLuint64 end = 0;
+        glGetQueryObjectui64v(measure.queries[0], GL_QUERY_RESULT, &start);
+        glGetQueryObjectui64v(measure.queries[1], GL_QUERY_RESULT, &end);
+        duration = end > start ? (end - start) / 1000 : 0;
+
+        if (measure.clockOffset != 0)
+            TraceRecorder::get().addSpan("gpu", _traceName, static_cast<int64_t>(start / 1000) + measure.clockOffset, *duration, TraceRecorder::gpuThreadId);
+
+        measure.pending = false;
+        _oldest = (_oldest + 1) % SPLASH_GPU_TIMER_QUERIES;
+    }
+
+    return duration;
+}
+
+} // namespace Splash
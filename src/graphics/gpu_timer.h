@@ -0,0 +1,100 @@
+/*
+ * Copyright (C) 2026 Emmanuel Durand
+ *
+ * This file is part of Splash.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Splash is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Splash.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * @gpu_timer.h
+ * Measure the GPU time spent between two points of the command stream
+ */
+
+#ifndef SPLASH_GPU_TIMER_H
+#define SPLASH_GPU_TIMER_H
+
+#include <array>
+#include <cstdint>
+#include <optional>
+#include <string>
+
+#include "./core/constants.h"
+
+// Number of measures in flight, so that results are read back without stalling the pipeline
+#define SPLASH_GPU_TIMER_QUERIES 4
+
+namespace Splash
+{
+
+/*************/
+//! GPU timer based on timestamp queries
+//! Results are read back a few frames later, once available, so that measuring never waits for the GPU.
+//! Must be used from a thread with a current GL context, and destroyed with the same context current.
+class GpuTimer
+{
+  public:
+    /**
+     * \brief Constructor
+     * \param traceName Name of the measures in the recorded traces, not traced if empty
+     */
+    explicit GpuTimer(const std::string& traceName = "")
+        : _traceName(traceName)
+    {
+    }
+
+    /**
+     * \brief Destructor
+     */
+    ~GpuTimer();
+
+    GpuTimer(const GpuTimer&) = delete;
+    GpuTimer& operator=(const GpuTimer&) = delete;
+
+    /**
+     * \brief Start a measure
+     */
+    void begin();
+
+    /**
+     * \brief End the current measure
+     */
+    void end();
+
+    /**
+     * \brief Get the duration of the most recent measure whose result is available
+     * Each measure is returned only once.
+     * \return Return the duration in microseconds, or nothing if no new result is available
+     */
+    std::optional<uint64_t> getDuration();
+
+  private:
+    struct Measure
+    {
+        GLuint queries[2]{0, 0};
+        bool pending{false};
+        int64_t clockOffset{0}; //!< Offset from the GPU clock to the local clock, in us, measured if tracing
+    };
+
+    std::string _traceName{};
+    std::array<Measure, SPLASH_GPU_TIMER_QUERIES> _measures{};
+    uint32_t _current{0}; //!< Index of the next measure to start
+    uint32_t _oldest{0};  //!< Index of the oldest pending measure
+    bool _running{false}; //!< True between begin() and end()
+    bool _initialized{false};
+};
+
+} // namespace Splash
+
+#endif // SPLASH_GPU_TIMER_H
@@ -14,6 +14,7 @@
 #include <glm/gtc/type_ptr.hpp>
 #include <glm/gtx/euler_angles.hpp>
 #include <glm/gtx/string_cast.hpp>
+#include <functional>
 #include <limits>
 
 using namespace std;
@@ -21,6 +22,11 @@ using namespace std;
 namespace Splash
 {
 
+// Attributes set at each frame on the shaders
+const AttributeId fillAttributeId = Attribute::getId("fill");
+const AttributeId sidenessAttributeId = Attribute::getId("sideness");
+const AttributeId uniformAttributeId = Attribute::getId("uniform");
+
 /*************/
 Object::Object(RootObject* root)
     : GraphObject(root)
@@ -50,19 +56,21 @@ Object::~Object()
 }
 
 /*************/
-void Object::activate()
+void Object::activate(const string& fillOverride)
 {
     if (_geometries.size() == 0)
         return;
 
     _mutex.lock();
 
+    const auto& fill = fillOverride.empty() ? _fill : fillOverride;
+
     // Create and store the shader depending on its type
-    auto shaderIt = _graphicsShaders.find(_fill);
+    auto shaderIt = _graphicsShaders.find(fill);
     if (shaderIt == _graphicsShaders.end())
     {
         _shader = make_shared<Shader>();
-        _graphicsShaders[_fill] = _shader;
+        _graphicsShaders[fill] = _shader;
     }
     else
     {
@@ -74,43 +82,48 @@ void Object::activate()
     for (uint32_t i = 0; i < _textures.size(); ++i)
         shaderParameters.push_back("TEX_" + to_string(i + 1));
     shaderParameters.push_back("TEXCOUNT " + to_string(_textures.size()));
+    if (_textures.size() > 0 && _textures[0]->getType() == "texture_array_layer")
+        shaderParameters.push_back("TEXTURE_ARRAY");
 
-    for (auto& p : _fillParameters)
-        shaderParameters.push_back(p);
+    if (fillOverride.empty())
+        for (auto& p : _fillParameters)
+            shaderParameters.push_back(p);
 
-    if (_fill == "texture")
+    if (fill == "texture")
     {
         if (_vertexBlendingActive)
             shaderParameters.push_back("VERTEXBLENDING");
+        else if (_imageBlendingActive)
+            shaderParameters.push_back("IMAGEBLENDING");
         if (_textures.size() > 0 && _textures[0]->getType() == "texture_syphon")
             shaderParameters.push_back("TEXTURE_RECT");
 
         shaderParameters.push_front("texture");
-        _shader->setAttribute("fill", shaderParameters);
+        _shader->setAttribute(fillAttributeId, shaderParameters);
     }
-    else if (_fill == "filter")
+    else if (fill == "filter")
     {
         if (_textures.size() > 0 && _textures[0]->getType() == "texture_syphon")
             shaderParameters.push_back("TEXTURE_RECT");
 
         shaderParameters.push_front("filter");
-        _shader->setAttribute("fill", shaderParameters);
+        _shader->setAttribute(fillAttributeId, shaderParameters);
     }
-    else if (_fill == "window")
+    else if (fill == "window")
     {
         shaderParameters.push_front("window");
-        _shader->setAttribute("fill", shaderParameters);
+        _shader->setAttribute(fillAttributeId, shaderParameters);
     }
     else
     {
-        shaderParameters.push_front(_fill);
-        _shader->setAttribute("fill", shaderParameters);
+        shaderParameters.push_front(fill);
+        _shader->setAttribute(fillAttributeId, shaderParameters);
     }
 
     // Set some uniforms
-    _shader->setAttribute("sideness", {_sideness});
-    _shader->setAttribute("uniform", {"_normalExp", _normalExponent});
-    _shader->setAttribute("uniform", {"_color", _color.r, _color.g, _color.b, _color.a});
+    _shader->setAttribute(sidenessAttributeId, {_sideness});
+    _shader->setUniform("_normalExp", _normalExponent);
+    _shader->setUniform("_color", glm::vec4(_color.r, _color.g, _color.b, _color.a));
 
     if (_geometries.size() > 0)
     {
@@ -133,11 +146,22 @@ void Object::activate()
             parameters.push_back(Value(t->getPrefix() + to_string(texUnit) + "_" + u.first));
             for (auto value : u.second)
                 parameters.push_back(value);
-            _shader->setAttribute("uniform", parameters);
+            _shader->setAttribute(uniformAttributeId, parameters);
         }
 
         texUnit++;
     }
+
+    // Additional planes of planar textures are bound after all the main textures
+    for (uint32_t i = 0; i < _textures.size(); ++i)
+    {
+        auto planes = _textures[i]->getPlanes();
+        for (uint32_t p = 0; p < planes.size(); ++p)
+        {
+            _shader->setTexture(planes[p], texUnit, _textures[i]->getPrefix() + to_string(i) + "_plane" + to_string(p + 1));
+            texUnit++;
+        }
+    }
 }
 
 /*************/
@@ -182,6 +206,64 @@ int64_t Object::getTimestamp() const
     return timestamp;
 }
 
+/**************/
+void Object::appendRenderState(vector<int64_t>& state) const
+{
+    state.push_back(static_cast<int64_t>(getAttributesVersion()));
+
+    state.push_back(static_cast<int64_t>(_textures.size()));
+    for (const auto& texture : _textures)
+    {
+        state.push_back(reinterpret_cast<int64_t>(texture.get()));
+        state.push_back(texture->getTimestamp());
+        state.push_back(static_cast<int64_t>(texture->getContentVersion()));
+    }
+
+    state.push_back(static_cast<int64_t>(_geometries.size()));
+    for (const auto& geometry : _geometries)
+    {
+        state.push_back(reinterpret_cast<int64_t>(geometry.get()));
+        state.push_back(geometry->getTimestamp());
+        state.push_back(static_cast<int64_t>(geometry->getAttributesVersion()));
+    }
+}
+
+/**************/
+vector<int64_t> Object::getDrawState() const
+{
+    vector<int64_t> state;
+    state.push_back(static_cast<int64_t>(hash<string>()(_fill)));
+
+    for (const auto& texture : _textures)
+        state.push_back(reinterpret_cast<int64_t>(texture.get()));
+
+    // Geometries come last, as they are rarely shared between objects
+    state.push_back(static_cast<int64_t>(_textures.size()));
+    for (const auto& geometry : _geometries)
+        state.push_back(reinterpret_cast<int64_t>(geometry.get()));
+
+    return state;
+}
+
+/**************/
+vector<double> Object::getBlendingState(bool includeMeshTimestamps) const
+{
+    vector<double> state;
+
+    auto modelMatrix = computeModelMatrix();
+    auto modelMatrixPtr = glm::value_ptr(modelMatrix);
+    state.insert(state.end(), modelMatrixPtr, modelMatrixPtr + 16);
+    state.push_back(static_cast<double>(_sideness));
+
+    // Tessellation does not change the mesh timestamp, only actual mesh updates do
+    state.push_back(static_cast<double>(_geometries.size()));
+    if (includeMeshTimestamps)
+        for (const auto& geometry : _geometries)
+            state.push_back(static_cast<double>(geometry->getTimestamp()));
+
+    return state;
+}
+
 /**************/
 void Object::removeCalibrationPoint(const glm::dvec3& point)
 {
@@ -202,7 +284,129 @@ void Object::draw()
         return;
 
     _shader->updateUniforms();
+    if (_drawCulled)
+    {
+        glMultiDrawArrays(GL_TRIANGLES, _drawFirsts.data(), _drawCounts.data(), static_cast<GLsizei>(_drawCounts.size()));
+        _drawCulled = false;
+    }
+    else
+    {
+        glDrawArrays(GL_TRIANGLES, 0, _geometries[0]->getVerticesNumber());
+    }
+}
+
+/*************/
+int Object::computeLevelOfDetail(const glm::dmat4& viewMatrix, const glm::dmat4& projectionMatrix, float viewportHeight, float pixelSize) const
+{
+    if (_geometries.size() == 0 || pixelSize <= 0.f)
+        return 0;
+
+    auto levelsOfDetail = _geometries[0]->getLevelsOfDetail();
+    auto mesh = _geometries[0]->getMesh();
+    if (!levelsOfDetail || levelsOfDetail->levels.empty() || !mesh)
+        return 0;
+
+    auto bounds = mesh->getBounds();
+    if (bounds->box.isEmpty())
+        return 0;
+
+    // Distance from the camera to the closest point of the bounding box, in mesh coordinates
+    auto eye = glm::dvec3(glm::inverse(viewMatrix * computeModelMatrix()) * glm::dvec4(0.0, 0.0, 0.0, 1.0));
+    auto closest = glm::clamp(eye, glm::dvec3(bounds->box.min), glm::dvec3(bounds->box.max));
+    auto distance = glm::length(eye - closest);
+    if (distance == 0.0)
+        return 0;
+
+    // Lengths are compared in mesh coordinates too, which holds as long as the object is scaled uniformly
+    auto pixelsPerUnit = projectionMatrix[1][1] * viewportHeight / 2.0 / distance;
+    const auto& levels = levelsOfDetail->levels;
+    for (auto level = static_cast<int>(levels.size()); level > 0; --level)
+        if (levels[level - 1].edgeLength * pixelsPerUnit <= pixelSize)
+            return level;
+
+    return 0;
+}
+
+/*************/
+void Object::setLevelOfDetail(int level)
+{
+    for (auto& geom : _geometries)
+        geom->setLevelOfDetail(level);
+}
+
+/*************/
+bool Object::computeVisibleRanges(const glm::dmat4& viewMatrix, const glm::dmat4& projectionMatrix, vector<GLint>& firsts, vector<GLsizei>& counts) const
+{
+    firsts.clear();
+    counts.clear();
+    if (_geometries.size() == 0)
+        return true;
+
+    auto mesh = _geometries[0]->getMesh();
+    if (!mesh)
+        return true;
+
+    // The geometry may hold vertices not coming from the mesh, for example if deserialized
+    auto bounds = mesh->getBounds();
+    if (bounds->verticesNumber == 0)
+        return true;
+
+    const auto mvp = projectionMatrix * viewMatrix * computeModelMatrix();
+    if (!bounds->box.isInFrustum(mvp))
+        return false;
+
+    // Chunks only match the geometry if it draws the mesh vertices, which is not the case of the tessellated alternative buffers
+    if (bounds->chunks.size() < 2 || _geometries[0]->getVerticesNumber() != bounds->verticesNumber)
+        return true;
+
+    for (size_t chunk = 0; chunk < bounds->chunks.size(); ++chunk)
+    {
+        if (!bounds->chunks[chunk].isInFrustum(mvp))
+            continue;
+
+        auto first = static_cast<GLint>(chunk * SPLASH_MESH_BOUNDS_CHUNK_VERTICES);
+        auto count = std::min<GLsizei>(SPLASH_MESH_BOUNDS_CHUNK_VERTICES, bounds->verticesNumber - first);
+        if (!counts.empty() && firsts.back() + counts.back() == first)
+        {
+            counts.back() += count;
+        }
+        else
+        {
+            firsts.push_back(first);
+            counts.push_back(count);
+        }
+    }
+
+    return !counts.empty();
+}
+
+/*************/
+void Object::setDrawRanges(const vector<GLint>& firsts, const vector<GLsizei>& counts)
+{
+    _drawFirsts = firsts;
+    _drawCounts = counts;
+    _drawCulled = !_drawCounts.empty();
+}
+
+/*************/
+void Object::drawPrimitiveIds(Shader& shader, const glm::dmat4& viewMatrix, const glm::dmat4& projectionMatrix)
+{
+    lock_guard<mutex> lock(_mutex);
+
+    if (_geometries.size() == 0)
+        return;
+
+    _geometries[0]->update();
+    _geometries[0]->activate();
+
+    shader.setAttribute(sidenessAttributeId, {_sideness});
+    shader.activate();
+    shader.setModelViewProjectionMatrix(viewMatrix * computeModelMatrix(), projectionMatrix);
+    shader.updateUniforms();
     glDrawArrays(GL_TRIANGLES, 0, _geometries[0]->getVerticesNumber());
+    shader.deactivate();
+
+    _geometries[0]->deactivate();
 }
 
 /*************/
@@ -387,8 +591,8 @@ void Object::resetVisibility(int primitiveIdShift)
             geom->update();
             geom->activateAsSharedBuffer();
             auto verticesNbr = geom->getVerticesNumber();
-            _computeShaderResetVisibility->setAttribute("uniform", {"_vertexNbr", verticesNbr});
-            _computeShaderResetVisibility->setAttribute("uniform", {"_primitiveIdShift", primitiveIdShift});
+            _computeShaderResetVisibility->setUniform("_vertexNbr", verticesNbr);
+            _computeShaderResetVisibility->setUniform("_primitiveIdShift", primitiveIdShift);
             _computeShaderResetVisibility->doCompute(verticesNbr / 3 / 128 + 1);
             geom->deactivate();
         }
@@ -413,7 +617,7 @@ void Object::resetBlendingAttribute()
             geom->update();
             geom->activateAsSharedBuffer();
             auto verticesNbr = geom->getVerticesNumber();
-            _computeShaderResetBlendingAttributes->setAttribute("uniform", {"_vertexNbr", verticesNbr});
+            _computeShaderResetBlendingAttributes->setUniform("_vertexNbr", verticesNbr);
             _computeShaderResetBlendingAttributes->doCompute(verticesNbr / 3 / 128 + 1);
             geom->deactivate();
         }
@@ -452,26 +656,22 @@ void Object::tessellateForThisCamera(glm::dmat4 viewMatrix, glm::dmat4 projectio
                 geom->update();
                 geom->activate();
 
-                _feedbackShaderSubdivideCamera->setAttribute("uniform", {"_blendWidth", blendWidth});
-                _feedbackShaderSubdivideCamera->setAttribute("uniform", {"_blendPrecision", blendPrecision});
-                _feedbackShaderSubdivideCamera->setAttribute("uniform", {"_sideness", _sideness});
-                _feedbackShaderSubdivideCamera->setAttribute("uniform", {"_fov", fovX, fovY});
+                _feedbackShaderSubdivideCamera->setUniform("_blendWidth", blendWidth);
+                _feedbackShaderSubdivideCamera->setUniform("_blendPrecision", blendPrecision);
+                _feedbackShaderSubdivideCamera->setUniform("_sideness", _sideness);
+                _feedbackShaderSubdivideCamera->setUniform("_fov", glm::vec2(fovX, fovY));
 
                 auto mv = viewMatrix * computeModelMatrix();
-                auto mvAsValues = Values(glm::value_ptr(mv), glm::value_ptr(mv) + 16);
-                _feedbackShaderSubdivideCamera->setAttribute("uniform", {"_mv", mvAsValues});
+                _feedbackShaderSubdivideCamera->setUniform("_mv", glm::mat4(mv));
 
                 auto mvp = projectionMatrix * viewMatrix * computeModelMatrix();
-                auto mvpAsValues = Values(glm::value_ptr(mvp), glm::value_ptr(mvp) + 16);
-                _feedbackShaderSubdivideCamera->setAttribute("uniform", {"_mvp", mvpAsValues});
+                _feedbackShaderSubdivideCamera->setUniform("_mvp", glm::mat4(mvp));
 
                 auto ip = glm::inverse(projectionMatrix);
-                auto ipAsValues = Values(glm::value_ptr(ip), glm::value_ptr(ip) + 16);
-                _feedbackShaderSubdivideCamera->setAttribute("uniform", {"_ip", ipAsValues});
+                _feedbackShaderSubdivideCamera->setUniform("_ip", glm::mat4(ip));
 
                 auto mNormal = projectionMatrix * glm::transpose(glm::inverse(viewMatrix * computeModelMatrix()));
-                auto mNormalAsValues = Values(glm::value_ptr(mNormal), glm::value_ptr(mNormal) + 16);
-                _feedbackShaderSubdivideCamera->setAttribute("uniform", {"_mNormal", mNormalAsValues});
+                _feedbackShaderSubdivideCamera->setUniform("_mNormal", glm::mat4(mNormal));
 
                 geom->activateForFeedback();
                 _feedbackShaderSubdivideCamera->activate();
@@ -505,10 +705,9 @@ void Object::transferVisibilityFromTexToAttr(int width, int height, int primitiv
     {
         geom->update();
         geom->activateAsSharedBuffer();
-        _computeShaderTransferVisibilityToAttr->setAttribute("uniform", {"_texSize", static_cast<float>(width), static_cast<float>(height)});
-        _computeShaderTransferVisibilityToAttr->setAttribute("uniform", {"_idShift", primitiveIdShift});
+        _computeShaderTransferVisibilityToAttr->setUniform("_texSize", glm::vec2(width, height));
+        _computeShaderTransferVisibilityToAttr->setUniform("_idShift", primitiveIdShift);
         _computeShaderTransferVisibilityToAttr->doCompute(width / 32 + 1, height / 32 + 1);
-        glMemoryBarrier(GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT);
         geom->deactivate();
     }
 }
@@ -533,17 +732,15 @@ void Object::computeCameraContribution(glm::dmat4 viewMatrix, glm::dmat4 project
 
             // Set uniforms
             auto verticesNbr = geom->getVerticesNumber();
-            _computeShaderComputeBlending->setAttribute("uniform", {"_vertexNbr", verticesNbr});
-            _computeShaderComputeBlending->setAttribute("uniform", {"_sideness", _sideness});
-            _computeShaderComputeBlending->setAttribute("uniform", {"_blendWidth", blendWidth});
+            _computeShaderComputeBlending->setUniform("_vertexNbr", verticesNbr);
+            _computeShaderComputeBlending->setUniform("_sideness", _sideness);
+            _computeShaderComputeBlending->setUniform("_blendWidth", blendWidth);
 
             auto mvp = projectionMatrix * viewMatrix * computeModelMatrix();
-            auto mvpAsValues = Values(glm::value_ptr(mvp), glm::value_ptr(mvp) + 16);
-            _computeShaderComputeBlending->setAttribute("uniform", {"_mvp", mvpAsValues});
+            _computeShaderComputeBlending->setUniform("_mvp", glm::mat4(mvp));
 
             auto mNormal = projectionMatrix * glm::transpose(glm::inverse(viewMatrix * computeModelMatrix()));
-            auto mNormalAsValues = Values(glm::value_ptr(mNormal), glm::value_ptr(mNormal) + 16);
-            _computeShaderComputeBlending->setAttribute("uniform", {"_mNormal", mNormalAsValues});
+            _computeShaderComputeBlending->setUniform("_mNormal", glm::mat4(mNormal));
 
             _computeShaderComputeBlending->doCompute(verticesNbr / 3);
 
@@ -554,6 +751,82 @@ void Object::computeCameraContribution(glm::dmat4 viewMatrix, glm::dmat4 project
     }
 }
 
+/*************/
+optional<Object::SampledUVRegion> Object::computeSampledUVRegion(const glm::dmat4& viewMatrix, const glm::dmat4& projectionMatrix, const glm::dvec2& viewportSize) const
+{
+    const auto mvp = projectionMatrix * viewMatrix * computeModelMatrix();
+    optional<SampledUVRegion> region;
+
+    for (const auto& geom : _geometries)
+    {
+        auto mesh = geom->getMesh();
+        if (!mesh)
+            continue;
+
+        const auto vertices = mesh->getVertCoords();
+        const auto uvs = mesh->getUVCoords();
+        const auto vertexCount = std::min(vertices.size() / 4, uvs.size() / 2);
+
+        for (size_t first = 0; first + 3 <= vertexCount; first += 3)
+        {
+            glm::dvec2 ndcMin{numeric_limits<double>::max()};
+            glm::dvec2 ndcMax{numeric_limits<double>::lowest()};
+            glm::dvec2 pixels[3];
+            int behindCount = 0;
+            for (size_t vertex = first; vertex < first + 3; ++vertex)
+            {
+                auto projected = mvp * glm::dvec4(vertices[vertex * 4], vertices[vertex * 4 + 1], vertices[vertex * 4 + 2], vertices[vertex * 4 + 3]);
+                if (projected.w <= 0.0)
+                {
+                    ++behindCount;
+                    continue;
+                }
+                auto ndc = glm::dvec2(projected) / projected.w;
+                ndcMin = glm::min(ndcMin, ndc);
+                ndcMax = glm::max(ndcMax, ndc);
+                pixels[vertex - first] = (ndc * 0.5 + 0.5) * viewportSize;
+            }
+
+            // Faces crossing the camera plane can not be projected, they are kept as a precaution
+            if (behindCount == 3)
+                continue;
+            if (behindCount == 0 && (ndcMax.x < -1.0 || ndcMin.x > 1.0 || ndcMax.y < -1.0 || ndcMin.y > 1.0))
+                continue;
+
+            glm::dvec2 faceUVs[3];
+            for (size_t vertex = first; vertex < first + 3; ++vertex)
+            {
+                auto uv = glm::dvec2(uvs[vertex * 2], uvs[vertex * 2 + 1]);
+                faceUVs[vertex - first] = uv;
+                if (!region)
+                    region = SampledUVRegion{glm::dvec4(uv, uv)};
+                region->region = glm::dvec4(glm::min(glm::dvec2(region->region), uv), glm::max(glm::dvec2(region->region[2], region->region[3]), uv));
+            }
+
+            // The density is given by the derivatives of the pixel position along U and V, over the face
+            if (behindCount != 0)
+            {
+                region->density = glm::dvec2(numeric_limits<double>::infinity());
+                continue;
+            }
+
+            const auto uvEdge1 = faceUVs[1] - faceUVs[0];
+            const auto uvEdge2 = faceUVs[2] - faceUVs[0];
+            const auto determinant = uvEdge1.x * uvEdge2.y - uvEdge2.x * uvEdge1.y;
+            if (abs(determinant) < numeric_limits<float>::epsilon())
+                continue;
+
+            const auto pixelEdge1 = pixels[1] - pixels[0];
+            const auto pixelEdge2 = pixels[2] - pixels[0];
+            const auto alongU = (pixelEdge1 * uvEdge2.y - pixelEdge2 * uvEdge1.y) / determinant;
+            const auto alongV = (pixelEdge2 * uvEdge1.x - pixelEdge1 * uvEdge2.x) / determinant;
+            region->density = glm::max(region->density, glm::dvec2(glm::length(alongU), glm::length(alongV)));
+        }
+    }
+
+    return region;
+}
+
 /*************/
 void Object::setViewProjectionMatrix(const glm::dmat4& mv, const glm::dmat4& mp)
 {
@@ -582,6 +855,14 @@ void Object::registerAttributes()
         {'b'});
     setAttributeDescription("activateVertexBlending", "If true, activate vertex blending");
 
+    addAttribute("activateImageBlending",
+        [&](const Values& args) {
+            _imageBlendingActive = args[0].as<bool>();
+            return true;
+        },
+        {'b'});
+    setAttributeDescription("activateImageBlending", "If true, activate the blending from the blending maps of the cameras");
+
     addAttribute("position",
         [&](const Values& args) {
             _position = glm::dvec3(args[0].as<float>(), args[1].as<float>(), args[2].as<float>());
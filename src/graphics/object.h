@@ -27,6 +27,7 @@
 
 #include <glm/glm.hpp>
 #include <memory>
+#include <optional>
 #include <vector>
 
 #include "./core/constants.h"
@@ -43,6 +44,14 @@ namespace Splash
 
 class Object : public GraphObject
 {
+  public:
+    //! Part of the texture space seen through a camera
+    struct SampledUVRegion
+    {
+        glm::dvec4 region{0.0};  //!< Seen region as (left, top, right, bottom), in UV coordinates
+        glm::dvec2 density{0.0}; //!< Highest count of viewport pixels per UV unit along U and V, infinite if it can not be known
+    };
+
   public:
     /**
      * \brief Constructor
@@ -63,8 +72,10 @@ class Object : public GraphObject
 
     /**
      * \brief Activate this object for rendering
+     * \param fillOverride If not empty, fill to render with instead of the one set through the "fill" attribute.
+     * The fill parameters of the object are not applied in this case.
      */
-    void activate();
+    void activate(const std::string& fillOverride = {});
 
     /**
      * \brief Compute the visibility for the mvp specified with setViewProjectionMatrix, for blending purposes
@@ -74,6 +85,16 @@ class Object : public GraphObject
      */
     void computeCameraContribution(glm::dmat4 viewMatrix, glm::dmat4 projectionMatrix, float blendWidth);
 
+    /**
+     * \brief Compute the bounding box of the UV coordinates of the faces seen through the given matrices, and the texture resolution they need
+     * This is conservative, faces are considered seen as soon as their bounding box overlaps the view
+     * \param viewMatrix View matrix
+     * \param projectionMatrix Projection matrix
+     * \param viewportSize Size of the viewport, in pixels
+     * \return Return the sampled region, or nothing if no face is seen
+     */
+    std::optional<SampledUVRegion> computeSampledUVRegion(const glm::dmat4& viewMatrix, const glm::dmat4& projectionMatrix, const glm::dvec2& viewportSize) const;
+
     /**
      * \brief Deactivate this object for rendering
      */
@@ -104,12 +125,70 @@ class Object : public GraphObject
      */
     virtual int64_t getTimestamp() const final;
 
+    /**
+     * Append the state of the object, its textures and geometries to the given list
+     * This is used by the cameras to detect whether they have to render again
+     * \param state State list to append to
+     */
+    void appendRenderState(std::vector<int64_t>& state) const;
+
+    /**
+     * Get the rendering state of the object, as its fill, textures and geometries
+     * This is used by the cameras to sort their draws, so that objects sharing the same state are drawn consecutively
+     * \return Return the state as a list of values, to be compared lexicographically
+     */
+    std::vector<int64_t> getDrawState() const;
+
+    /**
+     * Get the state of the object which the blending depends on
+     * This is used by the blender to detect which objects need their blending to be computed again
+     * \param includeMeshTimestamps If true, include the timestamps of the meshes, which are not stable across runs
+     * \return Return the state as a list of values
+     */
+    std::vector<double> getBlendingState(bool includeMeshTimestamps = true) const;
+
     /**
      * \brief Remove a calibration point
      * \param point Point coordinates
      */
     void removeCalibrationPoint(const glm::dvec3& point);
 
+    /**
+     * \brief Compute the ranges of faces inside the view frustum, without modifying the object so that cameras can do it in parallel
+     * Faces are culled by chunks of consecutive vertices, see Mesh::Bounds
+     * \param viewMatrix View matrix
+     * \param projectionMatrix Projection matrix
+     * \param firsts Set to the first vertex of each range of visible faces, left empty if all the faces have to be drawn
+     * \param counts Set to the vertex count of each range of visible faces
+     * \return Return false if the object is entirely out of the view, in which case it does not need to be drawn
+     */
+    bool computeVisibleRanges(const glm::dmat4& viewMatrix, const glm::dmat4& projectionMatrix, std::vector<GLint>& firsts, std::vector<GLsizei>& counts) const;
+
+    /**
+     * \brief Set the ranges of faces drawn by the next call to draw, as computed by computeVisibleRanges
+     * The next draw falls back to drawing all faces. Empty ranges draw all the faces.
+     * \param firsts First vertex of each range
+     * \param counts Vertex count of each range
+     */
+    void setDrawRanges(const std::vector<GLint>& firsts, const std::vector<GLsizei>& counts);
+
+    /**
+     * \brief Compute the coarsest level of detail fitting the given view, see Mesh::LevelsOfDetail
+     * The triangle edges of the part of the object closest to the camera are projected to at most pixelSize pixels
+     * \param viewMatrix View matrix
+     * \param projectionMatrix Projection matrix
+     * \param viewportHeight Height of the viewport, in pixels
+     * \param pixelSize Target length of the projected triangle edges, in pixels
+     * \return Return the level of detail, 0 being the full resolution
+     */
+    int computeLevelOfDetail(const glm::dmat4& viewMatrix, const glm::dmat4& projectionMatrix, float viewportHeight, float pixelSize) const;
+
+    /**
+     * \brief Set the level of detail of the geometries, for the next activations
+     * \param level Level of detail, 0 being the full resolution
+     */
+    void setLevelOfDetail(int level);
+
     /**
      * \brief Draw the object
      */
@@ -164,6 +243,15 @@ class Object : public GraphObject
      */
     void resetTessellation();
 
+    /**
+     * \brief Draw the primitive IDs of the object with the given shader, for the visibility test
+     * This neither changes the object shader nor binds its textures
+     * \param shader Shader to draw with, set to the "primitiveId" fill
+     * \param viewMatrix View matrix
+     * \param projectionMatrix Projection matrix
+     */
+    void drawPrimitiveIds(Shader& shader, const glm::dmat4& viewMatrix, const glm::dmat4& projectionMatrix);
+
     /**
      * \brief Reset the visibility flag, as well as the faces ID
      * \param primitiveIdShift Shift for the ID of the vertices
@@ -202,6 +290,7 @@ class Object : public GraphObject
 
     /**
      * \brief This transfers the visibility from the texture active as GL_TEXTURE0 to the vertices attributes
+     * A memory barrier has to be issued by the caller before using the updated attributes
      * \param width Width of the texture
      * \param height Height of the texture
      * \param primitiveIdShift Shift for the ID as rendered in the texture
@@ -241,8 +330,12 @@ class Object : public GraphObject
 
     std::vector<std::shared_ptr<Texture>> _textures;
     std::vector<std::shared_ptr<Geometry>> _geometries;
+    std::vector<GLint> _drawFirsts{};   //!< First vertex of each range of visible faces, set by setDrawRanges for the next draw
+    std::vector<GLsizei> _drawCounts{}; //!< Vertex count of each range of visible faces
+    bool _drawCulled{false};            //!< True if the next draw only draws the ranges of visible faces
 
     bool _vertexBlendingActive{false};
+    bool _imageBlendingActive{false}; //!< If true, the blending is read from the blending map of the camera drawing the object
 
     glm::dvec3 _position{0.0, 0.0, 0.0};
     glm::dvec3 _rotation{0.0, 0.0, 0.0};
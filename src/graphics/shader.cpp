@@ -1,14 +1,21 @@
 #include "./graphics/shader.h"
 
+#include <cstring>
+#include <filesystem>
 #include <fstream>
+#include <functional>
 #include <regex>
+#include <sstream>
 
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
 #include <glm/gtx/string_cast.hpp>
 
+#include "./core/scene.h"
 #include "./graphics/shaderSources.h"
+#include "./utils/boot_timeline.h"
 #include "./utils/log.h"
+#include "./utils/osutils.h"
 #include "./utils/timer.h"
 
 using namespace std;
@@ -63,6 +70,8 @@ Shader::~Shader()
 {
     if (glIsProgram(_program))
         glDeleteProgram(_program);
+    if (glIsProgram(_previousProgram))
+        glDeleteProgram(_previousProgram);
     for (auto& shader : _shaders)
         if (glIsShader(shader.second))
             glDeleteShader(shader.second);
@@ -78,6 +87,8 @@ void Shader::activate()
     if (_programType == prgGraphic)
     {
         _mutex.lock();
+        if (_linkPending)
+            updatePendingLink();
         if (!_isLinked)
         {
             if (!linkProgram())
@@ -86,13 +97,15 @@ void Shader::activate()
 
         _activated = true;
 
+        // The uniforms are those of the previous program until the new one is linked
+        auto program = _linkPending ? _previousProgram : _program;
         for (auto& u : _uniforms)
         {
             if (u.second.type == "buffer")
-                glUniformBlockBinding(_program, u.second.glIndex, 1);
+                glUniformBlockBinding(program, u.second.glIndex, 1);
         }
 
-        glUseProgram(_program);
+        glUseProgram(program);
 
         if (_sideness == singleSided)
         {
@@ -108,6 +121,8 @@ void Shader::activate()
     else if (_programType == prgFeedback)
     {
         _mutex.lock();
+        if (_linkPending)
+            updatePendingLink();
         if (!_isLinked)
         {
             if (!linkProgram())
@@ -115,7 +130,7 @@ void Shader::activate()
         }
 
         _activated = true;
-        glUseProgram(_program);
+        glUseProgram(_linkPending ? _previousProgram : _program);
         updateUniforms();
         glEnable(GL_RASTERIZER_DISCARD);
         glBeginTransformFeedback(GL_TRIANGLES);
@@ -155,6 +170,8 @@ void Shader::doCompute(GLuint numGroupsX, GLuint numGroupsY)
     if (_programType != prgCompute)
         return;
 
+    if (_linkPending)
+        updatePendingLink();
     if (!_isLinked)
     {
         if (!linkProgram())
@@ -162,7 +179,7 @@ void Shader::doCompute(GLuint numGroupsX, GLuint numGroupsY)
     }
 
     _activated = true;
-    glUseProgram(_program);
+    glUseProgram(_linkPending ? _previousProgram : _program);
     updateUniforms();
     glDispatchCompute(numGroupsX, numGroupsY, 1);
     _activated = false;
@@ -173,43 +190,117 @@ map<string, Values> Shader::getUniforms() const
 {
     map<string, Values> uniforms;
     for (auto& u : _uniforms)
-        uniforms[u.first] = u.second.values;
+        uniforms[u.first] = u.second.typedType != 0 ? typedUniformToValues(u.second) : u.second.values;
     return uniforms;
 }
 
 /*************/
-bool Shader::setSource(const std::string& src, const ShaderType type)
+void Shader::setTypedUniform(const string& name, GLenum glType, const void* data, size_t size)
 {
-    GLuint shader = _shaders[type];
+    auto uniformIt = _uniforms.find(name);
+    if (uniformIt == _uniforms.end())
+        uniformIt = _uniforms.emplace(name, Uniform()).first;
 
-    auto parsedSources = src;
-    parseIncludes(parsedSources);
-    const char* shaderSrc = parsedSources.c_str();
-    glShaderSource(shader, 1, (const GLchar**)&shaderSrc, 0);
-    glCompileShader(shader);
+    auto& uniform = uniformIt->second;
+    if (uniform.typedType == glType && memcmp(uniform.typedData.data(), data, size) == 0)
+        return;
 
-    GLint status;
-    glGetShaderiv(shader, GL_COMPILE_STATUS, &status);
-    if (status)
+    uniform.typedType = glType;
+    memcpy(uniform.typedData.data(), data, size);
+    _uniformsToUpdate.push_back(name);
+}
+
+/*************/
+void Shader::uploadTypedUniform(const Uniform& uniform)
+{
+    auto intData = reinterpret_cast<const GLint*>(uniform.typedData.data());
+    auto floatData = reinterpret_cast<const GLfloat*>(uniform.typedData.data());
+
+    switch (uniform.typedType)
     {
-#ifdef DEBUG
-        Log::get() << Log::DEBUGGING << "Shader::" << __FUNCTION__ << " - Shader of type " << stringFromShaderType(type) << " compiled successfully" << Log::endl;
-#endif
+    default:
+        assert(false);
+        break;
+    case GL_INT:
+        glUniform1iv(uniform.glIndex, 1, intData);
+        break;
+    case GL_INT_VEC2:
+        glUniform2iv(uniform.glIndex, 1, intData);
+        break;
+    case GL_INT_VEC3:
+        glUniform3iv(uniform.glIndex, 1, intData);
+        break;
+    case GL_INT_VEC4:
+        glUniform4iv(uniform.glIndex, 1, intData);
+        break;
+    case GL_FLOAT:
+        glUniform1fv(uniform.glIndex, 1, floatData);
+        break;
+    case GL_FLOAT_VEC2:
+        glUniform2fv(uniform.glIndex, 1, floatData);
+        break;
+    case GL_FLOAT_VEC3:
+        glUniform3fv(uniform.glIndex, 1, floatData);
+        break;
+    case GL_FLOAT_VEC4:
+        glUniform4fv(uniform.glIndex, 1, floatData);
+        break;
+    case GL_FLOAT_MAT3:
+        glUniformMatrix3fv(uniform.glIndex, 1, GL_FALSE, floatData);
+        break;
+    case GL_FLOAT_MAT4:
+        glUniformMatrix4fv(uniform.glIndex, 1, GL_FALSE, floatData);
+        break;
     }
-    else
+}
+
+/*************/
+Values Shader::typedUniformToValues(const Uniform& uniform)
+{
+    auto intData = reinterpret_cast<const GLint*>(uniform.typedData.data());
+    auto floatData = reinterpret_cast<const GLfloat*>(uniform.typedData.data());
+
+    switch (uniform.typedType)
     {
-        Log::get() << Log::WARNING << "Shader::" << __FUNCTION__ << " - Error while compiling a shader of type " << stringFromShaderType(type) << Log::endl;
-        GLint length;
-        glGetShaderiv(shader, GL_INFO_LOG_LENGTH, &length);
-        char* log = (char*)malloc(length);
-        glGetShaderInfoLog(shader, length, &length, log);
-        Log::get() << Log::WARNING << "Shader::" << __FUNCTION__ << " - Error log: \n" << (const char*)log << Log::endl;
-        free(log);
+    default:
+        return {};
+    case GL_INT:
+    case GL_INT_VEC2:
+    case GL_INT_VEC3:
+    case GL_INT_VEC4:
+        return Values(intData, intData + (uniform.typedType == GL_INT ? 1 : uniform.typedType - GL_INT_VEC2 + 2));
+    case GL_FLOAT:
+        return Values(floatData, floatData + 1);
+    case GL_FLOAT_VEC2:
+    case GL_FLOAT_VEC3:
+    case GL_FLOAT_VEC4:
+        return Values(floatData, floatData + (uniform.typedType - GL_FLOAT_VEC2 + 2));
+    case GL_FLOAT_MAT3:
+        return Values(floatData, floatData + 9);
+    case GL_FLOAT_MAT4:
+        return Values(floatData, floatData + 16);
     }
+}
+
+/*************/
+bool Shader::hasUniform(const string& name) const
+{
+    auto uniformIt = _uniforms.find(name);
+    return uniformIt != _uniforms.end() && uniformIt->second.glIndex != -1;
+}
+
+/*************/
+bool Shader::setSource(const std::string& src, const ShaderType type)
+{
+    if (_shaders.find(type) == _shaders.end())
+        return false;
+
+    auto parsedSources = src;
+    parseIncludes(parsedSources);
 
     _shadersSource[type] = parsedSources;
     _isLinked = false;
-    return status;
+    return true;
 }
 
 /*************/
@@ -227,7 +318,7 @@ bool Shader::setSource(const map<ShaderType, string>& sources)
         status = status && setSource(source.second, source.first);
 
     compileProgram();
-    return status;
+    return status && linkProgram();
 }
 
 /*************/
@@ -262,10 +353,24 @@ void Shader::setTexture(const shared_ptr<Texture>& texture, const GLuint texture
         if (uniform.glIndex == -1)
             return;
 
-        glActiveTexture(GL_TEXTURE0 + textureUnit);
-        texture->bind();
+        // Bindless textures need neither a texture unit nor a bind, and the handle is only sent when it changes
+        GLuint64 handle = _bindlessSamplers ? texture->getBindlessHandle() : 0;
+        if (handle != 0)
+        {
+            if (uniform.bindlessHandle != handle)
+            {
+                glUniformHandleui64ARB(uniform.glIndex, handle);
+                uniform.bindlessHandle = handle;
+            }
+        }
+        else
+        {
+            glActiveTexture(GL_TEXTURE0 + textureUnit);
+            texture->bind();
 
-        glUniform1i(uniform.glIndex, textureUnit);
+            glUniform1i(uniform.glIndex, textureUnit);
+            uniform.bindlessHandle = 0;
+        }
 
         _textures.push_back(texture);
         if ((uniformIt = _uniforms.find("_textureNbr")) != _uniforms.end())
@@ -305,44 +410,168 @@ void Shader::setModelViewProjectionMatrix(const glm::dmat4& mv, const glm::dmat4
 /*************/
 void Shader::compileProgram()
 {
-    GLint status;
-    if (glIsProgram(_program) == GL_TRUE)
+    if (_previousProgram != 0)
+    {
+        // The program being built to replace the previous one is superseded by this one
         glDeleteProgram(_program);
+    }
+    else if (glIsProgram(_program) == GL_TRUE)
+    {
+        // Programs are only linked in the background if there is another one to use meanwhile
+        GLint linked = GL_FALSE;
+        if (Scene::getHasParallelShaderCompile())
+            glGetProgramiv(_program, GL_LINK_STATUS, &linked);
+
+        if (linked == GL_TRUE)
+            _previousProgram = _program;
+        else
+            glDeleteProgram(_program);
+    }
 
     _program = glCreateProgram();
-    for (auto& shader : _shaders)
+    _isLinked = false;
+    _linkPending = false;
+}
+
+/*************/
+bool Shader::compileShader(ShaderType type, bool wait)
+{
+    BootStep bootStep("shader_compile");
+    auto shaderIt = _shaders.find(type);
+    auto sourceIt = _shadersSource.find(type);
+    if (shaderIt == _shaders.end() || sourceIt == _shadersSource.end())
+        return false;
+
+    GLuint shader = shaderIt->second;
+    const char* shaderSrc = sourceIt->second.c_str();
+    glShaderSource(shader, 1, (const GLchar**)&shaderSrc, 0);
+    glCompileShader(shader);
+
+    if (!wait)
+        return true;
+
+    return checkShaderStatus(type);
+}
+
+/*************/
+bool Shader::checkShaderStatus(ShaderType type)
+{
+    auto shaderIt = _shaders.find(type);
+    if (shaderIt == _shaders.end())
+        return false;
+
+    GLuint shader = shaderIt->second;
+    GLint status;
+    glGetShaderiv(shader, GL_COMPILE_STATUS, &status);
+    if (status)
     {
-        if (glIsShader(shader.second))
-        {
-            glGetShaderiv(shader.second, GL_COMPILE_STATUS, &status);
-            if (status == GL_TRUE)
-            {
-                glAttachShader(_program, shader.second);
 #ifdef DEBUG
-                Log::get() << Log::DEBUGGING << "Shader::" << __FUNCTION__ << " - Shader of type " << stringFromShaderType(shader.first) << " successfully attached to the program"
-                           << Log::endl;
+        Log::get() << Log::DEBUGGING << "Shader::" << __FUNCTION__ << " - Shader of type " << stringFromShaderType(type) << " compiled successfully" << Log::endl;
 #endif
-            }
-        }
     }
+    else
+    {
+        Log::get() << Log::WARNING << "Shader::" << __FUNCTION__ << " - Error while compiling a shader of type " << stringFromShaderType(type) << Log::endl;
+        GLint length;
+        glGetShaderiv(shader, GL_INFO_LOG_LENGTH, &length);
+        char* log = (char*)malloc(length);
+        glGetShaderInfoLog(shader, length, &length, log);
+        Log::get() << Log::WARNING << "Shader::" << __FUNCTION__ << " - Error log: \n" << (const char*)log << Log::endl;
+        free(log);
+    }
+
+    return status;
 }
 
 /*************/
 bool Shader::linkProgram()
+{
+    BootStep bootStep("shader_link");
+    auto cacheKey = getProgramCacheKey();
+    bool fromCache = loadProgramBinary(cacheKey);
+
+    // With a previous program to use meanwhile, nothing waits for the compilation and link to finish
+    bool inBackground = _previousProgram != 0;
+
+    if (!fromCache)
+    {
+        vector<GLuint> attachedShaders;
+        for (auto& source : _shadersSource)
+        {
+            if (!compileShader(static_cast<ShaderType>(source.first), !inBackground))
+                continue;
+            auto shader = _shaders[source.first];
+            glAttachShader(_program, shader);
+            attachedShaders.push_back(shader);
+        }
+
+        if (!_feedbackVaryings.empty())
+        {
+            vector<const GLchar*> varyings;
+            for (auto& varying : _feedbackVaryings)
+                varyings.push_back(varying.c_str());
+            glTransformFeedbackVaryings(_program, varyings.size(), varyings.data(), GL_SEPARATE_ATTRIBS);
+        }
+
+        glProgramParameteri(_program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+        glLinkProgram(_program);
+
+        // Shaders are not needed anymore once linked, and are attached again for the next link
+        for (auto shader : attachedShaders)
+            glDetachShader(_program, shader);
+
+        if (inBackground)
+        {
+            _linkPending = true;
+            _isLinked = true;
+            return true;
+        }
+    }
+
+    return finishLink(fromCache, cacheKey);
+}
+
+/*************/
+void Shader::updatePendingLink()
+{
+    GLint completed = GL_FALSE;
+    glGetProgramiv(_program, GL_COMPLETION_STATUS_ARB, &completed);
+    if (completed != GL_TRUE)
+        return;
+
+    _linkPending = false;
+    finishLink(false, getProgramCacheKey());
+}
+
+/*************/
+bool Shader::finishLink(bool fromCache, const string& cacheKey)
 {
     GLint status;
-    glLinkProgram(_program);
     glGetProgramiv(_program, GL_LINK_STATUS, &status);
     if (status == GL_TRUE)
     {
 #ifdef DEBUG
-        Log::get() << Log::DEBUGGING << "Shader::" << __FUNCTION__ << " - Shader program " << _currentProgramName << " linked successfully" << Log::endl;
+        Log::get() << Log::DEBUGGING << "Shader::" << __FUNCTION__ << " - Shader program " << _currentProgramName << " linked successfully" << (fromCache ? " from cache" : "") << Log::endl;
 #endif
 
+        if (!fromCache)
+            saveProgramBinary(cacheKey);
+
+        if (_previousProgram != 0)
+        {
+            glDeleteProgram(_previousProgram);
+            _previousProgram = 0;
+        }
+
+        _bindlessSamplers = false;
         for (auto src : _shadersSource)
+        {
             parseUniforms(src.second);
+            _bindlessSamplers = _bindlessSamplers || src.second.find("bindless_sampler") != string::npos;
+        }
 
         _isLinked = true;
+        _linkFailed = false;
         return true;
     }
     else
@@ -356,11 +585,154 @@ bool Shader::linkProgram()
         Log::get() << Log::WARNING << "Shader::" << __FUNCTION__ << " - Error log: \n" << (const char*)log << Log::endl;
         free(log);
 
+        _linkFailed = true;
+
+        // When linked in the background the compilation errors have not been checked yet,
+        // and the previous program is kept until the sources are fixed
+        if (_previousProgram != 0)
+        {
+            for (auto& source : _shadersSource)
+                checkShaderStatus(static_cast<ShaderType>(source.first));
+            glDeleteProgram(_program);
+            _program = _previousProgram;
+            _previousProgram = 0;
+            _isLinked = true;
+            return false;
+        }
+
         _isLinked = false;
         return false;
     }
 }
 
+/*************/
+string Shader::getProgramCacheDirectory()
+{
+    auto cacheEnv = getenv(SPLASH_SHADER_CACHE_ENV);
+    if (cacheEnv != nullptr)
+        return string(cacheEnv);
+
+    return Utils::getCachePath() + "/shaders";
+}
+
+/*************/
+string Shader::getProgramCacheKey() const
+{
+    string key;
+    for (auto name : {GL_VENDOR, GL_RENDERER, GL_VERSION})
+    {
+        auto value = reinterpret_cast<const char*>(glGetString(name));
+        key += string(value ? value : "") + "\n";
+    }
+
+    // Sources are sorted by type, to get a stable key
+    map<int, string> sources(_shadersSource.begin(), _shadersSource.end());
+    for (auto& source : sources)
+        key += to_string(source.first) + "\n" + source.second + "\n";
+    for (auto& varying : _feedbackVaryings)
+        key += varying + "\n";
+
+    return key;
+}
+
+/*************/
+bool Shader::loadProgramBinary(const string& key)
+{
+    auto cacheDirectory = getProgramCacheDirectory();
+    if (cacheDirectory.empty())
+        return false;
+
+    GLint formatCount = 0;
+    glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formatCount);
+    if (formatCount == 0)
+        return false;
+
+    stringstream filename;
+    filename << cacheDirectory << "/" << hex << std::hash<string>()(key) << ".bin";
+    ifstream file(filename.str(), ios::in | ios::binary);
+    if (!file)
+        return false;
+
+    // The file starts with the full key, to rule out hash collisions
+    uint64_t keySize = 0;
+    file.read(reinterpret_cast<char*>(&keySize), sizeof(keySize));
+    if (!file || keySize != key.size())
+        return false;
+
+    string storedKey(keySize, '\0');
+    file.read(storedKey.data(), keySize);
+    if (!file || storedKey != key)
+        return false;
+
+    GLenum format = 0;
+    file.read(reinterpret_cast<char*>(&format), sizeof(format));
+    vector<char> binary((istreambuf_iterator<char>(file)), istreambuf_iterator<char>());
+    if (binary.empty())
+        return false;
+
+    glProgramBinary(_program, format, binary.data(), binary.size());
+
+    // The driver may reject binaries from another version, in which case the program is built from sources
+    GLint status;
+    glGetProgramiv(_program, GL_LINK_STATUS, &status);
+    if (status != GL_TRUE)
+    {
+        Log::get() << Log::DEBUGGING << "Shader::" << __FUNCTION__ << " - Cached binary for program " << _currentProgramName << " was rejected by the driver" << Log::endl;
+        return false;
+    }
+
+    return true;
+}
+
+/*************/
+void Shader::saveProgramBinary(const string& key)
+{
+    auto cacheDirectory = getProgramCacheDirectory();
+    if (cacheDirectory.empty())
+        return;
+
+    GLint binarySize = 0;
+    glGetProgramiv(_program, GL_PROGRAM_BINARY_LENGTH, &binarySize);
+    if (binarySize <= 0)
+        return;
+
+    vector<char> binary(binarySize);
+    GLenum format = 0;
+    glGetProgramBinary(_program, binarySize, nullptr, &format, binary.data());
+
+    error_code errorCode;
+    filesystem::create_directories(cacheDirectory, errorCode);
+    if (errorCode)
+    {
+        Log::get() << Log::WARNING << "Shader::" << __FUNCTION__ << " - Unable to create shader cache directory " << cacheDirectory << ": " << errorCode.message() << Log::endl;
+        return;
+    }
+
+    // Written to a temporary file first, as multiple Scenes may save the same program concurrently
+    stringstream filename;
+    filename << cacheDirectory << "/" << hex << std::hash<string>()(key) << ".bin";
+    auto tmpFilename = filename.str() + "." + to_string(getpid()) + ".tmp";
+    {
+        ofstream file(tmpFilename, ios::out | ios::binary | ios::trunc);
+        uint64_t keySize = key.size();
+        file.write(reinterpret_cast<const char*>(&keySize), sizeof(keySize));
+        file.write(key.data(), keySize);
+        file.write(reinterpret_cast<const char*>(&format), sizeof(format));
+        file.write(binary.data(), binary.size());
+        if (!file)
+        {
+            Log::get() << Log::WARNING << "Shader::" << __FUNCTION__ << " - Unable to write shader cache file " << tmpFilename << Log::endl;
+            file.close();
+            filesystem::remove(tmpFilename, errorCode);
+            return;
+        }
+    }
+
+    filesystem::rename(tmpFilename, filename.str(), errorCode);
+    if (errorCode)
+        filesystem::remove(tmpFilename, errorCode);
+}
+
 /*************/
 void Shader::parseIncludes(std::string& src)
 {
@@ -471,6 +843,8 @@ void Shader::parseUniforms(const std::string& src)
 
             _uniforms[name].type = type;
             _uniforms[name].glIndex = glGetUniformLocation(_program, name.c_str());
+            _uniforms[name].typedType = 0;
+            _uniforms[name].bindlessHandle = 0;
             _uniforms[name].elementSize = type.find("mat") != string::npos ? elementSize * elementSize : elementSize;
             _uniforms[name].arraySize = arraySize;
             _uniformsDocumentation[name] = documentation;
@@ -599,6 +973,13 @@ void Shader::updateUniforms()
             if (uniform.glIndex == -1)
             {
                 uniform.values.clear(); // To make sure it is sent next time if the index is correctly set
+                uniform.typedType = 0;
+                continue;
+            }
+
+            if (uniform.typedType != 0)
+            {
+                uploadTypedUniform(uniform);
                 continue;
             }
 
@@ -714,6 +1095,7 @@ void Shader::updateUniforms()
 void Shader::resetShader(ShaderType type)
 {
     glDeleteShader(_shaders[type]);
+    _shadersSource.erase(type);
 
     if (type == vertex)
         _shaders[type] = glCreateShader(GL_VERTEX_SHADER);
@@ -746,12 +1128,13 @@ void Shader::registerAttributes()
 
         // Check if the values changed from previous use
         auto uniformIt = _uniforms.find(uniformName);
-        if (uniformIt != _uniforms.end() && Value(uniformArgs) == Value(uniformIt->second.values))
+        if (uniformIt != _uniforms.end() && uniformIt->second.typedType == 0 && Value(uniformArgs) == Value(uniformIt->second.values))
             return true;
         else if (uniformIt == _uniforms.end())
             uniformIt = (_uniforms.emplace(make_pair(uniformName, Uniform()))).first;
 
         uniformIt->second.values = uniformArgs;
+        uniformIt->second.typedType = 0;
         _uniformsToUpdate.push_back(uniformName);
 
         return true;
@@ -768,6 +1151,8 @@ void Shader::registerGraphicAttributes()
             string options = ShaderSources.VERSION_DIRECTIVE_GL4;
             for (uint32_t i = 1; i < args.size(); ++i)
                 options += "#define " + args[i].as<string>() + "\n";
+            if (Scene::getHasBindlessTextures())
+                options += ShaderSources.BINDLESS_SAMPLERS;
 
             if (args[0].as<string>() == "texture" && (_fill != texture || _shaderOptions != options))
             {
@@ -829,6 +1214,16 @@ void Shader::registerGraphicAttributes()
                 setSource(options + ShaderSources.FRAGMENT_SHADER_COLOR_CURVES_FILTER, fragment);
                 compileProgram();
             }
+            else if (args[0].as<string>() == "yuv420_filter" && (_fill != yuv420_filter || _shaderOptions != options))
+            {
+                _currentProgramName = args[0].as<string>();
+                _fill = yuv420_filter;
+                _shaderOptions = options;
+                setSource(options + ShaderSources.VERTEX_SHADER_FILTER, vertex);
+                resetShader(geometry);
+                setSource(options + ShaderSources.FRAGMENT_SHADER_YUV420_FILTER, fragment);
+                compileProgram();
+            }
             else if (args[0].as<string>() == "color" && (_fill != color || _shaderOptions != options))
             {
                 _currentProgramName = args[0].as<string>();
@@ -978,6 +1373,18 @@ void Shader::registerComputeAttributes()
             setSource(options + ShaderSources.COMPUTE_SHADER_TRANSFER_VISIBILITY_TO_ATTR, compute);
             compileProgram();
         }
+        else if ("accumulateBlendingWeights" == args[0].as<string>())
+        {
+            _currentProgramName = args[0].as<string>();
+            setSource(options + ShaderSources.COMPUTE_SHADER_ACCUMULATE_BLENDING_WEIGHTS, compute);
+            compileProgram();
+        }
+        else if ("normalizeBlendingWeights" == args[0].as<string>())
+        {
+            _currentProgramName = args[0].as<string>();
+            setSource(options + ShaderSources.COMPUTE_SHADER_NORMALIZE_BLENDING_WEIGHTS, compute);
+            compileProgram();
+        }
 
         return true;
     });
@@ -1014,19 +1421,11 @@ void Shader::registerFeedbackAttributes()
         if (args.size() < 1)
             return false;
 
-        GLchar* feedbackVaryings[args.size()];
-        vector<string> varyingNames;
-        for (uint32_t i = 0; i < args.size(); ++i)
-        {
-            varyingNames.push_back(args[i].as<string>());
-            feedbackVaryings[i] = new GLchar[256];
-            strcpy(feedbackVaryings[i], varyingNames[i].c_str());
-        }
-
-        glTransformFeedbackVaryings(_program, args.size(), const_cast<const GLchar**>(feedbackVaryings), GL_SEPARATE_ATTRIBS);
-
-        for (uint32_t i = 0; i < args.size(); ++i)
-            delete feedbackVaryings[i];
+        // Varyings are set on the program when it is linked
+        _feedbackVaryings.clear();
+        for (auto& arg : args)
+            _feedbackVaryings.push_back(arg.as<string>());
+        _isLinked = false;
 
         return true;
     });
@@ -25,13 +25,17 @@
 #ifndef SPLASH_SHADER_H
 #define SPLASH_SHADER_H
 
+#include <array>
 #include <atomic>
 #include <map>
 #include <memory>
 #include <string>
+#include <type_traits>
 #include <unordered_map>
 #include <vector>
 
+#include <glm/glm.hpp>
+
 #include "./core/constants.h"
 
 #include "./core/attribute.h"
@@ -41,6 +45,27 @@
 namespace Splash
 {
 
+/*************/
+//! GL type of the values which can be given to Shader::setUniform
+//! Using a type without specialization fails at compile time
+template <typename T>
+struct ShaderUniformType
+{
+};
+// clang-format off
+template <> struct ShaderUniformType<int> { static constexpr GLenum glType = GL_INT; };
+template <> struct ShaderUniformType<glm::ivec2> { static constexpr GLenum glType = GL_INT_VEC2; };
+template <> struct ShaderUniformType<glm::ivec3> { static constexpr GLenum glType = GL_INT_VEC3; };
+template <> struct ShaderUniformType<glm::ivec4> { static constexpr GLenum glType = GL_INT_VEC4; };
+template <> struct ShaderUniformType<float> { static constexpr GLenum glType = GL_FLOAT; };
+template <> struct ShaderUniformType<glm::vec2> { static constexpr GLenum glType = GL_FLOAT_VEC2; };
+template <> struct ShaderUniformType<glm::vec3> { static constexpr GLenum glType = GL_FLOAT_VEC3; };
+template <> struct ShaderUniformType<glm::vec4> { static constexpr GLenum glType = GL_FLOAT_VEC4; };
+template <> struct ShaderUniformType<glm::mat3> { static constexpr GLenum glType = GL_FLOAT_MAT3; };
+template <> struct ShaderUniformType<glm::mat4> { static constexpr GLenum glType = GL_FLOAT_MAT4; };
+// clang-format on
+
+/*************/
 class Shader : public GraphObject
 {
   public:
@@ -78,6 +103,7 @@ class Shader : public GraphObject
         image_filter,
         blacklevel_filter,
         color_curves_filter,
+        yuv420_filter,
         primitiveId,
         uv,
         userDefined,
@@ -139,6 +165,13 @@ class Shader : public GraphObject
      */
     std::map<std::string, Values> getUniforms() const;
 
+    /**
+     * \brief Check whether the given uniform is used by the shader program
+     * \param name Uniform name
+     * \return Return true if the uniform is active
+     */
+    bool hasUniform(const std::string& name) const;
+
     /**
      * Get the documentation for the uniforms based on the comments in GLSL code
      * \return Return a map of uniforms and their documentation
@@ -147,16 +180,17 @@ class Shader : public GraphObject
 
     /**
      * \brief Set a shader source
+     * Compilation is deferred to the program link, which can use a cached program binary instead
      * \param src Shader string
      * \param type Shader type
-     * \return Return true if the shader was compiled successfully
+     * \return Return true if the shader source was set
      */
     bool setSource(const std::string& src, const ShaderType type);
 
     /**
-     * \brief Set multiple shaders at once
+     * \brief Set multiple shaders at once, and link the resulting program
      * \param sources Map of shader sources
-     * \return Return true if all shader could be compiled
+     * \return Return true if all shader could be compiled and linked
      */
     bool setSource(const std::map<ShaderType, std::string>& sources);
 
@@ -164,7 +198,7 @@ class Shader : public GraphObject
      * \brief Set a shader source from file
      * \param filename Shader file
      * \param type Shader type
-     * \return Return true if the shader was compiled successfully
+     * \return Return true if the shader source could be loaded
      */
     bool setSourceFromFile(const std::string& filename, const ShaderType type);
 
@@ -183,11 +217,37 @@ class Shader : public GraphObject
      */
     void setModelViewProjectionMatrix(const glm::dmat4& mv, const glm::dmat4& mp);
 
+    /**
+     * \brief Set a uniform from a typed value, without going through the attributes and Values conversions
+     * The value is only sent to the GPU if it changed since it was last set
+     * \param name Uniform name
+     * \param value Uniform value, of one of the types specialized in ShaderUniformType
+     */
+    template <typename T>
+    void setUniform(const std::string& name, const T& value)
+    {
+        static_assert(std::is_trivially_copyable<T>::value && sizeof(T) <= sizeof(glm::mat4), "Unsupported uniform type");
+        setTypedUniform(name, ShaderUniformType<T>::glType, &value, sizeof(T));
+    }
+
     /**
      * \brief Set the currently queued uniforms updates
      */
     void updateUniforms();
 
+    /**
+     * \brief Check whether a new program is being compiled and linked in the background
+     * The previous program is used meanwhile, and the uniforms are those of the previous program
+     * \return Return true if a link is pending
+     */
+    bool isLinkPending() const { return _linkPending; }
+
+    /**
+     * \brief Check whether the last link of the program failed
+     * \return Return true if it failed, the previous program being kept if there was one
+     */
+    bool hasLinkFailed() const { return _linkFailed; }
+
   private:
     mutable std::mutex _mutex;
     std::atomic_bool _activated{false};
@@ -196,7 +256,11 @@ class Shader : public GraphObject
     std::unordered_map<int, GLuint> _shaders;
     std::unordered_map<int, std::string> _shadersSource;
     GLuint _program{0};
+    GLuint _previousProgram{0}; //!< Program used while _program is being compiled and linked in the background, 0 if none
     bool _isLinked = {false};
+    bool _linkPending{false}; //!< True while _program is being compiled and linked in the background
+    bool _linkFailed{false};  //!< True if the last link failed
+    bool _bindlessSamplers{false}; //!< True if the samplers of the program can be set from bindless handles
 
     struct Uniform
     {
@@ -207,12 +271,16 @@ class Shader : public GraphObject
         GLint glIndex{-1};
         GLuint glBuffer{0};
         bool glBufferReady{false};
+        GLenum typedType{0};                                //!< GL type of the value set through setUniform, 0 if set from Values
+        std::array<uint8_t, sizeof(glm::mat4)> typedData{}; //!< Value set through setUniform
+        GLuint64 bindlessHandle{0};                         //!< Bindless texture handle last set to this sampler, 0 if set to a texture unit
     };
     std::map<std::string, Uniform> _uniforms;
     std::unordered_map<std::string, std::string> _uniformsDocumentation;
     std::vector<std::string> _uniformsToUpdate;
     std::vector<std::shared_ptr<Texture>> _textures; // Currently used textures
     std::string _currentProgramName{};
+    std::vector<std::string> _feedbackVaryings{};
 
     // Rendering parameters
     Fill _fill{texture};
@@ -220,15 +288,93 @@ class Shader : public GraphObject
     Sideness _sideness{doubleSided};
 
     /**
-     * \brief Compile the shader program
+     * \brief Create a new shader program, to be linked from the current sources
+     * If parallel shader compilation is available, the current program is kept in use until the new one is linked
      */
     void compileProgram();
 
     /**
-     * \brief Link the shader program
+     * \brief Compile a shader from its source
+     * \param type Shader type
+     * \param wait If false, the compilation status is not waited for and is checked once the program is linked
+     * \return Return true if the shader was compiled successfully, or if not waiting for it
+     */
+    bool compileShader(ShaderType type, bool wait = true);
+
+    /**
+     * \brief Check the compilation status of a shader, logging the errors if any
+     * \param type Shader type
+     * \return Return true if the shader was compiled successfully
+     */
+    bool checkShaderStatus(ShaderType type);
+
+    /**
+     * \brief Check the status of the program link, and get its uniforms if it succeeded
+     * \param fromCache True if the program was loaded from the binary cache
+     * \param cacheKey Key of the program in the binary cache
+     * \return Return true if the program was linked successfully
+     */
+    bool finishLink(bool fromCache, const std::string& cacheKey);
+
+    /**
+     * \brief Check whether the background link finished, and replace the previous program if so
+     */
+    void updatePendingLink();
+
+    /**
+     * \brief Store a typed uniform value, and queue it for update if it changed
+     * \param name Uniform name
+     * \param glType GL type of the value
+     * \param data Pointer to the value
+     * \param size Size of the value
+     */
+    void setTypedUniform(const std::string& name, GLenum glType, const void* data, size_t size);
+
+    /**
+     * \brief Send a typed uniform value to the GPU
+     * \param uniform Uniform
+     */
+    void uploadTypedUniform(const Uniform& uniform);
+
+    /**
+     * \brief Convert a typed uniform value to Values
+     * \param uniform Uniform
+     * \return Return the values
+     */
+    static Values typedUniformToValues(const Uniform& uniform);
+
+    /**
+     * \brief Link the shader program, from the program binary cache if possible
      */
     bool linkProgram();
 
+    /**
+     * \brief Get the directory where program binaries are cached
+     * Defaults to $XDG_CACHE_HOME/splash/shaders, and can be overridden with the SPLASH_SHADER_CACHE environment variable, an empty value disabling the cache
+     * \return Return the cache directory, or an empty string if caching is disabled
+     */
+    static std::string getProgramCacheDirectory();
+
+    /**
+     * \brief Get the key identifying the current program in the binary cache
+     * It depends on the shader sources, the transform feedback varyings and the GL driver
+     * \return Return the cache key
+     */
+    std::string getProgramCacheKey() const;
+
+    /**
+     * \brief Load the program from the binary cache
+     * \param key Cache key
+     * \return Return true if the program was loaded and linked
+     */
+    bool loadProgramBinary(const std::string& key);
+
+    /**
+     * \brief Save the linked program to the binary cache
+     * \param key Cache key
+     */
+    void saveProgramBinary(const std::string& key);
+
     /**
      * \brief Parses the shader to replace includes by the corresponding sources
      * \param src Shader source
@@ -98,6 +98,20 @@ struct ShaderSources
             }
         )"},
         //
+        // Sample _tex0 when it is a layer of a texture array, the image covering the _tex0_layerScale part of the layer.
+        // Coordinates are clamped to the image, for the texels of the layer around it not to bleed in when filtering
+        {"textureArrayLayer", R"(
+            uniform sampler2DArray _tex0;
+            uniform float _tex0_layer = 0.0;
+            uniform vec2 _tex0_layerScale = vec2(1.0);
+
+            vec4 sampleLayer(vec2 uv)
+            {
+                vec2 halfTexel = vec2(0.5) / vec2(textureSize(_tex0, 0).xy);
+                return texture(_tex0, vec3(clamp(uv * _tex0_layerScale, halfTexel, _tex0_layerScale - halfTexel), _tex0_layer));
+            }
+        )"},
+        //
         // RGB to HSV and HSV to RGB
         {"hsv", R"(
             vec3 rgb2hsv(vec3 c)
@@ -174,6 +188,14 @@ struct ShaderSources
         #version 450 core
     )"};
 
+    /**
+     * Samplers declared after this can be set from bindless handles, or from texture units
+     */
+    const std::string BINDLESS_SAMPLERS{R"(
+        #extension GL_ARB_bindless_texture : require
+        layout(bindless_sampler) uniform;
+    )"};
+
     /**************************/
     // COMPUTE
     /**************************/
@@ -390,6 +412,103 @@ struct ShaderSources
         }
     )"};
 
+    /**
+     * Compute shader to add the contribution of a camera to the blending weights of another one, in image space
+     * Each pixel of the camera which owns the weights is projected to the contributing camera, and
+     * counts if the contributing camera sees the same point
+     */
+    const std::string COMPUTE_SHADER_ACCUMULATE_BLENDING_WEIGHTS{R"(
+        #extension GL_ARB_compute_shader : enable
+
+        #include getSmoothBlendFromVertex
+
+        layout(local_size_x = 16, local_size_y = 16) in;
+
+        layout(binding = 0) uniform sampler2D _depth;      // Depth seen by the camera owning the weights
+        layout(binding = 1) uniform sampler2D _otherDepth; // Depth seen by the contributing camera
+        layout(rg32f, binding = 0) uniform image2D _weights; // Weight of the owning camera, and sum of the weights of all cameras
+
+        uniform mat4 _inverseViewProjection;
+        uniform mat4 _otherViewProjection;
+        uniform mat4 _otherInverseViewProjection;
+        uniform float _otherBlendWidth = 0.05;
+        uniform int _isSelf = 0;
+        uniform float _depthTolerance = 0.01;
+
+        vec3 unproject(mat4 inverseViewProjection, vec2 coords, float depth)
+        {
+            vec4 point = inverseViewProjection * vec4(vec3(coords, depth) * 2.0 - 1.0, 1.0);
+            return point.xyz / point.w;
+        }
+
+        void main(void)
+        {
+            ivec2 pixCoords = ivec2(gl_GlobalInvocationID.xy);
+            ivec2 size = imageSize(_weights);
+            if (any(greaterThanEqual(pixCoords, size)))
+                return;
+
+            // Nothing is drawn on the background
+            float depth = texelFetch(_depth, pixCoords, 0).r;
+            if (depth >= 1.0)
+                return;
+
+            vec3 point = unproject(_inverseViewProjection, (vec2(pixCoords) + 0.5) / vec2(size), depth);
+            vec4 otherPoint = _otherViewProjection * vec4(point, 1.0);
+            if (otherPoint.w <= 0.0)
+                return;
+            otherPoint /= otherPoint.w;
+            if (any(greaterThan(abs(otherPoint.xy), vec2(1.0))))
+                return;
+
+            if (_isSelf == 0)
+            {
+                // The point is occluded if the contributing camera sees another point, farther than the tolerance
+                vec2 otherCoords = otherPoint.xy * 0.5 + 0.5;
+                ivec2 otherSize = textureSize(_otherDepth, 0);
+                float otherDepth = texelFetch(_otherDepth, clamp(ivec2(otherCoords * vec2(otherSize)), ivec2(0), otherSize - 1), 0).r;
+                if (otherDepth >= 1.0)
+                    return;
+
+                vec3 seenPoint = unproject(_otherInverseViewProjection, otherCoords, otherDepth);
+                vec3 nearPoint = unproject(_otherInverseViewProjection, otherCoords, 0.0);
+                if (distance(seenPoint, point) > _depthTolerance * distance(nearPoint, point))
+                    return;
+            }
+
+            float weight = getSmoothBlendFromVertex(otherPoint, _otherBlendWidth);
+            vec2 weights = imageLoad(_weights, pixCoords).rg;
+            weights.y += weight;
+            if (_isSelf != 0)
+                weights.x = weight;
+            imageStore(_weights, pixCoords, vec4(weights, 0.0, 0.0));
+        }
+    )"};
+
+    /**
+     * Compute shader to convert the accumulated blending weights of a camera to its blending map
+     */
+    const std::string COMPUTE_SHADER_NORMALIZE_BLENDING_WEIGHTS{R"(
+        #extension GL_ARB_compute_shader : enable
+
+        layout(local_size_x = 16, local_size_y = 16) in;
+
+        layout(rg32f, binding = 0) uniform readonly image2D _weights;
+        layout(r16, binding = 1) uniform writeonly image2D _blendingMap;
+
+        void main(void)
+        {
+            ivec2 pixCoords = ivec2(gl_GlobalInvocationID.xy);
+            if (any(greaterThanEqual(pixCoords, imageSize(_blendingMap))))
+                return;
+
+            // Pixels no camera contributed to are left untouched, as for vertices in the vertex blending
+            vec2 weights = imageLoad(_weights, pixCoords).rg;
+            float blendingValue = weights.y == 0.0 ? 1.0 : min(1.0, weights.x / weights.y);
+            imageStore(_blendingMap, pixCoords, vec4(blendingValue));
+        }
+    )"};
+
     /**************************/
     // FEEDBACK
     /**************************/
@@ -841,8 +960,10 @@ struct ShaderSources
      * Does not do much except for applying the intput texture
      */
     const std::string FRAGMENT_SHADER_DEFAULT_FILTER{R"(
-    #ifdef TEXTURE_RECT
+    #if defined(TEXTURE_RECT)
         uniform sampler2DRect _tex0;
+    #elif defined(TEXTURE_ARRAY)
+        #include textureArrayLayer
     #else
         uniform sampler2D _tex0;
     #endif
@@ -856,8 +977,10 @@ struct ShaderSources
 
         void main()
         {
-    #ifdef TEXTURE_RECT
+    #if defined(TEXTURE_RECT)
             vec4 color = texture(_tex0, texCoord * _tex0_size);
+    #elif defined(TEXTURE_ARRAY)
+            vec4 color = sampleLayer(texCoord);
     #else
             vec4 color = texture(_tex0, texCoord);
     #endif
@@ -869,7 +992,7 @@ struct ShaderSources
     /**
      * Image fragment shader for filters
      * This filter applies various color corrections, and is
-     * also able to convert from YUYV to RGB
+     * also able to convert from YUYV and planar YUV to RGB
      */
     const std::string FRAGMENT_SHADER_IMAGE_FILTER{R"(
         #include hsv
@@ -878,22 +1001,31 @@ struct ShaderSources
 
         #define PI 3.14159265359
 
-    #ifdef TEXTURE_RECT
+    #if defined(TEXTURE_RECT)
         uniform sampler2DRect _tex0;
+    #elif defined(TEXTURE_ARRAY)
+        #include textureArrayLayer
     #else
         uniform sampler2D _tex0;
+        // Chroma planes for planar YUV formats
+        uniform sampler2D _tex0_plane1;
+        uniform sampler2D _tex0_plane2;
     #endif
 
         in vec2 texCoord;
         out vec4 fragColor;
 
         uniform vec2 _tex0_size = vec2(1.0);
+        // Regions of the whole image held by the input and output, when filtering a tile of it
+        uniform vec4 _tex0_tileRect = vec4(0.0, 0.0, 1.0, 1.0);
+        uniform vec4 _outputTileRect = vec4(0.0, 0.0, 1.0, 1.0);
         // Texture transformation
         uniform int _tex0_flip = 0;
         uniform int _tex0_flop = 0;
         // Format specific parameters
         uniform int _tex0_YCoCg = 0;
-        uniform int _tex0_YUV = 0; // 1 = UYVY, 2 = YUYV
+        uniform int _tex0_YUV = 0; // 1 = UYVY, 2 = YUYV, 3 = NV12 / P010, 4 = I420
+        uniform int _tex0_gammaEncoded = 0; // Set for textures with a gamma applied and no sRGB internal format
 
         // Film uniforms
         uniform float _filmDuration = 0.f;
@@ -907,23 +1039,30 @@ struct ShaderSources
         uniform vec2 _colorBalance = vec2(1.f, 1.f);
         uniform vec2 _scale = vec2(1.f, 1.f);
 
+        // FUSED_STAGES is set by Filter when the following pointwise filters are computed in this pass,
+        // their source defining applyFusedStages
+
         void main(void)
         {
             // Compute the real texture coordinates, according to flip / flop
+            vec2 imageCoords = fma(texCoord, _outputTileRect.zw, _outputTileRect.xy);
             vec2 realCoords;
             if (_tex0_flip == 1 && _tex0_flop == 0)
-                realCoords = vec2(texCoord.x, 1.0 - texCoord.y);
+                realCoords = vec2(imageCoords.x, 1.0 - imageCoords.y);
             else if (_tex0_flip == 0 && _tex0_flop == 1)
-                realCoords = vec2(1.0 - texCoord.x, texCoord.y);
+                realCoords = vec2(1.0 - imageCoords.x, imageCoords.y);
             else if (_tex0_flip == 1 && _tex0_flop == 1)
-                realCoords = vec2(1.0 - texCoord.x, 1.0 - texCoord.y);
+                realCoords = vec2(1.0 - imageCoords.x, 1.0 - imageCoords.y);
             else
-                realCoords = texCoord;
+                realCoords = imageCoords;
 
             realCoords = fma((realCoords - vec2(0.5)), vec2(1.0) / _scale, vec2(0.5));
+            realCoords = (realCoords - _tex0_tileRect.xy) / _tex0_tileRect.zw;
 
-    #ifdef TEXTURE_RECT
+    #if defined(TEXTURE_RECT)
             vec4 color = texture(_tex0, realCoords * _tex0_size);
+    #elif defined(TEXTURE_ARRAY)
+            vec4 color = sampleLayer(realCoords);
     #else
             vec4 color = texture(_tex0, realCoords);
     #endif
@@ -938,9 +1077,14 @@ struct ShaderSources
                 color.rgba = vec4(Y + Co - Cg, Y + Cg, Y - Co - Cg, 1.0);
                 color.rgb = pow(color.rgb, vec3(2.2));
             }
+            else if (_tex0_gammaEncoded == 1)
+            {
+                color.rgb = pow(color.rgb, vec3(2.2));
+            }
 
+    #ifndef TEXTURE_ARRAY
             // If the color format is YUYV
-            if (_tex0_YUV > 0)
+            if (_tex0_YUV == 1 || _tex0_YUV == 2)
             {
                 // Texture coord rounded to the closer even pixel
                 ivec2 yuyvCoords = ivec2((int(realCoords.x * _tex0_size.x) / 2) * 2, int(realCoords.y * _tex0_size.y));
@@ -956,6 +1100,25 @@ struct ShaderSources
                 else // Odd pixel
                     color.rgb = yuv2rgb(yuyv.bga);
             }
+        #ifndef TEXTURE_RECT
+            // If the color format is planar, _tex0 holds the luma and the chroma is held by the additional planes
+            else if (_tex0_YUV == 3 || _tex0_YUV == 4)
+            {
+                vec3 yuv;
+                yuv.r = color.r;
+                if (_tex0_YUV == 3)
+                {
+                    yuv.gb = texture(_tex0_plane1, realCoords).rg;
+                }
+                else
+                {
+                    yuv.g = texture(_tex0_plane1, realCoords).r;
+                    yuv.b = texture(_tex0_plane2, realCoords).r;
+                }
+                color = vec4(yuv2rgb(yuv), 1.0);
+            }
+        #endif
+    #endif
             
             // Invert channels
             if (_invertChannels == 1)
@@ -968,6 +1131,9 @@ struct ShaderSources
             color.b *= _colorBalance.g / maxBalanceRatio;
 
             color = correctColor(color, _brightness, _saturation, _contrast);
+    #ifdef FUSED_STAGES
+            color = applyFusedStages(color);
+    #endif
             fragColor = color;
         }
     )"};
@@ -976,8 +1142,10 @@ struct ShaderSources
      * Black level fragment shader for filters
      */
     const std::string FRAGMENT_SHADER_BLACKLEVEL_FILTER{R"(
-    #ifdef TEXTURE_RECT
+    #if defined(TEXTURE_RECT)
         uniform sampler2DRect _tex0;
+    #elif defined(TEXTURE_ARRAY)
+        #include textureArrayLayer
     #else
         uniform sampler2D _tex0;
     #endif
@@ -991,13 +1159,79 @@ struct ShaderSources
 
         void main()
         {
-    #ifdef TEXTURE_RECT
+    #if defined(TEXTURE_RECT)
             vec4 color = texture(_tex0, texCoord * _tex0_size);
+    #elif defined(TEXTURE_ARRAY)
+            vec4 color = sampleLayer(texCoord);
     #else
             vec4 color = texture(_tex0, texCoord);
     #endif
 
-            fragColor.rgb = color.rgb * (1.0 - _blackLevel) + _blackLevel;
+            color.rgb = color.rgb * (1.0 - _blackLevel) + _blackLevel;
+    #ifdef FUSED_STAGES
+            color = applyFusedStages(color);
+    #endif
+            fragColor.rgb = color.rgb;
+        }
+    )"};
+
+    /**
+     * RGB to YUV 4:2:0 fragment shader for filters
+     * The output holds the planar I420 frame as is in memory: each RGBA texel packs four consecutive bytes of it,
+     * the Y plane first, then the U and V planes. Colors are converted according to BT.601, in limited range.
+     */
+    const std::string FRAGMENT_SHADER_YUV420_FILTER{R"(
+    #ifdef TEXTURE_RECT
+        uniform sampler2DRect _tex0;
+    #else
+        uniform sampler2D _tex0;
+    #endif
+
+        out vec4 fragColor;
+
+        uniform vec2 _tex0_size = vec2(1.0);
+        uniform ivec2 _frameSize = ivec2(8, 2); // Size of the I420 frame, the width being a multiple of 8
+
+        vec3 sampleInput(vec2 uv, float lod)
+        {
+    #ifdef TEXTURE_RECT
+            return texture(_tex0, uv * _tex0_size).rgb;
+    #else
+            return textureLod(_tex0, uv, lod).rgb;
+    #endif
+        }
+
+        float frameByte(int index, float lod)
+        {
+            int lumaSize = _frameSize.x * _frameSize.y;
+            if (index < lumaSize)
+            {
+                vec2 uv = (vec2(index % _frameSize.x, index / _frameSize.x) + 0.5) / vec2(_frameSize);
+                return (16.0 + dot(sampleInput(uv, lod), vec3(65.481, 128.553, 24.966))) / 255.0;
+            }
+
+            // Chroma is sampled at the center of each 2x2 block
+            int chromaWidth = _frameSize.x / 2;
+            int chromaSize = chromaWidth * (_frameSize.y / 2);
+            int chromaIndex = (index - lumaSize) % chromaSize;
+            vec2 uv = (vec2(chromaIndex % chromaWidth, chromaIndex / chromaWidth) * 2.0 + 1.0) / vec2(_frameSize);
+            vec3 color = sampleInput(uv, lod + 1.0);
+
+            if (index - lumaSize < chromaSize)
+                return (128.0 + dot(color, vec3(-37.797, -74.203, 112.0))) / 255.0;
+            else
+                return (128.0 + dot(color, vec3(112.0, -93.786, -18.214))) / 255.0;
+        }
+
+        void main()
+        {
+            ivec2 texel = ivec2(gl_FragCoord.xy);
+            int index = (texel.y * (_frameSize.x / 4) + texel.x) * 4;
+
+            // Neighbouring texels sample far apart, so the mipmap level is computed from the scaling
+            float lod = max(0.0, log2(max(_tex0_size.x / float(_frameSize.x), _tex0_size.y / float(_frameSize.y))));
+
+            fragColor = vec4(frameByte(index, lod), frameByte(index + 1, lod), frameByte(index + 2, lod), frameByte(index + 3, lod));
         }
     )"};
 
@@ -1006,8 +1240,10 @@ struct ShaderSources
      * This filter applies a transformation curve to RGB colors
      */
     const std::string FRAGMENT_SHADER_COLOR_CURVES_FILTER{R"(
-    #ifdef TEXTURE_RECT
+    #if defined(TEXTURE_RECT)
         uniform sampler2DRect _tex0;
+    #elif defined(TEXTURE_ARRAY)
+        #include textureArrayLayer
     #else
         uniform sampler2D _tex0;
     #endif
@@ -1041,8 +1277,10 @@ struct ShaderSources
 
         void main()
         {
-    #ifdef TEXTURE_RECT
+    #if defined(TEXTURE_RECT)
             vec4 color = texture(_tex0, texCoord * _tex0_size);
+    #elif defined(TEXTURE_ARRAY)
+            vec4 color = sampleLayer(texCoord);
     #else
             vec4 color = texture(_tex0, texCoord);
     #endif
@@ -1063,6 +1301,9 @@ struct ShaderSources
             color.rgb = curvedColor.rgb;
     #endif
 
+    #ifdef FUSED_STAGES
+            color = applyFusedStages(color);
+    #endif
             fragColor.rgb = color.rgb;
         }
     )"};
@@ -1104,6 +1345,8 @@ struct ShaderSources
         uniform int _tex0_flop = 0;
         // HapQ specific parameters
         uniform int _tex0_YCoCg = 0;
+        // Gamma correction, when drawn directly in a window
+        uniform vec2 _gamma = vec2(1.0, 2.2);
 
         void main(void)
         {
@@ -1135,6 +1378,9 @@ struct ShaderSources
                 color.rgb = pow(color.rgb, vec3(2.2));
             }
 
+            if (_gamma.x != 1.0)
+                color.rgb = pow(color.rgb, vec3(1.0 / _gamma.y));
+
             fragColor = color;
         }
     )"};
@@ -1324,6 +1570,9 @@ struct ShaderSources
 
         uniform vec2 _tex0_size = vec2(1.0);
         uniform vec2 _tex1_size = vec2(1.0);
+        // Regions of the whole images held by the textures, when they only hold a tile of them
+        uniform vec4 _tex0_tileRect = vec4(0.0, 0.0, 1.0, 1.0);
+        uniform vec4 _tex1_tileRect = vec4(0.0, 0.0, 1.0, 1.0);
 
         uniform int _showCameraCount = 0;
         uniform int _sideness = 0;
@@ -1332,6 +1581,15 @@ struct ShaderSources
         uniform int _isColorLUT = 0;
         uniform vec4 _color = vec4(0.0, 0.0, 0.0, 1.0);
         uniform vec3 _colorLUT[256];
+        // Whole color transform baked by the camera, on a fixed unit to never alias the other samplers
+        uniform int _isColorTransformLUT = 0;
+        layout(binding = 15) uniform sampler3D _colorTransformLUT;
+    #ifdef IMAGEBLENDING
+        // Blending computed in the image space of the camera, on a fixed unit as well
+        layout(binding = 14) uniform sampler2D _blendingMap;
+        uniform int _isBlendingMap = 0;
+        uniform vec2 _blendingMapScale = vec2(1.0); // Inverse of the render size
+    #endif
         uniform mat3 _colorMixMatrix = mat3(1.0, 0.0, 0.0,
                                             0.0, 1.0, 0.0,
                                             0.0, 0.0, 1.0);
@@ -1365,7 +1623,7 @@ struct ShaderSources
         #ifdef TEXTURE_RECT
             vec4 color = texture(_tex0, texCoord * _tex0_size);
         #else
-            vec4 color = texture(_tex0, texCoord);
+            vec4 color = texture(_tex0, (texCoord - _tex0_tileRect.xy) / _tex0_tileRect.zw);
         #endif
         #else
             vec4 color = _color;
@@ -1375,29 +1633,45 @@ struct ShaderSources
         #ifdef TEXTURE_RECT
             vec4 maskColor = texture(_tex1, texCoord * _tex1_size);
         #else
-            vec4 maskColor = texture(_tex1, texCoord);
+            vec4 maskColor = texture(_tex1, (texCoord - _tex1_tileRect.xy) / _tex1_tileRect.zw);
         #endif
             color.rgb = mix(color.rgb, maskColor.rgb, maskColor.a);
         #endif
 
-            float maxBalanceRatio = max(_fovAndColorBalance.z, _fovAndColorBalance.w);
-            color.r *= _fovAndColorBalance.z / maxBalanceRatio;
-            color.g *= 1.0 / maxBalanceRatio;
-            color.b *= _fovAndColorBalance.w / maxBalanceRatio;
-
         #ifdef VERTEXBLENDING
-            color.rgb = color.rgb * vertexIn.blendingValue;
+            float blendingValue = vertexIn.blendingValue;
+        #elif defined(IMAGEBLENDING)
+            float blendingValue = _isBlendingMap != 0 ? texture(_blendingMap, gl_FragCoord.xy * _blendingMapScale).r : 1.0;
+        #else
+            float blendingValue = 1.0;
         #endif
 
-            // Brightness correction
-            color = correctColor(color, brightness, saturation, contrast);
-
-            // Color correction through a LUT
-            if (_isColorLUT != 0)
+            if (_isColorTransformLUT != 0)
             {
-                ivec3 icolor = ivec3(round(color.rgb * 255.f));
-                color.rgb = vec3(_colorLUT[icolor.r].r, _colorLUT[icolor.g].g, _colorLUT[icolor.b].b);
-                //color.rgb = clamp(_colorMixMatrix * color.rgb, vec3(0.0), vec3(1.0));
+                // The blending commutes with the color balance, so it can be applied before the baked transform
+                vec3 lutSize = vec3(textureSize(_colorTransformLUT, 0));
+                vec3 lutCoords = clamp(color.rgb * blendingValue, 0.0, 1.0) * (lutSize - 1.0) / lutSize + 0.5 / lutSize;
+                color.rgb = texture(_colorTransformLUT, lutCoords).rgb;
+            }
+            else
+            {
+                float maxBalanceRatio = max(_fovAndColorBalance.z, _fovAndColorBalance.w);
+                color.r *= _fovAndColorBalance.z / maxBalanceRatio;
+                color.g *= 1.0 / maxBalanceRatio;
+                color.b *= _fovAndColorBalance.w / maxBalanceRatio;
+
+                color.rgb = color.rgb * blendingValue;
+
+                // Brightness correction
+                color = correctColor(color, brightness, saturation, contrast);
+
+                // Color correction through a LUT
+                if (_isColorLUT != 0)
+                {
+                    ivec3 icolor = ivec3(round(color.rgb * 255.f));
+                    color.rgb = vec3(_colorLUT[icolor.r].r, _colorLUT[icolor.g].g, _colorLUT[icolor.b].b);
+                    //color.rgb = clamp(_colorMixMatrix * color.rgb, vec3(0.0), vec3(1.0));
+                }
             }
 
             fragColor.rgb = color.rgb;
@@ -31,6 +31,19 @@ Texture::~Texture()
 #endif
 }
 
+/*************/
+bool Texture::isSampledWithMipmaps() const
+{
+    for (const auto& parent : getParents())
+    {
+        auto texture = dynamic_cast<const Texture*>(parent);
+        if (!texture || texture->samplesWithMipmaps(*this))
+            return true;
+    }
+
+    return false;
+}
+
 /*************/
 void Texture::registerAttributes()
 {
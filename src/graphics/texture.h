@@ -25,6 +25,7 @@
 #ifndef SPLASH_TEXTURE_H
 #define SPLASH_TEXTURE_H
 
+#include <atomic>
 #include <chrono>
 #include <glm/glm.hpp>
 #include <memory>
@@ -88,11 +89,25 @@ class Texture : public GraphObject
      */
     virtual GLuint getTexId() const = 0;
 
+    /**
+     * Get a bindless handle to sample the texture from, resident in the current context, see ARB_bindless_texture
+     * This must be called instead of bind(), unbind() still has to be called once done
+     * \return Return the handle, or 0 if the texture has to be bound
+     */
+    virtual GLuint64 getBindlessHandle() { return 0; }
+
     /**
      *  Get the prefix for the glsl sampler name
      */
     virtual std::string getPrefix() const { return "_tex"; }
 
+    /**
+     * Get the additional planes of the texture, for planar formats
+     * These are bound as "<prefix><unit>_plane<N>", N starting at 1
+     * \return Return the planes, empty for non planar formats
+     */
+    virtual std::vector<std::shared_ptr<Texture>> getPlanes() const { return {}; }
+
     /**
      * Get the timestamp
      * \return Return the timestamp in us
@@ -105,6 +120,18 @@ class Texture : public GraphObject
      */
     virtual void setTimestamp(int64_t timestamp) override { _spec.timestamp = timestamp; }
 
+    /**
+     * Get the content version, incremented each time the texture is rendered to
+     * Along with the timestamp, this is used to detect changes in the texture content
+     * \return Return the content version
+     */
+    virtual uint64_t getContentVersion() const { return _contentVersion; }
+
+    /**
+     * Signal that the texture content has been rendered to
+     */
+    void setContentUpdated() { ++_contentVersion; }
+
     /**
      *  Lock the texture for read / write operations
      */
@@ -121,9 +148,25 @@ class Texture : public GraphObject
      */
     void setResizable(bool resizable) { _resizable = resizable; }
 
+    /**
+     * Check whether any consumer of this texture samples it with mipmaps
+     * Consumers which are not textures are assumed to need them. This goes through the parents,
+     * so the objects should not be modified concurrently.
+     * \return Return true if the mipmaps have to be generated
+     */
+    bool isSampledWithMipmaps() const;
+
+    /**
+     * Check whether this texture samples the given input texture with mipmaps
+     * \param input Input texture
+     * \return Return true if the mipmaps of the input are sampled
+     */
+    virtual bool samplesWithMipmaps(const Texture& /*input*/) const { return true; }
+
   protected:
     mutable std::mutex _mutex;
     ImageBufferSpec _spec;
+    std::atomic_uint64_t _contentVersion{0};
 
     // Store some texture parameters
     bool _resizable{true};
@@ -0,0 +1,500 @@
+#include "./graphics/texture_array.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "./utils/log.h"
+
+// Maximum width and height of the layers, images larger than this are not held by arrays
+#define SPLASH_TEXTURE_ARRAY_MAX_LAYER_SIZE 4096
+// Layers are allocated with a size rounded up to a multiple of this, so that slightly larger images do not trigger a reallocation
+#define SPLASH_TEXTURE_ARRAY_SIZE_ALIGNMENT 64
+// Number of layers allocated at first, doubled each time the array is full
+#define SPLASH_TEXTURE_ARRAY_MIN_LAYERS 8
+// Number of PBOs in the upload ring
+#define SPLASH_TEXTURE_ARRAY_PBOS 3
+
+using namespace std;
+
+namespace Splash
+{
+
+/*************/
+Texture_Array::Texture_Array(RootObject* root)
+    : Texture(root)
+{
+    init();
+}
+
+/*************/
+Texture_Array::~Texture_Array()
+{
+    if (!_root)
+        return;
+
+#ifdef DEBUG
+    Log::get() << Log::DEBUGGING << "Texture_Array::~Texture_Array - Destructor" << Log::endl;
+#endif
+
+    lock_guard<mutex> lock(_mutex);
+    glDeleteTextures(1, &_glTex);
+    deletePbos();
+}
+
+/*************/
+void Texture_Array::init()
+{
+    _type = "texture_array";
+    registerAttributes();
+
+    // This is used for getting documentation "offline"
+    if (!_root)
+        return;
+}
+
+/*************/
+void Texture_Array::bind()
+{
+    glGetIntegerv(GL_ACTIVE_TEXTURE, &_activeTexture);
+    _activeTexture = _activeTexture - GL_TEXTURE0;
+    glBindTextureUnit(_activeTexture, _glTex);
+}
+
+/*************/
+void Texture_Array::unbind()
+{
+#ifdef DEBUG
+    glBindTextureUnit(_activeTexture, 0);
+#endif
+}
+
+/*************/
+unordered_map<string, Values> Texture_Array::getShaderUniforms() const
+{
+    unordered_map<string, Values> uniforms;
+    uniforms["size"] = {static_cast<float>(_layerWidth), static_cast<float>(_layerHeight)};
+    return uniforms;
+}
+
+/*************/
+GraphObject::MemoryUsage Texture_Array::getMemoryUsage() const
+{
+    lock_guard<mutex> lock(_mutex);
+
+    MemoryUsage usage;
+    if (!_glTex)
+        return usage;
+
+    usage.vram = static_cast<int64_t>(_layerWidth) * _layerHeight * 4 * _layerCapacity;
+    usage.vram += static_cast<int64_t>(_pbos.size() * _pboSize);
+    return usage;
+}
+
+/*************/
+int Texture_Array::addImage(const shared_ptr<Image>& image)
+{
+    lock_guard<mutex> lock(_mutex);
+
+    auto layerIt = find_if(_layers.begin(), _layers.end(), [](const Layer& layer) { return !layer.used; });
+    if (layerIt == _layers.end())
+    {
+        if (_maxLayers > 0 && static_cast<int>(_layers.size()) >= _maxLayers)
+        {
+            Log::get() << Log::WARNING << "Texture_Array::" << __FUNCTION__ << " - Texture array " << _name << " is full (" << _maxLayers << " layers), image "
+                       << image->getName() << " can not be added to it" << Log::endl;
+            return -1;
+        }
+        layerIt = _layers.emplace(_layers.end());
+    }
+
+    *layerIt = Layer();
+    layerIt->image = image;
+    layerIt->used = true;
+
+    return static_cast<int>(distance(_layers.begin(), layerIt));
+}
+
+/*************/
+void Texture_Array::removeImage(int layer)
+{
+    lock_guard<mutex> lock(_mutex);
+    if (layer < 0 || layer >= static_cast<int>(_layers.size()))
+        return;
+
+    // The content of the layer is left as is, it is overwritten when the layer is given to another image
+    _layers[layer] = Layer();
+}
+
+/*************/
+ImageBufferSpec Texture_Array::getLayerSpec(int layer) const
+{
+    lock_guard<mutex> lock(_mutex);
+    if (layer < 0 || layer >= static_cast<int>(_layers.size()))
+        return {};
+    return _layers[layer].spec;
+}
+
+/*************/
+glm::ivec2 Texture_Array::getLayerSize() const
+{
+    lock_guard<mutex> lock(_mutex);
+    return {_layerWidth, _layerHeight};
+}
+
+/*************/
+bool Texture_Array::isSupported(const ImageBufferSpec& spec)
+{
+    if (spec.type != ImageBufferSpec::Type::UINT8 || spec.bpp != spec.channels * 8)
+        return false;
+    if (spec.format != "RGB" && spec.format != "BGR" && spec.format != "RGBA" && spec.format != "BGRA")
+        return false;
+    if (spec.tileX != 0 || spec.tileY != 0 || spec.fullWidth > spec.width || spec.fullHeight > spec.height)
+        return false;
+    if (spec.width == 0 || spec.height == 0 || spec.width > SPLASH_TEXTURE_ARRAY_MAX_LAYER_SIZE || spec.height > SPLASH_TEXTURE_ARRAY_MAX_LAYER_SIZE)
+        return false;
+    return true;
+}
+
+/*************/
+void Texture_Array::update()
+{
+    lock_guard<mutex> lock(_mutex);
+
+    if (_maxLayers == 0)
+        glGetIntegerv(GL_MAX_ARRAY_TEXTURE_LAYERS, &_maxLayers);
+
+    // Gather the images which changed, and the layer size needed to hold them
+    vector<pair<int, shared_ptr<const ImageBuffer>>> uploads;
+    int width = _layerWidth;
+    int height = _layerHeight;
+    for (int index = 0; index < static_cast<int>(_layers.size()); ++index)
+    {
+        auto& layer = _layers[index];
+        if (!layer.used)
+            continue;
+
+        auto img = layer.image.lock();
+        if (!img || img->getTimestamp() == layer.timestamp)
+            continue;
+
+        img->update();
+        layer.timestamp = img->getTimestamp();
+        auto buffer = img->getSnapshot();
+        if (!buffer)
+            continue;
+
+        const auto& spec = buffer->getSpec();
+        Values srgb;
+        img->getAttribute("srgb", srgb);
+        const bool firstImage = _glTex == 0 && uploads.empty();
+        if (firstImage && !srgb.empty())
+            _srgb = srgb[0].as<bool>();
+
+        if (!isSupported(spec) || (!srgb.empty() && srgb[0].as<bool>() != _srgb))
+        {
+            if (!layer.rejected)
+                Log::get() << Log::WARNING << "Texture_Array::" << __FUNCTION__ << " - Image " << img->getName() << " can not be held by texture array " << _name
+                           << ", which only holds 8 bits RGB(A) images up to " << SPLASH_TEXTURE_ARRAY_MAX_LAYER_SIZE << " pixels wide and high, all with srgb set to "
+                           << _srgb << Log::endl;
+            layer.rejected = true;
+            continue;
+        }
+        layer.rejected = false;
+
+        width = std::max(width, static_cast<int>(spec.width));
+        height = std::max(height, static_cast<int>(spec.height));
+        uploads.emplace_back(index, buffer);
+    }
+
+    if (uploads.empty())
+        return;
+
+    width = std::min((width + SPLASH_TEXTURE_ARRAY_SIZE_ALIGNMENT - 1) / SPLASH_TEXTURE_ARRAY_SIZE_ALIGNMENT * SPLASH_TEXTURE_ARRAY_SIZE_ALIGNMENT, SPLASH_TEXTURE_ARRAY_MAX_LAYER_SIZE);
+    height = std::min((height + SPLASH_TEXTURE_ARRAY_SIZE_ALIGNMENT - 1) / SPLASH_TEXTURE_ARRAY_SIZE_ALIGNMENT * SPLASH_TEXTURE_ARRAY_SIZE_ALIGNMENT, SPLASH_TEXTURE_ARRAY_MAX_LAYER_SIZE);
+    int capacity = std::max(_layerCapacity, SPLASH_TEXTURE_ARRAY_MIN_LAYERS);
+    while (capacity < static_cast<int>(_layers.size()))
+        capacity *= 2;
+    capacity = std::min(capacity, _maxLayers);
+
+    if (width != _layerWidth || height != _layerHeight || capacity != _layerCapacity)
+        if (!reallocate(width, height, capacity))
+            return;
+
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    for (const auto& [index, buffer] : uploads)
+    {
+        if (index >= _layerCapacity)
+            continue;
+
+        const auto& spec = buffer->getSpec();
+        GLenum glChannelOrder = GL_RGBA;
+        if (spec.format == "RGB")
+            glChannelOrder = GL_RGB;
+        else if (spec.format == "BGR")
+            glChannelOrder = GL_BGR;
+        else if (spec.format == "BGRA")
+            glChannelOrder = GL_BGRA;
+
+        // Each PBO is reused once the upload from it, started a few layers before, is done
+        waitForPboFence(_pboIndex);
+        memcpy(_pbosPixels[_pboIndex], buffer->data(), spec.rawSize());
+
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, _pbos[_pboIndex]);
+        glTextureSubImage3D(_glTex, 0, 0, 0, index, spec.width, spec.height, 1, glChannelOrder, GL_UNSIGNED_BYTE, nullptr);
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        _pboFences[_pboIndex] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        _pboIndex = (_pboIndex + 1) % static_cast<int>(_pbos.size());
+
+        auto& layer = _layers[index];
+        layer.spec = spec;
+        layer.spec.timestamp = layer.timestamp;
+        _spec.timestamp = std::max(_spec.timestamp, layer.timestamp);
+    }
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+    setContentUpdated();
+}
+
+/*************/
+bool Texture_Array::reallocate(int width, int height, int capacity)
+{
+    if (width <= 0 || height <= 0 || capacity <= 0)
+        return false;
+
+    GLuint glTex;
+    glCreateTextures(GL_TEXTURE_2D_ARRAY, 1, &glTex);
+    glTextureParameteri(glTex, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTextureParameteri(glTex, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTextureParameteri(glTex, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTextureParameteri(glTex, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTextureStorage3D(glTex, 1, _srgb ? GL_SRGB8_ALPHA8 : GL_RGBA8, width, height, capacity);
+    glClearTexImage(glTex, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+
+    if (glGetError() != GL_NO_ERROR)
+    {
+        Log::get() << Log::WARNING << "Texture_Array::" << __FUNCTION__ << " - Unable to allocate texture array " << _name << " with " << capacity << " layers of " << width << "x"
+                   << height << Log::endl;
+        glDeleteTextures(1, &glTex);
+        return false;
+    }
+
+    // The layers already uploaded are kept, the array only ever grows
+    if (_glTex)
+    {
+        glCopyImageSubData(_glTex,
+            GL_TEXTURE_2D_ARRAY,
+            0,
+            0,
+            0,
+            0,
+            glTex,
+            GL_TEXTURE_2D_ARRAY,
+            0,
+            0,
+            0,
+            0,
+            std::min(_layerWidth, width),
+            std::min(_layerHeight, height),
+            std::min(_layerCapacity, capacity));
+        glDeleteTextures(1, &_glTex);
+    }
+
+    _glTex = glTex;
+    _layerWidth = width;
+    _layerHeight = height;
+    _layerCapacity = capacity;
+
+    Log::get() << Log::MESSAGE << "Texture_Array::" << __FUNCTION__ << " - Texture array " << _name << " holds " << capacity << " layers of " << width << "x" << height
+               << Log::endl;
+
+    const auto pboSize = static_cast<size_t>(width) * height * 4;
+    if (pboSize == _pboSize)
+        return true;
+
+    deletePbos();
+    _pboSize = pboSize;
+    _pbos.resize(SPLASH_TEXTURE_ARRAY_PBOS);
+    _pbosPixels.resize(SPLASH_TEXTURE_ARRAY_PBOS);
+    _pboFences.resize(SPLASH_TEXTURE_ARRAY_PBOS, nullptr);
+    glCreateBuffers(SPLASH_TEXTURE_ARRAY_PBOS, _pbos.data());
+    for (int i = 0; i < SPLASH_TEXTURE_ARRAY_PBOS; ++i)
+    {
+        glNamedBufferStorage(_pbos[i], _pboSize, 0, GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT);
+        _pbosPixels[i] = static_cast<GLubyte*>(glMapNamedBufferRange(_pbos[i], 0, _pboSize, GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT));
+    }
+    _pboIndex = 0;
+
+    return true;
+}
+
+/*************/
+void Texture_Array::deletePbos()
+{
+    for (auto& fence : _pboFences)
+        if (fence)
+            glDeleteSync(fence);
+
+    for (auto pbo : _pbos)
+        glUnmapNamedBuffer(pbo);
+    if (!_pbos.empty())
+        glDeleteBuffers(_pbos.size(), _pbos.data());
+
+    _pbos.clear();
+    _pbosPixels.clear();
+    _pboFences.clear();
+    _pboSize = 0;
+}
+
+/*************/
+void Texture_Array::waitForPboFence(int index)
+{
+    auto& fence = _pboFences[index];
+    if (!fence)
+        return;
+
+    while (glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000) == GL_TIMEOUT_EXPIRED)
+        continue;
+
+    glDeleteSync(fence);
+    fence = nullptr;
+}
+
+/*************/
+void Texture_Array::registerAttributes()
+{
+    Texture::registerAttributes();
+
+    addAttribute("layers", [](const Values&) { return true; }, [&]() -> Values {
+        lock_guard<mutex> lock(_mutex);
+        return {static_cast<int>(count_if(_layers.begin(), _layers.end(), [](const Layer& layer) { return layer.used; })), _layerCapacity};
+    });
+    setAttributeDescription("layers", "Number of layers used by images, and number of layers allocated");
+
+    addAttribute("layerSize", [](const Values&) { return true; }, [&]() -> Values {
+        lock_guard<mutex> lock(_mutex);
+        return {_layerWidth, _layerHeight};
+    });
+    setAttributeDescription("layerSize", "Size of the layers, which is the size of the largest image held by the array");
+}
+
+/*************/
+Texture_ArrayLayer::Texture_ArrayLayer(RootObject* root)
+    : Texture(root)
+{
+    _type = "texture_array_layer";
+    registerAttributes();
+}
+
+/*************/
+Texture_ArrayLayer::~Texture_ArrayLayer()
+{
+#ifdef DEBUG
+    Log::get() << Log::DEBUGGING << "Texture_ArrayLayer::~Texture_ArrayLayer - Destructor" << Log::endl;
+#endif
+
+    releaseLayer();
+}
+
+/*************/
+void Texture_ArrayLayer::bind()
+{
+    if (_array)
+        _array->bind();
+}
+
+/*************/
+void Texture_ArrayLayer::unbind()
+{
+    if (_array)
+        _array->unbind();
+}
+
+/*************/
+ImageBufferSpec Texture_ArrayLayer::getSpec() const
+{
+    if (!_array || _layer < 0)
+        return {};
+    return _array->getLayerSpec(_layer);
+}
+
+/*************/
+unordered_map<string, Values> Texture_ArrayLayer::getShaderUniforms() const
+{
+    unordered_map<string, Values> uniforms;
+    if (!_array || _layer < 0)
+        return uniforms;
+
+    const auto spec = getSpec();
+    const auto layerSize = _array->getLayerSize();
+    uniforms["size"] = {static_cast<float>(spec.width), static_cast<float>(spec.height)};
+    uniforms["layer"] = {static_cast<float>(_layer)};
+    if (layerSize.x > 0 && layerSize.y > 0)
+        uniforms["layerScale"] = {static_cast<float>(spec.width) / static_cast<float>(layerSize.x), static_cast<float>(spec.height) / static_cast<float>(layerSize.y)};
+
+    if (auto img = _img.lock())
+    {
+        Values flip, flop;
+        img->getAttribute("flip", flip);
+        img->getAttribute("flop", flop);
+        uniforms["flip"] = flip;
+        uniforms["flop"] = flop;
+    }
+
+    return uniforms;
+}
+
+/*************/
+bool Texture_ArrayLayer::linkIt(const shared_ptr<GraphObject>& obj)
+{
+    if (auto array = dynamic_pointer_cast<Texture_Array>(obj))
+    {
+        releaseLayer();
+        _array = array;
+        acquireLayer();
+        return true;
+    }
+    else if (auto img = dynamic_pointer_cast<Image>(obj))
+    {
+        releaseLayer();
+        _img = img;
+        acquireLayer();
+        return true;
+    }
+
+    return false;
+}
+
+/*************/
+void Texture_ArrayLayer::unlinkIt(const shared_ptr<GraphObject>& obj)
+{
+    if (obj == _array)
+    {
+        releaseLayer();
+        _array.reset();
+    }
+    else if (dynamic_pointer_cast<Image>(obj) && obj == _img.lock())
+    {
+        releaseLayer();
+        _img.reset();
+    }
+}
+
+/*************/
+void Texture_ArrayLayer::acquireLayer()
+{
+    auto img = _img.lock();
+    if (!_array || !img)
+        return;
+
+    _layer = _array->addImage(img);
+}
+
+/*************/
+void Texture_ArrayLayer::releaseLayer()
+{
+    if (_array && _layer >= 0)
+        _array->removeImage(_layer);
+    _layer = -1;
+}
+
+} // namespace Splash
@@ -0,0 +1,272 @@
+/*
+ * Copyright (C) 2026 Emmanuel Durand
+ *
+ * This file is part of Splash.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Splash is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Splash.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * @texture_array.h
+ * The Texture_Array and Texture_ArrayLayer classes, packing many small images in a single texture
+ */
+
+#ifndef SPLASH_TEXTURE_ARRAY_H
+#define SPLASH_TEXTURE_ARRAY_H
+
+#include <glm/glm.hpp>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "./core/constants.h"
+
+#include "./core/attribute.h"
+#include "./graphics/texture.h"
+#include "./image/image.h"
+
+namespace Splash
+{
+
+/*************/
+//! Array texture holding one image per layer, for projects using many small still images
+//! All the layers share the size of the largest image, smaller images being held in the bottom left corner
+//! of their layer. Images are uploaded through a single ring of PBOs, and are sampled through a Texture_ArrayLayer
+//! which selects their layer. Only uncompressed 8 bits images with the same sRGB setting can share an array.
+class Texture_Array : public Texture
+{
+  public:
+    /**
+     * Constructor
+     * \param root Root object
+     */
+    explicit Texture_Array(RootObject* root);
+
+    /**
+     * Destructor
+     */
+    ~Texture_Array() final;
+
+    Texture_Array(const Texture_Array&) = delete;
+    Texture_Array& operator=(const Texture_Array&) = delete;
+
+    /**
+     * Bind this texture
+     */
+    void bind() final;
+
+    /**
+     * Unbind this texture
+     */
+    void unbind() final;
+
+    /**
+     * Get the id of the gl texture
+     * \return Return the texture id
+     */
+    GLuint getTexId() const final { return _glTex; }
+
+    /**
+     * Get the shader parameters related to this texture. Texture should be locked first.
+     * \return Return the shader uniforms
+     */
+    std::unordered_map<std::string, Values> getShaderUniforms() const final;
+
+    /**
+     * Get the memory held by the texture storage and its PBOs
+     * \return Return the memory usage
+     */
+    MemoryUsage getMemoryUsage() const final;
+
+    /**
+     * Add an image to the array, uploaded to a layer of its own from the next update
+     * \param image Image
+     * \return Return the layer index
+     */
+    int addImage(const std::shared_ptr<Image>& image);
+
+    /**
+     * Remove the image of the given layer, which can then be given to another image
+     * \param layer Layer index
+     */
+    void removeImage(int layer);
+
+    /**
+     * Get the spec of the image last uploaded to the given layer
+     * \param layer Layer index
+     * \return Return the spec, with the timestamp of the upload. The spec is empty if nothing was uploaded yet
+     */
+    ImageBufferSpec getLayerSpec(int layer) const;
+
+    /**
+     * Get the size of the layers
+     * \return Return the width and height of the layers
+     */
+    glm::ivec2 getLayerSize() const;
+
+    /**
+     * Upload the images which changed since the last update, growing the array if needed
+     */
+    void update() final;
+
+  private:
+    struct Layer
+    {
+        std::weak_ptr<Image> image{};
+        ImageBufferSpec spec{}; //!< Spec of the last uploaded image
+        int64_t timestamp{-1};  //!< Timestamp of the image when last checked for an upload
+        bool used{false};
+        bool rejected{false}; //!< Set if the image can not be held by the array, to only warn once
+    };
+
+    GLuint _glTex{0};
+    GLint _activeTexture{0};
+    int _layerWidth{0};
+    int _layerHeight{0};
+    int _layerCapacity{0}; //!< Number of layers allocated in the texture
+    int _maxLayers{0};     //!< Maximum number of layers supported by the driver, queried on first update
+    std::vector<Layer> _layers{};
+    bool _srgb{true}; //!< Whether the layers are stored as sRGB, set from the first image uploaded
+
+    // Ring of PBOs shared by all the layers, each the size of a layer
+    std::vector<GLuint> _pbos{};
+    std::vector<GLubyte*> _pbosPixels{};
+    std::vector<GLsync> _pboFences{};
+    size_t _pboSize{0};
+    int _pboIndex{0};
+
+    /**
+     * Initialization
+     */
+    void init();
+
+    /**
+     * Reallocate the texture storage and the PBOs for the given layer size and count, keeping the uploaded layers
+     * \param width Layer width
+     * \param height Layer height
+     * \param capacity Layer count
+     * \return Return true if all went well
+     */
+    bool reallocate(int width, int height, int capacity);
+
+    /**
+     * Delete the PBOs and their fences
+     */
+    void deletePbos();
+
+    /**
+     * Wait for the upload from the given PBO to be done, so that it can be written to
+     * \param index PBO index
+     */
+    void waitForPboFence(int index);
+
+    /**
+     * Check whether an image spec can be held by the array
+     * \param spec Image spec
+     * \return Return true if the image can be uploaded to a layer
+     */
+    static bool isSupported(const ImageBufferSpec& spec);
+
+    /**
+     * Register new functors to modify attributes
+     */
+    void registerAttributes();
+};
+
+/*************/
+//! Single layer of a Texture_Array, sampled by the filters as any other texture
+//! Shaders get the layer index and the part of the layer covered by the image through the layer and layerScale uniforms.
+class Texture_ArrayLayer : public Texture
+{
+  public:
+    /**
+     * Constructor
+     * \param root Root object
+     */
+    explicit Texture_ArrayLayer(RootObject* root);
+
+    /**
+     * Destructor, giving the layer back to the array
+     */
+    ~Texture_ArrayLayer() final;
+
+    Texture_ArrayLayer(const Texture_ArrayLayer&) = delete;
+    Texture_ArrayLayer& operator=(const Texture_ArrayLayer&) = delete;
+
+    /**
+     * Bind the texture array
+     */
+    void bind() final;
+
+    /**
+     * Unbind the texture array
+     */
+    void unbind() final;
+
+    /**
+     * Get the id of the gl texture array
+     * \return Return the texture id, or 0 if not linked to an array
+     */
+    GLuint getTexId() const final { return _array ? _array->getTexId() : 0; }
+
+    /**
+     * Get the spec of the image held by the layer
+     * \return Return the spec
+     */
+    ImageBufferSpec getSpec() const final;
+
+    /**
+     * Get the timestamp of the last upload to the layer
+     * \return Return the timestamp in us
+     */
+    int64_t getTimestamp() const final { return getSpec().timestamp; }
+
+    /**
+     * Get the shader parameters related to this texture. Texture should be locked first.
+     * \return Return the shader uniforms
+     */
+    std::unordered_map<std::string, Values> getShaderUniforms() const final;
+
+  protected:
+    /**
+     * Try to link the given GraphObject to this object
+     * \param obj Shared pointer to the (wannabe) child object
+     */
+    bool linkIt(const std::shared_ptr<GraphObject>& obj) final;
+
+    /**
+     * Unlink a given object
+     * \param obj Object to unlink from
+     */
+    void unlinkIt(const std::shared_ptr<GraphObject>& obj) final;
+
+  private:
+    std::shared_ptr<Texture_Array> _array{nullptr};
+    std::weak_ptr<Image> _img{};
+    int _layer{-1}; //!< Layer index in the array, -1 until both the array and the image are linked
+
+    /**
+     * Get a layer from the array once both the array and the image are linked
+     */
+    void acquireLayer();
+
+    /**
+     * Give the layer back to the array
+     */
+    void releaseLayer();
+};
+
+} // namespace Splash
+
+#endif // SPLASH_TEXTURE_ARRAY_H
@@ -1,11 +1,20 @@
 #include "./graphics/texture_image.h"
 
+#include <algorithm>
+#include <cstring>
 #include <string>
 
+#include "./core/scene.h"
 #include "./image/image.h"
 #include "./utils/log.h"
+#include "./utils/thread_pool.h"
 #include "./utils/timer.h"
 
+// Maximum number of PBOs in the upload ring
+#define SPLASH_TEXTURE_MAX_PBOS 8
+// Number of PBOs in the read back rings, reads are dropped when they are all pending
+#define SPLASH_TEXTURE_READBACK_PBOS 3
+
 using namespace std;
 
 namespace Splash
@@ -40,12 +49,20 @@ Texture_Image::~Texture_Image()
 
     lock_guard<mutex> lock(_mutex);
     glDeleteTextures(1, &_glTex);
-    glDeleteBuffers(2, _pbos);
+    deleteBindlessHandles();
+    discardStagedUpload();
+    deletePbos();
+    deleteReadback(_mipmapReadback);
+    deleteReadback(_meanReadback);
+    if (_uploadFence)
+        glDeleteSync(_uploadFence);
 }
 
 /*************/
 Texture_Image& Texture_Image::operator=(const shared_ptr<Image>& img)
 {
+    lock_guard<mutex> lock(_mutex);
+    detachUploadRing();
     _img = weak_ptr<Image>(img);
     return *this;
 }
@@ -53,15 +70,104 @@ Texture_Image& Texture_Image::operator=(const shared_ptr<Image>& img)
 /*************/
 void Texture_Image::bind()
 {
+    waitForUpload();
+
     glGetIntegerv(GL_ACTIVE_TEXTURE, &_activeTexture);
     _activeTexture = _activeTexture - GL_TEXTURE0;
     glBindTextureUnit(_activeTexture, _glTex);
+
+    // The texture parameters are frozen once a bindless handle exists, the levels limit comes from its sampler
+    if (!_bindlessHandles.empty())
+    {
+        glBindSampler(_activeTexture, getBindlessHandleForMaxLevel().sampler);
+        _samplerBound = true;
+    }
+}
+
+/*************/
+GLuint64 Texture_Image::getBindlessHandle()
+{
+    if (!Scene::getHasBindlessTextures() || _multisample > 1 || _cubemap || _glTex == 0)
+        return 0;
+
+    waitForUpload();
+
+    auto& bindlessHandle = getBindlessHandleForMaxLevel();
+    auto context = glfwGetCurrentContext();
+    if (find(bindlessHandle.residentContexts.begin(), bindlessHandle.residentContexts.end(), context) == bindlessHandle.residentContexts.end())
+    {
+        glMakeTextureHandleResidentARB(bindlessHandle.handle);
+        bindlessHandle.residentContexts.push_back(context);
+    }
+
+    return bindlessHandle.handle;
 }
 
 /*************/
-void Texture_Image::generateMipmap() const
+Texture_Image::BindlessHandle& Texture_Image::getBindlessHandleForMaxLevel()
 {
-    glGenerateTextureMipmap(_glTex);
+    if (auto handleIt = _bindlessHandles.find(_maxLevel); handleIt != _bindlessHandles.end())
+        return handleIt->second;
+
+    // No level is excluded by the texture itself anymore, this has to be set before the first handle is created
+    if (_bindlessHandles.empty())
+        glTextureParameteri(_glTex, GL_TEXTURE_MAX_LEVEL, 1000);
+
+    // The sampler mirrors the texture parameters, with the levels limit applied as a LOD clamp
+    BindlessHandle bindlessHandle;
+    glCreateSamplers(1, &bindlessHandle.sampler);
+    for (auto parameter : {GL_TEXTURE_MIN_FILTER, GL_TEXTURE_MAG_FILTER, GL_TEXTURE_WRAP_S, GL_TEXTURE_WRAP_T})
+    {
+        GLint value;
+        glGetTextureParameteriv(_glTex, parameter, &value);
+        glSamplerParameteri(bindlessHandle.sampler, parameter, value);
+    }
+    GLfloat anisotropy;
+    glGetTextureParameterfv(_glTex, GL_TEXTURE_MAX_ANISOTROPY_EXT, &anisotropy);
+    glSamplerParameterf(bindlessHandle.sampler, GL_TEXTURE_MAX_ANISOTROPY_EXT, anisotropy);
+    glSamplerParameterf(bindlessHandle.sampler, GL_TEXTURE_MAX_LOD, static_cast<float>(_maxLevel));
+
+    bindlessHandle.handle = glGetTextureSamplerHandleARB(_glTex, bindlessHandle.sampler);
+    return _bindlessHandles.emplace(_maxLevel, bindlessHandle).first->second;
+}
+
+/*************/
+void Texture_Image::deleteBindlessHandles()
+{
+    // The handles are deleted along with the texture, only the samplers are left
+    for (auto& handle : _bindlessHandles)
+        glDeleteSamplers(1, &handle.second.sampler);
+    _bindlessHandles.clear();
+}
+
+/*************/
+void Texture_Image::waitForUpload()
+{
+    // Make sure the last upload is complete, in case it was done from another context
+    if (_uploadFence)
+    {
+        glWaitSync(_uploadFence, 0, GL_TIMEOUT_IGNORED);
+        glDeleteSync(_uploadFence);
+        _uploadFence = nullptr;
+    }
+}
+
+/*************/
+void Texture_Image::generateMipmap(int maxLevel) const
+{
+    // Outdated levels are excluded from sampling, so that minification falls back to the last generated level
+    // Once a bindless handle exists, this is done by the sampler of the handle for this limit
+    _maxLevel = maxLevel < 0 ? 1000 : maxLevel;
+    if (_bindlessHandles.empty())
+        glTextureParameteri(_glTex, GL_TEXTURE_MAX_LEVEL, _maxLevel);
+    if (maxLevel != 0)
+        glGenerateTextureMipmap(_glTex);
+}
+
+/*************/
+vector<shared_ptr<Texture>> Texture_Image::getPlanes() const
+{
+    return vector<shared_ptr<Texture>>(_chromaPlanes.begin(), _chromaPlanes.end());
 }
 
 /*************/
@@ -74,15 +180,40 @@ RgbValue Texture_Image::getMeanValue() const
     auto size = width * height * 4;
     ResizableArray<uint8_t> buffer(size);
     glGetTextureImage(_glTex, level, GL_RGBA, GL_UNSIGNED_INT_8_8_8_8_REV, buffer.size(), buffer.data());
+    return computeMeanValue(buffer.data(), width, height);
+}
+
+/*************/
+bool Texture_Image::getMeanValueAsync(RgbValue& meanValue)
+{
+    ImageBuffer image;
+    auto fetched = fetchReadback(_meanReadback, image);
+    if (fetched)
+        meanValue = computeMeanValue(image.data(), image.getSpec().width, image.getSpec().height);
+
+    int level = _texLevels - 1;
+    int width, height;
+    glGetTextureLevelParameteriv(_glTex, level, GL_TEXTURE_WIDTH, &width);
+    glGetTextureLevelParameteriv(_glTex, level, GL_TEXTURE_HEIGHT, &height);
+    queueReadback(_meanReadback, level, GL_RGBA, GL_UNSIGNED_INT_8_8_8_8_REV, ImageBufferSpec(width, height, 4, 32, ImageBufferSpec::Type::UINT8, "RGBA"));
+
+    return fetched;
+}
 
+/*************/
+RgbValue Texture_Image::computeMeanValue(const uint8_t* pixels, int width, int height)
+{
     RgbValue meanColor;
+    if (width == 0 || height == 0)
+        return meanColor;
+
     for (int y = 0; y < height; ++y)
     {
         RgbValue rowMeanColor;
         for (int x = 0; x < width; ++x)
         {
             auto index = (x + y * width) * 4;
-            RgbValue color(buffer[index], buffer[index + 1], buffer[index + 2]);
+            RgbValue color(pixels[index], pixels[index + 1], pixels[index + 2]);
             rowMeanColor += color;
         }
         rowMeanColor /= static_cast<float>(width);
@@ -118,6 +249,114 @@ ImageBuffer Texture_Image::grabMipmap(unsigned int level) const
     return image;
 }
 
+/*************/
+bool Texture_Image::grabMipmapAsync(unsigned int level, ImageBuffer& image)
+{
+    auto fetched = fetchReadback(_mipmapReadback, image);
+
+    int mipmapLevel = std::min<int>(level, _texLevels - 1);
+    GLint width, height;
+    glGetTextureLevelParameteriv(_glTex, mipmapLevel, GL_TEXTURE_WIDTH, &width);
+    glGetTextureLevelParameteriv(_glTex, mipmapLevel, GL_TEXTURE_HEIGHT, &height);
+
+    auto spec = _spec;
+    spec.width = width;
+    spec.height = height;
+    queueReadback(_mipmapReadback, mipmapLevel, _texFormat, _texType, spec);
+
+    return fetched;
+}
+
+/*************/
+bool Texture_Image::queueReadback(Readback& readback, int level, GLenum format, GLenum type, const ImageBufferSpec& spec)
+{
+    auto size = static_cast<size_t>(spec.rawSize());
+    if (size == 0)
+        return false;
+
+    if (readback.slots.empty())
+        readback.slots.resize(SPLASH_TEXTURE_READBACK_PBOS);
+
+    // All PBOs hold reads not fetched yet, the read is dropped instead of stalling
+    auto& slot = readback.slots[readback.writeIndex];
+    if (slot.fence)
+        return false;
+
+    if (!slot.pbo)
+        glCreateBuffers(1, &slot.pbo);
+    if (slot.size != size)
+    {
+        glNamedBufferData(slot.pbo, size, nullptr, GL_STREAM_READ);
+        slot.size = size;
+    }
+    slot.spec = spec;
+
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.pbo);
+    // Nvidia drivers give black images when reading a named texture to a PBO, see Sink::update
+    if (Scene::getGLVendor() == GL_VENDOR_NVIDIA)
+    {
+        glBindTexture(GL_TEXTURE_2D, _glTex);
+        glGetTexImage(GL_TEXTURE_2D, level, format, type, 0);
+        glBindTexture(GL_TEXTURE_2D, 0);
+    }
+    else
+    {
+        glGetTextureImage(_glTex, level, format, type, size, 0);
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    slot.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    readback.writeIndex = (readback.writeIndex + 1) % static_cast<int>(readback.slots.size());
+    return true;
+}
+
+/*************/
+bool Texture_Image::fetchReadback(Readback& readback, ImageBuffer& image)
+{
+    // Release all the completed reads, only the latest one is copied
+    int readyIndex = -1;
+    while (!readback.slots.empty() && readback.slots[readback.readIndex].fence)
+    {
+        auto& slot = readback.slots[readback.readIndex];
+        auto status = glClientWaitSync(slot.fence, 0, 0);
+        if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED)
+            break;
+
+        glDeleteSync(slot.fence);
+        slot.fence = nullptr;
+        readyIndex = readback.readIndex;
+        readback.readIndex = (readback.readIndex + 1) % static_cast<int>(readback.slots.size());
+    }
+
+    if (readyIndex < 0)
+        return false;
+
+    const auto& slot = readback.slots[readyIndex];
+    auto pixels = glMapNamedBufferRange(slot.pbo, 0, slot.size, GL_MAP_READ_BIT);
+    if (!pixels)
+        return false;
+
+    if (image.getSpec() != slot.spec)
+        image = ImageBuffer(slot.spec);
+    memcpy(image.data(), pixels, std::min(slot.size, image.getSize()));
+    glUnmapNamedBuffer(slot.pbo);
+    return true;
+}
+
+/*************/
+void Texture_Image::deleteReadback(Readback& readback)
+{
+    for (auto& slot : readback.slots)
+    {
+        if (slot.fence)
+            glDeleteSync(slot.fence);
+        if (slot.pbo)
+            glDeleteBuffers(1, &slot.pbo);
+    }
+    readback.slots.clear();
+    readback.writeIndex = readback.readIndex = 0;
+}
+
 /*************/
 bool Texture_Image::linkIt(const std::shared_ptr<GraphObject>& obj)
 {
@@ -139,14 +378,21 @@ void Texture_Image::unlinkIt(const shared_ptr<GraphObject>& obj)
     {
         auto img = dynamic_pointer_cast<Image>(obj);
         if (img == _img.lock())
+        {
+            lock_guard<mutex> lock(_mutex);
+            detachUploadRing();
             _img.reset();
+        }
     }
 }
 
 /*************/
 shared_ptr<Image> Texture_Image::read()
 {
-    auto img = make_shared<Image>(_root, _spec);
+    // The texture always holds the whole image, even if it was uploaded from tiles
+    auto spec = _spec;
+    spec.tileX = spec.tileY = spec.fullWidth = spec.fullHeight = 0;
+    auto img = make_shared<Image>(_root, spec);
     glGetTextureImage(_glTex, 0, _texFormat, _texType, img->getSpec().rawSize(), (GLvoid*)img->data());
     return img;
 }
@@ -193,6 +439,20 @@ void Texture_Image::reset(int width, int height, const string& pixelFormat, cons
         _texFormat = GL_RGBA;
         _texType = GL_UNSIGNED_INT_8_8_8_8_REV;
     }
+    else if (realPixelFormat == "RGB10A2")
+    {
+        _spec = ImageBufferSpec(width, height, 4, 32, ImageBufferSpec::Type::UINT8, "RGBA");
+        _texInternalFormat = GL_RGB10_A2;
+        _texFormat = GL_RGBA;
+        _texType = GL_UNSIGNED_INT_8_8_8_8_REV;
+    }
+    else if (realPixelFormat == "R11G11B10F")
+    {
+        _spec = ImageBufferSpec(width, height, 4, 32, ImageBufferSpec::Type::UINT8, "RGBA");
+        _texInternalFormat = GL_R11F_G11F_B10F;
+        _texFormat = GL_RGBA;
+        _texType = GL_UNSIGNED_INT_8_8_8_8_REV;
+    }
     else if (realPixelFormat == "RGB")
     {
         _spec = ImageBufferSpec(width, height, 3, 24, ImageBufferSpec::Type::UINT8, "RGB");
@@ -200,6 +460,27 @@ void Texture_Image::reset(int width, int height, const string& pixelFormat, cons
         _texFormat = GL_RGB;
         _texType = GL_UNSIGNED_BYTE;
     }
+    else if (realPixelFormat == "R8")
+    {
+        _spec = ImageBufferSpec(width, height, 1, 8, ImageBufferSpec::Type::UINT8, "R");
+        _texInternalFormat = GL_R8;
+        _texFormat = GL_RED;
+        _texType = GL_UNSIGNED_BYTE;
+    }
+    else if (realPixelFormat == "RG8")
+    {
+        _spec = ImageBufferSpec(width, height, 2, 16, ImageBufferSpec::Type::UINT8, "RG");
+        _texInternalFormat = GL_RG8;
+        _texFormat = GL_RG;
+        _texType = GL_UNSIGNED_BYTE;
+    }
+    else if (realPixelFormat == "RG16")
+    {
+        _spec = ImageBufferSpec(width, height, 2, 32, ImageBufferSpec::Type::UINT16, "RG");
+        _texInternalFormat = GL_RG16;
+        _texFormat = GL_RG;
+        _texType = GL_UNSIGNED_SHORT;
+    }
     else if (realPixelFormat == "R16")
     {
         _spec = ImageBufferSpec(width, height, 1, 16, ImageBufferSpec::Type::UINT16, "R");
@@ -225,6 +506,8 @@ void Texture_Image::reset(int width, int height, const string& pixelFormat, cons
     // Create and initialize the texture
     if (glIsTexture(_glTex))
         glDeleteTextures(1, &_glTex);
+    deleteBindlessHandles();
+    _maxLevel = 1000;
 
     if (_multisample > 1)
         glCreateTextures(GL_TEXTURE_2D_MULTISAMPLE, 1, &_glTex);
@@ -301,7 +584,31 @@ void Texture_Image::unbind()
 #ifdef DEBUG
     glBindTextureUnit(_activeTexture, 0);
 #endif
+    if (_samplerBound)
+    {
+        glBindSampler(_activeTexture, 0);
+        _samplerBound = false;
+    }
     _lastDrawnTimestamp = Timer::getTime();
+
+    lock_guard<mutex> lockLatency(_latencyMutex);
+    if (_uploadedTimestamp > 0)
+    {
+        _renderLatency.add(_lastDrawnTimestamp - _uploadedTimestamp);
+        _drawnTimestamp = _uploadedTimestamp;
+        _uploadedTimestamp = -1;
+    }
+}
+
+/*************/
+void Texture_Image::setFramePresented()
+{
+    lock_guard<mutex> lockLatency(_latencyMutex);
+    if (_drawnTimestamp > 0)
+    {
+        _swapLatency.add(Timer::getTime() - _drawnTimestamp);
+        _drawnTimestamp = -1;
+    }
 }
 
 /*************/
@@ -313,7 +620,7 @@ GLenum Texture_Image::getChannelOrder(const ImageBufferSpec& spec)
         glChannelOrder = GL_BGR;
     else if (spec.format == "RGB")
         glChannelOrder = GL_RGB;
-    else if (spec.format == "BGRA")
+    else if (spec.format == "BGRA" || spec.format == "RGB10A2")
         glChannelOrder = GL_BGRA;
     else if (spec.format == "RGBA")
         glChannelOrder = GL_RGBA;
@@ -333,11 +640,47 @@ GLenum Texture_Image::getChannelOrder(const ImageBufferSpec& spec)
     return glChannelOrder;
 }
 
+/*************/
+vector<Texture_Image::PlaneLayout> Texture_Image::getChromaPlanes(const ImageBufferSpec& spec)
+{
+    const size_t lumaSize = static_cast<size_t>(spec.width) * spec.height;
+
+    if (spec.format == "NV12")
+        return {{"RG8", GL_RG, GL_UNSIGNED_BYTE, lumaSize}};
+    else if (spec.format == "P010")
+        return {{"RG16", GL_RG, GL_UNSIGNED_SHORT, lumaSize * 2}};
+    else if (spec.format == "I420")
+        return {{"R8", GL_RED, GL_UNSIGNED_BYTE, lumaSize}, {"R8", GL_RED, GL_UNSIGNED_BYTE, lumaSize + lumaSize / 4}};
+
+    return {};
+}
+
+/*************/
+void Texture_Image::uploadChromaPlanes(const ImageBufferSpec& spec, const GLubyte* data)
+{
+    auto layouts = getChromaPlanes(spec);
+    if (layouts.size() != _chromaPlanes.size())
+        return;
+
+    const int planeWidth = (spec.width + 1) / 2;
+    const int planeHeight = (spec.height + 1) / 2;
+    for (size_t i = 0; i < layouts.size(); ++i)
+    {
+        // When reading from a PBO, the pointer is an offset in the buffer
+        auto planeData = data ? static_cast<const GLvoid*>(data + layouts[i].offset) : reinterpret_cast<const GLvoid*>(layouts[i].offset);
+        glTextureSubImage2D(_chromaPlanes[i]->_glTex, 0, 0, 0, planeWidth, planeHeight, layouts[i].channelOrder, layouts[i].dataType, planeData);
+    }
+}
+
 /*************/
 void Texture_Image::update()
 {
     lock_guard<mutex> lock(_mutex);
 
+    // The image must not be updated while being copied to a PBO
+    if (_pboCopy.valid())
+        _pboCopy.wait();
+
     // If _img is nullptr, this texture is not set from an Image
     if (_img.expired())
         return;
@@ -349,9 +692,24 @@ void Texture_Image::update()
     img->getAttribute("flip", flip);
     img->getAttribute("flop", flop);
 
+    // Flipping changes what is rendered from this texture, even if the image did not change
+    if (Value(flip) != Value(_shaderUniforms["flip"]) || Value(flop) != Value(_shaderUniforms["flop"]))
+        setContentUpdated();
     _shaderUniforms["flip"] = flip;
     _shaderUniforms["flop"] = flop;
 
+    // The mipmaps skipped while no consumer sampled them are generated as soon as one does
+    if (_mipmapsOutdated && _mipmapsNeeded)
+        updateMipmaps();
+
+    // Frames written to the upload ring are uploaded from there, until the image closes it
+    if (_uploadRing && !_uploadRing->isClosed())
+    {
+        uploadFromRing();
+        return;
+    }
+    detachUploadRing();
+
     if (img->getTimestamp() == _spec.timestamp)
         return;
 
@@ -385,12 +743,29 @@ void Texture_Image::update()
         isCompressed = true;
     }
 
+    // Planar YUV formats are uploaded as one texture per plane, the luma being held by this texture
+    auto chromaPlanes = getChromaPlanes(spec);
+    bool isPlanar = !chromaPlanes.empty();
+
     // Get GL parameters
     GLenum internalFormat;
     GLenum dataFormat = GL_UNSIGNED_BYTE;
-    if (!isCompressed)
+    if (isPlanar)
     {
-        if (spec.channels == 4 && spec.type == ImageBufferSpec::Type::UINT8)
+        glChannelOrder = GL_RED;
+        dataFormat = spec.type == ImageBufferSpec::Type::UINT16 ? GL_UNSIGNED_SHORT : GL_UNSIGNED_BYTE;
+        internalFormat = spec.type == ImageBufferSpec::Type::UINT16 ? GL_R16 : GL_R8;
+    }
+    else if (!isCompressed)
+    {
+        // Packed 10 bit RGB, as output for high bit depth videos. There is no sRGB variant of it,
+        // so the shader linearizes it instead
+        if (spec.format == "RGB10A2")
+        {
+            dataFormat = GL_UNSIGNED_INT_2_10_10_10_REV;
+            internalFormat = GL_RGB10_A2;
+        }
+        else if (spec.channels == 4 && spec.type == ImageBufferSpec::Type::UINT8)
         {
             dataFormat = GL_UNSIGNED_INT_8_8_8_8_REV;
             if (srgb[0].as<bool>())
@@ -411,6 +786,11 @@ void Texture_Image::update()
             dataFormat = GL_UNSIGNED_SHORT;
             internalFormat = GL_R16;
         }
+        else if (spec.channels == 1 && spec.type == ImageBufferSpec::Type::UINT8)
+        {
+            dataFormat = GL_UNSIGNED_BYTE;
+            internalFormat = GL_R8;
+        }
         else if (spec.channels == 2 && spec.type == ImageBufferSpec::Type::UINT8)
         {
             dataFormat = GL_UNSIGNED_SHORT;
@@ -449,28 +829,42 @@ void Texture_Image::update()
         }
     }
 
-    // Update the textures if the format changed
-    if (spec != _spec || !spec.videoFrame)
+    // Uploads not fitting in the budget are deferred, except for still images which are uploaded in parts over the next updates
+    // to a staged texture, the current one being sampled until the new one is complete
+    const bool uploadInParts = !spec.videoFrame && !isCompressed && !isPlanar && spec.height > 0;
+    if (_uploadBudget == 0 || (!uploadInParts && static_cast<size_t>(imageDataSize) > _uploadBudget))
+        return;
+
+    if (uploadInParts && (_stagedUpload.texture || static_cast<size_t>(imageDataSize) > _uploadBudget))
     {
+        if (!uploadStaged(img, spec, internalFormat, glChannelOrder, dataFormat))
+            return;
+    }
+    else if (spec != _spec || !spec.videoFrame || _pbos.empty())
+    {
+        // Update the textures if the format changed
+        // Tiles get a texture of their own size, shaders remapping the image coordinates to it through the tileRect uniform
+        discardStagedUpload();
+
+        const auto maxTextureSize = Scene::getGLMaxTextureSize();
+        if (maxTextureSize > 0 && (spec.width > static_cast<uint32_t>(maxTextureSize) || spec.height > static_cast<uint32_t>(maxTextureSize)))
+            Log::get() << Log::WARNING << "Texture_Image::" << __FUNCTION__ << " - Texture size " << spec.width << "x" << spec.height << " exceeds the maximum of " << maxTextureSize
+                       << ", only the parts of the image sampled by the cameras should be sent to this Scene" << Log::endl;
+
         // glTexStorage2D is immutable, so we have to delete the texture first
         glDeleteTextures(1, &_glTex);
-        glCreateTextures(GL_TEXTURE_2D, 1, &_glTex);
-
-        glTextureParameteri(_glTex, GL_TEXTURE_WRAP_S, _glTextureWrap);
-        glTextureParameteri(_glTex, GL_TEXTURE_WRAP_T, _glTextureWrap);
+        deleteBindlessHandles();
+        _maxLevel = 1000;
+        _glTex = createTexture(spec, internalFormat, isCompressed);
 
-        if (_filtering)
-        {
-            if (isCompressed)
-                glTextureParameteri(_glTex, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-            else
-                glTextureParameteri(_glTex, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-            glTextureParameteri(_glTex, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-        }
-        else
+        // Chroma planes are half the size of the luma plane
+        _chromaPlanes.clear();
+        for (const auto& layout : chromaPlanes)
         {
-            glTextureParameteri(_glTex, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-            glTextureParameteri(_glTex, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+            auto plane = make_shared<Texture_Image>(_root);
+            plane->setClampToEdge(_glTextureWrap == GL_CLAMP_TO_EDGE);
+            plane->reset((spec.width + 1) / 2, (spec.height + 1) / 2, layout.pixelFormat, nullptr);
+            _chromaPlanes.push_back(plane);
         }
 
         // Create or update the texture parameters
@@ -479,10 +873,19 @@ void Texture_Image::update()
 #ifdef DEBUG
             Log::get() << Log::DEBUGGING << "Texture_Image::" << __FUNCTION__ << " - Creating a new texture" << Log::endl;
 #endif
-            img->lockWrite();
-            glTextureStorage2D(_glTex, _texLevels, internalFormat, spec.width, spec.height);
-            glTextureSubImage2D(_glTex, 0, 0, 0, spec.width, spec.height, glChannelOrder, dataFormat, img->data());
-            img->unlockWrite();
+            // Planes rows are not necessarily aligned on 4 bytes
+            if (isPlanar)
+                glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+            auto snapshot = img->getSnapshot();
+            if (snapshot && snapshot->getSpec().rawSize() >= imageDataSize)
+            {
+                glTextureSubImage2D(_glTex, 0, 0, 0, spec.width, spec.height, glChannelOrder, dataFormat, snapshot->data());
+                if (isPlanar)
+                    uploadChromaPlanes(spec, reinterpret_cast<const GLubyte*>(snapshot->data()));
+            }
+
+            glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
         }
         else if (isCompressed)
         {
@@ -490,26 +893,32 @@ void Texture_Image::update()
             Log::get() << Log::DEBUGGING << "Texture_Image::" << __FUNCTION__ << " - Creating a new compressed texture" << Log::endl;
 #endif
 
-            img->lockWrite();
-            glTextureStorage2D(_glTex, _texLevels, internalFormat, spec.width, spec.height);
-            glCompressedTextureSubImage2D(_glTex, 0, 0, 0, spec.width, spec.height, internalFormat, imageDataSize, img->data());
-            img->unlockWrite();
+            auto snapshot = img->getSnapshot();
+            if (snapshot && snapshot->getSpec().rawSize() >= imageDataSize)
+                glCompressedTextureSubImage2D(_glTex, 0, 0, 0, spec.width, spec.height, internalFormat, imageDataSize, snapshot->data());
         }
 
-        if (!updatePbos(spec.width, spec.height, spec.pixelBytes()))
+        if (!updatePbos(imageDataSize))
             return;
 
-        // Fill one of the PBOs right now
-        auto pixels = _pbosPixels[0];
-        if (pixels != NULL)
+        // Images supporting it write their next frames straight to the PBOs
+        if (!isCompressed && !spec.isTile() && spec.videoFrame)
         {
-            img->lockWrite();
-            memcpy((void*)pixels, img->data(), imageDataSize);
-            img->unlockWrite();
+            auto ring = make_shared<UploadRing>(spec, _pbosPixels, imageDataSize);
+            if (img->setUploadRing(ring))
+            {
+                _uploadRing = ring;
+                _uploadRingChannelOrder = glChannelOrder;
+                _uploadRingDataFormat = dataFormat;
+            }
         }
 
-        // And copy it to the second PBO
-        glCopyNamedBufferSubData(_pbos[0], _pbos[1], 0, 0, imageDataSize);
+        // Otherwise fill the first PBO, which will be uploaded on next update
+        if (!_uploadRing)
+        {
+            _pboUploadIndex = 0;
+            copyToPbo(img, _pboUploadIndex, imageDataSize);
+        }
         _spec = spec;
     }
     // Update the content of the texture, i.e the image
@@ -517,28 +926,39 @@ void Texture_Image::update()
     {
         // Copy the pixels from the current PBO to the texture
         glBindBuffer(GL_PIXEL_UNPACK_BUFFER, _pbos[_pboUploadIndex]);
-        if (!isCompressed)
+        if (isPlanar)
+        {
+            glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+            glTextureSubImage2D(_glTex, 0, 0, 0, spec.width, spec.height, glChannelOrder, dataFormat, 0);
+            uploadChromaPlanes(spec, nullptr);
+            glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+        }
+        else if (!isCompressed)
             glTextureSubImage2D(_glTex, 0, 0, 0, spec.width, spec.height, glChannelOrder, dataFormat, 0);
         else
             glCompressedTextureSubImage2D(_glTex, 0, 0, 0, spec.width, spec.height, internalFormat, imageDataSize, 0);
         glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        _pboFences[_pboUploadIndex] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
 
-        _pboUploadIndex = (_pboUploadIndex + 1) % 2;
-
-        // Fill the next PBO with the image pixels
-        auto pixels = _pbosPixels[_pboUploadIndex];
-        if (pixels != nullptr)
-        {
-            img->lockWrite();
-            memcpy(pixels, img->data(), imageDataSize);
-            img->unlockWrite();
-        }
+        // Fill the next PBO with the image pixels, once the GPU is done with it
+        _pboUploadIndex = (_pboUploadIndex + 1) % static_cast<int>(_pbos.size());
+        waitForPboFence(_pboUploadIndex);
+        copyToPbo(img, _pboUploadIndex, imageDataSize);
     }
 
     _spec.timestamp = spec.timestamp;
 
+    if (spec.timestamp > 0)
+    {
+        lock_guard<mutex> lockLatency(_latencyMutex);
+        _uploadLatency.add(Timer::getTime() - spec.timestamp);
+        _uploadedTimestamp = spec.timestamp;
+    }
+
     // If needed, specify some uniforms for the shader which will use this texture
     _shaderUniforms.clear();
+    _shaderUniforms["flip"] = flip;
+    _shaderUniforms["flop"] = flop;
     if (spec.format == "YCoCg_DXT5")
         _shaderUniforms["YCoCg"] = {1};
     else
@@ -548,11 +968,152 @@ void Texture_Image::update()
         _shaderUniforms["YUV"] = {1};
     else if (spec.format == "YUYV")
         _shaderUniforms["YUV"] = {2};
+    else if (spec.format == "NV12" || spec.format == "P010")
+        _shaderUniforms["YUV"] = {3};
+    else if (spec.format == "I420")
+        _shaderUniforms["YUV"] = {4};
     else
         _shaderUniforms["YUV"] = {0};
 
-    if (_filtering && !isCompressed)
-        generateMipmap();
+    if (spec.format == "RGB10A2" && srgb[0].as<bool>())
+        _shaderUniforms["gammaEncoded"] = {1};
+    else
+        _shaderUniforms["gammaEncoded"] = {0};
+
+    // Region of the whole image held by the texture, in normalized coordinates
+    if (spec.isTile())
+        _shaderUniforms["tileRect"] = {static_cast<float>(spec.tileX) / static_cast<float>(spec.fullWidth),
+            static_cast<float>(spec.tileY) / static_cast<float>(spec.fullHeight),
+            static_cast<float>(spec.width) / static_cast<float>(spec.fullWidth),
+            static_cast<float>(spec.height) / static_cast<float>(spec.fullHeight)};
+    else
+        _shaderUniforms["tileRect"] = {0.f, 0.f, 1.f, 1.f};
+
+    if (!isCompressed)
+        updateMipmaps();
+
+    // Flush the commands so that the fence can be waited for from other contexts
+    if (_uploadFence)
+        glDeleteSync(_uploadFence);
+    _uploadFence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    glFlush();
+}
+
+/*************/
+size_t Texture_Image::getPendingUploadSize() const
+{
+    lock_guard<mutex> lock(_mutex);
+
+    auto img = _img.lock();
+    if (!img)
+        return 0;
+
+    if (_uploadRing && !_uploadRing->isClosed())
+        return _uploadRing->hasReadyFrame() ? _uploadRing->getSlotSize() : 0;
+
+    auto spec = img->getSpec();
+    if (spec.timestamp == _spec.timestamp)
+        return 0;
+
+    if (_stagedUpload.texture && _stagedUpload.spec == spec && _stagedUpload.spec.timestamp == spec.timestamp)
+        return spec.rawSize() / spec.height * (spec.height - _stagedUpload.uploadedRows);
+
+    return spec.rawSize();
+}
+
+/*************/
+bool Texture_Image::canUploadInParts() const
+{
+    auto img = _img.lock();
+    if (!img)
+        return false;
+
+    auto spec = img->getSpec();
+    const bool isCompressed = spec.format == "RGB_DXT1" || spec.format == "RGBA_DXT5" || spec.format == "YCoCg_DXT5";
+    return !spec.videoFrame && !isCompressed && getChromaPlanes(spec).empty() && spec.height > 0;
+}
+
+/*************/
+GLuint Texture_Image::createTexture(const ImageBufferSpec& spec, GLenum internalFormat, bool isCompressed) const
+{
+    GLuint texture = 0;
+    glCreateTextures(GL_TEXTURE_2D, 1, &texture);
+
+    glTextureParameteri(texture, GL_TEXTURE_WRAP_S, _glTextureWrap);
+    glTextureParameteri(texture, GL_TEXTURE_WRAP_T, _glTextureWrap);
+
+    if (_filtering)
+    {
+        if (isCompressed)
+            glTextureParameteri(texture, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        else
+            glTextureParameteri(texture, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+        glTextureParameteri(texture, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    }
+    else
+    {
+        glTextureParameteri(texture, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTextureParameteri(texture, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    }
+
+    // The two alpha bits of packed 10 bit RGB are left undefined by the decoders
+    if (spec.format == "RGB10A2")
+        glTextureParameteri(texture, GL_TEXTURE_SWIZZLE_A, GL_ONE);
+
+    glTextureStorage2D(texture, _texLevels, internalFormat, spec.width, spec.height);
+    return texture;
+}
+
+/*************/
+bool Texture_Image::uploadStaged(const shared_ptr<Image>& img, const ImageBufferSpec& spec, GLenum internalFormat, GLenum channelOrder, GLenum dataFormat)
+{
+    // A new image restarts the upload, reusing the staged texture if it has the same spec
+    if (!_stagedUpload.texture || _stagedUpload.spec != spec || _stagedUpload.spec.timestamp != spec.timestamp)
+    {
+        auto snapshot = img->getSnapshot();
+        if (!snapshot || snapshot->getSpec().rawSize() < spec.rawSize())
+            return false;
+
+        if (_stagedUpload.texture && _stagedUpload.spec != spec)
+            discardStagedUpload();
+        if (!_stagedUpload.texture)
+            _stagedUpload.texture = createTexture(spec, internalFormat, false);
+        _stagedUpload.snapshot = snapshot;
+        _stagedUpload.spec = spec;
+        _stagedUpload.uploadedRows = 0;
+    }
+
+    const size_t rowSize = spec.rawSize() / spec.height;
+    const auto rows = static_cast<uint32_t>(std::clamp<size_t>(_uploadBudget / rowSize, 1, spec.height - _stagedUpload.uploadedRows));
+    const auto pixels = _stagedUpload.snapshot->data() + rowSize * _stagedUpload.uploadedRows;
+
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glTextureSubImage2D(_stagedUpload.texture, 0, 0, _stagedUpload.uploadedRows, spec.width, rows, channelOrder, dataFormat, pixels);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    _stagedUpload.uploadedRows += rows;
+
+    if (_stagedUpload.uploadedRows < spec.height)
+    {
+        glFlush();
+        return false;
+    }
+
+    glDeleteTextures(1, &_glTex);
+    deleteBindlessHandles();
+    _maxLevel = 1000;
+    _glTex = _stagedUpload.texture;
+    _stagedUpload = {};
+    _chromaPlanes.clear();
+    _spec = spec;
+    return true;
+}
+
+/*************/
+void Texture_Image::discardStagedUpload()
+{
+    if (_stagedUpload.texture)
+        glDeleteTextures(1, &_stagedUpload.texture);
+    _stagedUpload = {};
 }
 
 /*************/
@@ -567,29 +1128,206 @@ void Texture_Image::init()
 }
 
 /*************/
-bool Texture_Image::updatePbos(int width, int height, int bytes)
+GraphObject::MemoryUsage Texture_Image::getMemoryUsage() const
 {
-    glDeleteBuffers(2, _pbos);
+    lock_guard<mutex> lock(_mutex);
 
-    auto flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
-    auto imageDataSize = width * height * bytes;
+    MemoryUsage usage;
+    if (!_glTex)
+        return usage;
 
-    glCreateBuffers(2, _pbos);
-    glNamedBufferStorage(_pbos[0], imageDataSize, 0, flags);
-    glNamedBufferStorage(_pbos[1], imageDataSize, 0, flags);
+    // The storage is allocated with all its mipmap levels, each a quarter of the previous one
+    const auto levelSize = static_cast<int64_t>(_spec.rawSize());
+    if (_multisample > 1)
+    {
+        usage.vram = levelSize * _multisample;
+    }
+    else
+    {
+        for (int level = 0; level < _texLevels; ++level)
+            usage.vram += levelSize >> (2 * level);
+    }
+
+    if (_cubemap)
+        usage.vram *= 6;
+
+    usage.vram += static_cast<int64_t>(_pbos.size() * _pboSize);
+
+    for (const auto& plane : _chromaPlanes)
+        if (plane)
+            usage.vram += plane->getMemoryUsage().vram;
+
+    return usage;
+}
 
-    _pbosPixels[0] = (GLubyte*)glMapNamedBufferRange(_pbos[0], 0, imageDataSize, flags);
-    _pbosPixels[1] = (GLubyte*)glMapNamedBufferRange(_pbos[1], 0, imageDataSize, flags);
+/*************/
+bool Texture_Image::updatePbos(int size)
+{
+    deletePbos();
+
+    auto flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+    auto pboCount = std::clamp(_pboCount, 2, SPLASH_TEXTURE_MAX_PBOS);
+
+    _pbos.resize(pboCount);
+    _pbosPixels.resize(pboCount);
+    _pboFences.resize(pboCount, nullptr);
 
-    if (!_pbosPixels[0] || !_pbosPixels[1])
+    _pboSize = size;
+    glCreateBuffers(pboCount, _pbos.data());
+    for (int i = 0; i < pboCount; ++i)
     {
-        Log::get() << Log::ERROR << "Texture_Image::" << __FUNCTION__ << " - Unable to initialize upload PBOs" << Log::endl;
-        return false;
+        glNamedBufferStorage(_pbos[i], size, 0, flags);
+        _pbosPixels[i] = (GLubyte*)glMapNamedBufferRange(_pbos[i], 0, size, flags);
+
+        if (!_pbosPixels[i])
+        {
+            Log::get() << Log::ERROR << "Texture_Image::" << __FUNCTION__ << " - Unable to initialize upload PBOs" << Log::endl;
+            deletePbos();
+            return false;
+        }
     }
 
     return true;
 }
 
+/*************/
+void Texture_Image::deletePbos()
+{
+    if (_pboCopy.valid())
+        _pboCopy.wait();
+
+    // The image must be done writing to the PBOs before they are unmapped
+    detachUploadRing();
+
+    for (auto& fence : _pboFences)
+        if (fence)
+            glDeleteSync(fence);
+
+    if (!_pbos.empty())
+        glDeleteBuffers(_pbos.size(), _pbos.data());
+
+    _pbos.clear();
+    _pbosPixels.clear();
+    _pboFences.clear();
+    _pboSize = 0;
+}
+
+/*************/
+void Texture_Image::copyToPbo(const shared_ptr<Image>& img, int index, int size)
+{
+    auto pixels = _pbosPixels[index];
+    if (!pixels)
+        return;
+
+    // The copy reads from a snapshot, so that the image can receive new frames meanwhile
+    _pboCopy = ThreadPool::get().enqueue([=]() {
+        auto snapshot = img->getSnapshot();
+        if (!snapshot || snapshot->getSpec().rawSize() < size)
+            return;
+        memcpy(pixels, snapshot->data(), size);
+    });
+}
+
+/*************/
+void Texture_Image::uploadFromRing()
+{
+    // Slots are handed back once the GPU is done reading them
+    for (auto slotIt = _uploadRingSlots.begin(); slotIt != _uploadRingSlots.end();)
+    {
+        auto& fence = _pboFences[*slotIt];
+        if (fence)
+        {
+            if (glClientWaitSync(fence, 0, 0) == GL_TIMEOUT_EXPIRED)
+            {
+                ++slotIt;
+                continue;
+            }
+            glDeleteSync(fence);
+            fence = nullptr;
+        }
+
+        _uploadRing->release(*slotIt);
+        slotIt = _uploadRingSlots.erase(slotIt);
+    }
+
+    // Frames which do not fit in the budget stay in the ring, where newer frames replace them
+    if (_uploadRing->getSlotSize() > _uploadBudget)
+        return;
+
+    int64_t timestamp = -1;
+    auto slot = _uploadRing->consume(timestamp);
+    if (slot < 0)
+        return;
+
+    const auto& spec = _uploadRing->getSpec();
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, _pbos[slot]);
+    if (!_chromaPlanes.empty())
+    {
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+        glTextureSubImage2D(_glTex, 0, 0, 0, spec.width, spec.height, _uploadRingChannelOrder, _uploadRingDataFormat, 0);
+        uploadChromaPlanes(spec, nullptr);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    }
+    else
+    {
+        glTextureSubImage2D(_glTex, 0, 0, 0, spec.width, spec.height, _uploadRingChannelOrder, _uploadRingDataFormat, 0);
+    }
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    _pboFences[slot] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    _uploadRingSlots.push_back(slot);
+
+    _spec.timestamp = timestamp;
+    {
+        lock_guard<mutex> lockLatency(_latencyMutex);
+        _uploadLatency.add(Timer::getTime() - timestamp);
+        _uploadedTimestamp = timestamp;
+    }
+
+    updateMipmaps();
+
+    if (_uploadFence)
+        glDeleteSync(_uploadFence);
+    _uploadFence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    glFlush();
+}
+
+/*************/
+void Texture_Image::detachUploadRing()
+{
+    if (!_uploadRing)
+        return;
+
+    // Fences of the slots still being read are kept, and waited for when the PBOs are used again
+    _uploadRing->close();
+    _uploadRing.reset();
+    _uploadRingSlots.clear();
+}
+
+/*************/
+void Texture_Image::waitForPboFence(int index)
+{
+    auto& fence = _pboFences[index];
+    if (!fence)
+        return;
+
+    // The fence is usually signaled already, as the PBO was last used a few frames ago
+    while (glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000) == GL_TIMEOUT_EXPIRED)
+        continue;
+
+    glDeleteSync(fence);
+    fence = nullptr;
+}
+
+/*************/
+void Texture_Image::updateMipmaps()
+{
+    if (!_filtering)
+        return;
+
+    generateMipmap(_mipmapsNeeded ? -1 : 0);
+    _mipmapsOutdated = !_mipmapsNeeded;
+}
+
 /*************/
 void Texture_Image::registerAttributes()
 {
@@ -612,6 +1350,15 @@ void Texture_Image::registerAttributes()
         {'b'});
     setAttributeDescription("clampToEdge", "If true, clamp the texture to the edge");
 
+    addAttribute("pboCount",
+        [&](const Values& args) {
+            _pboCount = std::clamp(args[0].as<int>(), 2, SPLASH_TEXTURE_MAX_PBOS);
+            return true;
+        },
+        [&]() -> Values { return {_pboCount}; },
+        {'i'});
+    setAttributeDescription("pboCount", "Number of buffers used to upload the images to the GPU, applied when the image format changes (between 2 and 8)");
+
     addAttribute("size",
         [&](const Values& args) {
             resize(args[0].as<int>(), args[1].as<int>());
@@ -622,6 +1369,18 @@ void Texture_Image::registerAttributes()
         },
         {'i', 'i'});
     setAttributeDescription("size", "Change the texture size");
+
+    addAttribute("latency",
+        [&](const Values&) { return true; },
+        [&]() -> Values {
+            lock_guard<mutex> lockLatency(_latencyMutex);
+            Values latencies;
+            for (const auto& [stage, histogram] : {make_pair("upload", &_uploadLatency), make_pair("render", &_renderLatency), make_pair("swap", &_swapLatency)})
+                latencies.push_back(Value(Values({histogram->getPercentile(50.0), histogram->getPercentile(95.0), histogram->getPercentile(99.0)}), stage));
+            return latencies;
+        });
+    setAttributeDescription("latency",
+        "Median, 95th and 99th percentiles of the latency in us between the arrival of the image frames and their upload, first draw, and buffer swap");
 }
 
 } // namespace Splash
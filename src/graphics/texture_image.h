@@ -28,7 +28,9 @@
 #include <chrono>
 #include <future>
 #include <glm/glm.hpp>
+#include <limits>
 #include <list>
+#include <map>
 #include <memory>
 
 #include "./core/constants.h"
@@ -37,6 +39,7 @@
 #include "./graphics/texture.h"
 #include "./image/image.h"
 #include "./utils/cgutils.h"
+#include "./utils/latency_histogram.h"
 
 namespace Splash
 {
@@ -49,7 +52,7 @@ class Texture_Image : public Texture
      * \param root Root object
      * \param width Width
      * \param height Height
-     * \param pixelFormat String describing the pixel format. Accepted values are RGB, RGBA, sRGBA, RGBA16, R16, YUYV, UYVY, D
+     * \param pixelFormat String describing the pixel format. Accepted values are RGB, RGBA, sRGBA, RGBA16, RGB10A2, R11G11B10F, R8, R16, RG8, RG16, YUYV, UYVY, D
      * \param data Pointer to data to use to initialize the texture
      * \param multisample Sample count for MSAA
      * \param cubemap True to request a cubemap
@@ -86,8 +89,15 @@ class Texture_Image : public Texture
 
     /**
      * \brief Generate the mipmaps for the texture
+     * \param maxLevel Last level to generate, or all levels if negative. Levels above are not sampled until generated
      */
-    void generateMipmap() const;
+    void generateMipmap(int maxLevel = -1) const;
+
+    /**
+     * Update whether the consumers of this texture sample it with mipmaps, which is used when uploading the next images
+     * This has to be called with the objects locked, see Texture::isSampledWithMipmaps
+     */
+    void updateMipmapsNeeded() { _mipmapsNeeded = isSampledWithMipmaps(); }
 
     /**
      * Computed the mean value for the image
@@ -95,12 +105,40 @@ class Texture_Image : public Texture
      */
     RgbValue getMeanValue() const;
 
+    /**
+     * Compute the mean value for the image, without waiting for the GPU
+     * The mean is read back from the last mipmap level through a PBO, and is available a frame or two later.
+     * \param meanValue Mean value, updated with the latest completed read back
+     * \return Return true if meanValue was updated
+     */
+    bool getMeanValueAsync(RgbValue& meanValue);
+
     /**
      * \brief Get the id of the gl texture
      * \return Return the texture id
      */
     GLuint getTexId() const final { return _glTex; }
 
+    /**
+     * \brief Get a bindless handle to sample the texture from, resident in the current context
+     * Once a handle exists the texture parameters can not change anymore, the mipmap levels limit set by
+     * generateMipmap is then applied through one sampler per limit. Texture should be locked first.
+     * \return Return the handle, or 0 if bindless textures are not available or the texture is multisampled or a cubemap
+     */
+    GLuint64 getBindlessHandle() final;
+
+    /**
+     * Get the memory held by the texture storage, its mipmaps, its PBOs and its chroma planes
+     * \return Return the memory usage
+     */
+    MemoryUsage getMemoryUsage() const override;
+
+    /**
+     * Get the chroma planes, for planar YUV formats. Texture should be locked first.
+     * \return Return the chroma planes
+     */
+    std::vector<std::shared_ptr<Texture>> getPlanes() const final;
+
     /**
      * \brief Get the shader parameters related to this texture. Texture should be locked first.
      * \return Return the shader uniforms
@@ -114,17 +152,32 @@ class Texture_Image : public Texture
      */
     ImageBuffer grabMipmap(unsigned int level = 0) const;
 
+    /**
+     * Grab the texture to the host memory at the given mipmap level, without waiting for the GPU
+     * A new grab is queued each call, and the latest completed one is copied to image. Grabs are dropped if all PBOs are pending.
+     * \param level Mipmap level to grab
+     * \param image Image to copy the latest completed grab to
+     * \return Return true if image was updated
+     */
+    bool grabMipmapAsync(unsigned int level, ImageBuffer& image);
+
     /**
      * \brief Read the texture and returns an Image
      * \return Return the image
      */
     std::shared_ptr<Image> read();
 
+    /**
+     * \brief Get the image this texture is set from
+     * \return Return the image, or nullptr if the texture is not set from an image
+     */
+    std::shared_ptr<Image> getImage() const { return _img.lock(); }
+
     /**
      * Set the buffer size / type / internal format
      * \param width Width
      * \param height Height
-     * \param pixelFormat String describing the pixel format. Accepted values are RGB, RGBA, sRGBA, RGBA16, R16, YUYV, UYVY, D
+     * \param pixelFormat String describing the pixel format. Accepted values are RGB, RGBA, sRGBA, RGBA16, RGB10A2, R11G11B10F, R8, R16, RG8, RG16, YUYV, UYVY, D
      * \param data Pointer to data to use to initialize the texture
      * \param multisample Sample count for MSAA
      * \param cubemap True to request a cubemap
@@ -149,6 +202,30 @@ class Texture_Image : public Texture
      */
     void update() final;
 
+    /**
+     * Get the number of bytes the next update would upload, estimated from the image spec
+     * \return Return the size in bytes, 0 if the texture is up to date
+     */
+    size_t getPendingUploadSize() const;
+
+    /**
+     * Get whether the pending upload can be spread over several updates, which is the case for uncompressed still images
+     * \return Return true if the upload can be done in parts
+     */
+    bool canUploadInParts() const;
+
+    /**
+     * Set the number of bytes the next updates may upload. Uploads which do not fit are deferred,
+     * except for the ones which can be done in parts which upload as many rows as the budget allows
+     * \param budget Budget in bytes
+     */
+    void setUploadBudget(size_t budget) { _uploadBudget = budget; }
+
+    /**
+     * \brief Signal that the buffers have been swapped, to measure the latency of the last drawn frame
+     */
+    void setFramePresented();
+
   protected:
     /**
      * \brief Try to link the given GraphObject to this object
@@ -162,19 +239,69 @@ class Texture_Image : public Texture
      */
     void unlinkIt(const std::shared_ptr<GraphObject>& obj) final;
 
+  private:
+    //! Ring of PBOs to read the texture back to, without stalling the pipeline
+    struct ReadbackSlot
+    {
+        GLuint pbo{0};
+        GLsync fence{nullptr}; //!< Set after the read to the PBO, signaled once its content is available
+        size_t size{0};        //!< Size of the PBO, in bytes
+        ImageBufferSpec spec{};
+    };
+
+    struct Readback
+    {
+        std::vector<ReadbackSlot> slots{};
+        int writeIndex{0};
+        int readIndex{0};
+    };
+
+    //! Still image uploaded in parts to a texture of its own, which replaces the current one once complete
+    struct StagedUpload
+    {
+        GLuint texture{0};
+        std::shared_ptr<const ImageBuffer> snapshot{nullptr};
+        ImageBufferSpec spec{};
+        uint32_t uploadedRows{0};
+    };
+
+    //! Bindless handle of the texture, sampled with a given mipmap levels limit
+    struct BindlessHandle
+    {
+        GLuint sampler{0};
+        GLuint64 handle{0};
+        std::vector<GLFWwindow*> residentContexts{}; //!< Handle residency is per context
+    };
+
   private:
     GLuint _glTex{0};
-    GLuint _pbos[2];
-    GLubyte* _pbosPixels[2];
+    std::vector<GLuint> _pbos{};
+    std::vector<GLubyte*> _pbosPixels{};
+    size_t _pboSize{0}; //!< Size of each PBO, in bytes
+    std::vector<GLsync> _pboFences{}; //!< Fences set after each upload from a PBO, signaled once the GPU is done reading it
+    std::future<void> _pboCopy{};     //!< Pending copy of the image to the next PBO
+    GLsync _uploadFence{nullptr};     //!< Fence set after the last upload, waited for when binding as it may come from another context
 
     int _multisample{0};
     bool _cubemap{false};
+    int _pboCount{3}; //!< Number of PBOs in the upload ring, applied when they are next created
     int _pboUploadIndex{0};
     int64_t _lastDrawnTimestamp{0};
+    size_t _uploadBudget{std::numeric_limits<size_t>::max()}; //!< Bytes the next updates may upload, set by the upload scheduler
+    StagedUpload _stagedUpload{};
+
+    Readback _mipmapReadback{}; //!< Read backs for grabMipmapAsync
+    Readback _meanReadback{};   //!< Read backs for getMeanValueAsync
+
+    std::map<int, BindlessHandle> _bindlessHandles{}; //!< Bindless handles, per mipmap levels limit
+    mutable int _maxLevel{1000};                      //!< Mipmap levels limit set by the last call to generateMipmap
+    bool _samplerBound{false};                        //!< True if a sampler of the bindless handles is bound along with the texture
 
     // Store some texture parameters
     static constexpr int _texLevels{4};
     bool _filtering{false};
+    std::atomic_bool _mipmapsNeeded{true}; //!< If false, no consumer samples the mipmaps and they are not generated
+    bool _mipmapsOutdated{false};          //!< True if the mipmaps were skipped for the current content
     GLenum _texFormat{GL_RGB}, _texType{GL_UNSIGNED_BYTE};
     std::string _pixelFormat{"RGBA"};
     GLint _texInternalFormat{GL_RGBA};
@@ -185,6 +312,32 @@ class Texture_Image : public Texture
 
     std::weak_ptr<Image> _img;
 
+    // Ring over the PBOs, to which the image writes its frames directly if it supports it
+    std::shared_ptr<UploadRing> _uploadRing{nullptr};
+    std::vector<int> _uploadRingSlots{}; //!< Slots uploaded from, handed back to the ring once their fence is signaled
+    GLenum _uploadRingChannelOrder{GL_RGBA};
+    GLenum _uploadRingDataFormat{GL_UNSIGNED_BYTE};
+
+    // Latencies of the frames from the image, measured from their arrival in the image
+    std::mutex _latencyMutex{};
+    LatencyHistogram _uploadLatency{}; //!< Arrival to upload
+    LatencyHistogram _renderLatency{}; //!< Arrival to the first draw using the frame
+    LatencyHistogram _swapLatency{};   //!< Arrival to the swap of the buffers showing the frame
+    int64_t _uploadedTimestamp{-1};    //!< Timestamp of the last uploaded frame, until drawn
+    int64_t _drawnTimestamp{-1};       //!< Timestamp of the last drawn frame, until swapped
+
+    // Chroma planes for planar YUV formats, the luma being held by _glTex
+    std::vector<std::shared_ptr<Texture_Image>> _chromaPlanes{};
+
+    //! Layout of a chroma plane inside a planar image buffer
+    struct PlaneLayout
+    {
+        std::string pixelFormat{};
+        GLenum channelOrder{GL_RED};
+        GLenum dataType{GL_UNSIGNED_BYTE};
+        size_t offset{0};
+    };
+
     // Parameters to send to the shader
     std::unordered_map<std::string, Values> _shaderUniforms;
 
@@ -193,6 +346,32 @@ class Texture_Image : public Texture
      */
     void init();
 
+    /**
+     * \brief Create a texture with its storage and sampling parameters
+     * \param spec Specification of the image held by the texture
+     * \param internalFormat Internal format
+     * \param isCompressed True if the internal format is compressed
+     * \return Return the texture id
+     */
+    GLuint createTexture(const ImageBufferSpec& spec, GLenum internalFormat, bool isCompressed) const;
+
+    /**
+     * \brief Upload part of a still image to the staged texture, as many rows as the upload budget allows
+     * The staged texture replaces the current one once all rows are uploaded.
+     * \param img Image
+     * \param spec Image specification
+     * \param internalFormat Internal format
+     * \param channelOrder Channel order
+     * \param dataFormat Data format
+     * \return Return true once the whole image has been uploaded and the staged texture is the current one
+     */
+    bool uploadStaged(const std::shared_ptr<Image>& img, const ImageBufferSpec& spec, GLenum internalFormat, GLenum channelOrder, GLenum dataFormat);
+
+    /**
+     * \brief Drop the staged upload, if any
+     */
+    void discardStagedUpload();
+
     /**
      * \brief Get GL channel order according to spec.format
      * \param spec Specification
@@ -200,14 +379,112 @@ class Texture_Image : public Texture
      */
     GLenum getChannelOrder(const ImageBufferSpec& spec);
 
+    /**
+     * \brief Get the layout of the chroma planes for planar YUV formats
+     * \param spec Specification
+     * \return Return the chroma planes layout, empty if the format is not planar
+     */
+    static std::vector<PlaneLayout> getChromaPlanes(const ImageBufferSpec& spec);
+
+    /**
+     * \brief Upload the chroma planes from the given buffer, or from the bound PBO if data is nullptr
+     * \param spec Specification of the whole image
+     * \param data Pointer to the image data, or nullptr to read from the bound PBO
+     */
+    void uploadChromaPlanes(const ImageBufferSpec& spec, const GLubyte* data);
+
     /**
      * \brief Update the pbos according to the parameters
-     * \param width Width
-     * \param height Height
-     * \param bytes Bytes per pixel
+     * \param size Size of the PBOs, in bytes
      * \return Return true if all went well
      */
-    bool updatePbos(int width, int height, int bytes);
+    bool updatePbos(int size);
+
+    /**
+     * \brief Delete the PBOs, after waiting for any pending copy
+     */
+    void deletePbos();
+
+    /**
+     * \brief Compute the mean value of a RGBA image, with 8 bits per channel
+     * \param pixels Image pixels
+     * \param width Image width
+     * \param height Image height
+     * \return Return the mean RGB value
+     */
+    static RgbValue computeMeanValue(const uint8_t* pixels, int width, int height);
+
+    /**
+     * \brief Queue a read of the given mipmap level to the next PBO of the read back ring
+     * \param readback Read back ring
+     * \param level Mipmap level to read
+     * \param format Pixel format to read to
+     * \param type Pixel type to read to
+     * \param spec Specification of the image read
+     * \return Return false if all PBOs are pending and the read was dropped
+     */
+    bool queueReadback(Readback& readback, int level, GLenum format, GLenum type, const ImageBufferSpec& spec);
+
+    /**
+     * \brief Get the latest completed read from the read back ring, without waiting
+     * \param readback Read back ring
+     * \param image Image to copy the read to
+     * \return Return true if image was updated
+     */
+    bool fetchReadback(Readback& readback, ImageBuffer& image);
+
+    /**
+     * \brief Delete the PBOs and fences of a read back ring
+     * \param readback Read back ring
+     */
+    static void deleteReadback(Readback& readback);
+
+    /**
+     * \brief Get the bindless handle for the current mipmap levels limit, creating it if needed
+     * \return Return the handle
+     */
+    BindlessHandle& getBindlessHandleForMaxLevel();
+
+    /**
+     * \brief Forget the bindless handles, after the texture they refer to has been deleted
+     */
+    void deleteBindlessHandles();
+
+    /**
+     * \brief Wait for the last upload to be complete, in case it was done from another context
+     */
+    void waitForUpload();
+
+    /**
+     * \brief Copy the image to the given PBO, asynchronously
+     * The GPU must be done reading the PBO, see waitForPboFence
+     * \param img Image to copy
+     * \param index PBO index
+     * \param size Size to copy, in bytes
+     */
+    void copyToPbo(const std::shared_ptr<Image>& img, int index, int size);
+
+    /**
+     * \brief Wait for the GPU to be done reading from the given PBO
+     * \param index PBO index
+     */
+    void waitForPboFence(int index);
+
+    /**
+     * \brief Upload the latest frame written by the image to the upload ring, if any
+     */
+    void uploadFromRing();
+
+    /**
+     * \brief Generate the mipmaps after an upload if they are sampled, otherwise only mark them as outdated
+     */
+    void updateMipmaps();
+
+    /**
+     * \brief Close the upload ring, after which the image writes its frames to its buffers again
+     * The texture mutex must be held
+     */
+    void detachUploadRing();
 
     /**
      * \brief Register new functors to modify attributes
@@ -85,6 +85,16 @@ void VirtualProbe::unlinkIt(const std::shared_ptr<GraphObject>& obj)
     Texture::unlinkIt(obj);
 }
 
+/*************/
+GraphObject::MemoryUsage VirtualProbe::getMemoryUsage() const
+{
+    MemoryUsage usage;
+    for (const auto* fbo : {_fbo.get(), _outFbo.get()})
+        if (fbo)
+            usage += fbo->getMemoryUsage();
+    return usage;
+}
+
 /*************/
 void VirtualProbe::render()
 {
@@ -115,21 +125,12 @@ void VirtualProbe::render()
         if (!obj)
             continue;
 
-        Values previousFill;
-        obj->getAttribute("fill", previousFill);
-        if (!previousFill.empty() && previousFill[0].as<string>() != "object_cubemap")
-            obj->setAttribute("fill", {"object_cubemap"});
-        else
-            previousFill.clear();
-
-        obj->activate();
+        // The cubemap shader outputs every triangle to the six faces at once, through gl_Layer
+        obj->activate("object_cubemap");
 
         obj->setViewProjectionMatrix(computeViewMatrix(), _faceProjectionMatrix);
         obj->draw();
         obj->deactivate();
-
-        if (!previousFill.empty())
-            obj->setAttribute("fill", previousFill);
     }
     _fbo->unbindDraw();
 
@@ -172,6 +173,7 @@ void VirtualProbe::setupFBO()
     _fbo->getColorTexture()->setAttribute("filtering", {false});
 
     _outFbo = make_unique<Framebuffer>(_root);
+    _outFbo->setDepthAttachment(false);
     _outFbo->setSize(_width, _height);
 
     _screen = make_unique<Object>(_root);
@@ -204,11 +206,25 @@ void VirtualProbe::setOutputSize(int width, int height)
         break;
     }
 
-    _cubemapSize = std::max(width, height);
+    _cubemapSize = std::max(1, static_cast<int>(std::max(width, height) * _renderScale));
     _fbo->setSize(_cubemapSize, _cubemapSize);
     _outFbo->setSize(_width, _height);
 }
 
+/*************/
+void VirtualProbe::setRenderScale(float scale)
+{
+    scale = std::clamp(scale, 0.1f, 1.f);
+    if (scale == _renderScale)
+        return;
+
+    _renderScale = scale;
+
+    // Force size update to match the new scale
+    _newWidth = _width;
+    _newHeight = _height;
+}
+
 /*************/
 void VirtualProbe::registerAttributes()
 {
@@ -82,6 +82,12 @@ class VirtualProbe : public Texture
      */
     ImageBufferSpec getSpec() const override { return _outFbo->getColorTexture()->getSpec(); }
 
+    /**
+     * Get the memory held by the render targets
+     * \return Return the memory usage
+     */
+    MemoryUsage getMemoryUsage() const final;
+
     /**
      * \brief Render this camera into its textures
      */
@@ -99,6 +105,12 @@ class VirtualProbe : public Texture
      */
     void setOutputSize(int width, int height);
 
+    /**
+     * \brief Set the render scale of the cubemap, used to lower its resolution when the GPU is overloaded
+     * \param scale Render scale, between 0.1 and 1
+     */
+    void setRenderScale(float scale);
+
     /**
      * \brier Bind this warp
      */
@@ -115,6 +127,12 @@ class VirtualProbe : public Texture
      */
     GLuint getTexId() const override { return _outFbo->getColorTexture()->getTexId(); }
 
+    /**
+     * \brief Get a bindless handle to sample the output from
+     * \return Return the handle, or 0 if the texture has to be bound
+     */
+    GLuint64 getBindlessHandle() override { return _outFbo->getColorTexture()->getBindlessHandle(); }
+
     /**
      * \brief Update for a VirtualProbe does nothing, it is the render() job
      */
@@ -151,6 +169,7 @@ class VirtualProbe : public Texture
     uint32_t _width{2048}, _height{2048};
     uint32_t _newWidth{0}, _newHeight{0};
     uint32_t _cubemapSize{512};
+    float _renderScale{1.f}; //!< Scale of the cubemap size, the output size is left unchanged
 
     ProjectionType _projectionType{ProjectionType::Equirectangular};
     float _sphericalFov{180.f};
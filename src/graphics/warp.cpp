@@ -4,6 +4,7 @@
 
 #include "./core/scene.h"
 #include "./graphics/texture_image.h"
+#include "./graphics/window.h"
 #include "./utils/cgutils.h"
 #include "./utils/log.h"
 #include "./utils/timer.h"
@@ -58,18 +59,80 @@ Warp::~Warp()
 /*************/
 void Warp::bind()
 {
-    _fbo->getColorTexture()->bind();
+    if (auto input = getPassthroughInput())
+        input->bind();
+    else
+        _fbo->getColorTexture()->bind();
 }
 
 /*************/
 unordered_map<string, Values> Warp::getShaderUniforms() const
 {
+    if (auto input = getPassthroughInput())
+        return input->getShaderUniforms();
+
     auto spec = _fbo->getColorTexture()->getSpec();
     unordered_map<string, Values> uniforms;
     uniforms["size"] = {static_cast<float>(_spec.width), static_cast<float>(spec.height)};
     return uniforms;
 }
 
+/*************/
+ImageBufferSpec Warp::getSpec() const
+{
+    if (auto input = getPassthroughInput())
+        return input->getSpec();
+    return _spec;
+}
+
+/*************/
+GLuint Warp::getTexId() const
+{
+    if (auto input = getPassthroughInput())
+        return input->getTexId();
+    return _fbo->getColorTexture()->getTexId();
+}
+
+/*************/
+GLuint64 Warp::getBindlessHandle()
+{
+    if (auto input = getPassthroughInput())
+        return input->getBindlessHandle();
+    return _fbo->getColorTexture()->getBindlessHandle();
+}
+
+/*************/
+int64_t Warp::getTimestamp() const
+{
+    if (auto input = getPassthroughInput())
+        return input->getTimestamp();
+    return _spec.timestamp;
+}
+
+/*************/
+uint64_t Warp::getContentVersion() const
+{
+    if (auto input = getPassthroughInput())
+        return input->getContentVersion();
+    return _fbo->getColorTexture()->getContentVersion();
+}
+
+/*************/
+shared_ptr<Texture> Warp::getInput() const
+{
+    if (auto camera = _inCamera.lock())
+        return camera->getTexture();
+    return _inTexture.lock();
+}
+
+/*************/
+shared_ptr<Texture> Warp::getPassthroughInput() const
+{
+    if (!_passthrough || _showControlPoints || _grabMipmapLevel >= 0 || !_screenMesh || !_screenMesh->isIdentity())
+        return {nullptr};
+    return getInput();
+}
+
 /*************/
 bool Warp::linkIt(const std::shared_ptr<GraphObject>& obj)
 {
@@ -97,7 +160,10 @@ bool Warp::linkIt(const std::shared_ptr<GraphObject>& obj)
 /*************/
 void Warp::unbind()
 {
-    _fbo->getColorTexture()->unbind();
+    if (auto input = getPassthroughInput())
+        input->unbind();
+    else
+        _fbo->getColorTexture()->unbind();
 }
 
 /*************/
@@ -126,35 +192,59 @@ void Warp::unlinkIt(const std::shared_ptr<GraphObject>& obj)
 /*************/
 void Warp::render()
 {
-    shared_ptr<Texture> input(nullptr);
+    auto input = getInput();
+    if (!input)
+        return;
 
-    if (!_inCamera.expired())
+    // An identity warp is skipped, its consumers directly sample the input and its output is released
+    if (getPassthroughInput())
     {
-        auto camera = _inCamera.lock();
-        input = camera->getTexture();
-    }
-    else if (!_inTexture.expired())
-    {
-        input = _inTexture.lock();
+        _fbo->release();
+        _inputsState.clear();
+        return;
     }
-    else
+
+    // Same if all the consumers draw the warp themselves, in their final composition pass
+    if (isComposited())
     {
+        _inputsState.clear();
+        _spec.timestamp = input->getTimestamp();
         return;
     }
 
+    renderOutput();
+}
+
+/*************/
+void Warp::renderOutput()
+{
+    auto input = getInput();
+    if (!input)
+        return;
+
     auto inputSpec = input->getSpec();
-    if (inputSpec != _spec)
+    if (inputSpec != _spec || _fbo->isReleased())
     {
         _spec = inputSpec;
         _fbo->setSize(inputSpec.width, inputSpec.height);
     }
 
+    // Nothing to do if neither the input nor the warp changed, except when showing the control points
+    vector<int64_t> inputsState{static_cast<int64_t>(getAttributesVersion()),
+        reinterpret_cast<int64_t>(input.get()),
+        input->getTimestamp(),
+        static_cast<int64_t>(input->getContentVersion()),
+        static_cast<int64_t>(_spec.width),
+        static_cast<int64_t>(_spec.height)};
+    if (!inputsChanged(inputsState) && !_showControlPoints)
+        return;
+
     _fbo->bindDraw();
     glEnable(GL_FRAMEBUFFER_SRGB);
     glViewport(0, 0, _spec.width, _spec.height);
 
     glClearColor(0.0, 0.0, 0.0, 0.0);
-    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    glClear(GL_COLOR_BUFFER_BIT);
 
     _screen->activate();
     _screen->draw();
@@ -196,18 +286,65 @@ void Warp::render()
     _fbo->unbindDraw();
 
     auto colorTexture = _fbo->getColorTexture();
+    colorTexture->setContentUpdated();
     colorTexture->generateMipmap();
     if (_grabMipmapLevel >= 0)
     {
-        _mipmapBuffer = colorTexture->grabMipmap(_grabMipmapLevel).getRawBuffer();
-        auto spec = colorTexture->getSpec();
-        _mipmapBufferSpec = {spec.width, spec.height, spec.channels, spec.bpp, spec.format};
+        // The grab is read back asynchronously, the buffer holds the latest completed one
+        if (ImageBuffer mipmap; colorTexture->grabMipmapAsync(_grabMipmapLevel, mipmap))
+        {
+            _mipmapBuffer = mipmap.getRawBuffer();
+            auto spec = colorTexture->getSpec();
+            _mipmapBufferSpec = {spec.width, spec.height, spec.channels, spec.bpp, spec.format};
+        }
     }
 
     colorTexture->setTimestamp(input->getTimestamp());
     _spec.timestamp = input->getTimestamp();
 }
 
+/*************/
+bool Warp::canBeComposited() const
+{
+    return !_showControlPoints && _grabMipmapLevel < 0 && getInput() != nullptr;
+}
+
+/*************/
+bool Warp::isComposited() const
+{
+    if (!canBeComposited())
+        return false;
+
+    const auto parents = getParents();
+    if (parents.empty())
+        return false;
+
+    for (const auto& parent : parents)
+    {
+        auto window = dynamic_cast<Window*>(parent);
+        if (!window || !window->isComposing())
+            return false;
+    }
+
+    return true;
+}
+
+/*************/
+bool Warp::drawComposited(const glm::vec2& gamma)
+{
+    if (!canBeComposited())
+        return false;
+
+    _screen->activate();
+    _screen->getShader()->setAttribute("uniform", {"_gamma", gamma.x, gamma.y});
+    _screen->draw();
+    // The warp shader is also used to render the warp output, which is not gamma corrected
+    _screen->getShader()->setAttribute("uniform", {"_gamma", 1.f, 2.2f});
+    _screen->deactivate();
+
+    return true;
+}
+
 /*************/
 int Warp::pickControlPoint(glm::vec2 p, glm::vec2& v)
 {
@@ -258,6 +395,7 @@ void Warp::loadDefaultModels()
 void Warp::setupFBO()
 {
     _fbo = make_unique<Framebuffer>(_root);
+    _fbo->setDepthAttachment(false);
     _fbo->setsRGB(true);
 
     // Setup the virtual screen
@@ -337,6 +475,15 @@ void Warp::registerAttributes()
         {'i', 'i'});
     setAttributeDescription("size", "Size of the rendered output");
 
+    addAttribute("passthrough",
+        [&](const Values& args) {
+            _passthrough = args[0].as<bool>();
+            return true;
+        },
+        [&]() -> Values { return {_passthrough}; },
+        {'b'});
+    setAttributeDescription("passthrough", "If true, the warp is skipped and its input is used directly as long as the control points form a regular lattice");
+
     // Show the Bezier patch describing the warp
     // Also resets the selected control point if hidden
     addAttribute("showControlLattice",
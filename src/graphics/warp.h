@@ -81,6 +81,12 @@ class Warp : public Texture
      */
     std::unordered_map<std::string, Values> getShaderUniforms() const;
 
+    /**
+     * \brief Get spec of the texture
+     * \return Return the spec
+     */
+    ImageBufferSpec getSpec() const override;
+
     /**
      * \brief Get the texture the warp is rendered to
      * \return Return the rendered texture
@@ -91,13 +97,31 @@ class Warp : public Texture
      * Get the output texture GL id
      * \return Return the id
      */
-    GLuint getTexId() const { return _fbo->getColorTexture()->getTexId(); }
+    GLuint getTexId() const;
+
+    /**
+     * Get a bindless handle to sample the output from
+     * \return Return the handle, or 0 if the texture has to be bound
+     */
+    GLuint64 getBindlessHandle() override;
 
     /**
      * Get the timestamp
      * \return Return the timestamp in us
      */
-    virtual int64_t getTimestamp() const final { return _spec.timestamp; }
+    virtual int64_t getTimestamp() const final;
+
+    /**
+     * Get the content version of the output texture
+     * \return Return the content version
+     */
+    uint64_t getContentVersion() const final;
+
+    /**
+     * Get the memory held by the render target
+     * \return Return the memory usage
+     */
+    MemoryUsage getMemoryUsage() const final { return _fbo ? _fbo->getMemoryUsage() : MemoryUsage(); }
 
     /**
      * \brief Get the coordinates of the closest vertex to the given point
@@ -114,9 +138,29 @@ class Warp : public Texture
 
     /**
      * \brief Update the warp
+     * Nothing is rendered if the warp is the identity, or if all its consumers composite it themselves
      */
     void render() final;
 
+    /**
+     * \brief Render the warp output, even if the consumers do not sample it
+     */
+    void renderOutput();
+
+    /**
+     * \brief Get whether the warp can be drawn directly by its consumers, instead of sampling its output
+     * This is not the case when the control points are shown, or when the output itself is grabbed
+     * \return Return true if the warp can be composited
+     */
+    bool canBeComposited() const;
+
+    /**
+     * \brief Draw the warped input into the bound framebuffer, for the final composition pass of a window
+     * \param gamma Gamma parameters, as used by the window shader
+     * \return Return true if the warp has been drawn
+     */
+    bool drawComposited(const glm::vec2& gamma);
+
     /**
      * \brief Update for a warp does nothing, it is the render() job
      */
@@ -144,6 +188,7 @@ class Warp : public Texture
     std::shared_ptr<Object> _screen{nullptr};
 
     // Render options
+    bool _passthrough{true}; //!< If true, an identity warp forwards its input instead of rendering it
     bool _showControlPoints{false};
     int _selectedControlPointIndex{-1};
 
@@ -152,6 +197,25 @@ class Warp : public Texture
     Value _mipmapBuffer{};
     Values _mipmapBufferSpec{};
 
+    /**
+     * \brief Get whether all the consumers of the warp composite it themselves
+     * \return Return true if the warp output is not needed
+     */
+    bool isComposited() const;
+
+    /**
+     * \brief Get the input texture
+     * \return Return the input, or nullptr if none is linked
+     */
+    std::shared_ptr<Texture> getInput() const;
+
+    /**
+     * \brief Get the input if the warp leaves it untouched and can be skipped
+     * This is the case when the patch is the identity, nothing is drawn over it, and the output itself is not needed
+     * \return Return the input to forward, or nullptr if the warp has to render
+     */
+    std::shared_ptr<Texture> getPassthroughInput() const;
+
     /**
      * \brief Init function called in constructors
      */
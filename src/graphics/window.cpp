@@ -16,6 +16,20 @@
 #include <functional>
 #include <glm/gtc/matrix_transform.hpp>
 
+// clang-format off
+#define GLFW_EXPOSE_NATIVE_X11
+#define GLFW_EXPOSE_NATIVE_GLX
+#include <GLFW/glfw3native.h>
+#include <GL/glxext.h>
+// clang-format on
+
+// Maximum difference between the sync control clock and the local clock for them to be considered as the same, in us
+#define SPLASH_WINDOW_UST_TOLERANCE 1000000
+// Maximum number of swaps waiting for their presentation to be measured
+#define SPLASH_WINDOW_MAX_PENDING_PRESENTATIONS 8
+// Capacity of the input events queues, events being dropped when they are full
+#define SPLASH_WINDOW_INPUT_QUEUE_SIZE 1024
+
 using namespace std;
 using namespace std::placeholders;
 
@@ -24,11 +38,11 @@ namespace Splash
 
 /*************/
 mutex Window::_callbackMutex;
-deque<pair<GLFWwindow*, vector<int>>> Window::_keys;
-deque<pair<GLFWwindow*, unsigned int>> Window::_chars;
-deque<pair<GLFWwindow*, vector<int>>> Window::_mouseBtn;
-pair<GLFWwindow*, vector<double>> Window::_mousePos;
-deque<pair<GLFWwindow*, vector<double>>> Window::_scroll;
+MpscRing<Window::InputEvent> Window::_keys{SPLASH_WINDOW_INPUT_QUEUE_SIZE};
+MpscRing<Window::InputEvent> Window::_chars{SPLASH_WINDOW_INPUT_QUEUE_SIZE};
+MpscRing<Window::InputEvent> Window::_mouseBtn{SPLASH_WINDOW_INPUT_QUEUE_SIZE};
+Window::InputEvent Window::_mousePos{};
+MpscRing<Window::InputEvent> Window::_scroll{SPLASH_WINDOW_INPUT_QUEUE_SIZE};
 vector<string> Window::_pathDropped;
 atomic_bool Window::_quitFlag;
 
@@ -86,84 +100,68 @@ Window::~Window()
 }
 
 /*************/
-int Window::getChars(GLFWwindow*& win, unsigned int& codepoint)
+bool Window::getChars(GLFWwindow*& win, unsigned int& codepoint)
 {
-    lock_guard<mutex> lock(_callbackMutex);
-    if (_chars.size() == 0)
-        return 0;
-
-    win = _chars.front().first;
-    codepoint = _chars.front().second;
-
-    _chars.pop_front();
+    InputEvent event;
+    if (!_chars.pop(event))
+        return false;
 
-    return _chars.size() + 1;
+    win = event.window;
+    codepoint = static_cast<unsigned int>(event.values[0]);
+    return true;
 }
 
 /*************/
-int Window::getKeys(GLFWwindow*& win, int& key, int& action, int& mods)
+bool Window::getKeys(GLFWwindow*& win, int& key, int& action, int& mods)
 {
-    lock_guard<mutex> lock(_callbackMutex);
-    if (_keys.size() == 0)
-        return 0;
-
-    win = _keys.front().first;
-    vector<int> keys = _keys.front().second;
-
-    key = keys[0];
-    action = keys[2];
-    mods = keys[3];
-
-    _keys.pop_front();
+    InputEvent event;
+    if (!_keys.pop(event))
+        return false;
 
-    return _keys.size() + 1;
+    win = event.window;
+    key = event.values[0];
+    action = event.values[2];
+    mods = event.values[3];
+    return true;
 }
 
 /*************/
-int Window::getMouseBtn(GLFWwindow*& win, int& btn, int& action, int& mods)
+bool Window::getMouseBtn(GLFWwindow*& win, int& btn, int& action, int& mods)
 {
-    lock_guard<mutex> lock(_callbackMutex);
-    if (_mouseBtn.size() == 0)
-        return 0;
-
-    win = _mouseBtn.front().first;
-    vector<int> mouse = _mouseBtn.front().second;
-
-    btn = mouse[0];
-    action = mouse[1];
-    mods = mouse[2];
-
-    _mouseBtn.pop_front();
+    InputEvent event;
+    if (!_mouseBtn.pop(event))
+        return false;
 
-    return _mouseBtn.size() + 1;
+    win = event.window;
+    btn = event.values[0];
+    action = event.values[1];
+    mods = event.values[2];
+    return true;
 }
 
 /*************/
 void Window::getMousePos(GLFWwindow*& win, int& xpos, int& ypos)
 {
     lock_guard<mutex> lock(_callbackMutex);
-    if (_mousePos.second.size() != 2)
+    if (!_mousePos.window)
         return;
 
-    win = _mousePos.first;
-    xpos = (int)_mousePos.second[0];
-    ypos = (int)_mousePos.second[1];
+    win = _mousePos.window;
+    xpos = static_cast<int>(_mousePos.offsets[0]);
+    ypos = static_cast<int>(_mousePos.offsets[1]);
 }
 
 /*************/
-int Window::getScroll(GLFWwindow*& win, double& xoffset, double& yoffset)
+bool Window::getScroll(GLFWwindow*& win, double& xoffset, double& yoffset)
 {
-    lock_guard<mutex> lock(_callbackMutex);
-    if (_scroll.size() == 0)
-        return 0;
-
-    win = _scroll.front().first;
-    xoffset = _scroll.front().second[0];
-    yoffset = _scroll.front().second[1];
-
-    _scroll.pop_front();
+    InputEvent event;
+    if (!_scroll.pop(event))
+        return false;
 
-    return _scroll.size() + 1;
+    win = event.window;
+    xoffset = event.offsets[0];
+    yoffset = event.offsets[1];
+    return true;
 }
 
 /*************/
@@ -306,38 +304,18 @@ void Window::render()
     glBlendEquation(GL_FUNC_ADD);
     glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 
-    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, _renderFbo);
-    if (_srgb)
-        glEnable(GL_FRAMEBUFFER_SRGB);
-
-    // If we are in synchronization testing mode
-    if (_swapSynchronizationTesting)
-    {
-        glClearColor(_swapSynchronizationColor[0], _swapSynchronizationColor[1], _swapSynchronizationColor[2], _swapSynchronizationColor[3]);
-        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-    }
-    // else, we draw the window normally
-    else
+    // In composition mode, the window is drawn directly in the default framebuffer when swapping
+    if (!_composition)
     {
-        glClearColor(0.0, 0.0, 0.0, 1.0);
-        glClear(GL_COLOR_BUFFER_BIT);
+        glBindFramebuffer(GL_DRAW_FRAMEBUFFER, _renderFbo);
+        if (_srgb)
+            glEnable(GL_FRAMEBUFFER_SRGB);
 
-        auto layout = _layout;
-        layout.push_front("_layout");
-        _screen->activate();
-        _screen->getShader()->setAttribute("uniform", layout);
-        _screen->getShader()->setAttribute("uniform", {"_gamma", static_cast<float>(_srgb), _gammaCorrection});
-        _screen->draw();
-        _screen->deactivate();
+        drawContent(w, h);
     }
-
-    if (_guiTexture != nullptr)
+    else if (_guiTexture != nullptr && _guiOnly)
     {
-        if (_guiOnly)
-            _gui->setAttribute("fullscreen", {true});
-        _screenGui->activate();
-        _screenGui->draw();
-        _screenGui->deactivate();
+        _gui->setAttribute("fullscreen", {true});
     }
 
     glDeleteSync(_renderFence);
@@ -347,25 +325,41 @@ void Window::render()
     // Resize the input textures accordingly to the window size.
     // This goes upstream to the cameras and gui
     // Textures are resized to the number of "frame" there are, according to the layout
-    bool resize = true;
-    for (uint32_t i = 0; i < _inTextures.size(); ++i)
+    // This is only done when the window, its layout or its inputs changed, so as not to mark the inputs as modified every frame
+    vector<int64_t> inputsState{static_cast<int64_t>(getAttributesVersion()), w, h, reinterpret_cast<int64_t>(_guiTexture.get())};
+    for (const auto& t : _inTextures)
+        inputsState.push_back(reinterpret_cast<int64_t>(t.lock().get()));
+    if (inputsChanged(inputsState) && !_viewports.empty())
     {
-        int value = _layout[i].as<int>();
-        for (uint32_t j = i + 1; j < _inTextures.size(); ++j)
-            if (_layout[j].as<int>() != value)
-                resize = false;
+        // Each input is rendered at the size of its viewport
+        for (size_t i = 0; i < _inTextures.size() && i < _viewports.size(); ++i)
+            if (auto texture = _inTextures[i].lock())
+                texture->setAttribute("size", {_viewports[i].z, _viewports[i].w});
+        if (_guiTexture != nullptr)
+            _guiTexture->setAttribute("size", {w, h});
     }
-    if (resize) // We don't do this if we are directly connected to a Texture (updated from an image)
+    else if (inputsChanged(inputsState))
     {
-        for (auto& t : _inTextures)
+        bool resize = true;
+        for (uint32_t i = 0; i < _inTextures.size(); ++i)
         {
-            if (t.expired())
-                continue;
-            t.lock()->setAttribute("size", {w, h});
+            int value = _layout[i].as<int>();
+            for (uint32_t j = i + 1; j < _inTextures.size(); ++j)
+                if (_layout[j].as<int>() != value)
+                    resize = false;
         }
+        if (resize) // We don't do this if we are directly connected to a Texture (updated from an image)
+        {
+            for (auto& t : _inTextures)
+            {
+                if (t.expired())
+                    continue;
+                t.lock()->setAttribute("size", {w, h});
+            }
+        }
+        if (_guiTexture != nullptr)
+            _guiTexture->setAttribute("size", {w, h});
     }
-    if (_guiTexture != nullptr)
-        _guiTexture->setAttribute("size", {w, h});
 
     // Update the timestamp based on the input textures
     int64_t timestamp{0};
@@ -391,6 +385,109 @@ void Window::render()
     return;
 }
 
+/*************/
+void Window::drawContent(int width, int height)
+{
+    // If we are in synchronization testing mode
+    if (_swapSynchronizationTesting)
+    {
+        glClearColor(_swapSynchronizationColor[0], _swapSynchronizationColor[1], _swapSynchronizationColor[2], _swapSynchronizationColor[3]);
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    }
+    // else, we draw the window normally
+    else
+    {
+        glClearColor(0.0, 0.0, 0.0, 1.0);
+        glClear(GL_COLOR_BUFFER_BIT);
+
+        if ((!_composition && _viewports.empty()) || !drawComposition(width, height))
+        {
+            auto layout = _layout;
+            layout.push_front("_layout");
+            _screen->activate();
+            _screen->getShader()->setAttribute("uniform", layout);
+            _screen->getShader()->setAttribute("uniform", {"_gamma", static_cast<float>(_srgb), _gammaCorrection});
+            _screen->draw();
+            _screen->deactivate();
+        }
+    }
+
+    if (_guiTexture != nullptr)
+    {
+        if (_guiOnly)
+            _gui->setAttribute("fullscreen", {true});
+        _screenGui->activate();
+        _screenGui->draw();
+        _screenGui->deactivate();
+    }
+}
+
+/*************/
+bool Window::drawComposition(int width, int height)
+{
+    vector<shared_ptr<Texture>> textures;
+    for (const auto& t : _inTextures)
+    {
+        auto texture = t.lock();
+        if (!texture)
+            return false;
+        textures.push_back(texture);
+    }
+
+    if (textures.empty())
+        return false;
+
+    // Each texture is drawn in its own part of the window, following the layout or its viewport.
+    // Warps are drawn directly from their input, other textures are sampled as is.
+    glm::vec2 gamma(static_cast<float>(_srgb), _gammaCorrection);
+    auto slotCount = static_cast<int>(textures.size());
+    for (int slot = 0; slot < slotCount; ++slot)
+    {
+        if (!_viewports.empty())
+        {
+            if (slot >= static_cast<int>(_viewports.size()))
+                break;
+
+            // Viewports are given from the top left corner of the window, as the outputs it spans are
+            const auto& viewport = _viewports[slot];
+            glViewport(viewport.x, height - viewport.y - viewport.w, viewport.z, viewport.w);
+            drawCompositedTexture(textures[slot], gamma);
+            continue;
+        }
+
+        if (slot >= static_cast<int>(_layout.size()))
+            break;
+
+        auto index = _layout[slot].as<int>();
+        if (index < 0 || index >= slotCount)
+            continue;
+
+        auto left = slot * width / slotCount;
+        auto right = (slot + 1) * width / slotCount;
+        glViewport(left, 0, right - left, height);
+        drawCompositedTexture(textures[index], gamma);
+    }
+
+    glViewport(0, 0, width, height);
+    return true;
+}
+
+/*************/
+void Window::drawCompositedTexture(const shared_ptr<Texture>& texture, const glm::vec2& gamma)
+{
+    auto warp = dynamic_pointer_cast<Warp>(texture);
+    if (warp && warp->drawComposited(gamma))
+        return;
+
+    _compositionScreen->addTexture(texture);
+    _compositionScreen->activate();
+    _compositionScreen->getShader()->setAttribute("uniform", {"_layout", 0, 1, 2, 3});
+    _compositionScreen->getShader()->setAttribute("uniform", {"_gamma", gamma.x, gamma.y});
+    _compositionScreen->draw();
+    _compositionScreen->deactivate();
+    _compositionScreen->removeTexture(texture);
+}
+
 /*************/
 void Window::setupFBOs()
 {
@@ -441,7 +538,7 @@ void Window::setupFBOs()
 }
 
 /*************/
-void Window::swapBuffers()
+void Window::swapBuffers(int64_t frameStart)
 {
     if (!_window->setAsCurrentContext())
         Log::get() << Log::WARNING << "Window::" << __FUNCTION__ << " - A previous context has not been released." << Log::endl;
@@ -459,7 +556,29 @@ void Window::swapBuffers()
         glDrawBuffer(GL_FRONT);
     }
 
-    glBlitNamedFramebuffer(_readFbo, 0, 0, 0, _windowRect[2], _windowRect[3], 0, 0, _windowRect[2], _windowRect[3], GL_COLOR_BUFFER_BIT, GL_NEAREST);
+    // Measure the presentation of the previous swaps, before issuing this one
+    bool presentationMeasured = !drawToFront && updatePresentationTiming();
+
+    if (_composition)
+    {
+        // Single pass from the inputs to the default framebuffer, replacing both the render to _renderFbo and the blit
+        glViewport(0, 0, _windowRect[2], _windowRect[3]);
+        glEnable(GL_BLEND);
+        glDisable(GL_DEPTH_TEST);
+        glBlendEquation(GL_FUNC_ADD);
+        glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+        if (_srgb)
+            glEnable(GL_FRAMEBUFFER_SRGB);
+
+        drawContent(_windowRect[2], _windowRect[3]);
+
+        glDisable(GL_FRAMEBUFFER_SRGB);
+        glDisable(GL_BLEND);
+    }
+    else
+    {
+        glBlitNamedFramebuffer(_readFbo, 0, 0, 0, _windowRect[2], _windowRect[3], 0, 0, _windowRect[2], _windowRect[3], GL_COLOR_BUFFER_BIT, GL_NEAREST);
+    }
 
     if (Scene::getHasNVSwapGroup())
         glfwSwapBuffers(_window->get());
@@ -470,11 +589,74 @@ void Window::swapBuffers()
         glDrawBuffer(GL_BACK);
 
     _frontBufferTimestamp = _backBufferTimestamp;
-    _presentationDelay = Timer::getTime() - _frontBufferTimestamp;
+    if (presentationMeasured)
+    {
+        _pendingPresentations.push_back({++_issuedSwapCount, _frontBufferTimestamp, frameStart});
+        while (_pendingPresentations.size() > SPLASH_WINDOW_MAX_PENDING_PRESENTATIONS)
+            _pendingPresentations.pop_front();
+    }
+    else
+    {
+        auto now = Timer::getTime();
+        _presentationDelay = now - _frontBufferTimestamp;
+        _renderToPresent.add(now - frameStart);
+    }
 
     _window->releaseContext();
 }
 
+/*************/
+bool Window::updatePresentationTiming()
+{
+#ifdef GLX_OML_sync_control
+    static auto getSyncValues = reinterpret_cast<PFNGLXGETSYNCVALUESOMLPROC>(glfwGetProcAddress("glXGetSyncValuesOML"));
+
+    if (_hasSyncControl == -1)
+        _hasSyncControl = (getSyncValues != nullptr && glfwExtensionSupported("GLX_OML_sync_control")) ? 1 : 0;
+    if (_hasSyncControl == 0)
+        return false;
+
+    int64_t ust = 0;
+    int64_t msc = 0;
+    int64_t sbc = 0;
+    if (!getSyncValues(glfwGetX11Display(), glfwGetGLXWindow(_window->get()), &ust, &msc, &sbc))
+        return false;
+
+    if (_lastMsc < 0)
+    {
+        _issuedSwapCount = sbc;
+    }
+    else if (msc > _lastMsc)
+    {
+        _vblankInterval = (ust - _lastUst) / (msc - _lastMsc);
+
+        // Vertical blanks which did not show a new frame, while one was expected
+        auto expectedVblanks = (sbc - _lastSbc) * std::max(1, _swapInterval);
+        if (_swapInterval > 0 && !_pendingPresentations.empty() && msc - _lastMsc > expectedVblanks)
+            _missedFrames += msc - _lastMsc - expectedVblanks;
+    }
+
+    _lastUst = ust;
+    _lastMsc = msc;
+    _lastSbc = sbc;
+
+    // The swaps completed so far were shown at the last vertical blank at the latest
+    bool sameClock = std::abs(Timer::getTime() - ust) < SPLASH_WINDOW_UST_TOLERANCE;
+    while (!_pendingPresentations.empty() && _pendingPresentations.front().swapCount <= sbc)
+    {
+        const auto& presentation = _pendingPresentations.front();
+        auto presentationTime = sameClock ? ust : Timer::getTime();
+        _presentationDelay = presentationTime - presentation.timestamp;
+        _renderToPresent.add(presentationTime - presentation.frameStart);
+        _pendingPresentations.pop_front();
+    }
+
+    return true;
+#else
+    return false;
+#endif
+}
+
 /*************/
 void Window::showCursor(bool visibility)
 {
@@ -525,41 +707,52 @@ void Window::unsetTexture(const shared_ptr<Texture>& tex)
 /*************/
 void Window::keyCallback(GLFWwindow* win, int key, int scancode, int action, int mods)
 {
-    lock_guard<mutex> lock(_callbackMutex);
-    vector<int> keys{key, scancode, action, mods};
-    _keys.push_back(pair<GLFWwindow*, vector<int>>(win, keys));
+    InputEvent event;
+    event.window = win;
+    event.values[0] = key;
+    event.values[1] = scancode;
+    event.values[2] = action;
+    event.values[3] = mods;
+    _keys.push(event);
 }
 
 /*************/
 void Window::charCallback(GLFWwindow* win, unsigned int codepoint)
 {
-    lock_guard<mutex> lock(_callbackMutex);
-    _chars.push_back(pair<GLFWwindow*, unsigned int>(win, codepoint));
+    InputEvent event;
+    event.window = win;
+    event.values[0] = static_cast<int>(codepoint);
+    _chars.push(event);
 }
 
 /*************/
 void Window::mouseBtnCallback(GLFWwindow* win, int button, int action, int mods)
 {
-    lock_guard<mutex> lock(_callbackMutex);
-    vector<int> btn{button, action, mods};
-    _mouseBtn.push_back(pair<GLFWwindow*, vector<int>>(win, btn));
+    InputEvent event;
+    event.window = win;
+    event.values[0] = button;
+    event.values[1] = action;
+    event.values[2] = mods;
+    _mouseBtn.push(event);
 }
 
 /*************/
 void Window::mousePosCallback(GLFWwindow* win, double xpos, double ypos)
 {
     lock_guard<mutex> lock(_callbackMutex);
-    vector<double> pos{xpos, ypos};
-    _mousePos.first = win;
-    _mousePos.second = move(pos);
+    _mousePos.window = win;
+    _mousePos.offsets[0] = xpos;
+    _mousePos.offsets[1] = ypos;
 }
 
 /*************/
 void Window::scrollCallback(GLFWwindow* win, double xoffset, double yoffset)
 {
-    lock_guard<mutex> lock(_callbackMutex);
-    vector<double> scroll{xoffset, yoffset};
-    _scroll.push_back(pair<GLFWwindow*, vector<double>>(win, scroll));
+    InputEvent event;
+    event.window = win;
+    event.offsets[0] = xoffset;
+    event.offsets[1] = yoffset;
+    _scroll.push(event);
 }
 
 /*************/
@@ -613,6 +806,11 @@ bool Window::setProjectionSurface()
     virtualScreen = make_shared<Geometry>(_root);
     _screenGui->addGeometry(virtualScreen);
 
+    _compositionScreen = make_shared<Object>(_root);
+    _compositionScreen->setAttribute("fill", {"window"});
+    virtualScreen = make_shared<Geometry>(_root);
+    _compositionScreen->addGeometry(virtualScreen);
+
 #ifdef DEBUG
     GLenum error = glGetError();
     if (error)
@@ -707,6 +905,16 @@ void Window::registerAttributes()
         {'b'});
     setAttributeDescription("guiOnly", "If true, only the GUI will be able to link to this window. Does not affect pre-existing links.");
 
+    addAttribute("composition",
+        [&](const Values& args) {
+            _composition = args[0].as<bool>();
+            return true;
+        },
+        [&]() -> Values { return {_composition}; },
+        {'b'});
+    setAttributeDescription("composition",
+        "If true, warps, layout and gamma are applied in a single pass drawing directly in the window, instead of going through intermediate framebuffers");
+
     addAttribute("srgb",
         [&](const Values& args) {
             _srgb = args[0].as<bool>();
@@ -744,6 +952,28 @@ void Window::registerAttributes()
         {'i'});
     setAttributeDescription("layout", "Set the placement of the various input textures");
 
+    addAttribute("viewports",
+        [&](const Values& args) {
+            if (args.size() % 4 != 0)
+                return false;
+
+            _viewports.clear();
+            for (size_t i = 0; i + 3 < args.size(); i += 4)
+                _viewports.emplace_back(args[i].as<int>(), args[i + 1].as<int>(), std::max(args[i + 2].as<int>(), 1), std::max(args[i + 3].as<int>(), 1));
+
+            return true;
+        },
+        [&]() -> Values {
+            Values viewports;
+            for (const auto& viewport : _viewports)
+                for (int i = 0; i < 4; ++i)
+                    viewports.push_back(viewport[i]);
+            return viewports;
+        });
+    setAttributeDescription("viewports",
+        "Set the rectangle of each input in the window, as x, y, width and height in pixels from the top left corner, one after the other in the linking order. "
+        "This lets a single window span all the outputs of a GPU, the layout being used if empty");
+
     addAttribute("position",
         [&](const Values& args) {
             _windowRect[0] = args[0].as<int>();
@@ -826,7 +1056,16 @@ void Window::registerAttributes()
     setAttributeDescription("textureList", "Get the list of the textures linked to the window");
 
     addAttribute("presentationDelay", [&](const Values&) { return true; }, [&]() -> Values { return {_presentationDelay}; });
-    setAttributeDescription("presentationDelay", "Delay between the update of an image and its display");
+    setAttributeDescription("presentationDelay", "Delay between the update of an image and its display, measured at the vertical blank when sync control is available");
+
+    addAttribute("vblankInterval", [&](const Values&) { return true; }, [&]() -> Values { return {_vblankInterval}; });
+    setAttributeDescription("vblankInterval", "Measured duration between two vertical blanks, in us, or 0 if sync control is not available");
+
+    addAttribute("missedFrames", [&](const Values&) { return true; }, [&]() -> Values { return {static_cast<int64_t>(_missedFrames)}; });
+    setAttributeDescription("missedFrames", "Number of vertical blanks during which a new frame was expected but not shown");
+
+    addAttribute("renderToPresent", [&](const Values&) { return true; }, [&]() -> Values { return {getRenderToPresent(50.0), getRenderToPresent(99.0)}; });
+    setAttributeDescription("renderToPresent", "Median and 99th percentile of the duration from the start of the rendering of a frame to its presentation, in us");
 }
 
 } // namespace Splash
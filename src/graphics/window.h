@@ -42,6 +42,8 @@
 #include "./graphics/object.h"
 #include "./graphics/texture.h"
 #include "./graphics/texture_image.h"
+#include "./utils/latency_histogram.h"
+#include "./utils/mpsc_ring.h"
 
 namespace Splash
 {
@@ -74,9 +76,9 @@ class Window : public GraphObject
      * \brief Get grabbed character (not necesserily a specific key)
      * \param win GLFW window which grabbed the input
      * \param codepoint Character code
-     * \return Return the number of characters in the queue before calling this method
+     * \return Return false if the queue is empty
      */
-    static int getChars(GLFWwindow*& win, unsigned int& codepoint);
+    static bool getChars(GLFWwindow*& win, unsigned int& codepoint);
 
     /**
      * \brief Get the next grabbed key in the queue
@@ -84,9 +86,9 @@ class Window : public GraphObject
      * \param key Key code
      * \param action Action grabbed (press, release)
      * \param mods Key modifier
-     * \return Return the number of actions in the queue before calling this method
+     * \return Return false if the queue is empty
      */
-    static int getKeys(GLFWwindow*& win, int& key, int& action, int& mods);
+    static bool getKeys(GLFWwindow*& win, int& key, int& action, int& mods);
 
     /**
      * \brief Get the grabbed mouse action
@@ -94,9 +96,9 @@ class Window : public GraphObject
      * \param btn Mouse button number
      * \param action Mouse action detected (press, release)
      * \param mods Key modifier
-     * \return Return the number of actions in the queue before calling this method
+     * \return Return false if the queue is empty
      */
-    static int getMouseBtn(GLFWwindow*& win, int& btn, int& action, int& mods);
+    static bool getMouseBtn(GLFWwindow*& win, int& btn, int& action, int& mods);
 
     /**
      * \brief Get the mouse position
@@ -111,9 +113,9 @@ class Window : public GraphObject
      * \param win GLFW window the mouse hovers
      * \param xoffset X offset of the wheel
      * \param yoffset Y offset of the wheel
-     * \return Return the number of actions in the queue before calling this method
+     * \return Return false if the queue is empty
      */
-    static int getScroll(GLFWwindow*& win, double& xoffset, double& yoffset);
+    static bool getScroll(GLFWwindow*& win, double& xoffset, double& yoffset);
 
     /**
      * \brief Get the list of paths dropped onto any window
@@ -170,8 +172,35 @@ class Window : public GraphObject
 
     /**
      * \brief Swap the back and front buffers
+     * \param frameStart Time at which the rendering of the frame started, in us
      */
-    void swapBuffers();
+    void swapBuffers(int64_t frameStart);
+
+    /**
+     * \brief Get whether the window is drawn in a single composition pass, see the "composition" attribute
+     * \return Return true if the composition mode is active
+     */
+    bool isComposing() const { return _composition; }
+
+    /**
+     * \brief Get the measured duration between two vertical blanks
+     * \return Return the duration in us, or 0 if it could not be measured
+     */
+    int64_t getVblankInterval() const { return _vblankInterval; }
+
+    /**
+     * \brief Get the number of vertical blanks which did not show the expected new frame
+     * \return Return the missed frame count
+     */
+    uint64_t getMissedFrames() const { return _missedFrames; }
+
+    /**
+     * \brief Get a percentile of the duration between the start of the rendering of the frames and their presentation
+     * Without sync control, the presentation is approximated by the end of the swap
+     * \param percentile Percentile, between 0 and 100
+     * \return Return the duration in us, or 0 if no frame was measured yet
+     */
+    int64_t getRenderToPresent(double percentile) const { return _renderToPresent.getPercentile(percentile); }
 
   protected:
     /**
@@ -194,6 +223,23 @@ class Window : public GraphObject
     int64_t _frontBufferTimestamp{0};
     int64_t _presentationDelay{0};
 
+    // Presentation timing, measured through GLX_OML_sync_control when available
+    int _hasSyncControl{-1};  //!< -1 if not tested yet, 0 if not available, 1 otherwise
+    int64_t _issuedSwapCount{0}; //!< Swap buffer count reached once all issued swaps are completed
+    struct PendingPresentation
+    {
+        int64_t swapCount{0};  //!< Swap buffer count reached once this frame is swapped
+        int64_t timestamp{0};  //!< Content timestamp
+        int64_t frameStart{0}; //!< Start of the rendering of the frame
+    };
+    std::deque<PendingPresentation> _pendingPresentations{}; //!< Frames swapped but not yet measured
+    int64_t _lastUst{0};
+    int64_t _lastMsc{-1};
+    int64_t _lastSbc{0};
+    std::atomic<int64_t> _vblankInterval{0}; //!< Measured duration between two vertical blanks, in us
+    std::atomic<uint64_t> _missedFrames{0};  //!< Number of vertical blanks which did not show the expected new frame
+    LatencyHistogram _renderToPresent{};     //!< Durations from the start of the rendering of the frames to their presentation
+
     int _screenId{-1};
     bool _withDecoration{true};
     int _windowRect[4];
@@ -201,8 +247,10 @@ class Window : public GraphObject
     bool _srgb{true};
     float _gammaCorrection{2.2f};
     Values _layout{0, 1, 2, 3};
+    std::vector<glm::ivec4> _viewports{}; //!< Rectangle of each input as x, y, width, height from the top left corner, the layout being used if empty
     int _swapInterval{1};
     bool _guiOnly{false};
+    bool _composition{false}; //!< If true, the inputs are drawn directly in the default framebuffer when swapping
 
     // Swap synchronization test
     bool _swapSynchronizationTesting{false};
@@ -219,19 +267,28 @@ class Window : public GraphObject
 
     std::shared_ptr<Object> _screen;
     std::shared_ptr<Object> _screenGui;
+    std::shared_ptr<Object> _compositionScreen; //!< Draws a single input in composition mode
     glm::dmat4 _viewProjectionMatrix;
     std::vector<std::weak_ptr<Texture>> _inTextures;
     std::shared_ptr<Gui> _gui{nullptr};
     std::shared_ptr<Texture> _guiTexture{nullptr}; // The gui has its own texture
 
+    // Input events, pushed from the GLFW callbacks and read by the input threads
+    struct InputEvent
+    {
+        GLFWwindow* window{nullptr};
+        int values[4]{0, 0, 0, 0};
+        double offsets[2]{0.0, 0.0};
+    };
+
     static std::mutex _callbackMutex;
-    static std::deque<std::pair<GLFWwindow*, std::vector<int>>> _keys;      // Input keys queue
-    static std::deque<std::pair<GLFWwindow*, unsigned int>> _chars;         // Input keys queue
-    static std::deque<std::pair<GLFWwindow*, std::vector<int>>> _mouseBtn;  // Input mouse buttons queue
-    static std::pair<GLFWwindow*, std::vector<double>> _mousePos;           // Input mouse position
-    static std::deque<std::pair<GLFWwindow*, std::vector<double>>> _scroll; // Input mouse scroll queue
-    static std::vector<std::string> _pathDropped;                           // Filepath drag&dropped
-    static std::atomic_bool _quitFlag;                                      // Grabs close window events
+    static MpscRing<InputEvent> _keys;            // Input keys queue
+    static MpscRing<InputEvent> _chars;           // Input characters queue
+    static MpscRing<InputEvent> _mouseBtn;        // Input mouse buttons queue
+    static InputEvent _mousePos;                  // Input mouse position, only the last one is kept
+    static MpscRing<InputEvent> _scroll;          // Input mouse scroll queue
+    static std::vector<std::string> _pathDropped; // Filepath drag&dropped
+    static std::atomic_bool _quitFlag;            // Grabs close window events
 
     /**
      * \brief Input callbacks
@@ -255,6 +312,35 @@ class Window : public GraphObject
      */
     void registerAttributes();
 
+    /**
+     * \brief Query the sync control values, and update the presentation delay of the swaps presented since the last call
+     * Must be called with the window context current
+     * \return Return true if sync control is available
+     */
+    bool updatePresentationTiming();
+
+    /**
+     * \brief Draw the inputs and the gui into the bound framebuffer
+     * \param width Width of the framebuffer
+     * \param height Height of the framebuffer
+     */
+    void drawContent(int width, int height);
+
+    /**
+     * \brief Draw each input in its part of the layout or in its viewport, warps being drawn directly from their own input
+     * \param width Width of the framebuffer
+     * \param height Height of the framebuffer
+     * \return Return false if an input is not available, in which case nothing is drawn
+     */
+    bool drawComposition(int width, int height);
+
+    /**
+     * \brief Draw a single input in the current viewport, warps being drawn directly from their own input
+     * \param texture Input texture
+     * \param gamma sRGB flag and gamma correction
+     */
+    void drawCompositedTexture(const std::shared_ptr<Texture>& texture, const glm::vec2& gamma);
+
     /**
      * \brief Set up the user events callbacks
      */
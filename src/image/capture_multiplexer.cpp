@@ -0,0 +1,259 @@
+#include "./image/capture_multiplexer.h"
+
+#include <algorithm>
+#include <limits>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+#include "./utils/log.h"
+#include "./utils/timer.h"
+
+// Maximum number of ready file descriptors handled for each wait
+#define SPLASH_CAPTURE_MAX_EVENTS 32
+
+using namespace std;
+
+namespace Splash
+{
+
+/*************/
+CaptureMultiplexer::CaptureMultiplexer()
+{
+    _epollFd = epoll_create1(EPOLL_CLOEXEC);
+    _wakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (_epollFd < 0 || _wakeFd < 0)
+    {
+        Log::get() << Log::ERROR << "CaptureMultiplexer::" << __FUNCTION__ << " - Unable to create the epoll and event file descriptors" << Log::endl;
+        return;
+    }
+
+    // The event file descriptor has id 0, which is never given to a device
+    struct epoll_event event;
+    event.events = EPOLLIN;
+    event.data.u64 = 0;
+    if (epoll_ctl(_epollFd, EPOLL_CTL_ADD, _wakeFd, &event) < 0)
+    {
+        Log::get() << Log::ERROR << "CaptureMultiplexer::" << __FUNCTION__ << " - Unable to watch the event file descriptor" << Log::endl;
+        return;
+    }
+
+    _running = true;
+    _thread = thread([this]() { run(); });
+}
+
+/*************/
+CaptureMultiplexer::~CaptureMultiplexer()
+{
+    _running = false;
+    if (_wakeFd >= 0)
+    {
+        uint64_t value = 1;
+        [[maybe_unused]] auto result = ::write(_wakeFd, &value, sizeof(value));
+    }
+
+    if (_thread.joinable())
+        _thread.join();
+
+    if (_wakeFd >= 0)
+        close(_wakeFd);
+    if (_epollFd >= 0)
+        close(_epollFd);
+}
+
+/*************/
+uint64_t CaptureMultiplexer::addDevice(Device&& device)
+{
+    if (!_running || device.fd < 0 || !device.dequeue || !device.publish)
+        return 0;
+
+    uint64_t id = 0;
+    {
+        lock_guard<mutex> lock(_mutex);
+        id = _nextId++;
+
+        struct epoll_event event;
+        event.events = EPOLLIN | EPOLLPRI;
+        event.data.u64 = id;
+        if (epoll_ctl(_epollFd, EPOLL_CTL_ADD, device.fd, &event) < 0)
+        {
+            Log::get() << Log::WARNING << "CaptureMultiplexer::" << __FUNCTION__ << " - Unable to watch file descriptor " << device.fd << Log::endl;
+            return 0;
+        }
+
+        if (!device.syncGroup.empty())
+            _syncGroups.emplace(device.syncGroup, SyncGroup());
+        _devices.emplace(id, DeviceState{std::move(device), -1});
+    }
+
+    // Wake the capture thread up, for it to start ticking the new device
+    uint64_t value = 1;
+    [[maybe_unused]] auto result = ::write(_wakeFd, &value, sizeof(value));
+
+    return id;
+}
+
+/*************/
+void CaptureMultiplexer::removeDevice(uint64_t id)
+{
+    lock_guard<mutex> lock(_mutex);
+    auto deviceIt = _devices.find(id);
+    if (deviceIt == _devices.end())
+        return;
+
+    epoll_ctl(_epollFd, EPOLL_CTL_DEL, deviceIt->second.device.fd, nullptr);
+    const auto syncGroup = deviceIt->second.device.syncGroup;
+    _devices.erase(deviceIt);
+
+    if (!syncGroup.empty() && std::none_of(_devices.begin(), _devices.end(), [&](const auto& device) { return device.second.device.syncGroup == syncGroup; }))
+        _syncGroups.erase(syncGroup);
+}
+
+/*************/
+int64_t CaptureMultiplexer::getSyncSkew(const string& syncGroup) const
+{
+    lock_guard<mutex> lock(_mutex);
+    auto groupIt = _syncGroups.find(syncGroup);
+    if (groupIt == _syncGroups.end())
+        return 0;
+    return groupIt->second.skew;
+}
+
+/*************/
+size_t CaptureMultiplexer::getDeviceCount() const
+{
+    lock_guard<mutex> lock(_mutex);
+    return _devices.size();
+}
+
+/*************/
+void CaptureMultiplexer::run()
+{
+    struct epoll_event events[SPLASH_CAPTURE_MAX_EVENTS];
+    int timeout = -1;
+
+    while (_running)
+    {
+        auto eventCount = epoll_wait(_epollFd, events, SPLASH_CAPTURE_MAX_EVENTS, timeout);
+        if (eventCount < 0 && errno != EINTR)
+        {
+            Log::get() << Log::ERROR << "CaptureMultiplexer::" << __FUNCTION__ << " - Error while waiting for the capture devices, stopping the capture" << Log::endl;
+            _running = false;
+            return;
+        }
+
+        lock_guard<mutex> lock(_mutex);
+        auto now = Timer::getTime();
+
+        for (int i = 0; i < eventCount; ++i)
+        {
+            if (events[i].data.u64 == 0)
+            {
+                uint64_t value = 0;
+                [[maybe_unused]] auto result = ::read(_wakeFd, &value, sizeof(value));
+                continue;
+            }
+            dequeueDevice(events[i].data.u64, now);
+        }
+
+        auto syncTimeout = publishSyncGroups(now);
+
+        if (now - _lastTick >= static_cast<int64_t>(SPLASH_CAPTURE_TICK_PERIOD) * 1000)
+        {
+            for (auto& [id, state] : _devices)
+                if (state.device.tick && state.device.fd >= 0)
+                    state.device.tick();
+            _lastTick = now;
+        }
+
+        // Wait for the next tick, or for the next sync group to time out. Without any device, only wait for one to be added
+        if (_devices.empty())
+        {
+            timeout = -1;
+        }
+        else
+        {
+            timeout = static_cast<int>(std::max<int64_t>(0, (_lastTick + static_cast<int64_t>(SPLASH_CAPTURE_TICK_PERIOD) * 1000 - now) / 1000));
+            if (syncTimeout >= 0)
+                timeout = std::min(timeout, syncTimeout);
+        }
+    }
+}
+
+/*************/
+void CaptureMultiplexer::dequeueDevice(uint64_t id, int64_t now)
+{
+    // The device may have been removed since epoll_wait returned
+    auto deviceIt = _devices.find(id);
+    if (deviceIt == _devices.end())
+        return;
+
+    auto& state = deviceIt->second;
+    if (!state.device.dequeue())
+    {
+        Log::get() << Log::WARNING << "CaptureMultiplexer::" << __FUNCTION__ << " - Failed to dequeue a frame from file descriptor " << state.device.fd
+                   << ", it is not watched anymore" << Log::endl;
+        epoll_ctl(_epollFd, EPOLL_CTL_DEL, state.device.fd, nullptr);
+        state.pendingTime = -1;
+        // The device is kept until removed by its owner, to honor the removeDevice contract
+        state.device.fd = -1;
+        return;
+    }
+
+    if (state.device.syncGroup.empty())
+    {
+        state.device.publish();
+        return;
+    }
+
+    state.pendingTime = now;
+    auto& group = _syncGroups[state.device.syncGroup];
+    if (group.pendingSince < 0)
+        group.pendingSince = now;
+}
+
+/*************/
+int CaptureMultiplexer::publishSyncGroups(int64_t now)
+{
+    int nextTimeout = -1;
+
+    for (auto& [name, group] : _syncGroups)
+    {
+        if (group.pendingSince < 0)
+            continue;
+
+        bool complete = true;
+        for (const auto& [id, state] : _devices)
+            if (state.device.syncGroup == name && state.device.fd >= 0 && state.pendingTime < 0)
+                complete = false;
+
+        const auto elapsed = now - group.pendingSince;
+        const auto timeoutDuration = static_cast<int64_t>(SPLASH_CAPTURE_SYNC_TIMEOUT) * 1000;
+        if (!complete && elapsed < timeoutDuration)
+        {
+            const auto remaining = static_cast<int>((timeoutDuration - elapsed + 999) / 1000);
+            nextTimeout = nextTimeout < 0 ? remaining : std::min(nextTimeout, remaining);
+            continue;
+        }
+
+        int64_t firstFrame = numeric_limits<int64_t>::max();
+        int64_t lastFrame = numeric_limits<int64_t>::min();
+        for (auto& [id, state] : _devices)
+        {
+            if (state.device.syncGroup != name || state.pendingTime < 0)
+                continue;
+            firstFrame = std::min(firstFrame, state.pendingTime);
+            lastFrame = std::max(lastFrame, state.pendingTime);
+            state.device.publish();
+            state.pendingTime = -1;
+        }
+
+        if (lastFrame >= firstFrame)
+            group.skew = lastFrame - firstFrame;
+        group.pendingSince = -1;
+    }
+
+    return nextTimeout;
+}
+
+} // namespace Splash
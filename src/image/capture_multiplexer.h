@@ -0,0 +1,159 @@
+/*
+ * Copyright (C) 2026 Emmanuel Durand
+ *
+ * This file is part of Splash.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Splash is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Splash.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * @capture_multiplexer.h
+ * The CaptureMultiplexer class, waiting for the frames of all the capture devices from a single thread
+ */
+
+#ifndef SPLASH_CAPTURE_MULTIPLEXER_H
+#define SPLASH_CAPTURE_MULTIPLEXER_H
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+
+// Time after which the frames of a sync group are published even if some devices did not deliver theirs, in ms
+#define SPLASH_CAPTURE_SYNC_TIMEOUT 40
+// Period at which the devices are ticked, whether they delivered frames or not, in ms
+#define SPLASH_CAPTURE_TICK_PERIOD 50
+
+namespace Splash
+{
+
+/*************/
+//! Single thread waiting through epoll for the frames of all the capture devices, instead of one thread per device
+//! Each device is dequeued as soon as its file descriptor is ready, into a pending frame which is then published.
+//! Devices sharing a sync group have their frames published together, once every one of them delivered a frame
+//! or once the oldest pending frame of the group waited for more than SPLASH_CAPTURE_SYNC_TIMEOUT, so that
+//! multiple inputs update at the same time. Devices without a sync group are published right after being dequeued.
+class CaptureMultiplexer
+{
+  public:
+    struct Device
+    {
+        int fd{-1};               //!< File descriptor to wait on, ready when a frame can be dequeued
+        std::string syncGroup{};  //!< Devices of the same non-empty sync group are published together
+        std::function<bool()> dequeue{}; //!< Dequeue the ready frame into the pending one, replacing it if any. Returns false on failure, in which case the device is removed
+        std::function<void()> publish{}; //!< Make the pending frame the current one
+        std::function<void()> tick{};    //!< Called every SPLASH_CAPTURE_TICK_PERIOD, optional
+    };
+
+  public:
+    /**
+     * \brief Get the process-wide multiplexer
+     * \return Return the CaptureMultiplexer singleton
+     */
+    static CaptureMultiplexer& get()
+    {
+        static auto instance = new CaptureMultiplexer();
+        return *instance;
+    }
+
+    /**
+     * \brief Constructor
+     */
+    CaptureMultiplexer();
+
+    /**
+     * \brief Destructor, stops the capture thread
+     */
+    ~CaptureMultiplexer();
+
+    CaptureMultiplexer(const CaptureMultiplexer&) = delete;
+    CaptureMultiplexer& operator=(const CaptureMultiplexer&) = delete;
+
+    /**
+     * \brief Add a device
+     * \param device Device description
+     * \return Return the device id, or 0 if the device could not be added
+     */
+    uint64_t addDevice(Device&& device);
+
+    /**
+     * \brief Remove a device. Once this returns, none of its callbacks is running nor will be called anymore
+     * This must not be called from the callbacks of the device
+     * \param id Device id, ignored if unknown
+     */
+    void removeDevice(uint64_t id);
+
+    /**
+     * \brief Get the skew between the frames of a sync group, when they were last published
+     * \param syncGroup Sync group
+     * \return Return the time between the first and the last dequeued frames, in us
+     */
+    int64_t getSyncSkew(const std::string& syncGroup) const;
+
+    /**
+     * \brief Get the number of devices
+     * \return Return the device count
+     */
+    size_t getDeviceCount() const;
+
+  private:
+    struct DeviceState
+    {
+        Device device{};
+        int64_t pendingTime{-1}; //!< Time at which the pending frame was dequeued, -1 if none is pending
+    };
+
+    struct SyncGroup
+    {
+        int64_t pendingSince{-1}; //!< Time at which the first frame of the group was dequeued since the last publication, -1 if none
+        int64_t skew{0};          //!< Skew between the frames at the last publication, in us
+    };
+
+    mutable std::mutex _mutex{}; //!< Held while calling the device callbacks
+    int _epollFd{-1};
+    int _wakeFd{-1}; //!< Event file descriptor waking the capture thread up when the devices change
+    uint64_t _nextId{1};
+    std::map<uint64_t, DeviceState> _devices{};
+    std::map<std::string, SyncGroup> _syncGroups{};
+    int64_t _lastTick{0};
+
+    std::thread _thread{};
+    std::atomic_bool _running{false};
+
+    /**
+     * \brief Capture thread function
+     */
+    void run();
+
+    /**
+     * \brief Dequeue a ready device, and publish it if not part of a sync group. _mutex has to be locked
+     * \param id Device id
+     * \param now Current time, in us
+     */
+    void dequeueDevice(uint64_t id, int64_t now);
+
+    /**
+     * \brief Publish the sync groups which are complete or which timed out. _mutex has to be locked
+     * \param now Current time, in us
+     * \return Return the time until the next group times out, in ms, or -1 if no frame is pending
+     */
+    int publishSyncGroups(int64_t now);
+};
+
+} // namespace Splash
+
+#endif // SPLASH_CAPTURE_MULTIPLEXER_H
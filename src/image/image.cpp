@@ -1,20 +1,43 @@
 #include "./image/image.h"
 
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstring>
+#include <filesystem>
 #include <fstream>
-#include <future>
+#include <functional>
+#include <iomanip>
 #include <memory>
+#include <sstream>
+#include <string_view>
+#include <utility>
 
 #define STB_IMAGE_IMPLEMENTATION
 #define STB_IMAGE_WRITE_IMPLEMENTATION
 #include <stb_image.h>
 #include <stb_image_write.h>
 
+#if HAVE_TURBOJPEG
+#include <turbojpeg.h>
+#endif
+
+#include "./utils/boot_timeline.h"
+#include "./utils/dxt_encoder.h"
 #include "./utils/log.h"
 #include "./utils/osutils.h"
+#include "./utils/scope_guard.h"
+#include "./utils/thread_pool.h"
 #include "./utils/timer.h"
 
 #define SPLASH_IMAGE_COPY_THREADS 2
 #define SPLASH_IMAGE_SERIALIZED_HEADER_SIZE 4096
+// Tiles borders are aligned on this number of pixels, to limit how often their size changes
+#define SPLASH_IMAGE_TILE_ALIGNMENT 64
+// Tiles covering more than this ratio of the image are not worth it
+#define SPLASH_IMAGE_TILE_MAX_COVERAGE 0.9f
+#define SPLASH_IMAGE_CACHE_MAGIC "SPLDXT5"
+#define SPLASH_IMAGE_CACHE_VERSION 1
 
 using namespace std;
 
@@ -27,6 +50,7 @@ Image::Image(RootObject* root)
 {
     init();
     _renderingPriority = Priority::MEDIA;
+    _cpuOnlyUpdate = true;
 }
 
 /*************/
@@ -53,6 +77,9 @@ void Image::init()
 /*************/
 Image::~Image()
 {
+    if (_compressionFuture.valid())
+        _compressionFuture.wait();
+
     lock_guard<shared_mutex> writeLock(_writeMutex);
     lock_guard<Spinlock> readlock(_readMutex);
 #ifdef DEBUG
@@ -79,6 +106,13 @@ ImageBuffer Image::get() const
     return img;
 }
 
+/*************/
+shared_ptr<const ImageBuffer> Image::getSnapshot() const
+{
+    lock_guard<Spinlock> lock(_readMutex);
+    return _image;
+}
+
 /*************/
 ImageBufferSpec Image::getSpec() const
 {
@@ -89,6 +123,30 @@ ImageBufferSpec Image::getSpec() const
         return ImageBufferSpec();
 }
 
+/*************/
+void Image::setTimestamp(int64_t timestamp)
+{
+    {
+        lock_guard<shared_mutex> lockWrite(_writeMutex);
+        if (_imageUpdated && _bufferImage)
+        {
+            _bufferImage->getSpec().timestamp = timestamp;
+            return;
+        }
+    }
+
+    // The published image is never modified, so it is replaced by a copy holding the new timestamp
+    auto snapshot = getSnapshot();
+    if (!snapshot)
+        return;
+    auto image = make_shared<ImageBuffer>(*snapshot);
+    image->getSpec().timestamp = timestamp;
+
+    lock_guard<Spinlock> lockRead(_readMutex);
+    if (_image == snapshot)
+        _image = std::move(image);
+}
+
 /*************/
 void Image::set(const ImageBuffer& img)
 {
@@ -117,20 +175,22 @@ void Image::set(unsigned int w, unsigned int h, unsigned int channels, ImageBuff
 /*************/
 shared_ptr<SerializedObject> Image::serialize() const
 {
-    lock_guard<Spinlock> lock(_readMutex);
+    // The copy is done from a snapshot, so that neither the readers nor the writers wait for it
+    auto image = getSnapshot();
 
     if (Timer::get().isDebug())
         Timer::get() << "serialize " + _name;
 
     // We first get the xml version of the specs, and pack them into the obj
-    if (!_image)
+    if (!image)
         return {};
-    string xmlSpec = _image->getSpec().to_string();
+    string xmlSpec = image->getSpec().to_string();
     int nbrChar = xmlSpec.size();
-    int imgSize = _image->getSpec().rawSize();
+    int imgSize = image->getSpec().rawSize();
     int totalSize = SPLASH_IMAGE_SERIALIZED_HEADER_SIZE + imgSize;
 
-    auto obj = make_shared<SerializedObject>(totalSize);
+    // When sent to other processes, the object lives in shared memory
+    auto obj = _root ? _root->allocateSerializedObject(totalSize) : make_shared<SerializedObject>(totalSize);
 
     auto currentObjPtr = obj->data();
     const uint8_t* ptr = reinterpret_cast<const uint8_t*>(&nbrChar);
@@ -142,16 +202,16 @@ shared_ptr<SerializedObject> Image::serialize() const
     currentObjPtr = obj->data() + SPLASH_IMAGE_SERIALIZED_HEADER_SIZE;
 
     // And then, the image
-    const char* imgPtr = reinterpret_cast<const char*>(_image->data());
+    const char* imgPtr = reinterpret_cast<const char*>(image->data());
     if (imgPtr == NULL)
         return {};
 
     {
-        vector<future<void>> threads;
         int stride = SPLASH_IMAGE_COPY_THREADS;
-        for (int i = 0; i < stride - 1; ++i)
-            threads.push_back(async(launch::async, ([=]() { copy(imgPtr + imgSize / stride * i, imgPtr + imgSize / stride * (i + 1), currentObjPtr + imgSize / stride * i); })));
-        copy(imgPtr + imgSize / stride * (stride - 1), imgPtr + imgSize, currentObjPtr + imgSize / stride * (stride - 1));
+        ThreadPool::get().runParallel(stride, [=](unsigned int i) {
+            auto end = static_cast<int>(i) == stride - 1 ? imgPtr + imgSize : imgPtr + imgSize / stride * (i + 1);
+            copy(imgPtr + imgSize / stride * i, end, currentObjPtr + imgSize / stride * i);
+        });
     }
 
     if (Timer::get().isDebug())
@@ -160,6 +220,77 @@ shared_ptr<SerializedObject> Image::serialize() const
     return obj;
 }
 
+/*************/
+shared_ptr<SerializedObject> Image::serializeRegion(float left, float top, float right, float bottom) const
+{
+    {
+        auto image = getSnapshot();
+        if (!image)
+            return {};
+
+        const auto& spec = image->getSpec();
+        const auto alignDown = [](float coord, uint32_t size) {
+            auto pixel = static_cast<uint32_t>(std::clamp(coord, 0.f, 1.f) * size);
+            return pixel - pixel % SPLASH_IMAGE_TILE_ALIGNMENT;
+        };
+        const auto alignUp = [](float coord, uint32_t size) {
+            auto pixel = static_cast<uint32_t>(ceil(std::clamp(coord, 0.f, 1.f) * size));
+            pixel += (SPLASH_IMAGE_TILE_ALIGNMENT - pixel % SPLASH_IMAGE_TILE_ALIGNMENT) % SPLASH_IMAGE_TILE_ALIGNMENT;
+            return std::min(pixel, size);
+        };
+
+        const auto tileLeft = alignDown(left, spec.width);
+        const auto tileTop = alignDown(top, spec.height);
+        const auto tileRight = std::max(alignUp(right, spec.width), tileLeft + 1);
+        const auto tileBottom = std::max(alignUp(bottom, spec.height), tileTop + 1);
+        const auto coverage = static_cast<float>(tileRight - tileLeft) * (tileBottom - tileTop) / (static_cast<float>(spec.width) * spec.height);
+
+        if (!spec.isTile() && spec.isTileable() && tileRight <= spec.width && tileBottom <= spec.height && coverage < SPLASH_IMAGE_TILE_MAX_COVERAGE)
+        {
+            auto tileSpec = spec;
+            tileSpec.width = tileRight - tileLeft;
+            tileSpec.height = tileBottom - tileTop;
+            tileSpec.tileX = tileLeft;
+            tileSpec.tileY = tileTop;
+            tileSpec.fullWidth = spec.width;
+            tileSpec.fullHeight = spec.height;
+
+            string xmlSpec = tileSpec.to_string();
+            int nbrChar = xmlSpec.size();
+            int totalSize = SPLASH_IMAGE_SERIALIZED_HEADER_SIZE + tileSpec.rawSize();
+            auto obj = _root ? _root->allocateSerializedObject(totalSize) : make_shared<SerializedObject>(totalSize);
+
+            auto currentObjPtr = obj->data();
+            const uint8_t* ptr = reinterpret_cast<const uint8_t*>(&nbrChar);
+            copy(ptr, ptr + sizeof(nbrChar), currentObjPtr);
+            currentObjPtr += sizeof(nbrChar);
+            copy(xmlSpec.c_str(), xmlSpec.c_str() + nbrChar, currentObjPtr);
+            currentObjPtr = obj->data() + SPLASH_IMAGE_SERIALIZED_HEADER_SIZE;
+
+            const auto imgPtr = image->data();
+            if (!imgPtr)
+                return {};
+
+            // Copy the part of each row covered by the tile
+            const size_t pixelSize = spec.bpp / 8;
+            const size_t rowSize = spec.width * pixelSize;
+            const size_t tileRowSize = tileSpec.width * pixelSize;
+            const auto srcPtr = imgPtr + tileTop * rowSize + tileLeft * pixelSize;
+            const int stride = SPLASH_IMAGE_COPY_THREADS;
+            const auto rows = static_cast<int>(tileSpec.height);
+            ThreadPool::get().runParallel(stride, [=](unsigned int i) {
+                auto end = static_cast<int>(i) == stride - 1 ? rows : rows / stride * (static_cast<int>(i) + 1);
+                for (int row = rows / stride * static_cast<int>(i); row < end; ++row)
+                    copy(srcPtr + row * rowSize, srcPtr + row * rowSize + tileRowSize, currentObjPtr + row * tileRowSize);
+            });
+
+            return obj;
+        }
+    }
+
+    return serialize();
+}
+
 /*************/
 bool Image::deserialize(const shared_ptr<SerializedObject>& obj)
 {
@@ -228,34 +359,48 @@ bool Image::read(const string& filename)
 /*************/
 bool Image::readFile(const string& filename)
 {
-    if (!ifstream(filename).is_open())
+    BootStep bootStep("image_load");
+    // A compression still running for the previous file would be discarded anyway
+    auto readFileIndex = ++_readFileIndex;
+    if (_compressionFuture.valid())
+        _compressionFuture.wait();
+
+    // Compressed images are cached on disk, identified by the content of their source file
+    optional<uint64_t> contentHash;
+    uint64_t fileSize = 0;
+    unique_ptr<ImageBuffer> img;
+    if (_compressTexture)
     {
-        Log::get() << Log::WARNING << "Image::" << __FUNCTION__ << " - Unable to load file " << filename << Log::endl;
-        return false;
+        contentHash = hashFile(filename, fileSize);
+        if (contentHash)
+            img = readFromCache(*contentHash, fileSize);
     }
+    const bool isCompressed = img != nullptr;
 
-    int w, h, c;
-    // We force conversion to RGBA
-    uint8_t* rawImage = stbi_load(filename.c_str(), &w, &h, &c, 4);
+    if (!img)
+        img = decode(filename);
 
-    if (!rawImage)
+    if (!img)
     {
-        Log::get() << Log::WARNING << "Image::" << __FUNCTION__ << " - Caught an error while opening image file " << filename << Log::endl;
+        Log::get() << Log::WARNING << "Image::" << __FUNCTION__ << " - Unable to load image file " << filename << ": " << stbi_failure_reason() << Log::endl;
         return false;
     }
 
-    auto spec = ImageBufferSpec(w, h, 4, 32, ImageBufferSpec::Type::UINT8, "RGBA");
-    spec.videoFrame = false;
+    img->getSpec().videoFrame = false;
 
-    auto img = ImageBuffer(spec);
-    memcpy(img.data(), rawImage, w * h * 4);
-    stbi_image_free(rawImage);
+    // The uncompressed image is shown until the compression is done
+    shared_ptr<ImageBuffer> uncompressed;
+    if (contentHash && !isCompressed)
+    {
+        if (img->getSpec().width % 4 == 0 && img->getSpec().height % 4 == 0)
+            uncompressed = make_shared<ImageBuffer>(*img);
+        else
+            Log::get() << Log::WARNING << "Image::" << __FUNCTION__ << " - Size of image " << filename << " is not a multiple of 4, it is kept uncompressed" << Log::endl;
+    }
 
     {
         lock_guard<Spinlock> lock(_readMutex);
-        if (!_bufferImage)
-            _bufferImage = make_unique<ImageBuffer>();
-        std::swap(*_bufferImage, img);
+        _bufferImage = std::move(img);
         _imageUpdated = true;
     }
 
@@ -263,17 +408,251 @@ bool Image::readFile(const string& filename)
     if (!_isConnectedToRemote)
         update();
 
+    if (uncompressed)
+    {
+        _compressionFuture = async(launch::async, [=]() {
+            auto compressed = compress(*uncompressed);
+            writeToCache(*contentHash, fileSize, *compressed);
+
+            // Swapped in from the main loop, unless another file has been read meanwhile
+            auto sharedCompressed = shared_ptr<ImageBuffer>(std::move(compressed));
+            addTask([=]() {
+                if (readFileIndex != _readFileIndex)
+                    return;
+
+                {
+                    lock_guard<Spinlock> lock(_readMutex);
+                    _bufferImage = make_unique<ImageBuffer>(std::move(*sharedCompressed));
+                    _bufferImage->getSpec().videoFrame = false;
+                    _imageUpdated = true;
+                }
+
+                updateTimestamp();
+                if (!_isConnectedToRemote)
+                    update();
+            });
+        });
+    }
+
     return true;
 }
 
+/*************/
+optional<uint64_t> Image::hashFile(const string& filename, uint64_t& fileSize)
+{
+    ifstream file(filename, ios::binary | ios::ate);
+    if (!file.is_open())
+        return {};
+
+    string content(static_cast<size_t>(file.tellg()), '\0');
+    file.seekg(0);
+    file.read(content.data(), content.size());
+    if (!file)
+        return {};
+
+    fileSize = content.size();
+    return hash<string_view>()(string_view(content));
+}
+
+/*************/
+string Image::getCacheFilePath(uint64_t contentHash)
+{
+    stringstream path;
+    path << Utils::getCachePath() << "/textures/" << hex << setw(16) << setfill('0') << contentHash << ".splashdxt";
+    return path.str();
+}
+
+/*************/
+unique_ptr<ImageBuffer> Image::readFromCache(uint64_t contentHash, uint64_t fileSize)
+{
+    ifstream file(getCacheFilePath(contentHash), ios::in | ios::binary);
+    if (!file)
+        return {nullptr};
+
+    char magic[sizeof(SPLASH_IMAGE_CACHE_MAGIC)];
+    uint32_t version = 0;
+    uint64_t cachedFileSize = 0;
+    uint32_t width = 0;
+    uint32_t height = 0;
+    file.read(magic, sizeof(magic));
+    file.read(reinterpret_cast<char*>(&version), sizeof(version));
+    file.read(reinterpret_cast<char*>(&cachedFileSize), sizeof(cachedFileSize));
+    file.read(reinterpret_cast<char*>(&width), sizeof(width));
+    file.read(reinterpret_cast<char*>(&height), sizeof(height));
+    if (!file || memcmp(magic, SPLASH_IMAGE_CACHE_MAGIC, sizeof(magic)) != 0 || version != SPLASH_IMAGE_CACHE_VERSION || cachedFileSize != fileSize)
+        return {nullptr};
+
+    if (width == 0 || height == 0 || width % 4 != 0 || height % 4 != 0 || width > 65536 || height > 65536)
+        return {nullptr};
+
+    // DXT5 images hold one byte per pixel, this is how Texture_Image expects them
+    auto img = make_unique<ImageBuffer>(ImageBufferSpec(width, height, 1, 8, ImageBufferSpec::Type::UINT8, "RGBA_DXT5"));
+    file.read(reinterpret_cast<char*>(img->data()), img->getSpec().rawSize());
+    if (!file)
+        return {nullptr};
+
+    return img;
+}
+
+/*************/
+void Image::writeToCache(uint64_t contentHash, uint64_t fileSize, const ImageBuffer& img)
+{
+    Utils::writeCacheFile(getCacheFilePath(contentHash), SPLASH_IMAGE_CACHE_MAGIC, SPLASH_IMAGE_CACHE_VERSION, [&](ofstream& file) {
+        const auto& spec = img.getSpec();
+        uint32_t width = spec.width;
+        uint32_t height = spec.height;
+
+        file.write(reinterpret_cast<const char*>(&fileSize), sizeof(fileSize));
+        file.write(reinterpret_cast<const char*>(&width), sizeof(width));
+        file.write(reinterpret_cast<const char*>(&height), sizeof(height));
+        file.write(reinterpret_cast<const char*>(img.data()), spec.rawSize());
+    });
+}
+
+/*************/
+unique_ptr<ImageBuffer> Image::compress(const ImageBuffer& img)
+{
+    const auto& spec = img.getSpec();
+    auto compressed = make_unique<ImageBuffer>(ImageBufferSpec(spec.width, spec.height, 1, 8, ImageBufferSpec::Type::UINT8, "RGBA_DXT5"));
+
+    const auto pixels = img.data();
+    const auto blocks = compressed->data();
+    const auto blockRows = spec.height / 4;
+    const auto threadCount = ThreadPool::get().getThreadCount();
+    ThreadPool::get().runParallel(threadCount, [=](unsigned int i) {
+        for (auto row = i; row < blockRows; row += threadCount)
+            DxtEncoder::compressBlockRow(pixels, spec.width, spec.height, row, blocks);
+    });
+
+    return compressed;
+}
+
+/*************/
+unique_ptr<ImageBuffer> Image::decode(const string& filename)
+{
+    // JPEG files are decoded with libjpeg-turbo if available, the other ones with stb_image
+    unique_ptr<ImageBuffer> img;
+#if HAVE_TURBOJPEG
+    img = decodeJpegFile(filename);
+#endif
+    if (!img)
+        img = decodeFile(filename);
+    return img;
+}
+
+/*************/
+unique_ptr<ImageBuffer> Image::decode(const uint8_t* data, size_t size)
+{
+    if (!data || size == 0)
+        return {nullptr};
+
+    unique_ptr<ImageBuffer> img;
+#if HAVE_TURBOJPEG
+    if (size >= 3 && data[0] == 0xFF && data[1] == 0xD8 && data[2] == 0xFF)
+        img = decodeJpeg(data, size);
+#endif
+    if (img)
+        return img;
+
+    int w, h, c;
+    uint8_t* rawImage = stbi_load_from_memory(data, static_cast<int>(size), &w, &h, &c, 4);
+    if (!rawImage)
+        return {nullptr};
+
+    auto spec = ImageBufferSpec(w, h, 4, 32, ImageBufferSpec::Type::UINT8, "RGBA");
+    auto pixels = ResizableArray<uint8_t>(rawImage, spec.rawSize(), [](uint8_t* pixelData) { stbi_image_free(pixelData); });
+    return make_unique<ImageBuffer>(spec, std::move(pixels));
+}
+
+#if HAVE_TURBOJPEG
+/*************/
+unique_ptr<ImageBuffer> Image::decodeJpegFile(const string& filename)
+{
+    ifstream file(filename, ios::binary | ios::ate);
+    if (!file.is_open())
+        return {nullptr};
+
+    auto fileSize = static_cast<size_t>(file.tellg());
+    if (fileSize < 3)
+        return {nullptr};
+
+    // Check the start of image marker before reading the whole file
+    vector<unsigned char> jpeg(fileSize);
+    file.seekg(0);
+    file.read(reinterpret_cast<char*>(jpeg.data()), 3);
+    if (jpeg[0] != 0xFF || jpeg[1] != 0xD8 || jpeg[2] != 0xFF)
+        return {nullptr};
+    file.read(reinterpret_cast<char*>(jpeg.data()) + 3, fileSize - 3);
+    if (!file)
+        return {nullptr};
+
+    return decodeJpeg(jpeg.data(), jpeg.size());
+}
+
+/*************/
+unique_ptr<ImageBuffer> Image::decodeJpeg(const uint8_t* data, size_t size)
+{
+    auto decompressor = tjInitDecompress();
+    if (!decompressor)
+        return {nullptr};
+    OnScopeExit { tjDestroy(decompressor); };
+
+    int width, height, subsampling, colorspace;
+    if (tjDecompressHeader3(decompressor, data, size, &width, &height, &subsampling, &colorspace) != 0)
+        return {nullptr};
+
+    // RGBA is the only 8 bits layout uploaded to the GPU without any conversion
+    auto img = make_unique<ImageBuffer>(ImageBufferSpec(width, height, 4, 32, ImageBufferSpec::Type::UINT8, "RGBA"));
+    if (tjDecompress2(decompressor, data, size, img->data(), width, 0, height, TJPF_RGBA, 0) != 0)
+    {
+        Log::get() << Log::WARNING << "Image::" << __FUNCTION__ << " - Error while decoding JPEG data: " << string(tjGetErrorStr2(decompressor)) << Log::endl;
+        return {nullptr};
+    }
+
+    return img;
+}
+#endif
+
+/*************/
+unique_ptr<ImageBuffer> Image::decodeFile(const string& filename)
+{
+    int w, h, c;
+    // We force conversion to RGBA, the only 8 bits layout uploaded to the GPU without any conversion
+    uint8_t* rawImage = stbi_load(filename.c_str(), &w, &h, &c, 4);
+    if (!rawImage)
+        return {nullptr};
+
+    auto spec = ImageBufferSpec(w, h, 4, 32, ImageBufferSpec::Type::UINT8, "RGBA");
+    auto pixels = ResizableArray<uint8_t>(rawImage, spec.rawSize(), [](uint8_t* data) { stbi_image_free(data); });
+    return make_unique<ImageBuffer>(spec, std::move(pixels));
+}
+
 /*************/
 void Image::zero()
 {
-    lock_guard<Spinlock> lock(_readMutex);
-    if (!_image)
+    auto image = getSnapshot();
+    if (!image)
         return;
 
-    _image->zero();
+    // The published buffer may be held by readers, it is replaced instead of being modified
+    auto zeroed = make_shared<ImageBuffer>(image->getSpec());
+    zeroed->zero();
+
+    lock_guard<Spinlock> lock(_readMutex);
+    _image = std::move(zeroed);
+}
+
+/*************/
+GraphObject::MemoryUsage Image::getMemoryUsage() const
+{
+    lock_guard<Spinlock> lockRead(_readMutex);
+    shared_lock<shared_mutex> lockWrite(_writeMutex);
+
+    MemoryUsage usage;
+    for (const auto buffer : std::initializer_list<const ImageBuffer*>{_image.get(), _bufferImage.get(), &_bufferDeserialize})
+        if (buffer)
+            usage.ram += static_cast<int64_t>(buffer->getRawBuffer().size());
+    return usage;
 }
 
 /*************/
@@ -283,7 +662,19 @@ void Image::update()
     {
         lock_guard<Spinlock> lockRead(_readMutex);
         shared_lock<shared_mutex> lockWrite(_writeMutex);
-        _image.swap(_bufferImage);
+        if (_bufferImage)
+        {
+            auto previousImage = std::exchange(_image, shared_ptr<ImageBuffer>(std::move(_bufferImage)));
+
+            // The previous image is recycled as the back buffer, unless a reader still holds a snapshot of it.
+            // New snapshots can only be taken with the read lock held, so the use count can not grow meanwhile.
+            // The use count is read relaxed, so the fence orders the last reader accesses before the buffer is reused.
+            if (previousImage && previousImage.use_count() == 1)
+            {
+                std::atomic_thread_fence(std::memory_order_acquire);
+                _bufferImage = make_unique<ImageBuffer>(std::move(*previousImage));
+            }
+        }
         _imageUpdated = false;
 
         if (_remoteType.empty() || _type == _remoteType)
@@ -360,35 +751,31 @@ void Image::createDefaultImage()
     img.zero();
 
     lock_guard<Spinlock> lock(_readMutex);
-    if (!_image)
-        _image = make_unique<ImageBuffer>();
-    std::swap(*_image, img);
+    _image = make_shared<ImageBuffer>(std::move(img));
     updateTimestamp();
 }
 
 /*************/
-void Image::createPattern()
+void Image::createPattern(int width, int height)
 {
-    ImageBufferSpec spec(512, 512, 4, 8 * 4, ImageBufferSpec::Type::UINT8);
+    ImageBufferSpec spec(width, height, 4, 8 * 4, ImageBufferSpec::Type::UINT8);
     ImageBuffer img(spec);
 
     uint8_t* p = reinterpret_cast<uint8_t*>(img.data());
 
-    for (int y = 0; y < 512; ++y)
-        for (int x = 0; x < 512; ++x)
+    for (int y = 0; y < height; ++y)
+        for (int x = 0; x < width; ++x)
         {
             if (x % 16 > 7 && y % 64 > 31)
                 for (int c = 0; c < 4; ++c)
-                    p[(x + y * 512) * 4 + c] = 255;
+                    p[(x + y * width) * 4 + c] = 255;
             else
                 for (int c = 0; c < 4; ++c)
-                    p[(x + y * 512) * 4 + c] = 0;
+                    p[(x + y * width) * 4 + c] = 0;
         }
 
     lock_guard<Spinlock> lock(_readMutex);
-    if (!_image)
-        _image = make_unique<ImageBuffer>();
-    std::swap(*_image, img);
+    _image = make_shared<ImageBuffer>(std::move(img));
     updateTimestamp();
 }
 
@@ -426,6 +813,17 @@ void Image::registerAttributes()
         {'s'});
     setAttributeDescription("file", "Image file to load");
 
+    addAttribute("compress",
+        [&](const Values& args) {
+            _compressTexture = args[0].as<bool>();
+            return true;
+        },
+        [&]() -> Values { return {_compressTexture}; },
+        {'b'});
+    setAttributeDescription("compress",
+        "If true, the image is compressed to DXT5 (lossy) before being sent to the GPU, and cached on disk for the next loads. Applies to the next file read, "
+        "the width and height have to be multiples of 4");
+
     addAttribute("srgb",
         [&](const Values& args) {
             _srgb = args[0].as<bool>();
@@ -435,6 +833,17 @@ void Image::registerAttributes()
         {'b'});
     setAttributeDescription("srgb", "Set to true if the image file is stored as sRGB");
 
+    addAttribute("textureArray",
+        [&](const Values& args) {
+            _textureArray = args[0].as<string>();
+            return true;
+        },
+        [&]() -> Values { return {_textureArray}; },
+        {'s'});
+    setAttributeDescription("textureArray",
+        "If set, the image is uploaded as a layer of the texture array of this name, shared with the other images set to it instead of getting a texture of its own. "
+        "Meant for many small still images of the same format. Applies to the next links of the image");
+
     addAttribute("benchmark",
         [&](const Values& args) {
             _benchmark = args[0].as<bool>();
@@ -445,13 +854,17 @@ void Image::registerAttributes()
 
     addAttribute("pattern",
         [&](const Values& args) {
-            if (args[0].as<bool>())
+            if (!args[0].as<bool>())
+                return true;
+            if (args.size() >= 3)
+                createPattern(std::max(1, args[1].as<int>()), std::max(1, args[2].as<int>()));
+            else
                 createPattern();
             return true;
         },
         [&]() -> Values { return {false}; },
         {'b'});
-    setAttributeDescription("pattern", "Set to true to replace the image with a pattern");
+    setAttributeDescription("pattern", "Set to true to replace the image with a pattern, optionally followed by the pattern width and height");
 
     addAttribute("mediaInfo",
         [&](const Values& args) {
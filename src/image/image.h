@@ -25,8 +25,11 @@
 #ifndef SPLASH_IMAGE_H
 #define SPLASH_IMAGE_H
 
+#include <atomic>
 #include <chrono>
+#include <future>
 #include <mutex>
+#include <optional>
 
 #include "./core/constants.h"
 
@@ -34,6 +37,7 @@
 #include "./core/buffer_object.h"
 #include "./core/imagebuffer.h"
 #include "./core/root_object.h"
+#include "./core/upload_ring.h"
 
 namespace Splash
 {
@@ -78,6 +82,14 @@ class Image : public BufferObject
      */
     ImageBuffer get() const;
 
+    /**
+     * \brief Get the current image buffer, without copying it
+     * The buffer is never modified once published, and stays valid as long as the returned pointer is held.
+     * Writers are not blocked by snapshots, a held snapshot only prevents its buffer from being recycled.
+     * \return Return the current image buffer, or nullptr if there is none
+     */
+    std::shared_ptr<const ImageBuffer> getSnapshot() const;
+
     /**
      * \brief Get the file path
      * \return Return the file path
@@ -90,6 +102,12 @@ class Image : public BufferObject
      */
     ImageBufferSpec getSpec() const;
 
+    /**
+     * Get the memory held by the image buffers. Buffers mapped from GPU memory are not counted
+     * \return Return the memory usage
+     */
+    MemoryUsage getMemoryUsage() const override;
+
     /**
      * Get the timestamp for the current image
      * \return Return the timestamp
@@ -104,11 +122,7 @@ class Image : public BufferObject
      * Set the timestamp
      * \param timestamp Timestamp, in us
      */
-    void setTimestamp(int64_t timestamp) override
-    {
-        std::lock_guard<std::shared_mutex> lock(_writeMutex);
-        _image->getSpec().timestamp = timestamp;
-    }
+    void setTimestamp(int64_t timestamp) override;
 
     /**
      * \brief Set the image from an ImageBuffer
@@ -125,12 +139,47 @@ class Image : public BufferObject
      */
     void set(unsigned int w, unsigned int h, unsigned int channels, ImageBufferSpec::Type type);
 
+    /**
+     * \brief Set the ring to write the next frames to, instead of the image buffers
+     * Only some images support it, the ring being then used until it is closed
+     * \param ring Upload ring
+     * \return Return true if the image writes its frames to the ring
+     */
+    virtual bool setUploadRing(const std::shared_ptr<UploadRing>& /*ring*/) { return false; }
+
+    /**
+     * \brief Suspend or resume the production of new frames, when no camera samples the image
+     * Only decoded medias do something with it, static images being cheap to keep
+     * \param suspended If true, the image is suspended
+     */
+    virtual void setSuspended(bool /*suspended*/) {}
+
+    /**
+     * \brief Set the resolution at which the cameras sample the image, so that it can be produced at a lower resolution
+     * Only decoded medias do something with it
+     * \param width Sampled width, 0 if the whole image resolution is needed
+     * \param height Sampled height, 0 if the whole image resolution is needed
+     */
+    virtual void setSampledResolution(int /*width*/, int /*height*/) {}
+
     /**
      * \brief Serialize the image
      * \return Return the serialized image
      */
     std::shared_ptr<SerializedObject> serialize() const override;
 
+    /**
+     * \brief Serialize the part of the image covering the given UV region, as a tile
+     * The tile is aligned on a few pixels, and the whole image is serialized if it can not be tiled
+     * or if the tile would cover it almost entirely
+     * \param left Left border of the region, in UV coordinates
+     * \param top Top border of the region, in UV coordinates
+     * \param right Right border of the region, in UV coordinates
+     * \param bottom Bottom border of the region, in UV coordinates
+     * \return Return the serialized tile
+     */
+    std::shared_ptr<SerializedObject> serializeRegion(float left, float top, float right, float bottom) const;
+
     /**
      * \brief Update the Image from a serialized representation
      * \param obj Serialized image
@@ -172,8 +221,8 @@ class Image : public BufferObject
     bool write(const std::string& filename);
 
   protected:
-    std::unique_ptr<ImageBuffer> _image{nullptr};
-    std::unique_ptr<ImageBuffer> _bufferImage{nullptr};
+    std::shared_ptr<ImageBuffer> _image{nullptr};       //!< Published image, replaced as a whole so that snapshots stay untouched
+    std::unique_ptr<ImageBuffer> _bufferImage{nullptr}; //!< Back buffer, filled by the writers and published by update()
     std::string _filepath{""};
 
     Values _mediaInfo{};
@@ -184,9 +233,11 @@ class Image : public BufferObject
     bool _imageUpdated{false};
     bool _srgb{true};
     bool _benchmark{false};
+    bool _compressTexture{false};
+    std::string _textureArray{}; //!< If set, name of the texture array the image is uploaded to, as one of its layers
 
-    void createDefaultImage(); //< Create a default black image
-    void createPattern();      //< Create a default pattern
+    void createDefaultImage();                              //< Create a default black image
+    void createPattern(int width = 512, int height = 512); //< Create a default pattern
 
     /**
      * Update the _mediaInfo member
@@ -200,6 +251,47 @@ class Image : public BufferObject
      */
     bool readFile(const std::string& filename);
 
+#if HAVE_TURBOJPEG
+    /**
+     * \brief Decode a JPEG file with libjpeg-turbo, directly to the image buffer
+     * \param filename File path
+     * \return Return the decoded image, or nullptr if the file is not a JPEG or could not be decoded
+     */
+    static std::unique_ptr<ImageBuffer> decodeJpegFile(const std::string& filename);
+
+    /**
+     * \brief Decode a JPEG held in memory with libjpeg-turbo, directly to the image buffer
+     * \param data JPEG data
+     * \param size JPEG data size
+     * \return Return the decoded image, or nullptr if the data could not be decoded
+     */
+    static std::unique_ptr<ImageBuffer> decodeJpeg(const uint8_t* data, size_t size);
+#endif
+
+    /**
+     * \brief Decode an image file, with libjpeg-turbo for JPEG files if available and stb_image otherwise
+     * This does not modify the image, and can be called from any thread
+     * \param filename File path
+     * \return Return the decoded image, or nullptr if the file could not be decoded
+     */
+    static std::unique_ptr<ImageBuffer> decode(const std::string& filename);
+
+    /**
+     * \brief Decode an image file held in memory, with libjpeg-turbo for JPEG data if available and stb_image otherwise
+     * This does not modify the image, and can be called from any thread
+     * \param data Image file data
+     * \param size Image file data size
+     * \return Return the decoded image, or nullptr if the data could not be decoded
+     */
+    static std::unique_ptr<ImageBuffer> decode(const uint8_t* data, size_t size);
+
+    /**
+     * \brief Decode an image file with stb_image, the decoded pixels being adopted by the image buffer
+     * \param filename File path
+     * \return Return the decoded image, or nullptr if the file could not be decoded
+     */
+    static std::unique_ptr<ImageBuffer> decodeFile(const std::string& filename);
+
     /**
      * \brief Register new functors to modify attributes
      */
@@ -209,6 +301,48 @@ class Image : public BufferObject
     // Deserialization is done in this buffer, to avoid realloc
     ImageBuffer _bufferDeserialize;
 
+    // Compression of the last read file, replacing the uncompressed image once done
+    std::future<void> _compressionFuture{};
+    std::atomic<uint64_t> _readFileIndex{0};
+
+    /**
+     * \brief Hash the content of a file, to identify it in the compressed image cache
+     * \param filename File path
+     * \param fileSize Set to the file size
+     * \return Return the hash, or nothing if the file could not be read
+     */
+    static std::optional<uint64_t> hashFile(const std::string& filename, uint64_t& fileSize);
+
+    /**
+     * \brief Get the path of the compressed image cache file for the given file content
+     * \param contentHash Hash of the image file content
+     * \return Return the cache file path
+     */
+    static std::string getCacheFilePath(uint64_t contentHash);
+
+    /**
+     * \brief Read a compressed image from the cache
+     * \param contentHash Hash of the image file content
+     * \param fileSize Size of the image file, checked against the cache to rule out hash collisions
+     * \return Return the compressed image, or nullptr if it is not in the cache
+     */
+    static std::unique_ptr<ImageBuffer> readFromCache(uint64_t contentHash, uint64_t fileSize);
+
+    /**
+     * \brief Write a compressed image to the cache
+     * \param contentHash Hash of the image file content
+     * \param fileSize Size of the image file
+     * \param img Compressed image
+     */
+    static void writeToCache(uint64_t contentHash, uint64_t fileSize, const ImageBuffer& img);
+
+    /**
+     * \brief Compress an RGBA image to DXT5
+     * \param img RGBA image, with a width and height multiple of 4
+     * \return Return the compressed image
+     */
+    static std::unique_ptr<ImageBuffer> compress(const ImageBuffer& img);
+
     /**
      * Add more media info, to be implemented by derived classes
      */
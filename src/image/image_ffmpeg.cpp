@@ -1,28 +1,85 @@
 #include "./image/image_ffmpeg.h"
 
+#include <algorithm>
 #include <chrono>
+#include <cmath>
 #include <functional>
 #include <future>
+#include <limits>
 #include <numeric>
+#include <tuple>
 #if HAVE_LINUX
 #include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
 #endif
 #include <fstream>
 #include <hap.h>
 
+extern "C" {
+#include <libavutil/opt.h>
+}
+
 #include "./utils/cgutils.h"
 #include "./utils/log.h"
 #include "./utils/osutils.h"
+#include "./utils/scope_guard.h"
 #include "./utils/timer.h"
+#include "./utils/trace_recorder.h"
+
+// Tolerance when comparing frame timings, in us
+#define SPLASH_FFMPEG_SEEK_TOLERANCE 1000
+// Maximum number of frames decoded in advance for each cue
+#define SPLASH_FFMPEG_CUE_FRAMES 16
+// Part of the buffer size which can be used by the cue cache, as a divider
+#define SPLASH_FFMPEG_CUE_CACHE_RATIO 4
+// Difference to the audio clock below which the video clock is left untouched, in us
+#define SPLASH_FFMPEG_AUDIO_SYNC_TOLERANCE 5000
+// Part of the difference to the audio clock corrected for each frame, as a divider
+#define SPLASH_FFMPEG_AUDIO_SYNC_SLEW 4
+// Maximum difference between the playback times of two objects sharing a decoder, in us
+#define SPLASH_FFMPEG_SHARED_DECODER_TOLERANCE 1000000
+// Duration a follower can diverge from its leader before decoding on its own, in us, as attributes of mirrored objects are not all set at once
+#define SPLASH_FFMPEG_SHARED_DECODER_GRACE 500000
+// Highest factor by which the decoded frames can be downscaled to the resolution sampled by the cameras
+#define SPLASH_FFMPEG_MAX_DOWNSCALE 8
+// Delay before the first reconnection attempt to a lost live stream, in us
+#define SPLASH_FFMPEG_LIVE_RECONNECT_MIN_DELAY 250000
+// Maximum delay between two reconnection attempts to a live stream, in us
+#define SPLASH_FFMPEG_LIVE_RECONNECT_MAX_DELAY 8000000
+// Duration after which a live stream which does not send anything is considered lost, in us
+#define SPLASH_FFMPEG_LIVE_TIMEOUT 2000000
+// Longest wait of the scrubbing loop between two checks of the scrub position, in us
+#define SPLASH_FFMPEG_SCRUB_POLL_PERIOD 5000
+// Part of the buffer size which can be used by the compressed packets cache used for scrubbing, as a divider
+#define SPLASH_FFMPEG_SCRUB_CACHE_RATIO 2
+// Part of the buffer size which can be held by the pool of recycled frames, as a divider
+#define SPLASH_FFMPEG_FRAME_POOL_RATIO 4
+// Number of threads swscale slices each frame conversion over, 0 for as many as there are cores
+#define SPLASH_FFMPEG_CONVERSION_THREADS 0
+// Maximum number of compressed packets read ahead of the decoding
+#define SPLASH_FFMPEG_PACKET_QUEUE_LENGTH 256
+// Maximum number of decoded frames handed over to the display loop at once
+#define SPLASH_FFMPEG_FRAME_QUEUE_LENGTH 256
+// Part of the buffer size which can be held by the compressed packets read ahead of the decoding, as a divider
+#define SPLASH_FFMPEG_PACKET_QUEUE_RATIO 8
+// Size of the blocks read from local files, in bytes
+#define SPLASH_FFMPEG_IO_BLOCK_SIZE (1 << 20)
+// Size of the part of local files the kernel is asked to read ahead, in bytes
+#define SPLASH_FFMPEG_READAHEAD_SIZE (32 << 20)
 
 using namespace std;
 
 namespace Splash
 {
 
+mutex Image_FFmpeg::_sharedDecodersMutex{};
+map<string, Image_FFmpeg*> Image_FFmpeg::_sharedDecoders{};
+
 /*************/
 Image_FFmpeg::Image_FFmpeg(RootObject* root)
     : Image(root)
+    , _timedFrames(SPLASH_FFMPEG_FRAME_QUEUE_LENGTH)
 {
     init();
 }
@@ -30,6 +87,8 @@ Image_FFmpeg::Image_FFmpeg(RootObject* root)
 /*************/
 Image_FFmpeg::~Image_FFmpeg()
 {
+    releaseFollowers();
+    stopFollowing();
     freeFFmpegObjects();
 }
 
@@ -37,6 +96,7 @@ Image_FFmpeg::~Image_FFmpeg()
 void Image_FFmpeg::init()
 {
     _type = "image_ffmpeg";
+    _framePool.setMaximumSize(_maximumBufferSize / SPLASH_FFMPEG_FRAME_POOL_RATIO);
     registerAttributes();
 
     // This is used for getting documentation "offline"
@@ -52,6 +112,8 @@ void Image_FFmpeg::freeFFmpegObjects()
     if (_continueRead)
     {
         _continueRead = false;
+        _interruptIO = true;
+        notifyLoops();
         _readLoopThread.join();
         _videoDisplayThread.join();
 #if HAVE_PORTAUDIO
@@ -66,27 +128,107 @@ void Image_FFmpeg::freeFFmpegObjects()
         avformat_close_input(&_avContext);
         _avContext = nullptr;
     }
+#if HAVE_LINUX
+    closeFileIO();
+#endif
+    _interruptIO = false;
+}
+
+/*************/
+int Image_FFmpeg::interruptIO(void* opaque)
+{
+    auto image = static_cast<Image_FFmpeg*>(opaque);
+    return image->_interruptIO ? 1 : 0;
+}
+
+/*************/
+void Image_FFmpeg::scheduleReconnect()
+{
+    auto delay = std::max<int64_t>(_reconnectDelay, SPLASH_FFMPEG_LIVE_RECONNECT_MIN_DELAY);
+    _reconnectDelay = std::min<int64_t>(delay * 2, SPLASH_FFMPEG_LIVE_RECONNECT_MAX_DELAY);
+    _reconnectTime = Timer::getTime() + delay;
+    Log::get() << Log::WARNING << "Image_FFmpeg::" << __FUNCTION__ << " - Live stream " << _filepath << " is not available, trying again in " << delay / 1000 << "ms"
+               << Log::endl;
 }
 
 /*************/
 float Image_FFmpeg::getMediaDuration() const
 {
     if (!_avContext)
-        return 0.f;
+        return _sharedDuration; // Only set while following another object
     return static_cast<float>(_avContext->duration) / static_cast<float>(AV_TIME_BASE);
 }
 
+/*************/
+GraphObject::MemoryUsage Image_FFmpeg::getMemoryUsage() const
+{
+    auto usage = Image::getMemoryUsage();
+
+    usage.ram += _timedFramesSize;
+
+    {
+        lock_guard<mutex> lock(_cueMutex);
+        for (const auto& [cueTime, cachedCue] : _cueCache)
+            usage.ram += cachedCue.size;
+    }
+    usage.ram += _scrubCacheSize;
+
+    return usage;
+}
+
 /*************/
 bool Image_FFmpeg::read(const string& filename)
 {
-    const auto filepath = Utils::getFullPathFromFilePath(filename, _root->getConfigurationPath());
+    // URLs of network streams are given as is to FFmpeg
+    const auto filepath = filename.find("://") != string::npos ? filename : Utils::getFullPathFromFilePath(filename, _root->getConfigurationPath());
 
     // First: cleanup
+    releaseFollowers();
+    stopFollowing();
     freeFFmpegObjects();
+    _reconnectTime = -1;
+
+    if (followSharedDecoder(filepath))
+        return true;
+
+    // Live streams are read without buffering, and reads blocked by a lost connection are aborted when closing
+    AVDictionary* formatOptions = nullptr;
+    _avContext = avformat_alloc_context();
+    if (_live)
+    {
+        auto timeout = to_string(SPLASH_FFMPEG_LIVE_TIMEOUT);
+        av_dict_set(&formatOptions, "fflags", "nobuffer", 0);
+        av_dict_set(&formatOptions, "flags", "low_delay", 0);
+        av_dict_set(&formatOptions, "probesize", "500000", 0);
+        av_dict_set(&formatOptions, "analyzeduration", "500000", 0);
+        av_dict_set(&formatOptions, "rw_timeout", timeout.c_str(), 0);
+#if LIBAVFORMAT_VERSION_INT >= AV_VERSION_INT(59, 0, 100)
+        av_dict_set(&formatOptions, "timeout", timeout.c_str(), 0);
+#else
+        av_dict_set(&formatOptions, "stimeout", timeout.c_str(), 0);
+#endif
+        _avContext->interrupt_callback.callback = &Image_FFmpeg::interruptIO;
+        _avContext->interrupt_callback.opaque = this;
+    }
+#if HAVE_LINUX
+    else if (filepath.find("://") == string::npos && openFileIO(filepath))
+    {
+        _avContext->pb = _ioContext;
+        _avContext->flags |= AVFMT_FLAG_CUSTOM_IO;
+    }
+#endif
 
-    if (avformat_open_input(&_avContext, filepath.c_str(), nullptr, nullptr) != 0)
+    auto openResult = avformat_open_input(&_avContext, filepath.c_str(), nullptr, &formatOptions);
+    av_dict_free(&formatOptions);
+    if (openResult != 0)
     {
         Log::get() << Log::WARNING << "Image_FFmpeg::" << __FUNCTION__ << " - Couldn't read file " << filepath << Log::endl;
+        _avContext = nullptr;
+#if HAVE_LINUX
+        closeFileIO();
+#endif
+        if (_live)
+            scheduleReconnect();
         return false;
     }
 
@@ -94,9 +236,17 @@ bool Image_FFmpeg::read(const string& filename)
     {
         Log::get() << Log::WARNING << "Image_FFmpeg::" << __FUNCTION__ << " - Couldn't retrieve information for file " << filepath << Log::endl;
         avformat_close_input(&_avContext);
+#if HAVE_LINUX
+        closeFileIO();
+#endif
+        if (_live)
+            scheduleReconnect();
         return false;
     }
 
+    if (_live)
+        _avContext->flags |= AVFMT_FLAG_NOBUFFER;
+
     Log::get() << Log::MESSAGE << "Image_FFmpeg::" << __FUNCTION__ << " - Successfully loaded file " << filepath << Log::endl;
     av_dump_format(_avContext, 0, filepath.c_str(), 0);
 
@@ -113,6 +263,19 @@ bool Image_FFmpeg::read(const string& filename)
     }
 #endif
 
+    _mediaPath = filepath;
+    {
+        lock_guard<mutex> lock(_cueMutex);
+        _cueCache.clear();
+        _cuesUpdated = true;
+    }
+
+    {
+        lock_guard<mutex> lockShared(_sharedDecodersMutex);
+        updateSuspension();
+        updateOutputResolution();
+    }
+
     // Launch the loops
     _continueRead = true;
     _videoDisplayThread = thread([&]() { videoDisplayLoop(); });
@@ -121,9 +284,285 @@ bool Image_FFmpeg::read(const string& filename)
 #endif
     _readLoopThread = thread([&]() { readLoop(); });
 
+    // Other objects opening the same media can show the frames decoded by this one
+    if (_shareDecoder)
+    {
+        lock_guard<mutex> lockShared(_sharedDecodersMutex);
+        if (_sharedDecoders.find(filepath) == _sharedDecoders.end())
+            _sharedDecoders[filepath] = this;
+    }
+
+    return true;
+}
+
+/*************/
+Image_FFmpeg::PlaybackOptions Image_FFmpeg::getPlaybackOptions() const
+{
+    PlaybackOptions options;
+    options.hwaccel = _hwaccel;
+    options.loop = _loopOnVideo;
+    options.paused = _paused;
+    options.useClock = _useClock;
+    options.live = _live;
+    options.scrub = _scrub;
+    options.speed = _speed;
+    options.shiftTime = _shiftTime;
+    options.trimStart = _trimStart;
+    options.trimEnd = _trimEnd;
+    return options;
+}
+
+/*************/
+bool Image_FFmpeg::followSharedDecoder(const string& filepath)
+{
+    if (!_shareDecoder)
+        return false;
+
+    lock_guard<mutex> lockShared(_sharedDecodersMutex);
+    auto decoderIt = _sharedDecoders.find(filepath);
+    if (decoderIt == _sharedDecoders.end() || decoderIt->second == this)
+        return false;
+
+    // Objects driven by the master clock play at the same time, the others only if they are about to show the same frames
+    auto leader = decoderIt->second;
+    if (leader->getPlaybackOptions() != getPlaybackOptions())
+        return false;
+    if (!_useClock && abs(leader->_elapsedTime - _elapsedTime) > SPLASH_FFMPEG_SHARED_DECODER_TOLERANCE)
+        return false;
+
+    _leader = leader;
+    _mediaPath = filepath;
+    _sharedDuration = leader->getMediaDuration();
+    _pendingSeekTime = -1;
+    _divergedSince = -1;
+    leader->_followers.push_back(this);
+    leader->updateSuspension();
+    leader->updateOutputResolution();
+
+    Log::get() << Log::MESSAGE << "Image_FFmpeg::" << __FUNCTION__ << " - Image " << _name << " shows the frames decoded by " << leader->getName() << " for file " << filepath
+               << Log::endl;
     return true;
 }
 
+/*************/
+void Image_FFmpeg::stopFollowing()
+{
+    lock_guard<mutex> lockShared(_sharedDecodersMutex);
+    _sharedDuration = 0.f;
+    if (!_leader)
+        return;
+
+    auto& followers = _leader->_followers;
+    followers.erase(remove(followers.begin(), followers.end(), this), followers.end());
+    _leader->updateSuspension();
+    _leader->updateOutputResolution();
+    _leader = nullptr;
+}
+
+/*************/
+void Image_FFmpeg::releaseFollowers()
+{
+    lock_guard<mutex> lockShared(_sharedDecodersMutex);
+    if (auto decoderIt = _sharedDecoders.find(_mediaPath); decoderIt != _sharedDecoders.end() && decoderIt->second == this)
+        _sharedDecoders.erase(decoderIt);
+
+    // The followers open the media from their own main loop, the first one becoming the leader of the others
+    for (auto follower : _followers)
+    {
+        follower->_leader = nullptr;
+        auto elapsed = _elapsedTime;
+        follower->addTask([follower, elapsed]() { follower->reopenAt(elapsed); });
+    }
+    _followers.clear();
+    _sharedImage.reset();
+}
+
+/*************/
+bool Image_FFmpeg::isFollowing() const
+{
+    lock_guard<mutex> lockShared(_sharedDecodersMutex);
+    return _leader != nullptr;
+}
+
+/*************/
+void Image_FFmpeg::showSharedImage(const shared_ptr<ImageBuffer>& image, int64_t elapsed)
+{
+    {
+        lock_guard<Spinlock> lockRead(_readMutex);
+        lock_guard<shared_mutex> lockWrite(_writeMutex);
+        _image = image;
+    }
+    _elapsedTime = elapsed;
+
+    updateTimestamp(image->getSpec().timestamp);
+    if (_remoteType.empty() || _type == _remoteType)
+        updateMediaInfo();
+}
+
+/*************/
+void Image_FFmpeg::reopenAt(int64_t time)
+{
+    // The time is also used to check whether another object plays at the same time
+    _elapsedTime = time;
+    if (!read(_filepath))
+        return;
+    seek_async(static_cast<float>(time) / 1e6f);
+}
+
+/*************/
+void Image_FFmpeg::update()
+{
+    Image::update();
+
+    shared_ptr<ImageBuffer> image;
+    {
+        lock_guard<Spinlock> lockRead(_readMutex);
+        image = _image;
+    }
+
+    lock_guard<mutex> lockShared(_sharedDecodersMutex);
+    if (_followers.empty())
+        return;
+
+    const auto options = getPlaybackOptions();
+    const auto now = Timer::getTime();
+    vector<pair<Image_FFmpeg*, int64_t>> divergedFollowers;
+    for (auto follower : _followers)
+    {
+        // A seek is satisfied once the leader reached the same time, which happens when all mirrored objects are seeked together.
+        // The follower may be updated concurrently, so it only clears the seek if it was not requested again meanwhile.
+        auto pendingSeekTime = follower->_pendingSeekTime.load();
+        if (pendingSeekTime >= 0 && abs(pendingSeekTime - _elapsedTime) <= SPLASH_FFMPEG_SHARED_DECODER_TOLERANCE && follower->_pendingSeekTime.compare_exchange_strong(pendingSeekTime, -1))
+            pendingSeekTime = -1;
+
+        if (pendingSeekTime < 0 && follower->getPlaybackOptions() == options)
+        {
+            follower->_divergedSince = -1;
+            continue;
+        }
+
+        auto divergedSince = follower->_divergedSince.load();
+        if (divergedSince < 0)
+            follower->_divergedSince = now;
+        else if (now - divergedSince > SPLASH_FFMPEG_SHARED_DECODER_GRACE)
+            divergedFollowers.push_back({follower, pendingSeekTime >= 0 ? pendingSeekTime : _elapsedTime});
+    }
+
+    for (const auto& [follower, time] : divergedFollowers)
+    {
+        _followers.erase(remove(_followers.begin(), _followers.end(), follower), _followers.end());
+        follower->_leader = nullptr;
+        auto reopened = follower;
+        auto reopenTime = time;
+        follower->addTask([reopened, reopenTime]() { reopened->reopenAt(reopenTime); });
+        Log::get() << Log::MESSAGE << "Image_FFmpeg::" << __FUNCTION__ << " - Image " << follower->getName() << " does not play like " << _name << " anymore, it will decode "
+                   << _mediaPath << " itself" << Log::endl;
+    }
+    if (!divergedFollowers.empty())
+    {
+        updateSuspension();
+        updateOutputResolution();
+    }
+
+    if (!image || image == _sharedImage)
+        return;
+    _sharedImage = image;
+
+    for (auto follower : _followers)
+        follower->showSharedImage(image, _elapsedTime);
+}
+
+/*************/
+void Image_FFmpeg::setSuspended(bool suspended)
+{
+    lock_guard<mutex> lockShared(_sharedDecodersMutex);
+    _suspendRequested = suspended;
+    if (_leader)
+        _leader->updateSuspension();
+    else
+        updateSuspension();
+}
+
+/*************/
+void Image_FFmpeg::updateSuspension()
+{
+    auto suspended = _suspendRequested && all_of(_followers.begin(), _followers.end(), [](const auto follower) { return follower->_suspendRequested; });
+#if HAVE_PORTAUDIO
+    // The sound is still heard when the image is not seen
+    if (_speaker)
+        suspended = false;
+#endif
+
+    {
+        lock_guard<mutex> lockSeek(_videoSeekMutex);
+        if (suspended == _suspended)
+            return;
+        _suspended = suspended;
+        _readCondition.notify_all();
+    }
+
+    Log::get() << Log::MESSAGE << "Image_FFmpeg::" << __FUNCTION__ << " - Image " << _name << (suspended ? " is not sampled anymore, decoding is suspended" : " is sampled again, decoding resumes")
+               << Log::endl;
+
+    // Decoding resumes where the playback is now, from the main loop as seeking may wait for a previous seek
+    if (suspended || !_continueRead)
+        return;
+    addTask([this]() {
+        if (_paused || _startTime < 0 || !_avContext)
+            return;
+        auto position = static_cast<float>(Timer::getTime() - _startTime) / 1e6f;
+        auto duration = getMediaDuration();
+        if (_loopOnVideo && duration > 0.f)
+            position = fmod(position, duration);
+        seek_async(position);
+    });
+}
+
+/*************/
+void Image_FFmpeg::setSampledResolution(int width, int height)
+{
+    lock_guard<mutex> lockShared(_sharedDecodersMutex);
+    _sampledResolution = {width, height};
+    if (_leader)
+        _leader->updateOutputResolution();
+    else
+        updateOutputResolution();
+}
+
+/*************/
+void Image_FFmpeg::updateOutputResolution()
+{
+    auto resolution = _sampledResolution;
+    for (const auto follower : _followers)
+    {
+        const auto& followerResolution = follower->_sampledResolution;
+        if (resolution[0] == 0 || resolution[1] == 0 || followerResolution[0] == 0 || followerResolution[1] == 0)
+            resolution = {0, 0};
+        else
+            resolution = {std::max(resolution[0], followerResolution[0]), std::max(resolution[1], followerResolution[1])};
+    }
+
+    _outputWidth = resolution[0];
+    _outputHeight = resolution[1];
+}
+
+/*************/
+array<int, 2> Image_FFmpeg::getOutputSize(int width, int height) const
+{
+    const auto outputWidth = _outputWidth.load();
+    const auto outputHeight = _outputHeight.load();
+    if (!_downscale || outputWidth <= 0 || outputHeight <= 0)
+        return {width, height};
+
+    // Sizes are kept even, as chroma is subsampled by 2 for the planar formats
+    int factor = 1;
+    while (factor < SPLASH_FFMPEG_MAX_DOWNSCALE && width / (factor * 2) >= outputWidth && height / (factor * 2) >= outputHeight)
+        factor *= 2;
+    if (factor == 1)
+        return {width, height};
+    return {std::max(2, (width / factor) & ~1), std::max(2, (height / factor) & ~1)};
+}
+
 /*************/
 string Image_FFmpeg::tagToFourCC(unsigned int tag)
 {
@@ -196,303 +635,466 @@ bool Image_FFmpeg::setupAudioOutput(AVCodecContext* audioCodecContext)
     if (!_speaker)
         return false;
 
-    _speaker->setParameters(audioCodecContext->channels, audioCodecContext->sample_rate, format, _audioDeviceOutput);
+    _speaker->setParameters(audioCodecContext->channels, audioCodecContext->sample_rate, format, _audioDeviceOutput, _audioOutputChannel);
     return true;
 }
 #endif
 
 /*************/
-void Image_FFmpeg::readLoop()
+Image_FFmpeg::VideoDecoder::~VideoDecoder()
 {
-    // Find the first video stream
-    _videoStreamIndex = -1;
-#if HAVE_PORTAUDIO
-    _audioStreamIndex = -1;
-#endif
-    for (uint32_t i = 0; i < _avContext->nb_streams; ++i)
-    {
-        if (_avContext->streams[i]->codecpar->codec_type == AVMEDIA_TYPE_VIDEO && _videoStreamIndex < 0)
-            _videoStreamIndex = i;
-#if HAVE_PORTAUDIO
-        else if (_avContext->streams[i]->codecpar->codec_type == AVMEDIA_TYPE_AUDIO && _audioStreamIndex < 0)
-            _audioStreamIndex = i;
-#endif
-    }
-
-    if (_videoStreamIndex == -1)
-    {
-        Log::get() << Log::WARNING << "Image_FFmpeg::" << __FUNCTION__ << " - No video stream found in file " << _filepath << Log::endl;
-        return;
-    }
-
-#if HAVE_PORTAUDIO
-    if (_audioStreamIndex == -1)
+    av_frame_free(&hwTransferFrame);
+    av_frame_free(&convertedFrame);
+    av_frame_free(&scaledFrame);
+    av_frame_free(&frame);
+    if (swsContext)
+        sws_freeContext(swsContext);
+    if (scaleContext)
+        sws_freeContext(scaleContext);
+    if (codecContext)
     {
-        Log::get() << Log::MESSAGE << "Image_FFmpeg::" << __FUNCTION__ << " - No audio stream found in file " << _filepath << Log::endl;
+        avcodec_close(codecContext);
+        avcodec_free_context(&codecContext);
     }
-#endif
+}
 
-    // Find a video decoder
-    auto videoStream = _avContext->streams[_videoStreamIndex];
-    auto videoCodecParameters = _avContext->streams[_videoStreamIndex]->codecpar;
-    auto videoCodecContext = avcodec_alloc_context3(nullptr);
-    if (avcodec_parameters_to_context(videoCodecContext, videoCodecParameters) < 0)
+/*************/
+bool Image_FFmpeg::openVideoDecoder(AVStream* stream, VideoDecoder& decoder, bool useHardware)
+{
+    decoder.codecContext = avcodec_alloc_context3(nullptr);
+    if (avcodec_parameters_to_context(decoder.codecContext, stream->codecpar) < 0)
     {
         Log::get() << Log::WARNING << "Image_FFmpeg::" << __FUNCTION__ << " - Unable to create a video context from the codec parameters from file " << _filepath << Log::endl;
-        return;
+        return false;
     }
 
-    // Set video format info
-    _videoFormat.resize(1024);
-    avcodec_string(const_cast<char*>(_videoFormat.data()), _videoFormat.size(), videoCodecContext, 0);
-
-    videoCodecContext->thread_count = min(Utils::getCoreCount(), 16);
-    auto videoCodec = avcodec_find_decoder(videoCodecContext->codec_id);
-    auto isHap = false;
+    auto codecContext = decoder.codecContext;
+    auto videoCodec = avcodec_find_decoder(codecContext->codec_id);
+    decoder.timeBase = (double)stream->time_base.num / (double)stream->time_base.den;
 
-    // Check whether the video codec only has intra frames
-    auto desc = avcodec_descriptor_get(videoCodecContext->codec_id);
-    if (desc)
-        _intraOnly = !!(desc->props & AV_CODEC_PROP_INTRA_ONLY);
-    else
-        _intraOnly = false; // We don't know, so we consider it's not
-
-    auto fourcc = tagToFourCC(videoCodecContext->codec_tag);
+    auto fourcc = tagToFourCC(codecContext->codec_tag);
     if (fourcc.find("Hap") != string::npos)
     {
-        isHap = true;
-        _intraOnly = true; // Hap is necessarily intra only
+        decoder.isHap = true;
     }
     else if (videoCodec == nullptr)
     {
         Log::get() << Log::WARNING << "Image_FFmpeg::" << __FUNCTION__ << " - Video codec not supported for file " << _filepath << Log::endl;
-        return;
+        return false;
     }
 
     if (videoCodec)
     {
-        AVDictionary* optionsDict = nullptr;
-        if (avcodec_open2(videoCodecContext, videoCodec, &optionsDict) < 0)
-        {
-            Log::get() << Log::WARNING << "Image_FFmpeg::" << __FUNCTION__ << " - Could not open video codec for file " << _filepath << Log::endl;
-            return;
-        }
-    }
-
-#if HAVE_PORTAUDIO
-    // Find an audio decoder
-    auto audioCodecContext = avcodec_alloc_context3(nullptr);
-    if (_audioStreamIndex >= 0)
-    {
-        AVCodec* audioCodec{nullptr};
-        auto audioCodecParameters = _avContext->streams[_audioStreamIndex]->codecpar;
-        if (avcodec_parameters_to_context(audioCodecContext, audioCodecParameters) < 0)
+        // If hardware decoding is not available, fall back to software decoding
+        if (useHardware && !decoder.isHap && _hwaccel != "none")
         {
-            Log::get() << Log::WARNING << "Image_FFmpeg::" << __FUNCTION__ << " - Unable to create an audio context from the codec parameters for file " << _filepath << Log::endl;
-            return;
+            decoder.useHardware = setupHardwareDecoding(codecContext, videoCodec);
+            if (!decoder.useHardware)
+                Log::get() << Log::WARNING << "Image_FFmpeg::" << __FUNCTION__ << " - Unable to set up hardware decoding " << _hwaccel << ", using software decoding for file " << _filepath
+                           << Log::endl;
         }
 
-        audioCodec = avcodec_find_decoder(audioCodecContext->codec_id);
+        if (!decoder.useHardware)
+            codecContext->thread_count = min(Utils::getCoreCount(), 16);
 
-        if (audioCodec == nullptr)
+        // Frame threading delays the output by as many frames as there are threads
+        if (_live)
         {
-            Log::get() << Log::WARNING << "Image_FFmpeg::" << __FUNCTION__ << " - Audio codec not supported for file " << _filepath << Log::endl;
-            audioCodecContext = nullptr;
+            codecContext->flags |= AV_CODEC_FLAG_LOW_DELAY;
+            codecContext->thread_type = FF_THREAD_SLICE;
         }
-        else
+
+        AVDictionary* optionsDict = nullptr;
+        if (avcodec_open2(codecContext, videoCodec, &optionsDict) < 0)
         {
-            AVDictionary* audioOptionsDict = nullptr;
-            if (avcodec_open2(audioCodecContext, audioCodec, &audioOptionsDict) < 0)
-            {
-                Log::get() << Log::WARNING << "Image_FFmpeg::" << __FUNCTION__ << " - Could not open audio codec for file " << _filepath << Log::endl;
-                audioCodecContext = nullptr;
-            }
+            Log::get() << Log::WARNING << "Image_FFmpeg::" << __FUNCTION__ << " - Could not open video codec for file " << _filepath << Log::endl;
+            return false;
         }
-
-        if (audioCodecContext)
-            _audioDeviceOutputUpdated = true;
-
-        auto audioStream = _avContext->streams[_audioStreamIndex];
-        _audioTimeBase = (double)audioStream->time_base.num / (double)audioStream->time_base.den;
     }
-#endif
-
-    // Start reading frames
-    AVFrame *frame, *rgbFrame;
-    frame = av_frame_alloc();
-    rgbFrame = av_frame_alloc();
 
-    if (!frame || !rgbFrame)
+    decoder.frame = av_frame_alloc();
+    decoder.convertedFrame = av_frame_alloc();
+    decoder.hwTransferFrame = av_frame_alloc();
+    decoder.scaledFrame = av_frame_alloc();
+    if (!decoder.frame || !decoder.convertedFrame || !decoder.hwTransferFrame || !decoder.scaledFrame)
     {
         Log::get() << Log::WARNING << "Image_FFmpeg::" << __FUNCTION__ << " - Error while allocating frame structures" << Log::endl;
-        return;
+        return false;
     }
 
-    int numBytes = av_image_get_buffer_size(AV_PIX_FMT_YUYV422, videoCodecContext->width, videoCodecContext->height, 1);
-    vector<unsigned char> buffer(numBytes);
-
-    struct SwsContext* swsContext = nullptr;
-    if (!isHap)
-    {
-        swsContext = sws_getContext(videoCodecContext->width,
-            videoCodecContext->height,
-            videoCodecContext->pix_fmt,
-            videoCodecContext->width,
-            videoCodecContext->height,
-            AV_PIX_FMT_YUYV422,
-            SWS_BILINEAR,
-            nullptr,
-            nullptr,
-            nullptr);
-
-        av_image_fill_arrays(rgbFrame->data, rgbFrame->linesize, buffer.data(), AV_PIX_FMT_YUYV422, videoCodecContext->width, videoCodecContext->height, 1);
-    }
+    return true;
+}
 
-    AVPacket packet;
-    av_init_packet(&packet);
+/*************/
+bool Image_FFmpeg::decodeVideoPacket(VideoDecoder& decoder, AVPacket* packet, TimedFrame& timedFrame)
+{
+    TraceSpan span("decode", _name);
 
-    _videoTimeBase = (double)videoStream->time_base.num / (double)videoStream->time_base.den;
+    auto codecContext = decoder.codecContext;
 
-    // This implements looping
-    _startTime = Timer::getTime();
-    while (_continueRead)
+    //
+    // If the codec is handled by FFmpeg
+    if (!decoder.isHap)
     {
-        auto shouldContinueLoop = [&]() -> bool {
-            lock_guard<mutex> lock(_videoSeekMutex);
-            return _continueRead && av_read_frame(_avContext, &packet) >= 0;
-        };
-
-        while (shouldContinueLoop())
+        auto frame = decoder.frame;
+        auto frameFinished = false;
+        if (avcodec_send_packet(codecContext, packet) < 0)
+            Log::get() << Log::WARNING << "Image_FFmpeg::" << __FUNCTION__ << " - Error while decoding a frame in file " << _filepath << Log::endl;
+        if (avcodec_receive_frame(codecContext, frame) == 0)
+            frameFinished = true;
+
+        // Frames decoded on the GPU have to be transferred to the host memory first
+        AVFrame* decodedFrame = frame;
+        if (frameFinished && decoder.useHardware && frame->format == _hwPixelFormat)
         {
-            // Reading the video
-            if (packet.stream_index == _videoStreamIndex && _videoSeekMutex.try_lock())
+            if (av_hwframe_transfer_data(decoder.hwTransferFrame, frame, 0) < 0)
             {
-                auto img = unique_ptr<ImageBuffer>();
-                uint64_t timing = 0;
-                bool hasFrame = false;
+                Log::get() << Log::WARNING << "Image_FFmpeg::" << __FUNCTION__ << " - Error while transferring a hardware decoded frame in file " << _filepath << Log::endl;
+                frameFinished = false;
+            }
+            decodedFrame = decoder.hwTransferFrame;
+        }
 
-                //
-                // If the codec is handled by FFmpeg
-                if (!isHap)
+        if (frameFinished)
+        {
+            // Frames sampled at a lower resolution by the cameras are downscaled right away, saving the copies and uploads
+            const auto format = static_cast<AVPixelFormat>(decodedFrame->format);
+            const auto outputFormat = getOutputFormat(format);
+            const auto [width, height] = getOutputSize(codecContext->width, codecContext->height);
+            const auto downscaled = width != codecContext->width || height != codecContext->height;
+
+            // Planar frames are kept as is, and converted to RGB in the shaders
+            AVFrame* planarFrame = decodedFrame;
+            if (isPlanarFormat(outputFormat) && (downscaled || outputFormat != format))
+            {
+                auto scaledFrame = decoder.scaledFrame;
+                if (scaledFrame->width != width || scaledFrame->height != height || scaledFrame->format != outputFormat)
                 {
-                    auto frameFinished = false;
-                    if (avcodec_send_packet(videoCodecContext, &packet) < 0)
-                        Log::get() << Log::WARNING << "Image_FFmpeg::" << __FUNCTION__ << " - Error while decoding a frame in file " << _filepath << Log::endl;
-                    if (avcodec_receive_frame(videoCodecContext, frame) == 0)
-                        frameFinished = true;
+                    av_frame_unref(scaledFrame);
+                    scaledFrame->format = outputFormat;
+                    scaledFrame->width = width;
+                    scaledFrame->height = height;
+                    if (av_frame_get_buffer(scaledFrame, 0) < 0)
+                        Log::get() << Log::WARNING << "Image_FFmpeg::" << __FUNCTION__ << " - Unable to allocate a downscaled frame for file " << _filepath << Log::endl;
+                }
 
-                    if (frameFinished)
-                    {
-                        sws_scale(swsContext, (const uint8_t* const*)frame->data, frame->linesize, 0, videoCodecContext->height, rgbFrame->data, rgbFrame->linesize);
+                decoder.scaleContext = getConversionContext(
+                    decoder.scaleContext, decodedFrame->width, decodedFrame->height, format, width, height, outputFormat, downscaled ? SWS_AREA : SWS_BILINEAR);
+                if (scaledFrame->data[0] && decoder.scaleContext && convertFrame(decoder.scaleContext, decodedFrame, scaledFrame))
+                    planarFrame = scaledFrame;
+            }
 
-                        ImageBufferSpec spec(videoCodecContext->width, videoCodecContext->height, 3, 16, ImageBufferSpec::Type::UINT8, "YUYV");
-                        img.reset(new ImageBuffer(spec));
+            if (planarFrame != decodedFrame || !downscaled)
+                timedFrame.frame = copyPlanarFrame(planarFrame, width, height);
+            if (!timedFrame.frame)
+            {
+                // Other frames are converted to a packed format, right into the image buffer
+                const auto packedFormat = isPlanarFormat(outputFormat) ? AV_PIX_FMT_YUYV422 : outputFormat;
+                auto spec = packedFormat == AV_PIX_FMT_YUYV422 ? ImageBufferSpec(width, height, 3, 16, ImageBufferSpec::Type::UINT8, "YUYV")
+                                                               : ImageBufferSpec(width, height, 4, 32, ImageBufferSpec::Type::UINT8, "RGB10A2");
+                auto buffer = _framePool.acquire(spec);
+
+                auto numBytes = av_image_get_buffer_size(packedFormat, width, height, 1);
+                decoder.swsContext = getConversionContext(
+                    decoder.swsContext, decodedFrame->width, decodedFrame->height, format, width, height, packedFormat, downscaled ? SWS_AREA : SWS_BILINEAR);
+                if (decoder.swsContext && numBytes > 0 && static_cast<size_t>(numBytes) <= buffer->getSize())
+                {
+                    // The converted frame wraps the image buffer without owning it, as sws_scale_frame only writes to reference counted frames
+                    auto pixels = reinterpret_cast<uint8_t*>(buffer->data());
+                    auto convertedFrame = decoder.convertedFrame;
+                    convertedFrame->format = packedFormat;
+                    convertedFrame->width = width;
+                    convertedFrame->height = height;
+                    av_image_fill_arrays(convertedFrame->data, convertedFrame->linesize, pixels, packedFormat, width, height, 1);
+                    convertedFrame->buf[0] = av_buffer_create(pixels, numBytes, [](void*, uint8_t*) {}, nullptr, 0);
+
+                    if (convertedFrame->buf[0] && convertFrame(decoder.swsContext, decodedFrame, convertedFrame))
+                        timedFrame.frame = std::move(buffer);
+                    av_frame_unref(convertedFrame);
+                }
 
-                        unsigned char* pixels = reinterpret_cast<unsigned char*>(img->data());
-                        copy(buffer.begin(), buffer.end(), pixels);
+                if (!timedFrame.frame)
+                {
+                    Log::get() << Log::WARNING << "Image_FFmpeg::" << __FUNCTION__ << " - Error while converting a frame in file " << _filepath << Log::endl;
+                    _framePool.release(std::move(buffer));
+                    frameFinished = false;
+                }
+            }
 
-                        if (packet.pts != AV_NOPTS_VALUE)
-                            timing = static_cast<uint64_t>((double)frame->best_effort_timestamp * _videoTimeBase * 1e6);
-                        else
-                            timing = 0.0;
-                        // This handles repeated frames
-                        timing += frame->repeat_pict * _videoTimeBase * 0.5;
+            if (packet->pts != AV_NOPTS_VALUE)
+                timedFrame.timing = static_cast<uint64_t>((double)frame->best_effort_timestamp * decoder.timeBase * 1e6);
+            else
+                timedFrame.timing = 0.0;
+            // This handles repeated frames
+            timedFrame.timing += frame->repeat_pict * decoder.timeBase * 0.5;
+        }
 
-                        hasFrame = true;
-                    }
+        av_frame_unref(decoder.hwTransferFrame);
+        av_frame_unref(frame);
+        return frameFinished;
+    }
 
-                    av_frame_unref(frame);
-                }
-                //
-                // If the codec is marked as Hap / Hap alpha / Hap Q
-                else if (isHap)
-                {
-                    // We are using kind of a hack to store a DXT compressed image in an ImageBuffer
-                    // First, we check the texture format type
-                    std::string textureFormat;
-                    if (hapDecodeFrame(packet.data, packet.size, nullptr, 0, textureFormat))
-                    {
-                        // Check if we need to resize the reader buffer
-                        // We set the size so as to have just enough place for the given texture format
-                        ImageBufferSpec spec;
-                        if (textureFormat == "RGB_DXT1")
-                        {
-                            spec = ImageBufferSpec(videoCodecContext->width, (int)(ceil((float)videoCodecContext->height / 2.f)), 1, 8, ImageBufferSpec::Type::UINT8);
-                        }
-                        else if (textureFormat == "RGBA_DXT5")
-                        {
-                            spec = ImageBufferSpec(videoCodecContext->width, videoCodecContext->height, 1, 8, ImageBufferSpec::Type::UINT8);
-                        }
-                        else if (textureFormat == "YCoCg_DXT5")
-                        {
-                            spec = ImageBufferSpec(videoCodecContext->width, videoCodecContext->height, 1, 8, ImageBufferSpec::Type::UINT8);
-                        }
-                        else
-                        {
-                            av_packet_unref(&packet);
-                            return;
-                        }
+    //
+    // If the codec is marked as Hap / Hap alpha / Hap Q
+    // We are using kind of a hack to store a DXT compressed image in an ImageBuffer
+    // First, we check the texture format type
+    std::string textureFormat;
+    if (!hapDecodeFrame(packet->data, packet->size, nullptr, 0, textureFormat))
+        return false;
 
-                        spec.format = {textureFormat};
-                        img.reset(new ImageBuffer(spec));
+    // Check if we need to resize the reader buffer
+    // We set the size so as to have just enough place for the given texture format
+    ImageBufferSpec spec;
+    if (textureFormat == "RGB_DXT1")
+    {
+        spec = ImageBufferSpec(codecContext->width, (int)(ceil((float)codecContext->height / 2.f)), 1, 8, ImageBufferSpec::Type::UINT8);
+    }
+    else if (textureFormat == "RGBA_DXT5")
+    {
+        spec = ImageBufferSpec(codecContext->width, codecContext->height, 1, 8, ImageBufferSpec::Type::UINT8);
+    }
+    else if (textureFormat == "YCoCg_DXT5")
+    {
+        spec = ImageBufferSpec(codecContext->width, codecContext->height, 1, 8, ImageBufferSpec::Type::UINT8);
+    }
+    else
+    {
+        Log::get() << Log::WARNING << "Image_FFmpeg::" << __FUNCTION__ << " - Unsupported Hap texture format " << textureFormat << " in file " << _filepath << Log::endl;
+        return false;
+    }
 
-                        unsigned long outputBufferBytes = spec.width * spec.height * spec.channels;
+    spec.format = {textureFormat};
+    timedFrame.frame = _framePool.acquire(spec);
 
-                        if (hapDecodeFrame(packet.data, packet.size, img->data(), outputBufferBytes, textureFormat))
-                        {
-                            if (packet.pts != AV_NOPTS_VALUE)
-                                timing = static_cast<uint64_t>((double)packet.pts * _videoTimeBase * 1e6);
-                            else
-                                timing = 0.0;
+    unsigned long outputBufferBytes = spec.width * spec.height * spec.channels;
+    if (!hapDecodeFrame(packet->data, packet->size, timedFrame.frame->data(), outputBufferBytes, textureFormat))
+        return false;
 
-                            hasFrame = true;
-                        }
-                    }
+    if (packet->pts != AV_NOPTS_VALUE)
+        timedFrame.timing = static_cast<uint64_t>((double)packet->pts * decoder.timeBase * 1e6);
+    else
+        timedFrame.timing = 0.0;
+
+    return true;
+}
+
+/*************/
+void Image_FFmpeg::buildKeyframeIndex(AVStream* stream)
+{
+    _keyframes.clear();
+
+#if LIBAVFORMAT_VERSION_INT >= AV_VERSION_INT(58, 78, 100)
+    auto entryCount = avformat_index_get_entries_count(stream);
+#else
+    auto entryCount = stream->nb_index_entries;
+#endif
+    for (int i = 0; i < entryCount; ++i)
+    {
+#if LIBAVFORMAT_VERSION_INT >= AV_VERSION_INT(58, 78, 100)
+        auto entry = avformat_index_get_entry(stream, i);
+#else
+        auto entry = &stream->index_entries[i];
+#endif
+        if (entry && (entry->flags & AVINDEX_KEYFRAME))
+            _keyframes.push_back(entry->timestamp);
+    }
+
+    sort(_keyframes.begin(), _keyframes.end());
+}
+
+/*************/
+int64_t Image_FFmpeg::getPreviousKeyframe(int64_t timestamp) const
+{
+    auto keyframeIt = upper_bound(_keyframes.begin(), _keyframes.end(), timestamp);
+    if (keyframeIt == _keyframes.begin())
+        return -1;
+    return *prev(keyframeIt);
+}
+
+/*************/
+void Image_FFmpeg::readLoop()
+{
+    TraceRecorder::get().setThreadName(_name + " read");
+
+    // Find the first video stream
+    _videoStreamIndex = -1;
+#if HAVE_PORTAUDIO
+    _audioStreamIndex = -1;
+#endif
+    for (uint32_t i = 0; i < _avContext->nb_streams; ++i)
+    {
+        if (_avContext->streams[i]->codecpar->codec_type == AVMEDIA_TYPE_VIDEO && _videoStreamIndex < 0)
+            _videoStreamIndex = i;
+#if HAVE_PORTAUDIO
+        else if (_avContext->streams[i]->codecpar->codec_type == AVMEDIA_TYPE_AUDIO && _audioStreamIndex < 0)
+            _audioStreamIndex = i;
+#endif
+    }
+
+    if (_videoStreamIndex == -1)
+    {
+        Log::get() << Log::WARNING << "Image_FFmpeg::" << __FUNCTION__ << " - No video stream found in file " << _filepath << Log::endl;
+        return;
+    }
+
+#if HAVE_PORTAUDIO
+    if (_audioStreamIndex == -1)
+    {
+        Log::get() << Log::MESSAGE << "Image_FFmpeg::" << __FUNCTION__ << " - No audio stream found in file " << _filepath << Log::endl;
+    }
+#endif
+
+    // Find a video decoder
+    auto videoStream = _avContext->streams[_videoStreamIndex];
+    _hwPixelFormat = AV_PIX_FMT_NONE;
+    VideoDecoder decoder;
+    if (!openVideoDecoder(videoStream, decoder, true))
+        return;
+    auto videoCodecContext = decoder.codecContext;
+
+    // Set video format info
+    _videoFormat.resize(1024);
+    avcodec_string(const_cast<char*>(_videoFormat.data()), _videoFormat.size(), videoCodecContext, 0);
+
+    // Check whether the video codec only has intra frames
+    auto desc = avcodec_descriptor_get(videoCodecContext->codec_id);
+    if (decoder.isHap)
+        _intraOnly = true; // Hap is necessarily intra only
+    else if (desc)
+        _intraOnly = !!(desc->props & AV_CODEC_PROP_INTRA_ONLY);
+    else
+        _intraOnly = false; // We don't know, so we consider it's not
+
+    {
+        lock_guard<mutex> lock(_videoSeekMutex);
+        buildKeyframeIndex(videoStream);
+    }
+
+#if HAVE_PORTAUDIO
+    // Find an audio decoder
+    auto audioCodecContext = avcodec_alloc_context3(nullptr);
+    if (_audioStreamIndex >= 0)
+    {
+        AVCodec* audioCodec{nullptr};
+        auto audioCodecParameters = _avContext->streams[_audioStreamIndex]->codecpar;
+        if (avcodec_parameters_to_context(audioCodecContext, audioCodecParameters) < 0)
+        {
+            Log::get() << Log::WARNING << "Image_FFmpeg::" << __FUNCTION__ << " - Unable to create an audio context from the codec parameters for file " << _filepath << Log::endl;
+            return;
+        }
+
+        audioCodec = avcodec_find_decoder(audioCodecContext->codec_id);
+
+        if (audioCodec == nullptr)
+        {
+            Log::get() << Log::WARNING << "Image_FFmpeg::" << __FUNCTION__ << " - Audio codec not supported for file " << _filepath << Log::endl;
+            audioCodecContext = nullptr;
+        }
+        else
+        {
+            AVDictionary* audioOptionsDict = nullptr;
+            if (avcodec_open2(audioCodecContext, audioCodec, &audioOptionsDict) < 0)
+            {
+                Log::get() << Log::WARNING << "Image_FFmpeg::" << __FUNCTION__ << " - Could not open audio codec for file " << _filepath << Log::endl;
+                audioCodecContext = nullptr;
+            }
+        }
+
+        if (audioCodecContext)
+            _audioDeviceOutputUpdated = true;
+
+        auto audioStream = _avContext->streams[_audioStreamIndex];
+        _audioTimeBase = (double)audioStream->time_base.num / (double)audioStream->time_base.den;
+    }
+
+    AVFrame* audioFrame = av_frame_alloc();
+#endif
+
+    _videoTimeBase = decoder.timeBase;
+
+    // Cues can be prefetched now that the stream is known, live streams can not be seeked to them
+    if (!_live)
+        _prefetchThread = thread([&]() { prefetchLoop(); });
+
+    // Packets are read on their own thread, so that slow reads do not hold the decoding back
+    _stopDemux = false;
+    _demuxThread = thread([&]() { demuxLoop(); });
+
+    // This implements looping
+    _startTime = Timer::getTime();
+    while (_continueRead)
+    {
+        if (!Utils::applyThreadClass(Utils::ThreadClass::decode))
+            Log::get() << Log::WARNING << "Image_FFmpeg::" << __FUNCTION__ << " - Unable to apply the scheduling of the decode threads" << Log::endl;
+
+        // Intra only medias are scrubbed by decoding their frames in any order
+        if (canScrub())
+        {
+            {
+                lock_guard<mutex> lockDemux(_demuxMutex);
+                clearPacketQueue();
+            }
+            scrubLoop(decoder);
+            continue;
+        }
+
+        // Nothing is read nor decoded while no camera samples the image, the demux thread waiting for it
+        while (auto packet = popPacket())
+        {
+            // Reading the video
+            if (packet->stream_index == _videoStreamIndex && _videoSeekMutex.try_lock())
+            {
+                // Frames still held by the decoder are from before the last seek
+                if (_flushDecoder.exchange(false) && avcodec_is_open(videoCodecContext))
+                    avcodec_flush_buffers(videoCodecContext);
+
+                TimedFrame timedFrame;
+                bool hasFrame = decodeVideoPacket(decoder, packet, timedFrame);
+
+                // After a seek, frames between the keyframe and the target are decoded but not shown
+                auto skipFramesBefore = _skipFramesBefore.load();
+                if (hasFrame && skipFramesBefore >= 0)
+                {
+                    if (static_cast<int64_t>(timedFrame.timing) + SPLASH_FFMPEG_SEEK_TOLERANCE < skipFramesBefore)
+                        hasFrame = false;
+                    else
+                        _skipFramesBefore = -1;
                 }
 
-                int64_t totalBufferSize = 0;
+                if (hasFrame)
                 {
-                    lock_guard<mutex> lockFrames(_videoQueueMutex);
-                    if (hasFrame)
+                    // Live streams only keep the latest frame
+                    if (_live)
                     {
-                        // Add the frame size to the history
-                        _framesSize.push_back(img->getSize());
-
-                        _timedFrames.emplace_back();
-                        std::swap(_timedFrames[_timedFrames.size() - 1].frame, img);
-                        _timedFrames[_timedFrames.size() - 1].timing = timing;
+                        _timedFrames.clear();
+                        _reconnectDelay = 0;
                     }
 
-                    // Check the current buffer size (sum of all frames in buffer)
-                    for (auto& f : _framesSize)
-                        totalBufferSize += f;
+                    pushTimedFrame(std::move(timedFrame));
+                    notifyVideoQueue();
                 }
 
-                int timedFramesBuffered = _timedFrames.size();
-
                 _videoSeekMutex.unlock();
-                av_packet_unref(&packet);
+                av_packet_free(&packet);
 
                 // Do not store more than a few frames in memory
                 // _maximumBufferSize is divided by 2 as another frame queue is held by the display loop
-                while (timedFramesBuffered > 0 && totalBufferSize > _maximumBufferSize / 2 && _continueRead)
+                if (_timedFramesSize > _maximumBufferSize / 2 || _timedFrames.size() >= _timedFrames.capacity() / 2)
                 {
-                    this_thread::sleep_for(chrono::milliseconds(5));
-                    lock_guard<mutex> lockSeek(_videoSeekMutex);
-                    lock_guard<mutex> lockQueue(_videoQueueMutex);
-                    timedFramesBuffered = _timedFrames.size();
+                    unique_lock<mutex> lockQueue(_videoQueueMutex);
+                    _videoQueueCondition.wait(lockQueue, [&]() { return !_continueRead || _timedFrames.empty(); });
                 }
             }
 #if HAVE_PORTAUDIO
             // Reading the audio
-            else if (packet.stream_index == _audioStreamIndex && audioCodecContext)
+            else if (packet->stream_index == _audioStreamIndex && audioCodecContext)
             {
-                if (avcodec_send_packet(audioCodecContext, &packet) < 0)
+                if (avcodec_send_packet(audioCodecContext, packet) < 0)
                     Log::get() << Log::WARNING << "Image_FFmpeg::" << __FUNCTION__ << " - Error while decoding an audio frame in file " << _filepath << Log::endl;
-                uint64_t timing = (double)packet.pts * _audioTimeBase * 1e6;
-                av_packet_unref(&packet);
+                uint64_t timing = (double)packet->pts * _audioTimeBase * 1e6;
+                av_packet_free(&packet);
 
-                while (avcodec_receive_frame(audioCodecContext, frame) == 0)
+                while (avcodec_receive_frame(audioCodecContext, audioFrame) == 0)
                 {
                     // Check whether we were asked to connect to another output
                     if (audioCodecContext && _audioDeviceOutputUpdated)
@@ -501,74 +1103,602 @@ void Image_FFmpeg::readLoop()
                         _audioDeviceOutputUpdated = false;
                     }
 
-                    size_t dataSize = av_samples_get_buffer_size(nullptr, audioCodecContext->channels, frame->nb_samples, audioCodecContext->sample_fmt, 1);
+                    size_t dataSize = av_samples_get_buffer_size(nullptr, audioCodecContext->channels, audioFrame->nb_samples, audioCodecContext->sample_fmt, 1);
                     auto buffer = ResizableArray<uint8_t>(dataSize);
                     auto linesize = dataSize / audioCodecContext->channels;
                     if (_planar)
                         for (int c = 0; c < audioCodecContext->channels; ++c)
-                            copy(frame->extended_data[c], frame->extended_data[c] + linesize, buffer.data() + c * linesize);
+                            copy(audioFrame->extended_data[c], audioFrame->extended_data[c] + linesize, buffer.data() + c * linesize);
                     else
-                        copy(frame->extended_data[0], frame->extended_data[0] + dataSize, buffer.data());
+                        copy(audioFrame->extended_data[0], audioFrame->extended_data[0] + dataSize, buffer.data());
 
                     TimedAudioFrame timedFrame;
                     timedFrame.frame = std::move(buffer);
                     timedFrame.timing = timing;
-                    lock_guard<mutex> lockAudio(_audioMutex);
-                    _audioQueue.push_back(std::move(timedFrame));
+                    timedFrame.duration = static_cast<int64_t>(audioFrame->nb_samples) * 1000000 / std::max(1, audioCodecContext->sample_rate);
+                    {
+                        lock_guard<mutex> lockAudio(_audioMutex);
+                        _audioQueue.push_back(std::move(timedFrame));
+                    }
+                    _audioCondition.notify_one();
 
-                    av_frame_unref(frame);
+                    av_frame_unref(audioFrame);
                 }
             }
 #endif
             else
             {
-                av_packet_unref(&packet);
+                av_packet_free(&packet);
+            }
+        }
+
+        // Reading stopped to start scrubbing, not because the end of the file was reached
+        if (canScrub())
+            continue;
+
+        // A live stream which ends has been lost, it is opened again from the main loop
+        if (_live)
+        {
+            if (_continueRead)
+                scheduleReconnect();
+            break;
+        }
+
+        // If we loop, seek to the beginning, or whatever time is set in _trimStart
+        if (_loopOnVideo)
+        {
+            // This prevents looping to happen before the queue has been consumed
+            lock_guard<mutex> lockEnd(_videoEndMutex);
+            seek(static_cast<float>(_trimStart) / 1e6, false);
+        }
+        else
+        {
+            // Otherwise, wait for a seek or for looping to be enabled
+            unique_lock<mutex> lockSeek(_videoSeekMutex);
+            _readCondition.wait(lockSeek, [&]() { return !_continueRead || _loopOnVideo || _seekedSinceEnd || canScrub(); });
+            _seekedSinceEnd = false;
+        }
+    }
+
+    {
+        lock_guard<mutex> lockSeek(_videoSeekMutex);
+        lock_guard<mutex> lockQueue(_packetQueueMutex);
+        _stopDemux = true;
+    }
+    _readCondition.notify_all();
+    _packetQueueCondition.notify_all();
+    if (_demuxThread.joinable())
+        _demuxThread.join();
+    {
+        lock_guard<mutex> lockDemux(_demuxMutex);
+        clearPacketQueue();
+    }
+
+    {
+        lock_guard<mutex> lock(_cueMutex);
+        _cueCondition.notify_all();
+    }
+    if (_prefetchThread.joinable())
+        _prefetchThread.join();
+    clearScrubCache();
+    _framePool.clear();
+
+    _videoStreamIndex = -1;
+
+#if HAVE_PORTAUDIO
+    av_frame_free(&audioFrame);
+    if (audioCodecContext)
+    {
+        avcodec_close(audioCodecContext);
+        avcodec_free_context(&audioCodecContext);
+    }
+    _audioStreamIndex = -1;
+#endif
+}
+
+/*************/
+void Image_FFmpeg::demuxLoop()
+{
+    TraceRecorder::get().setThreadName(_name + " demux");
+    const auto maximumQueueSize = _maximumBufferSize / SPLASH_FFMPEG_PACKET_QUEUE_RATIO;
+
+    while (!_stopDemux)
+    {
+        {
+            // Wait for room in the queue, or for a seek once the end of the file is reached
+            unique_lock<mutex> lockQueue(_packetQueueMutex);
+            _packetQueueCondition.wait(lockQueue, [&]() {
+                return _stopDemux || (!_demuxEnded && _packetQueue.size() < SPLASH_FFMPEG_PACKET_QUEUE_LENGTH && _packetQueueSize < maximumQueueSize);
+            });
+        }
+
+        {
+            // Nothing is read while no camera samples the image, nor while scrubbing as the read loop then reads the file itself
+            unique_lock<mutex> lockSeek(_videoSeekMutex);
+            _readCondition.wait(lockSeek, [&]() { return _stopDemux || (!_suspended && !canScrub()); });
+            if (_stopDemux)
+                break;
+        }
+
+        // Packets are queued while _demuxMutex is held, so that none from before a seek is queued after it
+        lock_guard<mutex> lockDemux(_demuxMutex);
+        auto packet = av_packet_alloc();
+        bool endOfFile = av_read_frame(_avContext, packet) < 0;
+        if (endOfFile)
+            av_packet_free(&packet);
+
+        {
+            lock_guard<mutex> lockQueue(_packetQueueMutex);
+            if (endOfFile)
+            {
+                _demuxEnded = true;
+            }
+            else
+            {
+                _packetQueueSize += packet->size;
+                _packetQueue.push_back(packet);
+            }
+        }
+        _packetQueueCondition.notify_all();
+    }
+}
+
+/*************/
+AVPacket* Image_FFmpeg::popPacket()
+{
+    unique_lock<mutex> lock(_packetQueueMutex);
+    _packetQueueCondition.wait(lock, [&]() { return !_continueRead || canScrub() || _demuxEnded || !_packetQueue.empty(); });
+    if (!_continueRead || canScrub() || _packetQueue.empty())
+        return nullptr;
+
+    auto packet = _packetQueue.front();
+    _packetQueue.pop_front();
+    _packetQueueSize -= packet->size;
+    _packetQueueCondition.notify_all();
+    return packet;
+}
+
+/*************/
+void Image_FFmpeg::clearPacketQueue()
+{
+    {
+        lock_guard<mutex> lock(_packetQueueMutex);
+        for (auto& packet : _packetQueue)
+            av_packet_free(&packet);
+        _packetQueue.clear();
+        _packetQueueSize = 0;
+        _demuxEnded = false;
+    }
+    _packetQueueCondition.notify_all();
+}
+
+#if HAVE_LINUX
+/*************/
+bool Image_FFmpeg::openFileIO(const string& filepath)
+{
+    _ioFd = open(filepath.c_str(), O_RDONLY | O_CLOEXEC);
+    if (_ioFd < 0)
+        return false;
+
+    struct stat fileStat;
+    if (fstat(_ioFd, &fileStat) < 0 || !S_ISREG(fileStat.st_mode))
+    {
+        closeFileIO();
+        return false;
+    }
+    _ioFileSize = fileStat.st_size;
+    _ioPosition = 0;
+    _ioReadaheadEnd = 0;
+
+    auto buffer = static_cast<uint8_t*>(av_malloc(SPLASH_FFMPEG_IO_BLOCK_SIZE));
+    if (buffer)
+        _ioContext = avio_alloc_context(buffer, SPLASH_FFMPEG_IO_BLOCK_SIZE, 0, this, &Image_FFmpeg::readFileIO, nullptr, &Image_FFmpeg::seekFileIO);
+
+    if (!_ioContext)
+    {
+        Log::get() << Log::WARNING << "Image_FFmpeg::" << __FUNCTION__ << " - Unable to allocate the IO context for file " << filepath << ", letting FFmpeg read it" << Log::endl;
+        av_free(buffer);
+        closeFileIO();
+        return false;
+    }
+
+    return true;
+}
+
+/*************/
+void Image_FFmpeg::closeFileIO()
+{
+    if (_ioContext)
+    {
+        av_freep(&_ioContext->buffer);
+        avio_context_free(&_ioContext);
+    }
+
+    if (_ioFd >= 0)
+    {
+        close(_ioFd);
+        _ioFd = -1;
+    }
+}
+
+/*************/
+int Image_FFmpeg::readFileIO(void* opaque, uint8_t* buffer, int size)
+{
+    auto image = static_cast<Image_FFmpeg*>(opaque);
+    auto readSize = pread(image->_ioFd, buffer, size, image->_ioPosition);
+    if (readSize < 0)
+        return AVERROR(errno);
+    if (readSize == 0)
+        return AVERROR_EOF;
+    image->_ioPosition += readSize;
+
+    // Ask the kernel for the next part of the file before the decoding needs it
+    if (image->_ioReadaheadEnd - image->_ioPosition < SPLASH_FFMPEG_READAHEAD_SIZE / 2 && image->_ioReadaheadEnd < image->_ioFileSize)
+    {
+        auto start = std::max(image->_ioPosition, image->_ioReadaheadEnd);
+        posix_fadvise(image->_ioFd, start, SPLASH_FFMPEG_READAHEAD_SIZE, POSIX_FADV_WILLNEED);
+        image->_ioReadaheadEnd = start + SPLASH_FFMPEG_READAHEAD_SIZE;
+    }
+
+    return static_cast<int>(readSize);
+}
+
+/*************/
+int64_t Image_FFmpeg::seekFileIO(void* opaque, int64_t offset, int whence)
+{
+    auto image = static_cast<Image_FFmpeg*>(opaque);
+    if (whence & AVSEEK_SIZE)
+        return image->_ioFileSize;
+
+    int64_t position = 0;
+    switch (whence & ~AVSEEK_FORCE)
+    {
+    default:
+        return AVERROR(EINVAL);
+    case SEEK_SET:
+        position = offset;
+        break;
+    case SEEK_CUR:
+        position = image->_ioPosition + offset;
+        break;
+    case SEEK_END:
+        position = image->_ioFileSize + offset;
+        break;
+    }
+
+    if (position < 0)
+        return AVERROR(EINVAL);
+
+    // Reading ahead starts over from the new position if it is out of the part already asked for
+    if (position < image->_ioPosition || position > image->_ioReadaheadEnd)
+        image->_ioReadaheadEnd = position;
+    image->_ioPosition = position;
+    return position;
+}
+#endif
+
+/*************/
+void Image_FFmpeg::prefetchLoop()
+{
+    TraceRecorder::get().setThreadName(_name + " prefetch");
+
+    // Cues are decoded from a separate demuxer and decoder, to leave the playback untouched
+    AVFormatContext* context = nullptr;
+    if (avformat_open_input(&context, _mediaPath.c_str(), nullptr, nullptr) != 0 || avformat_find_stream_info(context, nullptr) < 0)
+    {
+        Log::get() << Log::WARNING << "Image_FFmpeg::" << __FUNCTION__ << " - Unable to open file " << _mediaPath << " for prefetching cues" << Log::endl;
+        if (context)
+            avformat_close_input(&context);
+        return;
+    }
+    OnScopeExit { avformat_close_input(&context); };
+
+    VideoDecoder decoder;
+    if (!openVideoDecoder(context->streams[_videoStreamIndex], decoder, false))
+        return;
+
+    while (_continueRead)
+    {
+        if (!Utils::applyThreadClass(Utils::ThreadClass::decode))
+            Log::get() << Log::WARNING << "Image_FFmpeg::" << __FUNCTION__ << " - Unable to apply the scheduling of the decode threads" << Log::endl;
+
+        vector<int64_t> cues;
+        {
+            unique_lock<mutex> lock(_cueMutex);
+            _cueCondition.wait(lock, [&]() { return _cuesUpdated || !_continueRead; });
+            if (!_continueRead)
+                break;
+            _cuesUpdated = false;
+
+            cues = _cues;
+            if (_loopOnVideo)
+                cues.push_back(_trimStart);
+
+            // Forget about the cues which are not used anymore
+            for (auto cueIt = _cueCache.begin(); cueIt != _cueCache.end();)
+            {
+                if (find(cues.begin(), cues.end(), cueIt->first) == cues.end())
+                    cueIt = _cueCache.erase(cueIt);
+                else
+                    ++cueIt;
+            }
+        }
+
+        for (const auto cue : cues)
+        {
+            {
+                lock_guard<mutex> lock(_cueMutex);
+                if (_cueCache.find(cue) != _cueCache.end() || _cuesUpdated)
+                    continue;
+            }
+
+            if (!_continueRead)
+                break;
+
+            // Seek to the keyframe preceding the cue, and decode up to it
+            auto timestamp = static_cast<int64_t>(static_cast<double>(cue) / 1e6 / decoder.timeBase);
+            if (avformat_seek_file(context, _videoStreamIndex, INT64_MIN, timestamp, timestamp, AVSEEK_FLAG_BACKWARD) < 0)
+                continue;
+            if (avcodec_is_open(decoder.codecContext))
+                avcodec_flush_buffers(decoder.codecContext);
+
+            // Each cue gets an even share of the cache
+            const int64_t cueBudget = _maximumBufferSize / SPLASH_FFMPEG_CUE_CACHE_RATIO / static_cast<int64_t>(cues.size());
+            CachedCue cachedCue;
+            AVPacket packet;
+            av_init_packet(&packet);
+            while (_continueRead && cachedCue.frames.size() < SPLASH_FFMPEG_CUE_FRAMES && av_read_frame(context, &packet) >= 0)
+            {
+                TimedFrame timedFrame;
+                if (packet.stream_index == _videoStreamIndex && decodeVideoPacket(decoder, &packet, timedFrame))
+                {
+                    if (static_cast<int64_t>(timedFrame.timing) + SPLASH_FFMPEG_SEEK_TOLERANCE >= cue)
+                    {
+                        cachedCue.size += timedFrame.frame->getSize();
+                        cachedCue.frames.push_back(std::move(timedFrame));
+                    }
+                }
+                av_packet_unref(&packet);
+
+                if (cachedCue.size >= cueBudget)
+                    break;
+            }
+
+            if (cachedCue.frames.empty())
+                continue;
+
+            lock_guard<mutex> lock(_cueMutex);
+            cachedCue.lastUse = ++_cueUseCounter;
+            _cueCache[cue] = std::move(cachedCue);
+
+            // Evict the least recently used cues if the cache grew too big
+            int64_t cacheSize = 0;
+            for (const auto& cachedEntry : _cueCache)
+                cacheSize += cachedEntry.second.size;
+            while (cacheSize > _maximumBufferSize / SPLASH_FFMPEG_CUE_CACHE_RATIO && _cueCache.size() > 1)
+            {
+                auto leastUsedIt = min_element(_cueCache.begin(), _cueCache.end(), [](const auto& a, const auto& b) { return a.second.lastUse < b.second.lastUse; });
+                cacheSize -= leastUsedIt->second.size;
+                _cueCache.erase(leastUsedIt);
+            }
+        }
+    }
+}
+
+/*************/
+bool Image_FFmpeg::setupHardwareDecoding(AVCodecContext* codecContext, const AVCodec* codec)
+{
+#if LIBAVCODEC_VERSION_MAJOR >= 58
+    auto deviceType = AV_HWDEVICE_TYPE_NONE;
+    if (_hwaccel != "auto")
+    {
+        deviceType = av_hwdevice_find_type_by_name(_hwaccel.c_str());
+        if (deviceType == AV_HWDEVICE_TYPE_NONE)
+        {
+            Log::get() << Log::WARNING << "Image_FFmpeg::" << __FUNCTION__ << " - Unknown hardware decoding API: " << _hwaccel << Log::endl;
+            return false;
+        }
+    }
+
+    for (int i = 0;; ++i)
+    {
+        auto config = avcodec_get_hw_config(codec, i);
+        if (!config)
+            break;
+        if (!(config->methods & AV_CODEC_HW_CONFIG_METHOD_HW_DEVICE_CTX))
+            continue;
+        if (deviceType != AV_HWDEVICE_TYPE_NONE && config->device_type != deviceType)
+            continue;
+
+        AVBufferRef* deviceContext = nullptr;
+        if (av_hwdevice_ctx_create(&deviceContext, config->device_type, nullptr, nullptr, 0) < 0)
+            continue;
+
+        // The codec context takes ownership of the device context
+        codecContext->hw_device_ctx = deviceContext;
+        codecContext->opaque = this;
+        codecContext->get_format = getHardwareFormat;
+        _hwPixelFormat = config->pix_fmt;
+
+        Log::get() << Log::MESSAGE << "Image_FFmpeg::" << __FUNCTION__ << " - Using hardware decoding through " << string(av_hwdevice_get_type_name(config->device_type))
+                   << " for file " << _filepath << Log::endl;
+        return true;
+    }
+
+    return false;
+#else
+    (void)codecContext;
+    (void)codec;
+    Log::get() << Log::WARNING << "Image_FFmpeg::" << __FUNCTION__ << " - Hardware decoding needs a more recent version of FFmpeg" << Log::endl;
+    return false;
+#endif
+}
+
+/*************/
+AVPixelFormat Image_FFmpeg::getHardwareFormat(AVCodecContext* codecContext, const AVPixelFormat* formats)
+{
+    auto that = static_cast<Image_FFmpeg*>(codecContext->opaque);
+    for (auto format = formats; *format != AV_PIX_FMT_NONE; ++format)
+        if (*format == that->_hwPixelFormat)
+            return *format;
+
+    // The stream can not be decoded by the hardware, so we return the first software format
+    Log::get() << Log::WARNING << "Image_FFmpeg::" << __FUNCTION__ << " - Hardware decoding is not available for this stream, falling back to software decoding" << Log::endl;
+    for (auto format = formats; *format != AV_PIX_FMT_NONE; ++format)
+    {
+        auto descriptor = av_pix_fmt_desc_get(*format);
+        if (descriptor && !(descriptor->flags & AV_PIX_FMT_FLAG_HWACCEL))
+            return *format;
+    }
+
+    return AV_PIX_FMT_NONE;
+}
+
+/*************/
+bool Image_FFmpeg::isPlanarFormat(AVPixelFormat format)
+{
+    return format == AV_PIX_FMT_NV12 || format == AV_PIX_FMT_P010LE || format == AV_PIX_FMT_YUV420P || format == AV_PIX_FMT_YUVJ420P;
+}
+
+/*************/
+struct SwsContext* Image_FFmpeg::getConversionContext(
+    struct SwsContext* context, int srcWidth, int srcHeight, AVPixelFormat srcFormat, int dstWidth, int dstHeight, AVPixelFormat dstFormat, int flags)
+{
+#if LIBSWSCALE_VERSION_INT >= AV_VERSION_INT(6, 1, 100)
+    const std::array<std::pair<const char*, int64_t>, 7> options{{{"srcw", srcWidth},
+        {"srch", srcHeight},
+        {"src_format", srcFormat},
+        {"dstw", dstWidth},
+        {"dsth", dstHeight},
+        {"dst_format", dstFormat},
+        {"sws_flags", flags}}};
+
+    if (context)
+    {
+        auto matches = true;
+        for (const auto& [name, value] : options)
+        {
+            int64_t current = 0;
+            if (av_opt_get_int(context, name, 0, &current) < 0 || current != value)
+            {
+                matches = false;
+                break;
             }
         }
 
-        // This prevents looping to happen before the queue has been consumed
-        lock_guard<mutex> lockEnd(_videoEndMutex);
-
-        // If we loop, seek to the beginning, or whatever time is set in _trimStart
-        if (_loopOnVideo)
-            seek(static_cast<float>(_trimStart) / 1e6, false);
-        else
-            this_thread::sleep_for(chrono::milliseconds(50));
+        if (matches)
+            return context;
+        sws_freeContext(context);
     }
 
-    av_frame_free(&rgbFrame);
-    av_frame_free(&frame);
-    if (!isHap)
-        sws_freeContext(swsContext);
-    avcodec_close(videoCodecContext);
-    avcodec_free_context(&videoCodecContext);
-    _videoStreamIndex = -1;
+    context = sws_alloc_context();
+    if (!context)
+        return nullptr;
 
-#if HAVE_PORTAUDIO
-    if (audioCodecContext)
+    for (const auto& [name, value] : options)
+        av_opt_set_int(context, name, value, 0);
+    av_opt_set_int(context, "threads", SPLASH_FFMPEG_CONVERSION_THREADS, 0);
+
+    if (sws_init_context(context, nullptr, nullptr) < 0)
     {
-        avcodec_close(audioCodecContext);
-        avcodec_free_context(&audioCodecContext);
+        sws_freeContext(context);
+        return nullptr;
     }
-    _audioStreamIndex = -1;
+
+    return context;
+#else
+    return sws_getCachedContext(context, srcWidth, srcHeight, srcFormat, dstWidth, dstHeight, dstFormat, flags, nullptr, nullptr, nullptr);
+#endif
+}
+
+/*************/
+bool Image_FFmpeg::convertFrame(struct SwsContext* context, const AVFrame* source, AVFrame* destination)
+{
+#if LIBSWSCALE_VERSION_INT >= AV_VERSION_INT(6, 1, 100)
+    return sws_scale_frame(context, destination, source) >= 0;
+#else
+    return sws_scale(context, (const uint8_t* const*)source->data, source->linesize, 0, source->height, destination->data, destination->linesize) > 0;
+#endif
+}
+
+/*************/
+AVPixelFormat Image_FFmpeg::getOutputFormat(AVPixelFormat format)
+{
+    if (isPlanarFormat(format))
+        return format;
+
+    auto desc = av_pix_fmt_desc_get(format);
+    if (!desc || desc->comp[0].depth <= 8 || (desc->flags & AV_PIX_FMT_FLAG_HWACCEL))
+        return AV_PIX_FMT_YUYV422;
+
+    // Subsampled chroma fits in P010, full resolution chroma would be lost by it
+    if (!(desc->flags & AV_PIX_FMT_FLAG_RGB) && desc->log2_chroma_w > 0)
+        return AV_PIX_FMT_P010LE;
+#if LIBAVUTIL_VERSION_INT >= AV_VERSION_INT(56, 55, 100)
+    return AV_PIX_FMT_X2RGB10LE;
+#else
+    return AV_PIX_FMT_P010LE;
 #endif
 }
 
+/*************/
+unique_ptr<ImageBuffer> Image_FFmpeg::copyPlanarFrame(const AVFrame* frame, int width, int height)
+{
+    auto format = static_cast<AVPixelFormat>(frame->format);
+    if (!isPlanarFormat(format))
+        return {nullptr};
+
+    // Chroma is subsampled by 2 in both directions
+    if (width % 2 != 0 || height % 2 != 0)
+        return {nullptr};
+
+    unique_ptr<ImageBuffer> img;
+    // Each plane is given as its row size, its row count and the index of the source plane
+    vector<tuple<int, int, int>> planes;
+    if (format == AV_PIX_FMT_NV12)
+    {
+        img = _framePool.acquire(ImageBufferSpec(width, height, 3, 12, ImageBufferSpec::Type::UINT8, "NV12"));
+        planes = {{width, height, 0}, {width, height / 2, 1}};
+    }
+    else if (format == AV_PIX_FMT_P010LE)
+    {
+        img = _framePool.acquire(ImageBufferSpec(width, height, 3, 24, ImageBufferSpec::Type::UINT16, "P010"));
+        planes = {{width * 2, height, 0}, {width * 2, height / 2, 1}};
+    }
+    else
+    {
+        img = _framePool.acquire(ImageBufferSpec(width, height, 3, 12, ImageBufferSpec::Type::UINT8, "I420"));
+        planes = {{width, height, 0}, {width / 2, height / 2, 1}, {width / 2, height / 2, 2}};
+    }
+
+    // Planes are copied one after the other, removing the line padding
+    auto pixels = img->data();
+    for (const auto& [rowSize, rowCount, planeIndex] : planes)
+    {
+        for (int y = 0; y < rowCount; ++y)
+            memcpy(pixels + y * rowSize, frame->data[planeIndex] + y * frame->linesize[planeIndex], rowSize);
+        pixels += rowSize * rowCount;
+    }
+
+    return img;
+}
+
 #if HAVE_PORTAUDIO
 /*************/
 void Image_FFmpeg::audioLoop()
 {
     while (_continueRead)
     {
+        if (!Utils::applyThreadClass(Utils::ThreadClass::audio))
+            Log::get() << Log::WARNING << "Image_FFmpeg::" << __FUNCTION__ << " - Unable to apply the scheduling of the audio threads" << Log::endl;
+
         auto localQueue = deque<TimedAudioFrame>();
         {
-            lock_guard<mutex> lockAudio(_audioMutex);
+            unique_lock<mutex> lockAudio(_audioMutex);
+            _audioCondition.wait(lockAudio, [&]() { return !_continueRead || !_audioQueue.empty(); });
             std::swap(localQueue, _audioQueue);
         }
 
-        if (localQueue.empty())
-            this_thread::sleep_for(chrono::milliseconds(10));
-
         while (!localQueue.empty() && _continueRead && _speaker)
         {
             auto currentTime = Timer::getTime() - _startTime;
@@ -579,31 +1709,63 @@ void Image_FFmpeg::audioLoop()
                 continue;
             }
 
-            while (localQueue[0].timing - currentTime > 100000)
+            // Frames are sent ahead of time, the wait being interrupted by seeks as they change _startTime
+            while (_continueRead && localQueue[0].timing - currentTime > 100000)
             {
-                this_thread::sleep_for(chrono::milliseconds(5));
+                unique_lock<mutex> lockAudio(_audioMutex);
+                _audioCondition.wait_for(lockAudio, chrono::microseconds(localQueue[0].timing - currentTime - 100000));
                 currentTime = Timer::getTime() - _startTime;
             }
 
-            _speaker->addToQueue(localQueue[0].frame);
+            if (_speaker->addToQueue(localQueue[0].frame))
+                _audioQueueEnd = localQueue[0].timing + localQueue[0].duration;
 
             localQueue.pop_front();
         }
     }
 }
+
+/*************/
+bool Image_FFmpeg::getAudioClock(int64_t& time) const
+{
+    auto queueEnd = _audioQueueEnd.load();
+    if (!_speaker || !*_speaker || queueEnd < 0 || Timer::getTime() < _audioClockResumeTime)
+        return false;
+
+    // Once the sound is over or starving, the video is left running on its own
+    auto queueDuration = _speaker->getQueueDuration();
+    if (queueDuration <= 0)
+        return false;
+
+    time = queueEnd - queueDuration;
+    return true;
+}
+#else
+/*************/
+bool Image_FFmpeg::getAudioClock(int64_t& /*time*/) const
+{
+    return false;
+}
 #endif
 
 /*************/
 void Image_FFmpeg::seek(float seconds, bool clearQueues)
 {
-    if (!_avContext)
+    if (!_avContext || _live)
         return;
 
     lock_guard<mutex> lock(_videoSeekMutex);
-
-    int seekFlag = 0;
-    if (_elapsedTime > seconds)
-        seekFlag = AVSEEK_FLAG_BACKWARD;
+    lock_guard<mutex> lockDemux(_demuxMutex);
+    OnScopeExit
+    {
+        // Wake up the read loop if it reached the end of the file, and the display and audio loops waiting for a frame timing
+        _seekedSinceEnd = true;
+        _readCondition.notify_all();
+        _videoQueueCondition.notify_all();
+#if HAVE_PORTAUDIO
+        _audioCondition.notify_all();
+#endif
+    };
 
     // Prevent seeking outside of the file
     float duration = getMediaDuration();
@@ -612,8 +1774,31 @@ void Image_FFmpeg::seek(float seconds, bool clearQueues)
     else if (seconds > duration)
         seconds = duration;
 
-    int frame = static_cast<int>(floor(seconds / _videoTimeBase));
-    if (avformat_seek_file(_avContext, _videoStreamIndex, 0, frame, frame, seekFlag) < 0)
+    // If the target is a prefetched cue, its frames are shown right away and decoding resumes after them
+    auto target = static_cast<int64_t>(seconds * 1e6);
+    deque<TimedFrame> cueFrames;
+    {
+        lock_guard<mutex> lockCue(_cueMutex);
+        for (auto& cachedEntry : _cueCache)
+        {
+            if (abs(cachedEntry.first - target) > SPLASH_FFMPEG_SEEK_TOLERANCE)
+                continue;
+
+            cachedEntry.second.lastUse = ++_cueUseCounter;
+            for (const auto& cachedFrame : cachedEntry.second.frames)
+                cueFrames.push_back({make_unique<ImageBuffer>(*cachedFrame.frame), cachedFrame.timing});
+            break;
+        }
+    }
+    auto resumeTime = cueFrames.empty() ? target : static_cast<int64_t>(cueFrames.back().timing) + 2 * SPLASH_FFMPEG_SEEK_TOLERANCE;
+
+    // Decoding has to start from the keyframe preceding the target
+    auto timestamp = static_cast<int64_t>(static_cast<double>(resumeTime) / 1e6 / _videoTimeBase);
+    auto keyframe = getPreviousKeyframe(timestamp);
+    if (keyframe >= 0)
+        timestamp = keyframe;
+
+    if (avformat_seek_file(_avContext, _videoStreamIndex, INT64_MIN, timestamp, timestamp, AVSEEK_FLAG_BACKWARD) < 0)
     {
         Log::get() << Log::WARNING << "Image_FFmpeg::" << __FUNCTION__ << " - Could not seek to timestamp " << seconds << Log::endl;
     }
@@ -623,6 +1808,11 @@ void Image_FFmpeg::seek(float seconds, bool clearQueues)
         // As seeking will no necessarily go to the desired timestamp, but to the closest i-frame,
         // we will set _startTime at the next frame in the videoDisplayLoop
         _startTime = -1;
+        _skipFramesBefore = resumeTime;
+        _flushDecoder = true;
+
+        // Packets read ahead are from before the seek, and the demux thread resumes if it reached the end of the file
+        clearPacketQueue();
 
         if (clearQueues)
         {
@@ -632,7 +1822,226 @@ void Image_FFmpeg::seek(float seconds, bool clearQueues)
                 _speaker->clearQueue();
 #endif
         }
+
+#if HAVE_PORTAUDIO
+        // The audio clock is only valid again once the sound from before the seek has been played
+        _audioQueueEnd = -1;
+        _audioClockResumeTime = Timer::getTime() + (_speaker ? _speaker->getQueueDuration() : 0);
+#endif
+
+        for (auto& cueFrame : cueFrames)
+            pushTimedFrame(std::move(cueFrame));
+    }
+}
+
+/*************/
+void Image_FFmpeg::scrubLoop(VideoDecoder& decoder)
+{
+    Log::get() << Log::MESSAGE << "Image_FFmpeg::" << __FUNCTION__ << " - Scrubbing file " << _filepath << Log::endl;
+    _scrubbing = true;
+
+    const auto frameTime = [&](size_t index) { return static_cast<int64_t>(static_cast<double>(_keyframes[index]) * _videoTimeBase * 1e6); };
+    const auto duration = static_cast<int64_t>(getMediaDuration() * 1e6);
+    const auto maximumCacheSize = _maximumBufferSize / SPLASH_FFMPEG_SCRUB_CACHE_RATIO;
+
+    int64_t position = _elapsedTime;
+    size_t shownIndex = numeric_limits<size_t>::max();
+    size_t nextReadIndex = numeric_limits<size_t>::max();
+    auto lastTime = Timer::getTime();
+    while (_continueRead && _scrub)
+    {
+        {
+            // Nothing is decoded while no camera samples the image
+            unique_lock<mutex> lockSeek(_videoSeekMutex);
+            _readCondition.wait(lockSeek, [&]() { return !_continueRead || !_suspended; });
+        }
+
+        // The position follows the playback speed, or jumps to the requested target
+        const auto now = Timer::getTime();
+        const auto speed = _paused ? 0.f : _speed.load();
+        position += static_cast<int64_t>(static_cast<float>(now - lastTime) * speed);
+        lastTime = now;
+        if (auto target = _scrubTarget.exchange(-1); target >= 0)
+            position = target;
+        if (duration > 0)
+            position = _loopOnVideo ? (position % duration + duration) % duration : std::clamp<int64_t>(position, 0, duration);
+
+        auto frameIt = upper_bound(_keyframes.begin(), _keyframes.end(), static_cast<int64_t>(static_cast<double>(position) / 1e6 / _videoTimeBase));
+        auto index = static_cast<size_t>(frameIt == _keyframes.begin() ? 0 : distance(_keyframes.begin(), frameIt) - 1);
+
+        if (index != shownIndex)
+        {
+            TimedFrame timedFrame;
+            auto packet = getScrubPacket(index, nextReadIndex);
+            bool hasFrame = packet && decodeVideoPacket(decoder, packet, timedFrame);
+
+            // Codecs decoded by FFmpeg can hold the frame back, even when intra only
+            if (packet && !hasFrame && !decoder.isHap)
+            {
+                AVPacket drainPacket;
+                av_init_packet(&drainPacket);
+                drainPacket.data = nullptr;
+                drainPacket.size = 0;
+                hasFrame = decodeVideoPacket(decoder, &drainPacket, timedFrame);
+                avcodec_flush_buffers(decoder.codecContext);
+            }
+
+            if (hasFrame)
+            {
+                timedFrame.timing = frameTime(index);
+                {
+                    lock_guard<mutex> lockSeek(_videoSeekMutex);
+                    _timedFrames.clear();
+                    pushTimedFrame(std::move(timedFrame));
+                }
+                notifyVideoQueue();
+                shownIndex = index;
+            }
+
+            // Least recently used packets are evicted, keeping the one just shown
+            while (_scrubCacheSize > maximumCacheSize && _scrubCache.size() > 1)
+            {
+                auto oldestIt = min_element(_scrubCache.begin(), _scrubCache.end(), [](const auto& a, const auto& b) { return a.second.lastUse < b.second.lastUse; });
+                _scrubCacheSize -= oldestIt->second.packet->size;
+                av_packet_free(&oldestIt->second.packet);
+                _scrubCache.erase(oldestIt);
+            }
+        }
+
+        // Wait until the next frame is due in the playback direction, or for a new target
+        int64_t waitTime = SPLASH_FFMPEG_SCRUB_POLL_PERIOD;
+        if (speed > 0.f && index + 1 < _keyframes.size())
+            waitTime = static_cast<int64_t>(static_cast<float>(frameTime(index + 1) - position) / speed);
+        else if (speed < 0.f)
+            waitTime = static_cast<int64_t>(static_cast<float>(position - frameTime(index) + 1) / -speed);
+        waitTime = std::clamp<int64_t>(waitTime, 1000, SPLASH_FFMPEG_SCRUB_POLL_PERIOD);
+
+        unique_lock<mutex> lockSeek(_videoSeekMutex);
+        _readCondition.wait_for(lockSeek, chrono::microseconds(waitTime), [&]() { return !_continueRead || !_scrub || _scrubTarget >= 0; });
+    }
+
+    _scrubbing = false;
+    Log::get() << Log::MESSAGE << "Image_FFmpeg::" << __FUNCTION__ << " - Stopped scrubbing file " << _filepath << Log::endl;
+
+    // Sequential reading resumes from the scrub position
+    if (_continueRead)
+        seek(static_cast<float>(position) / 1e6f);
+}
+
+/*************/
+AVPacket* Image_FFmpeg::getScrubPacket(size_t index, size_t& nextReadIndex)
+{
+    if (auto cachedIt = _scrubCache.find(index); cachedIt != _scrubCache.end())
+    {
+        cachedIt->second.lastUse = ++_scrubUseCounter;
+        return cachedIt->second.packet;
+    }
+
+    lock_guard<mutex> lockSeek(_videoSeekMutex);
+    lock_guard<mutex> lockDemux(_demuxMutex);
+
+    // Frames read in order do not need a seek
+    if (index != nextReadIndex && av_seek_frame(_avContext, _videoStreamIndex, _keyframes[index], AVSEEK_FLAG_BACKWARD) < 0)
+    {
+        Log::get() << Log::WARNING << "Image_FFmpeg::" << __FUNCTION__ << " - Could not seek to frame " << index << " in file " << _filepath << Log::endl;
+        nextReadIndex = numeric_limits<size_t>::max();
+        return nullptr;
+    }
+
+    auto packet = av_packet_alloc();
+    while (true)
+    {
+        if (av_read_frame(_avContext, packet) < 0)
+        {
+            av_packet_free(&packet);
+            nextReadIndex = numeric_limits<size_t>::max();
+            return nullptr;
+        }
+        if (packet->stream_index == _videoStreamIndex)
+            break;
+        av_packet_unref(packet);
+    }
+
+    // The seek can land on a neighbouring frame, the packet is cached as the one it really is
+    auto timestamp = packet->dts != AV_NOPTS_VALUE ? packet->dts : packet->pts;
+    if (auto frameIt = lower_bound(_keyframes.begin(), _keyframes.end(), timestamp); frameIt != _keyframes.end() && *frameIt == timestamp)
+        index = static_cast<size_t>(distance(_keyframes.begin(), frameIt));
+    nextReadIndex = index + 1;
+
+    auto& cachedPacket = _scrubCache[index];
+    if (cachedPacket.packet)
+    {
+        _scrubCacheSize -= cachedPacket.packet->size;
+        av_packet_free(&cachedPacket.packet);
+    }
+    cachedPacket.packet = packet;
+    cachedPacket.lastUse = ++_scrubUseCounter;
+    _scrubCacheSize += packet->size;
+    return packet;
+}
+
+/*************/
+void Image_FFmpeg::clearScrubCache()
+{
+    for (auto& [index, cachedPacket] : _scrubCache)
+        av_packet_free(&cachedPacket.packet);
+    _scrubCache.clear();
+    _scrubCacheSize = 0;
+}
+
+/*************/
+void Image_FFmpeg::signalCuesUpdated()
+{
+    {
+        lock_guard<mutex> lock(_cueMutex);
+        _cuesUpdated = true;
+    }
+    _cueCondition.notify_all();
+}
+
+/*************/
+void Image_FFmpeg::notifyLoops()
+{
+    {
+        lock_guard<mutex> lock(_videoSeekMutex);
+        _readCondition.notify_all();
+    }
+    {
+        lock_guard<mutex> lock(_packetQueueMutex);
+        _packetQueueCondition.notify_all();
+    }
+    {
+        lock_guard<mutex> lock(_videoQueueMutex);
+        _videoQueueCondition.notify_all();
+    }
+#if HAVE_PORTAUDIO
+    {
+        lock_guard<mutex> lock(_audioMutex);
+        _audioCondition.notify_all();
     }
+#endif
+}
+
+/*************/
+void Image_FFmpeg::pushTimedFrame(TimedFrame&& timedFrame)
+{
+    const auto frameSize = timedFrame.frame->getSize();
+    _timedFramesSize += frameSize;
+    if (_timedFrames.push(std::move(timedFrame)))
+        return;
+
+    // The display loop did not catch up, which only happens if frames were pushed after a seek
+    _timedFramesSize -= frameSize;
+    _framePool.release(std::move(timedFrame.frame));
+    Log::get() << Log::DEBUGGING << "Image_FFmpeg::" << __FUNCTION__ << " - Frame queue is full, dropping a frame" << Log::endl;
+}
+
+/*************/
+void Image_FFmpeg::notifyVideoQueue()
+{
+    // Notifying under the lock, so that a loop checking the queue right before waiting does not miss it
+    lock_guard<mutex> lock(_videoQueueMutex);
+    _videoQueueCondition.notify_all();
 }
 
 /*************/
@@ -647,32 +2056,82 @@ void Image_FFmpeg::seek_async(float seconds, bool clearQueues)
 /*************/
 void Image_FFmpeg::videoDisplayLoop()
 {
+    TraceRecorder::get().setThreadName(_name + " display");
+
     while (_continueRead)
     {
+        if (!Utils::applyThreadClass(Utils::ThreadClass::render))
+            Log::get() << Log::WARNING << "Image_FFmpeg::" << __FUNCTION__ << " - Unable to apply the scheduling of the render threads" << Log::endl;
+
         auto localQueue = deque<TimedFrame>();
-        if (!_timedFrames.empty())
+
+        // Frames which are dropped, or replaced once shown, go back to the pool to be reused by the decoder
+        const auto recycleFront = [&]() {
+            _framePool.release(std::move(localQueue.front().frame));
+            localQueue.pop_front();
+        };
+        const auto recycleAll = [&]() {
+            while (!localQueue.empty())
+                recycleFront();
+        };
         {
-            lock_guard<mutex> lockFrames(_videoQueueMutex);
-            std::swap(localQueue, _timedFrames);
-            _framesSize.clear();
+            unique_lock<mutex> lockFrames(_videoQueueMutex);
+            _videoQueueCondition.wait(lockFrames, [&]() { return !_continueRead || !_timedFrames.empty(); });
         }
-        else
+
+        // Frames are moved out of the ring without locking, those dropped by a seek going back to the pool
+        const auto dropFrame = [&](TimedFrame& timedFrame) {
+            _timedFramesSize -= timedFrame.frame->getSize();
+            _framePool.release(std::move(timedFrame.frame));
+        };
+        TimedFrame poppedFrame;
+        while (_timedFrames.pop(poppedFrame, dropFrame))
         {
-            this_thread::sleep_for(chrono::milliseconds(1));
-            continue;
+            _timedFramesSize -= poppedFrame.frame->getSize();
+            localQueue.push_back(std::move(poppedFrame));
         }
+        // The read loop may be waiting for the queue to be consumed
+        notifyVideoQueue();
 
         // This sets the start time after a seek
         if (!localQueue.empty() && _startTime == -1)
             _startTime = Timer::getTime() - localQueue[0].timing;
 
+        // Show the given frame right away
+        const auto showFrame = [&](TimedFrame& timedFrame) {
+            _elapsedTime = timedFrame.timing;
+
+            int64_t frameTimestamp{0};
+            {
+                lock_guard<shared_mutex> lock(_writeMutex);
+                if (!_bufferImage)
+                    _bufferImage = make_unique<ImageBuffer>();
+                std::swap(_bufferImage, timedFrame.frame);
+                frameTimestamp = _bufferImage->getSpec().timestamp;
+                _imageUpdated = true;
+            }
+
+            // The back buffer can be published by the main loop as soon as the lock is released
+            updateTimestamp(frameTimestamp);
+            if (!_isConnectedToRemote)
+                update();
+        };
+
         lock_guard<mutex> lockEnd(_videoEndMutex);
         while (!localQueue.empty() && _continueRead)
         {
+            // Live and scrubbed frames are shown as soon as they are decoded, only the latest one being kept
+            if (_live || _scrubbing)
+            {
+                showFrame(localQueue.back());
+                recycleAll();
+                continue;
+            }
+
             // If seek, clear the local queue as the frames should not be shown
             if (_startTime == -1)
             {
-                localQueue.clear();
+                recycleAll();
                 continue;
             }
 
@@ -697,7 +2156,9 @@ void Image_FFmpeg::videoDisplayLoop()
                 if (_paused || (clockIsPaused && useClock))
                 {
                     _startTime = Timer::getTime() - _currentTime;
-                    this_thread::sleep_for(chrono::milliseconds(2));
+                    // The pause attribute signals when it changes, but the master clock has to be checked periodically
+                    unique_lock<mutex> lockFrames(_videoQueueMutex);
+                    _videoQueueCondition.wait_for(lockFrames, chrono::milliseconds(2), [&]() { return !_continueRead || (!_paused && !useClock); });
                     continue;
                 }
                 else if (useClock && _clockTime != -1l)
@@ -714,6 +2175,18 @@ void Image_FFmpeg::videoDisplayLoop()
                 else
                 {
                     _currentTime = Timer::getTime() - _startTime;
+
+                    // Slew the local clock towards the audio clock, which is too jittery to be followed directly
+                    int64_t audioTime = 0;
+                    if (_syncToAudio && getAudioClock(audioTime))
+                    {
+                        auto delta = audioTime - _currentTime;
+                        if (abs(delta) > SPLASH_FFMPEG_AUDIO_SYNC_TOLERANCE)
+                        {
+                            _startTime -= delta / SPLASH_FFMPEG_AUDIO_SYNC_SLEW;
+                            _currentTime += delta / SPLASH_FFMPEG_AUDIO_SYNC_SLEW;
+                        }
+                    }
                 }
 
                 // If the frame is beyond the trimming end, seek to the trimming start
@@ -722,7 +2195,7 @@ void Image_FFmpeg::videoDisplayLoop()
                     if (timedFrame.timing < _trimStart)
                     {
                         auto expectedValue = false;
-                        localQueue.clear();
+                        recycleAll();
                         if (_timeJump.compare_exchange_strong(expectedValue, true, std::memory_order_acquire))
                             seek_async(static_cast<float>(_trimStart) / 1e6);
                         continue;
@@ -730,7 +2203,7 @@ void Image_FFmpeg::videoDisplayLoop()
                     else if (timedFrame.timing > _trimEnd)
                     {
                         auto expectedValue = false;
-                        localQueue.clear();
+                        recycleAll();
                         if (_timeJump.compare_exchange_strong(expectedValue, true, std::memory_order_acquire))
                             seek_async(getMediaDuration());
                         continue;
@@ -747,33 +2220,33 @@ void Image_FFmpeg::videoDisplayLoop()
                     if (_timeJump.compare_exchange_strong(expectedValue, true, std::memory_order_acquire))
                     {
                         _elapsedTime = _currentTime / 1e6;
-                        localQueue.clear();
+                        recycleAll();
                         seek_async(_elapsedTime);
                     }
 
                     continue;
                 }
 
+                // When following the audio, late frames are dropped as long as the next one is due too
+                if (waitTime < 0 && _syncToAudio && localQueue.size() > 1 && static_cast<int64_t>(localQueue[1].timing) <= _currentTime)
+                {
+                    recycleFront();
+                    continue;
+                }
+
                 // Wait for the right time to display the frame
+                // A seek sets _startTime to -1 and interrupts the wait, the frame being dropped
                 if (waitTime > 0)
-                    this_thread::sleep_for(chrono::microseconds(waitTime));
-
-                _elapsedTime = timedFrame.timing;
-
                 {
-                    lock_guard<shared_mutex> lock(_writeMutex);
-                    if (!_bufferImage)
-                        _bufferImage = make_unique<ImageBuffer>();
-                    std::swap(_bufferImage, timedFrame.frame);
-                    _imageUpdated = true;
+                    unique_lock<mutex> lockFrames(_videoQueueMutex);
+                    if (_videoQueueCondition.wait_for(lockFrames, chrono::microseconds(waitTime), [&]() { return !_continueRead || _startTime == -1; }))
+                        continue;
                 }
 
-                updateTimestamp(_bufferImage->getSpec().timestamp);
-                if (!_isConnectedToRemote)
-                    update();
+                showFrame(timedFrame);
             }
 
-            localQueue.pop_front();
+            recycleFront();
         }
     }
 }
@@ -790,10 +2263,28 @@ void Image_FFmpeg::registerAttributes()
 {
     Image::registerAttributes();
 
+    addAttribute("hwaccel",
+        [&](const Values& args) {
+            auto hwaccel = args[0].as<string>();
+            if (hwaccel == _hwaccel)
+                return true;
+            _hwaccel = hwaccel;
+
+            // The decoder is set up when opening the file, so it has to be opened again
+            if (_filepath.empty())
+                return true;
+            return read(_filepath);
+        },
+        [&]() -> Values { return {_hwaccel}; },
+        {'s'});
+    setAttributeDescription("hwaccel",
+        "Hardware decoding API to use, for example vaapi, cuda (for NVDEC) or vdpau. Set to auto to use the first available one, or none to decode on the CPU");
+
     addAttribute("bufferSize",
         [&](const Values& args) {
             int64_t sizeMB = max(16, args[0].as<int>());
             _maximumBufferSize = sizeMB * (int64_t)1048576;
+            _framePool.setMaximumSize(_maximumBufferSize / SPLASH_FFMPEG_FRAME_POOL_RATIO);
             return true;
         },
         [&]() -> Values { return {_maximumBufferSize / (int64_t)1048576}; },
@@ -803,7 +2294,7 @@ void Image_FFmpeg::registerAttributes()
     addAttribute("duration",
         [&](const Values&) { return false; },
         [&]() -> Values {
-            if (_avContext == nullptr)
+            if (_avContext == nullptr && !isFollowing())
                 return {0.f};
 
             return {getMediaDuration()};
@@ -819,11 +2310,36 @@ void Image_FFmpeg::registerAttributes()
         [&]() -> Values { return {_audioDeviceOutput}; },
         {'s'});
     setAttributeDescription("audioDeviceOutput", "Name of the audio device to send the audio to (i.e. Jack writable client)");
+
+    addAttribute("audioOutputChannel",
+        [&](const Values& args) {
+            _audioOutputChannel = std::max(-1, args[0].as<int>());
+            _audioDeviceOutputUpdated = true;
+            return true;
+        },
+        [&]() -> Values { return {_audioOutputChannel}; },
+        {'i'});
+    setAttributeDescription("audioOutputChannel",
+        "If positive, mix the audio into the channels of the output device starting at this one, sharing a single stream with the other media. If -1, open a dedicated stream");
+
+    addAttribute("syncToAudio",
+        [&](const Values& args) {
+            _syncToAudio = args[0].as<bool>();
+            return true;
+        },
+        [&]() -> Values { return {_syncToAudio}; },
+        {'b'});
+    setAttributeDescription("syncToAudio", "If true, the video follows the audio being played, dropping or holding frames as needed. The master clock has priority when useClock is set");
 #endif
 
     addAttribute("loop",
         [&](const Values& args) {
-            _loopOnVideo = args[0].as<bool>();
+            {
+                lock_guard<mutex> lock(_videoSeekMutex);
+                _loopOnVideo = args[0].as<bool>();
+            }
+            _readCondition.notify_all();
+            signalCuesUpdated();
             return true;
         },
         [&]() -> Values {
@@ -834,7 +2350,7 @@ void Image_FFmpeg::registerAttributes()
     addAttribute("elapsed",
         [&](const Values&) { return false; },
         [&]() -> Values {
-            if (_avContext == nullptr)
+            if (_avContext == nullptr && !isFollowing())
                 return {0.f};
 
             float duration = std::max(0.f, static_cast<float>(_elapsedTime) / 1e6f);
@@ -844,7 +2360,11 @@ void Image_FFmpeg::registerAttributes()
 
     addAttribute("pause",
         [&](const Values& args) {
-            _paused = args[0].as<bool>();
+            {
+                lock_guard<mutex> lock(_videoQueueMutex);
+                _paused = args[0].as<bool>();
+            }
+            _videoQueueCondition.notify_all();
             return true;
         },
         [&]() -> Values { return {_paused}; },
@@ -853,6 +2373,22 @@ void Image_FFmpeg::registerAttributes()
     addAttribute("seek",
         [&](const Values& args) {
             float seconds = args[0].as<float>();
+
+            // While scrubbing, the position is changed without going through the sequential seek
+            if (_scrubbing)
+            {
+                _scrubTarget = static_cast<int64_t>(std::max(0.f, seconds) * 1e6);
+                notifyLoops();
+                _seekTime = seconds;
+                return true;
+            }
+
+            {
+                // While following, the seek is only checked against the leader time
+                lock_guard<mutex> lockShared(_sharedDecodersMutex);
+                if (_leader)
+                    _pendingSeekTime = static_cast<int64_t>(seconds * 1e6);
+            }
             seek_async(seconds);
             _seekTime = seconds;
             return true;
@@ -861,6 +2397,28 @@ void Image_FFmpeg::registerAttributes()
         {'r'});
     setAttributeDescription("seek", "Change the read position in the video file");
 
+    addAttribute("cues",
+        [&](const Values& args) {
+            {
+                lock_guard<mutex> lock(_cueMutex);
+                _cues.clear();
+                for (const auto& arg : args)
+                    _cues.push_back(static_cast<int64_t>(arg.as<double>() * 1e6));
+            }
+            signalCuesUpdated();
+            return true;
+        },
+        [&]() -> Values {
+            lock_guard<mutex> lock(_cueMutex);
+            Values cues;
+            for (const auto cue : _cues)
+                cues.push_back(static_cast<double>(cue) / 1e6);
+            return cues;
+        },
+        {});
+    setAttributeDescription("cues",
+        "Times (in seconds) the video is expected to be seeked to. The first frames after each cue are decoded in advance, so that seeking to them is immediate");
+
     addAttribute("trim",
         [&](const Values& args) {
             auto start = args[0].as<double>();
@@ -878,6 +2436,7 @@ void Image_FFmpeg::registerAttributes()
 
             _trimStart = static_cast<int64_t>(start * 1e6);
             _trimEnd = static_cast<int64_t>(end * 1e6);
+            signalCuesUpdated();
 
             return true;
         },
@@ -908,6 +2467,87 @@ void Image_FFmpeg::registerAttributes()
         [&]() -> Values { return {_videoFormat}; },
         {'s'});
 
+    addAttribute(
+        "shareDecoder",
+        [&](const Values& args) {
+            _shareDecoder = args[0].as<bool>();
+            return true;
+        },
+        [&]() -> Values { return {_shareDecoder}; },
+        {'b'});
+    setAttributeDescription("shareDecoder",
+        "If true and another object plays the same media with the same options, its decoded frames are shown instead of decoding the media again. Applied when opening the "
+        "media");
+
+    addAttribute(
+        "downscale",
+        [&](const Values& args) {
+            _downscale = args[0].as<bool>();
+            return true;
+        },
+        [&]() -> Values { return {_downscale.load()}; },
+        {'b'});
+    setAttributeDescription("downscale",
+        "If true, the decoded frames are downscaled by up to 8 when the cameras sample them at a lower resolution. Hap frames are always kept at their original resolution");
+
+    addAttribute(
+        "live",
+        [&](const Values& args) {
+            auto live = args[0].as<bool>();
+            if (live == _live)
+                return true;
+            _live = live;
+
+            // Lost streams are opened again from the main loop
+            if (_live)
+                addPeriodicTask(
+                    "liveReconnect",
+                    [&]() {
+                        auto reconnectTime = _reconnectTime.load();
+                        if (reconnectTime < 0 || Timer::getTime() < reconnectTime)
+                            return;
+                        _reconnectTime = -1;
+                        read(_filepath);
+                    },
+                    100);
+            else
+                removePeriodicTask("liveReconnect");
+
+            // The stream is opened with different options
+            if (_filepath.empty())
+                return true;
+            return read(_filepath);
+        },
+        [&]() -> Values { return {_live.load()}; },
+        {'b'});
+    setAttributeDescription("live",
+        "If true, the media is read as a live network stream (RTSP, SRT, UDP...): there is no buffering nor seeking, only the latest decoded frame is shown and the "
+        "stream is opened again when lost");
+
+    addAttribute(
+        "scrub",
+        [&](const Values& args) {
+            _scrub = args[0].as<bool>();
+            notifyLoops();
+            return true;
+        },
+        [&]() -> Values { return {_scrub.load()}; },
+        {'b'});
+    setAttributeDescription("scrub",
+        "If true and the media is intra only (Hap, ProRes, MJPEG...), frames are decoded in any order from a cache of compressed packets, following the speed "
+        "attribute and jumping instantly to the seek position");
+
+    addAttribute(
+        "speed",
+        [&](const Values& args) {
+            _speed = args[0].as<float>();
+            notifyLoops();
+            return true;
+        },
+        [&]() -> Values { return {_speed.load()}; },
+        {'r'});
+    setAttributeDescription("speed", "Playback speed while scrubbing, negative to play backwards");
+
     addAttribute("timeShift",
         [&](const Values& args) {
             _shiftTime = args[0].as<float>();
@@ -27,25 +27,34 @@
 
 #include "./core/constants.h"
 
+#include <array>
 #include <atomic>
 #include <condition_variable>
 #include <deque>
 #include <future>
+#include <map>
+#include <memory>
 #include <mutex>
+#include <string>
 #include <thread>
+#include <vector>
 
 extern "C" {
 #include <libavcodec/avcodec.h>
 #include <libavformat/avformat.h>
 #include <libavutil/avutil.h>
+#include <libavutil/hwcontext.h>
 #include <libavutil/imgutils.h>
+#include <libavutil/pixdesc.h>
 #include <libswscale/swscale.h>
 }
 
 #include "./core/constants.h"
 
 #include "./core/attribute.h"
+#include "./core/imagebuffer_pool.h"
 #include "./image/image.h"
+#include "./utils/spsc_ring.h"
 #if HAVE_PORTAUDIO
 #include "./sound/speaker.h"
 #endif
@@ -80,28 +89,157 @@ class Image_FFmpeg : public Image
      */
     bool read(const std::string& filename) final;
 
+    /**
+     * Get the memory held by the image, including the queued and cached decoded frames
+     * \return Return the memory usage
+     */
+    MemoryUsage getMemoryUsage() const final;
+
+    /**
+     * \brief Update the image, and show it on the objects sharing this decoder
+     */
+    void update() final;
+
+    /**
+     * \brief Suspend or resume decoding, the decoder of shared medias being suspended only once all objects showing it are
+     * \param suspended If true, the image is suspended
+     */
+    void setSuspended(bool suspended) final;
+
+    /**
+     * \brief Set the resolution at which the cameras sample the image, the frames being downscaled by powers of two down to it
+     * \param width Sampled width, 0 if the whole image resolution is needed
+     * \param height Sampled height, 0 if the whole image resolution is needed
+     */
+    void setSampledResolution(int width, int height) final;
+
   private:
+    //! Options which have to match for an object to show the frames decoded by another one
+    struct PlaybackOptions
+    {
+        std::string hwaccel{""};
+        bool loop{true};
+        bool paused{false};
+        bool useClock{false};
+        bool live{false};
+        bool scrub{false};
+        float speed{1.f};
+        float shiftTime{0.f};
+        uint64_t trimStart{0ull};
+        uint64_t trimEnd{0ull};
+
+        bool operator==(const PlaybackOptions& other) const
+        {
+            return hwaccel == other.hwaccel && loop == other.loop && paused == other.paused && useClock == other.useClock && live == other.live && scrub == other.scrub && speed == other.speed &&
+                   shiftTime == other.shiftTime &&
+                   trimStart == other.trimStart && trimEnd == other.trimEnd;
+        }
+        bool operator!=(const PlaybackOptions& other) const { return !(*this == other); }
+    };
+
+    // Decoders shared between the objects reading the same media, all protected by _sharedDecodersMutex
+    static std::mutex _sharedDecodersMutex;
+    static std::map<std::string, Image_FFmpeg*> _sharedDecoders; //!< Objects decoding a media which others can follow, by media path
+    bool _shareDecoder{true};                                    //!< If true, the decoder of another object reading the same media is used when possible
+    Image_FFmpeg* _leader{nullptr};                              //!< Object decoding the media for this one, if any
+    std::vector<Image_FFmpeg*> _followers{};                     //!< Objects showing the frames decoded by this one
+    std::shared_ptr<ImageBuffer> _sharedImage{nullptr};          //!< Last image shown on the followers
+    float _sharedDuration{0.f};                                  //!< Duration of the media decoded by the leader
+    std::atomic<int64_t> _pendingSeekTime{-1};                   //!< Seek requested while following, in us, until the leader reaches it
+    std::atomic<int64_t> _divergedSince{-1};                     //!< Time at which this follower started to diverge from its leader, in us
+    bool _suspendRequested{false};                               //!< Set if no camera samples this object
+    std::array<int, 2> _sampledResolution{0, 0};                 //!< Resolution at which the cameras sample this object, 0 if unknown
+
+    // Suspension of the decoding, protected by _videoSeekMutex
+    bool _suspended{false}; //!< If true, the read loop waits instead of decoding new frames
+
+    // Decode-time downscaling to the resolution the cameras sample the frames at
+    std::atomic_bool _downscale{true}; //!< If true, frames are downscaled to the sampled resolution
+    std::atomic_int _outputWidth{0};   //!< Width needed by this object and its followers, 0 for the whole resolution
+    std::atomic_int _outputHeight{0};  //!< Height needed by this object and its followers, 0 for the whole resolution
+
+    // Live mode, for network streams: no buffering nor seeking, only the latest frame is shown
+    std::atomic_bool _live{false};
+    std::atomic_bool _interruptIO{false};    //!< Set to abort the blocking reads from the network when closing the media
+    std::atomic<int64_t> _reconnectTime{-1}; //!< Time at which to open the stream again after losing it, in us, -1 if not needed
+    std::atomic<int64_t> _reconnectDelay{0}; //!< Delay before the next reconnection attempt, doubled after each failed one, in us
+
+    // Scrubbing of intra only medias, any frame being decoded from its packet alone
+    struct ScrubPacket
+    {
+        AVPacket* packet{nullptr};
+        uint64_t lastUse{0}; //!< Last use of this packet, to evict the least recently used ones
+    };
+    std::atomic_bool _scrub{false};              //!< If true, intra only medias are played from the scrub position instead of sequentially
+    std::atomic_bool _scrubbing{false};          //!< Set while the read loop scrubs
+    std::atomic<float> _speed{1.f};              //!< Playback speed while scrubbing, negative to play backwards
+    std::atomic<int64_t> _scrubTarget{-1};       //!< Position to jump to while scrubbing, in us, -1 if none
+    std::map<size_t, ScrubPacket> _scrubCache{}; //!< Compressed packets, by index in _keyframes, only used by the read loop
+    std::atomic<int64_t> _scrubCacheSize{0};     //!< Size of the cached packets, in bytes
+    uint64_t _scrubUseCounter{0};
+
     std::thread _readLoopThread;
     std::atomic_bool _continueRead{false};
     std::atomic_bool _loopOnVideo{true};
 
+    // Demuxing, run ahead of the decoding on its own thread. The queue is protected by _packetQueueMutex
+    std::thread _demuxThread{};
+    std::deque<AVPacket*> _packetQueue{};            //!< Compressed packets read from the file, waiting to be decoded
+    int64_t _packetQueueSize{0};                     //!< Size of the queued packets, in bytes
+    bool _demuxEnded{false};                         //!< Set when the end of the file is reached, until the next seek
+    std::atomic_bool _stopDemux{false};              //!< Set by the read loop to stop the demux thread
+    std::mutex _demuxMutex{};                        //!< Held while reading from or seeking in _avContext, locked after _videoSeekMutex
+    std::mutex _packetQueueMutex{};                  //!< Locked after _demuxMutex when both are needed
+    std::condition_variable _packetQueueCondition{}; //!< Signaled when packets are queued or consumed, used with _packetQueueMutex
+
+#if HAVE_LINUX
+    // Reading of local files through large blocks, with the next part of the file read ahead by the kernel
+    AVIOContext* _ioContext{nullptr};
+    int _ioFd{-1};
+    int64_t _ioFileSize{0};
+    int64_t _ioPosition{0};
+    int64_t _ioReadaheadEnd{0}; //!< End of the part of the file the kernel was asked to read ahead
+#endif
+
     std::thread _videoDisplayThread;
     struct TimedFrame
     {
         std::unique_ptr<ImageBuffer> frame{};
         uint64_t timing{0ull}; // in us
     };
-    std::deque<TimedFrame> _timedFrames;
-
-    // Frame size history, used to keep the frame buffer smaller than _maximumBufferSize
-    std::vector<int64_t> _framesSize{};
+    //! Decoded frames handed over to the display loop. Pushed by the read loop, the scrub loop and seek, which are serialized by _videoSeekMutex
+    SpscRing<TimedFrame> _timedFrames;
+    std::atomic<int64_t> _timedFramesSize{0}; //!< Size of the frames in _timedFrames, used to keep the frame buffer smaller than _maximumBufferSize
     int64_t _maximumBufferSize{(int64_t)1 << 29};
+    ImageBufferPool _framePool{}; //!< Frames dropped or replaced by the display loop, reused by the decoder
 
-    std::mutex _videoQueueMutex;
+    mutable std::mutex _videoQueueMutex;
     std::mutex _videoSeekMutex;
     std::mutex _videoEndMutex;
+    std::condition_variable _videoQueueCondition{}; //!< Signaled when the frame queue or the playback state changes, used with _videoQueueMutex which only guards the waits
+    std::condition_variable _readCondition{};       //!< Signaled on seek or loop change, to resume reading at the end of the file, used with _videoSeekMutex
+    bool _seekedSinceEnd{false};                    //!< Set by seek, so that the read loop resumes after reaching the end of the file
     std::future<void> _seekFuture;
 
+    std::vector<int64_t> _keyframes{};          //!< Timestamps of the keyframes of the video stream, in the stream time base
+    std::atomic<int64_t> _skipFramesBefore{-1}; //!< After a seek, decoded frames before this timing (in us) are not shown
+    std::atomic_bool _flushDecoder{false};      //!< Set after a seek, to drop the frames still held by the decoder
+
+    // Decoded frames for the cue points, so that seeking to them is immediate
+    struct CachedCue
+    {
+        std::deque<TimedFrame> frames{};
+        int64_t size{0};     //!< Size of the frames, in bytes
+        uint64_t lastUse{0}; //!< Last use of this cue, to evict the least recently used ones
+    };
+    std::thread _prefetchThread{};
+    std::vector<int64_t> _cues{};               //!< Cue times, in us
+    std::map<int64_t, CachedCue> _cueCache{};   //!< Cached frames, per cue time
+    uint64_t _cueUseCounter{0};
+    bool _cuesUpdated{false};
+    mutable std::mutex _cueMutex{};
+    std::condition_variable _cueCondition{};
+
     std::atomic_bool _timeJump{false};
 
     bool _intraOnly{false};
@@ -117,12 +255,17 @@ class Image_FFmpeg : public Image
     std::mutex _clockMutex;
     bool _useClock{false};
     int64_t _clockTime{-1};
+    bool _syncToAudio{false}; //!< If true, the video is synchronized to the audio clock
 
     AVFormatContext* _avContext{nullptr};
+    std::string _mediaPath{""}; //!< Full path to the file being read
     double _videoTimeBase{0.033};
     int _videoStreamIndex{-1};
     std::string _videoFormat{""}; //!< Holds the current video format information
 
+    std::string _hwaccel{"none"};                    //!< Hardware decoding API to use, or "none" / "auto"
+    AVPixelFormat _hwPixelFormat{AV_PIX_FMT_NONE}; //!< Pixel format of the hardware decoded frames, if hardware decoding is active
+
 #if HAVE_PORTAUDIO
     std::unique_ptr<Speaker> _speaker;
     int _audioStreamIndex{-1};
@@ -130,17 +273,42 @@ class Image_FFmpeg : public Image
     bool _planar{false};
     std::string _audioDeviceOutput{""};
     bool _audioDeviceOutputUpdated{false};
+    int _audioOutputChannel{-1}; //!< First device channel to route the sound to through the device mixer, -1 for a dedicated stream
+    std::atomic<int64_t> _audioQueueEnd{-1};       //!< Media time at the end of the last audio frame sent to the speaker, in us
+    std::atomic<int64_t> _audioClockResumeTime{0}; //!< Time after which the sound queued before the last seek has been played, in us
 
     std::thread _audioThread{};
     struct TimedAudioFrame
     {
         ResizableArray<uint8_t> frame{};
-        int64_t timing{0ull}; // in us
+        int64_t timing{0ull};  // in us
+        int64_t duration{0ll}; // in us
     };
     std::deque<TimedAudioFrame> _audioQueue{};
     std::mutex _audioMutex{};
+    std::condition_variable _audioCondition{}; //!< Signaled when audio frames are queued or when seeking
 #endif
 
+    //! Video decoding state, used by the read loop and by the cue prefetching
+    struct VideoDecoder
+    {
+        AVCodecContext* codecContext{nullptr};
+        AVFrame* frame{nullptr};
+        AVFrame* hwTransferFrame{nullptr};
+        AVFrame* convertedFrame{nullptr}; //!< Wraps the image buffer the packed frames are converted to
+        AVFrame* scaledFrame{nullptr};
+        struct SwsContext* swsContext{nullptr};   //!< Conversion of the frames to a packed format
+        struct SwsContext* scaleContext{nullptr}; //!< Downscaling of the planar frames, which keeps their format
+        double timeBase{0.033};
+        bool isHap{false};
+        bool useHardware{false};
+
+        VideoDecoder() = default;
+        VideoDecoder(const VideoDecoder&) = delete;
+        VideoDecoder& operator=(const VideoDecoder&) = delete;
+        ~VideoDecoder();
+    };
+
     /**
      * \brief Convert a codec tag to a fourcc
      * \param tag Tag to convert
@@ -148,6 +316,56 @@ class Image_FFmpeg : public Image
      */
     std::string tagToFourCC(unsigned int tag);
 
+    /**
+     * \brief Copy a decoded planar frame (NV12, P010 or I420) to an ImageBuffer, without converting it
+     * \param frame Decoded frame
+     * \param width Frame width
+     * \param height Frame height
+     * \return Return the image, or nullptr if the frame can not be copied as is
+     */
+    std::unique_ptr<ImageBuffer> copyPlanarFrame(const AVFrame* frame, int width, int height);
+
+    /**
+     * \brief Check whether frames of the given format are kept planar
+     * \param format Pixel format
+     * \return Return true if copyPlanarFrame supports the format
+     */
+    static bool isPlanarFormat(AVPixelFormat format);
+
+    /**
+     * \brief Get the format to output the frames decoded in the given format
+     * High bit depth frames are kept above 8 bits, as P010 when their chroma is subsampled
+     * and as packed 10 bit RGB otherwise, so as not to double the size of the frames
+     * \param format Decoded pixel format
+     * \return Return the output format, either a planar one, YUYV or packed 10 bit RGB
+     */
+    static AVPixelFormat getOutputFormat(AVPixelFormat format);
+
+    /**
+     * \brief Get a conversion context for the given parameters, reusing the given one if it matches them
+     * The conversion is sliced over multiple threads when swscale supports it
+     * \param context Previous context, freed if it does not match
+     * \param srcWidth Source width
+     * \param srcHeight Source height
+     * \param srcFormat Source pixel format
+     * \param dstWidth Destination width
+     * \param dstHeight Destination height
+     * \param dstFormat Destination pixel format
+     * \param flags Scaling flags
+     * \return Return the context, or nullptr if it could not be created
+     */
+    static struct SwsContext* getConversionContext(
+        struct SwsContext* context, int srcWidth, int srcHeight, AVPixelFormat srcFormat, int dstWidth, int dstHeight, AVPixelFormat dstFormat, int flags);
+
+    /**
+     * \brief Convert a whole frame with the given context
+     * \param context Conversion context
+     * \param source Source frame
+     * \param destination Destination frame, with its buffers allocated
+     * \return Return true if the frame was converted
+     */
+    static bool convertFrame(struct SwsContext* context, const AVFrame* source, AVFrame* destination);
+
     /**
      * \brief Free everything related to FFmpeg
      */
@@ -158,6 +376,68 @@ class Image_FFmpeg : public Image
      */
     float getMediaDuration() const;
 
+    /**
+     * \brief Get the options which have to match to share a decoder
+     * \return Return the playback options
+     */
+    PlaybackOptions getPlaybackOptions() const;
+
+    /**
+     * \brief Show the frames decoded by another object reading the same media, if one matches
+     * \param filepath Full path to the media
+     * \return Return true if this object now follows another one
+     */
+    bool followSharedDecoder(const std::string& filepath);
+
+    /**
+     * \brief Stop showing the frames decoded by another object
+     */
+    void stopFollowing();
+
+    /**
+     * \brief Stop decoding for the followers, which open the media themselves at the current time
+     */
+    void releaseFollowers();
+
+    /**
+     * \brief Check whether this object shows the frames decoded by another one
+     * \return Return true if following
+     */
+    bool isFollowing() const;
+
+    /**
+     * \brief Show an image decoded by the leader
+     * \param image Image to show
+     * \param elapsed Time of the image in the media, in us
+     */
+    void showSharedImage(const std::shared_ptr<ImageBuffer>& image, int64_t elapsed);
+
+    /**
+     * \brief Open the media again after having followed another object, and seek to the given time
+     * \param time Time to seek to, in us
+     */
+    void reopenAt(int64_t time);
+
+    /**
+     * \brief Suspend or resume the read loop, depending on whether this object and its followers are sampled
+     * Must be called with _sharedDecodersMutex locked
+     */
+    void updateSuspension();
+
+    /**
+     * \brief Update the resolution to decode to, as the highest one needed by this object and its followers
+     * Must be called with _sharedDecodersMutex locked
+     */
+    void updateOutputResolution();
+
+    /**
+     * \brief Get the size to output the decoded frames at
+     * \param width Width of the decoded frames
+     * \param height Height of the decoded frames
+     * \return Return the output size, downscaled by a power of two as long as it stays above the needed resolution
+     */
+    std::array<int, 2> getOutputSize(int width, int height) const;
+
     /**
      * \brief Base init for the class
      */
@@ -168,6 +448,154 @@ class Image_FFmpeg : public Image
      */
     void readLoop();
 
+    /**
+     * \brief Demux loop, reading the compressed packets into _packetQueue ahead of the read loop
+     */
+    void demuxLoop();
+
+    /**
+     * \brief Get the next packet read by the demux thread, waiting for it if needed
+     * \return Return the packet, to be freed by the caller, or nullptr at the end of the file, when stopping or to start scrubbing
+     */
+    AVPacket* popPacket();
+
+    /**
+     * \brief Free the queued packets, for example after a seek. _demuxMutex has to be locked
+     */
+    void clearPacketQueue();
+
+#if HAVE_LINUX
+    /**
+     * \brief Open a local file for FFmpeg to read through _ioContext
+     * \param filepath File path
+     * \return Return true if the file has been opened, otherwise FFmpeg reads it on its own
+     */
+    bool openFileIO(const std::string& filepath);
+
+    /**
+     * \brief Free _ioContext and close the file
+     */
+    void closeFileIO();
+
+    /**
+     * \brief Callback used by FFmpeg to read from the file opened by openFileIO
+     * \param opaque Pointer to the Image_FFmpeg
+     * \param buffer Buffer to read to
+     * \param size Buffer size
+     * \return Return the number of bytes read, or an AVERROR
+     */
+    static int readFileIO(void* opaque, uint8_t* buffer, int size);
+
+    /**
+     * \brief Callback used by FFmpeg to seek in the file opened by openFileIO
+     * \param opaque Pointer to the Image_FFmpeg
+     * \param offset Offset
+     * \param whence SEEK_SET, SEEK_CUR, SEEK_END, or AVSEEK_SIZE to get the file size
+     * \return Return the new position, the file size, or an AVERROR
+     */
+    static int64_t seekFileIO(void* opaque, int64_t offset, int whence);
+#endif
+
+    /**
+     * \brief Open a decoder for the given video stream
+     * \param stream Video stream
+     * \param decoder Decoder to set up
+     * \param useHardware If true, try to decode on the GPU according to _hwaccel
+     * \return Return true if the decoder is ready
+     */
+    bool openVideoDecoder(AVStream* stream, VideoDecoder& decoder, bool useHardware);
+
+    /**
+     * \brief Decode a video packet
+     * \param decoder Video decoder
+     * \param packet Packet to decode
+     * \param timedFrame Decoded frame, with its timing
+     * \return Return true if a frame has been decoded
+     */
+    bool decodeVideoPacket(VideoDecoder& decoder, AVPacket* packet, TimedFrame& timedFrame);
+
+    /**
+     * \brief Build the keyframe index from the stream index entries
+     * \param stream Video stream
+     */
+    void buildKeyframeIndex(AVStream* stream);
+
+    /**
+     * \brief Get the last keyframe at or before the given timestamp
+     * \param timestamp Timestamp, in the stream time base
+     * \return Return the keyframe timestamp, or -1 if none is known
+     */
+    int64_t getPreviousKeyframe(int64_t timestamp) const;
+
+    /**
+     * \brief Cue prefetching loop, decoding the first frames after each cue
+     */
+    void prefetchLoop();
+
+    /**
+     * \brief Check whether the media can be scrubbed, which needs an intra only codec and an index of its frames
+     * \return Return true if scrubbing is enabled and possible
+     */
+    bool canScrub() const { return _scrub && _intraOnly && !_keyframes.empty(); }
+
+    /**
+     * \brief Scrubbing loop, run by the read loop instead of the sequential reading until scrubbing is disabled
+     * \param decoder Video decoder
+     */
+    void scrubLoop(VideoDecoder& decoder);
+
+    /**
+     * \brief Get the compressed packet of the given frame, from the cache or from the file
+     * \param index Frame index in _keyframes
+     * \param nextReadIndex Index of the frame the file is positioned at, updated after reading
+     * \return Return the packet, or nullptr if it could not be read
+     */
+    AVPacket* getScrubPacket(size_t index, size_t& nextReadIndex);
+
+    /**
+     * \brief Free the cached compressed packets
+     */
+    void clearScrubCache();
+
+    /**
+     * \brief Signal the prefetching loop that the cues changed
+     */
+    void signalCuesUpdated();
+
+    /**
+     * \brief Wake up all the threads waiting on the queues, for example when stopping
+     */
+    void notifyLoops();
+
+    /**
+     * \brief Set up hardware decoding for the given codec context, according to _hwaccel
+     * Must be called before opening the codec. On success, _hwPixelFormat is set to the hardware pixel format
+     * \param codecContext Video codec context
+     * \param codec Video codec
+     * \return Return true if hardware decoding has been set up
+     */
+    bool setupHardwareDecoding(AVCodecContext* codecContext, const AVCodec* codec);
+
+    /**
+     * \brief Callback used by FFmpeg to select the output pixel format, preferring the hardware one
+     * \param codecContext Video codec context
+     * \param formats Formats supported by the decoder, terminated by AV_PIX_FMT_NONE
+     * \return Return the selected format
+     */
+    static AVPixelFormat getHardwareFormat(AVCodecContext* codecContext, const AVPixelFormat* formats);
+
+    /**
+     * \brief Callback used by FFmpeg to check whether a blocking operation has to be aborted
+     * \param opaque Pointer to the Image_FFmpeg
+     * \return Return 1 if the operation has to be aborted
+     */
+    static int interruptIO(void* opaque);
+
+    /**
+     * \brief Schedule opening the live stream again, with an exponential backoff
+     */
+    void scheduleReconnect();
+
     /**
      * \brief Seek in the video
      * \param seconds Desired position
@@ -180,6 +608,17 @@ class Image_FFmpeg : public Image
      */
     void seek_async(float seconds, bool clearQueues = true);
 
+    /**
+     * Hand a decoded frame over to the display loop, only while holding _videoSeekMutex
+     * \param timedFrame Frame to push, given back to the pool if the queue is full
+     */
+    void pushTimedFrame(TimedFrame&& timedFrame);
+
+    /**
+     * Wake up the display and read loops waiting on the frame queue
+     */
+    void notifyVideoQueue();
+
     /**
      * Set the audio output
      * \return Return true if all went well
@@ -191,6 +630,13 @@ class Image_FFmpeg : public Image
      */
     void audioLoop();
 
+    /**
+     * Get the media time currently heard from the speaker
+     * \param time Media time, in us
+     * \return Return false if no sound is being played
+     */
+    bool getAudioClock(int64_t& time) const;
+
     /**
      * Add more media info
      */
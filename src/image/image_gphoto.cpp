@@ -1,13 +1,14 @@
 #include "./image/image_gphoto.h"
 
 #include <cmath>
-#include <fcntl.h>
-#include <unistd.h>
+#include <cstdlib>
 
 #include "./utils/log.h"
 #include "./utils/scope_guard.h"
 #include "./utils/timer.h"
 
+#define SPLASH_GPHOTO_EVENT_TIMEOUT 10 // Timeout when waiting for camera events, in ms
+
 using namespace std;
 
 namespace Splash
@@ -24,6 +25,9 @@ Image_GPhoto::Image_GPhoto(RootObject* root, const std::string& cameraName)
 /*************/
 Image_GPhoto::~Image_GPhoto()
 {
+    if (_decodeFuture.valid())
+        _decodeFuture.wait();
+
     lock_guard<recursive_mutex> lock(_gpMutex);
 
     for (auto& camera : _cameras)
@@ -124,65 +128,99 @@ void Image_GPhoto::detectCameras()
 
 /*************/
 bool Image_GPhoto::capture()
+{
+    auto photo = captureAsync();
+    if (!photo.valid())
+        return false;
+
+    // Photos are shown in capture order, the previous one has to be decoded first
+    if (_decodeFuture.valid())
+        _decodeFuture.wait();
+
+    _decodeFuture = async(launch::async, [this, photo = std::move(photo)]() mutable {
+        auto img = photo.get();
+        if (!img)
+        {
+            Log::get() << Log::WARNING << "Image_GPhoto::capture - Unable to decode the captured photo" << Log::endl;
+            return;
+        }
+
+        img->getSpec().videoFrame = false;
+        {
+            lock_guard<Spinlock> lock(_readMutex);
+            _bufferImage = std::move(img);
+            _imageUpdated = true;
+        }
+
+        updateTimestamp();
+        if (!_isConnectedToRemote)
+            update();
+    });
+
+    return true;
+}
+
+/*************/
+future<unique_ptr<ImageBuffer>> Image_GPhoto::captureAsync()
 {
     lock_guard<recursive_mutex> lock(_gpMutex);
 
     if (_selectedCameraIndex == -1)
     {
         Log::get() << Log::WARNING << "Image_GPhoto::" << __FUNCTION__ << " - A camera must be selected before trying to capture" << Log::endl;
-        return false;
+        return {};
     }
 
     GPhotoCamera& camera = _cameras[_selectedCameraIndex];
 
     CameraFilePath filePath{};
-    int res;
-    if ((res = gp_camera_capture(camera.cam, GP_CAPTURE_IMAGE, &filePath, _gpContext)) == GP_OK)
+    if (gp_camera_capture(camera.cam, GP_CAPTURE_IMAGE, &filePath, _gpContext) != GP_OK)
     {
-        if (string(filePath.name).find(".jpg") != string::npos || string(filePath.name).find(".JPG") != string::npos)
-        {
-            CameraFile* destination;
-            int handle = open((string("/tmp/") + string(filePath.name)).c_str(), O_CREAT | O_WRONLY, 0666);
-            if (handle != -1)
-            {
-                gp_file_new_from_fd(&destination, handle);
-                if (gp_camera_file_get(camera.cam, filePath.folder, filePath.name, GP_FILE_TYPE_NORMAL, destination, _gpContext) != GP_OK)
-                {
-                    Log::get() << Log::WARNING << "Image_GPhoto::" << __FUNCTION__ << " - Unable to download file " << string(filePath.folder) << "/" << string(filePath.name)
-                               << Log::endl;
-                }
-#ifdef DEBUG
-                else
-                {
-                    Log::get() << Log::DEBUGGING << "Image_GPhoto::" << __FUNCTION__ << " - Sucessfully downloaded file " << string(filePath.folder) << "/" << string(filePath.name)
-                               << Log::endl;
-                }
-#endif
-                close(handle);
-            }
+        Log::get() << Log::WARNING << "Image_GPhoto::" << __FUNCTION__ << " - Unable to capture a photo" << Log::endl;
+        return {};
+    }
+    OnScopeExit { gp_camera_file_delete(camera.cam, filePath.folder, filePath.name, _gpContext); };
 
-            // Read the downloaded file
-            readFile(string("/tmp/") + string(filePath.name));
-        }
-        else
-        {
-            Log::get() << Log::WARNING << "Image_GPhoto::" << __FUNCTION__ << " - Captured image filetype is not jpeg. Maybe the camera is set to RAW?" << Log::endl;
-            res = GP_ERROR;
-        }
+    if (string(filePath.name).find(".jpg") == string::npos && string(filePath.name).find(".JPG") == string::npos)
+    {
+        Log::get() << Log::WARNING << "Image_GPhoto::" << __FUNCTION__ << " - Captured image filetype is not jpeg. Maybe the camera is set to RAW?" << Log::endl;
+        return {};
+    }
 
-        gp_camera_file_delete(camera.cam, filePath.folder, filePath.name, _gpContext);
+    // The photo is downloaded to memory, there is no need to go through a temporary file
+    CameraFile* destination = nullptr;
+    if (gp_file_new(&destination) != GP_OK)
+        return {};
+    OnScopeExit { gp_file_unref(destination); };
 
-        // Delete the file
-        if (remove((string("/tmp/") + string(filePath.name)).c_str()) == -1)
-            Log::get() << Log::WARNING << "Image_GPhoto::" << __FUNCTION__ << " - Unable to delete file /tmp/" << filePath.name << Log::endl;
+    if (gp_camera_file_get(camera.cam, filePath.folder, filePath.name, GP_FILE_TYPE_NORMAL, destination, _gpContext) != GP_OK)
+    {
+        Log::get() << Log::WARNING << "Image_GPhoto::" << __FUNCTION__ << " - Unable to download file " << string(filePath.folder) << "/" << string(filePath.name) << Log::endl;
+        return {};
     }
+#ifdef DEBUG
+    Log::get() << Log::DEBUGGING << "Image_GPhoto::" << __FUNCTION__ << " - Sucessfully downloaded file " << string(filePath.folder) << "/" << string(filePath.name) << Log::endl;
+#endif
 
-    this_thread::sleep_for(chrono::milliseconds(1000));
+    const char* data = nullptr;
+    unsigned long int size = 0;
+    if (gp_file_get_data_and_size(destination, &data, &size) != GP_OK || size == 0)
+        return {};
+    auto photo = vector<uint8_t>(reinterpret_cast<const uint8_t*>(data), reinterpret_cast<const uint8_t*>(data) + size);
+
+    // The camera is ready for the next capture once the events raised by this one have been handled,
+    // which is much shorter than waiting for a fixed delay
+    CameraEventType eventType;
+    void* eventData = nullptr;
+    while (gp_camera_wait_for_event(camera.cam, SPLASH_GPHOTO_EVENT_TIMEOUT, &eventType, &eventData, _gpContext) == GP_OK)
+    {
+        free(eventData);
+        eventData = nullptr;
+        if (eventType == GP_EVENT_TIMEOUT)
+            break;
+    }
 
-    if (res != GP_OK)
-        return false;
-    else
-        return true;
+    return async(launch::async, [photo = std::move(photo)]() { return decode(photo.data(), photo.size()); });
 }
 
 /*************/
@@ -461,6 +499,27 @@ void Image_GPhoto::registerAttributes()
                 return {true};
         });
     setAttributeDescription("ready", "Ask whether the camera is ready to shoot");
+
+    addAttribute("model",
+        [&](const Values&) { return false; },
+        [&]() -> Values {
+            lock_guard<recursive_mutex> lock(_gpMutex);
+            if (_selectedCameraIndex == -1)
+                return {};
+            return {_cameras[_selectedCameraIndex].model};
+        });
+    setAttributeDescription("model", "Model of the selected camera");
+
+    addAttribute("lens",
+        [&](const Values&) { return false; },
+        [&]() -> Values {
+            string value;
+            if (doGetProperty("lensname", value))
+                return {value};
+            else
+                return {};
+        });
+    setAttributeDescription("lens", "Name of the lens mounted on the camera, if reported by the camera");
 }
 
 } // namespace Splash
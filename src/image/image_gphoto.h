@@ -26,6 +26,8 @@
 #ifndef SPLASH_IMAGE_GPHOTO_H
 #define SPLASH_IMAGE_GPHOTO_H
 
+#include <future>
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -61,9 +63,18 @@ class Image_GPhoto : public Image_Sequence
 
     /**
      * Capture a new photo
+     * The photo is decoded and shown in the background, so that the next capture can be triggered meanwhile
+     * \return Return true if the photo has been captured and downloaded
      */
     bool capture() final;
 
+    /**
+     * Capture a new photo and download it, the photo being decoded in the background
+     * The next capture can be triggered while the previous photos are still being decoded
+     * \return Return a future holding the decoded photo, which is invalid if the capture failed
+     */
+    std::future<std::unique_ptr<ImageBuffer>> captureAsync();
+
     /**
      * Set the camera to read from
      */
@@ -93,6 +104,8 @@ class Image_GPhoto : public Image_Sequence
     std::vector<GPhotoCamera> _cameras;
     int _selectedCameraIndex{-1};
 
+    std::future<void> _decodeFuture{}; //!< Decoding of the last photo captured through capture()
+
     /**
      * Detect connected cameras
      */
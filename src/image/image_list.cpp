@@ -2,8 +2,14 @@
 
 #include <algorithm>
 #include <filesystem>
+#include <map>
 
+#include "./utils/log.h"
 #include "./utils/osutils.h"
+#include "./utils/thread_pool.h"
+#include "./utils/timer.h"
+
+#define SPLASH_IMAGE_LIST_MAX_PREFETCH 64
 
 namespace Splash
 {
@@ -15,10 +21,17 @@ Image_List::Image_List(RootObject* root)
     init();
 }
 
+/*************/
+Image_List::~Image_List()
+{
+    stopPlayback();
+}
+
 /*************/
 void Image_List::init()
 {
     _type = "image_list";
+    registerAttributes();
 }
 
 /*************/
@@ -27,6 +40,9 @@ bool Image_List::read(const std::string& dirname)
     if (!std::filesystem::is_directory(dirname))
         return false;
 
+    // The playback thread reads the file list
+    stopPlayback();
+
     // read the files from a directory
     for (const auto& it : std::filesystem::directory_iterator(dirname))
     {
@@ -36,12 +52,15 @@ bool Image_List::read(const std::string& dirname)
 
         std::string extension = path.extension();
         Utils::toLower(extension);
-        if (extension == ".jpg" || extension == ".png")
+        if (extension == ".jpg" || extension == ".jpeg" || extension == ".png")
             _filenameSeq.push_back(std::filesystem::absolute(path));
     }
 
     // sort in descending order
     std::sort(_filenameSeq.begin(), _filenameSeq.end(), std::greater<std::string>());
+    _playlist = std::vector<std::string>(_filenameSeq.rbegin(), _filenameSeq.rend());
+
+    updatePlayback();
     return true;
 }
 
@@ -56,4 +75,174 @@ bool Image_List::capture()
     return true;
 }
 
+/*************/
+void Image_List::updatePlayback()
+{
+    stopPlayback();
+    if (_framerate <= 0.f || _playlist.empty() || !_root)
+        return;
+
+    std::lock_guard<std::mutex> lock(_playbackMutex);
+    _playbackRun = true;
+    _playbackFuture = std::async(std::launch::async, [this]() { playbackThreadFunc(); });
+}
+
+/*************/
+void Image_List::stopPlayback()
+{
+    {
+        std::lock_guard<std::mutex> lock(_playbackMutex);
+        _playbackRun = false;
+    }
+    _playbackCondition.notify_all();
+
+    if (_playbackFuture.valid())
+        _playbackFuture.wait();
+}
+
+/*************/
+void Image_List::playbackThreadFunc()
+{
+    // Decoded images are held by the tasks until they are shown, and dropped if they come too late
+    struct Frame
+    {
+        std::shared_ptr<std::unique_ptr<ImageBuffer>> image{nullptr};
+        std::future<void> decoded{};
+    };
+    std::map<int64_t, Frame> prefetched;
+
+    const auto frameCount = static_cast<int64_t>(_playlist.size());
+    const auto startTime = Timer::getTime();
+    int64_t shownFrame = -1;
+
+    std::unique_lock<std::mutex> lock(_playbackMutex);
+    while (_playbackRun)
+    {
+        lock.unlock();
+
+        const auto framerate = _framerate.load();
+        const auto loop = _loop.load();
+
+        // The frame to show is given by the master clock if requested, by the time since the start otherwise
+        int64_t time = Timer::getTime() - startTime;
+        int64_t clockAsMs = 0;
+        bool clockIsPaused = false;
+        if (_useClock && Timer::get().getMasterClock<std::chrono::milliseconds>(clockAsMs, clockIsPaused))
+            time = clockAsMs * 1000;
+
+        const auto timeFrame = std::max<int64_t>(0, static_cast<int64_t>(static_cast<double>(time) * framerate / 1e6));
+        const auto frame = loop ? timeFrame % frameCount : std::min(timeFrame, frameCount - 1);
+
+        // Decode the next frames ahead, dropping the ones which are not needed anymore
+        const auto prefetchCount = std::clamp<int64_t>(_prefetchCount, 1, std::min<int64_t>(frameCount, SPLASH_IMAGE_LIST_MAX_PREFETCH));
+        std::vector<int64_t> window;
+        for (int64_t i = 0; i < prefetchCount; ++i)
+            window.push_back(loop ? (frame + i) % frameCount : std::min(frame + i, frameCount - 1));
+
+        for (auto frameIt = prefetched.begin(); frameIt != prefetched.end();)
+        {
+            if (std::find(window.begin(), window.end(), frameIt->first) == window.end())
+                frameIt = prefetched.erase(frameIt);
+            else
+                ++frameIt;
+        }
+
+        for (const auto index : window)
+        {
+            if (prefetched.find(index) != prefetched.end() || index == shownFrame)
+                continue;
+
+            Frame prefetchedFrame;
+            auto image = std::make_shared<std::unique_ptr<ImageBuffer>>();
+            auto filename = _playlist[index];
+            prefetchedFrame.image = image;
+            prefetchedFrame.decoded = ThreadPool::get().enqueue([=]() { *image = decode(filename); });
+            prefetched[index] = std::move(prefetchedFrame);
+        }
+
+        // Show the current frame as soon as it is decoded
+        bool waitingForFrame = false;
+        if (frame != shownFrame)
+        {
+            auto frameIt = prefetched.find(frame);
+            if (frameIt != prefetched.end() && frameIt->second.decoded.wait_for(std::chrono::seconds(0)) == std::future_status::ready)
+            {
+                auto image = std::move(*frameIt->second.image);
+                prefetched.erase(frameIt);
+                shownFrame = frame;
+
+                if (image)
+                {
+                    image->getSpec().videoFrame = true;
+                    {
+                        std::lock_guard<Spinlock> lockRead(_readMutex);
+                        _bufferImage = std::move(image);
+                        _imageUpdated = true;
+                    }
+                    updateTimestamp();
+                }
+                else
+                {
+                    Log::get() << Log::WARNING << "Image_List::" << __FUNCTION__ << " - Unable to load image file " << _playlist[frame] << Log::endl;
+                }
+            }
+            else
+            {
+                waitingForFrame = true;
+            }
+        }
+
+        // Wait for the next frame, or poll while the current one is being decoded
+        auto waitTime = std::chrono::microseconds(1000);
+        if (!waitingForFrame)
+            waitTime = std::chrono::microseconds(std::max<int64_t>(1000, static_cast<int64_t>(static_cast<double>(timeFrame + 1) * 1e6 / framerate) - time));
+
+        lock.lock();
+        _playbackCondition.wait_for(lock, waitTime, [&]() { return !_playbackRun; });
+    }
+}
+
+/*************/
+void Image_List::registerAttributes()
+{
+    Image_Sequence::registerAttributes();
+
+    addAttribute("framerate",
+        [&](const Values& args) {
+            _framerate = std::max(0.f, args[0].as<float>());
+            updatePlayback();
+            return true;
+        },
+        [&]() -> Values { return {_framerate.load()}; },
+        {'r'});
+    setAttributeDescription("framerate", "Framerate at which the files are played, in frames per second. If 0, a file is only read when asking for a capture");
+
+    addAttribute("loop",
+        [&](const Values& args) {
+            _loop = args[0].as<bool>();
+            return true;
+        },
+        [&]() -> Values { return {_loop.load()}; },
+        {'b'});
+    setAttributeDescription("loop", "If true, the playback loops over the files");
+
+    addAttribute("prefetch",
+        [&](const Values& args) {
+            _prefetchCount = std::clamp(args[0].as<int>(), 1, SPLASH_IMAGE_LIST_MAX_PREFETCH);
+            return true;
+        },
+        [&]() -> Values { return {_prefetchCount.load()}; },
+        {'i'});
+    setAttributeDescription("prefetch", "Number of files decoded ahead of time during playback, in parallel");
+
+    addAttribute("useClock",
+        [&](const Values& args) {
+            _useClock = args[0].as<bool>();
+            return true;
+        },
+        [&]() -> Values { return {_useClock.load()}; },
+        {'b'});
+    setAttributeDescription("useClock", "If true, the playback follows the master clock instead of starting when the files are read");
+}
+
 } // namespace Splash
@@ -25,6 +25,11 @@
 #ifndef SPLASH_IMAGE_LIST_H
 #define SPLASH_IMAGE_LIST_H
 
+#include <atomic>
+#include <condition_variable>
+#include <future>
+#include <mutex>
+
 #include "./image/image_sequence.h"
 
 namespace Splash
@@ -39,6 +44,11 @@ class Image_List : public Image_Sequence
      */
     Image_List(RootObject* root);
 
+    /**
+     * Destructor
+     */
+    ~Image_List() final;
+
     /**
      * No copy constructor
      */
@@ -61,13 +71,47 @@ class Image_List : public Image_Sequence
      */
     const std::vector<std::string> getFileList() const { return _filenameSeq; };
 
+  protected:
+    /**
+     * Register new functors to modify attributes
+     */
+    void registerAttributes() override;
+
   private:
     std::vector<std::string> _filenameSeq;
+    std::vector<std::string> _playlist{}; //!< All the files of the directory, in playing order
+
+    // Playback parameters
+    std::atomic<float> _framerate{0.f};
+    std::atomic_bool _loop{true};
+    std::atomic_bool _useClock{false};
+    std::atomic_int _prefetchCount{8};
+
+    // Playback thread, decoding the next files ahead of time on the thread pool
+    std::mutex _playbackMutex{};
+    std::condition_variable _playbackCondition{};
+    bool _playbackRun{false};
+    std::future<void> _playbackFuture{};
 
     /**
      * Base init for the class
      */
     void init();
+
+    /**
+     * Start or stop the playback, according to the framerate and the file list
+     */
+    void updatePlayback();
+
+    /**
+     * Stop the playback thread
+     */
+    void stopPlayback();
+
+    /**
+     * Playback loop, showing each file at its time and prefetching the next ones
+     */
+    void playbackThreadFunc();
 };
 
 } // namespace Splash
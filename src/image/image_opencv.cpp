@@ -7,6 +7,8 @@
 
 #include "./utils/cgutils.h"
 #include "./utils/log.h"
+#include "./utils/osutils.h"
+#include "./utils/scope_guard.h"
 #include "./utils/timer.h"
 
 using namespace std;
@@ -24,9 +26,7 @@ Image_OpenCV::Image_OpenCV(RootObject* root)
 /*************/
 Image_OpenCV::~Image_OpenCV()
 {
-    _continueReading = false;
-    if (_readLoopThread.joinable())
-        _readLoopThread.join();
+    stopCapture();
 }
 
 /*************/
@@ -42,12 +42,11 @@ bool Image_OpenCV::read(const string& filename)
     }
 
     // This releases any previous input
-    _continueReading = false;
-    if (_readLoopThread.joinable())
-        _readLoopThread.join();
+    stopCapture();
 
     _continueReading = true;
-    _readLoopThread = thread([&]() { readLoop(); });
+    _grabThread = thread([&]() { grabLoop(); });
+    _retrieveThread = thread([&]() { retrieveLoop(); });
 
     return true;
 }
@@ -64,85 +63,130 @@ void Image_OpenCV::init()
 }
 
 /*************/
-void Image_OpenCV::readLoop()
+void Image_OpenCV::grabLoop()
 {
-    std::unique_ptr<cv::VideoCapture> videoCapture{nullptr};
+    // The retrieve thread only uses the input once a frame has been grabbed
     if (_inputIndex >= 0)
-        videoCapture = make_unique<cv::VideoCapture>(_inputIndex);
+        _videoCapture = make_unique<cv::VideoCapture>(_inputIndex);
     else
-        videoCapture = make_unique<cv::VideoCapture>(_filepath);
+        _videoCapture = make_unique<cv::VideoCapture>(_filepath);
 
-    if (!videoCapture->isOpened())
+    OnScopeExit
+    {
+        {
+            lock_guard<mutex> lock(_frameMutex);
+            _continueReading = false;
+        }
+        _frameCondition.notify_all();
+    };
+
+    if (!_videoCapture->isOpened())
     {
         Log::get() << Log::WARNING << "Image_OpenCV::" << __FUNCTION__ << " - Unable to open video capture input " << _filepath << Log::endl;
         return;
     }
 
-    uint32_t width = videoCapture->get(cv::CAP_PROP_FRAME_WIDTH);
-    uint32_t height = videoCapture->get(cv::CAP_PROP_FRAME_HEIGHT);
-    uint32_t framerate = videoCapture->get(cv::CAP_PROP_FPS);
-    float exposure = videoCapture->get(cv::CAP_PROP_AUTO_EXPOSURE);
+    uint32_t width = _videoCapture->get(cv::CAP_PROP_FRAME_WIDTH);
+    uint32_t height = _videoCapture->get(cv::CAP_PROP_FRAME_HEIGHT);
+    uint32_t framerate = _videoCapture->get(cv::CAP_PROP_FPS);
+    float exposure = _videoCapture->get(cv::CAP_PROP_AUTO_EXPOSURE);
+    bool nativeFormat = false;
+    _fourcc = static_cast<int>(_videoCapture->get(cv::CAP_PROP_FOURCC));
 
     Log::get() << Log::MESSAGE << "Image_OpenCV::" << __FUNCTION__ << " - Successfully initialized VideoCapture " << _filepath << Log::endl;
 
     _capturing = true;
-    while (_continueReading)
+    while (true)
     {
+        if (!Utils::applyThreadClass(Utils::ThreadClass::decode))
+            Log::get() << Log::WARNING << "Image_OpenCV::" << __FUNCTION__ << " - Unable to apply the scheduling of the decode threads" << Log::endl;
+
+        unique_lock<mutex> lock(_frameMutex);
+        _frameCondition.wait(lock, [&]() { return !_frameGrabbed || !_continueReading; });
+        if (!_continueReading)
+            break;
+
         if (_cvOptionsUpdated)
         {
             _cvOptionsUpdated = false;
             auto options = parseCVOptions(_cvOptions);
             for (const auto& [prop, value] : options)
-                videoCapture->set(prop, value);
+                _videoCapture->set(prop, value);
+        }
+
+        // Raw mode keeps the frames in the camera pixel format, converted on the GPU
+        if (nativeFormat != _nativeFormat)
+        {
+            nativeFormat = _nativeFormat;
+            _videoCapture->set(cv::CAP_PROP_FORMAT, nativeFormat ? -1 : CV_8UC3);
+            _videoCapture->set(cv::CAP_PROP_CONVERT_RGB, nativeFormat ? 0 : 1);
+            _fourcc = static_cast<int>(_videoCapture->get(cv::CAP_PROP_FOURCC));
         }
 
         // Update capture parameters
         if (width != _width)
-            videoCapture->set(cv::CAP_PROP_FRAME_WIDTH, _width);
+            _videoCapture->set(cv::CAP_PROP_FRAME_WIDTH, _width);
         if (height != _height)
-            videoCapture->set(cv::CAP_PROP_FRAME_HEIGHT, _height);
+            _videoCapture->set(cv::CAP_PROP_FRAME_HEIGHT, _height);
         if (framerate != _framerate)
-            videoCapture->set(cv::CAP_PROP_FPS, _framerate);
+            _videoCapture->set(cv::CAP_PROP_FPS, _framerate);
         if (exposure != _exposure)
-            videoCapture->set(cv::CAP_PROP_EXPOSURE, _exposure);
+            _videoCapture->set(cv::CAP_PROP_EXPOSURE, _exposure);
 
-        _width = width = videoCapture->get(cv::CAP_PROP_FRAME_WIDTH);
-        _height = height = videoCapture->get(cv::CAP_PROP_FRAME_HEIGHT);
-        _framerate = framerate = videoCapture->get(cv::CAP_PROP_FPS);
-        _exposure = exposure = videoCapture->get(cv::CAP_PROP_EXPOSURE);
+        _width = width = _videoCapture->get(cv::CAP_PROP_FRAME_WIDTH);
+        _height = height = _videoCapture->get(cv::CAP_PROP_FRAME_HEIGHT);
+        _framerate = framerate = _videoCapture->get(cv::CAP_PROP_FPS);
+        _exposure = exposure = _videoCapture->get(cv::CAP_PROP_EXPOSURE);
 
-        // Capture
-        auto capture = cv::Mat();
-        if (!videoCapture->read(capture))
+        // Grabbing only dequeues the frame, it is decoded by the retrieve thread
+        if (!_videoCapture->grab())
         {
             Log::get() << Log::WARNING << "Image_OpenCV::" << __FUNCTION__ << " - An error occurred while reading the VideoCapture" << Log::endl;
-            return;
+            break;
         }
 
-        if (capture.channels() == 1)
-        {
-            auto rgba = cv::Mat();
-            cv::cvtColor(capture, rgba, cv::COLOR_GRAY2RGBA);
-            capture = rgba;
-        }
+        _frameGrabbed = true;
+        lock.unlock();
+        _frameCondition.notify_all();
+    }
+    _capturing = false;
+}
+
+/*************/
+void Image_OpenCV::retrieveLoop()
+{
+    while (true)
+    {
+        if (!Utils::applyThreadClass(Utils::ThreadClass::decode))
+            Log::get() << Log::WARNING << "Image_OpenCV::" << __FUNCTION__ << " - Unable to apply the scheduling of the decode threads" << Log::endl;
 
-        auto spec = _readBuffer.getSpec();
-        if (static_cast<int>(spec.width) != capture.rows || static_cast<int>(spec.height) != capture.cols || static_cast<int>(spec.channels) != capture.channels())
+        // The next frame is grabbed while this one is converted and published
+        cv::Mat frame;
         {
-            ImageBufferSpec newSpec(capture.cols, capture.rows, capture.channels(), 8 * capture.channels(), ImageBufferSpec::Type::UINT8);
-            newSpec.format = "BGRA";
-            _readBuffer = ImageBuffer(newSpec);
+            unique_lock<mutex> lock(_frameMutex);
+            _frameCondition.wait(lock, [&]() { return _frameGrabbed || !_continueReading; });
+            if (!_frameGrabbed)
+                break;
+
+            auto retrieved = _videoCapture->retrieve(frame);
+            _frameGrabbed = false;
+            lock.unlock();
+            _frameCondition.notify_all();
+
+            if (!retrieved)
+            {
+                Log::get() << Log::WARNING << "Image_OpenCV::" << __FUNCTION__ << " - Unable to retrieve the grabbed frame" << Log::endl;
+                continue;
+            }
         }
-        unsigned char* pixels = reinterpret_cast<unsigned char*>(_readBuffer.data());
 
-        unsigned int imageSize = capture.rows * capture.cols * capture.channels();
-        copy(capture.data, capture.data + imageSize, pixels);
+        auto img = wrapFrame(frame);
+        if (!img)
+            continue;
 
         {
             lock_guard<shared_mutex> lockWrite(_writeMutex);
-            if (!_bufferImage)
-                _bufferImage = make_unique<ImageBuffer>();
-            std::swap(*_bufferImage, _readBuffer);
+            _bufferImage = std::move(img);
             _imageUpdated = true;
         }
         updateTimestamp();
@@ -152,7 +196,77 @@ void Image_OpenCV::readLoop()
         if (Timer::get().isDebug())
             Timer::get() >> ("read " + _name);
     }
-    _capturing = false;
+}
+
+/*************/
+void Image_OpenCV::stopCapture()
+{
+    {
+        lock_guard<mutex> lock(_frameMutex);
+        _continueReading = false;
+    }
+    _frameCondition.notify_all();
+
+    if (_grabThread.joinable())
+        _grabThread.join();
+    if (_retrieveThread.joinable())
+        _retrieveThread.join();
+
+    _frameGrabbed = false;
+    _videoCapture.reset();
+}
+
+/*************/
+unique_ptr<ImageBuffer> Image_OpenCV::wrapFrame(cv::Mat frame)
+{
+    if (frame.empty())
+        return {nullptr};
+
+    // Compressed frames, i.e. MJPEG in raw mode, come as a single row
+    if (frame.rows == 1 && frame.type() == CV_8UC1)
+        frame = cv::imdecode(frame, cv::IMREAD_COLOR);
+    else if (frame.type() == CV_8UC1)
+        cv::cvtColor(frame, frame, cv::COLOR_GRAY2BGR);
+
+    if (frame.empty())
+        return {nullptr};
+
+    ImageBufferSpec spec;
+    switch (frame.type())
+    {
+    case CV_8UC2:
+    {
+        auto fourcc = _fourcc.load();
+        const auto fourccString = string(reinterpret_cast<const char*>(&fourcc), 4);
+        if (fourccString == "YUYV" || fourccString == "YUY2")
+            spec = ImageBufferSpec(frame.cols, frame.rows, 3, 16, ImageBufferSpec::Type::UINT8, "YUYV");
+        else if (fourccString == "UYVY")
+            spec = ImageBufferSpec(frame.cols, frame.rows, 3, 16, ImageBufferSpec::Type::UINT8, "UYVY");
+        else
+        {
+            Log::get() << Log::WARNING << "Image_OpenCV::" << __FUNCTION__ << " - Unsupported camera pixel format " << fourccString << Log::endl;
+            return {nullptr};
+        }
+        break;
+    }
+    case CV_8UC3:
+        spec = ImageBufferSpec(frame.cols, frame.rows, 3, 24, ImageBufferSpec::Type::UINT8, "BGR");
+        break;
+    case CV_8UC4:
+        spec = ImageBufferSpec(frame.cols, frame.rows, 4, 32, ImageBufferSpec::Type::UINT8, "BGRA");
+        break;
+    default:
+        Log::get() << Log::WARNING << "Image_OpenCV::" << __FUNCTION__ << " - Unsupported frame type " << frame.type() << Log::endl;
+        return {nullptr};
+    }
+    spec.videoFrame = true;
+
+    if (!frame.isContinuous())
+        frame = frame.clone();
+
+    // The frame is wrapped without any copy, the deleter holding a reference to it
+    auto pixels = ResizableArray<uint8_t>(frame.data, spec.rawSize(), [frame](uint8_t*) {});
+    return make_unique<ImageBuffer>(spec, std::move(pixels));
 }
 
 /*************/
@@ -236,6 +350,15 @@ void Image_OpenCV::registerAttributes()
         R"(OpenCV attributes set as a string following the format: "key1=value1, key2=value2, ...".
         Keys must be indices from cv::CAP_PROPs, and values must be doubles.
         Attributes can be found in OpenCV documentation: https://docs.opencv.org.)");
+
+    addAttribute("nativeFormat",
+        [&](const Values& args) {
+            _nativeFormat = args[0].as<bool>();
+            return true;
+        },
+        [&]() -> Values { return {_nativeFormat.load()}; },
+        {'b'});
+    setAttributeDescription("nativeFormat", "If set to true, frames are kept in the camera pixel format (i.e. YUYV) and converted on the GPU instead of by OpenCV");
 }
 
 } // namespace Splash
@@ -26,7 +26,9 @@
 #define SPLASH_IMAGE_OPENCV_H
 
 #include <atomic>
+#include <condition_variable>
 #include <map>
+#include <memory>
 #include <mutex>
 #include <thread>
 
@@ -37,6 +39,7 @@
 
 namespace cv
 {
+class Mat;
 class VideoCapture;
 }
 
@@ -77,10 +80,19 @@ class Image_OpenCV : public Image
     std::string _cvOptions{};
     bool _cvOptionsUpdated{false};
 
+    std::atomic_bool _nativeFormat{false}; //!< If true, frames are kept in the camera pixel format
+    std::atomic_int _fourcc{0};            //!< FourCC of the camera pixel format
+
     bool _capturing{false};
-    std::thread _readLoopThread;
+    std::unique_ptr<cv::VideoCapture> _videoCapture{nullptr};
+    std::thread _grabThread;
+    std::thread _retrieveThread;
     std::atomic_bool _continueReading{false};
-    ImageBuffer _readBuffer;
+
+    // Frames are grabbed and retrieved alternately, the retrieved frame being published while the next one is grabbed
+    std::mutex _frameMutex{};
+    std::condition_variable _frameCondition{};
+    bool _frameGrabbed{false};
 
     /**
      * Base init for the class
@@ -95,9 +107,26 @@ class Image_OpenCV : public Image
     std::map<int, double> parseCVOptions(const std::string& options);
 
     /**
-     * Input read loop
+     * Input grab loop, which also applies the capture parameters
+     */
+    void grabLoop();
+
+    /**
+     * Retrieve loop, decoding and publishing the grabbed frames
+     */
+    void retrieveLoop();
+
+    /**
+     * Stop the grab and retrieve loops, and release the input
+     */
+    void stopCapture();
+
+    /**
+     * Wrap a retrieved frame in an image buffer, without copy when its layout is supported by the texture
+     * \param frame Retrieved frame
+     * \return Return the image buffer, or nullptr if the frame layout is not supported
      */
-    void readLoop();
+    std::unique_ptr<ImageBuffer> wrapFrame(cv::Mat frame);
 
     /**
      * Register new functors to modify attributes
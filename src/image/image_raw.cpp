@@ -0,0 +1,409 @@
+#include "./image/image_raw.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <map>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "./utils/log.h"
+#include "./utils/osutils.h"
+#include "./utils/scope_guard.h"
+#include "./utils/thread_pool.h"
+#include "./utils/timer.h"
+
+#define SPLASH_IMAGE_RAW_MAX_SPEC_SIZE 4096
+#define SPLASH_IMAGE_RAW_MAX_READAHEAD 64
+
+using namespace std;
+
+namespace Splash
+{
+
+/*************/
+Image_Raw::Mapping::~Mapping()
+{
+    if (data)
+        munmap(data, size);
+}
+
+/*************/
+Image_Raw::DirectFile::~DirectFile()
+{
+    if (fd >= 0)
+        ::close(fd);
+}
+
+/*************/
+Image_Raw::Image_Raw(RootObject* root)
+    : Image(root)
+{
+    init();
+}
+
+/*************/
+Image_Raw::~Image_Raw()
+{
+    close();
+}
+
+/*************/
+void Image_Raw::init()
+{
+    _type = "image_raw";
+    registerAttributes();
+}
+
+/*************/
+uint64_t Image_Raw::getFrameStride(const ImageBufferSpec& spec)
+{
+    const uint64_t alignment = SPLASH_IMAGE_RAW_ALIGNMENT;
+    return (static_cast<uint64_t>(spec.rawSize()) + alignment - 1) / alignment * alignment;
+}
+
+/*************/
+bool Image_Raw::writeHeader(ostream& stream, const ImageBufferSpec& spec, uint64_t frameCount, double framerate)
+{
+    auto specString = spec.to_string();
+    const uint64_t alignment = SPLASH_IMAGE_RAW_ALIGNMENT;
+
+    FileHeader header;
+    header.specSize = specString.size();
+    header.dataOffset = (sizeof(FileHeader) + header.specSize + alignment - 1) / alignment * alignment;
+    header.frameStride = getFrameStride(spec);
+    header.frameCount = frameCount;
+    header.framerate = framerate;
+
+    stream.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    stream.write(specString.data(), specString.size());
+    const auto padding = vector<char>(header.dataOffset - sizeof(FileHeader) - header.specSize, 0);
+    stream.write(padding.data(), padding.size());
+    return static_cast<bool>(stream);
+}
+
+/*************/
+bool Image_Raw::read(const string& filename)
+{
+    const auto filepath = Utils::getFullPathFromFilePath(filename, _root->getConfigurationPath());
+    close();
+
+    int fd = open(filepath.c_str(), O_RDONLY);
+    if (fd < 0)
+    {
+        Log::get() << Log::WARNING << "Image_Raw::" << __FUNCTION__ << " - Unable to open file " << filepath << ": " << string(strerror(errno)) << Log::endl;
+        return false;
+    }
+    OnScopeExit { ::close(fd); };
+
+    FileHeader header;
+    struct stat fileStat;
+    if (fstat(fd, &fileStat) != 0 || pread(fd, &header, sizeof(header), 0) != sizeof(header) || memcmp(header.magic, SPLASH_IMAGE_RAW_MAGIC, sizeof(header.magic)) != 0 ||
+        header.specSize == 0 || header.specSize > SPLASH_IMAGE_RAW_MAX_SPEC_SIZE)
+    {
+        Log::get() << Log::WARNING << "Image_Raw::" << __FUNCTION__ << " - File " << filepath << " is not a raw frame sequence" << Log::endl;
+        return false;
+    }
+
+    string specString(header.specSize, '\0');
+    if (pread(fd, specString.data(), specString.size(), sizeof(header)) != static_cast<ssize_t>(specString.size()) || count(specString.begin(), specString.end(), ';') != 8)
+    {
+        Log::get() << Log::WARNING << "Image_Raw::" << __FUNCTION__ << " - Invalid frame spec in file " << filepath << Log::endl;
+        return false;
+    }
+
+    ImageBufferSpec spec;
+    try
+    {
+        spec.from_string(specString);
+    }
+    catch (...)
+    {
+        Log::get() << Log::WARNING << "Image_Raw::" << __FUNCTION__ << " - Invalid frame spec in file " << filepath << Log::endl;
+        return false;
+    }
+
+    // Frames must be aligned for O_DIRECT and madvise, and all be in the file
+    const auto fileSize = static_cast<uint64_t>(fileStat.st_size);
+    if (spec.rawSize() == 0 || header.frameCount == 0 || header.frameStride < static_cast<uint64_t>(spec.rawSize()) || header.dataOffset % SPLASH_IMAGE_RAW_ALIGNMENT != 0 ||
+        header.frameStride % SPLASH_IMAGE_RAW_ALIGNMENT != 0 || header.dataOffset > fileSize || (fileSize - header.dataOffset) / header.frameStride < header.frameCount)
+    {
+        Log::get() << Log::WARNING << "Image_Raw::" << __FUNCTION__ << " - File " << filepath << " is truncated or has an invalid layout" << Log::endl;
+        return false;
+    }
+
+    if (_direct)
+    {
+        auto directFile = make_shared<DirectFile>();
+        directFile->fd = open(filepath.c_str(), O_RDONLY | O_DIRECT);
+        if (directFile->fd >= 0)
+            _directFile = directFile;
+        else
+            Log::get() << Log::WARNING << "Image_Raw::" << __FUNCTION__ << " - Unable to open " << filepath << " with O_DIRECT, falling back to memory mapping: " << string(strerror(errno))
+                       << Log::endl;
+    }
+
+    if (!_directFile)
+    {
+        // Privately mapped, so that modifying a frame never writes to the file
+        auto data = mmap(nullptr, fileSize, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+        if (data == MAP_FAILED)
+        {
+            Log::get() << Log::WARNING << "Image_Raw::" << __FUNCTION__ << " - Unable to map file " << filepath << ": " << string(strerror(errno)) << Log::endl;
+            return false;
+        }
+
+        auto mapping = make_shared<Mapping>();
+        mapping->data = static_cast<uint8_t*>(data);
+        mapping->size = fileSize;
+        madvise(mapping->data, mapping->size, MADV_SEQUENTIAL);
+        _mapping = mapping;
+    }
+
+    spec.videoFrame = true;
+    spec.timestamp = 0;
+    _header = header;
+    _frameSpec = spec;
+
+    Log::get() << Log::MESSAGE << "Image_Raw::" << __FUNCTION__ << " - Successfully loaded file " << filepath << ", with " << header.frameCount << " frames of " << spec.width << "x"
+               << spec.height << " " << spec.format << Log::endl;
+
+    {
+        lock_guard<mutex> lock(_playbackMutex);
+        _playbackRun = true;
+    }
+    _playbackFuture = async(launch::async, [this]() { playbackThreadFunc(); });
+
+    return true;
+}
+
+/*************/
+void Image_Raw::close()
+{
+    {
+        lock_guard<mutex> lock(_playbackMutex);
+        _playbackRun = false;
+    }
+    _playbackCondition.notify_all();
+
+    if (_playbackFuture.valid())
+        _playbackFuture.wait();
+
+    // Frames still pointing into the mapping keep it alive
+    _mapping.reset();
+    _directFile.reset();
+}
+
+/*************/
+unique_ptr<ImageBuffer> Image_Raw::mapFrame(uint64_t index) const
+{
+    auto mapping = _mapping;
+    auto data = mapping->data + _header.dataOffset + index * _header.frameStride;
+    auto pixels = ResizableArray<uint8_t>(data, _frameSpec.rawSize(), [mapping](uint8_t*) {});
+    return make_unique<ImageBuffer>(_frameSpec, std::move(pixels));
+}
+
+/*************/
+unique_ptr<ImageBuffer> Image_Raw::readFrameDirect(const shared_ptr<DirectFile>& file, uint64_t offset, uint64_t stride, const ImageBufferSpec& spec)
+{
+    void* buffer = nullptr;
+    if (posix_memalign(&buffer, SPLASH_IMAGE_RAW_ALIGNMENT, stride) != 0)
+        return {nullptr};
+    auto pixels = ResizableArray<uint8_t>(static_cast<uint8_t*>(buffer), spec.rawSize(), [](uint8_t* data) { free(data); });
+
+    // O_DIRECT reads may be split, but always on aligned boundaries
+    uint64_t done = 0;
+    while (done < stride)
+    {
+        auto result = pread(file->fd, static_cast<uint8_t*>(buffer) + done, stride - done, offset + done);
+        if (result < 0 && errno == EINTR)
+            continue;
+        if (result <= 0)
+            return {nullptr};
+        done += result;
+    }
+
+    return make_unique<ImageBuffer>(spec, std::move(pixels));
+}
+
+/*************/
+void Image_Raw::playbackThreadFunc()
+{
+    // Frames read ahead, held until they are shown and dropped if they come too late
+    struct Frame
+    {
+        shared_ptr<unique_ptr<ImageBuffer>> image{nullptr};
+        future<void> read{}; //!< Only valid when read with O_DIRECT
+    };
+    map<int64_t, Frame> prefetched;
+
+    const auto frameCount = static_cast<int64_t>(_header.frameCount);
+    const auto startTime = Timer::getTime();
+    int64_t shownFrame = -1;
+
+    unique_lock<mutex> lock(_playbackMutex);
+    while (_playbackRun)
+    {
+        lock.unlock();
+
+        const auto framerate = _framerate > 0.f ? static_cast<double>(_framerate) : _header.framerate;
+        const auto loop = _loop.load();
+
+        // The frame to show is given by the master clock if requested, by the time since the file was read otherwise
+        int64_t time = Timer::getTime() - startTime;
+        int64_t clockAsMs = 0;
+        bool clockIsPaused = false;
+        if (_useClock && Timer::get().getMasterClock<chrono::milliseconds>(clockAsMs, clockIsPaused))
+            time = clockAsMs * 1000;
+
+        const auto timeFrame = framerate > 0.0 ? std::max<int64_t>(0, static_cast<int64_t>(static_cast<double>(time) * framerate / 1e6)) : 0;
+        const auto frame = loop ? timeFrame % frameCount : std::min(timeFrame, frameCount - 1);
+
+        // Read the next frames ahead, either by asking the kernel to or by reading them on the thread pool
+        const auto readahead = std::clamp<int64_t>(_readahead, 1, std::min<int64_t>(frameCount, SPLASH_IMAGE_RAW_MAX_READAHEAD));
+        vector<int64_t> window;
+        for (int64_t i = 0; i < readahead; ++i)
+            window.push_back(loop ? (frame + i) % frameCount : std::min(frame + i, frameCount - 1));
+
+        for (auto frameIt = prefetched.begin(); frameIt != prefetched.end();)
+        {
+            if (find(window.begin(), window.end(), frameIt->first) == window.end())
+                frameIt = prefetched.erase(frameIt);
+            else
+                ++frameIt;
+        }
+
+        for (const auto index : window)
+        {
+            if (prefetched.find(index) != prefetched.end() || index == shownFrame)
+                continue;
+
+            Frame prefetchedFrame;
+            prefetchedFrame.image = make_shared<unique_ptr<ImageBuffer>>();
+            const auto offset = _header.dataOffset + index * _header.frameStride;
+            if (_directFile)
+            {
+                auto image = prefetchedFrame.image;
+                auto file = _directFile;
+                auto stride = _header.frameStride;
+                auto spec = _frameSpec;
+                prefetchedFrame.read = ThreadPool::get().enqueue([=]() { *image = readFrameDirect(file, offset, stride, spec); });
+            }
+            else
+            {
+                madvise(_mapping->data + offset, _header.frameStride, MADV_WILLNEED);
+                *prefetchedFrame.image = mapFrame(index);
+            }
+            prefetched[index] = std::move(prefetchedFrame);
+        }
+
+        // Show the current frame as soon as it is available
+        bool waitingForFrame = false;
+        if (frame != shownFrame)
+        {
+            auto frameIt = prefetched.find(frame);
+            if (frameIt != prefetched.end() && (!frameIt->second.read.valid() || frameIt->second.read.wait_for(chrono::seconds(0)) == future_status::ready))
+            {
+                auto image = std::move(*frameIt->second.image);
+                prefetched.erase(frameIt);
+                shownFrame = frame;
+
+                if (image)
+                {
+                    {
+                        lock_guard<Spinlock> lockRead(_readMutex);
+                        _bufferImage = std::move(image);
+                        _imageUpdated = true;
+                    }
+                    updateTimestamp();
+                }
+                else
+                {
+                    Log::get() << Log::WARNING << "Image_Raw::" << __FUNCTION__ << " - Unable to read frame " << frame << Log::endl;
+                }
+            }
+            else
+            {
+                waitingForFrame = true;
+            }
+        }
+
+        // Wait for the next frame, or poll while the current one is being read
+        auto waitTime = chrono::microseconds(1000);
+        if (!waitingForFrame && framerate > 0.0)
+            waitTime = chrono::microseconds(std::max<int64_t>(1000, static_cast<int64_t>(static_cast<double>(timeFrame + 1) * 1e6 / framerate) - time));
+        else if (!waitingForFrame)
+            waitTime = chrono::microseconds(10000);
+
+        lock.lock();
+        _playbackCondition.wait_for(lock, waitTime, [&]() { return !_playbackRun; });
+    }
+}
+
+/*************/
+void Image_Raw::updateMoreMediaInfo(Values& mediaInfo)
+{
+    mediaInfo.push_back(Value(static_cast<int64_t>(_header.frameCount), "frames"));
+    mediaInfo.push_back(Value(_header.framerate, "framerate"));
+}
+
+/*************/
+void Image_Raw::registerAttributes()
+{
+    Image::registerAttributes();
+
+    addAttribute("direct",
+        [&](const Values& args) {
+            auto direct = args[0].as<bool>();
+            if (direct == _direct)
+                return true;
+            _direct = direct;
+            // The file has to be opened again
+            if (!_filepath.empty())
+                return read(_filepath);
+            return true;
+        },
+        [&]() -> Values { return {_direct}; },
+        {'b'});
+    setAttributeDescription("direct", "If true, frames are read ahead with O_DIRECT instead of being memory mapped, bypassing the page cache");
+
+    addAttribute("framerate",
+        [&](const Values& args) {
+            _framerate = std::max(0.f, args[0].as<float>());
+            return true;
+        },
+        [&]() -> Values { return {_framerate.load()}; },
+        {'r'});
+    setAttributeDescription("framerate", "Playback framerate in frames per second, overriding the one from the file if not 0");
+
+    addAttribute("loop",
+        [&](const Values& args) {
+            _loop = args[0].as<bool>();
+            return true;
+        },
+        [&]() -> Values { return {_loop.load()}; },
+        {'b'});
+    setAttributeDescription("loop", "If true, the playback loops over the frames");
+
+    addAttribute("readahead",
+        [&](const Values& args) {
+            _readahead = std::clamp(args[0].as<int>(), 1, SPLASH_IMAGE_RAW_MAX_READAHEAD);
+            return true;
+        },
+        [&]() -> Values { return {_readahead.load()}; },
+        {'i'});
+    setAttributeDescription("readahead", "Number of frames read ahead of time during playback");
+
+    addAttribute("useClock",
+        [&](const Values& args) {
+            _useClock = args[0].as<bool>();
+            return true;
+        },
+        [&]() -> Values { return {_useClock.load()}; },
+        {'b'});
+    setAttributeDescription("useClock", "If true, the playback follows the master clock instead of starting when the file is read");
+}
+
+} // namespace Splash
@@ -0,0 +1,189 @@
+/*
+ * Copyright (C) 2026 Emmanuel Durand
+ *
+ * This file is part of Splash.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Splash is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Splash.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * @image_raw.h
+ * The Image_Raw class, playing memory mapped sequences of raw frames
+ */
+
+#ifndef SPLASH_IMAGE_RAW_H
+#define SPLASH_IMAGE_RAW_H
+
+#include <atomic>
+#include <condition_variable>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <ostream>
+
+#include "./core/constants.h"
+
+#include "./core/attribute.h"
+#include "./image/image.h"
+
+#define SPLASH_IMAGE_RAW_MAGIC "SPLRAW1"
+#define SPLASH_IMAGE_RAW_ALIGNMENT 4096
+
+namespace Splash
+{
+
+/*************/
+//! Image source playing a file of uncompressed frames, without any decoding
+//! The file starts with a header holding the frames spec, followed by the frames, each one
+//! starting on a page boundary. Frames are either memory mapped and sent as is, or read
+//! ahead with O_DIRECT to bypass the page cache.
+class Image_Raw final : public Image
+{
+  public:
+    //! Header at the start of a raw frame sequence file, followed by the serialized ImageBufferSpec
+    struct FileHeader
+    {
+        char magic[8]{SPLASH_IMAGE_RAW_MAGIC};
+        uint64_t dataOffset{0};  //!< Offset of the first frame, aligned on SPLASH_IMAGE_RAW_ALIGNMENT
+        uint64_t frameStride{0}; //!< Offset between two frames, aligned on SPLASH_IMAGE_RAW_ALIGNMENT
+        uint64_t frameCount{0};
+        double framerate{0.0}; //!< Frames per second
+        uint32_t specSize{0};  //!< Size of the serialized spec following the header
+    };
+
+  public:
+    /**
+     * \brief Constructor
+     * \param root Root object
+     */
+    Image_Raw(RootObject* root);
+
+    /**
+     * \brief Destructor
+     */
+    ~Image_Raw() final;
+
+    /**
+     * No copy constructor
+     */
+    Image_Raw(const Image_Raw&) = delete;
+    Image_Raw& operator=(const Image_Raw&) = delete;
+
+    /**
+     * \brief Set the path to read from
+     * \param filename File to read
+     * \return Return true if all went well
+     */
+    bool read(const std::string& filename) final;
+
+    /**
+     * \brief Get the offset between two frames in a file, for the given spec
+     * \param spec Frames spec
+     * \return Return the frame stride in bytes
+     */
+    static uint64_t getFrameStride(const ImageBufferSpec& spec);
+
+    /**
+     * \brief Write the header of a raw frame sequence file, padded up to the first frame
+     * Each frame has then to be written, padded to getFrameStride(spec) bytes
+     * \param stream Stream to write to
+     * \param spec Frames spec
+     * \param frameCount Number of frames
+     * \param framerate Frames per second
+     * \return Return true if all went well
+     */
+    static bool writeHeader(std::ostream& stream, const ImageBufferSpec& spec, uint64_t frameCount, double framerate);
+
+  private:
+    //! Mapping of the whole file, kept alive by the frames pointing into it
+    struct Mapping
+    {
+        uint8_t* data{nullptr};
+        size_t size{0};
+        ~Mapping();
+    };
+
+    //! File opened with O_DIRECT, kept alive by the reads still running
+    struct DirectFile
+    {
+        int fd{-1};
+        ~DirectFile();
+    };
+
+    FileHeader _header{};
+    ImageBufferSpec _frameSpec{};
+    std::shared_ptr<Mapping> _mapping{nullptr};
+    std::shared_ptr<DirectFile> _directFile{nullptr};
+
+    // Playback parameters
+    std::atomic<float> _framerate{0.f}; //!< If not 0, overrides the framerate from the file
+    std::atomic_bool _loop{true};
+    std::atomic_bool _useClock{false};
+    std::atomic_int _readahead{8};
+    bool _direct{false};
+
+    // Playback thread
+    std::mutex _playbackMutex{};
+    std::condition_variable _playbackCondition{};
+    bool _playbackRun{false};
+    std::future<void> _playbackFuture{};
+
+    /**
+     * \brief Base init for the class
+     */
+    void init();
+
+    /**
+     * \brief Stop the playback and close the file
+     */
+    void close();
+
+    /**
+     * \brief Playback loop, showing each frame at its time and reading the next ones ahead
+     */
+    void playbackThreadFunc();
+
+    /**
+     * \brief Get an image buffer pointing to the given frame in the mapping
+     * \param index Frame index
+     * \return Return the frame
+     */
+    std::unique_ptr<ImageBuffer> mapFrame(uint64_t index) const;
+
+    /**
+     * \brief Read a frame with O_DIRECT, to an aligned buffer
+     * Static so that it can run on the thread pool whatever happens to the image
+     * \param file File opened with O_DIRECT
+     * \param offset Frame offset in the file
+     * \param stride Frame stride in the file
+     * \param spec Frame spec
+     * \return Return the frame, or nullptr if it could not be read
+     */
+    static std::unique_ptr<ImageBuffer> readFrameDirect(const std::shared_ptr<DirectFile>& file, uint64_t offset, uint64_t stride, const ImageBufferSpec& spec);
+
+    /**
+     * \brief Add media info specific to this class
+     * \param mediaInfo Media info to complete
+     */
+    void updateMoreMediaInfo(Values& mediaInfo) final;
+
+    /**
+     * \brief Register new functors to modify attributes
+     */
+    void registerAttributes();
+};
+
+} // namespace Splash
+
+#endif // SPLASH_IMAGE_RAW_H
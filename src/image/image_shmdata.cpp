@@ -16,6 +16,7 @@
 #include "./utils/cgutils.h"
 #include "./utils/log.h"
 #include "./utils/osutils.h"
+#include "./utils/thread_pool.h"
 #include "./utils/timer.h"
 
 #define SPLASH_SHMDATA_THREADS 2
@@ -267,61 +268,43 @@ void Image_Shmdata::readHapFrame(void* data, int data_size)
 void Image_Shmdata::readUncompressedFrame(void* data, int /*data_size*/)
 {
     // Check if we need to resize the reader buffer
-    auto bufSpec = _readerBuffer.getSpec();
-    if (bufSpec.width != _width || bufSpec.height != _height || bufSpec.channels != _channels)
+    ImageBufferSpec spec(_width, _height, _channels, 8 * _channels, ImageBufferSpec::Type::UINT8);
+    if (_green < _blue)
+        spec.format = "BGR";
+    else
+        spec.format = "RGB";
+    if (_channels == 4)
+        spec.format.push_back('A');
+
+    // I420 is kept planar and converted to RGB in the shaders
+    if (_is420)
     {
-        ImageBufferSpec spec(_width, _height, _channels, 8 * _channels, ImageBufferSpec::Type::UINT8);
-        if (_green < _blue)
-            spec.format = "BGR";
-        else
-            spec.format = "RGB";
-        if (_channels == 4)
-            spec.format.push_back('A');
+        spec.format = "I420";
+        spec.bpp = 12;
+    }
+    else if (_is422)
+    {
+        spec.format = "UYVY";
+        spec.bpp = 16;
+    }
 
-        if (_is420 || _is422)
-        {
-            spec.format = "UYVY";
-            spec.bpp = 16;
-        }
+    // Frames are written directly to the upload buffers of the texture when possible
+    auto isSupported = (!_isYUV && (_channels == 3 || _channels == 4)) || _is420 || _is422;
+    if (isSupported && _directUpload && writeToUploadRing(data, spec))
+        return;
 
+    if (_readerBuffer.getSpec() != spec)
         _readerBuffer = ImageBuffer(spec);
-    }
 
     if (!_isYUV && (_channels == 3 || _channels == 4))
     {
-        char* pixels = (char*)(_readerBuffer).data();
-        vector<future<void>> threads;
-        for (int block = 0; block < SPLASH_SHMDATA_THREADS; ++block)
-        {
-            int size = _width * _height * _channels * sizeof(char);
-            threads.push_back(async(launch::async, [=]() {
-                int sizeOfBlock; // We compute the size of the block, to handle image size non divisible by SPLASH_SHMDATA_THREADS
-                if (size - size / SPLASH_SHMDATA_THREADS * block < 2 * size / SPLASH_SHMDATA_THREADS)
-                    sizeOfBlock = size - size / SPLASH_SHMDATA_THREADS * block;
-                else
-                    sizeOfBlock = size / SPLASH_SHMDATA_THREADS;
-
-                memcpy(pixels + size / SPLASH_SHMDATA_THREADS * block, (const char*)data + size / SPLASH_SHMDATA_THREADS * block, sizeOfBlock);
-            }));
-        }
+        copyFrame(_readerBuffer.data(), static_cast<const uint8_t*>(data), _width * _height * _channels);
     }
     else if (_is420)
     {
-        const unsigned char* Y = static_cast<const unsigned char*>(data);
-        const unsigned char* U = static_cast<const unsigned char*>(data) + _width * _height;
-        const unsigned char* V = static_cast<const unsigned char*>(data) + _width * _height * 5 / 4;
+        const unsigned char* YUV = static_cast<const unsigned char*>(data);
         char* pixels = (char*)(_readerBuffer).data();
-
-        for (uint32_t y = 0; y < _height; ++y)
-        {
-            for (uint32_t x = 0; x < _width; x += 2)
-            {
-                pixels[(x + y * _width) * 2 + 0] = U[(x / 2) + (y / 2) * (_width / 2)];
-                pixels[(x + y * _width) * 2 + 1] = Y[x + y * _width];
-                pixels[(x + y * _width) * 2 + 2] = V[(x / 2) + (y / 2) * (_width / 2)];
-                pixels[(x + y * _width) * 2 + 3] = Y[x + y * _width + 1];
-            }
-        }
+        copy(YUV, YUV + _width * _height * 3 / 2, pixels);
     }
     else if (_is422)
     {
@@ -344,9 +327,92 @@ void Image_Shmdata::readUncompressedFrame(void* data, int /*data_size*/)
         update();
 }
 
+/*************/
+void Image_Shmdata::copyFrame(uint8_t* dst, const uint8_t* src, size_t size) const
+{
+    ThreadPool::get().runParallel(SPLASH_SHMDATA_THREADS, [=](unsigned int block) {
+        // The last block gets the remainder, to handle sizes non divisible by SPLASH_SHMDATA_THREADS
+        auto blockSize = size / SPLASH_SHMDATA_THREADS;
+        auto offset = blockSize * block;
+        if (block == SPLASH_SHMDATA_THREADS - 1)
+            blockSize = size - offset;
+
+        memcpy(dst + offset, src + offset, blockSize);
+    });
+}
+
+/*************/
+bool Image_Shmdata::setUploadRing(const shared_ptr<UploadRing>& ring)
+{
+    // Copies of an image in other processes do not read the frames themselves
+    if (!_directUpload || _isConnectedToRemote)
+        return false;
+
+    lock_guard<mutex> lockRing(_uploadRingMutex);
+    // Only one texture at a time can be fed directly
+    if (_uploadRing && !_uploadRing->isClosed())
+        return false;
+
+    _uploadRing = ring;
+    return true;
+}
+
+/*************/
+bool Image_Shmdata::writeToUploadRing(const void* data, const ImageBufferSpec& spec)
+{
+    shared_ptr<UploadRing> ring;
+    {
+        lock_guard<mutex> lockRing(_uploadRingMutex);
+        ring = _uploadRing;
+    }
+
+    if (!ring)
+        return false;
+
+    // If the spec changed, the frame goes through the image buffers and the texture sets up a new ring
+    if (ring->getSpec() != spec || ring->getSlotSize() < spec.rawSize())
+        ring->close();
+
+    auto slot = ring->acquire();
+    if (slot < 0)
+    {
+        if (!ring->isClosed())
+            return true; // All slots are being uploaded, the frame is dropped
+
+        lock_guard<mutex> lockRing(_uploadRingMutex);
+        if (_uploadRing == ring)
+            _uploadRing.reset();
+        return false;
+    }
+
+    copyFrame(ring->getPixels(slot), static_cast<const uint8_t*>(data), spec.rawSize());
+    auto timestamp = Timer::getTime();
+    ring->commit(slot, timestamp);
+    updateTimestamp(timestamp);
+
+    return true;
+}
+
 /*************/
 void Image_Shmdata::registerAttributes()
 {
     Image::registerAttributes();
+
+    addAttribute("directUpload",
+        [&](const Values& args) {
+            _directUpload = args[0].as<bool>();
+            if (!_directUpload)
+            {
+                lock_guard<mutex> lockRing(_uploadRingMutex);
+                if (_uploadRing)
+                    _uploadRing->close();
+                _uploadRing.reset();
+            }
+            return true;
+        },
+        [&]() -> Values { return {_directUpload.load()}; },
+        {'b'});
+    setAttributeDescription("directUpload",
+        "If true, frames are written directly to the upload buffers of the texture when in the same process, saving two copies. The image then feeds a single texture");
 }
 }
@@ -60,6 +60,13 @@ class Image_Shmdata : public Image
      */
     bool read(const std::string& filename) final;
 
+    /**
+     * \brief Set the ring to write the next frames to, if direct upload is enabled
+     * \param ring Upload ring
+     * \return Return true if the frames are written to the ring
+     */
+    bool setUploadRing(const std::shared_ptr<UploadRing>& ring) final;
+
   private:
     Utils::ShmdataLogger _logger;
     std::unique_ptr<shmdata::Follower> _reader{nullptr};
@@ -81,6 +88,11 @@ class Image_Shmdata : public Image
     // Hap specific attributes
     std::string _textureFormat{""};
 
+    // Direct upload to the buffers of the texture
+    std::atomic_bool _directUpload{false};
+    std::mutex _uploadRingMutex{};
+    std::shared_ptr<UploadRing> _uploadRing{nullptr};
+
     /**
      * Compute some LUT (currently only the YCbCr to RGB one)
      */
@@ -115,6 +127,22 @@ class Image_Shmdata : public Image
      */
     void readUncompressedFrame(void* data, int data_size);
 
+    /**
+     * Copy a frame using SPLASH_SHMDATA_THREADS threads
+     * \param dst Destination
+     * \param src Source
+     * \param size Size to copy, in bytes
+     */
+    void copyFrame(uint8_t* dst, const uint8_t* src, size_t size) const;
+
+    /**
+     * Write an uncompressed frame to the upload ring, if one matching the frame spec is set
+     * \param data Content of the frame
+     * \param spec Spec of the frame
+     * \return Return true if the frame has been handled through the ring
+     */
+    bool writeToUploadRing(const void* data, const ImageBufferSpec& spec);
+
     /**
      * Register new functors to modify attributes
      */
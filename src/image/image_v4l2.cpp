@@ -1,7 +1,7 @@
 #include "./image/image_v4l2.h"
 
+#include <algorithm>
 #include <fcntl.h>
-#include <poll.h>
 #include <sys/mman.h>
 #include <unistd.h>
 
@@ -9,6 +9,7 @@
 #include "rgb133v4l2.h"
 #endif
 
+#include "./image/capture_multiplexer.h"
 #include "./utils/osutils.h"
 
 #define NUMERATOR 1001
@@ -26,6 +27,37 @@ Image_V4L2::Image_V4L2(RootObject* root)
     init();
 }
 
+/*************/
+Image_V4L2::MappedBuffers::~MappedBuffers()
+{
+    for (const auto& mapping : mappings)
+        if (munmap(mapping.first, mapping.second) == -1)
+            Log::get() << Log::WARNING << "Image_V4L2::MappedBuffers::" << __FUNCTION__ << " - Failed to unmap capture buffer" << Log::endl;
+}
+
+/*************/
+void Image_V4L2::MappedBuffers::requeue(uint32_t index)
+{
+    lock_guard<mutex> lock(buffersMutex);
+    if (deviceFd < 0)
+        return;
+
+    struct v4l2_buffer buffer;
+    struct v4l2_plane planes[VIDEO_MAX_PLANES];
+    memset(&buffer, 0, sizeof(buffer));
+    memset(planes, 0, sizeof(planes));
+    buffer.type = bufferType;
+    buffer.memory = V4L2_MEMORY_MMAP;
+    buffer.index = index;
+    if (bufferType == V4L2_BUF_TYPE_VIDEO_CAPTURE_MPLANE)
+    {
+        buffer.m.planes = planes;
+        buffer.length = planeCount;
+    }
+    if (xioctl(deviceFd, VIDIOC_QBUF, &buffer) < 0)
+        Log::get() << Log::WARNING << "Image_V4L2::MappedBuffers::" << __FUNCTION__ << " - Failed to requeue buffer " << index << Log::endl;
+}
+
 /*************/
 Image_V4L2::~Image_V4L2()
 {
@@ -69,13 +101,26 @@ bool Image_V4L2::doCapture()
         _capturing = initializeIOMethod();
     if (_capturing)
         _capturing = initializeCapture();
+    if (_capturing && _outputPixelFormat == V4L2_PIX_FMT_MJPEG)
+        _capturing = openDecoder();
+    if (_capturing)
+        _capturing = startStreaming();
     if (_capturing)
     {
-        _captureThreadRun = true;
-        _captureFuture = async(std::launch::async, [this]() {
-            captureThreadFunc();
-            _capturing = false;
-        });
+        // Frames are dequeued by the multiplexer thread, shared by all the capture devices
+        CaptureMultiplexer::Device device;
+        device.fd = _deviceFd;
+        device.syncGroup = _syncGroup;
+        device.dequeue = [this]() { return dequeueFrame(); };
+        device.publish = [this]() { publishFrame(); };
+#if HAVE_DATAPATH
+        if (_isDatapath)
+            device.tick = [this]() { updateSourceFormat(); };
+#endif
+        _captureDeviceId = CaptureMultiplexer::get().addDevice(std::move(device));
+        _capturing = _captureDeviceId != 0;
+        if (!_capturing)
+            stopStreaming();
     }
 
     return _capturing;
@@ -89,160 +134,57 @@ void Image_V4L2::stopCapture()
     if (!_capturing)
         return;
 
-    _captureThreadRun = false;
-    if (_captureFuture.valid())
-        _captureFuture.wait();
+    CaptureMultiplexer::get().removeDevice(_captureDeviceId);
+    _captureDeviceId = 0;
 
+    stopStreaming();
+    closeDecoder();
     closeCaptureDevice();
+    _capturing = false;
 }
 
 /*************/
-void Image_V4L2::captureThreadFunc()
+bool Image_V4L2::startStreaming()
 {
-    int result = 0;
-    struct v4l2_buffer buffer;
-    enum v4l2_buf_type bufferType;
-
     if (!_hasStreamingIO)
-    {
-        while (_captureThreadRun)
-        {
-            if (!_bufferImage || _bufferImage->getSpec() != _imageBuffers[buffer.index]->getSpec())
-                _bufferImage = make_unique<ImageBuffer>(_spec);
-
-            {
-                unique_lock<shared_mutex> lockWrite(_writeMutex);
-                result = ::read(_deviceFd, _bufferImage->data(), _spec.rawSize());
-                _imageUpdated = true;
-            }
+        return true;
 
-            if (result < 0)
-            {
-                Log::get() << Log::WARNING << "Image_V4L2::" << __FUNCTION__ << " - Failed to read from capture device " << _devicePath << Log::endl;
-                return;
-            }
+    assert(_ioMethod == V4L2_MEMORY_MMAP || _ioMethod == V4L2_MEMORY_USERPTR);
 
-            updateTimestamp();
-            if (!_isConnectedToRemote)
-                update();
-        }
-    }
-    else
+    auto bufferType = static_cast<v4l2_buf_type>(_bufferType);
+    auto result = xioctl(_deviceFd, VIDIOC_STREAMON, &bufferType);
+    if (result < 0)
     {
-        assert(_ioMethod == V4L2_MEMORY_MMAP || _ioMethod == V4L2_MEMORY_USERPTR);
-
-        bufferType = V4L2_BUF_TYPE_VIDEO_CAPTURE;
-        result = xioctl(_deviceFd, VIDIOC_STREAMON, &bufferType);
-        if (result < 0)
-        {
-            Log::get() << Log::WARNING << "Image_V4L2::" << __FUNCTION__ << " - VIDIOC_STREAMON failed: " << result << Log::endl;
-            return;
-        }
+        Log::get() << Log::WARNING << "Image_V4L2::" << __FUNCTION__ << " - VIDIOC_STREAMON failed: " << result << Log::endl;
+        return false;
+    }
 
-        // Run the capture
-        while (_captureThreadRun)
-        {
-            struct pollfd fd;
-            fd.fd = _deviceFd;
-            fd.events = POLLIN | POLLPRI;
-            fd.revents = 0;
+    return true;
+}
 
-            if (poll(&fd, 1, 50) > 0)
-            {
-                if (fd.revents & (POLLIN | POLLPRI))
-                {
-                    memset(&buffer, 0, sizeof(buffer));
-                    buffer.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
-                    buffer.memory = _ioMethod;
-
-                    result = xioctl(_deviceFd, VIDIOC_DQBUF, &buffer);
-                    if (result < 0)
-                    {
-                        switch (errno)
-                        {
-                        case EAGAIN:
-                            continue;
-                        case EIO:
-                        default:
-                            Log::get() << Log::WARNING << "Image_V4L2::" << __FUNCTION__ << " - Failed to dequeue buffer " << buffer.index << Log::endl;
-                            return;
-                        }
-                    }
-
-                    assert(buffer.index < _bufferCount);
-
-                    if (!_bufferImage || _bufferImage->getSpec() != _imageBuffers[buffer.index]->getSpec())
-                        _bufferImage = make_unique<ImageBuffer>(_spec);
-
-                    if (_ioMethod == V4L2_MEMORY_MMAP)
-                    {
-                        auto& imageBuffer = _imageBuffers[buffer.index];
-                        unique_lock<shared_mutex> lockWrite(_writeMutex);
-                        _bufferImage = make_unique<ImageBuffer>(imageBuffer->getSpec(), imageBuffer->data());
-                        _imageUpdated = true;
-                    }
-                    else if (_ioMethod == V4L2_MEMORY_USERPTR)
-                    {
-                        unique_lock<shared_mutex> lockWrite(_writeMutex);
-                        _bufferImage.swap(_imageBuffers[buffer.index]);
-                        _imageUpdated = true;
-                    }
-
-                    buffer.m.userptr = reinterpret_cast<unsigned long>(_imageBuffers[buffer.index]->data());
-                    buffer.length = _spec.rawSize();
-
-                    result = xioctl(_deviceFd, VIDIOC_QBUF, &buffer);
-                    if (result < 0)
-                    {
-                        Log::get() << Log::WARNING << "Image_V4L2::" << __FUNCTION__ << " - Failed to requeue buffer " << buffer.index << Log::endl;
-                        return;
-                    }
-
-                    updateTimestamp();
-                    if (!_isConnectedToRemote)
-                        update();
-                }
-            }
+/*************/
+void Image_V4L2::stopStreaming()
+{
+    _framePending = false;
+    _pendingImage.reset();
+    _pendingCompressedFrame.reset();
 
-#if HAVE_DATAPATH
-            // Get the source video format, for information
-            if (_isDatapath)
-            {
-                memset(&_v4l2SourceFormat, 0, sizeof(_v4l2SourceFormat));
-                _v4l2SourceFormat.type = V4L2_BUF_TYPE_CAPTURE_SOURCE;
-                if (xioctl(_deviceFd, RGB133_VIDIOC_G_SRC_FMT, &_v4l2SourceFormat) >= 0)
-                {
-                    auto sourceFormatAsString = to_string(_v4l2SourceFormat.fmt.pix.width) + "x" + to_string(_v4l2SourceFormat.fmt.pix.height) + string("@") +
-                                                to_string((float)_v4l2SourceFormat.fmt.pix.priv / 1000.f) + "Hz, format " +
-                                                string(reinterpret_cast<char*>(&_v4l2SourceFormat.fmt.pix.pixelformat), 4);
-
-                    if (!_automaticResizing)
-                    {
-                        if (_outputWidth != _v4l2SourceFormat.fmt.pix.width || _outputHeight != _v4l2SourceFormat.fmt.pix.height)
-                        {
-                            _automaticResizing = true;
-                            addTask([=]() {
-                                stopCapture();
-                                _outputWidth = std::max(320u, _v4l2SourceFormat.fmt.pix.width);
-                                _outputHeight = std::max(240u, _v4l2SourceFormat.fmt.pix.height);
-                                doCapture();
-                                _automaticResizing = false;
-                            });
-                        }
-                    }
-
-                    _sourceFormatAsString = sourceFormatAsString;
-                }
-            }
-#endif
+    if (_hasStreamingIO)
+    {
+        // Buffers released from now on must not be queued anymore
+        if (_mappedBuffers)
+        {
+            lock_guard<mutex> lock(_mappedBuffers->buffersMutex);
+            _mappedBuffers->deviceFd = -1;
         }
 
-        bufferType = V4L2_BUF_TYPE_VIDEO_CAPTURE;
-        result = xioctl(_deviceFd, VIDIOC_STREAMOFF, &bufferType);
+        auto bufferType = static_cast<v4l2_buf_type>(_bufferType);
+        auto result = xioctl(_deviceFd, VIDIOC_STREAMOFF, &bufferType);
         if (result < 0)
             Log::get() << Log::WARNING << "Image_V4L2::" << __FUNCTION__ << " - VIDIOC_STREAMOFF failed: " << result << Log::endl;
 
-        for (uint32_t i = 0; i < _bufferCount; ++i)
+        struct v4l2_buffer buffer;
+        for (uint32_t i = 0; _ioMethod == V4L2_MEMORY_USERPTR && i < _bufferCount; ++i)
         {
             memset(&buffer, 0, sizeof(buffer));
             buffer.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
@@ -261,10 +203,315 @@ void Image_V4L2::captureThreadFunc()
     updateTimestamp();
 }
 
+/*************/
+bool Image_V4L2::dequeueFrame()
+{
+    if (!_hasStreamingIO)
+    {
+        if (!_pendingImage || _pendingImage->getSpec() != _spec)
+            _pendingImage = make_unique<ImageBuffer>(_spec);
+
+        if (::read(_deviceFd, _pendingImage->data(), _spec.rawSize()) < 0)
+        {
+            if (errno == EAGAIN)
+                return true;
+            Log::get() << Log::WARNING << "Image_V4L2::" << __FUNCTION__ << " - Failed to read from capture device " << _devicePath << Log::endl;
+            addTask([this]() { stopCapture(); });
+            return false;
+        }
+
+        _framePending = true;
+        return true;
+    }
+
+    struct v4l2_buffer buffer;
+    struct v4l2_plane planes[VIDEO_MAX_PLANES];
+    memset(&buffer, 0, sizeof(buffer));
+    memset(planes, 0, sizeof(planes));
+    buffer.type = _bufferType;
+    buffer.memory = _ioMethod;
+    if (_bufferType == V4L2_BUF_TYPE_VIDEO_CAPTURE_MPLANE)
+    {
+        buffer.m.planes = planes;
+        buffer.length = _planeCount;
+    }
+
+    if (xioctl(_deviceFd, VIDIOC_DQBUF, &buffer) < 0)
+    {
+        if (errno == EAGAIN)
+            return true;
+        Log::get() << Log::WARNING << "Image_V4L2::" << __FUNCTION__ << " - Failed to dequeue buffer " << buffer.index << Log::endl;
+        addTask([this]() { stopCapture(); });
+        return false;
+    }
+
+    // A frame still pending is replaced by the newer one, its buffer being released or reused
+    if (_ioMethod == V4L2_MEMORY_MMAP)
+    {
+        assert((buffer.index + 1) * _planeCount <= _mappedBuffers->mappings.size());
+
+        auto mappedBuffers = _mappedBuffers;
+        auto index = buffer.index;
+        auto requeue = [mappedBuffers, index](uint8_t*) { mappedBuffers->requeue(index); };
+        const auto& mapping = _mappedBuffers->mappings[buffer.index * _planeCount];
+
+        if (_outputPixelFormat == V4L2_PIX_FMT_MJPEG)
+        {
+            // The driver buffer is queued back once decoded, or when replaced by a newer frame
+            auto bytesUsed = _bufferType == V4L2_BUF_TYPE_VIDEO_CAPTURE_MPLANE ? planes[0].bytesused : buffer.bytesused;
+            _pendingCompressedFrame = make_unique<ResizableArray<uint8_t>>(static_cast<uint8_t*>(mapping.first), std::min<size_t>(bytesUsed, mapping.second), requeue);
+        }
+        else if (_wrapBuffers)
+        {
+            // The image wraps the driver buffer, which is queued back once the image is released
+            auto frame = ResizableArray<uint8_t>(static_cast<uint8_t*>(mapping.first), _spec.rawSize(), requeue);
+            _pendingImage = make_unique<ImageBuffer>(_spec, std::move(frame));
+        }
+        else
+        {
+            vector<const uint8_t*> planePointers;
+            for (uint32_t plane = 0; plane < _planeCount; ++plane)
+                planePointers.push_back(static_cast<const uint8_t*>(_mappedBuffers->mappings[buffer.index * _planeCount + plane].first));
+            _pendingImage = copyPlanes(planePointers);
+            _mappedBuffers->requeue(buffer.index);
+        }
+    }
+    else if (_ioMethod == V4L2_MEMORY_USERPTR)
+    {
+        assert(buffer.index < _imageBuffers.size());
+
+        if (!_pendingImage || _pendingImage->getSpec() != _imageBuffers[buffer.index]->getSpec())
+            _pendingImage = make_unique<ImageBuffer>(_spec);
+        _pendingImage.swap(_imageBuffers[buffer.index]);
+
+        buffer.m.userptr = reinterpret_cast<unsigned long>(_imageBuffers[buffer.index]->data());
+        buffer.length = _spec.rawSize();
+
+        if (xioctl(_deviceFd, VIDIOC_QBUF, &buffer) < 0)
+        {
+            Log::get() << Log::WARNING << "Image_V4L2::" << __FUNCTION__ << " - Failed to requeue buffer " << buffer.index << Log::endl;
+            addTask([this]() { stopCapture(); });
+            return false;
+        }
+    }
+
+    _framePending = true;
+    return true;
+}
+
+/*************/
+void Image_V4L2::publishFrame()
+{
+    if (!_framePending)
+        return;
+    _framePending = false;
+
+    // Compressed frames are signaled once decoded
+    if (_pendingCompressedFrame)
+    {
+        {
+            lock_guard<mutex> lockDecode(_decodeMutex);
+            _compressedFrame = std::move(_pendingCompressedFrame);
+        }
+        _decodeCondition.notify_one();
+        return;
+    }
+
+    {
+        unique_lock<shared_mutex> lockWrite(_writeMutex);
+        // Images not wrapping driver buffers are kept to receive the next frames, instead of being reallocated
+        if (!_hasStreamingIO || _ioMethod == V4L2_MEMORY_USERPTR)
+            _bufferImage.swap(_pendingImage);
+        else
+            _bufferImage = std::move(_pendingImage);
+        _imageUpdated = true;
+    }
+
+    updateTimestamp();
+    if (!_isConnectedToRemote)
+        update();
+}
+
+#if HAVE_DATAPATH
+/*************/
+void Image_V4L2::updateSourceFormat()
+{
+    // Get the source video format, for information
+    memset(&_v4l2SourceFormat, 0, sizeof(_v4l2SourceFormat));
+    _v4l2SourceFormat.type = V4L2_BUF_TYPE_CAPTURE_SOURCE;
+    if (xioctl(_deviceFd, RGB133_VIDIOC_G_SRC_FMT, &_v4l2SourceFormat) < 0)
+        return;
+
+    auto sourceFormatAsString = to_string(_v4l2SourceFormat.fmt.pix.width) + "x" + to_string(_v4l2SourceFormat.fmt.pix.height) + string("@") +
+                                to_string((float)_v4l2SourceFormat.fmt.pix.priv / 1000.f) + "Hz, format " +
+                                string(reinterpret_cast<char*>(&_v4l2SourceFormat.fmt.pix.pixelformat), 4);
+
+    if (!_automaticResizing)
+    {
+        if (_outputWidth != _v4l2SourceFormat.fmt.pix.width || _outputHeight != _v4l2SourceFormat.fmt.pix.height)
+        {
+            _automaticResizing = true;
+            addTask([=]() {
+                stopCapture();
+                _outputWidth = std::max(320u, _v4l2SourceFormat.fmt.pix.width);
+                _outputHeight = std::max(240u, _v4l2SourceFormat.fmt.pix.height);
+                doCapture();
+                _automaticResizing = false;
+            });
+        }
+    }
+
+    _sourceFormatAsString = sourceFormatAsString;
+}
+#endif
+
+/*************/
+void Image_V4L2::decodeThreadFunc()
+{
+    unique_ptr<ImageBuffer> image;
+
+    while (true)
+    {
+        unique_ptr<ResizableArray<uint8_t>> compressedFrame;
+        {
+            unique_lock<mutex> lockDecode(_decodeMutex);
+            _decodeCondition.wait(lockDecode, [&]() { return !_decodeThreadRun || _compressedFrame; });
+            if (!_decodeThreadRun)
+                return;
+            compressedFrame.swap(_compressedFrame);
+        }
+
+        // The packet is not reference counted, so the decoder copies it and the driver buffer can be queued back right away
+        _decoderPacket->data = compressedFrame->data();
+        _decoderPacket->size = static_cast<int>(compressedFrame->size());
+        auto result = avcodec_send_packet(_decoderContext, _decoderPacket);
+        compressedFrame.reset();
+        if (result < 0)
+        {
+            Log::get() << Log::WARNING << "Image_V4L2::" << __FUNCTION__ << " - Failed to decode a compressed frame" << Log::endl;
+            continue;
+        }
+
+        while (avcodec_receive_frame(_decoderContext, _decodedFrame) == 0)
+        {
+            // UVC cameras mostly send 4:2:2 JPEG frames, which are converted to 4:2:0 and limited range
+            auto width = _decodedFrame->width & ~1;
+            auto height = _decodedFrame->height & ~1;
+            ImageBufferSpec spec(width, height, 3, 12, ImageBufferSpec::Type::UINT8, "I420");
+            if (!image || image->getSpec() != spec)
+                image = make_unique<ImageBuffer>(spec);
+
+            uint8_t* dstData[4];
+            int dstLinesize[4];
+            av_image_fill_arrays(dstData, dstLinesize, image->data(), AV_PIX_FMT_YUV420P, width, height, 1);
+
+            _swsContext = sws_getCachedContext(
+                _swsContext, width, height, static_cast<AVPixelFormat>(_decodedFrame->format), width, height, AV_PIX_FMT_YUV420P, SWS_BILINEAR, nullptr, nullptr, nullptr);
+            if (!_swsContext)
+            {
+                Log::get() << Log::WARNING << "Image_V4L2::" << __FUNCTION__ << " - Unsupported decoded pixel format" << Log::endl;
+                av_frame_unref(_decodedFrame);
+                continue;
+            }
+            sws_scale(_swsContext, (const uint8_t* const*)_decodedFrame->data, _decodedFrame->linesize, 0, height, dstData, dstLinesize);
+            av_frame_unref(_decodedFrame);
+
+            {
+                unique_lock<shared_mutex> lockWrite(_writeMutex);
+                _bufferImage.swap(image);
+                _imageUpdated = true;
+            }
+
+            updateTimestamp();
+            if (!_isConnectedToRemote)
+                update();
+        }
+    }
+}
+
+/*************/
+bool Image_V4L2::openDecoder()
+{
+    auto codec = avcodec_find_decoder(AV_CODEC_ID_MJPEG);
+    if (!codec)
+    {
+        Log::get() << Log::WARNING << "Image_V4L2::" << __FUNCTION__ << " - MJPEG decoder not found" << Log::endl;
+        return false;
+    }
+
+    _decoderContext = avcodec_alloc_context3(codec);
+    _decoderPacket = av_packet_alloc();
+    _decodedFrame = av_frame_alloc();
+    if (!_decoderContext || !_decoderPacket || !_decodedFrame || avcodec_open2(_decoderContext, codec, nullptr) < 0)
+    {
+        Log::get() << Log::WARNING << "Image_V4L2::" << __FUNCTION__ << " - Unable to open the MJPEG decoder" << Log::endl;
+        closeDecoder();
+        return false;
+    }
+
+    _decodeThreadRun = true;
+    _decodeFuture = async(std::launch::async, [this]() { decodeThreadFunc(); });
+
+    return true;
+}
+
+/*************/
+void Image_V4L2::closeDecoder()
+{
+    {
+        lock_guard<mutex> lockDecode(_decodeMutex);
+        _decodeThreadRun = false;
+        _compressedFrame.reset();
+    }
+    _decodeCondition.notify_one();
+
+    if (_decodeFuture.valid())
+        _decodeFuture.wait();
+
+    avcodec_free_context(&_decoderContext);
+    av_packet_free(&_decoderPacket);
+    av_frame_free(&_decodedFrame);
+    sws_freeContext(_swsContext);
+    _swsContext = nullptr;
+}
+
+/*************/
+unique_ptr<ImageBuffer> Image_V4L2::copyPlanes(const vector<const uint8_t*>& planes) const
+{
+    auto image = make_unique<ImageBuffer>(_spec);
+    auto pixels = image->data();
+
+    // With a single memory plane, the frame planes follow each other using the same stride
+    auto source = planes[0];
+    for (uint32_t plane = 0; plane < _frameLayout.size(); ++plane)
+    {
+        auto memoryPlane = std::min<uint32_t>(plane, _planeCount - 1);
+        if (memoryPlane == plane && plane > 0)
+            source = planes[memoryPlane];
+
+        uint32_t stride = _bufferType == V4L2_BUF_TYPE_VIDEO_CAPTURE_MPLANE ? _v4l2Format.fmt.pix_mp.plane_fmt[memoryPlane].bytesperline : _v4l2Format.fmt.pix.bytesperline;
+        const auto& [rowSize, rowCount] = _frameLayout[plane];
+        stride = std::max(stride, rowSize);
+
+        for (uint32_t row = 0; row < rowCount; ++row)
+        {
+            memcpy(pixels, source, rowSize);
+            pixels += rowSize;
+            source += stride;
+        }
+    }
+
+    return image;
+}
+
 /*************/
 bool Image_V4L2::initializeIOMethod()
 {
-    if (initializeUserPtr())
+    // Compressed frames are smaller than the decoded image, and multi planar frames need one pointer per plane,
+    // both are only handled with memory mapped buffers
+    auto userPtrSupported = _bufferType == V4L2_BUF_TYPE_VIDEO_CAPTURE && _outputPixelFormat != V4L2_PIX_FMT_MJPEG;
+
+    if (userPtrSupported && initializeUserPtr())
     {
         Log::get() << Log::MESSAGE << "Image_V4L2::" << __FUNCTION__ << " - Initialized device " << _devicePath << " with user pointer io method" << Log::endl;
         _ioMethod = V4L2_MEMORY_USERPTR;
@@ -285,8 +532,8 @@ bool Image_V4L2::initializeIOMethod()
 bool Image_V4L2::initializeMemoryMap()
 {
     memset(&_v4l2RequestBuffers, 0, sizeof(_v4l2RequestBuffers));
-    _v4l2RequestBuffers.count = _bufferCount;
-    _v4l2RequestBuffers.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+    _v4l2RequestBuffers.count = _mmapBufferCount;
+    _v4l2RequestBuffers.type = _bufferType;
     _v4l2RequestBuffers.memory = V4L2_MEMORY_MMAP;
 
     if (xioctl(_deviceFd, VIDIOC_REQBUFS, &_v4l2RequestBuffers))
@@ -303,7 +550,7 @@ bool Image_V4L2::initializeUserPtr()
 {
     memset(&_v4l2RequestBuffers, 0, sizeof(_v4l2RequestBuffers));
     _v4l2RequestBuffers.count = _bufferCount;
-    _v4l2RequestBuffers.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+    _v4l2RequestBuffers.type = _bufferType;
     _v4l2RequestBuffers.memory = V4L2_MEMORY_USERPTR;
 
     int result = xioctl(_deviceFd, VIDIOC_REQBUFS, &_v4l2RequestBuffers);
@@ -386,13 +633,26 @@ bool Image_V4L2::initializeCapture()
     {
         int result;
         struct v4l2_buffer buffer;
+        struct v4l2_plane planes[VIDEO_MAX_PLANES];
 
-        for (uint32_t i = 0; i < _bufferCount; ++i)
+        _mappedBuffers = make_shared<MappedBuffers>();
+        _mappedBuffers->deviceFd = _deviceFd;
+        _mappedBuffers->bufferType = _bufferType;
+        _mappedBuffers->planeCount = _planeCount;
+
+        // The driver may have allocated a different number of buffers than requested
+        for (uint32_t i = 0; i < _v4l2RequestBuffers.count; ++i)
         {
             memset(&buffer, 0, sizeof(buffer));
-            buffer.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+            memset(planes, 0, sizeof(planes));
+            buffer.type = _bufferType;
             buffer.memory = V4L2_MEMORY_MMAP;
             buffer.index = i;
+            if (_bufferType == V4L2_BUF_TYPE_VIDEO_CAPTURE_MPLANE)
+            {
+                buffer.m.planes = planes;
+                buffer.length = _planeCount;
+            }
 
             result = xioctl(_deviceFd, VIDIOC_QUERYBUF, &buffer);
             if (result < 0)
@@ -401,14 +661,26 @@ bool Image_V4L2::initializeCapture()
                 return false;
             }
 
-            auto mappedMemory = mmap(nullptr, buffer.length, PROT_READ | PROT_WRITE, MAP_SHARED, _deviceFd, buffer.m.offset);
-            if (mappedMemory == MAP_FAILED)
+            for (uint32_t plane = 0; plane < _planeCount; ++plane)
             {
-                Log::get() << Log::WARNING << "Image_V4L2::" << __FUNCTION__ << " - Error while calling mmap: " << result << Log::endl;
-                return false;
+                auto length = _bufferType == V4L2_BUF_TYPE_VIDEO_CAPTURE_MPLANE ? planes[plane].length : buffer.length;
+                auto offset = _bufferType == V4L2_BUF_TYPE_VIDEO_CAPTURE_MPLANE ? planes[plane].m.mem_offset : buffer.m.offset;
+
+                auto mappedMemory = mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_SHARED, _deviceFd, offset);
+                if (mappedMemory == MAP_FAILED)
+                {
+                    Log::get() << Log::WARNING << "Image_V4L2::" << __FUNCTION__ << " - Error while calling mmap: " << result << Log::endl;
+                    return false;
+                }
+
+                _mappedBuffers->mappings.emplace_back(mappedMemory, length);
             }
 
-            _imageBuffers.push_back(make_unique<ImageBuffer>(_spec, static_cast<uint8_t*>(mappedMemory), true));
+            if (_outputPixelFormat != V4L2_PIX_FMT_MJPEG && _wrapBuffers && _mappedBuffers->mappings.back().second < _spec.rawSize())
+            {
+                Log::get() << Log::WARNING << "Image_V4L2::" << __FUNCTION__ << " - Capture buffer is smaller than the captured frame" << Log::endl;
+                return false;
+            }
 
             result = xioctl(_deviceFd, VIDIOC_QBUF, &buffer);
             if (result < 0)
@@ -496,9 +768,15 @@ bool Image_V4L2::openCaptureDevice(const std::string& devicePath)
         return false;
     }
 
+    // Multi planar API is only used for devices which do not support the single planar one
+    if (_v4l2Capability.capabilities & V4L2_CAP_VIDEO_CAPTURE)
+        _bufferType = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+    else if (_v4l2Capability.capabilities & V4L2_CAP_VIDEO_CAPTURE_MPLANE)
+        _bufferType = V4L2_BUF_TYPE_VIDEO_CAPTURE_MPLANE;
+
     if (!_capabilitiesEnumerated)
     {
-        if (_v4l2Capability.capabilities & V4L2_CAP_VIDEO_CAPTURE)
+        if (_v4l2Capability.capabilities & (V4L2_CAP_VIDEO_CAPTURE | V4L2_CAP_VIDEO_CAPTURE_MPLANE))
         {
             if (!enumerateCaptureDeviceInputs())
                 Log::get() << Log::WARNING << "Image_V4L2::" << __FUNCTION__ << " - Failed to enumerate capture inputs" << Log::endl;
@@ -543,11 +821,21 @@ bool Image_V4L2::openCaptureDevice(const std::string& devicePath)
 
     // Try setting the video format
     memset(&_v4l2Format, 0, sizeof(_v4l2Format));
-    _v4l2Format.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
-    _v4l2Format.fmt.pix.width = _outputWidth;
-    _v4l2Format.fmt.pix.height = _outputHeight;
-    _v4l2Format.fmt.pix.field = V4L2_FIELD_NONE;
-    _v4l2Format.fmt.pix.pixelformat = _outputPixelFormat;
+    _v4l2Format.type = _bufferType;
+    if (_bufferType == V4L2_BUF_TYPE_VIDEO_CAPTURE_MPLANE)
+    {
+        _v4l2Format.fmt.pix_mp.width = _outputWidth;
+        _v4l2Format.fmt.pix_mp.height = _outputHeight;
+        _v4l2Format.fmt.pix_mp.field = V4L2_FIELD_NONE;
+        _v4l2Format.fmt.pix_mp.pixelformat = _outputPixelFormat;
+    }
+    else
+    {
+        _v4l2Format.fmt.pix.width = _outputWidth;
+        _v4l2Format.fmt.pix.height = _outputHeight;
+        _v4l2Format.fmt.pix.field = V4L2_FIELD_NONE;
+        _v4l2Format.fmt.pix.pixelformat = _outputPixelFormat;
+    }
 
     if (xioctl(_deviceFd, VIDIOC_S_FMT, &_v4l2Format) < 0)
         Log::get() << Log::WARNING << "Image_V4L2::" << __FUNCTION__ << " - Unable to set the desired video format, trying to revert to the original one" << Log::endl;
@@ -557,7 +845,7 @@ bool Image_V4L2::openCaptureDevice(const std::string& devicePath)
 
     // Get the real video format
     memset(&_v4l2Format, 0, sizeof(_v4l2Format));
-    _v4l2Format.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+    _v4l2Format.type = _bufferType;
     if (xioctl(_deviceFd, VIDIOC_G_FMT, &_v4l2Format) < 0)
     {
         Log::get() << Log::WARNING << "Image_V4L2::" << __FUNCTION__ << " - Failed to get capture video format" << Log::endl;
@@ -565,9 +853,25 @@ bool Image_V4L2::openCaptureDevice(const std::string& devicePath)
         return false;
     }
 
-    _outputWidth = _v4l2Format.fmt.pix.width;
-    _outputHeight = _v4l2Format.fmt.pix.height;
-    _outputPixelFormat = _v4l2Format.fmt.pix.pixelformat;
+    // Row strides of each memory plane, 0 meaning that rows are not padded
+    vector<uint32_t> bytesPerLine;
+    if (_bufferType == V4L2_BUF_TYPE_VIDEO_CAPTURE_MPLANE)
+    {
+        _outputWidth = _v4l2Format.fmt.pix_mp.width;
+        _outputHeight = _v4l2Format.fmt.pix_mp.height;
+        _outputPixelFormat = _v4l2Format.fmt.pix_mp.pixelformat;
+        _planeCount = std::clamp<uint32_t>(_v4l2Format.fmt.pix_mp.num_planes, 1, VIDEO_MAX_PLANES);
+        for (uint32_t plane = 0; plane < _planeCount; ++plane)
+            bytesPerLine.push_back(_v4l2Format.fmt.pix_mp.plane_fmt[plane].bytesperline);
+    }
+    else
+    {
+        _outputWidth = _v4l2Format.fmt.pix.width;
+        _outputHeight = _v4l2Format.fmt.pix.height;
+        _outputPixelFormat = _v4l2Format.fmt.pix.pixelformat;
+        _planeCount = 1;
+        bytesPerLine.push_back(_v4l2Format.fmt.pix.bytesperline);
+    }
 
     Log::get() << Log::MESSAGE << "Image_V4L2::" << __FUNCTION__ << " - Capture format set to: " << _outputWidth << "x" << _outputHeight << " for format "
                << string(reinterpret_cast<char*>(&_outputPixelFormat), 4) << Log::endl;
@@ -586,8 +890,34 @@ bool Image_V4L2::openCaptureDevice(const std::string& devicePath)
     case V4L2_PIX_FMT_YUYV:
         _spec = ImageBufferSpec(_outputWidth, _outputHeight, 3, 16, ImageBufferSpec::Type::UINT8, "YUYV");
         break;
+    case V4L2_PIX_FMT_NV12:
+    case V4L2_PIX_FMT_NV12M:
+        _spec = ImageBufferSpec(_outputWidth, _outputHeight, 3, 12, ImageBufferSpec::Type::UINT8, "NV12");
+        break;
+    case V4L2_PIX_FMT_MJPEG:
+        // Frames are decoded to I420, which needs even dimensions
+        _spec = ImageBufferSpec(_outputWidth & ~1u, _outputHeight & ~1u, 3, 12, ImageBufferSpec::Type::UINT8, "I420");
+        break;
+    }
+
+    if (!_hasStreamingIO && (_bufferType == V4L2_BUF_TYPE_VIDEO_CAPTURE_MPLANE || _outputPixelFormat == V4L2_PIX_FMT_MJPEG))
+    {
+        Log::get() << Log::WARNING << "Image_V4L2::" << __FUNCTION__ << " - Multi planar and compressed formats need a device supporting streaming I/O" << Log::endl;
+        closeCaptureDevice();
+        return false;
     }
 
+    // Frames can be wrapped as is only if their planes are contiguous, without any row padding
+    if (_outputPixelFormat == V4L2_PIX_FMT_NV12 || _outputPixelFormat == V4L2_PIX_FMT_NV12M)
+        _frameLayout = {{_outputWidth, _outputHeight}, {_outputWidth, _outputHeight / 2}};
+    else
+        _frameLayout = {{static_cast<uint32_t>(_spec.rawSize() / std::max(_outputHeight, 1u)), _outputHeight}};
+
+    _wrapBuffers = _planeCount == 1;
+    for (const auto& plane : _frameLayout)
+        if (bytesPerLine[0] != 0 && bytesPerLine[0] != plane.first)
+            _wrapBuffers = false;
+
     return true;
 }
 
@@ -598,11 +928,11 @@ void Image_V4L2::closeCaptureDevice()
     _v4l2Standards.clear();
     _v4l2Formats.clear();
 
+    // The buffers are unmapped once the last image wrapping one of them is released
     if (_ioMethod == V4L2_MEMORY_MMAP)
     {
-        for (auto& buffer : _imageBuffers)
-            if (munmap(buffer->data(), buffer->getSize()) == -1)
-                Log::get() << Log::WARNING << "Image_V4L2::" << __FUNCTION__ << " - Failed to unmap buffer for device " << _devicePath << Log::endl;
+        _imageBuffers.clear();
+        _mappedBuffers.reset();
     }
 
     if (_deviceFd >= 0)
@@ -660,7 +990,7 @@ bool Image_V4L2::enumerateCaptureFormats()
 
     memset(&format, 0, sizeof(format));
     format.index = 0;
-    format.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+    format.type = _bufferType;
 
     _v4l2FormatCount = 0;
     while (xioctl(_deviceFd, VIDIOC_ENUM_FMT, &format) >= 0)
@@ -673,7 +1003,7 @@ bool Image_V4L2::enumerateCaptureFormats()
     for (int i = 0; i < _v4l2FormatCount; ++i)
     {
         _v4l2Formats[i].index = i;
-        _v4l2Formats[i].type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+        _v4l2Formats[i].type = _bufferType;
 
         if (xioctl(_deviceFd, VIDIOC_ENUM_FMT, &_v4l2Formats[i]) < 0)
         {
@@ -730,6 +1060,11 @@ void Image_V4L2::updateMoreMediaInfo(Values& mediaInfo)
 {
     mediaInfo.push_back(Value(_devicePath, "devicePath"));
     mediaInfo.push_back(Value(_v4l2Index, "v4l2Index"));
+    if (!_syncGroup.empty())
+    {
+        mediaInfo.push_back(Value(_syncGroup, "syncGroup"));
+        mediaInfo.push_back(Value(CaptureMultiplexer::get().getSyncSkew(_syncGroup), "syncSkew"));
+    }
 }
 
 /*************/
@@ -831,6 +1166,20 @@ void Image_V4L2::registerAttributes()
         {'i'});
     setAttributeDescription("index", "Set the input index for the selected V4L2 capture device");
 
+    addAttribute("syncGroup",
+        [&](const Values& args) {
+            auto isCapturing = _capturing;
+            stopCapture();
+            _syncGroup = args[0].as<string>();
+            if (isCapturing)
+                scheduleCapture();
+
+            return true;
+        },
+        [&]() -> Values { return {_syncGroup}; },
+        {'s'});
+    setAttributeDescription("syncGroup", "Capture devices sharing the same sync group are updated together, for synchronized multiple inputs. Leave empty to update as soon as possible");
+
     addAttribute("sourceFormat", [&](const Values&) { return true; }, [&]() -> Values { return {_sourceFormatAsString}; }, {});
 
     addAttribute("pixelFormat",
@@ -845,6 +1194,10 @@ void Image_V4L2::registerAttributes()
                 _outputPixelFormat = V4L2_PIX_FMT_BGR24;
             else if (format.find("YUYV") != string::npos)
                 _outputPixelFormat = V4L2_PIX_FMT_YUYV;
+            else if (format.find("NV12") != string::npos)
+                _outputPixelFormat = V4L2_PIX_FMT_NV12;
+            else if (format.find("MJPEG") != string::npos)
+                _outputPixelFormat = V4L2_PIX_FMT_MJPEG;
             else
                 _outputPixelFormat = V4L2_PIX_FMT_RGB24;
 
@@ -869,11 +1222,18 @@ void Image_V4L2::registerAttributes()
             case V4L2_PIX_FMT_YUYV:
                 format = "YUYV";
                 break;
+            case V4L2_PIX_FMT_NV12:
+            case V4L2_PIX_FMT_NV12M:
+                format = "NV12";
+                break;
+            case V4L2_PIX_FMT_MJPEG:
+                format = "MJPEG";
+                break;
             }
             return {format};
         },
         {'s'});
-    setAttributeDescription("pixelFormat", "Set the desired output format, either RGB or YUYV");
+    setAttributeDescription("pixelFormat", "Set the desired output format, either RGB, BGR, YUYV, NV12 or MJPEG (decoded to I420)");
 }
 
 } // namespace Splash
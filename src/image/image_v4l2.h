@@ -26,13 +26,23 @@
 #define SPLASH_IMAGE_V4L2_H
 
 #include <atomic>
+#include <condition_variable>
 #include <deque>
 #include <future>
+#include <memory>
 #include <mutex>
+#include <vector>
 
 #include <linux/videodev2.h>
 
+extern "C" {
+#include <libavcodec/avcodec.h>
+#include <libavutil/imgutils.h>
+#include <libswscale/swscale.h>
+}
+
 #include "./core/constants.h"
+#include "./image/capture_multiplexer.h"
 #include "./image/image.h"
 
 namespace Splash
@@ -67,6 +77,8 @@ class Image_V4L2 : public Image
     std::unordered_map<std::string, Values> _shaderUniforms;
 
     uint32_t _ioMethod{0};
+    uint32_t _bufferType{V4L2_BUF_TYPE_VIDEO_CAPTURE}; //!< Either single or multi planar capture, depending on the device
+    uint32_t _planeCount{1};                            //!< Number of memory planes per capture buffer
 
     // File descriptors
     int _deviceFd{-1};
@@ -100,22 +112,108 @@ class Image_V4L2 : public Image
     // Capture buffers;
     struct v4l2_requestbuffers _v4l2RequestBuffers;
     static const uint32_t _bufferCount{1};
+    static const uint32_t _mmapBufferCount{4}; //!< Memory mapped buffers are held by the images wrapping them, more are needed
     std::deque<std::unique_ptr<ImageBuffer>> _imageBuffers{};
 
-    bool _shouldCapture{false};    //!< True if the device should start capturing
-    bool _capturing{false};        //!< True if currently capturing frames
-    bool _captureThreadRun{false}; //!< Set to false to stop the capture thread
+    //! Memory mapped capture buffers, shared with the images wrapping them
+    //! A buffer is queued back to the driver once the image wrapping it is released,
+    //! and the buffers are only unmapped once no image wraps them anymore.
+    struct MappedBuffers
+    {
+        std::mutex buffersMutex{};
+        int deviceFd{-1}; //!< Set to -1 when streaming stops, so that released buffers are not queued anymore
+        uint32_t bufferType{V4L2_BUF_TYPE_VIDEO_CAPTURE};
+        uint32_t planeCount{1};
+        std::vector<std::pair<void*, size_t>> mappings{}; //!< One mapping per plane, for each buffer
+
+        ~MappedBuffers();
+
+        /**
+         * Queue the given buffer back to the driver, if still streaming
+         * \param index Buffer index
+         */
+        void requeue(uint32_t index);
+    };
+    std::shared_ptr<MappedBuffers> _mappedBuffers{nullptr};
+
+    bool _shouldCapture{false}; //!< True if the device should start capturing
+    bool _capturing{false};     //!< True if currently capturing frames
     std::mutex _startStopMutex{};
     std::atomic_bool _automaticResizing{false};
 
     ImageBufferSpec _spec{};
+    std::vector<std::pair<uint32_t, uint32_t>> _frameLayout{}; //!< Row size and row count of each plane of the captured frames, once packed
+    bool _wrapBuffers{true};                                   //!< True if the captured frames are contiguous, and can be wrapped as is
+
+    // Capture through the CaptureMultiplexer, the following members being only accessed from its thread while capturing
+    std::string _syncGroup{};                                                  //!< Devices of the same sync group are updated together
+    uint64_t _captureDeviceId{0};                                              //!< Id of the device in the multiplexer, 0 if not capturing
+    bool _framePending{false};                                                 //!< True if a frame has been dequeued and not published yet
+    std::unique_ptr<ImageBuffer> _pendingImage{nullptr};                       //!< Last dequeued frame, also kept to receive the next one if it does not wrap a driver buffer
+    std::unique_ptr<ResizableArray<uint8_t>> _pendingCompressedFrame{nullptr}; //!< Last dequeued compressed frame
+
+    // MJPEG decoding, done in a dedicated thread so that the capture thread keeps dequeuing buffers
+    AVCodecContext* _decoderContext{nullptr};
+    AVPacket* _decoderPacket{nullptr};
+    AVFrame* _decodedFrame{nullptr};
+    SwsContext* _swsContext{nullptr};
+    std::mutex _decodeMutex{};
+    std::condition_variable _decodeCondition{};
+    std::unique_ptr<ResizableArray<uint8_t>> _compressedFrame{nullptr}; //!< Last compressed frame, dropped if not decoded before the next one
+    bool _decodeThreadRun{false};
+    std::future<void> _decodeFuture{};
+
+    /**
+     * Start streaming from the device, if it supports streaming
+     * \return Return true if the device is ready to deliver frames
+     */
+    bool startStreaming();
+
+    /**
+     * Stop streaming from the device, and reset the image
+     */
+    void stopStreaming();
+
+    /**
+     * Dequeue the ready frame from the device, replacing the pending one if any. Called by the CaptureMultiplexer
+     * \return Return false if the device failed, in which case the capture is stopped
+     */
+    bool dequeueFrame();
+
+    /**
+     * Make the pending frame the current image, or send it to the decoder. Called by the CaptureMultiplexer
+     */
+    void publishFrame();
 
-    std::future<void> _captureFuture{};
+#if HAVE_DATAPATH
+    /**
+     * Get the source format from the Datapath card, and resize the capture to match it
+     */
+    void updateSourceFormat();
+#endif
+
+    /**
+     * Decoding thread function, converts the compressed frames to I420
+     */
+    void decodeThreadFunc();
+
+    /**
+     * Open the MJPEG decoder and start the decoding thread
+     * \return Return true if the decoder has been opened successfully
+     */
+    bool openDecoder();
+
+    /**
+     * Stop the decoding thread and close the decoder
+     */
+    void closeDecoder();
 
     /**
-     * Capture thread function
+     * Copy a captured frame to a contiguous image, removing the row padding
+     * \param planes Pointers to the memory planes of the captured buffer
+     * \return Return the packed image
      */
-    void captureThreadFunc();
+    std::unique_ptr<ImageBuffer> copyPlanes(const std::vector<const uint8_t*>& planes) const;
 
     /**
      * \brief As the name suggests
@@ -111,7 +111,10 @@ void Queue::update()
 
         if (sourceIndex >= _playlist.size())
         {
-            _currentSource = dynamic_pointer_cast<BufferObject>(_factory->create("image"));
+            // A plain image holds no decoder, it can simply be cleared
+            if (!_currentSource || _currentSource->getType() != "image")
+                replaceCurrentSource(dynamic_pointer_cast<BufferObject>(_factory->create("image")));
+            dynamic_pointer_cast<Image>(_currentSource)->zero();
             _currentSource->setName(_name + DISTANT_NAME_SUFFIX);
             _root->sendMessage(_name, "source", {"image"});
         }
@@ -119,44 +122,37 @@ void Queue::update()
         {
             auto& sourceParameters = _playlist[_currentSourceIndex];
 
-            if (!_currentSource || _currentSource->getType() != sourceParameters.type)
-                _currentSource = dynamic_pointer_cast<BufferObject>(_factory->create(sourceParameters.type));
-
-            if (_currentSource)
-                _playing = true;
-            else
-                _currentSource = dynamic_pointer_cast<BufferObject>(_factory->create("image"));
-            dynamic_pointer_cast<Image>(_currentSource)->zero();
-            _currentSource->setName(_name + DISTANT_NAME_SUFFIX);
-
-            _currentSource->setAttribute("file", {sourceParameters.filename});
-
-            if (_useClock && !sourceParameters.freeRun)
+            if (auto preloadedSource = takePreloadedSource(_currentSourceIndex); preloadedSource)
             {
-                // If we use the master clock, set a timeshift to be correctly placed in the video
-                // (as the source gets its clock from the same Timer)
-                _currentSource->setAttribute("timeShift", {-(float)sourceParameters.start / 1e6});
-                _currentSource->setAttribute("useClock", {true});
+                // The preloaded source is already decoding, paused, it only has to be started
+                replaceCurrentSource(preloadedSource);
+                _playing = true;
+                _currentSource->setName(_name + DISTANT_NAME_SUFFIX);
+                _currentSource->setAttribute("useClock", {_useClock && !sourceParameters.freeRun});
+                if (_currentSource->hasAttribute("pause"))
+                    _currentSource->setAttribute("pause", {false});
             }
             else
             {
-                _currentSource->setAttribute("useClock", {false});
+                if (!_currentSource || _currentSource->getType() != sourceParameters.type)
+                    replaceCurrentSource(dynamic_pointer_cast<BufferObject>(_factory->create(sourceParameters.type)));
+
+                if (_currentSource)
+                    _playing = true;
+                else
+                    _currentSource = dynamic_pointer_cast<BufferObject>(_factory->create("image"));
+                _currentSource->setName(_name + DISTANT_NAME_SUFFIX);
+                configureSource(_currentSource, sourceParameters, _useClock);
             }
 
             _root->sendMessage(_name, "source", {sourceParameters.type});
 
-            for (const auto& arg : sourceParameters.args)
-            {
-                if (!arg.isNamed())
-                    continue;
-
-                _currentSource->setAttribute(arg.getName(), arg.as<Values>());
-            }
-
             Log::get() << Log::MESSAGE << "Queue::" << __FUNCTION__ << " - Playing file: " << sourceParameters.filename << Log::endl;
         }
     }
 
+    preloadSources(sourceIndex);
+
     if (!_useClock && !_playlist[_currentSourceIndex].freeRun && _seeked)
     {
         // If we don't use the master clock, we want to seek accordingly in the file
@@ -168,6 +164,148 @@ void Queue::update()
         _currentSource->update();
 }
 
+/*************/
+void Queue::replaceCurrentSource(const shared_ptr<BufferObject>& source)
+{
+    if (_currentSource)
+    {
+        // The new source will get the same name, the previous one must not remove its branch from the tree
+        _currentSource->detachFromTree();
+        auto previousSource = make_shared<shared_ptr<BufferObject>>(std::move(_currentSource));
+        runAsyncTask([previousSource]() { previousSource->reset(); });
+    }
+
+    _currentSource = source;
+}
+
+/*************/
+void Queue::configureSource(const shared_ptr<BufferObject>& source, const Source& parameters, bool useClock)
+{
+    dynamic_pointer_cast<Image>(source)->zero();
+    source->setAttribute("file", {parameters.filename});
+
+    // If we use the master clock, the timeshift places the source correctly in the video
+    // (as the source gets its clock from the same Timer)
+    source->setAttribute("timeShift", {-(float)parameters.start / 1e6});
+    source->setAttribute("useClock", {useClock && !parameters.freeRun});
+
+    for (const auto& arg : parameters.args)
+    {
+        if (!arg.isNamed())
+            continue;
+
+        source->setAttribute(arg.getName(), arg.as<Values>());
+    }
+}
+
+/*************/
+void Queue::preloadSources(uint32_t currentIndex)
+{
+    vector<uint32_t> upcomingIndices;
+    for (int32_t i = 1; i <= _preloadCount; ++i)
+    {
+        auto index = currentIndex + i;
+        if (index >= _playlist.size())
+        {
+            // The playlist only wraps around when looping on the local clock
+            if (!_loop || _useClock)
+                break;
+            index %= _playlist.size();
+        }
+
+        if (index != currentIndex && find(upcomingIndices.begin(), upcomingIndices.end(), index) == upcomingIndices.end())
+            upcomingIndices.push_back(index);
+    }
+
+    // Drop what is not upcoming anymore, after a seek or a playlist change
+    for (auto preloadedIt = _preloadedSources.begin(); preloadedIt != _preloadedSources.end();)
+    {
+        const auto& preloaded = *preloadedIt;
+        bool isUpcoming = find(upcomingIndices.begin(), upcomingIndices.end(), preloaded->index) != upcomingIndices.end();
+        if (isUpcoming && _playlist[preloaded->index].type == preloaded->type && _playlist[preloaded->index].filename == preloaded->filename)
+        {
+            ++preloadedIt;
+            continue;
+        }
+
+        dropPreloadedSource(preloaded);
+        preloadedIt = _preloadedSources.erase(preloadedIt);
+    }
+
+    for (const auto index : upcomingIndices)
+    {
+        auto isPreloaded = find_if(_preloadedSources.begin(), _preloadedSources.end(), [&](const auto& preloaded) { return preloaded->index == index; });
+        if (isPreloaded != _preloadedSources.end())
+            continue;
+
+        const auto& parameters = _playlist[index];
+        auto source = dynamic_pointer_cast<BufferObject>(_factory->create(parameters.type));
+        if (!source)
+            continue;
+
+        auto preloaded = make_shared<PreloadedSource>();
+        preloaded->index = index;
+        preloaded->type = parameters.type;
+        preloaded->filename = parameters.filename;
+        _preloadedSources.push_back(preloaded);
+
+        // Opening the file and probing the codecs are done on a worker, the source staying paused until it is played
+        runAsyncTask([preloaded, source, parameters, useClock = _useClock]() mutable {
+            if (source->hasAttribute("pause"))
+                source->setAttribute("pause", {true});
+            configureSource(source, parameters, useClock);
+
+            lock_guard<mutex> lock(preloaded->mutex);
+            if (!preloaded->cancelled)
+                preloaded->source = source;
+            preloaded->ready = true;
+            // If cancelled, the source is destroyed here, on the worker
+            source.reset();
+        });
+    }
+}
+
+/*************/
+shared_ptr<BufferObject> Queue::takePreloadedSource(uint32_t index)
+{
+    auto preloadedIt = find_if(_preloadedSources.begin(), _preloadedSources.end(), [&](const auto& preloaded) { return preloaded->index == index; });
+    if (preloadedIt == _preloadedSources.end())
+        return {nullptr};
+
+    auto preloaded = *preloadedIt;
+    _preloadedSources.erase(preloadedIt);
+
+    {
+        lock_guard<mutex> lock(preloaded->mutex);
+        if (preloaded->ready && preloaded->type == _playlist[index].type && preloaded->filename == _playlist[index].filename)
+        {
+            preloaded->cancelled = true;
+            return std::move(preloaded->source);
+        }
+    }
+
+    // Not ready in time, the entry is loaded the usual way
+    dropPreloadedSource(preloaded);
+    return {nullptr};
+}
+
+/*************/
+void Queue::dropPreloadedSource(const shared_ptr<PreloadedSource>& preloaded)
+{
+    shared_ptr<BufferObject> source;
+    {
+        lock_guard<mutex> lock(preloaded->mutex);
+        preloaded->cancelled = true;
+        swap(source, preloaded->source);
+    }
+
+    if (source)
+    {
+        auto droppedSource = make_shared<shared_ptr<BufferObject>>(std::move(source));
+        runAsyncTask([droppedSource]() { droppedSource->reset(); });
+    }
+}
+
 /*************/
 void Queue::cleanPlaylist(vector<Source>& playlist)
 {
@@ -284,6 +422,15 @@ void Queue::registerAttributes()
         {'b'});
     setAttributeDescription("loop", "Set whether to loop through the queue or not");
 
+    addAttribute("preload",
+        [&](const Values& args) {
+            _preloadCount = max(0, args[0].as<int>());
+            return true;
+        },
+        [&]() -> Values { return {_preloadCount}; },
+        {'i'});
+    setAttributeDescription("preload", "Number of upcoming playlist entries opened ahead of time, for them to start without delay");
+
     addAttribute("pause",
         [&](const Values& args) {
             _paused = args[0].as<bool>();
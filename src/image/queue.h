@@ -113,6 +113,20 @@ class Queue : public BufferObject
 
     std::shared_ptr<BufferObject> _currentSource; // The source being played
 
+    // Source opened ahead of its start time, so that switching to it does not wait for the file to be opened and decoded
+    struct PreloadedSource
+    {
+        uint32_t index{0};
+        std::string type{};
+        std::string filename{};
+        std::mutex mutex{};
+        std::shared_ptr<BufferObject> source{}; //!< Set once the source is ready
+        bool ready{false};
+        bool cancelled{false};
+    };
+    std::vector<std::shared_ptr<PreloadedSource>> _preloadedSources{};
+    int32_t _preloadCount{1}; // Number of upcoming playlist entries to preload
+
     int32_t _currentSourceIndex{-1};
     bool _playing{false};
 
@@ -128,6 +142,39 @@ class Queue : public BufferObject
      */
     void cleanPlaylist(std::vector<Source>& playlist);
 
+    /**
+     * Replace the current source. The previous one is destroyed on a worker, as stopping its decoder can take a while
+     * \param source New source
+     */
+    void replaceCurrentSource(const std::shared_ptr<BufferObject>& source);
+
+    /**
+     * Set the parameters of a playlist entry to the given source, and open its file
+     * \param source Source to configure
+     * \param parameters Playlist entry
+     * \param useClock True if the master clock is used
+     */
+    static void configureSource(const std::shared_ptr<BufferObject>& source, const Source& parameters, bool useClock);
+
+    /**
+     * Preload the playlist entries following the given one, and drop the preloaded entries which are not upcoming anymore
+     * \param currentIndex Index of the entry currently played
+     */
+    void preloadSources(uint32_t currentIndex);
+
+    /**
+     * Take the preloaded source for the given entry, if it is ready
+     * \param index Playlist entry index
+     * \return Return the source, or nullptr if it was not preloaded or is not ready yet
+     */
+    std::shared_ptr<BufferObject> takePreloadedSource(uint32_t index);
+
+    /**
+     * Drop a preloaded source, its destruction happening on a worker
+     * \param preloaded Preloaded source
+     */
+    void dropPreloadedSource(const std::shared_ptr<PreloadedSource>& preloaded);
+
     /**
      * Regist\brief er new functors to modify attributes
      */
@@ -1,11 +1,27 @@
 #include "./mesh/mesh.h"
 
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <limits>
+#include <sstream>
+
 #include "./core/root_object.h"
 #include "./mesh/meshloader.h"
+#include "./utils/boot_timeline.h"
 #include "./utils/log.h"
 #include "./utils/osutils.h"
+#include "./utils/thread_pool.h"
 #include "./utils/timer.h"
 
+// Binary mesh cache format, the version has to be incremented whenever the format changes
+#define SPLASH_MESH_CACHE_MAGIC "SPLMESH"
+#define SPLASH_MESH_CACHE_VERSION 2
+
+// Prefix of the shared memory segments meshes are published to
+#define SPLASH_MESH_SHM_PREFIX "/splash_mesh_"
+
 using namespace std;
 
 namespace Splash
@@ -17,6 +33,7 @@ Mesh::Mesh(RootObject* root)
 {
     init();
     _renderingPriority = Priority::MEDIA;
+    _cpuOnlyUpdate = true;
 }
 
 /*************/
@@ -52,6 +69,9 @@ bool Mesh::operator==(Mesh& otherMesh) const
 vector<float> Mesh::getVertCoords() const
 {
     lock_guard<Spinlock> lock(_readMutex);
+    if (_packedMesh)
+        return getPackedArray(0);
+
     vector<float> coords;
     for (auto& v : _mesh.vertices)
     {
@@ -63,10 +83,143 @@ vector<float> Mesh::getVertCoords() const
     return coords;
 }
 
+/*************/
+float Mesh::pickVertex(const glm::dvec3& p, glm::dvec3& v) const
+{
+    shared_ptr<const KdTree> index;
+    {
+        lock_guard<mutex> lockIndex(_pickingIndexMutex);
+        if (!_pickingIndex)
+        {
+            vector<glm::vec3> vertices;
+            {
+                lock_guard<Spinlock> lock(_readMutex);
+                if (_packedMesh)
+                {
+                    auto coords = getPackedArray(0);
+                    vertices.reserve(coords.size() / 4);
+                    for (size_t i = 0; i + 3 < coords.size(); i += 4)
+                        vertices.emplace_back(coords[i], coords[i + 1], coords[i + 2]);
+                }
+                else
+                {
+                    vertices.reserve(_mesh.vertices.size());
+                    for (const auto& vertex : _mesh.vertices)
+                        vertices.emplace_back(vertex);
+                }
+            }
+            _pickingIndex = make_shared<const KdTree>(std::move(vertices));
+        }
+        index = _pickingIndex;
+    }
+
+    glm::vec3 nearest;
+    float distance;
+    if (!index->findNearest(glm::vec3(p), nearest, distance))
+        return numeric_limits<float>::max();
+
+    v = nearest;
+    return distance;
+}
+
+/*************/
+shared_ptr<const Mesh::Bounds> Mesh::getBounds() const
+{
+    lock_guard<mutex> lockBounds(_boundsMutex);
+    if (_bounds)
+        return _bounds;
+
+    auto bounds = make_shared<Bounds>();
+    auto coords = getVertCoords();
+    bounds->verticesNumber = static_cast<int>(coords.size() / 4);
+    bounds->chunks.resize((bounds->verticesNumber + SPLASH_MESH_BOUNDS_CHUNK_VERTICES - 1) / SPLASH_MESH_BOUNDS_CHUNK_VERTICES);
+    for (int vertex = 0; vertex < bounds->verticesNumber; ++vertex)
+        bounds->chunks[vertex / SPLASH_MESH_BOUNDS_CHUNK_VERTICES].extend(glm::vec3(coords[vertex * 4], coords[vertex * 4 + 1], coords[vertex * 4 + 2]));
+    for (const auto& chunk : bounds->chunks)
+        bounds->box.extend(chunk);
+
+    _bounds = bounds;
+    return _bounds;
+}
+
+/*************/
+shared_ptr<const Mesh::LevelsOfDetail> Mesh::getLevelsOfDetail() const
+{
+    if (_levelsOfDetailCount <= 0 || _isDynamic)
+        return {nullptr};
+
+    shared_ptr<LevelsOfDetailState> state;
+    {
+        lock_guard<mutex> lockLevels(_levelsOfDetailMutex);
+        if (!_levelsOfDetailState)
+        {
+            // The task only holds the state, which is dropped if the mesh changes in the meantime
+            _levelsOfDetailState = make_shared<LevelsOfDetailState>();
+            MeshSimplifier::Arrays mesh{getVertCoords(), getUVCoords(), getNormals(), getAnnexe()};
+            ThreadPool::get().enqueue([state = _levelsOfDetailState, mesh = std::move(mesh), count = _levelsOfDetailCount, name = _name]() {
+                auto levels = generateLevelsOfDetail(mesh, count);
+                Log::get() << Log::MESSAGE << "Mesh::getLevelsOfDetail - Generated " << levels->levels.size() << " levels of detail for mesh " << name << Log::endl;
+                lock_guard<mutex> lock(state->mutex);
+                state->levels = levels;
+            });
+        }
+        state = _levelsOfDetailState;
+    }
+
+    lock_guard<mutex> lock(state->mutex);
+    return state->levels;
+}
+
+/*************/
+shared_ptr<const Mesh::LevelsOfDetail> Mesh::generateLevelsOfDetail(const MeshSimplifier::Arrays& mesh, int count)
+{
+    auto levels = make_shared<LevelsOfDetail>();
+    levels->edgeLength = MeshSimplifier::getMeanEdgeLength(mesh.vertices);
+    levels->levels.reserve(count);
+
+    const auto* previous = &mesh;
+    auto cellSize = levels->edgeLength;
+    for (int level = 0; level < count && cellSize > 0.f; ++level)
+    {
+        cellSize *= 2.f;
+        auto simplified = MeshSimplifier::simplify(*previous, cellSize);
+
+        // No more levels once the mesh does not get significantly simpler
+        if (simplified.vertices.empty() || simplified.vertices.size() * 10 > previous->vertices.size() * 9)
+            break;
+
+        auto edgeLength = MeshSimplifier::getMeanEdgeLength(simplified.vertices);
+        levels->levels.push_back({std::move(simplified), edgeLength});
+        previous = &levels->levels.back().arrays;
+    }
+
+    return levels;
+}
+
+/*************/
+void Mesh::resetComputedData()
+{
+    {
+        lock_guard<mutex> lockIndex(_pickingIndexMutex);
+        _pickingIndex.reset();
+    }
+
+    {
+        lock_guard<mutex> lockBounds(_boundsMutex);
+        _bounds.reset();
+    }
+
+    lock_guard<mutex> lockLevels(_levelsOfDetailMutex);
+    _levelsOfDetailState.reset();
+}
+
 /*************/
 vector<float> Mesh::getUVCoords() const
 {
     lock_guard<Spinlock> lock(_readMutex);
+    if (_packedMesh)
+        return getPackedArray(1);
+
     vector<float> coords;
     for (auto& u : _mesh.uvs)
     {
@@ -80,6 +233,9 @@ vector<float> Mesh::getUVCoords() const
 vector<float> Mesh::getNormals() const
 {
     lock_guard<Spinlock> lock(_readMutex);
+    if (_packedMesh)
+        return getPackedArray(2);
+
     vector<float> normals;
     for (auto& n : _mesh.normals)
     {
@@ -95,6 +251,9 @@ vector<float> Mesh::getNormals() const
 vector<float> Mesh::getAnnexe() const
 {
     lock_guard<Spinlock> lock(_readMutex);
+    if (_packedMesh)
+        return getPackedArray(3);
+
     vector<float> annexe;
     for (auto& a : _mesh.annexe)
     {
@@ -106,64 +265,231 @@ vector<float> Mesh::getAnnexe() const
     return annexe;
 }
 
+/*************/
+vector<float> Mesh::getPackedArray(uint32_t index) const
+{
+    // Number of floats per vertex for each of the packed arrays
+    static const uint32_t components[] = {4, 2, 4, 4};
+    if (!_packedMesh || index >= 4)
+        return {};
+
+    int nbrVertices;
+    memcpy(&nbrVertices, _packedMesh->data(), sizeof(nbrVertices));
+
+    size_t offset = sizeof(nbrVertices);
+    for (uint32_t i = 0; i < index; ++i)
+        offset += components[i] * nbrVertices * sizeof(float);
+    size_t count = components[index] * nbrVertices;
+    if (offset + count * sizeof(float) > _packedMesh->size())
+        return {};
+
+    vector<float> array(count);
+    memcpy(array.data(), _packedMesh->data() + offset, count * sizeof(float));
+    return array;
+}
+
+/*************/
+shared_ptr<SerializedObject> Mesh::getPackedMesh() const
+{
+    lock_guard<Spinlock> lock(_readMutex);
+    return _packedMesh;
+}
+
 /*************/
 bool Mesh::read(const string& filename)
 {
     if (!_isConnectedToRemote)
     {
-        Loader::Obj objLoader;
-        if (!objLoader.load(filename))
+        BootStep bootStep("mesh_load");
+        MeshContainer mesh;
+        if (!readFromCache(filename, mesh))
         {
-            Log::get() << Log::WARNING << "Mesh::" << __FUNCTION__ << " - Unable to read the specified mesh file: " << filename << Log::endl;
-            return false;
-        }
+            Loader::Obj objLoader;
+            if (!objLoader.load(filename))
+            {
+                Log::get() << Log::WARNING << "Mesh::" << __FUNCTION__ << " - Unable to read the specified mesh file: " << filename << Log::endl;
+                return false;
+            }
 
-        MeshContainer mesh;
-        mesh.vertices = objLoader.getVertices();
-        mesh.uvs = objLoader.getUVs();
-        mesh.normals = objLoader.getNormals();
+            mesh.vertices = objLoader.getVertices();
+            mesh.uvs = objLoader.getUVs();
+            mesh.normals = objLoader.getNormals();
+
+            writeToCache(filename, mesh);
+        }
 
         lock_guard<shared_mutex> lock(_writeMutex);
-        _mesh = mesh;
+        _mesh = std::move(mesh);
         updateTimestamp();
+
+        lock_guard<mutex> lockSerialize(_serializeMutex);
+        _serializedMesh.reset();
+
+        resetComputedData();
     }
 
     return true;
 }
 
 /*************/
-shared_ptr<SerializedObject> Mesh::serialize() const
+string Mesh::getCacheFilePath(const string& filename)
 {
-    auto obj = make_shared<SerializedObject>();
+    error_code errorCode;
+    auto absolutePath = filesystem::absolute(filename, errorCode).lexically_normal().string();
 
-    if (Timer::get().isDebug())
-        Timer::get() << "serialize " + _name;
+    stringstream path;
+    path << Utils::getCachePath() << "/meshes/" << hex << std::hash<string>()(absolutePath) << ".splashmesh";
+    return path.str();
+}
 
-    // For this, we will use the getVertex, getUV, etc. methods to create a serialized representation of the mesh
-    vector<vector<float>> data;
-    data.push_back(getVertCoords());
-    data.push_back(getUVCoords());
-    data.push_back(getNormals());
-    data.push_back(getAnnexe());
+/*************/
+bool Mesh::readFromCache(const string& filename, MeshContainer& mesh)
+{
+    error_code errorCode;
+    auto sourceSize = static_cast<uint64_t>(filesystem::file_size(filename, errorCode));
+    if (errorCode)
+        return false;
+    auto sourceTime = static_cast<int64_t>(filesystem::last_write_time(filename, errorCode).time_since_epoch().count());
+    if (errorCode)
+        return false;
+
+    ifstream file(getCacheFilePath(filename), ios::in | ios::binary);
+    if (!file)
+        return false;
+
+    // The header identifies the source file, which has to be unchanged since the cache was written
+    char magic[sizeof(SPLASH_MESH_CACHE_MAGIC)];
+    uint32_t version = 0;
+    uint64_t pathSize = 0;
+    file.read(magic, sizeof(magic));
+    file.read(reinterpret_cast<char*>(&version), sizeof(version));
+    file.read(reinterpret_cast<char*>(&pathSize), sizeof(pathSize));
+    if (!file || memcmp(magic, SPLASH_MESH_CACHE_MAGIC, sizeof(magic)) != 0 || version != SPLASH_MESH_CACHE_VERSION || pathSize > 4096)
+        return false;
+
+    string path(pathSize, '\0');
+    uint64_t cachedSourceSize = 0;
+    int64_t cachedSourceTime = 0;
+    uint64_t vertexCount = 0;
+    file.read(path.data(), pathSize);
+    file.read(reinterpret_cast<char*>(&cachedSourceSize), sizeof(cachedSourceSize));
+    file.read(reinterpret_cast<char*>(&cachedSourceTime), sizeof(cachedSourceTime));
+    file.read(reinterpret_cast<char*>(&vertexCount), sizeof(vertexCount));
+    if (!file || path != filesystem::absolute(filename, errorCode).lexically_normal().string() || cachedSourceSize != sourceSize || cachedSourceTime != sourceTime)
+        return false;
+
+    // Sanity check before allocating, as an obj file needs at least one byte per face vertex
+    if (vertexCount == 0 || vertexCount > sourceSize)
+        return false;
+
+    mesh.vertices.resize(vertexCount);
+    mesh.uvs.resize(vertexCount);
+    mesh.normals.resize(vertexCount);
+    file.read(reinterpret_cast<char*>(mesh.vertices.data()), vertexCount * sizeof(glm::vec4));
+    file.read(reinterpret_cast<char*>(mesh.uvs.data()), vertexCount * sizeof(glm::vec2));
+    file.read(reinterpret_cast<char*>(mesh.normals.data()), vertexCount * sizeof(glm::vec3));
+    if (!file)
+    {
+        mesh = MeshContainer();
+        return false;
+    }
+
+    return true;
+}
+
+/*************/
+void Mesh::writeToCache(const string& filename, const MeshContainer& mesh)
+{
+    error_code errorCode;
+    auto sourceSize = static_cast<uint64_t>(filesystem::file_size(filename, errorCode));
+    if (errorCode)
+        return;
+    auto sourceTime = static_cast<int64_t>(filesystem::last_write_time(filename, errorCode).time_since_epoch().count());
+    if (errorCode)
+        return;
+
+    if (mesh.vertices.empty() || mesh.uvs.size() != mesh.vertices.size() || mesh.normals.size() != mesh.vertices.size())
+        return;
 
+    auto path = filesystem::absolute(filename, errorCode).lexically_normal().string();
+    Utils::writeCacheFile(getCacheFilePath(filename), SPLASH_MESH_CACHE_MAGIC, SPLASH_MESH_CACHE_VERSION, [&](ofstream& file) {
+        uint64_t pathSize = path.size();
+        uint64_t vertexCount = mesh.vertices.size();
+
+        file.write(reinterpret_cast<const char*>(&pathSize), sizeof(pathSize));
+        file.write(path.data(), pathSize);
+        file.write(reinterpret_cast<const char*>(&sourceSize), sizeof(sourceSize));
+        file.write(reinterpret_cast<const char*>(&sourceTime), sizeof(sourceTime));
+        file.write(reinterpret_cast<const char*>(&vertexCount), sizeof(vertexCount));
+        file.write(reinterpret_cast<const char*>(mesh.vertices.data()), vertexCount * sizeof(glm::vec4));
+        file.write(reinterpret_cast<const char*>(mesh.uvs.data()), vertexCount * sizeof(glm::vec2));
+        file.write(reinterpret_cast<const char*>(mesh.normals.data()), vertexCount * sizeof(glm::vec3));
+    });
+}
+
+/*************/
+shared_ptr<SerializedObject> Mesh::packMesh() const
+{
     lock_guard<Spinlock> lock(_readMutex);
-    int nbrVertices = data[0].size() / 4;
-    int totalSize = sizeof(nbrVertices); // We add to all this the total number of vertices
-    for (auto& d : data)
-        totalSize += d.size() * sizeof(d[0]);
-    obj->resize(totalSize);
+    if (_packedMesh)
+        return make_shared<SerializedObject>(_packedMesh->data(), _packedMesh->data() + _packedMesh->size());
+
+    int nbrVertices = _mesh.vertices.size();
+    size_t totalSize = sizeof(nbrVertices) + (_mesh.vertices.size() * 4 + _mesh.uvs.size() * 2 + _mesh.normals.size() * 4 + _mesh.annexe.size() * 4) * sizeof(float);
+    auto obj = make_shared<SerializedObject>(totalSize);
 
     auto currentObjPtr = obj->data();
-    const char* ptr = reinterpret_cast<const char*>(&nbrVertices);
-    copy(ptr, ptr + sizeof(nbrVertices), currentObjPtr);
+    memcpy(currentObjPtr, &nbrVertices, sizeof(nbrVertices));
     currentObjPtr += sizeof(nbrVertices);
 
-    for (auto& d : data)
+    auto writeFloats = [&](const float* values, size_t count) {
+        memcpy(currentObjPtr, values, count * sizeof(float));
+        currentObjPtr += count * sizeof(float);
+    };
+
+    for (const auto& v : _mesh.vertices)
+        writeFloats(&v[0], 4);
+    for (const auto& u : _mesh.uvs)
+        writeFloats(&u[0], 2);
+    for (const auto& n : _mesh.normals)
     {
-        ptr = reinterpret_cast<const char*>(d.data());
-        copy(ptr, ptr + d.size() * sizeof(float), currentObjPtr);
-        currentObjPtr += d.size() * sizeof(float);
+        const float normal[] = {n[0], n[1], n[2], 0.f};
+        writeFloats(normal, 4);
     }
+    for (const auto& a : _mesh.annexe)
+        writeFloats(&a[0], 4);
+
+    return obj;
+}
+
+/*************/
+shared_ptr<SerializedObject> Mesh::serialize() const
+{
+    lock_guard<mutex> lockSerialize(_serializeMutex);
+    if (_serializedMesh)
+        return _serializedMesh;
+
+    if (Timer::get().isDebug())
+        Timer::get() << "serialize " + _name;
+
+    auto obj = packMesh();
+
+    // Publishing the mesh lets the scenes map it instead of receiving a copy,
+    // and resending it (for example when an attribute changes) only costs a reference
+    if (!_isDynamic && !_benchmark)
+    {
+        if (auto blob = ShmBlob::publish(SPLASH_MESH_SHM_PREFIX, obj->data(), obj->size()); blob)
+        {
+            if (blob != _publishedMesh)
+            {
+                _previousPublishedMesh = _publishedMesh;
+                _publishedMesh = blob;
+            }
+            obj = blob->serializeReference();
+        }
+    }
+
+    _serializedMesh = obj;
 
     if (Timer::get().isDebug())
         Timer::get() >> ("serialize " + _name);
@@ -177,6 +503,38 @@ bool Mesh::deserialize(const shared_ptr<SerializedObject>& obj)
     if (obj.get() == nullptr || obj->size() == 0)
         return false;
 
+    // The mesh has been published in shared memory, it is mapped and used as is
+    if (auto reference = ShmBlob::getReference(obj); reference)
+    {
+        {
+            lock_guard<Spinlock> lock(_readMutex);
+            if ((_packedMesh || _bufferPackedMesh) && _packedMeshHash == reference->hash)
+                return true;
+        }
+
+        auto packedMesh = ShmBlob::map(reference.value());
+        if (!packedMesh)
+            return false;
+
+        int nbrVertices;
+        memcpy(&nbrVertices, packedMesh->data(), sizeof(nbrVertices));
+        auto baseSize = sizeof(nbrVertices) + static_cast<size_t>(nbrVertices) * 10 * sizeof(float);
+        if (nbrVertices < 0 || (packedMesh->size() != baseSize && packedMesh->size() != baseSize + static_cast<size_t>(nbrVertices) * 4 * sizeof(float)))
+        {
+            Log::get() << Log::WARNING << "Mesh::" << __FUNCTION__ << " - Bad shared mesh received, discarding" << Log::endl;
+            return false;
+        }
+
+        lock_guard<shared_mutex> lock(_writeMutex);
+        _bufferMesh = MeshContainer();
+        _bufferUpdatedRange.reset();
+        _bufferPackedMesh = packedMesh;
+        _packedMeshHash = reference->hash;
+        _meshUpdated = true;
+        updateTimestamp();
+        return true;
+    }
+
     if (Timer::get().isDebug())
         Timer::get() << "deserialize " + _name;
 
@@ -255,7 +613,25 @@ bool Mesh::deserialize(const shared_ptr<SerializedObject>& obj)
             }
         }
 
-        _bufferMesh = mesh;
+        // Meshes received continuously are not published in shared memory by the World, and are often only
+        // partly modified: they are streamed, and only the vertices which changed are uploaded
+        lock_guard<shared_mutex> lock(_writeMutex);
+        if (_receivedInlineMesh && !_packedMesh && !_bufferPackedMesh)
+        {
+            _isDynamic = true;
+            if (auto range = getChangedRange(_bufferMesh, mesh); range)
+                markUpdatedRange(range->first, range->second - range->first);
+            else
+                _bufferUpdatedRange.reset();
+        }
+        else
+        {
+            _bufferUpdatedRange.reset();
+        }
+        _receivedInlineMesh = true;
+
+        _bufferMesh = std::move(mesh);
+        _bufferPackedMesh.reset();
         _meshUpdated = true;
 
         updateTimestamp();
@@ -278,15 +654,80 @@ void Mesh::update()
 {
     if (_meshUpdated)
     {
-        lock_guard<Spinlock> lock(_readMutex);
-        shared_lock<shared_mutex> lockWrite(_writeMutex);
-        _mesh = _bufferMesh;
-        _meshUpdated = false;
+        {
+            lock_guard<Spinlock> lock(_readMutex);
+            shared_lock<shared_mutex> lockWrite(_writeMutex);
+            _mesh = _bufferMesh;
+            _packedMesh = std::move(_bufferPackedMesh);
+            _bufferPackedMesh.reset();
+            _meshUpdated = false;
+
+            _updatedRange = _bufferUpdatedRange;
+            _bufferUpdatedRange.reset();
+            _updatedRangeSince = _contentTimestamp;
+            _contentTimestamp = getTimestamp();
+        }
+
+        {
+            lock_guard<mutex> lockSerialize(_serializeMutex);
+            _serializedMesh.reset();
+        }
+
+        resetComputedData();
     }
     else if (_benchmark)
         updateTimestamp();
 }
 
+/*************/
+bool Mesh::getUpdatedRange(int64_t since, size_t& first, size_t& count) const
+{
+    lock_guard<Spinlock> lock(_readMutex);
+    if (!_updatedRange || since != _updatedRangeSince || getTimestamp() != _contentTimestamp)
+        return false;
+
+    first = _updatedRange->first;
+    count = _updatedRange->second - _updatedRange->first;
+    return true;
+}
+
+/*************/
+void Mesh::markUpdatedRange(size_t first, size_t count)
+{
+    if (!_meshUpdated)
+        _bufferUpdatedRange = make_pair(first, first + count);
+    else if (_bufferUpdatedRange && count != 0)
+        _bufferUpdatedRange = _bufferUpdatedRange->first < _bufferUpdatedRange->second
+                                  ? make_pair(std::min(_bufferUpdatedRange->first, first), std::max(_bufferUpdatedRange->second, first + count))
+                                  : make_pair(first, first + count);
+}
+
+/*************/
+optional<pair<size_t, size_t>> Mesh::getChangedRange(const MeshContainer& previous, const MeshContainer& mesh)
+{
+    const auto count = mesh.vertices.size();
+    if (previous.vertices.size() != count || previous.uvs.size() != mesh.uvs.size() || previous.normals.size() != mesh.normals.size() ||
+        previous.annexe.size() != mesh.annexe.size())
+        return {};
+
+    auto differs = [&](size_t index) {
+        return previous.vertices[index] != mesh.vertices[index] || (index < mesh.uvs.size() && previous.uvs[index] != mesh.uvs[index]) ||
+               (index < mesh.normals.size() && previous.normals[index] != mesh.normals[index]) ||
+               (index < mesh.annexe.size() && previous.annexe[index] != mesh.annexe[index]);
+    };
+
+    size_t begin = 0;
+    while (begin < count && !differs(begin))
+        ++begin;
+    if (begin == count)
+        return make_pair(size_t(0), size_t(0));
+
+    size_t end = count;
+    while (end > begin && !differs(end - 1))
+        --end;
+    return make_pair(begin, end);
+}
+
 /*************/
 void Mesh::createDefaultMesh(int subdiv)
 {
@@ -348,8 +789,16 @@ void Mesh::createDefaultMesh(int subdiv)
 
     lock_guard<shared_mutex> lock(_writeMutex);
     _mesh = std::move(mesh);
+    _packedMesh.reset();
 
     updateTimestamp();
+
+    {
+        lock_guard<mutex> lockSerialize(_serializeMutex);
+        _serializedMesh.reset();
+    }
+
+    resetComputedData();
 }
 
 /*************/
@@ -373,6 +822,34 @@ void Mesh::registerAttributes()
         },
         {'b'});
     setAttributeDescription("benchmark", "Set to true to resend the image even when not updated");
+
+    addAttribute("levelsOfDetail",
+        [&](const Values& args) {
+            _levelsOfDetailCount = std::max(0, args[0].as<int>());
+            lock_guard<mutex> lockLevels(_levelsOfDetailMutex);
+            _levelsOfDetailState.reset();
+            return true;
+        },
+        [&]() -> Values { return {_levelsOfDetailCount}; },
+        {'i'});
+    setAttributeDescription("levelsOfDetail",
+        "Maximum number of simplified versions of the mesh to generate, each halving the resolution of the previous one. Cameras draw the coarsest one fitting their resolution");
+
+    addAttribute("compactVertexAttributes",
+        [&](const Values& args) {
+            auto compact = args[0].as<bool>();
+            if (compact == _compactVertexAttributes)
+                return true;
+            _compactVertexAttributes = compact;
+            // The GPU buffers are created again when the mesh changes
+            updateTimestamp();
+            return true;
+        },
+        [&]() -> Values { return {_compactVertexAttributes}; },
+        {'b'});
+    setAttributeDescription("compactVertexAttributes",
+        "If true, static meshes are uploaded with texture coordinates as 16 bits integers when they lie in [0, 1], and normals as 10 bits integers. Set to false for full "
+        "float precision");
 }
 
 } // end of namespace
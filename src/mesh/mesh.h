@@ -29,18 +29,49 @@
 #include <glm/glm.hpp>
 #include <memory>
 #include <mutex>
+#include <optional>
+#include <utility>
 #include <vector>
 
 #include "./core/constants.h"
 
 #include "./core/attribute.h"
 #include "./core/buffer_object.h"
+#include "./core/shm_blob.h"
+#include "./utils/bounding_box.h"
+#include "./utils/kdtree.h"
+#include "./utils/mesh_simplifier.h"
+
+// Number of vertices of the chunks of consecutive faces bounded separately, for culling parts of large meshes
+#define SPLASH_MESH_BOUNDS_CHUNK_VERTICES 3072
 
 namespace Splash
 {
 
 class Mesh : public BufferObject
 {
+  public:
+    //! Bounding boxes of the mesh as a whole, and of each chunk of SPLASH_MESH_BOUNDS_CHUNK_VERTICES consecutive vertices in the order of getVertCoords()
+    struct Bounds
+    {
+        BoundingBox box{};
+        std::vector<BoundingBox> chunks{};
+        int verticesNumber{0};
+    };
+
+    //! Simplified versions of the mesh, from the finest to the coarsest
+    struct LevelsOfDetail
+    {
+        struct Level
+        {
+            MeshSimplifier::Arrays arrays{};
+            float edgeLength{0.f}; //!< Mean length of the triangle edges
+        };
+
+        float edgeLength{0.f}; //!< Mean length of the triangle edges of the full resolution mesh
+        std::vector<Level> levels{};
+    };
+
   public:
     /**
      * \brief Constructor
@@ -73,6 +104,29 @@ class Mesh : public BufferObject
      */
     virtual std::vector<float> getVertCoords() const;
 
+    /**
+     * \brief Find the vertex nearest to the given point
+     * Vertices are indexed on the first call after each mesh change, following calls do not go through all of them
+     * \param p Point, in mesh coordinates
+     * \param v Nearest vertex
+     * \return Return the distance to the nearest vertex, or the maximum float value if the mesh is empty
+     */
+    float pickVertex(const glm::dvec3& p, glm::dvec3& v) const;
+
+    /**
+     * \brief Get the bounding boxes of the mesh
+     * They are computed on the first call after each mesh change
+     * \return Return the bounding boxes, in mesh coordinates
+     */
+    std::shared_ptr<const Bounds> getBounds() const;
+
+    /**
+     * \brief Get the simplified versions of the mesh
+     * They are generated in the background, starting on the first call after each mesh change
+     * \return Return the levels of detail, or nullptr if they are disabled or not generated yet
+     */
+    std::shared_ptr<const LevelsOfDetail> getLevelsOfDetail() const;
+
     /**
      * \brief Get a 1D vector of the UV coordinates for all points, same order as getVertCoords()
      * \return Return a vector representing the UV coordinates
@@ -100,6 +154,8 @@ class Mesh : public BufferObject
 
     /**
      * \brief Get a serialized representation of the mesh
+     * The representation is only rebuilt when the mesh changes. If possible it is published
+     * in shared memory, and the returned object only holds a reference to it.
      * \return Return a serialized object
      */
     std::shared_ptr<SerializedObject> serialize() const override;
@@ -111,6 +167,35 @@ class Mesh : public BufferObject
      */
     bool deserialize(const std::shared_ptr<SerializedObject>& obj) override;
 
+    /**
+     * \brief Get the packed vertex arrays mapped from shared memory, if the mesh is backed by them
+     * The layout is the one given by serialize(): the number of vertices, then the vertices, UVs, normals and annexe
+     * \return Return the packed arrays, or nullptr
+     */
+    std::shared_ptr<SerializedObject> getPackedMesh() const;
+
+    /**
+     * \brief Check whether the mesh is updated continuously
+     * \return Return true if the mesh is dynamic
+     */
+    bool isDynamic() const { return _isDynamic; }
+
+    /**
+     * \brief Get the vertices changed by the last update, when only part of the mesh changed
+     * Vertices are indexed in the order of getVertCoords()
+     * \param since Timestamp of the mesh content the caller already holds
+     * \param first Set to the first changed vertex
+     * \param count Set to the changed vertex count
+     * \return Return true if the changes between the given timestamp and the current content are limited to this range
+     */
+    bool getUpdatedRange(int64_t since, size_t& first, size_t& count) const;
+
+    /**
+     * \brief Check whether the mesh can be uploaded with compact texture coordinates and normals
+     * \return Return true if compact vertex attributes are allowed
+     */
+    bool hasCompactVertexAttributes() const { return _compactVertexAttributes; }
+
     /**
      * \brief Update the content of the mesh
      */
@@ -131,6 +216,17 @@ class Mesh : public BufferObject
     bool _meshUpdated{false};
     bool _benchmark{false};
     int _planeSubdivisions{0};
+    bool _isDynamic{false}; //!< Set to true for meshes updated continuously, which are streamed to the GPU instead of being published in shared memory
+    bool _compactVertexAttributes{true}; //!< If true, static meshes are uploaded with 16 bits texture coordinates and 10 bits normals
+    std::optional<std::pair<size_t, size_t>> _bufferUpdatedRange{}; //!< Vertices of _bufferMesh changed since the last update, as [begin, end). Unset if the whole mesh changed
+
+    /**
+     * \brief Mark some vertices of _bufferMesh as changed, the write mutex being locked. The caller then sets _meshUpdated
+     * Updates setting _meshUpdated without going through this method are considered as changing the whole mesh, and have to reset _bufferUpdatedRange
+     * \param first First changed vertex
+     * \param count Changed vertex count
+     */
+    void markUpdatedRange(size_t first, size_t count);
 
     /**
      * \brief Register new functors to modify attributes
@@ -138,8 +234,99 @@ class Mesh : public BufferObject
     void registerAttributes();
 
   private:
+    // Packed arrays mapped from shared memory, used instead of _mesh when set
+    std::shared_ptr<SerializedObject> _packedMesh{nullptr};
+    std::shared_ptr<SerializedObject> _bufferPackedMesh{nullptr};
+    uint64_t _packedMeshHash{0};
+
+    // Vertices changed by the last update, and the timestamps of the content before and after it
+    std::optional<std::pair<size_t, size_t>> _updatedRange{};
+    int64_t _updatedRangeSince{-1};
+    int64_t _contentTimestamp{-1};
+    bool _receivedInlineMesh{false}; //!< Set once a mesh has been received without going through shared memory
+
+    // Serialized representation, kept until the mesh changes
+    mutable std::mutex _serializeMutex{};
+    mutable std::shared_ptr<SerializedObject> _serializedMesh{nullptr};
+    mutable std::shared_ptr<ShmBlob> _publishedMesh{nullptr};
+    mutable std::shared_ptr<ShmBlob> _previousPublishedMesh{nullptr}; //!< Kept for the scenes which did not map it yet
+
+    // Index of the vertices for picking, built when first needed and reset when the mesh changes
+    mutable std::mutex _pickingIndexMutex{};
+    mutable std::shared_ptr<const KdTree> _pickingIndex{nullptr};
+
+    // Bounding boxes, computed when first needed and reset when the mesh changes
+    mutable std::mutex _boundsMutex{};
+    mutable std::shared_ptr<const Bounds> _bounds{nullptr};
+
+    // Levels of detail, generated in the background when first needed and reset when the mesh changes
+    struct LevelsOfDetailState
+    {
+        std::mutex mutex{};
+        std::shared_ptr<const LevelsOfDetail> levels{nullptr};
+    };
+    int _levelsOfDetailCount{0}; //!< Maximum number of levels of detail to generate
+    mutable std::mutex _levelsOfDetailMutex{};
+    mutable std::shared_ptr<LevelsOfDetailState> _levelsOfDetailState{nullptr};
+
     void init();
 
+    /**
+     * \brief Get the range of vertices differing between two meshes
+     * \param previous Previous mesh
+     * \param mesh New mesh
+     * \return Return the range as [begin, end), empty if the meshes are identical, or nothing if their layouts differ
+     */
+    static std::optional<std::pair<size_t, size_t>> getChangedRange(const MeshContainer& previous, const MeshContainer& mesh);
+
+    /**
+     * \brief Generate the levels of detail of a mesh, each one halving the resolution of the previous one
+     * \param mesh Full resolution mesh
+     * \param count Maximum number of levels
+     * \return Return the levels of detail
+     */
+    static std::shared_ptr<const LevelsOfDetail> generateLevelsOfDetail(const MeshSimplifier::Arrays& mesh, int count);
+
+    /**
+     * \brief Reset the data computed from the mesh, after it changed
+     */
+    void resetComputedData();
+
+    /**
+     * \brief Get one of the packed arrays. Read mutex should be locked first.
+     * \param index Array index: 0 for vertices, 1 for UVs, 2 for normals, 3 for the annexe
+     * \return Return the array, empty if not present
+     */
+    std::vector<float> getPackedArray(uint32_t index) const;
+
+    /**
+     * \brief Pack the mesh arrays, following the layout used by serialize()
+     * \return Return the packed arrays
+     */
+    std::shared_ptr<SerializedObject> packMesh() const;
+
+    /**
+     * \brief Get the path of the binary cache file for the given mesh file
+     * \param filename Mesh file
+     * \return Return the cache file path
+     */
+    static std::string getCacheFilePath(const std::string& filename);
+
+    /**
+     * \brief Read a mesh from the binary cache, if it is up to date with the given mesh file
+     * \param filename Mesh file
+     * \param mesh Container to fill
+     * \return Return true if the mesh was read from the cache
+     */
+    static bool readFromCache(const std::string& filename, MeshContainer& mesh);
+
+    /**
+     * \brief Write a mesh to the binary cache
+     * \param filename Mesh file the mesh was read from
+     * \param mesh Mesh to write
+     */
+    static void writeToCache(const std::string& filename, const MeshContainer& mesh);
+
     /**
      * \brief Create a plane mesh, subdivided according to the parameter
      * \param subdiv Number of subdivision for the plane
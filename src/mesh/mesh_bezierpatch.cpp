@@ -2,6 +2,9 @@
 
 #include "./utils/log.h"
 
+// Maximum distance of the control points to the regular lattice for the patch to be considered as the identity
+#define SPLASH_BEZIERPATCH_IDENTITY_EPSILON 1e-5f
+
 using namespace std;
 
 namespace Splash
@@ -33,6 +36,7 @@ void Mesh_BezierPatch::switchMeshes(bool control)
         _bufferMesh = _bezierMesh;
 
     updateTimestamp();
+    _bufferUpdatedRange.reset();
     _meshUpdated = true;
 }
 
@@ -114,6 +118,12 @@ void Mesh_BezierPatch::createPatch(Patch& patch)
         for (int u = 0; u < width; ++u)
             patch.uvs[u + v * width] = glm::vec2((float)u / ((float)width - 1.f), (float)v / ((float)height - 1.f));
 
+    // A regular lattice leaves the input untouched
+    bool isIdentity = true;
+    for (uint32_t i = 0; i < patch.vertices.size() && isIdentity; ++i)
+        isIdentity = glm::length(patch.vertices[i] - (patch.uvs[i] * 2.f - 1.f)) < SPLASH_BEZIERPATCH_IDENTITY_EPSILON;
+    _isIdentity = isIdentity;
+
     _patch = patch;
     _patchUpdated = true;
 
@@ -174,27 +184,42 @@ void Mesh_BezierPatch::updatePatch()
         _binomialDimensions = _patch.size;
     }
 
-    // Compute the vertices positions
+    // The Bernstein polynomials only depend on u or v, so they are evaluated once per row and column
+    auto computeBasis = [&](const vector<float>& coeffs, int count) {
+        vector<float> basis(_patchResolution * count);
+        for (int r = 0; r < _patchResolution; ++r)
+        {
+            float t = (float)r / ((float)_patchResolution - 1.f);
+            for (int i = 0; i < count; ++i)
+                basis[r * count + i] = coeffs[i] * pow(t, (float)i) * pow(1.f - t, (float)count - 1.f - (float)i);
+        }
+        return basis;
+    };
+    auto basisX = computeBasis(_binomialCoeffsX, _patch.size.x);
+    auto basisY = computeBasis(_binomialCoeffsY, _patch.size.y);
+
+    // Compute the vertices positions, first blending the control points rows along v
+    vector<glm::vec2> rowPoints(_patch.size.x);
     for (int v = 0; v < _patchResolution; ++v)
     {
         glm::vec2 uv;
 
         uv.y = (float)v / ((float)_patchResolution - 1.f);
 
+        for (int i = 0; i < _patch.size.x; ++i)
+        {
+            rowPoints[i] = glm::vec2(0.f, 0.f);
+            for (int j = 0; j < _patch.size.y; ++j)
+                rowPoints[i] += basisY[v * _patch.size.y + j] * _patch.vertices[i + j * _patch.size.x];
+        }
+
         for (int u = 0; u < _patchResolution; ++u)
         {
             uv.x = (float)u / ((float)_patchResolution - 1.f);
 
             glm::vec2 vertex{0.f, 0.f};
-            for (int j = 0; j < _patch.size.y; ++j)
-            {
-                for (int i = 0; i < _patch.size.x; ++i)
-                {
-                    float factor = _binomialCoeffsY[j] * pow(uv.y, (float)j) * pow(1.f - uv.y, (float)_patch.size.y - 1.f - (float)j) * _binomialCoeffsX[i] * pow(uv.x, (float)i) *
-                                   pow(1.f - uv.x, (float)_patch.size.x - 1.f - (float)i);
-                    vertex += factor * _patch.vertices[i + j * _patch.size.x];
-                }
-            }
+            for (int i = 0; i < _patch.size.x; ++i)
+                vertex += basisX[u * _patch.size.x + i] * rowPoints[i];
 
             vertices.push_back(vertex);
             uvs.push_back(uv);
@@ -236,6 +261,7 @@ void Mesh_BezierPatch::updatePatch()
     _bezierMesh = mesh;
 
     updateTimestamp();
+    _bufferUpdatedRange.reset();
     _meshUpdated = true;
 }
 
@@ -249,11 +275,27 @@ void Mesh_BezierPatch::registerAttributes()
             auto width = args[0].as<uint32_t>();
             auto height = args[1].as<uint32_t>();
 
+            Patch patch;
+            patch.size = glm::ivec2(width, height);
+
+            // Control points can also be given as a single array of contiguous coordinates
+            if (args.size() == 3 && args[2].getType() == Value::Type::reals)
+            {
+                const auto& coordinates = args[2].asRef<Value::Reals>();
+                if (coordinates.size() != 2 * width * height)
+                    return false;
+
+                patch.vertices.reserve(width * height);
+                for (uint32_t p = 0; p < width * height; ++p)
+                    patch.vertices.emplace_back(coordinates[2 * p], coordinates[2 * p + 1]);
+
+                createPatch(patch);
+                return true;
+            }
+
             if (args.size() - 2 != height * width)
                 return false;
 
-            Patch patch;
-            patch.size = glm::ivec2(width, height);
             for (uint32_t p = 2; p < args.size(); ++p)
                 patch.vertices.push_back(glm::vec2(args[p].as<Values>()[0].as<float>(), args[p].as<Values>()[1].as<float>()));
 
@@ -25,6 +25,7 @@
 #ifndef SPLASH_MESH_BEZIERPATCH_H
 #define SPLASH_MESH_BEZIERPATCH_H
 
+#include <atomic>
 #include <chrono>
 #include <glm/glm.hpp>
 #include <memory>
@@ -66,6 +67,12 @@ class Mesh_BezierPatch : public Mesh
      */
     std::vector<glm::vec2> getControlPoints() const { return _patch.vertices; }
 
+    /**
+     * \brief Get whether the control points form a regular lattice, in which case the patch does not deform its input
+     * \return Return true if the patch is the identity
+     */
+    bool isIdentity() const { return _isIdentity; }
+
     /**
      * \brief Select the bezier mesh or the control points as the mesh to output
      * \param control If true, selects the control points
@@ -90,6 +97,7 @@ class Mesh_BezierPatch : public Mesh
     std::mutex _patchMutex{};
 
     bool _patchUpdated{true};
+    std::atomic_bool _isIdentity{true}; //!< True if the control points form a regular lattice
     MeshContainer _bezierControl;
     MeshContainer _bezierMesh;
 
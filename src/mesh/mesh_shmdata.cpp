@@ -3,6 +3,7 @@
 #include "./core/root_object.h"
 #include "./utils/osutils.h"
 #include "./utils/log.h"
+#include "./utils/mesh_delta.h"
 #include "./utils/timer.h"
 
 using namespace std;
@@ -34,6 +35,7 @@ bool Mesh_Shmdata::read(const string& filename)
 void Mesh_Shmdata::init()
 {
     _type = "mesh_shmdata";
+    _isDynamic = true;
     registerAttributes();
 
     // This is used for getting documentation "offline"
@@ -58,11 +60,26 @@ void Mesh_Shmdata::onCaps(const string& dataType)
 }
 
 /*************/
-void Mesh_Shmdata::onData(void* data, int /*data_size*/)
+void Mesh_Shmdata::onData(void* data, int data_size)
 {
-    if (!_capsIsValid)
+    if (!_capsIsValid || data_size <= 0)
         return;
 
+    if (Timer::get().isDebug())
+        Timer::get() << "mesh_shmdata " + _name;
+
+    if (MeshDelta::isDelta(static_cast<uint8_t*>(data), data_size))
+        readDeltaFrame(static_cast<uint8_t*>(data), data_size);
+    else
+        readFullFrame(static_cast<uint8_t*>(data), data_size);
+
+    if (Timer::get().isDebug())
+        Timer::get() >> ("mesh_shmdata " + _name);
+}
+
+/*************/
+void Mesh_Shmdata::readFullFrame(const uint8_t* data, size_t /*size*/)
+{
     // Read the number of vertices and polys
     int* intPtr = (int*)data;
     float* floatPtr = (float*)data;
@@ -85,8 +102,16 @@ void Mesh_Shmdata::onData(void* data, int /*data_size*/)
     }
 
     intPtr += 8 * verticeNbr;
-    // Then create the faces
+    // Then create the faces, keeping track of where each vertex is copied so that delta frames can be applied
     MeshContainer newMesh;
+    vector<vector<uint32_t>> copies(verticeNbr);
+    auto addVertex = [&](int index) {
+        copies[index].push_back(static_cast<uint32_t>(newMesh.vertices.size()));
+        newMesh.vertices.push_back(vertices[index]);
+        newMesh.uvs.push_back(uvs[index]);
+        newMesh.normals.push_back(normals[index]);
+    };
+
     for (int p = 0; p < polyNbr; ++p)
     {
         int size = *(intPtr++);
@@ -95,35 +120,75 @@ void Mesh_Shmdata::onData(void* data, int /*data_size*/)
         if (size >= 3)
         {
             for (int vert = 0; vert < 3; ++vert)
-            {
-                newMesh.vertices.push_back(vertices[*(intPtr + vert)]);
-                newMesh.uvs.push_back(uvs[*(intPtr + vert)]);
-                newMesh.normals.push_back(normals[*(intPtr + vert)]);
-            }
+                addVertex(*(intPtr + vert));
         }
         if (size == 4)
         {
             for (int vert = 2; vert < 5; ++vert)
-            {
-                newMesh.vertices.push_back(vertices[*(intPtr + (vert % 4))]);
-                newMesh.uvs.push_back(uvs[*(intPtr + (vert % 4))]);
-                newMesh.normals.push_back(normals[*(intPtr + (vert % 4))]);
-            }
+                addVertex(*(intPtr + (vert % 4)));
         }
 
         intPtr += size;
     }
 
     lock_guard<shared_mutex> lock(_writeMutex);
-    if (Timer::get().isDebug())
-        Timer::get() << "mesh_shmdata " + _name;
+    _copyOffsets.resize(verticeNbr + 1);
+    _copyIndices.clear();
+    _copyIndices.reserve(newMesh.vertices.size());
+    for (int v = 0; v < verticeNbr; ++v)
+    {
+        _copyOffsets[v] = static_cast<uint32_t>(_copyIndices.size());
+        _copyIndices.insert(_copyIndices.end(), copies[v].begin(), copies[v].end());
+    }
+    _copyOffsets[verticeNbr] = static_cast<uint32_t>(_copyIndices.size());
+
+    _sourceVertices = std::move(vertices);
+    _sourceUvs = std::move(uvs);
+    _sourceNormals = std::move(normals);
 
     _bufferMesh = std::move(newMesh);
+    _bufferUpdatedRange.reset();
     _meshUpdated = true;
     updateTimestamp();
+}
 
-    if (Timer::get().isDebug())
-        Timer::get() >> ("mesh_shmdata " + _name);
+/*************/
+void Mesh_Shmdata::readDeltaFrame(const uint8_t* data, size_t size)
+{
+    lock_guard<shared_mutex> lock(_writeMutex);
+
+    vector<MeshDelta::Range> ranges;
+    if (!MeshDelta::apply(data, size, _sourceVertices, _sourceUvs, _sourceNormals, ranges))
+    {
+        Log::get() << Log::WARNING << "Mesh_Shmdata::" << __FUNCTION__ << " - Delta frame does not match the current mesh, discarding" << Log::endl;
+        return;
+    }
+
+    // Only the copies of the changed vertices are updated in the triangulated mesh
+    auto first = _bufferMesh.vertices.size();
+    size_t last = 0;
+    for (const auto& range : ranges)
+    {
+        for (auto v = range.first; v < range.first + range.count; ++v)
+        {
+            for (auto copy = _copyOffsets[v]; copy < _copyOffsets[v + 1]; ++copy)
+            {
+                auto index = _copyIndices[copy];
+                _bufferMesh.vertices[index] = _sourceVertices[v];
+                _bufferMesh.uvs[index] = _sourceUvs[v];
+                _bufferMesh.normals[index] = _sourceNormals[v];
+                first = std::min<size_t>(first, index);
+                last = std::max<size_t>(last, index + 1);
+            }
+        }
+    }
+
+    if (first >= last)
+        return;
+
+    markUpdatedRange(first, last - first);
+    _meshUpdated = true;
+    updateTimestamp();
 }
 
 /*************/
@@ -72,6 +72,13 @@ class Mesh_Shmdata : public Mesh
     std::unique_ptr<shmdata::Follower> _reader{nullptr};
     bool _capsIsValid{false};
 
+    // Vertices of the last full frame, patched by the delta frames
+    std::vector<glm::vec4> _sourceVertices{};
+    std::vector<glm::vec2> _sourceUvs{};
+    std::vector<glm::vec3> _sourceNormals{};
+    std::vector<uint32_t> _copyOffsets{}; //!< For each source vertex, offset of its copies in _copyIndices
+    std::vector<uint32_t> _copyIndices{}; //!< Indices of the copies of the source vertices in the triangulated mesh
+
     /**
      * \brief Base init for the class
      */
@@ -90,6 +97,20 @@ class Mesh_Shmdata : public Mesh
      */
     void onData(void* data, int data_size);
 
+    /**
+     * \brief Read a full frame, holding all the vertices and faces
+     * \param data Pointer to the data
+     * \param size Size of the buffer
+     */
+    void readFullFrame(const uint8_t* data, size_t size);
+
+    /**
+     * \brief Read a delta frame, holding only the vertices which changed since the last frame
+     * \param data Pointer to the data
+     * \param size Size of the buffer
+     */
+    void readDeltaFrame(const uint8_t* data, size_t size);
+
     /**
      * \brief Register new functors to modify attributes
      */
@@ -25,15 +25,19 @@
 #ifndef SPLASH_MESHLOADER_H
 #define SPLASH_MESHLOADER_H
 
-#include <fstream>
-#include <iostream>
-#include <sstream>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
 #include <string>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 #include <vector>
 
 #include <glm/glm.hpp>
 
 #include "../utils/log.h"
+#include "../utils/vertex_cache.h"
 
 namespace Splash
 {
@@ -60,196 +64,116 @@ class Obj : public Base
     ~Obj(){};
 
     /**
-     * Remove trailing whitespaces
-     * \param str Input string
-     * \return Return the input string without trailing whitespaces
+     * Load the obj file given its filename
+     * The file is memory-mapped and parsed in place, without intermediate strings
+     * \param filename Filename
+     * \return Return true if the file has been loaded correctly
      */
-    std::string removeTrailingSpaces(const std::string& str)
+    bool load(const std::string& filename)
     {
-        auto output = str;
-        while (output.back() == ' ')
-            output.pop_back();
-        return output;
-    }
+        int fd = open(filename.c_str(), O_RDONLY);
+        if (fd < 0)
+            return false;
 
-    /**
-     * Replace multiple consecutive spaces with a single one
-     * \param str Input string
-     * \return Return the input string without multiple consecutive spaces
-     */
-    std::string compressSpaces(const std::string& str)
-    {
-        auto output = str;
-        size_t pos{0};
-        while ((pos = output.find("  ")) != std::string::npos)
-            output.replace(pos, 2, " ");
-        return output;
-    }
+        struct stat fileStat;
+        if (fstat(fd, &fileStat) != 0 || fileStat.st_size == 0)
+        {
+            close(fd);
+            return false;
+        }
 
-    /**
-     * Remove trailing slashes at the end of a face vertex definition
-     * i.e: f 1/1/ 2/2/ 3/3/
-     * \param str Input string
-     * \return Return the input string without the trailing slashes
-     */
-    std::string removeTrailingSlashes(const std::string& str)
-    {
-        auto output = str;
-        size_t pos{0};
-        while ((pos = output.find("/ ")) != std::string::npos)
-            output.replace(pos, 2, " ");
-        while (output.back() == '/')
-            output.pop_back();
-        return output;
+        auto size = static_cast<size_t>(fileStat.st_size);
+        auto mapped = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        close(fd);
+        if (mapped == MAP_FAILED)
+            return false;
+        madvise(mapped, size, MADV_SEQUENTIAL);
+
+        auto begin = static_cast<const char*>(mapped);
+        auto status = parse(begin, begin + size);
+        munmap(mapped, size);
+
+        return status;
     }
 
     /**
-     * Load the obj file given its filename
-     * \param filename Filename
-     * \return Return true if the file has been loaded correctly
+     * Parse the content of an obj file
+     * \param begin Beginning of the content
+     * \param end End of the content
+     * \return Return true if the content has been parsed correctly
      */
-    bool load(const std::string& filename)
+    bool parse(const char* begin, const char* end)
     {
-        std::ifstream file(filename, std::ios::in);
-        if (!file.is_open())
-            return false;
-
         _vertices.clear();
         _uvs.clear();
         _normals.clear();
         _faces.clear();
 
-        for (std::string line; std::getline(file, line);)
+        std::vector<FaceVertex> face;
+        for (const char* line = begin; line < end;)
         {
-            auto fullLine = line;
-            line = removeTrailingSpaces(line);
-            line = compressSpaces(line);
-            line = removeTrailingSlashes(line);
+            auto lineEnd = static_cast<const char*>(memchr(line, '\n', end - line));
+            if (lineEnd == nullptr)
+                lineEnd = end;
 
-            std::string::size_type pos;
-            if ((pos = line.find("o ")) == 0)
-            {
-                continue;
-            }
-            else if ((pos = line.find("v ")) == 0)
-            {
-                pos += 1;
-                glm::vec4 vertex;
-                int index = 0;
-                do
-                {
-                    pos++;
-                    line = line.substr(pos);
-                    vertex[index] = std::stof(line);
-                    index++;
-                    pos = line.find(" ");
-                } while (pos != std::string::npos && index < 4);
+            auto ptr = line;
+            line = lineEnd + 1;
 
-                if (index < 3)
-                    vertex[3] = 1.f;
+            skipSpaces(ptr, lineEnd);
+            if (lineEnd - ptr < 3)
+                continue;
 
+            if (ptr[0] == 'v' && isSpace(ptr[1]))
+            {
+                ptr += 2;
+                glm::vec4 vertex(0.f, 0.f, 0.f, 1.f);
+                for (int index = 0; index < 4 && parseFloat(ptr, lineEnd, vertex[index]); ++index)
+                    continue;
                 _vertices.push_back(vertex);
             }
-            else if ((pos = line.find("vt ")) == 0)
+            else if (ptr[0] == 'v' && ptr[1] == 't' && isSpace(ptr[2]))
             {
-                pos += 2;
-                glm::vec2 uv;
-                int index = 0;
-                do
-                {
-                    pos++;
-                    line = line.substr(pos);
-                    uv[index] = std::stof(line);
-                    index++;
-                    pos = line.find(" ");
-                } while (pos != std::string::npos && index < 2);
-
+                ptr += 3;
+                glm::vec2 uv(0.f, 0.f);
+                for (int index = 0; index < 2 && parseFloat(ptr, lineEnd, uv[index]); ++index)
+                    continue;
                 _uvs.push_back(uv);
             }
-            else if ((pos = line.find("vn ")) == 0)
+            else if (ptr[0] == 'v' && ptr[1] == 'n' && isSpace(ptr[2]))
             {
-                pos += 2;
-                glm::vec3 normal;
-                int index = 0;
-                do
-                {
-                    pos++;
-                    line = line.substr(pos);
-                    normal[index] = std::stof(line);
-                    index++;
-                    pos = line.find(" ");
-                } while (pos != std::string::npos && index < 3);
-
+                ptr += 3;
+                glm::vec3 normal(0.f, 0.f, 0.f);
+                for (int index = 0; index < 3 && parseFloat(ptr, lineEnd, normal[index]); ++index)
+                    continue;
                 _normals.push_back(normal);
             }
-            else if ((pos = line.find("f ")) == 0)
+            else if (ptr[0] == 'f' && isSpace(ptr[1]))
             {
-                pos += 1;
-
-                std::vector<FaceVertex> face;
-                std::string::size_type nextSlash, nextSpace;
-                do
-                {
-                    pos++;
-                    line = line.substr(pos);
-                    nextSpace = line.find(" ");
-
-                    FaceVertex faceVertex;
-                    faceVertex.vertexId = std::stoi(line) - 1;
-
-                    nextSlash = line.find("/");
-                    if (nextSlash != std::string::npos && (nextSpace == std::string::npos || nextSlash < nextSpace))
-                    {
-                        line = line.substr(nextSlash + 1);
-                        nextSlash = line.find("/");
-                        if (nextSlash != 0)
-                        {
-                            nextSpace = line.find(" ");
-                            faceVertex.uvId = std::stoi(line) - 1;
-                        }
-                    }
-                    else
-                    {
-                        nextSlash = line.find("/");
-                    }
-
-                    if (nextSlash != std::string::npos && (nextSpace == std::string::npos || nextSlash < nextSpace))
-                    {
-                        line = line.substr(nextSlash + 1);
-                        nextSpace = line.find(" ");
-                        faceVertex.normalId = std::stoi(line) - 1;
-                    }
-
+                ptr += 2;
+                face.clear();
+                FaceVertex faceVertex;
+                while (parseFaceVertex(ptr, lineEnd, faceVertex))
                     face.push_back(faceVertex);
 
-                    pos = nextSpace;
-                } while (pos != std::string::npos);
-
                 // We triangulate faces right away if needed
                 // Only tris and quads are supported
-                if (face.size() == 3)
+                if (face.size() >= 3)
                 {
-                    _faces.push_back(face);
+                    _faces.push_back(face[0]);
+                    _faces.push_back(face[1]);
+                    _faces.push_back(face[2]);
                 }
-                else if (face.size() >= 4)
+                if (face.size() >= 4)
                 {
-                    std::vector<FaceVertex> newFace;
-                    newFace.push_back(face[0]);
-                    newFace.push_back(face[1]);
-                    newFace.push_back(face[2]);
-                    _faces.push_back(newFace);
-
-                    newFace.clear();
-                    newFace.push_back(face[2]);
-                    newFace.push_back(face[3]);
-                    newFace.push_back(face[0]);
-                    _faces.push_back(newFace);
+                    _faces.push_back(face[2]);
+                    _faces.push_back(face[3]);
+                    _faces.push_back(face[0]);
                 }
             }
         }
 
-        // Check that we have faces, vertices and UVs
-        if (_vertices.size() == 0 || _faces.size() == 0)
+        // Check that we have valid faces and vertices
+        if (_vertices.size() == 0 || _faces.size() == 0 || !checkFaces())
         {
             _vertices.clear();
             _faces.clear();
@@ -259,6 +183,10 @@ class Obj : public Base
             return false;
         }
 
+        // Consecutive triangles are made to share their vertices, which keeps the vertex
+        // fetches local and the chunks used to cull the mesh compact
+        reorderFaces();
+
         return true;
     }
 
@@ -269,13 +197,10 @@ class Obj : public Base
     std::vector<glm::vec4> getVertices() const
     {
         std::vector<glm::vec4> vertices;
+        vertices.reserve(_faces.size());
 
-        for (auto& face : _faces)
-        {
-            vertices.push_back(_vertices[face[0].vertexId]);
-            vertices.push_back(_vertices[face[1].vertexId]);
-            vertices.push_back(_vertices[face[2].vertexId]);
-        }
+        for (auto& faceVertex : _faces)
+            vertices.push_back(_vertices[faceVertex.vertexId]);
 
         return vertices;
     }
@@ -287,17 +212,19 @@ class Obj : public Base
     std::vector<glm::vec2> getUVs() const
     {
         std::vector<glm::vec2> uvs;
+        uvs.reserve(_faces.size());
 
-        for (auto& face : _faces)
+        for (size_t i = 0; i < _faces.size(); i += 3)
         {
-            if (face[0].uvId == -1)
-                for (uint32_t i = 0; i < face.size(); ++i)
+            if (_faces[i].uvId == -1)
+            {
+                for (uint32_t v = 0; v < 3; ++v)
                     uvs.push_back(glm::vec2(0.f, 0.f));
+            }
             else
             {
-                uvs.push_back(_uvs[face[0].uvId]);
-                uvs.push_back(_uvs[face[1].uvId]);
-                uvs.push_back(_uvs[face[2].uvId]);
+                for (uint32_t v = 0; v < 3; ++v)
+                    uvs.push_back(_faces[i + v].uvId == -1 ? glm::vec2(0.f, 0.f) : _uvs[_faces[i + v].uvId]);
             }
         }
 
@@ -311,13 +238,14 @@ class Obj : public Base
     std::vector<glm::vec3> getNormals() const
     {
         std::vector<glm::vec3> normals;
+        normals.reserve(_faces.size());
 
-        for (auto& face : _faces)
+        for (size_t i = 0; i < _faces.size(); i += 3)
         {
-            if (face[0].normalId == -1)
+            if (_faces[i].normalId == -1)
             {
-                auto edge1 = glm::vec3(_vertices[face[1].vertexId] - _vertices[face[0].vertexId]);
-                auto edge2 = glm::vec3(_vertices[face[2].vertexId] - _vertices[face[0].vertexId]);
+                auto edge1 = glm::vec3(_vertices[_faces[i + 1].vertexId] - _vertices[_faces[i].vertexId]);
+                auto edge2 = glm::vec3(_vertices[_faces[i + 2].vertexId] - _vertices[_faces[i].vertexId]);
                 auto normal = glm::normalize(glm::cross(edge1, edge2));
 
                 normals.push_back(normal);
@@ -326,9 +254,8 @@ class Obj : public Base
             }
             else
             {
-                normals.push_back(_normals[face[0].normalId]);
-                normals.push_back(_normals[face[1].normalId]);
-                normals.push_back(_normals[face[2].normalId]);
+                for (uint32_t v = 0; v < 3; ++v)
+                    normals.push_back(_faces[i + v].normalId == -1 ? glm::vec3(0.f, 0.f, 1.f) : _normals[_faces[i + v].normalId]);
             }
         }
 
@@ -352,7 +279,168 @@ class Obj : public Base
         int uvId{-1};
         int normalId{-1};
     };
-    std::vector<std::vector<FaceVertex>> _faces;
+    std::vector<FaceVertex> _faces; //!< Triangulated faces, three vertices per face
+
+    /**
+     * Check whether a character is a space or tab
+     * \param c Character
+     * \return Return true if the character is a space
+     */
+    static bool isSpace(char c) { return c == ' ' || c == '\t' || c == '\r'; }
+
+    /**
+     * Move the pointer after any space
+     * \param ptr Pointer to move
+     * \param end End of the line
+     */
+    static void skipSpaces(const char*& ptr, const char* end)
+    {
+        while (ptr < end && isSpace(*ptr))
+            ++ptr;
+    }
+
+    /**
+     * Parse a float and move the pointer after it
+     * \param ptr Pointer to the beginning of the float, moved after the float if parsed successfully
+     * \param end End of the line
+     * \param value Parsed value
+     * \return Return true if a float has been parsed
+     */
+    static bool parseFloat(const char*& ptr, const char* end, float& value)
+    {
+        skipSpaces(ptr, end);
+
+        // The mapped file is not null-terminated, so the token is copied to a buffer for strtof
+        char token[64];
+        size_t length = 0;
+        while (ptr + length < end && !isSpace(ptr[length]) && length < sizeof(token) - 1)
+        {
+            token[length] = ptr[length];
+            ++length;
+        }
+        if (length == 0)
+            return false;
+        token[length] = '\0';
+
+        char* tokenEnd = nullptr;
+        value = std::strtof(token, &tokenEnd);
+        if (tokenEnd == token)
+            return false;
+
+        ptr += tokenEnd - token;
+        return true;
+    }
+
+    /**
+     * Parse an integer and move the pointer after it
+     * \param ptr Pointer to the beginning of the integer, moved after the integer if parsed successfully
+     * \param end End of the line
+     * \param value Parsed value
+     * \return Return true if an integer has been parsed
+     */
+    static bool parseInt(const char*& ptr, const char* end, int& value)
+    {
+        auto current = ptr;
+        bool negative = false;
+        if (current < end && (*current == '-' || *current == '+'))
+            negative = *(current++) == '-';
+
+        if (current >= end || *current < '0' || *current > '9')
+            return false;
+
+        value = 0;
+        while (current < end && *current >= '0' && *current <= '9')
+            value = value * 10 + (*(current++) - '0');
+        if (negative)
+            value = -value;
+
+        ptr = current;
+        return true;
+    }
+
+    /**
+     * Parse a face vertex definition, i.e: 1, 1/2, 1//3, 1/2/3 or 1/2/
+     * \param ptr Pointer to the beginning of the definition, moved after it
+     * \param end End of the line
+     * \param faceVertex Parsed face vertex, with 0-based indices
+     * \return Return true if a face vertex has been parsed
+     */
+    bool parseFaceVertex(const char*& ptr, const char* end, FaceVertex& faceVertex) const
+    {
+        skipSpaces(ptr, end);
+
+        int vertexId, uvId, normalId;
+        if (!parseInt(ptr, end, vertexId))
+            return false;
+
+        faceVertex = FaceVertex();
+        faceVertex.vertexId = resolveIndex(vertexId, _vertices.size());
+        if (ptr < end && *ptr == '/')
+        {
+            ++ptr;
+            if (parseInt(ptr, end, uvId))
+                faceVertex.uvId = resolveIndex(uvId, _uvs.size());
+            if (ptr < end && *ptr == '/')
+            {
+                ++ptr;
+                if (parseInt(ptr, end, normalId))
+                    faceVertex.normalId = resolveIndex(normalId, _normals.size());
+            }
+        }
+
+        // Skip anything left in this definition
+        while (ptr < end && !isSpace(*ptr))
+            ++ptr;
+
+        return true;
+    }
+
+    /**
+     * Convert an obj index to a 0-based index, negative indices being relative to the end of the list
+     * \param index Index as written in the file
+     * \param count Number of elements defined so far
+     * \return Return the 0-based index
+     */
+    static int resolveIndex(int index, size_t count) { return index < 0 ? static_cast<int>(count) + index : index - 1; }
+
+    /**
+     * Reorder the faces for vertex locality, keeping the vertices of each face in their order
+     */
+    void reorderFaces()
+    {
+        std::vector<uint32_t> indices(_faces.size());
+        for (size_t i = 0; i < _faces.size(); ++i)
+            indices[i] = static_cast<uint32_t>(_faces[i].vertexId);
+
+        auto order = VertexCache::optimizeTriangleOrder(indices, static_cast<uint32_t>(_vertices.size()));
+        if (order.size() * 3 != _faces.size())
+            return;
+
+        std::vector<FaceVertex> faces;
+        faces.reserve(_faces.size());
+        for (auto triangle : order)
+            for (size_t corner = 0; corner < 3; ++corner)
+                faces.push_back(_faces[triangle * 3 + corner]);
+        _faces = std::move(faces);
+    }
+
+    /**
+     * Check that all face indices refer to defined elements
+     * \return Return true if all indices are valid
+     */
+    bool checkFaces() const
+    {
+        for (auto& faceVertex : _faces)
+        {
+            if (faceVertex.vertexId < 0 || faceVertex.vertexId >= static_cast<int>(_vertices.size()))
+                return false;
+            if (faceVertex.uvId >= static_cast<int>(_uvs.size()) || faceVertex.normalId >= static_cast<int>(_normals.size()))
+                return false;
+            if (faceVertex.uvId < -1 || faceVertex.normalId < -1)
+                return false;
+        }
+        return true;
+    }
 };
 
 } // end of namespace
@@ -3,9 +3,14 @@
 #include <fstream>
 
 #include "./core/scene.h"
+#include "./graphics/camera.h"
 #include "./graphics/texture.h"
+#include "./utils/log.h"
 #include "./utils/timer.h"
 
+// Maximum number of frame buffers, frames are dropped if they are all referenced
+#define SPLASH_SINK_MAX_POOLED_FRAMES 8
+
 using namespace std;
 
 namespace Splash
@@ -29,13 +34,23 @@ Sink::~Sink()
     if (!_root)
         return;
 
-    if (_mappedPixels)
-    {
-        glUnmapNamedBuffer(_pbos[_pboWriteIndex]);
-        _mappedPixels = nullptr;
-    }
+    deletePbos();
+}
+
+/*************/
+shared_ptr<const ResizableArray<uint8_t>> Sink::getFrame(uint64_t* index)
+{
+    lock_guard<mutex> lock(_lockPixels);
+    if (index)
+        *index = _frameIndex;
+    return _frame;
+}
 
-    glDeleteBuffers(_pbos.size(), _pbos.data());
+/*************/
+bool Sink::waitForFrame(uint64_t index, int64_t timeout)
+{
+    unique_lock<mutex> lock(_lockPixels);
+    return _frameCondition.wait_for(lock, chrono::microseconds(timeout), [&]() { return _frameIndex > index; });
 }
 
 /*************/
@@ -54,7 +69,7 @@ bool Sink::linkIt(const shared_ptr<GraphObject>& obj)
         _inputFilter = dynamic_pointer_cast<Filter>(obj);
         return true;
     }
-    else if (auto objAsTexture = dynamic_pointer_cast<Texture>(obj); objAsTexture)
+    else if (dynamic_pointer_cast<Texture>(obj) || dynamic_pointer_cast<Camera>(obj))
     {
         auto filter = dynamic_pointer_cast<Filter>(_root->createObject("filter", getName() + "_" + obj->getName() + "_filter").lock());
         filter->setSavable(_savable); // We always save the filters as they hold user-specified values, if this is savable
@@ -75,7 +90,7 @@ void Sink::unlinkIt(const shared_ptr<GraphObject>& obj)
         objAsFilter->setSixteenBpc(true);
         _inputFilter.reset();
     }
-    else if (auto objAsTexture = dynamic_pointer_cast<Texture>(obj); objAsTexture)
+    else if (dynamic_pointer_cast<Texture>(obj) || dynamic_pointer_cast<Camera>(obj))
     {
         auto filterName = getName() + "_" + obj->getName() + "_filter";
 
@@ -92,26 +107,77 @@ void Sink::unlinkIt(const shared_ptr<GraphObject>& obj)
 /*************/
 void Sink::render()
 {
-    if (!_inputFilter || !_mappedPixels)
+    if (!_inputFilter || _pboReadyIndex < 0)
+        return;
+
+    handlePixels(reinterpret_cast<char*>(_pbosPixels[_pboReadyIndex]), _spec);
+
+    // The PBO can now be downloaded to again
+    glDeleteSync(_pboFences[_pboReadyIndex]);
+    _pboFences[_pboReadyIndex] = nullptr;
+    _pboReadyIndex = -1;
+}
+
+/*************/
+GraphObject::MemoryUsage Sink::getMemoryUsage() const
+{
+    MemoryUsage usage;
+    usage.vram = static_cast<int64_t>(_pbos.size() * _pboSize);
+    usage.ram = static_cast<int64_t>(_image.getRawBuffer().size());
+
+    lock_guard<mutex> lock(_lockPixels);
+    for (const auto& buffer : _framePool)
+        usage.ram += static_cast<int64_t>(buffer->size());
+    return usage;
+}
+
+/*************/
+void Sink::setGrouped(bool grouped)
+{
+    if (grouped == _grouped)
         return;
 
-    handlePixels(reinterpret_cast<char*>(_mappedPixels), _spec);
+    _grouped = grouped;
+    _lastFrameTiming = 0;
+    if (_grouped)
+        deletePbos();
+}
+
+/*************/
+void Sink::handleGroupedPixels(const char* pixels, const ImageBufferSpec& spec)
+{
+    if (!_grouped || !_opened)
+        return;
+
+    uint64_t currentTime = Timer::get().getTime();
+    uint64_t period = static_cast<uint64_t>(1e6 / (double)_framerate);
+    if (period != 0 && _lastFrameTiming != 0 && currentTime - _lastFrameTiming < period)
+        return;
+    _lastFrameTiming = currentTime;
+
+    _spec = spec;
+    handlePixels(pixels, spec);
 }
 
 /*************/
 void Sink::update()
 {
-    if (!_inputFilter)
+    if (!_inputFilter || _grouped)
         return;
 
     auto textureSpec = _inputFilter->getSpec();
     if (textureSpec.rawSize() == 0)
         return;
 
-    if (!_pbos.empty() && _mappedPixels)
+    // Check whether the oldest download is complete, without waiting for it
+    if (!_pbos.empty() && _pboReadyIndex < 0 && _pboFences[_pboReadIndex])
     {
-        glUnmapNamedBuffer(_pbos[_pboWriteIndex]);
-        _mappedPixels = nullptr;
+        auto status = glClientWaitSync(_pboFences[_pboReadIndex], 0, 0);
+        if (status == GL_ALREADY_SIGNALED || status == GL_CONDITION_SATISFIED)
+        {
+            _pboReadyIndex = _pboReadIndex;
+            _pboReadIndex = (_pboReadIndex + 1) % static_cast<int>(_pbos.size());
+        }
     }
 
     if (!_opened)
@@ -130,6 +196,10 @@ void Sink::update()
         _image = ImageBuffer(_spec);
     }
 
+    // All PBOs hold pixels not handled yet, the frame is dropped instead of stalling
+    if (_pbos.empty() || _pboFences[_pboWriteIndex])
+        return;
+
     glBindBuffer(GL_PIXEL_PACK_BUFFER, _pbos[_pboWriteIndex]);
 
     auto scene = dynamic_cast<Scene*>(_root);
@@ -171,34 +241,94 @@ void Sink::update()
 
     glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
 
-    _pboWriteIndex = (_pboWriteIndex + 1) % _pbos.size();
-
-    _mappedPixels = (GLubyte*)glMapNamedBufferRange(_pbos[_pboWriteIndex], 0, _spec.rawSize(), GL_MAP_READ_BIT);
+    _pboFences[_pboWriteIndex] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    _pboWriteIndex = (_pboWriteIndex + 1) % static_cast<int>(_pbos.size());
 }
 
 /*************/
 void Sink::handlePixels(const char* pixels, const ImageBufferSpec& spec)
 {
+    // A buffer only referenced by the pool is neither the last frame nor held by a reader
+    shared_ptr<ResizableArray<uint8_t>> buffer{nullptr};
+    {
+        lock_guard<mutex> lock(_lockPixels);
+        for (const auto& pooledBuffer : _framePool)
+        {
+            if (pooledBuffer.use_count() == 1)
+            {
+                buffer = pooledBuffer;
+                break;
+            }
+        }
+
+        if (!buffer)
+        {
+            if (_framePool.size() >= SPLASH_SINK_MAX_POOLED_FRAMES)
+                return;
+            buffer = make_shared<ResizableArray<uint8_t>>();
+            _framePool.push_back(buffer);
+        }
+    }
+
     uint32_t size = spec.rawSize();
-    if (size != _buffer.size())
-        _buffer.resize(size);
+    if (size != buffer->size())
+        buffer->resize(size);
+    memcpy(buffer->data(), pixels, size);
 
-    memcpy(_buffer.data(), pixels, size);
+    {
+        lock_guard<mutex> lock(_lockPixels);
+        _frame = buffer;
+        ++_frameIndex;
+    }
+    _frameCondition.notify_all();
 }
 
 /*************/
 void Sink::updatePbos(int width, int height, int bytes)
 {
-    if (!_pbos.empty())
-        glDeleteBuffers(_pbos.size(), _pbos.data());
+    deletePbos();
+
+    // The PBOs are mapped once and for all, the fences telling when their content can be read
+    auto flags = GL_MAP_READ_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+    auto size = width * height * bytes;
 
     _pbos.resize(_pboCount);
+    _pbosPixels.resize(_pboCount);
+    _pboFences.resize(_pboCount, nullptr);
+    _pboSize = size;
     glCreateBuffers(_pbos.size(), _pbos.data());
 
     for (uint32_t i = 0; i < _pbos.size(); ++i)
-        glNamedBufferData(_pbos[i], width * height * bytes, 0, GL_STREAM_READ);
+    {
+        glNamedBufferStorage(_pbos[i], size, 0, flags);
+        _pbosPixels[i] = (GLubyte*)glMapNamedBufferRange(_pbos[i], 0, size, flags);
+
+        if (!_pbosPixels[i])
+        {
+            Log::get() << Log::ERROR << "Sink::" << __FUNCTION__ << " - Unable to initialize download PBOs" << Log::endl;
+            deletePbos();
+            return;
+        }
+    }
+}
+
+/*************/
+void Sink::deletePbos()
+{
+    for (auto& fence : _pboFences)
+        if (fence)
+            glDeleteSync(fence);
+
+    if (!_pbos.empty())
+        glDeleteBuffers(_pbos.size(), _pbos.data());
 
+    _pbos.clear();
+    _pbosPixels.clear();
+    _pboFences.clear();
+    _pboSize = 0;
     _pboWriteIndex = 0;
+    _pboReadIndex = 0;
+    _pboReadyIndex = -1;
 }
 
 /*************/
@@ -25,9 +25,11 @@
 #ifndef SPLASH_SINK_H
 #define SPLASH_SINK_H
 
+#include <condition_variable>
 #include <future>
 #include <memory>
 #include <mutex>
+#include <vector>
 
 #include "./core/constants.h"
 
@@ -53,10 +55,20 @@ class Sink : public GraphObject
     virtual ~Sink() override;
 
     /**
-     * Get the current buffer as a resizable array
-     * \return Return the buffer
+     * Get the last frame handled by the sink, without copying it
+     * The frame is not modified while it is referenced, it goes back to the frame pool once released.
+     * \param index If not null, set to the index of the returned frame, which increases with each new frame
+     * \return Return the frame, or nullptr if none has been handled yet
      */
-    ResizableArray<uint8_t> getBuffer() const { return _buffer; };
+    std::shared_ptr<const ResizableArray<uint8_t>> getFrame(uint64_t* index = nullptr);
+
+    /**
+     * Wait for a frame newer than the given one
+     * \param index Index of the last frame known by the caller
+     * \param timeout Maximum waiting time, in us
+     * \return Return true if a newer frame is available
+     */
+    bool waitForFrame(uint64_t index, int64_t timeout);
 
     /**
      * Generate a caps from the input texture spec
@@ -64,6 +76,37 @@ class Sink : public GraphObject
      */
     std::string getCaps() const;
 
+    /**
+     * Get the memory held by the download PBOs and the frame buffers
+     * \return Return the memory usage
+     */
+    MemoryUsage getMemoryUsage() const final;
+
+    /**
+     * Get the filter read back by the sink
+     * \return Return the input filter, or nullptr if not linked
+     */
+    std::shared_ptr<Filter> getInputFilter() const { return _inputFilter; }
+
+    /**
+     * Set whether the sink is read back by a Sink_Group, in which case it does not download its input by itself
+     * \param grouped If true, the download PBOs are released and frames only come from handleGroupedPixels
+     */
+    void setGrouped(bool grouped);
+
+    /**
+     * Get whether the sink can be given frames scaled down by a Sink_Group
+     * \return Return true if the pixels can be resampled
+     */
+    virtual bool acceptsScaledFrames() const { return true; }
+
+    /**
+     * Handle a frame read back by a Sink_Group, honoring the opened state and the framerate of the sink
+     * \param pixels Frame pixels, only valid during the call
+     * \param spec Frame specifications
+     */
+    void handleGroupedPixels(const char* pixels, const ImageBufferSpec& spec);
+
     /**
      * Update the inner buffer of the sink
      */
@@ -98,19 +141,28 @@ class Sink : public GraphObject
     std::shared_ptr<Filter> _inputFilter{nullptr};
     ImageBufferSpec _spec{};
     ImageBuffer _image{};
-    std::mutex _lockPixels{};
-    ResizableArray<uint8_t> _buffer{};
+    mutable std::mutex _lockPixels{};
+    std::condition_variable _frameCondition{};                          //!< Signaled when a new frame is available, used with _lockPixels
+    std::vector<std::shared_ptr<ResizableArray<uint8_t>>> _framePool{}; //!< Frame buffers, reused once nothing else references them
+    std::shared_ptr<ResizableArray<uint8_t>> _frame{nullptr};           //!< Last frame handled
+    uint64_t _frameIndex{0};                                            //!< Index of the last frame handled, 0 if none
 
-    bool _opened{false}; //!< If true, the sink lets frames through
+    bool _opened{false};  //!< If true, the sink lets frames through
+    bool _grouped{false}; //!< If true, frames are read back by a Sink_Group
 
     uint64_t _lastFrameTiming{0};
     uint32_t _pboCount{3};
     std::vector<GLuint> _pbos{};
-    int _pboWriteIndex{0};
-    GLubyte* _mappedPixels{nullptr};
+    std::vector<GLubyte*> _pbosPixels{}; //!< Persistent mappings of the PBOs
+    size_t _pboSize{0};                  //!< Size of each PBO, in bytes
+    std::vector<GLsync> _pboFences{};    //!< Fences set after each download to a PBO, until its pixels are handled
+    int _pboWriteIndex{0};               //!< Next PBO to download to
+    int _pboReadIndex{0};                //!< Oldest PBO holding a pending download
+    int _pboReadyIndex{-1};              //!< PBO whose download is complete and not handled yet, or -1
 
     /**
-     * Class to be implemented to copy the _mappedPixels somewhere
+     * Class to be implemented to copy the pixels somewhere
+     * The pixels point directly to the mapped GPU buffer, they are only valid during the call
      */
     virtual void handlePixels(const char* pixels, const ImageBufferSpec& spec);
 
@@ -121,6 +173,11 @@ class Sink : public GraphObject
      * \param bytes Bytes per pixel
      */
     void updatePbos(int width, int height, int bytes);
+
+    /**
+     * Delete the PBOs along with their fences
+     */
+    void deletePbos();
 };
 
 } // namespace Splash
@@ -0,0 +1,434 @@
+#include "./sink/sink_encoded.h"
+
+#include <algorithm>
+#include <cstring>
+#include <regex>
+
+#include "./utils/log.h"
+#include "./utils/osutils.h"
+#include "./utils/timer.h"
+
+using namespace std;
+
+namespace Splash
+{
+
+/*************/
+Sink_Encoded::Sink_Encoded(RootObject* root)
+    : Sink(root)
+{
+    _type = "sink_encoded";
+    registerAttributes();
+
+    _encodeThread = thread([&]() { encodeLoop(); });
+}
+
+/*************/
+Sink_Encoded::~Sink_Encoded()
+{
+    stopEncoding();
+}
+
+/*************/
+void Sink_Encoded::stopEncoding()
+{
+    {
+        lock_guard<mutex> lock(_encodeMutex);
+        _encodeThreadRunning = false;
+    }
+    _encodeCondition.notify_one();
+    if (_encodeThread.joinable())
+        _encodeThread.join();
+
+    lock_guard<mutex> lock(_encodeMutex);
+    closeOutput();
+    freeFFmpegObjects();
+}
+
+/*************/
+AVCodec* Sink_Encoded::findEncoderByName(const string& codecName)
+{
+    AVCodec* codec{nullptr};
+
+    if (codecName == "h264")
+    {
+        codec = avcodec_find_encoder_by_name("h264_nvenc");
+        if (!codec)
+            codec = avcodec_find_encoder_by_name("h264_vaapi");
+        if (!codec)
+            codec = avcodec_find_encoder_by_name("h264_amf");
+        if (!codec)
+            codec = avcodec_find_encoder_by_name("libx264");
+    }
+    else if (codecName == "hevc")
+    {
+        codec = avcodec_find_encoder_by_name("hvec_nvenc");
+        if (!codec)
+            codec = avcodec_find_encoder_by_name("hevc_vaapi");
+        if (!codec)
+            codec = avcodec_find_encoder_by_name("hevc_amf");
+        if (!codec)
+            codec = avcodec_find_encoder_by_name("libx265");
+    }
+
+    else if (codecName == "hap")
+    {
+        codec = avcodec_find_encoder_by_name("hap");
+    }
+
+    return codec;
+}
+
+/*************/
+unordered_map<string, string> Sink_Encoded::parseOptions(const string& options)
+{
+    regex re("(([^=]+)=([^ ,]+))+");
+    auto sre_begin = sregex_iterator(options.begin(), options.end(), re);
+    auto sre_end = sregex_iterator();
+
+    unordered_map<string, string> result;
+    for (auto i = sre_begin; i != sre_end; ++i)
+    {
+        std::smatch match = *i;
+        auto key = match[2];
+        auto value = match[3];
+        result[key] = value;
+    }
+
+    return result;
+}
+
+/*************/
+bool Sink_Encoded::initFFmpegObjects(const ImageBufferSpec& spec, bool isYuv)
+{
+    _codec = findEncoderByName(_codecName);
+    if (!_codec)
+    {
+        Log::get() << Log::WARNING << "Sink_Encoded::" << __FUNCTION__ << " - Unable to find encoder for codec " << _codecName << Log::endl;
+        return false;
+    }
+
+    _context = avcodec_alloc_context3(_codec);
+    if (!_context)
+    {
+        Log::get() << Log::WARNING << "Sink_Encoded::" << __FUNCTION__ << " - Unable to allocate video codec context for codec " << _codecName << Log::endl;
+        return false;
+    }
+
+    _context->bit_rate = _bitRate;
+    _context->width = spec.width;
+    _context->height = spec.height;
+    _context->time_base = (AVRational){1, static_cast<int>(_framerate)};
+    _context->framerate = (AVRational){static_cast<int>(_framerate), 1};
+    _context->sample_aspect_ratio = (AVRational){static_cast<int>(spec.width), static_cast<int>(spec.height)};
+    _context->pix_fmt = _pixelFormat;
+    if (_keyframeInterval > 0)
+        _context->gop_size = _keyframeInterval;
+    if (needsGlobalHeader())
+        _context->flags |= AV_CODEC_FLAG_GLOBAL_HEADER;
+
+    auto options = parseOptions(_options);
+    for (auto& option : options)
+        av_opt_set(_context->priv_data, option.first.c_str(), option.second.c_str(), 0);
+
+    if (avcodec_open2(_context, _codec, nullptr) < 0)
+    {
+        Log::get() << Log::WARNING << "Sink_Encoded::" << __FUNCTION__ << " - Unable to open codec " << _codecName << Log::endl;
+        return false;
+    }
+
+    _frame = av_frame_alloc();
+    _yuvFrame = av_frame_alloc();
+    if (!_frame || !_yuvFrame)
+    {
+        Log::get() << Log::WARNING << "Sink_Encoded::" << __FUNCTION__ << " - Unable to allocate frame" << Log::endl;
+        return false;
+    }
+
+    _yuvFrame->format = _pixelFormat;
+    _yuvFrame->width = spec.width;
+    _yuvFrame->height = spec.height;
+
+    // The encoded frame then points directly to the pixels read back, no conversion nor copy is needed
+    if (isYuv || _pixelFormat == AV_PIX_FMT_RGBA)
+    {
+        _startTime = Timer::get().getTime();
+        _lastPts = -1;
+        return true;
+    }
+
+    _swsContext = sws_getContext(spec.width, spec.height, AV_PIX_FMT_RGB32, spec.width, spec.height, _pixelFormat, SWS_BILINEAR, nullptr, nullptr, nullptr);
+
+    _frame->format = AV_PIX_FMT_RGB32;
+    _frame->width = spec.width;
+    _frame->height = spec.height;
+    if (av_image_alloc(_frame->data, _frame->linesize, _context->width, _context->height, AV_PIX_FMT_RGB32, 32) < 0)
+    {
+        Log::get() << Log::WARNING << "Sink_Encoded::" << __FUNCTION__ << " - Unable to allocate raw RGBA picture buffer" << Log::endl;
+        return false;
+    }
+
+    if (av_image_alloc(_yuvFrame->data, _yuvFrame->linesize, _context->width, _context->height, _pixelFormat, 32) < 0)
+    {
+        Log::get() << Log::WARNING << "Sink_Encoded::" << __FUNCTION__ << " - Unable to allocate raw YUV420 picture buffer" << Log::endl;
+        return false;
+    }
+
+    _startTime = Timer::get().getTime();
+    _lastPts = -1;
+    return true;
+}
+
+/*************/
+void Sink_Encoded::freeFFmpegObjects()
+{
+    if (_context)
+    {
+        avcodec_close(_context);
+        av_free(_context);
+        _context = nullptr;
+    }
+
+    if (_frame)
+        av_frame_free(&_frame);
+    if (_yuvFrame)
+        av_frame_free(&_yuvFrame);
+
+    if (_swsContext)
+    {
+        sws_freeContext(_swsContext);
+        _swsContext = nullptr;
+    }
+}
+
+/*************/
+bool Sink_Encoded::linkIt(const shared_ptr<GraphObject>& obj)
+{
+    if (auto objAsYuvFilter = dynamic_pointer_cast<FilterYuv>(obj); objAsYuvFilter)
+    {
+        if (!Sink::linkIt(obj))
+            return false;
+        _yuvFilter = objAsYuvFilter;
+        return true;
+    }
+
+    if (!_gpuConversion || _pixelFormat != AV_PIX_FMT_YUV420P || !dynamic_pointer_cast<Filter>(obj))
+        return Sink::linkIt(obj);
+
+    // Textures go through Sink::linkIt, which creates a filter and links it back here
+    auto yuvFilter = dynamic_pointer_cast<FilterYuv>(_root->createObject("filter_yuv", getName() + "_" + obj->getName() + "_yuv").lock());
+    if (!yuvFilter || !yuvFilter->linkTo(obj))
+        return false;
+    yuvFilter->setSavable(false);
+    yuvFilter->setAttribute("frameSize", {_encodingSize[0], _encodingSize[1]});
+
+    return linkIt(yuvFilter);
+}
+
+/*************/
+void Sink_Encoded::unlinkIt(const shared_ptr<GraphObject>& obj)
+{
+    auto yuvFilterName = getName() + "_" + obj->getName() + "_yuv";
+    if (auto yuvFilter = _root->getObject(yuvFilterName); yuvFilter && yuvFilter == _yuvFilter)
+    {
+        yuvFilter->unlinkFrom(obj);
+        Sink::unlinkIt(yuvFilter);
+        _yuvFilter.reset();
+        _root->disposeObject(yuvFilterName);
+        return;
+    }
+
+    if (obj == _yuvFilter)
+        _yuvFilter.reset();
+    Sink::unlinkIt(obj);
+}
+
+/*************/
+void Sink_Encoded::handlePixels(const char* pixels, const ImageBufferSpec& spec)
+{
+    auto size = spec.rawSize();
+    if (!pixels || size == 0)
+        return;
+
+    // The encoder is being reset, drop this frame instead of waiting for it
+    unique_lock<mutex> lock(_encodeMutex, try_to_lock);
+    if (!lock.owns_lock())
+        return;
+
+    // Any frame not yet taken by the encoding thread is replaced by this one
+    _pendingPixels.resize(size);
+    memcpy(_pendingPixels.data(), pixels, size);
+    _pendingSpec = spec;
+    _pendingIsYuv = _yuvFilter != nullptr;
+    _pendingTimestamp = Timer::get().getTime();
+    _hasPendingFrame = true;
+
+    lock.unlock();
+    _encodeCondition.notify_one();
+}
+
+/*************/
+void Sink_Encoded::encodeLoop()
+{
+    while (true)
+    {
+        if (!Utils::applyThreadClass(Utils::ThreadClass::decode))
+            Log::get() << Log::WARNING << "Sink_Encoded::" << __FUNCTION__ << " - Unable to apply the scheduling of the decode threads" << Log::endl;
+
+        unique_lock<mutex> lock(_encodeMutex);
+        _encodeCondition.wait(lock, [&]() { return _hasPendingFrame || !_encodeThreadRunning; });
+        if (!_encodeThreadRunning)
+            break;
+
+        swap(_pendingPixels, _encodedPixels);
+        _hasPendingFrame = false;
+        auto spec = _pendingSpec;
+        auto isYuv = _pendingIsYuv;
+        auto timestamp = _pendingTimestamp;
+
+        // When converted on the GPU, each RGBA texel holds four consecutive bytes of a YUV420P frame
+        auto frameSpec = spec;
+        if (isYuv)
+        {
+            frameSpec.width = spec.width * 4;
+            frameSpec.height = spec.height * 2 / 3;
+        }
+
+        // Reset while holding the lock, as it depends on the codec parameters
+        if (_resetEncoding || !_context || spec != _previousSpec || _previousFramerate != _framerate)
+        {
+            _resetEncoding = false;
+
+            // Reset FFmpeg context and stuff, then the output which may depend on the codec context
+            closeOutput();
+            freeFFmpegObjects();
+            if (!initFFmpegObjects(frameSpec, isYuv) || !openOutput(frameSpec, spec.rawSize()))
+            {
+                // Without a codec context, everything is tried again with the next frame
+                freeFFmpegObjects();
+                continue;
+            }
+
+            _previousSpec = spec;
+            _previousFramerate = _framerate;
+        }
+
+        lock.unlock();
+        encodeFrame(_encodedPixels.data(), frameSpec, isYuv, timestamp);
+    }
+}
+
+/*************/
+void Sink_Encoded::encodeFrame(const char* pixels, const ImageBufferSpec& spec, bool isYuv, int64_t timestamp)
+{
+    av_init_packet(&_packet);
+    _packet.data = nullptr;
+    _packet.size = 0;
+
+    if (isYuv)
+    {
+        av_image_fill_arrays(_yuvFrame->data, _yuvFrame->linesize, reinterpret_cast<const uint8_t*>(pixels), AV_PIX_FMT_YUV420P, spec.width, spec.height, 1);
+    }
+    else if (_pixelFormat == AV_PIX_FMT_RGBA)
+    {
+        av_image_fill_arrays(_yuvFrame->data, _yuvFrame->linesize, reinterpret_cast<const uint8_t*>(pixels), AV_PIX_FMT_RGBA, spec.width, spec.height, 1);
+    }
+    else
+    {
+        av_image_fill_arrays(_frame->data, _frame->linesize, reinterpret_cast<const uint8_t*>(pixels), AV_PIX_FMT_RGB32, spec.width, spec.height, 1);
+        sws_scale(_swsContext, _frame->data, _frame->linesize, 0, spec.height, _yuvFrame->data, _yuvFrame->linesize);
+    }
+
+    // Timestamps are expressed in frames, and must be strictly increasing
+    auto pts = static_cast<int64_t>(static_cast<double>(timestamp - _startTime) * _framerate / 1e6);
+    _lastPts = std::max(pts, _lastPts + 1);
+    _yuvFrame->pts = _lastPts;
+    _yuvFrame->quality = _context->global_quality;
+    _yuvFrame->pict_type = AV_PICTURE_TYPE_NONE;
+
+    auto ret = avcodec_send_frame(_context, _yuvFrame);
+    if (ret < 0)
+    {
+        Log::get() << Log::WARNING << "Sink_Encoded::" << __FUNCTION__ << " - Error encoding frame" << Log::endl;
+        return;
+    }
+
+    while (1)
+    {
+        ret = avcodec_receive_packet(_context, &_packet);
+        if (ret == AVERROR(EAGAIN))
+            break;
+        else if (ret < 0)
+            return;
+
+        if (_packet.size != 0)
+            writePacket(&_packet);
+        av_packet_unref(&_packet);
+    }
+}
+
+/*************/
+void Sink_Encoded::registerAttributes()
+{
+    Sink::registerAttributes();
+
+    addAttribute("bitrate",
+        [&](const Values& args) {
+            lock_guard<mutex> lock(_encodeMutex);
+            _bitRate = std::max(1000000, args[0].as<int>());
+            _resetEncoding = true;
+            return true;
+        },
+        [&]() -> Values { return {_bitRate}; },
+        {'i'});
+    setAttributeDescription("bitrate", "Output encoded video target bitrate");
+
+    addAttribute("codec",
+        [&](const Values& args) {
+            lock_guard<mutex> lock(_encodeMutex);
+            _codecName = args[0].as<string>();
+            transform(_codecName.begin(), _codecName.end(), _codecName.begin(), ::tolower);
+            _resetEncoding = true;
+            return true;
+        },
+        [&]() -> Values { return {_codecName}; },
+        {'s'});
+    setAttributeDescription("codec", "Desired codec");
+
+    addAttribute("codecOptions",
+        [&](const Values& args) {
+            lock_guard<mutex> lock(_encodeMutex);
+            _options = args[0].as<string>();
+            _resetEncoding = true;
+            return true;
+        },
+        [&]() -> Values { return {_options}; },
+        {'s'});
+    setAttributeDescription("codecOptions",
+        "Codec options as a string following the format: \"key1=value1, key2=value2, etc\".\n"
+        "Options can be listed with the following terminal command:\n"
+        "$ ffmpeg -h encoder=ENCODER_NAME");
+
+    addAttribute("encodingSize",
+        [&](const Values& args) {
+            _encodingSize[0] = args[0].as<int>();
+            _encodingSize[1] = args[1].as<int>();
+            if (_yuvFilter)
+                _yuvFilter->setAttribute("frameSize", {_encodingSize[0], _encodingSize[1]});
+            return true;
+        },
+        [&]() -> Values { return {_encodingSize[0], _encodingSize[1]}; },
+        {'i', 'i'});
+    setAttributeDescription("encodingSize", "Size of the encoded frames when converting on the GPU, the input size is used if set to 0");
+
+    addAttribute("gpuConversion",
+        [&](const Values& args) {
+            _gpuConversion = args[0].as<bool>();
+            return true;
+        },
+        [&]() -> Values { return {_gpuConversion}; },
+        {'b'});
+    setAttributeDescription("gpuConversion", "If true, frames are converted to YUV and scaled on the GPU before being read back. Applied when linking the next input");
+}
+
+} // namespace Splash
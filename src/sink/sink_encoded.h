@@ -0,0 +1,212 @@
+/*
+ * Copyright (C) 2026 Emmanuel Durand
+ *
+ * This file is part of Splash.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Splash is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Splash.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * @sink_encoded.h
+ * The Sink_Encoded base class, encoding the connected object with FFmpeg
+ */
+
+#ifndef SPLASH_SINK_ENCODED_H
+#define SPLASH_SINK_ENCODED_H
+
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+extern "C" {
+#include <libavcodec/avcodec.h>
+#include <libavformat/avformat.h>
+#include <libavutil/imgutils.h>
+#include <libavutil/opt.h>
+#include <libswscale/swscale.h>
+}
+
+#include "./graphics/filter_yuv.h"
+#include "./sink/sink.h"
+
+namespace Splash
+{
+
+/*************/
+//! Base class for sinks sending the connected object as an encoded video
+//! Frames are converted to YUV on the GPU if possible, and encoded in a dedicated thread.
+//! Derived classes implement where the packets are sent, and must call stopEncoding() in their destructor.
+class Sink_Encoded : public Sink
+{
+  public:
+    /**
+     * Constructor
+     */
+    Sink_Encoded(RootObject* root);
+
+    /**
+     * Destructor
+     */
+    virtual ~Sink_Encoded() override;
+
+  protected:
+    std::mutex _encodeMutex{};  //!< Protects the pending frame, the codec parameters and the encoder reset
+    bool _resetEncoding{false}; //!< If true, the encoder and the output are reset before the next frame
+
+    // Codec parameters
+    AVCodecContext* _context{nullptr};
+    std::string _codecName{"h264"};
+    int _bitRate{4000000};
+    std::string _options{"profile=baseline"};
+    int _keyframeInterval{0};                       //!< Frames between keyframes, the encoder default is used if not positive
+    AVPixelFormat _pixelFormat{AV_PIX_FMT_YUV420P}; //!< Pixel format fed to the encoder, either YUV420P or RGBA, set at construction
+
+    /**
+     * Stop the encoding thread, to be called by derived classes before their members are destroyed
+     */
+    void stopEncoding();
+
+    /**
+     * Open the output once the encoder has been (re)initialized, called from the encoding thread with _encodeMutex held
+     * \param spec Specifications of the encoded frames
+     * \param rawSize Size of the frames read back, in bytes
+     * \return Return true if the output is ready to receive packets
+     */
+    virtual bool openOutput(const ImageBufferSpec& spec, size_t rawSize) = 0;
+
+    /**
+     * Close the output, called from the encoding thread with _encodeMutex held, and when stopping
+     */
+    virtual void closeOutput() {}
+
+    /**
+     * Get whether the codec headers must be stored once in the container, instead of in the stream
+     * \return Return true to set the global header flag on the codec context
+     */
+    virtual bool needsGlobalHeader() const { return false; }
+
+    /**
+     * Send an encoded packet, called from the encoding thread
+     * \param packet Encoded packet, with timestamps in the codec time base
+     */
+    virtual void writePacket(AVPacket* packet) = 0;
+
+    /**
+     * Parse the options from the given string, formatted as:
+     * "key1=value1, key2=value2, etc"
+     * \param options String to parse
+     * \return Return a map of keys and values
+     */
+    static std::unordered_map<std::string, std::string> parseOptions(const std::string& options);
+
+    /**
+     * \brief Register new functors to modify attributes
+     */
+    void registerAttributes();
+
+  private:
+    ImageBufferSpec _previousSpec{};
+    uint32_t _previousFramerate{0};
+
+    // Conversion to YUV on the GPU, inserted between the input filter and the readback
+    bool _gpuConversion{true};                      //!< If true, a YUV filter is inserted when linking a filter
+    int _encodingSize[2]{0, 0};                     //!< Size of the encoded frames, the input size being used if not positive
+    std::shared_ptr<FilterYuv> _yuvFilter{nullptr}; //!< If set, the pixels handled are already in YUV420P layout
+
+    // Encoding thread, fed with the last frame read back
+    std::thread _encodeThread{};
+    std::condition_variable _encodeCondition{}; //!< Signaled when a frame is pending or when stopping
+    bool _encodeThreadRunning{true};
+    bool _hasPendingFrame{false};
+    std::vector<char> _pendingPixels{}; //!< Last frame handed over by the render thread
+    std::vector<char> _encodedPixels{}; //!< Frame being encoded, swapped with the pending one to avoid any allocation
+    ImageBufferSpec _pendingSpec{};
+    bool _pendingIsYuv{false};
+    int64_t _pendingTimestamp{0};
+
+    // FFmpeg objects
+    AVCodec* _codec{nullptr};
+    AVFrame *_frame{nullptr}, *_yuvFrame{nullptr}; //!< Frame read back, and frame sent to the encoder
+    SwsContext* _swsContext{nullptr};
+    AVPacket _packet;
+    int64_t _startTime{0ll};
+    int64_t _lastPts{-1}; //!< Timestamp of the last encoded frame, in the codec time base
+
+    /**
+     * Find an encoder base on its name
+     * \param encoderName Codec name
+     * \return Return a codec
+     */
+    AVCodec* findEncoderByName(const std::string& codecName);
+
+    /**
+     * Init FFmpeg objects
+     * \param spec Input image specifications
+     * \param isYuv True if the input pixels are already a YUV420P frame
+     * \return Return true if all went well
+     */
+    bool initFFmpegObjects(const ImageBufferSpec& spec, bool isYuv);
+
+    /**
+     * Free everything related to FFmpeg
+     */
+    void freeFFmpegObjects();
+
+    /**
+     * Try to link the given GraphObject to this object
+     * Filters are read back through a YUV conversion filter if GPU conversion is enabled
+     * \param obj Shared pointer to the (wannabe) child object
+     */
+    bool linkIt(const std::shared_ptr<GraphObject>& obj) final;
+
+    /**
+     * Try to unlink the given GraphObject from this object
+     * \param obj Shared pointer to the (supposed) child object
+     */
+    void unlinkIt(const std::shared_ptr<GraphObject>& obj) final;
+
+    /**
+     * Frames converted to YUV on the GPU are packed, and can not be resampled
+     * \return Return true if no YUV conversion filter is used
+     */
+    bool acceptsScaledFrames() const final { return _yuvFilter == nullptr; }
+
+    /**
+     * Hand the pixels over to the encoding thread
+     * If the previous frame has not been taken yet, it is dropped.
+     * \param pixels Input image
+     * \param spec Input image specifications
+     */
+    void handlePixels(const char* pixels, const ImageBufferSpec& spec) final;
+
+    /**
+     * Encoding thread loop, resets the encoder if needed and encodes the pending frames
+     */
+    void encodeLoop();
+
+    /**
+     * Encode a frame and send the resulting packets
+     * \param pixels Frame pixels
+     * \param spec Frame specifications, with the YUV frame size if isYuv is true
+     * \param isYuv True if the pixels are already a YUV420P frame
+     * \param timestamp Time at which the frame was read back, in us
+     */
+    void encodeFrame(const char* pixels, const ImageBufferSpec& spec, bool isYuv, int64_t timestamp);
+};
+
+} // namespace Splash
+
+#endif // SPLASH_SINK_ENCODED_H
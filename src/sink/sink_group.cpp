@@ -0,0 +1,364 @@
+#include "./sink/sink_group.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#include "./graphics/filter.h"
+#include "./utils/log.h"
+#include "./utils/timer.h"
+
+// Maximum width of the atlas, inputs going further are placed on a new row
+#define SPLASH_SINK_GROUP_MAX_ATLAS_WIDTH 8192
+
+using namespace std;
+
+namespace Splash
+{
+
+/*************/
+Sink_Group::Sink_Group(RootObject* root)
+    : GraphObject(root)
+{
+    _type = "sink_group";
+    _renderingPriority = Priority::POST_CAMERA;
+    registerAttributes();
+}
+
+/*************/
+Sink_Group::~Sink_Group()
+{
+    if (!_root)
+        return;
+
+    for (const auto& sink : _sinks)
+        sink->setGrouped(false);
+
+    deleteAtlas();
+    if (_readFbo)
+        glDeleteFramebuffers(1, &_readFbo);
+}
+
+/*************/
+bool Sink_Group::linkIt(const shared_ptr<GraphObject>& obj)
+{
+    auto sink = dynamic_pointer_cast<Sink>(obj);
+    if (!sink)
+        return false;
+
+    if (std::find(_sinks.begin(), _sinks.end(), sink) == _sinks.end())
+        _sinks.push_back(sink);
+    return true;
+}
+
+/*************/
+void Sink_Group::unlinkIt(const shared_ptr<GraphObject>& obj)
+{
+    auto sink = dynamic_pointer_cast<Sink>(obj);
+    if (!sink)
+        return;
+
+    auto sinkIt = std::find(_sinks.begin(), _sinks.end(), sink);
+    if (sinkIt == _sinks.end())
+        return;
+
+    sink->setGrouped(false);
+    _sinks.erase(sinkIt);
+}
+
+/*************/
+GraphObject::MemoryUsage Sink_Group::getMemoryUsage() const
+{
+    MemoryUsage usage;
+    usage.vram = static_cast<int64_t>(_atlasWidth) * _atlasHeight * 4 + static_cast<int64_t>(_pbos.size() * _pboSize);
+    usage.ram = static_cast<int64_t>(_framePixels.size());
+    return usage;
+}
+
+/*************/
+bool Sink_Group::updateLayout()
+{
+    vector<Region> regions;
+    int x = 0;
+    int y = 0;
+    int rowHeight = 0;
+    int atlasWidth = 0;
+
+    // Inputs are placed side by side, on rows as wide as the atlas allows
+    for (const auto& sink : _sinks)
+    {
+        auto filter = sink->getInputFilter();
+        if (!filter)
+        {
+            sink->setGrouped(false);
+            continue;
+        }
+
+        auto spec = filter->getSpec();
+        if (spec.rawSize() == 0 || spec.channels != 4 || spec.bpp != 32 || spec.type != ImageBufferSpec::Type::UINT8)
+        {
+            sink->setGrouped(false);
+            continue;
+        }
+
+        Region region;
+        region.sink = sink;
+        region.inputWidth = static_cast<int>(spec.width);
+        region.inputHeight = static_cast<int>(spec.height);
+
+        const auto scale = sink->acceptsScaledFrames() ? _scale : 1.f;
+        const auto width = std::max(1, static_cast<int>(std::round(spec.width * scale)));
+        const auto height = std::max(1, static_cast<int>(std::round(spec.height * scale)));
+        if (width > SPLASH_SINK_GROUP_MAX_ATLAS_WIDTH)
+        {
+            sink->setGrouped(false);
+            continue;
+        }
+
+        if (x != 0 && x + width > SPLASH_SINK_GROUP_MAX_ATLAS_WIDTH)
+        {
+            x = 0;
+            y += rowHeight;
+            rowHeight = 0;
+        }
+
+        region.x = x;
+        region.y = y;
+        region.spec = spec;
+        region.spec.width = width;
+        region.spec.height = height;
+        region.spec.timestamp = -1;
+
+        x += width;
+        rowHeight = std::max(rowHeight, height);
+        atlasWidth = std::max(atlasWidth, x);
+        regions.push_back(region);
+    }
+    const int atlasHeight = y + rowHeight;
+
+    for (const auto& region : regions)
+        region.sink->setGrouped(true);
+
+    bool changed = atlasWidth != _atlasWidth || atlasHeight != _atlasHeight || regions.size() != _regions.size();
+    for (size_t i = 0; !changed && i < regions.size(); ++i)
+    {
+        const auto& current = _regions[i];
+        const auto& next = regions[i];
+        changed = current.sink != next.sink || current.x != next.x || current.y != next.y || current.inputWidth != next.inputWidth ||
+                  current.inputHeight != next.inputHeight || current.spec.width != next.spec.width || current.spec.height != next.spec.height;
+    }
+
+    _regions = std::move(regions);
+    _atlasWidth = atlasWidth;
+    _atlasHeight = atlasHeight;
+    return changed;
+}
+
+/*************/
+bool Sink_Group::reallocate()
+{
+    // Pending downloads follow the previous layout, they are dropped
+    deleteAtlas();
+
+    if (_regions.empty())
+        return true;
+
+    if (!_readFbo)
+        glCreateFramebuffers(1, &_readFbo);
+
+    glCreateTextures(GL_TEXTURE_2D, 1, &_atlasTex);
+    glTextureStorage2D(_atlasTex, 1, GL_RGBA8, _atlasWidth, _atlasHeight);
+    glCreateFramebuffers(1, &_atlasFbo);
+    glNamedFramebufferTexture(_atlasFbo, GL_COLOR_ATTACHMENT0, _atlasTex, 0);
+    if (glCheckNamedFramebufferStatus(_atlasFbo, GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+    {
+        Log::get() << Log::ERROR << "Sink_Group::" << __FUNCTION__ << " - Unable to create a " << _atlasWidth << "x" << _atlasHeight << " atlas" << Log::endl;
+        deleteAtlas();
+        return false;
+    }
+
+    // The PBOs are mapped once and for all, the fences telling when their content can be read
+    auto flags = GL_MAP_READ_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+    auto size = static_cast<size_t>(_atlasWidth) * _atlasHeight * 4;
+
+    _pbos.resize(_pboCount);
+    _pbosPixels.resize(_pboCount);
+    _pboFences.resize(_pboCount, nullptr);
+    _pboSize = size;
+    glCreateBuffers(_pbos.size(), _pbos.data());
+
+    for (uint32_t i = 0; i < _pbos.size(); ++i)
+    {
+        glNamedBufferStorage(_pbos[i], size, 0, flags);
+        _pbosPixels[i] = (GLubyte*)glMapNamedBufferRange(_pbos[i], 0, size, flags);
+
+        if (!_pbosPixels[i])
+        {
+            Log::get() << Log::ERROR << "Sink_Group::" << __FUNCTION__ << " - Unable to initialize download PBOs" << Log::endl;
+            deleteAtlas();
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/*************/
+void Sink_Group::deleteAtlas()
+{
+    for (auto& fence : _pboFences)
+        if (fence)
+            glDeleteSync(fence);
+
+    if (!_pbos.empty())
+        glDeleteBuffers(_pbos.size(), _pbos.data());
+
+    _pbos.clear();
+    _pbosPixels.clear();
+    _pboFences.clear();
+    _pboSize = 0;
+    _pboWriteIndex = 0;
+    _pboReadIndex = 0;
+    _pboReadyIndex = -1;
+
+    if (_atlasFbo)
+        glDeleteFramebuffers(1, &_atlasFbo);
+    if (_atlasTex)
+        glDeleteTextures(1, &_atlasTex);
+    _atlasFbo = 0;
+    _atlasTex = 0;
+}
+
+/*************/
+void Sink_Group::update()
+{
+    if (updateLayout() || (!_regions.empty() && _pbos.size() != _pboCount))
+        if (!reallocate())
+            return;
+
+    if (_pbos.empty())
+        return;
+
+    // Check whether the oldest download is complete, without waiting for it
+    if (_pboReadyIndex < 0 && _pboFences[_pboReadIndex])
+    {
+        auto status = glClientWaitSync(_pboFences[_pboReadIndex], 0, 0);
+        if (status == GL_ALREADY_SIGNALED || status == GL_CONDITION_SATISFIED)
+        {
+            _pboReadyIndex = _pboReadIndex;
+            _pboReadIndex = (_pboReadIndex + 1) % static_cast<int>(_pbos.size());
+        }
+    }
+
+    uint64_t currentTime = Timer::get().getTime();
+    uint64_t period = static_cast<uint64_t>(1e6 / (double)_framerate);
+    if (period != 0 && _lastFrameTiming != 0 && currentTime - _lastFrameTiming < period)
+        return;
+
+    // All PBOs hold pixels not handled yet, the frame is dropped instead of stalling
+    if (_pboFences[_pboWriteIndex])
+        return;
+    _lastFrameTiming = currentTime;
+
+    for (const auto& region : _regions)
+    {
+        auto filter = region.sink->getInputFilter();
+        if (!filter)
+            continue;
+
+        const bool scaled = region.inputWidth != static_cast<int>(region.spec.width) || region.inputHeight != static_cast<int>(region.spec.height);
+        glNamedFramebufferTexture(_readFbo, GL_COLOR_ATTACHMENT0, filter->getTexId(), 0);
+        glBlitNamedFramebuffer(_readFbo,
+            _atlasFbo,
+            0,
+            0,
+            region.inputWidth,
+            region.inputHeight,
+            region.x,
+            region.y,
+            region.x + static_cast<int>(region.spec.width),
+            region.y + static_cast<int>(region.spec.height),
+            GL_COLOR_BUFFER_BIT,
+            scaled ? GL_LINEAR : GL_NEAREST);
+    }
+    glNamedFramebufferTexture(_readFbo, GL_COLOR_ATTACHMENT0, 0, 0);
+
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, _atlasFbo);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, _pbos[_pboWriteIndex]);
+    glReadPixels(0, 0, _atlasWidth, _atlasHeight, GL_RGBA, GL_UNSIGNED_INT_8_8_8_8_REV, 0);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+
+    _pboFences[_pboWriteIndex] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    _pboWriteIndex = (_pboWriteIndex + 1) % static_cast<int>(_pbos.size());
+}
+
+/*************/
+void Sink_Group::render()
+{
+    if (_pboReadyIndex < 0)
+        return;
+
+    const auto atlasPixels = _pbosPixels[_pboReadyIndex];
+    const auto atlasRowSize = static_cast<size_t>(_atlasWidth) * 4;
+    for (const auto& region : _regions)
+    {
+        const auto rowSize = static_cast<size_t>(region.spec.width) * 4;
+        const auto regionPixels = atlasPixels + region.y * atlasRowSize + region.x * 4;
+
+        // Regions spanning the whole atlas width are already contiguous
+        if (rowSize == atlasRowSize)
+        {
+            region.sink->handleGroupedPixels(reinterpret_cast<const char*>(regionPixels), region.spec);
+            continue;
+        }
+
+        _framePixels.resize(rowSize * region.spec.height);
+        for (uint32_t row = 0; row < region.spec.height; ++row)
+            memcpy(_framePixels.data() + row * rowSize, regionPixels + row * atlasRowSize, rowSize);
+        region.sink->handleGroupedPixels(reinterpret_cast<const char*>(_framePixels.data()), region.spec);
+    }
+
+    // The PBO can now be downloaded to again
+    glDeleteSync(_pboFences[_pboReadyIndex]);
+    _pboFences[_pboReadyIndex] = nullptr;
+    _pboReadyIndex = -1;
+}
+
+/*************/
+void Sink_Group::registerAttributes()
+{
+    GraphObject::registerAttributes();
+
+    addAttribute(
+        "bufferCount",
+        [&](const Values& args) {
+            _pboCount = max(args[0].as<int>(), 2);
+            return true;
+        },
+        [&]() -> Values { return {_pboCount}; },
+        {'i'});
+    setAttributeDescription("bufferCount", "Number of GPU buffers to use for data download to CPU memory");
+
+    addAttribute(
+        "framerate",
+        [&](const Values& args) {
+            _framerate = max(1, args[0].as<int>());
+            return true;
+        },
+        [&]() -> Values { return {_framerate}; },
+        {'i'});
+    setAttributeDescription("framerate", "Maximum download rate of the atlas, each sink also dropping frames according to its own framerate");
+
+    addAttribute(
+        "scale",
+        [&](const Values& args) {
+            _scale = std::clamp(args[0].as<float>(), 0.01f, 1.f);
+            return true;
+        },
+        [&]() -> Values { return {_scale}; },
+        {'r'});
+    setAttributeDescription("scale", "Scale applied to the inputs of the sinks in the atlas, sinks receiving YUV frames being kept at full size");
+}
+
+} // namespace Splash
@@ -0,0 +1,150 @@
+/*
+ * Copyright (C) 2026 Emmanuel Durand
+ *
+ * This file is part of Splash.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Splash is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Splash.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * @sink_group.h
+ * The Sink_Group class, reading back the inputs of many sinks at once
+ */
+
+#ifndef SPLASH_SINK_GROUP_H
+#define SPLASH_SINK_GROUP_H
+
+#include <memory>
+#include <vector>
+
+#include "./core/constants.h"
+
+#include "./core/attribute.h"
+#include "./core/graph_object.h"
+#include "./sink/sink.h"
+
+namespace Splash
+{
+
+/*************/
+//! Reads back the inputs of all the linked sinks through a single download, instead of one per sink
+//! The inputs are copied, optionally scaled down, side by side in an atlas texture which is downloaded through a ring of PBOs.
+//! Once a download is complete, each sink is handed its own part of the atlas. Only sinks whose input is 8 bits RGBA are grouped,
+//! the others keep on reading back their input by themselves.
+class Sink_Group : public GraphObject
+{
+  public:
+    /**
+     * Constructor
+     * \param root Root object
+     */
+    explicit Sink_Group(RootObject* root);
+
+    /**
+     * Destructor
+     */
+    ~Sink_Group() final;
+
+    Sink_Group(const Sink_Group&) = delete;
+    Sink_Group& operator=(const Sink_Group&) = delete;
+
+    /**
+     * Get the memory held by the atlas and the download PBOs
+     * \return Return the memory usage
+     */
+    MemoryUsage getMemoryUsage() const final;
+
+    /**
+     * Copy the inputs to the atlas and download it, if the framerate allows for it
+     */
+    void update() final;
+
+    /**
+     * Hand the last downloaded atlas over to the sinks
+     */
+    void render() final;
+
+  protected:
+    /**
+     * Try to link the given GraphObject to this object
+     * \param obj Shared pointer to the (wannabe) child object
+     */
+    bool linkIt(const std::shared_ptr<GraphObject>& obj) final;
+
+    /**
+     * Try to unlink the given GraphObject from this object
+     * \param obj Shared pointer to the (supposed) child object
+     */
+    void unlinkIt(const std::shared_ptr<GraphObject>& obj) final;
+
+  private:
+    struct Region
+    {
+        std::shared_ptr<Sink> sink{nullptr};
+        ImageBufferSpec spec{}; //!< Spec of the frames handed to the sink
+        int x{0};
+        int y{0};
+        int inputWidth{0};
+        int inputHeight{0};
+    };
+
+    std::vector<std::shared_ptr<Sink>> _sinks{};
+    std::vector<Region> _regions{};     //!< Regions of the grouped sinks in the atlas
+    std::vector<uint8_t> _framePixels{}; //!< Pixels of a single region, contiguous
+
+    float _scale{1.f};       //!< Scale applied to the inputs of the sinks accepting it
+    uint32_t _framerate{30}; //!< Maximum download rate
+    uint64_t _lastFrameTiming{0};
+
+    GLuint _atlasTex{0};
+    GLuint _atlasFbo{0};
+    GLuint _readFbo{0}; //!< Framebuffer the inputs are attached to, to be blitted to the atlas
+    int _atlasWidth{0};
+    int _atlasHeight{0};
+
+    uint32_t _pboCount{3};
+    std::vector<GLuint> _pbos{};
+    std::vector<GLubyte*> _pbosPixels{}; //!< Persistent mappings of the PBOs
+    std::vector<GLsync> _pboFences{};    //!< Fences set after each download to a PBO, until its pixels are handled
+    size_t _pboSize{0};                  //!< Size of each PBO, in bytes
+    int _pboWriteIndex{0};               //!< Next PBO to download to
+    int _pboReadIndex{0};                //!< Oldest PBO holding a pending download
+    int _pboReadyIndex{-1};              //!< PBO whose download is complete and not handled yet, or -1
+
+    /**
+     * Compute the regions of the sinks in the atlas, and set which sinks are grouped
+     * \return Return true if the layout changed since the last call
+     */
+    bool updateLayout();
+
+    /**
+     * Reallocate the atlas and the PBOs to the current layout
+     * \return Return true if all went well
+     */
+    bool reallocate();
+
+    /**
+     * Delete the atlas and the PBOs, along with their fences
+     */
+    void deleteAtlas();
+
+    /**
+     * Register new functors to modify attributes
+     */
+    void registerAttributes();
+};
+
+} // namespace Splash
+
+#endif // SPLASH_SINK_GROUP_H
@@ -0,0 +1,146 @@
+#include "./sink/sink_network.h"
+
+#include "./utils/log.h"
+
+#define SPLASH_SINK_NETWORK_PACKET_SIZE 1316 // Seven MPEG-TS packets, fitting in a single datagram
+
+using namespace std;
+
+namespace Splash
+{
+
+/*************/
+Sink_Network::Sink_Network(RootObject* root)
+    : Sink_Encoded(root)
+{
+    _type = "sink_network";
+    registerAttributes();
+}
+
+/*************/
+Sink_Network::~Sink_Network()
+{
+    stopEncoding();
+}
+
+/*************/
+string Sink_Network::getFormatName(const string& url)
+{
+    if (url.rfind("rtp://", 0) == 0)
+        return "rtp_mpegts";
+    return "mpegts";
+}
+
+/*************/
+bool Sink_Network::openOutput(const ImageBufferSpec& /*spec*/, size_t /*rawSize*/)
+{
+    auto formatName = getFormatName(_url);
+    if (avformat_alloc_output_context2(&_formatContext, nullptr, formatName.c_str(), _url.c_str()) < 0 || !_formatContext)
+    {
+        Log::get() << Log::WARNING << "Sink_Network::" << __FUNCTION__ << " - Unable to allocate the output context for " << _url << Log::endl;
+        return false;
+    }
+    _formatContext->max_delay = _latency * 1000;
+
+    _stream = avformat_new_stream(_formatContext, nullptr);
+    if (!_stream || avcodec_parameters_from_context(_stream->codecpar, _context) < 0)
+    {
+        Log::get() << Log::WARNING << "Sink_Network::" << __FUNCTION__ << " - Unable to create the output stream" << Log::endl;
+        closeOutput();
+        return false;
+    }
+    _stream->time_base = _context->time_base;
+
+    if (!(_formatContext->oformat->flags & AVFMT_NOFILE))
+    {
+        AVDictionary* options = nullptr;
+        if (_url.rfind("srt://", 0) == 0)
+            av_dict_set(&options, "latency", to_string(_latency * 1000).c_str(), 0);
+        av_dict_set(&options, "pkt_size", to_string(SPLASH_SINK_NETWORK_PACKET_SIZE).c_str(), 0);
+
+        auto result = avio_open2(&_formatContext->pb, _url.c_str(), AVIO_FLAG_WRITE, nullptr, &options);
+        av_dict_free(&options);
+        if (result < 0)
+        {
+            Log::get() << Log::WARNING << "Sink_Network::" << __FUNCTION__ << " - Unable to open " << _url << Log::endl;
+            closeOutput();
+            return false;
+        }
+    }
+
+    if (avformat_write_header(_formatContext, nullptr) < 0)
+    {
+        Log::get() << Log::WARNING << "Sink_Network::" << __FUNCTION__ << " - Unable to write the stream header to " << _url << Log::endl;
+        closeOutput();
+        return false;
+    }
+    _headerWritten = true;
+
+    return true;
+}
+
+/*************/
+void Sink_Network::closeOutput()
+{
+    if (!_formatContext)
+        return;
+
+    if (_headerWritten)
+        av_write_trailer(_formatContext);
+    _headerWritten = false;
+
+    if (!(_formatContext->oformat->flags & AVFMT_NOFILE))
+        avio_closep(&_formatContext->pb);
+
+    avformat_free_context(_formatContext);
+    _formatContext = nullptr;
+    _stream = nullptr;
+}
+
+/*************/
+void Sink_Network::writePacket(AVPacket* packet)
+{
+    if (!_formatContext || !_stream)
+        return;
+
+    av_packet_rescale_ts(packet, _context->time_base, _stream->time_base);
+    packet->stream_index = _stream->index;
+
+    // There is a single stream, so no interleaving is needed and packets are sent right away
+    if (av_write_frame(_formatContext, packet) < 0)
+    {
+        Log::get() << Log::WARNING << "Sink_Network::" << __FUNCTION__ << " - Unable to send packet to " << _url << ", reopening the output" << Log::endl;
+        lock_guard<mutex> lock(_encodeMutex);
+        _resetEncoding = true;
+    }
+}
+
+/*************/
+void Sink_Network::registerAttributes()
+{
+    addAttribute("url",
+        [&](const Values& args) {
+            lock_guard<mutex> lock(_encodeMutex);
+            _url = args[0].as<string>();
+            _resetEncoding = true;
+            return true;
+        },
+        [&]() -> Values { return {_url}; },
+        {'s'});
+    setAttributeDescription("url",
+        "Url to stream to, as srt://host:port, rtp://host:port or udp://host:port. The stream is sent as MPEG-TS.\n"
+        "SRT is used in caller mode, the receiver has to listen on the given port.");
+
+    addAttribute("latency",
+        [&](const Values& args) {
+            lock_guard<mutex> lock(_encodeMutex);
+            _latency = std::max(0, args[0].as<int>());
+            _resetEncoding = true;
+            return true;
+        },
+        [&]() -> Values { return {_latency}; },
+        {'i'});
+    setAttributeDescription("latency", "Target latency in milliseconds, used as the SRT buffer and as the maximum muxing delay");
+}
+
+} // namespace Splash
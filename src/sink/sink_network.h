@@ -0,0 +1,93 @@
+/*
+ * Copyright (C) 2026 Emmanuel Durand
+ *
+ * This file is part of Splash.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Splash is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Splash.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * @sink_network.h
+ * The Sink_Network class, streaming the connected object over SRT or RTP
+ */
+
+#ifndef SPLASH_SINK_NETWORK_H
+#define SPLASH_SINK_NETWORK_H
+
+#include <string>
+
+#include "./sink/sink_encoded.h"
+
+namespace Splash
+{
+
+/*************/
+//! Sink streaming the connected object as an encoded video in MPEG-TS, over SRT, RTP or UDP
+//! The stream is sent directly from the encoding thread, without going through an external pipeline.
+class Sink_Network : public Sink_Encoded
+{
+  public:
+    /**
+     * Constructor
+     */
+    Sink_Network(RootObject* root);
+
+    /**
+     * Destructor
+     */
+    ~Sink_Network() final;
+
+  private:
+    std::string _url{"srt://127.0.0.1:9000"};
+    int _latency{20}; //!< Latency in ms, used as the SRT receiver buffer and as the muxing delay
+    AVFormatContext* _formatContext{nullptr};
+    AVStream* _stream{nullptr};
+    bool _headerWritten{false};
+
+    /**
+     * Get the muxer to use for the given url
+     * \param url Output url
+     * \return Return the muxer name
+     */
+    static std::string getFormatName(const std::string& url);
+
+    /**
+     * Open the network output, and write the stream header
+     * \param spec Specifications of the encoded frames
+     * \param rawSize Size of the frames read back, in bytes
+     * \return Return true if the output has been opened
+     */
+    bool openOutput(const ImageBufferSpec& spec, size_t rawSize) final;
+
+    /**
+     * Close the network output
+     */
+    void closeOutput() final;
+
+    /**
+     * Mux and send an encoded packet
+     * If sending fails, the output is reopened before the next frame.
+     * \param packet Encoded packet
+     */
+    void writePacket(AVPacket* packet) final;
+
+    /**
+     * Register new functors to modify attributes
+     */
+    void registerAttributes();
+};
+
+} // namespace Splash
+
+#endif // SPLASH_SINK_NETWORK_H
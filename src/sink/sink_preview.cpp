@@ -0,0 +1,63 @@
+#include "./sink/sink_preview.h"
+
+#include "./core/scene.h"
+#include "./utils/log.h"
+
+using namespace std;
+
+namespace Splash
+{
+
+/*************/
+Sink_Preview::Sink_Preview(RootObject* root)
+    : Sink_Encoded(root)
+{
+    _type = "sink_preview";
+    _bitRate = 1000000;
+    _keyframeInterval = 30; // Clients joining a running preview wait for the next keyframe
+    _savable = false;
+    registerAttributes();
+
+    setAttribute("encodingSize", {320, 180});
+    setAttribute("framerate", {15});
+}
+
+/*************/
+Sink_Preview::~Sink_Preview()
+{
+    stopEncoding();
+}
+
+/*************/
+bool Sink_Preview::openOutput(const ImageBufferSpec& /*spec*/, size_t /*rawSize*/)
+{
+    return true;
+}
+
+/*************/
+void Sink_Preview::writePacket(AVPacket* packet)
+{
+    auto scene = dynamic_cast<Scene*>(_root);
+    if (!scene || _server.empty())
+        return;
+
+    // Packets are self-contained with the baseline profile, so that clients can start decoding from any keyframe
+    const bool keyframe = packet->flags & AV_PKT_FLAG_KEY;
+    scene->sendMessageToWorld("previewPacket",
+        {_server, getName(), keyframe, _context->width, _context->height, _codecName, Value::Buffer(packet->data, packet->data + packet->size)});
+}
+
+/*************/
+void Sink_Preview::registerAttributes()
+{
+    addAttribute("server",
+        [&](const Values& args) {
+            _server = args[0].as<string>();
+            return true;
+        },
+        [&]() -> Values { return {_server}; },
+        {'s'});
+    setAttributeDescription("server", "Name of the object receiving the encoded packets, in the World");
+}
+
+} // namespace Splash
@@ -0,0 +1,77 @@
+/*
+ * Copyright (C) 2026 Emmanuel Durand
+ *
+ * This file is part of Splash.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Splash is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Splash.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * @sink_preview.h
+ * The Sink_Preview class, sending a low resolution encoded preview of the connected object to the World
+ */
+
+#ifndef SPLASH_SINK_PREVIEW_H
+#define SPLASH_SINK_PREVIEW_H
+
+#include <string>
+
+#include "./sink/sink_encoded.h"
+
+namespace Splash
+{
+
+/*************/
+//! Sink encoding a small, low framerate preview of the connected object, for remote GUIs
+//! Encoded packets are sent as messages to the World, which hands them to the server object given by the server attribute.
+//! These sinks are created and deleted by the server as remote clients ask for previews, and are never saved.
+class Sink_Preview : public Sink_Encoded
+{
+  public:
+    /**
+     * Constructor
+     */
+    Sink_Preview(RootObject* root);
+
+    /**
+     * Destructor
+     */
+    ~Sink_Preview() final;
+
+  private:
+    std::string _server{}; //!< Name of the object receiving the packets, in the World
+
+    /**
+     * Nothing to open, packets are sent as messages
+     * \param spec Specifications of the encoded frames
+     * \param rawSize Size of the frames read back, in bytes
+     * \return Return true
+     */
+    bool openOutput(const ImageBufferSpec& spec, size_t rawSize) final;
+
+    /**
+     * Send an encoded packet to the server
+     * \param packet Encoded packet
+     */
+    void writePacket(AVPacket* packet) final;
+
+    /**
+     * Register new functors to modify attributes
+     */
+    void registerAttributes();
+};
+
+} // namespace Splash
+
+#endif // SPLASH_SINK_PREVIEW_H
@@ -0,0 +1,263 @@
+#include "./sink/sink_record.h"
+
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "./utils/log.h"
+
+// Size of the buffer used by the muxer, each filled buffer being queued for writing
+#define SPLASH_SINK_RECORD_IO_BUFFER_SIZE (1 << 20)
+
+using namespace std;
+
+namespace Splash
+{
+
+/*************/
+Sink_Record::Sink_Record(RootObject* root)
+    : Sink_Encoded(root)
+{
+    _type = "sink_record";
+    _codecName = "hap";
+    _options = "format=hap";
+    _pixelFormat = AV_PIX_FMT_RGBA;
+    registerAttributes();
+}
+
+/*************/
+Sink_Record::~Sink_Record()
+{
+    stopEncoding();
+}
+
+/*************/
+bool Sink_Record::openOutput(const ImageBufferSpec& /*spec*/, size_t /*rawSize*/)
+{
+    _fd = open(_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
+    if (_fd < 0)
+    {
+        Log::get() << Log::WARNING << "Sink_Record::" << __FUNCTION__ << " - Unable to open " << _path << ": " << strerror(errno) << Log::endl;
+        return false;
+    }
+
+    // Preallocating avoids the filesystem growing the file while recording
+    if (_preallocatedSize > 0 && posix_fallocate(_fd, 0, static_cast<off_t>(_preallocatedSize) * 1024 * 1024) != 0)
+        Log::get() << Log::WARNING << "Sink_Record::" << __FUNCTION__ << " - Unable to preallocate " << _preallocatedSize << "MB for " << _path << Log::endl;
+
+    _fileOffset = 0;
+    _fileEnd = 0;
+    _ioError = false;
+    _ioThreadRunning = true;
+    _ioThread = thread([&]() { ioLoop(); });
+
+    if (avformat_alloc_output_context2(&_formatContext, nullptr, "mov", _path.c_str()) < 0 || !_formatContext)
+    {
+        Log::get() << Log::WARNING << "Sink_Record::" << __FUNCTION__ << " - Unable to allocate the output context for " << _path << Log::endl;
+        closeOutput();
+        return false;
+    }
+
+    auto ioBuffer = static_cast<uint8_t*>(av_malloc(SPLASH_SINK_RECORD_IO_BUFFER_SIZE));
+    _formatContext->pb = avio_alloc_context(ioBuffer, SPLASH_SINK_RECORD_IO_BUFFER_SIZE, 1, this, nullptr, &Sink_Record::writeCallback, &Sink_Record::seekCallback);
+    if (!_formatContext->pb)
+    {
+        av_free(ioBuffer);
+        closeOutput();
+        return false;
+    }
+    _formatContext->pb->seekable = AVIO_SEEKABLE_NORMAL;
+
+    _stream = avformat_new_stream(_formatContext, nullptr);
+    if (!_stream || avcodec_parameters_from_context(_stream->codecpar, _context) < 0)
+    {
+        Log::get() << Log::WARNING << "Sink_Record::" << __FUNCTION__ << " - Unable to create the output stream" << Log::endl;
+        closeOutput();
+        return false;
+    }
+    _stream->time_base = _context->time_base;
+
+    if (avformat_write_header(_formatContext, nullptr) < 0)
+    {
+        Log::get() << Log::WARNING << "Sink_Record::" << __FUNCTION__ << " - Unable to write the file header to " << _path << Log::endl;
+        closeOutput();
+        return false;
+    }
+    _headerWritten = true;
+
+    return true;
+}
+
+/*************/
+void Sink_Record::closeOutput()
+{
+    if (_formatContext)
+    {
+        if (_headerWritten)
+            av_write_trailer(_formatContext);
+        _headerWritten = false;
+
+        if (_formatContext->pb)
+        {
+            avio_flush(_formatContext->pb);
+            av_freep(&_formatContext->pb->buffer);
+            avio_context_free(&_formatContext->pb);
+        }
+
+        avformat_free_context(_formatContext);
+        _formatContext = nullptr;
+        _stream = nullptr;
+    }
+
+    if (_ioThread.joinable())
+    {
+        {
+            lock_guard<mutex> lock(_ioMutex);
+            _ioThreadRunning = false;
+        }
+        _ioCondition.notify_all();
+        _ioThread.join();
+    }
+
+    if (_fd >= 0)
+    {
+        // Remove what was preallocated but not used
+        if (ftruncate(_fd, _fileEnd) != 0)
+            Log::get() << Log::WARNING << "Sink_Record::" << __FUNCTION__ << " - Unable to truncate " << _path << Log::endl;
+        close(_fd);
+        _fd = -1;
+    }
+}
+
+/*************/
+void Sink_Record::writePacket(AVPacket* packet)
+{
+    if (!_formatContext || !_stream)
+        return;
+
+    av_packet_rescale_ts(packet, _context->time_base, _stream->time_base);
+    packet->stream_index = _stream->index;
+
+    if (av_write_frame(_formatContext, packet) < 0)
+        Log::get() << Log::WARNING << "Sink_Record::" << __FUNCTION__ << " - Unable to write packet to " << _path << Log::endl;
+}
+
+/*************/
+void Sink_Record::ioLoop()
+{
+    unique_lock<mutex> lock(_ioMutex);
+    while (true)
+    {
+        _ioCondition.wait(lock, [&]() { return !_pendingChunks.empty() || !_ioThreadRunning; });
+        if (_pendingChunks.empty() && !_ioThreadRunning)
+            break;
+
+        auto chunk = std::move(_pendingChunks.front());
+        _pendingChunks.pop_front();
+        lock.unlock();
+
+        size_t written = 0;
+        while (written < chunk.data.size())
+        {
+            auto result = pwrite(_fd, chunk.data.data() + written, chunk.data.size() - written, chunk.offset + written);
+            if (result <= 0)
+                break;
+            written += result;
+        }
+
+        lock.lock();
+        if (written < chunk.data.size() && !_ioError)
+        {
+            _ioError = true;
+            Log::get() << Log::WARNING << "Sink_Record::" << __FUNCTION__ << " - Unable to write to " << _path << ": " << strerror(errno) << Log::endl;
+        }
+        _freeChunks.push_back(std::move(chunk));
+    }
+}
+
+/*************/
+int Sink_Record::writeCallback(void* opaque, uint8_t* buffer, int size)
+{
+    auto that = static_cast<Sink_Record*>(opaque);
+
+    Chunk chunk;
+    {
+        lock_guard<mutex> lock(that->_ioMutex);
+        if (that->_ioError)
+            return AVERROR(EIO);
+
+        if (!that->_freeChunks.empty())
+        {
+            chunk = std::move(that->_freeChunks.back());
+            that->_freeChunks.pop_back();
+        }
+    }
+
+    chunk.offset = that->_fileOffset;
+    chunk.data.assign(buffer, buffer + size);
+    that->_fileOffset += size;
+    that->_fileEnd = std::max(that->_fileEnd, that->_fileOffset);
+
+    {
+        lock_guard<mutex> lock(that->_ioMutex);
+        that->_pendingChunks.push_back(std::move(chunk));
+    }
+    that->_ioCondition.notify_one();
+
+    return size;
+}
+
+/*************/
+int64_t Sink_Record::seekCallback(void* opaque, int64_t offset, int whence)
+{
+    auto that = static_cast<Sink_Record*>(opaque);
+
+    switch (whence & ~AVSEEK_FORCE)
+    {
+    default:
+        return -1;
+    case AVSEEK_SIZE:
+        return that->_fileEnd;
+    case SEEK_SET:
+        that->_fileOffset = offset;
+        break;
+    case SEEK_CUR:
+        that->_fileOffset += offset;
+        break;
+    case SEEK_END:
+        that->_fileOffset = that->_fileEnd + offset;
+        break;
+    }
+
+    return that->_fileOffset;
+}
+
+/*************/
+void Sink_Record::registerAttributes()
+{
+    addAttribute("path",
+        [&](const Values& args) {
+            lock_guard<mutex> lock(_encodeMutex);
+            _path = args[0].as<string>();
+            _resetEncoding = true;
+            return true;
+        },
+        [&]() -> Values { return {_path}; },
+        {'s'});
+    setAttributeDescription("path",
+        "Path of the recorded MOV file. Changing it finalizes the current file and starts a new one.\n"
+        "With Hap, the width and height of the input must be multiples of 4.");
+
+    addAttribute("preallocate",
+        [&](const Values& args) {
+            lock_guard<mutex> lock(_encodeMutex);
+            _preallocatedSize = std::max(0, args[0].as<int>());
+            return true;
+        },
+        [&]() -> Values { return {_preallocatedSize}; },
+        {'i'});
+    setAttributeDescription("preallocate", "Size to preallocate for the recorded file, in MB. Applied to the next file");
+}
+
+} // namespace Splash
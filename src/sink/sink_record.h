@@ -0,0 +1,140 @@
+/*
+ * Copyright (C) 2026 Emmanuel Durand
+ *
+ * This file is part of Splash.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Splash is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Splash.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * @sink_record.h
+ * The Sink_Record class, recording the connected object to a movie file
+ */
+
+#ifndef SPLASH_SINK_RECORD_H
+#define SPLASH_SINK_RECORD_H
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "./sink/sink_encoded.h"
+
+namespace Splash
+{
+
+/*************/
+//! Sink recording the connected object to a MOV file, encoded with Hap by default for cheap playback with Image_FFmpeg
+//! The file is preallocated, and written by a dedicated I/O thread so that disk latency never stalls the encoder.
+//! It is finalized when the path changes or when the sink is deleted.
+class Sink_Record : public Sink_Encoded
+{
+  public:
+    /**
+     * Constructor
+     */
+    Sink_Record(RootObject* root);
+
+    /**
+     * Destructor
+     */
+    ~Sink_Record() final;
+
+  private:
+    //! Data waiting to be written to the file
+    struct Chunk
+    {
+        int64_t offset{0};
+        std::vector<uint8_t> data{};
+    };
+
+    std::string _path{"/tmp/splash_record.mov"};
+    int _preallocatedSize{1024}; //!< Size to preallocate for the file, in MB
+
+    AVFormatContext* _formatContext{nullptr};
+    AVStream* _stream{nullptr};
+    bool _headerWritten{false};
+
+    // File written asynchronously, the muxer only ever sees the I/O callbacks
+    int _fd{-1};
+    int64_t _fileOffset{0}; //!< Muxer position in the file
+    int64_t _fileEnd{0};    //!< Size of the data written by the muxer
+    bool _ioError{false};   //!< Set by the I/O thread if a write failed, used with _ioMutex
+    std::thread _ioThread{};
+    std::mutex _ioMutex{};
+    std::condition_variable _ioCondition{}; //!< Signaled when chunks are queued or written, and when stopping
+    bool _ioThreadRunning{false};
+    std::deque<Chunk> _pendingChunks{};
+    std::vector<Chunk> _freeChunks{}; //!< Already allocated chunks, reused to avoid allocations
+
+    /**
+     * Open the file and the MOV muxer, and write the header
+     * \param spec Specifications of the encoded frames
+     * \param rawSize Size of the frames read back, in bytes
+     * \return Return true if the recording started
+     */
+    bool openOutput(const ImageBufferSpec& spec, size_t rawSize) final;
+
+    /**
+     * Write the trailer, wait for all data to be written and close the file
+     */
+    void closeOutput() final;
+
+    /**
+     * Mux an encoded packet
+     * \param packet Encoded packet
+     */
+    void writePacket(AVPacket* packet) final;
+
+    /**
+     * MOV needs the codec headers in the container
+     * \return Return true
+     */
+    bool needsGlobalHeader() const final { return true; }
+
+    /**
+     * I/O thread loop, writing the queued chunks to the file
+     */
+    void ioLoop();
+
+    /**
+     * Muxer write callback, queues the data for the I/O thread
+     * \param opaque Pointer to the Sink_Record
+     * \param buffer Data to write
+     * \param size Data size
+     * \return Return the written size
+     */
+    static int writeCallback(void* opaque, uint8_t* buffer, int size);
+
+    /**
+     * Muxer seek callback
+     * \param opaque Pointer to the Sink_Record
+     * \param offset Offset
+     * \param whence Origin of the offset, or AVSEEK_SIZE
+     * \return Return the new position, or the file size for AVSEEK_SIZE
+     */
+    static int64_t seekCallback(void* opaque, int64_t offset, int whence);
+
+    /**
+     * Register new functors to modify attributes
+     */
+    void registerAttributes();
+};
+
+} // namespace Splash
+
+#endif // SPLASH_SINK_RECORD_H
@@ -50,7 +50,7 @@ class Sink_Shmdata : public Sink
     uint32_t _previousFramerate{0};
 
     /**
-     * Class to be implemented to copy the _mappedPixels somewhere
+     * Class to be implemented to copy the pixels somewhere
      */
     void handlePixels(const char* pixels, const ImageBufferSpec& spec) final;
 
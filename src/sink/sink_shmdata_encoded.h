@@ -25,25 +25,15 @@
 #ifndef SPLASH_SINK_SHMDATA_ENCODED_H
 #define SPLASH_SINK_SHMDATA_ENCODED_H
 
-#include <unordered_map>
-
 #include <shmdata/writer.hpp>
 
-extern "C" {
-#include <libavcodec/avcodec.h>
-#include <libavformat/avformat.h>
-#include <libavutil/imgutils.h>
-#include <libavutil/opt.h>
-#include <libswscale/swscale.h>
-}
-
+#include "./sink/sink_encoded.h"
 #include "./utils/osutils.h"
-#include "./sink/sink.h"
 
 namespace Splash
 {
 
-class Sink_Shmdata_Encoded : public Sink
+class Sink_Shmdata_Encoded : public Sink_Encoded
 {
   public:
     /**
@@ -61,42 +51,6 @@ class Sink_Shmdata_Encoded : public Sink
     std::string _caps{""};
     Utils::ShmdataLogger _logger;
     std::unique_ptr<shmdata::Writer> _writer{nullptr};
-    ImageBufferSpec _previousSpec{};
-    uint32_t _previousFramerate{0};
-    bool _resetEncoding{false};
-
-    // FFmpeg objects
-    AVCodec* _codec{nullptr};
-    AVCodecContext* _context{nullptr};
-    AVFrame *_frame{nullptr}, *_yuvFrame{nullptr};
-    SwsContext* _swsContext{nullptr};
-    AVPacket _packet;
-
-    // Codec parameters
-    int64_t _startTime{0ll};
-    std::string _codecName{"h264"};
-    int _bitRate{4000000};
-    double _framerate{30.0};
-    std::string _options{"profile=baseline"};
-
-    /**
-     * Find an encoder base on its name
-     * \param encoderName Codec name
-     * \return Return a codec
-     */
-    AVCodec* findEncoderByName(const std::string& codecName);
-
-    /**
-     * Init FFmpeg objects
-     * \param spec Input image specifications
-     * \return Return true if all went well
-     */
-    bool initFFmpegObjects(const ImageBufferSpec& spec);
-
-    /**
-     * Free everything related to FFmpeg
-     */
-    void freeFFmpegObjects();
 
     /**
      * Generate the caps from the spec, the context and the options
@@ -110,18 +64,18 @@ class Sink_Shmdata_Encoded : public Sink
     std::string generateCaps(const ImageBufferSpec& spec, uint32_t framerate, const std::string& optionString, const std::string& codecName, AVCodecContext* ctx);
 
     /**
-     * Class to be implemented to copy the _mappedPixels somewhere
-     * \param pixels Input image
-     * \param spec Input image specifications
+     * Reset the shmdata writer with caps matching the encoder
+     * \param spec Specifications of the encoded frames
+     * \param rawSize Size of the frames read back, in bytes
+     * \return Return true if the writer has been created
      */
-    void handlePixels(const char* pixels, const ImageBufferSpec& spec) final;
+    bool openOutput(const ImageBufferSpec& spec, size_t rawSize) final;
 
     /**
-     * Parse the options from the given string, formatted as:
-     * option1=value1, option2=value2, etc
-     * \param options Encoding options
+     * Send an encoded packet through shmdata
+     * \param packet Encoded packet
      */
-    std::unordered_map<std::string, std::string> parseOptions(const std::string& options);
+    void writePacket(AVPacket* packet) final;
 
     /**
      * Register new functors to modify attributes
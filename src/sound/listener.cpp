@@ -22,8 +22,9 @@ Listener::~Listener()
 }
 
 /*************/
-void Listener::setParameters(uint32_t channels, uint32_t sampleRate, Sound_Engine::SampleFormat format, const string& deviceName)
+void Listener::setParameters(uint32_t channels, uint32_t sampleRate, Sound_Engine::SampleFormat format, const string& deviceName, unsigned long framesPerBuffer)
 {
+    _framesPerBuffer = std::max(1ul, framesPerBuffer);
     _channels = std::max((uint32_t)1, channels);
     _sampleRate = sampleRate;
     _sampleFormat = format;
@@ -50,7 +51,7 @@ void Listener::initResources()
     if (!_engine.getDevice(true, _deviceName))
         return;
 
-    if (!_engine.setParameters(_sampleRate, _sampleFormat, _channels, 256))
+    if (!_engine.setParameters(_sampleRate, _sampleFormat, _channels, _framesPerBuffer))
         return;
 
     _engine.getParameters(_sampleRate, _sampleSize, _planar);
@@ -62,7 +63,7 @@ void Listener::initResources()
 
 /*************/
 int Listener::portAudioCallback(
-    const void* in, void* /*out*/, unsigned long framesPerBuffer, const PaStreamCallbackTimeInfo* /*timeInfo*/, PaStreamCallbackFlags /*statusFlags*/, void* userData)
+    const void* in, void* /*out*/, unsigned long framesPerBuffer, const PaStreamCallbackTimeInfo* timeInfo, PaStreamCallbackFlags /*statusFlags*/, void* userData)
 {
     auto that = (Listener*)userData;
     uint8_t* input = (uint8_t*)in;
@@ -70,31 +71,20 @@ int Listener::portAudioCallback(
     if (!input)
         return paContinue;
 
-    int readPosition = that->_ringReadPosition;
-    int writePosition = that->_ringWritePosition;
-
-    int delta = 0;
-    if (readPosition > writePosition)
-        delta = readPosition - writePosition;
-    else
-        delta = SPLASH_LISTENER_RINGBUFFER_SIZE - writePosition + readPosition;
-
-    int step = framesPerBuffer * that->_channels * that->_sampleSize;
-    if (delta < step)
-        return paContinue;
-
-    int spaceLeft = SPLASH_LISTENER_RINGBUFFER_SIZE - writePosition;
-
-    if (spaceLeft < step)
-        writePosition = 0;
+    size_t step = framesPerBuffer * that->_channels * that->_sampleSize;
+    if (that->_inputCallback)
+    {
+        // Some host APIs do not fill the timing information, in which case the input latency is ignored
+        int64_t inputLatency = timeInfo ? static_cast<int64_t>((timeInfo->currentTime - timeInfo->inputBufferAdcTime) * 1e6) : 0;
+        if (inputLatency < 0 || inputLatency > 1000000)
+            inputLatency = 0;
+        that->_inputCallback(input, step, Timer::getTime() - inputLatency);
+    }
     else
-        spaceLeft = 0;
-
-    std::copy(input, input + step, &that->_ringBuffer[writePosition]);
-    writePosition = (writePosition + step);
-
-    that->_ringUnusedSpace = spaceLeft;
-    that->_ringWritePosition = writePosition;
+    {
+        // If the ring buffer is full, the input is dropped
+        that->_ringBuffer.write(input, step);
+    }
 
     if (that->_abortCallback)
         return paComplete;
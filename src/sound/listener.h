@@ -27,10 +27,8 @@
 
 #define SPLASH_LISTENER_RINGBUFFER_SIZE (4 * 1024 * 1024) // use a 4MB ring buffer
 
-#include <array>
-#include <atomic>
+#include <functional>
 #include <memory>
-#include <mutex>
 #include <vector>
 
 #include <portaudio.h>
@@ -40,6 +38,7 @@
 #include "./core/attribute.h"
 #include "./core/graph_object.h"
 #include "./sound/sound_engine.h"
+#include "./utils/spsc_ring.h"
 
 namespace Splash
 {
@@ -47,6 +46,10 @@ namespace Splash
 /*************/
 class Listener : public GraphObject
 {
+  public:
+    //! Callback receiving the input directly from the audio thread, with the buffer, its size in bytes and the local time when its first sample was captured, in us
+    using InputCallback = std::function<void(const uint8_t*, size_t, int64_t)>;
+
   public:
     /**
      * \brief Constructor
@@ -70,7 +73,9 @@ class Listener : public GraphObject
     Listener& operator=(const Listener&) = delete;
 
     /**
-     * \brief Add a buffer to the playing queue
+     * \brief Read a buffer from the recording queue
+     * This must always be called from the same thread, as the queue is a single consumer ring buffer.
+     * \param buffer Buffer to fill, its size gives the amount of samples to read
      * \return Return false if there was an error
      */
     template <typename T>
@@ -78,11 +83,28 @@ class Listener : public GraphObject
 
     /**
      * \brief Set the audio parameters
+     * \param channels Channel count
+     * \param sampleRate Sample rate, 0 for the device default
+     * \param format Sample format
+     * \param deviceName Input device name, the default one if empty
+     * \param framesPerBuffer Frames per callback, lower values decrease the latency
+     */
+    void setParameters(uint32_t channels, uint32_t sampleRate, Sound_Engine::SampleFormat format, const std::string& deviceName = "", unsigned long framesPerBuffer = 256);
+
+    /**
+     * \brief Get the effective sample rate
+     * \return Return the sample rate
+     */
+    unsigned int getSampleRate() const { return _sampleRate; }
+
+    /**
+     * \brief Set a callback to receive the input from the audio thread instead of queuing it
+     * This must be set before calling setParameters, and the callback must neither block nor allocate.
+     * \param callback Input callback
      */
-    void setParameters(uint32_t channels, uint32_t sampleRate, Sound_Engine::SampleFormat format, const std::string& deviceName = "");
+    void setInputCallback(const InputCallback& callback) { _inputCallback = callback; }
 
   private:
-    Sound_Engine _engine;
     bool _ready{false};
     unsigned int _channels{2};
     unsigned int _sampleRate{0};
@@ -91,11 +113,13 @@ class Listener : public GraphObject
     std::string _deviceName{""};
     size_t _sampleSize{2};
     bool _abortCallback{false};
+    unsigned long _framesPerBuffer{256};
 
-    std::array<uint8_t, SPLASH_LISTENER_RINGBUFFER_SIZE> _ringBuffer;
-    std::atomic_int _ringWritePosition{0};
-    std::atomic_int _ringReadPosition{0};
-    std::atomic_int _ringUnusedSpace{0};
+    SpscByteRing _ringBuffer{SPLASH_LISTENER_RINGBUFFER_SIZE};
+    InputCallback _inputCallback{};
+
+    // Declared last so that the stream is stopped before the members it uses are destroyed
+    Sound_Engine _engine;
 
     /**
      * \brief Free all PortAudio resources
@@ -126,44 +150,7 @@ bool Listener::readFromQueue(std::vector<T>& buffer)
     if (buffer.size() == 0)
         return false;
 
-    int readPosition = _ringReadPosition;
-    int writePosition = _ringWritePosition;
-    int unusedSpace = _ringUnusedSpace;
-
-    // If the ring buffer is not filled enough, fill with zeros instead
-    int delta = 0;
-    if (writePosition >= readPosition)
-        delta = writePosition - readPosition;
-    else
-        delta = SPLASH_LISTENER_RINGBUFFER_SIZE - unusedSpace - readPosition + writePosition;
-
-    int step = buffer.size() * sizeof(T);
-    if (delta < step)
-    {
-        return false;
-    }
-    // Else, we copy the values and move the read position
-    else
-    {
-        int effectiveSpace = SPLASH_LISTENER_RINGBUFFER_SIZE - unusedSpace;
-        int ringBufferEndLength = effectiveSpace - readPosition;
-
-        if (step <= ringBufferEndLength)
-        {
-            std::copy(&_ringBuffer[readPosition], &_ringBuffer[readPosition] + step, buffer.data());
-            readPosition = readPosition + step;
-        }
-        else
-        {
-            std::copy(&_ringBuffer[readPosition], &_ringBuffer[effectiveSpace], buffer.data());
-            std::copy(&_ringBuffer[0], &_ringBuffer[step - ringBufferEndLength], reinterpret_cast<char*>(buffer.data()) + ringBufferEndLength);
-            readPosition = step - ringBufferEndLength;
-        }
-
-        _ringReadPosition = readPosition;
-    }
-
-    return true;
+    return _ringBuffer.read(reinterpret_cast<uint8_t*>(buffer.data()), buffer.size() * sizeof(T));
 }
 
 } // namespace Splash
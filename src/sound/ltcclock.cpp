@@ -1,11 +1,20 @@
 #include "./sound/ltcclock.h"
 
 #include <chrono>
-#include <iostream>
+#include <cstdlib>
 
 #include "./utils/log.h"
 #include "./utils/timer.h"
 
+// Frames per audio callback, kept small as the decoding latency depends on it
+#define SPLASH_LTC_FRAMES_PER_BUFFER 64
+// Consecutive silent samples after which the clock is considered paused, about a frame at 48kHz
+#define SPLASH_LTC_PAUSE_SAMPLES 2048
+// Offset error above which the offset is stepped instead of filtered, in us
+#define SPLASH_LTC_STEP_THRESHOLD 100000
+// Part of the offset error corrected for each LTC frame, as a divider
+#define SPLASH_LTC_FILTER_RATIO 16
+
 using namespace std;
 
 namespace Splash
@@ -17,117 +26,135 @@ LtcClock::LtcClock(bool masterClock, const string& deviceName)
 {
     registerAttributes();
 
+    _masterClock = masterClock;
+    _ltcDecoder = ltc_decoder_create(1920, 32);
+
+    // Decoding happens in the audio callback, so that the frames can be dated from the sample they start at
     _listener = unique_ptr<Listener>(new Listener());
-    _listener->setParameters(1, 0, Sound_Engine::SAMPLE_FMT_U8, deviceName);
-    if (!_listener)
+    _listener->setInputCallback([this](const uint8_t* data, size_t size, int64_t captureTime) { processInput(data, size, captureTime); });
+    _listener->setParameters(1, 0, Sound_Engine::SAMPLE_FMT_U8, deviceName, SPLASH_LTC_FRAMES_PER_BUFFER);
+    if (!*_listener)
     {
         _listener.reset();
         return;
     }
-
-    _masterClock = masterClock;
-    _continue = true;
+    _sampleRate = _listener->getSampleRate();
 
     Log::get() << Log::MESSAGE << "LtcClock::" << __FUNCTION__ << " - Input clock enabled" << Log::endl;
+}
 
-    _ltcThread = thread([&]() {
-        LTCDecoder* ltcDecoder = ltc_decoder_create(1920, 32);
-        LTCFrameExt ltcFrame;
+/*************/
+LtcClock::~LtcClock()
+{
+    // Stop the input stream before freeing the decoder it uses
+    _listener.reset();
+    ltc_decoder_free(_ltcDecoder);
 
-        vector<uint8_t> inputBuffer(256);
-        long int total = 0;
+    Log::get() << Log::MESSAGE << "LtcClock::" << __FUNCTION__ << " - Input clock disabled" << Log::endl;
+}
 
-        while (_continue)
+/*************/
+Timer::Point LtcClock::getClock()
+{
+    return _clock;
+}
+
+/*************/
+void LtcClock::processInput(const uint8_t* data, size_t size, int64_t captureTime)
+{
+    // Check all values to check whether the clock is paused or not
+    bool silent = true;
+    for (size_t i = 0; i < size; ++i)
+    {
+        if (data[i] < 126 || data[i] > 129) // This is for noise handling. There is not enough room for a clock in between.
         {
-            if (!_listener->readFromQueue(inputBuffer))
-            {
-                this_thread::sleep_for(chrono::milliseconds(5));
-                continue;
-            }
+            silent = false;
+            break;
+        }
+    }
 
-            // Check all values to check whether the clock is paused or not
-            bool paused = true;
-            for (auto& v : inputBuffer)
-            {
-                if (v < 126 || v > 129) // This is for noise handling. There is not enough room for a clock in between.
-                {
-                    paused = false;
-                    break;
-                }
-            }
+    // Blocks are small, the clock is only paused after enough of them have been silent
+    _silentSamples = silent ? _silentSamples + size : 0;
+    bool paused = _silentSamples >= SPLASH_LTC_PAUSE_SAMPLES;
+
+    // Always set the pause status, even when no frame has been received
+    _clock.paused = paused;
+    Timer::get().setMasterClockPaused(paused);
 
-            // Always set the pause status, even when no frame has been received
-            _clock.paused = paused;
-            Timer::get().setMasterClockPaused(paused);
+    auto blockStart = _sampleCount;
+    ltc_decoder_write(_ltcDecoder, const_cast<ltcsnd_sample_t*>(data), size, blockStart);
+    _sampleCount += size;
 
-            ltc_decoder_write(ltcDecoder, (ltcsnd_sample_t*)inputBuffer.data(), inputBuffer.size(), total);
-            total += inputBuffer.size();
+    const auto sampleRate = static_cast<int64_t>(_sampleRate.load());
 
-            // Try reading a new LTC frame
-            while (ltc_decoder_read(ltcDecoder, &ltcFrame))
+    // Try reading a new LTC frame
+    LTCFrameExt ltcFrame;
+    while (ltc_decoder_read(_ltcDecoder, &ltcFrame))
+    {
+        _ready = true;
+
+        SMPTETimecode stime;
+        ltc_frame_to_time(&stime, &ltcFrame.ltc, LTC_TC_CLOCK);
+
+        Timer::Point clock;
+        clock.paused = paused;
+        clock.years = stime.years;
+        clock.months = stime.months;
+        clock.days = stime.days;
+        clock.hours = stime.hours;
+        clock.mins = stime.mins;
+        clock.secs = stime.secs;
+
+        // This updates the maximum frames per second, to be able to handle any framerate
+        if (stime.frame == 0)
+        {
+            // Only accept some specific values
+            if (_previousFrame == 24 || _previousFrame == 25 || _previousFrame == 30 || _previousFrame == 60)
             {
-                _ready = true;
-
-                SMPTETimecode stime;
-                ltc_frame_to_time(&stime, &ltcFrame.ltc, LTC_TC_CLOCK);
-
-                Timer::Point clock;
-                clock.paused = paused;
-                clock.years = stime.years;
-                clock.months = stime.months;
-                clock.days = stime.days;
-                clock.hours = stime.hours;
-                clock.mins = stime.mins;
-                clock.secs = stime.secs;
-
-                // This updates the maximum frames per second, to be able to handle any framerate
-                if (stime.frame == 0)
+                // Small trick to handle errors
+                if (_framerateChanged)
                 {
-                    // Only accept some specific values
-                    if (_previousFrame == 24 || _previousFrame == 25 || _previousFrame == 30 || _previousFrame == 60)
-                    {
-                        // Small trick to handle errors
-                        if (_framerateChanged)
-                        {
-                            _maximumFramePerSec = _previousFrame + 1;
-                            _framerateChanged = false;
-                        }
-                        else
-                        {
-                            _framerateChanged = true;
-                        }
-                    }
+                    _maximumFramePerSec = _previousFrame + 1;
+                    _framerateChanged = false;
+                }
+                else
+                {
+                    _framerateChanged = true;
                 }
-
-                _previousFrame = stime.frame;
-                clock.frame = stime.frame * 120 / _maximumFramePerSec;
-
-                _clock = clock;
-
-                if (_masterClock)
-                    Timer::get().setMasterClock(_clock);
             }
-
         }
 
-        ltc_decoder_free(ltcDecoder);
-    });
-}
+        _previousFrame = stime.frame;
+        clock.frame = stime.frame * 120 / _maximumFramePerSec;
 
-/*************/
-LtcClock::~LtcClock()
-{
-    _continue = false;
-    if (_ltcThread.joinable())
-        _ltcThread.join();
+        _clock = clock;
 
-    Log::get() << Log::MESSAGE << "LtcClock::" << __FUNCTION__ << " - Input clock disabled" << Log::endl;
-}
+        // The timecode is the time at the start of the frame, dated from its first sample
+        int64_t frames = clock.frame + (clock.secs + (clock.mins + (clock.hours + clock.days * 24ll) * 60ll) * 60ll) * 120ll;
+        int64_t timecode = frames * 1000000 / 120;
+        int64_t frameStartTime = captureTime;
+        if (sampleRate > 0)
+            frameStartTime += (static_cast<int64_t>(ltcFrame.off_start) - static_cast<int64_t>(blockStart)) * 1000000 / sampleRate;
 
-/*************/
-Timer::Point LtcClock::getClock()
-{
-    return _clock;
+        // Filter the offset to the local clock, to remove the jitter from the decoding
+        auto rawOffset = timecode - frameStartTime;
+        auto error = rawOffset - _offset;
+        if (!_offsetSet || std::abs(error) > SPLASH_LTC_STEP_THRESHOLD)
+        {
+            _offset = rawOffset;
+            _jitter = 0;
+            _offsetSet = true;
+        }
+        else
+        {
+            _offset += error / SPLASH_LTC_FILTER_RATIO;
+            _jitter += (std::abs(error) - _jitter) / SPLASH_LTC_FILTER_RATIO;
+        }
+
+        // The master clock interpolates from the update time until the next frame
+        if (_masterClock)
+            Timer::get().setMasterClock(_clock, timecode - _offset);
+    }
 }
 
 } // namespace Splash
@@ -25,10 +25,8 @@
 #ifndef SPLASH_LTCCLOCK_H
 #define SPLASH_LTCCLOCK_H
 
+#include <atomic>
 #include <memory>
-#include <mutex>
-#include <thread>
-#include <vector>
 
 #include <ltc.h>
 #include <portaudio.h>
@@ -68,19 +66,45 @@ class LtcClock : public GraphObject
      */
     Timer::Point getClock();
 
+    /**
+     * \brief Get the filtered offset between the LTC time and the local clock
+     * \return Return the offset in us
+     */
+    int64_t getOffset() const { return _offset; }
+
+    /**
+     * \brief Get the average deviation of the LTC frames from the filtered offset
+     * \return Return the jitter in us
+     */
+    int64_t getJitter() const { return _jitter; }
+
   private:
-    bool _ready{false};
+    std::atomic_bool _ready{false};
     bool _masterClock{false};
-    bool _continue{false};
-    std::thread _ltcThread;
 
     bool _framerateChanged{false};
     uint8_t _previousFrame{0};
     uint8_t _maximumFramePerSec{30};
 
+    LTCDecoder* _ltcDecoder{nullptr};
+    std::atomic_uint _sampleRate{0}; //!< Input sample rate, read from the audio thread
+    ltc_off_t _sampleCount{0};       //!< Samples written to the decoder so far
+    size_t _silentSamples{0};        //!< Consecutive samples without any signal
+    bool _offsetSet{false};          //!< True once the offset has been measured
+    std::atomic_int64_t _offset{0};  //!< Filtered offset between the LTC time and the local clock, in us
+    std::atomic_int64_t _jitter{0};  //!< Average deviation from the filtered offset, in us
+
     Timer::Point _clock;
     std::unique_ptr<Listener> _listener;
 
+    /**
+     * \brief Decode the input, called from the audio thread
+     * \param data Input samples
+     * \param size Sample count
+     * \param captureTime Local time when the first sample was captured, in us
+     */
+    void processInput(const uint8_t* data, size_t size, int64_t captureTime);
+
     /**
      * \brief Register new functors to modify attributes
      */
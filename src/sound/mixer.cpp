@@ -0,0 +1,263 @@
+#include "./sound/mixer.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "./utils/log.h"
+#include "./utils/timer.h"
+
+// Size of the ring buffer of each input, in bytes
+#define SPLASH_MIXER_INPUT_RINGBUFFER_SIZE (4 * 1024 * 1024)
+
+using namespace std;
+
+namespace Splash
+{
+
+mutex Mixer::_registryMutex{};
+unordered_map<string, weak_ptr<Mixer>> Mixer::_registry{};
+
+/*************/
+shared_ptr<Mixer> Mixer::get(const string& deviceName)
+{
+    lock_guard<mutex> lock(_registryMutex);
+    for (auto registryIt = _registry.begin(); registryIt != _registry.end();)
+    {
+        if (registryIt->second.expired())
+            registryIt = _registry.erase(registryIt);
+        else
+            ++registryIt;
+    }
+
+    if (auto registryIt = _registry.find(deviceName); registryIt != _registry.end())
+        return registryIt->second.lock();
+
+    auto mixer = shared_ptr<Mixer>(new Mixer(deviceName));
+    if (!mixer->_ready)
+        return {nullptr};
+
+    _registry[deviceName] = mixer;
+    return mixer;
+}
+
+/*************/
+Mixer::Mixer(const string& deviceName)
+{
+    if (!_engine.getDevice(false, deviceName))
+        return;
+
+    // All the channels of the device are opened, so that any input can be routed to any of them
+    _channels = std::min(std::max(0, _engine.getDeviceChannelCount()), SPLASH_MIXER_MAX_CHANNELS);
+    if (_channels == 0)
+        return;
+
+    if (!_engine.setParameters(0.0, Sound_Engine::SAMPLE_FMT_FLT, _channels, SPLASH_MIXER_FRAMES_PER_BUFFER))
+        return;
+
+    size_t sampleSize = 0;
+    bool planar = false;
+    _engine.getParameters(_sampleRate, sampleSize, planar);
+
+    if (!_engine.startStream(Mixer::portAudioCallback, this))
+        return;
+
+    Log::get() << Log::MESSAGE << "Mixer::" << __FUNCTION__ << " - Mixing to " << _channels << " channels at " << _sampleRate << "Hz" << Log::endl;
+    _ready = true;
+}
+
+/*************/
+Mixer::~Mixer() {}
+
+/*************/
+int Mixer::addInput(uint32_t channels, uint32_t sampleRate, uint32_t firstChannel)
+{
+    if (!_ready || channels == 0 || sampleRate == 0 || firstChannel >= _channels)
+        return -1;
+
+    lock_guard<mutex> lock(_inputsMutex);
+    for (size_t index = 0; index < _inputs.size(); ++index)
+    {
+        auto& input = _inputs[index];
+        if (input.state.load(memory_order_acquire) != InputState::free)
+            continue;
+
+        // Free inputs are not touched by the audio callback, so they can be set up without synchronization
+        input.ring = make_unique<SpscByteRing>(SPLASH_MIXER_INPUT_RINGBUFFER_SIZE);
+        input.channels = channels;
+        input.sampleRate = sampleRate;
+        input.firstChannel = firstChannel;
+        input.ratio = static_cast<double>(sampleRate) / static_cast<double>(_sampleRate);
+        input.phase = 0.0;
+        auto maxInputFrames = static_cast<size_t>(SPLASH_MIXER_FRAMES_PER_BUFFER * input.ratio) + 3;
+        input.frames.assign(maxInputFrames * channels, 0.f);
+        input.resampled.assign(SPLASH_MIXER_FRAMES_PER_BUFFER * channels, 0.f);
+
+        input.state.store(InputState::active, memory_order_release);
+        return static_cast<int>(index);
+    }
+
+    Log::get() << Log::WARNING << "Mixer::" << __FUNCTION__ << " - No input left, maximum is " << SPLASH_MIXER_MAX_INPUTS << Log::endl;
+    return -1;
+}
+
+/*************/
+void Mixer::removeInput(int input)
+{
+    if (input < 0 || input >= static_cast<int>(_inputs.size()))
+        return;
+
+    lock_guard<mutex> lock(_inputsMutex);
+    auto& slot = _inputs[input];
+    if (slot.state.load(memory_order_acquire) != InputState::active)
+        return;
+
+    // The input is handed to the audio callback, which frees it on its next run once it does not read it anymore.
+    // If the stream stopped, the input stays reserved, as there is no telling whether the callback still reads it.
+    slot.state.store(InputState::releasing, memory_order_release);
+}
+
+/*************/
+bool Mixer::write(int input, const float* samples, size_t frameCount)
+{
+    if (input < 0 || input >= static_cast<int>(_inputs.size()))
+        return false;
+
+    auto& slot = _inputs[input];
+    if (slot.state.load(memory_order_acquire) != InputState::active)
+        return false;
+
+    return slot.ring->write(reinterpret_cast<const uint8_t*>(samples), frameCount * slot.channels * sizeof(float));
+}
+
+/*************/
+void Mixer::clear(int input)
+{
+    if (input < 0 || input >= static_cast<int>(_inputs.size()))
+        return;
+
+    auto& slot = _inputs[input];
+    if (slot.state.load(memory_order_acquire) == InputState::active)
+        slot.ring->clear();
+}
+
+/*************/
+int64_t Mixer::getQueueDuration(int input) const
+{
+    if (input < 0 || input >= static_cast<int>(_inputs.size()))
+        return 0;
+
+    const auto& slot = _inputs[input];
+    if (slot.state.load(memory_order_acquire) != InputState::active)
+        return 0;
+
+    auto byteRate = static_cast<int64_t>(slot.sampleRate * slot.channels * sizeof(float));
+    auto queued = static_cast<int64_t>(slot.ring->readAvailable()) * 1000000 / byteRate;
+    auto inDevice = std::max<int64_t>(0, _callbackQueueDuration - (Timer::getTime() - _callbackTime));
+    return queued + inDevice;
+}
+
+/*************/
+void Mixer::mixInput(Input& input, float* output, size_t frameCount)
+{
+    const auto channels = input.channels;
+    const auto frameSize = channels * sizeof(float);
+    auto resampled = input.resampled.data();
+    size_t mixedFrames = 0;
+
+    if (input.sampleRate == _sampleRate)
+    {
+        // Same rate, whatever is available is mixed right away
+        mixedFrames = std::min<size_t>(frameCount, input.ring->readAvailable() / frameSize);
+        if (mixedFrames == 0 || !input.ring->read(reinterpret_cast<uint8_t*>(resampled), mixedFrames * frameSize))
+            return;
+    }
+    else
+    {
+        // Linear interpolation, the two input frames around the next output frame being kept between blocks
+        auto frames = input.frames.data();
+        auto newFrames = static_cast<size_t>(input.phase + static_cast<double>(frameCount) * input.ratio);
+        if (input.ring->readAvailable() < newFrames * frameSize || !input.ring->read(reinterpret_cast<uint8_t*>(frames + 2 * channels), newFrames * frameSize))
+            return;
+
+        for (size_t frame = 0; frame < frameCount; ++frame)
+        {
+            auto position = input.phase + static_cast<double>(frame) * input.ratio;
+            auto index = static_cast<size_t>(position);
+            auto weight = static_cast<float>(position - static_cast<double>(index));
+            const float* __restrict previous = frames + index * channels;
+            const float* __restrict next = previous + channels;
+            float* __restrict destination = resampled + frame * channels;
+            for (uint32_t channel = 0; channel < channels; ++channel)
+                destination[channel] = previous[channel] + (next[channel] - previous[channel]) * weight;
+        }
+
+        memmove(frames, frames + newFrames * channels, 2 * frameSize);
+        input.phase = input.phase + static_cast<double>(frameCount) * input.ratio - static_cast<double>(newFrames);
+        mixedFrames = frameCount;
+    }
+
+    // Route the input channels to the output ones, dropping those beyond the last output channel
+    const auto routedChannels = std::min(channels, _channels - input.firstChannel);
+    if (input.firstChannel == 0 && channels == _channels)
+    {
+        // Contiguous case, vectorized by the compiler
+        const float* __restrict source = resampled;
+        float* __restrict destination = output;
+        for (size_t sample = 0; sample < mixedFrames * channels; ++sample)
+            destination[sample] += source[sample];
+    }
+    else
+    {
+        for (size_t frame = 0; frame < mixedFrames; ++frame)
+        {
+            const float* __restrict source = resampled + frame * channels;
+            float* __restrict destination = output + frame * _channels + input.firstChannel;
+            for (uint32_t channel = 0; channel < routedChannels; ++channel)
+                destination[channel] += source[channel];
+        }
+    }
+}
+
+/*************/
+int Mixer::portAudioCallback(
+    const void* /*in*/, void* out, unsigned long framesPerBuffer, const PaStreamCallbackTimeInfo* timeInfo, PaStreamCallbackFlags /*statusFlags*/, void* userData)
+{
+    auto that = static_cast<Mixer*>(userData);
+    auto output = static_cast<float*>(out);
+
+    if (!output)
+        return paContinue;
+
+    memset(output, 0, framesPerBuffer * that->_channels * sizeof(float));
+
+    bool hasSound = false;
+    for (auto& input : that->_inputs)
+    {
+        auto state = input.state.load(memory_order_acquire);
+        if (state == InputState::releasing)
+        {
+            input.state.store(InputState::free, memory_order_release);
+            continue;
+        }
+        if (state != InputState::active)
+            continue;
+
+        // The buffers are sized for the requested block size, which some hosts may not respect
+        for (unsigned long offset = 0; offset < framesPerBuffer; offset += SPLASH_MIXER_FRAMES_PER_BUFFER)
+        {
+            auto frameCount = std::min<unsigned long>(SPLASH_MIXER_FRAMES_PER_BUFFER, framesPerBuffer - offset);
+            that->mixInput(input, output + offset * that->_channels, frameCount);
+        }
+        hasSound = true;
+    }
+
+    // Keep track of when the sound handed to the device will be heard
+    int64_t latency = timeInfo ? std::max<int64_t>(0, (timeInfo->outputBufferDacTime - timeInfo->currentTime) * 1e6) : 0;
+    int64_t blockDuration = hasSound ? static_cast<int64_t>(framesPerBuffer) * 1000000 / std::max(1u, that->_sampleRate) : 0;
+    that->_callbackQueueDuration = latency + blockDuration;
+    that->_callbackTime = Timer::getTime();
+
+    return paContinue;
+}
+
+} // namespace Splash
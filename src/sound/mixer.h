@@ -0,0 +1,180 @@
+/*
+ * Copyright (C) 2015 Emmanuel Durand
+ *
+ * This file is part of Splash.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Splash is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Splash.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * @mixer.h
+ * The Mixer class, feeding a single multichannel output stream from many inputs
+ */
+
+#ifndef SPLASH_MIXER_H
+#define SPLASH_MIXER_H
+
+#define SPLASH_MIXER_MAX_INPUTS 32
+#define SPLASH_MIXER_MAX_CHANNELS 64
+#define SPLASH_MIXER_FRAMES_PER_BUFFER 256
+
+#include <array>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "./core/constants.h"
+
+#include "./sound/sound_engine.h"
+#include "./utils/spsc_ring.h"
+
+namespace Splash
+{
+
+/*************/
+//! Output stream shared by all the inputs sent to the same device
+//! Each input is queued in its own wait-free ring, then resampled to the device rate and
+//! added to the output channels it is routed to, from the audio callback. All the buffers
+//! are allocated when an input is added, so the callback never allocates nor locks.
+class Mixer
+{
+  public:
+    /**
+     * Get the mixer for the given device, creating it if needed
+     * \param deviceName Output device name, the default one if empty
+     * \return Return the mixer, or nullptr if the device could not be opened
+     */
+    static std::shared_ptr<Mixer> get(const std::string& deviceName = "");
+
+    /**
+     * Destructor
+     */
+    ~Mixer();
+
+    Mixer(const Mixer&) = delete;
+    Mixer& operator=(const Mixer&) = delete;
+
+    /**
+     * Add an input
+     * \param channels Input channel count
+     * \param sampleRate Input sample rate
+     * \param firstChannel Output channel the first input channel is routed to, the next ones following
+     * \return Return the input index, or -1 if no input is available
+     */
+    int addInput(uint32_t channels, uint32_t sampleRate, uint32_t firstChannel);
+
+    /**
+     * Remove an input, which is freed by the audio callback on its next run
+     * \param input Input index
+     */
+    void removeInput(int input);
+
+    /**
+     * Queue samples for an input. Must always be called from the same thread for a given input.
+     * \param input Input index
+     * \param samples Interleaved samples
+     * \param frameCount Frame count
+     * \return Return false if there is not enough room left, in which case nothing is queued
+     */
+    bool write(int input, const float* samples, size_t frameCount);
+
+    /**
+     * Drop the samples queued for an input, from any thread
+     * \param input Input index
+     */
+    void clear(int input);
+
+    /**
+     * Get the time left until the last sample queued for an input is heard, including the output latency
+     * \param input Input index
+     * \return Return the duration in us, or 0 if nothing is queued
+     */
+    int64_t getQueueDuration(int input) const;
+
+    /**
+     * Get the output channel count
+     * \return Return the channel count
+     */
+    uint32_t getChannels() const { return _channels; }
+
+    /**
+     * Get the output sample rate
+     * \return Return the sample rate
+     */
+    uint32_t getSampleRate() const { return _sampleRate; }
+
+  private:
+    enum class InputState
+    {
+        free,
+        active,
+        releasing
+    };
+
+    struct Input
+    {
+        std::atomic<InputState> state{InputState::free};
+        std::unique_ptr<SpscByteRing> ring{nullptr};
+        uint32_t channels{0};
+        uint32_t sampleRate{0};
+        uint32_t firstChannel{0};
+        double ratio{1.0};              //!< Input frames per output frame
+        double phase{0.0};              //!< Position of the next output frame between the two last input frames
+        std::vector<float> frames{};    //!< Two last input frames followed by the frames read for the current block
+        std::vector<float> resampled{}; //!< Input resampled at the output rate
+    };
+
+    static std::mutex _registryMutex;
+    static std::unordered_map<std::string, std::weak_ptr<Mixer>> _registry;
+
+    bool _ready{false};
+    uint32_t _channels{0};
+    unsigned int _sampleRate{0};
+
+    std::mutex _inputsMutex{};
+    std::array<Input, SPLASH_MIXER_MAX_INPUTS> _inputs{};
+
+    std::atomic_int64_t _callbackTime{0};          //!< Time of the last callback, in us
+    std::atomic_int64_t _callbackQueueDuration{0}; //!< Duration of the sound handed to the device at the last callback, latency included
+
+    // Declared last so that the stream is stopped before the members it uses are destroyed
+    Sound_Engine _engine;
+
+    /**
+     * Constructor
+     * \param deviceName Output device name
+     */
+    explicit Mixer(const std::string& deviceName);
+
+    /**
+     * Mix an input into the output buffer
+     * \param input Input to mix
+     * \param output Interleaved output buffer
+     * \param frameCount Output frame count
+     */
+    void mixInput(Input& input, float* output, size_t frameCount);
+
+    /**
+     * PortAudio callback
+     */
+    static int portAudioCallback(
+        const void* in, void* out, unsigned long framesPerBuffer, const PaStreamCallbackTimeInfo* timeInfo, PaStreamCallbackFlags statusFlags, void* userData);
+};
+
+} // namespace Splash
+
+#endif // SPLASH_MIXER_H
@@ -90,6 +90,40 @@ bool Sound_Engine::getDevice(bool inputDevice, const string& name)
     return true;
 }
 
+/*************/
+int Sound_Engine::getDeviceChannelCount() const
+{
+    if (!_connected)
+        return 0;
+
+    auto deviceInfo = Pa_GetDeviceInfo(_streamParameters.device);
+    if (!deviceInfo)
+        return 0;
+    return _inputDevice ? deviceInfo->maxInputChannels : deviceInfo->maxOutputChannels;
+}
+
+/*************/
+size_t Sound_Engine::getSampleSize(SampleFormat format)
+{
+    switch (format)
+    {
+    default:
+        return 0;
+    case SAMPLE_FMT_U8:
+    case SAMPLE_FMT_U8P:
+        return sizeof(unsigned char);
+    case SAMPLE_FMT_S16:
+    case SAMPLE_FMT_S16P:
+        return sizeof(short);
+    case SAMPLE_FMT_S32:
+    case SAMPLE_FMT_S32P:
+        return sizeof(int);
+    case SAMPLE_FMT_FLT:
+    case SAMPLE_FMT_FLTP:
+        return sizeof(float);
+    }
+}
+
 /*************/
 bool Sound_Engine::setParameters(double sampleRate, SampleFormat sampleFormat, int channelCount, unsigned long framesPerBuffer)
 {
@@ -68,6 +68,26 @@ class Sound_Engine
      */
     bool getDevice(bool inputDevice = false, const std::string& name = "");
 
+    /**
+     * Get the maximum channel count of the selected device
+     * \return Return the channel count, 0 if no device is selected
+     */
+    int getDeviceChannelCount() const;
+
+    /**
+     * Get the size of a sample for the given format
+     * \param format Sample format
+     * \return Return the sample size in bytes, 0 if the format is unknown
+     */
+    static size_t getSampleSize(SampleFormat format);
+
+    /**
+     * Get whether the given format is planar
+     * \param format Sample format
+     * \return Return true if planar
+     */
+    static bool isPlanar(SampleFormat format) { return format >= SAMPLE_FMT_U8P; }
+
     /**
      * Get the stream parameters
      * \param sampleRate Sample rate
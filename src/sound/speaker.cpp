@@ -1,5 +1,7 @@
 #include "./sound/speaker.h"
 
+#include <cstring>
+
 #include "./utils/log.h"
 #include "./utils/timer.h"
 
@@ -24,19 +26,35 @@ Speaker::~Speaker()
 /*************/
 void Speaker::clearQueue()
 {
-    std::lock_guard<std::mutex> lock(_ringWriteMutex);
-    _ringReadPosition = 0;
-    _ringWritePosition = 0;
-    _ringUnusedSpace = 0;
+    if (_mixer)
+        _mixer->clear(_mixerInput);
+    else
+        _ringBuffer.clear();
+}
+
+/*************/
+int64_t Speaker::getQueueDuration() const
+{
+    if (!_ready)
+        return 0;
+
+    if (_mixer)
+        return _mixer->getQueueDuration(_mixerInput);
+
+    auto byteRate = static_cast<int64_t>(_sampleRate * _channels * _sampleSize);
+    auto queued = static_cast<int64_t>(_ringBuffer.readAvailable()) * 1000000 / byteRate;
+    auto inDevice = std::max<int64_t>(0, _callbackQueueDuration - (Timer::getTime() - _callbackTime));
+    return queued + inDevice;
 }
 
 /*************/
-void Speaker::setParameters(uint32_t channels, uint32_t sampleRate, Sound_Engine::SampleFormat format, const string& deviceName)
+void Speaker::setParameters(uint32_t channels, uint32_t sampleRate, Sound_Engine::SampleFormat format, const string& deviceName, int outputChannel)
 {
     _channels = std::max((uint32_t)1, channels);
     _sampleRate = std::max((uint32_t)1, sampleRate);
     _sampleFormat = format;
     _deviceName = deviceName;
+    _outputChannel = outputChannel;
 
     Log::get() << Log::MESSAGE << "Speaker::" << __FUNCTION__ << " - Set audio output: " << _sampleRate << "kHz on " << _channels << " channels" << Log::endl;
 
@@ -49,6 +67,13 @@ void Speaker::freeResources()
     if (!_ready)
         return;
 
+    if (_mixer)
+    {
+        _mixer->removeInput(_mixerInput);
+        _mixerInput = -1;
+        _mixer.reset();
+    }
+
     _abortCallback = true;
     _ready = false;
 }
@@ -59,6 +84,27 @@ void Speaker::initResources()
     if (_ready)
         freeResources();
 
+    // Routed through the mixer, the sound is converted and resampled to the device format
+    if (_outputChannel >= 0)
+    {
+        _mixer = Mixer::get(_deviceName);
+        if (!_mixer)
+            return;
+
+        _sampleSize = Sound_Engine::getSampleSize(_sampleFormat);
+        _planar = Sound_Engine::isPlanar(_sampleFormat);
+        _mixerInput = _mixer->addInput(_channels, _sampleRate, _outputChannel);
+        if (_mixerInput < 0 || _sampleSize == 0)
+        {
+            _mixer->removeInput(_mixerInput);
+            _mixer.reset();
+            return;
+        }
+
+        _ready = true;
+        return;
+    }
+
     if (!_engine.getDevice(false, _deviceName))
         return;
 
@@ -75,7 +121,7 @@ void Speaker::initResources()
 
 /*************/
 int Speaker::portAudioCallback(
-    const void* /*in*/, void* out, unsigned long framesPerBuffer, const PaStreamCallbackTimeInfo* /*timeInfo*/, PaStreamCallbackFlags /*statusFlags*/, void* userData)
+    const void* /*in*/, void* out, unsigned long framesPerBuffer, const PaStreamCallbackTimeInfo* timeInfo, PaStreamCallbackFlags /*statusFlags*/, void* userData)
 {
     auto that = static_cast<Speaker*>(userData);
     uint8_t* output = (uint8_t*)out;
@@ -83,49 +129,79 @@ int Speaker::portAudioCallback(
     if (!output)
         return paContinue;
 
-    int readPosition = that->_ringReadPosition;
-    int writePosition = that->_ringWritePosition;
-
     // If the ring buffer is not filled enough, fill with zeros instead
-    int delta = 0;
-    if (writePosition >= readPosition)
-        delta = writePosition - readPosition;
-    else
-        delta = SPLASH_SPEAKER_RINGBUFFER_SIZE - readPosition + writePosition;
-    int step = framesPerBuffer * that->_channels * that->_sampleSize;
-
-    if (delta < step)
-    {
-        for (int i = 0; i < step; ++i)
-            *output++ = 0;
-    }
-    // Else, we copy the values and move the read position
-    else
-    {
-        int effectiveSpace = SPLASH_SPEAKER_RINGBUFFER_SIZE - that->_ringUnusedSpace;
-
-        int ringBufferEndLength = effectiveSpace - readPosition;
-
-        if (step <= ringBufferEndLength)
-        {
-            copy(&that->_ringBuffer[readPosition], &that->_ringBuffer[readPosition + step], output);
-        }
-        else
-        {
-            copy(&that->_ringBuffer[readPosition], &that->_ringBuffer[effectiveSpace], output);
-            output += ringBufferEndLength;
-            copy(&that->_ringBuffer[0], &that->_ringBuffer[step - ringBufferEndLength], output);
-        }
+    size_t step = framesPerBuffer * that->_channels * that->_sampleSize;
+    bool hasSound = that->_ringBuffer.read(output, step);
+    if (!hasSound)
+        memset(output, 0, step);
 
-        readPosition = (readPosition + step) % effectiveSpace;
-        that->_ringReadPosition = readPosition;
-    }
+    // Keep track of when the sound handed to the device will be heard
+    int64_t latency = timeInfo ? std::max<int64_t>(0, (timeInfo->outputBufferDacTime - timeInfo->currentTime) * 1e6) : 0;
+    int64_t blockDuration = hasSound ? static_cast<int64_t>(framesPerBuffer) * 1000000 / that->_sampleRate : 0;
+    that->_callbackQueueDuration = latency + blockDuration;
+    that->_callbackTime = Timer::getTime();
 
     if (that->_abortCallback)
         return paComplete;
     return paContinue;
 }
 
+/*************/
+bool Speaker::queueToMixer(const uint8_t* data, size_t size)
+{
+    const size_t frameCount = size / (_sampleSize * _channels);
+    if (frameCount == 0)
+        return true;
+
+    if (_mixerBuffer.size() < frameCount * _channels)
+        _mixerBuffer.resize(frameCount * _channels);
+
+    auto convert = [&](auto toFloat) {
+        for (size_t frame = 0; frame < frameCount; ++frame)
+            for (uint32_t channel = 0; channel < _channels; ++channel)
+            {
+                auto sampleIndex = _planar ? channel * frameCount + frame : frame * _channels + channel;
+                _mixerBuffer[frame * _channels + channel] = toFloat(data + sampleIndex * _sampleSize);
+            }
+    };
+
+    switch (_sampleFormat)
+    {
+    default:
+        return false;
+    case Sound_Engine::SAMPLE_FMT_U8:
+    case Sound_Engine::SAMPLE_FMT_U8P:
+        convert([](const uint8_t* sample) { return (static_cast<float>(*sample) - 128.f) / 128.f; });
+        break;
+    case Sound_Engine::SAMPLE_FMT_S16:
+    case Sound_Engine::SAMPLE_FMT_S16P:
+        convert([](const uint8_t* sample) {
+            int16_t value;
+            memcpy(&value, sample, sizeof(value));
+            return static_cast<float>(value) / 32768.f;
+        });
+        break;
+    case Sound_Engine::SAMPLE_FMT_S32:
+    case Sound_Engine::SAMPLE_FMT_S32P:
+        convert([](const uint8_t* sample) {
+            int32_t value;
+            memcpy(&value, sample, sizeof(value));
+            return static_cast<float>(value) / 2147483648.f;
+        });
+        break;
+    case Sound_Engine::SAMPLE_FMT_FLT:
+    case Sound_Engine::SAMPLE_FMT_FLTP:
+        convert([](const uint8_t* sample) {
+            float value;
+            memcpy(&value, sample, sizeof(value));
+            return value;
+        });
+        break;
+    }
+
+    return _mixer->write(_mixerInput, _mixerBuffer.data(), frameCount);
+}
+
 /*************/
 void Speaker::registerAttributes()
 {
@@ -27,17 +27,18 @@
 
 #define SPLASH_SPEAKER_RINGBUFFER_SIZE (4 * 1024 * 1024)
 
-#include <array>
 #include <atomic>
+#include <cstring>
 #include <memory>
-#include <mutex>
 #include <vector>
 
 #include "./core/constants.h"
 
 #include "./core/attribute.h"
 #include "./core/graph_object.h"
+#include "./sound/mixer.h"
 #include "./sound/sound_engine.h"
+#include "./utils/spsc_ring.h"
 
 namespace Splash
 {
@@ -69,6 +70,7 @@ class Speaker : public GraphObject
 
     /**
      * \brief Add a buffer to the playing queue
+     * This must always be called from the same thread, as the queue is a single producer ring buffer.
      * \param buffer Buffer to add
      * \return Return false if there was an error
      */
@@ -76,17 +78,26 @@ class Speaker : public GraphObject
     bool addToQueue(const ResizableArray<T>& buffer);
 
     /**
-     * \brief Clear the queue
+     * \brief Clear the queue, from any thread
      */
     void clearQueue();
 
+    /**
+     * \brief Get the time left until the last queued sample is heard, including the output latency
+     * This drives the audio clock for synchronizing the video to the sound.
+     * \return Return the duration in us, or 0 if nothing is queued
+     */
+    int64_t getQueueDuration() const;
+
     /**
      * \brief Set the audio parameters
      * \param channels Channel count
      * \param sampleRate Sample rate
      * \param format Sample format
+     * \param deviceName Output device name, the default one if empty
+     * \param outputChannel Output channel to route the first channel to through the device mixer, or -1 to open a dedicated stream
      */
-    void setParameters(uint32_t channels, uint32_t sampleRate, Sound_Engine::SampleFormat format, const std::string& deviceName = "");
+    void setParameters(uint32_t channels, uint32_t sampleRate, Sound_Engine::SampleFormat format, const std::string& deviceName = "", int outputChannel = -1);
 
   private:
     Sound_Engine _engine;
@@ -97,14 +108,26 @@ class Speaker : public GraphObject
     Sound_Engine::SampleFormat _sampleFormat{Sound_Engine::SAMPLE_FMT_S16};
     size_t _sampleSize{2};
     std::string _deviceName{""};
+    int _outputChannel{-1};
 
     bool _abortCallback{false};
 
-    std::array<uint8_t, SPLASH_SPEAKER_RINGBUFFER_SIZE> _ringBuffer;
-    std::atomic_int _ringWritePosition{0};
-    std::atomic_int _ringReadPosition{0};
-    std::atomic_int _ringUnusedSpace{0};
-    std::mutex _ringWriteMutex;
+    SpscByteRing _ringBuffer{SPLASH_SPEAKER_RINGBUFFER_SIZE};
+    std::vector<uint8_t> _interleavedBuffer{};      //!< Scratch buffer for interleaving planar inputs, only grows
+    std::atomic<int64_t> _callbackTime{0};          //!< Time of the last callback, in us
+    std::atomic<int64_t> _callbackQueueDuration{0}; //!< Duration of the sound handed to the device at the last callback, latency included
+
+    std::shared_ptr<Mixer> _mixer{nullptr}; //!< Device mixer, if the sound is routed through it
+    int _mixerInput{-1};                    //!< Input index in the mixer
+    std::vector<float> _mixerBuffer{};      //!< Scratch buffer for converting the input to the mixer format, only grows
+
+    /**
+     * \brief Convert a buffer to the mixer format and queue it
+     * \param data Buffer to queue
+     * \param size Buffer size in bytes
+     * \return Return false if there was an error
+     */
+    bool queueToMixer(const uint8_t* data, size_t size);
 
     /**
      * \brief Free all PortAudio resources
@@ -121,7 +144,7 @@ class Speaker : public GraphObject
      * \param in Unused
      * \param out Pointer to output data
      * \param framesPerBuffer Frame count
-     * \param timeInfo Unused
+     * \param timeInfo Timing information, used to estimate the output latency
      * \param userData Pointer to this object
      */
     static int portAudioCallback(
@@ -137,55 +160,39 @@ class Speaker : public GraphObject
 template <typename T>
 bool Speaker::addToQueue(const ResizableArray<T>& buffer)
 {
-    std::lock_guard<std::mutex> lock(_ringWriteMutex);
+    auto byteSize = buffer.size() * sizeof(T);
+    if (byteSize == 0)
+        return true;
+
+    if (_mixer)
+        return queueToMixer(reinterpret_cast<const uint8_t*>(buffer.data()), byteSize);
+
+    // Check for space first, to avoid interleaving a buffer which would be dropped
+    if (_ringBuffer.capacity() - _ringBuffer.readAvailable() < byteSize)
+        return false;
+
+    auto bufferPtr = reinterpret_cast<const uint8_t*>(buffer.data());
 
     // If the input buffer is planar, we need to interlace it
-    ResizableArray<T> interleavedBuffer(buffer.size());
     if (_planar)
     {
+        if (_interleavedBuffer.size() < byteSize)
+            _interleavedBuffer.resize(byteSize);
+
         size_t step = _sampleSize / sizeof(T);
         uint32_t sampleNbr = (buffer.size() / step) / _channels;
-        int linesize = sampleNbr * step;
+        size_t linesize = sampleNbr * step;
         for (uint32_t channel = 0; channel < _channels; ++channel)
             for (uint32_t sample = 0; sample < sampleNbr; ++sample)
             {
-                int index = sample * step + channel * linesize;
-                std::copy(&buffer[index], &buffer[index + step], &interleavedBuffer[(sample * _channels + channel) * step]);
+                size_t index = sample * step + channel * linesize;
+                memcpy(&_interleavedBuffer[(sample * _channels + channel) * step * sizeof(T)], &buffer[index], step * sizeof(T));
             }
-    }
-
-    auto bufferSampleSize = sizeof(T);
-    int readPosition = _ringReadPosition;
-    int writePosition = _ringWritePosition;
-
-    int delta = 0;
-    if (readPosition > writePosition)
-        delta = readPosition - writePosition;
-    else
-        delta = SPLASH_SPEAKER_RINGBUFFER_SIZE - writePosition + readPosition;
-
-    if (delta < static_cast<int>(buffer.size() * bufferSampleSize))
-        return false;
 
-    int spaceLeft = SPLASH_SPEAKER_RINGBUFFER_SIZE - writePosition;
-
-    const uint8_t* bufferPtr;
-    if (_planar)
-        bufferPtr = static_cast<const uint8_t*>(interleavedBuffer.data());
-    else
-        bufferPtr = static_cast<const uint8_t*>(buffer.data());
-
-    if (spaceLeft < static_cast<int>(buffer.size() * bufferSampleSize))
-    {
-        _ringUnusedSpace = spaceLeft;
-        writePosition = 0;
+        bufferPtr = _interleavedBuffer.data();
     }
 
-    std::copy(bufferPtr, bufferPtr + buffer.size() * bufferSampleSize, &_ringBuffer[writePosition]);
-    writePosition = (writePosition + buffer.size() * bufferSampleSize);
-
-    _ringWritePosition = writePosition;
-    return true;
+    return _ringBuffer.write(bufferPtr, byteSize);
 }
 
 } // end of namespace
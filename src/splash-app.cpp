@@ -31,6 +31,7 @@
 #include "./core/constants.h"
 #include "./core/scene.h"
 #include "./core/world.h"
+#include "./utils/boot_timeline.h"
 #include "./utils/log.h"
 #include "./utils/osutils.h"
 #include "./utils/timer.h"
@@ -53,27 +54,38 @@ RootObject::Context parseArguments(int argc, char** argv)
     while (true)
     {
         static struct option longOptions[] = {
+            {"address", required_argument, 0, 'a'},
+            {"benchmark", required_argument, 0, 'b'},
             {"debug", no_argument, 0, 'd'},
+            {"headless", no_argument, 0, 'e'},
 #if HAVE_LINUX
             {"forceDisplay", required_argument, 0, 'D'},
             {"displayServer", required_argument, 0, 'S'},
 #endif
+            {"remoteGui", required_argument, 0, 'g'},
             {"help", no_argument, 0, 'h'},
             {"hide", no_argument, 0, 'H'},
             {"info", no_argument, 0, 'i'},
             {"log2file", no_argument, 0, 'l'},
+            {"multicast", required_argument, 0, 'm'},
+#if HAVE_LINUX
+            {"numaNode", required_argument, 0, 'n'},
+#endif
             {"open", required_argument, 0, 'o'},
             {"prefix", required_argument, 0, 'p'},
             {"python", required_argument, 0, 'P'},
+            {"record", required_argument, 0, 'r'},
+            {"replay", required_argument, 0, 'R'},
             {"silent", no_argument, 0, 's'},
             {"timer", no_argument, 0, 't'},
+            {"world", required_argument, 0, 'w'},
             {"child", no_argument, 0, 'c'},
             {"doNotSpawn", no_argument, 0, 'x'},
             {0, 0, 0, 0}
         };
 
         int optionIndex = 0;
-        auto ret = getopt_long(argc, argv, "+cdD:S:hHilo:p:P:stx", longOptions, &optionIndex);
+        auto ret = getopt_long(argc, argv, "+a:b:cdeD:S:g:hHilm:n:o:p:P:r:R:stw:x", longOptions, &optionIndex);
 
         if (ret == -1)
             break;
@@ -91,19 +103,46 @@ RootObject::Context parseArguments(int argc, char** argv)
 #if HAVE_LINUX
             cout << "\t-D (--forceDisplay) : force the display on which to show all windows" << endl;
             cout << "\t-S (--displayServer) : set the display server ID" << endl;
+            cout << "\t-n (--numaNode) [node] : run on the cores of the given NUMA node, and allocate memory from it" << endl;
 #endif
             cout << "\t-s (--silent) : disable all messages" << endl;
             cout << "\t-i (--info) : get description for all objects attributes" << endl;
             cout << "\t-H (--hide) : run Splash in background" << endl;
+            cout << "\t-e (--headless) : render through EGL without a display server, for sinks and benchmarks" << endl;
             cout << "\t-P (--python) : add the given Python script to the loaded configuration" << endl;
             cout << "                  any argument after -- will be sent to the script" << endl;
             cout << "\t-l (--log2file) : write the logs to /var/log/splash.log, if possible" << endl;
             cout << "\t-p (--prefix) : set the shared memory socket paths prefix (defaults to the PID)" << endl;
             cout << "\t-c (--child): run as a child controlled by a master Splash process" << endl;
+            cout << "\t-b (--benchmark) [frames] : render the configuration in background with synthetic media for the given number of frames," << endl;
+            cout << "                  then print the timings as JSON and quit" << endl;
+            cout << "\t-r (--record) [filename] : record the messages and tree changes of the session to [filename]" << endl;
+            cout << "\t-R (--replay) [filename] : replay the session recorded in [filename], then print the timings as JSON and quit" << endl;
+            cout << "\t-a (--address) [host:port] : listen on the given TCP address for processes on other hosts, using this port and the next two" << endl;
+            cout << "\t-w (--world) [host:port] : with --child, TCP address of a World running on another host" << endl;
+            cout << "\t-g (--remoteGui) [host:port] : serve the tree and low resolution previews to remote GUI clients on the given TCP address" << endl;
+            cout << "\t-m (--multicast) [interface;group:port] : exchange buffers with processes on other hosts through PGM multicast" << endl;
             cout << "\t-x (--doNotSpawn): do not spawn subprocesses, which have to be ran manually" << endl;
             cout << endl;
             exit(0);
         }
+        case 'a':
+        {
+            context.listenAddress = string(optarg);
+            break;
+        }
+        case 'b':
+        {
+            auto frames = atoi(optarg);
+            if (frames <= 0)
+            {
+                Log::get() << Log::WARNING << "Splash::" << __FUNCTION__ << " - " << string(optarg) << ": argument expects a positive integer" << Log::endl;
+                exit(0);
+            }
+            context.benchmarkFrames = static_cast<uint32_t>(frames);
+            context.hide = true;
+            break;
+        }
         case 'd':
         {
             Log::get().setVerbosity(Log::DEBUGGING);
@@ -149,6 +188,16 @@ RootObject::Context parseArguments(int argc, char** argv)
             }
             break;
         }
+        case 'e':
+        {
+            context.headless = true;
+            break;
+        }
+        case 'g':
+        {
+            context.remoteGuiAddress = string(optarg);
+            break;
+        }
         case 'H':
         {
             context.hide = true;
@@ -189,6 +238,24 @@ RootObject::Context parseArguments(int argc, char** argv)
             context.log2file = true;
             break;
         }
+        case 'm':
+        {
+            context.multicastAddress = string(optarg);
+            break;
+        }
+#if HAVE_LINUX
+        case 'n':
+        {
+            auto node = atoi(optarg);
+            if (node < 0 || node >= Utils::getNumaNodeCount())
+            {
+                Log::get() << Log::WARNING << "Splash::" << __FUNCTION__ << " - " << string(optarg) << ": argument expects an existing NUMA node" << Log::endl;
+                exit(0);
+            }
+            context.numaNode = node;
+            break;
+        }
+#endif
         case 'o':
         {
             context.defaultConfigurationFile = false;
@@ -200,6 +267,16 @@ RootObject::Context parseArguments(int argc, char** argv)
             context.socketPrefix = string(optarg);
             break;
         }
+        case 'r':
+        {
+            context.recordSessionPath = Utils::getFullPathFromFilePath(string(optarg), Utils::getCurrentWorkingDirectory());
+            break;
+        }
+        case 'R':
+        {
+            context.replaySessionPath = Utils::getFullPathFromFilePath(string(optarg), Utils::getCurrentWorkingDirectory());
+            break;
+        }
         case 's':
         {
             Log::get().setVerbosity(Log::NONE);
@@ -215,6 +292,11 @@ RootObject::Context parseArguments(int argc, char** argv)
             context.childProcess = true;
             break;
         }
+        case 'w':
+        {
+            context.worldAddress = string(optarg);
+            break;
+        }
         case 'x':
         {
             context.spawnSubprocesses = false;
@@ -253,8 +335,23 @@ RootObject::Context parseArguments(int argc, char** argv)
 /*************/
 int main(int argc, char** argv)
 {
+    BootTimeline::get().mark("process_start");
     auto context = parseArguments(argc, argv);
 
+#if HAVE_LINUX
+    // Bound before any thread is created, so that they all inherit the binding
+    if (context.numaNode)
+    {
+        if (Utils::bindToNumaNode(*context.numaNode))
+            Log::get() << Log::MESSAGE << "Splash::" << __FUNCTION__ << " - Bound to NUMA node " << *context.numaNode << Log::endl;
+        else
+            Log::get() << Log::WARNING << "Splash::" << __FUNCTION__ << " - Unable to bind to NUMA node " << *context.numaNode << Log::endl;
+    }
+#endif
+
+    // Thread classes with no core set fall back to the cores of the process, keeping the NUMA binding
+    Utils::captureProcessAffinity();
+
     if (context.childProcess)
     {
         Scene scene(context);
@@ -2,6 +2,9 @@
 
 #include "./core/scene.h"
 
+// Period after which the cached window names are refreshed, in us
+#define SPLASH_USERINPUT_WINDOW_NAMES_PERIOD 1000000
+
 using namespace std;
 
 namespace Splash
@@ -71,8 +74,8 @@ vector<UserInput::State> UserInput::getState(const string& id)
 
     readState();
 
-    auto state(_state);
-    _state.clear();
+    auto state = vector<UserInput::State>();
+    std::swap(state, _state);
     return state;
 }
 
@@ -129,24 +132,34 @@ string UserInput::getWindowName(const GLFWwindow* glfwWindow) const
     if (!glfwWindow)
         return {};
 
+    auto now = Timer::getTime();
+    if (auto nameIt = _windowNames.find(glfwWindow); nameIt != _windowNames.end() && now - _windowNamesUpdateTime < SPLASH_USERINPUT_WINDOW_NAMES_PERIOD)
+        return nameIt->second;
+
     auto scene = dynamic_cast<Scene*>(_root);
     if (!scene)
         return {};
 
     auto windows = list<shared_ptr<GraphObject>>();
-    auto lock = scene->getLockOnObjects();
-    for (auto& obj : scene->_objects)
-        if (obj.second->getType() == "window")
-            windows.push_back(obj.second);
-
+    for (const auto& [name, object] : scene->getObjectsSnapshot()->getObjects())
+        if (object->getType() == "window")
+            windows.push_back(object);
+
+    // Windows are only cached by name, as their GLFW handlers can be reused once they are destroyed
+    _windowNames.clear();
+    _windowNamesUpdateTime = now;
+    string windowName;
     for (auto& w : windows)
     {
         auto window = dynamic_pointer_cast<Window>(w);
         if (window->isWindow(const_cast<GLFWwindow*>(glfwWindow)))
-            return window->getName();
+        {
+            windowName = window->getName();
+            _windowNames[glfwWindow] = windowName;
+        }
     }
 
-    return {};
+    return windowName;
 }
 
 /*************/
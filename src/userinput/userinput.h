@@ -27,6 +27,7 @@
 
 #include <memory>
 #include <thread>
+#include <unordered_map>
 
 #include "./core/constants.h"
 
@@ -127,11 +128,15 @@ class UserInput : public GraphObject
     int _updateRate{100};        //!< Updates per second
     std::thread _updateThread{}; //!< Thread running the update loop
 
+    mutable std::unordered_map<const GLFWwindow*, std::string> _windowNames{}; //!< Cached window names, per GLFW window handler
+    mutable int64_t _windowNamesUpdateTime{0};                                 //!< Last time the window names were cached, in us
+
     static std::mutex _callbackMutex;                                                   //!< Mutex to protect callbacks
     static std::map<State, std::function<void(const State&)>, StateCompare> _callbacks; //!< Callbacks for specific events
 
     /**
      * \brief Get a window name from its GLFW handler
+     * Names are cached, so that bursts of events do not lock the scene objects for each of them
      * \param window GLFW window handler
      * \return Return window name
      */
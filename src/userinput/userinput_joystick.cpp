@@ -2,6 +2,9 @@
 
 #include <regex>
 
+// Period between two joystick detections, in us
+#define SPLASH_JOYSTICK_DETECTION_PERIOD 1000000
+
 using namespace std;
 
 namespace Splash
@@ -21,6 +24,11 @@ Joystick::~Joystick()
 /*************/
 void Joystick::detectJoysticks()
 {
+    auto now = Timer::getTime();
+    if (now - _lastDetectionTime < SPLASH_JOYSTICK_DETECTION_PERIOD)
+        return;
+    _lastDetectionTime = now;
+
     int nbrJoysticks = 0;
     for (int i = GLFW_JOYSTICK_1; i < GLFW_JOYSTICK_LAST; ++i)
         if (glfwJoystickPresent(i))
@@ -39,7 +47,10 @@ void Joystick::updateMethod()
         auto& joystick = _joysticks[i];
         int count;
         auto bufferAxes = glfwGetJoystickAxes(GLFW_JOYSTICK_1 + i, &count);
-        auto axes = vector<float>(bufferAxes, bufferAxes + count);
+        if (!bufferAxes)
+            count = 0;
+        auto& axes = _axesBuffer;
+        axes.assign(bufferAxes, bufferAxes + count);
 
         // TODO: axes configuration, in this case for the dead zone
         for (auto& a : axes)
@@ -55,7 +66,9 @@ void Joystick::updateMethod()
             joystick.axes[a] += axes[a];
 
         auto bufferButtons = glfwGetJoystickButtons(GLFW_JOYSTICK_1 + i, &count);
-        joystick.buttons = vector<uint8_t>(bufferButtons, bufferButtons + count);
+        if (!bufferButtons)
+            count = 0;
+        joystick.buttons.assign(bufferButtons, bufferButtons + count);
     }
 }
 
@@ -51,7 +51,9 @@ class Joystick : public UserInput
         std::vector<uint8_t> buttons;
     };
 
-    std::vector<Stick> _joysticks; //!< Current joysticks state
+    std::vector<Stick> _joysticks;    //!< Current joysticks state
+    int64_t _lastDetectionTime{0};    //!< Last time joysticks were detected, in us
+    std::vector<float> _axesBuffer{}; //!< Buffer for the axes values, reused across updates
 
     /**
      * \brief Update the joystick list
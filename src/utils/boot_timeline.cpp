@@ -0,0 +1,109 @@
+#include "./utils/boot_timeline.h"
+
+#include <algorithm>
+
+#include "./utils/timer.h"
+
+using namespace std;
+
+namespace Splash
+{
+
+namespace
+{
+thread_local string threadOwner{};
+}
+
+/*************/
+string BootTimeline::setThreadOwner(const string& owner)
+{
+    auto previousOwner = threadOwner;
+    threadOwner = owner;
+
+    lock_guard<mutex> lock(_mutex);
+    if (_primaryOwner.empty())
+        _primaryOwner = owner;
+    return previousOwner;
+}
+
+/*************/
+void BootTimeline::addStep(const string& name, int64_t start, int64_t end)
+{
+    if (!isBooting())
+        return;
+
+    {
+        lock_guard<mutex> lock(_mutex);
+        auto& step = _steps[{threadOwner, name}];
+        if (step.count == 0)
+        {
+            step.name = name;
+            step.start = start;
+        }
+        else
+        {
+            step.start = std::min(step.start, start);
+        }
+        step.end = std::max(step.end, end);
+        step.duration += end - start;
+        ++step.count;
+    }
+
+    _version.fetch_add(1, memory_order_release);
+}
+
+/*************/
+void BootTimeline::mark(const string& name)
+{
+    auto now = Timer::getTime();
+    addStep(name, now, now);
+}
+
+/*************/
+vector<BootTimeline::Step> BootTimeline::getSteps(const string& owner) const
+{
+    map<string, Step> ownedSteps;
+    {
+        lock_guard<mutex> lock(_mutex);
+        for (const auto& [key, step] : _steps)
+        {
+            const auto& stepOwner = key.first;
+            if (stepOwner != owner && !(stepOwner.empty() && owner == _primaryOwner))
+                continue;
+
+            // Steps recorded before the thread owner was set are merged with the owned ones
+            auto [stepIt, inserted] = ownedSteps.try_emplace(step.name, step);
+            if (inserted)
+                continue;
+            auto& mergedStep = stepIt->second;
+            mergedStep.start = std::min(mergedStep.start, step.start);
+            mergedStep.end = std::max(mergedStep.end, step.end);
+            mergedStep.duration += step.duration;
+            mergedStep.count += step.count;
+        }
+    }
+
+    vector<Step> steps;
+    for (auto& ownedStep : ownedSteps)
+        steps.push_back(std::move(ownedStep.second));
+    std::sort(steps.begin(), steps.end(), [](const Step& a, const Step& b) { return a.start < b.start; });
+    return steps;
+}
+
+/*************/
+BootStep::BootStep(const string& name)
+{
+    if (!BootTimeline::get().isBooting())
+        return;
+    _name = name;
+    _start = Timer::getTime();
+}
+
+/*************/
+BootStep::~BootStep()
+{
+    if (_start != 0)
+        BootTimeline::get().addStep(_name, _start, Timer::getTime());
+}
+
+} // namespace Splash
@@ -0,0 +1,157 @@
+/*
+ * Copyright (C) 2026 Emmanuel Durand
+ *
+ * This file is part of Splash.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Splash is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Splash.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * @boot_timeline.h
+ * Timeline of the steps taken by a process from its start to its first frame
+ */
+
+#ifndef SPLASH_BOOT_TIMELINE_H
+#define SPLASH_BOOT_TIMELINE_H
+
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace Splash
+{
+
+/*************/
+//! Recorder of the boot steps of the process
+//! Steps with the same name are aggregated, so that repeated steps like shader compilations
+//! show up as a single entry with their first start, last end, summed duration and count.
+//! Each step belongs to the root object owning the thread which recorded it, steps from threads
+//! without an owner belong to the first root object of the process. Recording stops once the
+//! boot is marked as finished, so that runtime loads do not cost anything nor blur the timeline.
+class BootTimeline
+{
+  public:
+    struct Step
+    {
+        std::string name{};
+        int64_t start{0};    //!< First start, on the local clock, in us
+        int64_t end{0};      //!< Last end, on the local clock, in us
+        int64_t duration{0}; //!< Summed duration of all occurrences, in us
+        uint32_t count{0};   //!< Number of occurrences
+    };
+
+  public:
+    /**
+     * \brief Constructor, for a timeline independent of the process one
+     */
+    BootTimeline() = default;
+
+    /**
+     * \brief Get the singleton
+     * \return Return the BootTimeline singleton
+     */
+    static BootTimeline& get()
+    {
+        static auto instance = new BootTimeline;
+        return *instance;
+    }
+
+    BootTimeline(const BootTimeline&) = delete;
+    BootTimeline& operator=(const BootTimeline&) = delete;
+
+    /**
+     * \brief Set the root object owning the steps recorded from the calling thread
+     * \param owner Root object name
+     * \return Return the previous owner of the calling thread
+     */
+    std::string setThreadOwner(const std::string& owner);
+
+    /**
+     * \brief Add an occurrence of a step
+     * \param name Step name
+     * \param start Start time on the local clock, in us
+     * \param end End time on the local clock, in us
+     */
+    void addStep(const std::string& name, int64_t start, int64_t end);
+
+    /**
+     * \brief Add an instantaneous step
+     * \param name Step name
+     */
+    void mark(const std::string& name);
+
+    /**
+     * \brief Get the steps belonging to the given root object, sorted by start time
+     * \param owner Root object name
+     * \return Return the steps
+     */
+    std::vector<Step> getSteps(const std::string& owner) const;
+
+    /**
+     * \brief Get a counter incremented whenever a step is added
+     * \return Return the version
+     */
+    uint64_t getVersion() const { return _version.load(std::memory_order_acquire); }
+
+    /**
+     * \brief Stop recording steps
+     */
+    void finish() { _finished.store(true, std::memory_order_release); }
+
+    /**
+     * \brief Get whether steps are still recorded
+     * \return Return true while booting
+     */
+    bool isBooting() const { return !_finished.load(std::memory_order_acquire); }
+
+  private:
+    std::atomic_bool _finished{false};
+    std::atomic_uint64_t _version{0};
+
+    mutable std::mutex _mutex{};
+    std::string _primaryOwner{};
+    std::map<std::pair<std::string, std::string>, Step> _steps{}; //!< Steps, by owner and name
+};
+
+/*************/
+//! Boot step measured over the lifetime of the object
+class BootStep
+{
+  public:
+    /**
+     * \brief Constructor, starts the step if still booting
+     * \param name Step name
+     */
+    explicit BootStep(const std::string& name);
+
+    /**
+     * \brief Destructor, ends the step
+     */
+    ~BootStep();
+
+    BootStep(const BootStep&) = delete;
+    BootStep& operator=(const BootStep&) = delete;
+
+  private:
+    std::string _name{};
+    int64_t _start{0};
+};
+
+} // namespace Splash
+
+#endif // SPLASH_BOOT_TIMELINE_H
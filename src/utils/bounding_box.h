@@ -0,0 +1,103 @@
+/*
+ * Copyright (C) 2026 Emmanuel Durand
+ *
+ * This file is part of Splash.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Splash is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Splash.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * @bounding_box.h
+ * Axis aligned bounding boxes, and their test against a view frustum
+ */
+
+#ifndef SPLASH_BOUNDING_BOX_H
+#define SPLASH_BOUNDING_BOX_H
+
+#include <limits>
+
+#include <glm/glm.hpp>
+
+namespace Splash
+{
+
+/*************/
+//! Axis aligned bounding box, empty until a point is added to it
+struct BoundingBox
+{
+    glm::vec3 min{std::numeric_limits<float>::max()};
+    glm::vec3 max{std::numeric_limits<float>::lowest()};
+
+    /**
+     * Check whether the box holds no point
+     * \return Return true if empty
+     */
+    bool isEmpty() const { return min.x > max.x || min.y > max.y || min.z > max.z; }
+
+    /**
+     * Grow the box to include the given point
+     * \param point Point to include
+     */
+    void extend(const glm::vec3& point)
+    {
+        min = glm::min(min, point);
+        max = glm::max(max, point);
+    }
+
+    /**
+     * Grow the box to include the given box
+     * \param box Box to include
+     */
+    void extend(const BoundingBox& box)
+    {
+        if (box.isEmpty())
+            return;
+        extend(box.min);
+        extend(box.max);
+    }
+
+    /**
+     * Check whether the box may be seen through the given model view projection matrix
+     * This is conservative: the box is only culled if all its corners are outside of the same clipping plane.
+     * \param mvp Model view projection matrix
+     * \return Return false if the box is out of the view frustum
+     */
+    bool isInFrustum(const glm::dmat4& mvp) const
+    {
+        if (isEmpty())
+            return false;
+
+        // Count the corners outside of each of the six clipping planes, -w <= x, y, z <= w
+        int outside[6] = {0, 0, 0, 0, 0, 0};
+        for (int corner = 0; corner < 8; ++corner)
+        {
+            auto point = glm::dvec4(corner & 1 ? max.x : min.x, corner & 2 ? max.y : min.y, corner & 4 ? max.z : min.z, 1.0);
+            auto clip = mvp * point;
+            for (int axis = 0; axis < 3; ++axis)
+            {
+                outside[axis * 2] += clip[axis] < -clip.w;
+                outside[axis * 2 + 1] += clip[axis] > clip.w;
+            }
+        }
+
+        for (auto count : outside)
+            if (count == 8)
+                return false;
+        return true;
+    }
+};
+
+} // namespace Splash
+
+#endif // SPLASH_BOUNDING_BOX_H
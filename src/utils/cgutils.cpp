@@ -1,6 +1,6 @@
 #include "./utils/cgutils.h"
 
-#include <future>
+#include "./utils/thread_pool.h"
 
 using namespace std;
 
@@ -10,9 +10,8 @@ namespace Splash
 /*************/
 void hapDecodeCallback(HapDecodeWorkFunction func, void* p, unsigned int count, void* /*info*/)
 {
-    vector<future<void>> threads;
-    for (unsigned int i = 0; i < count; ++i)
-        threads.push_back(async(launch::async, [=]() { func(p, i); }));
+    // Chunks are decompressed in parallel, and all of them must be done when returning
+    ThreadPool::get().runParallel(count, [=](unsigned int index) { func(p, index); });
 }
 
 /*************/
@@ -0,0 +1,147 @@
+/*
+ * Copyright (C) 2026 Emmanuel Durand
+ *
+ * This file is part of Splash.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Splash is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Splash.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * @clock_sync.h
+ * Estimation of the offset between the local clock and a remote reference clock
+ */
+
+#ifndef SPLASH_CLOCK_SYNC_H
+#define SPLASH_CLOCK_SYNC_H
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <limits>
+
+namespace Splash
+{
+
+/*************/
+//! NTP like estimation of the offset to a remote clock, from request / reply exchanges
+//! Each exchange gives an offset sample, assuming a symmetric network path. Among the
+//! last samples, the one with the smallest round trip is the least affected by queuing
+//! delays and is taken as the target. The offset is stepped to the target on first sync
+//! or when it is too far off, and slewed towards it otherwise so that the clock stays monotonic.
+class ClockSync
+{
+  public:
+    /**
+     * Constructor
+     * \param windowSize Number of samples among which the best one is selected
+     * \param stepThreshold Offset error in us above which the offset is stepped instead of slewed
+     * \param maxSlew Maximum offset correction per sample in us, when slewing
+     */
+    explicit ClockSync(size_t windowSize = 8, int64_t stepThreshold = 10000, int64_t maxSlew = 200)
+        : _windowSize(windowSize > 0 ? windowSize : 1)
+        , _stepThreshold(stepThreshold)
+        , _maxSlew(maxSlew)
+    {
+    }
+
+    /**
+     * Add a sample from a request / reply exchange
+     * \param localSend Local time when the request was sent, in us
+     * \param remote Remote time read while answering the request, in us
+     * \param localReceive Local time when the answer was received, in us
+     * \return Return false if the sample is invalid and was dropped
+     */
+    bool addSample(int64_t localSend, int64_t remote, int64_t localReceive)
+    {
+        if (localReceive < localSend)
+            return false;
+
+        Sample sample;
+        sample.roundTrip = localReceive - localSend;
+        sample.offset = remote - (localSend + sample.roundTrip / 2);
+
+        _samples.push_back(sample);
+        while (_samples.size() > _windowSize)
+            _samples.pop_front();
+
+        auto best = _samples.front();
+        for (const auto& s : _samples)
+            if (s.roundTrip < best.roundTrip)
+                best = s;
+        _roundTrip = best.roundTrip;
+
+        auto error = best.offset - _offset;
+        if (!_synchronized || error > _stepThreshold || error < -_stepThreshold)
+        {
+            _offset = best.offset;
+            _synchronized = true;
+        }
+        else
+        {
+            _offset += error > _maxSlew ? _maxSlew : (error < -_maxSlew ? -_maxSlew : error);
+        }
+
+        return true;
+    }
+
+    /**
+     * Get the current offset estimation, to add to the local clock to get the remote one
+     * \return Return the offset in us
+     */
+    int64_t getOffset() const { return _offset; }
+
+    /**
+     * Get the round trip of the sample currently used as the offset target
+     * This is an upper bound of twice the offset error.
+     * \return Return the round trip in us
+     */
+    int64_t getRoundTrip() const { return _roundTrip; }
+
+    /**
+     * Get whether at least one valid sample has been received
+     * \return Return true if synchronized
+     */
+    bool isSynchronized() const { return _synchronized; }
+
+    /**
+     * Drop all samples, the next one will step the offset
+     */
+    void reset()
+    {
+        _samples.clear();
+        _synchronized = false;
+        _offset = 0;
+        _roundTrip = std::numeric_limits<int64_t>::max();
+    }
+
+  private:
+    struct Sample
+    {
+        int64_t offset{0};
+        int64_t roundTrip{0};
+    };
+
+    size_t _windowSize;
+    int64_t _stepThreshold;
+    int64_t _maxSlew;
+
+    std::deque<Sample> _samples{};
+    bool _synchronized{false};
+    int64_t _offset{0};
+    int64_t _roundTrip{std::numeric_limits<int64_t>::max()};
+};
+
+} // namespace Splash
+
+#endif // SPLASH_CLOCK_SYNC_H
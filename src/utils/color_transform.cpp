@@ -0,0 +1,88 @@
+#include "./utils/color_transform.h"
+
+#include <algorithm>
+#include <cmath>
+
+using namespace std;
+
+namespace Splash
+{
+
+namespace
+{
+// Same as rgb2hsv and hsv2rgb from the hsv shader include
+array<float, 3> rgb2hsv(const array<float, 3>& c)
+{
+    array<float, 4> p = c[1] < c[2] ? array<float, 4>{c[2], c[1], -1.f, 2.f / 3.f} : array<float, 4>{c[1], c[2], 0.f, -1.f / 3.f};
+    array<float, 4> q = c[0] < p[0] ? array<float, 4>{p[0], p[1], p[3], c[0]} : array<float, 4>{c[0], p[1], p[2], p[0]};
+
+    float d = q[0] - std::min(q[3], q[1]);
+    float e = 1.0e-10f;
+    return {std::abs(q[2] + (q[3] - q[1]) / (6.f * d + e)), d / (q[0] + e), q[0]};
+}
+
+array<float, 3> hsv2rgb(const array<float, 3>& c)
+{
+    array<float, 3> rgb;
+    const array<float, 3> k{1.f, 2.f / 3.f, 1.f / 3.f};
+    for (int i = 0; i < 3; ++i)
+    {
+        float shifted = c[0] + k[i];
+        float p = std::abs((shifted - std::floor(shifted)) * 6.f - 3.f);
+        rgb[i] = c[2] * (1.f + (std::clamp(p - 1.f, 0.f, 1.f) - 1.f) * c[1]);
+    }
+    return rgb;
+}
+} // namespace
+
+/*************/
+array<float, 3> ColorTransform::apply(array<float, 3> color) const
+{
+    float maxBalanceRatio = std::max(balanceRed, balanceBlue);
+    color[0] *= balanceRed / maxBalanceRatio;
+    color[1] *= 1.f / maxBalanceRatio;
+    color[2] *= balanceBlue / maxBalanceRatio;
+
+    if (brightness != 1.f || saturation != 1.f || contrast != 1.f)
+    {
+        auto hsv = rgb2hsv(color);
+        hsv[2] *= brightness;
+        hsv[1] = std::min(1.f, hsv[1] * saturation);
+        hsv[2] = (hsv[2] - 0.5f) * contrast + 0.5f;
+        hsv[2] = std::min(1.f, hsv[2]);
+        color = hsv2rgb(hsv);
+    }
+
+    if (lut.size() == 768)
+    {
+        for (int i = 0; i < 3; ++i)
+        {
+            auto index = std::clamp(static_cast<int>(std::round(color[i] * 255.f)), 0, 255);
+            color[i] = lut[index * 3 + i];
+        }
+    }
+
+    return color;
+}
+
+/*************/
+vector<float> ColorTransform::bake(int size) const
+{
+    if (size < 2)
+        return {};
+
+    vector<float> table;
+    table.reserve(size * size * size * 3);
+    const float step = 1.f / static_cast<float>(size - 1);
+    for (int b = 0; b < size; ++b)
+        for (int g = 0; g < size; ++g)
+            for (int r = 0; r < size; ++r)
+            {
+                auto color = apply({r * step, g * step, b * step});
+                table.insert(table.end(), color.begin(), color.end());
+            }
+
+    return table;
+}
+
+} // namespace Splash
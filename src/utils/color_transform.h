@@ -0,0 +1,70 @@
+/*
+ * Copyright (C) 2026 Emmanuel Durand
+ *
+ * This file is part of Splash.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Splash is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Splash.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * @color_transform.h
+ * Color transform applied by the cameras, baked into 3D lookup tables
+ */
+
+#ifndef SPLASH_COLOR_TRANSFORM_H
+#define SPLASH_COLOR_TRANSFORM_H
+
+#include <array>
+#include <vector>
+
+namespace Splash
+{
+
+/*************/
+//! CPU version of the color transform of the textured fragment shader, see FRAGMENT_SHADER_TEXTURE
+//! The color balance is applied first, then the brightness, saturation and contrast, then the lookup table.
+struct ColorTransform
+{
+    float balanceRed{1.f};    //!< Color balance, as the red over green ratio
+    float balanceBlue{1.f};   //!< Color balance, as the blue over green ratio
+    float brightness{1.f};    //!< Brightness correction
+    float saturation{1.f};    //!< Saturation correction
+    float contrast{1.f};      //!< Contrast correction
+    std::vector<float> lut{}; //!< Per channel lookup table as 256 RGB triplets, applied if not empty
+
+    /**
+     * Apply the transform to the given color
+     * \param color RGB color
+     * \return Return the transformed color
+     */
+    std::array<float, 3> apply(std::array<float, 3> color) const;
+
+    /**
+     * Bake the transform into a 3D lookup table
+     * \param size Number of samples along each axis, the inputs being sampled at i / (size - 1)
+     * \return Return size^3 RGB triplets, red varying fastest then green
+     */
+    std::vector<float> bake(int size) const;
+
+    bool operator==(const ColorTransform& other) const
+    {
+        return balanceRed == other.balanceRed && balanceBlue == other.balanceBlue && brightness == other.brightness && saturation == other.saturation &&
+               contrast == other.contrast && lut == other.lut;
+    }
+    bool operator!=(const ColorTransform& other) const { return !(*this == other); }
+};
+
+} // namespace Splash
+
+#endif // SPLASH_COLOR_TRANSFORM_H
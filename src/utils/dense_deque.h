@@ -26,6 +26,7 @@
 #define SPLASH_DENSE_DEQUE_H
 
 #include <initializer_list>
+#include <utility>
 #include <vector>
 
 namespace Splash
@@ -68,12 +69,15 @@ class DenseDeque
         return *this;
     }
 
-    DenseDeque(const DenseDeque<T>&& value) { operator=(value); }
+    DenseDeque(DenseDeque<T>&& value) noexcept
+        : _data(std::move(value._data))
+    {
+    }
     DenseDeque<T>& operator=(DenseDeque<T>&& other) noexcept
     {
         if (&other == this)
             return *this;
-        _data = other._data;
+        _data = std::move(other._data);
         return *this;
     }
 
@@ -21,6 +21,8 @@
  * @dense_map.h
  * Dense map, a cache friendly unordered map based on std::vector
  * It matches as much as possible std::map, check https://en.cppreference.com/w/cpp/container/map
+ * Elements are kept in insertion order. Lookups in small maps scan a byte of each key hash with SSE2 or NEON,
+ * larger maps also maintain an open addressing index.
  *
  * Known issues:
  * - modifying the DenseMap while iterating over it with a for range may invalide the std::pair references
@@ -29,12 +31,21 @@
 #ifndef SPLASH_DENSE_MAP_H
 #define SPLASH_DENSE_MAP_H
 
+#include <algorithm>
+#include <cstdint>
+#include <functional>
 #include <initializer_list>
 #include <memory>
 #include <stdexcept>
 #include <vector>
 
-#include "./utils/dense_set.h"
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+#define SPLASH_DENSE_MAP_INDEX_THRESHOLD 64
 
 namespace Splash
 {
@@ -325,7 +336,9 @@ class DenseMap
     DenseMap<Key, T>& operator=(const DenseMap<Key, T>& other)
     {
         _keys = other._keys;
+        _tags = other._tags;
         _values = other._values;
+        _slots = other._slots;
         return *this;
     }
 
@@ -333,72 +346,69 @@ class DenseMap
     DenseMap<Key, T>& operator=(DenseMap<Key, T>&& other) noexcept
     {
         _keys = other._keys;
+        _tags = other._tags;
         _values = other._values;
+        _slots = other._slots;
         return *this;
     }
 
     DenseMap(std::initializer_list<std::pair<Key, T>> init) { operator=(init); }
     DenseMap<Key, T>& operator=(std::initializer_list<std::pair<Key, T>> init)
     {
-        _keys.clear();
-        _values.clear();
+        clear();
         for (auto p = init.begin(); p != init.end(); ++p)
-        {
-            if (_keys.find(p->first) == _keys.end())
-            {
-                auto keyIt = _keys.insert(p->first);
-                _values.push_back(p->second);
-            }
-        }
+            insert(*p);
         return *this;
     }
 
     // Element access
     T& at(const Key& key)
     {
-        typename DenseSet<Key>::const_iterator it = _keys.find(key);
-        if (it == _keys.cend())
+        auto index = findIndex(key);
+        if (index == _keys.size())
             throw std::out_of_range("Container does not have a element with key " + std::to_string(key));
-        return _values[std::distance(_keys.cbegin(), it)];
+        return _values[index];
     }
 
     const T& at(const Key& key) const
     {
-        typename DenseSet<Key>::const_iterator it = _keys.find(key);
-        if (it == _keys.cend())
+        auto index = findIndex(key);
+        if (index == _keys.size())
             throw std::out_of_range("Container does not have a element with key " + std::to_string(key));
-        return _values[std::distance(_keys.cbegin(), it)];
+        return _values[index];
     }
 
     T& operator[](const Key& key)
     {
-        typename DenseSet<Key>::const_iterator it = _keys.find(key);
-        if (it != _keys.cend())
-            return _values[std::distance(_keys.cbegin(), it)];
+        auto index = findIndex(key);
+        if (index != _keys.size())
+            return _values[index];
 
-        insert({key, T()});
+        appendKey(key);
+        _values.emplace_back();
         return _values.back();
     }
 
     T& operator[](Key&& key)
     {
-        typename DenseSet<Key>::const_iterator it = _keys.find(key);
-        if (it != _keys.cend())
-            return _values[std::distance(_keys.cbegin(), it)];
+        auto index = findIndex(key);
+        if (index != _keys.size())
+            return _values[index];
 
-        insert({key, T()});
+        appendKey(std::move(key));
+        _values.emplace_back();
         return _values.back();
     }
 
     // Comparison operators
     bool operator==(const DenseMap<Key, T>& rhs) const
     {
-        for (const auto& key : _keys)
+        for (size_t i = 0; i < _keys.size(); ++i)
         {
-            const_iterator it = rhs.find(key);
-            if (it == rhs.cend())
+            auto index = rhs.findIndex(_keys[i]);
+            if (index == rhs._keys.size())
                 return false;
-            if (it->second != _values[std::distance(rhs.cbegin(), it)])
+            if (rhs._values[index] != _values[i])
                 return false;
         }
         return true;
@@ -433,6 +443,7 @@ class DenseMap
     void reserve(size_t size)
     {
         _keys.reserve(size);
+        _tags.reserve(size);
         _values.reserve(size);
     }
 
@@ -440,30 +451,30 @@ class DenseMap
     void clear()
     {
         _keys.clear();
+        _tags.clear();
         _values.clear();
+        _slots.clear();
     }
 
     std::pair<iterator, bool> insert(const std::pair<Key, T>& value)
     {
-        auto result = _keys.insert(value.first);
-        if (result.second)
-        {
-            _values.emplace_back(value.second);
-            return std::make_pair(iterator(_keys.size() - 1, *this), true);
-        }
+        auto index = findIndex(value.first);
+        if (index != _keys.size())
+            return std::make_pair(iterator(index, *this), false);
 
-        return std::make_pair(iterator(std::distance(_keys.begin(), result.first), *this), false);
+        appendKey(value.first);
+        _values.emplace_back(value.second);
+        return std::make_pair(iterator(index, *this), true);
     }
     std::pair<iterator, bool> insert(std::pair<Key, T>&& value)
     {
-        auto result = _keys.insert(value.first);
-        if (result.second)
-        {
-            _values.emplace_back(std::move(value.second));
-            return std::make_pair(iterator(_keys.size() - 1, *this), true);
-        }
+        auto index = findIndex(value.first);
+        if (index != _keys.size())
+            return std::make_pair(iterator(index, *this), false);
 
-        return std::make_pair(iterator(std::distance(_keys.begin(), result.first), *this), false);
+        appendKey(std::move(value.first));
+        _values.emplace_back(std::move(value.second));
+        return std::make_pair(iterator(index, *this), true);
     }
     template <class InputIt>
     void insert(InputIt first, InputIt last)
@@ -479,30 +490,30 @@ class DenseMap
 
     std::pair<iterator, bool> insert_or_assign(const Key& key, T&& obj)
     {
-        auto result = _keys.insert(key);
-        if (!result.second)
+        auto index = findIndex(key);
+        if (index != _keys.size())
         {
-            auto index = std::distance(_keys.begin(), result.first);
-            _values[index] = obj;
+            _values[index] = std::move(obj);
             return std::make_pair(iterator(index, *this), false);
         }
 
-        _values.emplace_back(obj);
-        return std::make_pair(iterator(_keys.size() - 1, *this), true);
+        appendKey(key);
+        _values.emplace_back(std::move(obj));
+        return std::make_pair(iterator(index, *this), true);
     }
 
     std::pair<iterator, bool> insert_or_assign(Key&& key, T&& obj)
     {
-        auto result = _keys.insert(key);
-        if (!result.second)
+        auto index = findIndex(key);
+        if (index != _keys.size())
         {
-            auto index = std::distance(_keys.begin(), result.first);
-            _values[index] = obj;
+            _values[index] = std::move(obj);
             return std::make_pair(iterator(index, *this), false);
         }
 
-        _values.emplace_back(obj);
-        return std::make_pair(iterator(_keys.size() - 1, *this), true);
+        appendKey(std::move(key));
+        _values.emplace_back(std::move(obj));
+        return std::make_pair(iterator(index, *this), true);
     }
 
     template <class... Args>
@@ -514,34 +525,17 @@ class DenseMap
     template <class... Args>
     std::pair<iterator, bool> try_emplace(const Key& key, Args&&... args)
     {
-        auto result = _keys.insert(key);
-        if (!result.second)
-            return make_pair(iterator(std::distance(_keys.begin(), result.first), *this), false);
+        auto index = findIndex(key);
+        if (index != _keys.size())
+            return std::make_pair(iterator(index, *this), false);
 
-        _values.emplace_back(args...);
-        return std::make_pair(iterator(_keys.size() - 1, *this), true);
+        appendKey(key);
+        _values.emplace_back(std::forward<Args>(args)...);
+        return std::make_pair(iterator(index, *this), true);
     }
 
-    iterator erase(iterator pos)
-    {
-        auto it = _keys.find(pos->first);
-        if (it == _keys.end())
-            return end();
-        auto index = std::distance(_keys.begin(), it);
-        _keys.erase(it);
-        _values.erase(_values.begin() + index);
-        return iterator(index, *this);
-    }
-    iterator erase(const_iterator pos)
-    {
-        auto it = _keys.find(pos->first);
-        if (it == _keys.end())
-            return end();
-        auto index = std::distance(_keys.begin(), it);
-        _keys.erase(it);
-        _values.erase(_values.begin() + index);
-        return iterator(index, *this);
-    }
+    iterator erase(iterator pos) { return eraseIndex(findIndex(pos->first)); }
+    iterator erase(const_iterator pos) { return eraseIndex(findIndex(pos->first)); }
     iterator erase(const_iterator first, const_iterator last)
     {
         auto current = first;
@@ -552,42 +546,184 @@ class DenseMap
     }
     size_t erase(const Key& key)
     {
-        auto it = _keys.find(key);
-        if (it == _keys.end())
+        auto index = findIndex(key);
+        if (index == _keys.size())
             return 0;
-        auto index = std::distance(_keys.begin(), it);
-        _keys.erase(key);
-        _values.erase(_values.begin() + index);
+        eraseIndex(index);
         return 1;
     }
 
     void swap(DenseMap& other)
     {
         std::swap(_keys, other._keys);
+        std::swap(_tags, other._tags);
         std::swap(_values, other._values);
+        std::swap(_slots, other._slots);
     }
 
     // Lookup
-    iterator find(const Key& key)
+    size_t count(const Key& key) const { return findIndex(key) == _keys.size() ? 0 : 1; }
+
+    iterator find(const Key& key) { return iterator(findIndex(key), *this); }
+    const_iterator find(const Key& key) const { return const_iterator(findIndex(key), *this); }
+
+  protected:
+    std::vector<Key> _keys;
+    std::vector<uint8_t> _tags; //!< One byte of each key hash, in the same order as _keys
+    std::vector<T> _values;
+    std::vector<uint32_t> _slots; //!< Open addressing index holding element indices plus one, only for large maps
+
+    /**
+     * Get the mixed hash of a key
+     * std::hash is the identity for integers, so it is mixed to spread its bits
+     * \param key Key
+     * \return Return the hash
+     */
+    static uint64_t getHash(const Key& key) { return static_cast<uint64_t>(std::hash<Key>()(key)) * 0x9E3779B97F4A7C15ull; }
+
+    /**
+     * Get the one byte tag corresponding to a hash
+     * \param hash Mixed hash
+     * \return Return the tag
+     */
+    static uint8_t getTag(uint64_t hash) { return static_cast<uint8_t>(hash >> 56); }
+
+    /**
+     * Find the index of a key
+     * Small maps compare the tags 16 at a time, and the keys only when the tags match.
+     * Larger maps probe the open addressing index.
+     * \param key Key
+     * \return Return the index, or size() if the key is not in the map
+     */
+    size_t findIndex(const Key& key) const
+    {
+        const auto hash = getHash(key);
+        const auto tag = getTag(hash);
+        const auto size = _keys.size();
+        const auto tags = _tags.data();
+
+        if (!_slots.empty())
+        {
+            const auto mask = _slots.size() - 1;
+            for (auto position = hash & mask;; position = (position + 1) & mask)
+            {
+                const auto slot = _slots[position];
+                if (slot == 0)
+                    return size;
+                if (tags[slot - 1] == tag && _keys[slot - 1] == key)
+                    return slot - 1;
+            }
+        }
+
+        size_t index = 0;
+#if defined(__SSE2__)
+        const __m128i pattern = _mm_set1_epi8(static_cast<char>(tag));
+        for (; index + 16 <= size; index += 16)
+        {
+            const __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(tags + index));
+            auto mask = static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(block, pattern)));
+            while (mask != 0)
+            {
+                const auto offset = static_cast<size_t>(__builtin_ctz(mask));
+                if (_keys[index + offset] == key)
+                    return index + offset;
+                mask &= mask - 1;
+            }
+        }
+#elif defined(__ARM_NEON)
+        const uint8x16_t pattern = vdupq_n_u8(tag);
+        for (; index + 16 <= size; index += 16)
+        {
+            const uint8x16_t matches = vceqq_u8(vld1q_u8(tags + index), pattern);
+            // Narrow each byte of the comparison result to 4 bits, to get a 64 bits mask
+            auto mask = vget_lane_u64(vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(matches), 4)), 0);
+            while (mask != 0)
+            {
+                const auto offset = static_cast<size_t>(__builtin_ctzll(mask) >> 2);
+                if (_keys[index + offset] == key)
+                    return index + offset;
+                mask &= ~(0xFull << (offset << 2));
+            }
+        }
+#endif
+
+        for (; index < size; ++index)
+            if (tags[index] == tag && _keys[index] == key)
+                return index;
+
+        return size;
+    }
+
+    /**
+     * Append a key which is known not to be in the map yet
+     * \param key Key
+     */
+    template <class K>
+    void appendKey(K&& key)
+    {
+        const auto hash = getHash(key);
+        _tags.push_back(getTag(hash));
+        _keys.emplace_back(std::forward<K>(key));
+
+        if (_keys.size() <= SPLASH_DENSE_MAP_INDEX_THRESHOLD)
+            return;
+
+        if (_keys.size() * 2 > _slots.size())
+            rebuildIndex();
+        else
+            insertSlot(hash, _keys.size() - 1);
+    }
+
+    /**
+     * Erase the element at the given index
+     * \param index Index
+     * \return Return an iterator to the element following the erased one
+     */
+    iterator eraseIndex(size_t index)
     {
-        typename DenseSet<Key>::const_iterator it = _keys.find(key);
-        if (it == _keys.cend())
+        if (index >= _keys.size())
             return end();
-        auto index = std::distance(_keys.cbegin(), it);
+        _keys.erase(_keys.begin() + index);
+        _tags.erase(_tags.begin() + index);
+        _values.erase(_values.begin() + index);
+
+        // Erasing shifts the following elements, so the index has to be rebuilt
+        if (!_slots.empty())
+            rebuildIndex();
         return iterator(index, *this);
     }
-    const_iterator find(const Key& key) const
+
+    /**
+     * Add an element to the open addressing index
+     * \param hash Mixed hash of the element key
+     * \param index Element index
+     */
+    void insertSlot(uint64_t hash, size_t index)
     {
-        typename DenseSet<Key>::const_iterator it = _keys.find(key);
-        if (it == _keys.cend())
-            return cend();
-        auto index = std::distance(_keys.cbegin(), it);
-        return const_iterator(index, *this);
+        const auto mask = _slots.size() - 1;
+        auto position = hash & mask;
+        while (_slots[position] != 0)
+            position = (position + 1) & mask;
+        _slots[position] = static_cast<uint32_t>(index + 1);
     }
 
-  protected:
-    DenseSet<Key> _keys;
-    std::vector<T> _values;
+    /**
+     * Rebuild the open addressing index, keeping its load factor below one half
+     * The index is dropped when the map is small enough to be scanned
+     */
+    void rebuildIndex()
+    {
+        _slots.clear();
+        if (_keys.size() <= SPLASH_DENSE_MAP_INDEX_THRESHOLD)
+            return;
+
+        size_t slotCount = 1;
+        while (slotCount < _keys.size() * 2)
+            slotCount <<= 1;
+        _slots.resize(slotCount, 0);
+        for (size_t index = 0; index < _keys.size(); ++index)
+            insertSlot(getHash(_keys[index]), index);
+    }
 };
 
 } // namespace Splash
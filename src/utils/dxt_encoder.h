@@ -0,0 +1,276 @@
+/*
+ * Copyright (C) 2026 Emmanuel Durand
+ *
+ * This file is part of Splash.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Splash is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Splash.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * @dxt_encoder.h
+ * Fast DXT5 (BC3) block compression of RGBA images
+ */
+
+#ifndef SPLASH_DXT_ENCODER_H
+#define SPLASH_DXT_ENCODER_H
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+
+namespace Splash
+{
+
+/*************/
+//! DXT5 encoder, picking a single pair of endpoints for each 4x4 block
+//! The color endpoints are the extreme colors along the principal axis of the block, inset a bit
+//! to reduce the error on the other colors. This is much faster than an exhaustive search, and
+//! good enough for pictures.
+class DxtEncoder
+{
+  public:
+    static constexpr uint32_t blockSize = 16; //!< Size of a compressed 4x4 block, in bytes
+
+    /**
+     * Get the size of the compressed image
+     * \param width Image width
+     * \param height Image height
+     * \return Return the size in bytes, which is one byte per pixel for a block aligned image
+     */
+    static size_t compressedSize(uint32_t width, uint32_t height) { return static_cast<size_t>((width + 3) / 4) * ((height + 3) / 4) * blockSize; }
+
+    /**
+     * Compress a row of 4x4 blocks from an RGBA image
+     * Rows can be compressed independently, to spread the work over multiple threads
+     * \param rgba RGBA pixels, 8 bits per channel
+     * \param width Image width
+     * \param height Image height
+     * \param blockRow Index of the row of blocks to compress
+     * \param blocks Output buffer, of compressedSize(width, height) bytes
+     */
+    static void compressBlockRow(const uint8_t* rgba, uint32_t width, uint32_t height, uint32_t blockRow, uint8_t* blocks)
+    {
+        const uint32_t blocksPerRow = (width + 3) / 4;
+        uint8_t block[64];
+        for (uint32_t blockColumn = 0; blockColumn < blocksPerRow; ++blockColumn)
+        {
+            // Pixels outside of the image are clamped to the border
+            for (uint32_t y = 0; y < 4; ++y)
+            {
+                const auto row = std::min(blockRow * 4 + y, height - 1);
+                for (uint32_t x = 0; x < 4; ++x)
+                {
+                    const auto column = std::min(blockColumn * 4 + x, width - 1);
+                    memcpy(block + (y * 4 + x) * 4, rgba + (static_cast<size_t>(row) * width + column) * 4, 4);
+                }
+            }
+
+            compressBlock(block, blocks + (static_cast<size_t>(blockRow) * blocksPerRow + blockColumn) * blockSize);
+        }
+    }
+
+    /**
+     * Compress a single 4x4 block
+     * \param block 16 RGBA pixels, row by row
+     * \param output Output buffer, of blockSize bytes
+     */
+    static void compressBlock(const uint8_t* block, uint8_t* output)
+    {
+        compressAlpha(block, output);
+        compressColor(block, output + 8);
+    }
+
+  private:
+    /**
+     * Compress the alpha channel of a block, as two 8 bits endpoints and 3 bits indices
+     */
+    static void compressAlpha(const uint8_t* block, uint8_t* output)
+    {
+        uint8_t minAlpha = 255, maxAlpha = 0;
+        for (uint32_t i = 0; i < 16; ++i)
+        {
+            minAlpha = std::min(minAlpha, block[i * 4 + 3]);
+            maxAlpha = std::max(maxAlpha, block[i * 4 + 3]);
+        }
+
+        output[0] = maxAlpha;
+        output[1] = minAlpha;
+        memset(output + 2, 0, 6);
+        if (maxAlpha == minAlpha)
+            return;
+
+        // With the first endpoint being the greatest, the palette holds the 6 interpolated values
+        int palette[8];
+        palette[0] = maxAlpha;
+        palette[1] = minAlpha;
+        for (int i = 1; i < 7; ++i)
+            palette[i + 1] = ((7 - i) * maxAlpha + i * minAlpha) / 7;
+
+        uint64_t indices = 0;
+        for (uint32_t i = 0; i < 16; ++i)
+        {
+            const int alpha = block[i * 4 + 3];
+            uint64_t bestIndex = 0;
+            int bestError = 256;
+            for (uint64_t p = 0; p < 8; ++p)
+            {
+                const auto error = std::abs(alpha - palette[p]);
+                if (error < bestError)
+                {
+                    bestError = error;
+                    bestIndex = p;
+                }
+            }
+            indices |= bestIndex << (i * 3);
+        }
+
+        for (uint32_t i = 0; i < 6; ++i)
+            output[2 + i] = static_cast<uint8_t>(indices >> (i * 8));
+    }
+
+    /**
+     * Compress the color channels of a block, as two RGB565 endpoints and 2 bits indices
+     */
+    static void compressColor(const uint8_t* block, uint8_t* output)
+    {
+        int mean[3] = {0, 0, 0};
+        for (uint32_t i = 0; i < 16; ++i)
+            for (uint32_t c = 0; c < 3; ++c)
+                mean[c] += block[i * 4 + c];
+        for (uint32_t c = 0; c < 3; ++c)
+            mean[c] = (mean[c] + 8) / 16;
+
+        // Principal axis of the block colors, from a few power iterations on their covariance matrix
+        float covariance[6] = {0.f, 0.f, 0.f, 0.f, 0.f, 0.f};
+        for (uint32_t i = 0; i < 16; ++i)
+        {
+            const float red = block[i * 4] - mean[0];
+            const float green = block[i * 4 + 1] - mean[1];
+            const float blue = block[i * 4 + 2] - mean[2];
+            covariance[0] += red * red;
+            covariance[1] += red * green;
+            covariance[2] += red * blue;
+            covariance[3] += green * green;
+            covariance[4] += green * blue;
+            covariance[5] += blue * blue;
+        }
+
+        float axis[3] = {0.9f, 1.f, 0.7f};
+        for (uint32_t iteration = 0; iteration < 4; ++iteration)
+        {
+            const float red = axis[0] * covariance[0] + axis[1] * covariance[1] + axis[2] * covariance[2];
+            const float green = axis[0] * covariance[1] + axis[1] * covariance[3] + axis[2] * covariance[4];
+            const float blue = axis[0] * covariance[2] + axis[1] * covariance[4] + axis[2] * covariance[5];
+            const float norm = std::max({std::abs(red), std::abs(green), std::abs(blue)});
+            if (norm < 1e-4f)
+                break;
+            axis[0] = red / norm;
+            axis[1] = green / norm;
+            axis[2] = blue / norm;
+        }
+
+        // The endpoints are the extreme colors along the axis
+        const uint8_t* minColor8 = block;
+        const uint8_t* maxColor8 = block;
+        float minProjection = std::numeric_limits<float>::max();
+        float maxProjection = std::numeric_limits<float>::lowest();
+        for (uint32_t i = 0; i < 16; ++i)
+        {
+            const auto projection = block[i * 4] * axis[0] + block[i * 4 + 1] * axis[1] + block[i * 4 + 2] * axis[2];
+            if (projection < minProjection)
+            {
+                minProjection = projection;
+                minColor8 = block + i * 4;
+            }
+            if (projection > maxProjection)
+            {
+                maxProjection = projection;
+                maxColor8 = block + i * 4;
+            }
+        }
+
+        // Inset the endpoints by 1/16th of the range, to reduce the error on the other colors
+        int minColor[3], maxColor[3];
+        for (uint32_t c = 0; c < 3; ++c)
+        {
+            const int inset = (maxColor8[c] - minColor8[c]) / 16;
+            maxColor[c] = std::clamp(maxColor8[c] - inset, 0, 255);
+            minColor[c] = std::clamp(minColor8[c] + inset, 0, 255);
+        }
+
+        auto color0 = toRGB565(maxColor);
+        auto color1 = toRGB565(minColor);
+        // DXT5 color blocks are always decoded in four colors mode, the order only matters for readability
+        if (color0 < color1)
+            std::swap(color0, color1);
+
+        int palette[4][3];
+        fromRGB565(color0, palette[0]);
+        fromRGB565(color1, palette[1]);
+        for (uint32_t c = 0; c < 3; ++c)
+        {
+            palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+            palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+        }
+
+        uint32_t indices = 0;
+        for (uint32_t i = 0; i < 16; ++i)
+        {
+            uint32_t bestIndex = 0;
+            int bestError = 3 * 256 * 256;
+            for (uint32_t p = 0; p < 4; ++p)
+            {
+                int error = 0;
+                for (uint32_t c = 0; c < 3; ++c)
+                {
+                    const int difference = block[i * 4 + c] - palette[p][c];
+                    error += difference * difference;
+                }
+                if (error < bestError)
+                {
+                    bestError = error;
+                    bestIndex = p;
+                }
+            }
+            indices |= bestIndex << (i * 2);
+        }
+
+        output[0] = static_cast<uint8_t>(color0);
+        output[1] = static_cast<uint8_t>(color0 >> 8);
+        output[2] = static_cast<uint8_t>(color1);
+        output[3] = static_cast<uint8_t>(color1 >> 8);
+        for (uint32_t i = 0; i < 4; ++i)
+            output[4 + i] = static_cast<uint8_t>(indices >> (i * 8));
+    }
+
+    static uint16_t toRGB565(const int* color)
+    {
+        return static_cast<uint16_t>(((color[0] * 31 + 127) / 255) << 11 | ((color[1] * 63 + 127) / 255) << 5 | ((color[2] * 31 + 127) / 255));
+    }
+
+    static void fromRGB565(uint16_t value, int* color)
+    {
+        const int red = (value >> 11) & 0x1F;
+        const int green = (value >> 5) & 0x3F;
+        const int blue = value & 0x1F;
+        color[0] = (red << 3) | (red >> 2);
+        color[1] = (green << 2) | (green >> 4);
+        color[2] = (blue << 3) | (blue >> 2);
+    }
+};
+
+} // namespace Splash
+
+#endif // SPLASH_DXT_ENCODER_H
@@ -0,0 +1,110 @@
+/*
+ * Copyright (C) 2026 Emmanuel Durand
+ *
+ * This file is part of Splash.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Splash is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Splash.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * @frame_arena.h
+ * Monotonic arena, reset at every loop, for the temporaries of a single frame
+ */
+
+#ifndef SPLASH_FRAME_ARENA_H
+#define SPLASH_FRAME_ARENA_H
+
+#include <cstddef>
+#include <memory_resource>
+#include <optional>
+#include <vector>
+
+namespace Splash
+{
+
+/*************/
+//! Memory resource handing out chunks of a buffer which is reused from one loop to the next
+//! Nothing is released before reset() is called, at which point all allocations must be dead.
+//! If a loop needed more than the buffer size, the buffer grows at reset to the size used,
+//! so that once the high-water mark is reached no loop goes to the global heap anymore.
+//! As for any memory resource, an arena must only be used by one thread at a time.
+class FrameArena
+{
+  public:
+    /**
+     * Constructor
+     * \param initialSize Initial buffer size, in bytes
+     */
+    explicit FrameArena(size_t initialSize = 65536)
+        : _buffer(initialSize > 0 ? initialSize : 1)
+    {
+        _resource.emplace(_buffer.data(), _buffer.size(), &_upstream);
+    }
+
+    FrameArena(const FrameArena&) = delete;
+    FrameArena& operator=(const FrameArena&) = delete;
+
+    /**
+     * Get the memory resource to give to the pmr containers
+     * \return Return a pointer to the resource
+     */
+    std::pmr::memory_resource* resource() { return &_resource.value(); }
+
+    /**
+     * Release all the allocations made since the last reset
+     * Every container using the arena must have been destroyed before calling this
+     */
+    void reset()
+    {
+        _resource.reset();
+        if (auto overflow = _upstream.getAllocatedSize(); overflow > 0)
+            _buffer = std::vector<std::byte>(_buffer.size() + overflow);
+        _upstream.resetAllocatedSize();
+        _resource.emplace(_buffer.data(), _buffer.size(), &_upstream);
+    }
+
+    /**
+     * Get the buffer size
+     * \return Return the size in bytes
+     */
+    size_t capacity() const { return _buffer.size(); }
+
+  private:
+    //! Resource forwarding to the global heap, counting the bytes allocated since the last reset
+    class UpstreamResource : public std::pmr::memory_resource
+    {
+      public:
+        size_t getAllocatedSize() const { return _allocatedSize; }
+        void resetAllocatedSize() { _allocatedSize = 0; }
+
+      private:
+        size_t _allocatedSize{0};
+
+        void* do_allocate(size_t bytes, size_t alignment) final
+        {
+            _allocatedSize += bytes;
+            return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+        }
+        void do_deallocate(void* ptr, size_t bytes, size_t alignment) final { std::pmr::new_delete_resource()->deallocate(ptr, bytes, alignment); }
+        bool do_is_equal(const std::pmr::memory_resource& other) const noexcept final { return this == &other; }
+    };
+
+    std::vector<std::byte> _buffer{};
+    UpstreamResource _upstream{};
+    std::optional<std::pmr::monotonic_buffer_resource> _resource{};
+};
+
+} // namespace Splash
+
+#endif // SPLASH_FRAME_ARENA_H
@@ -0,0 +1,373 @@
+#include "./utils/http_protocol.h"
+
+#include <algorithm>
+#include <array>
+#include <cctype>
+
+// GUID appended to the WebSocket key, as defined by RFC 6455
+#define SPLASH_WEBSOCKET_GUID "258EAFA5-E914-47DA-95CA-C5AB0DC85B11"
+
+using namespace std;
+
+namespace Splash
+{
+namespace Http
+{
+
+namespace
+{
+/*************/
+string toLower(string str)
+{
+    transform(str.begin(), str.end(), str.begin(), [](unsigned char c) { return static_cast<char>(tolower(c)); });
+    return str;
+}
+
+/*************/
+string trim(const string& str)
+{
+    auto first = str.find_first_not_of(" \t");
+    if (first == string::npos)
+        return {};
+    auto last = str.find_last_not_of(" \t");
+    return str.substr(first, last - first + 1);
+}
+} // namespace
+
+/*************/
+bool hasToken(const string& header, const string& token)
+{
+    size_t start = 0;
+    while (start <= header.size())
+    {
+        auto end = header.find(',', start);
+        if (end == string::npos)
+            end = header.size();
+        if (toLower(trim(header.substr(start, end - start))) == token)
+            return true;
+        start = end + 1;
+    }
+    return false;
+}
+
+/*************/
+ParseStatus parseRequest(const string& buffer, Request& request, size_t& consumed, size_t maxSize)
+{
+    auto headerEnd = buffer.find("\r\n\r\n");
+    if (headerEnd == string::npos)
+        return buffer.size() > maxSize ? ParseStatus::Invalid : ParseStatus::Incomplete;
+
+    request = Request();
+
+    // Request line
+    auto lineEnd = buffer.find("\r\n");
+    auto requestLine = buffer.substr(0, lineEnd);
+    auto methodEnd = requestLine.find(' ');
+    auto targetEnd = methodEnd == string::npos ? string::npos : requestLine.find(' ', methodEnd + 1);
+    if (targetEnd == string::npos || requestLine.compare(targetEnd + 1, 7, "HTTP/1.") != 0)
+        return ParseStatus::Invalid;
+    request.method = requestLine.substr(0, methodEnd);
+    request.target = requestLine.substr(methodEnd + 1, targetEnd - methodEnd - 1);
+    if (request.method.empty() || request.target.empty())
+        return ParseStatus::Invalid;
+
+    // Headers
+    auto lineStart = lineEnd + 2;
+    while (lineStart < headerEnd + 2)
+    {
+        lineEnd = buffer.find("\r\n", lineStart);
+        auto line = buffer.substr(lineStart, lineEnd - lineStart);
+        auto separator = line.find(':');
+        if (separator == string::npos || separator == 0)
+            return ParseStatus::Invalid;
+        request.headers[toLower(line.substr(0, separator))] = trim(line.substr(separator + 1));
+        lineStart = lineEnd + 2;
+    }
+
+    // Only bodies with a known length are supported
+    if (request.headers.find("transfer-encoding") != request.headers.end())
+        return ParseStatus::Invalid;
+
+    size_t contentLength = 0;
+    if (auto lengthIt = request.headers.find("content-length"); lengthIt != request.headers.end())
+    {
+        const auto& length = lengthIt->second;
+        if (length.empty() || length.size() > 10 || !all_of(length.begin(), length.end(), [](unsigned char c) { return isdigit(c); }))
+            return ParseStatus::Invalid;
+        contentLength = stoull(length);
+    }
+
+    auto bodyStart = headerEnd + 4;
+    if (bodyStart + contentLength > maxSize)
+        return ParseStatus::Invalid;
+    if (buffer.size() < bodyStart + contentLength)
+        return ParseStatus::Incomplete;
+
+    request.body = buffer.substr(bodyStart, contentLength);
+    consumed = bodyStart + contentLength;
+    return ParseStatus::Complete;
+}
+
+/*************/
+string buildResponse(int status, const string& contentType, const string& body, bool keepAlive)
+{
+    string response = "HTTP/1.1 " + to_string(status) + " " + getStatusText(status) + "\r\n";
+    if (!contentType.empty())
+        response += "Content-Type: " + contentType + "\r\n";
+    response += "Content-Length: " + to_string(body.size()) + "\r\n";
+    response += "Access-Control-Allow-Origin: *\r\n";
+    if (status == 204)
+    {
+        response += "Access-Control-Allow-Methods: GET, PUT, POST, OPTIONS\r\n";
+        response += "Access-Control-Allow-Headers: Content-Type\r\n";
+    }
+    response += keepAlive ? "Connection: keep-alive\r\n" : "Connection: close\r\n";
+    response += "\r\n";
+    response += body;
+    return response;
+}
+
+/*************/
+string getStatusText(int status)
+{
+    switch (status)
+    {
+    case 101:
+        return "Switching Protocols";
+    case 200:
+        return "OK";
+    case 202:
+        return "Accepted";
+    case 204:
+        return "No Content";
+    case 400:
+        return "Bad Request";
+    case 404:
+        return "Not Found";
+    case 405:
+        return "Method Not Allowed";
+    case 413:
+        return "Payload Too Large";
+    case 500:
+        return "Internal Server Error";
+    default:
+        return "Unknown";
+    }
+}
+
+/*************/
+string decodeUrl(const string& str)
+{
+    string decoded;
+    decoded.reserve(str.size());
+    for (size_t i = 0; i < str.size(); ++i)
+    {
+        if (str[i] == '%' && i + 2 < str.size() && isxdigit(static_cast<unsigned char>(str[i + 1])) && isxdigit(static_cast<unsigned char>(str[i + 2])))
+        {
+            decoded.push_back(static_cast<char>(stoi(str.substr(i + 1, 2), nullptr, 16)));
+            i += 2;
+        }
+        else
+        {
+            decoded.push_back(str[i]);
+        }
+    }
+    return decoded;
+}
+
+/*************/
+bool isWebSocketUpgrade(const Request& request)
+{
+    return request.method == "GET" && hasToken(request.getHeader("connection"), "upgrade") && toLower(request.getHeader("upgrade")) == "websocket" &&
+           request.getHeader("sec-websocket-version") == "13" && !request.getHeader("sec-websocket-key").empty();
+}
+
+/*************/
+string buildWebSocketHandshake(const Request& request)
+{
+    string response = "HTTP/1.1 101 Switching Protocols\r\n";
+    response += "Upgrade: websocket\r\n";
+    response += "Connection: Upgrade\r\n";
+    response += "Sec-WebSocket-Accept: " + getWebSocketAccept(request.getHeader("sec-websocket-key")) + "\r\n";
+    response += "\r\n";
+    return response;
+}
+
+/*************/
+string getWebSocketAccept(const string& key)
+{
+    return encodeBase64(sha1(key + SPLASH_WEBSOCKET_GUID));
+}
+
+/*************/
+ParseStatus decodeFrame(const string& buffer, Frame& frame, size_t& consumed, size_t maxPayload)
+{
+    if (buffer.size() < 2)
+        return ParseStatus::Incomplete;
+
+    auto data = reinterpret_cast<const uint8_t*>(buffer.data());
+    frame.fin = data[0] & 0x80;
+    frame.opcode = data[0] & 0x0F;
+    bool masked = data[1] & 0x80;
+    uint64_t length = data[1] & 0x7F;
+
+    // Reserved bits are not used as no extension is negotiated, and client frames must be masked
+    if ((data[0] & 0x70) || !masked)
+        return ParseStatus::Invalid;
+    if ((frame.opcode & 0x08) && (!frame.fin || length > 125))
+        return ParseStatus::Invalid;
+
+    size_t position = 2;
+    if (length == 126 || length == 127)
+    {
+        size_t lengthSize = length == 126 ? 2 : 8;
+        if (buffer.size() < position + lengthSize)
+            return ParseStatus::Incomplete;
+        length = 0;
+        for (size_t i = 0; i < lengthSize; ++i)
+            length = (length << 8) | data[position + i];
+        position += lengthSize;
+    }
+
+    if (length > maxPayload)
+        return ParseStatus::Invalid;
+    if (buffer.size() < position + 4 + length)
+        return ParseStatus::Incomplete;
+
+    const uint8_t* mask = data + position;
+    position += 4;
+    frame.payload.resize(length);
+    for (size_t i = 0; i < length; ++i)
+        frame.payload[i] = static_cast<char>(data[position + i] ^ mask[i % 4]);
+
+    consumed = position + length;
+    return ParseStatus::Complete;
+}
+
+/*************/
+string encodeFrame(uint8_t opcode, const string& payload)
+{
+    string frame;
+    frame.reserve(payload.size() + 10);
+    frame.push_back(static_cast<char>(0x80 | (opcode & 0x0F)));
+
+    auto length = static_cast<uint64_t>(payload.size());
+    if (length < 126)
+    {
+        frame.push_back(static_cast<char>(length));
+    }
+    else if (length <= 0xFFFF)
+    {
+        frame.push_back(static_cast<char>(126));
+        frame.push_back(static_cast<char>((length >> 8) & 0xFF));
+        frame.push_back(static_cast<char>(length & 0xFF));
+    }
+    else
+    {
+        frame.push_back(static_cast<char>(127));
+        for (int i = 7; i >= 0; --i)
+            frame.push_back(static_cast<char>((length >> (8 * i)) & 0xFF));
+    }
+
+    frame += payload;
+    return frame;
+}
+
+/*************/
+string sha1(const string& data)
+{
+    array<uint32_t, 5> state{0x67452301, 0xEFCDAB89, 0x98BADCFE, 0x10325476, 0xC3D2E1F0};
+
+    // Padding, with the message length in bits as a big endian 64 bits integer
+    string message = data;
+    message.push_back(static_cast<char>(0x80));
+    while (message.size() % 64 != 56)
+        message.push_back(0);
+    auto bitLength = static_cast<uint64_t>(data.size()) * 8;
+    for (int i = 7; i >= 0; --i)
+        message.push_back(static_cast<char>((bitLength >> (8 * i)) & 0xFF));
+
+    auto rotate = [](uint32_t value, int bits) { return (value << bits) | (value >> (32 - bits)); };
+    auto bytes = reinterpret_cast<const uint8_t*>(message.data());
+    for (size_t chunk = 0; chunk < message.size(); chunk += 64)
+    {
+        array<uint32_t, 80> words;
+        for (size_t i = 0; i < 16; ++i)
+            words[i] = (static_cast<uint32_t>(bytes[chunk + 4 * i]) << 24) | (static_cast<uint32_t>(bytes[chunk + 4 * i + 1]) << 16) |
+                       (static_cast<uint32_t>(bytes[chunk + 4 * i + 2]) << 8) | static_cast<uint32_t>(bytes[chunk + 4 * i + 3]);
+        for (size_t i = 16; i < 80; ++i)
+            words[i] = rotate(words[i - 3] ^ words[i - 8] ^ words[i - 14] ^ words[i - 16], 1);
+
+        auto [a, b, c, d, e] = state;
+        for (size_t i = 0; i < 80; ++i)
+        {
+            uint32_t f, k;
+            if (i < 20)
+            {
+                f = (b & c) | (~b & d);
+                k = 0x5A827999;
+            }
+            else if (i < 40)
+            {
+                f = b ^ c ^ d;
+                k = 0x6ED9EBA1;
+            }
+            else if (i < 60)
+            {
+                f = (b & c) | (b & d) | (c & d);
+                k = 0x8F1BBCDC;
+            }
+            else
+            {
+                f = b ^ c ^ d;
+                k = 0xCA62C1D6;
+            }
+
+            auto temp = rotate(a, 5) + f + e + k + words[i];
+            e = d;
+            d = c;
+            c = rotate(b, 30);
+            b = a;
+            a = temp;
+        }
+
+        state[0] += a;
+        state[1] += b;
+        state[2] += c;
+        state[3] += d;
+        state[4] += e;
+    }
+
+    string digest;
+    for (auto value : state)
+        for (int i = 3; i >= 0; --i)
+            digest.push_back(static_cast<char>((value >> (8 * i)) & 0xFF));
+    return digest;
+}
+
+/*************/
+string encodeBase64(const string& data)
+{
+    static const char* alphabet = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+    string encoded;
+    encoded.reserve((data.size() + 2) / 3 * 4);
+    auto bytes = reinterpret_cast<const uint8_t*>(data.data());
+    for (size_t i = 0; i < data.size(); i += 3)
+    {
+        uint32_t block = bytes[i] << 16;
+        if (i + 1 < data.size())
+            block |= bytes[i + 1] << 8;
+        if (i + 2 < data.size())
+            block |= bytes[i + 2];
+
+        encoded.push_back(alphabet[(block >> 18) & 0x3F]);
+        encoded.push_back(alphabet[(block >> 12) & 0x3F]);
+        encoded.push_back(i + 1 < data.size() ? alphabet[(block >> 6) & 0x3F] : '=');
+        encoded.push_back(i + 2 < data.size() ? alphabet[block & 0x3F] : '=');
+    }
+    return encoded;
+}
+
+} // namespace Http
+} // namespace Splash
@@ -0,0 +1,184 @@
+/*
+ * Copyright (C) 2026 Emmanuel Durand
+ *
+ * This file is part of Splash.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Splash is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Splash.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * @http_protocol.h
+ * Minimal HTTP/1.1 and WebSocket (RFC 6455) protocol handling, independent of any socket
+ */
+
+#ifndef SPLASH_HTTP_PROTOCOL_H
+#define SPLASH_HTTP_PROTOCOL_H
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace Splash
+{
+namespace Http
+{
+
+//! Result of an attempt to parse a message from a buffer
+enum class ParseStatus : uint8_t
+{
+    Incomplete, //!< More data is needed
+    Complete,   //!< A message has been parsed
+    Invalid     //!< The buffer does not hold a valid message
+};
+
+//! HTTP request
+struct Request
+{
+    std::string method{};
+    std::string target{};
+    std::map<std::string, std::string> headers{}; //!< Header names are lowercase
+    std::string body{};
+
+    /**
+     * Get the value of the given header
+     * \param name Header name, lowercase
+     * \return Return the header value, or an empty string
+     */
+    std::string getHeader(const std::string& name) const
+    {
+        auto headerIt = headers.find(name);
+        return headerIt == headers.end() ? std::string() : headerIt->second;
+    }
+};
+
+//! WebSocket frame opcodes
+enum Opcode : uint8_t
+{
+    Continuation = 0x0,
+    Text = 0x1,
+    Binary = 0x2,
+    Close = 0x8,
+    Ping = 0x9,
+    Pong = 0xA
+};
+
+//! WebSocket frame
+struct Frame
+{
+    bool fin{true};
+    uint8_t opcode{Opcode::Text};
+    std::string payload{}; //!< Unmasked payload
+};
+
+/**
+ * Parse an HTTP request from the beginning of the buffer
+ * \param buffer Received data
+ * \param request Parsed request
+ * \param consumed Number of bytes used by the request, if complete
+ * \param maxSize Maximum size of the request, headers and body included
+ * \return Return the parse status
+ */
+ParseStatus parseRequest(const std::string& buffer, Request& request, size_t& consumed, size_t maxSize);
+
+/**
+ * Build an HTTP response
+ * \param status Status code
+ * \param contentType Content type, not sent if empty
+ * \param body Response body
+ * \param keepAlive If false, ask the client to close the connection
+ * \return Return the response, ready to be sent
+ */
+std::string buildResponse(int status, const std::string& contentType, const std::string& body, bool keepAlive = true);
+
+/**
+ * Get the reason phrase for the given status code
+ * \param status Status code
+ * \return Return the reason phrase
+ */
+std::string getStatusText(int status);
+
+/**
+ * Decode a percent-encoded URL component
+ * \param str Encoded string
+ * \return Return the decoded string
+ */
+std::string decodeUrl(const std::string& str);
+
+/**
+ * Check whether a comma separated header value holds the given token, case insensitively
+ * \param header Header value
+ * \param token Token, lowercase
+ * \return Return true if the token is found
+ */
+bool hasToken(const std::string& header, const std::string& token);
+
+/**
+ * Check whether the request asks for an upgrade to the WebSocket protocol
+ * \param request Request
+ * \return Return true if this is a valid WebSocket upgrade request
+ */
+bool isWebSocketUpgrade(const Request& request);
+
+/**
+ * Build the response accepting a WebSocket upgrade
+ * \param request Upgrade request
+ * \return Return the response, ready to be sent
+ */
+std::string buildWebSocketHandshake(const Request& request);
+
+/**
+ * Compute the Sec-WebSocket-Accept value for the given key
+ * \param key Sec-WebSocket-Key sent by the client
+ * \return Return the accept value
+ */
+std::string getWebSocketAccept(const std::string& key);
+
+/**
+ * Decode a WebSocket frame from the beginning of the buffer
+ * \param buffer Received data
+ * \param frame Decoded frame
+ * \param consumed Number of bytes used by the frame, if complete
+ * \param maxPayload Maximum payload size
+ * \return Return the parse status
+ */
+ParseStatus decodeFrame(const std::string& buffer, Frame& frame, size_t& consumed, size_t maxPayload);
+
+/**
+ * Encode a WebSocket frame, unmasked as sent by a server
+ * \param opcode Frame opcode
+ * \param payload Frame payload
+ * \return Return the encoded frame
+ */
+std::string encodeFrame(uint8_t opcode, const std::string& payload);
+
+/**
+ * Compute the SHA-1 digest of the given data
+ * \param data Input data
+ * \return Return the 20 bytes digest
+ */
+std::string sha1(const std::string& data);
+
+/**
+ * Encode data in base64
+ * \param data Input data
+ * \return Return the encoded data
+ */
+std::string encodeBase64(const std::string& data);
+
+} // namespace Http
+} // namespace Splash
+
+#endif // SPLASH_HTTP_PROTOCOL_H
@@ -0,0 +1,394 @@
+#include "./utils/json_snapshot.h"
+
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <fstream>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "./utils/jsonutils.h"
+#include "./utils/log.h"
+
+// Maximum nesting of arrays and objects accepted when decoding, to reject corrupted snapshots
+#define SPLASH_JSON_SNAPSHOT_MAX_DEPTH 256
+
+using namespace std;
+
+namespace Splash
+{
+namespace Utils
+{
+
+namespace
+{
+
+//! Snapshot header, followed by the encoded tree
+struct SnapshotHeader
+{
+    char magic[8]{SPLASH_JSON_SNAPSHOT_MAGIC};
+    uint32_t version{SPLASH_JSON_SNAPSHOT_VERSION};
+    uint32_t reserved{0};
+    int64_t sourceSize{-1};        //!< Size of the source Json file, or -1 if none
+    int64_t sourceModification{0}; //!< Modification date of the source Json file, in ns
+    uint64_t payloadSize{0};       //!< Size of the encoded tree
+};
+
+//! Tags of the encoded values. Arrays holding only reals are stored as a contiguous block of doubles,
+//! which covers most of the large arrays (calibration points, warp lattices...)
+enum class Tag : uint8_t
+{
+    Null = 0,
+    False,
+    True,
+    Int,
+    UInt,
+    Real,
+    String,
+    Array,
+    Object,
+    RealArray
+};
+
+/*************/
+template <typename T>
+void write(string& buffer, const T& value)
+{
+    buffer.append(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+/*************/
+void writeString(string& buffer, const char* begin, const char* end)
+{
+    write(buffer, static_cast<uint32_t>(end - begin));
+    buffer.append(begin, end - begin);
+}
+
+/*************/
+void encode(string& buffer, const Json::Value& value)
+{
+    switch (value.type())
+    {
+    default:
+    case Json::nullValue:
+        write(buffer, Tag::Null);
+        break;
+    case Json::booleanValue:
+        write(buffer, value.asBool() ? Tag::True : Tag::False);
+        break;
+    case Json::intValue:
+        write(buffer, Tag::Int);
+        write(buffer, static_cast<int64_t>(value.asInt64()));
+        break;
+    case Json::uintValue:
+        write(buffer, Tag::UInt);
+        write(buffer, static_cast<uint64_t>(value.asUInt64()));
+        break;
+    case Json::realValue:
+        write(buffer, Tag::Real);
+        write(buffer, value.asDouble());
+        break;
+    case Json::stringValue:
+    {
+        const char* begin = nullptr;
+        const char* end = nullptr;
+        value.getString(&begin, &end);
+        write(buffer, Tag::String);
+        writeString(buffer, begin, end);
+        break;
+    }
+    case Json::arrayValue:
+    {
+        bool onlyReals = value.size() > 0;
+        for (const auto& item : value)
+        {
+            if (item.type() != Json::realValue)
+            {
+                onlyReals = false;
+                break;
+            }
+        }
+
+        write(buffer, onlyReals ? Tag::RealArray : Tag::Array);
+        write(buffer, static_cast<uint32_t>(value.size()));
+        for (const auto& item : value)
+        {
+            if (onlyReals)
+                write(buffer, item.asDouble());
+            else
+                encode(buffer, item);
+        }
+        break;
+    }
+    case Json::objectValue:
+    {
+        write(buffer, Tag::Object);
+        write(buffer, static_cast<uint32_t>(value.size()));
+        for (auto it = value.begin(); it != value.end(); ++it)
+        {
+            const char* end = nullptr;
+            const char* begin = it.memberName(&end);
+            writeString(buffer, begin, end);
+            encode(buffer, *it);
+        }
+        break;
+    }
+    }
+}
+
+//! Bounds checked reader over the mapped payload
+struct Reader
+{
+    const uint8_t* current{nullptr};
+    const uint8_t* end{nullptr};
+
+    size_t remaining() const { return static_cast<size_t>(end - current); }
+
+    template <typename T>
+    bool read(T& value)
+    {
+        if (remaining() < sizeof(T))
+            return false;
+        memcpy(&value, current, sizeof(T));
+        current += sizeof(T);
+        return true;
+    }
+
+    bool readString(string& value)
+    {
+        uint32_t length = 0;
+        if (!read(length) || remaining() < length)
+            return false;
+        value.assign(reinterpret_cast<const char*>(current), length);
+        current += length;
+        return true;
+    }
+};
+
+/*************/
+bool decode(Reader& reader, Json::Value& value, int depth)
+{
+    if (depth > SPLASH_JSON_SNAPSHOT_MAX_DEPTH)
+        return false;
+
+    Tag tag;
+    if (!reader.read(tag))
+        return false;
+
+    switch (tag)
+    {
+    default:
+        return false;
+    case Tag::Null:
+        value = Json::Value();
+        return true;
+    case Tag::False:
+    case Tag::True:
+        value = Json::Value(tag == Tag::True);
+        return true;
+    case Tag::Int:
+    {
+        int64_t number = 0;
+        if (!reader.read(number))
+            return false;
+        value = Json::Value(static_cast<Json::Int64>(number));
+        return true;
+    }
+    case Tag::UInt:
+    {
+        uint64_t number = 0;
+        if (!reader.read(number))
+            return false;
+        value = Json::Value(static_cast<Json::UInt64>(number));
+        return true;
+    }
+    case Tag::Real:
+    {
+        double number = 0.0;
+        if (!reader.read(number))
+            return false;
+        value = Json::Value(number);
+        return true;
+    }
+    case Tag::String:
+    {
+        string text;
+        if (!reader.readString(text))
+            return false;
+        value = Json::Value(text);
+        return true;
+    }
+    case Tag::RealArray:
+    {
+        uint32_t count = 0;
+        if (!reader.read(count) || reader.remaining() / sizeof(double) < count)
+            return false;
+        value = Json::Value(Json::arrayValue);
+        value.resize(count);
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            double number = 0.0;
+            reader.read(number);
+            value[i] = number;
+        }
+        return true;
+    }
+    case Tag::Array:
+    {
+        // Each item takes at least one byte, which bounds the count of a corrupted snapshot
+        uint32_t count = 0;
+        if (!reader.read(count) || reader.remaining() < count)
+            return false;
+        value = Json::Value(Json::arrayValue);
+        value.resize(count);
+        for (uint32_t i = 0; i < count; ++i)
+            if (!decode(reader, value[i], depth + 1))
+                return false;
+        return true;
+    }
+    case Tag::Object:
+    {
+        uint32_t count = 0;
+        if (!reader.read(count) || reader.remaining() < count)
+            return false;
+        value = Json::Value(Json::objectValue);
+        string key;
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            if (!reader.readString(key))
+                return false;
+            if (!decode(reader, value[key], depth + 1))
+                return false;
+        }
+        return true;
+    }
+    }
+}
+
+/*************/
+bool getSourceStat(const string& source, int64_t& size, int64_t& modification)
+{
+    struct stat sourceStat;
+    if (stat(source.c_str(), &sourceStat) != 0)
+        return false;
+    size = static_cast<int64_t>(sourceStat.st_size);
+    modification = static_cast<int64_t>(sourceStat.st_mtim.tv_sec) * 1000000000 + static_cast<int64_t>(sourceStat.st_mtim.tv_nsec);
+    return true;
+}
+
+} // namespace
+
+/*************/
+bool saveJsonSnapshot(const string& filename, const Json::Value& value, const string& source)
+{
+    SnapshotHeader header;
+    if (!source.empty() && !getSourceStat(source, header.sourceSize, header.sourceModification))
+    {
+        Log::get() << Log::WARNING << "Utils::" << __FUNCTION__ << " - Unable to get the status of source file " << source << Log::endl;
+        return false;
+    }
+
+    string payload;
+    encode(payload, value);
+    header.payloadSize = payload.size();
+
+    auto temporaryFilename = filename + ".tmp";
+    ofstream out(temporaryFilename, ios::binary | ios::trunc);
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    out.write(payload.data(), payload.size());
+    out.close();
+
+    if (!out || rename(temporaryFilename.c_str(), filename.c_str()) != 0)
+    {
+        Log::get() << Log::WARNING << "Utils::" << __FUNCTION__ << " - Unable to write snapshot " << filename << Log::endl;
+        remove(temporaryFilename.c_str());
+        return false;
+    }
+
+    return true;
+}
+
+/*************/
+bool loadJsonSnapshot(const string& filename, Json::Value& value, const string& source)
+{
+    int fd = open(filename.c_str(), O_RDONLY);
+    if (fd < 0)
+        return false;
+
+    struct stat snapshotStat;
+    if (fstat(fd, &snapshotStat) != 0 || static_cast<size_t>(snapshotStat.st_size) < sizeof(SnapshotHeader))
+    {
+        close(fd);
+        return false;
+    }
+
+    auto size = static_cast<size_t>(snapshotStat.st_size);
+    auto ptr = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (ptr == MAP_FAILED)
+        return false;
+
+    auto data = static_cast<const uint8_t*>(ptr);
+    SnapshotHeader header;
+    memcpy(&header, data, sizeof(header));
+
+    bool isValid = memcmp(header.magic, SPLASH_JSON_SNAPSHOT_MAGIC, sizeof(header.magic)) == 0 && header.version == SPLASH_JSON_SNAPSHOT_VERSION &&
+                   header.payloadSize == size - sizeof(header);
+    if (!isValid)
+    {
+        Log::get() << Log::WARNING << "Utils::" << __FUNCTION__ << " - File " << filename << " is not a valid snapshot" << Log::endl;
+        munmap(ptr, size);
+        return false;
+    }
+
+    if (!source.empty())
+    {
+        int64_t sourceSize = -1;
+        int64_t sourceModification = 0;
+        if (!getSourceStat(source, sourceSize, sourceModification) || sourceSize != header.sourceSize || sourceModification != header.sourceModification)
+        {
+            Log::get() << Log::DEBUGGING << "Utils::" << __FUNCTION__ << " - Snapshot " << filename << " is outdated, " << source << " was modified since" << Log::endl;
+            munmap(ptr, size);
+            return false;
+        }
+    }
+
+    Reader reader{data + sizeof(header), data + size};
+    Json::Value decoded;
+    auto isDecoded = decode(reader, decoded, 0) && reader.remaining() == 0;
+    munmap(ptr, size);
+
+    if (!isDecoded)
+    {
+        Log::get() << Log::WARNING << "Utils::" << __FUNCTION__ << " - Snapshot " << filename << " is corrupted" << Log::endl;
+        return false;
+    }
+
+    value = std::move(decoded);
+    return true;
+}
+
+/*************/
+bool isJsonSnapshot(const string& filename)
+{
+    char magic[8]{};
+    ifstream in(filename, ios::binary);
+    in.read(magic, sizeof(magic));
+    return in && memcmp(magic, SPLASH_JSON_SNAPSHOT_MAGIC, sizeof(magic)) == 0;
+}
+
+/*************/
+bool loadJsonFileOrSnapshot(const string& filename, Json::Value& value)
+{
+    if (isJsonSnapshot(filename))
+        return loadJsonSnapshot(filename, value);
+
+    if (loadJsonSnapshot(getJsonSnapshotPath(filename), value, filename))
+        return true;
+
+    return loadJsonFile(filename, value);
+}
+
+} // namespace Utils
+} // namespace Splash
@@ -0,0 +1,92 @@
+/*
+ * Copyright (C) 2026 Emmanuel Durand
+ *
+ * This file is part of Splash.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Splash is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Splash.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * @json_snapshot.h
+ * Binary snapshots of Json trees, to load configurations without parsing text
+ */
+
+#ifndef SPLASH_JSON_SNAPSHOT_H
+#define SPLASH_JSON_SNAPSHOT_H
+
+#include <cstdint>
+#include <string>
+
+#include <json/json.h>
+
+#define SPLASH_JSON_SNAPSHOT_MAGIC "SPLSNAP"
+#define SPLASH_JSON_SNAPSHOT_VERSION 1
+#define SPLASH_JSON_SNAPSHOT_SUFFIX ".snapshot"
+
+namespace Splash
+{
+namespace Utils
+{
+
+/**
+ * Get the path of the snapshot associated to the given Json file
+ * \param filename Json file path
+ * \return Return the snapshot path
+ */
+inline std::string getJsonSnapshotPath(const std::string& filename)
+{
+    return filename + SPLASH_JSON_SNAPSHOT_SUFFIX;
+}
+
+/**
+ * Save a Json tree as a binary snapshot
+ * The snapshot stores the size and modification date of the source file, if any, so that
+ * it is discarded once the source file has been edited. It is written to a temporary file
+ * first, so that a snapshot is never left half written.
+ * \param filename Snapshot file path
+ * \param value Json tree to save
+ * \param source Path of the Json file this snapshot stands for, can be empty
+ * \return Return true if the snapshot was written
+ */
+bool saveJsonSnapshot(const std::string& filename, const Json::Value& value, const std::string& source = "");
+
+/**
+ * Load a binary snapshot into a Json tree
+ * \param filename Snapshot file path
+ * \param value Holds the Json tree
+ * \param source Path of the Json file this snapshot stands for. If not empty, the snapshot is rejected if this file changed since it was saved
+ * \return Return true if the snapshot was valid and up to date
+ */
+bool loadJsonSnapshot(const std::string& filename, Json::Value& value, const std::string& source = "");
+
+/**
+ * Check whether the given file is a binary snapshot
+ * \param filename File path
+ * \return Return true if the file starts with the snapshot magic
+ */
+bool isJsonSnapshot(const std::string& filename);
+
+/**
+ * Load a Json file, from its up to date snapshot if there is one
+ * The given file can also directly be a snapshot.
+ * \param filename Json or snapshot file path
+ * \param value Holds the Json tree
+ * \return Return true if everything went well
+ */
+bool loadJsonFileOrSnapshot(const std::string& filename, Json::Value& value);
+
+} // namespace Utils
+} // namespace Splash
+
+#endif // SPLASH_JSON_SNAPSHOT_H
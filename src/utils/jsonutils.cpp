@@ -1,6 +1,11 @@
 #include "./utils/jsonutils.h"
 
 #include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <limits>
+#include <locale>
+#include <sstream>
 
 namespace Splash
 {
@@ -158,6 +163,487 @@ bool checkAndUpgradeConfiguration(Json::Value& configuration)
     return true;
 }
 
+/*************/
+namespace
+{
+// Single pass parser building Json::Value directly, accepting what the default jsoncpp reader accepts:
+// comments, trailing commas and trailing content after the root value
+class JsonParser
+{
+  public:
+    JsonParser(const char* begin, const char* end)
+        : _begin(begin)
+        , _current(begin)
+        , _end(end)
+    {
+    }
+
+    bool parse(Json::Value& root, std::string& errors)
+    {
+        // Skip the UTF-8 byte order mark
+        if (_end - _current >= 3 && std::equal(_current, _current + 3, "\xEF\xBB\xBF"))
+            _current += 3;
+
+        if (!parseValue(root, 0))
+        {
+            errors = describeError();
+            return false;
+        }
+        return true;
+    }
+
+  private:
+    const char* _begin;
+    const char* _current;
+    const char* _end;
+    const char* _errorPosition{nullptr};
+    std::string _error{};
+
+    static constexpr int _stackLimit{1000};
+
+    bool fail(const std::string& error)
+    {
+        _error = error;
+        _errorPosition = _current;
+        return false;
+    }
+
+    std::string describeError() const
+    {
+        int line = 1;
+        const char* lineStart = _begin;
+        for (auto c = _begin; c < _errorPosition && c < _end; ++c)
+        {
+            if (*c == '\n')
+            {
+                ++line;
+                lineStart = c + 1;
+            }
+        }
+        return "* Line " + std::to_string(line) + ", Column " + std::to_string(_errorPosition - lineStart + 1) + "\n  " + _error + "\n";
+    }
+
+    bool skipSpacesAndComments()
+    {
+        while (_current < _end)
+        {
+            auto c = *_current;
+            if (c == ' ' || c == '\t' || c == '\n' || c == '\r')
+            {
+                ++_current;
+            }
+            else if (c == '/' && _current + 1 < _end && _current[1] == '/')
+            {
+                while (_current < _end && *_current != '\n')
+                    ++_current;
+            }
+            else if (c == '/' && _current + 1 < _end && _current[1] == '*')
+            {
+                auto commentEnd = std::search(_current + 2, _end, "*/", "*/" + 2);
+                if (commentEnd == _end)
+                    return fail("Unterminated comment");
+                _current = commentEnd + 2;
+            }
+            else
+            {
+                break;
+            }
+        }
+        return true;
+    }
+
+    bool matchKeyword(const char* keyword, size_t length)
+    {
+        if (static_cast<size_t>(_end - _current) < length || !std::equal(keyword, keyword + length, _current))
+            return fail("Syntax error: value, object or array expected.");
+        _current += length;
+        return true;
+    }
+
+    bool parseValue(Json::Value& value, int depth)
+    {
+        if (depth > _stackLimit)
+            return fail("Exceeded stackLimit in readValue().");
+
+        if (!skipSpacesAndComments())
+            return false;
+        if (_current == _end)
+            return fail("Syntax error: value, object or array expected.");
+
+        switch (*_current)
+        {
+        case '{':
+            return parseObject(value, depth);
+        case '[':
+            return parseArray(value, depth);
+        case '"':
+        {
+            std::string str;
+            if (!parseString(str))
+                return false;
+            value = Json::Value(str);
+            return true;
+        }
+        case 't':
+            value = Json::Value(true);
+            return matchKeyword("true", 4);
+        case 'f':
+            value = Json::Value(false);
+            return matchKeyword("false", 5);
+        case 'n':
+            value = Json::Value();
+            return matchKeyword("null", 4);
+        default:
+            return parseNumber(value);
+        }
+    }
+
+    bool parseObject(Json::Value& value, int depth)
+    {
+        ++_current;
+        value = Json::Value(Json::objectValue);
+        while (true)
+        {
+            if (!skipSpacesAndComments())
+                return false;
+            if (_current < _end && *_current == '}')
+            {
+                ++_current;
+                return true;
+            }
+            if (_current == _end || *_current != '"')
+                return fail("Missing '}' or object member name");
+
+            std::string name;
+            if (!parseString(name))
+                return false;
+
+            if (!skipSpacesAndComments())
+                return false;
+            if (_current == _end || *_current != ':')
+                return fail("Missing ':' after object member name");
+            ++_current;
+
+            if (!parseValue(value[name], depth + 1))
+                return false;
+
+            if (!skipSpacesAndComments())
+                return false;
+            if (_current < _end && *_current == ',')
+                ++_current;
+            else if (_current < _end && *_current == '}')
+                continue;
+            else
+                return fail("Missing ',' or '}' in object declaration");
+        }
+    }
+
+    bool parseArray(Json::Value& value, int depth)
+    {
+        ++_current;
+        value = Json::Value(Json::arrayValue);
+        while (true)
+        {
+            if (!skipSpacesAndComments())
+                return false;
+            if (_current < _end && *_current == ']')
+            {
+                ++_current;
+                return true;
+            }
+
+            if (!parseValue(value[value.size()], depth + 1))
+                return false;
+
+            if (!skipSpacesAndComments())
+                return false;
+            if (_current < _end && *_current == ',')
+                ++_current;
+            else if (_current < _end && *_current == ']')
+                continue;
+            else
+                return fail("Missing ',' or ']' in array declaration");
+        }
+    }
+
+    bool parseHex(uint32_t& codePoint)
+    {
+        if (_end - _current < 4)
+            return fail("Bad unicode escape sequence in string: four digits expected.");
+
+        codePoint = 0;
+        for (int i = 0; i < 4; ++i)
+        {
+            auto c = *_current++;
+            codePoint <<= 4;
+            if (c >= '0' && c <= '9')
+                codePoint += c - '0';
+            else if (c >= 'a' && c <= 'f')
+                codePoint += c - 'a' + 10;
+            else if (c >= 'A' && c <= 'F')
+                codePoint += c - 'A' + 10;
+            else
+                return fail("Bad unicode escape sequence in string: hexadecimal digit expected.");
+        }
+        return true;
+    }
+
+    static void appendUtf8(std::string& str, uint32_t codePoint)
+    {
+        if (codePoint < 0x80)
+        {
+            str += static_cast<char>(codePoint);
+        }
+        else if (codePoint < 0x800)
+        {
+            str += static_cast<char>(0xC0 | (codePoint >> 6));
+            str += static_cast<char>(0x80 | (codePoint & 0x3F));
+        }
+        else if (codePoint < 0x10000)
+        {
+            str += static_cast<char>(0xE0 | (codePoint >> 12));
+            str += static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F));
+            str += static_cast<char>(0x80 | (codePoint & 0x3F));
+        }
+        else
+        {
+            str += static_cast<char>(0xF0 | (codePoint >> 18));
+            str += static_cast<char>(0x80 | ((codePoint >> 12) & 0x3F));
+            str += static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F));
+            str += static_cast<char>(0x80 | (codePoint & 0x3F));
+        }
+    }
+
+    bool parseString(std::string& str)
+    {
+        ++_current;
+        while (true)
+        {
+            // Copy the characters up to the next quote or escape sequence at once
+            auto chunkEnd = _current;
+            while (chunkEnd < _end && *chunkEnd != '"' && *chunkEnd != '\\')
+                ++chunkEnd;
+            str.append(_current, chunkEnd);
+            _current = chunkEnd;
+
+            if (_current == _end)
+                return fail("Missing '\"' at the end of the string");
+
+            if (*_current++ == '"')
+                return true;
+
+            if (_current == _end)
+                return fail("Empty escape sequence in string");
+
+            auto escaped = *_current++;
+            switch (escaped)
+            {
+            case '"':
+            case '/':
+            case '\\':
+                str += escaped;
+                break;
+            case 'b':
+                str += '\b';
+                break;
+            case 'f':
+                str += '\f';
+                break;
+            case 'n':
+                str += '\n';
+                break;
+            case 'r':
+                str += '\r';
+                break;
+            case 't':
+                str += '\t';
+                break;
+            case 'u':
+            {
+                uint32_t codePoint = 0;
+                if (!parseHex(codePoint))
+                    return false;
+
+                // Surrogate pairs are combined into a single code point
+                if (codePoint >= 0xD800 && codePoint <= 0xDBFF)
+                {
+                    uint32_t lowSurrogate = 0;
+                    if (_end - _current < 2 || _current[0] != '\\' || _current[1] != 'u')
+                        return fail("additional six characters expected to parse unicode surrogate pair.");
+                    _current += 2;
+                    if (!parseHex(lowSurrogate))
+                        return false;
+                    if (lowSurrogate < 0xDC00 || lowSurrogate > 0xDFFF)
+                        return fail("expecting another \\u token to begin the second half of a unicode surrogate pair");
+                    codePoint = 0x10000 + ((codePoint & 0x3FF) << 10) + (lowSurrogate & 0x3FF);
+                }
+
+                appendUtf8(str, codePoint);
+                break;
+            }
+            default:
+                return fail("Bad escape sequence in string");
+            }
+        }
+    }
+
+    /**
+     * Check whether a number which does not fit in a double is too small, rather than too large
+     * \param start Start of the number
+     * \param end End of the number
+     * \return Return true if the magnitude of the number is below 1
+     */
+    static bool isTooSmall(const char* start, const char* end)
+    {
+        const auto isDigit = [&](const char* position) { return position < end && *position >= '0' && *position <= '9'; };
+
+        // Power of ten of the first significant digit
+        auto position = start;
+        if (position < end && *position == '-')
+            ++position;
+        int64_t magnitude = 0;
+        bool significant = false;
+        for (; isDigit(position); ++position)
+        {
+            if (significant)
+                ++magnitude;
+            else
+                significant = *position != '0';
+        }
+        if (position < end && *position == '.')
+        {
+            for (++position; isDigit(position); ++position)
+            {
+                if (significant)
+                    continue;
+                --magnitude;
+                significant = *position != '0';
+            }
+        }
+
+        int64_t exponent = 0;
+        bool negativeExponent = false;
+        if (position < end && (*position == 'e' || *position == 'E'))
+        {
+            ++position;
+            if (position < end && (*position == '+' || *position == '-'))
+                negativeExponent = *position++ == '-';
+            for (; isDigit(position); ++position)
+                exponent = std::min<int64_t>(exponent * 10 + (*position - '0'), std::numeric_limits<int32_t>::max());
+        }
+
+        return magnitude + (negativeExponent ? -exponent : exponent) < 0;
+    }
+
+    bool parseNumber(Json::Value& value)
+    {
+        auto start = _current;
+        auto position = _current;
+        if (position < _end && *position == '-')
+            ++position;
+
+        bool isInteger = true;
+        uint64_t integer = 0;
+        bool overflow = false;
+        auto digitsStart = position;
+        while (position < _end && *position >= '0' && *position <= '9')
+        {
+            auto digit = static_cast<uint64_t>(*position - '0');
+            if (integer > (std::numeric_limits<uint64_t>::max() - digit) / 10)
+                overflow = true;
+            integer = integer * 10 + digit;
+            ++position;
+        }
+        if (position == digitsStart)
+            return fail("Syntax error: value, object or array expected.");
+
+        if (position < _end && *position == '.')
+        {
+            isInteger = false;
+            ++position;
+            while (position < _end && *position >= '0' && *position <= '9')
+                ++position;
+        }
+        if (position < _end && (*position == 'e' || *position == 'E'))
+        {
+            isInteger = false;
+            ++position;
+            if (position < _end && (*position == '+' || *position == '-'))
+                ++position;
+            while (position < _end && *position >= '0' && *position <= '9')
+                ++position;
+        }
+        _current = position;
+
+        // Integers are typed as the default jsoncpp reader does, falling back to doubles if they do not fit
+        bool isNegative = *start == '-';
+        if (isInteger && !overflow)
+        {
+            const auto maxIntegerValue = isNegative ? static_cast<uint64_t>(Json::Value::maxLargestInt) + 1 : Json::Value::maxLargestUInt;
+            if (integer <= maxIntegerValue)
+            {
+                if (isNegative && integer == maxIntegerValue)
+                    value = Json::Value(Json::Value::minLargestInt);
+                else if (isNegative)
+                    value = Json::Value(-static_cast<Json::LargestInt>(integer));
+                else if (integer <= static_cast<uint64_t>(Json::Value::maxLargestInt))
+                    value = Json::Value(static_cast<Json::LargestInt>(integer));
+                else
+                    value = Json::Value(static_cast<Json::LargestUInt>(integer));
+                return true;
+            }
+        }
+
+        double number = 0.0;
+#if defined(__cpp_lib_to_chars) && __cpp_lib_to_chars >= 201611L
+        auto result = std::from_chars(start, position, number);
+        if (result.ec == std::errc::result_out_of_range && result.ptr == position)
+        {
+            // As with the default jsoncpp reader, numbers too small for a double are read as 0 and numbers too large as infinity
+            number = isTooSmall(start, position) ? 0.0 : std::numeric_limits<double>::infinity();
+            if (isNegative)
+                number = -number;
+        }
+        else if (result.ec != std::errc() || result.ptr != position)
+        {
+            _current = start;
+            return fail("'" + std::string(start, position) + "' is not a number.");
+        }
+#else
+        std::istringstream stream(std::string(start, position));
+        stream.imbue(std::locale::classic());
+        if (!(stream >> number))
+        {
+            // Same handling of the numbers too large for a double as the default jsoncpp reader
+            if (number == std::numeric_limits<double>::max())
+                number = std::numeric_limits<double>::infinity();
+            else if (number == std::numeric_limits<double>::lowest())
+                number = -std::numeric_limits<double>::infinity();
+            else
+            {
+                _current = start;
+                return fail("'" + std::string(start, position) + "' is not a number.");
+            }
+        }
+#endif
+        value = Json::Value(number);
+        return true;
+    }
+};
+} // namespace
+
+/*************/
+bool parseJson(const char* begin, const char* end, Json::Value& value, std::string& errors)
+{
+    Json::Value root;
+    JsonParser parser(begin, end);
+    if (!parser.parse(root, errors))
+        return false;
+
+    value = std::move(root);
+    return true;
+}
+
 /*************/
 bool loadJsonFile(const std::string& filename, Json::Value& configuration)
 {
@@ -178,11 +664,9 @@ bool loadJsonFile(const std::string& filename, Json::Value& configuration)
     }
 
     Json::Value config;
-    Json::CharReaderBuilder builder;
-    std::unique_ptr<Json::CharReader> const reader(builder.newCharReader());
     std::string errs;
 
-    bool success = reader->parse(contents.c_str(), contents.c_str() + contents.size(), &config, &errs);
+    bool success = parseJson(contents.c_str(), contents.c_str() + contents.size(), config, errs);
     if (!success)
     {
         Log::get() << Log::WARNING << __FUNCTION__ << " - Unable to parse file " << filename << Log::endl;
@@ -190,7 +674,7 @@ bool loadJsonFile(const std::string& filename, Json::Value& configuration)
         return false;
     }
 
-    configuration = config;
+    configuration = std::move(config);
     return true;
 }
 
@@ -221,25 +705,23 @@ Values jsonToValues(const Json::Value& values)
     }
     else if (values.isObject())
     {
-        auto names = values.getMemberNames();
-        int index = 0;
-        for (const auto& v : values)
+        for (auto it = values.begin(); it != values.end(); ++it)
         {
+            const auto& v = *it;
+            const auto name = it.name();
             if (v.isBool())
-                outValues.emplace_back(v.asBool(), names[index]);
+                outValues.emplace_back(v.asBool(), name);
             else if (v.isInt())
-                outValues.emplace_back(v.asInt(), names[index]);
+                outValues.emplace_back(v.asInt(), name);
             else if (v.isDouble())
-                outValues.emplace_back(v.asFloat(), names[index]);
+                outValues.emplace_back(v.asFloat(), name);
             else if (v.isArray() || v.isObject())
-                outValues.emplace_back(jsonToValues(v), names[index]);
+                outValues.emplace_back(jsonToValues(v), name);
             else
             {
                 outValues.emplace_back(v.asString());
-                outValues.back().setName(names[index]);
+                outValues.back().setName(name);
             }
-
-            ++index;
         }
     }
     else
@@ -248,5 +730,43 @@ Values jsonToValues(const Json::Value& values)
     return outValues;
 }
 
+/*************/
+bool isJsonEquivalent(const Json::Value& lhs, const Json::Value& rhs, double epsilon)
+{
+    if (lhs.isArray() && !rhs.isArray() && lhs.size() == 1)
+        return isJsonEquivalent(lhs[0], rhs, epsilon);
+    if (rhs.isArray() && !lhs.isArray() && rhs.size() == 1)
+        return isJsonEquivalent(lhs, rhs[0], epsilon);
+
+    if (lhs.isNumeric() && rhs.isNumeric() && !lhs.isBool() && !rhs.isBool())
+    {
+        auto a = lhs.asDouble();
+        auto b = rhs.asDouble();
+        return std::abs(a - b) <= epsilon * std::max(1.0, std::max(std::abs(a), std::abs(b)));
+    }
+
+    if (lhs.isArray() && rhs.isArray())
+    {
+        if (lhs.size() != rhs.size())
+            return false;
+        for (Json::ArrayIndex i = 0; i < lhs.size(); ++i)
+            if (!isJsonEquivalent(lhs[i], rhs[i], epsilon))
+                return false;
+        return true;
+    }
+
+    if (lhs.isObject() && rhs.isObject())
+    {
+        if (lhs.getMemberNames() != rhs.getMemberNames())
+            return false;
+        for (const auto& name : lhs.getMemberNames())
+            if (!isJsonEquivalent(lhs[name], rhs[name], epsilon))
+                return false;
+        return true;
+    }
+
+    return lhs == rhs;
+}
+
 } // namespace Utils
 } // namespace Splash
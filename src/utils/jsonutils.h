@@ -48,6 +48,18 @@ namespace Utils
  */
 bool checkAndUpgradeConfiguration(Json::Value& configuration);
 
+/**
+ * Parse a Json document
+ * This accepts the same documents as the default jsoncpp reader, comments and trailing commas included,
+ * but parses them in a single pass and converts the numbers without going through streams
+ * \param begin Beginning of the document
+ * \param end End of the document
+ * \param value Holds the Json tree
+ * \param errors Set to the description of the error, if any
+ * \return Return true if the document was parsed successfully
+ */
+bool parseJson(const char* begin, const char* end, Json::Value& value, std::string& errors);
+
 /**
  * Load a Json file
  * \param filename Json file path
@@ -63,6 +75,17 @@ bool loadJsonFile(const std::string& filename, Json::Value& configuration);
  */
 Values jsonToValues(const Json::Value& values);
 
+/**
+ * Check whether two Json values describe the same attribute value
+ * Numbers are compared with a relative tolerance, as attributes are stored as floats, and a single value
+ * is considered equivalent to an array holding only this value
+ * \param lhs First value
+ * \param rhs Second value
+ * \param epsilon Relative tolerance for numbers
+ * \return Return true if the values are equivalent
+ */
+bool isJsonEquivalent(const Json::Value& lhs, const Json::Value& rhs, double epsilon = 1e-5);
+
 } // end of namespace
 } // end of namespace
 
@@ -0,0 +1,139 @@
+/*
+ * Copyright (C) 2026 Emmanuel Durand
+ *
+ * This file is part of Splash.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Splash is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Splash.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * @kdtree.h
+ * Static k-d tree over 3D points, for nearest neighbour queries
+ */
+
+#ifndef SPLASH_KDTREE_H
+#define SPLASH_KDTREE_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+namespace Splash
+{
+
+/*************/
+//! Balanced k-d tree, stored implicitly: the points are reordered so that the median of each range
+//! along the split axis of its depth sits in the middle of the range, with the lower half before it.
+//! Building is O(n log n), queries are O(log n) on average. The tree can not be modified once built.
+class KdTree
+{
+  public:
+    /**
+     * Constructor
+     * \param points Points to index
+     */
+    explicit KdTree(std::vector<glm::vec3> points = {})
+        : _points(std::move(points))
+    {
+        build(0, _points.size(), 0);
+    }
+
+    /**
+     * Get the number of indexed points
+     * \return Return the point count
+     */
+    size_t size() const { return _points.size(); }
+
+    /**
+     * Find the indexed point nearest to the given one
+     * \param point Query point
+     * \param nearest Nearest point
+     * \param distance Distance to the nearest point
+     * \return Return false if the tree is empty
+     */
+    bool findNearest(const glm::vec3& point, glm::vec3& nearest, float& distance) const
+    {
+        if (_points.empty())
+            return false;
+
+        size_t nearestIndex = 0;
+        float squaredDistance = std::numeric_limits<float>::max();
+        search(point, 0, _points.size(), 0, nearestIndex, squaredDistance);
+
+        nearest = _points[nearestIndex];
+        distance = std::sqrt(squaredDistance);
+        return true;
+    }
+
+  private:
+    std::vector<glm::vec3> _points{};
+
+    void build(size_t begin, size_t end, uint32_t depth)
+    {
+        // Ranges are split iteratively on their upper half, recursively on their lower one
+        while (end - begin > 1)
+        {
+            const auto axis = depth % 3;
+            const auto middle = begin + (end - begin) / 2;
+            std::nth_element(_points.begin() + begin, _points.begin() + middle, _points.begin() + end, [axis](const glm::vec3& lhs, const glm::vec3& rhs) {
+                return lhs[axis] < rhs[axis];
+            });
+
+            build(begin, middle, depth + 1);
+            begin = middle + 1;
+            ++depth;
+        }
+    }
+
+    void search(const glm::vec3& point, size_t begin, size_t end, uint32_t depth, size_t& nearestIndex, float& squaredDistance) const
+    {
+        if (begin >= end)
+            return;
+
+        const auto axis = depth % 3;
+        const auto middle = begin + (end - begin) / 2;
+        const auto& median = _points[middle];
+
+        const auto offset = point - median;
+        const auto medianDistance = glm::dot(offset, offset);
+        if (medianDistance < squaredDistance)
+        {
+            squaredDistance = medianDistance;
+            nearestIndex = middle;
+        }
+
+        // The side of the query point is searched first, the other one only if it can hold a nearer point
+        const auto axisOffset = point[axis] - median[axis];
+        if (axisOffset < 0.f)
+        {
+            search(point, begin, middle, depth + 1, nearestIndex, squaredDistance);
+            if (axisOffset * axisOffset < squaredDistance)
+                search(point, middle + 1, end, depth + 1, nearestIndex, squaredDistance);
+        }
+        else
+        {
+            search(point, middle + 1, end, depth + 1, nearestIndex, squaredDistance);
+            if (axisOffset * axisOffset < squaredDistance)
+                search(point, begin, middle, depth + 1, nearestIndex, squaredDistance);
+        }
+    }
+};
+
+} // namespace Splash
+
+#endif // SPLASH_KDTREE_H
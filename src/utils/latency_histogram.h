@@ -0,0 +1,150 @@
+/*
+ * Copyright (C) 2026 Emmanuel Durand
+ *
+ * This file is part of Splash.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Splash is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Splash.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * @latency_histogram.h
+ * Compact histogram of latencies, for percentile estimation
+ */
+
+#ifndef SPLASH_LATENCY_HISTOGRAM_H
+#define SPLASH_LATENCY_HISTOGRAM_H
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+
+namespace Splash
+{
+
+/*************/
+//! Histogram of latencies with logarithmic buckets, eight per octave, giving
+//! percentiles with a relative error below 12.5%. Once the window size is reached
+//! all buckets are halved, so that old samples fade out instead of being dropped at once.
+class LatencyHistogram
+{
+  public:
+    /**
+     * Constructor
+     * \param windowSize Number of samples after which the bucket counts are halved
+     */
+    explicit LatencyHistogram(uint64_t windowSize = 1024)
+        : _windowSize(std::max<uint64_t>(windowSize, 2))
+    {
+    }
+
+    /**
+     * Add a sample
+     * \param latency Latency in us, negative values being counted as null
+     */
+    void add(int64_t latency)
+    {
+        ++_buckets[getBucketIndex(latency)];
+        if (++_count < _windowSize)
+            return;
+
+        _count = 0;
+        for (auto& bucket : _buckets)
+        {
+            bucket /= 2;
+            _count += bucket;
+        }
+    }
+
+    /**
+     * Get the given percentile of the current samples
+     * \param percentile Percentile, between 0 and 100
+     * \return Return the upper bound of the bucket holding the percentile in us, or 0 if there is no sample
+     */
+    int64_t getPercentile(double percentile) const
+    {
+        if (_count == 0)
+            return 0;
+
+        auto rank = std::max<uint64_t>(1, static_cast<uint64_t>(std::ceil(std::clamp(percentile, 0.0, 100.0) / 100.0 * _count)));
+        uint64_t cumulated = 0;
+        for (size_t index = 0; index < _bucketCount; ++index)
+        {
+            cumulated += _buckets[index];
+            if (cumulated >= rank)
+                return getBucketUpperBound(index);
+        }
+
+        return getBucketUpperBound(_bucketCount - 1);
+    }
+
+    /**
+     * Get the number of samples currently held
+     * \return Return the sample count
+     */
+    uint64_t getCount() const { return _count; }
+
+    /**
+     * Drop all samples
+     */
+    void reset()
+    {
+        _buckets.fill(0);
+        _count = 0;
+    }
+
+  private:
+    static constexpr int _subBucketBits{3};
+    static constexpr int64_t _subBucketCount{1 << _subBucketBits};
+    static constexpr size_t _bucketCount{(63 - _subBucketBits + 1) * _subBucketCount};
+
+    uint64_t _windowSize;
+    uint64_t _count{0};
+    std::array<uint64_t, _bucketCount> _buckets{};
+
+    /**
+     * Get the bucket holding the given value
+     * \param value Value
+     * \return Return the bucket index
+     */
+    static size_t getBucketIndex(int64_t value)
+    {
+        if (value < _subBucketCount)
+            return static_cast<size_t>(std::max<int64_t>(value, 0));
+
+        auto octave = 63 - __builtin_clzll(static_cast<uint64_t>(value));
+        auto subBucket = (value >> (octave - _subBucketBits)) & (_subBucketCount - 1);
+        return static_cast<size_t>((octave - _subBucketBits + 1) * _subBucketCount + subBucket);
+    }
+
+    /**
+     * Get the highest value held by the given bucket
+     * \param index Bucket index
+     * \return Return the upper bound
+     */
+    static int64_t getBucketUpperBound(size_t index)
+    {
+        if (index < static_cast<size_t>(_subBucketCount))
+            return static_cast<int64_t>(index);
+
+        auto octave = static_cast<int>(index / _subBucketCount) + _subBucketBits - 1;
+        auto subBucket = static_cast<int64_t>(index % _subBucketCount);
+        auto width = int64_t(1) << (octave - _subBucketBits);
+        return (_subBucketCount + subBucket) * width + width - 1;
+    }
+};
+
+} // namespace Splash
+
+#endif // SPLASH_LATENCY_HISTOGRAM_H
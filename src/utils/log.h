@@ -25,7 +25,9 @@
 #ifndef SPLASH_LOG_H
 #define SPLASH_LOG_H
 
+#include <atomic>
 #include <chrono>
+#include <cstdlib>
 #include <ctime>
 #include <deque>
 #include <fstream>
@@ -33,6 +35,7 @@
 #include <iostream>
 #include <mutex>
 #include <string>
+#include <thread>
 #include <tuple>
 #include <utility>
 #include <vector>
@@ -41,13 +44,21 @@
 
 #include "./core/spinlock.h"
 #include "./core/value.h"
+#include "./utils/mpsc_ring.h"
 
 #define SPLASH_LOG_FILE "/var/log/splash.log"
+#define SPLASH_LOG_RING_SIZE 1024
+#define SPLASH_LOG_DISPATCH_PERIOD_MS 5
+#define SPLASH_LOG_REPEAT_REPORT_PERIOD_MS 1000
 
 namespace Splash
 {
 
 /*************/
+//! Logs are composed and queued by the calling thread without locking, and dispatched
+//! to the console, the log file and the log history by a background thread.
+//! Consecutive repetitions of a message by a thread are reported at most once per second,
+//! and messages are dropped and counted if the queue is full.
 class Log
 {
   public:
@@ -82,8 +93,10 @@ class Log
     template <typename... T>
     void operator()(Priority p, T... args)
     {
-        std::lock_guard<Spinlock> lock(_mutex);
-        rec(p, args...);
+        Record record;
+        record.priority = p;
+        addToString(record.message, args...);
+        queue(record);
     }
 
     /**
@@ -94,8 +107,7 @@ class Log
     template <typename T>
     Log& operator<<(const T& msg)
     {
-        std::lock_guard<Spinlock> lock(_mutex);
-        addToString(_tempString, msg);
+        addToString(getThreadRecords().composed.message, msg);
         return *this;
     }
 
@@ -106,8 +118,7 @@ class Log
      */
     Log& operator<<(const Value& v)
     {
-        std::lock_guard<Spinlock> lock(_mutex);
-        addToString(_tempString, v.as<std::string>());
+        addToString(getThreadRecords().composed.message, v.as<std::string>());
         return *this;
     }
 
@@ -118,13 +129,12 @@ class Log
      */
     Log& operator<<(Log::Action action)
     {
-        std::lock_guard<Spinlock> lock(_mutex);
         if (action == endl)
         {
-            if (_tempPriority >= _verbosity)
-                rec(_tempPriority, _tempString);
-            _tempString.clear();
-            _tempPriority = MESSAGE;
+            if (getThreadRecords().composed.priority >= _verbosity)
+                queue(getThreadRecords().composed);
+            getThreadRecords().composed.message.clear();
+            getThreadRecords().composed.priority = MESSAGE;
         }
         return *this;
     }
@@ -136,16 +146,24 @@ class Log
      */
     Log& operator<<(Log::Priority p)
     {
-        std::lock_guard<Spinlock> lock(_mutex);
-        _tempPriority = p;
+        getThreadRecords().composed.priority = p;
         return *this;
     }
 
+    /**
+     * \brief Dispatch the queued messages right away, from the calling thread
+     */
+    void flush() { dispatch(); }
+
     /**
      * \brief Get the full logs
      * \return Return the full logs
      */
-    std::deque<std::tuple<uint64_t, std::string, Priority>> getFullLogs() { return _logs; }
+    std::deque<std::tuple<uint64_t, std::string, Priority>> getFullLogs()
+    {
+        std::lock_guard<Spinlock> lock(_mutex);
+        return _logs;
+    }
 
     /**
      * \brief Get the logs by priority
@@ -215,11 +233,35 @@ class Log
         }
     }
 
+  private:
+    struct Record
+    {
+        std::chrono::system_clock::time_point timestamp{};
+        Priority priority{MESSAGE};
+        std::string message{};
+    };
+
   private:
     /**
-     * \brief Constructor
+     * \brief Constructor, starts the dispatching thread
      */
-    Log() {}
+    Log()
+    {
+        std::thread([this]() {
+            while (!_stopDispatching)
+            {
+                dispatch();
+                std::this_thread::sleep_for(std::chrono::milliseconds(SPLASH_LOG_DISPATCH_PERIOD_MS));
+            }
+        }).detach();
+
+        // Make sure queued messages are output before exiting
+        std::atexit([]() {
+            auto& log = Log::get();
+            log._stopDispatching = true;
+            log.dispatch();
+        });
+    }
 
     /**
      * \brief Destructor
@@ -240,8 +282,96 @@ class Log
     int _logPointer{0};
     Priority _verbosity{MESSAGE};
 
-    std::string _tempString;
-    Priority _tempPriority{MESSAGE};
+    MpscRing<Record> _records{SPLASH_LOG_RING_SIZE}; //!< Messages waiting to be dispatched
+    std::atomic_uint64_t _droppedRecords{0};
+    std::atomic_bool _stopDispatching{false};
+
+    std::mutex _dispatchMutex{}; //!< Only one thread at a time may dispatch, as the ring has a single consumer
+    Record _dispatchedRecord{};
+
+    //! Per thread logging state
+    struct ThreadRecords
+    {
+        Record composed{};       //!< Message being composed
+        Record last{};           //!< Last message queued
+        uint64_t repeatCount{0}; //!< Number of repetitions of the last message not reported yet
+    };
+
+    /**
+     * \brief Get the logging state of the calling thread
+     * \return Return the state
+     */
+    static ThreadRecords& getThreadRecords()
+    {
+        static thread_local ThreadRecords records;
+        return records;
+    }
+
+    /**
+     * \brief Queue a message, never blocks.
+     * Consecutive repetitions of a message by a thread are counted and reported
+     * at most once per period, so that warning storms do not fill the queue.
+     * \param record Message to queue, its timestamp is set to the current time
+     */
+    void queue(Record& record)
+    {
+        auto& records = getThreadRecords();
+        record.timestamp = std::chrono::system_clock::now();
+
+        if (record.priority == records.last.priority && record.message == records.last.message)
+        {
+            ++records.repeatCount;
+            if (record.timestamp - records.last.timestamp > std::chrono::milliseconds(SPLASH_LOG_REPEAT_REPORT_PERIOD_MS))
+                queueRepetitions(records, record.timestamp);
+            return;
+        }
+
+        if (records.repeatCount > 0)
+            queueRepetitions(records, record.timestamp);
+
+        if (!_records.push(record))
+            ++_droppedRecords;
+        records.last = record;
+    }
+
+    /**
+     * \brief Queue the report of the repetitions of the last message of a thread
+     * \param records Thread logging state
+     * \param timestamp Report timestamp
+     */
+    void queueRepetitions(ThreadRecords& records, std::chrono::system_clock::time_point timestamp)
+    {
+        Record report;
+        report.timestamp = timestamp;
+        report.priority = records.last.priority;
+        report.message = "Last message repeated " + std::to_string(records.repeatCount) + " times: " + records.last.message;
+        if (!_records.push(report))
+            ++_droppedRecords;
+
+        records.repeatCount = 0;
+        records.last.timestamp = timestamp;
+    }
+
+    /**
+     * \brief Output all queued messages
+     */
+    void dispatch()
+    {
+        std::lock_guard<std::mutex> lockDispatch(_dispatchMutex);
+        std::ofstream logFile;
+
+        while (_records.pop(_dispatchedRecord))
+            rec(_dispatchedRecord, logFile);
+
+        if (auto dropped = _droppedRecords.exchange(0); dropped > 0)
+        {
+            Record record;
+            record.timestamp = std::chrono::system_clock::now();
+            record.priority = WARNING;
+            record.message = "Log::" + std::string(__FUNCTION__) + " - " + std::to_string(dropped) + " messages were dropped as they were logged too fast";
+            rec(record, logFile);
+        }
+    }
 
     /*****/
     template <typename T, typename... Ts>
@@ -268,32 +398,28 @@ class Log
     void addToString(std::string&) const { return; }
 
     /**
-     * \brief Set a new log message
+     * \brief Output a message to the log file, the console and the log history
+     * \param record Message
+     * \param logFile Log file, opened when first needed
      */
-    template <typename... T>
-    void rec(Priority p, T... args)
+    void rec(const Record& record, std::ofstream& logFile)
     {
-        std::chrono::system_clock::time_point now = std::chrono::system_clock::now();
-        std::string message("");
-        addToString(message, args...);
-
         // Write to log file, if we may
         if (_logToFile)
         {
-            std::ofstream logFile(SPLASH_LOG_FILE, std::ostream::out | std::ostream::app);
+            if (!logFile.is_open())
+                logFile.open(SPLASH_LOG_FILE, std::ostream::out | std::ostream::app);
             if (logFile.good())
-            {
-                logFile << formatMessage(now, message, p) << "\n";
-                logFile.close();
-            }
+                logFile << formatMessage(record.timestamp, record.message, record.priority) << "\n";
         }
 
         // Write to console
-        if (p >= _verbosity)
-            toConsole(formatMessage(now, message, p));
+        if (record.priority >= _verbosity)
+            toConsole(formatMessage(record.timestamp, record.message, record.priority));
 
-        uint64_t timeAsUsecs = std::chrono::duration_cast<std::chrono::milliseconds>(now.time_since_epoch()).count();
-        _logs.push_back(std::make_tuple(timeAsUsecs, message, p));
+        uint64_t timeAsUsecs = std::chrono::duration_cast<std::chrono::milliseconds>(record.timestamp.time_since_epoch()).count();
+        std::lock_guard<Spinlock> lock(_mutex);
+        _logs.push_back(std::make_tuple(timeAsUsecs, record.message, record.priority));
         if (_logs.size() > _logLength)
         {
             _logPointer = _logPointer > 0 ? _logPointer - 1 : _logPointer;
@@ -0,0 +1,172 @@
+/*
+ * Copyright (C) 2026 Emmanuel Durand
+ *
+ * This file is part of Splash.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Splash is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Splash.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * @mesh_delta.h
+ * Decoding of the delta frames of meshes received through shared memory, holding only the vertices which changed
+ */
+
+#ifndef SPLASH_MESH_DELTA_H
+#define SPLASH_MESH_DELTA_H
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <glm/glm.hpp>
+#include <vector>
+
+// Value of the first integer of a delta frame, full frames starting with their vertex count
+#define SPLASH_MESH_DELTA_MARKER -1
+// Flag set when the vertices of a delta frame are quantized
+#define SPLASH_MESH_DELTA_QUANTIZED 0x1
+
+namespace Splash
+{
+namespace MeshDelta
+{
+
+// A delta frame is laid out as follows, all values being 32 bits unless stated otherwise:
+// - the marker, the vertex count of the mesh it applies to, the flags and the range count
+// - if quantized, the bounding box of the positions as min x, y, z then max x, y, z floats
+// - for each range, the first vertex and the vertex count, followed by the vertices
+// Vertices are given as x, y, z, u, v, nx, ny, nz floats. Quantized vertices are given as 16 bits
+// unsigned positions in the bounding box, 16 bits signed normals, then u, v floats.
+
+//! Range of consecutive vertices changed by a delta frame
+struct Range
+{
+    uint32_t first{0};
+    uint32_t count{0};
+};
+
+/**
+ * Check whether a frame is a delta frame
+ * \param data Frame data
+ * \param size Frame size
+ * \return Return true if the frame is a delta frame
+ */
+inline bool isDelta(const uint8_t* data, size_t size)
+{
+    int32_t marker = 0;
+    if (size < sizeof(marker))
+        return false;
+    memcpy(&marker, data, sizeof(marker));
+    return marker == SPLASH_MESH_DELTA_MARKER;
+}
+
+/**
+ * Apply a delta frame to the vertices of a mesh. Nothing is modified if the frame is malformed or does not match the mesh
+ * \param data Frame data
+ * \param size Frame size
+ * \param vertices Vertex positions
+ * \param uvs Vertex texture coordinates
+ * \param normals Vertex normals
+ * \param ranges Set to the ranges of vertices changed by the frame
+ * \return Return true if the frame has been applied
+ */
+inline bool apply(const uint8_t* data, size_t size, std::vector<glm::vec4>& vertices, std::vector<glm::vec2>& uvs, std::vector<glm::vec3>& normals, std::vector<Range>& ranges)
+{
+    ranges.clear();
+
+    int32_t header[4];
+    if (size < sizeof(header))
+        return false;
+    memcpy(header, data, sizeof(header));
+
+    const auto vertexCount = header[1];
+    const auto quantized = (header[2] & SPLASH_MESH_DELTA_QUANTIZED) != 0;
+    const auto rangeCount = header[3];
+    if (header[0] != SPLASH_MESH_DELTA_MARKER || vertexCount < 0 || rangeCount < 0 || static_cast<size_t>(vertexCount) != vertices.size() ||
+        uvs.size() != vertices.size() || normals.size() != vertices.size())
+        return false;
+
+    size_t offset = sizeof(header);
+    float box[6] = {0.f, 0.f, 0.f, 0.f, 0.f, 0.f};
+    if (quantized)
+    {
+        if (size < offset + sizeof(box))
+            return false;
+        memcpy(box, data + offset, sizeof(box));
+        offset += sizeof(box);
+    }
+
+    const size_t vertexSize = quantized ? 6 * sizeof(uint16_t) + 2 * sizeof(float) : 8 * sizeof(float);
+
+    // The whole frame is checked before modifying anything
+    const auto rangesOffset = offset;
+    for (int32_t r = 0; r < rangeCount; ++r)
+    {
+        int32_t range[2];
+        if (size < offset + sizeof(range))
+            return false;
+        memcpy(range, data + offset, sizeof(range));
+        offset += sizeof(range);
+
+        if (range[0] < 0 || range[1] < 0 || static_cast<int64_t>(range[0]) + range[1] > vertexCount || size < offset + range[1] * vertexSize)
+            return false;
+        offset += range[1] * vertexSize;
+    }
+
+    offset = rangesOffset;
+    ranges.reserve(rangeCount);
+    for (int32_t r = 0; r < rangeCount; ++r)
+    {
+        int32_t range[2];
+        memcpy(range, data + offset, sizeof(range));
+        offset += sizeof(range);
+        ranges.push_back({static_cast<uint32_t>(range[0]), static_cast<uint32_t>(range[1])});
+
+        for (int32_t v = range[0]; v < range[0] + range[1]; ++v)
+        {
+            if (quantized)
+            {
+                uint16_t position[3];
+                int16_t normal[3];
+                float uv[2];
+                memcpy(position, data + offset, sizeof(position));
+                memcpy(normal, data + offset + sizeof(position), sizeof(normal));
+                memcpy(uv, data + offset + sizeof(position) + sizeof(normal), sizeof(uv));
+
+                for (int c = 0; c < 3; ++c)
+                {
+                    vertices[v][c] = box[c] + (box[c + 3] - box[c]) * static_cast<float>(position[c]) / 65535.f;
+                    normals[v][c] = std::max(static_cast<float>(normal[c]) / 32767.f, -1.f);
+                }
+                vertices[v][3] = 1.f;
+                uvs[v] = glm::vec2(uv[0], uv[1]);
+            }
+            else
+            {
+                float values[8];
+                memcpy(values, data + offset, sizeof(values));
+                vertices[v] = glm::vec4(values[0], values[1], values[2], 1.f);
+                uvs[v] = glm::vec2(values[3], values[4]);
+                normals[v] = glm::vec3(values[5], values[6], values[7]);
+            }
+            offset += vertexSize;
+        }
+    }
+
+    return true;
+}
+
+} // namespace MeshDelta
+} // namespace Splash
+
+#endif // SPLASH_MESH_DELTA_H
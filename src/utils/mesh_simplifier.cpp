@@ -0,0 +1,107 @@
+#include "./utils/mesh_simplifier.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <unordered_map>
+
+#include <glm/glm.hpp>
+
+using namespace std;
+
+namespace Splash
+{
+namespace MeshSimplifier
+{
+
+/*************/
+float getMeanEdgeLength(const vector<float>& vertices)
+{
+    const auto triangleCount = vertices.size() / 12;
+    if (triangleCount == 0)
+        return 0.f;
+
+    double length = 0.0;
+    for (size_t triangle = 0; triangle < triangleCount; ++triangle)
+    {
+        const auto* coords = vertices.data() + triangle * 12;
+        glm::vec3 a(coords[0], coords[1], coords[2]);
+        glm::vec3 b(coords[4], coords[5], coords[6]);
+        glm::vec3 c(coords[8], coords[9], coords[10]);
+        length += glm::length(b - a) + glm::length(c - b) + glm::length(a - c);
+    }
+
+    return static_cast<float>(length / (triangleCount * 3));
+}
+
+/*************/
+Arrays simplify(const Arrays& mesh, float cellSize)
+{
+    const auto vertexCount = mesh.vertices.size() / 4 / 3 * 3;
+    if (vertexCount == 0 || !(cellSize > 0.f))
+        return mesh;
+
+    glm::vec3 origin(numeric_limits<float>::max());
+    glm::vec3 extent(numeric_limits<float>::lowest());
+    for (size_t vertex = 0; vertex < vertexCount; ++vertex)
+    {
+        glm::vec3 point(mesh.vertices[vertex * 4], mesh.vertices[vertex * 4 + 1], mesh.vertices[vertex * 4 + 2]);
+        origin = glm::min(origin, point);
+        extent = glm::max(extent, point);
+    }
+    extent -= origin;
+
+    // Cells are indexed on 21 bits per axis, the grid is coarsened if the mesh is too large for it
+    constexpr uint64_t cellMask = (1ull << 21) - 1;
+    cellSize = std::max({cellSize, extent.x / cellMask, extent.y / cellMask, extent.z / cellMask});
+
+    unordered_map<uint64_t, uint32_t> cellClusters;
+    vector<glm::dvec4> clusterSums;
+    vector<uint32_t> vertexClusters(vertexCount);
+    for (size_t vertex = 0; vertex < vertexCount; ++vertex)
+    {
+        glm::vec4 point(mesh.vertices[vertex * 4], mesh.vertices[vertex * 4 + 1], mesh.vertices[vertex * 4 + 2], mesh.vertices[vertex * 4 + 3]);
+        auto cell = glm::floor((glm::vec3(point) - origin) / cellSize);
+        auto key = (static_cast<uint64_t>(cell.x) & cellMask) | (static_cast<uint64_t>(cell.y) & cellMask) << 21 | (static_cast<uint64_t>(cell.z) & cellMask) << 42;
+
+        auto [clusterIt, inserted] = cellClusters.try_emplace(key, static_cast<uint32_t>(clusterSums.size()));
+        if (inserted)
+            clusterSums.emplace_back(0.0);
+        clusterSums[clusterIt->second] += glm::dvec4(glm::dvec3(point), 1.0);
+        vertexClusters[vertex] = clusterIt->second;
+    }
+
+    vector<glm::vec3> clusterPositions(clusterSums.size());
+    for (size_t cluster = 0; cluster < clusterSums.size(); ++cluster)
+        clusterPositions[cluster] = glm::vec3(glm::dvec3(clusterSums[cluster]) / clusterSums[cluster].w);
+
+    const auto hasUVs = mesh.uvs.size() >= vertexCount * 2;
+    const auto hasNormals = mesh.normals.size() >= vertexCount * 4;
+    const auto hasAnnexe = mesh.annexe.size() >= vertexCount * 4;
+
+    Arrays simplified;
+    for (size_t first = 0; first < vertexCount; first += 3)
+    {
+        auto a = vertexClusters[first], b = vertexClusters[first + 1], c = vertexClusters[first + 2];
+        if (a == b || b == c || c == a)
+            continue;
+
+        for (size_t vertex = first; vertex < first + 3; ++vertex)
+        {
+            const auto& position = clusterPositions[vertexClusters[vertex]];
+            simplified.vertices.insert(simplified.vertices.end(), {position.x, position.y, position.z, mesh.vertices[vertex * 4 + 3]});
+            if (hasUVs)
+                simplified.uvs.insert(simplified.uvs.end(), mesh.uvs.begin() + vertex * 2, mesh.uvs.begin() + vertex * 2 + 2);
+            if (hasNormals)
+                simplified.normals.insert(simplified.normals.end(), mesh.normals.begin() + vertex * 4, mesh.normals.begin() + vertex * 4 + 4);
+            if (hasAnnexe)
+                simplified.annexe.insert(simplified.annexe.end(), mesh.annexe.begin() + vertex * 4, mesh.annexe.begin() + vertex * 4 + 4);
+        }
+    }
+
+    return simplified;
+}
+
+} // namespace MeshSimplifier
+} // namespace Splash
@@ -0,0 +1,66 @@
+/*
+ * Copyright (C) 2026 Emmanuel Durand
+ *
+ * This file is part of Splash.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Splash is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Splash.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * @mesh_simplifier.h
+ * Simplification of triangle meshes, to generate their levels of detail
+ */
+
+#ifndef SPLASH_MESH_SIMPLIFIER_H
+#define SPLASH_MESH_SIMPLIFIER_H
+
+#include <vector>
+
+namespace Splash
+{
+namespace MeshSimplifier
+{
+
+//! Vertex arrays of a triangle list, with the layout of the Geometry buffers
+//! Each vertex has 4 floats of coordinates, 2 of UV, 4 of normal and 4 of annexe. All but the coordinates may be empty.
+struct Arrays
+{
+    std::vector<float> vertices{};
+    std::vector<float> uvs{};
+    std::vector<float> normals{};
+    std::vector<float> annexe{};
+};
+
+/**
+ * Get the mean length of the edges of the triangles
+ * \param vertices Vertex coordinates, 4 floats per vertex
+ * \return Return the mean edge length, or 0 if there is no triangle
+ */
+float getMeanEdgeLength(const std::vector<float>& vertices);
+
+/**
+ * Simplify a triangle list by clustering its vertices over a regular grid
+ * All vertices of a cell are moved to their mean position, and the triangles with less than
+ * three distinct cells are dropped. Vertices keep their own UV, normal and annexe, so that
+ * texture seams are preserved. This is linear in the number of vertices.
+ * \param mesh Mesh to simplify
+ * \param cellSize Size of the grid cells, in mesh coordinates
+ * \return Return the simplified mesh
+ */
+Arrays simplify(const Arrays& mesh, float cellSize);
+
+} // namespace MeshSimplifier
+} // namespace Splash
+
+#endif // SPLASH_MESH_SIMPLIFIER_H
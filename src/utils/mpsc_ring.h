@@ -0,0 +1,136 @@
+/*
+ * Copyright (C) 2026 Emmanuel Durand
+ *
+ * This file is part of Splash.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Splash is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Splash.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * @mpsc_ring.h
+ * Bounded, lock-free, multiple producers and single consumer ring buffer
+ */
+
+#ifndef SPLASH_MPSC_RING_H
+#define SPLASH_MPSC_RING_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace Splash
+{
+
+/*************/
+//! Bounded ring buffer, based on per-cell sequence numbers
+//! Any number of threads can push concurrently, only one thread at a time may pop.
+//! Cells are copy-assigned, so that types like std::string keep their capacity
+//! and do not allocate once the ring has been filled once.
+template <typename T>
+class MpscRing
+{
+  public:
+    /**
+     * Constructor
+     * \param capacity Ring capacity, rounded up to the next power of two
+     */
+    explicit MpscRing(size_t capacity)
+    {
+        size_t roundedCapacity = 1;
+        while (roundedCapacity < capacity)
+            roundedCapacity <<= 1;
+
+        _mask = roundedCapacity - 1;
+        _cells = std::vector<Cell>(roundedCapacity);
+        for (size_t i = 0; i < roundedCapacity; ++i)
+            _cells[i].sequence.store(i, std::memory_order_relaxed);
+    }
+
+    MpscRing(const MpscRing&) = delete;
+    MpscRing& operator=(const MpscRing&) = delete;
+
+    /**
+     * Push a copy of the given value, never blocks
+     * \param value Value to push
+     * \return Return false if the ring is full
+     */
+    bool push(const T& value)
+    {
+        auto position = _pushPosition.load(std::memory_order_relaxed);
+        Cell* cell = nullptr;
+        while (true)
+        {
+            cell = &_cells[position & _mask];
+            auto sequence = cell->sequence.load(std::memory_order_acquire);
+            auto difference = static_cast<int64_t>(sequence) - static_cast<int64_t>(position);
+            if (difference == 0)
+            {
+                if (_pushPosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+                    break;
+            }
+            else if (difference < 0)
+            {
+                return false;
+            }
+            else
+            {
+                position = _pushPosition.load(std::memory_order_relaxed);
+            }
+        }
+
+        cell->value = value;
+        cell->sequence.store(position + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * Pop the oldest value. Must not be called concurrently.
+     * \param value Value to copy the popped value to
+     * \return Return false if the ring is empty
+     */
+    bool pop(T& value)
+    {
+        auto& cell = _cells[_popPosition & _mask];
+        if (cell.sequence.load(std::memory_order_acquire) != _popPosition + 1)
+            return false;
+
+        value = cell.value;
+        cell.sequence.store(_popPosition + _mask + 1, std::memory_order_release);
+        ++_popPosition;
+        return true;
+    }
+
+    /**
+     * Get the ring capacity
+     * \return Return the capacity
+     */
+    size_t capacity() const { return _mask + 1; }
+
+  private:
+    struct Cell
+    {
+        std::atomic<uint64_t> sequence{0};
+        T value{};
+    };
+
+    std::vector<Cell> _cells{};
+    uint64_t _mask{0};
+    alignas(64) std::atomic<uint64_t> _pushPosition{0};
+    alignas(64) uint64_t _popPosition{0};
+};
+
+} // namespace Splash
+
+#endif // SPLASH_MPSC_RING_H
@@ -26,7 +26,13 @@
 #define SPLASH_OSUTILS_H
 
 #include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstring>
 #include <filesystem>
+#include <fstream>
+#include <functional>
+#include <mutex>
 #include <pwd.h>
 #include <sched.h>
 #include <string>
@@ -40,6 +46,10 @@
 #include "./core/constants.h"
 #include "./utils/log.h"
 
+#if HAVE_LINUX
+#include <linux/mempolicy.h>
+#endif
+
 #if HAVE_SHMDATA
 #include <shmdata/abstract-logger.hpp>
 #endif
@@ -118,6 +128,298 @@ inline bool setRealTime()
 #endif
 }
 
+/**
+ * \brief Set the scheduling policy of the current thread
+ * \param policy Scheduling policy, among "default", "batch", "idle", "fifo" and "rr"
+ * \param priority Priority, only used by the realtime policies "fifo" and "rr"
+ * \return Return true if it was able to set the scheduling
+ */
+inline bool setScheduling(const std::string& policy, int priority)
+{
+#if HAVE_LINUX
+    int schedPolicy = SCHED_OTHER;
+    if (policy == "batch")
+        schedPolicy = SCHED_BATCH;
+    else if (policy == "idle")
+        schedPolicy = SCHED_IDLE;
+    else if (policy == "fifo")
+        schedPolicy = SCHED_FIFO;
+    else if (policy == "rr")
+        schedPolicy = SCHED_RR;
+    else if (policy != "default")
+        return false;
+
+    sched_param params;
+    params.sched_priority = 0;
+    if (schedPolicy == SCHED_FIFO || schedPolicy == SCHED_RR)
+        params.sched_priority = std::clamp(priority, sched_get_priority_min(schedPolicy), sched_get_priority_max(schedPolicy));
+
+    if (sched_setscheduler(getThreadId(), schedPolicy, &params) != 0)
+        return false;
+
+    return true;
+#else
+    return false;
+#endif
+}
+
+/**
+ * \brief Parse a CPU list as found in sysfs, like "0-3,8-11"
+ * \param cpuList CPU list
+ * \return Return the cores in the list
+ */
+inline std::vector<int> parseCpuList(const std::string& cpuList)
+{
+    std::vector<int> cores;
+    size_t position = 0;
+    while (position < cpuList.size())
+    {
+        auto separator = cpuList.find(',', position);
+        auto range = cpuList.substr(position, separator == std::string::npos ? std::string::npos : separator - position);
+        position = separator == std::string::npos ? cpuList.size() : separator + 1;
+
+        try
+        {
+            auto dash = range.find('-');
+            auto first = std::stoi(range.substr(0, dash));
+            auto last = dash == std::string::npos ? first : std::stoi(range.substr(dash + 1));
+            for (int core = first; core <= last; ++core)
+                cores.push_back(core);
+        }
+        catch (...)
+        {
+            continue;
+        }
+    }
+    return cores;
+}
+
+/**
+ * \brief Get the number of NUMA nodes
+ * \return Return the node count, 1 if the topology is not available
+ */
+inline int getNumaNodeCount()
+{
+    std::ifstream file("/sys/devices/system/node/possible");
+    std::string nodeList;
+    if (!file.is_open() || !std::getline(file, nodeList))
+        return 1;
+    auto nodes = parseCpuList(nodeList);
+    return nodes.empty() ? 1 : nodes.back() + 1;
+}
+
+/**
+ * \brief Get the cores of a NUMA node
+ * \param node NUMA node
+ * \return Return the cores, or an empty vector if the node does not exist
+ */
+inline std::vector<int> getNumaNodeCores(int node)
+{
+    std::ifstream file("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist");
+    std::string cpuList;
+    if (!file.is_open() || !std::getline(file, cpuList))
+        return {};
+    return parseCpuList(cpuList);
+}
+
+/**
+ * \brief Get the NUMA node a PCI device is attached to
+ * \param busId PCI bus id, as "0000:01:00.0"
+ * \return Return the node, or -1 if unknown
+ */
+inline int getPciDeviceNumaNode(const std::string& busId)
+{
+    std::ifstream file("/sys/bus/pci/devices/" + busId + "/numa_node");
+    int node = -1;
+    if (!file.is_open() || !(file >> node))
+        return -1;
+    return node;
+}
+
+/**
+ * \brief Bind the current thread to a NUMA node: it runs on the node cores, and allocates from the node memory first.
+ * Threads created afterwards inherit this binding, so this is meant to be called at process startup.
+ * \param node NUMA node
+ * \return Return true if all went well
+ */
+inline bool bindToNumaNode(int node)
+{
+#if HAVE_LINUX
+    auto cores = getNumaNodeCores(node);
+    if (cores.empty() || !setAffinity(cores))
+        return false;
+
+    // Memory falls back to the other nodes when this one is full, instead of failing
+    unsigned long nodeMask = 0;
+    if (node >= static_cast<int>(sizeof(nodeMask) * 8))
+        return false;
+    nodeMask = 1ul << node;
+    if (syscall(SYS_set_mempolicy, MPOL_PREFERRED, &nodeMask, sizeof(nodeMask) * 8) != 0)
+        return false;
+
+    return true;
+#else
+    return false;
+#endif
+}
+
+//! Classes of threads sharing the same CPU set and scheduling policy
+enum class ThreadClass : uint8_t
+{
+    render = 0, //!< Scene render loop, texture upload and video frame display
+    audio,      //!< Audio output of the media players
+    decode,     //!< Media demuxing and decoding, capture and encoding
+    network,    //!< Link input threads
+    count
+};
+
+//! CPU set and scheduling policy of a thread class
+struct ThreadScheduling
+{
+    std::string policy{"default"}; //!< Scheduling policy, see setScheduling
+    int priority{0};               //!< Priority for the realtime policies
+    std::vector<int> cores{};      //!< Cores the threads are allowed to run on, any core of the process if empty
+
+    bool operator==(const ThreadScheduling&) const = default;
+};
+
+//! Scheduling of all thread classes for this process
+struct ThreadClassRegistry
+{
+    std::mutex mutex{};
+    std::array<ThreadScheduling, static_cast<size_t>(ThreadClass::count)> scheduling{};
+    std::vector<int> processCores{}; //!< Cores of the process at startup, used by the classes with no core set
+    //! Incremented on each change of a class, so that its threads only apply the settings when needed
+    std::array<std::atomic<uint64_t>, static_cast<size_t>(ThreadClass::count)> versions{};
+};
+
+/**
+ * \brief Get the thread class registry of this process
+ * \return Return the registry
+ */
+inline ThreadClassRegistry& getThreadClassRegistry()
+{
+    static ThreadClassRegistry registry;
+    return registry;
+}
+
+/**
+ * \brief Get the cores the current thread is allowed to run on
+ * \return Return the cores, or an empty vector if they could not be queried
+ */
+inline std::vector<int> getAffinity()
+{
+    std::vector<int> cores;
+#if HAVE_LINUX
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    if (sched_getaffinity(getThreadId(), sizeof(set), &set) != 0)
+        return cores;
+
+    for (int core = 0; core < CPU_SETSIZE; ++core)
+        if (CPU_ISSET(core, &set))
+            cores.push_back(core);
+#endif
+    return cores;
+}
+
+/**
+ * \brief Store the affinity of the current thread as the one of the thread classes with no core set
+ * This is meant to be called at process startup, after any NUMA binding, so that the classes do not undo it.
+ */
+inline void captureProcessAffinity()
+{
+    auto cores = getAffinity();
+    auto& registry = getThreadClassRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    registry.processCores = cores;
+}
+
+/**
+ * \brief Get the thread class from its name
+ * \param name Thread class name, among "render", "audio", "decode" and "network"
+ * \return Return the thread class, or ThreadClass::count if the name is unknown
+ */
+inline ThreadClass getThreadClassFromName(const std::string& name)
+{
+    static const std::array<std::string, static_cast<size_t>(ThreadClass::count)> names{"render", "audio", "decode", "network"};
+    for (size_t i = 0; i < names.size(); ++i)
+        if (names[i] == name)
+            return static_cast<ThreadClass>(i);
+    return ThreadClass::count;
+}
+
+/**
+ * \brief Set the scheduling of a thread class, applied by its threads the next time they call applyThreadClass
+ * \param threadClass Thread class
+ * \param scheduling Scheduling
+ */
+inline void setThreadClassScheduling(ThreadClass threadClass, const ThreadScheduling& scheduling)
+{
+    if (threadClass == ThreadClass::count)
+        return;
+
+    auto& registry = getThreadClassRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    auto index = static_cast<size_t>(threadClass);
+    if (registry.scheduling[index] == scheduling)
+        return;
+    registry.scheduling[index] = scheduling;
+    registry.versions[index].fetch_add(1, std::memory_order_release);
+}
+
+/**
+ * \brief Get the scheduling of a thread class
+ * \param threadClass Thread class
+ * \return Return the scheduling
+ */
+inline ThreadScheduling getThreadClassScheduling(ThreadClass threadClass)
+{
+    if (threadClass == ThreadClass::count)
+        return {};
+
+    auto& registry = getThreadClassRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    return registry.scheduling[static_cast<size_t>(threadClass)];
+}
+
+/**
+ * \brief Apply the scheduling of the given thread class to the current thread, if it changed since the last call from this thread
+ * This is cheap when nothing changed, and is meant to be called at each iteration of the thread loop.
+ * \param threadClass Thread class of the current thread
+ * \return Return false if the scheduling had to be applied and could not be
+ */
+inline bool applyThreadClass(ThreadClass threadClass)
+{
+    thread_local std::array<uint64_t, static_cast<size_t>(ThreadClass::count)> appliedVersions{};
+
+    if (threadClass == ThreadClass::count)
+        return true;
+
+    auto& registry = getThreadClassRegistry();
+    auto index = static_cast<size_t>(threadClass);
+    auto version = registry.versions[index].load(std::memory_order_acquire);
+    if (version == appliedVersions[index])
+        return true;
+    appliedVersions[index] = version;
+
+    ThreadScheduling scheduling;
+    std::vector<int> cores;
+    {
+        std::lock_guard<std::mutex> lock(registry.mutex);
+        scheduling = registry.scheduling[index];
+        cores = scheduling.cores.empty() ? registry.processCores : scheduling.cores;
+    }
+
+    if (cores.empty())
+        for (int core = 0; core < getCoreCount(); ++core)
+            cores.push_back(core);
+
+    auto status = setAffinity(cores);
+    status &= setScheduling(scheduling.policy, scheduling.priority);
+    return status;
+}
+
 /**
  * Utils function to handle ioctl being interrupted
  * See SA_RESTART here: http://pubs.opengroup.org/onlinepubs/009695399/functions/sigaction.html
@@ -180,6 +482,64 @@ inline std::string getHomePath()
     return std::string(pw->pw_dir);
 }
 
+/**
+ * \brief Get the path where Splash stores its cached data, following the XDG base directory specification
+ * \return Return the cache path
+ */
+inline std::string getCachePath()
+{
+    auto xdgCache = getenv("XDG_CACHE_HOME");
+    if (xdgCache != nullptr && std::string(xdgCache) != "")
+        return std::string(xdgCache) + "/splash";
+    return getHomePath() + "/.cache/splash";
+}
+
+/**
+ * \brief Write a file to the cache, starting with a header made of a magic string and a format version
+ * The file is first written to a temporary file which is then renamed, so that a partially written file is never read,
+ * even by another process writing the same file concurrently
+ * \param path Cache file path, its directory being created if needed
+ * \param magic Magic string identifying the file type, written with its terminating null character
+ * \param version Version of the file format
+ * \param writeContent Function writing what follows the header
+ * \return Return true if the file was written
+ */
+inline bool writeCacheFile(const std::string& path, const char* magic, uint32_t version, const std::function<void(std::ofstream&)>& writeContent)
+{
+    std::error_code errorCode;
+    std::filesystem::create_directories(std::filesystem::path(path).parent_path(), errorCode);
+    if (errorCode)
+    {
+        Log::get() << Log::WARNING << "Utils::" << __FUNCTION__ << " - Unable to create cache directory for " << path << ": " << errorCode.message() << Log::endl;
+        return false;
+    }
+
+    auto tmpPath = path + "." + std::to_string(getpid()) + ".tmp";
+    {
+        std::ofstream file(tmpPath, std::ios::out | std::ios::binary | std::ios::trunc);
+        file.write(magic, strlen(magic) + 1);
+        file.write(reinterpret_cast<const char*>(&version), sizeof(version));
+        writeContent(file);
+
+        if (!file)
+        {
+            Log::get() << Log::WARNING << "Utils::" << __FUNCTION__ << " - Unable to write cache file " << tmpPath << Log::endl;
+            file.close();
+            std::filesystem::remove(tmpPath, errorCode);
+            return false;
+        }
+    }
+
+    std::filesystem::rename(tmpPath, path, errorCode);
+    if (errorCode)
+    {
+        std::filesystem::remove(tmpPath, errorCode);
+        return false;
+    }
+
+    return true;
+}
+
 /**
  * \brief Get the directory path from the file path.
  * \param filepath File path
@@ -25,18 +25,37 @@
 #ifndef SPLASH_RESIZABLE_ARRAY_H
 #define SPLASH_RESIZABLE_ARRAY_H
 
+#include <algorithm>
+#include <cstdint>
 #include <cstdlib>
 #include <cstring>
+#include <functional>
 #include <memory>
+#include <sys/mman.h>
+#include <type_traits>
+
+// Buffers at least this large, in bytes, are mapped directly and backed by transparent huge pages
+#define SPLASH_RESIZABLE_ARRAY_LARGE_BUFFER_SIZE (4 * 1024 * 1024)
+// Alignment of large buffers, matching the size of a transparent huge page
+#define SPLASH_RESIZABLE_ARRAY_HUGE_PAGE_SIZE (2 * 1024 * 1024)
 
 namespace Splash
 {
 
 /*************/
+//! Buffer of trivially copyable values, which are left uninitialized on allocation
+//! Large buffers are mapped aligned on huge page boundaries and marked as candidates for
+//! transparent huge pages, to reduce page faults and TLB misses when handling big frames.
+//! Pages are only committed on first touch, and are thus placed on the NUMA node of the
+//! thread filling the buffer.
 template <typename T>
 class ResizableArray
 {
+    static_assert(std::is_trivially_copyable<T>::value, "ResizableArray only holds trivially copyable types");
+
   public:
+    using Deleter = std::function<void(T*)>;
+
     /**
      * Constructor with an initial size
      * \param size Initial array size
@@ -61,10 +80,32 @@ class ResizableArray
 
         _size = static_cast<size_t>(end - start);
         _shift = 0;
-        _buffer = std::unique_ptr<T[]>(new T[_size]);
+        _buffer = allocate(_size);
         memcpy(data(), start, _size * sizeof(T));
     }
 
+    /**
+     * Constructor adopting an externally allocated buffer, without copying it
+     * The deleter is called with the buffer pointer once the array releases it
+     * \param data Pointer to the external buffer
+     * \param size Buffer size
+     * \param deleter Function called to release the buffer
+     */
+    ResizableArray(T* data, size_t size, const Deleter& deleter)
+    {
+        if (!data || size == 0)
+        {
+            if (data && deleter)
+                deleter(data);
+            return;
+        }
+
+        _size = size;
+        _shift = 0;
+        _buffer = std::unique_ptr<T[], Deleter>(data, deleter);
+        _adopted = true;
+    }
+
     /**
      * Copy constructor
      * \param a ResizableArray to copy
@@ -73,19 +114,22 @@ class ResizableArray
     {
         _size = a.size();
         _shift = 0;
-        _buffer = std::unique_ptr<T[]>(new T[_size]);
-        memcpy(data(), a.data(), _size);
+        _buffer = allocate(_size);
+        memcpy(data(), a.data(), _size * sizeof(T));
     }
 
     /**
      * Move constructor
      * \param a ResizableArray to move
      */
-    ResizableArray(ResizableArray&& a)
+    ResizableArray(ResizableArray&& a) noexcept
         : _size(a._size)
         , _shift(a._shift)
+        , _adopted(a._adopted)
         , _buffer(std::move(a._buffer))
     {
+        a._size = 0;
+        a._shift = 0;
     }
 
     /**
@@ -99,8 +143,9 @@ class ResizableArray
 
         _size = a.size();
         _shift = 0;
-        _buffer = std::unique_ptr<T[]>(new T[_size]);
-        memcpy(data(), a.data(), _size);
+        _adopted = false;
+        _buffer = allocate(_size);
+        memcpy(data(), a.data(), _size * sizeof(T));
 
         return *this;
     }
@@ -109,14 +154,17 @@ class ResizableArray
      * Move operator
      * \param a ResizableArray to move from
      */
-    ResizableArray& operator=(ResizableArray&& a)
+    ResizableArray& operator=(ResizableArray&& a) noexcept
     {
         if (this == &a)
             return *this;
 
         _size = a._size;
         _shift = a._shift;
+        _adopted = a._adopted;
         _buffer = std::move(a._buffer);
+        a._size = 0;
+        a._shift = 0;
 
         return *this;
     }
@@ -155,6 +203,12 @@ class ResizableArray
      */
     inline size_t size() const { return _size; }
 
+    /**
+     * Check whether the buffer has been adopted from an external allocation
+     * \return Return true if the buffer is released through a custom deleter
+     */
+    inline bool isAdopted() const { return _adopted; }
+
     /**
      * Resize the buffer
      * \param size New size
@@ -169,28 +223,73 @@ class ResizableArray
         {
             _size = 0;
             _shift = 0;
+            _adopted = false;
             _buffer.reset(nullptr);
         }
         else
         {
-            auto newBuffer = std::unique_ptr<T[]>(new T[size]);
+            auto newBuffer = allocate(size);
             if (_size != 0)
-            {
-                if (size > _size)
-                    memcpy(newBuffer.get(), _buffer.get(), _size);
-                else
-                    memcpy(newBuffer.get(), _buffer.get(), size);
-            }
+                memcpy(newBuffer.get(), data(), std::min(size, _size) * sizeof(T));
             std::swap(_buffer, newBuffer);
             _size = size;
             _shift = 0;
+            _adopted = false;
         }
     }
 
   private:
-    size_t _size{0};                       //!< Buffer size
-    size_t _shift{0};                      //!< Buffer shift
-    std::unique_ptr<T[]> _buffer{nullptr}; //!< Pointer to the buffer data
+    size_t _size{0};                                    //!< Buffer size
+    size_t _shift{0};                                   //!< Buffer shift
+    bool _adopted{false};                               //!< True if the buffer comes from an external allocation
+    std::unique_ptr<T[], Deleter> _buffer{nullptr, {}}; //!< Pointer to the buffer data
+
+    /**
+     * Allocate a buffer owned by this array, without initializing it
+     * \param size Buffer size
+     * \return Return the allocated buffer
+     */
+    static std::unique_ptr<T[], Deleter> allocate(size_t size)
+    {
+        if (size == 0)
+            return {nullptr, {}};
+
+        if (size * sizeof(T) >= SPLASH_RESIZABLE_ARRAY_LARGE_BUFFER_SIZE)
+            if (auto buffer = allocateLarge(size))
+                return buffer;
+
+        return std::unique_ptr<T[], Deleter>(new T[size], [](T* ptr) { delete[] ptr; });
+    }
+
+    /**
+     * Map a large buffer aligned on a huge page boundary
+     * \param size Buffer size
+     * \return Return the mapped buffer, or nullptr if the mapping failed
+     */
+    static std::unique_ptr<T[], Deleter> allocateLarge(size_t size)
+    {
+        const size_t alignment = SPLASH_RESIZABLE_ARRAY_HUGE_PAGE_SIZE;
+        const size_t length = (size * sizeof(T) + alignment - 1) / alignment * alignment;
+
+        // Over map by one huge page, then unmap what lies outside of the aligned range
+        auto mapped = mmap(nullptr, length + alignment, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (mapped == MAP_FAILED)
+            return {nullptr, {}};
+
+        auto start = reinterpret_cast<uintptr_t>(mapped);
+        auto alignedStart = (start + alignment - 1) / alignment * alignment;
+        if (alignedStart > start)
+            munmap(mapped, alignedStart - start);
+        if (auto tail = start + length + alignment - (alignedStart + length); tail > 0)
+            munmap(reinterpret_cast<void*>(alignedStart + length), tail);
+
+        auto ptr = reinterpret_cast<void*>(alignedStart);
+#ifdef MADV_HUGEPAGE
+        madvise(ptr, length, MADV_HUGEPAGE);
+#endif
+
+        return std::unique_ptr<T[], Deleter>(static_cast<T*>(ptr), [length](T* buffer) { munmap(buffer, length); });
+    }
 };
 
 } // namespace Splash
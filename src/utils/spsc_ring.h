@@ -0,0 +1,256 @@
+/*
+ * Copyright (C) 2026 Emmanuel Durand
+ *
+ * This file is part of Splash.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Splash is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Splash.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * @spsc_ring.h
+ * Bounded, wait-free, single producer and single consumer ring buffers, holding bytes or movable items
+ */
+
+#ifndef SPLASH_SPSC_RING_H
+#define SPLASH_SPSC_RING_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <utility>
+#include <vector>
+
+namespace Splash
+{
+
+/*************/
+//! Byte ring buffer shared between exactly one writing thread and one reading thread
+//! Reads and writes are all or nothing, and never block nor allocate, which makes the
+//! ring usable from a real-time audio callback. Positions are monotonic counters, so
+//! the whole capacity is usable and no space is lost when the data wraps around.
+class SpscByteRing
+{
+  public:
+    /**
+     * Constructor
+     * \param capacity Ring capacity in bytes, rounded up to the next power of two
+     */
+    explicit SpscByteRing(size_t capacity)
+    {
+        size_t roundedCapacity = 1;
+        while (roundedCapacity < capacity)
+            roundedCapacity <<= 1;
+
+        _mask = roundedCapacity - 1;
+        _buffer = std::vector<uint8_t>(roundedCapacity);
+    }
+
+    SpscByteRing(const SpscByteRing&) = delete;
+    SpscByteRing& operator=(const SpscByteRing&) = delete;
+
+    /**
+     * Write the given bytes, only from the writing thread
+     * \param data Bytes to write
+     * \param size Byte count
+     * \return Return false if there is not enough space left, in which case nothing is written
+     */
+    bool write(const uint8_t* data, size_t size)
+    {
+        auto writePosition = _writePosition.load(std::memory_order_relaxed);
+        auto readPosition = _readPosition.load(std::memory_order_acquire);
+        if (capacity() - (writePosition - readPosition) < size)
+            return false;
+
+        auto offset = writePosition & _mask;
+        auto firstPart = std::min<size_t>(size, capacity() - offset);
+        memcpy(&_buffer[offset], data, firstPart);
+        memcpy(_buffer.data(), data + firstPart, size - firstPart);
+
+        _writePosition.store(writePosition + size, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * Read bytes, only from the reading thread
+     * \param data Buffer to read to
+     * \param size Byte count
+     * \return Return false if not enough bytes are available, in which case nothing is read
+     */
+    bool read(uint8_t* data, size_t size)
+    {
+        auto readPosition = _readPosition.load(std::memory_order_relaxed);
+        if (_clearRequested.exchange(false, std::memory_order_acquire))
+        {
+            readPosition = _writePosition.load(std::memory_order_acquire);
+            _readPosition.store(readPosition, std::memory_order_release);
+        }
+
+        auto writePosition = _writePosition.load(std::memory_order_acquire);
+        if (writePosition - readPosition < size)
+            return false;
+
+        auto offset = readPosition & _mask;
+        auto firstPart = std::min<size_t>(size, capacity() - offset);
+        memcpy(data, &_buffer[offset], firstPart);
+        memcpy(data + firstPart, _buffer.data(), size - firstPart);
+
+        _readPosition.store(readPosition + size, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * Ask for the ring to be emptied, from any thread
+     * The reading thread drops everything written so far on its next read.
+     */
+    void clear() { _clearRequested.store(true, std::memory_order_release); }
+
+    /**
+     * Get the number of bytes available for reading
+     * \return Return the byte count
+     */
+    size_t readAvailable() const { return _writePosition.load(std::memory_order_acquire) - _readPosition.load(std::memory_order_acquire); }
+
+    /**
+     * Get the ring capacity
+     * \return Return the capacity in bytes
+     */
+    size_t capacity() const { return _mask + 1; }
+
+  private:
+    std::vector<uint8_t> _buffer{};
+    uint64_t _mask{0};
+    std::atomic_bool _clearRequested{false};
+    alignas(64) std::atomic<uint64_t> _writePosition{0};
+    alignas(64) std::atomic<uint64_t> _readPosition{0};
+};
+
+/*************/
+//! Ring of movable items shared between one producing thread and one consuming thread
+//! Items are moved in and out of preallocated slots, so that handing over an item never locks nor allocates.
+//! Producing from more than one thread is possible as long as the producers are serialized by the caller.
+template <typename T>
+class SpscRing
+{
+  public:
+    /**
+     * Constructor
+     * \param capacity Number of slots, rounded up to the next power of two
+     */
+    explicit SpscRing(size_t capacity)
+    {
+        size_t roundedCapacity = 1;
+        while (roundedCapacity < capacity)
+            roundedCapacity <<= 1;
+
+        _mask = roundedCapacity - 1;
+        _slots = std::vector<T>(roundedCapacity);
+    }
+
+    SpscRing(const SpscRing&) = delete;
+    SpscRing& operator=(const SpscRing&) = delete;
+
+    /**
+     * Push an item, only from the producing thread
+     * \param item Item to move into the ring
+     * \return Return false if the ring is full, in which case the item is left untouched
+     */
+    bool push(T&& item)
+    {
+        auto writePosition = _writePosition.load(std::memory_order_relaxed);
+        auto readPosition = _readPosition.load(std::memory_order_acquire);
+        if (writePosition - readPosition > _mask)
+            return false;
+
+        _slots[writePosition & _mask] = std::move(item);
+        _writePosition.store(writePosition + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * Pop the oldest item, only from the consuming thread
+     * Items dropped by a call to clear() are handed to the given functor instead, which can recycle them.
+     * \param item Item to move the oldest item to
+     * \param onDrop Functor called with each dropped item
+     * \return Return false if the ring is empty
+     */
+    template <typename OnDrop>
+    bool pop(T& item, OnDrop&& onDrop)
+    {
+        auto readPosition = _readPosition.load(std::memory_order_relaxed);
+        auto clearPosition = _clearPosition.load(std::memory_order_acquire);
+        for (; readPosition < clearPosition; ++readPosition)
+        {
+            onDrop(_slots[readPosition & _mask]);
+            _slots[readPosition & _mask] = T();
+        }
+
+        auto writePosition = _writePosition.load(std::memory_order_acquire);
+        if (writePosition == readPosition)
+        {
+            _readPosition.store(readPosition, std::memory_order_release);
+            return false;
+        }
+
+        item = std::move(_slots[readPosition & _mask]);
+        _slots[readPosition & _mask] = T();
+        _readPosition.store(readPosition + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * Pop the oldest item, only from the consuming thread, items dropped by clear() being destroyed
+     * \param item Item to move the oldest item to
+     * \return Return false if the ring is empty
+     */
+    bool pop(T& item)
+    {
+        return pop(item, [](T&) {});
+    }
+
+    /**
+     * Drop all the items pushed so far, only from the producing thread
+     * The items are released by the consuming thread on its next pop, items pushed after this call being kept.
+     */
+    void clear() { _clearPosition.store(_writePosition.load(std::memory_order_relaxed), std::memory_order_release); }
+
+    /**
+     * Get the number of items in the ring, including the dropped items not released yet
+     * \return Return the item count
+     */
+    size_t size() const { return _writePosition.load(std::memory_order_acquire) - _readPosition.load(std::memory_order_acquire); }
+
+    /**
+     * Check whether the ring is empty
+     * \return Return true if there is nothing to pop nor to release
+     */
+    bool empty() const { return size() == 0; }
+
+    /**
+     * Get the ring capacity
+     * \return Return the number of slots
+     */
+    size_t capacity() const { return _mask + 1; }
+
+  private:
+    std::vector<T> _slots{};
+    uint64_t _mask{0};
+    std::atomic<uint64_t> _clearPosition{0}; //!< Items before this position are dropped
+    alignas(64) std::atomic<uint64_t> _writePosition{0};
+    alignas(64) std::atomic<uint64_t> _readPosition{0};
+};
+
+} // namespace Splash
+
+#endif // SPLASH_SPSC_RING_H
@@ -0,0 +1,212 @@
+#include "./utils/thread_pool.h"
+
+#include "./utils/log.h"
+#include "./utils/osutils.h"
+
+using namespace std;
+
+namespace Splash
+{
+
+namespace
+{
+// Pool and queue index of the current thread, if it is a worker
+thread_local const ThreadPool* currentPool{nullptr};
+thread_local unsigned int currentQueue{0};
+} // namespace
+
+/*************/
+ThreadPool::ThreadPool(unsigned int threadCount)
+{
+    threadCount = std::max(1u, threadCount);
+    for (unsigned int i = 0; i < threadCount; ++i)
+        _queues.emplace_back(make_unique<Queue>());
+    for (unsigned int i = 0; i < threadCount; ++i)
+        _workers.emplace_back([this, i]() { work(i); });
+}
+
+/*************/
+ThreadPool::~ThreadPool()
+{
+    {
+        lock_guard<mutex> lock(_sleepMutex);
+        _running = false;
+    }
+    _sleepCondition.notify_all();
+
+    for (auto& worker : _workers)
+        worker.join();
+}
+
+/*************/
+future<void> ThreadPool::enqueue(function<void()>&& task)
+{
+    packaged_task<void()> packagedTask(std::move(task));
+    auto result = packagedTask.get_future();
+
+    // The pending count is increased first so that it never goes below the number of queued tasks
+    _pendingTasks.fetch_add(1, memory_order_acq_rel);
+
+    auto index = currentPool == this ? currentQueue : _nextQueue.fetch_add(1, memory_order_relaxed) % _queues.size();
+    {
+        lock_guard<mutex> lock(_queues[index]->mutex);
+        _queues[index]->tasks.emplace_back(std::move(packagedTask));
+    }
+
+    {
+        // Locking makes sure that a worker about to sleep sees the new task
+        lock_guard<mutex> lock(_sleepMutex);
+    }
+    _sleepCondition.notify_one();
+
+    return result;
+}
+
+/*************/
+void ThreadPool::runParallel(unsigned int count, const function<void(unsigned int)>& func)
+{
+    if (count == 0)
+        return;
+
+    struct State
+    {
+        atomic_uint next{0};
+        unsigned int done{0};
+        mutex doneMutex{};
+        condition_variable doneCondition{};
+    };
+    auto state = make_shared<State>();
+
+    // Helpers only run indices which are still available, the State keeps them safe if they start late
+    auto runIndices = [state, count, &func]() {
+        unsigned int index;
+        while ((index = state->next.fetch_add(1, memory_order_acq_rel)) < count)
+        {
+            func(index);
+            lock_guard<mutex> lock(state->doneMutex);
+            if (++state->done == count)
+                state->doneCondition.notify_all();
+        }
+    };
+
+    for (unsigned int i = 1; i < std::min<unsigned int>(count, _workers.size() + 1); ++i)
+        enqueue(runIndices);
+    runIndices();
+
+    unique_lock<mutex> lock(state->doneMutex);
+    state->doneCondition.wait(lock, [&]() { return state->done == count; });
+}
+
+/*************/
+void ThreadPool::setAffinity(const vector<int>& cores)
+{
+    {
+        lock_guard<mutex> lock(_sleepMutex);
+        _cores = cores;
+        ++_settingsVersion;
+    }
+    _sleepCondition.notify_all();
+}
+
+/*************/
+vector<int> ThreadPool::getAffinity() const
+{
+    lock_guard<mutex> lock(_sleepMutex);
+    return _cores;
+}
+
+/*************/
+void ThreadPool::setRealTime(bool realtime)
+{
+    {
+        lock_guard<mutex> lock(_sleepMutex);
+        _realTime = realtime;
+        ++_settingsVersion;
+    }
+    _sleepCondition.notify_all();
+}
+
+/*************/
+bool ThreadPool::getRealTime() const
+{
+    lock_guard<mutex> lock(_sleepMutex);
+    return _realTime;
+}
+
+/*************/
+bool ThreadPool::takeTask(unsigned int index, packaged_task<void()>& task)
+{
+    // Own queue first, newest tasks first as their data is more likely to be in cache
+    {
+        auto& queue = *_queues[index];
+        lock_guard<mutex> lock(queue.mutex);
+        if (!queue.tasks.empty())
+        {
+            task = std::move(queue.tasks.back());
+            queue.tasks.pop_back();
+            return true;
+        }
+    }
+
+    // Then steal the oldest task of another worker
+    for (unsigned int i = 1; i < _queues.size(); ++i)
+    {
+        auto& queue = *_queues[(index + i) % _queues.size()];
+        lock_guard<mutex> lock(queue.mutex);
+        if (!queue.tasks.empty())
+        {
+            task = std::move(queue.tasks.front());
+            queue.tasks.pop_front();
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/*************/
+void ThreadPool::work(unsigned int index)
+{
+    currentPool = this;
+    currentQueue = index;
+
+    uint32_t settingsVersion = 0;
+    while (true)
+    {
+        vector<int> cores;
+        bool realTime = false;
+        bool settingsChanged = false;
+        {
+            unique_lock<mutex> lock(_sleepMutex);
+            _sleepCondition.wait(lock, [&]() { return !_running || _pendingTasks.load(memory_order_acquire) > 0 || settingsVersion != _settingsVersion; });
+
+            if (settingsVersion != _settingsVersion)
+            {
+                settingsVersion = _settingsVersion;
+                cores = _cores;
+                realTime = _realTime;
+                settingsChanged = true;
+            }
+
+            if (!_running && _pendingTasks.load(memory_order_acquire) == 0)
+                return;
+        }
+
+        if (settingsChanged)
+        {
+            if (!cores.empty() && !Utils::setAffinity(cores))
+                Log::get() << Log::WARNING << "ThreadPool::" << __FUNCTION__ << " - Unable to set the affinity of worker " << index << Log::endl;
+            if (realTime && !Utils::setRealTime())
+                Log::get() << Log::WARNING << "ThreadPool::" << __FUNCTION__ << " - Unable to set realtime priority for worker " << index << Log::endl;
+        }
+
+        packaged_task<void()> task;
+        if (!takeTask(index, task))
+            continue;
+
+        _pendingTasks.fetch_sub(1, memory_order_acq_rel);
+        task();
+    }
+}
+
+} // namespace Splash
@@ -0,0 +1,156 @@
+/*
+ * Copyright (C) 2026 Emmanuel Durand
+ *
+ * This file is part of Splash.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Splash is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Splash.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * @thread_pool.h
+ * Process-wide pool of persistent worker threads
+ */
+
+#ifndef SPLASH_THREAD_POOL_H
+#define SPLASH_THREAD_POOL_H
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace Splash
+{
+
+/*************/
+//! Pool of worker threads, created once and reused for short lived tasks
+//! Each worker has its own queue, and idle workers steal tasks from the others.
+class ThreadPool
+{
+  public:
+    /**
+     * \brief Get the process-wide pool
+     * \return Return the ThreadPool singleton
+     */
+    static ThreadPool& get()
+    {
+        static auto instance = new ThreadPool(std::max(2u, std::thread::hardware_concurrency()));
+        return *instance;
+    }
+
+    /**
+     * \brief Constructor
+     * \param threadCount Number of worker threads
+     */
+    explicit ThreadPool(unsigned int threadCount);
+
+    /**
+     * \brief Destructor, waits for the queued tasks to finish
+     */
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    /**
+     * \brief Queue a task to be run by one of the workers
+     * Tasks queued from a worker go to its own queue, others are distributed among the workers
+     * \param task Task to run
+     * \return Return a future which becomes ready once the task has run
+     */
+    std::future<void> enqueue(std::function<void()>&& task);
+
+    /**
+     * \brief Run a function over a range of indices, using the workers and the calling thread
+     * Indices not yet picked by a worker are run by the calling thread, so this never waits
+     * for a worker to become available, even if they are all busy
+     * \param count Number of indices
+     * \param func Function to run for each index
+     */
+    void runParallel(unsigned int count, const std::function<void(unsigned int)>& func);
+
+    /**
+     * \brief Get the number of worker threads
+     * \return Return the thread count
+     */
+    unsigned int getThreadCount() const { return _workers.size(); }
+
+    /**
+     * \brief Set the cores the workers are allowed to run on
+     * \param cores Core indices. If empty, the affinity is left untouched
+     */
+    void setAffinity(const std::vector<int>& cores);
+
+    /**
+     * \brief Get the cores the workers are allowed to run on
+     * \return Return the core indices
+     */
+    std::vector<int> getAffinity() const;
+
+    /**
+     * \brief Set whether the workers should ask for realtime scheduling
+     * \param realtime If true, the workers are set to realtime priority
+     */
+    void setRealTime(bool realtime);
+
+    /**
+     * \brief Get whether the workers ask for realtime scheduling
+     * \return Return true if they do
+     */
+    bool getRealTime() const;
+
+  private:
+    struct Queue
+    {
+        std::deque<std::packaged_task<void()>> tasks{};
+        std::mutex mutex{};
+    };
+
+    std::vector<std::thread> _workers{};
+    std::vector<std::unique_ptr<Queue>> _queues{};
+    std::atomic_uint _nextQueue{0};
+    std::atomic_uint _pendingTasks{0};
+
+    mutable std::mutex _sleepMutex{};
+    std::condition_variable _sleepCondition{};
+    bool _running{true};
+
+    std::vector<int> _cores{};     //!< Cores the workers should run on
+    bool _realTime{false};         //!< True if the workers should run with realtime priority
+    uint32_t _settingsVersion{0};  //!< Incremented each time the scheduling settings change
+
+    /**
+     * \brief Get a task from the given queue, or steal one from another queue
+     * \param index Index of the worker queue
+     * \param task Task to fill
+     * \return Return true if a task has been found
+     */
+    bool takeTask(unsigned int index, std::packaged_task<void()>& task);
+
+    /**
+     * \brief Worker thread loop
+     * \param index Index of the worker
+     */
+    void work(unsigned int index);
+};
+
+} // namespace Splash
+
+#endif // SPLASH_THREAD_POOL_H
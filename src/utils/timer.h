@@ -25,13 +25,20 @@
 #ifndef SPLASH_TIMER_H
 #define SPLASH_TIMER_H
 
+#include <array>
+#include <atomic>
 #include <chrono>
+#include <mutex>
 #include <string>
 #include <thread>
+#include <unordered_map>
 
 #include "./core/constants.h"
 #include "./core/spinlock.h"
 #include "./utils/dense_map.h"
+#include "./utils/trace_recorder.h"
+
+#define SPLASH_TIMER_MAX_PROBES 256
 
 namespace Splash
 {
@@ -74,6 +81,12 @@ class Timer
         bool operator!=(const Point& rhs) const { return !operator==(rhs); }
     };
 
+    //! Handle to a pre registered duration, measured without locking nor name lookup
+    struct Probe
+    {
+        uint32_t id{SPLASH_TIMER_MAX_PROBES};
+    };
+
     /**
      * \brief Get the singleton
      * \return Return the Timer singleton
@@ -157,6 +170,9 @@ class Timer
      */
     unsigned long long getDuration(const std::string& name) const
     {
+        if (auto probe = findProbe(name); probe.id < SPLASH_TIMER_MAX_PROBES && _probeSlots[probe.id].measured.load(std::memory_order_acquire))
+            return _probeSlots[probe.id].duration.load(std::memory_order_relaxed);
+
         std::lock_guard<Spinlock> lock(_timerMutex);
         auto durationIt = _durationMap.find(name);
         if (durationIt == _durationMap.end())
@@ -164,14 +180,58 @@ class Timer
         return durationIt->second;
     }
 
+    /**
+     * \brief Get the last duration measured through the given probe
+     * \param probe Probe
+     * \return Return the duration in us
+     */
+    unsigned long long getDuration(Probe probe) const
+    {
+        if (probe.id >= SPLASH_TIMER_MAX_PROBES)
+            return 0;
+        return _probeSlots[probe.id].duration.load(std::memory_order_relaxed);
+    }
+
     /**
      * \brief Get the whole duration map
      * \return Return the whole duration map
      */
     const DenseMap<std::string, uint64_t> getDurationMap() const
     {
-        std::lock_guard<Spinlock> lock(_timerMutex);
-        return _durationMap;
+        std::unique_lock<Spinlock> lock(_timerMutex);
+        auto durationMap = _durationMap;
+        lock.unlock();
+
+        // Gather the probes durations, names are never modified once the probe is counted in
+        auto probeCount = _probeCount.load(std::memory_order_acquire);
+        for (uint32_t i = 0; i < probeCount; ++i)
+            if (_probeSlots[i].measured.load(std::memory_order_acquire))
+                durationMap[_probeNames[i]] = _probeSlots[i].duration.load(std::memory_order_relaxed);
+
+        return durationMap;
+    }
+
+    /**
+     * \brief Get the probe for the given duration name, registering it if needed.
+     * Registering takes a lock, so probes are best created once and stored.
+     * Durations measured through a probe are reported under its name by getDuration and getDurationMap.
+     * \param name Duration name
+     * \return Return the probe, which is invalid and measures nothing if too many probes have been registered
+     */
+    Probe getProbe(const std::string& name)
+    {
+        std::lock_guard<Spinlock> lock(_probesMutex);
+        if (auto probeIt = _probeIds.find(name); probeIt != _probeIds.end())
+            return {probeIt->second};
+
+        auto probeCount = _probeCount.load(std::memory_order_relaxed);
+        if (probeCount >= SPLASH_TIMER_MAX_PROBES)
+            return {};
+
+        _probeNames[probeCount] = name;
+        _probeIds[name] = probeCount;
+        _probeCount.store(probeCount + 1, std::memory_order_release);
+        return {probeCount};
     }
 
     /**
@@ -220,6 +280,32 @@ class Timer
         return *this;
     }
 
+    Timer& operator<<(Probe probe)
+    {
+        if (!_enabled || probe.id >= SPLASH_TIMER_MAX_PROBES)
+            return *this;
+        _probeSlots[probe.id].start.store(getTime(), std::memory_order_relaxed);
+        return *this;
+    }
+
+    Timer& operator>>(Probe probe)
+    {
+        if (!_enabled || probe.id >= SPLASH_TIMER_MAX_PROBES)
+            return *this;
+
+        auto& slot = _probeSlots[probe.id];
+        auto start = slot.start.load(std::memory_order_relaxed);
+        if (start == 0)
+            return *this;
+        auto duration = getTime() - start;
+        slot.duration.store(duration, std::memory_order_relaxed);
+        slot.measured.store(true, std::memory_order_release);
+
+        if (TraceRecorder::get().isRecording())
+            TraceRecorder::get().addSpan("timer", _probeNames[probe.id], start, duration);
+        return *this;
+    }
+
     Timer& operator>>(unsigned long long duration)
     {
         std::lock_guard<Spinlock> lock(_timerMutex);
@@ -266,15 +352,33 @@ class Timer
      * \brief Set the master clock time
      * \param clock Master clock value
      */
-    void setMasterClock(const Timer::Point& clock)
+    void setMasterClock(const Timer::Point& clock) { setMasterClock(clock, getTime()); }
+
+    /**
+     * \brief Set the master clock time, along with the local time at which it took this value
+     * This is used when the clock is received from another process, to compensate for the transmission delay
+     * \param clock Master clock value
+     * \param updateTime Local time when the master clock took this value, in us
+     */
+    void setMasterClock(const Timer::Point& clock, int64_t updateTime)
     {
         std::lock_guard<Spinlock> lockClock(_clockMutex);
         if (clock != _clock)
-            _lastMasterClockUpdate = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch());
+            _lastMasterClockUpdate = std::chrono::microseconds(updateTime);
         _clockSet = true;
         _clock = clock;
     }
 
+    /**
+     * \brief Get the local time at which the master clock was last updated
+     * \return Return the update time in us, 0 if the master clock has never been set
+     */
+    int64_t getMasterClockUpdateTime() const
+    {
+        std::lock_guard<Spinlock> lockClock(_clockMutex);
+        return _lastMasterClockUpdate.count();
+    }
+
     /**
      * Set master clock pause status
      * \param paused True if paused
@@ -349,6 +453,28 @@ class Timer
      */
     static inline int64_t getTime() { return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count(); }
 
+    /**
+     * \brief Set the offset between the local clock and the clock shared by the whole cluster
+     * \param offset Offset in us, to add to the local clock to get the shared clock
+     */
+    void setClockOffset(int64_t offset)
+    {
+        _clockOffset.store(offset, std::memory_order_relaxed);
+        TraceRecorder::get().setClockOffset(offset);
+    }
+
+    /**
+     * \brief Get the offset between the local clock and the clock shared by the whole cluster
+     * \return Return the offset in us
+     */
+    int64_t getClockOffset() const { return _clockOffset.load(std::memory_order_relaxed); }
+
+    /**
+     * \brief Get the current time of the clock shared by the whole cluster, which is the World clock
+     * \return Return the shared time in us
+     */
+    int64_t getSharedTime() const { return getTime() + getClockOffset(); }
+
   private:
     Timer() {}
     ~Timer() {}
@@ -370,6 +496,35 @@ class Timer
     std::chrono::microseconds _lastMasterClockUpdate{};
     Timer::Point _clock;
     bool _clockSet{false};
+    std::atomic_int64_t _clockOffset{0}; //!< Offset to the shared clock, see setClockOffset
+
+    struct alignas(64) ProbeSlot // Aligned to avoid false sharing between probes used by different threads
+    {
+        std::atomic_int64_t start{0};
+        std::atomic_uint64_t duration{0};
+        std::atomic_bool measured{false};
+    };
+    std::array<ProbeSlot, SPLASH_TIMER_MAX_PROBES> _probeSlots{};
+    std::array<std::string, SPLASH_TIMER_MAX_PROBES> _probeNames{};
+    std::unordered_map<std::string, uint32_t> _probeIds{};
+    std::atomic_uint32_t _probeCount{0};
+    mutable Spinlock _probesMutex;
+
+    /**
+     * \brief Find the probe registered for the given name
+     * \param name Duration name
+     * \return Return the probe, invalid if none is registered for this name
+     */
+    Probe findProbe(const std::string& name) const
+    {
+        if (_probeCount.load(std::memory_order_acquire) == 0)
+            return {};
+
+        std::lock_guard<Spinlock> lock(_probesMutex);
+        if (auto probeIt = _probeIds.find(name); probeIt != _probeIds.end())
+            return {probeIt->second};
+        return {};
+    }
 
     /**
      * \brief Start a duration measurement
@@ -407,6 +562,9 @@ class Timer
                 _durationMap[name] = currentTime - timeIt->second;
             else
                 durationIt->second = currentTime - timeIt->second;
+
+            if (TraceRecorder::get().isRecording())
+                TraceRecorder::get().addSpan("timer", name, timeIt->second, currentTime - timeIt->second);
         }
     }
 };
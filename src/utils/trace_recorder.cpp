@@ -0,0 +1,166 @@
+#include "./utils/trace_recorder.h"
+
+#include <fstream>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include "./utils/log.h"
+
+// Period at which the collecting thread gathers the recorded spans, in ms
+#define SPLASH_TRACE_COLLECT_PERIOD 10
+
+using namespace std;
+
+namespace Splash
+{
+
+namespace
+{
+/*************/
+string escapeJson(const string& str)
+{
+    string escaped;
+    escaped.reserve(str.size());
+    for (auto c : str)
+    {
+        if (c == '"' || c == '\\')
+        {
+            escaped += '\\';
+            escaped += c;
+        }
+        else if (static_cast<unsigned char>(c) < 0x20)
+        {
+            escaped += ' ';
+        }
+        else
+        {
+            escaped += c;
+        }
+    }
+    return escaped;
+}
+} // namespace
+
+/*************/
+uint64_t TraceRecorder::getCurrentThreadId()
+{
+    thread_local uint64_t threadId = static_cast<uint64_t>(syscall(SYS_gettid));
+    return threadId;
+}
+
+/*************/
+bool TraceRecorder::start()
+{
+    lock_guard<mutex> lock(_recordingMutex);
+    if (_recording)
+        return false;
+
+    // Spans pushed after the end of the previous recording are dropped
+    Event event;
+    while (_ring.pop(event))
+        continue;
+    _events.clear();
+    _droppedEvents = 0;
+
+    _recording = true;
+    _collectThread = thread([this]() {
+        while (_recording)
+        {
+            collect();
+            this_thread::sleep_for(chrono::milliseconds(SPLASH_TRACE_COLLECT_PERIOD));
+        }
+    });
+
+    return true;
+}
+
+/*************/
+bool TraceRecorder::stop(const string& path)
+{
+    lock_guard<mutex> lock(_recordingMutex);
+    if (!_recording)
+        return false;
+
+    _recording = false;
+    if (_collectThread.joinable())
+        _collectThread.join();
+    collect();
+
+    ofstream file(path, ios::out | ios::trunc);
+    if (!file.is_open())
+    {
+        Log::get() << Log::WARNING << "TraceRecorder::" << __FUNCTION__ << " - Unable to open file " << path << " for writing" << Log::endl;
+        return false;
+    }
+
+    auto pid = static_cast<uint64_t>(getpid());
+    file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+
+    {
+        lock_guard<mutex> lockNames(_namesMutex);
+        file << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":" << pid << ",\"tid\":0,\"args\":{\"name\":\"" << escapeJson(_processName.empty() ? "splash" : _processName)
+             << "\"}}";
+        file << ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":" << pid << ",\"tid\":" << gpuThreadId << ",\"args\":{\"name\":\"GPU\"}}";
+        for (const auto& [threadId, threadName] : _threadNames)
+            file << ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":" << pid << ",\"tid\":" << threadId << ",\"args\":{\"name\":\"" << escapeJson(threadName) << "\"}}";
+    }
+
+    for (const auto& event : _events)
+        file << ",\n{\"name\":\"" << escapeJson(event.name) << "\",\"cat\":\"" << event.category << "\",\"ph\":\"X\",\"ts\":" << event.timestamp << ",\"dur\":" << event.duration
+             << ",\"pid\":" << pid << ",\"tid\":" << event.threadId << "}";
+    file << "\n]}\n";
+
+    if (_droppedEvents != 0)
+        Log::get() << Log::WARNING << "TraceRecorder::" << __FUNCTION__ << " - " << _droppedEvents.load() << " spans were dropped from the trace" << Log::endl;
+    Log::get() << Log::MESSAGE << "TraceRecorder::" << __FUNCTION__ << " - Trace with " << _events.size() << " spans written to " << path << Log::endl;
+
+    _events.clear();
+    _events.shrink_to_fit();
+    return true;
+}
+
+/*************/
+void TraceRecorder::addSpan(const char* category, const string& name, int64_t start, int64_t duration, uint64_t threadId)
+{
+    if (!isRecording())
+        return;
+
+    Event event;
+    event.name = name;
+    event.category = category;
+    event.timestamp = start + _clockOffset.load(std::memory_order_relaxed);
+    event.duration = duration;
+    event.threadId = threadId;
+    if (!_ring.push(event))
+        _droppedEvents.fetch_add(1, std::memory_order_relaxed);
+}
+
+/*************/
+void TraceRecorder::setProcessName(const string& name)
+{
+    lock_guard<mutex> lockNames(_namesMutex);
+    if (_processName.empty())
+        _processName = name;
+}
+
+/*************/
+void TraceRecorder::setThreadName(const string& name)
+{
+    lock_guard<mutex> lockNames(_namesMutex);
+    _threadNames[getCurrentThreadId()] = name;
+}
+
+/*************/
+void TraceRecorder::collect()
+{
+    Event event;
+    while (_ring.pop(event))
+    {
+        if (_events.size() < SPLASH_TRACE_MAX_EVENTS)
+            _events.push_back(event);
+        else
+            _droppedEvents.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+} // namespace Splash
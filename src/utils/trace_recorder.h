@@ -0,0 +1,205 @@
+/*
+ * Copyright (C) 2026 Emmanuel Durand
+ *
+ * This file is part of Splash.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Splash is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Splash.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * @trace_recorder.h
+ * Recording of timed spans from all threads, exported as a Chrome / Perfetto trace
+ */
+
+#ifndef SPLASH_TRACE_RECORDER_H
+#define SPLASH_TRACE_RECORDER_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "./utils/mpsc_ring.h"
+
+// Number of spans which can be pushed before the collecting thread gathers them
+#define SPLASH_TRACE_RING_SIZE 65536
+// Maximum number of spans kept in a recording, further spans are dropped
+#define SPLASH_TRACE_MAX_EVENTS 4000000
+
+namespace Splash
+{
+
+/*************/
+//! Recorder of timed spans, from any thread of the process
+//! Spans are pushed to a lock free ring and gathered by a collecting thread while recording,
+//! so that recording costs a few atomic operations per span and nothing when not recording.
+//! Timestamps are converted to the shared clock, so that the traces written by the World and
+//! by each Scene process can be merged in a single timeline.
+class TraceRecorder
+{
+  public:
+    //! Thread id used for the GPU timings lane
+    static constexpr uint64_t gpuThreadId{0};
+
+    struct Event
+    {
+        std::string name{};
+        const char* category{""}; //!< Category, must be a string literal
+        int64_t timestamp{0};     //!< Start time on the shared clock, in us
+        int64_t duration{0};      //!< Duration, in us
+        uint64_t threadId{0};
+    };
+
+  public:
+    /**
+     * \brief Get the singleton
+     * \return Return the TraceRecorder singleton
+     */
+    static TraceRecorder& get()
+    {
+        static auto instance = new TraceRecorder;
+        return *instance;
+    }
+
+    TraceRecorder(const TraceRecorder&) = delete;
+    TraceRecorder& operator=(const TraceRecorder&) = delete;
+
+    /**
+     * \brief Get the local time, with the same clock as Timer::getTime
+     * \return Return the time in us
+     */
+    static inline int64_t getTime() { return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count(); }
+
+    /**
+     * \brief Get the id of the calling thread, as shown in the trace
+     * \return Return the system thread id
+     */
+    static uint64_t getCurrentThreadId();
+
+    /**
+     * \brief Start recording, dropping any previous recording not written
+     * \return Return false if already recording
+     */
+    bool start();
+
+    /**
+     * \brief Stop recording and write the trace to the given file, in the Chrome trace event format
+     * \param path File path
+     * \return Return false if not recording, or if the file could not be written
+     */
+    bool stop(const std::string& path);
+
+    /**
+     * \brief Get whether spans are recorded
+     * \return Return true if recording
+     */
+    bool isRecording() const { return _recording.load(std::memory_order_relaxed); }
+
+    /**
+     * \brief Record a span which already ended
+     * \param category Category, must be a string literal
+     * \param name Span name
+     * \param start Start time on the local clock, in us
+     * \param duration Duration, in us
+     * \param threadId Thread lane of the span, the calling thread if not set
+     */
+    void addSpan(const char* category, const std::string& name, int64_t start, int64_t duration, uint64_t threadId = getCurrentThreadId());
+
+    /**
+     * \brief Set the offset from the local clock to the shared clock
+     * \param offset Offset in us
+     */
+    void setClockOffset(int64_t offset) { _clockOffset.store(offset, std::memory_order_relaxed); }
+
+    /**
+     * \brief Set the process name shown in the trace, if not already set
+     * \param name Process name
+     */
+    void setProcessName(const std::string& name);
+
+    /**
+     * \brief Set the name of the calling thread as shown in the trace
+     * \param name Thread name
+     */
+    void setThreadName(const std::string& name);
+
+  private:
+    std::atomic_bool _recording{false};
+    std::atomic_int64_t _clockOffset{0};
+    MpscRing<Event> _ring{SPLASH_TRACE_RING_SIZE};
+    std::atomic_uint64_t _droppedEvents{0}; //!< Spans dropped because the ring or the recording was full
+
+    std::mutex _recordingMutex{};
+    std::thread _collectThread{};
+    std::vector<Event> _events{};
+
+    std::mutex _namesMutex{};
+    std::string _processName{};
+    std::map<uint64_t, std::string> _threadNames{};
+
+    /**
+     * \brief Constructor
+     */
+    TraceRecorder() = default;
+
+    /**
+     * \brief Move the spans from the ring to the recording
+     */
+    void collect();
+};
+
+/*************/
+//! Span measured over the lifetime of the object
+class TraceSpan
+{
+  public:
+    /**
+     * \brief Constructor, starts the span if recording
+     * \param category Category, must be a string literal
+     * \param name Span name
+     */
+    TraceSpan(const char* category, const std::string& name)
+        : _category(category)
+    {
+        if (!TraceRecorder::get().isRecording())
+            return;
+        _name = name;
+        _start = TraceRecorder::getTime();
+    }
+
+    /**
+     * \brief Destructor, ends the span
+     */
+    ~TraceSpan()
+    {
+        if (_start != 0)
+            TraceRecorder::get().addSpan(_category, _name, _start, TraceRecorder::getTime() - _start);
+    }
+
+    TraceSpan(const TraceSpan&) = delete;
+    TraceSpan& operator=(const TraceSpan&) = delete;
+
+  private:
+    const char* _category;
+    std::string _name{};
+    int64_t _start{0};
+};
+
+} // namespace Splash
+
+#endif // SPLASH_TRACE_RECORDER_H
@@ -0,0 +1,181 @@
+#include "./utils/vertex_cache.h"
+
+#include <algorithm>
+#include <cmath>
+#include <deque>
+
+using namespace std;
+
+namespace Splash
+{
+namespace VertexCache
+{
+
+namespace
+{
+constexpr float cacheDecayPower = 1.5f;
+constexpr float lastTriangleScore = 0.75f;
+constexpr float valenceBoostScale = 2.f;
+constexpr float valenceBoostPower = 0.5f;
+
+/*************/
+float getVertexScore(int cachePosition, uint32_t remainingTriangles, uint32_t cacheSize)
+{
+    // Vertices used by no remaining triangle are not worth anything
+    if (remainingTriangles == 0)
+        return -1.f;
+
+    float score = 0.f;
+    if (cachePosition >= 0)
+    {
+        // The vertices of the last triangle get a fixed score, so that the next one does not reuse them too eagerly
+        if (cachePosition < 3)
+            score = lastTriangleScore;
+        else
+            score = pow(1.f - static_cast<float>(cachePosition - 3) / static_cast<float>(cacheSize - 3), cacheDecayPower);
+    }
+
+    // Vertices with few triangles left are favored, so that they get out of the way
+    return score + valenceBoostScale * pow(static_cast<float>(remainingTriangles), -valenceBoostPower);
+}
+} // namespace
+
+/*************/
+vector<uint32_t> optimizeTriangleOrder(const vector<uint32_t>& indices, uint32_t vertexCount, uint32_t cacheSize)
+{
+    const auto triangleCount = static_cast<uint32_t>(indices.size() / 3);
+    if (indices.size() % 3 != 0 || cacheSize < 4)
+        return {};
+    for (auto index : indices)
+        if (index >= vertexCount)
+            return {};
+
+    // Triangles of each vertex, as offsets in a single array
+    vector<uint32_t> triangleOffsets(vertexCount + 1, 0);
+    for (auto index : indices)
+        ++triangleOffsets[index + 1];
+    for (uint32_t vertex = 0; vertex < vertexCount; ++vertex)
+        triangleOffsets[vertex + 1] += triangleOffsets[vertex];
+
+    vector<uint32_t> vertexTriangles(indices.size());
+    vector<uint32_t> remainingTriangles(vertexCount, 0);
+    for (uint32_t triangle = 0; triangle < triangleCount; ++triangle)
+    {
+        for (uint32_t corner = 0; corner < 3; ++corner)
+        {
+            auto vertex = indices[triangle * 3 + corner];
+            vertexTriangles[triangleOffsets[vertex] + remainingTriangles[vertex]++] = triangle;
+        }
+    }
+
+    vector<float> vertexScores(vertexCount);
+    for (uint32_t vertex = 0; vertex < vertexCount; ++vertex)
+        vertexScores[vertex] = getVertexScore(-1, remainingTriangles[vertex], cacheSize);
+
+    vector<float> triangleScores(triangleCount);
+    for (uint32_t triangle = 0; triangle < triangleCount; ++triangle)
+        triangleScores[triangle] = vertexScores[indices[triangle * 3]] + vertexScores[indices[triangle * 3 + 1]] + vertexScores[indices[triangle * 3 + 2]];
+
+    vector<bool> emitted(triangleCount, false);
+    vector<uint32_t> order;
+    order.reserve(triangleCount);
+
+    // The cache holds the vertices of the last emitted triangles, most recent first
+    vector<uint32_t> cache;
+    cache.reserve(cacheSize + 3);
+    uint32_t scanPosition = 0;
+
+    while (order.size() < triangleCount)
+    {
+        // The best triangle is looked for among the ones using a cached vertex, and among all the others only if there is none
+        int64_t bestTriangle = -1;
+        float bestScore = -1.f;
+        for (auto vertex : cache)
+        {
+            for (uint32_t i = triangleOffsets[vertex]; i < triangleOffsets[vertex] + remainingTriangles[vertex]; ++i)
+            {
+                auto triangle = vertexTriangles[i];
+                if (triangleScores[triangle] > bestScore)
+                {
+                    bestScore = triangleScores[triangle];
+                    bestTriangle = triangle;
+                }
+            }
+        }
+
+        if (bestTriangle < 0)
+        {
+            while (emitted[scanPosition])
+                ++scanPosition;
+            bestTriangle = scanPosition;
+        }
+
+        const auto triangle = static_cast<uint32_t>(bestTriangle);
+        emitted[triangle] = true;
+        order.push_back(triangle);
+
+        // The triangle is removed from the lists of its vertices, which are moved to the front of the cache
+        for (uint32_t corner = 0; corner < 3; ++corner)
+        {
+            auto vertex = indices[triangle * 3 + corner];
+            auto first = vertexTriangles.begin() + triangleOffsets[vertex];
+            auto last = first + remainingTriangles[vertex];
+            auto triangleIt = find(first, last, triangle);
+            iter_swap(triangleIt, last - 1);
+            --remainingTriangles[vertex];
+
+            if (auto cacheIt = find(cache.begin(), cache.end(), vertex); cacheIt != cache.end())
+                cache.erase(cacheIt);
+        }
+        for (uint32_t corner = 0; corner < 3; ++corner)
+            cache.insert(cache.begin(), indices[triangle * 3 + 2 - corner]);
+
+        // Scores are only updated for the vertices whose cache position changed, and the triangles using them
+        for (uint32_t position = 0; position < cache.size(); ++position)
+        {
+            auto vertex = cache[position];
+            auto cachePosition = position < cacheSize ? static_cast<int>(position) : -1;
+            auto score = getVertexScore(cachePosition, remainingTriangles[vertex], cacheSize);
+            auto scoreDelta = score - vertexScores[vertex];
+            vertexScores[vertex] = score;
+            for (uint32_t i = triangleOffsets[vertex]; i < triangleOffsets[vertex] + remainingTriangles[vertex]; ++i)
+                triangleScores[vertexTriangles[i]] += scoreDelta;
+        }
+
+        if (cache.size() > cacheSize)
+            cache.resize(cacheSize);
+    }
+
+    return order;
+}
+
+/*************/
+float getAverageCacheMissRatio(const vector<uint32_t>& indices, uint32_t vertexCount, uint32_t cacheSize)
+{
+    const auto triangleCount = indices.size() / 3;
+    if (triangleCount == 0 || cacheSize == 0)
+        return 0.f;
+
+    deque<uint32_t> cache;
+    vector<bool> cached(vertexCount, false);
+    size_t misses = 0;
+    for (auto index : indices)
+    {
+        if (index >= vertexCount || cached[index])
+            continue;
+
+        ++misses;
+        cache.push_back(index);
+        cached[index] = true;
+        if (cache.size() > cacheSize)
+        {
+            cached[cache.front()] = false;
+            cache.pop_front();
+        }
+    }
+
+    return static_cast<float>(misses) / static_cast<float>(triangleCount);
+}
+
+} // namespace VertexCache
+} // namespace Splash
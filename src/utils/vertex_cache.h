@@ -0,0 +1,62 @@
+/*
+ * Copyright (C) 2026 Emmanuel Durand
+ *
+ * This file is part of Splash.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Splash is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Splash.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * @vertex_cache.h
+ * Reordering of the triangles of a mesh for vertex locality
+ */
+
+#ifndef SPLASH_VERTEX_CACHE_H
+#define SPLASH_VERTEX_CACHE_H
+
+#include <cstdint>
+#include <vector>
+
+namespace Splash
+{
+namespace VertexCache
+{
+
+//! Size of the simulated vertex cache, in vertices
+constexpr uint32_t defaultCacheSize = 32;
+
+/**
+ * Get an order of the triangles in which consecutive triangles share as many vertices as possible
+ * This follows Tom Forsyth's linear-speed vertex cache optimization, which scores the vertices
+ * by their position in a simulated LRU cache and by the number of triangles still using them.
+ * \param indices Vertex indices, three per triangle
+ * \param vertexCount Number of vertices, all indices being lower than it
+ * \param cacheSize Size of the simulated cache
+ * \return Return the triangle indices in their new order, or an empty vector if the indices are invalid
+ */
+std::vector<uint32_t> optimizeTriangleOrder(const std::vector<uint32_t>& indices, uint32_t vertexCount, uint32_t cacheSize = defaultCacheSize);
+
+/**
+ * Get the average number of cache misses per triangle, simulating a FIFO vertex cache
+ * \param indices Vertex indices, three per triangle
+ * \param vertexCount Number of vertices, all indices being lower than it
+ * \param cacheSize Size of the simulated cache
+ * \return Return the average cache miss ratio, between 0.5 for the best meshes and 3
+ */
+float getAverageCacheMissRatio(const std::vector<uint32_t>& indices, uint32_t vertexCount, uint32_t cacheSize = defaultCacheSize);
+
+} // namespace VertexCache
+} // namespace Splash
+
+#endif // SPLASH_VERTEX_CACHE_H
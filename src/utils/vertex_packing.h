@@ -0,0 +1,92 @@
+/*
+ * Copyright (C) 2026 Emmanuel Durand
+ *
+ * This file is part of Splash.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Splash is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Splash.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * @vertex_packing.h
+ * Conversion of vertex attributes to compact GPU formats, unpacked by the vertex fetch as normalized integers
+ */
+
+#ifndef SPLASH_VERTEX_PACKING_H
+#define SPLASH_VERTEX_PACKING_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+namespace Splash
+{
+namespace VertexPacking
+{
+
+/**
+ * Pack a normal to the signed normalized 2_10_10_10 reversed format, x being in the lowest bits
+ * \param x X component, in [-1, 1]
+ * \param y Y component, in [-1, 1]
+ * \param z Z component, in [-1, 1]
+ * \param w W component, rounded to -1, 0 or 1
+ * \return Return the packed normal
+ */
+inline uint32_t packNormal(float x, float y, float z, float w)
+{
+    auto packComponent = [](float value, int32_t maxValue, int bits) {
+        auto quantized = static_cast<int32_t>(std::lround(std::clamp(value, -1.f, 1.f) * static_cast<float>(maxValue)));
+        return static_cast<uint32_t>(quantized) & ((1u << bits) - 1);
+    };
+
+    return packComponent(x, 511, 10) | (packComponent(y, 511, 10) << 10) | (packComponent(z, 511, 10) << 20) | (packComponent(w, 1, 2) << 30);
+}
+
+/**
+ * Pack normals, given as four floats each, to the signed normalized 2_10_10_10 reversed format
+ * \param normals Normals, four floats per vertex
+ * \param count Vertex count
+ * \return Return the packed normals
+ */
+inline std::vector<uint32_t> packNormals(const float* normals, size_t count)
+{
+    std::vector<uint32_t> packed(count);
+    for (size_t i = 0; i < count; ++i)
+        packed[i] = packNormal(normals[i * 4], normals[i * 4 + 1], normals[i * 4 + 2], normals[i * 4 + 3]);
+    return packed;
+}
+
+/**
+ * Pack texture coordinates to unsigned normalized 16 bits integers, if they all lie in [0, 1]
+ * Their precision is then 1/65535, below the texel size of any texture
+ * \param texCoords Texture coordinates, two floats per vertex
+ * \param count Vertex count
+ * \param packed Set to the packed coordinates
+ * \return Return false if some coordinates are out of [0, 1], in which case they can not be packed
+ */
+inline bool packTexCoords(const float* texCoords, size_t count, std::vector<uint16_t>& packed)
+{
+    if (!std::all_of(texCoords, texCoords + count * 2, [](float value) { return value >= 0.f && value <= 1.f; }))
+        return false;
+
+    packed.resize(count * 2);
+    for (size_t i = 0; i < count * 2; ++i)
+        packed[i] = static_cast<uint16_t>(std::lround(texCoords[i] * 65535.f));
+    return true;
+}
+
+} // namespace VertexPacking
+} // namespace Splash
+
+#endif // SPLASH_VERTEX_PACKING_H
@@ -1,5 +1,7 @@
 # This should should be ran within Splash:
 # splash -P integration_tests.py
+# The performance mode is best ran with the headless renderer:
+# splash --headless -P integration_tests.py -- --perf
 
 import argparse
 import os
@@ -10,12 +12,26 @@ from unittest import TestLoader, TestResult
 
 
 TEST_CASES_PATH = f"{os.path.dirname(os.path.abspath(__file__))}/test_cases"
+PERF_CASES_PATH = f"{os.path.dirname(os.path.abspath(__file__))}/performanceTests.json"
+PERF_BASELINES_PATH = f"{os.path.dirname(os.path.abspath(__file__))}/performance_baselines.json"
+
+sys.path.insert(0, os.path.dirname(os.path.abspath(__file__)))
+import performance
 
 
 def splash_init() -> None:
     parser = argparse.ArgumentParser()
     parser.add_argument('--pattern', dest='pattern', type=str, default="test*.py")
     parser.add_argument('--list', dest='list', action='store_true', default=False)
+    parser.add_argument('--perf', dest='perf', action='store_true', default=False,
+                        help="Run the performance cases instead of the tests")
+    parser.add_argument('--perf-cases', dest='perf_cases', type=str, default=PERF_CASES_PATH)
+    parser.add_argument('--perf-filter', dest='perf_filter', type=str, default="",
+                        help="Only run the performance cases whose name contains this string")
+    parser.add_argument('--baselines', dest='baselines', type=str, default=PERF_BASELINES_PATH)
+    parser.add_argument('--update-baselines', dest='update_baselines', action='store_true', default=False)
+    parser.add_argument('--report', dest='report', type=str, default="",
+                        help="Write the performance report as JSON to this file")
     args = parser.parse_args()
 
     if args.list is True:
@@ -28,6 +44,17 @@ def splash_init() -> None:
         for file in files:
             print(f"- {file}")
         print("\n")
+    elif args.perf is True:
+        success = performance.run(
+            cases_path=args.perf_cases,
+            baselines_path=args.baselines,
+            report_path=args.report,
+            pattern=args.perf_filter,
+            update_baselines=args.update_baselines
+        )
+        # Splash exits with the status of an uncaught SystemExit, which makes the check target fail
+        if not success:
+            sys.exit(1)
     else:
         runTests(pattern=args.pattern)
 
@@ -0,0 +1,171 @@
+# Performance mode of the integration tests: each case is run for a number of frames,
+# the loop timings published in the tree are collected and compared against stored baselines.
+
+import json
+import os
+import splash
+
+from statistics import mean, median
+from time import sleep, strftime, monotonic
+
+
+def _percentile(samples: list, percentile: float) -> float:
+    ordered = sorted(samples)
+    index = min(len(ordered) - 1, max(0, int(round(percentile / 100.0 * (len(ordered) - 1)))))
+    return float(ordered[index])
+
+
+def _frame_counts() -> dict:
+    return {
+        root: values["frame_count"]
+        for root, values in splash.get_root_branch_values("stats").items()
+        if "frame_count" in values
+    }
+
+
+def _wait_for_frames(frames: int, timeout: float) -> bool:
+    """Wait for all the Scenes to render the given number of frames, or until the timeout"""
+    start_counts = _frame_counts()
+    start = monotonic()
+    while monotonic() - start < timeout:
+        counts = _frame_counts()
+        if counts and all(counts[root] - start_counts.get(root, counts[root]) >= frames for root in counts):
+            return True
+        sleep(0.01)
+    return False
+
+
+def run_case(case: dict, defaults: dict, base_dir: str) -> dict:
+    """
+    Run a performance case and collect the timings of its metrics, in microseconds
+    Returns the statistics of each metric, as {root: {metric: {"mean", "p50", "p95", "samples"}}}
+    """
+    frames = case.get("frames", defaults.get("frames", 600))
+    warmup_frames = case.get("warmup_frames", defaults.get("warmup_frames", 120))
+    metrics = case.get("metrics", defaults.get("metrics", ["loop_scene"]))
+
+    if "project" in case:
+        splash.set_world_attribute("loadProject", [os.path.join(base_dir, case["project"])])
+    for command in case.get("commands", []):
+        splash.set_world_attribute(command[0], command[1])
+    if not _wait_for_frames(warmup_frames, timeout=30.0):
+        print(f"Performance case {case['name']}: the Scenes did not render any frame")
+        return {}
+
+    # Samples are taken each time a Scene renders a new frame
+    samples = {}
+    last_counts = _frame_counts()
+    collected = 0
+    start = monotonic()
+    while collected < frames and monotonic() - start < 10.0 + frames / 10.0:
+        counts = _frame_counts()
+        new_frames = [root for root in counts if counts[root] != last_counts.get(root)]
+        if not new_frames:
+            sleep(0.001)
+            continue
+
+        durations = splash.get_root_branch_values("durations")
+        for root in new_frames + ["world"]:
+            for metric in metrics:
+                if metric in durations.get(root, {}):
+                    samples.setdefault(root, {}).setdefault(metric, []).append(durations[root][metric])
+        last_counts = counts
+        collected += 1
+
+    return {
+        root: {
+            metric: {
+                "mean": mean(values),
+                "p50": median(values),
+                "p95": _percentile(values, 95.0),
+                "samples": len(values)
+            }
+            for metric, values in root_samples.items()
+        }
+        for root, root_samples in samples.items()
+    }
+
+
+def compare(results: dict, baselines: dict, tolerance: float) -> list:
+    """
+    Compare the results of a case with its baseline
+    Returns a list of (root, metric, statistic, baseline, current, ratio, status) tuples
+    """
+    comparisons = []
+    for root, metrics in results.items():
+        for metric, statistics in metrics.items():
+            baseline = baselines.get(root, {}).get(metric)
+            for statistic in ("mean", "p95"):
+                current = statistics[statistic]
+                if baseline is None or not baseline.get(statistic):
+                    comparisons.append((root, metric, statistic, None, current, None, "new"))
+                    continue
+
+                ratio = current / baseline[statistic]
+                if ratio > 1.0 + tolerance:
+                    status = "slower"
+                elif ratio < 1.0 - tolerance:
+                    status = "faster"
+                else:
+                    status = "same"
+                comparisons.append((root, metric, statistic, baseline[statistic], current, ratio, status))
+    return comparisons
+
+
+def run(cases_path: str, baselines_path: str, report_path: str, pattern: str, update_baselines: bool) -> bool:
+    """
+    Run the performance cases matching the pattern, and compare them to the baselines
+    Returns False if any metric is slower than its baseline beyond the tolerance
+    """
+    with open(cases_path) as cases_file:
+        definition = json.load(cases_file)
+
+    baselines = {}
+    if os.path.isfile(baselines_path):
+        with open(baselines_path) as baselines_file:
+            baselines = json.load(baselines_file)
+
+    base_dir = os.path.dirname(os.path.abspath(cases_path))
+    report = {"date": strftime("%Y-%m-%dT%H:%M:%S"), "cases": {}}
+    success = True
+
+    for case in definition.get("cases", []):
+        if pattern and pattern not in case["name"]:
+            continue
+
+        print(f"\n================\nPerformance case {case['name']}")
+        results = run_case(case, definition, base_dir)
+        tolerance = case.get("tolerance", definition.get("tolerance", 0.1))
+        comparisons = compare(results, baselines.get(case["name"], {}), tolerance)
+
+        for root, metric, statistic, baseline, current, ratio, status in comparisons:
+            if ratio is None:
+                print(f"  {root}/{metric} {statistic}: {current:.0f}us (no baseline)")
+            else:
+                print(f"  {root}/{metric} {statistic}: {current:.0f}us, baseline {baseline:.0f}us ({(ratio - 1.0) * 100.0:+.1f}%, {status})")
+            if status == "slower":
+                success = False
+
+        report["cases"][case["name"]] = {
+            "results": results,
+            "comparisons": [
+                {"root": c[0], "metric": c[1], "statistic": c[2], "baseline": c[3], "current": c[4], "ratio": c[5], "status": c[6]}
+                for c in comparisons
+            ]
+        }
+        if update_baselines and results:
+            baselines[case["name"]] = results
+
+    print(f"\nPerformance {'within tolerance' if success else 'regression detected'}")
+
+    if report_path:
+        with open(report_path, "w") as report_file:
+            json.dump(report, report_file, indent=2)
+        print(f"Report written to {report_path}")
+
+    if update_baselines:
+        with open(baselines_path, "w") as baselines_file:
+            json.dump(baselines, baselines_file, indent=2, sort_keys=True)
+        print(f"Baselines written to {baselines_path}")
+
+    return success
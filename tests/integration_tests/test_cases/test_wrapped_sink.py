@@ -16,6 +16,10 @@ class TestWrappedSink(SplashTestCase):
         sleep(0.5)
         image = sink.grab()
         print("Sink linked, grabbed image:", image.hex())
+        image.release()
+
+        with sink.grab(timeout=1.0) as image:
+            print("Sink linked, waited for next image of size:", len(image))
         sink.close()
         sink.unlink()
 
@@ -0,0 +1,366 @@
+/*
+ * Copyright (C) 2026 Emmanuel Durand
+ *
+ * This file is part of Splash.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Splash is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Splash.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Micro benchmarks of the core hot paths: serialization, tree replication,
+ * attribute dispatch and inter-process links
+ * Run with --json to get an output compatible with the google-benchmark tools,
+ * and with any other argument to only run the benchmarks whose name contains it.
+ */
+
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+#include "./core/base_object.h"
+#include "./core/imagebuffer.h"
+#include "./core/root_object.h"
+#include "./core/serialized_object.h"
+#include "./core/serializer.h"
+#include "./core/tree.h"
+#include "./core/value.h"
+#include "./image/image.h"
+#include "./utils/log.h"
+
+#include "./perf_harness.h"
+
+using namespace Splash;
+
+/*************/
+// Prevents the compiler from optimizing away a computed value
+template <typename T>
+inline void doNotOptimize(const T& value)
+{
+    asm volatile("" : : "r,m"(value) : "memory");
+}
+
+/*************/
+class BaseObjectMock : public BaseObject
+{
+  public:
+    BaseObjectMock()
+        : BaseObject()
+    {
+        addAttribute(
+            "position",
+            [&](const Values& args) {
+                _position = {args[0].as<float>(), args[1].as<float>(), args[2].as<float>()};
+                return true;
+            },
+            [&]() -> Values { return {_position[0], _position[1], _position[2]}; },
+            {'r', 'r', 'r'});
+
+        // Filler attributes, so that the lookup is done in a realistically sized map
+        for (int i = 0; i < 64; ++i)
+            addAttribute(
+                "filler_" + std::to_string(i), [](const Values&) { return true; }, []() -> Values { return {}; }, {});
+    }
+
+  private:
+    std::vector<float> _position{0.f, 0.f, 0.f};
+};
+
+/*************/
+class RootObjectMock : public RootObject
+{
+  public:
+    std::atomic<int64_t> _lastPong{-1};
+    std::atomic<uint64_t> _receivedBuffers{0};
+
+  public:
+    RootObjectMock(const std::string& name, const std::string& peer)
+        : RootObject()
+        , _peer(peer)
+    {
+        _name = name;
+        _tree.setName(_name);
+        _link = std::make_unique<Link>(this, _name);
+
+        addAttribute(
+            "ping",
+            [&](const Values& args) {
+                sendMessage(_peer, "pong", args);
+                return true;
+            },
+            {'i'});
+        addAttribute(
+            "pong",
+            [&](const Values& args) {
+                _lastPong = args[0].as<int64_t>();
+                return true;
+            },
+            {'i'});
+    }
+
+    void connect() { _link->connectTo(_peer, ""); }
+    std::shared_ptr<SerializedObject> allocate(size_t size) { return _link->allocateBuffer(size); }
+    void send(const std::shared_ptr<SerializedObject>& buffer) { _link->sendBuffer("payload", buffer); }
+    void ping(int64_t index) { sendMessage(_peer, "ping", {index}); }
+
+  protected:
+    bool handleSerializedObject(const std::string& /*name*/, const std::shared_ptr<SerializedObject>& /*obj*/) override
+    {
+        ++_receivedBuffers;
+        return true;
+    }
+
+  private:
+    std::string _peer;
+};
+
+/*************/
+void addSerializerBenchmarks(Perf::Suite& suite)
+{
+    std::vector<float> floats(1 << 16);
+    for (size_t i = 0; i < floats.size(); ++i)
+        floats[i] = static_cast<float>(i);
+
+    suite.add(
+        "Serial::serialize<vector<float>>/65536",
+        [=](uint64_t iterations) {
+            std::vector<uint8_t> buffer;
+            for (uint64_t i = 0; i < iterations; ++i)
+            {
+                buffer.clear();
+                Serial::serialize(floats, buffer);
+                doNotOptimize(buffer.data());
+            }
+        },
+        floats.size() * sizeof(float));
+
+    std::vector<uint8_t> serializedFloats;
+    Serial::serialize(floats, serializedFloats);
+    suite.add(
+        "Serial::deserialize<vector<float>>/65536",
+        [=](uint64_t iterations) {
+            for (uint64_t i = 0; i < iterations; ++i)
+            {
+                auto result = Serial::deserialize<std::vector<float>>(serializedFloats);
+                doNotOptimize(result.data());
+            }
+        },
+        floats.size() * sizeof(float));
+
+    std::vector<std::string> strings(1024, "Some value sent over the link");
+    suite.add("Serial::serialize<vector<string>>/1024", [=](uint64_t iterations) {
+        std::vector<uint8_t> buffer;
+        for (uint64_t i = 0; i < iterations; ++i)
+        {
+            buffer.clear();
+            Serial::serialize(strings, buffer);
+            doNotOptimize(buffer.data());
+        }
+    });
+
+    std::vector<uint8_t> serializedStrings;
+    Serial::serialize(strings, serializedStrings);
+    suite.add("Serial::deserialize<vector<string>>/1024", [=](uint64_t iterations) {
+        for (uint64_t i = 0; i < iterations; ++i)
+        {
+            auto result = Serial::deserialize<std::vector<std::string>>(serializedStrings);
+            doNotOptimize(result.data());
+        }
+    });
+}
+
+/*************/
+void addImageBenchmarks(Perf::Suite& suite)
+{
+    const std::vector<std::tuple<std::string, uint32_t, uint32_t>> resolutions{{"1080p", 1920, 1080}, {"4K", 3840, 2160}, {"8K", 7680, 4320}};
+    for (const auto& resolution : resolutions)
+    {
+        const auto label = std::get<0>(resolution);
+        auto spec = ImageBufferSpec(std::get<1>(resolution), std::get<2>(resolution), 4, 32, ImageBufferSpec::Type::UINT8, "RGBA");
+        auto source = std::make_shared<Image>(nullptr, spec);
+        auto destination = std::make_shared<Image>(nullptr, spec);
+        const auto bytes = static_cast<uint64_t>(spec.rawSize());
+
+        suite.add(
+            "Image::serialize/" + label,
+            [=](uint64_t iterations) {
+                for (uint64_t i = 0; i < iterations; ++i)
+                {
+                    auto obj = source->serialize();
+                    doNotOptimize(obj->data());
+                }
+            },
+            bytes);
+
+        auto serialized = source->serialize();
+        suite.add(
+            "Image::deserialize/" + label,
+            [=](uint64_t iterations) {
+                for (uint64_t i = 0; i < iterations; ++i)
+                {
+                    // The Image takes ownership of the buffer content, so it is given a fresh copy each time
+                    auto obj = std::make_shared<SerializedObject>();
+                    *obj = *serialized;
+                    destination->deserialize(obj);
+                }
+            },
+            bytes);
+    }
+}
+
+/*************/
+void addTreeBenchmarks(Perf::Suite& suite)
+{
+    for (const int leafCount : {16, 1024})
+    {
+        suite.add("Tree::Root::processQueue/" + std::to_string(leafCount) + "_seeds", [=](uint64_t iterations) {
+            Tree::Root source;
+            Tree::Root destination;
+            source.createBranchAt("/world/objects/image");
+            for (int leaf = 0; leaf < leafCount; ++leaf)
+                source.createLeafAt("/world/objects/image/attr_" + std::to_string(leaf));
+            destination.addSeedsToQueue(source.getUpdateSeedList());
+            destination.processQueue();
+
+            for (uint64_t i = 0; i < iterations; ++i)
+            {
+                for (int leaf = 0; leaf < leafCount; ++leaf)
+                    source.setValueForLeafAt("/world/objects/image/attr_" + std::to_string(leaf), Values({leaf, 3.14f, "value"}));
+                destination.addSeedsToQueue(source.getUpdateSeedList());
+                destination.processQueue();
+            }
+        });
+    }
+}
+
+/*************/
+void addValueBenchmarks(Perf::Suite& suite)
+{
+    suite.add("Value/construct_float", [](uint64_t iterations) {
+        for (uint64_t i = 0; i < iterations; ++i)
+        {
+            auto value = Value(static_cast<float>(i));
+            doNotOptimize(value);
+        }
+    });
+
+    suite.add("Value/construct_string", [](uint64_t iterations) {
+        for (uint64_t i = 0; i < iterations; ++i)
+        {
+            auto value = Value("a short string value");
+            doNotOptimize(value);
+        }
+    });
+
+    suite.add("Values/construct_mixed_4", [](uint64_t iterations) {
+        for (uint64_t i = 0; i < iterations; ++i)
+        {
+            auto values = Values({static_cast<int64_t>(i), 1.f, "name", Values({1, 2})});
+            doNotOptimize(values);
+        }
+    });
+
+    const auto floats = std::vector<float>(16, 1.f);
+    const auto source = Values(floats.begin(), floats.end());
+    suite.add("Values/copy_16_floats", [=](uint64_t iterations) {
+        for (uint64_t i = 0; i < iterations; ++i)
+        {
+            auto values = source;
+            doNotOptimize(values);
+        }
+    });
+}
+
+/*************/
+void addAttributeBenchmarks(Perf::Suite& suite)
+{
+    auto object = std::make_shared<BaseObjectMock>();
+    suite.add("BaseObject::setAttribute", [=](uint64_t iterations) {
+        for (uint64_t i = 0; i < iterations; ++i)
+            object->setAttribute("position", {static_cast<float>(i), 2.f, 3.f});
+    });
+
+    suite.add("BaseObject::getAttribute", [=](uint64_t iterations) {
+        for (uint64_t i = 0; i < iterations; ++i)
+        {
+            auto values = object->getAttribute("position");
+            doNotOptimize(values);
+        }
+    });
+}
+
+/*************/
+void addLinkBenchmarks(Perf::Suite& suite)
+{
+    const auto suffix = std::to_string(getpid());
+    auto sender = std::make_shared<RootObjectMock>("perf_sender_" + suffix, "perf_receiver_" + suffix);
+    auto receiver = std::make_shared<RootObjectMock>("perf_receiver_" + suffix, "perf_sender_" + suffix);
+    sender->connect();
+    receiver->connect();
+
+    // Wait for the connection to be up before measuring anything
+    for (int64_t attempt = 0; attempt < 100 && sender->_lastPong != attempt - 1; ++attempt)
+    {
+        sender->ping(attempt);
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    }
+
+    suite.add("Link/message_round_trip", [=](uint64_t iterations) {
+        for (uint64_t i = 0; i < iterations; ++i)
+        {
+            const auto index = static_cast<int64_t>(1000 + i);
+            sender->ping(index);
+            while (sender->_lastPong != index)
+                std::this_thread::yield();
+        }
+    });
+
+    for (const size_t size : {size_t(1) << 16, size_t(1920 * 1080 * 4)})
+    {
+        suite.add(
+            "Link/buffer_throughput/" + std::to_string(size),
+            [=](uint64_t iterations) {
+                const auto target = receiver->_receivedBuffers + iterations;
+                for (uint64_t i = 0; i < iterations; ++i)
+                {
+                    auto buffer = sender->allocate(size);
+                    memset(buffer->data(), static_cast<int>(i), size);
+                    sender->send(buffer);
+                }
+                while (receiver->_receivedBuffers < target)
+                    std::this_thread::yield();
+            },
+            size);
+    }
+}
+
+/*************/
+int main(int argc, char** argv)
+{
+    Log::get().setVerbosity(Log::ERROR);
+
+    Perf::Suite suite;
+    addSerializerBenchmarks(suite);
+    addImageBenchmarks(suite);
+    addTreeBenchmarks(suite);
+    addValueBenchmarks(suite);
+    addAttributeBenchmarks(suite);
+    addLinkBenchmarks(suite);
+
+    return suite.run(argc, argv);
+}
@@ -22,101 +22,126 @@
 #include <chrono>
 #include <iostream>
 #include <map>
+#include <random>
+#include <string>
 #include <unordered_map>
 #include <vector>
 
 using namespace Splash;
 
-int main()
+/*************/
+template <typename Key>
+std::vector<Key> generateKeys(size_t count);
+
+template <>
+std::vector<int> generateKeys<int>(size_t count)
 {
-    const size_t count = 1 << 8;
-    const size_t loopCount = 1 << 8;
-    volatile int key;
-    volatile float value;
+    std::vector<int> keys;
+    for (size_t i = 0; i < count; ++i)
+        keys.push_back(static_cast<int>(i));
+    return keys;
+}
 
-    std::cout << "----> DenseMap performance test\n";
+template <>
+std::vector<std::string> generateKeys<std::string>(size_t count)
+{
+    std::vector<std::string> keys;
+    for (size_t i = 0; i < count; ++i)
+        keys.push_back("object_" + std::to_string(i) + "_attribute");
+    return keys;
+}
 
-    /**
-     * DenseMap
-     */
-    std::cout << "DenseMap::insert -> " << std::flush;
-    DenseMap<int, float> dmap{};
+/*************/
+template <typename Func>
+void measure(const std::string& name, size_t loopCount, Func&& func)
+{
+    std::cout << name << " -> " << std::flush;
     auto start = std::chrono::steady_clock::now();
-    for (int loop = 0; loop < loopCount; ++loop)
-    {
-        dmap.clear();
-        for (size_t i = 0; i < count; ++i)
-            dmap.insert({i, static_cast<float>(i)});
-    }
+    for (size_t loop = 0; loop < loopCount; ++loop)
+        func();
     auto end = std::chrono::steady_clock::now();
     auto duration = std::chrono::duration_cast<std::chrono::microseconds>(end - start).count();
     std::cout << duration << "µs\n";
+}
 
-    std::cout << "DenseMap::iterator -> " << std::flush;
-    start = std::chrono::steady_clock::now();
-    for (int loop = 0; loop < loopCount; ++loop)
-        for (const auto& entry : dmap)
-        {
-            key = entry.first;
-            value = entry.second;
-        }
-    end = std::chrono::steady_clock::now();
-    duration = std::chrono::duration_cast<std::chrono::microseconds>(end - start).count();
-    std::cout << duration << "µs\n";
+/*************/
+template <typename Map, typename Key>
+void benchmark(const std::string& mapName, const std::string& keyName, const std::vector<Key>& keys, size_t loopCount)
+{
+    // Lookups are done in a shuffled order, with as many misses as hits
+    std::vector<Key> lookups = keys;
+    const auto missingKeys = generateKeys<Key>(keys.size() * 2);
+    lookups.insert(lookups.end(), missingKeys.begin() + keys.size(), missingKeys.end());
+    std::shuffle(lookups.begin(), lookups.end(), std::mt19937(42));
 
-    /**
-     * std::map
-     */
-    std::cout << "std::map::insert -> " << std::flush;
-    std::map<int, float> map{};
-    start = std::chrono::steady_clock::now();
-    for (int loop = 0; loop < loopCount; ++loop)
-    {
+    const auto prefix = mapName + "<" + keyName + ">[" + std::to_string(keys.size()) + "]";
+    volatile float value;
+    Map map{};
+
+    measure(prefix + "::insert", loopCount, [&]() {
         map.clear();
-        for (size_t i = 0; i < count; ++i)
-            map.insert({i, static_cast<float>(i)});
-    }
-    end = std::chrono::steady_clock::now();
-    duration = std::chrono::duration_cast<std::chrono::microseconds>(end - start).count();
-    std::cout << duration << "µs\n";
+        for (size_t i = 0; i < keys.size(); ++i)
+            map.insert({keys[i], static_cast<float>(i)});
+    });
 
-    std::cout << "std::map::iterator -> " << std::flush;
-    start = std::chrono::steady_clock::now();
-    for (int loop = 0; loop < loopCount; ++loop)
+    measure(prefix + "::iterator", loopCount, [&]() {
         for (const auto& entry : map)
-        {
-            key = entry.first;
             value = entry.second;
-        }
-    end = std::chrono::steady_clock::now();
-    duration = std::chrono::duration_cast<std::chrono::microseconds>(end - start).count();
-    std::cout << duration << "µs\n";
+    });
 
-    /**
-     * std::unordered_map
-     */
-    std::cout << "std::unordered_map::insert -> " << std::flush;
-    std::unordered_map<int, float> unordered_map{};
-    start = std::chrono::steady_clock::now();
-    for (int loop = 0; loop < loopCount; ++loop)
-    {
-        unordered_map.clear();
-        for (size_t i = 0; i < count; ++i)
-            unordered_map.insert({i, static_cast<float>(i)});
-    }
-    end = std::chrono::steady_clock::now();
-    duration = std::chrono::duration_cast<std::chrono::microseconds>(end - start).count();
-    std::cout << duration << "µs\n";
+    measure(prefix + "::find", loopCount, [&]() {
+        for (const auto& key : lookups)
+        {
+            auto it = map.find(key);
+            if (it != map.end())
+                value = it->second;
+        }
+    });
 
-    std::cout << "std::unordered_map::iterator -> " << std::flush;
-    start = std::chrono::steady_clock::now();
-    for (int loop = 0; loop < loopCount; ++loop)
-        for (const auto& entry : unordered_map)
+    // Mixed workload, mostly lookups and updates with a few insertions and removals, like the attributes of an object
+    measure(prefix + "::mixed", loopCount, [&]() {
+        for (size_t i = 0; i < lookups.size(); ++i)
         {
-            key = entry.first;
-            value = entry.second;
+            const auto& key = lookups[i];
+            switch (i % 8)
+            {
+            default:
+            {
+                auto it = map.find(key);
+                if (it != map.end())
+                    value = it->second;
+                break;
+            }
+            case 5:
+                map[key] = static_cast<float>(i);
+                break;
+            case 7:
+                map.erase(key);
+                break;
+            }
         }
-    end = std::chrono::steady_clock::now();
-    duration = std::chrono::duration_cast<std::chrono::microseconds>(end - start).count();
-    std::cout << duration << "µs\n";
+    });
+}
+
+/*************/
+template <typename Key>
+void benchmarkAll(const std::string& keyName, size_t count)
+{
+    const auto keys = generateKeys<Key>(count);
+    const size_t loopCount = std::max<size_t>(1, (1 << 16) / count);
+    benchmark<DenseMap<Key, float>>("DenseMap", keyName, keys, loopCount);
+    benchmark<std::map<Key, float>>("std::map", keyName, keys, loopCount);
+    benchmark<std::unordered_map<Key, float>>("std::unordered_map", keyName, keys, loopCount);
+}
+
+/*************/
+int main()
+{
+    std::cout << "----> DenseMap performance test\n";
+
+    for (const size_t count : {16, 256, 4096})
+    {
+        benchmarkAll<int>("int", count);
+        benchmarkAll<std::string>("string", count);
+    }
 }
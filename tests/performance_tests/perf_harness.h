@@ -0,0 +1,187 @@
+/*
+ * Copyright (C) 2026 Emmanuel Durand
+ *
+ * This file is part of Splash.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Splash is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Splash.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * @perf_harness.h
+ * Minimal micro benchmark harness, with an output compatible with google-benchmark
+ */
+
+#ifndef SPLASH_PERF_HARNESS_H
+#define SPLASH_PERF_HARNESS_H
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace Splash
+{
+namespace Perf
+{
+
+/*************/
+//! Suite of micro benchmarks
+//! Each benchmark is given an iteration count and runs its workload that many times. The count is
+//! raised until a run lasts long enough to be measured reliably, and the fastest of a few runs is kept.
+//! Results are printed as a table, or with --json in the google-benchmark JSON format so that
+//! the existing comparison tools can be used.
+class Suite
+{
+  public:
+    using Workload = std::function<void(uint64_t iterations)>;
+
+    /**
+     * \brief Add a benchmark
+     * \param name Benchmark name
+     * \param workload Workload, running the measured operation the given number of times
+     * \param bytesPerIteration Bytes processed by each iteration, to report a throughput
+     */
+    void add(const std::string& name, Workload workload, uint64_t bytesPerIteration = 0) { _benchmarks.push_back({name, std::move(workload), bytesPerIteration}); }
+
+    /**
+     * \brief Run all benchmarks matching the filter given as argument
+     * \param argc Argument count
+     * \param argv Arguments: --json to output json, any other argument being a filter on the benchmark names
+     * \return Return the process exit code
+     */
+    int run(int argc, char** argv)
+    {
+        bool json = false;
+        std::string filter{};
+        for (int i = 1; i < argc; ++i)
+        {
+            auto arg = std::string(argv[i]);
+            if (arg == "--json")
+                json = true;
+            else
+                filter = arg;
+        }
+
+        std::vector<Result> results;
+        for (const auto& benchmark : _benchmarks)
+        {
+            if (!filter.empty() && benchmark.name.find(filter) == std::string::npos)
+                continue;
+            results.push_back(measure(benchmark));
+            if (!json)
+                printResult(results.back());
+        }
+
+        if (json)
+            printJson(results);
+        return 0;
+    }
+
+  private:
+    static constexpr double _minimumRunDuration{0.2}; //!< Minimum duration of a run, in seconds
+    static constexpr int _runCount{3};                 //!< Number of runs, the fastest being kept
+
+    struct Benchmark
+    {
+        std::string name;
+        Workload workload;
+        uint64_t bytesPerIteration;
+    };
+
+    struct Result
+    {
+        std::string name;
+        uint64_t iterations;
+        double nanosecondsPerIteration;
+        double bytesPerSecond;
+    };
+
+    std::vector<Benchmark> _benchmarks{};
+
+    /**
+     * \brief Measure a benchmark
+     * \param benchmark Benchmark
+     * \return Return the result
+     */
+    static Result measure(const Benchmark& benchmark)
+    {
+        auto runFor = [&](uint64_t iterations) {
+            auto start = std::chrono::steady_clock::now();
+            benchmark.workload(iterations);
+            return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        };
+
+        // Find an iteration count giving a long enough run
+        uint64_t iterations = 1;
+        auto duration = runFor(iterations);
+        while (duration < _minimumRunDuration && iterations < (1ull << 40))
+        {
+            auto factor = duration > 0.0 ? std::clamp(_minimumRunDuration * 1.4 / duration, 2.0, 100.0) : 100.0;
+            iterations = static_cast<uint64_t>(static_cast<double>(iterations) * factor);
+            duration = runFor(iterations);
+        }
+
+        for (int run = 1; run < _runCount; ++run)
+            duration = std::min(duration, runFor(iterations));
+
+        Result result;
+        result.name = benchmark.name;
+        result.iterations = iterations;
+        result.nanosecondsPerIteration = duration * 1e9 / static_cast<double>(iterations);
+        result.bytesPerSecond = benchmark.bytesPerIteration != 0 ? static_cast<double>(benchmark.bytesPerIteration * iterations) / duration : 0.0;
+        return result;
+    }
+
+    /**
+     * \brief Print a result as a table row
+     * \param result Result
+     */
+    static void printResult(const Result& result)
+    {
+        std::cout << std::left << std::setw(48) << result.name << std::right << std::setw(16) << std::fixed << std::setprecision(1) << result.nanosecondsPerIteration << " ns"
+                  << std::setw(14) << result.iterations;
+        if (result.bytesPerSecond != 0.0)
+            std::cout << std::setw(12) << std::setprecision(2) << result.bytesPerSecond / (1024.0 * 1024.0 * 1024.0) << " GiB/s";
+        std::cout << std::endl;
+    }
+
+    /**
+     * \brief Print all results in the google-benchmark JSON format
+     * \param results Results
+     */
+    static void printJson(const std::vector<Result>& results)
+    {
+        std::cout << "{\n  \"benchmarks\": [";
+        for (size_t i = 0; i < results.size(); ++i)
+        {
+            const auto& result = results[i];
+            std::cout << (i == 0 ? "\n" : ",\n") << "    {\"name\": \"" << result.name << "\", \"run_type\": \"iteration\", \"iterations\": " << result.iterations
+                      << ", \"real_time\": " << std::setprecision(3) << std::fixed << result.nanosecondsPerIteration << ", \"cpu_time\": " << result.nanosecondsPerIteration
+                      << ", \"time_unit\": \"ns\"";
+            if (result.bytesPerSecond != 0.0)
+                std::cout << ", \"bytes_per_second\": " << result.bytesPerSecond;
+            std::cout << "}";
+        }
+        std::cout << "\n  ]\n}" << std::endl;
+    }
+};
+
+} // namespace Perf
+} // namespace Splash
+
+#endif // SPLASH_PERF_HARNESS_H
@@ -76,3 +76,31 @@ TEST_CASE("Testing Attribute constructors")
     attr({"Flying machine"});
     CHECK_EQ(attr()[0].as<string>(), "Flying machine");
 }
+
+/*************/
+TEST_CASE("Testing Attribute versions")
+{
+    auto attr = Attribute("attribute");
+    auto version = attr.getVersion();
+    CHECK(attr({42}));
+    CHECK_NE(attr.getVersion(), version);
+
+    version = attr.getVersion();
+    attr();
+    CHECK_EQ(attr.getVersion(), version);
+
+    attr.lock();
+    version = attr.getVersion();
+    CHECK_FALSE(attr({512}));
+    CHECK_EQ(attr.getVersion(), version);
+    attr.unlock();
+
+    attr = Attribute("attribute", [&](const Values&) { return false; }, nullptr, {'i'});
+    version = attr.getVersion();
+    CHECK_FALSE(attr({42}));
+    CHECK_EQ(attr.getVersion(), version);
+
+    // A new attribute never shares the version of the one it replaces
+    auto otherAttr = Attribute("attribute");
+    CHECK_NE(otherAttr.getVersion(), version);
+}
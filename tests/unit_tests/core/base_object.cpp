@@ -30,6 +30,13 @@ class BaseObjectMock : public BaseObject
         addPeriodicTask("counterTask", [this]() -> void { _integer += 2; });
     }
 
+    void setupKeyedTasks()
+    {
+        addTask("float", [this]() -> void { _float = 1.f; });
+        addTask([this]() -> void { _integer = 3; });
+        addTask("float", [this]() -> void { _float = static_cast<float>(_integer); });
+    }
+
     void cleanPeriodicTask() { removePeriodicTask("counterTask"); }
 
     void setupImbricatedPeriodicTasks()
@@ -182,6 +189,59 @@ TEST_CASE("Testing BaseObject attribute registering")
     CHECK(someString != otherString);
 }
 
+/*************/
+TEST_CASE("Testing BaseObject attributes version")
+{
+    auto object = make_shared<BaseObjectMock>();
+    auto version = object->getAttributesVersion();
+
+    object->setAttribute("integer", {42});
+    CHECK_EQ(object->getAttributesVersion(), version + 1);
+
+    // Default attributes do not change the version
+    version = object->getAttributesVersion();
+    object->setAttribute("someAttribute", {42});
+    CHECK_EQ(object->getAttributesVersion(), version);
+
+    // Queued tasks change the version, periodic tasks do not
+    object->setupTasks();
+    object->runTasks();
+    CHECK_EQ(object->getAttributesVersion(), version + 1);
+    object->runTasks();
+    CHECK_EQ(object->getAttributesVersion(), version + 1);
+    object->cleanPeriodicTask();
+}
+
+/*************/
+TEST_CASE("Testing BaseObject attribute access from identifiers")
+{
+    auto object = make_shared<BaseObjectMock>();
+    auto integerId = Attribute::getId("integer");
+    CHECK_EQ(Attribute::getId("integer"), integerId);
+    CHECK_EQ(Attribute::getName(integerId), "integer");
+
+    CHECK(object->setAttribute(integerId, {42}));
+    Values value;
+    CHECK(object->getAttribute(integerId, value));
+    CHECK_EQ(value[0].as<int>(), 42);
+    CHECK_EQ(object->getAttribute("integer").value()[0].as<int>(), 42);
+
+    // Unknown attributes are created by name, as with the string API
+    auto newAttributeId = Attribute::getId("identifiedAttribute");
+    CHECK_FALSE(object->getAttribute(newAttributeId, value));
+    object->setAttribute(newAttributeId, {"Flying machine"});
+    CHECK(object->getAttribute(newAttributeId, value));
+    CHECK_EQ(value[0].as<string>(), "Flying machine");
+
+    // Identifiers must still resolve after attributes are removed
+    object->removeAttributeProxy("float");
+    CHECK_FALSE(object->getAttribute(Attribute::getId("float"), value));
+    CHECK(object->getAttribute(newAttributeId, value));
+    CHECK_EQ(value[0].as<string>(), "Flying machine");
+    CHECK(object->setAttribute(integerId, {1337}));
+    CHECK_EQ(object->getAttribute("integer").value()[0].as<int>(), 1337);
+}
+
 /*************/
 TEST_CASE("Testing BaseObject task and periodic task")
 {
@@ -211,3 +271,20 @@ TEST_CASE("Testing BaseObject task and periodic task")
     object->runTasks();
     CHECK_EQ(object->getAttribute("string").value()[0].as<string>(), "Async task finished!");
 }
+
+/*************/
+TEST_CASE("Testing BaseObject keyed tasks")
+{
+    auto object = make_shared<BaseObjectMock>();
+    object->setupKeyedTasks();
+
+    // Only the latest keyed task runs, after the tasks added before it
+    object->runTasks();
+    CHECK_EQ(object->getAttribute("integer").value()[0].as<int>(), 3);
+    CHECK_EQ(object->getAttribute("float").value()[0].as<float>(), 3.f);
+
+    object->setAttribute("integer", {5});
+    object->setupKeyedTasks();
+    object->runTasks();
+    CHECK_EQ(object->getAttribute("float").value()[0].as<float>(), 3.f);
+}
@@ -72,3 +72,16 @@ TEST_CASE("Testing serialization")
 
     CHECK_NE(timestamp, buffer.getTimestamp());
 }
+
+/*************/
+TEST_CASE("Testing placement")
+{
+    auto buffer = BufferObjectMock();
+    CHECK_EQ(buffer.getPlacement(), "world");
+
+    buffer.setAttribute("placement", {"scene"});
+    CHECK_EQ(buffer.getPlacement(), "scene");
+
+    buffer.setAttribute("placement", {"elsewhere"});
+    CHECK_EQ(buffer.getPlacement(), "scene");
+}
@@ -34,6 +34,14 @@ TEST_CASE("Testing Factory default values")
     auto imageDefaultsIt = defaults.find("image");
     CHECK_NE(imageDefaultsIt->second.find("flip"), imageDefaultsIt->second.end());
 
+    // Default values are applied to the created objects
+    auto image = factory.create("image");
+    REQUIRE(image);
+    Values flip;
+    CHECK(image->getAttribute("flip", flip));
+    REQUIRE_EQ(flip.size(), 1);
+    CHECK_EQ(flip[0].as<int>(), 1);
+
     if (!previousDefaultFile.empty())
         setenv(SPLASH_DEFAULTS_FILE_ENV, previousDefaultFile.c_str(), 1);
 }
@@ -36,6 +36,22 @@ TEST_CASE("Testing ImageBufferSpec comparison")
     CHECK_NE(spec, otherSpec);
 }
 
+/*************/
+TEST_CASE("Testing ImageBufferSpec raw size")
+{
+    auto spec = ImageBufferSpec(512, 256, 3, 24, ImageBufferSpec::Type::UINT8, "RGB");
+    CHECK_EQ(spec.rawSize(), 512 * 256 * 3);
+    spec = ImageBufferSpec(512, 256, 3, 12, ImageBufferSpec::Type::UINT8, "NV12");
+    CHECK_EQ(spec.rawSize(), 512 * 256 * 3 / 2);
+    spec = ImageBufferSpec(512, 256, 3, 24, ImageBufferSpec::Type::UINT16, "P010");
+    CHECK_EQ(spec.rawSize(), 512 * 256 * 3);
+    spec = ImageBufferSpec(512, 256, 3, 12, ImageBufferSpec::Type::UINT8, "I420");
+    CHECK_EQ(spec.rawSize(), 512 * 256 * 3 / 2);
+
+    auto image = ImageBuffer(ImageBufferSpec(512, 256, 3, 12, ImageBufferSpec::Type::UINT8, "NV12"));
+    CHECK_EQ(image.getSize(), 512 * 256 * 3 / 2);
+}
+
 /*************/
 TEST_CASE("Testing ImageBufferSpec serialization")
 {
@@ -58,6 +74,37 @@ TEST_CASE("Testing ImageBufferSpec serialization")
     CHECK_EQ(spec, otherSpec);
 }
 
+/*************/
+TEST_CASE("Testing ImageBufferSpec tiles")
+{
+    auto spec = ImageBufferSpec(256, 128, 4, 32, ImageBufferSpec::Type::UINT8, "RGBA");
+    CHECK_FALSE(spec.isTile());
+
+    auto tileSpec = spec;
+    tileSpec.tileX = 64;
+    tileSpec.tileY = 32;
+    tileSpec.fullWidth = 1024;
+    tileSpec.fullHeight = 512;
+    CHECK(tileSpec.isTile());
+    CHECK_NE(spec, tileSpec);
+    CHECK_EQ(tileSpec.rawSize(), 256 * 128 * 4);
+    CHECK_EQ(tileSpec.to_string(), "256;128;4;32;0;RGBA;1;-1;64;32;1024;512;");
+
+    auto otherSpec = ImageBufferSpec();
+    otherSpec.from_string(tileSpec.to_string());
+    CHECK_EQ(otherSpec, tileSpec);
+
+    // A whole image spec resets the tile description
+    otherSpec.from_string(spec.to_string());
+    CHECK_EQ(otherSpec, spec);
+    CHECK_FALSE(otherSpec.isTile());
+
+    CHECK(spec.isTileable());
+    CHECK(ImageBufferSpec(256, 128, 3, 16, ImageBufferSpec::Type::UINT8, "UYVY").isTileable());
+    CHECK_FALSE(ImageBufferSpec(256, 128, 3, 12, ImageBufferSpec::Type::UINT8, "NV12").isTileable());
+    CHECK_FALSE(ImageBufferSpec(256, 128, 4, 8, ImageBufferSpec::Type::UINT8, "RGBA_DXT5").isTileable());
+}
+
 /*************/
 TEST_CASE("Testing ImageBuffer")
 {
@@ -69,3 +116,25 @@ TEST_CASE("Testing ImageBuffer")
     auto imageBuffer = ImageBuffer(spec);
     CHECK_EQ(imageBuffer.getSize(), width * height * bpp / 8);
 }
+
+/*************/
+TEST_CASE("Testing ImageBuffer adopting an external buffer")
+{
+    auto spec = ImageBufferSpec(16, 16, 4, 32, ImageBufferSpec::Type::UINT8, "RGBA");
+    std::vector<uint8_t> external(spec.rawSize(), 42);
+    bool released = false;
+
+    {
+        auto imageBuffer = ImageBuffer(spec, ResizableArray<uint8_t>(external.data(), external.size(), [&](uint8_t*) { released = true; }));
+        CHECK_EQ(imageBuffer.data(), external.data());
+        CHECK_EQ(imageBuffer.getSize(), spec.rawSize());
+
+        // Copies do not refer to the external buffer
+        auto copy = imageBuffer;
+        CHECK_NE(copy.data(), external.data());
+        CHECK_EQ(copy.data()[0], 42);
+        CHECK_FALSE(released);
+    }
+
+    CHECK(released);
+}
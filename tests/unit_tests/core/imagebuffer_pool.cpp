@@ -0,0 +1,55 @@
+#include <doctest.h>
+
+#include "./core/imagebuffer_pool.h"
+
+using namespace Splash;
+
+/*************/
+TEST_CASE("Testing ImageBufferPool recycling")
+{
+    auto pool = ImageBufferPool(1 << 20);
+    auto spec = ImageBufferSpec(64, 64, 4, 32, ImageBufferSpec::Type::UINT8, "RGBA");
+
+    auto buffer = pool.acquire(spec);
+    REQUIRE(buffer);
+    CHECK_EQ(buffer->getSize(), static_cast<size_t>(spec.rawSize()));
+    auto data = buffer->data();
+
+    pool.release(std::move(buffer));
+    CHECK_EQ(pool.getSize(), spec.rawSize());
+
+    // The same memory is handed back, with the new spec values
+    spec.timestamp = 42;
+    auto recycled = pool.acquire(spec);
+    CHECK_EQ(recycled->data(), data);
+    CHECK_EQ(recycled->getSpec().timestamp, 42);
+    CHECK_EQ(pool.getSize(), 0);
+
+    // Empty buffers are not kept
+    pool.release(std::make_unique<ImageBuffer>());
+    CHECK_EQ(pool.getSize(), 0);
+}
+
+/*************/
+TEST_CASE("Testing ImageBufferPool limits")
+{
+    auto spec = ImageBufferSpec(64, 64, 4, 32, ImageBufferSpec::Type::UINT8, "RGBA");
+    auto pool = ImageBufferPool(2 * spec.rawSize());
+
+    for (int i = 0; i < 3; ++i)
+        pool.release(std::make_unique<ImageBuffer>(spec));
+    CHECK_EQ(pool.getSize(), 2 * spec.rawSize());
+
+    pool.setMaximumSize(spec.rawSize());
+    CHECK_EQ(pool.getSize(), spec.rawSize());
+
+    // Buffers of another spec are dropped when none matches
+    auto otherSpec = ImageBufferSpec(32, 32, 4, 32, ImageBufferSpec::Type::UINT8, "RGBA");
+    auto buffer = pool.acquire(otherSpec);
+    CHECK_EQ(buffer->getSpec(), otherSpec);
+    CHECK_EQ(pool.getSize(), 0);
+
+    pool.release(std::move(buffer));
+    pool.clear();
+    CHECK_EQ(pool.getSize(), 0);
+}
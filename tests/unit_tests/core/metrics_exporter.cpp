@@ -0,0 +1,73 @@
+#include <doctest.h>
+
+#include <algorithm>
+#include <string>
+
+#include "./core/metrics_exporter.h"
+#include "./core/tree.h"
+
+using namespace std;
+using namespace Splash;
+
+/*************/
+TEST_CASE("Testing MetricsExporter collection and formatting")
+{
+    Tree::Root tree;
+    tree.createBranchAt("/world/durations");
+    tree.createBranchAt("/world/stats");
+    tree.createBranchAt("/world/attributes");
+    tree.createBranchAt("/local/durations");
+    tree.createBranchAt("/local/gpu");
+
+    tree.createLeafAt("/world/durations/loop_world", Values({16666}));
+    tree.createLeafAt("/world/stats/link_pending_buffers", Values({3}));
+    tree.createLeafAt("/world/attributes/framerate", Values({60}));
+    tree.createLeafAt("/local/durations/loop_scene", Values({16000}));
+    tree.createLeafAt("/local/gpu/cam.1", Values({1234}));
+    tree.createLeafAt("/local/gpu/name", Values({"not a number"}));
+
+    auto samples = MetricsExporter::collect(tree);
+    CHECK_EQ(samples.size(), 4);
+
+    // Only durations, statistics and GPU times are exported
+    CHECK(std::none_of(samples.begin(), samples.end(), [](const auto& sample) { return sample.group == "attributes"; }));
+
+    auto gpuSample = std::find_if(samples.begin(), samples.end(), [](const auto& sample) { return sample.group == "gpu"; });
+    REQUIRE(gpuSample != samples.end());
+    CHECK_EQ(gpuSample->root, "local");
+    CHECK_EQ(gpuSample->name, "cam.1");
+    CHECK_EQ(gpuSample->value, 1234.0);
+
+    auto prometheus = MetricsExporter::formatPrometheus(samples);
+    CHECK_NE(prometheus.find("# TYPE splash_duration_microseconds gauge\n"), string::npos);
+    CHECK_NE(prometheus.find("splash_duration_microseconds{root=\"world\",timer=\"loop_world\"} 16666\n"), string::npos);
+    CHECK_NE(prometheus.find("splash_gpu_time_microseconds{root=\"local\",object=\"cam.1\"} 1234\n"), string::npos);
+    CHECK_NE(prometheus.find("splash_statistic{root=\"world\",statistic=\"link_pending_buffers\"} 3\n"), string::npos);
+
+    // Each metric is described once, before its samples
+    auto firstDescription = prometheus.find("# HELP splash_duration_microseconds");
+    CHECK_EQ(prometheus.find("# HELP splash_duration_microseconds", firstDescription + 1), string::npos);
+    CHECK_LT(firstDescription, prometheus.find("splash_duration_microseconds{"));
+
+    auto statsd = MetricsExporter::formatStatsd(samples);
+    CHECK_EQ(statsd.size(), samples.size());
+    CHECK_NE(std::find(statsd.begin(), statsd.end(), "splash.local.gpu.cam_1:1234|g"), statsd.end());
+    CHECK_NE(std::find(statsd.begin(), statsd.end(), "splash.world.durations.loop_world:16666|g"), statsd.end());
+}
+
+/*************/
+TEST_CASE("Testing MetricsExporter outputs")
+{
+    MetricsExporter exporter;
+    CHECK_FALSE(exporter.isEnabled());
+
+    CHECK_FALSE(exporter.setStatsdAddress("localhost"));
+    CHECK_FALSE(exporter.isEnabled());
+
+    CHECK(exporter.setStatsdAddress("127.0.0.1:8125"));
+    CHECK(exporter.isEnabled());
+    CHECK_EQ(exporter.getStatsdAddress(), "127.0.0.1:8125");
+
+    CHECK(exporter.setStatsdAddress(""));
+    CHECK_FALSE(exporter.isEnabled());
+}
@@ -0,0 +1,69 @@
+#include <doctest.h>
+
+#include "./core/object_registry.h"
+
+using namespace Splash;
+
+/*************/
+struct RegisteredObject
+{
+    int value{0};
+};
+
+/*************/
+TEST_CASE("Testing ObjectRegistry snapshots")
+{
+    std::recursive_mutex mutex;
+    ObjectRegistry<RegisteredObject> registry(mutex);
+
+    auto first = std::make_shared<RegisteredObject>();
+    registry["first"] = first;
+
+    auto snapshot = registry.getSnapshot();
+    CHECK(snapshot->get("first") == first);
+    CHECK(snapshot->get("second") == nullptr);
+    CHECK(snapshot->getObjects().size() == 1);
+    CHECK(registry.getSnapshot() == snapshot);
+
+    // Previous snapshots are left untouched by modifications
+    auto second = std::make_shared<RegisteredObject>();
+    registry["second"] = second;
+    registry.erase("first");
+    auto newSnapshot = registry.getSnapshot();
+    CHECK(newSnapshot != snapshot);
+    CHECK(snapshot->get("first") == first);
+    CHECK(snapshot->get("second") == nullptr);
+    CHECK(newSnapshot->get("first") == nullptr);
+    CHECK(newSnapshot->get("second") == second);
+}
+
+/*************/
+TEST_CASE("Testing ObjectRegistry handles")
+{
+    std::recursive_mutex mutex;
+    ObjectRegistry<RegisteredObject> registry(mutex);
+    CHECK(!ObjectHandle().isValid());
+    CHECK(!registry.getSnapshot()->getHandle("object").isValid());
+
+    auto object = std::make_shared<RegisteredObject>();
+    registry["object"] = object;
+    auto handle = registry.getSnapshot()->getHandle("object");
+    CHECK(handle.isValid());
+    CHECK(registry.getSnapshot()->get(handle) == object);
+
+    // Handles are kept by the objects which stay registered
+    registry["other"] = std::make_shared<RegisteredObject>();
+    CHECK(registry.getSnapshot()->getHandle("object") == handle);
+
+    // A replaced object gets a new handle, even if it reuses the slot
+    auto replacement = std::make_shared<RegisteredObject>();
+    registry["object"] = replacement;
+    auto newHandle = registry.getSnapshot()->getHandle("object");
+    CHECK(newHandle != handle);
+    CHECK(registry.getSnapshot()->get(handle) == nullptr);
+    CHECK(registry.getSnapshot()->get(newHandle) == replacement);
+
+    registry.clear();
+    CHECK(registry.getSnapshot()->get(newHandle) == nullptr);
+    CHECK(registry.getSnapshot()->getObjects().empty());
+}
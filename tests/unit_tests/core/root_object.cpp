@@ -65,7 +65,11 @@ TEST_CASE("Testing RootObject construction")
     CHECK(tree->hasBranchAt("/world/commands"));
     CHECK(tree->hasBranchAt("/world/durations"));
     CHECK(tree->hasBranchAt("/world/logs"));
+    CHECK(tree->hasBranchAt("/world/memory"));
     CHECK(tree->hasBranchAt("/world/objects"));
+    CHECK(tree->hasBranchAt("/world/stats"));
+    CHECK(tree->hasLeafAt("/world/stats/spinlock_contended"));
+    CHECK(tree->hasLeafAt("/world/stats/spinlock_parked"));
 
     auto attributeList = root.getAttributesList();
     CHECK(std::find(attributeList.cbegin(), attributeList.cend(), "answerMessage") != attributeList.end());
@@ -126,6 +130,28 @@ TEST_CASE("Testing RootObject attribute set")
     CHECK_EQ(image->getAlias(), otherAlias);
 }
 
+/*************/
+TEST_CASE("Testing RootObject attribute queries")
+{
+    auto root = RootObjectMock();
+    root.set("world", "testValue", {42, "answer"}, false);
+    auto image = root.createObject("image", "image").lock();
+    root.set("image", "alias", {"imageAlias"}, false);
+
+    auto answers = root.answerQuery({Values({"world", "testValue"}), Values({"image", "alias"}), Values({"image", "nonExistingAttribute"}), Values({"nonExistingObject", "alias"})});
+    REQUIRE_EQ(answers.size(), 4);
+    CHECK_EQ(answers[0].as<Values>(), Values({42, "answer"}));
+    CHECK_EQ(answers[1].as<Values>(), Values({"imageAlias"}));
+    CHECK(answers[2].as<Values>().empty());
+    CHECK(answers[3].as<Values>().empty());
+
+    // Malformed queries are answered with an empty Values too
+    answers = root.answerQuery({Values({"world"}), 1});
+    REQUIRE_EQ(answers.size(), 2);
+    CHECK(answers[0].as<Values>().empty());
+    CHECK(answers[1].as<Values>().empty());
+}
+
 /*************/
 TEST_CASE("Testing RootObject serialized object set")
 {
@@ -160,3 +186,29 @@ TEST_CASE("Testing RootObject serialized object set")
     result = root.setFromSerializedObject(blenderName, serializedObject);
     CHECK_EQ(result, false);
 }
+
+/*************/
+TEST_CASE("Testing RootObject memory accounting")
+{
+    auto root = RootObjectMock();
+    auto image = std::dynamic_pointer_cast<Image>(root.createObject("image", "image").lock());
+    image->set(512, 256, 4, ImageBufferSpec::Type::UINT8);
+    image->update();
+    root.step();
+
+    auto tree = root.getTree();
+    Value value;
+    REQUIRE(tree->getValueForLeafAt("/world/memory/image", value));
+    auto usage = value.as<Values>();
+    REQUIRE_EQ(usage.size(), 2);
+    CHECK(usage[0].as<int64_t>() >= 512 * 256 * 4);
+    CHECK_EQ(usage[1].as<int64_t>(), 0);
+
+    REQUIRE(tree->getValueForLeafAt("/world/stats/memory_ram", value));
+    CHECK(value[0].as<int64_t>() >= usage[0].as<int64_t>());
+
+    root.disposeObject("image");
+    root.step();
+    root.step();
+    CHECK(!tree->hasLeafAt("/world/memory/image"));
+}
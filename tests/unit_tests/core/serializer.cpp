@@ -182,3 +182,34 @@ TEST_CASE("Testing deserialization")
         CHECK(std::get<2>(data) == std::get<2>(outData));
     }
 }
+
+/*************/
+TEST_CASE("Testing serialization of contiguous numeric containers")
+{
+    {
+        vector<uint8_t> buffer;
+        vector<double> data(1024);
+        for (uint32_t i = 0; i < data.size(); ++i)
+            data[i] = i * 0.5;
+        Serial::serialize(data, buffer);
+        CHECK_EQ(buffer.size(), sizeof(uint32_t) + data.size() * sizeof(double));
+        CHECK_EQ(Serial::getSize(data), buffer.size());
+        CHECK(Serial::deserialize<vector<double>>(buffer) == data);
+    }
+
+    {
+        vector<uint8_t> buffer;
+        vector<int> data{};
+        Serial::serialize(data, buffer);
+        CHECK_EQ(buffer.size(), sizeof(uint32_t));
+        CHECK(Serial::deserialize<vector<int>>(buffer).empty());
+    }
+
+    {
+        vector<uint8_t> buffer;
+        auto data = make_tuple(vector<vector<int>>{{1, 2, 3}, {}, {4}}, string("Ni"), vector<uint8_t>{4, 2});
+        Serial::serialize(data, buffer);
+        CHECK_EQ(Serial::getSize(data), buffer.size());
+        CHECK(Serial::deserialize<decltype(data)>(buffer) == data);
+    }
+}
@@ -0,0 +1,85 @@
+#include <doctest.h>
+
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <unistd.h>
+
+#include "./core/session_recording.h"
+
+using namespace std;
+using namespace Splash;
+
+/*************/
+TEST_CASE("Testing SessionRecording filtering")
+{
+    CHECK(SessionRecording::isRecordedMessage("addObject"));
+    CHECK(SessionRecording::isRecordedMessage("file"));
+    CHECK_FALSE(SessionRecording::isRecordedMessage("swapReady"));
+    CHECK_FALSE(SessionRecording::isRecordedMessage("pong"));
+
+    CHECK(SessionRecording::isRecordedSeed(Tree::Task::SetLeaf, "/world/attributes/framerate"));
+    CHECK(SessionRecording::isRecordedSeed(Tree::Task::AddBranch, "/scene/objects/camera"));
+    CHECK_FALSE(SessionRecording::isRecordedSeed(Tree::Task::SetLeaf, "/world/durations/loop_world"));
+    CHECK_FALSE(SessionRecording::isRecordedSeed(Tree::Task::RemoveLeaf, "/world/attributes/framerate"));
+    CHECK_FALSE(SessionRecording::isRecordedSeed(Tree::Task::SetLeaf, "/world"));
+    CHECK_FALSE(SessionRecording::isRecordedSeed(Tree::Task::SetLeaf, "world/attributes/framerate"));
+}
+
+/*************/
+TEST_CASE("Testing SessionRecording recording and reading")
+{
+    auto path = (filesystem::temp_directory_path() / ("splash_session_" + to_string(getpid()) + ".rec")).string();
+    auto mediaPath = (filesystem::temp_directory_path() / ("splash_session_media_" + to_string(getpid()) + ".raw")).string();
+    {
+        ofstream media(mediaPath, ios::binary | ios::trunc);
+        media << "frame";
+    }
+
+    Tree::Root tree;
+    tree.createBranchAt("/world/attributes");
+    tree.createBranchAt("/world/durations");
+    tree.getUpdateSeedList();
+    tree.createLeafAt("/world/attributes/framerate", Values({30}));
+    tree.createLeafAt("/world/durations/loop_world", Values({16666}));
+
+    {
+        SessionRecording recording;
+        REQUIRE(recording.start(path, "/some/configuration.json"));
+        CHECK(recording.isRecording());
+
+        recording.recordMessage("world", "swapReady", {});
+        recording.recordMessage("image", "flip", {true});
+        recording.recordOrigin();
+        recording.recordSeeds(tree.getUpdateSeedList());
+        recording.recordMedia("image", mediaPath);
+        recording.stop();
+        CHECK_FALSE(recording.isRecording());
+    }
+
+    SessionRecording::Header header;
+    vector<SessionRecording::Event> events;
+    REQUIRE(SessionRecording::read(path, header, events));
+    CHECK_EQ(header.version, SPLASH_SESSION_RECORDING_VERSION);
+    CHECK_EQ(header.configurationFile, "/some/configuration.json");
+
+    // The protocol message and the measurement branch are left out
+    REQUIRE_EQ(events.size(), 4);
+    CHECK(events[0].type == SessionRecording::EventType::Message);
+    CHECK_EQ(events[0].name, "image");
+    CHECK_EQ(events[0].attribute, "flip");
+    CHECK_EQ(events[0].args, Values({true}));
+    CHECK(events[1].type == SessionRecording::EventType::Origin);
+    CHECK(events[2].type == SessionRecording::EventType::Seeds);
+    CHECK_EQ(events[2].args.size(), 1);
+    CHECK(events[3].type == SessionRecording::EventType::Media);
+    CHECK(SessionRecording::checkMedia(events[3]));
+
+    for (size_t i = 1; i < events.size(); ++i)
+        CHECK_LE(events[i - 1].time, events[i].time);
+
+    filesystem::remove(mediaPath);
+    CHECK_FALSE(SessionRecording::checkMedia(events[3]));
+    filesystem::remove(path);
+    CHECK_FALSE(SessionRecording::read(path, header, events));
+}
@@ -0,0 +1,44 @@
+#include <doctest.h>
+
+#include <unistd.h>
+#include <vector>
+
+#include "./core/shm_blob.h"
+
+using namespace std;
+using namespace Splash;
+
+/*************/
+TEST_CASE("Testing ShmBlob publication and mapping")
+{
+    auto prefix = string("/splash_unittest_blob_");
+    vector<uint8_t> content(4096);
+    for (uint32_t i = 0; i < content.size(); ++i)
+        content[i] = i % 256;
+
+    auto blob = ShmBlob::publish(prefix, content.data(), content.size());
+    REQUIRE(blob);
+
+    // Publishing the same content gives back the same blob
+    auto sameBlob = ShmBlob::publish(prefix, content.data(), content.size());
+    CHECK_EQ(blob, sameBlob);
+
+    auto reference = ShmBlob::getReference(blob->serializeReference());
+    REQUIRE(reference);
+    CHECK_EQ(reference->hash, blob->getReference().hash);
+    CHECK_EQ(reference->size, content.size());
+
+    auto mapped = ShmBlob::map(reference.value());
+    REQUIRE(mapped);
+    CHECK_EQ(mapped->size(), content.size());
+    CHECK_EQ(mapped->data()[1234], 1234 % 256);
+
+    // A regular buffer is not a reference
+    CHECK_FALSE(ShmBlob::getReference(make_shared<SerializedObject>(sizeof(ShmBlob::Reference))));
+
+    // Existing mappings outlive the blob, but it can not be mapped anymore
+    blob.reset();
+    sameBlob.reset();
+    CHECK_EQ(mapped->data()[4095], 4095 % 256);
+    CHECK_FALSE(ShmBlob::map(reference.value()));
+}
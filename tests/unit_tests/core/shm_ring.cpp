@@ -0,0 +1,116 @@
+#include <doctest.h>
+
+#include <unistd.h>
+#include <vector>
+
+#include "./core/shm_ring.h"
+
+using namespace std;
+using namespace Splash;
+
+/*************/
+TEST_CASE("Testing ShmRing allocation and adoption")
+{
+    auto ringName = "/splash_unittest_" + to_string(getpid());
+    auto ring = ShmRing(ringName);
+    REQUIRE(ring.isValid());
+
+    auto buffer = ring.allocate(4096);
+    REQUIRE(buffer);
+    CHECK_EQ(buffer->size(), 4096);
+    for (uint32_t i = 0; i < buffer->size(); ++i)
+        buffer->data()[i] = i % 256;
+
+    auto descriptor = ring.retain(buffer);
+    REQUIRE(descriptor);
+    buffer.reset();
+
+    auto reader = ShmRingReader(ringName, "reader");
+    auto adopted = reader.adopt(descriptor.value());
+    REQUIRE(adopted);
+    CHECK_EQ(adopted->size(), 4096);
+    CHECK_EQ(adopted->data()[1234], 1234 % 256);
+
+    // A buffer which does not come from the ring can not be retained
+    auto otherBuffer = make_shared<SerializedObject>(128);
+    CHECK_FALSE(ring.retain(otherBuffer));
+}
+
+/*************/
+TEST_CASE("Testing ShmRing slot reuse")
+{
+    auto ringName = "/splash_unittest_reuse_" + to_string(getpid());
+    auto ring = ShmRing(ringName);
+    REQUIRE(ring.isValid());
+
+    vector<shared_ptr<SerializedObject>> buffers;
+    for (uint32_t i = 0; i < SPLASH_SHM_RING_SLOTS; ++i)
+    {
+        auto buffer = ring.allocate(1024);
+        REQUIRE(buffer);
+        buffers.push_back(buffer);
+    }
+
+    // All slots are held
+    CHECK_FALSE(ring.allocate(1024));
+
+    // Releasing a buffer frees its slot, which can grow as needed
+    buffers.pop_back();
+    auto buffer = ring.allocate(1 << 22);
+    REQUIRE(buffer);
+    CHECK_EQ(buffer->size(), 1 << 22);
+}
+
+/*************/
+TEST_CASE("Testing ShmRing slots waiting for the readers")
+{
+    auto ringName = "/splash_unittest_readers_" + to_string(getpid());
+    auto ring = ShmRing(ringName);
+    REQUIRE(ring.isValid());
+    auto reader = ShmRingReader(ringName, "reader");
+
+    // The reader registers when adopting its first buffer
+    auto buffer = ring.allocate(1024);
+    REQUIRE(buffer);
+    auto descriptor = ring.retain(buffer);
+    REQUIRE(descriptor);
+    buffer.reset();
+    auto adopted = reader.adopt(descriptor.value());
+    REQUIRE(adopted);
+
+    // A slot held by the reader is not reused
+    vector<shared_ptr<SerializedObject>> buffers;
+    while (auto heldBuffer = ring.allocate(1024))
+        buffers.push_back(heldBuffer);
+    CHECK_EQ(buffers.size(), SPLASH_SHM_RING_SLOTS - 1);
+    adopted.reset();
+    buffers.push_back(ring.allocate(1024));
+    CHECK(buffers.back());
+
+    // The descriptor of this buffer is lost on the way, so its slot waits for a later descriptor
+    auto lostBuffer = std::move(buffers.back());
+    buffers.pop_back();
+    REQUIRE(ring.retain(lostBuffer));
+    lostBuffer.reset();
+    CHECK_FALSE(ring.allocate(1024));
+
+    auto laterBuffer = std::move(buffers.back());
+    buffers.pop_back();
+    auto laterDescriptor = ring.retain(laterBuffer);
+    REQUIRE(laterDescriptor);
+    laterBuffer.reset();
+    CHECK(reader.adopt(laterDescriptor.value()));
+    buffers.push_back(ring.allocate(1024));
+    CHECK(buffers.back());
+    buffers.push_back(ring.allocate(1024));
+    CHECK(buffers.back());
+
+    // Once the reader is removed, its descriptors are not waited for anymore
+    lostBuffer = std::move(buffers.back());
+    buffers.pop_back();
+    REQUIRE(ring.retain(lostBuffer));
+    lostBuffer.reset();
+    CHECK_FALSE(ring.allocate(1024));
+    ring.removeReader("reader");
+    CHECK(ring.allocate(1024));
+}
@@ -0,0 +1,54 @@
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <doctest.h>
+
+#include "./core/spinlock.h"
+
+using namespace std;
+using namespace Splash;
+
+/*************/
+TEST_CASE("Testing Spinlock")
+{
+    Spinlock lock;
+    CHECK(lock.try_lock());
+    CHECK_FALSE(lock.try_lock());
+    lock.unlock();
+    CHECK(lock.try_lock());
+    lock.unlock();
+}
+
+/*************/
+TEST_CASE("Testing Spinlock under contention")
+{
+    static constexpr uint32_t threadCount = 4;
+    static constexpr uint32_t iterations = 100000;
+
+    Spinlock lock;
+    uint64_t counter = 0;
+    auto statistics = Spinlock::getStatistics();
+
+    // Holding the lock for a while forces the other threads to sleep on it
+    lock.lock();
+    vector<thread> threads;
+    for (uint32_t t = 0; t < threadCount; ++t)
+        threads.emplace_back([&]() {
+            for (uint32_t i = 0; i < iterations; ++i)
+            {
+                lock_guard<Spinlock> lockGuard(lock);
+                ++counter;
+            }
+        });
+    this_thread::sleep_for(chrono::milliseconds(50));
+    lock.unlock();
+
+    for (auto& t : threads)
+        t.join();
+
+    CHECK_EQ(counter, threadCount * iterations);
+    auto newStatistics = Spinlock::getStatistics();
+    CHECK(newStatistics.contended >= statistics.contended + threadCount);
+    CHECK(newStatistics.parked >= statistics.parked + threadCount);
+}
@@ -161,6 +161,73 @@ TEST_CASE("Testing the synchronization between trees")
     CHECK(maple == oak);
 }
 
+/*************/
+TEST_CASE("Testing leaf accesses after structural changes")
+{
+    Tree::Root maple;
+    Value value;
+
+    maple.createBranchAt("/a_branch");
+    maple.createLeafAt("/a_branch/a_leaf", {1});
+    CHECK(maple.setValueForLeafAt("/a_branch/a_leaf", 2));
+    CHECK(maple.getValueForLeafAt("/a_branch/a_leaf", value));
+    CHECK_EQ(value, Value(2));
+
+    maple.renameLeafAt("/a_branch/a_leaf", "renamed_leaf");
+    CHECK_FALSE(maple.hasLeafAt("/a_branch/a_leaf"));
+    CHECK_FALSE(maple.setValueForLeafAt("/a_branch/a_leaf", 3));
+    CHECK(maple.getValueForLeafAt("/a_branch/renamed_leaf", value));
+    CHECK_EQ(value, Value(2));
+
+    maple.removeBranchAt("/a_branch");
+    CHECK_FALSE(maple.hasLeafAt("/a_branch/renamed_leaf"));
+
+    maple.createBranchAt("/a_branch");
+    maple.createLeafAt("/a_branch/a_leaf");
+    CHECK(maple.setValueForLeafAt("/a_branch/a_leaf", 4));
+    CHECK(maple.getValueForLeafAt("/a_branch/a_leaf", value));
+    CHECK_EQ(value, Value(4));
+}
+
+/*************/
+TEST_CASE("Testing the coalescing of seeds")
+{
+    Tree::Root maple, oak;
+
+    maple.createBranchAt("/a_branch");
+    maple.createLeafAt("/a_branch/a_leaf");
+    maple.createLeafAt("/a_branch/another_leaf");
+    for (int i = 0; i < 16; ++i)
+    {
+        maple.setValueForLeafAt("/a_branch/a_leaf", i);
+        maple.setValueForLeafAt("/a_branch/another_leaf", -i);
+    }
+
+    auto updates = maple.getUpdateSeedList();
+    auto updatesCount = updates.size();
+    Tree::Root::coalesceSeeds(updates);
+    CHECK_EQ(updates.size(), updatesCount - 30);
+
+    oak.addSeedsToQueue(updates);
+    CHECK_NOTHROW(oak.processQueue());
+    CHECK(maple == oak);
+
+    // Structural changes are kept in order with the values set around them
+    maple.setValueForLeafAt("/a_branch/a_leaf", 42);
+    maple.removeLeafAt("/a_branch/a_leaf");
+    maple.createLeafAt("/a_branch/a_leaf");
+    maple.setValueForLeafAt("/a_branch/a_leaf", 1337);
+
+    updates = maple.getUpdateSeedList();
+    updatesCount = updates.size();
+    Tree::Root::coalesceSeeds(updates);
+    CHECK_EQ(updates.size(), updatesCount);
+
+    oak.addSeedsToQueue(updates);
+    CHECK_NOTHROW(oak.processQueue());
+    CHECK(maple == oak);
+}
+
 /*************/
 TEST_CASE("Testing adding and cutting existing branches and leaves")
 {
@@ -262,6 +329,82 @@ TEST_CASE("Testing the Leaf's callbacks")
     CHECK(extValue == Value("Ceci n'est pas un test"));
 }
 
+/*************/
+TEST_CASE("Testing the subscriptions to tree changes")
+{
+    Tree::Root maple;
+    maple.createLeafAt("/objects/image/attributes/file", {"a.png"});
+    maple.createLeafAt("/objects/mesh/attributes/file", {"a.obj"});
+
+    vector<Tree::Root::ChangeSet> branchChanges;
+    vector<Tree::Root::ChangeSet> leafChanges;
+    auto branchID = maple.subscribe("/objects/image/", [&](const Tree::Root::ChangeSet& changes) { branchChanges.push_back(changes); });
+    auto leafID = maple.subscribe("/objects/mesh/attributes/file", [&](const Tree::Root::ChangeSet& changes) { leafChanges.push_back(changes); });
+    CHECK_NE(branchID, leafID);
+
+    // Nothing is delivered until notified, and only the last value of each leaf is kept
+    maple.setValueForLeafAt("/objects/image/attributes/file", Values({"b.png"}));
+    maple.setValueForLeafAt("/objects/image/attributes/file", Values({"c.png"}));
+    maple.createLeafAt("/objects/image/attributes/flip", {true});
+    maple.createLeafAt("/objects/image_other/attributes/file", {"d.png"});
+    maple.setValueForLeafAt("/objects/mesh/attributes/file", Values({"b.obj"}));
+    CHECK(branchChanges.empty());
+    CHECK(leafChanges.empty());
+
+    maple.notifySubscribers();
+    REQUIRE_EQ(branchChanges.size(), 1);
+    CHECK_EQ(branchChanges[0].size(), 2);
+    CHECK(branchChanges[0]["/objects/image/attributes/file"] == Value(Values({"c.png"})));
+    CHECK(branchChanges[0]["/objects/image/attributes/flip"] == Value(Values({true})));
+    REQUIRE_EQ(leafChanges.size(), 1);
+    CHECK(leafChanges[0]["/objects/mesh/attributes/file"] == Value(Values({"b.obj"})));
+
+    // Setting the same value is not a change, and empty change sets are not delivered
+    maple.setValueForLeafAt("/objects/image/attributes/file", Values({"c.png"}));
+    maple.notifySubscribers();
+    CHECK_EQ(branchChanges.size(), 1);
+    CHECK_EQ(leafChanges.size(), 1);
+
+    // Changes coming from another tree are delivered too
+    Tree::Root oak;
+    oak.createLeafAt("/objects/mesh/attributes/file", {"b.obj"});
+    oak.setValueForLeafAt("/objects/mesh/attributes/file", Values({"c.obj"}));
+    maple.addSeedsToQueue(oak.getUpdateSeedList());
+    maple.processQueue();
+    maple.notifySubscribers();
+    REQUIRE_EQ(leafChanges.size(), 2);
+    CHECK(leafChanges[1]["/objects/mesh/attributes/file"] == Value(Values({"c.obj"})));
+
+    // Removals are reported with an empty value, also to the subscriptions to leaves under the removed branch
+    maple.removeBranchAt("/objects/mesh");
+    maple.removeLeafAt("/objects/image/attributes/flip");
+    maple.notifySubscribers();
+    REQUIRE_EQ(leafChanges.size(), 3);
+    CHECK(leafChanges[2]["/objects/mesh"].getType() == Value::Type::empty);
+    REQUIRE_EQ(branchChanges.size(), 2);
+    CHECK_EQ(branchChanges[1].size(), 1);
+    CHECK(branchChanges[1]["/objects/image/attributes/flip"].getType() == Value::Type::empty);
+
+    CHECK(maple.unsubscribe(branchID));
+    CHECK_FALSE(maple.unsubscribe(branchID));
+    maple.setValueForLeafAt("/objects/image/attributes/file", Values({"e.png"}));
+    maple.notifySubscribers();
+    CHECK_EQ(branchChanges.size(), 2);
+
+    // A callback can unsubscribe itself
+    int selfCalls = 0;
+    Tree::Root::SubscriptionID selfID = 0;
+    selfID = maple.subscribe("/", [&](const Tree::Root::ChangeSet&) {
+        ++selfCalls;
+        CHECK(maple.unsubscribe(selfID));
+    });
+    maple.setValueForLeafAt("/objects/image/attributes/file", Values({"f.png"}));
+    maple.notifySubscribers();
+    maple.setValueForLeafAt("/objects/image/attributes/file", Values({"g.png"}));
+    maple.notifySubscribers();
+    CHECK_EQ(selfCalls, 1);
+}
+
 /*************/
 TEST_CASE("Testing propagation through a main tree")
 {
@@ -291,3 +434,64 @@ TEST_CASE("Testing RootHandle")
     }
     CHECK(main.hasBranchAt("/first_branch"));
 }
+
+/*************/
+TEST_CASE("Testing tree snapshots")
+{
+    Tree::Root tree;
+    tree.createBranchAt("/world");
+    tree.createBranchAt("/scene");
+    tree.createLeafAt("/world/framerate", {60});
+    tree.createLeafAt("/scene/swapInterval", {1});
+
+    auto snapshot = tree.getSnapshot();
+    CHECK(snapshot->hasBranchAt("/world"));
+    CHECK(snapshot->hasLeafAt("/world/framerate"));
+    CHECK_FALSE(snapshot->hasLeafAt("/world/swapInterval"));
+    CHECK(snapshot->getBranchList() == tree.getBranchList());
+    CHECK(snapshot->getLeafListAt("/scene") == tree.getLeafListAt("/scene"));
+
+    Value value;
+    CHECK(snapshot->getValueForLeafAt("/world/framerate", value));
+    CHECK(value == Value(Values({60})));
+
+    // Without any change, the same snapshot is returned
+    CHECK(tree.getSnapshot() == snapshot);
+
+    // Changes do not affect the snapshots already taken
+    tree.setValueForLeafAt("/world/framerate", Values({30}));
+    tree.createLeafAt("/world/looseClock", {false});
+    auto newSnapshot = tree.getSnapshot();
+    CHECK(newSnapshot != snapshot);
+    CHECK(newSnapshot->getVersion() > snapshot->getVersion());
+
+    CHECK(snapshot->getValueForLeafAt("/world/framerate", value));
+    CHECK(value == Value(Values({60})));
+    CHECK_FALSE(snapshot->hasLeafAt("/world/looseClock"));
+    CHECK(newSnapshot->getValueForLeafAt("/world/framerate", value));
+    CHECK(value == Value(Values({30})));
+    CHECK(newSnapshot->hasLeafAt("/world/looseClock"));
+
+    // Unchanged branches are shared between snapshots
+    CHECK(snapshot->getBranchAt("/scene") == newSnapshot->getBranchAt("/scene"));
+    CHECK(snapshot->getBranchAt("/world") != newSnapshot->getBranchAt("/world"));
+
+    // Renaming and removal are captured too
+    tree.renameBranchAt("/scene", "otherScene");
+    tree.removeLeafAt("/world/looseClock");
+    auto lastSnapshot = tree.getSnapshot();
+    CHECK_FALSE(lastSnapshot->hasBranchAt("/scene"));
+    CHECK(lastSnapshot->hasLeafAt("/otherScene/swapInterval"));
+    CHECK_FALSE(lastSnapshot->hasLeafAt("/world/looseClock"));
+    CHECK(newSnapshot->hasBranchAt("/scene"));
+
+    // Leaves changed through seeds are captured as well
+    tree.addSeedToQueue(Tree::Task::SetLeaf, {"/otherScene/swapInterval", Values({0})});
+    tree.processQueue();
+    CHECK(tree.getSnapshot()->getValueForLeafAt("/otherScene/swapInterval", value));
+    CHECK(value == Value(Values({0})));
+
+    tree.cutdown();
+    CHECK(tree.getSnapshot()->getBranchList().empty());
+    CHECK(lastSnapshot->hasBranchAt("/world"));
+}
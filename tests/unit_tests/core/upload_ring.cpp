@@ -0,0 +1,71 @@
+#include <thread>
+
+#include <doctest.h>
+
+#include "./core/upload_ring.h"
+
+using namespace Splash;
+
+/*************/
+TEST_CASE("Testing UploadRing slots lifecycle")
+{
+    std::vector<uint8_t> memory(3 * 16);
+    auto ring = UploadRing(ImageBufferSpec(4, 4, 1, 8), {&memory[0], &memory[16], &memory[32]}, 16);
+    CHECK_EQ(ring.getSlotSize(), 16);
+
+    int64_t timestamp = -1;
+    CHECK_EQ(ring.consume(timestamp), -1);
+
+    auto first = ring.acquire();
+    CHECK_NE(first, -1);
+    CHECK_EQ(ring.getPixels(first), &memory[16 * first]);
+    ring.commit(first, 100);
+
+    // A frame committed before the previous one is consumed replaces it
+    auto second = ring.acquire();
+    CHECK_NE(second, first);
+    ring.commit(second, 200);
+    CHECK_EQ(ring.consume(timestamp), second);
+    CHECK_EQ(timestamp, 200);
+    CHECK_EQ(ring.consume(timestamp), -1);
+
+    // Slots being uploaded are not handed to the writer until released
+    auto third = ring.acquire();
+    auto fourth = ring.acquire();
+    CHECK_NE(third, -1);
+    CHECK_NE(fourth, -1);
+    CHECK_EQ(ring.acquire(), -1);
+    ring.cancel(fourth);
+    ring.commit(third, 300);
+    ring.release(second);
+
+    // With no free slot, the unconsumed frame is dropped
+    CHECK_NE(ring.acquire(), -1);
+    CHECK_NE(ring.acquire(), -1);
+    CHECK_EQ(ring.acquire(), third);
+    CHECK_EQ(ring.consume(timestamp), -1);
+    CHECK_EQ(ring.acquire(), -1);
+}
+
+/*************/
+TEST_CASE("Testing UploadRing closing")
+{
+    std::vector<uint8_t> memory(2 * 16);
+    auto ring = UploadRing(ImageBufferSpec(4, 4, 1, 8), {&memory[0], &memory[16]}, 16);
+
+    auto slot = ring.acquire();
+    CHECK_FALSE(ring.isClosed());
+
+    // Closing waits for the pending write
+    auto writer = std::thread([&]() {
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        ring.commit(slot, 100);
+    });
+    ring.close();
+    writer.join();
+
+    int64_t timestamp = -1;
+    CHECK(ring.isClosed());
+    CHECK_EQ(ring.acquire(), -1);
+    CHECK_EQ(ring.consume(timestamp), -1);
+}
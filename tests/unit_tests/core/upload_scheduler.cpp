@@ -0,0 +1,76 @@
+#include <doctest.h>
+
+#include "./core/upload_scheduler.h"
+
+using namespace Splash;
+
+/*************/
+TEST_CASE("Testing UploadScheduler without a budget")
+{
+    auto scheduler = UploadScheduler();
+    auto budgets = scheduler.schedule({{"video", 1000, UploadScheduler::Priority::VisibleLive, false}, {"still", 5000, UploadScheduler::Priority::HiddenStill, true}});
+    CHECK_EQ(budgets.size(), 2);
+    CHECK(budgets[0] >= 1000);
+    CHECK(budgets[1] >= 5000);
+}
+
+/*************/
+TEST_CASE("Testing UploadScheduler priorities")
+{
+    auto scheduler = UploadScheduler();
+    scheduler.setBudget(1500);
+
+    // Visible and live uploads go first, and the first upload of a frame always happens
+    auto budgets = scheduler.schedule({{"hidden", 1000, UploadScheduler::Priority::HiddenLive, false},
+        {"visible", 1000, UploadScheduler::Priority::VisibleLive, false},
+        {"idle", 0, UploadScheduler::Priority::VisibleLive, false}});
+    CHECK_EQ(budgets[0], 0);
+    CHECK_EQ(budgets[1], 1000);
+    CHECK_EQ(budgets[2], 0);
+    CHECK_EQ(scheduler.getDeferredFrames("hidden"), 1);
+    CHECK_EQ(scheduler.getDeferredFrames("idle"), 0);
+
+    budgets = scheduler.schedule({{"huge", 4000, UploadScheduler::Priority::VisibleLive, false}});
+    CHECK_EQ(budgets[0], 4000);
+}
+
+/*************/
+TEST_CASE("Testing UploadScheduler splittable uploads")
+{
+    auto scheduler = UploadScheduler();
+    scheduler.setBudget(1500);
+
+    // Stills get what is left of the budget, and are continued in the next frames
+    auto budgets = scheduler.schedule({{"video", 1000, UploadScheduler::Priority::VisibleLive, false}, {"still", 5000, UploadScheduler::Priority::VisibleStill, true}});
+    CHECK_EQ(budgets[0], 1000);
+    CHECK_EQ(budgets[1], 500);
+    CHECK_EQ(scheduler.getDeferredFrames("still"), 0);
+
+    budgets = scheduler.schedule({{"still", 4500, UploadScheduler::Priority::VisibleStill, true}});
+    CHECK_EQ(budgets[0], 1500);
+}
+
+/*************/
+TEST_CASE("Testing UploadScheduler aging")
+{
+    auto scheduler = UploadScheduler();
+    scheduler.setBudget(1000);
+
+    // A deferred upload rises in priority until it is uploaded
+    int frames = 0;
+    while (true)
+    {
+        auto budgets = scheduler.schedule({{"visible", 1000, UploadScheduler::Priority::VisibleLive, false}, {"hidden", 1000, UploadScheduler::Priority::HiddenStill, false}});
+        ++frames;
+        if (budgets[1] != 0)
+        {
+            CHECK_EQ(budgets[0], 0);
+            break;
+        }
+        REQUIRE(frames < 100);
+    }
+
+    CHECK_EQ(frames, 3 * SPLASH_UPLOAD_SCHEDULER_AGING_FRAMES + 1);
+    CHECK_EQ(scheduler.getDeferredFrames("hidden"), 0);
+    CHECK_EQ(scheduler.getDeferredFrames("visible"), 1);
+}
@@ -124,6 +124,58 @@ TEST_CASE("Testing buffer in Value")
     CHECK(isEqual);
 }
 
+/*************/
+TEST_CASE("Testing reals in Value")
+{
+    Value::Reals reals(64);
+    for (uint32_t i = 0; i < reals.size(); ++i)
+        reals[i] = static_cast<float>(i) * 0.25f;
+
+    Value value(reals);
+    CHECK_EQ(value.getType(), Value::Type::reals);
+    CHECK_EQ(value.getTypeAsChar(), 'f');
+    CHECK_EQ(value.size(), reals.size());
+    CHECK_EQ(value.byte_size(), reals.size() * sizeof(float));
+    CHECK(value.isConvertibleToType(Value::Type::values));
+
+    auto otherValue = value;
+    CHECK(otherValue == value);
+
+    // Reals convert element-wise to and from Values
+    auto values = value.as<Values>();
+    REQUIRE_EQ(values.size(), reals.size());
+    CHECK_EQ(values[10].as<float>(), 2.5f);
+    CHECK(Value(values).as<Value::Reals>()[63] == reals[63]);
+
+    {
+        vector<uint8_t> buffer;
+        Serial::serialize(value, buffer);
+        CHECK_EQ(buffer.size(), sizeof(Value::Type) + sizeof(uint32_t) + reals.size() * sizeof(float));
+        CHECK(Serial::deserialize<Value>(buffer) == value);
+    }
+}
+
+/*************/
+TEST_CASE("Testing Value moves")
+{
+    // Containers of Value only move their elements when growing if moving cannot throw
+    CHECK(std::is_nothrow_move_constructible_v<Values>);
+    CHECK(std::is_nothrow_move_constructible_v<Value::Buffer>);
+    CHECK(std::is_nothrow_move_constructible_v<Value>);
+
+    Values values{1, 2.0, "three", Values({4, 5})};
+    auto nested = values[3].as<Values>();
+    auto movedValues = Values(std::move(values));
+    CHECK(values.empty());
+    CHECK_EQ(movedValues.size(), 4);
+    CHECK(movedValues[3] == nested);
+
+    Value::Buffer buffer(256);
+    auto movedBuffer = Value::Buffer(std::move(buffer));
+    CHECK_EQ(buffer.size(), 0);
+    CHECK_EQ(movedBuffer.size(), 256);
+}
+
 /*************/
 TEST_CASE("Testing Value serialization")
 {
@@ -0,0 +1,90 @@
+#include <doctest.h>
+#include <vector>
+
+#include "./core/value_codec.h"
+
+using namespace Splash;
+
+namespace
+{
+Values roundTrip(const Values& values)
+{
+    std::vector<uint8_t> buffer(ValueCodec::getEncodedSize(values));
+    auto end = ValueCodec::encode(values, buffer.data());
+    CHECK_EQ(end, buffer.data() + buffer.size());
+
+    Values decoded;
+    CHECK(ValueCodec::decode(buffer.data(), buffer.size(), decoded));
+    return decoded;
+}
+} // namespace
+
+/*************/
+TEST_CASE("Testing Values encoding")
+{
+    CHECK_EQ(roundTrip({}), Values());
+
+    Values values{true, false, 0, -1, 42, 1ll << 40, -(1ll << 50), 3.14159, "some text", ""};
+    CHECK_EQ(roundTrip(values), values);
+
+    Values named{Value(1, "first"), Value(std::string("foo"), "second"), Value(Values{Value(1.0), Value(2.0)}, "third")};
+    auto decodedNamed = roundTrip(named);
+    CHECK_EQ(decodedNamed, named);
+    CHECK_EQ(decodedNamed[2].getName(), "third");
+
+    Values nested{Values({1, Values({2.5, "deep"}), Values()}), Value()};
+    CHECK_EQ(roundTrip(nested), nested);
+
+    Value::Buffer buffer(16);
+    for (size_t i = 0; i < buffer.size(); ++i)
+        buffer[i] = static_cast<uint8_t>(i);
+    Values withBuffer{buffer};
+    auto decodedBuffer = roundTrip(withBuffer);
+    REQUIRE_EQ(decodedBuffer.size(), 1);
+    REQUIRE_EQ(decodedBuffer[0].getType(), Value::Type::buffer);
+    CHECK_EQ(decodedBuffer[0].as<Value::Buffer>().size(), buffer.size());
+    CHECK_EQ(decodedBuffer[0].as<Value::Buffer>()[15], 15);
+}
+
+/*************/
+TEST_CASE("Testing Values encoding compactness")
+{
+    // Unnamed reals are copied in bulk, small integers take a single byte
+    Values reals;
+    for (int i = 0; i < 100; ++i)
+        reals.push_back(static_cast<double>(i) * 0.5);
+    CHECK_EQ(ValueCodec::getEncodedSize(reals), 2 + 100 * sizeof(double));
+    CHECK_EQ(roundTrip(reals), reals);
+
+    CHECK_EQ(ValueCodec::getEncodedSize({1, 2, 3}), 2 + 3 * 2);
+
+    // Contiguous reals are copied in bulk too, as floats
+    Value::Reals lattice(32 * 32 * 2);
+    for (uint32_t i = 0; i < lattice.size(); ++i)
+        lattice[i] = static_cast<float>(i) / 7.f;
+    Values withLattice{32, 32, lattice};
+    CHECK_EQ(ValueCodec::getEncodedSize(withLattice), 2 + 2 * 2 + 1 + 2 + lattice.size() * sizeof(float));
+    auto decodedLattice = roundTrip(withLattice);
+    REQUIRE_EQ(decodedLattice.size(), 3);
+    REQUIRE_EQ(decodedLattice[2].getType(), Value::Type::reals);
+    CHECK_EQ(decodedLattice, withLattice);
+}
+
+/*************/
+TEST_CASE("Testing Values decoding of malformed buffers")
+{
+    Values values{1, "text", Values{Value(1.0), Value(2.0), Value(3.0)}};
+    std::vector<uint8_t> buffer(ValueCodec::getEncodedSize(values));
+    ValueCodec::encode(values, buffer.data());
+
+    Values decoded;
+    for (size_t size = 0; size < buffer.size(); ++size)
+        CHECK_FALSE(ValueCodec::decode(buffer.data(), size, decoded));
+
+    auto withTrailingByte = buffer;
+    withTrailingByte.push_back(0);
+    CHECK_FALSE(ValueCodec::decode(withTrailingByte.data(), withTrailingByte.size(), decoded));
+
+    std::vector<uint8_t> hugeCount{0, 0xff, 0xff, 0xff, 0xff, 0x0f};
+    CHECK_FALSE(ValueCodec::decode(hugeCount.data(), hugeCount.size(), decoded));
+}
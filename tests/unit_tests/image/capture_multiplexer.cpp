@@ -0,0 +1,118 @@
+#include <atomic>
+#include <chrono>
+#include <doctest.h>
+#include <fcntl.h>
+#include <thread>
+#include <unistd.h>
+
+#include "./image/capture_multiplexer.h"
+
+using namespace std;
+using namespace Splash;
+
+namespace
+{
+/*************/
+// Pipe standing for a capture device, each byte written to it being a frame
+struct FakeDevice
+{
+    int fds[2]{-1, -1};
+    atomic_int dequeued{0};
+    atomic_int published{0};
+
+    FakeDevice() { REQUIRE(pipe2(fds, O_NONBLOCK) == 0); }
+    ~FakeDevice()
+    {
+        close(fds[0]);
+        close(fds[1]);
+    }
+
+    CaptureMultiplexer::Device getDevice(const string& syncGroup)
+    {
+        CaptureMultiplexer::Device device;
+        device.fd = fds[0];
+        device.syncGroup = syncGroup;
+        device.dequeue = [this]() {
+            char frame;
+            if (::read(fds[0], &frame, 1) == 1)
+                ++dequeued;
+            return true;
+        };
+        device.publish = [this]() { ++published; };
+        return device;
+    }
+
+    void sendFrame()
+    {
+        char frame = 0;
+        REQUIRE(::write(fds[1], &frame, 1) == 1);
+    }
+};
+
+/*************/
+bool waitFor(const function<bool()>& condition, int timeoutMs = 1000)
+{
+    auto start = chrono::steady_clock::now();
+    while (!condition())
+    {
+        if (chrono::steady_clock::now() - start > chrono::milliseconds(timeoutMs))
+            return false;
+        this_thread::sleep_for(chrono::milliseconds(1));
+    }
+    return true;
+}
+} // namespace
+
+/*************/
+TEST_CASE("Testing CaptureMultiplexer without sync group")
+{
+    CaptureMultiplexer multiplexer;
+    FakeDevice fakeDevice;
+
+    auto id = multiplexer.addDevice(fakeDevice.getDevice(""));
+    REQUIRE(id != 0);
+    CHECK_EQ(multiplexer.getDeviceCount(), 1);
+
+    fakeDevice.sendFrame();
+    CHECK(waitFor([&]() { return fakeDevice.published == 1; }));
+    CHECK_EQ(fakeDevice.dequeued, 1);
+
+    // Once removed, the device is not dequeued anymore
+    multiplexer.removeDevice(id);
+    CHECK_EQ(multiplexer.getDeviceCount(), 0);
+    fakeDevice.sendFrame();
+    this_thread::sleep_for(chrono::milliseconds(20));
+    CHECK_EQ(fakeDevice.dequeued, 1);
+
+    CHECK_EQ(multiplexer.addDevice(CaptureMultiplexer::Device()), 0);
+}
+
+/*************/
+TEST_CASE("Testing CaptureMultiplexer sync groups")
+{
+    CaptureMultiplexer multiplexer;
+    FakeDevice first, second;
+
+    auto firstId = multiplexer.addDevice(first.getDevice("wall"));
+    auto secondId = multiplexer.addDevice(second.getDevice("wall"));
+    REQUIRE(firstId != 0);
+    REQUIRE(secondId != 0);
+
+    // Frames are held until every device of the group delivered one
+    first.sendFrame();
+    CHECK(waitFor([&]() { return first.dequeued == 1; }));
+    CHECK_EQ(first.published, 0);
+
+    second.sendFrame();
+    CHECK(waitFor([&]() { return first.published == 1 && second.published == 1; }));
+    CHECK_LT(multiplexer.getSyncSkew("wall"), static_cast<int64_t>(SPLASH_CAPTURE_SYNC_TIMEOUT) * 1000);
+
+    // A device not delivering its frame does not stall the others for longer than the timeout
+    first.sendFrame();
+    CHECK(waitFor([&]() { return first.published == 2; }, SPLASH_CAPTURE_SYNC_TIMEOUT * 10));
+    CHECK_EQ(second.published, 1);
+
+    multiplexer.removeDevice(secondId);
+    multiplexer.removeDevice(firstId);
+    CHECK_EQ(multiplexer.getSyncSkew("wall"), 0);
+}
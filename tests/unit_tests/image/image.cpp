@@ -0,0 +1,36 @@
+#include "./image/image.h"
+
+#include <doctest.h>
+
+#include "./core/root_object.h"
+
+using namespace std;
+using namespace Splash;
+
+/*************/
+TEST_CASE("Testing Image snapshots")
+{
+    auto root = RootObject();
+    auto image = Image(&root);
+
+    image.set(64, 8, 4, ImageBufferSpec::Type::UINT8);
+    image.update();
+    auto snapshot = image.getSnapshot();
+    REQUIRE(snapshot);
+    CHECK_EQ(snapshot->getSpec().width, 64);
+
+    // Publishing new frames leaves the snapshot untouched
+    for (uint32_t width = 32; width < 64; width += 8)
+    {
+        image.set(width, 8, 4, ImageBufferSpec::Type::UINT8);
+        image.update();
+        CHECK_EQ(image.getSpec().width, width);
+        CHECK_EQ(snapshot->getSpec().width, 64);
+        CHECK_NE(image.getSnapshot().get(), snapshot.get());
+    }
+
+    // Images can still be serialized while a snapshot is held
+    auto serialized = image.serialize();
+    CHECK(serialized);
+    CHECK_EQ(snapshot->getSpec().width, 64);
+}
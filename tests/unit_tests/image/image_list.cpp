@@ -42,3 +42,26 @@ TEST_CASE("Testing capture")
     fileList = image.getFileList();
     CHECK_EQ(fileList.empty(), true);
 }
+
+TEST_CASE("Testing playback attributes")
+{
+    auto root = RootObject();
+    auto image = Image_List(&root);
+
+    Values framerate;
+    image.getAttribute("framerate", framerate);
+    CHECK_EQ(framerate[0].as<float>(), 0.f);
+
+    // Playback does not start without any file, and negative framerates disable it
+    CHECK(image.setAttribute("framerate", {30.f}));
+    image.getAttribute("framerate", framerate);
+    CHECK_EQ(framerate[0].as<float>(), 30.f);
+    CHECK(image.setAttribute("framerate", {-1.f}));
+    image.getAttribute("framerate", framerate);
+    CHECK_EQ(framerate[0].as<float>(), 0.f);
+
+    Values prefetch;
+    CHECK(image.setAttribute("prefetch", {1000}));
+    image.getAttribute("prefetch", prefetch);
+    CHECK_EQ(prefetch[0].as<int>(), 64);
+}
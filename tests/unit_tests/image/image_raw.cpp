@@ -0,0 +1,78 @@
+#include "./image/image_raw.h"
+
+#include <chrono>
+#include <doctest.h>
+#include <filesystem>
+#include <fstream>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+using namespace std;
+using namespace Splash;
+
+namespace
+{
+/*************/
+string writeRawFile(const ImageBufferSpec& spec, uint64_t frameCount)
+{
+    auto path = (filesystem::temp_directory_path() / ("splash_image_raw_" + to_string(getpid()) + ".raw")).string();
+    ofstream file(path, ios::binary | ios::trunc);
+    Image_Raw::writeHeader(file, spec, frameCount, 30.0);
+    for (uint64_t frame = 0; frame < frameCount; ++frame)
+    {
+        vector<char> pixels(Image_Raw::getFrameStride(spec), static_cast<char>(frame + 1));
+        file.write(pixels.data(), pixels.size());
+    }
+    return path;
+}
+} // namespace
+
+/*************/
+TEST_CASE("Testing Image_Raw file layout")
+{
+    auto spec = ImageBufferSpec(64, 8, 4, 32, ImageBufferSpec::Type::UINT8, "RGBA");
+    CHECK_EQ(Image_Raw::getFrameStride(spec) % SPLASH_IMAGE_RAW_ALIGNMENT, 0);
+    CHECK(Image_Raw::getFrameStride(spec) >= static_cast<uint64_t>(spec.rawSize()));
+
+    auto path = writeRawFile(spec, 3);
+    CHECK_EQ(filesystem::file_size(path), SPLASH_IMAGE_RAW_ALIGNMENT + 3 * Image_Raw::getFrameStride(spec));
+    filesystem::remove(path);
+}
+
+/*************/
+TEST_CASE("Testing Image_Raw playback")
+{
+    auto root = RootObject();
+    auto spec = ImageBufferSpec(64, 8, 4, 32, ImageBufferSpec::Type::UINT8, "RGBA");
+    auto path = writeRawFile(spec, 3);
+
+    for (const auto direct : {false, true})
+    {
+        auto image = Image_Raw(&root);
+        image.setAttribute("direct", {direct});
+        CHECK(image.read(path));
+
+        // The first frame is shown right away
+        bool updated = false;
+        for (int i = 0; i < 100 && !updated; ++i)
+        {
+            this_thread::sleep_for(chrono::milliseconds(10));
+            image.update();
+            updated = image.getSpec().width == spec.width;
+        }
+        CHECK(updated);
+        CHECK_EQ(image.getSpec().height, spec.height);
+        CHECK_EQ(image.getSpec().format, "RGBA");
+    }
+
+    // Files which are not raw frame sequences are refused
+    {
+        ofstream file(path, ios::binary | ios::trunc);
+        file << "not a raw file";
+    }
+    auto image = Image_Raw(&root);
+    CHECK_FALSE(image.read(path));
+
+    filesystem::remove(path);
+}
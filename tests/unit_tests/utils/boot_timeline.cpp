@@ -0,0 +1,49 @@
+#include <thread>
+
+#include <doctest.h>
+
+#include "./utils/boot_timeline.h"
+
+using namespace Splash;
+
+/*************/
+TEST_CASE("Testing BootTimeline step aggregation")
+{
+    BootTimeline timeline;
+    timeline.setThreadOwner("world");
+
+    auto version = timeline.getVersion();
+    timeline.addStep("load_config", 1000, 3000);
+    timeline.addStep("shader_compile", 2000, 2500);
+    timeline.addStep("shader_compile", 4000, 4100);
+    CHECK_GT(timeline.getVersion(), version);
+
+    // Steps from threads without an owner belong to the first owner of the process
+    std::thread([&]() { timeline.addStep("shader_compile", 1500, 1600); }).join();
+    std::thread([&]() {
+        timeline.setThreadOwner("scene");
+        timeline.addStep("gl_version_probe", 1200, 1800);
+    }).join();
+
+    auto steps = timeline.getSteps("world");
+    REQUIRE_EQ(steps.size(), 2);
+    CHECK_EQ(steps[0].name, "load_config");
+    CHECK_EQ(steps[1].name, "shader_compile");
+    CHECK_EQ(steps[1].start, 1500);
+    CHECK_EQ(steps[1].end, 4100);
+    CHECK_EQ(steps[1].duration, 700);
+    CHECK_EQ(steps[1].count, 3);
+
+    auto sceneSteps = timeline.getSteps("scene");
+    REQUIRE_EQ(sceneSteps.size(), 1);
+    CHECK_EQ(sceneSteps[0].name, "gl_version_probe");
+
+    // Nothing is recorded once the boot is over
+    timeline.finish();
+    CHECK_FALSE(timeline.isBooting());
+    version = timeline.getVersion();
+    timeline.addStep("mesh_load", 5000, 6000);
+    timeline.mark("first_frame");
+    CHECK_EQ(timeline.getVersion(), version);
+    CHECK_EQ(timeline.getSteps("world").size(), 2);
+}
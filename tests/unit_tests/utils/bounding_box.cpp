@@ -0,0 +1,55 @@
+#include <doctest.h>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "./utils/bounding_box.h"
+
+using namespace Splash;
+
+/*************/
+TEST_CASE("Testing BoundingBox extension")
+{
+    BoundingBox box;
+    CHECK(box.isEmpty());
+
+    box.extend(glm::vec3(1.f, -2.f, 3.f));
+    CHECK_FALSE(box.isEmpty());
+    CHECK(box.min == glm::vec3(1.f, -2.f, 3.f));
+    CHECK(box.max == glm::vec3(1.f, -2.f, 3.f));
+
+    box.extend(glm::vec3(-1.f, 2.f, 0.f));
+    CHECK(box.min == glm::vec3(-1.f, -2.f, 0.f));
+    CHECK(box.max == glm::vec3(1.f, 2.f, 3.f));
+
+    BoundingBox other;
+    other.extend(BoundingBox());
+    CHECK(other.isEmpty());
+    other.extend(box);
+    CHECK(other.min == box.min);
+    CHECK(other.max == box.max);
+}
+
+/*************/
+TEST_CASE("Testing BoundingBox frustum test")
+{
+    auto view = glm::lookAt(glm::dvec3(0.0, 0.0, 5.0), glm::dvec3(0.0), glm::dvec3(0.0, 1.0, 0.0));
+    auto projection = glm::perspective(glm::radians(60.0), 1.0, 0.1, 100.0);
+    auto mvp = projection * view;
+
+    auto makeBox = [](const glm::vec3& center, float halfSize) {
+        BoundingBox box;
+        box.extend(center - glm::vec3(halfSize));
+        box.extend(center + glm::vec3(halfSize));
+        return box;
+    };
+
+    CHECK(makeBox(glm::vec3(0.f), 1.f).isInFrustum(mvp));
+    // Behind the camera, beyond the far plane, and far on the side
+    CHECK_FALSE(makeBox(glm::vec3(0.f, 0.f, 10.f), 1.f).isInFrustum(mvp));
+    CHECK_FALSE(makeBox(glm::vec3(0.f, 0.f, -200.f), 1.f).isInFrustum(mvp));
+    CHECK_FALSE(makeBox(glm::vec3(50.f, 0.f, 0.f), 1.f).isInFrustum(mvp));
+    // Surrounding the camera, or crossing the border of the view
+    CHECK(makeBox(glm::vec3(0.f, 0.f, 5.f), 10.f).isInFrustum(mvp));
+    CHECK(makeBox(glm::vec3(3.5f, 0.f, 0.f), 1.f).isInFrustum(mvp));
+
+    CHECK_FALSE(BoundingBox().isInFrustum(mvp));
+}
@@ -0,0 +1,47 @@
+#include <doctest.h>
+
+#include "./utils/clock_sync.h"
+
+using namespace Splash;
+
+/*************/
+TEST_CASE("Testing ClockSync offset estimation")
+{
+    auto clockSync = ClockSync(4, 10000, 200);
+    CHECK_FALSE(clockSync.isSynchronized());
+    CHECK_FALSE(clockSync.addSample(100, 0, 50));
+    CHECK_FALSE(clockSync.isSynchronized());
+
+    // Remote clock is 5000us ahead, symmetric 100us round trip
+    CHECK(clockSync.addSample(1000, 6050, 1100));
+    CHECK(clockSync.isSynchronized());
+    CHECK_EQ(clockSync.getOffset(), 5000);
+    CHECK_EQ(clockSync.getRoundTrip(), 100);
+
+    // A delayed answer has a larger round trip and is ignored in favor of the best sample
+    CHECK(clockSync.addSample(2000, 7900, 4000));
+    CHECK_EQ(clockSync.getOffset(), 5000);
+    CHECK_EQ(clockSync.getRoundTrip(), 100);
+}
+
+/*************/
+TEST_CASE("Testing ClockSync slewing and stepping")
+{
+    auto clockSync = ClockSync(1, 10000, 200);
+    CHECK(clockSync.addSample(0, 5000, 0));
+    CHECK_EQ(clockSync.getOffset(), 5000);
+
+    // Small errors are slewed, at most by 200us per sample
+    CHECK(clockSync.addSample(0, 6000, 0));
+    CHECK_EQ(clockSync.getOffset(), 5200);
+    CHECK(clockSync.addSample(0, 5300, 0));
+    CHECK_EQ(clockSync.getOffset(), 5300);
+
+    // Large errors are stepped
+    CHECK(clockSync.addSample(0, -20000, 0));
+    CHECK_EQ(clockSync.getOffset(), -20000);
+
+    clockSync.reset();
+    CHECK_FALSE(clockSync.isSynchronized());
+    CHECK_EQ(clockSync.getOffset(), 0);
+}
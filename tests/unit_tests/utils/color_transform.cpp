@@ -0,0 +1,62 @@
+#include <doctest.h>
+
+#include "./utils/color_transform.h"
+
+using namespace Splash;
+
+/*************/
+TEST_CASE("Testing ColorTransform baking of the identity")
+{
+    ColorTransform transform;
+    auto table = transform.bake(3);
+    REQUIRE_EQ(table.size(), 3 * 3 * 3 * 3);
+
+    // Red varies fastest, then green, then blue
+    CHECK_EQ(table[0], 0.f);
+    CHECK_EQ(table[3], 0.5f);
+    CHECK_EQ(table[6], 1.f);
+    CHECK_EQ(table[3 * 3 + 1], 0.5f);
+    CHECK_EQ(table[9 * 3 + 2], 0.5f);
+    CHECK_EQ(table[26 * 3], 1.f);
+    CHECK_EQ(table[26 * 3 + 1], 1.f);
+    CHECK_EQ(table[26 * 3 + 2], 1.f);
+
+    CHECK(transform.bake(1).empty());
+}
+
+/*************/
+TEST_CASE("Testing ColorTransform steps")
+{
+    ColorTransform transform;
+
+    // The color balance scales the channels down to the highest ratio
+    transform.balanceRed = 0.5f;
+    auto color = transform.apply({1.f, 1.f, 1.f});
+    CHECK_EQ(color[0], 0.5f);
+    CHECK_EQ(color[1], 1.f);
+    CHECK_EQ(color[2], 1.f);
+
+    // A null saturation gives a gray of the same value
+    transform.balanceRed = 1.f;
+    transform.saturation = 0.f;
+    color = transform.apply({1.f, 0.f, 0.f});
+    CHECK_EQ(color[0], 1.f);
+    CHECK_EQ(color[1], 1.f);
+    CHECK_EQ(color[2], 1.f);
+
+    // The lookup table is applied per channel, with the nearest entry
+    transform.saturation = 1.f;
+    for (int i = 0; i < 256; ++i)
+        for (int c = 0; c < 3; ++c)
+            transform.lut.push_back(1.f - static_cast<float>(i) / 255.f);
+    color = transform.apply({1.f, 0.f, 0.5f});
+    CHECK_EQ(color[0], transform.lut[255 * 3]);
+    CHECK_EQ(color[1], transform.lut[1]);
+    CHECK_EQ(color[2], transform.lut[128 * 3 + 2]);
+
+    // Comparison is used to detect when the table has to be baked again
+    auto other = transform;
+    CHECK(other == transform);
+    other.contrast = 1.5f;
+    CHECK(other != transform);
+}
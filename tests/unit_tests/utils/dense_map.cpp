@@ -101,3 +101,67 @@ TEST_CASE("Testing Splash::DenseMap")
     otherMap = DenseMap<int, float>({{4, 4.f}, {8, 8.f}});
     CHECK(dmap == otherMap);
 }
+
+/*************/
+TEST_CASE("Testing Splash::DenseMap lookups")
+{
+    auto dmap = DenseMap<std::string, int>();
+    const int count = 1000;
+    for (int i = 0; i < count; ++i)
+        dmap["key_" + std::to_string(i)] = i;
+    CHECK(dmap.size() == count);
+
+    bool allFound = true;
+    for (int i = 0; i < count; ++i)
+    {
+        auto it = dmap.find("key_" + std::to_string(i));
+        allFound = allFound && it != dmap.end() && it->second == i;
+    }
+    CHECK(allFound);
+    CHECK(dmap.find("key_" + std::to_string(count)) == dmap.end());
+    CHECK(dmap.count("key_42") == 1);
+    CHECK(dmap.count("not_a_key") == 0);
+
+    // Iteration follows insertion order
+    int expected = 0;
+    bool ordered = true;
+    for (const auto& entry : dmap)
+        ordered = ordered && entry.second == expected++;
+    CHECK(ordered);
+
+    // Lookups stay valid after erasing, as the tags are erased along with the keys
+    for (int i = 0; i < count; i += 3)
+        CHECK(dmap.erase("key_" + std::to_string(i)) == 1);
+    allFound = true;
+    for (int i = 0; i < count; ++i)
+    {
+        auto it = dmap.find("key_" + std::to_string(i));
+        if (i % 3 == 0)
+            allFound = allFound && it == dmap.end();
+        else
+            allFound = allFound && it != dmap.end() && it->second == i;
+    }
+    CHECK(allFound);
+
+    auto intMap = DenseMap<int, int>();
+    for (int i = 0; i < count; ++i)
+        intMap.try_emplace(i * 256, i);
+    CHECK(intMap.size() == count);
+    CHECK(intMap.find(256 * 512)->second == 512);
+    CHECK(intMap.find(1) == intMap.end());
+    CHECK(intMap.insert({0, 42}).second == false);
+    CHECK(intMap.at(0) == 0);
+
+    // Below the index threshold, lookups scan the tags
+    auto smallMap = DenseMap<std::string, int>();
+    for (int i = 0; i < 48; ++i)
+        smallMap.try_emplace(std::to_string(i), i);
+    allFound = true;
+    for (int i = 0; i < 48; ++i)
+        allFound = allFound && smallMap.find(std::to_string(i))->second == i;
+    CHECK(allFound);
+    CHECK(smallMap.find("48") == smallMap.end());
+    smallMap.erase("20");
+    CHECK(smallMap.find("20") == smallMap.end());
+    CHECK(smallMap.find("47")->second == 47);
+}
@@ -0,0 +1,124 @@
+#include <doctest.h>
+
+#include <cmath>
+#include <vector>
+
+#include "./utils/dxt_encoder.h"
+
+using namespace Splash;
+
+namespace
+{
+/*************/
+// Reference DXT5 decoder, for a single block
+void decodeBlock(const uint8_t* input, uint8_t* block)
+{
+    int alpha[8];
+    alpha[0] = input[0];
+    alpha[1] = input[1];
+    for (int i = 1; i < 7; ++i)
+        alpha[i + 1] = alpha[0] > alpha[1] ? ((7 - i) * alpha[0] + i * alpha[1]) / 7 : (i < 5 ? ((5 - i) * alpha[0] + i * alpha[1]) / 5 : (i == 5 ? 0 : 255));
+    uint64_t alphaIndices = 0;
+    for (int i = 0; i < 6; ++i)
+        alphaIndices |= static_cast<uint64_t>(input[2 + i]) << (i * 8);
+
+    int color[4][3];
+    for (int e = 0; e < 2; ++e)
+    {
+        const int value = input[8 + e * 2] | input[9 + e * 2] << 8;
+        color[e][0] = ((value >> 11) & 0x1F) * 255 / 31;
+        color[e][1] = ((value >> 5) & 0x3F) * 255 / 63;
+        color[e][2] = (value & 0x1F) * 255 / 31;
+    }
+    for (int c = 0; c < 3; ++c)
+    {
+        color[2][c] = (2 * color[0][c] + color[1][c]) / 3;
+        color[3][c] = (color[0][c] + 2 * color[1][c]) / 3;
+    }
+    const uint32_t colorIndices = input[12] | input[13] << 8 | input[14] << 16 | static_cast<uint32_t>(input[15]) << 24;
+
+    for (int i = 0; i < 16; ++i)
+    {
+        const auto colorIndex = (colorIndices >> (i * 2)) & 0x3;
+        for (int c = 0; c < 3; ++c)
+            block[i * 4 + c] = color[colorIndex][c];
+        block[i * 4 + 3] = alpha[(alphaIndices >> (i * 3)) & 0x7];
+    }
+}
+} // namespace
+
+/*************/
+TEST_CASE("Testing DxtEncoder compressed size")
+{
+    CHECK_EQ(DxtEncoder::compressedSize(4, 4), 16);
+    CHECK_EQ(DxtEncoder::compressedSize(64, 32), 64 * 32);
+    CHECK_EQ(DxtEncoder::compressedSize(5, 3), 2 * 16);
+}
+
+/*************/
+TEST_CASE("Testing DxtEncoder on uniform blocks")
+{
+    for (const auto& pixel : {std::vector<uint8_t>{0, 0, 0, 255}, std::vector<uint8_t>{255, 255, 255, 0}, std::vector<uint8_t>{200, 100, 50, 128}})
+    {
+        uint8_t block[64];
+        for (int i = 0; i < 16; ++i)
+            std::copy(pixel.begin(), pixel.end(), block + i * 4);
+
+        uint8_t compressed[16];
+        DxtEncoder::compressBlock(block, compressed);
+        uint8_t decoded[64];
+        decodeBlock(compressed, decoded);
+
+        for (int i = 0; i < 16; ++i)
+        {
+            for (int c = 0; c < 3; ++c)
+                CHECK(std::abs(decoded[i * 4 + c] - pixel[c]) <= 4);
+            CHECK_EQ(decoded[i * 4 + 3], pixel[3]);
+        }
+    }
+}
+
+/*************/
+TEST_CASE("Testing DxtEncoder on gradients")
+{
+    const uint32_t width = 30;
+    const uint32_t height = 18;
+    std::vector<uint8_t> rgba(width * height * 4);
+    for (uint32_t y = 0; y < height; ++y)
+    {
+        for (uint32_t x = 0; x < width; ++x)
+        {
+            auto pixel = rgba.data() + (y * width + x) * 4;
+            pixel[0] = x * 255 / (width - 1);
+            pixel[1] = 255 - x * 255 / (width - 1);
+            pixel[2] = 64 + x * 4;
+            pixel[3] = y * 255 / (height - 1);
+        }
+    }
+
+    std::vector<uint8_t> blocks(DxtEncoder::compressedSize(width, height));
+    for (uint32_t row = 0; row < (height + 3) / 4; ++row)
+        DxtEncoder::compressBlockRow(rgba.data(), width, height, row, blocks.data());
+
+    // Compare the decoded image to the original, borders excluded from the padded blocks
+    double colorError = 0.0;
+    int maxAlphaError = 0;
+    const uint32_t blocksPerRow = (width + 3) / 4;
+    for (uint32_t y = 0; y < height; ++y)
+    {
+        for (uint32_t x = 0; x < width; ++x)
+        {
+            uint8_t decoded[64];
+            decodeBlock(blocks.data() + ((y / 4) * blocksPerRow + x / 4) * DxtEncoder::blockSize, decoded);
+            const auto decodedPixel = decoded + ((y % 4) * 4 + x % 4) * 4;
+            const auto pixel = rgba.data() + (y * width + x) * 4;
+            for (int c = 0; c < 3; ++c)
+                colorError += std::pow(decodedPixel[c] - pixel[c], 2.0);
+            maxAlphaError = std::max(maxAlphaError, std::abs(decodedPixel[3] - pixel[3]));
+        }
+    }
+
+    const auto rmse = std::sqrt(colorError / (width * height * 3));
+    CHECK(rmse < 3.0);
+    CHECK(maxAlphaError <= 4);
+}
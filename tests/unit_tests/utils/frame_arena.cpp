@@ -0,0 +1,57 @@
+#include <doctest.h>
+
+#include <memory_resource>
+#include <string>
+#include <vector>
+
+#include "./utils/frame_arena.h"
+
+using namespace std;
+using namespace Splash;
+
+/*************/
+TEST_CASE("Testing FrameArena allocations")
+{
+    FrameArena arena(1024);
+    CHECK_EQ(arena.capacity(), 1024);
+
+    {
+        pmr::vector<int> values(arena.resource());
+        values.reserve(128);
+        for (int i = 0; i < 128; ++i)
+            values.push_back(i);
+        CHECK_EQ(values[127], 127);
+
+        pmr::string text(64, 'a', arena.resource());
+        CHECK_EQ(text.size(), 64);
+    }
+    // Everything fitted into the initial buffer
+    arena.reset();
+    CHECK_EQ(arena.capacity(), 1024);
+}
+
+/*************/
+TEST_CASE("Testing FrameArena growth to the high-water mark")
+{
+    FrameArena arena(256);
+
+    {
+        pmr::vector<uint8_t> buffer(4096, 0, arena.resource());
+        CHECK_EQ(buffer.size(), 4096);
+    }
+    arena.reset();
+    auto capacity = arena.capacity();
+    CHECK_GE(capacity, 4096);
+
+    // Once grown, the same loop fits into the arena buffer
+    for (int loop = 0; loop < 8; ++loop)
+    {
+        {
+            pmr::vector<uint8_t> buffer(4096, 0, arena.resource());
+            buffer[4095] = 42;
+            CHECK_EQ(buffer[4095], 42);
+        }
+        arena.reset();
+    }
+    CHECK_EQ(arena.capacity(), capacity);
+}
@@ -0,0 +1,86 @@
+#include <doctest.h>
+
+#include "./utils/http_protocol.h"
+
+using namespace Splash;
+
+/*************/
+TEST_CASE("Testing HTTP request parsing")
+{
+    Http::Request request;
+    size_t consumed = 0;
+
+    std::string buffer = "PUT /objects/image/file HTTP/1.1\r\nHost: localhost\r\nContent-Length: 7\r\n\r\n[\"a.png\"]";
+    CHECK_EQ(Http::parseRequest(buffer.substr(0, 20), request, consumed, 1024), Http::ParseStatus::Incomplete);
+    CHECK_EQ(Http::parseRequest(buffer.substr(0, buffer.size() - 4), request, consumed, 1024), Http::ParseStatus::Incomplete);
+
+    buffer = "PUT /objects/image/file HTTP/1.1\r\nHost: localhost\r\nContent-Length: 9\r\n\r\n[\"a.png\"]GET";
+    REQUIRE_EQ(Http::parseRequest(buffer, request, consumed, 1024), Http::ParseStatus::Complete);
+    CHECK_EQ(request.method, "PUT");
+    CHECK_EQ(request.target, "/objects/image/file");
+    CHECK_EQ(request.getHeader("host"), "localhost");
+    CHECK_EQ(request.body, "[\"a.png\"]");
+    CHECK_EQ(consumed, buffer.size() - 3);
+
+    CHECK_EQ(Http::parseRequest("GARBAGE\r\n\r\n", request, consumed, 1024), Http::ParseStatus::Invalid);
+    CHECK_EQ(Http::parseRequest("POST / HTTP/1.1\r\nContent-Length: 4096\r\n\r\n", request, consumed, 1024), Http::ParseStatus::Invalid);
+    CHECK_EQ(Http::parseRequest(std::string(2048, 'a'), request, consumed, 1024), Http::ParseStatus::Invalid);
+
+    CHECK_EQ(Http::decodeUrl("/objects/my%20image"), "/objects/my image");
+    CHECK_EQ(Http::decodeUrl("100%"), "100%");
+
+    CHECK(Http::hasToken("Close", "close"));
+    CHECK(Http::hasToken("keep-alive, Upgrade", "upgrade"));
+    CHECK_FALSE(Http::hasToken("keep-alive", "close"));
+    CHECK_FALSE(Http::hasToken("", "close"));
+}
+
+/*************/
+TEST_CASE("Testing WebSocket handshake")
+{
+    // Values from RFC 6455
+    CHECK_EQ(Http::getWebSocketAccept("dGhlIHNhbXBsZSBub25jZQ=="), "s3pPLMBiTxaQ9kYGzzhZRbK+xOo=");
+    CHECK_EQ(Http::encodeBase64("ab"), "YWI=");
+    CHECK_EQ(Http::encodeBase64(""), "");
+
+    Http::Request request;
+    size_t consumed = 0;
+    std::string buffer = "GET /ws HTTP/1.1\r\nConnection: keep-alive, Upgrade\r\nUpgrade: websocket\r\nSec-WebSocket-Version: 13\r\n"
+                         "Sec-WebSocket-Key: dGhlIHNhbXBsZSBub25jZQ==\r\n\r\n";
+    REQUIRE_EQ(Http::parseRequest(buffer, request, consumed, 1024), Http::ParseStatus::Complete);
+    CHECK(Http::isWebSocketUpgrade(request));
+    CHECK_NE(Http::buildWebSocketHandshake(request).find("Sec-WebSocket-Accept: s3pPLMBiTxaQ9kYGzzhZRbK+xOo=\r\n"), std::string::npos);
+
+    request.headers.erase("upgrade");
+    CHECK_FALSE(Http::isWebSocketUpgrade(request));
+}
+
+/*************/
+TEST_CASE("Testing WebSocket frames")
+{
+    Http::Frame frame;
+    size_t consumed = 0;
+
+    // Masked "Hello" frame from RFC 6455
+    const std::string masked = "\x81\x85\x37\xfa\x21\x3d\x7f\x9f\x4d\x51\x58";
+    CHECK_EQ(Http::decodeFrame(masked.substr(0, 6), frame, consumed, 1024), Http::ParseStatus::Incomplete);
+    REQUIRE_EQ(Http::decodeFrame(masked, frame, consumed, 1024), Http::ParseStatus::Complete);
+    CHECK(frame.fin);
+    CHECK_EQ(frame.opcode, Http::Opcode::Text);
+    CHECK_EQ(frame.payload, "Hello");
+    CHECK_EQ(consumed, masked.size());
+
+    // Server frames are not masked, so they are rejected when received
+    auto encoded = Http::encodeFrame(Http::Opcode::Text, "Hello");
+    CHECK_EQ(encoded, "\x81\x05Hello");
+    CHECK_EQ(Http::decodeFrame(encoded, frame, consumed, 1024), Http::ParseStatus::Invalid);
+
+    auto large = Http::encodeFrame(Http::Opcode::Binary, std::string(70000, 'a'));
+    CHECK_EQ(large.size(), 70000 + 10);
+    CHECK_EQ(static_cast<uint8_t>(large[1]), 127);
+    CHECK_EQ(Http::encodeFrame(Http::Opcode::Binary, std::string(300, 'a')).size(), 300 + 4);
+
+    // Payloads larger than the limit are rejected
+    std::string header = "\x82\xfe\x01\x2c";
+    CHECK_EQ(Http::decodeFrame(header + "abcd", frame, consumed, 256), Http::ParseStatus::Invalid);
+}
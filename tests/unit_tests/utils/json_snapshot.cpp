@@ -0,0 +1,85 @@
+#include <cstdio>
+#include <fstream>
+#include <string>
+
+#include <doctest.h>
+#include <json/json.h>
+
+#include "./utils/json_snapshot.h"
+#include "./utils/jsonutils.h"
+#include "./utils/osutils.h"
+
+using namespace std;
+using namespace Splash;
+
+/*************/
+TEST_CASE("Testing Json snapshots round trip")
+{
+    auto filePath = Utils::getCurrentWorkingDirectory() + "/data/sample_scene_0.7.21.json";
+    Json::Value configuration;
+    REQUIRE(Utils::loadJsonFile(filePath, configuration));
+
+    Json::Value lattice(Json::arrayValue);
+    for (int i = 0; i < 64; ++i)
+        lattice.append(0.1 * static_cast<double>(i));
+    configuration["lattice"] = lattice;
+    configuration["mixed"].append(1);
+    configuration["mixed"].append(2.5);
+    configuration["mixed"].append("text");
+    configuration["mixed"].append(Json::Value());
+    configuration["mixed"].append(true);
+    configuration["large"] = static_cast<Json::UInt64>(1) << 40;
+    configuration["empty"] = Json::Value(Json::arrayValue);
+
+    auto snapshotPath = Utils::getCurrentWorkingDirectory() + "/snapshot_test.snapshot";
+    REQUIRE(Utils::saveJsonSnapshot(snapshotPath, configuration));
+    CHECK(Utils::isJsonSnapshot(snapshotPath));
+    CHECK_FALSE(Utils::isJsonSnapshot(filePath));
+
+    Json::Value loaded;
+    REQUIRE(Utils::loadJsonSnapshot(snapshotPath, loaded));
+    CHECK(loaded == configuration);
+
+    remove(snapshotPath.c_str());
+}
+
+/*************/
+TEST_CASE("Testing Json snapshots invalidation")
+{
+    auto sourcePath = Utils::getCurrentWorkingDirectory() + "/snapshot_source.json";
+    auto snapshotPath = Utils::getJsonSnapshotPath(sourcePath);
+
+    Json::Value configuration;
+    configuration["value"] = 1;
+    {
+        ofstream out(sourcePath, ios::binary);
+        out << configuration.toStyledString();
+    }
+    REQUIRE(Utils::saveJsonSnapshot(snapshotPath, configuration, sourcePath));
+
+    Json::Value loaded;
+    CHECK(Utils::loadJsonSnapshot(snapshotPath, loaded, sourcePath));
+    CHECK(loaded == configuration);
+    CHECK(Utils::loadJsonFileOrSnapshot(snapshotPath, loaded));
+    CHECK(loaded == configuration);
+
+    // Editing the source invalidates the snapshot, the source is then parsed
+    configuration["value"] = 12345;
+    {
+        ofstream out(sourcePath, ios::binary);
+        out << configuration.toStyledString();
+    }
+    CHECK_FALSE(Utils::loadJsonSnapshot(snapshotPath, loaded, sourcePath));
+    REQUIRE(Utils::loadJsonFileOrSnapshot(sourcePath, loaded));
+    CHECK(loaded["value"].asInt() == 12345);
+
+    // A truncated snapshot is rejected
+    {
+        ofstream out(snapshotPath, ios::binary | ios::trunc);
+        out << "SPLSNAP";
+    }
+    CHECK_FALSE(Utils::loadJsonSnapshot(snapshotPath, loaded));
+
+    remove(sourcePath.c_str());
+    remove(snapshotPath.c_str());
+}
@@ -1,4 +1,8 @@
+#include <fstream>
+#include <limits>
+#include <memory>
 #include <string>
+#include <vector>
 
 #include <doctest.h>
 #include <json/json.h>
@@ -30,3 +34,104 @@ TEST_CASE("Testing World::checkAndUpgradeConfiguration for a single Scene")
     CHECK(configuration_0_0_0 == configuration_0_7_15);
     CHECK(configuration_0_0_0 == configuration_0_7_21);
 }
+
+/*************/
+TEST_CASE("Testing Utils::isJsonEquivalent")
+{
+    CHECK(Utils::isJsonEquivalent(Json::Value(1), Json::Value(1.0)));
+    CHECK(Utils::isJsonEquivalent(Json::Value(0.1), Json::Value(static_cast<double>(0.1f))));
+    CHECK_FALSE(Utils::isJsonEquivalent(Json::Value(0.1), Json::Value(0.2)));
+    CHECK(Utils::isJsonEquivalent(Json::Value("file.png"), Json::Value("file.png")));
+    CHECK_FALSE(Utils::isJsonEquivalent(Json::Value("file.png"), Json::Value("other.png")));
+    CHECK_FALSE(Utils::isJsonEquivalent(Json::Value(true), Json::Value(1)));
+
+    Json::Value array;
+    array.append(2.0);
+    CHECK(Utils::isJsonEquivalent(array, Json::Value(2)));
+    CHECK(Utils::isJsonEquivalent(Json::Value(2), array));
+
+    Json::Value other = array;
+    other.append(3.0);
+    CHECK_FALSE(Utils::isJsonEquivalent(array, other));
+    array.append(3.0000001);
+    CHECK(Utils::isJsonEquivalent(array, other));
+
+    Json::Value object;
+    object["position"] = array;
+    Json::Value otherObject;
+    otherObject["position"] = other;
+    CHECK(Utils::isJsonEquivalent(object, otherObject));
+    otherObject["rotation"] = other;
+    CHECK_FALSE(Utils::isJsonEquivalent(object, otherObject));
+}
+
+/*************/
+TEST_CASE("Testing Utils::parseJson")
+{
+    const auto parseWithJsoncpp = [](const string& document) {
+        Json::Value value;
+        Json::CharReaderBuilder builder;
+        std::unique_ptr<Json::CharReader> const reader(builder.newCharReader());
+        string errors;
+        reader->parse(document.c_str(), document.c_str() + document.size(), &value, &errors);
+        return value;
+    };
+
+    const auto parse = [](const string& document, Json::Value& value) {
+        string errors;
+        return Utils::parseJson(document.c_str(), document.c_str() + document.size(), value, errors);
+    };
+
+    const vector<string> documents = {
+        R"({"integer": 42, "negative": -7, "large": 4294967296, "unsigned": 18446744073709551615, "huge": 1e300})",
+        R"({"float": 0.1, "exponent": -1.5e-3, "array": [1, 2.5, "three", true, false, null], "empty": {}, "emptyArray": []})",
+        R"({"escaped": "quote \" backslash \\ slash \/ tab \t newline \n", "unicode": "\u00e9\u20ac\ud83d\ude00"})",
+        "// Comment\n{/* inline */ \"key\": [1, 2, 3,], \"other\": {\"nested\": \"value\",},}",
+        R"({"duplicate": 1, "duplicate": 2})",
+        R"({"underflow": 1e-400, "negativeUnderflow": -0.0025e-400, "largeDigits": 1000e-3})",
+        "\xEF\xBB\xBF{\"bom\": true}",
+    };
+
+    for (const auto& document : documents)
+    {
+        Json::Value value;
+        CHECK(parse(document, value));
+        CHECK(value == parseWithJsoncpp(document));
+    }
+
+    Json::Value value;
+    CHECK(parse("[1, 2] trailing", value));
+    CHECK(value.size() == 2);
+
+    CHECK_FALSE(parse("", value));
+    CHECK_FALSE(parse("{\"key\" 1}", value));
+    CHECK_FALSE(parse("{\"key\": [1, 2}", value));
+    CHECK_FALSE(parse("{\"key\": \"unterminated}", value));
+    CHECK_FALSE(parse("{\"key\": tru}", value));
+    CHECK_FALSE(parse("{\"key\": \"\\x\"}", value));
+    CHECK_FALSE(parse("/* unterminated", value));
+
+    // Numbers which do not fit in a double are read as 0 or infinity, as recent jsoncpp releases do
+    CHECK(parse("[1e-400, -1e-400, 0.000001e-320, 1e400, -12.5e399, 100000e305]", value));
+    CHECK_EQ(value[0].asDouble(), 0.0);
+    CHECK_EQ(value[1].asDouble(), 0.0);
+    CHECK_EQ(value[2].asDouble(), 0.0);
+    CHECK_EQ(value[3].asDouble(), std::numeric_limits<double>::infinity());
+    CHECK_EQ(value[4].asDouble(), -std::numeric_limits<double>::infinity());
+    CHECK_EQ(value[5].asDouble(), std::numeric_limits<double>::infinity());
+
+    string errors;
+    const string document = "{\n  \"key\": ]\n}";
+    CHECK_FALSE(Utils::parseJson(document.c_str(), document.c_str() + document.size(), value, errors));
+    CHECK(errors.find("Line 2") != string::npos);
+
+    for (const auto& file : {"/data/sample_scene_0.0.0.json", "/data/sample_scene_0.7.15.json", "/data/sample_scene_0.7.21.json"})
+    {
+        Json::Value configuration;
+        CHECK(Utils::loadJsonFile(Utils::getCurrentWorkingDirectory() + file, configuration));
+
+        std::ifstream stream(Utils::getCurrentWorkingDirectory() + file);
+        const string contents((std::istreambuf_iterator<char>(stream)), std::istreambuf_iterator<char>());
+        CHECK(configuration == parseWithJsoncpp(contents));
+    }
+}
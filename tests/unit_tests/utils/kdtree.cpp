@@ -0,0 +1,46 @@
+#include <cmath>
+#include <doctest.h>
+#include <random>
+#include <vector>
+
+#include "./utils/kdtree.h"
+
+using namespace Splash;
+
+/*************/
+TEST_CASE("Testing KdTree nearest neighbour")
+{
+    KdTree emptyTree;
+    glm::vec3 nearest;
+    float distance;
+    CHECK_FALSE(emptyTree.findNearest(glm::vec3(0.f), nearest, distance));
+
+    std::mt19937 generator(42);
+    std::uniform_real_distribution<float> distribution(-1.f, 1.f);
+    std::vector<glm::vec3> points(10000);
+    for (auto& point : points)
+        point = glm::vec3(distribution(generator), distribution(generator), distribution(generator));
+    // Duplicated points must not confuse the search
+    for (size_t i = 0; i < 100; ++i)
+        points.push_back(points[i]);
+
+    KdTree tree(points);
+    CHECK_EQ(tree.size(), points.size());
+
+    for (size_t query = 0; query < 200; ++query)
+    {
+        glm::vec3 point(distribution(generator) * 1.5f, distribution(generator) * 1.5f, distribution(generator) * 1.5f);
+
+        float expectedDistance = std::numeric_limits<float>::max();
+        for (const auto& candidate : points)
+            expectedDistance = std::min(expectedDistance, glm::length(point - candidate));
+
+        REQUIRE(tree.findNearest(point, nearest, distance));
+        CHECK(std::abs(distance - expectedDistance) < 1e-6f);
+        CHECK(std::abs(glm::length(point - nearest) - expectedDistance) < 1e-6f);
+    }
+
+    // Indexed points are their own nearest neighbours
+    REQUIRE(tree.findNearest(points[123], nearest, distance));
+    CHECK_EQ(distance, 0.f);
+}
@@ -0,0 +1,57 @@
+#include <doctest.h>
+
+#include "./utils/latency_histogram.h"
+
+using namespace Splash;
+
+/*************/
+TEST_CASE("Testing LatencyHistogram percentiles")
+{
+    auto histogram = LatencyHistogram(100000);
+    CHECK_EQ(histogram.getCount(), 0);
+    CHECK_EQ(histogram.getPercentile(50.0), 0);
+
+    // Small values are held exactly
+    for (int64_t value = 0; value < 8; ++value)
+        histogram.add(value);
+    CHECK_EQ(histogram.getCount(), 8);
+    CHECK_EQ(histogram.getPercentile(50.0), 3);
+    CHECK_EQ(histogram.getPercentile(100.0), 7);
+
+    histogram.reset();
+    for (int64_t value = 1; value <= 10000; ++value)
+        histogram.add(value);
+    CHECK_EQ(histogram.getCount(), 10000);
+
+    for (const auto percentile : {10.0, 50.0, 95.0, 99.0})
+    {
+        auto expected = static_cast<int64_t>(percentile * 100.0);
+        auto estimation = histogram.getPercentile(percentile);
+        CHECK(estimation >= expected);
+        CHECK(estimation <= expected + expected / 8);
+    }
+
+    // Negative latencies are counted as null
+    histogram.reset();
+    histogram.add(-50);
+    CHECK_EQ(histogram.getPercentile(100.0), 0);
+}
+
+/*************/
+TEST_CASE("Testing LatencyHistogram window")
+{
+    auto histogram = LatencyHistogram(16);
+    for (int i = 0; i < 15; ++i)
+        histogram.add(1000);
+    CHECK_EQ(histogram.getCount(), 15);
+
+    // Reaching the window size halves the counts
+    histogram.add(1000);
+    CHECK_EQ(histogram.getCount(), 8);
+
+    // Old samples fade out as new ones come
+    for (int i = 0; i < 64; ++i)
+        histogram.add(20000);
+    CHECK(histogram.getPercentile(50.0) >= 20000);
+    CHECK(histogram.getPercentile(50.0) <= 20000 + 20000 / 8);
+}
@@ -0,0 +1,113 @@
+#include <cmath>
+#include <cstring>
+#include <doctest.h>
+#include <vector>
+
+#include "./utils/mesh_delta.h"
+
+using namespace Splash;
+
+namespace
+{
+// Append raw values to a frame
+template <typename T>
+void append(std::vector<uint8_t>& frame, const std::vector<T>& values)
+{
+    auto offset = frame.size();
+    frame.resize(offset + values.size() * sizeof(T));
+    memcpy(frame.data() + offset, values.data(), values.size() * sizeof(T));
+}
+} // namespace
+
+/*************/
+TEST_CASE("Testing mesh delta frames")
+{
+    std::vector<glm::vec4> vertices(8, glm::vec4(0.f, 0.f, 0.f, 1.f));
+    std::vector<glm::vec2> uvs(8, glm::vec2(0.f));
+    std::vector<glm::vec3> normals(8, glm::vec3(0.f, 0.f, 1.f));
+    std::vector<MeshDelta::Range> ranges;
+
+    std::vector<uint8_t> frame;
+    append<int32_t>(frame, {SPLASH_MESH_DELTA_MARKER, 8, 0, 2});
+    append<int32_t>(frame, {2, 1});
+    append<float>(frame, {1.f, 2.f, 3.f, 0.25f, 0.5f, 1.f, 0.f, 0.f});
+    append<int32_t>(frame, {6, 2});
+    append<float>(frame, {4.f, 5.f, 6.f, 0.75f, 1.f, 0.f, 1.f, 0.f, 7.f, 8.f, 9.f, 0.f, 0.f, 0.f, -1.f, 0.f});
+
+    CHECK(MeshDelta::isDelta(frame.data(), frame.size()));
+    REQUIRE(MeshDelta::apply(frame.data(), frame.size(), vertices, uvs, normals, ranges));
+    REQUIRE(ranges.size() == 2);
+    CHECK(ranges[0].first == 2);
+    CHECK(ranges[0].count == 1);
+    CHECK(ranges[1].first == 6);
+    CHECK(ranges[1].count == 2);
+
+    CHECK(vertices[2] == glm::vec4(1.f, 2.f, 3.f, 1.f));
+    CHECK(uvs[2] == glm::vec2(0.25f, 0.5f));
+    CHECK(normals[2] == glm::vec3(1.f, 0.f, 0.f));
+    CHECK(vertices[7] == glm::vec4(7.f, 8.f, 9.f, 1.f));
+    CHECK(normals[7] == glm::vec3(0.f, 0.f, -1.f));
+    CHECK(vertices[3] == glm::vec4(0.f, 0.f, 0.f, 1.f));
+
+    // Full frames start with their vertex count
+    std::vector<uint8_t> fullFrame;
+    append<int32_t>(fullFrame, {8, 0});
+    CHECK_FALSE(MeshDelta::isDelta(fullFrame.data(), fullFrame.size()));
+}
+
+/*************/
+TEST_CASE("Testing quantized mesh delta frames")
+{
+    std::vector<glm::vec4> vertices(4, glm::vec4(0.f, 0.f, 0.f, 1.f));
+    std::vector<glm::vec2> uvs(4, glm::vec2(0.f));
+    std::vector<glm::vec3> normals(4, glm::vec3(0.f, 0.f, 1.f));
+    std::vector<MeshDelta::Range> ranges;
+
+    std::vector<uint8_t> frame;
+    append<int32_t>(frame, {SPLASH_MESH_DELTA_MARKER, 4, SPLASH_MESH_DELTA_QUANTIZED, 1});
+    append<float>(frame, {-1.f, 0.f, 0.f, 1.f, 2.f, 4.f});
+    append<int32_t>(frame, {1, 1});
+    append<uint16_t>(frame, {65535, 32768, 0});
+    append<int16_t>(frame, {0, -32767, 0});
+    append<float>(frame, {0.5f, 0.25f});
+
+    REQUIRE(MeshDelta::apply(frame.data(), frame.size(), vertices, uvs, normals, ranges));
+    REQUIRE(ranges.size() == 1);
+    CHECK(vertices[1].x == doctest::Approx(1.f));
+    CHECK(std::abs(vertices[1].y - 1.f) < 0.001f);
+    CHECK(vertices[1].z == doctest::Approx(0.f));
+    CHECK(vertices[1].w == 1.f);
+    CHECK(normals[1].y == doctest::Approx(-1.f));
+    CHECK(uvs[1] == glm::vec2(0.5f, 0.25f));
+}
+
+/*************/
+TEST_CASE("Testing malformed mesh delta frames")
+{
+    std::vector<glm::vec4> vertices(4, glm::vec4(0.f, 0.f, 0.f, 1.f));
+    std::vector<glm::vec2> uvs(4, glm::vec2(0.f));
+    std::vector<glm::vec3> normals(4, glm::vec3(0.f, 0.f, 1.f));
+    std::vector<MeshDelta::Range> ranges;
+
+    // Vertex count not matching the mesh
+    std::vector<uint8_t> frame;
+    append<int32_t>(frame, {SPLASH_MESH_DELTA_MARKER, 5, 0, 0});
+    CHECK_FALSE(MeshDelta::apply(frame.data(), frame.size(), vertices, uvs, normals, ranges));
+
+    // Range out of the mesh, the first range must not be applied either
+    frame.clear();
+    append<int32_t>(frame, {SPLASH_MESH_DELTA_MARKER, 4, 0, 2});
+    append<int32_t>(frame, {0, 1});
+    append<float>(frame, {1.f, 1.f, 1.f, 0.f, 0.f, 0.f, 0.f, 1.f});
+    append<int32_t>(frame, {3, 2});
+    append<float>(frame, std::vector<float>(16, 1.f));
+    CHECK_FALSE(MeshDelta::apply(frame.data(), frame.size(), vertices, uvs, normals, ranges));
+    CHECK(vertices[0] == glm::vec4(0.f, 0.f, 0.f, 1.f));
+
+    // Truncated frame
+    frame.clear();
+    append<int32_t>(frame, {SPLASH_MESH_DELTA_MARKER, 4, 0, 1});
+    append<int32_t>(frame, {0, 2});
+    append<float>(frame, std::vector<float>(10, 1.f));
+    CHECK_FALSE(MeshDelta::apply(frame.data(), frame.size(), vertices, uvs, normals, ranges));
+}
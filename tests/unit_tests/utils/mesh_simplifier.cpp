@@ -0,0 +1,81 @@
+#include <doctest.h>
+#include <vector>
+
+#include "./utils/mesh_simplifier.h"
+
+using namespace Splash;
+
+namespace
+{
+// Regular grid of size x size quads over [0, 1]², two triangles each
+MeshSimplifier::Arrays makeGrid(int size)
+{
+    MeshSimplifier::Arrays grid;
+    auto addVertex = [&](int x, int y) {
+        auto u = static_cast<float>(x) / size;
+        auto v = static_cast<float>(y) / size;
+        grid.vertices.insert(grid.vertices.end(), {u, v, 0.f, 1.f});
+        grid.uvs.insert(grid.uvs.end(), {u, v});
+        grid.normals.insert(grid.normals.end(), {0.f, 0.f, 1.f, 0.f});
+    };
+
+    for (int y = 0; y < size; ++y)
+    {
+        for (int x = 0; x < size; ++x)
+        {
+            addVertex(x, y);
+            addVertex(x + 1, y);
+            addVertex(x + 1, y + 1);
+            addVertex(x, y);
+            addVertex(x + 1, y + 1);
+            addVertex(x, y + 1);
+        }
+    }
+
+    return grid;
+}
+} // namespace
+
+/*************/
+TEST_CASE("Testing mean edge length")
+{
+    CHECK_EQ(MeshSimplifier::getMeanEdgeLength({}), 0.f);
+
+    std::vector<float> triangle{0.f, 0.f, 0.f, 1.f, 3.f, 0.f, 0.f, 1.f, 0.f, 4.f, 0.f, 1.f};
+    CHECK_EQ(MeshSimplifier::getMeanEdgeLength(triangle), 4.f);
+}
+
+/*************/
+TEST_CASE("Testing mesh simplification")
+{
+    auto grid = makeGrid(32);
+    const auto vertexCount = grid.vertices.size() / 4;
+
+    // Cells smaller than the triangles keep all of them
+    auto same = MeshSimplifier::simplify(grid, 0.01f);
+    CHECK_EQ(same.vertices.size(), grid.vertices.size());
+
+    auto simplified = MeshSimplifier::simplify(grid, 4.f / 32.f);
+    const auto simplifiedCount = simplified.vertices.size() / 4;
+    CHECK(simplifiedCount > 0);
+    CHECK(simplifiedCount < vertexCount / 4);
+    CHECK_EQ(simplifiedCount % 3, 0);
+    CHECK_EQ(simplified.uvs.size(), simplifiedCount * 2);
+    CHECK_EQ(simplified.normals.size(), simplifiedCount * 4);
+    CHECK(simplified.annexe.empty());
+
+    // The simplified mesh stays within the original bounds
+    for (size_t vertex = 0; vertex < simplifiedCount; ++vertex)
+    {
+        CHECK(simplified.vertices[vertex * 4] >= 0.f);
+        CHECK(simplified.vertices[vertex * 4] <= 1.f);
+        CHECK(simplified.vertices[vertex * 4 + 2] == 0.f);
+        CHECK(simplified.vertices[vertex * 4 + 3] == 1.f);
+    }
+
+    CHECK(MeshSimplifier::getMeanEdgeLength(simplified.vertices) > MeshSimplifier::getMeanEdgeLength(grid.vertices));
+
+    // A cell containing the whole mesh drops all triangles
+    auto empty = MeshSimplifier::simplify(grid, 10.f);
+    CHECK(empty.vertices.empty());
+}
@@ -0,0 +1,73 @@
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <doctest.h>
+
+#include "./utils/mpsc_ring.h"
+
+using namespace std;
+using namespace Splash;
+
+/*************/
+TEST_CASE("Testing MpscRing push and pop")
+{
+    auto ring = MpscRing<string>(3);
+    CHECK_EQ(ring.capacity(), 4);
+
+    string value;
+    CHECK_FALSE(ring.pop(value));
+
+    for (uint32_t i = 0; i < ring.capacity(); ++i)
+        CHECK(ring.push(to_string(i)));
+    CHECK_FALSE(ring.push("overflow"));
+
+    for (uint32_t i = 0; i < ring.capacity(); ++i)
+    {
+        CHECK(ring.pop(value));
+        CHECK_EQ(value, to_string(i));
+    }
+    CHECK_FALSE(ring.pop(value));
+
+    // The ring wraps around once emptied
+    CHECK(ring.push("wrapped"));
+    CHECK(ring.pop(value));
+    CHECK_EQ(value, "wrapped");
+}
+
+/*************/
+TEST_CASE("Testing MpscRing with concurrent producers")
+{
+    static constexpr uint32_t producerCount = 4;
+    static constexpr uint32_t valuesPerProducer = 10000;
+    auto ring = MpscRing<uint32_t>(64);
+
+    vector<thread> producers;
+    for (uint32_t p = 0; p < producerCount; ++p)
+        producers.emplace_back([&ring, p]() {
+            for (uint32_t i = 0; i < valuesPerProducer; ++i)
+                while (!ring.push(p * valuesPerProducer + i))
+                    this_thread::yield();
+        });
+
+    // Values from a given producer must be popped in order
+    vector<int64_t> lastValues(producerCount, -1);
+    uint32_t popped = 0;
+    bool ordered = true;
+    uint32_t value;
+    while (popped < producerCount * valuesPerProducer)
+    {
+        if (!ring.pop(value))
+            continue;
+        auto producer = value / valuesPerProducer;
+        ordered &= (static_cast<int64_t>(value) > lastValues[producer]);
+        lastValues[producer] = value;
+        ++popped;
+    }
+
+    for (auto& producer : producers)
+        producer.join();
+
+    CHECK(ordered);
+    CHECK_FALSE(ring.pop(value));
+}
@@ -0,0 +1,100 @@
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <thread>
+
+#include <doctest.h>
+
+#include "./utils/osutils.h"
+
+using namespace Splash;
+
+/*************/
+TEST_CASE("Testing thread classes scheduling")
+{
+    CHECK_EQ(Utils::getThreadClassFromName("render"), Utils::ThreadClass::render);
+    CHECK_EQ(Utils::getThreadClassFromName("network"), Utils::ThreadClass::network);
+    CHECK_EQ(Utils::getThreadClassFromName("foo"), Utils::ThreadClass::count);
+
+    Utils::ThreadScheduling scheduling;
+    scheduling.policy = "batch";
+    scheduling.cores = {0};
+    Utils::setThreadClassScheduling(Utils::ThreadClass::decode, scheduling);
+
+    auto storedScheduling = Utils::getThreadClassScheduling(Utils::ThreadClass::decode);
+    CHECK_EQ(storedScheduling.policy, "batch");
+    CHECK_EQ(storedScheduling.cores, std::vector<int>({0}));
+    CHECK_EQ(Utils::getThreadClassScheduling(Utils::ThreadClass::render).policy, "default");
+
+#if HAVE_LINUX
+    // Lowering the priority of a thread does not need any privilege
+    std::thread([]() {
+        CHECK(Utils::applyThreadClass(Utils::ThreadClass::decode));
+        CHECK_EQ(sched_getscheduler(0), SCHED_BATCH);
+        CHECK_EQ(sched_getcpu(), 0);
+    }).join();
+#endif
+
+    // Setting the same scheduling again, or another class, does not make the decode threads apply it again
+    auto& registry = Utils::getThreadClassRegistry();
+    auto decodeVersion = registry.versions[static_cast<size_t>(Utils::ThreadClass::decode)].load();
+    Utils::setThreadClassScheduling(Utils::ThreadClass::decode, scheduling);
+    Utils::setThreadClassScheduling(Utils::ThreadClass::render, Utils::ThreadScheduling());
+    Utils::setThreadClassScheduling(Utils::ThreadClass::audio, {"idle", 0, {}});
+    CHECK_EQ(registry.versions[static_cast<size_t>(Utils::ThreadClass::decode)].load(), decodeVersion);
+    CHECK_EQ(registry.versions[static_cast<size_t>(Utils::ThreadClass::render)].load(), 0);
+
+#if HAVE_LINUX
+    // A class with no core set keeps the cores of the process
+    auto processCores = Utils::getAffinity();
+    REQUIRE_FALSE(processCores.empty());
+    Utils::captureProcessAffinity();
+    std::thread([&]() {
+        CHECK(Utils::applyThreadClass(Utils::ThreadClass::audio));
+        CHECK_EQ(Utils::getAffinity(), processCores);
+    }).join();
+#endif
+
+    Utils::setThreadClassScheduling(Utils::ThreadClass::audio, {});
+    Utils::setThreadClassScheduling(Utils::ThreadClass::decode, {});
+    CHECK(Utils::setScheduling("foo", 0) == false);
+}
+
+/*************/
+TEST_CASE("Testing NUMA topology discovery")
+{
+    CHECK_EQ(Utils::parseCpuList("0-3,8-9,12\n"), std::vector<int>({0, 1, 2, 3, 8, 9, 12}));
+    CHECK_EQ(Utils::parseCpuList("5"), std::vector<int>({5}));
+    CHECK(Utils::parseCpuList("").empty());
+
+    CHECK(Utils::getNumaNodeCount() >= 1);
+    CHECK(Utils::getNumaNodeCores(Utils::getNumaNodeCount()).empty());
+    CHECK_EQ(Utils::getPciDeviceNumaNode("ffff:ff:ff.f"), -1);
+}
+
+/*************/
+TEST_CASE("Testing cache file writing")
+{
+    auto directory = std::filesystem::temp_directory_path() / ("splash_unittest_cache_" + std::to_string(getpid()));
+    auto path = (directory / "sub" / "file.cache").string();
+
+    uint64_t content = 0x0123456789abcdef;
+    CHECK(Utils::writeCacheFile(path, "SPLTEST", 3, [&](std::ofstream& file) { file.write(reinterpret_cast<const char*>(&content), sizeof(content)); }));
+
+    std::ifstream file(path, std::ios::in | std::ios::binary);
+    char magic[8];
+    uint32_t version = 0;
+    uint64_t readContent = 0;
+    file.read(magic, sizeof(magic));
+    file.read(reinterpret_cast<char*>(&version), sizeof(version));
+    file.read(reinterpret_cast<char*>(&readContent), sizeof(readContent));
+    REQUIRE(file);
+    CHECK_EQ(std::string(magic), "SPLTEST");
+    CHECK_EQ(version, 3);
+    CHECK_EQ(readContent, content);
+
+    // No temporary file is left behind
+    CHECK_EQ(std::distance(std::filesystem::directory_iterator(directory / "sub"), std::filesystem::directory_iterator()), 1);
+
+    std::filesystem::remove_all(directory);
+}
@@ -107,3 +107,75 @@ TEST_CASE("Testing ResizableArray move constructor and operator")
     anotherOne = move(otherArray);
     CHECK_EQ(anotherOne[128], 42);
 }
+
+/*************/
+TEST_CASE("Testing ResizableArray adopting an external buffer")
+{
+    vector<uint8_t> data(256, 42);
+    bool released = false;
+
+    {
+        auto array = ResizableArray<uint8_t>(data.data(), data.size(), [&](uint8_t*) { released = true; });
+        CHECK_EQ(array.data(), data.data());
+        CHECK_EQ(array.size(), data.size());
+
+        auto otherArray = ResizableArray<uint8_t>(move(array));
+        CHECK_FALSE(released);
+        CHECK_EQ(otherArray[128], 42);
+
+        // Resizing copies the data to a buffer owned by the array
+        otherArray.resize(512);
+        CHECK(released);
+        CHECK_NE(otherArray.data(), data.data());
+        CHECK_EQ(otherArray[128], 42);
+    }
+
+    released = false;
+    {
+        auto array = ResizableArray<uint8_t>(data.data(), data.size(), [&](uint8_t*) { released = true; });
+    }
+    CHECK(released);
+}
+
+/*************/
+TEST_CASE("Testing ResizableArray large buffers")
+{
+    const size_t size = SPLASH_RESIZABLE_ARRAY_LARGE_BUFFER_SIZE + 1234;
+    auto array = ResizableArray<uint8_t>(size);
+    REQUIRE_EQ(array.size(), size);
+    CHECK_EQ(reinterpret_cast<uintptr_t>(array.data()) % SPLASH_RESIZABLE_ARRAY_HUGE_PAGE_SIZE, 0);
+
+    for (size_t i = 0; i < size; ++i)
+        array[i] = static_cast<uint8_t>(i);
+
+    auto copy = array;
+    CHECK_EQ(memcmp(copy.data(), array.data(), size), 0);
+
+    // Shifted data is kept when resizing
+    array.shift(16);
+    array.resize(size * 2);
+    CHECK_EQ(array[0], 16);
+    CHECK_EQ(array[size - 17], static_cast<uint8_t>(size - 1));
+
+    array.resize(128);
+    CHECK_EQ(array[127], static_cast<uint8_t>(143));
+}
+
+/*************/
+TEST_CASE("Testing ResizableArray copy of non byte values")
+{
+    vector<int> data(256);
+    for (size_t i = 0; i < data.size(); ++i)
+        data[i] = static_cast<int>(i);
+
+    auto array = ResizableArray(data.data(), data.data() + data.size());
+    auto copy = array;
+    CHECK_EQ(copy[255], 255);
+
+    ResizableArray<int> other;
+    other = array;
+    CHECK_EQ(other[255], 255);
+
+    copy.resize(512);
+    CHECK_EQ(copy[255], 255);
+}
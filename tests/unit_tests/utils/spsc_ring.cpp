@@ -0,0 +1,154 @@
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include <doctest.h>
+
+#include "./utils/spsc_ring.h"
+
+using namespace std;
+using namespace Splash;
+
+/*************/
+TEST_CASE("Testing SpscByteRing write and read")
+{
+    auto ring = SpscByteRing(6);
+    CHECK_EQ(ring.capacity(), 8);
+    CHECK_EQ(ring.readAvailable(), 0);
+
+    vector<uint8_t> buffer(3);
+    CHECK_FALSE(ring.read(buffer.data(), buffer.size()));
+
+    vector<uint8_t> input{0, 1, 2, 3, 4, 5};
+    CHECK(ring.write(input.data(), input.size()));
+    CHECK_EQ(ring.readAvailable(), 6);
+
+    // Writes are all or nothing
+    CHECK_FALSE(ring.write(input.data(), 3));
+    CHECK_EQ(ring.readAvailable(), 6);
+
+    CHECK(ring.read(buffer.data(), buffer.size()));
+    CHECK_EQ(buffer, vector<uint8_t>({0, 1, 2}));
+
+    // This write wraps around the end of the buffer
+    CHECK(ring.write(input.data(), 5));
+    CHECK_EQ(ring.readAvailable(), 8);
+
+    vector<uint8_t> output(8);
+    CHECK(ring.read(output.data(), output.size()));
+    CHECK_EQ(output, vector<uint8_t>({3, 4, 5, 0, 1, 2, 3, 4}));
+
+    CHECK(ring.write(input.data(), input.size()));
+    ring.clear();
+    CHECK_FALSE(ring.read(buffer.data(), buffer.size()));
+    CHECK_EQ(ring.readAvailable(), 0);
+}
+
+/*************/
+TEST_CASE("Testing SpscByteRing with concurrent writer and reader")
+{
+    static constexpr uint32_t valueCount = 105000;
+    static constexpr uint32_t valuesPerWrite = 7;
+    auto ring = SpscByteRing(64 * sizeof(uint32_t));
+
+    auto writer = thread([&ring]() {
+        vector<uint32_t> values(valuesPerWrite);
+        for (uint32_t i = 0; i < valueCount; i += valuesPerWrite)
+        {
+            for (uint32_t v = 0; v < valuesPerWrite; ++v)
+                values[v] = i + v;
+            while (!ring.write(reinterpret_cast<const uint8_t*>(values.data()), values.size() * sizeof(uint32_t)))
+                this_thread::yield();
+        }
+    });
+
+    // Values must be read in order, with reads not aligned on writes
+    bool ordered = true;
+    uint32_t expected = 0;
+    vector<uint32_t> values(3);
+    while (expected < valueCount)
+    {
+        if (!ring.read(reinterpret_cast<uint8_t*>(values.data()), values.size() * sizeof(uint32_t)))
+            continue;
+        for (auto value : values)
+            ordered &= (value == expected++);
+    }
+
+    writer.join();
+    CHECK(ordered);
+}
+
+/*************/
+TEST_CASE("Testing SpscRing push, pop and clear")
+{
+    auto ring = SpscRing<unique_ptr<int>>(3);
+    CHECK_EQ(ring.capacity(), 4);
+    CHECK(ring.empty());
+
+    unique_ptr<int> item;
+    CHECK_FALSE(ring.pop(item));
+
+    for (int i = 0; i < 4; ++i)
+        CHECK(ring.push(make_unique<int>(i)));
+    CHECK_EQ(ring.size(), 4);
+
+    // A failed push leaves the item untouched
+    auto extra = make_unique<int>(4);
+    CHECK_FALSE(ring.push(std::move(extra)));
+    CHECK(extra != nullptr);
+
+    CHECK(ring.pop(item));
+    CHECK_EQ(*item, 0);
+    CHECK(ring.push(std::move(extra)));
+
+    // Cleared items are handed to the drop functor, items pushed after the clear are kept
+    // The slots of cleared items are only released once the consumer pops
+    ring.clear();
+    CHECK_FALSE(ring.push(make_unique<int>(5)));
+    int dropped = 0;
+    const auto onDrop = [&](unique_ptr<int>& droppedItem) {
+        if (droppedItem)
+            ++dropped;
+    };
+    CHECK_FALSE(ring.pop(item, onDrop));
+    CHECK_EQ(dropped, 4);
+    CHECK(ring.empty());
+
+    CHECK(ring.push(make_unique<int>(6)));
+    ring.clear();
+    CHECK(ring.push(make_unique<int>(7)));
+    CHECK(ring.pop(item));
+    CHECK_EQ(*item, 7);
+    CHECK(ring.empty());
+}
+
+/*************/
+TEST_CASE("Testing SpscRing with concurrent producer and consumer")
+{
+    static constexpr uint32_t itemCount = 100000;
+    auto ring = SpscRing<vector<uint32_t>>(16);
+
+    auto producer = thread([&ring]() {
+        for (uint32_t i = 0; i < itemCount; ++i)
+        {
+            auto item = vector<uint32_t>({i, i + 1});
+            while (!ring.push(std::move(item)))
+                this_thread::yield();
+        }
+    });
+
+    bool ordered = true;
+    uint32_t expected = 0;
+    vector<uint32_t> item;
+    while (expected < itemCount)
+    {
+        if (!ring.pop(item))
+            continue;
+        ordered &= (item.size() == 2 && item[0] == expected && item[1] == expected + 1);
+        ++expected;
+    }
+
+    producer.join();
+    CHECK(ordered);
+}
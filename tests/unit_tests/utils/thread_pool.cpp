@@ -0,0 +1,78 @@
+#include <doctest.h>
+
+#include <atomic>
+#include <future>
+#include <vector>
+
+#include "./utils/thread_pool.h"
+
+using namespace std;
+using namespace Splash;
+
+/*************/
+TEST_CASE("Testing ThreadPool")
+{
+    ThreadPool pool(4);
+    CHECK_EQ(pool.getThreadCount(), 4);
+
+    atomic_int counter{0};
+    vector<future<void>> futures;
+    for (int i = 0; i < 64; ++i)
+        futures.push_back(pool.enqueue([&]() { counter.fetch_add(1); }));
+
+    for (auto& f : futures)
+        f.wait();
+    CHECK_EQ(counter.load(), 64);
+}
+
+/*************/
+TEST_CASE("Testing ThreadPool destruction")
+{
+    atomic_int counter{0};
+    {
+        ThreadPool pool(2);
+        for (int i = 0; i < 16; ++i)
+            pool.enqueue([&]() { counter.fetch_add(1); });
+    }
+    CHECK_EQ(counter.load(), 16);
+}
+
+/*************/
+TEST_CASE("Testing ThreadPool parallel run")
+{
+    ThreadPool pool(3);
+
+    vector<unsigned int> values(16, 0);
+    pool.runParallel(values.size(), [&](unsigned int index) { values[index] = index; });
+    for (unsigned int i = 0; i < values.size(); ++i)
+        CHECK_EQ(values[i], i);
+
+    // The calling thread runs the work itself if the workers are busy
+    promise<void> unblock;
+    auto blocker = unblock.get_future().share();
+    vector<future<void>> busy;
+    for (unsigned int i = 0; i < pool.getThreadCount(); ++i)
+        busy.push_back(pool.enqueue([blocker]() { blocker.wait(); }));
+
+    atomic_int counter{0};
+    pool.runParallel(8, [&](unsigned int) { counter.fetch_add(1); });
+    CHECK_EQ(counter.load(), 8);
+
+    unblock.set_value();
+    for (auto& f : busy)
+        f.wait();
+}
+
+/*************/
+TEST_CASE("Testing ThreadPool nested tasks")
+{
+    ThreadPool pool(2);
+
+    atomic_int counter{0};
+    auto outer = pool.enqueue([&]() {
+        pool.runParallel(4, [&](unsigned int) { counter.fetch_add(1); });
+        pool.enqueue([&]() { counter.fetch_add(1); }).wait();
+    });
+    outer.wait();
+    CHECK_EQ(counter.load(), 5);
+}
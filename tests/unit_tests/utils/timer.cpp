@@ -0,0 +1,61 @@
+#include <chrono>
+#include <thread>
+
+#include <doctest.h>
+
+#include "./utils/timer.h"
+
+using namespace std;
+using namespace Splash;
+
+/*************/
+TEST_CASE("Testing Timer probes")
+{
+    auto probe = Timer::get().getProbe("test_probe");
+    CHECK_EQ(Timer::get().getProbe("test_probe").id, probe.id);
+    CHECK_NE(Timer::get().getProbe("other_test_probe").id, probe.id);
+
+    // Stopping a probe which was never started does not measure anything
+    Timer::get() >> probe;
+    CHECK_EQ(Timer::get().getDuration(probe), 0);
+    auto durationMap = Timer::get().getDurationMap();
+    CHECK(durationMap.find("test_probe") == durationMap.end());
+
+    Timer::get() << probe;
+    this_thread::sleep_for(chrono::milliseconds(5));
+    Timer::get() >> probe;
+
+    auto duration = Timer::get().getDuration(probe);
+    CHECK(duration >= 5000);
+    CHECK_EQ(Timer::get().getDuration("test_probe"), duration);
+    durationMap = Timer::get().getDurationMap();
+    REQUIRE(durationMap.find("test_probe") != durationMap.end());
+    CHECK_EQ(durationMap["test_probe"], duration);
+
+    // Invalid probes are ignored
+    Timer::get() << Timer::Probe();
+    Timer::get() >> Timer::Probe();
+    CHECK_EQ(Timer::get().getDuration(Timer::Probe()), 0);
+}
+
+/*************/
+TEST_CASE("Testing Timer shared clock and master clock update time")
+{
+    Timer::get().setClockOffset(-1000000);
+    auto localTime = Timer::getTime();
+    auto sharedTime = Timer::get().getSharedTime();
+    CHECK(sharedTime <= localTime - 1000000 + 1000);
+    CHECK(sharedTime >= localTime - 1000000);
+    Timer::get().setClockOffset(0);
+
+    // A master clock received late is corrected from the given update time
+    Timer::Point clock;
+    clock.secs = 10;
+    Timer::get().setMasterClock(clock, Timer::getTime() - 500000);
+    int64_t time;
+    bool paused;
+    REQUIRE(Timer::get().getMasterClock<chrono::milliseconds>(time, paused));
+    CHECK_FALSE(paused);
+    CHECK(time >= 10500);
+    CHECK(time < 10600);
+}
@@ -0,0 +1,66 @@
+#include <fstream>
+#include <sstream>
+
+#include <doctest.h>
+#include <json/json.h>
+
+#include "./utils/timer.h"
+#include "./utils/trace_recorder.h"
+
+using namespace std;
+using namespace Splash;
+
+/*************/
+TEST_CASE("Testing TraceRecorder")
+{
+    auto path = string("/tmp/splash_unittest_trace.json");
+    auto& recorder = TraceRecorder::get();
+
+    // Nothing is recorded unless started
+    CHECK_FALSE(recorder.isRecording());
+    CHECK_FALSE(recorder.stop(path));
+    {
+        TraceSpan span("test", "not_recorded_span");
+    }
+
+    REQUIRE(recorder.start());
+    CHECK(recorder.isRecording());
+    CHECK_FALSE(recorder.start());
+
+    recorder.setThreadName("test thread");
+    {
+        TraceSpan span("test", "recorded_span");
+    }
+    auto probe = Timer::get().getProbe("trace_test_probe");
+    Timer::get() << probe;
+    Timer::get() >> probe;
+    recorder.addSpan("gpu", "gpu_span", TraceRecorder::getTime(), 10, TraceRecorder::gpuThreadId);
+
+    REQUIRE(recorder.stop(path));
+    CHECK_FALSE(recorder.isRecording());
+
+    ifstream file(path);
+    REQUIRE(file.is_open());
+    Json::Value trace;
+    Json::CharReaderBuilder builder;
+    string errors;
+    REQUIRE(Json::parseFromStream(builder, file, &trace, &errors));
+
+    bool hasSpan = false;
+    bool hasProbe = false;
+    bool hasGpuSpan = false;
+    bool hasThreadName = false;
+    for (const auto& event : trace["traceEvents"])
+    {
+        auto name = event["name"].asString();
+        CHECK_NE(name, "not_recorded_span");
+        hasSpan |= name == "recorded_span" && event["ph"].asString() == "X" && event["cat"].asString() == "test";
+        hasProbe |= name == "trace_test_probe" && event["cat"].asString() == "timer";
+        hasGpuSpan |= name == "gpu_span" && event["tid"].asUInt64() == TraceRecorder::gpuThreadId && event["dur"].asInt64() == 10;
+        hasThreadName |= name == "thread_name" && event["args"]["name"].asString() == "test thread";
+    }
+    CHECK(hasSpan);
+    CHECK(hasProbe);
+    CHECK(hasGpuSpan);
+    CHECK(hasThreadName);
+}
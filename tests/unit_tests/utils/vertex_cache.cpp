@@ -0,0 +1,71 @@
+#include <algorithm>
+#include <doctest.h>
+#include <numeric>
+#include <random>
+#include <vector>
+
+#include "./utils/vertex_cache.h"
+
+using namespace Splash;
+
+namespace
+{
+// Indexed grid of size x size quads, two triangles each, with its triangles shuffled
+std::vector<uint32_t> makeShuffledGrid(uint32_t size)
+{
+    std::vector<uint32_t> triangles;
+    for (uint32_t y = 0; y < size; ++y)
+    {
+        for (uint32_t x = 0; x < size; ++x)
+        {
+            auto corner = y * (size + 1) + x;
+            triangles.insert(triangles.end(), {corner, corner + 1, corner + size + 2});
+            triangles.insert(triangles.end(), {corner, corner + size + 2, corner + size + 1});
+        }
+    }
+
+    std::vector<uint32_t> order(triangles.size() / 3);
+    std::iota(order.begin(), order.end(), 0);
+    std::shuffle(order.begin(), order.end(), std::mt19937(42));
+
+    std::vector<uint32_t> indices;
+    for (auto triangle : order)
+        indices.insert(indices.end(), triangles.begin() + triangle * 3, triangles.begin() + triangle * 3 + 3);
+    return indices;
+}
+} // namespace
+
+/*************/
+TEST_CASE("Testing triangle reordering for the vertex cache")
+{
+    const uint32_t size = 32;
+    const uint32_t vertexCount = (size + 1) * (size + 1);
+    auto indices = makeShuffledGrid(size);
+
+    auto order = VertexCache::optimizeTriangleOrder(indices, vertexCount);
+    REQUIRE(order.size() == indices.size() / 3);
+
+    // Each triangle is emitted exactly once
+    auto sortedOrder = order;
+    std::sort(sortedOrder.begin(), sortedOrder.end());
+    for (uint32_t triangle = 0; triangle < sortedOrder.size(); ++triangle)
+        CHECK(sortedOrder[triangle] == triangle);
+
+    std::vector<uint32_t> reordered;
+    for (auto triangle : order)
+        reordered.insert(reordered.end(), indices.begin() + triangle * 3, indices.begin() + triangle * 3 + 3);
+
+    auto shuffledRatio = VertexCache::getAverageCacheMissRatio(indices, vertexCount);
+    auto reorderedRatio = VertexCache::getAverageCacheMissRatio(reordered, vertexCount);
+    CHECK(reorderedRatio < shuffledRatio);
+    CHECK(reorderedRatio < 1.f);
+}
+
+/*************/
+TEST_CASE("Testing triangle reordering with invalid indices")
+{
+    CHECK(VertexCache::optimizeTriangleOrder({0, 1}, 2).empty());
+    CHECK(VertexCache::optimizeTriangleOrder({0, 1, 3}, 3).empty());
+    CHECK(VertexCache::optimizeTriangleOrder({}, 0).empty());
+    CHECK(VertexCache::getAverageCacheMissRatio({0, 1, 2}, 3) == doctest::Approx(3.f));
+}
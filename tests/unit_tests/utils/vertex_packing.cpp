@@ -0,0 +1,49 @@
+#include <algorithm>
+#include <cmath>
+#include <doctest.h>
+#include <vector>
+
+#include "./utils/vertex_packing.h"
+
+using namespace Splash;
+
+namespace
+{
+// Decode a signed normalized component as the vertex fetch does
+float unpackComponent(uint32_t packed, int shift, int bits)
+{
+    auto value = static_cast<int32_t>(packed << (32 - shift - bits)) >> (32 - bits);
+    return std::max(static_cast<float>(value) / static_cast<float>((1 << (bits - 1)) - 1), -1.f);
+}
+} // namespace
+
+/*************/
+TEST_CASE("Testing normal packing")
+{
+    std::vector<float> normals{0.f, 0.f, 1.f, 0.f, -1.f, 0.f, 0.f, 0.f, 0.267f, -0.535f, 0.802f, 0.f, 2.f, -3.f, 0.f, 1.f};
+    auto packed = VertexPacking::packNormals(normals.data(), normals.size() / 4);
+    REQUIRE(packed.size() == 4);
+
+    for (size_t i = 0; i < packed.size(); ++i)
+    {
+        for (int c = 0; c < 3; ++c)
+            CHECK(std::abs(unpackComponent(packed[i], c * 10, 10) - std::clamp(normals[i * 4 + c], -1.f, 1.f)) <= 1.f / 511.f);
+        CHECK(unpackComponent(packed[i], 30, 2) == normals[i * 4 + 3]);
+    }
+}
+
+/*************/
+TEST_CASE("Testing texture coordinates packing")
+{
+    std::vector<uint16_t> packed;
+    std::vector<float> texCoords{0.f, 1.f, 0.5f, 0.25f, 0.123456f, 0.999f};
+    REQUIRE(VertexPacking::packTexCoords(texCoords.data(), texCoords.size() / 2, packed));
+    REQUIRE(packed.size() == texCoords.size());
+    CHECK(packed[0] == 0);
+    CHECK(packed[1] == 65535);
+    for (size_t i = 0; i < packed.size(); ++i)
+        CHECK(std::abs(static_cast<float>(packed[i]) / 65535.f - texCoords[i]) <= 0.5f / 65535.f);
+
+    std::vector<float> repeatedTexCoords{0.f, 0.f, 2.f, 1.f};
+    CHECK_FALSE(VertexPacking::packTexCoords(repeatedTexCoords.data(), repeatedTexCoords.size() / 2, packed));
+}
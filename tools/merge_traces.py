@@ -0,0 +1,24 @@
+#!/usr/bin/env python3
+
+# This script merges the trace files written by the World and the Scenes
+# when recording a trace (see the 'recordTrace' World attribute) into a
+# single file, which can be opened with ui.perfetto.dev or chrome://tracing
+#
+# Usage: merge_traces.py OUTPUT_FILE TRACE_FILE [TRACE_FILE ...]
+
+import json
+import sys
+
+if __name__ == "__main__":
+    if len(sys.argv) < 3:
+        print("Usage: merge_traces.py OUTPUT_FILE TRACE_FILE [TRACE_FILE ...]")
+        sys.exit(1)
+
+    # Timestamps are already on the clock shared by all the processes
+    events = []
+    for path in sys.argv[2:]:
+        with open(path) as traceFile:
+            events += json.load(traceFile)["traceEvents"]
+
+    with open(sys.argv[1], "w") as outputFile:
+        json.dump({"displayTimeUnit": "ms", "traceEvents": events}, outputFile)
@@ -22,31 +22,42 @@
  * A tool to check the calibration of a projection setup
  */
 
+#include <algorithm>
+#include <atomic>
+#include <cmath>
 #include <cstring>
-#include <functional>
-#include <memory>
+#include <iostream>
 #include <string>
+#include <thread>
 #include <vector>
 
 #include <opencv2/core.hpp>
-#include <opencv2/highgui.hpp>
+#include <opencv2/imgcodecs.hpp>
+#include <opencv2/imgproc.hpp>
 
-#include "cgUtils.h"
-#include "log.h"
+#include "./utils/log.h"
 
 using namespace Splash;
 
 /*************/
 struct Parameters
 {
-    bool valid {true};
-    std::string filename {""};
-    unsigned int subdivisions = 0;
-    bool silent {false};
-    bool outputImages {false};
-
-    cv::Mat3f image{};
-    cv::Mat1b mask{};
+    bool valid{true};
+    std::vector<std::string> filenames{};
+    std::string maskFilename{""};
+    unsigned int subdivisions{0};
+    unsigned int jobs{0}; // Number of files checked in parallel, 0 for as many as there are cores
+    bool silent{false};
+    bool json{false};
+    bool outputImages{false};
+};
+
+/*************/
+struct Result
+{
+    std::string filename{""};
+    bool valid{false};
+    std::vector<std::vector<double>> stdDevs{}; // Standard deviation of the luminance of each block, for each subdivision level
 };
 
 /*************/
@@ -56,15 +67,17 @@ void showHelp()
     using std::endl;
 
     cout << "Splash calibration checker" << endl;
-    cout << "A very simple tool to test projector calibration" << endl;
+    cout << "A very simple tool to test projector calibration, through the uniformity of HDR photos of the projection" << endl;
     cout << endl;
-    cout << "Usage:" << endl;
+    cout << "Usage: splash-check-calibration [options] [filename...]" << endl;
     cout << " --help (-h): this very help" << endl;
-    cout << " -f (--file) [filename]: specify the hdr image to test" << endl;
+    cout << " -f (--file) [filename]: specify an hdr image to test, can be repeated. Trailing arguments are tested too" << endl;
     cout << " -s (--subdiv) [subdivlevel]: specify the subdivision level for the test" << endl;
-    cout << " -m (--mask) [filename]: set a mask from a tga B&W image" << endl;
+    cout << " -m (--mask) [filename]: set a mask from a tga B&W image, shared by all the images" << endl;
+    cout << " -j (--jobs) [count]: number of images tested in parallel, defaults to the number of cores" << endl;
     cout << " -b (--batch): only output the result with no info (useful for batch test)" << endl;
-    cout << " -i (--image): output images named splash_check_[i].tga, i being the subdivision level" << endl;
+    cout << " -J (--json): output the results as JSON, one object per image" << endl;
+    cout << " -i (--image): output images named splash_check_[n]_[i].tga, n being the image index and i the subdivision level" << endl;
 
     exit(0);
 }
@@ -80,66 +93,65 @@ Parameters parseArgs(int argc, char** argv)
     if (argc == 1)
         showHelp();
 
-    for (unsigned int i = 0; i < argc;)
+    for (int i = 1; i < argc; ++i)
     {
-        if ((string(argv[i]) == "-f" || string(argv[i]) == "--file")&& i < argc - 1)
+        const auto arg = string(argv[i]);
+        if ((arg == "-f" || arg == "--file") && i < argc - 1)
         {
-            ++i;
-            params.filename = string(argv[i]);
-            params.image = cv::imread(params.filename);
+            params.filenames.push_back(string(argv[++i]));
         }
-        else if ((string(argv[i]) == "-s" || string(argv[i]) == "--subdiv")&& i < argc - 1)
+        else if ((arg == "-s" || arg == "--subdiv") && i < argc - 1)
         {
-            ++i;
-            params.subdivisions = std::stoi(string(argv[i]));
+            params.subdivisions = std::stoi(string(argv[++i]));
         }
-        else if ((string(argv[i]) == "-m" || string(argv[i]) == "--mask")&& i < argc - 1)
+        else if ((arg == "-m" || arg == "--mask") && i < argc - 1)
         {
-            ++i;
-            string filename = string(argv[i]);
-            if (filename.find("tga") == string::npos)
+            params.maskFilename = string(argv[++i]);
+            if (params.maskFilename.find("tga") == string::npos)
             {
                 params.valid = false;
                 Log::get() << Log::WARNING << "Please specify a TGA (non-RLE encoded) file for the mask." << Log::endl;
             }
-            else
-            {
-                params.mask = cv::imread(filename, cv::IMREAD_GRAYSCALE);
-            }
         }
-        else if (string(argv[i]) == "-b" || string(argv[i]) == "--batch")
+        else if ((arg == "-j" || arg == "--jobs") && i < argc - 1)
+        {
+            params.jobs = std::max(0, std::stoi(string(argv[++i])));
+        }
+        else if (arg == "-b" || arg == "--batch")
         {
             params.silent = true;
             Log::get().setVerbosity(Log::NONE);
         }
-        else if (string(argv[i]) == "-i" || string(argv[i]) == "--image")
+        else if (arg == "-J" || arg == "--json")
+        {
+            params.json = true;
+        }
+        else if (arg == "-i" || arg == "--image")
         {
             params.outputImages = true;
         }
-        else if (string(argv[i]) == "-h" || string(argv[i]) == "--help")
+        else if (arg == "-h" || arg == "--help")
         {
             showHelp();
         }
-        ++i;
+        else if (arg.find('-') != 0)
+        {
+            params.filenames.push_back(arg);
+        }
     }
-    
+
     // Check params
-    if (params.filename.find("hdr") == string::npos)
+    if (params.filenames.empty())
     {
         params.valid = false;
         Log::get() << Log::WARNING << "Please specify a HDR file to process." << Log::endl;
     }
-    if (params.image.total() == 0)
+    for (const auto& filename : params.filenames)
     {
-        params.valid = false;
-        Log::get() << Log::WARNING << "Could not open file " << params.filename << ". Exiting." << Log::endl;
-    }
-    if (params.mask.total() != 0)
-    {
-        if (params.mask.cols != params.image.cols || params.mask.rows != params.image.rows)
+        if (filename.find("hdr") == string::npos)
         {
             params.valid = false;
-            Log::get() << Log::WARNING << "Could not open file " << params.filename << ". Exiting." << Log::endl;
+            Log::get() << Log::WARNING << "File " << filename << " is not a HDR file." << Log::endl;
         }
     }
 
@@ -147,96 +159,83 @@ Parameters parseArgs(int argc, char** argv)
 }
 
 /*************/
-double getStdDev(Parameters& params, int x = 0, int y = 0, int w = 0, int h = 0)
+std::vector<std::vector<double>> getMultilevelStdDev(const cv::Mat1f& luminance, const cv::Mat1b& mask, unsigned int subdivisions)
 {
-    using std::cout;
-    using std::endl;
-
-    if (params.image.total() != 0)
-        return 0.0;
-
-    bool withMask = false;
-    if (params.mask.total() != 0)
-        withMask = true;
-
-    int width = w == 0 ? params.image.cols : std::min(w, params.image.cols);
-    int height = h == 0 ? params.image.rows : std::min(h, params.image.rows);
-
-    pic::BBox roi = pic::BBox(x, x+width, y, y+height);
-    double totalPixels = 0.0;
+    std::vector<std::vector<double>> results;
 
-    double maxValue = 0.0;
-    double meanValue = 0.0;
-    for (int y = roi.y0; y < roi.y1; ++y)
-        for (int x = roi.x0; x < roi.x1; ++x)
+    for (unsigned int l = 0; l <= subdivisions; ++l)
+    {
+        const int blocks = 1 << l;
+        std::vector<double> subdivResults;
+        for (int row = 0; row < blocks; ++row)
         {
-            if (withMask)
+            for (int col = 0; col < blocks; ++col)
             {
-                unsigned char* maskPixel = params.mask.ptr();
-                if (maskPixel[(y * params.mask.cols + x) * params.mask.channels] < 128)
+                // Blocks cover the whole image, the last ones taking the remaining pixels
+                const int x0 = luminance.cols * col / blocks;
+                const int x1 = luminance.cols * (col + 1) / blocks;
+                const int y0 = luminance.rows * row / blocks;
+                const int y1 = luminance.rows * (row + 1) / blocks;
+                const auto roi = cv::Rect(x0, y0, x1 - x0, y1 - y0);
+
+                if (roi.empty() || (mask.total() != 0 && cv::countNonZero(mask(roi)) == 0))
                 {
+                    subdivResults.push_back(0.0);
                     continue;
                 }
-            }
-            totalPixels++;
-
-            float* pixel = params.image(y, x);
-            RgbValue rgb(pixel[0], pixel[1], pixel[2]);
-            meanValue += rgb.luminance();
 
-            maxValue = std::max(maxValue, (double)rgb.luminance());
-        }
-    meanValue = totalPixels == 0.0 ? 0.0 : meanValue / totalPixels;
-
-    double stdDev = 0.0;
-    for (int y = roi.y0; y < roi.y1; ++y)
-        for (int x = roi.x0; x < roi.x1; ++x)
-        {
-            if (withMask)
-            {
-                unsigned char* maskPixel = params.mask.ptr();
-                if (maskPixel[(y * params.mask.cols + x) * params.mask.channels] < 128)
-                    continue;
+                cv::Scalar mean, stdDev;
+                if (mask.total() != 0)
+                    cv::meanStdDev(luminance(roi), mean, stdDev, mask(roi));
+                else
+                    cv::meanStdDev(luminance(roi), mean, stdDev);
+                subdivResults.push_back(stdDev[0]);
             }
-
-            float* pixel = image(y, x);
-            RgbValue rgb(pixel[0], pixel[1], pixel[2]);
-            double lum = rgb.luminance();
-            stdDev += std::pow(lum - meanValue, 2.0);
         }
 
-    stdDev = totalPixels == 0.0 ? 0.0 : std::sqrt(stdDev / totalPixels);
+        results.push_back(subdivResults);
+    }
 
-    return stdDev;
+    return results;
 }
 
 /*************/
-std::vector<std::vector<double>> applyMultilevel(std::function<double(Parameters&, int, int, int, int)> filter, Parameters& params)
+Result checkFile(const std::string& filename, const cv::Mat1b& mask, unsigned int subdivisions)
 {
-    std::vector<std::vector<double>> results;
+    Result result;
+    result.filename = filename;
 
-    for (unsigned int l = 0; l <= params.subdivisions; ++l)
+    cv::Mat image = cv::imread(filename, cv::IMREAD_ANYDEPTH | cv::IMREAD_COLOR);
+    if (image.total() == 0)
+    {
+        Log::get() << Log::WARNING << "Could not open file " << filename << "." << Log::endl;
+        return result;
+    }
+    if (mask.total() != 0 && (mask.cols != image.cols || mask.rows != image.rows))
     {
-        int blockWidth = params.image.cols / std::pow(2.0, l);
-        int blockHeight = params.image.rows / std::pow(2.0, l);
+        Log::get() << Log::WARNING << "The mask does not have the size of file " << filename << "." << Log::endl;
+        return result;
+    }
 
-        std::vector<double> subdivResults;
-        for (int y = 0; y < params.image.rows; y += blockHeight)
-            for (int x = 0; x < params.image.cols; x += blockWidth)
-            {
-                double result = filter(params, x, y, blockWidth, blockHeight);
-                subdivResults.push_back(result);
-            }
+    // Luminance of all the pixels at once, considering a sRGB linearized color space. OpenCV loads images as BGR
+    cv::Mat3f bgr;
+    image.convertTo(bgr, CV_32FC3);
+    cv::Mat1f luminance;
+    cv::transform(bgr, luminance, cv::Matx13f(0.0722f, 0.7152f, 0.2126f));
 
-        results.push_back(subdivResults);
-    }
+    // Pixels are in the mask if its value is at least 128
+    cv::Mat1b binaryMask;
+    if (mask.total() != 0)
+        cv::threshold(mask, binaryMask, 127, 255, cv::THRESH_BINARY);
 
-    return results;
+    result.stdDevs = getMultilevelStdDev(luminance, binaryMask, subdivisions);
+    result.valid = true;
+    return result;
 }
 
 /*************/
 #define OUTPUT_SIZE 512
-void saveImagesFromMultilevel(Parameters params, std::vector<std::vector<double>> results)
+void saveImagesFromMultilevel(const std::vector<std::vector<double>>& results, size_t fileIndex)
 {
     int index = 0;
 
@@ -247,7 +246,7 @@ void saveImagesFromMultilevel(Parameters params, std::vector<std::vector<double>
 
     for (auto& result : results)
     {
-        std::vector<unsigned char> image(OUTPUT_SIZE * OUTPUT_SIZE);
+        cv::Mat1b image(OUTPUT_SIZE, OUTPUT_SIZE);
         int subdiv = round(sqrt(result.size()));
         int step = OUTPUT_SIZE / subdiv;
 
@@ -255,44 +254,117 @@ void saveImagesFromMultilevel(Parameters params, std::vector<std::vector<double>
         {
             for (int x = 0; x < OUTPUT_SIZE; ++x)
             {
-                int col = x / step;
-                int row = y / step;
+                int col = std::min(x / step, subdiv - 1);
+                int row = std::min(y / step, subdiv - 1);
 
-                image[y * OUTPUT_SIZE + x] = (unsigned char)(result[row * subdiv + col] / maxStdDev * 255.0);
+                image(y, x) = maxStdDev == 0.0 ? 0 : (unsigned char)(result[row * subdiv + col] / maxStdDev * 255.0);
             }
         }
 
-        pic::WriteTGA("/tmp/splash_check_" + std::to_string(index) + ".tga", image.data(), OUTPUT_SIZE, OUTPUT_SIZE, 1);
+        cv::imwrite("/tmp/splash_check_" + std::to_string(fileIndex) + "_" + std::to_string(index) + ".tga", image);
         index++;
     }
 }
 
+/*************/
+std::string escapeJson(const std::string& input)
+{
+    std::string output;
+    for (auto c : input)
+    {
+        if (c == '"' || c == '\\')
+            output += '\\';
+        output += c;
+    }
+    return output;
+}
+
 /*************/
 int main(int argc, char** argv)
 {
     Parameters params = parseArgs(argc, argv);
 
+    cv::Mat1b mask;
+    if (params.valid && !params.maskFilename.empty())
+    {
+        mask = cv::imread(params.maskFilename, cv::IMREAD_GRAYSCALE);
+        if (mask.total() == 0)
+        {
+            params.valid = false;
+            Log::get() << Log::WARNING << "Could not open mask " << params.maskFilename << "." << Log::endl;
+        }
+    }
+
     if (!params.valid)
     {
         Log::get() << Log::WARNING << "An error was found in the parameters, exiting." << Log::endl;
         exit(1);
     }
 
-    Log::get() << Log::MESSAGE << "Processing file " << params.filename << Log::endl;
+    Log::get() << Log::MESSAGE << "Processing " << params.filenames.size() << " files" << Log::endl;
     Log::get() << Log::MESSAGE << "Subdivision level: " << params.subdivisions << Log::endl;
 
-    std::vector<std::vector<double>> stdDevMultilevel = applyMultilevel([&](Parameters& params, int x, int y, int w, int h) {
-        return getStdDev(params, x, y, w, h);
-    }, params);
+    // Files are checked in parallel, each worker taking the next file to check. OpenCV does not need to parallelize each of them
+    auto jobs = params.jobs != 0 ? params.jobs : std::max(1u, std::thread::hardware_concurrency());
+    jobs = std::min<unsigned int>(jobs, params.filenames.size());
+    if (jobs > 1)
+        cv::setNumThreads(1);
+
+    std::vector<Result> results(params.filenames.size());
+    std::atomic_size_t nextFile{0};
+    std::vector<std::thread> workers;
+    for (unsigned int job = 0; job < jobs; ++job)
+        workers.emplace_back([&]() {
+            for (auto fileIndex = nextFile++; fileIndex < params.filenames.size(); fileIndex = nextFile++)
+            {
+                results[fileIndex] = checkFile(params.filenames[fileIndex], mask, params.subdivisions);
+                if (params.outputImages && results[fileIndex].valid)
+                    saveImagesFromMultilevel(results[fileIndex].stdDevs, fileIndex);
+            }
+        });
+    for (auto& worker : workers)
+        worker.join();
 
-    Log::get() << Log::MESSAGE << "Standard deviations along all specified levels: " << Log::endl;
-    for (auto& subdivResult : stdDevMultilevel)
+    bool allValid = true;
+    if (params.json)
     {
-        for (auto& result : subdivResult)
-            std::cout << result << " ";
-        std::cout << std::endl;
+        std::cout << "[" << std::endl;
+        for (size_t fileIndex = 0; fileIndex < results.size(); ++fileIndex)
+        {
+            const auto& result = results[fileIndex];
+            allValid &= result.valid;
+
+            std::cout << "  {\"file\": \"" << escapeJson(result.filename) << "\", \"valid\": " << (result.valid ? "true" : "false") << ", \"stdDevs\": [";
+            for (size_t level = 0; level < result.stdDevs.size(); ++level)
+            {
+                std::cout << (level == 0 ? "[" : ", [");
+                for (size_t block = 0; block < result.stdDevs[level].size(); ++block)
+                    std::cout << (block == 0 ? "" : ", ") << result.stdDevs[level][block];
+                std::cout << "]";
+            }
+            std::cout << "]}" << (fileIndex + 1 < results.size() ? "," : "") << std::endl;
+        }
+        std::cout << "]" << std::endl;
+    }
+    else
+    {
+        for (const auto& result : results)
+        {
+            allValid &= result.valid;
+            if (!result.valid)
+                continue;
+
+            Log::get() << Log::MESSAGE << "Standard deviations along all specified levels for file " << result.filename << ": " << Log::endl;
+            if (results.size() > 1)
+                std::cout << result.filename << std::endl;
+            for (auto& subdivResult : result.stdDevs)
+            {
+                for (auto& value : subdivResult)
+                    std::cout << value << " ";
+                std::cout << std::endl;
+            }
+        }
     }
 
-    if (params.outputImages)
-        saveImagesFromMultilevel(params, stdDevMultilevel);
+    return allValid ? 0 : 1;
 }